@@ -0,0 +1,149 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/adaptive_batch_timeout_controller.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// The weight of the most recent inter-arrival time in the moving average.
+constexpr double kInterarrivalSmoothingFactor = 0.1;
+
+}  // namespace
+
+Status AdaptiveBatchTimeoutController::Create(
+    const Options& options,
+    std::unique_ptr<AdaptiveBatchTimeoutController>* result) {
+  if (options.max_batch_timeout_micros < 0) {
+    return errors::InvalidArgument(
+        "max_batch_timeout_micros must be non-negative; was ",
+        options.max_batch_timeout_micros);
+  }
+  if (options.latency_slo_micros <= 0) {
+    return errors::InvalidArgument("latency_slo_micros must be positive; was ",
+                                   options.latency_slo_micros);
+  }
+  if (options.processing_time_percentile <= 0 ||
+      options.processing_time_percentile > 1) {
+    return errors::InvalidArgument(
+        "processing_time_percentile must be in (0, 1]; was ",
+        options.processing_time_percentile);
+  }
+  if (options.num_timeout_levels < 2) {
+    return errors::InvalidArgument(
+        "num_timeout_levels must be at least 2; was ",
+        options.num_timeout_levels);
+  }
+  if (options.processing_time_window_size <= 0) {
+    return errors::InvalidArgument(
+        "processing_time_window_size must be positive; was ",
+        options.processing_time_window_size);
+  }
+  if (options.env == nullptr) {
+    return errors::InvalidArgument("env must be set");
+  }
+  result->reset(new AdaptiveBatchTimeoutController(options));
+  return OkStatus();
+}
+
+AdaptiveBatchTimeoutController::AdaptiveBatchTimeoutController(
+    const Options& options)
+    : options_(options) {
+  processing_times_micros_.reserve(options_.processing_time_window_size);
+}
+
+void AdaptiveBatchTimeoutController::RecordArrival() {
+  const int64_t now_micros = options_.env->NowMicros();
+  mutex_lock l(mu_);
+  if (last_arrival_micros_ >= 0) {
+    const double interarrival_micros =
+        std::max<int64_t>(0, now_micros - last_arrival_micros_);
+    if (mean_interarrival_micros_ < 0) {
+      mean_interarrival_micros_ = interarrival_micros;
+    } else {
+      mean_interarrival_micros_ +=
+          kInterarrivalSmoothingFactor *
+          (interarrival_micros - mean_interarrival_micros_);
+    }
+  }
+  last_arrival_micros_ = now_micros;
+  UpdateLevel();
+}
+
+void AdaptiveBatchTimeoutController::RecordBatchProcessingTime(
+    int64_t processing_time_micros) {
+  mutex_lock l(mu_);
+  if (processing_times_micros_.size() < options_.processing_time_window_size) {
+    processing_times_micros_.push_back(processing_time_micros);
+  } else {
+    processing_times_micros_[next_processing_time_index_] =
+        processing_time_micros;
+  }
+  next_processing_time_index_ =
+      (next_processing_time_index_ + 1) % options_.processing_time_window_size;
+
+  std::vector<int64_t> sorted_times = processing_times_micros_;
+  const int tail_index = std::min<int>(
+      sorted_times.size() - 1,
+      options_.processing_time_percentile * sorted_times.size());
+  std::nth_element(sorted_times.begin(), sorted_times.begin() + tail_index,
+                   sorted_times.end());
+  tail_processing_time_micros_ = sorted_times[tail_index];
+  UpdateLevel();
+}
+
+int AdaptiveBatchTimeoutController::CurrentLevel() const {
+  mutex_lock l(mu_);
+  return current_level_;
+}
+
+int64_t AdaptiveBatchTimeoutController::LevelTimeoutMicros(int level) const {
+  if (level >= options_.num_timeout_levels - 1) {
+    return 0;
+  }
+  return options_.max_batch_timeout_micros >> level;
+}
+
+void AdaptiveBatchTimeoutController::UpdateLevel() {
+  if (tail_processing_time_micros_ < 0) {
+    // Without any processing times, stick to the largest timeout.
+    current_level_ = 0;
+    return;
+  }
+  int64_t desired_timeout_micros =
+      std::min(options_.max_batch_timeout_micros,
+               options_.latency_slo_micros - tail_processing_time_micros_);
+  if (mean_interarrival_micros_ >= 0 &&
+      desired_timeout_micros < mean_interarrival_micros_) {
+    // No other request is expected to join the batch in time.
+    desired_timeout_micros = 0;
+  }
+  int level = 0;
+  while (level < options_.num_timeout_levels - 1 &&
+         LevelTimeoutMicros(level) > desired_timeout_micros) {
+    ++level;
+  }
+  current_level_ = level;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,127 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_ADAPTIVE_BATCH_TIMEOUT_CONTROLLER_H_
+#define TENSORFLOW_SERVING_BATCHING_ADAPTIVE_BATCH_TIMEOUT_CONTROLLER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Picks a batch timeout that keeps the tail latency of batched requests within
+// a latency SLO while waiting as long as possible for batches to fill.
+//
+// A request waits up to the batch timeout for its batch to close and is then
+// processed, so its latency is roughly bounded by the timeout plus the batch
+// processing time. The controller tracks the recent batch processing times and
+// the request arrival rate, and chooses the largest timeout such that:
+//  - the timeout plus the tail (see 'processing_time_percentile') of the
+//    processing times stays within 'latency_slo_micros', and
+//  - at least one more request is expected to arrive while waiting; otherwise
+//    waiting only adds latency without improving the batch fill.
+//
+// The timeout is quantized to 'num_timeout_levels' levels: level 0 is
+// 'max_batch_timeout_micros', each following level halves the timeout, and the
+// last level is zero. This lets a caller keep one batch queue per level (see
+// AdaptiveTimeoutBatchScheduler) instead of reconfiguring a queue in place.
+//
+// This class is thread-safe.
+class AdaptiveBatchTimeoutController {
+ public:
+  struct Options {
+    // The largest timeout the controller picks, typically the statically
+    // configured batch timeout.
+    int64_t max_batch_timeout_micros = 0;
+
+    // The target latency, from enqueuing a request to its batch completing.
+    int64_t latency_slo_micros = 0;
+
+    // The percentile of the batch processing times that, together with the
+    // timeout, must fit within 'latency_slo_micros'.
+    double processing_time_percentile = 0.99;
+
+    // The number of timeout levels. Must be at least 2.
+    int num_timeout_levels = 4;
+
+    // The number of most recent batch processing times that are tracked.
+    int processing_time_window_size = 128;
+
+    // The environment to use for obtaining the current time.
+    Env* env = Env::Default();
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<AdaptiveBatchTimeoutController>* result);
+
+  ~AdaptiveBatchTimeoutController() = default;
+
+  // Records that a request arrived now.
+  void RecordArrival() TF_LOCKS_EXCLUDED(mu_);
+
+  // Records that a batch took 'processing_time_micros' to process.
+  void RecordBatchProcessingTime(int64_t processing_time_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the level of the timeout currently chosen by the controller.
+  int CurrentLevel() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the timeout of timeout level 'level'.
+  int64_t LevelTimeoutMicros(int level) const;
+
+  int num_timeout_levels() const { return options_.num_timeout_levels; }
+
+  const Options& options() const { return options_; }
+
+ private:
+  explicit AdaptiveBatchTimeoutController(const Options& options);
+
+  // Recomputes 'current_level_' from the tracked statistics.
+  void UpdateLevel() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+
+  mutable mutex mu_;
+
+  // A ring buffer of the most recent batch processing times.
+  std::vector<int64_t> processing_times_micros_ TF_GUARDED_BY(mu_);
+  int next_processing_time_index_ TF_GUARDED_BY(mu_) = 0;
+
+  // The 'processing_time_percentile' of 'processing_times_micros_', or -1 if
+  // no batch was processed yet.
+  int64_t tail_processing_time_micros_ TF_GUARDED_BY(mu_) = -1;
+
+  // An exponentially weighted moving average of the time between consecutive
+  // request arrivals, or -1 before the second arrival.
+  double mean_interarrival_micros_ TF_GUARDED_BY(mu_) = -1;
+  int64_t last_arrival_micros_ TF_GUARDED_BY(mu_) = -1;
+
+  int current_level_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveBatchTimeoutController);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_ADAPTIVE_BATCH_TIMEOUT_CONTROLLER_H_
@@ -0,0 +1,134 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/adaptive_batch_timeout_controller.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Timeout levels: 8000, 4000, 2000, 0.
+AdaptiveBatchTimeoutController::Options CreateOptions(Env* env) {
+  AdaptiveBatchTimeoutController::Options options;
+  options.max_batch_timeout_micros = 8000;
+  options.latency_slo_micros = 10000;
+  options.num_timeout_levels = 4;
+  options.processing_time_window_size = 10;
+  options.env = env;
+  return options;
+}
+
+// Records 'num_arrivals' arrivals, 'interarrival_micros' apart.
+void RecordArrivals(int num_arrivals, int64_t interarrival_micros,
+                    test_util::FakeClockEnv* env,
+                    AdaptiveBatchTimeoutController* controller) {
+  for (int i = 0; i < num_arrivals; ++i) {
+    env->AdvanceByMicroseconds(interarrival_micros);
+    controller->RecordArrival();
+  }
+}
+
+TEST(AdaptiveBatchTimeoutControllerTest, LevelTimeouts) {
+  std::unique_ptr<AdaptiveBatchTimeoutController> controller;
+  TF_ASSERT_OK(AdaptiveBatchTimeoutController::Create(
+      CreateOptions(Env::Default()), &controller));
+  EXPECT_EQ(4, controller->num_timeout_levels());
+  EXPECT_EQ(8000, controller->LevelTimeoutMicros(0));
+  EXPECT_EQ(4000, controller->LevelTimeoutMicros(1));
+  EXPECT_EQ(2000, controller->LevelTimeoutMicros(2));
+  EXPECT_EQ(0, controller->LevelTimeoutMicros(3));
+}
+
+TEST(AdaptiveBatchTimeoutControllerTest, StartsAtLargestTimeout) {
+  test_util::FakeClockEnv env(Env::Default());
+  std::unique_ptr<AdaptiveBatchTimeoutController> controller;
+  TF_ASSERT_OK(
+      AdaptiveBatchTimeoutController::Create(CreateOptions(&env), &controller));
+  EXPECT_EQ(0, controller->CurrentLevel());
+  RecordArrivals(5, /*interarrival_micros=*/100, &env, controller.get());
+  EXPECT_EQ(0, controller->CurrentLevel());
+}
+
+TEST(AdaptiveBatchTimeoutControllerTest, KeepsWithinLatencySlo) {
+  test_util::FakeClockEnv env(Env::Default());
+  std::unique_ptr<AdaptiveBatchTimeoutController> controller;
+  TF_ASSERT_OK(
+      AdaptiveBatchTimeoutController::Create(CreateOptions(&env), &controller));
+  RecordArrivals(5, /*interarrival_micros=*/100, &env, controller.get());
+
+  // Fast batches leave room for the largest timeout.
+  controller->RecordBatchProcessingTime(1000);
+  EXPECT_EQ(0, controller->CurrentLevel());
+
+  // A slow batch dominates the tail and leaves 10000 - 5000 for waiting.
+  controller->RecordBatchProcessingTime(5000);
+  EXPECT_EQ(1, controller->CurrentLevel());
+
+  // No room for waiting at all.
+  controller->RecordBatchProcessingTime(9500);
+  EXPECT_EQ(3, controller->CurrentLevel());
+
+  // Once the slow batches fall out of the window, the timeout grows again.
+  for (int i = 0; i < 10; ++i) {
+    controller->RecordBatchProcessingTime(1000);
+  }
+  EXPECT_EQ(0, controller->CurrentLevel());
+}
+
+TEST(AdaptiveBatchTimeoutControllerTest, DoesNotWaitForSparseTraffic) {
+  test_util::FakeClockEnv env(Env::Default());
+  std::unique_ptr<AdaptiveBatchTimeoutController> controller;
+  TF_ASSERT_OK(
+      AdaptiveBatchTimeoutController::Create(CreateOptions(&env), &controller));
+  controller->RecordBatchProcessingTime(1000);
+
+  // Requests arrive further apart than the largest timeout, so waiting would
+  // not improve the batch fill.
+  RecordArrivals(5, /*interarrival_micros=*/20000, &env, controller.get());
+  EXPECT_EQ(3, controller->CurrentLevel());
+
+  // Once traffic picks up, batching pays off again.
+  RecordArrivals(50, /*interarrival_micros=*/100, &env, controller.get());
+  EXPECT_EQ(0, controller->CurrentLevel());
+}
+
+TEST(AdaptiveBatchTimeoutControllerTest, RejectsInvalidOptions) {
+  std::unique_ptr<AdaptiveBatchTimeoutController> controller;
+  AdaptiveBatchTimeoutController::Options options =
+      CreateOptions(Env::Default());
+  options.latency_slo_micros = 0;
+  EXPECT_FALSE(AdaptiveBatchTimeoutController::Create(options, &controller)
+                   .ok());
+
+  options = CreateOptions(Env::Default());
+  options.num_timeout_levels = 1;
+  EXPECT_FALSE(AdaptiveBatchTimeoutController::Create(options, &controller)
+                   .ok());
+
+  options = CreateOptions(Env::Default());
+  options.processing_time_percentile = 1.5;
+  EXPECT_FALSE(AdaptiveBatchTimeoutController::Create(options, &controller)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
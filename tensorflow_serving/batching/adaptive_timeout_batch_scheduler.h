@@ -0,0 +1,166 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_ADAPTIVE_TIMEOUT_BATCH_SCHEDULER_H_
+#define TENSORFLOW_SERVING_BATCHING_ADAPTIVE_TIMEOUT_BATCH_SCHEDULER_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow_serving/batching/adaptive_batch_timeout_controller.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A BatchScheduler whose batch timeout adapts to the load, as chosen by an
+// AdaptiveBatchTimeoutController.
+//
+// Batch queues (e.g. of a SharedBatchScheduler) have a fixed timeout, so this
+// class keeps one underlying queue per timeout level of the controller and
+// sends each task to the queue of the currently chosen level. While the level
+// is stable all tasks share one queue; after a change, the batch that is open
+// on the previous queue still closes at its timeout (or when it fills up).
+//
+// The processing time of each batch is fed back to the controller.
+template <typename TaskType>
+class AdaptiveTimeoutBatchScheduler : public BatchScheduler<TaskType> {
+ public:
+  using ProcessBatchCallback =
+      std::function<void(std::unique_ptr<Batch<TaskType>>)>;
+
+  // Creates an underlying queue with the given batch timeout, which invokes
+  // 'process_batch_callback' on its batches.
+  using QueueCreator = std::function<Status(
+      int64_t batch_timeout_micros, ProcessBatchCallback process_batch_callback,
+      std::unique_ptr<BatchScheduler<TaskType>>* queue)>;
+
+  static Status Create(
+      const AdaptiveBatchTimeoutController::Options& options,
+      ProcessBatchCallback process_batch_callback,
+      const QueueCreator& queue_creator,
+      std::unique_ptr<AdaptiveTimeoutBatchScheduler<TaskType>>* result);
+
+  ~AdaptiveTimeoutBatchScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<TaskType>* task) override;
+
+  // Returns the total over all queues.
+  size_t NumEnqueuedTasks() const override;
+
+  // Returns the capacity of the queue of the current timeout level.
+  size_t SchedulingCapacity() const override;
+
+  // Returns the smallest maximum task size over all queues.
+  size_t max_task_size() const override;
+
+  const AdaptiveBatchTimeoutController& controller() const {
+    return *controller_;
+  }
+
+ private:
+  AdaptiveTimeoutBatchScheduler() = default;
+
+  // Shared with the callbacks of the underlying queues.
+  std::shared_ptr<AdaptiveBatchTimeoutController> controller_;
+
+  // The queue for each timeout level, in the order of the levels.
+  std::vector<std::unique_ptr<BatchScheduler<TaskType>>> queues_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveTimeoutBatchScheduler);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+template <typename TaskType>
+Status AdaptiveTimeoutBatchScheduler<TaskType>::Create(
+    const AdaptiveBatchTimeoutController::Options& options,
+    ProcessBatchCallback process_batch_callback,
+    const QueueCreator& queue_creator,
+    std::unique_ptr<AdaptiveTimeoutBatchScheduler<TaskType>>* result) {
+  std::unique_ptr<AdaptiveBatchTimeoutController> controller;
+  TF_RETURN_IF_ERROR(
+      AdaptiveBatchTimeoutController::Create(options, &controller));
+
+  std::unique_ptr<AdaptiveTimeoutBatchScheduler<TaskType>> scheduler(
+      new AdaptiveTimeoutBatchScheduler<TaskType>);
+  scheduler->controller_ = std::move(controller);
+  std::shared_ptr<AdaptiveBatchTimeoutController> shared_controller =
+      scheduler->controller_;
+  Env* env = options.env;
+  ProcessBatchCallback timed_process_batch_callback =
+      [shared_controller, env,
+       process_batch_callback](std::unique_ptr<Batch<TaskType>> batch) {
+        const uint64_t start_time_micros = env->NowMicros();
+        process_batch_callback(std::move(batch));
+        shared_controller->RecordBatchProcessingTime(env->NowMicros() -
+                                                     start_time_micros);
+      };
+  const int num_levels = scheduler->controller_->num_timeout_levels();
+  scheduler->queues_.reserve(num_levels);
+  for (int level = 0; level < num_levels; ++level) {
+    std::unique_ptr<BatchScheduler<TaskType>> queue;
+    TF_RETURN_IF_ERROR(queue_creator(
+        scheduler->controller_->LevelTimeoutMicros(level),
+        timed_process_batch_callback, &queue));
+    scheduler->queues_.push_back(std::move(queue));
+  }
+  *result = std::move(scheduler);
+  return OkStatus();
+}
+
+template <typename TaskType>
+Status AdaptiveTimeoutBatchScheduler<TaskType>::Schedule(
+    std::unique_ptr<TaskType>* task) {
+  controller_->RecordArrival();
+  return queues_[controller_->CurrentLevel()]->Schedule(task);
+}
+
+template <typename TaskType>
+size_t AdaptiveTimeoutBatchScheduler<TaskType>::NumEnqueuedTasks() const {
+  size_t num_enqueued_tasks = 0;
+  for (const auto& queue : queues_) {
+    num_enqueued_tasks += queue->NumEnqueuedTasks();
+  }
+  return num_enqueued_tasks;
+}
+
+template <typename TaskType>
+size_t AdaptiveTimeoutBatchScheduler<TaskType>::SchedulingCapacity() const {
+  return queues_[controller_->CurrentLevel()]->SchedulingCapacity();
+}
+
+template <typename TaskType>
+size_t AdaptiveTimeoutBatchScheduler<TaskType>::max_task_size() const {
+  size_t max_task_size = queues_[0]->max_task_size();
+  for (const auto& queue : queues_) {
+    max_task_size = std::min(max_task_size, queue->max_task_size());
+  }
+  return max_task_size;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_ADAPTIVE_TIMEOUT_BATCH_SCHEDULER_H_
@@ -0,0 +1,116 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/adaptive_timeout_batch_scheduler.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class FakeTask : public BatchTask {
+ public:
+  FakeTask() = default;
+  ~FakeTask() override = default;
+
+  size_t size() const override { return 1; }
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
+};
+
+// A batch scheduler that counts the tasks it is given.
+class CountingScheduler : public BatchScheduler<FakeTask> {
+ public:
+  CountingScheduler() = default;
+  ~CountingScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<FakeTask>* task) override {
+    ++num_tasks_;
+    task->reset();
+    return OkStatus();
+  }
+
+  size_t NumEnqueuedTasks() const override { return num_tasks_; }
+
+  size_t SchedulingCapacity() const override { return 10; }
+
+  size_t max_task_size() const override { return 10; }
+
+ private:
+  int num_tasks_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CountingScheduler);
+};
+
+TEST(AdaptiveTimeoutBatchSchedulerTest, SwitchesQueuesWithTimeoutLevel) {
+  test_util::FakeClockEnv env(Env::Default());
+  AdaptiveBatchTimeoutController::Options options;
+  options.max_batch_timeout_micros = 8000;
+  options.latency_slo_micros = 10000;
+  options.num_timeout_levels = 4;
+  options.env = &env;
+
+  std::vector<int64_t> queue_timeouts;
+  std::vector<CountingScheduler*> queues;
+  AdaptiveTimeoutBatchScheduler<FakeTask>::ProcessBatchCallback
+      level_callback;
+  std::unique_ptr<AdaptiveTimeoutBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(AdaptiveTimeoutBatchScheduler<FakeTask>::Create(
+      options,
+      [&env](std::unique_ptr<Batch<FakeTask>> batch) {
+        // Simulates a slow batch.
+        env.AdvanceByMicroseconds(9500);
+      },
+      [&](int64_t batch_timeout_micros,
+          AdaptiveTimeoutBatchScheduler<FakeTask>::ProcessBatchCallback
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<FakeTask>>* queue) {
+        queue_timeouts.push_back(batch_timeout_micros);
+        level_callback = process_batch_callback;
+        auto counting_scheduler = std::make_unique<CountingScheduler>();
+        queues.push_back(counting_scheduler.get());
+        *queue = std::move(counting_scheduler);
+        return OkStatus();
+      },
+      &scheduler));
+  EXPECT_EQ(std::vector<int64_t>({8000, 4000, 2000, 0}), queue_timeouts);
+
+  auto task = std::make_unique<FakeTask>();
+  TF_ASSERT_OK(scheduler->Schedule(&task));
+  EXPECT_EQ(1, queues[0]->NumEnqueuedTasks());
+
+  // The slow batch leaves no room for waiting within the SLO, so subsequent
+  // tasks go to the queue without a timeout.
+  level_callback(std::make_unique<Batch<FakeTask>>());
+  EXPECT_EQ(3, scheduler->controller().CurrentLevel());
+  task = std::make_unique<FakeTask>();
+  TF_ASSERT_OK(scheduler->Schedule(&task));
+  EXPECT_EQ(1, queues[3]->NumEnqueuedTasks());
+  EXPECT_EQ(2, scheduler->NumEnqueuedTasks());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
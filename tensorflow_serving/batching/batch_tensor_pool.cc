@@ -0,0 +1,160 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/batch_tensor_pool.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/batch_util.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+string PoolKey(DataType dtype, const TensorShape& shape) {
+  return absl::StrCat(DataTypeString(dtype), shape.DebugString());
+}
+
+}  // namespace
+
+BatchTensorPool::BatchTensorPool(int max_tensors_per_key,
+                                 int64_t max_retained_bytes,
+                                 Allocator* allocator)
+    : max_tensors_per_key_(max_tensors_per_key),
+      max_retained_bytes_(max_retained_bytes),
+      allocator_(allocator != nullptr ? allocator : cpu_allocator()) {}
+
+Tensor BatchTensorPool::Allocate(DataType dtype, const TensorShape& shape) {
+  mutex_lock l(mu_);
+  const string key = PoolKey(dtype, shape);
+  for (const Tensor& tensor : tensors_[key]) {
+    // The pool's copy is the only remaining reference, so nobody else can
+    // observe the buffer anymore.
+    if (tensor.RefCountIsOne()) {
+      return tensor;
+    }
+  }
+  Tensor tensor(allocator_, dtype, shape);
+  if (tensors_[key].size() >= max_tensors_per_key_) {
+    return tensor;
+  }
+  const int64_t bytes = tensor.TotalBytes();
+  if (retained_bytes_ + bytes > max_retained_bytes_) {
+    ReleaseUnusedTensors(key, bytes);
+  }
+  if (retained_bytes_ + bytes <= max_retained_bytes_) {
+    tensors_[key].push_back(tensor);
+    retained_bytes_ += bytes;
+  }
+  return tensor;
+}
+
+void BatchTensorPool::ReleaseUnusedTensors(const string& key_to_keep,
+                                           int64_t bytes_needed) {
+  for (auto it = tensors_.begin(); it != tensors_.end();) {
+    if (retained_bytes_ + bytes_needed <= max_retained_bytes_) {
+      return;
+    }
+    if (it->first == key_to_keep) {
+      ++it;
+      continue;
+    }
+    std::vector<Tensor>& tensors = it->second;
+    for (auto tensor_it = tensors.begin(); tensor_it != tensors.end();) {
+      if (tensor_it->RefCountIsOne()) {
+        retained_bytes_ -= tensor_it->TotalBytes();
+        tensor_it = tensors.erase(tensor_it);
+      } else {
+        ++tensor_it;
+      }
+    }
+    if (tensors.empty()) {
+      tensors_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+Status BatchTensorPool::Concat(absl::Span<const Tensor> tensors,
+                               Tensor* result) {
+  if (tensors.empty()) {
+    return errors::InvalidArgument("Cannot concatenate zero tensors");
+  }
+  const Tensor& reference = tensors[0];
+  if (reference.dims() == 0) {
+    return errors::InvalidArgument(
+        "Cannot concatenate zero-dimensional tensors");
+  }
+  int64_t total_dim0_size = 0;
+  for (const Tensor& tensor : tensors) {
+    if (tensor.dtype() != reference.dtype()) {
+      return errors::InvalidArgument(
+          "Cannot concatenate tensors that have different data types");
+    }
+    if (tensor.dims() != reference.dims()) {
+      return errors::InvalidArgument(
+          "Cannot concatenate tensors that have different ranks");
+    }
+    for (int d = 1; d < reference.dims(); ++d) {
+      if (tensor.dim_size(d) != reference.dim_size(d)) {
+        return errors::InvalidArgument(
+            "Cannot concatenate tensors that have different shapes in a "
+            "non-zeroth dimension");
+      }
+    }
+    total_dim0_size += tensor.dim_size(0);
+  }
+
+  TensorShape shape = reference.shape();
+  shape.set_dim(0, total_dim0_size);
+  Tensor output = Allocate(reference.dtype(), shape);
+
+  int64_t offset = 0;
+  for (const Tensor& tensor : tensors) {
+    const int64_t num_slices = tensor.dim_size(0);
+    if (num_slices > 0) {
+      TF_RETURN_IF_ERROR(batch_util::CopyContiguousSlices(
+          tensor, /*src_offset=*/0, /*dst_offset=*/offset, num_slices,
+          &output));
+    }
+    offset += num_slices;
+  }
+  *result = std::move(output);
+  return OkStatus();
+}
+
+int BatchTensorPool::num_retained_tensors() const {
+  mutex_lock l(mu_);
+  int num_tensors = 0;
+  for (const auto& entry : tensors_) {
+    num_tensors += entry.second.size();
+  }
+  return num_tensors;
+}
+
+int64_t BatchTensorPool::num_retained_bytes() const {
+  mutex_lock l(mu_);
+  return retained_bytes_;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
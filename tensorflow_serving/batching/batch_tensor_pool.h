@@ -0,0 +1,117 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_BATCH_TENSOR_POOL_H_
+#define TENSORFLOW_SERVING_BATCHING_BATCH_TENSOR_POOL_H_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The number of merged input buffers retained per (dtype, shape) by batching
+// sessions that enable pooled batch assembly. Roughly bounds the number of
+// batches of the same shape that can be assembled concurrently without
+// allocating.
+constexpr int kMaxPooledBatchTensorsPerShape = 4;
+
+// Bounds the memory retained for padded per-task inputs by batching sessions
+// that enable pooled batch assembly. Padded shapes vary from batch to batch, so
+// unlike merged inputs they are pooled under a byte budget.
+constexpr int64_t kMaxPooledPaddedInputBytes = 64 << 20;
+
+// A pool of tensor buffers keyed by (dtype, shape), used to avoid allocating a
+// fresh buffer for every batch that is assembled with the same shape.
+//
+// The pool retains a reference to every buffer it hands out. A buffer is
+// recycled once all other references to it are gone, i.e. once the pool holds
+// the only remaining reference. Callers therefore never "return" a tensor to
+// the pool; dropping the tensor (and any tensors aliasing it) is sufficient.
+//
+// This class is thread-safe.
+class BatchTensorPool {
+ public:
+  // 'max_tensors_per_key' bounds the number of buffers retained for each
+  // (dtype, shape) pair. Once the bound is reached and all retained buffers are
+  // in use, Allocate() falls back to returning unpooled tensors.
+  //
+  // 'max_retained_bytes' bounds the total size of the retained buffers. When a
+  // new buffer would exceed it, unused buffers of other shapes are released
+  // first; if that is not enough the new buffer is not retained. This keeps the
+  // pool bounded when shapes vary a lot, e.g. with variable-length inputs.
+  //
+  // If 'allocator' is non-null, buffers are allocated from it, and it must
+  // outlive the pool and the tensors it hands out. Otherwise they are
+  // allocated from the default CPU allocator.
+  explicit BatchTensorPool(
+      int max_tensors_per_key,
+      int64_t max_retained_bytes = std::numeric_limits<int64_t>::max(),
+      Allocator* allocator = nullptr);
+
+  ~BatchTensorPool() = default;
+
+  // Returns a tensor with the given 'dtype' and 'shape'. The contents are
+  // unspecified (they may hold data from a previous use).
+  Tensor Allocate(DataType dtype, const TensorShape& shape)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Like tensor::Concat(), but assembles the result into a pooled buffer.
+  // 'tensors' must be non-empty, have the same dtype, and have the same shape
+  // in all but the 0th dimension.
+  Status Concat(absl::Span<const Tensor> tensors, Tensor* result);
+
+  // Returns the number of buffers currently retained by the pool, across all
+  // keys. Intended for tests and monitoring.
+  int num_retained_tensors() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the total size of the buffers currently retained by the pool.
+  int64_t num_retained_bytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Releases retained buffers that are not in use, skipping those stored under
+  // 'key_to_keep', until 'bytes_needed' more bytes fit in the budget.
+  void ReleaseUnusedTensors(const string& key_to_keep, int64_t bytes_needed)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int max_tensors_per_key_;
+  const int64_t max_retained_bytes_;
+  Allocator* const allocator_;
+
+  mutable mutex mu_;
+  absl::flat_hash_map<string, std::vector<Tensor>> tensors_
+      TF_GUARDED_BY(mu_);
+  int64_t retained_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BatchTensorPool);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_BATCH_TENSOR_POOL_H_
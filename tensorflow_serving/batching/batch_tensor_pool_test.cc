@@ -0,0 +1,165 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/batch_tensor_pool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Counts the allocations it forwards to the CPU allocator.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocations_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+  int num_allocations() const { return num_allocations_; }
+
+ private:
+  std::atomic<int> num_allocations_{0};
+};
+
+TEST(BatchTensorPoolTest, ReusesUnreferencedBuffers) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/2);
+  const void* first_data;
+  {
+    Tensor tensor = pool.Allocate(DT_FLOAT, {4, 3});
+    first_data = tensor.tensor_data().data();
+  }
+  Tensor tensor = pool.Allocate(DT_FLOAT, {4, 3});
+  EXPECT_EQ(first_data, tensor.tensor_data().data());
+  EXPECT_EQ(1, pool.num_retained_tensors());
+}
+
+TEST(BatchTensorPoolTest, DoesNotReuseReferencedBuffers) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/2);
+  Tensor first = pool.Allocate(DT_FLOAT, {4, 3});
+  // A slice keeps the underlying buffer alive.
+  Tensor slice = first.Slice(0, 1);
+  first = Tensor();
+  Tensor second = pool.Allocate(DT_FLOAT, {4, 3});
+  EXPECT_NE(slice.tensor_data().data(), second.tensor_data().data());
+  EXPECT_EQ(2, pool.num_retained_tensors());
+}
+
+TEST(BatchTensorPoolTest, KeysByDtypeAndShape) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/1);
+  pool.Allocate(DT_FLOAT, {4, 3});
+  pool.Allocate(DT_FLOAT, {8, 3});
+  pool.Allocate(DT_INT32, {4, 3});
+  EXPECT_EQ(3, pool.num_retained_tensors());
+}
+
+TEST(BatchTensorPoolTest, RespectsMaxTensorsPerKey) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/1);
+  Tensor first = pool.Allocate(DT_FLOAT, {2});
+  Tensor second = pool.Allocate(DT_FLOAT, {2});
+  EXPECT_NE(first.tensor_data().data(), second.tensor_data().data());
+  EXPECT_EQ(1, pool.num_retained_tensors());
+}
+
+TEST(BatchTensorPoolTest, RespectsMaxRetainedBytes) {
+  // Room for exactly one 4x4 float buffer.
+  BatchTensorPool pool(/*max_tensors_per_key=*/2,
+                       /*max_retained_bytes=*/4 * 4 * sizeof(float));
+  Tensor in_use = pool.Allocate(DT_FLOAT, {4, 4});
+  EXPECT_EQ(1, pool.num_retained_tensors());
+  // Neither another buffer of the same shape nor one of a different shape
+  // fits while the first one is in use.
+  pool.Allocate(DT_FLOAT, {4, 4});
+  pool.Allocate(DT_FLOAT, {2, 8});
+  EXPECT_EQ(1, pool.num_retained_tensors());
+  EXPECT_EQ(4 * 4 * sizeof(float), pool.num_retained_bytes());
+
+  // Once the first buffer is unused, it is released to make room.
+  in_use = Tensor();
+  Tensor other = pool.Allocate(DT_FLOAT, {2, 8});
+  EXPECT_EQ(1, pool.num_retained_tensors());
+  const void* other_data = other.tensor_data().data();
+  other = Tensor();
+  EXPECT_EQ(other_data, pool.Allocate(DT_FLOAT, {2, 8}).tensor_data().data());
+}
+
+TEST(BatchTensorPoolTest, AllocatesFromGivenAllocator) {
+  CountingAllocator allocator;
+  BatchTensorPool pool(/*max_tensors_per_key=*/1,
+                       std::numeric_limits<int64_t>::max(), &allocator);
+  Tensor merged;
+  TF_ASSERT_OK(pool.Concat({test::AsTensor<float>({1, 2}, {1, 2}),
+                            test::AsTensor<float>({3, 4}, {1, 2})},
+                           &merged));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2, 3, 4}, {2, 2}),
+                                 merged);
+  EXPECT_EQ(1, allocator.num_allocations());
+  // Recycled buffers are not allocated again.
+  merged = Tensor();
+  pool.Allocate(DT_FLOAT, {2, 2});
+  EXPECT_EQ(1, allocator.num_allocations());
+}
+
+TEST(BatchTensorPoolTest, Concat) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/1);
+  const Tensor a = test::AsTensor<float>({1, 2, 3, 4}, {2, 2});
+  const Tensor b = test::AsTensor<float>({5, 6}, {1, 2});
+  Tensor result;
+  TF_ASSERT_OK(pool.Concat({a, b}, &result));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {3, 2}), result);
+
+  // A second concatenation of the same shape lands in the recycled buffer.
+  const void* data = result.tensor_data().data();
+  result = Tensor();
+  TF_ASSERT_OK(pool.Concat({b, a}, &result));
+  EXPECT_EQ(data, result.tensor_data().data());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({5, 6, 1, 2, 3, 4}, {3, 2}), result);
+}
+
+TEST(BatchTensorPoolTest, ConcatStrings) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/1);
+  const Tensor a = test::AsTensor<tstring>({"a", "b"}, {2});
+  const Tensor b = test::AsTensor<tstring>({"c"}, {1});
+  Tensor result;
+  TF_ASSERT_OK(pool.Concat({a, b}, &result));
+  test::ExpectTensorEqual<tstring>(
+      test::AsTensor<tstring>({"a", "b", "c"}, {3}), result);
+}
+
+TEST(BatchTensorPoolTest, ConcatRejectsMismatchedShapes) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/1);
+  const Tensor a = test::AsTensor<float>({1, 2, 3, 4}, {2, 2});
+  const Tensor b = test::AsTensor<float>({5, 6, 7}, {1, 3});
+  Tensor result;
+  EXPECT_FALSE(pool.Concat({a, b}, &result).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -16,11 +16,55 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_BATCHING_BATCHING_OPTIONS_H_
 #define TENSORFLOW_SERVING_BATCHING_BATCHING_OPTIONS_H_
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/mutex.h"
+
 namespace tensorflow {
 namespace serving {
 
+// A ragged tensor (see tf.RaggedTensor) of one ragged dimension that a graph
+// takes or returns as two dense tensors: its flat values, and its row splits,
+// an int32 or int64 vector of one more entry than it has rows, which starts at
+// 0 and ends at the size of the 0th dimension of the values. Row i has the
+// values from row_splits[i] to row_splits[i + 1].
+struct RaggedTensorNames {
+  std::string values;
+  std::string row_splits;
+};
+
+// Allowed batch sizes (see BatchingOptions::allowed_batch_sizes) that can be
+// changed while a session batches with them.
+//
+// This class is thread-safe.
+class LiveAllowedBatchSizes {
+ public:
+  explicit LiveAllowedBatchSizes(std::vector<int> sizes)
+      : sizes_(std::make_shared<const std::vector<int>>(std::move(sizes))) {}
+
+  std::shared_ptr<const std::vector<int>> Get() const {
+    mutex_lock l(mu_);
+    return sizes_;
+  }
+
+  void Set(std::vector<int> sizes) {
+    auto new_sizes = std::make_shared<const std::vector<int>>(std::move(sizes));
+    mutex_lock l(mu_);
+    sizes_ = std::move(new_sizes);
+  }
+
+ private:
+  mutable mutex mu_;
+  std::shared_ptr<const std::vector<int>> sizes_ TF_GUARDED_BY(mu_);
+};
+
 // Batching options.
 struct BatchingOptions {
   // If set, restricts the allowed tensor batch sizes.
@@ -45,6 +89,13 @@ struct BatchingOptions {
   // If left empty, no rounding/padding is performed.
   std::vector<int> allowed_batch_sizes;
 
+  // If set, overrides 'allowed_batch_sizes' with the sizes it holds when each
+  // batch is formed. This lets the sizes change along with the max batch size
+  // of the queues while the session serves (see ReconfigurableBatchQueues).
+  //
+  // Currently only honored by BatchingSession.
+  std::shared_ptr<LiveAllowedBatchSizes> live_allowed_batch_sizes;
+
   // If set to true, padding is performed for tensors of the same name
   // but with unequal dimensions (modulo zeroth dimension), so that
   // all tensors of the same name have equal dim sizes.
@@ -75,6 +126,191 @@ struct BatchingOptions {
   // (modulo zeroth dimension) and this option is set to false,
   // then error Status will be returned.
   bool pad_variable_length_inputs = false;
+
+  // If non-empty, the tasks of each signature are bucketized by their padded
+  // dimension size, i.e. the largest size of any non-zeroth dimension among
+  // the task's input tensors, and each bucket gets its own batch scheduler
+  // (e.g. its own queue on a shared batch scheduler). Batches are thus formed
+  // from similarly shaped tasks, which bounds the padding added by
+  // 'pad_variable_length_inputs'.
+  //
+  // A task is routed to the first bucket whose boundary is greater than or
+  // equal to its padded dimension size; tasks larger than the last boundary
+  // share an extra, final bucket. For example, with boundaries [32, 128] a
+  // sequence of length 20 goes to bucket 0, 100 to bucket 1, and 512 to
+  // bucket 2.
+  //
+  // IMPORTANT: The entries must be in strictly increasing order.
+  std::vector<int64_t> padded_dim_bucket_boundaries;
+
+  // If true, along with 'pad_variable_length_inputs' and
+  // 'padded_dim_bucket_boundaries', the padded dimensions of each batch, i.e.
+  // those as large as its padded dimension size, are padded up to the boundary
+  // of its bucket rather than to the largest size in the batch. Every batch
+  // of a bucket then has the same shape, e.g. one that a TPU program was
+  // compiled for, so odd sizes do not trigger recompilations. Batches in the
+  // final bucket, above the last boundary, are padded as usual.
+  //
+  // Currently only honored by BatchingSession.
+  bool pad_to_bucket_boundaries = false;
+
+  // If set to true, batches are assembled with as little copying as possible:
+  //  - A batch consisting of one task that needs no padding is passed to the
+  //    wrapped session as-is, without concatenation.
+  //  - Otherwise, the merged input tensors are assembled into buffers that are
+  //    recycled across batches of the same shape (typically one of
+  //    'allowed_batch_sizes'), instead of freshly allocated ones.
+  //  - With 'pad_variable_length_inputs', the padded per-task tensors are
+  //    likewise allocated from recycled buffers.
+  //  - The per-task outputs are returned as slices that alias the batched
+  //    output tensors, instead of copies. (Slices that would violate the
+  //    tensor alignment requirements are still copied.)
+  //
+  // Since the per-task outputs alias the batched outputs, the memory of a
+  // batched output tensor is retained until all tasks of the batch have
+  // released their outputs.
+  //
+  // This option is useful for models with large per-request inputs or outputs
+  // (e.g. images or embeddings), where the copies dominate the batching
+  // overhead.
+  //
+  // Honored by BatchingSession and by the TFRT SavedModel batching wrapper.
+  bool enable_pooled_batch_assembly = false;
+
+  // If set, the merged input tensors of each batch are allocated from this
+  // allocator, which must outlive the session, instead of the default CPU
+  // allocator, and are recycled as with 'enable_pooled_batch_assembly'.
+  //
+  // This is intended for models that run on a GPU: with a pinned host memory
+  // allocator (e.g. the GPU host allocator of the process), the runtime copies
+  // each merged input to the device with a single asynchronous DMA transfer,
+  // rather than staging it through pinned memory first. Since pinned memory is
+  // expensive to allocate, recycling the buffers matters here. Batches whose
+  // rows are deduplicated (see 'enable_input_row_dedup') are still allocated
+  // from the CPU allocator.
+  //
+  // Currently only honored by BatchingSession.
+  Allocator* batch_input_allocator = nullptr;
+
+  // If set to true, signatures with the same input tensors share one batch
+  // scheduler: their tasks are batched together, and each batch fetches the
+  // union of their output tensors, of which each task receives the ones it
+  // requested. This yields fuller batches when a model is queried for
+  // different outputs of the same inputs (e.g. several heads of a multi-task
+  // model), at the cost of computing the outputs that only some of the tasks in
+  // a batch requested. Runs that fetch a subset of the outputs of a signature
+  // (e.g. Predict requests with an output filter) join its batches too, rather
+  // than being batched apart.
+  //
+  // Currently only honored by BatchingSession.
+  bool enable_joint_signature_batching = false;
+
+  // If set to true, a run of several signatures at once (e.g. for a
+  // MultiInference request) runs each of them as a separate task, batched with
+  // the other tasks of the signature, instead of running them together
+  // unbatched. This brings batching to MultiInference traffic, at the cost of
+  // the signatures no longer sharing the computation of their common inputs.
+  //
+  // Currently only honored by the TFRT SavedModel batching wrapper.
+  bool batch_multiple_signatures = false;
+
+  // If set to true, concurrent Run() calls hand their tasks to the batch
+  // scheduler through a lock-free ring buffer, from which one of the calling
+  // threads at a time forwards them (see combining_batch_scheduler.h), instead
+  // of all of them contending for the scheduler's queue mutex. This improves
+  // the per-core scalability of models that receive many small requests from
+  // many threads; with few concurrent requests it only adds overhead.
+  //
+  // Currently only honored by BatchingSession.
+  bool enable_combining_enqueue = false;
+
+  // If set to true, tasks issued with a sheddable criticality (see
+  // tsl/platform/criticality.h) are batched separately from critical tasks,
+  // each in its own lane with its own batch scheduler, and are only admitted
+  // while at most 'max_enqueued_critical_tasks_for_sheddable' critical tasks
+  // are waiting. Otherwise they fail with a retriable UNAVAILABLE error. This
+  // keeps latency-critical traffic from queueing behind bulk traffic, such as
+  // offline backfills, that shares the same model.
+  //
+  // Note that each lane of each signature is a separate queue, e.g. on a
+  // shared batch scheduler, so enabling this doubles the number of queues.
+  //
+  // Currently only honored by BatchingSession.
+  bool enable_criticality_lanes = false;
+
+  // See 'enable_criticality_lanes'.
+  int64_t max_enqueued_critical_tasks_for_sheddable = 0;
+
+  // If set to true, identical input rows within a batch are run through the
+  // wrapped session only once. When a batch is formed, the rows of the merged
+  // input tensors (one row per 0th-dimension entry, across all input tensors)
+  // are hashed and compared, only the distinct rows (padded to
+  // 'allowed_batch_sizes') are run, and the output rows are copied back to
+  // every row that had the same input.
+  //
+  // This option is useful when requests often repeat the same examples (e.g.
+  // popular items scored for many users), and requires the model to be a pure
+  // function of each input row: models whose outputs for one row depend on
+  // the other rows of the batch, or that are not deterministic, must not
+  // enable it. Batches whose inputs are not of a plain-old-data type or
+  // DT_STRING are run without deduplication.
+  //
+  // Currently only honored by BatchingSession.
+  bool enable_input_row_dedup = false;
+
+  // The ragged input and output tensors of the batched signatures, by name.
+  // Ragged tensors are merged without padding: the values of the tasks are
+  // concatenated, and their row splits are concatenated with those of each
+  // task offset by the values of the tasks before it. The rows of a ragged
+  // input count towards the 0th-dimension size of its task, which the other
+  // inputs share, and the padding rows of 'allowed_batch_sizes' are empty.
+  // Ragged outputs are split back into the rows of each task, by the batched
+  // row splits, which must be fetched along with the values.
+  //
+  // 'pad_variable_length_inputs' leaves ragged tensors alone, and
+  // 'enable_input_row_dedup' is ignored along with this option. Tasks with
+  // ragged inputs or outputs cannot be split, so the batch scheduler must not
+  // enable large batch splitting.
+  //
+  // Currently only honored by BatchingSession.
+  std::vector<RaggedTensorNames> ragged_tensors;
+
+  // If set, returns the cost of one row (0th-dimension entry) of a task with
+  // the given inputs. A task's size, as seen by the batch scheduler, is then
+  // its number of rows times this cost (at least 1), instead of its number of
+  // rows. So 'max_batch_size', 'max_execution_batch_size' and the splitting of
+  // large tasks (see SplitInputTask()) bound the estimated compute or memory
+  // of a batch rather than its number of rows.
+  //
+  // For example, MaxNonBatchDimSize() (see batching_util.h) makes a batch of
+  // 32 rows of 2k tokens cost as much as 4k rows of 16 tokens. Since the inputs
+  // are passed by name, a function can also apply a different formula to each
+  // signature.
+  //
+  // 'allowed_batch_sizes' and the padding of batches still count rows. Since
+  // the number of rows in a batch now depends on the inputs, the last allowed
+  // batch size need not match 'max_batch_size' in this case.
+  //
+  // Currently only honored by BatchingSession.
+  std::function<int64_t(const std::vector<std::pair<std::string, Tensor>>&)>
+      row_cost_func;
+
+  // If set to true, tasks whose RunOptions timeout expired while they waited
+  // in the batch queue fail with RESOURCE_EXHAUSTED and are left out of their
+  // batch, instead of being run anyway along with the unexpired tasks. (A
+  // batch whose tasks all expired always fails without running.) This avoids
+  // spending batch capacity on requests whose callers have given up.
+  //
+  // Currently only honored by BatchingSession.
+  bool shed_expired_tasks = false;
+
+  // The value of the 'model_name' label of the per-signature batching metrics
+  // (batch fill ratio, padding overhead, split tasks and queue depth) exported
+  // under /tensorflow/serving/batching_session/. May be left empty, e.g. if
+  // only one model is served.
+  //
+  // Currently only honored by BatchingSession.
+  std::string model_name;
 };
 
 }  // namespace serving
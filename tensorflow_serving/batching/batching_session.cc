@@ -17,15 +17,20 @@ limitations under the License.
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "absl/container/fixed_array.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
@@ -45,18 +50,25 @@ limitations under the License.
 #include "tensorflow/core/profiler/lib/traceme.h"
 #include "tensorflow/core/profiler/lib/traceme_encode.h"
 #include "tensorflow/core/public/session.h"
+#include "tensorflow_serving/batching/batch_tensor_pool.h"
 #include "tensorflow_serving/batching/batching_util.h"
+#include "tensorflow_serving/batching/bucketized_batch_scheduler.h"
+#include "tensorflow_serving/batching/combining_batch_scheduler.h"
 #include "tensorflow_serving/batching/incremental_barrier.h"
+#include "tensorflow_serving/batching/priority_batch_scheduler.h"
 #include "tensorflow_serving/batching/threadsafe_status.h"
 #include "tensorflow_serving/servables/tensorflow/serving_session.h"
+#include "tensorflow_serving/util/composite_tensor_util.h"
 #include "tensorflow_serving/util/hash.h"
+#include "tensorflow_serving/util/memory_accounting.h"
+#include "tensorflow_serving/util/sharded_metrics.h"
 
 namespace tensorflow {
 namespace serving {
 
 namespace {
 
-auto* queuing_latency = monitoring::Sampler<1>::New(
+auto* queuing_latency = ShardedSampler<1>::New(
     {"/tensorflow/serving/batching_session/queuing_latency",
      "Distribution of wall time spent (in microseconds) in queuing",
      "thread_pool_name"},
@@ -67,6 +79,64 @@ auto* wrapped_run_count = monitoring::Counter<0>::New(
     "/tensorflow/serving/batching_session/wrapped_run_count",
     "Total count of run calls on the wrapped session");
 
+auto* deduplicated_input_rows = monitoring::Counter<0>::New(
+    "/tensorflow/serving/batching_session/deduplicated_input_rows",
+    "Total count of batched input rows that were not run because an identical "
+    "row was run in the same batch");
+
+auto* shed_expired_tasks = monitoring::Counter<0>::New(
+    "/tensorflow/serving/batching_session/shed_expired_tasks",
+    "Total count of tasks left out of their batch because their timeout "
+    "expired while waiting in the batching queue");
+
+auto* cancelled_tasks = monitoring::Counter<0>::New(
+    "/tensorflow/serving/batching_session/cancelled_tasks",
+    "Total count of tasks left out of their batch because their request was "
+    "cancelled while waiting in the batching queue");
+
+// The per-signature metrics below are labelled by 'model_name' (see
+// BatchingOptions::model_name) and by 'signature' (see SignatureMetricLabel()).
+auto* batch_fill_ratio = monitoring::Sampler<2>::New(
+    {"/tensorflow/serving/batching_session/batch_fill_ratio",
+     "Distribution of the fraction of the rows of each batch run on the "
+     "wrapped session that come from tasks, i.e. are not batch padding",
+     "model_name", "signature"},
+    // Buckets [0.05, 0.1, ..., 1.0, DBL_MAX].
+    monitoring::Buckets::Explicit({0.05, 0.1, 0.15, 0.2, 0.25, 0.3, 0.35, 0.4,
+                                   0.45, 0.5, 0.55, 0.6, 0.65, 0.7, 0.75, 0.8,
+                                   0.85, 0.9, 0.95, 1.0}));
+
+auto* padding_overhead = monitoring::Sampler<2>::New(
+    {"/tensorflow/serving/batching_session/padding_overhead",
+     "Distribution of the ratio of the number of elements of the merged input "
+     "tensors of each batch to the number of elements of its tasks' inputs, "
+     "including both batch padding and variable-length input padding",
+     "model_name", "signature"},
+    // Exponential buckets [1*1.1^0, ..., 1*1.1^39 (~41), DBL_MAX].
+    monitoring::Buckets::Exponential(1, 1.1, 40));
+
+auto* split_tasks = monitoring::Counter<2>::New(
+    "/tensorflow/serving/batching_session/split_tasks",
+    "Total count of processed tasks that are splits of a larger task",
+    "model_name", "signature");
+
+auto* batch_stage_latency = ShardedSampler<3>::New(
+    {"/tensorflow/serving/batching_session/batch_stage_latency",
+     "Distribution of wall time (in microseconds) of the stages of batches: "
+     "the 'queue' wait of each task, and the 'merge' of the inputs, 'run' on "
+     "the wrapped session and 'split' of the outputs of each batch",
+     "model_name", "signature", "stage"},
+    // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+    monitoring::Buckets::Exponential(10, 1.8, 33));
+
+auto* queue_depth = monitoring::Sampler<2>::New(
+    {"/tensorflow/serving/batching_session/queue_depth",
+     "Distribution of the number of tasks waiting in the batch scheduler's "
+     "queue when a task is enqueued",
+     "model_name", "signature"},
+    // Exponential buckets [1*2^0, ..., 1*2^13, DBL_MAX].
+    monitoring::Buckets::Exponential(1, 2, 14));
+
 string TensorSignatureDebugString(const TensorSignature& signature) {
   return strings::StrCat("{input_tensors: <",
                          str_util::Join(signature.input_tensors, ", "),
@@ -74,6 +144,13 @@ string TensorSignatureDebugString(const TensorSignature& signature) {
                          str_util::Join(signature.output_tensors, ", "), ">}");
 }
 
+// Returns the value of the 'signature' label of the per-signature metrics, e.g.
+// "x:0,y:0->z:0" for input tensors "x:0" and "y:0" and output tensor "z:0".
+string SignatureMetricLabel(const TensorSignature& signature) {
+  return strings::StrCat(str_util::Join(signature.input_tensors, ","), "->",
+                         str_util::Join(signature.output_tensors, ","));
+}
+
 struct HashTensorSignature {
   uint64_t operator()(const TensorSignature& signature) const {
     uint64_t hash = 0xDECAFCAFFE /* seed */;
@@ -95,6 +172,41 @@ struct EqTensorSignature {
   }
 };
 
+// Merges the signatures in 'signatures' that have the same input tensors into
+// one joint signature, whose output tensors are the union of theirs and which
+// uses the scheduler creator of the first of them. Returns the resulting
+// signatures, and adds each signature that differs from its joint signature to
+// 'joint_signatures'.
+std::vector<SignatureWithBatchingSessionSchedulerCreator>
+JoinSignaturesWithSameInputs(
+    const std::vector<SignatureWithBatchingSessionSchedulerCreator>& signatures,
+    std::unordered_map<TensorSignature, TensorSignature, HashTensorSignature,
+                       EqTensorSignature>* joint_signatures) {
+  std::vector<SignatureWithBatchingSessionSchedulerCreator> joined_signatures;
+  std::map<std::set<string>, int> joined_index_by_inputs;
+  for (const auto& entry : signatures) {
+    auto it = joined_index_by_inputs.find(entry.signature.input_tensors);
+    if (it == joined_index_by_inputs.end()) {
+      joined_index_by_inputs[entry.signature.input_tensors] =
+          joined_signatures.size();
+      joined_signatures.push_back(entry);
+    } else {
+      joined_signatures[it->second].signature.output_tensors.insert(
+          entry.signature.output_tensors.begin(),
+          entry.signature.output_tensors.end());
+    }
+  }
+  for (const auto& entry : signatures) {
+    const TensorSignature& joint_signature =
+        joined_signatures[joined_index_by_inputs[entry.signature.input_tensors]]
+            .signature;
+    if (!EqTensorSignature()(entry.signature, joint_signature)) {
+      (*joint_signatures)[entry.signature] = joint_signature;
+    }
+  }
+  return joined_signatures;
+}
+
 // Constructs a TensorSignature from a Run() call's 'inputs' and
 // 'output_tensor_names' arguments.
 TensorSignature TensorSignatureFromRunArgs(
@@ -120,18 +232,209 @@ const std::vector<std::pair<string, Tensor>>& GetTaskInput(
   return *batching_session_task.inputs;
 }
 
-// Constructs vector of all task inputs from Batch of BatchingSessionTasks.
-// Input for each task is a vector of pairs (tensor_name, tensor_value).
-std::vector<std::vector<std::pair<string, Tensor>>> GetTaskInputsVector(
+// Constructs vector of all task inputs from Batch of BatchingSessionTasks,
+// except for shed tasks.
+// Input for each task is a vector of pairs (tensor_name, tensor_value). The
+// inputs are referenced rather than copied.
+std::vector<const std::vector<std::pair<string, Tensor>>*> GetTaskInputsVector(
     const Batch<BatchingSessionTask>& batch) {
-  std::vector<std::vector<std::pair<string, Tensor>>> all_task_inputs;
+  std::vector<const std::vector<std::pair<string, Tensor>>*> all_task_inputs;
   all_task_inputs.reserve(batch.num_tasks());
   for (int i = 0; i < batch.num_tasks(); ++i) {
-    all_task_inputs.push_back(GetTaskInput(batch.task(i)));
+    if (!batch.task(i).shed) {
+      all_task_inputs.push_back(&GetTaskInput(batch.task(i)));
+    }
   }
   return all_task_inputs;
 }
 
+// Returns the number of rows (0th-dimension entries) of the tasks in 'batch'
+// that are not shed. Equals batch.size() unless the tasks have a row cost other
+// than one or some are shed.
+int64_t NumRows(const Batch<BatchingSessionTask>& batch) {
+  int64_t num_rows = 0;
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    if (!batch.task(i).shed) {
+      num_rows += batch.task(i).zeroth_dim_size;
+    }
+  }
+  return num_rows;
+}
+
+// Returns the row splits of a ragged tensor of a batch of tasks whose own are
+// 'row_splits' (see ValidateRowSplits()), followed by 'num_padding_rows' empty
+// rows: the row splits of each task, offset by the number of values of the
+// tasks before it.
+template <typename T>
+Tensor MergeRowSplits(const std::vector<Tensor>& row_splits,
+                      int num_padding_rows) {
+  int64_t num_rows = num_padding_rows;
+  for (const Tensor& task_row_splits : row_splits) {
+    num_rows += task_row_splits.NumElements() - 1;
+  }
+  Tensor merged(DataTypeToEnum<T>::value, TensorShape({num_rows + 1}));
+  auto merged_flat = merged.flat<T>();
+  int64_t row = 0;
+  merged_flat(row++) = 0;
+  T offset = 0;
+  for (const Tensor& task_row_splits : row_splits) {
+    auto flat = task_row_splits.flat<T>();
+    for (int64_t i = 1; i < flat.size(); ++i) {
+      merged_flat(row++) = offset + flat(i);
+    }
+    offset += flat(flat.size() - 1);
+  }
+  for (int i = 0; i < num_padding_rows; ++i) {
+    merged_flat(row++) = offset;
+  }
+  return merged;
+}
+
+// Splits the batched 'row_splits' of a ragged output into those of the tasks
+// of the batch, of 'task_sizes' rows each, each starting at 0, and sets
+// 'value_sizes' to the number of values of each task.
+template <typename T>
+void SplitRowSplits(const Tensor& row_splits,
+                    absl::Span<const int64_t> task_sizes,
+                    std::vector<Tensor>* split_row_splits,
+                    std::vector<int64_t>* value_sizes) {
+  auto flat = row_splits.flat<T>();
+  int64_t row = 0;
+  for (const int64_t task_size : task_sizes) {
+    Tensor task_row_splits(DataTypeToEnum<T>::value,
+                           TensorShape({task_size + 1}));
+    auto task_flat = task_row_splits.flat<T>();
+    const T first = flat(row);
+    for (int64_t i = 0; i <= task_size; ++i) {
+      task_flat(i) = flat(row + i) - first;
+    }
+    value_sizes->push_back(flat(row + task_size) - first);
+    split_row_splits->push_back(std::move(task_row_splits));
+    row += task_size;
+  }
+}
+
+// Returns the key used to bucketize a task by its padded dimension size: the
+// largest size of any non-zeroth dimension among the task's input tensors.
+int64_t PaddedDimSize(const BatchingSessionTask& task) {
+  int64_t padded_dim_size = 0;
+  for (const auto& entry : GetTaskInput(task)) {
+    padded_dim_size =
+        std::max(padded_dim_size, MaxNonBatchDimSize(entry.second));
+  }
+  return padded_dim_size;
+}
+
+// Raises the padded dimensions of 'batch' in 'max_dim_sizes' (see
+// CalculateMaxDimSizes()), i.e. the non-zeroth dimensions as large as the
+// padded dimension size of the batch, to the boundary of the bucket of the
+// batch, so that every batch of a bucket has the same shape. A no-op for
+// batches above the last boundary.
+void RoundUpToBucketBoundary(
+    const Batch<BatchingSessionTask>& batch,
+    const std::vector<int64_t>& bucket_boundaries,
+    std::map<string, std::vector<int>>* max_dim_sizes) {
+  int64_t padded_dim_size = 0;
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    padded_dim_size = std::max(padded_dim_size, PaddedDimSize(batch.task(i)));
+  }
+  const auto boundary = std::lower_bound(
+      bucket_boundaries.begin(), bucket_boundaries.end(), padded_dim_size);
+  if (padded_dim_size == 0 || boundary == bucket_boundaries.end()) {
+    return;
+  }
+  for (auto& entry : *max_dim_sizes) {
+    std::vector<int>& dim_sizes = entry.second;
+    for (int d = 1; d < dim_sizes.size(); ++d) {
+      if (dim_sizes[d] == padded_dim_size) {
+        dim_sizes[d] = *boundary;
+      }
+    }
+  }
+}
+
+// Returns true if 'task' was issued with a sheddable criticality, i.e. it may
+// be served at a lower priority than critical tasks.
+bool IsSheddable(const BatchingSessionTask& task) {
+  return task.criticality == tsl::criticality::Criticality::kSheddablePlus ||
+         task.criticality == tsl::criticality::Criticality::kSheddable;
+}
+
+// Wraps 'scheduler_creator' such that the created scheduler separates critical
+// and sheddable tasks into two lanes, each with its own scheduler created by
+// 'scheduler_creator', and defers sheddable tasks while more than
+// 'max_enqueued_critical_tasks' critical tasks are waiting. If
+// 'enable_criticality_lanes' is false, returns 'scheduler_creator' as-is.
+BatchingSessionSchedulerCreator MaybeAddCriticalityLanesSchedulerCreator(
+    bool enable_criticality_lanes, int64_t max_enqueued_critical_tasks,
+    BatchingSessionSchedulerCreator scheduler_creator) {
+  if (!enable_criticality_lanes) {
+    return scheduler_creator;
+  }
+  return [max_enqueued_critical_tasks, scheduler_creator](
+             std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+                 process_batch_callback,
+             std::unique_ptr<BatchScheduler<BatchingSessionTask>>*
+                 batch_scheduler) {
+    std::unique_ptr<BatchScheduler<BatchingSessionTask>> critical_scheduler;
+    TF_RETURN_IF_ERROR(
+        scheduler_creator(process_batch_callback, &critical_scheduler));
+    std::unique_ptr<BatchScheduler<BatchingSessionTask>> sheddable_scheduler;
+    TF_RETURN_IF_ERROR(
+        scheduler_creator(process_batch_callback, &sheddable_scheduler));
+    PriorityBatchScheduler<BatchingSessionTask>::Options options;
+    options.is_low_priority_func = IsSheddable;
+    options.max_enqueued_high_priority_tasks = max_enqueued_critical_tasks;
+    std::unique_ptr<PriorityBatchScheduler<BatchingSessionTask>>
+        priority_scheduler;
+    TF_RETURN_IF_ERROR(PriorityBatchScheduler<BatchingSessionTask>::Create(
+        options, std::move(critical_scheduler), std::move(sheddable_scheduler),
+        &priority_scheduler));
+    *batch_scheduler = std::move(priority_scheduler);
+    return OkStatus();
+  };
+}
+
+// Wraps 'scheduler_creator' such that the created scheduler forwards the tasks
+// of concurrent Schedule() calls to the scheduler created by
+// 'scheduler_creator' one at a time, via a CombiningBatchScheduler. If
+// 'enable_combining_enqueue' is false, returns 'scheduler_creator' as-is.
+BatchingSessionSchedulerCreator MaybeCombineEnqueuesSchedulerCreator(
+    bool enable_combining_enqueue,
+    BatchingSessionSchedulerCreator scheduler_creator) {
+  if (!enable_combining_enqueue) {
+    return scheduler_creator;
+  }
+  return [scheduler_creator](
+             std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+                 process_batch_callback,
+             std::unique_ptr<BatchScheduler<BatchingSessionTask>>*
+                 batch_scheduler) {
+    std::unique_ptr<BatchScheduler<BatchingSessionTask>> wrapped;
+    TF_RETURN_IF_ERROR(scheduler_creator(process_batch_callback, &wrapped));
+    std::unique_ptr<CombiningBatchScheduler<BatchingSessionTask>>
+        combining_scheduler;
+    TF_RETURN_IF_ERROR(CombiningBatchScheduler<BatchingSessionTask>::Create(
+        {}, std::move(wrapped), &combining_scheduler));
+    *batch_scheduler = std::move(combining_scheduler);
+    return OkStatus();
+  };
+}
+
+// Applies the scheduler wrappers selected by 'options' to 'scheduler_creator'.
+BatchingSessionSchedulerCreator WrapSchedulerCreator(
+    const BatchingSessionOptions& options,
+    BatchingSessionSchedulerCreator scheduler_creator) {
+  return MaybeCombineEnqueuesSchedulerCreator(
+      options.enable_combining_enqueue,
+      MaybeAddCriticalityLanesSchedulerCreator(
+          options.enable_criticality_lanes,
+          options.max_enqueued_critical_tasks_for_sheddable,
+          MaybeBucketizeSchedulerCreator<BatchingSessionTask>(
+              options.padded_dim_bucket_boundaries, PaddedDimSize,
+              std::move(scheduler_creator))));
+}
+
 }  // namespace
 
 TensorSignature TensorSignatureFromSignatureDef(
@@ -223,6 +526,16 @@ class BatchingSession : public ServingSession {
              std::vector<Tensor>* outputs, RunMetadata* run_metadata,
              const thread::ThreadPoolOptions& thread_pool_options) override;
 
+  // Schedules the run like Run(), but returns without waiting for its batch.
+  // Unless the run fails before it is scheduled, 'done' is called from the
+  // batch thread, once the batch is processed.
+  void RunAsync(const RunOptions& run_options,
+                const std::vector<std::pair<string, Tensor>>& inputs,
+                const std::vector<string>& output_tensor_names,
+                const std::vector<string>& target_node_names,
+                std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+                std::function<void(const Status&)> done) override;
+
   Status ListDevices(std::vector<DeviceAttributes>* response) override;
 
  private:
@@ -238,6 +551,17 @@ class BatchingSession : public ServingSession {
       std::vector<Tensor>* outputs, RunMetadata* run_metadata,
       absl::optional<thread::ThreadPoolOptions> thread_pool_options);
 
+  // Like InternalRun(), but calls 'done' with the status rather than waiting
+  // for it.
+  void InternalRunAsync(
+      const RunOptions& run_options,
+      const std::vector<std::pair<string, Tensor>>& inputs,
+      const std::vector<string>& output_tensor_names,
+      const std::vector<string>& target_node_names,
+      std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+      absl::optional<thread::ThreadPoolOptions> thread_pool_options,
+      std::function<void(const Status&)> done);
+
   // Computes the size of an input tensor list for batching purposes, by
   // analyzing the 0th dimension size of each of the tensors. All tensors in the
   // list must have the same 0th dimension size to be batchable. If the sizes
@@ -245,6 +569,16 @@ class BatchingSession : public ServingSession {
   Status ComputeInputSize(const std::vector<std::pair<string, Tensor>>& inputs,
                           size_t* size) const;
 
+  // Like ComputeInputSize(), for inputs with ragged tensors (see
+  // 'options_.ragged_tensors'), whose size is their number of rows.
+  Status ComputeRaggedInputSize(
+      const std::vector<std::pair<string, Tensor>>& inputs,
+      size_t* size) const;
+
+  // Whether some of 'tensors' are the values or row splits of ragged tensors.
+  bool HasRaggedTensors(
+      const std::vector<std::pair<string, Tensor>>& tensors) const;
+
   // Merges the input tensors in a batch, via concatenation of correspondingly-
   // named tensors. Puts the merged inputs in the order they are in in the
   // signature. Assumes 'batch' is non-empty. Returns an error if there are any
@@ -252,12 +586,31 @@ class BatchingSession : public ServingSession {
   // batchability.
   Status MergeInputTensors(
       const TensorSignature& signature, const Batch<BatchingSessionTask>& batch,
+      absl::Span<const int> allowed_batch_sizes,
       std::vector<std::pair<string, Tensor>>* merged_inputs);
 
+  // If 'options_.enable_input_row_dedup' is set and 'merged_inputs' has
+  // duplicate rows, replaces 'merged_inputs' with its distinct rows (padded to
+  // the allowed batch sizes) and sets 'row_to_unique' to the mapping from
+  // each original row to its distinct row (see FindUniqueRows()). Otherwise
+  // leaves 'merged_inputs' as is and clears 'row_to_unique'.
+  Status DeduplicateInputRows(
+      absl::Span<const int> allowed_batch_sizes,
+      std::vector<std::pair<string, Tensor>>* merged_inputs,
+      std::vector<int64_t>* row_to_unique);
+
+  // Undoes DeduplicateInputRows() on the outputs of the batched call, which
+  // ran 'num_batched_rows' rows, by copying the output rows of each distinct
+  // row to all its occurrences.
+  Status ExpandOutputRows(int64_t num_batched_rows,
+                          absl::Span<const int64_t> row_to_unique,
+                          std::vector<Tensor>* combined_outputs);
+
   // Splits the output of a batched call to 'wrapped_->Run()' into individual
   // task outputs. Assumes the output tensor order matches the signature.
   Status SplitOutputTensors(const TensorSignature& signature,
                             const std::vector<Tensor>& combined_outputs,
+                            absl::Span<const int> allowed_batch_sizes,
                             Batch<BatchingSessionTask>* batch);
 
   // Splits RunMetadata parts (e.g. costgraph attribution) into individual task
@@ -265,6 +618,17 @@ class BatchingSession : public ServingSession {
   Status SplitRunMetadata(RunMetadata* batch_metadata,
                           Batch<BatchingSessionTask>* batch);
 
+  // Records the per-signature metrics of 'batch', whose inputs were merged
+  // into 'merged_inputs' by MergeInputTensors().
+  void RecordBatchMetrics(
+      const TensorSignature& signature, const Batch<BatchingSessionTask>& batch,
+      const std::vector<std::pair<string, Tensor>>& merged_inputs) const;
+
+  // Returns the signature in 'batch_schedulers_' whose batches runs with
+  // 'signature' join, see 'output_subset_signatures_'.
+  const TensorSignature* FindBatchSignatureWithOutputs(
+      const TensorSignature& signature) ABSL_LOCKS_EXCLUDED(mu_);
+
   // Processes one batch of Run() calls with 'signature'. Called by
   // 'batch_scheduler_' in a batch thread.
   void ProcessBatch(const TensorSignature& signature,
@@ -276,11 +640,20 @@ class BatchingSession : public ServingSession {
   const std::string thread_pool_name_;
 
   std::unique_ptr<Session> wrapped_;
+  // Runs 'wrapped_', through its callables if it implements them.
+  std::unique_ptr<SessionCallables> wrapped_callables_;
   std::unordered_map<TensorSignature,
                      std::unique_ptr<BatchScheduler<BatchingSessionTask>>,
                      HashTensorSignature, EqTensorSignature>
       batch_schedulers_;
 
+  // If 'options_.enable_joint_signature_batching' is set, maps each signature
+  // that is batched jointly with others to their joint signature, whose batch
+  // scheduler in 'batch_schedulers_' it uses.
+  std::unordered_map<TensorSignature, TensorSignature, HashTensorSignature,
+                     EqTensorSignature>
+      joint_signatures_;
+
   // If set, default_scheduler_creator_ is used when the input signature does
   // not match any existing signature defined during model load. This helps
   // when the user uses either a combination of signatures or filter certain
@@ -292,6 +665,27 @@ class BatchingSession : public ServingSession {
                      HashTensorSignature, EqTensorSignature>
       custom_signature_batch_schedulers_ ABSL_GUARDED_BY(mu_);
 
+  // If 'options_.enable_joint_signature_batching' is set, maps the signatures
+  // of runs that fetch a subset of the outputs of a signature in
+  // 'batch_schedulers_' (e.g. with the output filter of a Predict request) to
+  // that signature, whose batches they join, or to null if there is none. Holds
+  // up to kMaxOutputSubsetSignatures entries.
+  static constexpr int kMaxOutputSubsetSignatures = 1024;
+  std::unordered_map<TensorSignature, const TensorSignature*,
+                     HashTensorSignature, EqTensorSignature>
+      output_subset_signatures_ ABSL_GUARDED_BY(mu_);
+
+  // Recycled buffers for merged and for padded per-task input tensors. Only
+  // used if 'options_.enable_pooled_batch_assembly' is true. The pools are
+  // keyed by (dtype, shape), which also keeps different signatures apart.
+  BatchTensorPool merged_input_pool_;
+  BatchTensorPool padded_input_pool_;
+
+  // The ragged tensors of 'options_.ragged_tensors': the name of the row splits
+  // of each by the name of its values, and the names of the row splits.
+  std::map<string, string> ragged_row_splits_by_values_;
+  std::set<string> ragged_row_splits_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(BatchingSession);
 };
 
@@ -305,7 +699,8 @@ Status BatchingSession::Create(
   auto status = BatchingSession::Create(options, std::move(wrapped),
                                         signatures_with_scheduler_creators,
                                         thread_pool_name, result);
-  result->get()->default_scheduler_creator_ = default_creator;
+  result->get()->default_scheduler_creator_ =
+      WrapSchedulerCreator(options, default_creator);
   return status;
 }
 
@@ -319,11 +714,20 @@ Status BatchingSession::Create(
       new BatchingSession(options, thread_pool_name));
   BatchingSession* raw_batching_session = batching_session.get();
   batching_session->wrapped_ = std::move(wrapped);
-
-  for (const auto& entry : signatures_with_scheduler_creators) {
+  batching_session->wrapped_callables_.reset(
+      new SessionCallables(batching_session->wrapped_.get()));
+
+  const std::vector<SignatureWithBatchingSessionSchedulerCreator>
+      batched_signatures =
+          options.enable_joint_signature_batching
+              ? JoinSignaturesWithSameInputs(
+                    signatures_with_scheduler_creators,
+                    &batching_session->joint_signatures_)
+              : signatures_with_scheduler_creators;
+  for (const auto& entry : batched_signatures) {
     const TensorSignature& signature = entry.signature;
-    const BatchingSessionSchedulerCreator& scheduler_creator =
-        entry.scheduler_creator;
+    const BatchingSessionSchedulerCreator scheduler_creator =
+        WrapSchedulerCreator(options, entry.scheduler_creator);
 
     std::unique_ptr<BatchScheduler<BatchingSessionTask>> batch_scheduler;
     TF_RETURN_IF_ERROR(scheduler_creator(
@@ -371,6 +775,16 @@ Status BatchingSession::Run(
                      thread_pool_options);
 }
 
+void BatchingSession::RunAsync(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
+    RunMetadata* run_metadata, std::function<void(const Status&)> done) {
+  InternalRunAsync(run_options, inputs, output_tensor_names, target_node_names,
+                   outputs, run_metadata, absl::nullopt, std::move(done));
+}
+
 Status BatchingSession::InternalRun(
     const RunOptions& run_options,
     const std::vector<std::pair<string, Tensor>>& inputs,
@@ -378,9 +792,40 @@ Status BatchingSession::InternalRun(
     const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
     RunMetadata* run_metadata,
     absl::optional<thread::ThreadPoolOptions> thread_pool_options) {
+  Notification done;
+  Status status;
+  InternalRunAsync(run_options, inputs, output_tensor_names, target_node_names,
+                   outputs, run_metadata, std::move(thread_pool_options),
+                   [&done, &status](const Status& run_status) {
+                     status = run_status;
+                     done.Notify();
+                   });
+  done.WaitForNotification();
+  return status;
+}
+
+void BatchingSession::InternalRunAsync(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
+    RunMetadata* run_metadata,
+    absl::optional<thread::ThreadPoolOptions> thread_pool_options,
+    std::function<void(const Status&)> done) {
   if (!target_node_names.empty()) {
-    return errors::PermissionDenied(
-        "BatchingSession does not support target nodes");
+    done(errors::PermissionDenied(
+        "BatchingSession does not support target nodes"));
+    return;
+  }
+
+  // Charge the time the request has spent so far against the timeout, so the
+  // deadline of the task below is that of the request.
+  RunOptions charged_run_options = run_options;
+  const Status deadline_status =
+      ApplyCurrentRequestDeadline(&charged_run_options);
+  if (!deadline_status.ok()) {
+    done(deadline_status);
+    return;
   }
 
   profiler::TraceMe trace_me([this] {
@@ -388,71 +833,144 @@ Status BatchingSession::InternalRun(
         "BatchingSessionRun",
         {{"thread_pool_name", thread_pool_name_}, {"_r", 1} /*root_event*/});
   });
-  const TensorSignature signature =
+  TensorSignature signature =
       TensorSignatureFromRunArgs(inputs, output_tensor_names);
+  auto joint_signature_it = joint_signatures_.find(signature);
+  if (joint_signature_it != joint_signatures_.end()) {
+    signature = joint_signature_it->second;
+  }
+  BatchScheduler<BatchingSessionTask>* batch_scheduler = nullptr;
   auto batch_scheduler_it = batch_schedulers_.find(signature);
-  if (batch_scheduler_it == batch_schedulers_.end()) {
-    if (default_scheduler_creator_.has_value()) {
-      absl::MutexLock l(&mu_);
-      batch_scheduler_it = custom_signature_batch_schedulers_.find(signature);
-      if (batch_scheduler_it == custom_signature_batch_schedulers_.end()) {
-        std::unique_ptr<BatchScheduler<BatchingSessionTask>> batch_scheduler;
-        TF_RETURN_IF_ERROR(default_scheduler_creator_.value()(
-            [&, signature](std::unique_ptr<Batch<BatchingSessionTask>> batch) {
-              ProcessBatch(signature, std::move(batch));
-            },
-            &batch_scheduler));
-        custom_signature_batch_schedulers_[signature] =
-            std::move(batch_scheduler);
-        batch_scheduler_it = custom_signature_batch_schedulers_.find(signature);
+  if (batch_scheduler_it == batch_schedulers_.end() &&
+      options_.enable_joint_signature_batching) {
+    const TensorSignature* batch_signature =
+        FindBatchSignatureWithOutputs(signature);
+    if (batch_signature != nullptr) {
+      signature = *batch_signature;
+      batch_scheduler_it = batch_schedulers_.find(signature);
+    }
+  }
+  if (batch_scheduler_it != batch_schedulers_.end()) {
+    batch_scheduler = batch_scheduler_it->second.get();
+  } else if (default_scheduler_creator_.has_value()) {
+    // Look the scheduler up under a shared lock first, so that concurrent
+    // requests for existing custom signatures do not serialize here.
+    {
+      absl::ReaderMutexLock l(&mu_);
+      auto it = custom_signature_batch_schedulers_.find(signature);
+      if (it != custom_signature_batch_schedulers_.end()) {
+        batch_scheduler = it->second.get();
       }
-    } else {
-      // We have a Run() call that doesn't match one of our batching signatures.
-      // Run it in-line.
-      LOG_EVERY_N_SEC(WARNING, 120)
-          << "Request doesn't match any declared signature and no default "
-             "scheduler creator specified. Bypassing "
-             "batcher. Request signature is: "
-          << TensorSignatureDebugString(signature);
-
-      // Because the wrapped session may not provide an implementation for
-      // thread_pool_options, we need to invoke different Run() functions
-      // depending on whether thread_pool_options is specified.
-      if (thread_pool_options) {
-        return wrapped_->Run(run_options, inputs, output_tensor_names,
-                             target_node_names, outputs, run_metadata,
-                             thread_pool_options.value());
-      } else {
-        return wrapped_->Run(run_options, inputs, output_tensor_names,
-                             target_node_names, outputs, run_metadata);
+    }
+    if (batch_scheduler == nullptr) {
+      Status create_status;
+      {
+        absl::MutexLock l(&mu_);
+        std::unique_ptr<BatchScheduler<BatchingSessionTask>>&
+            custom_scheduler = custom_signature_batch_schedulers_[signature];
+        if (custom_scheduler == nullptr) {
+          create_status = default_scheduler_creator_.value()(
+              [this,
+               signature](std::unique_ptr<Batch<BatchingSessionTask>> batch) {
+                ProcessBatch(signature, std::move(batch));
+              },
+              &custom_scheduler);
+        }
+        if (create_status.ok()) {
+          batch_scheduler = custom_scheduler.get();
+        } else {
+          custom_signature_batch_schedulers_.erase(signature);
+        }
+      }
+      if (!create_status.ok()) {
+        done(create_status);
+        return;
       }
     }
+  } else {
+    // We have a Run() call that doesn't match one of our batching signatures.
+    // Run it in-line.
+    LOG_EVERY_N_SEC(WARNING, 120)
+        << "Request doesn't match any declared signature and no default "
+           "scheduler creator specified. Bypassing "
+           "batcher. Request signature is: "
+        << TensorSignatureDebugString(signature);
+
+    // The wrapped session may not provide an implementation for
+    // thread_pool_options, so they are only passed on if specified.
+    done(wrapped_callables_->Run(
+        charged_run_options, inputs, output_tensor_names, target_node_names,
+        outputs, run_metadata,
+        thread_pool_options ? &thread_pool_options.value() : nullptr));
+    return;
   }
-  BatchScheduler<BatchingSessionTask>* batch_scheduler =
-      batch_scheduler_it->second.get();
 
   outputs->clear();
 
-  Notification done;
-  Status status;
   auto task = std::unique_ptr<BatchingSessionTask>(new BatchingSessionTask);
   task->enqueue_time_micros = EnvTime::NowMicros();
-  task->run_options = run_options;
-  TF_RETURN_IF_ERROR(ComputeInputSize(inputs, &task->zeroth_dim_size));
+  task->criticality = tsl::criticality::GetCriticality();
+  task->request_deadline = RequestDeadline::Current();
+  task->trace = CurrentTrace();
+  task->run_options = charged_run_options;
+  const Status input_size_status =
+      ComputeInputSize(inputs, &task->zeroth_dim_size);
+  if (!input_size_status.ok()) {
+    done(input_size_status);
+    return;
+  }
+  if (options_.row_cost_func) {
+    task->row_cost = std::max<int64_t>(1, options_.row_cost_func(inputs));
+  }
+  task->has_ragged_inputs = HasRaggedTensors(inputs);
   task->inputs = &inputs;
   task->output_tensor_names = &output_tensor_names;
-  task->done = &done;
-  task->status = &status;
+  task->done = std::move(done);
   task->outputs = outputs;
   task->run_metadata = run_metadata;
   task->thread_pool_options = thread_pool_options;
   task->thread_safe_status = std::make_shared<ThreadSafeStatus>();
-  task->shared_outputs = std::make_shared<std::vector<std::vector<Tensor>>>();
   task->split_run_metadatas = absl::make_unique<std::vector<RunMetadata>>();
 
-  TF_RETURN_IF_ERROR(batch_scheduler->Schedule(&task));
-  done.WaitForNotification();
-  return status;
+  queue_depth->GetCell(options_.model_name, SignatureMetricLabel(signature))
+      ->Add(batch_scheduler->NumEnqueuedTasks());
+  const Status schedule_status = batch_scheduler->Schedule(&task);
+  if (!schedule_status.ok()) {
+    // The task is left with us, and was not run.
+    task->done(schedule_status);
+  }
+}
+
+const TensorSignature* BatchingSession::FindBatchSignatureWithOutputs(
+    const TensorSignature& signature) {
+  {
+    absl::ReaderMutexLock l(&mu_);
+    auto it = output_subset_signatures_.find(signature);
+    if (it != output_subset_signatures_.end()) {
+      return it->second;
+    }
+  }
+  // Of the signatures with the same inputs and all of the outputs, the one
+  // with the fewest outputs computes the fewest unrequested ones.
+  const TensorSignature* batch_signature = nullptr;
+  for (const auto& entry : batch_schedulers_) {
+    const TensorSignature& candidate = entry.first;
+    if (candidate.input_tensors == signature.input_tensors &&
+        std::includes(candidate.output_tensors.begin(),
+                      candidate.output_tensors.end(),
+                      signature.output_tensors.begin(),
+                      signature.output_tensors.end()) &&
+        (batch_signature == nullptr ||
+         candidate.output_tensors.size() <
+             batch_signature->output_tensors.size())) {
+      batch_signature = &candidate;
+    }
+  }
+  absl::MutexLock l(&mu_);
+  if (output_subset_signatures_.size() < kMaxOutputSubsetSignatures) {
+    output_subset_signatures_[signature] = batch_signature;
+  }
+  return batch_signature;
 }
 
 Status BatchingSession::ListDevices(std::vector<DeviceAttributes>* response) {
@@ -461,10 +979,25 @@ Status BatchingSession::ListDevices(std::vector<DeviceAttributes>* response) {
 
 BatchingSession::BatchingSession(const BatchingSessionOptions& options,
                                  const std::string& thread_pool_name)
-    : options_(options), thread_pool_name_(thread_pool_name) {}
+    : options_(options),
+      thread_pool_name_(thread_pool_name),
+      merged_input_pool_(kMaxPooledBatchTensorsPerShape,
+                         std::numeric_limits<int64_t>::max(),
+                         options.batch_input_allocator),
+      padded_input_pool_(kMaxPooledBatchTensorsPerShape,
+                         kMaxPooledPaddedInputBytes) {
+  for (const RaggedTensorNames& ragged_tensor : options.ragged_tensors) {
+    ragged_row_splits_by_values_[ragged_tensor.values] =
+        ragged_tensor.row_splits;
+    ragged_row_splits_.insert(ragged_tensor.row_splits);
+  }
+}
 
 Status BatchingSession::ComputeInputSize(
     const std::vector<std::pair<string, Tensor>>& inputs, size_t* size) const {
+  if (HasRaggedTensors(inputs)) {
+    return ComputeRaggedInputSize(inputs, size);
+  }
   TF_RETURN_IF_ERROR(::tensorflow::serving::ComputeTensorBatchSize(
       inputs, size,
       [](const std::pair<std::string, Tensor>& tensor) {
@@ -480,8 +1013,80 @@ Status BatchingSession::ComputeInputSize(
   return OkStatus();
 }
 
+Status BatchingSession::ComputeRaggedInputSize(
+    const std::vector<std::pair<string, Tensor>>& inputs, size_t* size) const {
+  absl::optional<int64_t> num_rows;
+  for (const auto& entry : inputs) {
+    const Tensor& tensor = entry.second;
+    int64_t tensor_rows;
+    if (ragged_row_splits_.count(entry.first) > 0) {
+      TF_RETURN_IF_ERROR(ValidateRowSplits(entry.first, tensor));
+      tensor_rows = tensor.dim_size(0) - 1;
+    } else if (tensor.dims() == 0) {
+      return errors::InvalidArgument(
+          "Batching Run() input tensors must have at least one dimension");
+    } else if (ragged_row_splits_by_values_.count(entry.first) > 0) {
+      // Checked against its row splits below.
+      continue;
+    } else {
+      tensor_rows = tensor.dim_size(0);
+    }
+    if (num_rows.has_value() && *num_rows != tensor_rows) {
+      return errors::InvalidArgument(
+          "Batching Run() input tensors must have equal 0th-dimension size, "
+          "and ragged ones as many rows");
+    }
+    num_rows = tensor_rows;
+    RecordInputBatchSize<BatchingSessionTask>(tensor_rows);
+  }
+  for (const auto& entry : inputs) {
+    auto row_splits_name = ragged_row_splits_by_values_.find(entry.first);
+    if (row_splits_name == ragged_row_splits_by_values_.end()) {
+      continue;
+    }
+    auto row_splits = std::find_if(
+        inputs.begin(), inputs.end(),
+        [&row_splits_name](const std::pair<string, Tensor>& input) {
+          return input.first == row_splits_name->second;
+        });
+    if (row_splits == inputs.end()) {
+      return errors::InvalidArgument("The ragged tensor values '", entry.first,
+                                     "' must be fed with their row splits '",
+                                     row_splits_name->second, "'");
+    }
+    const Tensor& splits = row_splits->second;
+    if (RowSplit(splits, splits.dim_size(0) - 1) != entry.second.dim_size(0)) {
+      return errors::InvalidArgument(
+          "The row splits '", row_splits_name->second,
+          "' must end at the 0th-dimension size of the ragged tensor values '",
+          entry.first, "'");
+    }
+  }
+  if (!num_rows.has_value()) {
+    return errors::InvalidArgument(
+        "Batching Run() must have at least one input tensor");
+  }
+  *size = *num_rows;
+  return OkStatus();
+}
+
+bool BatchingSession::HasRaggedTensors(
+    const std::vector<std::pair<string, Tensor>>& tensors) const {
+  if (ragged_row_splits_.empty()) {
+    return false;
+  }
+  for (const auto& entry : tensors) {
+    if (ragged_row_splits_.count(entry.first) > 0 ||
+        ragged_row_splits_by_values_.count(entry.first) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 Status BatchingSession::MergeInputTensors(
     const TensorSignature& signature, const Batch<BatchingSessionTask>& batch,
+    absl::Span<const int> allowed_batch_sizes,
     std::vector<std::pair<string, Tensor>>* merged_inputs) {
   DCHECK_GE(batch.num_tasks(), 1);
   if (batch.num_tasks() < 1) {
@@ -489,9 +1094,10 @@ Status BatchingSession::MergeInputTensors(
                             batch.num_tasks());
   }
 
+  const int num_rows = NumRows(batch);
   const int lowest_allowed_batch_size =
-      RoundToLowestAllowedBatchSize(options_.allowed_batch_sizes, batch.size());
-  const int padding_size = lowest_allowed_batch_size - batch.size();
+      RoundToLowestAllowedBatchSize(allowed_batch_sizes, num_rows);
+  const int padding_size = lowest_allowed_batch_size - num_rows;
   profiler::TraceMe trace_me([lowest_allowed_batch_size, padding_size]() {
     return profiler::TraceMeEncode(
         "MergeInputTensors",
@@ -508,12 +1114,24 @@ Status BatchingSession::MergeInputTensors(
   // among tensors from individual tasks.
   absl::optional<std::map<string, std::vector<int>>> max_dim_sizes;
   if (options_.pad_variable_length_inputs) {
-    std::vector<std::vector<std::pair<string, Tensor>>> all_task_inputs =
-        GetTaskInputsVector(batch);
+    const std::vector<const std::vector<std::pair<string, Tensor>>*>
+        all_task_inputs = GetTaskInputsVector(batch);
     max_dim_sizes = CalculateMaxDimSizes(all_task_inputs);
+    if (options_.pad_to_bucket_boundaries) {
+      RoundUpToBucketBoundary(batch, options_.padded_dim_bucket_boundaries,
+                              &*max_dim_sizes);
+    }
+  }
+  // The padding goes after the last task that is not shed.
+  int last_task = batch.num_tasks() - 1;
+  while (last_task > 0 && batch.task(last_task).shed) {
+    --last_task;
   }
   // Populate 'tensors_to_merge'.
   for (int i = 0; i < batch.num_tasks(); ++i) {
+    if (batch.task(i).shed) {
+      continue;
+    }
     const std::vector<std::pair<string, Tensor>>& task_inputs =
         GetTaskInput(batch.task(i));
     for (const auto& entry : task_inputs) {
@@ -521,29 +1139,42 @@ Status BatchingSession::MergeInputTensors(
       const Tensor& tensor = entry.second;
 
       std::vector<Tensor>& tensor_vec = tensors_to_merge[tensor_name];
-      Tensor optionally_padded_tensor;
+      if (!ragged_row_splits_.empty() &&
+          (ragged_row_splits_.count(tensor_name) > 0 ||
+           ragged_row_splits_by_values_.count(tensor_name) > 0)) {
+        // Merged without padding, below.
+        if (!tensor_vec.empty() &&
+            (tensor.dtype() != tensor_vec[0].dtype() ||
+             !AreShapesEqualExceptZeroDim(tensor.shape(),
+                                          tensor_vec[0].shape()))) {
+          return errors::FailedPrecondition(
+              "Ragged tensors '", tensor_name,
+              "' from different tasks have different types, or shapes "
+              "beyond the 0th dimension");
+        }
+        tensor_vec.push_back(tensor);
+        continue;
+      }
       if (options_.pad_variable_length_inputs) {
-        TF_RETURN_IF_ERROR(AddPadding(tensor, (*max_dim_sizes)[tensor_name],
-                                      &optionally_padded_tensor));
-      } else {
-        optionally_padded_tensor = tensor;
-        // Check whether tensors with the same name have equal dims
-        // (except zeroth dim) when padding is turned off.
-        if (i > 0) {  // added at least one task to tensors_to_merge
-          TensorShape reference_shape =
-              tensors_to_merge[tensor_name][0].shape();
-          if (!AreShapesEqualExceptZeroDim(tensor.shape(), reference_shape)) {
-            return errors::FailedPrecondition(
-                "Tensors with name '" + tensor_name +
-                "' from different tasks have different shapes and padding is "
-                "turned off. Set pad_variable_length_inputs to true, or ensure "
-                "that all tensors with the same name have equal dimensions "
-                "starting with the first dim.");
-          }
+        // Padded as they are merged, below.
+        tensor_vec.push_back(tensor);
+        continue;
+      }
+      // Check whether tensors with the same name have equal dims
+      // (except zeroth dim) when padding is turned off.
+      if (!tensor_vec.empty()) {  // added at least one task
+        TensorShape reference_shape = tensor_vec[0].shape();
+        if (!AreShapesEqualExceptZeroDim(tensor.shape(), reference_shape)) {
+          return errors::FailedPrecondition(
+              "Tensors with name '" + tensor_name +
+              "' from different tasks have different shapes and padding is "
+              "turned off. Set pad_variable_length_inputs to true, or ensure "
+              "that all tensors with the same name have equal dimensions "
+              "starting with the first dim.");
         }
       }
-      tensor_vec.push_back(std::move(optionally_padded_tensor));
-      if (i == batch.num_tasks() - 1 && padding_size > 0) {
+      tensor_vec.push_back(tensor);
+      if (i == last_task && padding_size > 0) {
         // This is the last task. Insert padding.
         //
         // Use the first row of this task's tensor as the padding data. (We know
@@ -573,8 +1204,61 @@ Status BatchingSession::MergeInputTensors(
       return errors::Internal(
           "One or more tasks does not conform to batch signature");
     }
+    if (ragged_row_splits_.count(tensor_name) > 0) {
+      merged_inputs->push_back(
+          {tensor_name,
+           tensors->second[0].dtype() == DT_INT32
+               ? MergeRowSplits<int32>(tensors->second, padding_size)
+               : MergeRowSplits<int64_t>(tensors->second, padding_size)});
+      continue;
+    }
     Tensor concated;
-    const Status concat_status = tensor::Concat(tensors->second, &concated);
+    if (options_.pad_variable_length_inputs &&
+        ragged_row_splits_by_values_.count(tensor_name) == 0) {
+      const std::vector<int>& input_max_dim_sizes =
+          (*max_dim_sizes)[tensor_name];
+      // Most inputs are laid out in the merged tensor, padded, in one pass. A
+      // lone task is left to the path below, which may not copy it at all.
+      if ((tensors->second.size() > 1 || padding_size > 0) &&
+          PadAndConcat(tensors->second, input_max_dim_sizes, padding_size,
+                       options_.batch_input_allocator != nullptr ||
+                               options_.enable_pooled_batch_assembly
+                           ? &merged_input_pool_
+                           : nullptr,
+                       &concated)) {
+        merged_inputs->push_back({tensor_name, std::move(concated)});
+        continue;
+      }
+      // Else pad the tensors of the tasks one by one, to concatenate them.
+      for (Tensor& tensor : tensors->second) {
+        Tensor padded_tensor;
+        TF_RETURN_IF_ERROR(AddPadding(
+            tensor, input_max_dim_sizes,
+            options_.enable_pooled_batch_assembly ? &padded_input_pool_
+                                                  : nullptr,
+            &padded_tensor));
+        tensor = std::move(padded_tensor);
+      }
+      if (padding_size > 0) {
+        // As above, the padding repeats the first row of the last task.
+        const Tensor padding_tensor = tensors->second.back().Slice(0, 1);
+        for (int i = 0; i < padding_size; ++i) {
+          tensors->second.push_back(padding_tensor);
+        }
+      }
+    }
+    Status concat_status;
+    if (options_.batch_input_allocator != nullptr) {
+      // Copied even for a lone task, which is not in the allocator's memory.
+      concat_status = merged_input_pool_.Concat(tensors->second, &concated);
+    } else if (!options_.enable_pooled_batch_assembly) {
+      concat_status = tensor::Concat(tensors->second, &concated);
+    } else if (tensors->second.size() == 1) {
+      // A lone task without padding is already laid out as a batch.
+      concated = tensors->second[0];
+    } else {
+      concat_status = merged_input_pool_.Concat(tensors->second, &concated);
+    }
     DCHECK(concat_status.ok()) << concat_status.ToString();
     if (!concat_status.ok()) {
       return errors::Internal("Tensor concat operation failed: ",
@@ -586,9 +1270,72 @@ Status BatchingSession::MergeInputTensors(
   return OkStatus();
 }
 
+Status BatchingSession::DeduplicateInputRows(
+    absl::Span<const int> allowed_batch_sizes,
+    std::vector<std::pair<string, Tensor>>* merged_inputs,
+    std::vector<int64_t>* row_to_unique) {
+  row_to_unique->clear();
+  // The rows of ragged tensors are not deduplicated.
+  if (!options_.enable_input_row_dedup || !ragged_row_splits_.empty()) {
+    return OkStatus();
+  }
+  std::vector<Tensor> input_tensors;
+  input_tensors.reserve(merged_inputs->size());
+  for (const auto& entry : *merged_inputs) {
+    if (!IsRowDeduplicationSupported(entry.second.dtype())) {
+      return OkStatus();
+    }
+    input_tensors.push_back(entry.second);
+  }
+  profiler::TraceMe trace_me("DeduplicateInputRows");
+  std::vector<int64_t> unique_rows;
+  std::vector<int64_t> unique_row_indices;
+  TF_RETURN_IF_ERROR(
+      FindUniqueRows(input_tensors, &unique_rows, &unique_row_indices));
+  const int64_t num_rows = unique_row_indices.size();
+  const int padded_num_unique_rows = RoundToLowestAllowedBatchSize(
+      allowed_batch_sizes, unique_rows.size());
+  if (padded_num_unique_rows >= num_rows) {
+    // Deduplication would not make the batch any smaller.
+    return OkStatus();
+  }
+  // As in MergeInputTensors(), pad with repeats of a valid row.
+  unique_rows.resize(padded_num_unique_rows, unique_rows[0]);
+  for (auto& entry : *merged_inputs) {
+    Tensor unique_tensor;
+    TF_RETURN_IF_ERROR(GatherRows(entry.second, unique_rows, &unique_tensor));
+    entry.second = std::move(unique_tensor);
+  }
+  deduplicated_input_rows->GetCell()->IncrementBy(num_rows -
+                                                  padded_num_unique_rows);
+  *row_to_unique = std::move(unique_row_indices);
+  return OkStatus();
+}
+
+Status BatchingSession::ExpandOutputRows(
+    int64_t num_batched_rows, absl::Span<const int64_t> row_to_unique,
+    std::vector<Tensor>* combined_outputs) {
+  for (Tensor& tensor : *combined_outputs) {
+    if (tensor.shape().dims() == 0) {
+      return errors::FailedPrecondition(
+          "Batched output tensor has 0 dimensions");
+    }
+    if (tensor.shape().dim_size(0) != num_batched_rows) {
+      return errors::FailedPrecondition(
+          "Batched output tensor's 0th dimension does not equal the number of "
+          "distinct input rows");
+    }
+    Tensor expanded_tensor;
+    TF_RETURN_IF_ERROR(GatherRows(tensor, row_to_unique, &expanded_tensor));
+    tensor = std::move(expanded_tensor);
+  }
+  return OkStatus();
+}
+
 Status BatchingSession::SplitOutputTensors(
     const TensorSignature& signature,
     const std::vector<Tensor>& combined_outputs,
+    absl::Span<const int> allowed_batch_sizes,
     Batch<BatchingSessionTask>* batch) {
   DCHECK_GE(batch->num_tasks(), 1);
   if (batch->num_tasks() < 1) {
@@ -599,11 +1346,14 @@ Status BatchingSession::SplitOutputTensors(
   std::vector<int64_t> task_sizes_plus_optional_padding;
   task_sizes_plus_optional_padding.reserve(batch->num_tasks());
   for (int i = 0; i < batch->num_tasks(); ++i) {
-    task_sizes_plus_optional_padding.push_back(batch->task(i).zeroth_dim_size);
+    if (!batch->task(i).shed) {
+      task_sizes_plus_optional_padding.push_back(
+          batch->task(i).zeroth_dim_size);
+    }
   }
-  const int padding_size = RoundToLowestAllowedBatchSize(
-                               options_.allowed_batch_sizes, batch->size()) -
-                           batch->size();
+  const int num_rows = NumRows(*batch);
+  const int padding_size =
+      RoundToLowestAllowedBatchSize(allowed_batch_sizes, num_rows) - num_rows;
   if (padding_size > 0) {
     task_sizes_plus_optional_padding.push_back(padding_size);
   }
@@ -618,15 +1368,70 @@ Status BatchingSession::SplitOutputTensors(
   }
   const std::vector<string> output_tensors(signature.output_tensors.begin(),
                                            signature.output_tensors.end());
+  // The number of values of each task (and of the padding) in the ragged
+  // outputs, by the name of their row splits.
+  std::map<string, std::vector<int64_t>> ragged_value_sizes;
+  for (int i = 0; i < output_tensors.size(); ++i) {
+    const string& tensor_name = output_tensors[i];
+    if (ragged_row_splits_.count(tensor_name) == 0) {
+      continue;
+    }
+    const Tensor& tensor = combined_outputs[i];
+    if ((tensor.dtype() != DT_INT32 && tensor.dtype() != DT_INT64) ||
+        tensor.dims() != 1 ||
+        tensor.dim_size(0) != num_rows + padding_size + 1) {
+      return errors::FailedPrecondition(
+          "Batched ragged output row splits '", tensor_name,
+          "' are not an int32 or int64 vector of one more entry than the rows "
+          "of the input tensors");
+    }
+    std::vector<Tensor> split_tensor;
+    std::vector<int64_t>& value_sizes = ragged_value_sizes[tensor_name];
+    if (tensor.dtype() == DT_INT32) {
+      SplitRowSplits<int32>(tensor, task_sizes_plus_optional_padding,
+                            &split_tensor, &value_sizes);
+    } else {
+      SplitRowSplits<int64_t>(tensor, task_sizes_plus_optional_padding,
+                              &split_tensor, &value_sizes);
+    }
+    split_tensors[tensor_name] = std::move(split_tensor);
+  }
   for (int i = 0; i < output_tensors.size(); ++i) {
     const string& tensor_name = output_tensors[i];
     const Tensor& tensor = combined_outputs[i];
 
-    if (tensor.shape().dims() == 0) {
+    if (ragged_row_splits_.count(tensor_name) > 0) {
+      continue;
+    }
+    const std::vector<int64_t>* split_sizes = &task_sizes_plus_optional_padding;
+    auto row_splits_name = ragged_row_splits_by_values_.find(tensor_name);
+    if (row_splits_name != ragged_row_splits_by_values_.end()) {
+      auto value_sizes = ragged_value_sizes.find(row_splits_name->second);
+      if (value_sizes == ragged_value_sizes.end()) {
+        return errors::FailedPrecondition(
+            "The ragged tensor values '", tensor_name,
+            "' must be fetched with their row splits '",
+            row_splits_name->second, "'");
+      }
+      int64_t num_values = 0;
+      for (const int64_t value_size : value_sizes->second) {
+        if (value_size < 0) {
+          return errors::FailedPrecondition(
+              "Batched ragged output row splits '", row_splits_name->second,
+              "' decrease");
+        }
+        num_values += value_size;
+      }
+      if (tensor.dims() == 0 || tensor.dim_size(0) != num_values) {
+        return errors::FailedPrecondition(
+            "Batched ragged output values '", tensor_name,
+            "' do not match their row splits '", row_splits_name->second, "'");
+      }
+      split_sizes = &value_sizes->second;
+    } else if (tensor.shape().dims() == 0) {
       return errors::FailedPrecondition(
           "Batched output tensor has 0 dimensions");
-    }
-    if (tensor.shape().dim_size(0) != batch->size() + padding_size) {
+    } else if (tensor.shape().dim_size(0) != num_rows + padding_size) {
       return errors::FailedPrecondition(
           "Batched output tensor's 0th dimension does not equal the sum of the "
           "0th dimension sizes of the input tensors");
@@ -634,7 +1439,9 @@ Status BatchingSession::SplitOutputTensors(
 
     std::vector<Tensor> split_tensor;
     const Status split_status =
-        tensor::Split(tensor, task_sizes_plus_optional_padding, &split_tensor);
+        options_.enable_pooled_batch_assembly
+            ? SplitTensorWithAliasing(tensor, *split_sizes, &split_tensor)
+            : tensor::Split(tensor, *split_sizes, &split_tensor);
     DCHECK(split_status.ok()) << split_status.ToString();
     if (!split_status.ok()) {
       return errors::Internal("Tensor split operation failed: ",
@@ -650,21 +1457,35 @@ Status BatchingSession::SplitOutputTensors(
     split_tensors[tensor_name] = std::move(split_tensor);
   }
 
+  // The index of each task that is not shed among those that are not.
+  int split_index = 0;
   for (int i = 0; i < batch->num_tasks(); ++i) {
     BatchingSessionTask* task = batch->mutable_task(i);
-    for (const string& tensor_name : *task->output_tensor_names) {
-      auto split_tensor = split_tensors.find(tensor_name);
+    if (task->shed) {
+      continue;
+    }
+    const int task_index = split_index++;
+    for (int j = 0; j < task->output_tensor_names->size(); ++j) {
+      auto split_tensor = split_tensors.find((*task->output_tensor_names)[j]);
       DCHECK(split_tensor != split_tensors.end());
       if (split_tensor == split_tensors.end()) {
         return errors::Internal("Task does not conform to batch signature");
       }
 
       if (task->is_partial) {
-        std::vector<Tensor>& tensor_vector =
-            (*task->shared_outputs)[task->split_index];
-        tensor_vector.push_back(std::move(split_tensor->second[i]));
+        if (ragged_row_splits_.count(split_tensor->first) > 0 ||
+            ragged_row_splits_by_values_.count(split_tensor->first) > 0) {
+          return errors::FailedPrecondition(
+              "Ragged output '", split_tensor->first,
+              "' cannot be assembled from split tasks; disable large batch "
+              "splitting");
+        }
+        // Copy this split's output into place right away, so that whichever
+        // split completes last need not concatenate all of them.
+        TF_RETURN_IF_ERROR(task->split_outputs->AddSplitOutput(
+            task->split_index, j, split_tensor->second[task_index]));
       } else {
-        task->outputs->push_back(std::move(split_tensor->second[i]));
+        task->outputs->push_back(std::move(split_tensor->second[task_index]));
       }
     }
   }
@@ -708,6 +1529,58 @@ Status BatchingSession::SplitRunMetadata(RunMetadata* batch_metadata,
   return OkStatus();
 }
 
+void BatchingSession::RecordBatchMetrics(
+    const TensorSignature& signature, const Batch<BatchingSessionTask>& batch,
+    const std::vector<std::pair<string, Tensor>>& merged_inputs) const {
+  if (merged_inputs.empty()) {
+    return;
+  }
+  const string signature_label = SignatureMetricLabel(signature);
+  int64_t num_split_tasks = 0;
+  int64_t num_task_elements = 0;
+  for (int i = 0; i < batch.num_tasks(); ++i) {
+    const BatchingSessionTask& task = batch.task(i);
+    if (task.shed) {
+      continue;
+    }
+    if (task.is_partial) {
+      ++num_split_tasks;
+    }
+    for (const auto& entry : GetTaskInput(task)) {
+      num_task_elements += entry.second.NumElements();
+    }
+  }
+  int64_t num_merged_elements = 0;
+  for (const auto& entry : merged_inputs) {
+    num_merged_elements += entry.second.NumElements();
+  }
+
+  // The rows of ragged inputs are those of their row splits, less one.
+  int64_t num_batch_rows = 0;
+  for (const auto& entry : merged_inputs) {
+    if (ragged_row_splits_.count(entry.first) > 0) {
+      num_batch_rows = entry.second.dim_size(0) - 1;
+      break;
+    }
+    if (ragged_row_splits_by_values_.count(entry.first) == 0) {
+      num_batch_rows = entry.second.dim_size(0);
+      break;
+    }
+  }
+  if (num_batch_rows > 0) {
+    batch_fill_ratio->GetCell(options_.model_name, signature_label)
+        ->Add(static_cast<double>(NumRows(batch)) / num_batch_rows);
+  }
+  if (num_task_elements > 0) {
+    padding_overhead->GetCell(options_.model_name, signature_label)
+        ->Add(static_cast<double>(num_merged_elements) / num_task_elements);
+  }
+  if (num_split_tasks > 0) {
+    split_tasks->GetCell(options_.model_name, signature_label)
+        ->IncrementBy(num_split_tasks);
+  }
+}
+
 void BatchingSession::ProcessBatch(
     const TensorSignature& signature,
     std::unique_ptr<Batch<BatchingSessionTask>> batch) {
@@ -726,15 +1599,24 @@ void BatchingSession::ProcessBatch(
   // individual tasks and signal that they are done. We use MakeCleanup() to
   // ensure that this happens no matter how we exit the method below.
   Status status;
-  auto finally = gtl::MakeCleanup([&status, &batch] {
+  const Status shed_status = Status(
+      static_cast<tensorflow::errors::Code>(
+          absl::StatusCode::kResourceExhausted),
+      "Run() timeout exceeded while waiting in batching queue");
+  const Status cancelled_status = errors::Cancelled(
+      "The request was cancelled while waiting in batching queue");
+  auto finally = gtl::MakeCleanup([&status, &shed_status, &cancelled_status,
+                                   &batch] {
     for (int i = 0; i < batch->num_tasks(); ++i) {
       BatchingSessionTask* task = batch->mutable_task(i);
+      const Status& task_status = task->cancelled ? cancelled_status
+                                  : task->shed    ? shed_status
+                                                  : status;
       if (task->is_partial) {
-        task->thread_safe_status->Update(status);
+        task->thread_safe_status->Update(task_status);
         task->done_callback();
       } else {
-        *batch->mutable_task(i)->status = status;
-        batch->mutable_task(i)->done->Notify();
+        task->done(task_status);
       }
     }
   });
@@ -744,8 +1626,39 @@ void BatchingSession::ProcessBatch(
   // overall batch.
   bool all_tasks_timeout_exceeded = true;
   uint64_t batch_deadline_micros = 0;
+  const string signature_label = SignatureMetricLabel(signature);
+  ShardedSamplerCell* const queue_latency_cell =
+      batch_stage_latency->GetCell(options_.model_name, signature_label,
+                                   "queue");
+  // The traces of the traced requests in the batch, which get a span for each
+  // stage of the batch.
+  std::vector<CurrentTraceInfo> traces;
+  const auto record_stage_spans = [&traces](absl::string_view stage,
+                                            uint64_t start_micros,
+                                            uint64_t end_micros) {
+    for (const CurrentTraceInfo& trace : traces) {
+      trace.tracer->RecordSpan(trace.context, stage, start_micros, end_micros);
+    }
+  };
   for (int i = 0; i < batch->num_tasks(); ++i) {
     const BatchingSessionTask& task = batch->task(i);
+    queuing_latency->GetCell(thread_pool_name_)
+        ->Add(dequeue_time_micros - task.enqueue_time_micros);
+    queue_latency_cell->Add(dequeue_time_micros - task.enqueue_time_micros);
+    if (task.trace.tracer != nullptr) {
+      task.trace.tracer->RecordSpan(task.trace.context, "batch_queue",
+                                    task.enqueue_time_micros,
+                                    dequeue_time_micros);
+      traces.push_back(task.trace);
+    }
+    // Nobody waits for the outputs of cancelled requests.
+    if (task.request_deadline != nullptr &&
+        task.request_deadline->IsCancelled()) {
+      batch->mutable_task(i)->cancelled = true;
+      batch->mutable_task(i)->shed = true;
+      cancelled_tasks->GetCell()->IncrementBy(1);
+      continue;
+    }
     // If the caller doesn't populate RunOptions, the timeout is 0 by default.
     // Interpret that as "no timeout" i.e. infinity.
     const int64_t task_timeout_micros =
@@ -759,14 +1672,13 @@ void BatchingSession::ProcessBatch(
       if (task_deadline_micros > batch_deadline_micros) {
         batch_deadline_micros = task_deadline_micros;
       }
+    } else if (options_.shed_expired_tasks) {
+      batch->mutable_task(i)->shed = true;
+      shed_expired_tasks->GetCell()->IncrementBy(1);
     }
-    queuing_latency->GetCell(thread_pool_name_)
-        ->Add(dequeue_time_micros - task.enqueue_time_micros);
   }
   if (all_tasks_timeout_exceeded) {
-    status = Status(static_cast<tensorflow::errors::Code>(
-                        absl::StatusCode::kResourceExhausted),
-                    "Run() timeout exceeded while waiting in batching queue");
+    status = shed_status;
     return;
   }
 
@@ -779,10 +1691,40 @@ void BatchingSession::ProcessBatch(
   }
 
   std::vector<std::pair<string, Tensor>> merged_inputs;
-  status = MergeInputTensors(signature, *batch, &merged_inputs);
+  // The allowed batch sizes may change while the batch is processed, so all its
+  // stages use the sizes in effect when it is merged.
+  std::shared_ptr<const std::vector<int>> live_allowed_batch_sizes;
+  absl::Span<const int> allowed_batch_sizes = options_.allowed_batch_sizes;
+  if (options_.live_allowed_batch_sizes != nullptr) {
+    live_allowed_batch_sizes = options_.live_allowed_batch_sizes->Get();
+    allowed_batch_sizes = *live_allowed_batch_sizes;
+  }
+  status = MergeInputTensors(signature, *batch, allowed_batch_sizes,
+                             &merged_inputs);
+  if (!status.ok()) {
+    return;
+  }
+  RecordBatchMetrics(signature, *batch, merged_inputs);
+  // The merged inputs, and then the combined outputs, are buffers of the
+  // batching subsystem until the batch is split.
+  MemoryCharge memory_charge;
+  if (MemoryAccountingEnabled()) {
+    int64_t merged_bytes = 0;
+    for (const auto& entry : merged_inputs) {
+      merged_bytes += entry.second.TotalBytes();
+    }
+    memory_charge = MemoryCharge(MemorySubsystem::kBatching, merged_bytes);
+  }
+  std::vector<int64_t> row_to_unique;
+  status = DeduplicateInputRows(allowed_batch_sizes, &merged_inputs,
+                                &row_to_unique);
   if (!status.ok()) {
     return;
   }
+  const uint64_t merged_time_micros = EnvTime::NowMicros();
+  batch_stage_latency->GetCell(options_.model_name, signature_label, "merge")
+      ->Add(merged_time_micros - dequeue_time_micros);
+  record_stage_spans("batch_merge", dequeue_time_micros, merged_time_micros);
 
   absl::optional<thread::ThreadPoolOptions> thread_pool_options =
       batch->task(0).thread_pool_options;
@@ -791,26 +1733,41 @@ void BatchingSession::ProcessBatch(
       signature.output_tensors.begin(), signature.output_tensors.end());
   std::vector<Tensor> combined_outputs;
   RunMetadata run_metadata;
-  // Because the wrapped session may not provide an implementation for
-  // thread_pool_options, we need to invoke different Run() functions depending
-  // on whether thread_pool_options is specified.
-  if (thread_pool_options) {
-    status = wrapped_->Run(run_options, merged_inputs, output_tensor_names,
-                           {} /* target node names */, &combined_outputs,
-                           &run_metadata, thread_pool_options.value());
-  } else {
-    status = wrapped_->Run(run_options, merged_inputs, output_tensor_names,
-                           {} /* target node names */, &combined_outputs,
-                           &run_metadata);
-  }
+  // The wrapped session may not provide an implementation for
+  // thread_pool_options, so they are only passed on if specified.
+  status = wrapped_callables_->Run(
+      run_options, merged_inputs, output_tensor_names,
+      {} /* target node names */, &combined_outputs, &run_metadata,
+      thread_pool_options ? &thread_pool_options.value() : nullptr);
   wrapped_run_count->GetCell()->IncrementBy(1);
+  const uint64_t run_time_micros = EnvTime::NowMicros();
+  batch_stage_latency->GetCell(options_.model_name, signature_label, "run")
+      ->Add(run_time_micros - merged_time_micros);
+  record_stage_spans("batch_run", merged_time_micros, run_time_micros);
   status.Update(SplitRunMetadata(&run_metadata, batch.get()));
 
   if (!status.ok()) {
     return;
   }
+  if (MemoryAccountingEnabled()) {
+    for (const Tensor& tensor : combined_outputs) {
+      memory_charge.Add(tensor.TotalBytes());
+    }
+  }
 
-  status = SplitOutputTensors(signature, combined_outputs, batch.get());
+  if (!row_to_unique.empty()) {
+    status = ExpandOutputRows(merged_inputs[0].second.dim_size(0),
+                              row_to_unique, &combined_outputs);
+    if (!status.ok()) {
+      return;
+    }
+  }
+  status = SplitOutputTensors(signature, combined_outputs, allowed_batch_sizes,
+                              batch.get());
+  const uint64_t split_time_micros = EnvTime::NowMicros();
+  batch_stage_latency->GetCell(options_.model_name, signature_label, "split")
+      ->Add(split_time_micros - run_time_micros);
+  record_stage_spans("batch_split", run_time_micros, split_time_micros);
 }
 
 // TODO(b/158393551):
@@ -822,23 +1779,45 @@ Status SplitInputTask(
     int open_batch_remaining_slot, int max_batch_size,
     std::vector<std::unique_ptr<BatchingSessionTask>>* output_tasks) {
   BatchingSessionTask& input_task = *(*input_task_ptr);
-  const int64_t input_task_size = input_task.size();
+  const int64_t input_task_size = input_task.zeroth_dim_size;
+  if (input_task.has_ragged_inputs) {
+    return errors::FailedPrecondition(
+        "Tasks with ragged inputs cannot be split; disable large batch "
+        "splitting");
+  }
 
   DCHECK_GT(input_task_size, 0);
 
+  // The batch scheduler measures 'open_batch_remaining_slot' and
+  // 'max_batch_size' in task size units, of which each row takes 'row_cost'.
+  const int64_t row_cost = input_task.row_cost;
+  if (max_batch_size < row_cost) {
+    return errors::InvalidArgument("The cost of a single row of the task, ",
+                                   row_cost, ", exceeds the batch size limit ",
+                                   max_batch_size);
+  }
+  const internal::InputSplitMetadata input_split_metadata(
+      input_task_size, open_batch_remaining_slot / row_cost,
+      max_batch_size / row_cost);
+
+  // Creates an array of int64_t from an array of int, since `tensor::Split`
+  // requires an array of int64.
+  const absl::FixedArray<int64_t> output_task_sizes(
+      input_split_metadata.task_sizes().begin(),
+      input_split_metadata.task_sizes().end());
+  const int num_batches = output_task_sizes.size();
+
+  input_task.split_outputs = std::make_shared<SplitOutputAssembler>(
+      input_task.output_tensor_names->size(), output_task_sizes);
+
   // `split_task_done_callback` runs only after all split tasks are complete.
   std::function<void()> split_task_done_callback =
-      [done_notification = input_task.done,
-       shared_outputs = input_task.shared_outputs,
+      [done = input_task.done, split_outputs = input_task.split_outputs,
        shared_status = input_task.thread_safe_status,
-       num_output = input_task.output_tensor_names->size(),
-       outputs = input_task.outputs, status = input_task.status,
-       run_metadata = input_task.run_metadata,
+       outputs = input_task.outputs, run_metadata = input_task.run_metadata,
        split_run_metadatas = input_task.split_run_metadatas]() {
-        auto finally = gtl::MakeCleanup([&] {
-          *status = shared_status->status();
-          done_notification->Notify();
-        });
+        auto finally =
+            gtl::MakeCleanup([&] { done(shared_status->status()); });
 
         // Some slices of tasks encounter errors, return early without
         // processing per-split result.
@@ -846,23 +1825,11 @@ Status SplitInputTask(
           return;
         }
 
-        for (int i = 0; i < num_output; ++i) {
-          Tensor output_tensor;
-
-          // Concat i-th tensor from each split into i-th tensor of output.
-          std::vector<Tensor> to_concatenate;
-          to_concatenate.reserve(shared_outputs->size());
-          for (int j = 0; j < shared_outputs->size(); ++j) {
-            to_concatenate.push_back(std::move((*shared_outputs)[j][i]));
-          }
-          const auto concat_status =
-              tensor::Concat(to_concatenate, &output_tensor);
-          if (!concat_status.ok()) {
-            shared_status->Update(concat_status);
-            return;
-          }
-
-          outputs->push_back(std::move(output_tensor));
+        // The splits have already copied their outputs into place.
+        const Status finish_status = split_outputs->Finish(outputs);
+        if (!finish_status.ok()) {
+          shared_status->Update(finish_status);
+          return;
         }
 
         // `cost_dimension_map` aggregates costs from all splits for each
@@ -894,38 +1861,25 @@ Status SplitInputTask(
       };
   IncrementalBarrier barrier(split_task_done_callback);
 
-  const internal::InputSplitMetadata input_split_metadata(
-      input_task_size, open_batch_remaining_slot, max_batch_size);
-
-  // Creates an array of int64_t from an array of int, since `tensor::Split`
-  // requires an array of int64.
-  const absl::FixedArray<int64_t> output_task_sizes(
-      input_split_metadata.task_sizes().begin(),
-      input_split_metadata.task_sizes().end());
-  const int num_batches = output_task_sizes.size();
-
-  input_task.shared_outputs->resize(num_batches);
-
-  for (int i = 0; i < num_batches; ++i) {
-    (*input_task.shared_outputs)[i].reserve(
-        input_task.output_tensor_names->size());
-  }
-
   input_task.split_run_metadatas->resize(num_batches);
 
   output_tasks->reserve(num_batches);
   for (int i = 0; i < num_batches; i++) {
     auto task = absl::make_unique<BatchingSessionTask>();
     task->enqueue_time_micros = input_task.enqueue_time_micros;
+    task->criticality = input_task.criticality;
+    task->request_deadline = input_task.request_deadline;
+    task->trace = input_task.trace;
     task->run_options = input_task.run_options;
     task->zeroth_dim_size = output_task_sizes[i];
+    task->row_cost = input_task.row_cost;
     // `task->owned_input` will be initialized separately out of this for-loop.
     task->output_tensor_names = input_task.output_tensor_names;
 
     task->owned_split_inputs =
         absl::make_unique<std::vector<std::pair<string, Tensor>>>();
     task->split_index = i;
-    task->shared_outputs = input_task.shared_outputs;
+    task->split_outputs = input_task.split_outputs;
     task->thread_safe_status = input_task.thread_safe_status;
     task->is_partial = true;
     task->done_callback = barrier.Inc();
@@ -1005,7 +1959,10 @@ Status CreateBasicBatchingSession(
     std::unique_ptr<Session>* batching_session) {
   const auto& allowed_batch_sizes =
       batching_session_options.allowed_batch_sizes;
-  if (!allowed_batch_sizes.empty()) {
+  // With a row cost, the batch size limits are not in rows, so they cannot be
+  // checked against 'allowed_batch_sizes'.
+  if (!allowed_batch_sizes.empty() &&
+      !batching_session_options.row_cost_func) {
     if (schedule_options.enable_large_batch_splitting) {
       const int max_allowed_batch_size = allowed_batch_sizes.back();
       int32 last_size = 0;
@@ -1068,5 +2025,50 @@ Status CreateBasicBatchingSession(
   return OkStatus();
 }
 
+Status CreateStreamingBatchingSession(
+    const StreamingBatchScheduler<BatchingSessionTask>::Options&
+        schedule_options,
+    const BatchSchedulerRetrier<BatchingSessionTask>::Options& retry_options,
+    const BatchingSessionOptions& batching_session_options,
+    const TensorSignature& signature, std::unique_ptr<Session> session,
+    std::unique_ptr<Session>* batching_session) {
+  const auto& allowed_batch_sizes =
+      batching_session_options.allowed_batch_sizes;
+  if (!allowed_batch_sizes.empty() &&
+      !batching_session_options.row_cost_func &&
+      allowed_batch_sizes.back() != schedule_options.max_batch_size) {
+    return errors::InvalidArgument(
+        "Last entry in allowed_batch_sizes must match max_batch_size; last "
+        "entry was ",
+        allowed_batch_sizes.back(), "; expected ",
+        schedule_options.max_batch_size);
+  }
+
+  StreamingBatchScheduler<BatchingSessionTask>::Options
+      streaming_schedule_options = schedule_options;
+  if (streaming_schedule_options.enable_large_batch_splitting &&
+      streaming_schedule_options.split_input_task_func == nullptr) {
+    streaming_schedule_options.split_input_task_func = SplitInputTask;
+  }
+  auto scheduler_creator =
+      [streaming_schedule_options, retry_options](
+          std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<BatchingSessionTask>>*
+              batch_scheduler) {
+        return CreateRetryingStreamingBatchScheduler<BatchingSessionTask>(
+            streaming_schedule_options, retry_options, process_batch_callback,
+            batch_scheduler);
+      };
+
+  std::unique_ptr<BatchingSession> internal_batching_session;
+  TF_RETURN_IF_ERROR(BatchingSession::Create(
+      batching_session_options, std::move(session),
+      {{signature, scheduler_creator}}, schedule_options.thread_pool_name,
+      &internal_batching_session));
+  *batching_session = std::move(internal_batching_session);
+  return OkStatus();
+}
+
 }  // namespace serving
 }  // namespace tensorflow
@@ -34,7 +34,12 @@ limitations under the License.
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tsl/platform/criticality.h"
+#include "tensorflow_serving/util/request_deadline.h"
+#include "tensorflow_serving/util/request_trace.h"
+#include "tensorflow_serving/batching/batch_scheduler_retrier.h"
 #include "tensorflow_serving/batching/batching_options.h"
+#include "tensorflow_serving/batching/split_output_assembler.h"
+#include "tensorflow_serving/batching/streaming_batch_scheduler.h"
 #include "tensorflow_serving/batching/threadsafe_status.h"
 
 namespace tensorflow {
@@ -153,10 +158,31 @@ Status CreateBasicBatchingSession(
     const TensorSignature& signature, std::unique_ptr<Session> session,
     std::unique_ptr<Session>* batching_session);
 
+// A convenience for using CreateBatchingSession() to create a
+// StreamingBatchScheduler, wrapped in a BatchSchedulerRetrier, for a single
+// signature. Unlike a BasicBatchScheduler, a StreamingBatchScheduler hands each
+// batch to a batch thread as soon as it is opened and closes it as soon as it
+// is full, so a full batch starts executing without waiting for a timeout or a
+// thread to pick it up from a queue.
+//
+// If 'schedule_options.enable_large_batch_splitting' is true and no
+// 'split_input_task_func' is set, SplitInputTask() is used.
+Status CreateStreamingBatchingSession(
+    const typename StreamingBatchScheduler<BatchingSessionTask>::Options&
+        schedule_options,
+    const typename BatchSchedulerRetrier<BatchingSessionTask>::Options&
+        retry_options,
+    const BatchingSessionOptions& batching_session_options,
+    const TensorSignature& signature, std::unique_ptr<Session> session,
+    std::unique_ptr<Session>* batching_session);
+
 // The default implementation of
 // `BasicBatchScheduler::Options.split_input_task_func` if corresponding batch
 // scheduler for a batching session sets
 // `BasicBatchScheduler::Options.enable_large_batch_splitting` to true.
+// Tasks are split on row boundaries: with a row cost other than one (see
+// 'row_cost_func' in batching_options.h), each split holds as many rows as fit
+// in its batch.
 Status SplitInputTask(
     std::unique_ptr<BatchingSessionTask>* input_task_ptr,
     int open_batch_remaining_slot, int max_batch_size,
@@ -167,7 +193,15 @@ Status SplitInputTask(
 
 struct BatchingSessionTask : public BatchTask {
   ~BatchingSessionTask() override = default;
-  size_t size() const override { return zeroth_dim_size; }
+  size_t size() const override { return zeroth_dim_size * row_cost; }
+
+  // Returns the time, as per EnvTime::NowMicros(), by which the task must
+  // complete as per the timeout in 'run_options', or 0 if it has no timeout.
+  uint64_t deadline_micros() const {
+    return run_options.timeout_in_ms() <= 0
+               ? 0
+               : enqueue_time_micros + run_options.timeout_in_ms() * 1000;
+  }
 
   // For monitoring purpose.
   static std::string Name() { return "batching_session"; }
@@ -176,13 +210,18 @@ struct BatchingSessionTask : public BatchTask {
   uint64_t enqueue_time_micros;
   RunOptions run_options;
   size_t zeroth_dim_size;
+  // The cost of each row, see 'row_cost_func' in batching_options.h.
+  size_t row_cost = 1;
+  // Whether some of the inputs are ragged (see 'ragged_tensors' in
+  // batching_options.h), which keeps the task from being split.
+  bool has_ragged_inputs = false;
   const std::vector<std::pair<string, Tensor>>* inputs;
   const std::vector<string>* output_tensor_names;
 
   // Fields populated when a task is processed (as part of a batch), and
   // returned by BatchingSession when a task is complete.
-  Notification* done;
-  Status* status;
+  // Called with the status of the task once it is complete.
+  std::function<void(const Status&)> done;
   std::vector<Tensor>* outputs;
   RunMetadata* run_metadata;
   absl::optional<thread::ThreadPoolOptions> thread_pool_options;
@@ -198,14 +237,13 @@ struct BatchingSessionTask : public BatchTask {
   // invocation.
   int split_index = 0;
   std::function<void()> done_callback;
-  typedef std::vector<std::vector<Tensor>> TensorMatrix;
   // For shared_ptr objects, ownership shared by:
-  // 1) each split of task (to fill one row in this matrix)
+  // 1) each split of task (to copy its outputs into place as soon as its
+  // batch is processed)
   // and
-  // 2) callback that runs to merge output of individual splits for an op
+  // 2) callback that runs to return the assembled outputs for an op
   // invocation, after all splits complete.
-  // Two-dimensional tensor matrix,
-  std::shared_ptr<TensorMatrix> shared_outputs;
+  std::shared_ptr<SplitOutputAssembler> split_outputs;
   // 'status' records error (could be from any split) if at least one split
   // returns error, OK otherwise.
   std::shared_ptr<ThreadSafeStatus> thread_safe_status;
@@ -213,6 +251,22 @@ struct BatchingSessionTask : public BatchTask {
   std::shared_ptr<std::vector<RunMetadata>> split_run_metadatas;
 
   tsl::criticality::Criticality criticality;
+
+  // The deadline of the request the task serves, if the thread that issued it
+  // served one. Tasks whose requests are cancelled are left out of their batch.
+  std::shared_ptr<const RequestDeadline> request_deadline;
+
+  // The trace of the request the task serves, if the thread that issued it
+  // served a traced one. The stages of its batch are recorded as spans of it.
+  CurrentTraceInfo trace;
+
+  // Set if the task's request was cancelled while it waited in its batch
+  // queue, which also sets 'shed'.
+  bool cancelled = false;
+
+  // Set if the task expired while waiting in its batch queue and is left out
+  // of its batch. See 'shed_expired_tasks' in batching_options.h.
+  bool shed = false;
 };
 
 }  // namespace serving
@@ -0,0 +1,298 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the tensor plumbing of BatchingSession: merging the inputs of
+// the tasks of a batch (with and without padding), splitting the outputs of a
+// batch back to its tasks, splitting large tasks across batches, and padding
+// tensors. The wrapped session returns its input as its output, so the
+// benchmarks measure the batching layer alone.
+//
+// Run with:
+// bazel run -c opt \
+// tensorflow_serving/batching:batching_session_benchmark -- --benchmarks=.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow_serving/batching/batch_tensor_pool.h"
+#include "tensorflow_serving/batching/batching_session.h"
+#include "tensorflow_serving/batching/batching_util.h"
+#include "tensorflow_serving/batching/threadsafe_status.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// The tensor dtypes benchmarked, by argument.
+enum TensorDtype {
+  kFloat = 0,
+  kInt64 = 1,
+  kString = 2,
+};
+
+DataType ToDataType(const int dtype) {
+  switch (dtype) {
+    case kFloat:
+      return DT_FLOAT;
+    case kInt64:
+      return DT_INT64;
+    default:
+      return DT_STRING;
+  }
+}
+
+Tensor MakeTensor(const int dtype, const int rows, const int row_size) {
+  Tensor tensor(ToDataType(dtype), TensorShape({rows, row_size}));
+  for (int64_t i = 0; i < tensor.NumElements(); ++i) {
+    switch (dtype) {
+      case kFloat:
+        tensor.flat<float>()(i) = i;
+        break;
+      case kInt64:
+        tensor.flat<int64_t>()(i) = i;
+        break;
+      default:
+        tensor.flat<tstring>()(i) = absl::StrCat("value", i);
+        break;
+    }
+  }
+  return tensor;
+}
+
+// A session that returns its "x" input as its "y" output.
+class EchoSession : public ServingSession {
+ public:
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    *outputs = {inputs[0].second};
+    return OkStatus();
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    return Run(inputs, output_tensor_names, target_node_names, outputs);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    return Run(inputs, output_tensor_names, target_node_names, outputs);
+  }
+
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return errors::Unimplemented("ListDevices");
+  }
+};
+
+// Returns a batching session over an EchoSession whose batches hold exactly
+// 'batch_size' rows.
+std::unique_ptr<Session> CreateBatchingSession(
+    const int batch_size, const BatchingSessionOptions& options) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = batch_size;
+  // Batches are processed once full.
+  schedule_options.batch_timeout_micros = 10 * 1000 * 1000;
+  schedule_options.num_batch_threads = 1;
+  schedule_options.max_enqueued_batches = 2;
+  std::unique_ptr<Session> batching_session;
+  TF_CHECK_OK(CreateBasicBatchingSession(schedule_options, options,
+                                         {{"x"}, {"y"}},
+                                         std::make_unique<EchoSession>(),
+                                         &batching_session));
+  return batching_session;
+}
+
+// Runs one batch of the tasks with the inputs 'task_inputs' on
+// 'batching_session'.
+void RunBatch(
+    const std::vector<std::vector<std::pair<string, Tensor>>>& task_inputs,
+    Session* batching_session) {
+  const std::vector<string> output_names = {"y"};
+  std::vector<std::vector<Tensor>> outputs(task_inputs.size());
+  std::vector<RunMetadata> run_metadata(task_inputs.size());
+  BlockingCounter done(task_inputs.size());
+  for (int i = 0; i < task_inputs.size(); ++i) {
+    static_cast<ServingSession*>(batching_session)
+        ->RunAsync(RunOptions(), task_inputs[i], output_names, {}, &outputs[i],
+                   &run_metadata[i], [&done](const Status& status) {
+                     TF_CHECK_OK(status);
+                     done.DecrementCount();
+                   });
+  }
+  done.Wait();
+}
+
+// Arguments: (dtype, tasks per batch, rows per task, values per row, pooled
+// batch assembly).
+void BM_MergeAndSplit(benchmark::State& state) {
+  const int dtype = state.range(0);
+  const int num_tasks = state.range(1);
+  const int rows = state.range(2);
+  const int row_size = state.range(3);
+  BatchingSessionOptions options;
+  options.enable_pooled_batch_assembly = state.range(4);
+  std::unique_ptr<Session> batching_session =
+      CreateBatchingSession(num_tasks * rows, options);
+  const std::vector<std::vector<std::pair<string, Tensor>>> task_inputs(
+      num_tasks, {{"x", MakeTensor(dtype, rows, row_size)}});
+  for (auto s : state) {
+    RunBatch(task_inputs, batching_session.get());
+  }
+  state.SetItemsProcessed(state.iterations() * num_tasks * rows);
+}
+BENCHMARK(BM_MergeAndSplit)
+    ->Apply([](::benchmark::internal::Benchmark* benchmark) {
+      for (const int dtype : {kFloat, kInt64, kString}) {
+        for (const int num_tasks : {1, 8, 32}) {
+          for (const int rows : {1, 8}) {
+            for (const int row_size : {16, 1024, 16384}) {
+              for (const int pooled : {0, 1}) {
+                benchmark->Args({dtype, num_tasks, rows, row_size, pooled});
+              }
+            }
+          }
+        }
+      }
+    });
+
+// Arguments: (tasks per batch, values per row of the longest task, percent of
+// padding of the shorter tasks, pooled batch assembly). Every other task is
+// shorter, and padded to the longest one when merged.
+void BM_MergeWithPadding(benchmark::State& state) {
+  const int num_tasks = state.range(0);
+  const int row_size = state.range(1);
+  const int short_row_size = std::max<int>(
+      1, row_size * (100 - state.range(2)) / 100);
+  BatchingSessionOptions options;
+  options.pad_variable_length_inputs = true;
+  options.enable_pooled_batch_assembly = state.range(3);
+  std::unique_ptr<Session> batching_session =
+      CreateBatchingSession(num_tasks, options);
+  std::vector<std::vector<std::pair<string, Tensor>>> task_inputs;
+  for (int i = 0; i < num_tasks; ++i) {
+    task_inputs.push_back(
+        {{"x", MakeTensor(kFloat, 1, i % 2 == 0 ? row_size : short_row_size)}});
+  }
+  for (auto s : state) {
+    RunBatch(task_inputs, batching_session.get());
+  }
+  state.SetItemsProcessed(state.iterations() * num_tasks);
+}
+BENCHMARK(BM_MergeWithPadding)
+    ->Apply([](::benchmark::internal::Benchmark* benchmark) {
+      for (const int num_tasks : {8, 32}) {
+        for (const int row_size : {64, 4096}) {
+          for (const int padding_percent : {10, 50, 90}) {
+            for (const int pooled : {0, 1}) {
+              benchmark->Args({num_tasks, row_size, padding_percent, pooled});
+            }
+          }
+        }
+      }
+    });
+
+// Arguments: (rows of the task, number of splits, values per row).
+void BM_SplitInputTask(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int num_splits = state.range(1);
+  const std::vector<std::pair<string, Tensor>> inputs = {
+      {"x", MakeTensor(kFloat, rows, state.range(2))}};
+  const std::vector<string> output_names = {"y"};
+  std::vector<Tensor> outputs;
+  RunMetadata run_metadata;
+  const int max_batch_size = (rows + num_splits - 1) / num_splits;
+  for (auto s : state) {
+    auto task = std::make_unique<BatchingSessionTask>();
+    task->zeroth_dim_size = rows;
+    task->inputs = &inputs;
+    task->output_tensor_names = &output_names;
+    task->outputs = &outputs;
+    task->run_metadata = &run_metadata;
+    task->done = [](const Status&) {};
+    task->thread_safe_status = std::make_shared<ThreadSafeStatus>();
+    task->split_run_metadatas = std::make_shared<std::vector<RunMetadata>>();
+    std::vector<std::unique_ptr<BatchingSessionTask>> split_tasks;
+    TF_CHECK_OK(SplitInputTask(&task, max_batch_size, max_batch_size,
+                               &split_tasks));
+    CHECK_EQ(num_splits, split_tasks.size());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_SplitInputTask)
+    ->Args({64, 2, 64})
+    ->Args({64, 8, 64})
+    ->Args({1024, 2, 64})
+    ->Args({1024, 16, 64})
+    ->Args({1024, 16, 4096});
+
+// Arguments: (dtype, rows, values per row, percent of padding, pooled).
+void BM_AddPadding(benchmark::State& state) {
+  const int rows = state.range(1);
+  const int row_size = state.range(2);
+  const Tensor tensor = MakeTensor(state.range(0), rows, row_size);
+  const std::vector<int> max_dim_sizes = {
+      rows, static_cast<int>(row_size * 100 / (100 - state.range(3)))};
+  BatchTensorPool pool(/*max_tensors_per_key=*/4);
+  BatchTensorPool* const pool_or_null = state.range(4) ? &pool : nullptr;
+  for (auto s : state) {
+    Tensor padded_tensor;
+    TF_CHECK_OK(
+        AddPadding(tensor, max_dim_sizes, pool_or_null, &padded_tensor));
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_AddPadding)
+    ->Apply([](::benchmark::internal::Benchmark* benchmark) {
+      for (const int dtype : {kFloat, kInt64, kString}) {
+        for (const int row_size : {16, 1024}) {
+          for (const int padding_percent : {10, 50, 90}) {
+            for (const int pooled : {0, 1}) {
+              benchmark->Args({dtype, 32, row_size, padding_percent, pooled});
+            }
+          }
+        }
+      }
+    });
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  tensorflow::testing::RunBenchmarks();
+  return 0;
+}
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow_serving/batching/batching_session.h"
 
+#include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -23,12 +25,16 @@ limitations under the License.
 
 #include <gtest/gtest.h>
 #include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
@@ -42,6 +48,7 @@ limitations under the License.
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow_serving/servables/tensorflow/serving_session.h"
 #include "tensorflow_serving/test_util/test_util.h"
+#include "tensorflow_serving/util/request_deadline.h"
 
 namespace tensorflow {
 namespace serving {
@@ -51,6 +58,23 @@ using ::testing::HasSubstr;
 using ::testing::UnorderedElementsAre;
 
 // A wrapper around a Session that captures the batch size.
+// An allocator that counts the allocations it forwards to the CPU allocator.
+class CountingAllocator : public Allocator {
+ public:
+  string Name() override { return "counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocations_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+  int num_allocations() const { return num_allocations_; }
+
+ private:
+  std::atomic<int> num_allocations_{0};
+};
+
 class BatchSizeCapturingSession : public ServingSession {
  public:
   explicit BatchSizeCapturingSession(std::unique_ptr<Session> wrapped)
@@ -117,6 +141,71 @@ class BatchSizeCapturingSession : public ServingSession {
   TF_DISALLOW_COPY_AND_ASSIGN(BatchSizeCapturingSession);
 };
 
+// A session that returns the inputs named like its requested outputs, and
+// keeps the inputs of its latest run.
+class EchoSession : public ServingSession {
+ public:
+  EchoSession() = default;
+  ~EchoSession() override = default;
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    RunMetadata run_metadata;
+    return Run(RunOptions(), inputs, output_tensor_names, target_node_names,
+               outputs, &run_metadata);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    return Run(run_options, inputs, output_tensor_names, target_node_names,
+               outputs, run_metadata, thread::ThreadPoolOptions());
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override
+      TF_LOCKS_EXCLUDED(mu_) {
+    {
+      mutex_lock l(mu_);
+      latest_inputs_ = inputs;
+    }
+    for (const string& output_tensor_name : output_tensor_names) {
+      bool found = false;
+      for (const auto& input : inputs) {
+        if (input.first == output_tensor_name) {
+          outputs->push_back(input.second);
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        return errors::NotFound("No input ", output_tensor_name);
+      }
+    }
+    return OkStatus();
+  }
+
+  std::vector<std::pair<string, Tensor>> latest_inputs() const
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return latest_inputs_;
+  }
+
+ private:
+  mutable mutex mu_;
+  std::vector<std::pair<string, Tensor>> latest_inputs_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EchoSession);
+};
+
 // Creates a (non-batching) session with the half-plus-two model loaded.
 std::unique_ptr<Session> CreateHalfPlusTwoSession() {
   tensorflow::SessionOptions session_options;
@@ -227,6 +316,26 @@ bool CheckDescriptor(string label, const string& description,
   return true;
 }
 
+// Returns the histogram of the cell of the per-signature sampler 'label' whose
+// 'model_name' label is 'model_name', or an empty histogram if there is none.
+HistogramProto GetModelHistogram(const string& label,
+                                 const string& model_name) {
+  auto* collection_registry = monitoring::CollectionRegistry::Default();
+  monitoring::CollectionRegistry::CollectMetricsOptions options;
+  const std::unique_ptr<monitoring::CollectedMetrics> collected_metrics =
+      collection_registry->CollectMetrics(options);
+  const auto& point_set_map = collected_metrics->point_set_map;
+  if (point_set_map.find(label) == point_set_map.end()) return {};
+  for (const auto& point : point_set_map.at(label)->points) {
+    for (const auto& point_label : point->labels) {
+      if (point_label.name == "model_name" && point_label.value == model_name) {
+        return point->histogram_value;
+      }
+    }
+  }
+  return {};
+}
+
 TEST(BatchingSessionSignatureTest, TensorSignatureFromSignatureDef) {
   const SignatureDef signature_def =
       CreateSignatureDef({{"x0", "x1"}, {"y0", "y1"}});
@@ -318,6 +427,94 @@ TEST_P(BatchingSessionTest, Basic) {
       }));
 }
 
+TEST_P(BatchingSessionTest, RunAsync) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;  // fits two 2-unit tasks
+  schedule_options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateHalfPlusTwoSession(), &batching_session));
+  auto* serving_session = dynamic_cast<ServingSession*>(batching_session.get());
+  ASSERT_NE(nullptr, serving_session);
+
+  // Both requests are sent from this thread, which only waits once the two of
+  // them fill the batch.
+  const std::vector<std::pair<string, Tensor>> first_inputs = {
+      {"x", test::AsTensor<float>({100.0f, 42.0f}, {2})}};
+  const std::vector<std::pair<string, Tensor>> second_inputs = {
+      {"x", test::AsTensor<float>({71.5f, 18.3f}, {2})}};
+  const std::vector<string> output_names = {"y"};
+  std::vector<Tensor> first_outputs, second_outputs;
+  RunMetadata first_run_metadata, second_run_metadata;
+  Status first_status, second_status;
+  absl::Notification first_done, second_done;
+  serving_session->RunAsync(RunOptions(), first_inputs, output_names, {},
+                            &first_outputs, &first_run_metadata,
+                            [&](const Status& status) {
+                              first_status = status;
+                              first_done.Notify();
+                            });
+  EXPECT_FALSE(first_done.HasBeenNotified());
+  serving_session->RunAsync(RunOptions(), second_inputs, output_names, {},
+                            &second_outputs, &second_run_metadata,
+                            [&](const Status& status) {
+                              second_status = status;
+                              second_done.Notify();
+                            });
+  first_done.WaitForNotification();
+  second_done.WaitForNotification();
+  TF_ASSERT_OK(first_status);
+  TF_ASSERT_OK(second_status);
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({52.0f, 23.0f}, {2}),
+                                 first_outputs[0]);
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({37.75f, 11.15f}, {2}),
+                                 second_outputs[0]);
+
+  // Errors before scheduling are reported through the callback too.
+  absl::Notification failed;
+  serving_session->RunAsync(RunOptions(), first_inputs, output_names,
+                            {"target"}, &first_outputs, &first_run_metadata,
+                            [&](const Status& status) {
+                              first_status = status;
+                              failed.Notify();
+                            });
+  ASSERT_TRUE(failed.HasBeenNotified());
+  EXPECT_EQ(error::PERMISSION_DENIED, first_status.code());
+}
+
+TEST_P(BatchingSessionTest, CombiningEnqueue) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;  // fits two 2-unit tasks
+  schedule_options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.enable_combining_enqueue = true;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateHalfPlusTwoSession(), &batching_session));
+
+  // The two requests are forwarded to the scheduler by whichever thread
+  // combines them, and together trigger a batch to be processed.
+  std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "first_request_thread", [&batching_session] {
+        TestRequest({100.0f, 42.0f}, {2}, {52.0f, 23.0f}, {2},
+                    batching_session.get());
+      }));
+  std::unique_ptr<Thread> second_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "second_request_thread", [&batching_session] {
+        TestRequest({71.5f, 18.3f}, {2}, {37.75f, 11.15f}, {2},
+                    batching_session.get());
+      }));
+}
+
 TEST_P(BatchingSessionTest, BatchingWithPadding) {
   BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
   schedule_options.max_batch_size = 2;
@@ -347,6 +544,152 @@ TEST_P(BatchingSessionTest, BatchingWithPadding) {
       }));
 }
 
+TEST_P(BatchingSessionTest, BatchingWithPaddingAndBucketing) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 2;
+  schedule_options.batch_timeout_micros = 1e6;
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.pad_variable_length_inputs = true;
+  // Both requests below have padded dimension sizes (2 and 3) that fall into
+  // the first bucket, so they still form a batch together.
+  batching_session_options.padded_dim_bucket_boundaries = {4, 16};
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateMatrixHalfPlusTwoSession(), &batching_session));
+  std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "first_request", [&batching_session] {
+        TestRequest({1, 2, 3, 4}, {1, 2, 2},
+                    {2.5, 3, 2.5, 3.5, 4, 2.5, 2.5, 2.5, 2.5}, {1, 3, 3},
+                    batching_session.get());
+      }));
+  std::unique_ptr<Thread> second_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "second_request", [&batching_session] {
+        TestRequest({5, 6, 7, 8, 9, 10, 11, 12, 13}, {1, 3, 3},
+                    {4.5, 5, 5.5, 6, 6.5, 7, 7.5, 8, 8.5}, {1, 3, 3},
+                    batching_session.get());
+      }));
+}
+
+TEST_P(BatchingSessionTest, BatchingWithPaddingToBucketBoundaries) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 2;
+  schedule_options.batch_timeout_micros = 1000;
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.pad_variable_length_inputs = true;
+  batching_session_options.padded_dim_bucket_boundaries = {3, 16};
+  batching_session_options.pad_to_bucket_boundaries = true;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateMatrixHalfPlusTwoSession(), &batching_session));
+  // A lone [1, 2, 2] input is padded up to the [1, 3, 3] shape of its bucket,
+  // which the model accepts.
+  TestRequest({1, 2, 3, 4}, {1, 2, 2},
+              {2.5, 3, 2.5, 3.5, 4, 2.5, 2.5, 2.5, 2.5}, {1, 3, 3},
+              batching_session.get());
+}
+
+TEST_P(BatchingSessionTest, BucketingRejectsUnsortedBoundaries) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options = annotate_options(schedule_options);
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.padded_dim_bucket_boundaries = {16, 4};
+  std::unique_ptr<Session> batching_session;
+  EXPECT_FALSE(CreateBasicBatchingSession(
+                   schedule_options, batching_session_options, {{"x"}, {"y"}},
+                   CreateHalfPlusTwoSession(), &batching_session)
+                   .ok());
+}
+
+TEST_P(BatchingSessionTest, CriticalityLanes) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;  // fits two 2-unit tasks
+  schedule_options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.enable_criticality_lanes = true;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateHalfPlusTwoSession(), &batching_session));
+
+  // Both requests are issued with the default (critical) criticality, so they
+  // share a lane and form a batch together.
+  std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "first_request_thread", [&batching_session] {
+        TestRequest({100.0f, 42.0f}, {2}, {52.0f, 23.0f}, {2},
+                    batching_session.get());
+      }));
+  std::unique_ptr<Thread> second_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "second_request_thread", [&batching_session] {
+        TestRequest({71.5f, 18.3f}, {2}, {37.75f, 11.15f}, {2},
+                    batching_session.get());
+      }));
+}
+
+TEST(BatchingSessionTest, StreamingScheduler) {
+  StreamingBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;  // fits two 2-unit tasks
+  schedule_options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+  schedule_options.num_batch_threads = 1;
+  BatchSchedulerRetrier<BatchingSessionTask>::Options retry_options;
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  TF_ASSERT_OK(CreateStreamingBatchingSession(
+      schedule_options, retry_options, batching_session_options,
+      {{"x"}, {"y"}}, CreateHalfPlusTwoSession(), &batching_session));
+
+  // The two requests fill up the batch, which is processed right away.
+  std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "first_request_thread", [&batching_session] {
+        TestRequest({100.0f, 42.0f}, {2}, {52.0f, 23.0f}, {2},
+                    batching_session.get());
+      }));
+  std::unique_ptr<Thread> second_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "second_request_thread", [&batching_session] {
+        TestRequest({71.5f, 18.3f}, {2}, {37.75f, 11.15f}, {2},
+                    batching_session.get());
+      }));
+}
+
+TEST(BatchingSessionTest, StreamingSchedulerWithLargeBatchSplitting) {
+  StreamingBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 2;
+  schedule_options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+  schedule_options.num_batch_threads = 2;
+  schedule_options.enable_large_batch_splitting = true;
+  BatchSchedulerRetrier<BatchingSessionTask>::Options retry_options;
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  TF_ASSERT_OK(CreateStreamingBatchingSession(
+      schedule_options, retry_options, batching_session_options,
+      {{"x"}, {"y"}}, CreateHalfPlusTwoSession(), &batching_session));
+
+  // The request is split into two full batches.
+  TestRequest({100.0f, 42.0f, 71.5f, 18.3f}, {4},
+              {52.0f, 23.0f, 37.75f, 11.15f}, {4}, batching_session.get());
+}
+
+TEST(BatchingSessionTest, StreamingSchedulerRejectsMismatchedAllowedSizes) {
+  StreamingBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.allowed_batch_sizes = {2, 3};
+  std::unique_ptr<Session> batching_session;
+  EXPECT_FALSE(CreateStreamingBatchingSession(
+                   schedule_options, {}, batching_session_options,
+                   {{"x"}, {"y"}}, CreateHalfPlusTwoSession(),
+                   &batching_session)
+                   .ok());
+}
+
 TEST_P(BatchingSessionTest, BatchingWithLargeBatch) {
   BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
   schedule_options.max_batch_size = 3;
@@ -403,6 +746,45 @@ TEST_P(BatchingSessionTest, BatchingWithLargeBatch) {
   }
 }
 
+TEST_P(BatchingSessionTest, RowCost) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;  // fits two rows that cost 2 each
+  schedule_options.batch_timeout_micros = 1e6;
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.row_cost_func =
+      [](const std::vector<std::pair<string, Tensor>>& inputs) { return 2; };
+  std::unique_ptr<BatchSizeCapturingSession> batch_size_capturing_session(
+      new BatchSizeCapturingSession(CreateHalfPlusTwoSession()));
+  auto batch_size_capturing_session_raw = batch_size_capturing_session.get();
+  std::unique_ptr<Session> batching_session;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      std::move(batch_size_capturing_session), &batching_session));
+
+  {
+    // Two one-row requests fill a batch.
+    std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+        ThreadOptions(), "first_request_thread", [&batching_session] {
+          TestRequest({100.0f}, {1}, {52.0f}, {1}, batching_session.get());
+        }));
+    std::unique_ptr<Thread> second_request_thread(Env::Default()->StartThread(
+        ThreadOptions(), "second_request_thread", [&batching_session] {
+          TestRequest({42.0f}, {1}, {23.0f}, {1}, batching_session.get());
+        }));
+  }
+  EXPECT_EQ(2, batch_size_capturing_session_raw->latest_batch_size());
+
+  if (enable_large_batch_splitting()) {
+    // A three-row request costs 6, so it is split into batches of at most two
+    // rows.
+    TestRequest({100.0f, 42.0f, 10.0f}, {3}, {52.0f, 23.0f, 7.0f}, {3},
+                batching_session.get());
+    EXPECT_EQ(1, batch_size_capturing_session_raw->latest_batch_size());
+  }
+}
+
 TEST_P(BatchingSessionTest, BatchHandlesSplitError) {
   if (!enable_large_batch_splitting()) {
     return;
@@ -675,6 +1057,82 @@ TEST_P(BatchingSessionTest, SingletonBatch) {
               batching_session.get());
 }
 
+TEST_P(BatchingSessionTest, PooledBatchAssembly) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;  // fits two 2-unit tasks
+  schedule_options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+
+  std::unique_ptr<Session> batching_session;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.enable_pooled_batch_assembly = true;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateHalfPlusTwoSession(), &batching_session));
+
+  // Issue several rounds of batches of the same shape, so that later rounds
+  // are assembled into recycled buffers.
+  for (int round = 0; round < 3; ++round) {
+    std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+        ThreadOptions(), "first_request_thread", [&batching_session] {
+          TestRequest({100.0f, 42.0f}, {2}, {52.0f, 23.0f}, {2},
+                      batching_session.get());
+        }));
+    std::unique_ptr<Thread> second_request_thread(Env::Default()->StartThread(
+        ThreadOptions(), "second_request_thread", [&batching_session] {
+          TestRequest({71.5f, 18.3f}, {2}, {37.75f, 11.15f}, {2},
+                      batching_session.get());
+        }));
+  }
+}
+
+TEST_P(BatchingSessionTest, PooledBatchAssemblyWithPadding) {
+  std::unique_ptr<BatchSizeCapturingSession> batch_size_capturing_session(
+      new BatchSizeCapturingSession(CreateHalfPlusTwoSession()));
+  auto batch_size_capturing_session_raw = batch_size_capturing_session.get();
+
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;
+  schedule_options.batch_timeout_micros = 0;
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.allowed_batch_sizes = {1, 3, 4};
+  batching_session_options.enable_pooled_batch_assembly = true;
+  std::unique_ptr<Session> batching_session;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      std::move(batch_size_capturing_session), &batching_session));
+  for (int round = 0; round < 2; ++round) {
+    TestRequest({100.0f, 42.0f}, {2}, {52.0f, 23.0f}, {2},
+                batching_session.get());
+    // It should pad the batch size from 2 to 3.
+    EXPECT_EQ(3, batch_size_capturing_session_raw->latest_batch_size());
+  }
+}
+
+TEST_P(BatchingSessionTest, BatchInputAllocator) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;
+  schedule_options.batch_timeout_micros = 0;
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+  CountingAllocator allocator;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.batch_input_allocator = &allocator;
+  std::unique_ptr<Session> batching_session;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateHalfPlusTwoSession(), &batching_session));
+  for (int round = 0; round < 3; ++round) {
+    TestRequest({100.0f, 42.0f}, {2}, {52.0f, 23.0f}, {2},
+                batching_session.get());
+  }
+  // The merged input of the first batch is recycled by the later ones.
+  EXPECT_EQ(1, allocator.num_allocations());
+}
+
 TEST_P(BatchingSessionTest, RequestThatDoesntMatchSignatureGetsRunAnyway) {
   BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
   // Set the batching parameters s.t. if the request is batched the test will
@@ -819,6 +1277,136 @@ TEST_P(BatchingSessionTest, AllowedBatchSizesRequirePadding) {
       "Tracks the batch size distribution on processing.", {}));
 }
 
+TEST_P(BatchingSessionTest, PerSignatureBatchMetrics) {
+  const string kModelName = "per_signature_batch_metrics_model";
+  const HistogramProto start_fill = GetModelHistogram(
+      "/tensorflow/serving/batching_session/batch_fill_ratio", kModelName);
+  const HistogramProto start_overhead = GetModelHistogram(
+      "/tensorflow/serving/batching_session/padding_overhead", kModelName);
+  const HistogramProto start_depth = GetModelHistogram(
+      "/tensorflow/serving/batching_session/queue_depth", kModelName);
+
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;
+  schedule_options.batch_timeout_micros = 0;
+  schedule_options.num_batch_threads = 1;
+  schedule_options = annotate_options(schedule_options);
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.allowed_batch_sizes = {4};
+  batching_session_options.model_name = kModelName;
+  std::unique_ptr<Session> batching_session;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options, {{"x"}, {"y"}},
+      CreateHalfPlusTwoSession(), &batching_session));
+  TestRequest({100.0f, 42.0f, 10.0f}, {3}, {52.0f, 23.0f, 7.0f}, {3},
+              batching_session.get());
+
+  // The batch of 3 rows is padded to 4.
+  const HistogramProto fill = GetModelHistogram(
+      "/tensorflow/serving/batching_session/batch_fill_ratio", kModelName);
+  EXPECT_EQ(start_fill.num() + 1, fill.num());
+  EXPECT_NEAR(start_fill.sum() + 0.75, fill.sum(), 1e-6);
+  const HistogramProto overhead = GetModelHistogram(
+      "/tensorflow/serving/batching_session/padding_overhead", kModelName);
+  EXPECT_EQ(start_overhead.num() + 1, overhead.num());
+  EXPECT_NEAR(start_overhead.sum() + 4.0 / 3, overhead.sum(), 1e-6);
+  // Nothing else was waiting when the request was enqueued.
+  const HistogramProto depth = GetModelHistogram(
+      "/tensorflow/serving/batching_session/queue_depth", kModelName);
+  EXPECT_EQ(start_depth.num() + 1, depth.num());
+  EXPECT_EQ(start_depth.sum(), depth.sum());
+  EXPECT_TRUE(CheckDescriptor(
+      "/tensorflow/serving/batching_session/split_tasks",
+      "Total count of processed tasks that are splits of a larger task",
+      {"model_name", "signature"}));
+}
+
+TEST(BatchingSessionTest, RaggedTensors) {
+  std::unique_ptr<EchoSession> echo_session(new EchoSession);
+  EchoSession* echo_session_raw = echo_session.get();
+
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 5;
+  schedule_options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+  schedule_options.num_batch_threads = 1;
+  BatchingSessionOptions batching_session_options;
+  // A batch of the two 2-row tasks is padded with an empty row.
+  batching_session_options.allowed_batch_sizes = {5};
+  batching_session_options.ragged_tensors = {{"values", "row_splits"}};
+  std::unique_ptr<Session> batching_session;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options,
+      {{"values", "row_splits"}, {"values", "row_splits"}},
+      std::move(echo_session), &batching_session));
+
+  auto test_request = [&batching_session](
+                          const std::vector<float>& values,
+                          const std::vector<int64_t>& row_splits) {
+    const Tensor values_tensor = test::AsTensor<float>(
+        values, {static_cast<int64_t>(values.size())});
+    const Tensor row_splits_tensor = test::AsTensor<int64_t>(
+        row_splits, {static_cast<int64_t>(row_splits.size())});
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(batching_session->Run(
+        {{"values", values_tensor}, {"row_splits", row_splits_tensor}},
+        {"values", "row_splits"}, {} /* target nodes */, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    test::ExpectTensorEqual<float>(values_tensor, outputs[0]);
+    test::ExpectTensorEqual<int64_t>(row_splits_tensor, outputs[1]);
+  };
+  {
+    std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+        ThreadOptions(), "first_request_thread",
+        [&test_request] { test_request({1, 2, 3}, {0, 1, 3}); }));
+    std::unique_ptr<Thread> second_request_thread(Env::Default()->StartThread(
+        ThreadOptions(), "second_request_thread",
+        [&test_request] { test_request({4}, {0, 0, 1}); }));
+  }
+
+  // The values are concatenated without padding, and the row splits offset.
+  std::map<string, Tensor> batched_inputs;
+  for (const auto& input : echo_session_raw->latest_inputs()) {
+    batched_inputs[input.first] = input.second;
+  }
+  const Tensor& batched_values = batched_inputs["values"];
+  const Tensor& batched_row_splits = batched_inputs["row_splits"];
+  ASSERT_EQ(4, batched_values.NumElements());
+  const std::vector<float> first_values = {1, 2, 3, 4};
+  const std::vector<float> second_values = {4, 1, 2, 3};
+  const std::vector<float> values(
+      batched_values.flat<float>().data(),
+      batched_values.flat<float>().data() + batched_values.NumElements());
+  EXPECT_TRUE(values == first_values || values == second_values);
+  const std::vector<int64_t> row_splits(
+      batched_row_splits.flat<int64_t>().data(),
+      batched_row_splits.flat<int64_t>().data() +
+          batched_row_splits.NumElements());
+  EXPECT_TRUE(row_splits == std::vector<int64_t>({0, 1, 3, 3, 4, 4}) ||
+              row_splits == std::vector<int64_t>({0, 0, 1, 2, 4, 4}));
+}
+
+TEST(BatchingSessionTest, RaggedTensorsWithMismatchedRowSplits) {
+  BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
+  schedule_options.max_batch_size = 4;
+  schedule_options.batch_timeout_micros = 0;
+  schedule_options.num_batch_threads = 1;
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.ragged_tensors = {{"values", "row_splits"}};
+  std::unique_ptr<Session> batching_session;
+  TF_ASSERT_OK(CreateBasicBatchingSession(
+      schedule_options, batching_session_options,
+      {{"values", "row_splits"}, {"values", "row_splits"}},
+      std::unique_ptr<Session>(new EchoSession), &batching_session));
+
+  // The row splits must end at the number of values.
+  std::vector<Tensor> outputs;
+  const Status status = batching_session->Run(
+      {{"values", test::AsTensor<float>({1, 2}, {2})},
+       {"row_splits", test::AsTensor<int64_t>({0, 1, 3}, {3})}},
+      {"values", "row_splits"}, {} /* target nodes */, &outputs);
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+}
+
 TEST_P(BatchingSessionTest, UnsortedAllowedBatchSizesRejected) {
   BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
   schedule_options.max_batch_size = 4;
@@ -966,6 +1554,120 @@ TEST_P(BatchingSessionTest, MultipleSignatures) {
   EXPECT_EQ(0, schedulers[1]->NumEnqueuedTasks());
 }
 
+TEST_P(BatchingSessionTest, JointSignatureBatching) {
+  std::vector<BatchScheduler<BatchingSessionTask>*> schedulers;
+  auto create_scheduler =
+      [&schedulers, this](
+          std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<BatchingSessionTask>>* scheduler) {
+        BasicBatchScheduler<BatchingSessionTask>::Options options;
+        options.max_batch_size = 4;  // fits two 2-unit tasks
+        options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+        options.num_batch_threads = 1;
+        options = annotate_options(options);
+        std::unique_ptr<BasicBatchScheduler<BatchingSessionTask>>
+            basic_scheduler;
+        TF_RETURN_IF_ERROR(BasicBatchScheduler<BatchingSessionTask>::Create(
+            options, process_batch_callback, &basic_scheduler));
+        schedulers.push_back(basic_scheduler.get());
+        *scheduler = std::move(basic_scheduler);
+        return OkStatus();
+      };
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.enable_joint_signature_batching = true;
+  std::unique_ptr<Session> batching_session;
+  TF_CHECK_OK(CreateBatchingSession(
+      batching_session_options,
+      {{{{"x", "x2"}, {"y"}}, create_scheduler},
+       {{{"x", "x2"}, {"y3"}}, create_scheduler},
+       {{{"x", "x2"}, {"y", "y3"}}, create_scheduler}},
+      CreateHalfPlusTwoSession(), &batching_session));
+  // The three signatures share one scheduler.
+  ASSERT_EQ(1, schedulers.size());
+
+  Tensor input = test::AsTensor<float>({100.0f, 42.0f}, {2});
+  std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "first_request_thread", [&] {
+        std::vector<Tensor> outputs;
+        TF_ASSERT_OK(batching_session->Run({{"x", input}, {"x2", input}},
+                                           {"y"} /* outputs */,
+                                           {} /* target nodes */, &outputs));
+        ASSERT_EQ(1, outputs.size());
+        test::ExpectTensorEqual<float>(
+            test::AsTensor<float>({52.0f, 23.0f}, {2}), outputs[0]);
+      }));
+  while (schedulers[0]->NumEnqueuedTasks() != 1) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+
+  // A request for the other output fills the batch, so both requests are
+  // processed together.
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(batching_session->Run({{"x", input}, {"x2", input}},
+                                     {"y3"} /* outputs */,
+                                     {} /* target nodes */, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({53.0f, 24.0f}, {2}),
+                                 outputs[0]);
+  EXPECT_EQ(0, schedulers[0]->NumEnqueuedTasks());
+}
+
+TEST_P(BatchingSessionTest, JointSignatureBatchingOfOutputSubsets) {
+  std::vector<BatchScheduler<BatchingSessionTask>*> schedulers;
+  auto create_scheduler =
+      [&schedulers, this](
+          std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<BatchingSessionTask>>* scheduler) {
+        BasicBatchScheduler<BatchingSessionTask>::Options options;
+        options.max_batch_size = 4;  // fits two 2-unit tasks
+        options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+        options.num_batch_threads = 1;
+        options = annotate_options(options);
+        std::unique_ptr<BasicBatchScheduler<BatchingSessionTask>>
+            basic_scheduler;
+        TF_RETURN_IF_ERROR(BasicBatchScheduler<BatchingSessionTask>::Create(
+            options, process_batch_callback, &basic_scheduler));
+        schedulers.push_back(basic_scheduler.get());
+        *scheduler = std::move(basic_scheduler);
+        return OkStatus();
+      };
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.enable_joint_signature_batching = true;
+  std::unique_ptr<Session> batching_session;
+  TF_CHECK_OK(CreateBatchingSession(
+      batching_session_options,
+      {{{{"x", "x2"}, {"y", "y3"}}, create_scheduler}},
+      CreateHalfPlusTwoSession(), &batching_session));
+  ASSERT_EQ(1, schedulers.size());
+
+  // Runs that fetch one output each join the batches of the signature.
+  Tensor input = test::AsTensor<float>({100.0f, 42.0f}, {2});
+  std::unique_ptr<Thread> first_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "first_request_thread", [&] {
+        std::vector<Tensor> outputs;
+        TF_ASSERT_OK(batching_session->Run({{"x", input}, {"x2", input}},
+                                           {"y"} /* outputs */,
+                                           {} /* target nodes */, &outputs));
+        ASSERT_EQ(1, outputs.size());
+        test::ExpectTensorEqual<float>(
+            test::AsTensor<float>({52.0f, 23.0f}, {2}), outputs[0]);
+      }));
+  while (schedulers[0]->NumEnqueuedTasks() != 1) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(batching_session->Run({{"x", input}, {"x2", input}},
+                                     {"y3"} /* outputs */,
+                                     {} /* target nodes */, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({53.0f, 24.0f}, {2}),
+                                 outputs[0]);
+  EXPECT_EQ(0, schedulers[0]->NumEnqueuedTasks());
+}
+
 TEST_P(BatchingSessionTest, EnqueuedLongerThanTimeout) {
   BatchScheduler<BatchingSessionTask>* scheduler = nullptr;
   auto create_scheduler =
@@ -1024,6 +1726,132 @@ TEST_P(BatchingSessionTest, EnqueuedLongerThanTimeout) {
   request_returned.WaitForNotification();
 }
 
+TEST_P(BatchingSessionTest, ShedsExpiredTasks) {
+  BatchScheduler<BatchingSessionTask>* scheduler = nullptr;
+  auto create_scheduler =
+      [&scheduler, this](
+          std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<BatchingSessionTask>>* new_scheduler) {
+        BasicBatchScheduler<BatchingSessionTask>::Options options;
+        options.max_batch_size = 4;  // fits two 2-unit tasks
+        options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+        options.num_batch_threads = 1;
+        options = annotate_options(options);
+        std::unique_ptr<BasicBatchScheduler<BatchingSessionTask>>
+            basic_scheduler;
+        TF_RETURN_IF_ERROR(BasicBatchScheduler<BatchingSessionTask>::Create(
+            options, process_batch_callback, &basic_scheduler));
+        scheduler = basic_scheduler.get();
+        *new_scheduler = std::move(basic_scheduler);
+        return OkStatus();
+      };
+  BatchingSessionOptions batching_session_options;
+  batching_session_options.shed_expired_tasks = true;
+  std::unique_ptr<BatchSizeCapturingSession> batch_size_capturing_session(
+      new BatchSizeCapturingSession(CreateHalfPlusTwoSession()));
+  auto batch_size_capturing_session_raw = batch_size_capturing_session.get();
+  std::unique_ptr<Session> batching_session;
+  TF_CHECK_OK(CreateBatchingSession(
+      batching_session_options, {{{{"x"}, {"y"}}, create_scheduler}},
+      std::move(batch_size_capturing_session), &batching_session));
+  ASSERT_FALSE(scheduler == nullptr);
+
+  // Enqueue a request with a timeout that expires while it waits for the batch
+  // to fill.
+  std::unique_ptr<Thread> expiring_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "expiring_request_thread", [&batching_session] {
+        Tensor input = test::AsTensor<float>({100.0f, 42.0f}, {2});
+        RunOptions run_options;
+        run_options.set_timeout_in_ms(1);
+        std::vector<Tensor> outputs;
+        RunMetadata run_metadata;
+        const Status status = batching_session->Run(
+            run_options, {{"x", input}}, {"y"} /* outputs */,
+            {} /* target nodes */, &outputs, &run_metadata);
+        EXPECT_EQ(error::RESOURCE_EXHAUSTED, status.code());
+        EXPECT_THAT(status.message(),
+                    HasSubstr("timeout exceeded while waiting in batching"));
+      }));
+  while (scheduler->NumEnqueuedTasks() != 1) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+
+  // A request without a timeout fills the batch, and is run without the
+  // expired one.
+  TestRequest({71.5f, 18.3f}, {2}, {37.75f, 11.15f}, {2},
+              batching_session.get());
+  expiring_request_thread.reset();
+  EXPECT_EQ(2, batch_size_capturing_session_raw->latest_batch_size());
+}
+
+TEST_P(BatchingSessionTest, LeavesOutCancelledTasks) {
+  BatchScheduler<BatchingSessionTask>* scheduler = nullptr;
+  auto create_scheduler =
+      [&scheduler, this](
+          std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<BatchingSessionTask>>* new_scheduler) {
+        BasicBatchScheduler<BatchingSessionTask>::Options options;
+        options.max_batch_size = 4;  // fits two 2-unit tasks
+        options.batch_timeout_micros = 1 * 1000 * 1000;  // won't trigger
+        options.num_batch_threads = 1;
+        options = annotate_options(options);
+        std::unique_ptr<BasicBatchScheduler<BatchingSessionTask>>
+            basic_scheduler;
+        TF_RETURN_IF_ERROR(BasicBatchScheduler<BatchingSessionTask>::Create(
+            options, process_batch_callback, &basic_scheduler));
+        scheduler = basic_scheduler.get();
+        *new_scheduler = std::move(basic_scheduler);
+        return OkStatus();
+      };
+  std::unique_ptr<BatchSizeCapturingSession> batch_size_capturing_session(
+      new BatchSizeCapturingSession(CreateHalfPlusTwoSession()));
+  auto batch_size_capturing_session_raw = batch_size_capturing_session.get();
+  std::unique_ptr<Session> batching_session;
+  TF_CHECK_OK(CreateBatchingSession(
+      BatchingSessionOptions(), {{{{"x"}, {"y"}}, create_scheduler}},
+      std::move(batch_size_capturing_session), &batching_session));
+  ASSERT_FALSE(scheduler == nullptr);
+
+  // Enqueue a request whose caller cancels it while it waits for the batch to
+  // fill.
+  std::atomic<bool> cancelled{false};
+  std::unique_ptr<Thread> cancelled_request_thread(Env::Default()->StartThread(
+      ThreadOptions(), "cancelled_request_thread",
+      [&batching_session, &cancelled] {
+        ScopedRequestDeadline deadline_scope(std::make_shared<RequestDeadline>(
+            absl::InfiniteFuture(),
+            [&cancelled]() { return cancelled.load(); }));
+        Tensor input = test::AsTensor<float>({100.0f, 42.0f}, {2});
+        std::vector<Tensor> outputs;
+        RunMetadata run_metadata;
+        const Status status = batching_session->Run(
+            RunOptions(), {{"x", input}}, {"y"} /* outputs */,
+            {} /* target nodes */, &outputs, &run_metadata);
+        EXPECT_EQ(error::CANCELLED, status.code());
+      }));
+  while (scheduler->NumEnqueuedTasks() != 1) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  cancelled = true;
+
+  // Another request fills the batch, and is run without the cancelled one.
+  TestRequest({71.5f, 18.3f}, {2}, {37.75f, 11.15f}, {2},
+              batching_session.get());
+  cancelled_request_thread.reset();
+  EXPECT_EQ(2, batch_size_capturing_session_raw->latest_batch_size());
+
+  // Requests that are cancelled before they are issued are not enqueued.
+  ScopedRequestDeadline deadline_scope(std::make_shared<RequestDeadline>(
+      absl::InfiniteFuture(), []() { return true; }));
+  Tensor input = test::AsTensor<float>({100.0f, 42.0f}, {2});
+  std::vector<Tensor> outputs;
+  EXPECT_EQ(error::CANCELLED,
+            batching_session->Run({{"x", input}}, {"y"}, {}, &outputs).code());
+}
+
 TEST_P(BatchingSessionTest, ThreadPoolOptions) {
   BasicBatchScheduler<BatchingSessionTask>::Options schedule_options;
   schedule_options.max_batch_size = 3;
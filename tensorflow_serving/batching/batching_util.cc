@@ -15,16 +15,24 @@ limitations under the License.
 
 #include "tensorflow_serving/batching/batching_util.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <map>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/env_time.h"
+#include "tensorflow/core/platform/hash.h"
+#include "tensorflow_serving/util/hash.h"
 
 namespace tensorflow {
 namespace serving {
@@ -64,16 +72,84 @@ Eigen::array<OneDimPadding, num_dims> CreatePadding(
   return padding;
 }
 
+// Fills 'count' elements starting at 'data' with 'value', using memset if the
+// value's bytes are all zero.
+template <typename T>
+void FillWithValue(const T& value, bool value_is_zero, int64_t count,
+                   T* data) {
+  if (count <= 0) {
+    return;
+  }
+  if (value_is_zero) {
+    std::memset(data, 0, count * sizeof(T));
+  } else {
+    std::fill_n(data, count, value);
+  }
+}
+
+// Fast path for padding rank-2 and rank-3 tensors of trivially copyable types:
+// copies each row of the innermost dimension with memcpy and fills only the
+// padded regions, instead of evaluating a generic Eigen pad expression.
+// Returns false (leaving 'output' untouched) if the fast path does not apply.
+template <typename T, int num_dims>
+bool PadInnermostRows(const Tensor& input, const T& pad_value,
+                      Tensor* output) {
+  if constexpr ((num_dims != 2 && num_dims != 3) ||
+                !std::is_trivially_copyable<T>::value) {
+    return false;
+  } else {
+    if (!DataTypeCanUseMemcpy(input.dtype())) {
+      return false;
+    }
+    bool pad_value_is_zero = true;
+    const char* pad_value_bytes = reinterpret_cast<const char*>(&pad_value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      if (pad_value_bytes[i] != 0) {
+        pad_value_is_zero = false;
+        break;
+      }
+    }
+
+    // View both tensors as [outer, middle, inner], where 'middle' is 1 for
+    // rank-2 tensors.
+    const int64_t outer = input.dim_size(0);
+    const int64_t input_middle = num_dims == 3 ? input.dim_size(1) : 1;
+    const int64_t output_middle = num_dims == 3 ? output->dim_size(1) : 1;
+    const int64_t input_inner = input.dim_size(num_dims - 1);
+    const int64_t output_inner = output->dim_size(num_dims - 1);
+
+    const T* input_data = input.unaligned_flat<T>().data();
+    T* output_data = output->unaligned_flat<T>().data();
+    for (int64_t i = 0; i < outer; ++i) {
+      for (int64_t j = 0; j < output_middle; ++j) {
+        T* output_row = output_data + (i * output_middle + j) * output_inner;
+        if (j < input_middle) {
+          const T* input_row =
+              input_data + (i * input_middle + j) * input_inner;
+          std::memcpy(output_row, input_row, input_inner * sizeof(T));
+          FillWithValue(pad_value, pad_value_is_zero,
+                        output_inner - input_inner, output_row + input_inner);
+        } else {
+          FillWithValue(pad_value, pad_value_is_zero, output_inner,
+                        output_row);
+        }
+      }
+    }
+    return true;
+  }
+}
+
 // Functor, which performs padding of given input tensor
 // using specified padding signature.
 // For example, given tensor of shape [1, 2, 3] and padding signature
 // [[0, 0], [0, 2], [2, 2]]
 // functor produces padded_tensor of shape [1, 4, 7].
+// If 'pool' is non-null, the padded tensor is allocated from it.
 template <typename T, int num_dims>
 struct PadTensor {
   Status operator()(Tensor input,
                     const Eigen::array<OneDimPadding, num_dims>& padding,
-                    Tensor* output) {
+                    BatchTensorPool* pool, Tensor* output) {
     TensorShape output_shape;
     for (int d = 0; d < num_dims; ++d) {
       // Pad before existing elements.
@@ -93,9 +169,15 @@ struct PadTensor {
       return errors::InvalidArgument(
           "Got empty tensor in batch of non-empty tensors.");
     }
-    *output = Tensor(input.dtype(), output_shape);
-    typename TTypes<T, num_dims>::Tensor inputs = input.tensor<T, num_dims>();
+    *output = pool != nullptr ? pool->Allocate(input.dtype(), output_shape)
+                              : Tensor(input.dtype(), output_shape);
     T pad_value(input.flat<T>()(0));  // using existing values in padding
+    // The fast path only supports padding after existing elements, which is
+    // the only kind of padding CreatePadding() produces.
+    if (PadInnermostRows<T, num_dims>(input, pad_value, output)) {
+      return OkStatus();
+    }
+    typename TTypes<T, num_dims>::Tensor inputs = input.tensor<T, num_dims>();
     output->tensor<T, num_dims>() = inputs.pad(padding, pad_value);
     return OkStatus();
   }
@@ -106,44 +188,44 @@ struct PadTensor {
 template <typename T>
 Status PadTensorOfSpecificType(const Tensor& tensor,
                                absl::Span<const int> max_dim_sizes,
-                               Tensor* output_tensor) {
+                               BatchTensorPool* pool, Tensor* output_tensor) {
   int num_dims = tensor.dims();
   switch (num_dims) {
     case 1: {
       Eigen::array<OneDimPadding, 1> padding;
       padding = CreatePadding<1>(tensor, max_dim_sizes);
       PadTensor<T, 1> padding_functor = PadTensor<T, 1>();
-      return padding_functor(tensor, padding, output_tensor);
+      return padding_functor(tensor, padding, pool, output_tensor);
     }
     case 2: {
       Eigen::array<OneDimPadding, 2> padding;
       padding = CreatePadding<2>(tensor, max_dim_sizes);
       PadTensor<T, 2> padding_functor = PadTensor<T, 2>();
-      return padding_functor(tensor, padding, output_tensor);
+      return padding_functor(tensor, padding, pool, output_tensor);
     }
     case 3: {
       Eigen::array<OneDimPadding, 3> padding;
       padding = CreatePadding<3>(tensor, max_dim_sizes);
       PadTensor<T, 3> padding_functor = PadTensor<T, 3>();
-      return padding_functor(tensor, padding, output_tensor);
+      return padding_functor(tensor, padding, pool, output_tensor);
     }
     case 4: {
       Eigen::array<OneDimPadding, 4> padding;
       padding = CreatePadding<4>(tensor, max_dim_sizes);
       PadTensor<T, 4> padding_functor = PadTensor<T, 4>();
-      return padding_functor(tensor, padding, output_tensor);
+      return padding_functor(tensor, padding, pool, output_tensor);
     }
     case 5: {
       Eigen::array<OneDimPadding, 5> padding;
       padding = CreatePadding<5>(tensor, max_dim_sizes);
       PadTensor<T, 5> padding_functor = PadTensor<T, 5>();
-      return padding_functor(tensor, padding, output_tensor);
+      return padding_functor(tensor, padding, pool, output_tensor);
     }
     case 6: {
       Eigen::array<OneDimPadding, 6> padding;
       padding = CreatePadding<6>(tensor, max_dim_sizes);
       PadTensor<T, 6> padding_functor = PadTensor<T, 6>();
-      return padding_functor(tensor, padding, output_tensor);
+      return padding_functor(tensor, padding, pool, output_tensor);
     }
     default:
       // only ranks from 1 to 6 are supported
@@ -155,10 +237,20 @@ Status PadTensorOfSpecificType(const Tensor& tensor,
 
 std::map<string, std::vector<int>> CalculateMaxDimSizes(
     const std::vector<std::vector<std::pair<string, Tensor>>>& batch) {
+  std::vector<const std::vector<std::pair<string, Tensor>>*> batch_ptrs;
+  batch_ptrs.reserve(batch.size());
+  for (const auto& task_inputs : batch) {
+    batch_ptrs.push_back(&task_inputs);
+  }
+  return CalculateMaxDimSizes(batch_ptrs);
+}
+
+std::map<string, std::vector<int>> CalculateMaxDimSizes(
+    absl::Span<const std::vector<std::pair<string, Tensor>>* const> batch) {
   std::map<string, std::vector<int>> max_dim_sizes;
   // Populate 'max_dim_sizes'
   // init
-  const std::vector<std::pair<string, Tensor>>& task_inputs = batch[0];
+  const std::vector<std::pair<string, Tensor>>& task_inputs = *batch[0];
   for (const auto& entry : task_inputs) {
     const string& tensor_name = entry.first;
     const Tensor& tensor = entry.second;
@@ -166,7 +258,7 @@ std::map<string, std::vector<int>> CalculateMaxDimSizes(
   }
   // fill
   for (int i = 0; i < batch.size(); ++i) {
-    const std::vector<std::pair<string, Tensor>>& task_inputs = batch[i];
+    const std::vector<std::pair<string, Tensor>>& task_inputs = *batch[i];
     for (const auto& entry : task_inputs) {
       const string& tensor_name = entry.first;
       const Tensor& tensor = entry.second;
@@ -186,12 +278,17 @@ std::map<string, std::vector<int>> CalculateMaxDimSizes(
 
 Status AddPadding(const Tensor& tensor, absl::Span<const int> max_dim_sizes,
                   Tensor* padded_tensor) {
+  return AddPadding(tensor, max_dim_sizes, /*pool=*/nullptr, padded_tensor);
+}
+
+Status AddPadding(const Tensor& tensor, absl::Span<const int> max_dim_sizes,
+                  BatchTensorPool* pool, Tensor* padded_tensor) {
   const DataType input_dtype = tensor.dtype();
   Status padding_status;
 #define CASE(type)                                                           \
   case DataTypeToEnum<type>::value: {                                        \
-    padding_status =                                                         \
-        PadTensorOfSpecificType<type>(tensor, max_dim_sizes, padded_tensor); \
+    padding_status = PadTensorOfSpecificType<type>(tensor, max_dim_sizes,   \
+                                                   pool, padded_tensor);     \
     break;                                                                   \
   }
   switch (input_dtype) {
@@ -207,6 +304,143 @@ Status AddPadding(const Tensor& tensor, absl::Span<const int> max_dim_sizes,
   return padding_status;
 }
 
+namespace {
+
+// Copies the rows of 'src', of shape 'src_dims', to those of 'dst', of shape
+// 'dst_dims', which is no smaller in any dimension, and fills the rest of 'dst'
+// with 'pad'. 'src_strides' and 'dst_strides' are the elements between the
+// rows of each dimension. 'Word' is an unsigned integer as large as the
+// elements, so the loops copy and fill whole elements.
+template <typename Word>
+void CopyPadded(const Word* src, const int64_t* src_dims,
+                const int64_t* src_strides, const int64_t* dst_dims,
+                const int64_t* dst_strides, const int rank, const Word pad,
+                Word* dst) {
+  if (rank == 1) {
+    std::copy_n(src, src_dims[0], dst);
+    std::fill(dst + src_dims[0], dst + dst_dims[0], pad);
+    return;
+  }
+  for (int64_t i = 0; i < src_dims[0]; ++i) {
+    CopyPadded(src + i * src_strides[0], src_dims + 1, src_strides + 1,
+               dst_dims + 1, dst_strides + 1, rank - 1, pad,
+               dst + i * dst_strides[0]);
+  }
+  std::fill(dst + src_dims[0] * dst_strides[0],
+            dst + dst_dims[0] * dst_strides[0], pad);
+}
+
+template <typename Word>
+void PadAndConcatWords(absl::Span<const Tensor> tensors,
+                       const TensorShape& row_shape, int num_padding_rows,
+                       Tensor* result) {
+  const int rank = row_shape.dims() + 1;
+  const int64_t row_size = row_shape.num_elements();
+  Word* const dst = reinterpret_cast<Word*>(
+      const_cast<char*>(result->tensor_data().data()));
+  int64_t offset = 0;
+  for (const Tensor& tensor : tensors) {
+    const Word* const src =
+        reinterpret_cast<const Word*>(tensor.tensor_data().data());
+    // The trailing dimensions that need no padding are copied as one: e.g.
+    // [n, 3, 4] into [n, 5, 4] goes by rows of 12 elements into rows of 20.
+    int copy_rank = rank;
+    int64_t run_size = 1;
+    while (copy_rank > 1 && tensor.dim_size(copy_rank - 1) ==
+                                row_shape.dim_size(copy_rank - 2)) {
+      run_size *= tensor.dim_size(copy_rank - 1);
+      --copy_rank;
+    }
+    int64_t src_dims[6], dst_dims[6], src_strides[6], dst_strides[6];
+    for (int d = 0; d < copy_rank; ++d) {
+      src_dims[d] = tensor.dim_size(d);
+      dst_dims[d] = d == 0 ? src_dims[0] : row_shape.dim_size(d - 1);
+    }
+    src_dims[copy_rank - 1] *= run_size;
+    dst_dims[copy_rank - 1] *= run_size;
+    src_strides[copy_rank - 1] = dst_strides[copy_rank - 1] = 1;
+    for (int d = copy_rank - 2; d >= 0; --d) {
+      src_strides[d] = src_dims[d + 1] * src_strides[d + 1];
+      dst_strides[d] = dst_dims[d + 1] * dst_strides[d + 1];
+    }
+    CopyPadded(src, src_dims, src_strides, dst_dims, dst_strides, copy_rank,
+               src[0], dst + offset * row_size);
+    offset += tensor.dim_size(0);
+  }
+  // The padding rows repeat the first row of the last tensor.
+  const Word* const last_row =
+      dst + (offset - tensors.back().dim_size(0)) * row_size;
+  for (int i = 0; i < num_padding_rows; ++i) {
+    std::copy_n(last_row, row_size, dst + (offset + i) * row_size);
+  }
+}
+
+}  // namespace
+
+bool PadAndConcat(absl::Span<const Tensor> tensors,
+                  absl::Span<const int> max_dim_sizes,
+                  const int num_padding_rows, BatchTensorPool* pool,
+                  Tensor* result) {
+  if (tensors.empty() || num_padding_rows < 0) {
+    return false;
+  }
+  const DataType dtype = tensors[0].dtype();
+  const int rank = max_dim_sizes.size();
+  if (!DataTypeCanUseMemcpy(dtype) || rank < 1 || rank > 6) {
+    return false;
+  }
+  const int element_size = DataTypeSize(dtype);
+  if (element_size != 1 && element_size != 2 && element_size != 4 &&
+      element_size != 8) {
+    return false;
+  }
+  TensorShape row_shape;
+  for (int d = 1; d < rank; ++d) {
+    row_shape.AddDim(max_dim_sizes[d]);
+  }
+  int64_t num_rows = num_padding_rows;
+  for (const Tensor& tensor : tensors) {
+    if (tensor.dtype() != dtype || tensor.dims() != rank ||
+        tensor.NumElements() == 0 ||
+        reinterpret_cast<uintptr_t>(tensor.tensor_data().data()) %
+                element_size !=
+            0) {
+      return false;
+    }
+    for (int d = 1; d < rank; ++d) {
+      if (tensor.dim_size(d) > max_dim_sizes[d]) {
+        return false;
+      }
+    }
+    num_rows += tensor.dim_size(0);
+  }
+
+  TensorShape shape = row_shape;
+  shape.InsertDim(0, num_rows);
+  Tensor merged =
+      pool != nullptr ? pool->Allocate(dtype, shape) : Tensor(dtype, shape);
+  switch (element_size) {
+    case 1:
+      PadAndConcatWords<uint8_t>(tensors, row_shape, num_padding_rows,
+                                 &merged);
+      break;
+    case 2:
+      PadAndConcatWords<uint16_t>(tensors, row_shape, num_padding_rows,
+                                  &merged);
+      break;
+    case 4:
+      PadAndConcatWords<uint32_t>(tensors, row_shape, num_padding_rows,
+                                  &merged);
+      break;
+    case 8:
+      PadAndConcatWords<uint64_t>(tensors, row_shape, num_padding_rows,
+                                  &merged);
+      break;
+  }
+  *result = std::move(merged);
+  return true;
+}
+
 int RoundToLowestAllowedBatchSize(absl::Span<const int> allowed_batch_sizes,
                                   int batch_size) {
   if (allowed_batch_sizes.empty()) {
@@ -239,5 +473,196 @@ bool AreShapesEqualExceptZeroDim(const TensorShape& shape1,
   return true;
 }
 
+Status SplitTensorWithAliasing(const Tensor& tensor,
+                               absl::Span<const int64_t> sizes,
+                               std::vector<Tensor>* result) {
+  if (tensor.dims() == 0) {
+    return errors::InvalidArgument("Cannot split a zero-dimensional tensor");
+  }
+  int64_t total_size = 0;
+  for (const int64_t size : sizes) {
+    total_size += size;
+  }
+  if (total_size != tensor.dim_size(0)) {
+    return errors::InvalidArgument(
+        "The split sizes sum to ", total_size,
+        ", which does not match the 0th dimension size of the tensor ",
+        tensor.dim_size(0));
+  }
+
+  result->clear();
+  result->reserve(sizes.size());
+  int64_t start = 0;
+  for (const int64_t size : sizes) {
+    Tensor slice = tensor.Slice(start, start + size);
+    if (slice.IsAligned()) {
+      result->push_back(std::move(slice));
+    } else {
+      result->push_back(tensor::DeepCopy(slice));
+    }
+    start += size;
+  }
+  return OkStatus();
+}
+
+bool IsRowDeduplicationSupported(DataType dtype) {
+  return DataTypeCanUseMemcpy(dtype) || dtype == DT_STRING;
+}
+
+namespace {
+
+// Returns the hash of row 'row' of 'tensor', which is 'num_elements' elements
+// (or, for plain-old-data types, 'num_bytes' bytes) long.
+uint64_t HashRow(const Tensor& tensor, int64_t row, int64_t num_elements,
+                 int64_t num_bytes) {
+  if (tensor.dtype() == DT_STRING) {
+    const auto flat = tensor.flat<tstring>();
+    uint64_t hash = 0;
+    for (int64_t i = row * num_elements; i < (row + 1) * num_elements; ++i) {
+      hash = HashCombine(hash, Hash64(flat(i).data(), flat(i).size()));
+    }
+    return hash;
+  }
+  return Hash64(tensor.tensor_data().data() + row * num_bytes, num_bytes);
+}
+
+// Returns true iff rows 'row1' and 'row2' of 'tensor' are equal.
+bool RowsEqual(const Tensor& tensor, int64_t row1, int64_t row2,
+               int64_t num_elements, int64_t num_bytes) {
+  if (tensor.dtype() == DT_STRING) {
+    const auto flat = tensor.flat<tstring>();
+    for (int64_t i = 0; i < num_elements; ++i) {
+      if (flat(row1 * num_elements + i) != flat(row2 * num_elements + i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  const char* data = tensor.tensor_data().data();
+  return std::memcmp(data + row1 * num_bytes, data + row2 * num_bytes,
+                     num_bytes) == 0;
+}
+
+}  // namespace
+
+Status FindUniqueRows(absl::Span<const Tensor> tensors,
+                      std::vector<int64_t>* unique_rows,
+                      std::vector<int64_t>* row_to_unique) {
+  unique_rows->clear();
+  row_to_unique->clear();
+  if (tensors.empty()) {
+    return OkStatus();
+  }
+  const int64_t num_rows = tensors[0].dims() > 0 ? tensors[0].dim_size(0) : 0;
+  std::vector<int64_t> num_elements_per_row;
+  std::vector<int64_t> num_bytes_per_row;
+  for (const Tensor& tensor : tensors) {
+    if (tensor.dims() == 0 || tensor.dim_size(0) != num_rows) {
+      return errors::InvalidArgument(
+          "Tensors must have equal 0th dimension sizes to find unique rows");
+    }
+    if (!IsRowDeduplicationSupported(tensor.dtype())) {
+      return errors::Unimplemented("Cannot compare rows of tensors of type ",
+                                   DataTypeString(tensor.dtype()));
+    }
+    const int64_t num_elements =
+        num_rows == 0 ? 0 : tensor.NumElements() / num_rows;
+    num_elements_per_row.push_back(num_elements);
+    num_bytes_per_row.push_back(tensor.dtype() == DT_STRING
+                                    ? 0
+                                    : num_elements *
+                                          DataTypeSize(tensor.dtype()));
+  }
+
+  // For each row hash, the positions in 'unique_rows' of the rows with that
+  // hash.
+  std::unordered_map<uint64_t, std::vector<int64_t>> unique_rows_by_hash;
+  unique_rows_by_hash.reserve(num_rows);
+  row_to_unique->reserve(num_rows);
+  for (int64_t row = 0; row < num_rows; ++row) {
+    uint64_t hash = 0;
+    for (int i = 0; i < tensors.size(); ++i) {
+      hash = HashCombine(hash, HashRow(tensors[i], row, num_elements_per_row[i],
+                                       num_bytes_per_row[i]));
+    }
+    std::vector<int64_t>& candidates = unique_rows_by_hash[hash];
+    int64_t unique_index = -1;
+    for (const int64_t candidate : candidates) {
+      bool equal = true;
+      for (int i = 0; i < tensors.size() && equal; ++i) {
+        equal = RowsEqual(tensors[i], (*unique_rows)[candidate], row,
+                          num_elements_per_row[i], num_bytes_per_row[i]);
+      }
+      if (equal) {
+        unique_index = candidate;
+        break;
+      }
+    }
+    if (unique_index < 0) {
+      unique_index = unique_rows->size();
+      unique_rows->push_back(row);
+      candidates.push_back(unique_index);
+    }
+    row_to_unique->push_back(unique_index);
+  }
+  return OkStatus();
+}
+
+Status GatherRows(const Tensor& tensor, absl::Span<const int64_t> rows,
+                  Tensor* result) {
+  if (tensor.dims() == 0) {
+    return errors::InvalidArgument("Cannot gather rows of a scalar tensor");
+  }
+  const int64_t num_rows = tensor.dim_size(0);
+  for (const int64_t row : rows) {
+    if (row < 0 || row >= num_rows) {
+      return errors::InvalidArgument("Row index ", row,
+                                     " is out of range for a tensor with ",
+                                     num_rows, " rows");
+    }
+  }
+  TensorShape shape = tensor.shape();
+  shape.set_dim(0, rows.size());
+  if (DataTypeCanUseMemcpy(tensor.dtype())) {
+    *result = Tensor(tensor.dtype(), shape);
+    const int64_t num_bytes =
+        num_rows == 0 ? 0 : tensor.tensor_data().size() / num_rows;
+    const char* src = tensor.tensor_data().data();
+    char* dst = const_cast<char*>(result->tensor_data().data());
+    for (int64_t i = 0; i < rows.size(); ++i) {
+      std::memcpy(dst + i * num_bytes, src + rows[i] * num_bytes, num_bytes);
+    }
+    return OkStatus();
+  }
+  if (rows.empty()) {
+    *result = Tensor(tensor.dtype(), shape);
+    return OkStatus();
+  }
+  // Other types (e.g. DT_STRING) are copied element by element.
+  std::vector<Tensor> slices;
+  slices.reserve(rows.size());
+  for (const int64_t row : rows) {
+    slices.push_back(tensor.Slice(row, row + 1));
+  }
+  return tensor::Concat(slices, result);
+}
+
+int64_t MaxNonBatchDimSize(const Tensor& tensor) {
+  int64_t max_dim_size = 0;
+  for (int d = 1; d < tensor.dims(); ++d) {
+    max_dim_size = std::max(max_dim_size, tensor.dim_size(d));
+  }
+  return max_dim_size;
+}
+
+int64_t MaxNonBatchDimSize(
+    const std::vector<std::pair<string, Tensor>>& inputs) {
+  int64_t max_dim_size = 1;
+  for (const auto& entry : inputs) {
+    max_dim_size = std::max(max_dim_size, MaxNonBatchDimSize(entry.second));
+  }
+  return max_dim_size;
+}
+
 }  // namespace serving
 }  // namespace tensorflow
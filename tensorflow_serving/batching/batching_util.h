@@ -24,6 +24,7 @@ limitations under the License.
 #include "absl/types/span.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow_serving/batching/batch_tensor_pool.h"
 
 namespace tensorflow {
 namespace serving {
@@ -43,6 +44,11 @@ namespace serving {
 std::map<string, std::vector<int>> CalculateMaxDimSizes(
     const std::vector<std::vector<std::pair<string, Tensor>>>& batch);
 
+// Same as above, but takes pointers to the task inputs so that callers need not
+// copy them into a temporary vector.
+std::map<string, std::vector<int>> CalculateMaxDimSizes(
+    absl::Span<const std::vector<std::pair<string, Tensor>>* const> batch);
+
 // Pads tensor so that its shape becomes as specified in max_dim_sizes,
 // except for zeroth dimension, which is left as is.
 // First entry in max_dim_sizes is ignored.
@@ -64,6 +70,27 @@ std::map<string, std::vector<int>> CalculateMaxDimSizes(
 Status AddPadding(const Tensor& tensor, absl::Span<const int> max_dim_sizes,
                   Tensor* padded_tensor);
 
+// Same as above, but if 'pool' is non-null the padded tensor is allocated from
+// it, so that padded buffers are recycled across batches.
+Status AddPadding(const Tensor& tensor, absl::Span<const int> max_dim_sizes,
+                  BatchTensorPool* pool, Tensor* padded_tensor);
+
+// Concatenates 'tensors' along their 0th dimension, each padded like
+// AddPadding() to 'max_dim_sizes', followed by 'num_padding_rows' copies of the
+// first row of the last of them, into 'result', which is allocated from 'pool'
+// if it is non-null.
+//
+// Same as AddPadding() on each tensor and then tensor::Concat(), but writes
+// each element once, straight into the merged tensor, with copy and fill loops
+// compiled for the size of the elements. Returns false, leaving 'result'
+// untouched, for the tensors it does not apply to: those of types that cannot
+// be copied with memcpy() or whose elements are not 1, 2, 4 or 8 bytes, empty
+// or misaligned tensors, and those AddPadding() and tensor::Concat() reject,
+// which callers merge in those two steps instead.
+bool PadAndConcat(absl::Span<const Tensor> tensors,
+                  absl::Span<const int> max_dim_sizes, int num_padding_rows,
+                  BatchTensorPool* pool, Tensor* result);
+
 // Returns the smallest entry in `allowed_batch_sizes` that is greater than or
 // equal to `batch_size`. If `allowed_batch_sizes` is empty, simply returns
 // `batch_size`.
@@ -76,6 +103,51 @@ int RoundToLowestAllowedBatchSize(absl::Span<const int> allowed_batch_sizes,
 bool AreShapesEqualExceptZeroDim(const TensorShape& shape1,
                                  const TensorShape& shape2);
 
+// Splits 'tensor' along its 0th dimension into pieces with the given 0th
+// dimension 'sizes', which must sum to the 0th dimension size of 'tensor'.
+//
+// Unlike tensor::Split(), pieces whose data is suitably aligned alias the
+// buffer of 'tensor' (see Tensor::Slice()) instead of being copied; only
+// misaligned pieces are deep-copied, so that every resulting tensor can be
+// accessed with the aligned Tensor accessors.
+Status SplitTensorWithAliasing(const Tensor& tensor,
+                               absl::Span<const int64_t> sizes,
+                               std::vector<Tensor>* result);
+
+// Returns true iff the rows of tensors of type 'dtype' can be compared by
+// FindUniqueRows(), i.e. 'dtype' is a plain-old-data type or DT_STRING.
+bool IsRowDeduplicationSupported(DataType dtype);
+
+// Finds the distinct rows among the rows (0th-dimension entries) of 'tensors',
+// which must all have the same 0th dimension size. Row i and row j are equal
+// iff they are equal in every tensor, i.e. the tensors are treated as the
+// columns of a single batch.
+//
+// On return, 'unique_rows' holds the index of the first occurrence of each
+// distinct row, in increasing order, and 'row_to_unique' maps each row to the
+// position of its distinct row in 'unique_rows'. For example, for a single
+// tensor with rows [a, b, a, c, b] the result is unique_rows = [0, 1, 3] and
+// row_to_unique = [0, 1, 0, 2, 1].
+Status FindUniqueRows(absl::Span<const Tensor> tensors,
+                      std::vector<int64_t>* unique_rows,
+                      std::vector<int64_t>* row_to_unique);
+
+// Sets 'result' to a tensor whose i-th row is row 'rows[i]' of 'tensor',
+// which must have at least one dimension. Rows may be repeated.
+Status GatherRows(const Tensor& tensor, absl::Span<const int64_t> rows,
+                  Tensor* result);
+
+// Returns the largest size of any non-zeroth dimension of 'tensor', or 0 if it
+// has at most one dimension.
+int64_t MaxNonBatchDimSize(const Tensor& tensor);
+
+// Returns the largest size of any non-zeroth dimension among 'inputs', or 1 if
+// none of them has more than one dimension. For sequence inputs this is the
+// padded sequence length, so it can serve as 'row_cost_func' (see
+// batching_options.h) to weigh batches by their number of tokens.
+int64_t MaxNonBatchDimSize(
+    const std::vector<std::pair<string, Tensor>>& inputs);
+
 // Returns the first dimension size (batching dimension) of each tensor in
 // `inputs`. If their first dimension sizes don't match, returns an error.
 template <typename TensorList, typename DimFunc, typename DimSizeFunc>
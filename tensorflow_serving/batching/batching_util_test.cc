@@ -24,7 +24,10 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -89,6 +92,49 @@ TEST(BatchingUtilTest, AddPadding) {
   }
 }
 
+TEST(BatchingUtilTest, AddPaddingRank2) {
+  // The first element (1) is used as the padding value.
+  const Tensor tensor = test::AsTensor<float>({1, 2, 3, 4}, {2, 2});
+  Tensor padded_tensor;
+  TF_ASSERT_OK(AddPadding(tensor, {2, 3}, &padded_tensor));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 1, 3, 4, 1}, {2, 3}), padded_tensor);
+}
+
+TEST(BatchingUtilTest, AddPaddingRank3) {
+  const Tensor tensor = test::AsTensor<int32>({0, 1, 2, 3}, {1, 2, 2});
+  Tensor padded_tensor;
+  TF_ASSERT_OK(AddPadding(tensor, {1, 3, 3}, &padded_tensor));
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>({0, 1, 0, 2, 3, 0, 0, 0, 0}, {1, 3, 3}),
+      padded_tensor);
+}
+
+TEST(BatchingUtilTest, AddPaddingRank4) {
+  const Tensor tensor = test::AsTensor<float>({5, 6}, {1, 1, 1, 2});
+  Tensor padded_tensor;
+  TF_ASSERT_OK(AddPadding(tensor, {1, 2, 1, 2}, &padded_tensor));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({5, 6, 5, 5}, {1, 2, 1, 2}), padded_tensor);
+}
+
+TEST(BatchingUtilTest, AddPaddingWithPool) {
+  BatchTensorPool pool(/*max_tensors_per_key=*/1);
+  const Tensor tensor = test::AsTensor<float>({1, 2, 3, 4}, {2, 2});
+  Tensor padded_tensor;
+  TF_ASSERT_OK(AddPadding(tensor, {2, 3}, &pool, &padded_tensor));
+  const void* data = padded_tensor.tensor_data().data();
+  padded_tensor = Tensor();
+
+  // The recycled buffer still holds the previous contents; they must be fully
+  // overwritten.
+  TF_ASSERT_OK(AddPadding(test::AsTensor<float>({0, 5, 6, 7}, {2, 2}), {2, 3},
+                          &pool, &padded_tensor));
+  EXPECT_EQ(data, padded_tensor.tensor_data().data());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, 5, 0, 6, 7, 0}, {2, 3}), padded_tensor);
+}
+
 TEST(BatchingUtilTest, AddPaddingTensorWithUnsupportedRank) {
   const std::vector<int> max_dim_sizes{1, 1, 1, 1, 1, 1, 1};
   const Tensor tensor(DT_FLOAT, {1, 1, 1, 1, 1, 1, 1});
@@ -97,6 +143,154 @@ TEST(BatchingUtilTest, AddPaddingTensorWithUnsupportedRank) {
                 "Only tensors with rank from 1 to 6 can be padded."),
             AddPadding(tensor, max_dim_sizes, &padded_tensor));
 }
+
+// Returns the result of padding 'tensors' one by one and concatenating them,
+// as PadAndConcat() does in one pass.
+Tensor PadThenConcat(const std::vector<Tensor>& tensors,
+                     absl::Span<const int> max_dim_sizes,
+                     int num_padding_rows) {
+  std::vector<Tensor> padded_tensors;
+  for (const Tensor& tensor : tensors) {
+    padded_tensors.emplace_back();
+    TF_CHECK_OK(AddPadding(tensor, max_dim_sizes, &padded_tensors.back()));
+  }
+  const Tensor padding_row = padded_tensors.back().Slice(0, 1);
+  for (int i = 0; i < num_padding_rows; ++i) {
+    padded_tensors.push_back(padding_row);
+  }
+  Tensor result;
+  TF_CHECK_OK(tensor::Concat(padded_tensors, &result));
+  return result;
+}
+
+TEST(BatchingUtilTest, PadAndConcat) {
+  const std::vector<Tensor> rank1 = {test::AsTensor<int8>({1, 2}, {2}),
+                                     test::AsTensor<int8>({3}, {1})};
+  Tensor merged;
+  ASSERT_TRUE(PadAndConcat(rank1, {0}, 2, /*pool=*/nullptr, &merged));
+  test::ExpectTensorEqual<int8>(test::AsTensor<int8>({1, 2, 3, 3, 3}, {5}),
+                                merged);
+
+  // The innermost dimension needs no padding, the middle one does.
+  const std::vector<Tensor> rank3 = {
+      test::AsTensor<float>({1, 2, 3, 4}, {1, 2, 2}),
+      test::AsTensor<float>({5, 6, 7, 8, 9, 10}, {1, 3, 2})};
+  ASSERT_TRUE(PadAndConcat(rank3, {0, 3, 2}, 1, nullptr, &merged));
+  test::ExpectTensorEqual<float>(PadThenConcat(rank3, {0, 3, 2}, 1), merged);
+
+  const std::vector<Tensor> rank4 = {
+      test::AsTensor<int64_t>({1, 2, 3, 4, 5, 6}, {1, 2, 3, 1}),
+      test::AsTensor<int64_t>({7, 8, 9, 10}, {2, 1, 2, 1})};
+  ASSERT_TRUE(PadAndConcat(rank4, {0, 2, 3, 1}, 0, nullptr, &merged));
+  test::ExpectTensorEqual<int64_t>(PadThenConcat(rank4, {0, 2, 3, 1}, 0),
+                                   merged);
+
+  // A recycled buffer is fully overwritten.
+  BatchTensorPool pool(/*max_tensors_per_key=*/1);
+  const std::vector<Tensor> halves = {
+      test::AsTensor<Eigen::half>({Eigen::half(1)}, {1, 1}),
+      test::AsTensor<Eigen::half>({Eigen::half(2), Eigen::half(3)}, {1, 2})};
+  ASSERT_TRUE(PadAndConcat(halves, {0, 2}, 1, &pool, &merged));
+  const void* data = merged.tensor_data().data();
+  merged = Tensor();
+  ASSERT_TRUE(PadAndConcat(halves, {0, 2}, 1, &pool, &merged));
+  EXPECT_EQ(data, merged.tensor_data().data());
+  test::ExpectTensorEqual<Eigen::half>(PadThenConcat(halves, {0, 2}, 1),
+                                       merged);
+}
+
+TEST(BatchingUtilTest, PadAndConcatLeavesOtherTensorsToTwoSteps) {
+  Tensor merged;
+  EXPECT_FALSE(
+      PadAndConcat({test::AsTensor<tstring>({"a", "b"}, {2})}, {0}, 0,
+                   /*pool=*/nullptr, &merged));
+  EXPECT_FALSE(PadAndConcat(
+      {test::AsTensor<complex128>({complex128(1, 2)}, {1})}, {0}, 0, nullptr,
+      &merged));
+  EXPECT_FALSE(PadAndConcat({Tensor(DT_FLOAT, {0, 2})}, {0, 2}, 0, nullptr,
+                            &merged));
+  // The ranks must match.
+  EXPECT_FALSE(PadAndConcat({test::AsTensor<float>({1, 2}, {2})}, {0, 2}, 0,
+                            nullptr, &merged));
+}
+
+TEST(BatchingUtilTest, SplitTensorWithAliasing) {
+  const Tensor tensor =
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6, 7, 8}, {4, 2});
+  std::vector<Tensor> split;
+  TF_ASSERT_OK(SplitTensorWithAliasing(tensor, {1, 3}, &split));
+  ASSERT_EQ(2, split.size());
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2}, {1, 2}),
+                                 split[0]);
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({3, 4, 5, 6, 7, 8}, {3, 2}), split[1]);
+  // The first piece starts at the beginning of the buffer, so it is always
+  // aligned and must share the buffer.
+  EXPECT_EQ(tensor.tensor_data().data(), split[0].tensor_data().data());
+  for (const Tensor& piece : split) {
+    EXPECT_TRUE(piece.IsAligned());
+  }
+}
+
+TEST(BatchingUtilTest, SplitTensorWithAliasingRejectsBadSizes) {
+  const Tensor tensor = test::AsTensor<float>({1, 2, 3, 4}, {4});
+  std::vector<Tensor> split;
+  EXPECT_FALSE(SplitTensorWithAliasing(tensor, {1, 2}, &split).ok());
+}
+
+TEST(BatchingUtilTest, FindUniqueRows) {
+  // Rows 0 and 2 are equal in both tensors; rows 1 and 3 only in the first.
+  const Tensor floats =
+      test::AsTensor<float>({1, 2, 3, 4, 1, 2, 3, 4}, {4, 2});
+  const Tensor strings = test::AsTensor<tstring>({"a", "b", "a", "c"}, {4});
+  std::vector<int64_t> unique_rows;
+  std::vector<int64_t> row_to_unique;
+  TF_ASSERT_OK(
+      FindUniqueRows({floats, strings}, &unique_rows, &row_to_unique));
+  EXPECT_THAT(unique_rows, ElementsAre(0, 1, 3));
+  EXPECT_THAT(row_to_unique, ElementsAre(0, 1, 0, 2));
+
+  TF_ASSERT_OK(FindUniqueRows({floats}, &unique_rows, &row_to_unique));
+  EXPECT_THAT(unique_rows, ElementsAre(0, 1));
+  EXPECT_THAT(row_to_unique, ElementsAre(0, 1, 0, 1));
+}
+
+TEST(BatchingUtilTest, FindUniqueRowsRejectsMismatchedSizes) {
+  const Tensor floats = test::AsTensor<float>({1, 2, 3, 4}, {4});
+  const Tensor ints = test::AsTensor<int32>({1, 2}, {2});
+  std::vector<int64_t> unique_rows;
+  std::vector<int64_t> row_to_unique;
+  EXPECT_FALSE(
+      FindUniqueRows({floats, ints}, &unique_rows, &row_to_unique).ok());
+}
+
+TEST(BatchingUtilTest, GatherRows) {
+  const Tensor floats = test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {3, 2});
+  Tensor gathered;
+  TF_ASSERT_OK(GatherRows(floats, {2, 0, 2}, &gathered));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({5, 6, 1, 2, 5, 6}, {3, 2}), gathered);
+
+  const Tensor strings = test::AsTensor<tstring>({"a", "b", "c"}, {3});
+  TF_ASSERT_OK(GatherRows(strings, {1, 1}, &gathered));
+  test::ExpectTensorEqual<tstring>(test::AsTensor<tstring>({"b", "b"}, {2}),
+                                   gathered);
+
+  EXPECT_FALSE(GatherRows(floats, {3}, &gathered).ok());
+}
+
+TEST(BatchingUtilTest, MaxNonBatchDimSize) {
+  EXPECT_EQ(1, MaxNonBatchDimSize({{"x", test::AsTensor<float>({1, 2})}}));
+  EXPECT_EQ(5, MaxNonBatchDimSize(
+                   {{"x", Tensor(DT_FLOAT, {2, 3})},
+                    {"y", Tensor(DT_INT32, {2, 5, 4})}}));
+}
+
+TEST(BatchingUtilTest, MaxNonBatchDimSizeOfTensor) {
+  EXPECT_EQ(0, MaxNonBatchDimSize(test::AsTensor<float>({1, 2})));
+  EXPECT_EQ(5, MaxNonBatchDimSize(Tensor(DT_INT32, {2, 5, 4})));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -0,0 +1,226 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_BUCKETIZED_BATCH_SCHEDULER_H_
+#define TENSORFLOW_SERVING_BATCHING_BUCKETIZED_BATCH_SCHEDULER_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A BatchScheduler that routes each task to one of several underlying
+// schedulers ("buckets") based on a per-task key, so that every batch is formed
+// from tasks with similar keys.
+//
+// The typical use is bucketizing variable-length inputs by their sequence
+// length: with padding, a batch is padded to its longest task, so mixing short
+// and long tasks in the same batch wastes compute on padding.
+//
+// A task with key k is routed to the first bucket whose boundary is >= k. Tasks
+// whose key exceeds the last boundary go to an extra, final bucket. Hence there
+// are 'bucket_boundaries.size() + 1' buckets.
+template <typename TaskType>
+class BucketizedBatchScheduler : public BatchScheduler<TaskType> {
+ public:
+  struct Options {
+    // The inclusive upper bounds of the bucket keys, in strictly increasing
+    // order. Must be non-empty.
+    std::vector<int64_t> bucket_boundaries;
+
+    // Computes the bucketing key of a task.
+    std::function<int64_t(const TaskType&)> bucket_key_func;
+  };
+
+  // Creates a bucket scheduler, e.g. a queue of a SharedBatchScheduler.
+  using BucketSchedulerCreator =
+      std::function<Status(std::unique_ptr<BatchScheduler<TaskType>>*)>;
+
+  // Creates a BucketizedBatchScheduler, invoking 'bucket_scheduler_creator'
+  // once per bucket.
+  static Status Create(
+      const Options& options,
+      const BucketSchedulerCreator& bucket_scheduler_creator,
+      std::unique_ptr<BucketizedBatchScheduler<TaskType>>* result);
+
+  ~BucketizedBatchScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<TaskType>* task) override;
+
+  // Returns the total over all buckets.
+  size_t NumEnqueuedTasks() const override;
+
+  // Returns the total over all buckets. Whether a particular task fits depends
+  // on the bucket it is routed to.
+  size_t SchedulingCapacity() const override;
+
+  // Returns the smallest maximum task size over all buckets.
+  size_t max_task_size() const override;
+
+  // Returns the index of the bucket that tasks with the given key are routed
+  // to.
+  int BucketIndex(int64_t key) const;
+
+  int num_buckets() const { return buckets_.size(); }
+
+ private:
+  explicit BucketizedBatchScheduler(const Options& options);
+
+  const Options options_;
+  std::vector<std::unique_ptr<BatchScheduler<TaskType>>> buckets_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(BucketizedBatchScheduler);
+};
+
+// Creates a batch scheduler whose batches are handed to
+// 'process_batch_callback', e.g. BatchingSessionSchedulerCreator.
+template <typename TaskType>
+using BatchSchedulerCreator = std::function<Status(
+    std::function<void(std::unique_ptr<Batch<TaskType>>)>
+        process_batch_callback,
+    std::unique_ptr<BatchScheduler<TaskType>>* batch_scheduler)>;
+
+// Wraps 'scheduler_creator' such that the created scheduler bucketizes tasks by
+// 'bucket_key_func' over per-bucket schedulers created by 'scheduler_creator',
+// all sharing the same 'process_batch_callback'. If 'bucket_boundaries' is
+// empty, returns 'scheduler_creator' as-is.
+template <typename TaskType>
+BatchSchedulerCreator<TaskType> MaybeBucketizeSchedulerCreator(
+    const std::vector<int64_t>& bucket_boundaries,
+    std::function<int64_t(const TaskType&)> bucket_key_func,
+    BatchSchedulerCreator<TaskType> scheduler_creator);
+
+//////////
+// Implementation details follow. API users need not read.
+
+template <typename TaskType>
+Status BucketizedBatchScheduler<TaskType>::Create(
+    const Options& options,
+    const BucketSchedulerCreator& bucket_scheduler_creator,
+    std::unique_ptr<BucketizedBatchScheduler<TaskType>>* result) {
+  if (options.bucket_boundaries.empty()) {
+    return errors::InvalidArgument("bucket_boundaries must be non-empty");
+  }
+  for (int i = 1; i < options.bucket_boundaries.size(); ++i) {
+    if (options.bucket_boundaries[i] <= options.bucket_boundaries[i - 1]) {
+      return errors::InvalidArgument(
+          "bucket_boundaries entries must be strictly increasing");
+    }
+  }
+  if (options.bucket_key_func == nullptr) {
+    return errors::InvalidArgument("bucket_key_func must be set");
+  }
+
+  std::unique_ptr<BucketizedBatchScheduler<TaskType>> scheduler(
+      new BucketizedBatchScheduler<TaskType>(options));
+  const int num_buckets = options.bucket_boundaries.size() + 1;
+  scheduler->buckets_.reserve(num_buckets);
+  for (int i = 0; i < num_buckets; ++i) {
+    std::unique_ptr<BatchScheduler<TaskType>> bucket;
+    TF_RETURN_IF_ERROR(bucket_scheduler_creator(&bucket));
+    scheduler->buckets_.push_back(std::move(bucket));
+  }
+  *result = std::move(scheduler);
+  return OkStatus();
+}
+
+template <typename TaskType>
+BatchSchedulerCreator<TaskType> MaybeBucketizeSchedulerCreator(
+    const std::vector<int64_t>& bucket_boundaries,
+    std::function<int64_t(const TaskType&)> bucket_key_func,
+    BatchSchedulerCreator<TaskType> scheduler_creator) {
+  if (bucket_boundaries.empty()) {
+    return scheduler_creator;
+  }
+  typename BucketizedBatchScheduler<TaskType>::Options options;
+  options.bucket_boundaries = bucket_boundaries;
+  options.bucket_key_func = std::move(bucket_key_func);
+  return [options, scheduler_creator](
+             std::function<void(std::unique_ptr<Batch<TaskType>>)>
+                 process_batch_callback,
+             std::unique_ptr<BatchScheduler<TaskType>>* batch_scheduler) {
+    std::unique_ptr<BucketizedBatchScheduler<TaskType>> bucketized_scheduler;
+    TF_RETURN_IF_ERROR(BucketizedBatchScheduler<TaskType>::Create(
+        options,
+        [&](std::unique_ptr<BatchScheduler<TaskType>>* bucket) {
+          return scheduler_creator(process_batch_callback, bucket);
+        },
+        &bucketized_scheduler));
+    *batch_scheduler = std::move(bucketized_scheduler);
+    return OkStatus();
+  };
+}
+
+template <typename TaskType>
+Status BucketizedBatchScheduler<TaskType>::Schedule(
+    std::unique_ptr<TaskType>* task) {
+  const int64_t key = options_.bucket_key_func(**task);
+  return buckets_[BucketIndex(key)]->Schedule(task);
+}
+
+template <typename TaskType>
+size_t BucketizedBatchScheduler<TaskType>::NumEnqueuedTasks() const {
+  size_t num_enqueued_tasks = 0;
+  for (const auto& bucket : buckets_) {
+    num_enqueued_tasks += bucket->NumEnqueuedTasks();
+  }
+  return num_enqueued_tasks;
+}
+
+template <typename TaskType>
+size_t BucketizedBatchScheduler<TaskType>::SchedulingCapacity() const {
+  size_t scheduling_capacity = 0;
+  for (const auto& bucket : buckets_) {
+    scheduling_capacity += bucket->SchedulingCapacity();
+  }
+  return scheduling_capacity;
+}
+
+template <typename TaskType>
+size_t BucketizedBatchScheduler<TaskType>::max_task_size() const {
+  size_t max_task_size = buckets_[0]->max_task_size();
+  for (const auto& bucket : buckets_) {
+    max_task_size = std::min(max_task_size, bucket->max_task_size());
+  }
+  return max_task_size;
+}
+
+template <typename TaskType>
+int BucketizedBatchScheduler<TaskType>::BucketIndex(int64_t key) const {
+  return std::lower_bound(options_.bucket_boundaries.begin(),
+                          options_.bucket_boundaries.end(), key) -
+         options_.bucket_boundaries.begin();
+}
+
+template <typename TaskType>
+BucketizedBatchScheduler<TaskType>::BucketizedBatchScheduler(
+    const Options& options)
+    : options_(options) {}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_BUCKETIZED_BATCH_SCHEDULER_H_
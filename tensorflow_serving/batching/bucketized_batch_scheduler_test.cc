@@ -0,0 +1,146 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/bucketized_batch_scheduler.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class FakeTask : public BatchTask {
+ public:
+  explicit FakeTask(int64_t length) : length_(length) {}
+  ~FakeTask() override = default;
+
+  size_t size() const override { return 1; }
+
+  int64_t length() const { return length_; }
+
+ private:
+  const int64_t length_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
+};
+
+// A batch scheduler that records the tasks it is given.
+class RecordingScheduler : public BatchScheduler<FakeTask> {
+ public:
+  explicit RecordingScheduler(size_t max_task_size)
+      : max_task_size_(max_task_size) {}
+  ~RecordingScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<FakeTask>* task) override {
+    lengths_.push_back((*task)->length());
+    task->reset();
+    return OkStatus();
+  }
+
+  size_t NumEnqueuedTasks() const override { return lengths_.size(); }
+
+  size_t SchedulingCapacity() const override { return 10; }
+
+  size_t max_task_size() const override { return max_task_size_; }
+
+  const std::vector<int64_t>& lengths() const { return lengths_; }
+
+ private:
+  const size_t max_task_size_;
+  std::vector<int64_t> lengths_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordingScheduler);
+};
+
+BucketizedBatchScheduler<FakeTask>::Options CreateOptions(
+    std::vector<int64_t> bucket_boundaries) {
+  BucketizedBatchScheduler<FakeTask>::Options options;
+  options.bucket_boundaries = std::move(bucket_boundaries);
+  options.bucket_key_func = [](const FakeTask& task) { return task.length(); };
+  return options;
+}
+
+TEST(BucketizedBatchSchedulerTest, RoutesTasksByKey) {
+  std::vector<RecordingScheduler*> buckets;
+  std::unique_ptr<BucketizedBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(BucketizedBatchScheduler<FakeTask>::Create(
+      CreateOptions({16, 64}),
+      [&buckets](std::unique_ptr<BatchScheduler<FakeTask>>* bucket) {
+        auto recording_scheduler = std::make_unique<RecordingScheduler>(
+            /*max_task_size=*/100 - buckets.size());
+        buckets.push_back(recording_scheduler.get());
+        *bucket = std::move(recording_scheduler);
+        return OkStatus();
+      },
+      &scheduler));
+  ASSERT_EQ(3, buckets.size());
+  EXPECT_EQ(3, scheduler->num_buckets());
+
+  for (const int64_t length : {1, 16, 17, 64, 65, 1000}) {
+    auto task = std::make_unique<FakeTask>(length);
+    TF_ASSERT_OK(scheduler->Schedule(&task));
+    EXPECT_EQ(nullptr, task);
+  }
+  EXPECT_EQ(std::vector<int64_t>({1, 16}), buckets[0]->lengths());
+  EXPECT_EQ(std::vector<int64_t>({17, 64}), buckets[1]->lengths());
+  EXPECT_EQ(std::vector<int64_t>({65, 1000}), buckets[2]->lengths());
+
+  EXPECT_EQ(6, scheduler->NumEnqueuedTasks());
+  EXPECT_EQ(30, scheduler->SchedulingCapacity());
+  EXPECT_EQ(98, scheduler->max_task_size());
+}
+
+TEST(BucketizedBatchSchedulerTest, RejectsInvalidOptions) {
+  auto creator = [](std::unique_ptr<BatchScheduler<FakeTask>>* bucket) {
+    *bucket = std::make_unique<RecordingScheduler>(/*max_task_size=*/1);
+    return OkStatus();
+  };
+  std::unique_ptr<BucketizedBatchScheduler<FakeTask>> scheduler;
+  EXPECT_FALSE(BucketizedBatchScheduler<FakeTask>::Create(CreateOptions({}),
+                                                          creator, &scheduler)
+                   .ok());
+  EXPECT_FALSE(BucketizedBatchScheduler<FakeTask>::Create(
+                   CreateOptions({64, 16}), creator, &scheduler)
+                   .ok());
+  BucketizedBatchScheduler<FakeTask>::Options options = CreateOptions({16});
+  options.bucket_key_func = nullptr;
+  EXPECT_FALSE(
+      BucketizedBatchScheduler<FakeTask>::Create(options, creator, &scheduler)
+          .ok());
+}
+
+TEST(BucketizedBatchSchedulerTest, PropagatesCreatorError) {
+  std::unique_ptr<BucketizedBatchScheduler<FakeTask>> scheduler;
+  const Status status = BucketizedBatchScheduler<FakeTask>::Create(
+      CreateOptions({16}),
+      [](std::unique_ptr<BatchScheduler<FakeTask>>* bucket) {
+        return errors::Internal("no queue for you");
+      },
+      &scheduler);
+  EXPECT_EQ(error::INTERNAL, status.code());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
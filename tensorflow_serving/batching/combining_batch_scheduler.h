@@ -0,0 +1,245 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_COMBINING_BATCH_SCHEDULER_H_
+#define TENSORFLOW_SERVING_BATCHING_COMBINING_BATCH_SCHEDULER_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A BatchScheduler that funnels concurrent Schedule() calls into a wrapped
+// scheduler one at a time, so that the wrapped scheduler's queue mutex is not
+// contended by the request threads ("flat combining").
+//
+// Schedule() publishes its task in a bounded multi-producer ring buffer, which
+// reserves a slot with a single atomic operation and takes no lock. One of the
+// waiting callers then takes on the role of the combiner and forwards the
+// published tasks, in order, to the wrapped scheduler, while the others wait
+// (spinning on a flag of their own) for the outcome of their task. Each caller
+// gets the status of the wrapped Schedule() for its own task, and keeps the
+// task if it failed, so the semantics of the wrapped scheduler, including its
+// batch timeouts and task splitting, are unchanged. If the ring buffer is full,
+// Schedule() calls the wrapped scheduler directly.
+//
+// This pays off when many threads schedule small tasks at a high rate: the
+// wrapped scheduler's mutex then stays in the combiner's cache instead of
+// bouncing between cores, and the request threads do not sleep on it.
+template <typename TaskType>
+class CombiningBatchScheduler : public BatchScheduler<TaskType> {
+ public:
+  struct Options {
+    // The number of Schedule() calls that can wait for the combiner at once.
+    // Rounded up to a power of two.
+    size_t ring_capacity = 1024;
+
+    // The maximum number of tasks a combiner forwards before it gives up the
+    // role, which bounds the extra latency of the thread acting as combiner.
+    int max_tasks_per_combining_pass = 64;
+  };
+
+  static Status Create(
+      const Options& options, std::unique_ptr<BatchScheduler<TaskType>> wrapped,
+      std::unique_ptr<CombiningBatchScheduler<TaskType>>* result);
+
+  ~CombiningBatchScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<TaskType>* task) override;
+
+  size_t NumEnqueuedTasks() const override {
+    return wrapped_->NumEnqueuedTasks();
+  }
+
+  size_t SchedulingCapacity() const override {
+    return wrapped_->SchedulingCapacity();
+  }
+
+  size_t max_task_size() const override { return wrapped_->max_task_size(); }
+
+ private:
+  // A pending Schedule() call. Lives on the caller's stack.
+  struct Request {
+    std::unique_ptr<TaskType>* task;
+    Status status;
+    std::atomic<bool> done{false};
+  };
+
+  // A slot of the ring buffer. Its sequence number tells whether the slot is
+  // free for the enqueue position 'sequence' or holds the request published at
+  // position 'sequence - 1' (see Dmitry Vyukov's bounded MPMC queue).
+  struct alignas(64) Cell {
+    std::atomic<uint64_t> sequence;
+    Request* request;
+  };
+
+  CombiningBatchScheduler(const Options& options,
+                          std::unique_ptr<BatchScheduler<TaskType>> wrapped);
+
+  // Publishes 'request' in the ring buffer. Returns false if it is full.
+  bool TryEnqueue(Request* request);
+
+  // Removes the oldest published request from the ring buffer, or returns
+  // nullptr if there is none. Only called by the combiner.
+  Request* TryDequeue();
+
+  // Forwards up to 'max_tasks_per_combining_pass' published requests to the
+  // wrapped scheduler. Only called by the combiner.
+  void Combine();
+
+  const Options options_;
+  std::unique_ptr<BatchScheduler<TaskType>> wrapped_;
+
+  const uint64_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+
+  // Whether some caller is acting as the combiner. Guards 'dequeue_pos_'.
+  alignas(64) std::atomic<bool> combining_{false};
+  uint64_t dequeue_pos_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CombiningBatchScheduler);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+template <typename TaskType>
+Status CombiningBatchScheduler<TaskType>::Create(
+    const Options& options, std::unique_ptr<BatchScheduler<TaskType>> wrapped,
+    std::unique_ptr<CombiningBatchScheduler<TaskType>>* result) {
+  if (options.ring_capacity == 0) {
+    return errors::InvalidArgument("ring_capacity must be positive");
+  }
+  if (options.max_tasks_per_combining_pass <= 0) {
+    return errors::InvalidArgument(
+        "max_tasks_per_combining_pass must be positive; was ",
+        options.max_tasks_per_combining_pass);
+  }
+  if (wrapped == nullptr) {
+    return errors::InvalidArgument("The wrapped scheduler must be set");
+  }
+  result->reset(new CombiningBatchScheduler<TaskType>(options,
+                                                      std::move(wrapped)));
+  return OkStatus();
+}
+
+template <typename TaskType>
+Status CombiningBatchScheduler<TaskType>::Schedule(
+    std::unique_ptr<TaskType>* task) {
+  Request request;
+  request.task = task;
+  if (!TryEnqueue(&request)) {
+    return wrapped_->Schedule(task);
+  }
+  constexpr int kNumSpinsBeforeYield = 64;
+  int num_spins = 0;
+  while (!request.done.load(std::memory_order_acquire)) {
+    if (!combining_.load(std::memory_order_relaxed) &&
+        !combining_.exchange(true, std::memory_order_acquire)) {
+      Combine();
+      combining_.store(false, std::memory_order_release);
+    } else if (++num_spins > kNumSpinsBeforeYield) {
+      std::this_thread::yield();
+    }
+  }
+  return request.status;
+}
+
+template <typename TaskType>
+CombiningBatchScheduler<TaskType>::CombiningBatchScheduler(
+    const Options& options, std::unique_ptr<BatchScheduler<TaskType>> wrapped)
+    : options_(options),
+      wrapped_(std::move(wrapped)),
+      mask_([&options] {
+        uint64_t capacity = 1;
+        while (capacity < options.ring_capacity) {
+          capacity *= 2;
+        }
+        return capacity - 1;
+      }()),
+      cells_(new Cell[mask_ + 1]) {
+  for (uint64_t i = 0; i <= mask_; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename TaskType>
+bool CombiningBatchScheduler<TaskType>::TryEnqueue(Request* request) {
+  uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell* cell = &cells_[pos & mask_];
+    const uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const int64_t diff =
+        static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed)) {
+        cell->request = request;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The slot still holds the request from one lap ago.
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename TaskType>
+typename CombiningBatchScheduler<TaskType>::Request*
+CombiningBatchScheduler<TaskType>::TryDequeue() {
+  Cell* cell = &cells_[dequeue_pos_ & mask_];
+  if (cell->sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+    // Empty, or the slot is reserved but its request not yet published; its
+    // caller will forward it when it gets to be the combiner.
+    return nullptr;
+  }
+  Request* request = cell->request;
+  cell->sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+  ++dequeue_pos_;
+  return request;
+}
+
+template <typename TaskType>
+void CombiningBatchScheduler<TaskType>::Combine() {
+  for (int i = 0; i < options_.max_tasks_per_combining_pass; ++i) {
+    Request* request = TryDequeue();
+    if (request == nullptr) {
+      return;
+    }
+    request->status = wrapped_->Schedule(request->task);
+    // The request may be destroyed as soon as it is marked done.
+    request->done.store(true, std::memory_order_release);
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_COMBINING_BATCH_SCHEDULER_H_
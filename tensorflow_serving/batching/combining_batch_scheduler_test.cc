@@ -0,0 +1,175 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/combining_batch_scheduler.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class FakeTask : public BatchTask {
+ public:
+  FakeTask(int id, size_t size) : id_(id), size_(size) {}
+  ~FakeTask() override = default;
+
+  size_t size() const override { return size_; }
+
+  int id() const { return id_; }
+
+ private:
+  const int id_;
+  const size_t size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
+};
+
+// A batch scheduler that records the ids of the tasks it accepts and rejects
+// tasks larger than 'max_task_size'.
+class RecordingScheduler : public BatchScheduler<FakeTask> {
+ public:
+  explicit RecordingScheduler(size_t max_task_size)
+      : max_task_size_(max_task_size) {}
+  ~RecordingScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<FakeTask>* task) override {
+    if ((*task)->size() > max_task_size_) {
+      return errors::InvalidArgument("Task too large");
+    }
+    mutex_lock l(mu_);
+    ids_.push_back((*task)->id());
+    task->reset();
+    return OkStatus();
+  }
+
+  size_t NumEnqueuedTasks() const override {
+    mutex_lock l(mu_);
+    return ids_.size();
+  }
+
+  size_t SchedulingCapacity() const override { return 7; }
+
+  size_t max_task_size() const override { return max_task_size_; }
+
+  std::vector<int> ids() const {
+    mutex_lock l(mu_);
+    return ids_;
+  }
+
+ private:
+  const size_t max_task_size_;
+  mutable mutex mu_;
+  std::vector<int> ids_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordingScheduler);
+};
+
+TEST(CombiningBatchSchedulerTest, ForwardsTasksAndStatus) {
+  auto wrapped = std::make_unique<RecordingScheduler>(/*max_task_size=*/2);
+  RecordingScheduler* recording_scheduler = wrapped.get();
+  std::unique_ptr<CombiningBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(CombiningBatchScheduler<FakeTask>::Create(
+      {}, std::move(wrapped), &scheduler));
+  EXPECT_EQ(2, scheduler->max_task_size());
+  EXPECT_EQ(7, scheduler->SchedulingCapacity());
+
+  auto task = std::make_unique<FakeTask>(1, 2);
+  TF_ASSERT_OK(scheduler->Schedule(&task));
+  EXPECT_EQ(nullptr, task);
+
+  // A rejected task stays with the caller.
+  task = std::make_unique<FakeTask>(2, 3);
+  const Status status = scheduler->Schedule(&task);
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+  ASSERT_NE(nullptr, task);
+  EXPECT_EQ(2, task->id());
+
+  EXPECT_EQ(std::vector<int>({1}), recording_scheduler->ids());
+  EXPECT_EQ(1, scheduler->NumEnqueuedTasks());
+}
+
+TEST(CombiningBatchSchedulerTest, ConcurrentSchedule) {
+  constexpr int kNumThreads = 16;
+  constexpr int kNumTasksPerThread = 500;
+  // A small ring, so that some calls fall back to the direct path.
+  for (const size_t ring_capacity : {size_t{4}, size_t{1024}}) {
+    auto wrapped = std::make_unique<RecordingScheduler>(/*max_task_size=*/1);
+    RecordingScheduler* recording_scheduler = wrapped.get();
+    CombiningBatchScheduler<FakeTask>::Options options;
+    options.ring_capacity = ring_capacity;
+    options.max_tasks_per_combining_pass = 8;
+    std::unique_ptr<CombiningBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(CombiningBatchScheduler<FakeTask>::Create(
+        options, std::move(wrapped), &scheduler));
+    {
+      std::vector<std::unique_ptr<Thread>> threads;
+      for (int t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back(
+            Env::Default()->StartThread({}, "schedule", [&scheduler, t] {
+              for (int i = 0; i < kNumTasksPerThread; ++i) {
+                // Every other task is rejected.
+                const int id = t * kNumTasksPerThread + i;
+                auto task = std::make_unique<FakeTask>(id, 1 + id % 2);
+                const Status status = scheduler->Schedule(&task);
+                EXPECT_EQ(id % 2 == 0, status.ok());
+                EXPECT_EQ(id % 2 == 0, task == nullptr);
+              }
+            }));
+      }
+    }
+    std::vector<int> ids = recording_scheduler->ids();
+    std::sort(ids.begin(), ids.end());
+    std::vector<int> expected_ids;
+    for (int id = 0; id < kNumThreads * kNumTasksPerThread; id += 2) {
+      expected_ids.push_back(id);
+    }
+    EXPECT_EQ(expected_ids, ids);
+  }
+}
+
+TEST(CombiningBatchSchedulerTest, InvalidOptions) {
+  std::unique_ptr<CombiningBatchScheduler<FakeTask>> scheduler;
+  CombiningBatchScheduler<FakeTask>::Options options;
+  options.ring_capacity = 0;
+  EXPECT_FALSE(CombiningBatchScheduler<FakeTask>::Create(
+                   options, std::make_unique<RecordingScheduler>(1),
+                   &scheduler)
+                   .ok());
+  options = {};
+  options.max_tasks_per_combining_pass = 0;
+  EXPECT_FALSE(CombiningBatchScheduler<FakeTask>::Create(
+                   options, std::make_unique<RecordingScheduler>(1),
+                   &scheduler)
+                   .ok());
+  EXPECT_FALSE(
+      CombiningBatchScheduler<FakeTask>::Create({}, nullptr, &scheduler).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,382 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/continuous_batcher.h"
+
+#include <map>
+#include <utility>
+
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
+#include "tensorflow_serving/batching/batching_util.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// Returns OK iff a task with 'inputs' can be merged into a batch whose inputs
+// are 'batch_inputs', i.e. both have the same tensor names and types, and
+// equal shapes except for the 0th dimension.
+Status CheckBatchable(
+    const std::vector<std::pair<string, Tensor>>& batch_inputs,
+    const std::vector<std::pair<string, Tensor>>& inputs) {
+  if (inputs.size() != batch_inputs.size()) {
+    return errors::InvalidArgument(
+        "Task has ", inputs.size(), " inputs, but the running batch has ",
+        batch_inputs.size());
+  }
+  std::map<string, const Tensor*> tensors;
+  for (const auto& entry : inputs) {
+    tensors[entry.first] = &entry.second;
+  }
+  for (const auto& entry : batch_inputs) {
+    auto it = tensors.find(entry.first);
+    if (it == tensors.end()) {
+      return errors::InvalidArgument("Task is missing input '", entry.first,
+                                     "' of the running batch");
+    }
+    if (it->second->dtype() != entry.second.dtype() ||
+        !AreShapesEqualExceptZeroDim(it->second->shape(),
+                                     entry.second.shape())) {
+      return errors::InvalidArgument(
+          "Input '", entry.first, "' of type ",
+          DataTypeString(it->second->dtype()), " and shape ",
+          it->second->shape().DebugString(),
+          " cannot be batched with the running batch, of type ",
+          DataTypeString(entry.second.dtype()), " and shape ",
+          entry.second.shape().DebugString());
+    }
+  }
+  return OkStatus();
+}
+
+// Returns true iff 'rows' is [0, 1, ..., rows.size() - 1].
+bool IsPrefix(const std::vector<int64_t>& rows) {
+  for (int i = 0; i < rows.size(); ++i) {
+    if (rows[i] != i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status ContinuousBatcher::Create(const Options& options, Session* session,
+                                 std::unique_ptr<ContinuousBatcher>* result) {
+  if (options.max_batch_size <= 0) {
+    return errors::InvalidArgument("max_batch_size must be positive; was ",
+                                   options.max_batch_size);
+  }
+  if (!options.allowed_batch_sizes.empty()) {
+    int last_size = 0;
+    for (const int size : options.allowed_batch_sizes) {
+      if (size <= last_size) {
+        return errors::InvalidArgument(
+            "allowed_batch_sizes entries must be positive and monotonically "
+            "increasing");
+      }
+      last_size = size;
+    }
+    if (last_size != options.max_batch_size) {
+      return errors::InvalidArgument(
+          "Last entry in allowed_batch_sizes must match max_batch_size; last "
+          "entry was ",
+          last_size, "; expected ", options.max_batch_size);
+    }
+  }
+  result->reset(new ContinuousBatcher(options, session));
+  return OkStatus();
+}
+
+ContinuousBatcher::ContinuousBatcher(const Options& options, Session* session)
+    : options_(options), session_(session) {
+  for (const auto& state_tensor : options_.state_tensors) {
+    output_tensor_names_.push_back(state_tensor.second);
+  }
+  for (const string& step_output_tensor : options_.step_output_tensors) {
+    output_tensor_names_.push_back(step_output_tensor);
+  }
+  if (!options_.done_tensor.empty()) {
+    output_tensor_names_.push_back(options_.done_tensor);
+  }
+  thread_.reset(options_.env->StartThread({}, options_.thread_name,
+                                          [this] { RunLoop(); }));
+}
+
+ContinuousBatcher::~ContinuousBatcher() {
+  {
+    mutex_lock l(mu_);
+    stopped_ = true;
+  }
+  tasks_added_.notify_all();
+  // Joins the loop thread, which returns once no tasks are left.
+  thread_.reset();
+}
+
+Status ContinuousBatcher::Run(
+    const std::vector<std::pair<string, Tensor>>& inputs, int max_steps,
+    std::vector<Tensor>* outputs) {
+  if (max_steps <= 0) {
+    return errors::InvalidArgument("max_steps must be positive; was ",
+                                   max_steps);
+  }
+  if (inputs.empty()) {
+    return errors::InvalidArgument(
+        "ContinuousBatcher Run() must have at least one input tensor");
+  }
+  for (const auto& entry : inputs) {
+    if (entry.second.dims() == 0 || entry.second.dim_size(0) != 1) {
+      return errors::InvalidArgument(
+          "ContinuousBatcher Run() input tensors must have a 0th dimension of "
+          "size 1; input '",
+          entry.first, "' has shape ", entry.second.shape().DebugString());
+    }
+  }
+  for (const auto& state_tensor : options_.state_tensors) {
+    bool found = false;
+    for (const auto& entry : inputs) {
+      found |= entry.first == state_tensor.first;
+    }
+    if (!found) {
+      return errors::InvalidArgument("Missing initial value of state input '",
+                                     state_tensor.first, "'");
+    }
+  }
+
+  outputs->clear();
+  Task task;
+  task.inputs = &inputs;
+  task.max_steps = max_steps;
+  task.outputs = outputs;
+  task.step_outputs.resize(options_.step_output_tensors.size());
+  {
+    mutex_lock l(mu_);
+    waiting_tasks_.push_back(&task);
+  }
+  tasks_added_.notify_one();
+  task.done.WaitForNotification();
+  return task.status;
+}
+
+int ContinuousBatcher::NumWaitingTasks() const {
+  mutex_lock l(mu_);
+  return waiting_tasks_.size();
+}
+
+void ContinuousBatcher::RunLoop() {
+  std::vector<int64_t> kept_rows;
+  bool batch_changed = false;
+  for (;;) {
+    std::vector<Task*> joining_tasks;
+    {
+      mutex_lock l(mu_);
+      while (waiting_tasks_.empty() && running_tasks_.empty() && !stopped_) {
+        tasks_added_.wait(l);
+      }
+      if (waiting_tasks_.empty() && running_tasks_.empty()) {
+        return;
+      }
+      while (!waiting_tasks_.empty() &&
+             running_tasks_.size() + joining_tasks.size() <
+                 options_.max_batch_size) {
+        joining_tasks.push_back(waiting_tasks_.front());
+        waiting_tasks_.pop_front();
+      }
+    }
+    if (batch_changed || !joining_tasks.empty()) {
+      AssembleBatch(kept_rows, joining_tasks);
+    }
+    if (running_tasks_.empty()) {
+      batch_changed = false;
+      continue;
+    }
+    batch_changed = RunStep(&kept_rows);
+  }
+}
+
+void ContinuousBatcher::AssembleBatch(const std::vector<int64_t>& kept_rows,
+                                      const std::vector<Task*>& joining_tasks) {
+  profiler::TraceMe trace_me("ContinuousBatcher::AssembleBatch");
+  std::vector<Task*> admitted_tasks;
+  const std::vector<std::pair<string, Tensor>>* reference_inputs =
+      running_tasks_.empty() ? nullptr : &batch_inputs_;
+  for (Task* task : joining_tasks) {
+    if (reference_inputs != nullptr) {
+      const Status status = CheckBatchable(*reference_inputs, *task->inputs);
+      if (!status.ok()) {
+        FinishTask(task, status);
+        continue;
+      }
+    } else {
+      reference_inputs = task->inputs;
+    }
+    admitted_tasks.push_back(task);
+  }
+
+  const int64_t num_rows = running_tasks_.size() + admitted_tasks.size();
+  if (num_rows == 0) {
+    batch_inputs_.clear();
+    batch_inputs_rows_ = 0;
+    return;
+  }
+  const int64_t padded_num_rows =
+      RoundToLowestAllowedBatchSize(options_.allowed_batch_sizes, num_rows);
+
+  // For each input tensor name, the pieces to concatenate, in row order.
+  std::map<string, std::vector<Tensor>> pieces;
+  Status status;
+  if (!running_tasks_.empty()) {
+    for (const auto& entry : batch_inputs_) {
+      Tensor kept;
+      if (IsPrefix(kept_rows)) {
+        kept = entry.second.Slice(0, kept_rows.size());
+      } else {
+        status.Update(GatherRows(entry.second, kept_rows, &kept));
+      }
+      pieces[entry.first].push_back(std::move(kept));
+    }
+  }
+  for (Task* task : admitted_tasks) {
+    for (const auto& entry : *task->inputs) {
+      pieces[entry.first].push_back(entry.second);
+    }
+  }
+  std::vector<std::pair<string, Tensor>> batch_inputs;
+  for (auto& entry : pieces) {
+    std::vector<Tensor>& tensors = entry.second;
+    if (padded_num_rows > num_rows) {
+      const Tensor padding = tensors[0].Slice(0, 1);
+      tensors.resize(tensors.size() + padded_num_rows - num_rows, padding);
+    }
+    Tensor merged;
+    if (tensors.size() == 1) {
+      merged = tensors[0];
+    } else {
+      status.Update(tensor::Concat(tensors, &merged));
+    }
+    batch_inputs.push_back({entry.first, std::move(merged)});
+  }
+
+  running_tasks_.insert(running_tasks_.end(), admitted_tasks.begin(),
+                        admitted_tasks.end());
+  if (!status.ok()) {
+    for (Task* task : running_tasks_) {
+      FinishTask(task, status);
+    }
+    running_tasks_.clear();
+    batch_inputs_.clear();
+    batch_inputs_rows_ = 0;
+    return;
+  }
+  batch_inputs_ = std::move(batch_inputs);
+  batch_inputs_rows_ = padded_num_rows;
+}
+
+bool ContinuousBatcher::RunStep(std::vector<int64_t>* kept_rows) {
+  profiler::TraceMe trace_me([this] {
+    return profiler::TraceMeEncode(
+        "ContinuousBatcher::RunStep",
+        {{"batch_size", running_tasks_.size()},
+         {"batch_size_after_padding", batch_inputs_rows_}});
+  });
+  std::vector<Tensor> outputs;
+  Status status = session_->Run(batch_inputs_, output_tensor_names_,
+                                {} /* target node names */, &outputs);
+  if (status.ok() && outputs.size() != output_tensor_names_.size()) {
+    status = errors::Internal("Step function returned ", outputs.size(),
+                              " outputs; expected ",
+                              output_tensor_names_.size());
+  }
+  for (int i = 0; status.ok() && i < outputs.size(); ++i) {
+    if (outputs[i].dims() == 0 ||
+        outputs[i].dim_size(0) != batch_inputs_rows_) {
+      status = errors::FailedPrecondition(
+          "Step function output '", output_tensor_names_[i],
+          "' does not have the batch size of the inputs; shape is ",
+          outputs[i].shape().DebugString(), ", batch size ",
+          batch_inputs_rows_);
+    }
+  }
+  const bool has_done_tensor = !options_.done_tensor.empty();
+  if (status.ok() && has_done_tensor &&
+      (outputs.back().dtype() != DT_BOOL ||
+       outputs.back().NumElements() != batch_inputs_rows_)) {
+    status = errors::FailedPrecondition(
+        "Done output '", options_.done_tensor,
+        "' must be a DT_BOOL tensor with one entry per row");
+  }
+  kept_rows->clear();
+  if (!status.ok()) {
+    for (Task* task : running_tasks_) {
+      FinishTask(task, status);
+    }
+    running_tasks_.clear();
+    batch_inputs_.clear();
+    batch_inputs_rows_ = 0;
+    return true;
+  }
+
+  // Feed the state outputs back as the inputs of the next step.
+  const int num_state_tensors = options_.state_tensors.size();
+  for (int i = 0; i < num_state_tensors; ++i) {
+    for (auto& entry : batch_inputs_) {
+      if (entry.first == options_.state_tensors[i].first) {
+        entry.second = outputs[i];
+      }
+    }
+  }
+
+  std::vector<Task*> remaining_tasks;
+  for (int row = 0; row < running_tasks_.size(); ++row) {
+    Task* task = running_tasks_[row];
+    for (int i = 0; i < task->step_outputs.size(); ++i) {
+      // Copied, so that the task does not retain the whole batch's outputs.
+      task->step_outputs[i].push_back(
+          tensor::DeepCopy(outputs[num_state_tensors + i].Slice(row, row + 1)));
+    }
+    ++task->num_steps;
+    if (task->num_steps >= task->max_steps ||
+        (has_done_tensor && outputs.back().flat<bool>()(row))) {
+      FinishTask(task, OkStatus());
+    } else {
+      remaining_tasks.push_back(task);
+      kept_rows->push_back(row);
+    }
+  }
+  const bool batch_changed = remaining_tasks.size() != running_tasks_.size();
+  running_tasks_ = std::move(remaining_tasks);
+  return batch_changed;
+}
+
+void ContinuousBatcher::FinishTask(Task* task, const Status& status) {
+  task->status = status;
+  for (int i = 0; task->status.ok() && i < task->step_outputs.size(); ++i) {
+    Tensor output;
+    task->status = tensor::Concat(task->step_outputs[i], &output);
+    task->outputs->push_back(std::move(output));
+  }
+  if (!task->status.ok()) {
+    task->outputs->clear();
+  }
+  task->done.Notify();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,177 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_CONTINUOUS_BATCHER_H_
+#define TENSORFLOW_SERVING_BATCHING_CONTINUOUS_BATCHER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Batches the steps of iterative computations, such as autoregressive decoding,
+// at the granularity of a single step ("continuous" or "iteration-level"
+// batching).
+//
+// The wrapped session runs a step function: given the inputs of a batch of
+// tasks, it computes one step for each of them. Some of its outputs are state
+// (e.g. the KV cache of a decoder), which is fed back as the corresponding
+// input of the task's next step; others are per-step results (e.g. the
+// generated token), which are collected for each task across its steps; and an
+// optional boolean output tells, for each task, whether it is finished.
+//
+// Unlike with a BatchScheduler, where a batch is run once and completes as a
+// whole, the running batch here changes between steps: once a task is
+// finished it leaves the batch and its Run() call returns, and waiting tasks
+// join it (up to 'max_batch_size'). So short computations are not held up by
+// long ones, and a free row is reused as soon as it frees up. While the
+// membership of the batch does not change, the state outputs of a step are
+// fed to the next step as they are, without splitting and re-merging them.
+//
+// Each task supplies one row (0th-dimension entry) of every input of the step
+// function, namely its constant inputs and the initial values of its state.
+// Tasks are merged row-wise, like the tasks of a BatchingSession, so their
+// inputs must have equal shapes except for the 0th dimension; for state
+// tensors that grow with the sequence, such as a KV cache, this means that
+// they are allocated at their maximum length up front and that the position
+// of each task is passed as an input.
+//
+// The steps are run by a dedicated thread. This class is thread-safe.
+class ContinuousBatcher {
+ public:
+  struct Options {
+    // The maximum number of tasks in the running batch.
+    int max_batch_size = 32;
+
+    // If non-empty, the running batch is padded, with copies of its first
+    // row, to the smallest of these sizes that fits the tasks. Must be in
+    // increasing order, with the last entry equal to 'max_batch_size'.
+    std::vector<int> allowed_batch_sizes;
+
+    // The state tensors of the step function, as (input tensor name, output
+    // tensor name) pairs: the output of a step is the input of the next step.
+    std::vector<std::pair<string, string>> state_tensors;
+
+    // The per-step outputs of the step function that are returned by Run().
+    std::vector<string> step_output_tensors;
+
+    // If non-empty, a DT_BOOL output of the step function with one entry per
+    // row, which is true for the tasks that are finished after the step.
+    // Otherwise each task runs for the number of steps passed to Run().
+    string done_tensor;
+
+    // The name of the thread that runs the steps.
+    string thread_name = "continuous_batcher";
+
+    // The environment to use for starting the thread.
+    Env* env = Env::Default();
+  };
+
+  // Creates a batcher that runs the step function on 'session', which must
+  // outlive it.
+  static Status Create(const Options& options, Session* session,
+                       std::unique_ptr<ContinuousBatcher>* result);
+
+  // Blocks until all tasks are finished.
+  ~ContinuousBatcher();
+
+  // Runs the task with 'inputs' (see the class comment) for up to 'max_steps'
+  // steps, or until the done output says that it is finished. Sets 'outputs'
+  // to one tensor per entry of 'step_output_tensors', which stacks the
+  // task's per-step outputs along the 0th dimension, i.e. has one entry per
+  // step in place of the batch dimension. Blocks until the task is finished.
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             int max_steps, std::vector<Tensor>* outputs);
+
+  // Returns the number of tasks that are waiting to join the running batch.
+  int NumWaitingTasks() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Task {
+    const std::vector<std::pair<string, Tensor>>* inputs;
+    int max_steps;
+    std::vector<Tensor>* outputs;
+    int num_steps = 0;
+
+    // For each entry of 'step_output_tensors', the outputs of each step.
+    std::vector<std::vector<Tensor>> step_outputs;
+
+    Status status;
+    Notification done;
+  };
+
+  ContinuousBatcher(const Options& options, Session* session);
+
+  // Runs steps until the batcher is destroyed and no tasks are left.
+  void RunLoop() TF_LOCKS_EXCLUDED(mu_);
+
+  // Rebuilds 'batch_inputs_' from its rows 'kept_rows', which belong to the
+  // tasks in 'running_tasks_', and from the inputs of 'joining_tasks', which
+  // are appended to 'running_tasks_'. Fails the joining tasks whose inputs are
+  // not batchable with the rest.
+  void AssembleBatch(const std::vector<int64_t>& kept_rows,
+                     const std::vector<Task*>& joining_tasks);
+
+  // Runs one step of the running batch and finishes the tasks that are done.
+  // Sets 'kept_rows' to the rows of 'batch_inputs_' of the remaining tasks.
+  // Returns true iff any task left the batch.
+  bool RunStep(std::vector<int64_t>* kept_rows);
+
+  // Finishes 'task' with 'status', or with its collected outputs if 'status'
+  // is OK.
+  void FinishTask(Task* task, const Status& status);
+
+  const Options options_;
+  Session* const session_;
+
+  // The output tensors fetched from the step function, in order: the state
+  // outputs, the per-step outputs and the done output, if any.
+  std::vector<string> output_tensor_names_;
+
+  mutable mutex mu_;
+  condition_variable tasks_added_;
+  std::deque<Task*> waiting_tasks_ TF_GUARDED_BY(mu_);
+  bool stopped_ TF_GUARDED_BY(mu_) = false;
+
+  // Only accessed by the loop thread: the tasks in the running batch, in row
+  // order, and the inputs of the batch's next step, which have
+  // 'batch_inputs_rows_' rows (including padding).
+  std::vector<Task*> running_tasks_;
+  std::vector<std::pair<string, Tensor>> batch_inputs_;
+  int64_t batch_inputs_rows_ = 0;
+
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ContinuousBatcher);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_CONTINUOUS_BATCHER_H_
@@ -0,0 +1,213 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/continuous_batcher.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::Contains;
+
+// A step function that adds input "increment" to state "count", returns the
+// new count as per-step output "token", and is done once the count reaches
+// input "limit" (or, for all tasks, once FinishAll() was called).
+class CountingStepSession : public ServingSession {
+ public:
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    std::map<string, Tensor> tensors(inputs.begin(), inputs.end());
+    const auto increment = tensors["increment"].flat<int64_t>();
+    const auto count = tensors["count"].flat<int64_t>();
+    const auto limit = tensors["limit"].flat<int64_t>();
+    const int64_t num_rows = count.size();
+    Tensor new_count(DT_INT64, TensorShape({num_rows}));
+    Tensor done(DT_BOOL, TensorShape({num_rows}));
+    {
+      mutex_lock l(mu_);
+      batch_sizes_.push_back(num_rows);
+      for (int64_t i = 0; i < num_rows; ++i) {
+        new_count.flat<int64_t>()(i) = count(i) + increment(i);
+        done.flat<bool>()(i) =
+            finish_all_ || new_count.flat<int64_t>()(i) >= limit(i);
+      }
+    }
+    for (const string& name : output_tensor_names) {
+      if (name == "new_count" || name == "token") {
+        outputs->push_back(new_count);
+      } else if (name == "done") {
+        outputs->push_back(done);
+      } else {
+        return errors::NotFound("No output ", name);
+      }
+    }
+    return OkStatus();
+  }
+
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return errors::Unimplemented("ListDevices");
+  }
+
+  void FinishAll() {
+    mutex_lock l(mu_);
+    finish_all_ = true;
+  }
+
+  std::vector<int64_t> batch_sizes() {
+    mutex_lock l(mu_);
+    return batch_sizes_;
+  }
+
+ private:
+  mutex mu_;
+  bool finish_all_ TF_GUARDED_BY(mu_) = false;
+  std::vector<int64_t> batch_sizes_ TF_GUARDED_BY(mu_);
+};
+
+ContinuousBatcher::Options CountingOptions() {
+  ContinuousBatcher::Options options;
+  options.max_batch_size = 4;
+  options.state_tensors = {{"count", "new_count"}};
+  options.step_output_tensors = {"token"};
+  options.done_tensor = "done";
+  return options;
+}
+
+std::vector<std::pair<string, Tensor>> CountingInputs(int64_t increment,
+                                                      int64_t limit) {
+  return {{"increment", test::AsTensor<int64_t>({increment}, {1})},
+          {"count", test::AsTensor<int64_t>({0}, {1})},
+          {"limit", test::AsTensor<int64_t>({limit}, {1})}};
+}
+
+TEST(ContinuousBatcherTest, RunsTaskUntilDone) {
+  CountingStepSession session;
+  ContinuousBatcher::Options options = CountingOptions();
+  options.allowed_batch_sizes = {2, 4};
+  std::unique_ptr<ContinuousBatcher> batcher;
+  TF_ASSERT_OK(ContinuousBatcher::Create(options, &session, &batcher));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(batcher->Run(CountingInputs(2, 6), /*max_steps=*/100, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>({2, 4, 6}, {3}),
+                                   outputs[0]);
+  // The lone task is padded to the smallest allowed batch size.
+  EXPECT_EQ(std::vector<int64_t>({2, 2, 2}), session.batch_sizes());
+}
+
+TEST(ContinuousBatcherTest, StopsAfterMaxSteps) {
+  CountingStepSession session;
+  ContinuousBatcher::Options options = CountingOptions();
+  options.done_tensor = "";
+  std::unique_ptr<ContinuousBatcher> batcher;
+  TF_ASSERT_OK(ContinuousBatcher::Create(options, &session, &batcher));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(batcher->Run(CountingInputs(1, 1), /*max_steps=*/4, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>({1, 2, 3, 4}, {4}),
+                                   outputs[0]);
+}
+
+TEST(ContinuousBatcherTest, TasksJoinAndLeaveRunningBatch) {
+  CountingStepSession session;
+  std::unique_ptr<ContinuousBatcher> batcher;
+  TF_ASSERT_OK(
+      ContinuousBatcher::Create(CountingOptions(), &session, &batcher));
+
+  // A task that runs until FinishAll() is called.
+  Notification long_task_done;
+  std::vector<Tensor> long_outputs;
+  std::unique_ptr<Thread> long_task(
+      Env::Default()->StartThread({}, "long_task", [&] {
+        TF_ASSERT_OK(batcher->Run(CountingInputs(1, 1 << 30),
+                                  /*max_steps=*/1 << 30, &long_outputs));
+        long_task_done.Notify();
+      }));
+  while (session.batch_sizes().empty()) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+
+  // A short task joins the running batch and finishes while the long task is
+  // still running.
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(batcher->Run(CountingInputs(3, 9), /*max_steps=*/100, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>({3, 6, 9}, {3}),
+                                   outputs[0]);
+  EXPECT_FALSE(long_task_done.HasBeenNotified());
+  EXPECT_THAT(session.batch_sizes(), Contains(2));
+
+  // An unbatchable task fails without affecting the running batch.
+  std::vector<std::pair<string, Tensor>> unbatchable_inputs =
+      CountingInputs(1, 1);
+  unbatchable_inputs[0].second = test::AsTensor<int64_t>({1, 1}, {1, 2});
+  EXPECT_FALSE(batcher->Run(unbatchable_inputs, 100, &outputs).ok());
+  EXPECT_FALSE(long_task_done.HasBeenNotified());
+
+  session.FinishAll();
+  long_task.reset();
+  ASSERT_EQ(1, long_outputs.size());
+  const auto tokens = long_outputs[0].flat<int64_t>();
+  for (int i = 0; i < tokens.size(); ++i) {
+    EXPECT_EQ(i + 1, tokens(i));
+  }
+}
+
+TEST(ContinuousBatcherTest, RejectsInvalidArguments) {
+  CountingStepSession session;
+  std::unique_ptr<ContinuousBatcher> batcher;
+  ContinuousBatcher::Options options = CountingOptions();
+  options.allowed_batch_sizes = {2, 3};  // Does not end with max_batch_size.
+  EXPECT_FALSE(ContinuousBatcher::Create(options, &session, &batcher).ok());
+
+  TF_ASSERT_OK(
+      ContinuousBatcher::Create(CountingOptions(), &session, &batcher));
+  std::vector<Tensor> outputs;
+  EXPECT_FALSE(batcher->Run(CountingInputs(1, 1), /*max_steps=*/0, &outputs)
+                   .ok());
+  // More than one row.
+  std::vector<std::pair<string, Tensor>> inputs = CountingInputs(1, 1);
+  inputs[1].second = test::AsTensor<int64_t>({0, 0}, {2});
+  EXPECT_FALSE(batcher->Run(inputs, /*max_steps=*/1, &outputs).ok());
+  // Missing the initial state.
+  inputs = CountingInputs(1, 1);
+  inputs.erase(inputs.begin() + 1);
+  EXPECT_FALSE(batcher->Run(inputs, /*max_steps=*/1, &outputs).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
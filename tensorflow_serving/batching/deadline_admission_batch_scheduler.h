@@ -0,0 +1,187 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_DEADLINE_ADMISSION_BATCH_SCHEDULER_H_
+#define TENSORFLOW_SERVING_BATCHING_DEADLINE_ADMISSION_BATCH_SCHEDULER_H_
+
+#include <stddef.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow_serving/batching/queueing_delay_estimator.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A BatchScheduler that rejects tasks that are not expected to complete before
+// their deadline, instead of letting them wait in an overloaded queue only to
+// time out there.
+//
+// Each task's completion time is estimated by a QueueingDelayEstimator from the
+// work queued ahead of it in the underlying scheduler and from the recent batch
+// processing times. If the estimate ends past the task's deadline, Schedule()
+// fails with RESOURCE_EXHAUSTED, which (unlike the UNAVAILABLE of a full queue)
+// BatchSchedulerRetrier does not retry. Under a load spike the queue thus stays
+// short enough for the admitted tasks to meet their deadlines.
+template <typename TaskType>
+class DeadlineAdmissionBatchScheduler : public BatchScheduler<TaskType> {
+ public:
+  using ProcessBatchCallback =
+      std::function<void(std::unique_ptr<Batch<TaskType>>)>;
+
+  // Creates the underlying scheduler, which invokes 'process_batch_callback' on
+  // its batches.
+  using SchedulerCreator =
+      std::function<Status(ProcessBatchCallback process_batch_callback,
+                           std::unique_ptr<BatchScheduler<TaskType>>*)>;
+
+  struct Options {
+    QueueingDelayEstimator::Options estimator_options;
+
+    // Returns the time, in microseconds as per 'env', by which 'task' must
+    // complete, or 0 if it has no deadline. Tasks without a deadline are
+    // always admitted.
+    std::function<uint64_t(const TaskType& task)> deadline_micros_func;
+
+    // The environment to use for obtaining the current time.
+    Env* env = Env::Default();
+  };
+
+  static Status Create(
+      const Options& options, ProcessBatchCallback process_batch_callback,
+      const SchedulerCreator& scheduler_creator,
+      std::unique_ptr<DeadlineAdmissionBatchScheduler<TaskType>>* result);
+
+  ~DeadlineAdmissionBatchScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<TaskType>* task) override;
+
+  size_t NumEnqueuedTasks() const override {
+    return wrapped_->NumEnqueuedTasks();
+  }
+
+  size_t SchedulingCapacity() const override {
+    return wrapped_->SchedulingCapacity();
+  }
+
+  size_t max_task_size() const override { return wrapped_->max_task_size(); }
+
+  const QueueingDelayEstimator& estimator() const { return *estimator_; }
+
+ private:
+  explicit DeadlineAdmissionBatchScheduler(const Options& options)
+      : options_(options) {}
+
+  const Options options_;
+
+  // Shared with the process-batch callback of the underlying scheduler.
+  std::shared_ptr<QueueingDelayEstimator> estimator_;
+
+  std::unique_ptr<BatchScheduler<TaskType>> wrapped_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DeadlineAdmissionBatchScheduler);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+namespace internal {
+
+inline monitoring::Counter<0>* DeadlineAdmissionRejectedTasks() {
+  static monitoring::Counter<0>* counter = monitoring::Counter<0>::New(
+      "/tensorflow/serving/batching/deadline_admission_rejected_tasks",
+      "Tracks the number of tasks rejected at enqueue time because they were "
+      "not expected to complete before their deadline.");
+  return counter;
+}
+
+}  // namespace internal
+
+template <typename TaskType>
+Status DeadlineAdmissionBatchScheduler<TaskType>::Create(
+    const Options& options, ProcessBatchCallback process_batch_callback,
+    const SchedulerCreator& scheduler_creator,
+    std::unique_ptr<DeadlineAdmissionBatchScheduler<TaskType>>* result) {
+  if (!options.deadline_micros_func) {
+    return errors::InvalidArgument("deadline_micros_func must be set");
+  }
+  if (options.env == nullptr) {
+    return errors::InvalidArgument("env must be set");
+  }
+  std::unique_ptr<QueueingDelayEstimator> estimator;
+  TF_RETURN_IF_ERROR(
+      QueueingDelayEstimator::Create(options.estimator_options, &estimator));
+
+  std::unique_ptr<DeadlineAdmissionBatchScheduler<TaskType>> scheduler(
+      new DeadlineAdmissionBatchScheduler<TaskType>(options));
+  scheduler->estimator_ = std::move(estimator);
+  std::shared_ptr<QueueingDelayEstimator> shared_estimator =
+      scheduler->estimator_;
+  Env* env = options.env;
+  TF_RETURN_IF_ERROR(scheduler_creator(
+      [shared_estimator, env,
+       process_batch_callback](std::unique_ptr<Batch<TaskType>> batch) {
+        shared_estimator->RecordDequeued(batch->size());
+        const uint64_t start_time_micros = env->NowMicros();
+        process_batch_callback(std::move(batch));
+        shared_estimator->RecordBatchProcessingTime(env->NowMicros() -
+                                                    start_time_micros);
+      },
+      &scheduler->wrapped_));
+  if (scheduler->wrapped_ == nullptr) {
+    return errors::Internal("Failed to create the underlying batch scheduler");
+  }
+  *result = std::move(scheduler);
+  return OkStatus();
+}
+
+template <typename TaskType>
+Status DeadlineAdmissionBatchScheduler<TaskType>::Schedule(
+    std::unique_ptr<TaskType>* task) {
+  const int64_t size = (*task)->size();
+  const uint64_t deadline_micros = options_.deadline_micros_func(**task);
+  if (deadline_micros > 0) {
+    const int64_t estimated_micros =
+        estimator_->EstimateCompletionMicros(size);
+    if (options_.env->NowMicros() + estimated_micros > deadline_micros) {
+      internal::DeadlineAdmissionRejectedTasks()->GetCell()->IncrementBy(1);
+      return errors::ResourceExhausted(
+          "The batch queue is too long for the task to complete within its "
+          "deadline; estimated queueing and processing time is ",
+          estimated_micros, " microseconds");
+    }
+  }
+  // Count the task before scheduling it, since a batch holding it may start
+  // processing before Schedule() returns.
+  estimator_->RecordEnqueued(size);
+  const Status status = wrapped_->Schedule(task);
+  if (!status.ok()) {
+    estimator_->RecordDequeued(size);
+  }
+  return status;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_DEADLINE_ADMISSION_BATCH_SCHEDULER_H_
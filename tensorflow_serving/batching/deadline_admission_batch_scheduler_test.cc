@@ -0,0 +1,152 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/deadline_admission_batch_scheduler.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class FakeTask : public BatchTask {
+ public:
+  explicit FakeTask(uint64_t deadline_micros)
+      : deadline_micros_(deadline_micros) {}
+  ~FakeTask() override = default;
+
+  size_t size() const override { return 1; }
+
+  uint64_t deadline_micros() const { return deadline_micros_; }
+
+ private:
+  const uint64_t deadline_micros_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
+};
+
+// A batch scheduler that holds on to the tasks it is given.
+class HoldingScheduler : public BatchScheduler<FakeTask> {
+ public:
+  HoldingScheduler() = default;
+  ~HoldingScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<FakeTask>* task) override {
+    tasks_.push_back(std::move(*task));
+    return OkStatus();
+  }
+
+  size_t NumEnqueuedTasks() const override { return tasks_.size(); }
+
+  size_t SchedulingCapacity() const override { return 100; }
+
+  size_t max_task_size() const override { return 4; }
+
+  // Returns a batch of the first 'num_tasks' held tasks.
+  std::unique_ptr<Batch<FakeTask>> TakeBatch(int num_tasks) {
+    auto batch = std::make_unique<Batch<FakeTask>>();
+    for (int i = 0; i < num_tasks; ++i) {
+      batch->AddTask(std::move(tasks_[i]));
+    }
+    tasks_.erase(tasks_.begin(), tasks_.begin() + num_tasks);
+    batch->Close();
+    return batch;
+  }
+
+ private:
+  std::vector<std::unique_ptr<FakeTask>> tasks_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(HoldingScheduler);
+};
+
+TEST(DeadlineAdmissionBatchSchedulerTest, RejectsTasksThatWouldMissDeadline) {
+  test_util::FakeClockEnv env(Env::Default());
+  DeadlineAdmissionBatchScheduler<FakeTask>::Options options;
+  options.estimator_options.max_batch_size = 4;
+  options.deadline_micros_func = [](const FakeTask& task) {
+    return task.deadline_micros();
+  };
+  options.env = &env;
+
+  HoldingScheduler* queue = nullptr;
+  DeadlineAdmissionBatchScheduler<FakeTask>::ProcessBatchCallback
+      queue_callback;
+  std::unique_ptr<DeadlineAdmissionBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(DeadlineAdmissionBatchScheduler<FakeTask>::Create(
+      options,
+      [&env](std::unique_ptr<Batch<FakeTask>> batch) {
+        env.AdvanceByMicroseconds(1000);
+      },
+      [&](DeadlineAdmissionBatchScheduler<FakeTask>::ProcessBatchCallback
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<FakeTask>>* wrapped) {
+        queue_callback = process_batch_callback;
+        auto holding_scheduler = std::make_unique<HoldingScheduler>();
+        queue = holding_scheduler.get();
+        *wrapped = std::move(holding_scheduler);
+        return OkStatus();
+      },
+      &scheduler));
+
+  // Until a batch has been processed, all tasks are admitted.
+  for (int i = 0; i < 8; ++i) {
+    auto task = std::make_unique<FakeTask>(/*deadline_micros=*/1);
+    TF_ASSERT_OK(scheduler->Schedule(&task));
+  }
+  queue_callback(queue->TakeBatch(4));
+  EXPECT_EQ(4, scheduler->estimator().queued_size());
+
+  // Four tasks fill the batch ahead, so a new task completes after two more
+  // batches, i.e. 2000us from now.
+  const uint64_t now_micros = env.NowMicros();
+  auto task = std::make_unique<FakeTask>(now_micros + 1500);
+  const Status status = scheduler->Schedule(&task);
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED, status.code());
+  EXPECT_NE(nullptr, task);
+  task = std::make_unique<FakeTask>(now_micros + 2000);
+  TF_ASSERT_OK(scheduler->Schedule(&task));
+  // A task without a deadline is always admitted.
+  task = std::make_unique<FakeTask>(/*deadline_micros=*/0);
+  TF_ASSERT_OK(scheduler->Schedule(&task));
+  EXPECT_EQ(6, scheduler->NumEnqueuedTasks());
+}
+
+TEST(DeadlineAdmissionBatchSchedulerTest, RejectsInvalidOptions) {
+  DeadlineAdmissionBatchScheduler<FakeTask>::Options options;
+  options.estimator_options.max_batch_size = 4;
+  std::unique_ptr<DeadlineAdmissionBatchScheduler<FakeTask>> scheduler;
+  EXPECT_FALSE(DeadlineAdmissionBatchScheduler<FakeTask>::Create(
+                   options, [](std::unique_ptr<Batch<FakeTask>> batch) {},
+                   [](DeadlineAdmissionBatchScheduler<
+                          FakeTask>::ProcessBatchCallback,
+                      std::unique_ptr<BatchScheduler<FakeTask>>* wrapped) {
+                     *wrapped = std::make_unique<HoldingScheduler>();
+                     return OkStatus();
+                   },
+                   &scheduler)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
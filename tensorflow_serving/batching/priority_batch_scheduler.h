@@ -0,0 +1,153 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_PRIORITY_BATCH_SCHEDULER_H_
+#define TENSORFLOW_SERVING_BATCHING_PRIORITY_BATCH_SCHEDULER_H_
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A BatchScheduler with two lanes, each backed by its own underlying scheduler
+// (e.g. two queues of a SharedBatchScheduler): one for high-priority (latency
+// critical) tasks and one for low-priority (e.g. offline backfill) tasks. Each
+// batch contains tasks of one lane only.
+//
+// Low-priority tasks only use capacity that high-priority tasks leave over:
+// while the high-priority lane has more than
+// 'max_enqueued_high_priority_tasks' tasks waiting, low-priority tasks are
+// turned away with an UNAVAILABLE error. That error is retriable, so layering a
+// BatchSchedulerRetrier on top defers low-priority tasks until the
+// high-priority backlog drains.
+template <typename TaskType>
+class PriorityBatchScheduler : public BatchScheduler<TaskType> {
+ public:
+  struct Options {
+    // Returns true if the task belongs in the low-priority lane.
+    std::function<bool(const TaskType&)> is_low_priority_func;
+
+    // The high-priority backlog (in tasks) above which low-priority tasks are
+    // turned away. The default of 0 admits low-priority tasks only while no
+    // high-priority task is waiting.
+    size_t max_enqueued_high_priority_tasks = 0;
+  };
+
+  static Status Create(
+      const Options& options,
+      std::unique_ptr<BatchScheduler<TaskType>> high_priority_scheduler,
+      std::unique_ptr<BatchScheduler<TaskType>> low_priority_scheduler,
+      std::unique_ptr<PriorityBatchScheduler<TaskType>>* result);
+
+  ~PriorityBatchScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<TaskType>* task) override;
+
+  // Returns the total over both lanes.
+  size_t NumEnqueuedTasks() const override;
+
+  // Returns the capacity of the high-priority lane, i.e. the capacity available
+  // to latency-critical tasks.
+  size_t SchedulingCapacity() const override;
+
+  size_t max_task_size() const override;
+
+ private:
+  PriorityBatchScheduler(
+      const Options& options,
+      std::unique_ptr<BatchScheduler<TaskType>> high_priority_scheduler,
+      std::unique_ptr<BatchScheduler<TaskType>> low_priority_scheduler);
+
+  const Options options_;
+  std::unique_ptr<BatchScheduler<TaskType>> high_priority_scheduler_;
+  std::unique_ptr<BatchScheduler<TaskType>> low_priority_scheduler_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PriorityBatchScheduler);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+template <typename TaskType>
+Status PriorityBatchScheduler<TaskType>::Create(
+    const Options& options,
+    std::unique_ptr<BatchScheduler<TaskType>> high_priority_scheduler,
+    std::unique_ptr<BatchScheduler<TaskType>> low_priority_scheduler,
+    std::unique_ptr<PriorityBatchScheduler<TaskType>>* result) {
+  if (options.is_low_priority_func == nullptr) {
+    return errors::InvalidArgument("is_low_priority_func must be set");
+  }
+  if (high_priority_scheduler == nullptr || low_priority_scheduler == nullptr) {
+    return errors::InvalidArgument("Both lane schedulers must be set");
+  }
+  result->reset(new PriorityBatchScheduler<TaskType>(
+      options, std::move(high_priority_scheduler),
+      std::move(low_priority_scheduler)));
+  return OkStatus();
+}
+
+template <typename TaskType>
+Status PriorityBatchScheduler<TaskType>::Schedule(
+    std::unique_ptr<TaskType>* task) {
+  if (!options_.is_low_priority_func(**task)) {
+    return high_priority_scheduler_->Schedule(task);
+  }
+  if (high_priority_scheduler_->NumEnqueuedTasks() >
+      options_.max_enqueued_high_priority_tasks) {
+    return errors::Unavailable(
+        "Low-priority task deferred while high-priority tasks are queued");
+  }
+  return low_priority_scheduler_->Schedule(task);
+}
+
+template <typename TaskType>
+size_t PriorityBatchScheduler<TaskType>::NumEnqueuedTasks() const {
+  return high_priority_scheduler_->NumEnqueuedTasks() +
+         low_priority_scheduler_->NumEnqueuedTasks();
+}
+
+template <typename TaskType>
+size_t PriorityBatchScheduler<TaskType>::SchedulingCapacity() const {
+  return high_priority_scheduler_->SchedulingCapacity();
+}
+
+template <typename TaskType>
+size_t PriorityBatchScheduler<TaskType>::max_task_size() const {
+  return std::min(high_priority_scheduler_->max_task_size(),
+                  low_priority_scheduler_->max_task_size());
+}
+
+template <typename TaskType>
+PriorityBatchScheduler<TaskType>::PriorityBatchScheduler(
+    const Options& options,
+    std::unique_ptr<BatchScheduler<TaskType>> high_priority_scheduler,
+    std::unique_ptr<BatchScheduler<TaskType>> low_priority_scheduler)
+    : options_(options),
+      high_priority_scheduler_(std::move(high_priority_scheduler)),
+      low_priority_scheduler_(std::move(low_priority_scheduler)) {}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_PRIORITY_BATCH_SCHEDULER_H_
@@ -0,0 +1,167 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/priority_batch_scheduler.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class FakeTask : public BatchTask {
+ public:
+  FakeTask(int id, bool low_priority) : id_(id), low_priority_(low_priority) {}
+  ~FakeTask() override = default;
+
+  size_t size() const override { return 1; }
+
+  int id() const { return id_; }
+
+  bool low_priority() const { return low_priority_; }
+
+ private:
+  const int id_;
+  const bool low_priority_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
+};
+
+// A batch scheduler that records the tasks it is given and holds on to them
+// until Clear() is called.
+class RecordingScheduler : public BatchScheduler<FakeTask> {
+ public:
+  RecordingScheduler(size_t scheduling_capacity, size_t max_task_size)
+      : scheduling_capacity_(scheduling_capacity),
+        max_task_size_(max_task_size) {}
+  ~RecordingScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<FakeTask>* task) override {
+    ids_.push_back((*task)->id());
+    ++num_enqueued_tasks_;
+    task->reset();
+    return OkStatus();
+  }
+
+  size_t NumEnqueuedTasks() const override { return num_enqueued_tasks_; }
+
+  size_t SchedulingCapacity() const override { return scheduling_capacity_; }
+
+  size_t max_task_size() const override { return max_task_size_; }
+
+  // Simulates the enqueued tasks being processed.
+  void Clear() { num_enqueued_tasks_ = 0; }
+
+  const std::vector<int>& ids() const { return ids_; }
+
+ private:
+  const size_t scheduling_capacity_;
+  const size_t max_task_size_;
+  size_t num_enqueued_tasks_ = 0;
+  std::vector<int> ids_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RecordingScheduler);
+};
+
+PriorityBatchScheduler<FakeTask>::Options CreateOptions(
+    size_t max_enqueued_high_priority_tasks) {
+  PriorityBatchScheduler<FakeTask>::Options options;
+  options.is_low_priority_func = [](const FakeTask& task) {
+    return task.low_priority();
+  };
+  options.max_enqueued_high_priority_tasks = max_enqueued_high_priority_tasks;
+  return options;
+}
+
+TEST(PriorityBatchSchedulerTest, RoutesTasksByPriority) {
+  auto high = std::make_unique<RecordingScheduler>(/*scheduling_capacity=*/7,
+                                                   /*max_task_size=*/10);
+  auto low = std::make_unique<RecordingScheduler>(/*scheduling_capacity=*/3,
+                                                  /*max_task_size=*/5);
+  RecordingScheduler* high_ptr = high.get();
+  RecordingScheduler* low_ptr = low.get();
+  std::unique_ptr<PriorityBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(PriorityBatchScheduler<FakeTask>::Create(
+      CreateOptions(/*max_enqueued_high_priority_tasks=*/1), std::move(high),
+      std::move(low), &scheduler));
+
+  for (const int id : {0, 1, 2}) {
+    auto task = std::make_unique<FakeTask>(id, /*low_priority=*/id != 1);
+    TF_ASSERT_OK(scheduler->Schedule(&task));
+    EXPECT_EQ(nullptr, task);
+  }
+  EXPECT_EQ(std::vector<int>({1}), high_ptr->ids());
+  EXPECT_EQ(std::vector<int>({0, 2}), low_ptr->ids());
+
+  EXPECT_EQ(3, scheduler->NumEnqueuedTasks());
+  EXPECT_EQ(7, scheduler->SchedulingCapacity());
+  EXPECT_EQ(5, scheduler->max_task_size());
+}
+
+TEST(PriorityBatchSchedulerTest, DefersLowPriorityTasksUnderLoad) {
+  auto high = std::make_unique<RecordingScheduler>(/*scheduling_capacity=*/10,
+                                                   /*max_task_size=*/10);
+  auto low = std::make_unique<RecordingScheduler>(/*scheduling_capacity=*/10,
+                                                  /*max_task_size=*/10);
+  RecordingScheduler* high_ptr = high.get();
+  RecordingScheduler* low_ptr = low.get();
+  std::unique_ptr<PriorityBatchScheduler<FakeTask>> scheduler;
+  TF_ASSERT_OK(PriorityBatchScheduler<FakeTask>::Create(
+      CreateOptions(/*max_enqueued_high_priority_tasks=*/0), std::move(high),
+      std::move(low), &scheduler));
+
+  auto high_task = std::make_unique<FakeTask>(0, /*low_priority=*/false);
+  TF_ASSERT_OK(scheduler->Schedule(&high_task));
+
+  // A high-priority task is waiting, so the low-priority task is turned away
+  // and stays with the caller.
+  auto low_task = std::make_unique<FakeTask>(1, /*low_priority=*/true);
+  const Status status = scheduler->Schedule(&low_task);
+  EXPECT_EQ(error::UNAVAILABLE, status.code());
+  ASSERT_NE(nullptr, low_task);
+  EXPECT_TRUE(low_ptr->ids().empty());
+
+  // Once the high-priority backlog is drained, it is admitted.
+  high_ptr->Clear();
+  TF_ASSERT_OK(scheduler->Schedule(&low_task));
+  EXPECT_EQ(std::vector<int>({1}), low_ptr->ids());
+}
+
+TEST(PriorityBatchSchedulerTest, RejectsInvalidOptions) {
+  std::unique_ptr<PriorityBatchScheduler<FakeTask>> scheduler;
+  PriorityBatchScheduler<FakeTask>::Options options = CreateOptions(0);
+  options.is_low_priority_func = nullptr;
+  EXPECT_FALSE(PriorityBatchScheduler<FakeTask>::Create(
+                   options, std::make_unique<RecordingScheduler>(1, 1),
+                   std::make_unique<RecordingScheduler>(1, 1), &scheduler)
+                   .ok());
+  EXPECT_FALSE(PriorityBatchScheduler<FakeTask>::Create(
+                   CreateOptions(0), std::make_unique<RecordingScheduler>(1, 1),
+                   nullptr, &scheduler)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
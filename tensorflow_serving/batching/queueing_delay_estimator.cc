@@ -0,0 +1,90 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/queueing_delay_estimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+Status QueueingDelayEstimator::Create(
+    const Options& options, std::unique_ptr<QueueingDelayEstimator>* result) {
+  if (options.max_batch_size <= 0) {
+    return errors::InvalidArgument("max_batch_size must be positive; was ",
+                                   options.max_batch_size);
+  }
+  if (options.num_batch_threads <= 0) {
+    return errors::InvalidArgument("num_batch_threads must be positive; was ",
+                                   options.num_batch_threads);
+  }
+  if (options.smoothing_factor <= 0 || options.smoothing_factor > 1) {
+    return errors::InvalidArgument(
+        "smoothing_factor must be in (0, 1]; was ", options.smoothing_factor);
+  }
+  result->reset(new QueueingDelayEstimator(options));
+  return OkStatus();
+}
+
+QueueingDelayEstimator::QueueingDelayEstimator(const Options& options)
+    : options_(options) {}
+
+void QueueingDelayEstimator::RecordEnqueued(int64_t size) {
+  mutex_lock l(mu_);
+  queued_size_ += size;
+}
+
+void QueueingDelayEstimator::RecordDequeued(int64_t size) {
+  mutex_lock l(mu_);
+  queued_size_ = std::max<int64_t>(0, queued_size_ - size);
+}
+
+void QueueingDelayEstimator::RecordBatchProcessingTime(
+    int64_t processing_time_micros) {
+  mutex_lock l(mu_);
+  if (mean_processing_time_micros_ < 0) {
+    mean_processing_time_micros_ = processing_time_micros;
+  } else {
+    mean_processing_time_micros_ +=
+        options_.smoothing_factor *
+        (processing_time_micros - mean_processing_time_micros_);
+  }
+}
+
+int64_t QueueingDelayEstimator::EstimateCompletionMicros(int64_t size) const {
+  mutex_lock l(mu_);
+  if (mean_processing_time_micros_ < 0) {
+    return 0;
+  }
+  const int64_t total_size = queued_size_ + std::max<int64_t>(size, 1);
+  const int64_t num_batches =
+      (total_size + options_.max_batch_size - 1) / options_.max_batch_size;
+  const int64_t num_rounds =
+      (num_batches + options_.num_batch_threads - 1) /
+      options_.num_batch_threads;
+  return static_cast<int64_t>(
+      std::ceil(num_rounds * mean_processing_time_micros_));
+}
+
+int64_t QueueingDelayEstimator::queued_size() const {
+  mutex_lock l(mu_);
+  return queued_size_;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
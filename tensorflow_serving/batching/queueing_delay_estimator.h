@@ -0,0 +1,99 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_QUEUEING_DELAY_ESTIMATOR_H_
+#define TENSORFLOW_SERVING_BATCHING_QUEUEING_DELAY_ESTIMATOR_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Estimates how long a task enqueued on a batch queue takes to complete, i.e.
+// to wait for the batches ahead of it and then be processed in its own batch.
+//
+// The estimator tracks the total size of the tasks waiting in the queue and a
+// moving average of the batch processing times. The waiting tasks, plus the
+// new one, fill ceil(size / 'max_batch_size') batches, which are processed
+// 'num_batch_threads' at a time, so the estimate is
+//
+//   ceil(ceil(size / max_batch_size) / num_batch_threads) * processing time.
+//
+// The estimate ignores the time a batch waits for its timeout, as well as any
+// other queues sharing the same batch threads.
+//
+// This class is thread-safe.
+class QueueingDelayEstimator {
+ public:
+  struct Options {
+    // The maximum size of a batch, in task size units.
+    int64_t max_batch_size = 0;
+
+    // The number of batches processed concurrently, typically the number of
+    // batch threads.
+    int num_batch_threads = 1;
+
+    // The weight of the most recent batch processing time in the moving
+    // average. Must be in (0, 1].
+    double smoothing_factor = 0.2;
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<QueueingDelayEstimator>* result);
+
+  ~QueueingDelayEstimator() = default;
+
+  // Records that a task of size 'size' was enqueued.
+  void RecordEnqueued(int64_t size) TF_LOCKS_EXCLUDED(mu_);
+
+  // Records that tasks of total size 'size' left the queue, e.g. because a
+  // batch holding them started processing or because enqueuing them failed.
+  void RecordDequeued(int64_t size) TF_LOCKS_EXCLUDED(mu_);
+
+  // Records that a batch took 'processing_time_micros' to process.
+  void RecordBatchProcessingTime(int64_t processing_time_micros)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the estimated time until a task of size 'size', if enqueued now,
+  // completes. Returns 0 before the first batch processing time is recorded.
+  int64_t EstimateCompletionMicros(int64_t size) const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the total size of the tasks currently waiting in the queue.
+  int64_t queued_size() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  explicit QueueingDelayEstimator(const Options& options);
+
+  const Options options_;
+
+  mutable mutex mu_;
+  int64_t queued_size_ TF_GUARDED_BY(mu_) = 0;
+  // The moving average of the batch processing times, or -1 if no batch was
+  // processed yet.
+  double mean_processing_time_micros_ TF_GUARDED_BY(mu_) = -1;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(QueueingDelayEstimator);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_QUEUEING_DELAY_ESTIMATOR_H_
@@ -0,0 +1,70 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/queueing_delay_estimator.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(QueueingDelayEstimatorTest, EstimatesFromQueuedSizeAndProcessingTime) {
+  QueueingDelayEstimator::Options options;
+  options.max_batch_size = 4;
+  options.num_batch_threads = 2;
+  options.smoothing_factor = 0.5;
+  std::unique_ptr<QueueingDelayEstimator> estimator;
+  TF_ASSERT_OK(QueueingDelayEstimator::Create(options, &estimator));
+
+  // Nothing is known before the first batch completes.
+  estimator->RecordEnqueued(10);
+  EXPECT_EQ(0, estimator->EstimateCompletionMicros(2));
+
+  estimator->RecordBatchProcessingTime(1000);
+  // 12 units fill 3 batches, which take two rounds on two threads.
+  EXPECT_EQ(2000, estimator->EstimateCompletionMicros(2));
+  // 8 units fill 2 batches, one round.
+  estimator->RecordDequeued(4);
+  EXPECT_EQ(6, estimator->queued_size());
+  EXPECT_EQ(1000, estimator->EstimateCompletionMicros(2));
+
+  // The processing time is a moving average.
+  estimator->RecordBatchProcessingTime(3000);
+  EXPECT_EQ(2000, estimator->EstimateCompletionMicros(2));
+
+  // The queued size does not drop below zero.
+  estimator->RecordDequeued(100);
+  EXPECT_EQ(0, estimator->queued_size());
+}
+
+TEST(QueueingDelayEstimatorTest, RejectsInvalidOptions) {
+  std::unique_ptr<QueueingDelayEstimator> estimator;
+  QueueingDelayEstimator::Options options;
+  EXPECT_FALSE(QueueingDelayEstimator::Create(options, &estimator).ok());
+  options.max_batch_size = 4;
+  options.num_batch_threads = 0;
+  EXPECT_FALSE(QueueingDelayEstimator::Create(options, &estimator).ok());
+  options.num_batch_threads = 1;
+  options.smoothing_factor = 0;
+  EXPECT_FALSE(QueueingDelayEstimator::Create(options, &estimator).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
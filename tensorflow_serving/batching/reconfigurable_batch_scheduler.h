@@ -0,0 +1,215 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_RECONFIGURABLE_BATCH_SCHEDULER_H_
+#define TENSORFLOW_SERVING_BATCHING_RECONFIGURABLE_BATCH_SCHEDULER_H_
+
+#include <stddef.h>
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/util/fast_read_dynamic_ptr.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Makes BatchSchedulers whose underlying queues can be replaced while they
+// serve, e.g. to change the batch timeout or the maximum batch size of a model
+// without reloading it.
+//
+// The underlying queues of all the schedulers made by one instance are made by
+// its current queue creator. Reconfigure() swaps in a new creator, and replaces
+// the queue of each scheduler with one the new creator makes. Tasks scheduled
+// from then on go to the new queues; the old queues still process the tasks
+// they hold (e.g. a SharedBatchScheduler queue closes its open batch) before
+// they are destroyed.
+//
+// This class is thread-safe.
+template <typename TaskType>
+class ReconfigurableBatchQueues
+    : public std::enable_shared_from_this<ReconfigurableBatchQueues<TaskType>> {
+ public:
+  using ProcessBatchCallback =
+      std::function<void(std::unique_ptr<Batch<TaskType>>)>;
+
+  // Creates an underlying queue which invokes 'process_batch_callback' on its
+  // batches.
+  using QueueCreator =
+      std::function<Status(ProcessBatchCallback process_batch_callback,
+                           std::unique_ptr<BatchScheduler<TaskType>>* queue)>;
+
+  static std::shared_ptr<ReconfigurableBatchQueues<TaskType>> Create(
+      QueueCreator queue_creator);
+
+  ~ReconfigurableBatchQueues() = default;
+
+  // Creates a scheduler whose batches are passed to
+  // 'process_batch_callback', with an underlying queue made by the current
+  // creator. The scheduler keeps these queues alive.
+  Status CreateScheduler(ProcessBatchCallback process_batch_callback,
+                         std::unique_ptr<BatchScheduler<TaskType>>* scheduler)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Makes 'queue_creator' the current creator, and replaces the underlying
+  // queues of the live schedulers with queues it makes. Waits for the old
+  // queues to process their tasks. If any new queue cannot be made, returns
+  // the error and leaves the creator and all queues as they were.
+  Status Reconfigure(QueueCreator queue_creator) TF_LOCKS_EXCLUDED(mu_);
+
+  // The number of live schedulers made by CreateScheduler().
+  int num_schedulers() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  class Scheduler;
+
+  explicit ReconfigurableBatchQueues(QueueCreator queue_creator)
+      : queue_creator_(std::move(queue_creator)) {}
+
+  void Unsubscribe(Scheduler* scheduler) TF_LOCKS_EXCLUDED(mu_);
+
+  mutable mutex mu_;
+
+  QueueCreator queue_creator_ TF_GUARDED_BY(mu_);
+
+  std::set<Scheduler*> schedulers_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ReconfigurableBatchQueues);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+template <typename TaskType>
+class ReconfigurableBatchQueues<TaskType>::Scheduler
+    : public BatchScheduler<TaskType> {
+ public:
+  Scheduler(std::shared_ptr<ReconfigurableBatchQueues<TaskType>> queues,
+            ProcessBatchCallback process_batch_callback,
+            std::unique_ptr<BatchScheduler<TaskType>> queue)
+      : queues_(std::move(queues)),
+        process_batch_callback_(std::move(process_batch_callback)),
+        queue_(std::unique_ptr<Queue>(new Queue{std::move(queue)})) {}
+
+  ~Scheduler() override { queues_->Unsubscribe(this); }
+
+  Status Schedule(std::unique_ptr<TaskType>* task) override {
+    return queue_.get()->queue->Schedule(task);
+  }
+
+  size_t NumEnqueuedTasks() const override {
+    return queue_.get()->queue->NumEnqueuedTasks();
+  }
+
+  size_t SchedulingCapacity() const override {
+    return queue_.get()->queue->SchedulingCapacity();
+  }
+
+  size_t max_task_size() const override {
+    return queue_.get()->queue->max_task_size();
+  }
+
+  const ProcessBatchCallback& process_batch_callback() const {
+    return process_batch_callback_;
+  }
+
+  // Makes 'queue' the underlying queue, and destroys the previous one once no
+  // task is being scheduled on it.
+  void ReplaceQueue(std::unique_ptr<BatchScheduler<TaskType>> queue) {
+    queue_.Update(std::unique_ptr<Queue>(new Queue{std::move(queue)})).reset();
+  }
+
+ private:
+  // Holds the queue, so that schedulers can use it through the const pointers
+  // of FastReadDynamicPtr.
+  struct Queue {
+    std::unique_ptr<BatchScheduler<TaskType>> queue;
+  };
+
+  const std::shared_ptr<ReconfigurableBatchQueues<TaskType>> queues_;
+  const ProcessBatchCallback process_batch_callback_;
+  FastReadDynamicPtr<Queue> queue_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Scheduler);
+};
+
+template <typename TaskType>
+std::shared_ptr<ReconfigurableBatchQueues<TaskType>>
+ReconfigurableBatchQueues<TaskType>::Create(QueueCreator queue_creator) {
+  return std::shared_ptr<ReconfigurableBatchQueues<TaskType>>(
+      new ReconfigurableBatchQueues<TaskType>(std::move(queue_creator)));
+}
+
+template <typename TaskType>
+Status ReconfigurableBatchQueues<TaskType>::CreateScheduler(
+    ProcessBatchCallback process_batch_callback,
+    std::unique_ptr<BatchScheduler<TaskType>>* scheduler) {
+  mutex_lock l(mu_);
+  std::unique_ptr<BatchScheduler<TaskType>> queue;
+  TF_RETURN_IF_ERROR(queue_creator_(process_batch_callback, &queue));
+  std::unique_ptr<Scheduler> result(new Scheduler(
+      this->shared_from_this(), std::move(process_batch_callback),
+      std::move(queue)));
+  schedulers_.insert(result.get());
+  *scheduler = std::move(result);
+  return OkStatus();
+}
+
+template <typename TaskType>
+Status ReconfigurableBatchQueues<TaskType>::Reconfigure(
+    QueueCreator queue_creator) {
+  mutex_lock l(mu_);
+  // Make all the new queues before replacing any, so that a failure leaves the
+  // schedulers consistent.
+  std::vector<std::unique_ptr<BatchScheduler<TaskType>>> new_queues;
+  new_queues.reserve(schedulers_.size());
+  for (Scheduler* scheduler : schedulers_) {
+    std::unique_ptr<BatchScheduler<TaskType>> queue;
+    TF_RETURN_IF_ERROR(
+        queue_creator(scheduler->process_batch_callback(), &queue));
+    new_queues.push_back(std::move(queue));
+  }
+  queue_creator_ = std::move(queue_creator);
+  auto new_queue = new_queues.begin();
+  for (Scheduler* scheduler : schedulers_) {
+    scheduler->ReplaceQueue(std::move(*new_queue++));
+  }
+  return OkStatus();
+}
+
+template <typename TaskType>
+int ReconfigurableBatchQueues<TaskType>::num_schedulers() const {
+  mutex_lock l(mu_);
+  return schedulers_.size();
+}
+
+template <typename TaskType>
+void ReconfigurableBatchQueues<TaskType>::Unsubscribe(Scheduler* scheduler) {
+  mutex_lock l(mu_);
+  schedulers_.erase(scheduler);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_RECONFIGURABLE_BATCH_SCHEDULER_H_
@@ -0,0 +1,166 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/reconfigurable_batch_scheduler.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class FakeTask : public BatchTask {
+ public:
+  FakeTask() = default;
+  ~FakeTask() override = default;
+
+  size_t size() const override { return 1; }
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
+};
+
+// A batch scheduler that counts the tasks it is given, and records when it is
+// destroyed.
+class CountingScheduler : public BatchScheduler<FakeTask> {
+ public:
+  CountingScheduler(size_t max_task_size, bool* destroyed)
+      : max_task_size_(max_task_size), destroyed_(destroyed) {}
+  ~CountingScheduler() override { *destroyed_ = true; }
+
+  Status Schedule(std::unique_ptr<FakeTask>* task) override {
+    ++num_tasks_;
+    task->reset();
+    return OkStatus();
+  }
+
+  size_t NumEnqueuedTasks() const override { return num_tasks_; }
+
+  size_t SchedulingCapacity() const override { return 10; }
+
+  size_t max_task_size() const override { return max_task_size_; }
+
+ private:
+  const size_t max_task_size_;
+  bool* const destroyed_;
+  int num_tasks_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CountingScheduler);
+};
+
+using Queues = ReconfigurableBatchQueues<FakeTask>;
+
+// Returns a queue creator of CountingSchedulers with the given max task size,
+// recording in 'destroyed' whether each queue it made has been destroyed.
+Queues::QueueCreator CountingQueueCreator(
+    size_t max_task_size, std::vector<std::unique_ptr<bool>>* destroyed) {
+  return [max_task_size, destroyed](
+             Queues::ProcessBatchCallback process_batch_callback,
+             std::unique_ptr<BatchScheduler<FakeTask>>* queue) {
+    destroyed->push_back(std::make_unique<bool>(false));
+    queue->reset(
+        new CountingScheduler(max_task_size, destroyed->back().get()));
+    return OkStatus();
+  };
+}
+
+TEST(ReconfigurableBatchQueuesTest, ReplacesQueuesOfLiveSchedulers) {
+  std::vector<std::unique_ptr<bool>> destroyed;
+  auto queues = Queues::Create(CountingQueueCreator(4, &destroyed));
+  std::unique_ptr<BatchScheduler<FakeTask>> a, b;
+  TF_ASSERT_OK(queues->CreateScheduler(
+      [](std::unique_ptr<Batch<FakeTask>> batch) {}, &a));
+  TF_ASSERT_OK(queues->CreateScheduler(
+      [](std::unique_ptr<Batch<FakeTask>> batch) {}, &b));
+  EXPECT_EQ(2, queues->num_schedulers());
+  EXPECT_EQ(4, a->max_task_size());
+  auto task = std::make_unique<FakeTask>();
+  TF_ASSERT_OK(a->Schedule(&task));
+  EXPECT_EQ(1, a->NumEnqueuedTasks());
+
+  TF_ASSERT_OK(queues->Reconfigure(CountingQueueCreator(8, &destroyed)));
+  ASSERT_EQ(4, destroyed.size());
+  EXPECT_TRUE(*destroyed[0]);
+  EXPECT_TRUE(*destroyed[1]);
+  EXPECT_FALSE(*destroyed[2]);
+  EXPECT_FALSE(*destroyed[3]);
+  EXPECT_EQ(8, a->max_task_size());
+  EXPECT_EQ(8, b->max_task_size());
+  EXPECT_EQ(0, a->NumEnqueuedTasks());
+  task = std::make_unique<FakeTask>();
+  TF_ASSERT_OK(a->Schedule(&task));
+  EXPECT_EQ(1, a->NumEnqueuedTasks());
+
+  // Schedulers created later use the new creator too.
+  std::unique_ptr<BatchScheduler<FakeTask>> c;
+  TF_ASSERT_OK(queues->CreateScheduler(
+      [](std::unique_ptr<Batch<FakeTask>> batch) {}, &c));
+  EXPECT_EQ(8, c->max_task_size());
+
+  // Destroyed schedulers are no longer reconfigured.
+  b.reset();
+  c.reset();
+  EXPECT_EQ(1, queues->num_schedulers());
+  TF_ASSERT_OK(queues->Reconfigure(CountingQueueCreator(16, &destroyed)));
+  EXPECT_EQ(6, destroyed.size());
+  EXPECT_EQ(16, a->max_task_size());
+}
+
+TEST(ReconfigurableBatchQueuesTest, KeepsQueuesIfCreationFails) {
+  std::vector<std::unique_ptr<bool>> destroyed;
+  auto queues = Queues::Create(CountingQueueCreator(4, &destroyed));
+  std::unique_ptr<BatchScheduler<FakeTask>> a, b;
+  TF_ASSERT_OK(queues->CreateScheduler(
+      [](std::unique_ptr<Batch<FakeTask>> batch) {}, &a));
+  TF_ASSERT_OK(queues->CreateScheduler(
+      [](std::unique_ptr<Batch<FakeTask>> batch) {}, &b));
+
+  // The second queue fails, so neither scheduler changes.
+  Queues::QueueCreator good_creator = CountingQueueCreator(8, &destroyed);
+  int num_created = 0;
+  Queues::QueueCreator failing_creator =
+      [&](Queues::ProcessBatchCallback process_batch_callback,
+          std::unique_ptr<BatchScheduler<FakeTask>>* queue) {
+        if (num_created++ > 0) {
+          return errors::InvalidArgument("Bad queue");
+        }
+        return good_creator(process_batch_callback, queue);
+      };
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            queues->Reconfigure(failing_creator).code());
+  EXPECT_EQ(4, a->max_task_size());
+  EXPECT_EQ(4, b->max_task_size());
+  EXPECT_FALSE(*destroyed[0]);
+  EXPECT_FALSE(*destroyed[1]);
+
+  // Nor do later schedulers.
+  std::unique_ptr<BatchScheduler<FakeTask>> c;
+  TF_ASSERT_OK(queues->CreateScheduler(
+      [](std::unique_ptr<Batch<FakeTask>> batch) {}, &c));
+  EXPECT_EQ(4, c->max_task_size());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,137 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/split_output_assembler.h"
+
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// Returns true iff split outputs of type 'dtype' are copied into place rather
+// than concatenated at the end.
+bool CanCopyRows(DataType dtype) {
+  return DataTypeCanUseMemcpy(dtype) || dtype == DT_STRING;
+}
+
+}  // namespace
+
+SplitOutputAssembler::SplitOutputAssembler(
+    int num_outputs, absl::Span<const int64_t> split_sizes)
+    : split_sizes_(split_sizes.begin(), split_sizes.end()),
+      outputs_(num_outputs) {
+  split_offsets_.reserve(split_sizes.size());
+  for (const int64_t split_size : split_sizes) {
+    split_offsets_.push_back(total_size_);
+    total_size_ += split_size;
+  }
+  for (Output& output : outputs_) {
+    output.pieces.resize(split_sizes.size());
+  }
+}
+
+Status SplitOutputAssembler::AddSplitOutput(int split_index, int output_index,
+                                            const Tensor& tensor) {
+  if (split_index < 0 || split_index >= split_sizes_.size()) {
+    return errors::Internal("Split index ", split_index, " out of range");
+  }
+  if (tensor.dims() == 0 || tensor.dim_size(0) != split_sizes_[split_index]) {
+    return errors::FailedPrecondition(
+        "Output tensor of split ", split_index,
+        " does not match the 0th dimension size of the split's input");
+  }
+
+  Tensor assembled;
+  {
+    mutex_lock l(mu_);
+    if (output_index < 0 || output_index >= outputs_.size()) {
+      return errors::Internal("Output index ", output_index, " out of range");
+    }
+    Output& output = outputs_[output_index];
+    if (!CanCopyRows(tensor.dtype())) {
+      output.pieces[split_index] = tensor;
+      return OkStatus();
+    }
+    if (!output.allocated) {
+      TensorShape shape = tensor.shape();
+      shape.set_dim(0, total_size_);
+      output.tensor = Tensor(tensor.dtype(), shape);
+      output.allocated = true;
+    } else {
+      TensorShape shape = tensor.shape();
+      shape.set_dim(0, total_size_);
+      if (tensor.dtype() != output.tensor.dtype() ||
+          shape != output.tensor.shape()) {
+        return errors::FailedPrecondition(
+            "Output tensors of different splits have incompatible types or "
+            "shapes: ",
+            DataTypeString(tensor.dtype()), tensor.shape().DebugString(),
+            " vs. ", DataTypeString(output.tensor.dtype()),
+            output.tensor.shape().DebugString());
+      }
+    }
+    // Shares the buffer, which splits fill in disjoint ranges of rows, so the
+    // copy below need not hold the lock.
+    assembled = output.tensor;
+  }
+
+  const int64_t start_row = split_offsets_[split_index];
+  if (tensor.dtype() == DT_STRING) {
+    const int64_t num_elements = tensor.NumElements();
+    const int64_t start =
+        tensor.dim_size(0) == 0
+            ? 0
+            : start_row * (num_elements / tensor.dim_size(0));
+    const auto src = tensor.unaligned_flat<tstring>();
+    auto dst = assembled.flat<tstring>();
+    for (int64_t i = 0; i < num_elements; ++i) {
+      dst(start + i) = src(i);
+    }
+  } else {
+    const StringPiece src = tensor.tensor_data();
+    const int64_t row_bytes =
+        tensor.dim_size(0) == 0 ? 0 : src.size() / tensor.dim_size(0);
+    char* dst = const_cast<char*>(assembled.tensor_data().data());
+    std::memcpy(dst + start_row * row_bytes, src.data(), src.size());
+  }
+  return OkStatus();
+}
+
+Status SplitOutputAssembler::Finish(std::vector<Tensor>* outputs) {
+  mutex_lock l(mu_);
+  for (Output& output : outputs_) {
+    if (output.allocated) {
+      outputs->push_back(std::move(output.tensor));
+      continue;
+    }
+    Tensor concated;
+    TF_RETURN_IF_ERROR(tensor::Concat(output.pieces, &concated));
+    outputs->push_back(std::move(concated));
+  }
+  outputs_.clear();
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,91 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_SPLIT_OUTPUT_ASSEMBLER_H_
+#define TENSORFLOW_SERVING_BATCHING_SPLIT_OUTPUT_ASSEMBLER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Assembles the outputs of a task that was split into several smaller tasks
+// (see SplitInputTask() in batching_session.h), as the splits complete.
+//
+// Each output tensor of the original task is the concatenation, along the 0th
+// dimension, of the corresponding output tensors of the splits. Rather than
+// holding on to the split outputs until all splits are done and concatenating
+// them then, each split's output is copied into its place in the final tensor
+// as soon as the split's batch has been processed. That spreads the copying
+// across the batch threads, lets the batched output tensors be released
+// early, and leaves no concatenation on the critical path once the last split
+// completes.
+//
+// Outputs of types that cannot be copied row-wise (i.e. other than plain-old-
+// data types and DT_STRING) are retained and concatenated by Finish().
+//
+// This class is thread-safe.
+class SplitOutputAssembler {
+ public:
+  // 'split_sizes' are the 0th dimension sizes of the splits, in order, and
+  // 'num_outputs' the number of output tensors of each split.
+  SplitOutputAssembler(int num_outputs, absl::Span<const int64_t> split_sizes);
+
+  ~SplitOutputAssembler() = default;
+
+  // Copies 'tensor', the output 'output_index' of split 'split_index', into
+  // place. Returns an error if its shape is incompatible with the output of
+  // another split.
+  Status AddSplitOutput(int split_index, int output_index,
+                        const Tensor& tensor) TF_LOCKS_EXCLUDED(mu_);
+
+  // Sets 'outputs' to the assembled output tensors. Must be called once, after
+  // AddSplitOutput() succeeded for every output of every split.
+  Status Finish(std::vector<Tensor>* outputs) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Output {
+    // The assembled tensor, allocated when the first split output arrives.
+    bool allocated = false;
+    Tensor tensor;
+
+    // For types that cannot be copied row-wise, the split outputs, indexed
+    // by split.
+    std::vector<Tensor> pieces;
+  };
+
+  // The 0th dimension offset of each split into the assembled tensors.
+  std::vector<int64_t> split_offsets_;
+  std::vector<int64_t> split_sizes_;
+  int64_t total_size_ = 0;
+
+  mutex mu_;
+  std::vector<Output> outputs_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SplitOutputAssembler);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_SPLIT_OUTPUT_ASSEMBLER_H_
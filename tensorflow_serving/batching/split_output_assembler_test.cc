@@ -0,0 +1,97 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/split_output_assembler.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(SplitOutputAssemblerTest, AssemblesSplitsInAnyOrder) {
+  SplitOutputAssembler assembler(/*num_outputs=*/2, {1, 2});
+  // The second split completes first.
+  TF_ASSERT_OK(assembler.AddSplitOutput(
+      1, 0, test::AsTensor<float>({3, 4, 5, 6}, {2, 2})));
+  TF_ASSERT_OK(
+      assembler.AddSplitOutput(1, 1, test::AsTensor<tstring>({"b", "c"})));
+  TF_ASSERT_OK(
+      assembler.AddSplitOutput(0, 0, test::AsTensor<float>({1, 2}, {1, 2})));
+  TF_ASSERT_OK(assembler.AddSplitOutput(0, 1, test::AsTensor<tstring>({"a"})));
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(assembler.Finish(&outputs));
+  ASSERT_EQ(2, outputs.size());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {3, 2}), outputs[0]);
+  test::ExpectTensorEqual<tstring>(test::AsTensor<tstring>({"a", "b", "c"}),
+                                   outputs[1]);
+}
+
+TEST(SplitOutputAssemblerTest, AssemblesConcurrentSplits) {
+  constexpr int kNumSplits = 8;
+  SplitOutputAssembler assembler(
+      /*num_outputs=*/1, std::vector<int64_t>(kNumSplits, 2));
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < kNumSplits; ++i) {
+      threads.emplace_back(
+          Env::Default()->StartThread({}, "split", [&assembler, i] {
+            TF_ASSERT_OK(assembler.AddSplitOutput(
+                i, 0, test::AsTensor<int32>({2 * i, 2 * i + 1})));
+          }));
+    }
+  }
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(assembler.Finish(&outputs));
+  ASSERT_EQ(1, outputs.size());
+  std::vector<int32> expected;
+  for (int i = 0; i < 2 * kNumSplits; ++i) {
+    expected.push_back(i);
+  }
+  test::ExpectTensorEqual<int32>(test::AsTensor<int32>(expected), outputs[0]);
+}
+
+TEST(SplitOutputAssemblerTest, RejectsIncompatibleSplits) {
+  SplitOutputAssembler assembler(/*num_outputs=*/1, {1, 2});
+  // Wrong 0th dimension size for the split.
+  EXPECT_FALSE(
+      assembler.AddSplitOutput(0, 0, test::AsTensor<float>({1, 2})).ok());
+
+  TF_ASSERT_OK(
+      assembler.AddSplitOutput(0, 0, test::AsTensor<float>({1, 2}, {1, 2})));
+  // Mismatched inner dimension.
+  EXPECT_FALSE(assembler
+                   .AddSplitOutput(
+                       1, 0, test::AsTensor<float>({1, 2, 3, 4, 5, 6}, {2, 3}))
+                   .ok());
+  // Mismatched type.
+  EXPECT_FALSE(assembler
+                   .AddSplitOutput(1, 0,
+                                   test::AsTensor<int32>({1, 2, 3, 4}, {2, 2}))
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
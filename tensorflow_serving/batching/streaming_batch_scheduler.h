@@ -22,6 +22,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -144,6 +145,28 @@ class StreamingBatchScheduler : public BatchScheduler<TaskType> {
     // Must be >= 1, and should be tuned carefully.
     int num_batch_threads = port::MaxParallelism();
 
+    // If true, a task that does not fit into the open batch is split (as
+    // specified by 'split_input_task_func' below) such that the first piece
+    // fills up the open batch and the remaining pieces start new batches of at
+    // most 'max_batch_size' each. This also admits tasks larger than
+    // 'max_batch_size'. A task is only split if there are enough idle batch
+    // threads to start all of its pieces right away, so the largest task that
+    // can be admitted is roughly 'num_batch_threads * max_batch_size'.
+    //
+    // If false, tasks larger than 'max_batch_size' are rejected.
+    bool enable_large_batch_splitting = false;
+
+    // Splits 'input_task' into pieces, the first of which has size
+    // 'open_batch_remaining_slot' (unless that is zero) and the others have
+    // size of at most 'max_batch_size'. Must be set if
+    // 'enable_large_batch_splitting' is true. The signature matches that of
+    // the split functions of the batch schedulers in
+    // tensorflow/core/kernels/batching_util.
+    std::function<Status(std::unique_ptr<TaskType>* input_task,
+                         int open_batch_remaining_slot, int max_batch_size,
+                         std::vector<std::unique_ptr<TaskType>>* output_tasks)>
+        split_input_task_func;
+
     // The following options are typically only overridden by test code.
 
     // The environment to use.
@@ -181,6 +204,19 @@ class StreamingBatchScheduler : public BatchScheduler<TaskType> {
   bool TaskFitsInBatch(const TaskType* task,
                        const Batch<TaskType>* batch) const;
 
+  // Adds 'task' to 'open_batch_', which must have room for it, scheduling the
+  // batch to be closed after the timeout if 'task' is its first task and
+  // closing it right away if 'task' fills it up.
+  void AddTaskToOpenBatch(std::unique_ptr<TaskType> task)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Splits 'task' with 'options_.split_input_task_func' and adds the pieces to
+  // the open batch and as many new batches as needed. Returns UNAVAILABLE,
+  // leaving 'task' untouched, if there aren't enough idle batch threads to
+  // start the new batches.
+  Status ScheduleSplitTask(std::unique_ptr<TaskType>* task)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Closes 'open_batch_' (unless it equals nullptr), and replaces it with a
   // fresh open batch. Schedules the new batch on 'batch_threads_'.
   void StartNewBatch() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -313,9 +349,15 @@ Status StreamingBatchScheduler<TaskType>::Create(
     return errors::InvalidArgument("num_batch_threads must be positive; was ",
                                    options.num_batch_threads);
   }
+  if (options.enable_large_batch_splitting &&
+      options.split_input_task_func == nullptr) {
+    return errors::InvalidArgument(
+        "split_input_task_func must be set when enable_large_batch_splitting "
+        "is true");
+  }
   scheduler->reset(
       new StreamingBatchScheduler<TaskType>(options, process_batch_callback));
-  return Status();
+  return OkStatus();
 }
 
 template <typename TaskType>
@@ -336,7 +378,8 @@ StreamingBatchScheduler<TaskType>::~StreamingBatchScheduler() {
 template <typename TaskType>
 Status StreamingBatchScheduler<TaskType>::Schedule(
     std::unique_ptr<TaskType>* task) {
-  if ((*task)->size() > options_.max_batch_size) {
+  if ((*task)->size() > options_.max_batch_size &&
+      !options_.enable_large_batch_splitting) {
     return errors::InvalidArgument("Task size ", (*task)->size(),
                                    " is larger than maximum batch size ",
                                    options_.max_batch_size);
@@ -345,6 +388,13 @@ Status StreamingBatchScheduler<TaskType>::Schedule(
   {
     mutex_lock l(mu_);
 
+    if (options_.enable_large_batch_splitting &&
+        (open_batch_ == nullptr
+             ? (*task)->size() > options_.max_batch_size
+             : !TaskFitsInBatch(task->get(), open_batch_))) {
+      return ScheduleSplitTask(task);
+    }
+
     if (open_batch_ == nullptr || !TaskFitsInBatch(task->get(), open_batch_)) {
       StartNewBatch();
     }
@@ -360,23 +410,65 @@ Status StreamingBatchScheduler<TaskType>::Schedule(
           "this task");
     }
 
-    // If we are about to add the first task to a batch, schedule the batch to
-    // be closed after the timeout.
-    if (options_.batch_timeout_micros > 0 && open_batch_->empty()) {
-      const uint64_t batch_deadline =
-          options_.env->NowMicros() + options_.batch_timeout_micros;
-      ScheduleCloseOfCurrentOpenBatch(batch_deadline);
-    }
+    AddTaskToOpenBatch(std::move(*task));
+  }
+
+  return OkStatus();
+}
 
-    open_batch_->AddTask(std::move(*task));
+template <typename TaskType>
+void StreamingBatchScheduler<TaskType>::AddTaskToOpenBatch(
+    std::unique_ptr<TaskType> task) {
+  // If we are about to add the first task to a batch, schedule the batch to
+  // be closed after the timeout.
+  if (options_.batch_timeout_micros > 0 && open_batch_->empty()) {
+    const uint64_t batch_deadline =
+        options_.env->NowMicros() + options_.batch_timeout_micros;
+    ScheduleCloseOfCurrentOpenBatch(batch_deadline);
+  }
 
-    // If we've exactly reached the target size, we can close this batch now.
-    if (open_batch_->size() == options_.max_batch_size) {
+  open_batch_->AddTask(std::move(task));
+
+  // If we've exactly reached the target size, we can close this batch now.
+  if (open_batch_->size() == options_.max_batch_size) {
+    StartNewBatch();
+  }
+}
+
+template <typename TaskType>
+Status StreamingBatchScheduler<TaskType>::ScheduleSplitTask(
+    std::unique_ptr<TaskType>* task) {
+  const int open_batch_remaining_slot =
+      open_batch_ == nullptr ? 0
+                             : options_.max_batch_size - open_batch_->size();
+  const size_t task_size = (*task)->size();
+  const size_t size_for_new_batches =
+      task_size - std::min<size_t>(task_size, open_batch_remaining_slot);
+  const int num_new_batches =
+      (size_for_new_batches + options_.max_batch_size - 1) /
+      options_.max_batch_size;
+  // Mirrors the capacity check in Schedule(): every new batch needs a thread.
+  if (num_batches_in_progress_ + num_new_batches >
+      options_.num_batch_threads) {
+    return errors::Unavailable(
+        "This task would be split across ", num_new_batches,
+        " fresh batches, but not enough batch threads are idle, so at present "
+        "there is no processing capacity available for this task");
+  }
+
+  std::vector<std::unique_ptr<TaskType>> output_tasks;
+  TF_RETURN_IF_ERROR(options_.split_input_task_func(
+      task, open_batch_remaining_slot, options_.max_batch_size,
+      &output_tasks));
+  task->reset();
+  for (auto& output_task : output_tasks) {
+    if (open_batch_ == nullptr ||
+        !TaskFitsInBatch(output_task.get(), open_batch_)) {
       StartNewBatch();
     }
+    AddTaskToOpenBatch(std::move(output_task));
   }
-
-  return Status();
+  return OkStatus();
 }
 
 template <typename TaskType>
@@ -464,7 +556,7 @@ Status CreateRetryingStreamingBatchScheduler(
   TF_RETURN_IF_ERROR(BatchSchedulerRetrier<TaskType>::Create(
       retry_options, std::move(streaming_scheduler), &retrier));
   *scheduler = std::move(retrier);
-  return Status();
+  return OkStatus();
 }
 
 }  // namespace serving
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_serving/batching/streaming_batch_scheduler.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -125,6 +126,71 @@ TEST(StreamingBatchSchedulerTest, ObeyBatchSizeConstraint) {
       UnorderedElementsAre(ElementsAre(3, 5), ElementsAre(3, 1, 6), IsEmpty()));
 }
 
+TEST(StreamingBatchSchedulerTest, LargeBatchSplitting) {
+  mutex mu;
+  std::vector<std::vector<size_t>> callback_data;
+  auto callback = [&mu,
+                   &callback_data](std::unique_ptr<Batch<FakeTask>> batch) {
+    batch->WaitUntilClosed();
+    std::vector<size_t> batch_data;
+    for (int i = 0; i < batch->num_tasks(); ++i) {
+      batch_data.push_back(batch->mutable_task(i)->size());
+    }
+    {
+      mutex_lock l(mu);
+      callback_data.push_back(batch_data);
+    }
+  };
+
+  {
+    StreamingBatchScheduler<FakeTask>::Options options;
+    options.max_batch_size = 10;
+    options.batch_timeout_micros = -1;
+    options.num_batch_threads = 3;
+    options.enable_large_batch_splitting = true;
+    options.split_input_task_func =
+        [](std::unique_ptr<FakeTask>* input_task, int open_batch_remaining_slot,
+           int max_batch_size,
+           std::vector<std::unique_ptr<FakeTask>>* output_tasks) {
+          size_t remaining_size = (*input_task)->size();
+          size_t piece_size = open_batch_remaining_slot > 0
+                                  ? open_batch_remaining_slot
+                                  : max_batch_size;
+          while (remaining_size > 0) {
+            const size_t size = std::min(piece_size, remaining_size);
+            output_tasks->emplace_back(new FakeTask(size));
+            remaining_size -= size;
+            piece_size = max_batch_size;
+          }
+          return OkStatus();
+        };
+    std::unique_ptr<StreamingBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(StreamingBatchScheduler<FakeTask>::Create(options, callback,
+                                                           &scheduler));
+
+    TF_ASSERT_OK(ScheduleTask(3, scheduler.get()));
+    // Split into 7, which fills up the first batch, and 8, which starts a
+    // second one.
+    TF_ASSERT_OK(ScheduleTask(15, scheduler.get()));
+    // Would need ten more batches, but only one more batch thread is idle.
+    const Status status = ScheduleTask(100, scheduler.get());
+    EXPECT_EQ(error::UNAVAILABLE, status.code());
+  }
+
+  EXPECT_THAT(callback_data,
+              UnorderedElementsAre(ElementsAre(3, 7), ElementsAre(8)));
+}
+
+TEST(StreamingBatchSchedulerTest, RejectsSplittingWithoutSplitFunc) {
+  StreamingBatchScheduler<FakeTask>::Options options;
+  options.enable_large_batch_splitting = true;
+  std::unique_ptr<StreamingBatchScheduler<FakeTask>> scheduler;
+  EXPECT_FALSE(StreamingBatchScheduler<FakeTask>::Create(
+                   options, [](std::unique_ptr<Batch<FakeTask>> batch) {},
+                   &scheduler)
+                   .ok());
+}
+
 TEST(StreamingBatchSchedulerTest, Timeout) {
   // Set up a fake clock, which only advances when we explicitly tell it to.
   test_util::FakeClockEnv env(Env::Default());
@@ -19,10 +19,15 @@ limitations under the License.
 #include "absl/container/inlined_vector.h"
 #include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow_serving/batching/batch_tensor_pool.h"
 #include "tensorflow_serving/batching/batching_util.h"
+#include "tensorflow_serving/batching/bucketized_batch_scheduler.h"
 #include "tensorflow_serving/batching/incremental_barrier.h"
+#include "tensorflow_serving/util/request_deadline.h"
+#include "tsl/platform/criticality.h"
 
 namespace tensorflow {
 namespace serving {
@@ -38,6 +43,16 @@ auto *queuing_latency = monitoring::Sampler<0>::New(
     // Scale of 100, power of 1.2 with bucket count 52 (~1 second).
     monitoring::Buckets::Exponential(100, 1.2, 52));
 
+// Returns the key used to bucketize a task by its padded dimension size: the
+// largest size of any non-zeroth dimension among the task's input tensors.
+int64_t PaddedDimSize(const SavedModelBatchingTask &task) {
+  int64_t padded_dim_size = 0;
+  for (const Tensor &tensor : task.tfrt_inputs) {
+    padded_dim_size = std::max(padded_dim_size, MaxNonBatchDimSize(tensor));
+  }
+  return padded_dim_size;
+}
+
 // Batching implementation of SavedModel.
 class SavedModelWithBatching : public tfrt::SavedModel {
  public:
@@ -72,15 +87,13 @@ class SavedModelWithBatching : public tfrt::SavedModel {
              absl::string_view func_name, absl::Span<const Tensor> inputs,
              std::vector<Tensor> *outputs) override;
 
+  // With 'options_.batch_multiple_signatures', each function is run as in
+  // Run(), batched with the other calls of the function, if each has a batch
+  // scheduler. Otherwise the functions are run together by `wrapped_`.
   Status RunMultipleSignatures(
       const RunOptions &run_options, absl::Span<const std::string> names,
       absl::Span<const std::vector<tensorflow::Tensor>> multi_inputs,
-      std::vector<std::vector<tensorflow::Tensor>> *multi_outputs) override {
-    // TODO(b/191149783): Implement batching support for
-    // RunMultipleSignatures().
-    return wrapped_->RunMultipleSignatures(run_options, names, multi_inputs,
-                                           multi_outputs);
-  }
+      std::vector<std::vector<tensorflow::Tensor>> *multi_outputs) override;
 
   Status RunByTensorNames(
       const RunOptions &run_options,
@@ -94,6 +107,15 @@ class SavedModelWithBatching : public tfrt::SavedModel {
   }
 
  private:
+  // Schedules a task with `inputs` on the batch scheduler of a function. Once
+  // the task's batch has run, `outputs` and `status` are set and `done` is
+  // notified.
+  Status ScheduleTask(const tfrt::SavedModel::RunOptions &run_options,
+                      BatchScheduler<SavedModelBatchingTask> *scheduler,
+                      absl::Span<const Tensor> inputs,
+                      std::vector<Tensor> *outputs, Notification *done,
+                      Status *status);
+
   // Batches tensors in `batch` and invokes Run() with underlying `wrapped_`.
   void ProcessBatch(absl::string_view func_name,
                     std::unique_ptr<Batch<SavedModelBatchingTask>> batch);
@@ -116,6 +138,11 @@ class SavedModelWithBatching : public tfrt::SavedModel {
                       std::unique_ptr<BatchScheduler<SavedModelBatchingTask>>>
       batch_schedulers_;
 
+  // Recycled buffers for merged and for padded per-task input tensors. Only
+  // used if 'options_.enable_pooled_batch_assembly' is true.
+  BatchTensorPool merged_input_pool_;
+  BatchTensorPool padded_input_pool_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(SavedModelWithBatching);
 };
 
@@ -124,7 +151,10 @@ SavedModelWithBatching::SavedModelWithBatching(
     std::unique_ptr<SavedModel> saved_model)
     : tfrt::SavedModel(&saved_model->runtime()),
       options_(options),
-      wrapped_(std::move(saved_model)) {}
+      wrapped_(std::move(saved_model)),
+      merged_input_pool_(kMaxPooledBatchTensorsPerShape),
+      padded_input_pool_(kMaxPooledBatchTensorsPerShape,
+                         kMaxPooledPaddedInputBytes) {}
 
 Status SavedModelWithBatching::Create(
     const SavedModelBatchingOptions &options,
@@ -135,6 +165,12 @@ Status SavedModelWithBatching::Create(
   if (saved_model == nullptr) {
     return errors::FailedPrecondition("saved_model must not be null.");
   }
+  for (size_t i = 1; i < options.allowed_batch_sizes.size(); ++i) {
+    if (options.allowed_batch_sizes[i] <= options.allowed_batch_sizes[i - 1]) {
+      return errors::InvalidArgument(
+          "allowed_batch_sizes entries must be monotonically increasing");
+    }
+  }
 
   SavedModel *raw_saved_model = saved_model.get();
   std::unique_ptr<SavedModelWithBatching> saved_model_with_batching =
@@ -159,7 +195,11 @@ Status SavedModelWithBatching::Create(
     }
 
     const std::string &func_name = insert_result.first->first;
-    TF_RETURN_IF_ERROR(entry.scheduler_creator(
+    const SavedModelBatchingSchedulerCreator scheduler_creator =
+        MaybeBucketizeSchedulerCreator<SavedModelBatchingTask>(
+            options.padded_dim_bucket_boundaries, PaddedDimSize,
+            entry.scheduler_creator);
+    TF_RETURN_IF_ERROR(scheduler_creator(
         [func_name, raw_saved_model_with_batching](
             std::unique_ptr<Batch<SavedModelBatchingTask>> batch) {
           raw_saved_model_with_batching->ProcessBatch(func_name,
@@ -203,6 +243,60 @@ Status SavedModelWithBatching::Run(
 
   Notification done;
   Status status;
+  TF_RETURN_IF_ERROR(ScheduleTask(run_options, it->second.get(), inputs,
+                                  outputs, &done, &status));
+  done.WaitForNotification();
+  return status;
+}
+
+Status SavedModelWithBatching::RunMultipleSignatures(
+    const RunOptions &run_options, absl::Span<const std::string> names,
+    absl::Span<const std::vector<tensorflow::Tensor>> multi_inputs,
+    std::vector<std::vector<tensorflow::Tensor>> *multi_outputs) {
+  std::vector<BatchScheduler<SavedModelBatchingTask> *> schedulers;
+  if (options_.batch_multiple_signatures && multi_outputs != nullptr &&
+      names.size() == multi_inputs.size()) {
+    for (const std::string &name : names) {
+      auto it = batch_schedulers_.find(name);
+      if (it == batch_schedulers_.end()) {
+        break;
+      }
+      schedulers.push_back(it->second.get());
+    }
+  }
+  if (names.empty() || schedulers.size() != names.size()) {
+    return wrapped_->RunMultipleSignatures(run_options, names, multi_inputs,
+                                           multi_outputs);
+  }
+
+  multi_outputs->clear();
+  multi_outputs->resize(names.size());
+  std::vector<Notification> done(names.size());
+  std::vector<Status> statuses(names.size());
+  // The functions are scheduled all at once, so that they are batched
+  // concurrently, then waited for.
+  Status status;
+  int num_scheduled_tasks = 0;
+  for (; num_scheduled_tasks < names.size(); ++num_scheduled_tasks) {
+    const int i = num_scheduled_tasks;
+    status = ScheduleTask(run_options, schedulers[i], multi_inputs[i],
+                          &(*multi_outputs)[i], &done[i], &statuses[i]);
+    if (!status.ok()) {
+      break;
+    }
+  }
+  for (int i = 0; i < num_scheduled_tasks; ++i) {
+    done[i].WaitForNotification();
+    status.Update(statuses[i]);
+  }
+  return status;
+}
+
+Status SavedModelWithBatching::ScheduleTask(
+    const tfrt::SavedModel::RunOptions &run_options,
+    BatchScheduler<SavedModelBatchingTask> *scheduler,
+    absl::Span<const Tensor> inputs, std::vector<Tensor> *outputs,
+    Notification *done, Status *status) {
   auto task = absl::make_unique<SavedModelBatchingTask>();
   TF_RETURN_IF_ERROR(ComputeTensorBatchSize(
       inputs, &task->zeroth_dim_size,
@@ -213,14 +307,14 @@ Status SavedModelWithBatching::Run(
   task->host_context = GetHostContext();
   task->tfrt_inputs = inputs;
   task->tfrt_outputs = outputs;
-  task->done = &done;
-  task->status = &status;
+  task->done = done;
+  task->status = status;
   task->run_options = run_options;
   task->enqueue_time_micros = EnvTime::NowMicros();
+  task->request_deadline = RequestDeadline::Current();
+  task->criticality = tsl::criticality::GetCriticality();
 
-  TF_RETURN_IF_ERROR(it->second->Schedule(&task));
-  done.WaitForNotification();
-  return status;
+  return scheduler->Schedule(&task);
 }
 
 // TODO(b/168220822): Once tfrt supports tensor split/pad/concat utilities and
@@ -288,8 +382,11 @@ Status SavedModelWithBatching::BatchInputTensors(
 
       Tensor optionally_padded_tensor;
       if (options_.pad_variable_length_inputs) {
-        TF_RETURN_IF_ERROR(AddPadding(tensor, max_dim_sizes[tensor_idx],
-                                      &optionally_padded_tensor));
+        TF_RETURN_IF_ERROR(AddPadding(
+            tensor, max_dim_sizes[tensor_idx],
+            options_.enable_pooled_batch_assembly ? &padded_input_pool_
+                                                  : nullptr,
+            &optionally_padded_tensor));
       } else {
         optionally_padded_tensor = tensor;
         if (batch_idx > 0) {
@@ -315,8 +412,15 @@ Status SavedModelWithBatching::BatchInputTensors(
 
   for (const auto &tensors : tensors_to_merge) {
     Tensor concated;
-    TF_RETURN_IF_ERROR(tensor::Concat(tensors, &concated));
-    batch_inputs->push_back(concated);
+    if (!options_.enable_pooled_batch_assembly) {
+      TF_RETURN_IF_ERROR(tensor::Concat(tensors, &concated));
+    } else if (tensors.size() == 1) {
+      // A lone task without padding is already laid out as a batch.
+      concated = tensors[0];
+    } else {
+      TF_RETURN_IF_ERROR(merged_input_pool_.Concat(tensors, &concated));
+    }
+    batch_inputs->push_back(std::move(concated));
   }
 
   return Status();
@@ -345,9 +449,16 @@ void SavedModelWithBatching::ProcessBatch(
   const uint64_t dequeue_time_micros = EnvTime::NowMicros();
 
   bool all_tasks_timeout_exceeded = true;
+  // The tasks of a batch are run together, so the batch is only dropped once
+  // all their requests are cancelled.
+  bool all_tasks_cancelled = true;
   absl::optional<std::chrono::system_clock::time_point> batch_deadline;
   for (int batch_idx = 0; batch_idx < batch->num_tasks(); ++batch_idx) {
     const SavedModelBatchingTask &task = batch->task(batch_idx);
+    if (task.request_deadline == nullptr ||
+        !task.request_deadline->IsCancelled()) {
+      all_tasks_cancelled = false;
+    }
     if (!task.run_options.deadline.has_value() ||
         absl::ToChronoTime(absl::Now()) < task.run_options.deadline.value()) {
       all_tasks_timeout_exceeded = false;
@@ -361,6 +472,11 @@ void SavedModelWithBatching::ProcessBatch(
                                     task.enqueue_time_micros);
   }
 
+  if (all_tasks_cancelled) {
+    status = errors::Cancelled(
+        "The requests were cancelled while waiting in batching queue");
+    return;
+  }
   if (all_tasks_timeout_exceeded) {
     status = Status(
         static_cast<tsl::errors::Code>(absl::StatusCode::kResourceExhausted),
@@ -400,8 +516,12 @@ Status SavedModelWithBatching::SplitOutputTensors(
 
   for (const auto &combined_tensor : combined_outputs) {
     std::vector<Tensor> split_tensors;
-    TF_RETURN_IF_ERROR(
-        tensor::Split(combined_tensor, split_batch_sizes, &split_tensors));
+    TF_RETURN_IF_ERROR(options_.enable_pooled_batch_assembly
+                           ? SplitTensorWithAliasing(combined_tensor,
+                                                     split_batch_sizes,
+                                                     &split_tensors)
+                           : tensor::Split(combined_tensor, split_batch_sizes,
+                                           &split_tensors));
 
     for (int batch_idx = 0; batch_idx < batch->num_tasks(); ++batch_idx) {
       SavedModelBatchingTask *task = batch->mutable_task(batch_idx);
@@ -495,7 +615,11 @@ Status SplitSavedModelInputTask(
   for (int i = 0; i < output_task_num; ++i) {
     auto task = absl::make_unique<SavedModelBatchingTask>();
     task->zeroth_dim_size = output_task_sizes[i];
+    task->host_context = input_task->host_context;
     task->run_options = input_task->run_options;
+    task->enqueue_time_micros = input_task->enqueue_time_micros;
+    task->request_deadline = input_task->request_deadline;
+    task->criticality = input_task->criticality;
     task->tfrt_outputs = (*split_output)[i].get();
     task->done_callback = barrier.Inc();
     task->partial_status = partial_status.get();
@@ -419,6 +419,113 @@ TEST_F(SavedModelWithBatchingTest, UnequalShapesWhenPaddingIsTurnedOff) {
       }));
 }
 
+// Tests that creation of SavedModelWithBatching returns an appropriate error if
+// the allowed batch sizes are not increasing.
+TEST_F(SavedModelWithBatchingTest, UnsortedAllowedBatchSizesRejected) {
+  std::unique_ptr<test_util::MockSavedModel> wrapped_saved_model =
+      InitializeMockSavedModel();
+  auto scheduler_creator =
+      absl::bind_front(&CreateDefaultBasicBatchScheduler,
+                       BuildSchedulerOptions(/*max_batch_size=*/4));
+  std::vector<FuncNameWithBatchingSchedulerCreator> creators = {
+      {kFunctionOne, scheduler_creator}};
+  EXPECT_THAT(CreateSavedModelWithBatching(
+                  BuildSavedModelBatchingOptions(
+                      /*pad_variable_length_inputs=*/false,
+                      /*allowed_batch_sizes=*/{4, 2}),
+                  creators, std::move(wrapped_saved_model),
+                  &saved_model_with_batching_),
+              TFStatusIs(error::INVALID_ARGUMENT, "monotonically increasing"));
+}
+
+// Tests that with bucket boundaries, tasks are only batched with tasks of a
+// similar padded dimension size, so that short tasks are not padded to the
+// size of long ones.
+TEST_F(SavedModelWithBatchingTest, BucketizesByPaddedDimSize) {
+  SavedModelBatchingOptions options =
+      BuildSavedModelBatchingOptions(/*pad_variable_length_inputs=*/true,
+                                     /*allowed_batch_sizes=*/{});
+  options.padded_dim_bucket_boundaries = {3};
+  Initialize(BuildSchedulerOptions(/*max_batch_size=*/2), options);
+
+  // Two short and two long tasks, issued alternately.
+  auto inputs = MakeTensorsBatch({{{{1, 2}, {1, 2}}},
+                                  {{{1, 2, 3, 4, 5}, {1, 5}}},
+                                  {{{3, 4, 5}, {1, 3}}},
+                                  {{{6, 7, 8, 9, 10, 11}, {1, 6}}}});
+
+  EXPECT_CALL(
+      *wrapped_saved_model_,
+      Run(_, kFunctionOne, ::testing::An<absl::Span<const Tensor>>(), _))
+      .Times(2)
+      .WillRepeatedly(Invoke([&](const tfrt::SavedModel::RunOptions &,
+                                 absl::string_view,
+                                 absl::Span<const Tensor> inputs,
+                                 std::vector<Tensor> *outputs) {
+        // Each batch holds the two tasks of one bucket, padded to the longer
+        // of the two.
+        EXPECT_EQ(2, inputs[0].dim_size(0));
+        EXPECT_TRUE(inputs[0].dim_size(1) == 3 || inputs[0].dim_size(1) == 6);
+        outputs->push_back(MakeTensor({1, 2}, /*shape=*/{2}));
+        return Status();
+      }));
+
+  tfrt::SavedModel::RunOptions run_options;
+  std::vector<std::unique_ptr<Thread>> request_threads;
+  for (const auto &task_inputs : inputs) {
+    request_threads.emplace_back(Env::Default()->StartThread(
+        ThreadOptions(), "request_thread", [&] {
+          std::vector<Tensor> outputs;
+          TF_ASSERT_OK(saved_model_with_batching_->Run(
+              run_options, kFunctionOne, task_inputs, &outputs));
+          EXPECT_EQ(1, outputs.size());
+        }));
+  }
+}
+
+// Tests that batching with pooled batch assembly produces the same outputs as
+// regular batching, across several batches that reuse the pooled buffers.
+TEST_F(SavedModelWithBatchingTest, PooledBatchAssembly) {
+  SavedModelBatchingOptions options =
+      BuildSavedModelBatchingOptions(/*pad_variable_length_inputs=*/true,
+                                     /*allowed_batch_sizes=*/{4});
+  options.enable_pooled_batch_assembly = true;
+  Initialize(BuildSchedulerOptions(/*max_batch_size=*/2), options);
+
+  EXPECT_CALL(
+      *wrapped_saved_model_,
+      Run(_, kFunctionOne, ::testing::An<absl::Span<const Tensor>>(), _))
+      .Times(3)
+      .WillRepeatedly(Invoke([&](const tfrt::SavedModel::RunOptions &,
+                                 absl::string_view,
+                                 absl::Span<const Tensor> inputs,
+                                 std::vector<Tensor> *outputs) {
+        // Echo the (padded) input.
+        EXPECT_EQ(4, inputs[0].dim_size(0));
+        outputs->push_back(inputs[0]);
+        return Status();
+      }));
+
+  tfrt::SavedModel::RunOptions run_options;
+  for (int i = 0; i < 3; ++i) {
+    auto inputs = MakeTensorsBatch(
+        {{{{1.0f * i, 2}, {1, 2}}}, {{{3, 4, 5.0f * i}, {1, 3}}}});
+    // The first task is padded with its first element.
+    std::vector<Tensor> expected = {MakeTensor({1.0f * i, 2, 1.0f * i}, {1, 3}),
+                                    MakeTensor({3, 4, 5.0f * i}, {1, 3})};
+    std::vector<std::unique_ptr<Thread>> request_threads;
+    for (int j = 0; j < 2; ++j) {
+      request_threads.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), "request_thread", [&, j] {
+            std::vector<Tensor> outputs;
+            TF_ASSERT_OK(saved_model_with_batching_->Run(
+                run_options, kFunctionOne, inputs[j], &outputs));
+            EXPECT_THAT(outputs, ElementsAre(MatchesTensor(&expected[j])));
+          }));
+    }
+  }
+}
+
 // Tests that processing batch returns an appropriate error if all tasks in the
 // batch has a past deadline.
 TEST_F(SavedModelWithBatchingTest, AllTasksExceededDeadline) {
@@ -545,6 +652,68 @@ TEST_F(SavedModelWithBatchingTest, MultipleFunctions) {
   }
 }
 
+// Tests that with 'batch_multiple_signatures', each function of
+// RunMultipleSignatures() is batched with the other runs of the function.
+TEST_F(SavedModelWithBatchingTest, BatchesMultipleSignatures) {
+  SavedModelBatchingOptions options;
+  options.batch_multiple_signatures = true;
+  Initialize(BuildSchedulerOptions(/*max_batch_size=*/2), options);
+
+  EXPECT_CALL(*wrapped_saved_model_, RunMultipleSignatures(_, _, _, _))
+      .Times(0);
+  for (const char *function : {kFunctionOne, kFunctionTwo}) {
+    EXPECT_CALL(*wrapped_saved_model_,
+                Run(_, function, ::testing::An<absl::Span<const Tensor>>(), _))
+        .WillOnce(Invoke([&](const tfrt::SavedModel::RunOptions &run_options,
+                             absl::string_view func_name,
+                             absl::Span<const Tensor> inputs,
+                             std::vector<Tensor> *outputs) {
+          // Both requests are in the batch; echo it.
+          EXPECT_EQ(2, inputs[0].dim_size(0));
+          outputs->push_back(inputs[0]);
+          return Status();
+        }));
+  }
+
+  const std::vector<std::string> names = {kFunctionOne, kFunctionTwo};
+  auto inputs = MakeTensorsBatch({{{{1, 2}, {1, 2}}}, {{{3, 4}, {1, 2}}}});
+  std::vector<std::unique_ptr<Thread>> request_threads;
+  for (int i = 0; i < 2; ++i) {
+    request_threads.emplace_back(Env::Default()->StartThread(
+        ThreadOptions(), "request_thread", [&, i] {
+          const std::vector<std::vector<Tensor>> multi_inputs = {inputs[i],
+                                                                 inputs[i]};
+          std::vector<std::vector<Tensor>> multi_outputs;
+          TF_ASSERT_OK(saved_model_with_batching_->RunMultipleSignatures(
+              tfrt::SavedModel::RunOptions(), names, multi_inputs,
+              &multi_outputs));
+          ASSERT_EQ(2, multi_outputs.size());
+          for (const std::vector<Tensor> &outputs : multi_outputs) {
+            EXPECT_THAT(outputs, ElementsAre(MatchesTensor(&inputs[i][0])));
+          }
+        }));
+  }
+}
+
+// Tests that by default RunMultipleSignatures() runs the functions together,
+// unbatched.
+TEST_F(SavedModelWithBatchingTest, MultipleSignaturesUnbatchedByDefault) {
+  Initialize(BuildSchedulerOptions(/*max_batch_size=*/2));
+
+  EXPECT_CALL(*wrapped_saved_model_, RunMultipleSignatures(_, _, _, _))
+      .WillOnce(Return(Status()));
+  EXPECT_CALL(*wrapped_saved_model_,
+              Run(_, _, ::testing::An<absl::Span<const Tensor>>(), _))
+      .Times(0);
+
+  const std::vector<std::string> names = {kFunctionOne, kFunctionTwo};
+  const std::vector<std::vector<Tensor>> multi_inputs =
+      MakeTensorsBatch({{{{1, 2}, {1, 2}}}, {{{1, 2}, {1, 2}}}});
+  std::vector<std::vector<Tensor>> multi_outputs;
+  TF_ASSERT_OK(saved_model_with_batching_->RunMultipleSignatures(
+      tfrt::SavedModel::RunOptions(), names, multi_inputs, &multi_outputs));
+}
+
 // Tests that when a large batch needs to be splitted, tensors are splitted and
 // partial outputs are eventually merged appropriately.
 TEST_F(SavedModelWithBatchingTest, SplitInputBasic) {
@@ -0,0 +1,178 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/weighted_fair_batch_gate.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+auto* slot_wait_time = monitoring::Sampler<1>::New(
+    {"/tensorflow/serving/batching/fair_batch_gate/slot_wait_time",
+     "Distribution of wall time spent (in microseconds) by batches waiting for "
+     "a batch execution slot",
+     "queue_name"},
+    // Scale of 100, power of 1.2 with bucket count 52 (~1 second).
+    monitoring::Buckets::Exponential(100, 1.2, 52));
+
+auto* slot_busy_time = monitoring::Counter<1>::New(
+    "/tensorflow/serving/batching/fair_batch_gate/slot_busy_time",
+    "Total wall time spent (in microseconds) by batch execution slots "
+    "processing batches of the queue. Its rate is the average number of slots "
+    "occupied by the queue.",
+    "queue_name");
+
+// The weight of the most recent batch in the per-queue mean batch cost.
+constexpr double kCostSmoothingFactor = 0.2;
+
+}  // namespace
+
+Status WeightedFairBatchGate::Create(
+    const Options& options, std::shared_ptr<WeightedFairBatchGate>* gate) {
+  if (options.num_slots <= 0) {
+    return errors::InvalidArgument("num_slots must be positive; was ",
+                                   options.num_slots);
+  }
+  if (options.env == nullptr) {
+    return errors::InvalidArgument("env must be set");
+  }
+  gate->reset(new WeightedFairBatchGate(options));
+  return OkStatus();
+}
+
+WeightedFairBatchGate::WeightedFairBatchGate(const Options& options)
+    : options_(options), num_free_slots_(options.num_slots) {}
+
+WeightedFairBatchGate::~WeightedFairBatchGate() {
+  mutex_lock l(mu_);
+  DCHECK(queues_.empty());
+}
+
+Status WeightedFairBatchGate::AddQueue(const string& name, double weight,
+                                       std::unique_ptr<Queue>* queue) {
+  if (weight <= 0) {
+    return errors::InvalidArgument("Queue weight must be positive; was ",
+                                   weight);
+  }
+  QueueState* state;
+  {
+    mutex_lock l(mu_);
+    queues_.emplace_back();
+    state = &queues_.back();
+    state->name = name;
+    state->weight = weight;
+    state->virtual_time = system_virtual_time_;
+  }
+  queue->reset(new Queue(shared_from_this(), state));
+  return OkStatus();
+}
+
+double WeightedFairBatchGate::Acquire(QueueState* state) {
+  mutex_lock l(mu_);
+  if (state->num_waiting == 0 && state->num_running == 0) {
+    // The queue becomes active, so forfeit any credit it built up while idle.
+    state->virtual_time = std::max(state->virtual_time, system_virtual_time_);
+  }
+  ++state->num_waiting;
+  while (num_free_slots_ == 0 || NextQueueToServe() != state) {
+    slot_released_.wait(l);
+  }
+  --state->num_waiting;
+  ++state->num_running;
+  --num_free_slots_;
+  system_virtual_time_ = state->virtual_time;
+  const double charged_cost_micros = state->mean_cost_micros;
+  state->virtual_time += charged_cost_micros / state->weight;
+  if (num_free_slots_ > 0) {
+    // A batch of another queue may be next in line for the remaining slots.
+    slot_released_.notify_all();
+  }
+  return charged_cost_micros;
+}
+
+void WeightedFairBatchGate::Release(QueueState* state,
+                                    double charged_cost_micros,
+                                    int64_t cost_micros) {
+  mutex_lock l(mu_);
+  state->virtual_time += (cost_micros - charged_cost_micros) / state->weight;
+  if (state->mean_cost_micros == 0) {
+    state->mean_cost_micros = cost_micros;
+  } else {
+    state->mean_cost_micros +=
+        kCostSmoothingFactor * (cost_micros - state->mean_cost_micros);
+  }
+  --state->num_running;
+  ++num_free_slots_;
+  slot_released_.notify_all();
+}
+
+int WeightedFairBatchGate::NumWaitingBatches() const {
+  mutex_lock l(mu_);
+  int num_waiting_batches = 0;
+  for (const QueueState& state : queues_) {
+    num_waiting_batches += state.num_waiting;
+  }
+  return num_waiting_batches;
+}
+
+WeightedFairBatchGate::QueueState* WeightedFairBatchGate::NextQueueToServe() {
+  QueueState* next = nullptr;
+  for (QueueState& state : queues_) {
+    if (state.num_waiting > 0 &&
+        (next == nullptr || state.virtual_time < next->virtual_time)) {
+      next = &state;
+    }
+  }
+  return next;
+}
+
+void WeightedFairBatchGate::RemoveQueue(QueueState* state) {
+  mutex_lock l(mu_);
+  DCHECK_EQ(0, state->num_waiting);
+  DCHECK_EQ(0, state->num_running);
+  queues_.remove_if(
+      [state](const QueueState& entry) { return &entry == state; });
+}
+
+WeightedFairBatchGate::Queue::~Queue() { gate_->RemoveQueue(state_); }
+
+void WeightedFairBatchGate::Queue::Run(
+    const std::function<void()>& process_batch) {
+  Env* env = gate_->options_.env;
+  const uint64_t wait_start_time_micros = env->NowMicros();
+  const double charged_cost_micros = gate_->Acquire(state_);
+  const uint64_t start_time_micros = env->NowMicros();
+  slot_wait_time->GetCell(state_->name)
+      ->Add(start_time_micros - wait_start_time_micros);
+
+  process_batch();
+
+  const int64_t cost_micros = env->NowMicros() - start_time_micros;
+  slot_busy_time->GetCell(state_->name)->IncrementBy(cost_micros);
+  gate_->Release(state_, charged_cost_micros, cost_micros);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
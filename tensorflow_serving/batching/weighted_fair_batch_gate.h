@@ -0,0 +1,154 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_BATCHING_WEIGHTED_FAIR_BATCH_GATE_H_
+#define TENSORFLOW_SERVING_BATCHING_WEIGHTED_FAIR_BATCH_GATE_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Shares a fixed number of batch execution slots among several batch queues,
+// typically one per model, in proportion to per-queue weights.
+//
+// A SharedBatchScheduler interleaves the batches of its queues round-robin,
+// which is fair in the number of batches but not in the time they take: a
+// model whose batches are expensive, or that has many batches queued, occupies
+// most of the batch threads and delays the batches of other models. To prevent
+// that, each batch first waits for one of 'num_slots' slots, which are handed
+// out by start-time fair queueing over the measured batch processing times. A
+// queue with weight 2 receives twice the slot time of a queue with weight 1
+// while both have batches waiting; idle queues do not bank any credit.
+//
+// Batch threads wait for a slot while holding their batch, so the batch
+// scheduler should have more threads than the gate has slots (e.g. twice as
+// many), to keep forming batches of other queues while some are waiting.
+//
+// This class is thread-safe.
+class WeightedFairBatchGate
+    : public std::enable_shared_from_this<WeightedFairBatchGate> {
+ public:
+  struct Options {
+    // The number of batches that may be processed concurrently.
+    int num_slots = 1;
+
+    // The environment to use for timing batches.
+    Env* env = Env::Default();
+  };
+
+  static Status Create(const Options& options,
+                       std::shared_ptr<WeightedFairBatchGate>* gate);
+
+  ~WeightedFairBatchGate();
+
+  class Queue;
+
+  // Registers a queue named 'name' (used to label the metrics) with 'weight',
+  // which must be positive. The queue is unregistered once 'queue' is
+  // destroyed.
+  Status AddQueue(const string& name, double weight,
+                  std::unique_ptr<Queue>* queue);
+
+  int num_slots() const { return options_.num_slots; }
+
+  // Returns the number of batches currently waiting for a slot, across all
+  // queues.
+  int NumWaitingBatches() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct QueueState {
+    string name;
+    double weight;
+
+    // The virtual time up to which the queue has been served, i.e. the sum of
+    // the (estimated) costs of its batches divided by its weight.
+    double virtual_time = 0;
+
+    // A moving average of the processing times of the queue's batches, used
+    // to charge batches when they are granted a slot.
+    double mean_cost_micros = 0;
+
+    int num_waiting = 0;
+    int num_running = 0;
+  };
+
+  explicit WeightedFairBatchGate(const Options& options);
+
+  // Blocks until 'state' is granted a slot. Returns the cost that 'state' is
+  // charged in advance for the batch.
+  double Acquire(QueueState* state) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the slot granted to 'state', whose batch took 'cost_micros', of
+  // which 'charged_cost_micros' were charged by Acquire().
+  void Release(QueueState* state, double charged_cost_micros,
+               int64_t cost_micros) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the waiting queue with the lowest virtual time, or nullptr.
+  QueueState* NextQueueToServe() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void RemoveQueue(QueueState* state) TF_LOCKS_EXCLUDED(mu_);
+
+  const Options options_;
+
+  mutable mutex mu_;
+  condition_variable slot_released_;
+
+  std::list<QueueState> queues_ TF_GUARDED_BY(mu_);
+  int num_free_slots_ TF_GUARDED_BY(mu_);
+
+  // The virtual time of the most recently served queue. Queues that become
+  // active start from here, so they neither lose out to nor overtake queues
+  // that have been busy meanwhile.
+  double system_virtual_time_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WeightedFairBatchGate);
+};
+
+// A handle to a queue registered with a WeightedFairBatchGate.
+class WeightedFairBatchGate::Queue {
+ public:
+  ~Queue();
+
+  // Waits for a slot, invokes 'process_batch' and returns the slot.
+  void Run(const std::function<void()>& process_batch);
+
+ private:
+  friend class WeightedFairBatchGate;
+
+  Queue(std::shared_ptr<WeightedFairBatchGate> gate, QueueState* state)
+      : gate_(std::move(gate)), state_(state) {}
+
+  const std::shared_ptr<WeightedFairBatchGate> gate_;
+  QueueState* const state_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Queue);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_BATCHING_WEIGHTED_FAIR_BATCH_GATE_H_
@@ -0,0 +1,120 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/batching/weighted_fair_batch_gate.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Blocks until 'num_batches' batches are waiting at 'gate'.
+void WaitForWaitingBatches(int num_batches, const WeightedFairBatchGate& gate) {
+  while (gate.NumWaitingBatches() < num_batches) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+}
+
+TEST(WeightedFairBatchGateTest, RunsBatches) {
+  std::shared_ptr<WeightedFairBatchGate> gate;
+  TF_ASSERT_OK(WeightedFairBatchGate::Create({}, &gate));
+  std::unique_ptr<WeightedFairBatchGate::Queue> queue;
+  TF_ASSERT_OK(gate->AddQueue("queue", 1.0, &queue));
+  int num_runs = 0;
+  queue->Run([&num_runs] { ++num_runs; });
+  queue->Run([&num_runs] { ++num_runs; });
+  EXPECT_EQ(2, num_runs);
+  EXPECT_EQ(0, gate->NumWaitingBatches());
+}
+
+TEST(WeightedFairBatchGateTest, ServesLeastServedQueueFirst) {
+  test_util::FakeClockEnv env(Env::Default());
+  WeightedFairBatchGate::Options options;
+  options.num_slots = 1;
+  options.env = &env;
+  std::shared_ptr<WeightedFairBatchGate> gate;
+  TF_ASSERT_OK(WeightedFairBatchGate::Create(options, &gate));
+  std::unique_ptr<WeightedFairBatchGate::Queue> hot_queue;
+  TF_ASSERT_OK(gate->AddQueue("hot", 1.0, &hot_queue));
+  std::unique_ptr<WeightedFairBatchGate::Queue> cold_queue;
+  TF_ASSERT_OK(gate->AddQueue("cold", 1.0, &cold_queue));
+
+  mutex mu;
+  std::vector<string> order;
+  auto record = [&mu, &order](const string& name) {
+    mutex_lock l(mu);
+    order.push_back(name);
+  };
+
+  // A slow batch of the hot queue occupies the only slot.
+  Notification first_batch_started;
+  Notification finish_first_batch;
+  std::unique_ptr<Thread> first_batch(Env::Default()->StartThread(
+      {}, "first_batch", [&] {
+        hot_queue->Run([&] {
+          record("hot");
+          first_batch_started.Notify();
+          finish_first_batch.WaitForNotification();
+          env.AdvanceByMicroseconds(1000);
+        });
+      }));
+  first_batch_started.WaitForNotification();
+
+  // Meanwhile, more batches of the hot queue pile up, and then one of the cold
+  // queue arrives.
+  std::vector<std::unique_ptr<Thread>> batches;
+  for (int i = 0; i < 3; ++i) {
+    batches.emplace_back(Env::Default()->StartThread(
+        {}, "hot_batch", [&] { hot_queue->Run([&] { record("hot"); }); }));
+  }
+  WaitForWaitingBatches(3, *gate);
+  batches.emplace_back(Env::Default()->StartThread(
+      {}, "cold_batch", [&] { cold_queue->Run([&] { record("cold"); }); }));
+  WaitForWaitingBatches(4, *gate);
+
+  // The cold queue has not been served yet, so it goes next.
+  finish_first_batch.Notify();
+  first_batch.reset();
+  batches.clear();
+  EXPECT_THAT(order, ElementsAre("hot", "cold", "hot", "hot", "hot"));
+}
+
+TEST(WeightedFairBatchGateTest, RejectsInvalidArguments) {
+  std::shared_ptr<WeightedFairBatchGate> gate;
+  WeightedFairBatchGate::Options options;
+  options.num_slots = 0;
+  EXPECT_FALSE(WeightedFairBatchGate::Create(options, &gate).ok());
+
+  TF_ASSERT_OK(WeightedFairBatchGate::Create({}, &gate));
+  std::unique_ptr<WeightedFairBatchGate::Queue> queue;
+  EXPECT_FALSE(gate->AddQueue("queue", 0, &queue).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
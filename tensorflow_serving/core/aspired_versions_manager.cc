@@ -16,7 +16,9 @@ limitations under the License.
 #include "tensorflow_serving/core/aspired_versions_manager.h"
 
 #include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <iterator>
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
@@ -48,11 +50,16 @@ struct Aspired {
 };
 
 // Decides which action amongst the 2 to take. We prefer an unload action over a
-// load action.
+// load action, and between two loads, the one of the servable stream with the
+// higher load priority, then the one earlier in the load order.
 //
 // Note that this returns a strict weak ordering.
 struct CompareActions {
  public:
+  CompareActions(const std::map<string, int32>& load_priorities,
+                 const std::map<string, int>& load_ranks)
+      : load_priorities_(load_priorities), load_ranks_(load_ranks) {}
+
   bool operator()(
       const absl::optional<AspiredVersionPolicy::ServableAction>& lhs,
       const absl::optional<AspiredVersionPolicy::ServableAction>& rhs) {
@@ -63,10 +70,30 @@ struct CompareActions {
       return true;
     }
     // By this point, we are sure the optionals have values.
+    if (lhs->action == AspiredVersionPolicy::Action::kLoad &&
+        rhs->action == AspiredVersionPolicy::Action::kLoad) {
+      const int32 lhs_priority = LoadPriority(lhs->id.name);
+      const int32 rhs_priority = LoadPriority(rhs->id.name);
+      if (lhs_priority != rhs_priority) {
+        return lhs_priority > rhs_priority;
+      }
+      return LoadRank(lhs->id.name) < LoadRank(rhs->id.name);
+    }
     return OrderActions(lhs.value(), rhs.value()).action != rhs.value().action;
   }
 
  private:
+  int32 LoadPriority(const string& servable_name) const {
+    const auto it = load_priorities_.find(servable_name);
+    return it == load_priorities_.end() ? 0 : it->second;
+  }
+
+  int LoadRank(const string& servable_name) const {
+    const auto it = load_ranks_.find(servable_name);
+    return it == load_ranks_.end() ? std::numeric_limits<int>::max()
+                                   : it->second;
+  }
+
   AspiredVersionPolicy::ServableAction OrderActions(
       const AspiredVersionPolicy::ServableAction& lhs,
       const AspiredVersionPolicy::ServableAction& rhs) {
@@ -80,8 +107,31 @@ struct CompareActions {
         return lhs;
     }
   }
+
+  const std::map<string, int32>& load_priorities_;
+  const std::map<string, int>& load_ranks_;
 };
 
+// Returns true if a servable in 'state' holds, or is about to hold, the
+// resources of a loaded version.
+bool IsLoadedOrInTransition(const LoaderHarness::State state) {
+  switch (state) {
+    case LoaderHarness::State::kLoadRequested:
+    case LoaderHarness::State::kLoadApproved:
+    case LoaderHarness::State::kLoading:
+    case LoaderHarness::State::kReady:
+    case LoaderHarness::State::kUnloadRequested:
+    case LoaderHarness::State::kQuiescing:
+    case LoaderHarness::State::kQuiesced:
+    case LoaderHarness::State::kUnloading:
+      return true;
+    case LoaderHarness::State::kNew:
+    case LoaderHarness::State::kDisabled:
+    case LoaderHarness::State::kError:
+      return false;
+  }
+}
+
 // Validates whether all entries in 'versions' pertain to the servable named
 // 'servable_name'.
 Status ValidateAspiredVersions(
@@ -158,11 +208,20 @@ Status AspiredVersionsManager::Create(
   basic_manager_options.resource_tracker = std::move(options.resource_tracker);
   basic_manager_options.num_load_threads = options.num_load_threads;
   basic_manager_options.num_unload_threads = options.num_unload_threads;
+  basic_manager_options.work_stealing_load_executor =
+      options.work_stealing_load_executor;
   basic_manager_options.max_num_load_retries = options.max_num_load_retries;
   basic_manager_options.load_retry_interval_micros =
       options.load_retry_interval_micros;
+  basic_manager_options.load_retry_backoff = options.load_retry_backoff;
+  basic_manager_options.load_retry_budget =
+      std::move(options.load_retry_budget);
   basic_manager_options.flush_filesystem_caches =
       options.flush_filesystem_caches;
+  basic_manager_options.use_per_thread_handle_refs =
+      options.use_per_thread_handle_refs;
+  basic_manager_options.enable_batch_load_approval =
+      options.enable_batch_load_approval;
   basic_manager_options.env = options.env;
   basic_manager_options.servable_event_bus = options.servable_event_bus;
   basic_manager_options.pre_load_hook = std::move(options.pre_load_hook);
@@ -176,6 +235,8 @@ Status AspiredVersionsManager::Create(
       options.with_current_context));
   (manager->get())->enable_reload_servables_with_error_ =
       options.enable_reload_servables_with_error;
+  (manager->get())->max_num_concurrent_version_transitions_ =
+      options.max_num_concurrent_version_transitions;
   return OkStatus();
 }
 
@@ -191,27 +252,20 @@ AspiredVersionsManager::AspiredVersionsManager(
         this->SetNumLoadThreads(num_load_threads);
       }));
   if (manage_state_interval_micros > 0) {
-    PeriodicFunction::Options pf_options;
-    pf_options.env = env;
-    pf_options.thread_name_prefix = "AspiredVersionsManager_ManageState_Thread";
+    const string thread_name = "AspiredVersionsManager_ManageState_Thread";
     if (with_current_context) {
       tensorflow::Context context(tensorflow::ContextKind::kThread);
-      manage_state_thread_.reset(new PeriodicFunction(
-          [this, context = std::move(context)]() {
+      manage_state_thread_.reset(env->StartThread(
+          {}, thread_name,
+          [this, manage_state_interval_micros, context = std::move(context)]() {
             tensorflow::WithContext wc(context);
-            this->FlushServables();
-            this->HandlePendingAspiredVersionsRequests();
-            this->InvokePolicyAndExecuteAction();
-          },
-          manage_state_interval_micros));
+            this->RunManageStateLoop(manage_state_interval_micros);
+          }));
     } else {
-      manage_state_thread_.reset(new PeriodicFunction(
-          [this]() {
-            this->FlushServables();
-            this->HandlePendingAspiredVersionsRequests();
-            this->InvokePolicyAndExecuteAction();
-          },
-          manage_state_interval_micros));
+      manage_state_thread_.reset(env->StartThread(
+          {}, thread_name, [this, manage_state_interval_micros]() {
+            this->RunManageStateLoop(manage_state_interval_micros);
+          }));
     }
   }
 }
@@ -221,10 +275,44 @@ AspiredVersionsManager::~AspiredVersionsManager() {
   // tearing down any other manager state.
   target_impl_.reset();
 
+  {
+    mutex_lock l(manage_state_mu_);
+    stop_manage_state_ = true;
+    manage_state_cv_.notify_all();
+  }
   // This will wait till the thread is joined.
   manage_state_thread_.reset();
 }
 
+void AspiredVersionsManager::RunManageStateLoop(
+    const int64_t manage_state_interval_micros) {
+  while (true) {
+    {
+      mutex_lock l(manage_state_mu_);
+      if (!manage_state_requested_ && !stop_manage_state_) {
+        manage_state_cv_.wait_for(
+            l, std::chrono::microseconds(manage_state_interval_micros));
+      }
+      if (stop_manage_state_) {
+        return;
+      }
+      manage_state_requested_ = false;
+    }
+    FlushServables();
+    HandlePendingAspiredVersionsRequests();
+    if (InvokePolicyAndExecuteAction()) {
+      // The policy may have more actions to take, e.g. in other streams.
+      WakeManageStateThread();
+    }
+  }
+}
+
+void AspiredVersionsManager::WakeManageStateThread() {
+  mutex_lock l(manage_state_mu_);
+  manage_state_requested_ = true;
+  manage_state_cv_.notify_all();
+}
+
 std::vector<ServableId> AspiredVersionsManager::ListAvailableServableIds()
     const {
   return basic_manager_->ListAvailableServableIds();
@@ -264,6 +352,7 @@ void AspiredVersionsManager::EnqueueAspiredVersionsRequest(
     pending_aspired_versions_requests_[string(servable_name)] =
         std::move(versions);
   }
+  WakeManageStateThread();
 }
 
 void AspiredVersionsManager::ProcessAspiredVersionsRequest(
@@ -370,21 +459,58 @@ bool AspiredVersionsManager::ContainsAnyReaspiredVersions(
 absl::optional<AspiredVersionPolicy::ServableAction>
 AspiredVersionsManager::GetNextAction() {
   std::vector<absl::optional<AspiredVersionPolicy::ServableAction>> actions;
+  // A stream is in a version transition while more than one of its versions
+  // holds resources. The indices of the load actions that would start one.
+  int num_streams_in_transition = 0;
+  std::vector<int> transition_starting_loads;
   for (const string& servable_name :
        basic_manager_->GetManagedServableNames()) {
     std::vector<AspiredServableStateSnapshot> aspired_state_snapshots;
+    int num_loaded_versions = 0;
     for (const ServableStateSnapshot<Aspired>& state_snapshot :
          basic_manager_->GetManagedServableStateSnapshots<Aspired>(
              servable_name)) {
       aspired_state_snapshots.push_back(
           {state_snapshot.id, state_snapshot.state,
            state_snapshot.additional_state->is_aspired});
+      if (IsLoadedOrInTransition(state_snapshot.state)) {
+        ++num_loaded_versions;
+      }
+    }
+    if (num_loaded_versions > 1) {
+      ++num_streams_in_transition;
     }
     actions.emplace_back(
         aspired_version_policy_->GetNextAction(aspired_state_snapshots));
+    if (actions.back() &&
+        actions.back()->action == AspiredVersionPolicy::Action::kLoad &&
+        num_loaded_versions == 1) {
+      transition_starting_loads.push_back(actions.size() - 1);
+    }
+  }
+  if (max_num_concurrent_version_transitions_ > 0) {
+    // Hold back the loads that would start a transition, beyond the limit.
+    // They are reconsidered once a transition ends, with an unload.
+    int num_transitions_to_start = std::max(
+        0, static_cast<int>(max_num_concurrent_version_transitions_) -
+               num_streams_in_transition);
+    for (const int index : transition_starting_loads) {
+      if (num_transitions_to_start > 0) {
+        --num_transitions_to_start;
+      } else {
+        VLOG(1) << "Postponing " << actions[index]->DebugString()
+                << " since " << num_streams_in_transition
+                << " version transitions are in progress";
+        actions[index] = absl::nullopt;
+      }
+    }
   }
 
-  std::sort(actions.begin(), actions.end(), CompareActions());
+  {
+    mutex_lock l(load_priorities_mu_);
+    std::sort(actions.begin(), actions.end(),
+              CompareActions(load_priorities_, load_ranks_));
+  }
   const absl::optional<AspiredVersionPolicy::ServableAction> next_action =
       !actions.empty() ? actions[0] : absl::nullopt;
   if (next_action) {
@@ -397,20 +523,26 @@ void AspiredVersionsManager::PerformAction(
     const AspiredVersionPolicy::ServableAction action) {
   switch (action.action) {
     case AspiredVersionPolicy::Action::kLoad: {
-      basic_manager_->LoadServable(action.id, [action](const Status& status) {
-        if (!status.ok()) {
-          LOG(ERROR) << "Servable " << action.id.DebugString()
-                     << " cannot be loaded: " << status;
-        }
-      });
+      basic_manager_->LoadServable(
+          action.id, [this, action](const Status& status) {
+            if (!status.ok()) {
+              LOG(ERROR) << "Servable " << action.id.DebugString()
+                         << " cannot be loaded: " << status;
+            }
+            // The load may enable the next transition, e.g. the unload of the
+            // version it replaces.
+            WakeManageStateThread();
+          });
     } break;
     case AspiredVersionPolicy::Action::kUnload: {
-      basic_manager_->UnloadServable(action.id, [action](const Status& status) {
-        if (!status.ok()) {
-          LOG(ERROR) << "Servable " << action.id.DebugString()
-                     << " cannot be unloaded: " << status;
-        }
-      });
+      basic_manager_->UnloadServable(
+          action.id, [this, action](const Status& status) {
+            if (!status.ok()) {
+              LOG(ERROR) << "Servable " << action.id.DebugString()
+                         << " cannot be unloaded: " << status;
+            }
+            WakeManageStateThread();
+          });
     } break;
   }
 }
@@ -470,17 +602,39 @@ void AspiredVersionsManager::HandlePendingAspiredVersionsRequests() {
   }
 }
 
-void AspiredVersionsManager::InvokePolicyAndExecuteAction() {
+bool AspiredVersionsManager::InvokePolicyAndExecuteAction() {
   mutex_lock l(basic_manager_read_modify_write_mu_);
 
   const absl::optional<AspiredVersionPolicy::ServableAction> next_action =
       GetNextAction();
   if (!next_action) {
-    return;
+    return false;
   }
   // NOTE: we could do action validation here.
 
   PerformAction(*next_action);
+  return true;
+}
+
+void AspiredVersionsManager::SetLoadPriorities(
+    std::map<string, int32> load_priorities) {
+  mutex_lock l(load_priorities_mu_);
+  load_priorities_ = std::move(load_priorities);
+}
+
+void AspiredVersionsManager::SetLoadOrder(
+    const std::vector<string>& load_order) {
+  std::map<string, int> load_ranks;
+  for (int i = 0; i < load_order.size(); ++i) {
+    load_ranks.emplace(load_order[i], i);
+  }
+  mutex_lock l(load_priorities_mu_);
+  load_ranks_ = std::move(load_ranks);
+}
+
+void AspiredVersionsManager::SetLoadRetryPolicies(
+    std::map<string, BasicManager::LoadRetryPolicy> load_retry_policies) {
+  basic_manager_->SetLoadRetryPolicies(std::move(load_retry_policies));
 }
 
 void AspiredVersionsManager::SetNumLoadThreads(const uint32 num_load_threads) {
@@ -16,13 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_CORE_ASPIRED_VERSIONS_MANAGER_H_
 #define TENSORFLOW_SERVING_CORE_ASPIRED_VERSIONS_MANAGER_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "absl/types/optional.h"
-#include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/hash/hash.h"
@@ -97,6 +97,12 @@ class AspiredVersionsManager : public Manager,
     /// The periodicity, in microseconds, of the thread which manages the state
     /// of the servables. Default: 100 milliseconds. If this is set less than or
     /// equal to 0, we don't run this thread at all.
+    ///
+    /// The thread also runs as soon as an aspired-versions request comes in
+    /// and whenever a load or unload finishes, and right away again after each
+    /// action it takes, so that version transitions don't wait for the next
+    /// period. The period only bounds the delay of transitions that no such
+    /// event triggers, e.g. retries of postponed requests.
     int64_t manage_state_interval_micros = 100 * 1000;
 
     /// EventBus to publish servable state changes. This is optional, if unset,
@@ -118,6 +124,10 @@ class AspiredVersionsManager : public Manager,
     /// performed serially in the manager's main work loop.
     uint32 num_unload_threads = 0;
 
+    /// Whether the load thread-pool is a WorkStealingExecutor, rather than a
+    /// single-queue thread-pool.
+    bool work_stealing_load_executor = false;
+
     /// Maximum number of times we retry loading a servable, after the first
     /// failure, before we give up.
     uint32 max_num_load_retries = 5;
@@ -127,12 +137,26 @@ class AspiredVersionsManager : public Manager,
     /// Default: 1 minute.
     int64_t load_retry_interval_micros = 1LL * 60 * 1000 * 1000;
 
+    /// How the interval between load retries grows, and the budget the load
+    /// retries of all servables are taken from, if any. See
+    /// BasicManager::Options.
+    RetryBackoff load_retry_backoff;
+    std::shared_ptr<RetryBudget> load_retry_budget;
+
     // If true, and there are not multiple load threads, filesystem caches will
     // be flushed after each servable is loaded. (Cache flush is skipped when
     // multiple load threads are active, in order to avoid setting back a
     // concurrent load on another thread.)
     bool flush_filesystem_caches = false;
 
+    // If true, servable handles are reference counted per thread that gets
+    // them, instead of per CPU. See BasicManager::Options.
+    bool use_per_thread_handle_refs = false;
+
+    // If true, loads are approved in batches, packed against the resource
+    // tracker's budget. See BasicManager::Options.
+    bool enable_batch_load_approval = false;
+
     /// The environment to use for starting threads in the thread-pool or for
     /// sleeping.
     Env* env = Env::Default();
@@ -145,6 +169,15 @@ class AspiredVersionsManager : public Manager,
     // future attempts at reload to progress.
     bool enable_reload_servables_with_error = false;
 
+    // The maximum number of servable streams that may be in a version
+    // transition at the same time, i.e. have more than one version loaded or
+    // loading. Loads that would start a transition beyond this number are held
+    // back until another transition ends. This bounds the peak memory of
+    // swapping versions of many streams at once, e.g. at a periodic refresh of
+    // large models. Loads of streams with no loaded version are not limited.
+    // If set to 0, the number is unbounded.
+    uint32 max_num_concurrent_version_transitions = 0;
+
     // If true, the AspiredVersionsManager will propagate its current context to
     // the newly created periodic functions.
     bool with_current_context = false;
@@ -212,6 +245,26 @@ class AspiredVersionsManager : public Manager,
   Source<std::unique_ptr<Loader>>::AspiredVersionsCallback
   GetAspiredVersionsCallback() override;
 
+  /// Sets the load priorities of servable streams, by name. When versions of
+  /// several streams are to be loaded, those of the streams with higher
+  /// priorities are loaded first, e.g. to make important models available
+  /// early at startup. Streams not in 'load_priorities' have priority 0.
+  /// Unloads still take precedence over all loads.
+  void SetLoadPriorities(std::map<string, int32> load_priorities)
+      TF_LOCKS_EXCLUDED(load_priorities_mu_);
+
+  /// Sets the order in which to load the versions of servable streams of the
+  /// same load priority, e.g. the order in which they were loaded before a
+  /// restart. Streams earlier in 'load_order' are loaded first, and streams
+  /// not in it after those that are.
+  void SetLoadOrder(const std::vector<string>& load_order)
+      TF_LOCKS_EXCLUDED(load_priorities_mu_);
+
+  /// Sets the load retry policies of servable streams, by name. See
+  /// BasicManager::SetLoadRetryPolicies().
+  void SetLoadRetryPolicies(
+      std::map<string, BasicManager::LoadRetryPolicy> load_retry_policies);
+
  private:
   friend class internal::AspiredVersionsManagerTargetImpl;
   friend class test_util::AspiredVersionsManagerTestAccess;
@@ -278,10 +331,21 @@ class AspiredVersionsManager : public Manager,
                         pending_aspired_versions_requests_mu_);
 
   // Invokes the aspired-version policy and executes any returned policy action.
-  // This method is intended to be invoked periodically.
-  void InvokePolicyAndExecuteAction()
+  // This method is intended to be invoked periodically. Returns true iff an
+  // action was executed.
+  bool InvokePolicyAndExecuteAction()
       TF_LOCKS_EXCLUDED(basic_manager_read_modify_write_mu_);
 
+  // Runs FlushServables(), HandlePendingAspiredVersionsRequests() and
+  // InvokePolicyAndExecuteAction() whenever the manage-state thread is woken
+  // up, or 'manage_state_interval_micros' have passed, until the manager is
+  // destroyed.
+  void RunManageStateLoop(int64_t manage_state_interval_micros)
+      TF_LOCKS_EXCLUDED(manage_state_mu_);
+
+  // Wakes up the manage-state thread, if any.
+  void WakeManageStateThread() TF_LOCKS_EXCLUDED(manage_state_mu_);
+
   // Sets the number of load threads.
   //
   // We immediately block all new load requests while the current executor is
@@ -309,9 +373,22 @@ class AspiredVersionsManager : public Manager,
   // the set of managed servables and their state (in particular, aspiredness).
   mutable mutex basic_manager_read_modify_write_mu_;
 
-  // Periodically runs HandlePendingAspiredVersionsRequests() and
-  // InvokePolicyAndExecuteAction() in a background thread.
-  std::unique_ptr<PeriodicFunction> manage_state_thread_;
+  // The load priorities of servable streams. See SetLoadPriorities().
+  std::map<string, int32> load_priorities_ TF_GUARDED_BY(load_priorities_mu_);
+  // The position of each stream in the load order. See SetLoadOrder().
+  std::map<string, int> load_ranks_ TF_GUARDED_BY(load_priorities_mu_);
+  mutable mutex load_priorities_mu_;
+
+  // Used to wake up and stop the manage-state thread. These are declared before
+  // 'basic_manager_', so that load and unload callbacks may still use them
+  // while it is destroyed.
+  mutex manage_state_mu_;
+  condition_variable manage_state_cv_;
+  bool manage_state_requested_ TF_GUARDED_BY(manage_state_mu_) = false;
+  bool stop_manage_state_ TF_GUARDED_BY(manage_state_mu_) = false;
+
+  // Runs RunManageStateLoop() in the background.
+  std::unique_ptr<Thread> manage_state_thread_;
 
   // The object that implements the Target API on behalf of this manager.
   std::unique_ptr<TargetBase<std::unique_ptr<Loader>>> target_impl_;
@@ -327,6 +404,9 @@ class AspiredVersionsManager : public Manager,
   // future attempts at reload to progress.
   bool enable_reload_servables_with_error_ = false;
 
+  // See Options::max_num_concurrent_version_transitions.
+  uint32 max_num_concurrent_version_transitions_ = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(AspiredVersionsManager);
 };
 
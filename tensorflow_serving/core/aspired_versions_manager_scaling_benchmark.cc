@@ -0,0 +1,302 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of how AspiredVersionsManager scales with the number of servables
+// it manages: handle lookups, version churn (each version swap loads a version
+// and unloads one, and so updates the serving map twice), ServableStateMonitor
+// event handling, and memory per servable, at 1k to 10k servable streams.
+//
+// Run with:
+// bazel run -c opt --dynamic_mode=off \
+// tensorflow_serving/core:aspired_versions_manager_scaling_benchmark --
+// --benchmarks=.
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/kernels/batching_util/periodic_function.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow_serving/core/aspired_versions_manager.h"
+#include "tensorflow_serving/core/availability_preserving_policy.h"
+#include "tensorflow_serving/core/loader.h"
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/core/servable_handle.h"
+#include "tensorflow_serving/core/servable_state.h"
+#include "tensorflow_serving/core/servable_state_monitor.h"
+#include "tensorflow_serving/core/simple_loader.h"
+#include "tensorflow_serving/core/source.h"
+#include "tensorflow_serving/core/test_util/manager_test_util.h"
+#include "tensorflow_serving/util/event_bus.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr char kServableName[] = "kServableName";
+
+// Returns the resident memory of the process, or 0 where unknown.
+int64_t ResidentBytes() {
+#if defined(__linux__)
+  FILE* const statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+  long total_pages, resident_pages;  // NOLINT(runtime/int)
+  const int num_read = fscanf(statm, "%ld %ld", &total_pages, &resident_pages);
+  fclose(statm);
+  return num_read == 2 ? int64_t{resident_pages} * sysconf(_SC_PAGESIZE) : 0;
+#else
+  return 0;
+#endif
+}
+
+std::unique_ptr<Loader> CreateLoader(const int64_t version) {
+  return std::unique_ptr<Loader>(new SimpleLoader<int64_t>(
+      [version](std::unique_ptr<int64_t>* const servable) {
+        servable->reset(new int64_t(version));
+        return OkStatus();
+      },
+      SimpleLoader<int64_t>::EstimateNoResources()));
+}
+
+// A manager serving one version each of 'num_servables' servable streams,
+// whose policy actions are run by the benchmarks rather than a thread.
+class ScaledManager {
+ public:
+  ScaledManager(const int num_servables, const bool monitored)
+      : bus_(EventBus<ServableState>::CreateEventBus()) {
+    const int64_t resident_bytes_before = ResidentBytes();
+    if (monitored) {
+      monitor_.reset(new ServableStateMonitor(bus_.get()));
+    }
+    AspiredVersionsManager::Options options;
+    options.manage_state_interval_micros = -1;
+    options.aspired_version_policy.reset(new AvailabilityPreservingPolicy());
+    options.servable_event_bus = bus_.get();
+    TF_CHECK_OK(AspiredVersionsManager::Create(std::move(options), &manager_));
+    aspired_versions_callback_ = manager_->GetAspiredVersionsCallback();
+
+    for (int i = 0; i < num_servables; ++i) {
+      names_.push_back(strings::StrCat(kServableName, i));
+      versions_.push_back(0);
+      Aspire(i);
+    }
+    test_util::AspiredVersionsManagerTestAccess manager_access(manager_.get());
+    manager_access.HandlePendingAspiredVersionsRequests();
+    // Each policy action loads one servable.
+    for (int i = 0; i < num_servables; ++i) {
+      manager_access.InvokePolicyAndExecuteAction();
+    }
+    CHECK_EQ(num_servables, manager_->ListAvailableServableIds().size());
+    bytes_per_servable_ =
+        static_cast<double>(ResidentBytes() - resident_bytes_before) /
+        num_servables;
+  }
+
+  AspiredVersionsManager* manager() { return manager_.get(); }
+  const std::vector<string>& names() const { return names_; }
+  double bytes_per_servable() const { return bytes_per_servable_; }
+
+  // Replaces the version of servable stream 'index' with the next one, as a
+  // source would on finding a new version, and runs the resulting load and
+  // unload.
+  void SwapVersion(const int index) {
+    ++versions_[index];
+    Aspire(index);
+    test_util::AspiredVersionsManagerTestAccess manager_access(manager_.get());
+    manager_access.HandlePendingAspiredVersionsRequests();
+    manager_access.InvokePolicyAndExecuteAction();
+    manager_access.InvokePolicyAndExecuteAction();
+    manager_access.FlushServables();
+  }
+
+ private:
+  void Aspire(const int index) {
+    std::vector<ServableData<std::unique_ptr<Loader>>> versions;
+    versions.push_back({{names_[index], versions_[index]},
+                        CreateLoader(versions_[index])});
+    aspired_versions_callback_(names_[index], std::move(versions));
+  }
+
+  std::shared_ptr<EventBus<ServableState>> bus_;
+  std::unique_ptr<ServableStateMonitor> monitor_;
+  std::unique_ptr<AspiredVersionsManager> manager_;
+  Source<std::unique_ptr<Loader>>::AspiredVersionsCallback
+      aspired_versions_callback_;
+  std::vector<string> names_;
+  std::vector<int64_t> versions_;
+  double bytes_per_servable_ = 0;
+};
+
+// Returns the manager of 'num_servables' servables, creating it on first use,
+// as loading thousands of servables takes a while.
+ScaledManager* GetScaledManager(const int num_servables, const bool monitored) {
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* const managers =
+      new std::map<std::pair<int, bool>, std::unique_ptr<ScaledManager>>();
+  mutex_lock l(mu);
+  std::unique_ptr<ScaledManager>& manager =
+      (*managers)[{num_servables, monitored}];
+  if (manager == nullptr) {
+    manager.reset(new ScaledManager(num_servables, monitored));
+  }
+  return manager.get();
+}
+
+// Returns the indices of the servable streams to pick, at random.
+std::vector<int> RandomIndices(const int num_servables) {
+  random::PhiloxRandom philox(testing::RandomSeed());
+  random::SimplePhilox random(&philox);
+  std::vector<int> indices;
+  for (int i = 0; i < 1024; ++i) {
+    indices.push_back(random.Uniform(num_servables));
+  }
+  return indices;
+}
+
+// Arguments: (servable streams).
+void BM_GetServableHandle(::testing::benchmark::State& state) {
+  ScaledManager* const scaled_manager =
+      GetScaledManager(state.range(0), /*monitored=*/false);
+  std::vector<ServableRequest> requests;
+  for (const int index : RandomIndices(state.range(0))) {
+    requests.push_back(ServableRequest::Latest(scaled_manager->names()[index]));
+  }
+  ServableHandle<int64_t> handle;
+  int i = 0;
+  for (auto s : state) {
+    TF_CHECK_OK(scaled_manager->manager()->GetServableHandle(
+        requests[i++ % requests.size()], &handle));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["bytes_per_servable"] = scaled_manager->bytes_per_servable();
+}
+BENCHMARK(BM_GetServableHandle)
+    ->Arg(1000)
+    ->Arg(3000)
+    ->Arg(10000)
+    ->UseRealTime()
+    ->ThreadRange(1, 16);
+
+// Arguments: (servable streams, whether a ServableStateMonitor is attached).
+void BM_VersionChurn(::testing::benchmark::State& state) {
+  ScaledManager* const scaled_manager =
+      GetScaledManager(state.range(0), state.range(1));
+  const std::vector<int> indices = RandomIndices(state.range(0));
+  int i = 0;
+  for (auto s : state) {
+    scaled_manager->SwapVersion(indices[i++ % indices.size()]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_VersionChurn)
+    ->ArgPair(1000, false)
+    ->ArgPair(1000, true)
+    ->ArgPair(3000, false)
+    ->ArgPair(3000, true)
+    ->ArgPair(10000, false)
+    ->ArgPair(10000, true);
+
+// Lookups while a version is swapped every millisecond, so that the serving
+// map is updated under the readers. Arguments: (servable streams).
+void BM_GetServableHandleWithChurn(::testing::benchmark::State& state) {
+  ScaledManager* const scaled_manager =
+      GetScaledManager(state.range(0), /*monitored=*/false);
+  std::vector<ServableRequest> requests;
+  const std::vector<int> indices = RandomIndices(state.range(0));
+  for (const int index : indices) {
+    requests.push_back(ServableRequest::Latest(scaled_manager->names()[index]));
+  }
+  static PeriodicFunction* churn_thread = nullptr;
+  if (state.thread_index() == 0) {
+    PeriodicFunction::Options options;
+    options.thread_name_prefix = "ScalingBenchmark_Churn_Thread";
+    churn_thread = new PeriodicFunction(
+        [scaled_manager, indices, i = 0]() mutable {
+          scaled_manager->SwapVersion(indices[i++ % indices.size()]);
+        },
+        /*interval_micros=*/1000, options);
+  }
+  ServableHandle<int64_t> handle;
+  int i = 0;
+  for (auto s : state) {
+    TF_CHECK_OK(scaled_manager->manager()->GetServableHandle(
+        requests[i++ % requests.size()], &handle));
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete churn_thread;
+    churn_thread = nullptr;
+  }
+}
+BENCHMARK(BM_GetServableHandleWithChurn)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->UseRealTime()
+    ->ThreadRange(1, 16);
+
+// The cost to a ServableStateMonitor of an event, when it tracks the states of
+// many servables. Arguments: (servable streams).
+void BM_ServableStateMonitorEvent(::testing::benchmark::State& state) {
+  auto bus = EventBus<ServableState>::CreateEventBus();
+  ServableStateMonitor monitor(bus.get());
+  const int num_servables = state.range(0);
+  for (int i = 0; i < num_servables; ++i) {
+    bus->Publish({{strings::StrCat(kServableName, i), 0},
+                  ServableState::ManagerState::kAvailable,
+                  OkStatus()});
+  }
+  const std::vector<int> indices = RandomIndices(num_servables);
+  int i = 0;
+  for (auto s : state) {
+    const int index = indices[i % indices.size()];
+    // Alternates each servable between loading and available, so that the
+    // number of tracked servables stays the same.
+    bus->Publish({{strings::StrCat(kServableName, index), 0},
+                  (i / indices.size()) % 2 == 0
+                      ? ServableState::ManagerState::kLoading
+                      : ServableState::ManagerState::kAvailable,
+                  OkStatus()});
+    ++i;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ServableStateMonitorEvent)->Arg(1000)->Arg(3000)->Arg(10000);
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  tensorflow::testing::RunBenchmarks();
+  return 0;
+}
@@ -689,6 +689,64 @@ TEST_P(AspiredVersionsManagerTest, ManagerPrefersUnloadOverLoad) {
   EXPECT_EQ(2, *found_2_handle);
 }
 
+// Between loads of different servable streams, the manager prefers the stream
+// with the higher load priority.
+TEST_P(AspiredVersionsManagerTest, ManagerPrefersLoadsOfHigherPriority) {
+  manager_->SetLoadPriorities({{string(kServableName2), 1}});
+  for (const StringPiece servable_name : {kServableName, kServableName2}) {
+    std::vector<ServableData<std::unique_ptr<Loader>>> aspired_versions;
+    for (int i = 0; i <= kNumVersionsPerServable; ++i) {
+      aspired_versions.push_back(
+          CreateAspiredVersion({string(servable_name), i}));
+    }
+    manager_->GetAspiredVersionsCallback()(servable_name,
+                                           std::move(aspired_versions));
+    HandlePendingAspiredVersionsRequests();
+  }
+
+  // Both streams have a version to load, and the second one goes first.
+  InvokePolicyAndExecuteAction();
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor_, {kServableName2, kNumVersionsPerServable},
+      {ServableState::ManagerState::kAvailable});
+  ServableHandle<int64_t> handle;
+  const Status status = manager_->GetServableHandle(
+      ServableRequest::Specific(kServableName, kNumVersionsPerServable),
+      &handle);
+  EXPECT_EQ(error::NOT_FOUND, status.code());
+
+  InvokePolicyAndExecuteAction();
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor_, {kServableName, kNumVersionsPerServable},
+      {ServableState::ManagerState::kAvailable});
+}
+
+// Between loads of servable streams of the same priority, the manager follows
+// the load order.
+TEST_P(AspiredVersionsManagerTest, ManagerFollowsLoadOrder) {
+  manager_->SetLoadOrder({string(kServableName2), string(kServableName)});
+  for (const StringPiece servable_name : {kServableName, kServableName2}) {
+    std::vector<ServableData<std::unique_ptr<Loader>>> aspired_versions;
+    for (int i = 0; i <= kNumVersionsPerServable; ++i) {
+      aspired_versions.push_back(
+          CreateAspiredVersion({string(servable_name), i}));
+    }
+    manager_->GetAspiredVersionsCallback()(servable_name,
+                                           std::move(aspired_versions));
+    HandlePendingAspiredVersionsRequests();
+  }
+
+  InvokePolicyAndExecuteAction();
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor_, {kServableName2, kNumVersionsPerServable},
+      {ServableState::ManagerState::kAvailable});
+  ServableHandle<int64_t> handle;
+  const Status status = manager_->GetServableHandle(
+      ServableRequest::Specific(kServableName, kNumVersionsPerServable),
+      &handle);
+  EXPECT_EQ(error::NOT_FOUND, status.code());
+}
+
 // Test to ensure the manager doesn't try to load or serve an incoming erroneous
 // aspired-version entry.
 TEST_P(AspiredVersionsManagerTest, ErroneousAspiredVersion) {
@@ -905,6 +963,118 @@ TEST_P(AspiredVersionsManagerTest, NoEventBus) {
   HandlePendingAspiredVersionsRequests();
 }
 
+// Tests that the manage-state thread runs on aspired-versions requests and on
+// load and unload completions, rather than only once per interval.
+TEST(AspiredVersionsManagerEventsTest, TransitionsDoNotWaitForInterval) {
+  std::shared_ptr<EventBus<ServableState>> servable_event_bus =
+      EventBus<ServableState>::CreateEventBus();
+  ServableStateMonitor servable_state_monitor(servable_event_bus.get());
+  AspiredVersionsManager::Options options;
+  // Longer than the test is allowed to run.
+  options.manage_state_interval_micros = 24LL * 60 * 60 * 1000 * 1000;
+  options.servable_event_bus = servable_event_bus.get();
+  options.env = Env::Default();
+  options.aspired_version_policy.reset(new AvailabilityPreservingPolicy());
+  options.num_load_threads = 1;
+  options.num_unload_threads = 1;
+  std::unique_ptr<AspiredVersionsManager> manager;
+  TF_ASSERT_OK(AspiredVersionsManager::Create(std::move(options), &manager));
+
+  const ServableId id_1 = {kServableName, 1};
+  std::vector<ServableData<std::unique_ptr<Loader>>> aspired_versions_1;
+  aspired_versions_1.push_back(
+      {id_1, std::unique_ptr<Loader>(new FakeLoader(1))});
+  manager->GetAspiredVersionsCallback()(kServableName,
+                                        std::move(aspired_versions_1));
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor, id_1, {ServableState::ManagerState::kAvailable});
+
+  // Swapping versions takes a load, and then an unload, in successive runs.
+  const ServableId id_2 = {kServableName, 2};
+  std::vector<ServableData<std::unique_ptr<Loader>>> aspired_versions_2;
+  aspired_versions_2.push_back(
+      {id_2, std::unique_ptr<Loader>(new FakeLoader(2))});
+  manager->GetAspiredVersionsCallback()(kServableName,
+                                        std::move(aspired_versions_2));
+  WaitUntilServableManagerStateIsOneOf(servable_state_monitor, id_1,
+                                       {ServableState::ManagerState::kEnd});
+  EXPECT_EQ(ServableState::ManagerState::kAvailable,
+            servable_state_monitor.GetState(id_2)->manager_state);
+}
+
+TEST(AspiredVersionsManagerTransitionsTest, LimitsConcurrentTransitions) {
+  std::shared_ptr<EventBus<ServableState>> servable_event_bus =
+      EventBus<ServableState>::CreateEventBus();
+  ServableStateMonitor servable_state_monitor(servable_event_bus.get());
+  AspiredVersionsManager::Options options;
+  // The state manager thread won't be run automatically.
+  options.manage_state_interval_micros = -1;
+  options.servable_event_bus = servable_event_bus.get();
+  options.env = Env::Default();
+  options.aspired_version_policy.reset(new AvailabilityPreservingPolicy());
+  options.num_load_threads = 1;
+  options.max_num_concurrent_version_transitions = 1;
+  std::unique_ptr<AspiredVersionsManager> manager;
+  TF_ASSERT_OK(AspiredVersionsManager::Create(std::move(options), &manager));
+  test_util::AspiredVersionsManagerTestAccess manager_test_access(
+      manager.get());
+
+  const auto set_aspired_version = [&](const ServableId& id,
+                                       std::unique_ptr<Loader> loader) {
+    std::vector<ServableData<std::unique_ptr<Loader>>> aspired_versions;
+    aspired_versions.push_back({id, std::move(loader)});
+    manager->GetAspiredVersionsCallback()(id.name,
+                                          std::move(aspired_versions));
+  };
+  const ServableId id_1_1 = {kServableName, 1};
+  const ServableId id_1_2 = {kServableName, 2};
+  const ServableId id_2_1 = {kServableName2, 1};
+  const ServableId id_2_2 = {kServableName2, 2};
+
+  // Initial loads aren't transitions, and aren't limited.
+  set_aspired_version(id_1_1, std::unique_ptr<Loader>(new FakeLoader(1)));
+  set_aspired_version(id_2_1, std::unique_ptr<Loader>(new FakeLoader(1)));
+  manager_test_access.HandlePendingAspiredVersionsRequests();
+  manager_test_access.InvokePolicyAndExecuteAction();
+  manager_test_access.InvokePolicyAndExecuteAction();
+  for (const ServableId& id : {id_1_1, id_2_1}) {
+    WaitUntilServableManagerStateIsOneOf(
+        servable_state_monitor, id, {ServableState::ManagerState::kAvailable});
+  }
+
+  // The first stream's new version takes a while to load.
+  Notification finish_load;
+  test_util::MockLoader* loader = new NiceMock<test_util::MockLoader>;
+  ON_CALL(*loader, LoadWithMetadata(_))
+      .WillByDefault(InvokeWithoutArgs([&finish_load]() {
+        finish_load.WaitForNotification();
+        return OkStatus();
+      }));
+  set_aspired_version(id_1_2, std::unique_ptr<Loader>(loader));
+  set_aspired_version(id_2_2, std::unique_ptr<Loader>(new FakeLoader(2)));
+  manager_test_access.HandlePendingAspiredVersionsRequests();
+  manager_test_access.InvokePolicyAndExecuteAction();
+
+  // While it is in transition, the second stream's new version isn't loaded.
+  manager_test_access.InvokePolicyAndExecuteAction();
+  EXPECT_EQ(ServableState::ManagerState::kStart,
+            servable_state_monitor.GetState(id_2_2)->manager_state);
+
+  // Once the first stream's old version is unloaded, the second stream can
+  // swap versions.
+  finish_load.Notify();
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor, id_1_2,
+      {ServableState::ManagerState::kAvailable});
+  manager_test_access.InvokePolicyAndExecuteAction();
+  WaitUntilServableManagerStateIsOneOf(servable_state_monitor, id_1_1,
+                                       {ServableState::ManagerState::kEnd});
+  manager_test_access.InvokePolicyAndExecuteAction();
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor, id_2_2,
+      {ServableState::ManagerState::kAvailable});
+}
+
 TEST_P(AspiredVersionsManagerTest, RetryOnLoadErrorFinallySucceeds) {
   CHECK_GE(max_num_load_retries_, 1);
   const ServableId id = {kServableName, 7};
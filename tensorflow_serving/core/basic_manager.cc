@@ -28,12 +28,16 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow_serving/core/load_profile.h"
 #include "tensorflow_serving/core/servable_handle.h"
 #include "tensorflow_serving/core/source.h"
-#include "tensorflow_serving/util/hash.h"
+#include "tensorflow_serving/resources/resource_values.h"
+#include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/util/inline_executor.h"
+#include "tensorflow_serving/util/memory_accounting.h"
 #include "tensorflow_serving/util/retrier.h"
 #include "tensorflow_serving/util/threadpool_executor.h"
+#include "tensorflow_serving/util/work_stealing_executor.h"
 
 namespace tensorflow {
 namespace serving {
@@ -42,82 +46,93 @@ namespace {
 
 std::unique_ptr<Executor> CreateExecutor(Env* const env,
                                          const uint32 num_threads,
-                                         const string& threadpool_name) {
+                                         const string& threadpool_name,
+                                         const bool work_stealing = false) {
   std::unique_ptr<Executor> executor;
   if (num_threads == 0) {
     executor.reset(new InlineExecutor());
+  } else if (work_stealing) {
+    executor.reset(new WorkStealingExecutor(env, threadpool_name, num_threads));
   } else {
     executor.reset(new ThreadPoolExecutor(env, threadpool_name, num_threads));
   }
   return executor;
 }
 
-}  // namespace
+// A servable handle given out by a ServingMap, which its thread caches to give
+// out again. The loader is held weakly, so that the cache doesn't delay
+// unloading.
+struct CachedServableHandle {
+  uint64_t serving_map_id;
+  uint64_t generation;
+  ServableRequest request;
+  ServableId id;
+  uint64_t load_generation;
+  std::weak_ptr<Loader> loader;
+};
 
-struct BasicManager::ServingMap::EqRequest {
-  bool operator()(const ServableRequest& lhs,
-                  const ServableRequest& rhs) const {
-    if (lhs.version != rhs.version) {
-      return false;
-    }
-    if (lhs.auto_version_policy != rhs.auto_version_policy) {
-      return false;
+// The number of handles each thread caches, over all serving maps.
+constexpr int kMaxCachedServableHandlesPerThread = 8;
+
+std::vector<CachedServableHandle>* ThreadCachedServableHandles() {
+  thread_local std::vector<CachedServableHandle> cached_handles;
+  return &cached_handles;
+}
+
+bool EqualServableRequests(const ServableRequest& lhs,
+                           const ServableRequest& rhs) {
+  return lhs.name == rhs.name && lhs.version == rhs.version &&
+         lhs.auto_version_policy == rhs.auto_version_policy;
+}
+
+uint64_t NextServingMapId() {
+  static std::atomic<uint64_t> next_id{0};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Reports the RAM that 'loader' estimates its loaded servable 'id' to take, by
+// device, for the memory breakdown (see SetServableMemory()).
+void AccountServableMemory(const ServableId& id, const Loader& loader) {
+  if (!MemoryAccountingEnabled()) {
+    return;
+  }
+  ResourceAllocation estimate;
+  if (!loader.EstimateResources(&estimate).ok()) {
+    return;
+  }
+  std::map<string, int64_t> bytes_by_device;
+  for (const ResourceAllocation::Entry& entry :
+       estimate.resource_quantities()) {
+    if (entry.resource().kind() != resource_kinds::kRamBytes) {
+      continue;
     }
-    // Even if there is a small probability that version & policy checking can
-    // eliminate string checking, we should do that since O(string_equality) >>
-    // O(version_equality) + O(policy_equality).
-    if (lhs.name != rhs.name) {
-      return false;
+    string device = entry.resource().device();
+    if (device != device_types::kMain &&
+        entry.resource().has_device_instance()) {
+      strings::StrAppend(&device, ":",
+                         entry.resource().device_instance().value());
     }
-    return true;
+    bytes_by_device[device] += entry.quantity();
   }
-};
+  SetServableMemory(id.name, id.version, bytes_by_device);
+}
 
-struct BasicManager::ServingMap::HashRequest {
-  uint64_t operator()(const ServableRequest& request) const {
-    // Hash codes for many common types are remarkably bad, often clustering
-    // around the same values of the low and/or high bits for linear
-    // sequences of inputs such as 1, 2, 3; or addresses of consecutively
-    // allocated objects.  For these cases the default hash function is the
-    // identity function on the bit patterns.
-    //
-    // So we apply a one-to-one mapping to the resulting bit patterns to
-    // make the high bits contain more entropy from the entire hash code.
-    // It's based on Fibonacci hashing from Knuth's Art of Computer
-    // Programming volume 3, section 6.4.
-    const uint64_t version_hash = [&]() -> uint64_t {
-      if (request.version) {
-        return std::hash<int64_t>()(request.version.value()) *
-               0x9E3779B97F4A7C13;  // (sqrt(5) - 1)/2 as a binary fraction.
-      } else {
-        switch (request.auto_version_policy) {
-          case ServableRequest::AutoVersionPolicy::kEarliest:
-            return 0x01234CAFFE;
-          case ServableRequest::AutoVersionPolicy::kLatest:
-            return 0xDECAFCAFFE;
-        }
-      }
-    }();
-    // Using version_hash as the seed here to combine the hashes.
-    return HashCombine(version_hash, std::hash<string>()(request.name));
-  }
-};
+}  // namespace
 
-BasicManager::ServingMap::ServingMap()
-    : handles_map_(std::unique_ptr<HandlesMap>(new HandlesMap())) {}
+BasicManager::ServingMap::ServingMap(const bool per_thread_refs)
+    : per_thread_refs_(per_thread_refs),
+      shards_map_(per_thread_refs,
+                  std::unique_ptr<ShardsMap>(new ShardsMap())),
+      id_(NextServingMapId()) {}
 
 std::vector<ServableId> BasicManager::ServingMap::ListAvailableServableIds()
     const {
   std::vector<ServableId> ids;
-  std::shared_ptr<const HandlesMap> handles_map = handles_map_.get();
-  for (auto iter = handles_map->begin(); iter != handles_map->end();) {
-    // We get the iterator where all the values for a particular key ends.
-    const auto key_end = handles_map->equal_range(iter->first).second;
-
-    for (; iter != key_end; ++iter) {
-      if (iter->first.version) {
-        ids.push_back(iter->second->id());
-      }
+  std::shared_ptr<const ShardsMap> shards_map = shards_map_.get();
+  for (const auto& shard : *shards_map) {
+    std::shared_ptr<const StreamHandles> stream_handles = shard.second->get();
+    for (const auto& version : stream_handles->versions) {
+      ids.push_back(version.second->id());
     }
   }
   return ids;
@@ -126,126 +141,201 @@ std::vector<ServableId> BasicManager::ServingMap::ListAvailableServableIds()
 Status BasicManager::ServingMap::GetUntypedServableHandle(
     const ServableRequest& request,
     std::unique_ptr<UntypedServableHandle>* const untyped_handle) {
-  std::shared_ptr<const HandlesMap> handles_map = handles_map_.get();
-  const auto found_it = handles_map->find(request);
-  if (found_it == handles_map->end()) {
+  const uint64_t generation = generation_.load(std::memory_order_acquire);
+  const bool cacheable = generation % 2 == 0;
+  std::vector<CachedServableHandle>* const cached_handles =
+      ThreadCachedServableHandles();
+  auto cached_it = std::find_if(
+      cached_handles->begin(), cached_handles->end(),
+      [&](const CachedServableHandle& cached) {
+        return cached.serving_map_id == id_ &&
+               EqualServableRequests(cached.request, request);
+      });
+  if (cacheable && cached_it != cached_handles->end() &&
+      cached_it->generation == generation) {
+    std::shared_ptr<Loader> loader = cached_it->loader.lock();
+    if (loader != nullptr) {
+      untyped_handle->reset(new SharedPtrHandle(
+          cached_it->id, std::move(loader), cached_it->load_generation));
+      return OkStatus();
+    }
+  }
+
+  std::shared_ptr<const StreamHandles> stream_handles;
+  {
+    std::shared_ptr<const ShardsMap> shards_map = shards_map_.get();
+    const auto found_it = shards_map->find(request.name);
+    if (found_it != shards_map->end()) {
+      stream_handles = found_it->second->get();
+    }
+  }
+  const LoaderHarness* harness = nullptr;
+  if (stream_handles != nullptr) {
+    if (request.version) {
+      const auto found_it =
+          stream_handles->versions.find(request.version.value());
+      if (found_it != stream_handles->versions.end()) {
+        harness = found_it->second.get();
+      }
+    } else {
+      switch (request.auto_version_policy) {
+        case ServableRequest::AutoVersionPolicy::kEarliest:
+          harness = stream_handles->earliest.get();
+          break;
+        case ServableRequest::AutoVersionPolicy::kLatest:
+          harness = stream_handles->latest.get();
+          break;
+      }
+    }
+  }
+  if (harness == nullptr) {
     return errors::NotFound("Servable not found for request: ",
                             request.DebugString());
   }
 
-  const LoaderHarness& harness = *found_it->second;
   // We use the aliasing constructor of shared_ptr here. So even though we are
   // returning a shared_ptr to servable, the ref-counting is happening on the
-  // handles_map. This delays the map destruction till the last handle from the
-  // previous map is freed, when we are doing handles_map updates.
+  // stream's handles. This delays their destruction till the last handle from
+  // the previous version of the shard is freed, when we are doing shard
+  // updates.
+  std::shared_ptr<Loader> loader(stream_handles, harness->loader());
+  if (cacheable) {
+    if (cached_it == cached_handles->end()) {
+      if (cached_handles->size() >= kMaxCachedServableHandlesPerThread) {
+        cached_handles->erase(cached_handles->begin());
+      }
+      cached_it = cached_handles->emplace(cached_handles->end());
+    }
+    *cached_it = {id_, generation, request, harness->id(),
+                  harness->load_generation(), loader};
+  }
   untyped_handle->reset(new SharedPtrHandle(
-      harness.id(), std::shared_ptr<Loader>(handles_map, harness.loader())));
+      harness->id(), std::move(loader), harness->load_generation()));
   return OkStatus();
 }
 
 std::map<ServableId, std::unique_ptr<UntypedServableHandle>>
 BasicManager::ServingMap::GetAvailableUntypedServableHandles() const {
   std::map<ServableId, std::unique_ptr<UntypedServableHandle>> result;
-  std::shared_ptr<const HandlesMap> handles_map = handles_map_.get();
-  for (const auto& handle : *handles_map) {
-    const ServableRequest& request = handle.first;
-    // If the entry is one of the auto-versioned request ones, skip it. We would
-    // already get it from the entry which has the specific request.
-    if (!request.version) {
-      continue;
+  std::shared_ptr<const ShardsMap> shards_map = shards_map_.get();
+  for (const auto& shard : *shards_map) {
+    std::shared_ptr<const StreamHandles> stream_handles = shard.second->get();
+    for (const auto& version : stream_handles->versions) {
+      const LoaderHarness& harness = *version.second;
+      result.emplace(
+          harness.id(),
+          std::unique_ptr<UntypedServableHandle>(new SharedPtrHandle(
+              harness.id(),
+              std::shared_ptr<Loader>(stream_handles, harness.loader()),
+              harness.load_generation())));
     }
-    const LoaderHarness& harness = *handle.second;
-    result.emplace(harness.id(),
-                   std::unique_ptr<UntypedServableHandle>(new SharedPtrHandle(
-                       harness.id(), std::shared_ptr<Loader>(
-                                         handles_map, harness.loader()))));
   }
   return result;
 }
 
-void BasicManager::ServingMap::Update(const ManagedMap& managed_map) {
-  struct CompareRequests {
-    bool operator()(const ServableRequest& lhs,
-                    const ServableRequest& rhs) const {
-      const int strcmp_result = lhs.name.compare(rhs.name);
-      if (strcmp_result != 0) {
-        return strcmp_result < 0;
-      }
-      DCHECK(lhs.version);
-      DCHECK(rhs.version);
-      return lhs.version.value() < rhs.version.value();
-    }
-  };
-  std::multimap<ServableRequest, std::shared_ptr<const LoaderHarness>,
-                CompareRequests>
-      sorted_available_map;
-  for (const auto& elem : managed_map) {
-    std::shared_ptr<const LoaderHarness> harness = elem.second;
-    if (harness->state() == LoaderHarness::State::kReady) {
-      sorted_available_map.emplace(ServableRequest::FromId(harness->id()),
-                                   harness);
+void BasicManager::ServingMap::Update(const ManagedMap& managed_map,
+                                      const string& servable_name) {
+  std::vector<std::shared_ptr<const LoaderHarness>> ready_harnesses;
+  const auto range = managed_map.equal_range(servable_name);
+  for (auto iter = range.first; iter != range.second; ++iter) {
+    if (iter->second->state() == LoaderHarness::State::kReady) {
+      ready_harnesses.push_back(iter->second);
     }
   }
+  std::sort(ready_harnesses.begin(), ready_harnesses.end(),
+            [](const std::shared_ptr<const LoaderHarness>& lhs,
+               const std::shared_ptr<const LoaderHarness>& rhs) {
+              return lhs->id().version < rhs->id().version;
+            });
+  std::vector<int64_t> versions;
+  for (const auto& harness : ready_harnesses) {
+    versions.push_back(harness->id().version);
+  }
 
-  std::unique_ptr<HandlesMap> new_handles_map(new HandlesMap());
-  auto prev_iter = sorted_available_map.end();
-  for (auto iter = sorted_available_map.begin();
-       iter != sorted_available_map.end(); ++iter) {
-    std::shared_ptr<const LoaderHarness> harness = iter->second;
-    new_handles_map->emplace(ServableRequest::FromId(harness->id()), harness);
-
-    // If this is the first harness in the stream for a given servable name, add
-    // it again to the handles_map, marking it as the earliest for that stream.
-    if (prev_iter == sorted_available_map.end() ||
-        prev_iter->second->id().name != harness->id().name) {
-      const ServableRequest earliest_request =
-          ServableRequest::Earliest(harness->id().name);
-      new_handles_map->emplace(earliest_request, harness);
-    }
+  auto state_it = shard_states_.find(servable_name);
+  if (state_it == shard_states_.end() ? versions.empty()
+                                      : state_it->second.versions == versions) {
+    return;
+  }
 
-    // If this is the last harness in the stream for a given servable name, add
-    // it again to the handles_map, marking it as the latest for that stream.
-    const auto next_iter = std::next(iter);
-    if (next_iter == sorted_available_map.end() ||
-        next_iter->second->id().name != harness->id().name) {
-      const ServableRequest latest_request =
-          ServableRequest::Latest(harness->id().name);
-      new_handles_map->emplace(latest_request, harness);
-    }
+  // Stop giving out cached handles until the change is done.
+  generation_.fetch_add(1, std::memory_order_acq_rel);
 
-    prev_iter = iter;
+  std::unique_ptr<StreamHandles> new_stream_handles(new StreamHandles());
+  for (const auto& harness : ready_harnesses) {
+    new_stream_handles->versions.emplace(harness->id().version, harness);
+  }
+  if (!ready_harnesses.empty()) {
+    new_stream_handles->earliest = ready_harnesses.front();
+    new_stream_handles->latest = ready_harnesses.back();
   }
 
-  // This blocks until the last handle given out by the old handles map is
-  // freed.
-  handles_map_.Update(std::move(new_handles_map));
+  if (state_it != shard_states_.end()) {
+    // This blocks until the last handle given out by the old shard is freed.
+    state_it->second.shard->Update(std::move(new_stream_handles));
+    if (!versions.empty()) {
+      state_it->second.versions = std::move(versions);
+      generation_.fetch_add(1, std::memory_order_release);
+      return;
+    }
+    shard_states_.erase(state_it);
+  } else {
+    ShardState& state = shard_states_[servable_name];
+    state.shard = std::make_shared<Shard>(per_thread_refs_,
+                                          std::move(new_stream_handles));
+    state.versions = std::move(versions);
+  }
+
+  // The stream was added or removed, so publish a new map of the shards. This
+  // only waits for the lookups that are in progress, since the handles given
+  // out hold on to the shards rather than to the map.
+  std::unique_ptr<ShardsMap> new_shards_map(new ShardsMap());
+  for (const auto& state : shard_states_) {
+    new_shards_map->emplace(state.first, state.second.shard);
+  }
+  shards_map_.Update(std::move(new_shards_map));
+  generation_.fetch_add(1, std::memory_order_release);
 }
 
 Status BasicManager::Create(Options options,
                             std::unique_ptr<BasicManager>* manager) {
   manager->reset(new BasicManager(
       options.env, options.num_load_threads, options.num_unload_threads,
-      options.max_num_load_retries, options.load_retry_interval_micros,
-      options.flush_filesystem_caches, std::move(options.resource_tracker),
-      options.servable_event_bus, std::move(options.pre_load_hook)));
+      options.work_stealing_load_executor, options.max_num_load_retries,
+      options.load_retry_interval_micros, options.load_retry_backoff,
+      std::move(options.load_retry_budget), options.flush_filesystem_caches,
+      options.use_per_thread_handle_refs, options.enable_batch_load_approval,
+      std::move(options.resource_tracker), options.servable_event_bus,
+      std::move(options.pre_load_hook)));
   return OkStatus();
 }
 
 BasicManager::BasicManager(Env* const env, const uint32 num_load_threads,
                            const uint32 num_unload_threads,
+                           bool work_stealing_load_executor,
                            uint32 max_num_load_retries,
                            int64_t load_retry_interval_micros,
+                           const RetryBackoff& load_retry_backoff,
+                           std::shared_ptr<RetryBudget> load_retry_budget,
                            bool flush_filesystem_caches,
+                           bool use_per_thread_handle_refs,
+                           bool enable_batch_load_approval,
                            std::unique_ptr<ResourceTracker> resource_tracker,
                            EventBus<ServableState>* servable_event_bus,
                            std::function<void(const ServableId&)> pre_load_hook)
-    : servable_event_bus_(servable_event_bus),
+    : load_retry_budget_(std::move(load_retry_budget)),
+      servable_event_bus_(servable_event_bus),
+      serving_map_(use_per_thread_handle_refs),
       env_(env),
       num_load_threads_(num_load_threads),
+      work_stealing_load_executor_(work_stealing_load_executor),
       flush_filesystem_caches_(flush_filesystem_caches),
+      enable_batch_load_approval_(enable_batch_load_approval),
       pre_load_hook_(std::move(pre_load_hook)) {
   harness_options_.max_num_load_retries = max_num_load_retries;
   harness_options_.load_retry_interval_micros = load_retry_interval_micros;
+  harness_options_.load_retry_backoff = load_retry_backoff;
+  harness_options_.load_retry_budget = load_retry_budget_.get();
   harness_options_.error_callback = [this](const ServableId& id,
                                            const Status& error) {
     PublishOnEventBus({id, ServableState::ManagerState::kEnd, error});
@@ -254,7 +344,8 @@ BasicManager::BasicManager(Env* const env, const uint32 num_load_threads,
   {
     mutex_lock l(load_executor_mu_);
     load_executor_ =
-        CreateExecutor(env_, num_load_threads, "BasicManager_Load_ThreadPool");
+        CreateExecutor(env_, num_load_threads, "BasicManager_Load_ThreadPool",
+                       work_stealing_load_executor_);
   }
   unload_executor_ = CreateExecutor(env_, num_unload_threads,
                                     "BasicManager_Unload_ThreadPool");
@@ -317,10 +408,10 @@ BasicManager::GetAvailableUntypedServableHandles() const {
   return serving_map_.GetAvailableUntypedServableHandles();
 }
 
-void BasicManager::UpdateServingMap() {
-  // This blocks until the last handle given out by the old serving map is
-  // freed.
-  serving_map_.Update(managed_map_);
+void BasicManager::UpdateServingMap(const string& servable_name) {
+  // This blocks until the last handle given out by the old shard of the
+  // servable stream is freed.
+  serving_map_.Update(managed_map_, servable_name);
 }
 
 BasicManager::ManagedMap::iterator BasicManager::FindHarnessInMap(
@@ -374,10 +465,29 @@ Status BasicManager::ManageServable(
       std::move(servable),
       [this](const ServableId& id, std::unique_ptr<Loader> loader) {
         return std::make_shared<LoaderHarness>(id, std::move(loader),
-                                               harness_options_);
+                                               GetHarnessOptions(id.name));
       });
 }
 
+void BasicManager::SetLoadRetryPolicies(
+    std::map<string, LoadRetryPolicy> load_retry_policies) {
+  mutex_lock l(load_retry_policies_mu_);
+  load_retry_policies_ = std::move(load_retry_policies);
+}
+
+LoaderHarness::Options BasicManager::GetHarnessOptions(
+    const string& servable_name) const {
+  LoaderHarness::Options options = harness_options_;
+  mutex_lock l(load_retry_policies_mu_);
+  auto it = load_retry_policies_.find(servable_name);
+  if (it != load_retry_policies_.end()) {
+    options.max_num_load_retries = it->second.max_num_load_retries;
+    options.load_retry_interval_micros = it->second.load_retry_interval_micros;
+    options.load_retry_backoff = it->second.load_retry_backoff;
+  }
+  return options;
+}
+
 Status BasicManager::StopManagingServable(const ServableId& id) {
   VLOG(1) << "Request to stop managing servable " << id;
   mutex_lock l(mu_);
@@ -504,7 +614,13 @@ Status BasicManager::ExecuteLoad(LoaderHarness* harness) {
 
   {
     mutex_lock l(mu_);
-    UpdateServingMap();
+    UpdateServingMap(id.name);
+    // Loaders memoize their estimates, so this is cheap under the lock, like
+    // the estimates of RecomputeUsedResources().
+    LoaderHarness* loaded_harness;
+    if (GetHealthyHarness(id, &loaded_harness).ok()) {
+      AccountServableMemory(id, *loaded_harness->loader());
+    }
   }
 
   PublishOnEventBus({id, ServableState::ManagerState::kAvailable, OkStatus()});
@@ -541,12 +657,13 @@ Status BasicManager::ExecuteUnload(LoaderHarness* harness) {
     mutex_lock l(mu_);
     PublishOnEventBus(
         {id, ServableState::ManagerState::kUnloading, harness->status()});
-    UpdateServingMap();
+    UpdateServingMap(id.name);
     TF_RETURN_IF_ERROR(harness->DoneQuiescing());
   }
 
   // We don't hold the lock while calling Unload() as it may block.
   TF_RETURN_IF_ERROR(harness->Unload());
+  ClearServableMemory(id.name, id.version);
   PublishOnEventBus({id, ServableState::ManagerState::kEnd, OkStatus()});
   return OkStatus();
 }
@@ -588,7 +705,8 @@ void BasicManager::SetNumLoadThreads(const uint32 num_load_threads) {
   load_executor_.reset();
   num_load_threads_.store(num_load_threads);
   load_executor_ =
-      CreateExecutor(env_, num_load_threads, "BasicManager_Load_ThreadPool");
+      CreateExecutor(env_, num_load_threads, "BasicManager_Load_ThreadPool",
+                     work_stealing_load_executor_);
 }
 
 uint32 BasicManager::num_load_threads() const {
@@ -637,10 +755,22 @@ void BasicManager::LoadOrUnloadServable(const LoadOrUnloadRequest& request,
 
 void BasicManager::HandleLoadOrUnloadRequest(const LoadOrUnloadRequest& request,
                                              DoneCallback done_callback) {
+  // Profiles loads from the approval on, which covers estimating the
+  // resources of the servable and waiting for them.
+  absl::optional<ScopedLoadProfile> load_profile;
+  if (request.kind == LoadOrUnloadRequest::Kind::kLoad) {
+    load_profile.emplace(request.servable_id);
+    PrepareLoadApproval(request.servable_id);
+  }
+
   // Decision phase.
   Status decision_status;
   LoaderHarness* harness;
   {
+    absl::optional<ScopedLoadPhase> approve_phase;
+    if (load_profile.has_value()) {
+      approve_phase.emplace("approve_load");
+    }
     // We serialize the decision phases of the requests. We will make a decision
     // about the present request before allowing other requests to enter their
     // decision phase. See the .h file for more explanation and rationale.
@@ -648,6 +778,12 @@ void BasicManager::HandleLoadOrUnloadRequest(const LoadOrUnloadRequest& request,
     decision_status = ApproveLoadOrUnload(request, &harness);
   }
   if (!decision_status.ok()) {
+    // Keeps the profile of the earlier load of the servable if the request
+    // was e.g. a duplicate, but profiles loads that ran out of resources.
+    if (load_profile.has_value() &&
+        !errors::IsResourceExhausted(decision_status)) {
+      load_profile->Discard();
+    }
     done_callback(decision_status);
     return;
   }
@@ -661,11 +797,26 @@ Status BasicManager::ApproveLoadOrUnload(const LoadOrUnloadRequest& request,
                                          LoaderHarness** harness) {
   mutex_lock l(mu_);
 
+  if (request.kind == LoadOrUnloadRequest::Kind::kLoad) {
+    pending_load_approvals_.erase(
+        std::remove_if(pending_load_approvals_.begin(),
+                       pending_load_approvals_.end(),
+                       [&](const PendingLoadApproval& pending) {
+                         return pending.harness->id() == request.servable_id;
+                       }),
+        pending_load_approvals_.end());
+  }
+
   TF_RETURN_IF_ERROR(GetHealthyHarness(request.servable_id, harness));
 
   switch (request.kind) {
     case LoadOrUnloadRequest::Kind::kLoad: {
+      if (batch_approved_loads_.erase(request.servable_id) > 0) {
+        // Approved in the decision phase of another load.
+        return OkStatus();
+      }
       TF_RETURN_IF_ERROR(ApproveLoad(*harness, &l));
+      ApprovePendingLoads();
       break;
     }
     case LoadOrUnloadRequest::Kind::kUnload: {
@@ -701,6 +852,63 @@ Status BasicManager::ApproveLoad(LoaderHarness* harness, mutex_lock* mu_lock) {
   return OkStatus();
 }
 
+void BasicManager::PrepareLoadApproval(const ServableId& id) {
+  if (!enable_batch_load_approval_) {
+    return;
+  }
+  LoaderHarness* harness;
+  {
+    mutex_lock l(mu_);
+    if (resource_tracker_ == nullptr || !GetHealthyHarness(id, &harness).ok()) {
+      return;
+    }
+  }
+  // The harness stays in state kLoadRequested, and hence managed, until the
+  // decision phase. Loaders usually memoize their estimate, which makes the one
+  // of the decision phase cheap. If the estimate fails, the decision phase
+  // retries and reports it.
+  ResourceAllocation estimate;
+  if (!harness->loader()->EstimateResources(&estimate).ok()) {
+    return;
+  }
+  uint64_t total_resource_quantity = 0;
+  for (const auto& resource_quantity : estimate.resource_quantities()) {
+    total_resource_quantity += resource_quantity.quantity();
+  }
+  mutex_lock l(mu_);
+  pending_load_approvals_.push_back({harness, total_resource_quantity});
+}
+
+void BasicManager::ApprovePendingLoads() {
+  if (pending_load_approvals_.empty()) {
+    return;
+  }
+  std::vector<PendingLoadApproval> pending_loads;
+  pending_loads.swap(pending_load_approvals_);
+  std::stable_sort(pending_loads.begin(), pending_loads.end(),
+                   [](const PendingLoadApproval& lhs,
+                      const PendingLoadApproval& rhs) {
+                     return lhs.total_resource_quantity >
+                            rhs.total_resource_quantity;
+                   });
+  // The resources reserved by the approved load are accounted for already.
+  for (const PendingLoadApproval& pending : pending_loads) {
+    bool resources_reserved = false;
+    if (resource_tracker_
+            ->ReserveResources(*pending.harness->loader(), &resources_reserved)
+            .ok() &&
+        resources_reserved && pending.harness->LoadApproved().ok()) {
+      LOG(INFO) << "Successfully reserved resources to load servable "
+                << pending.harness->id().DebugString()
+                << " along with another servable";
+      batch_approved_loads_.insert(pending.harness->id());
+      ++num_ongoing_load_unload_executions_;
+    } else {
+      pending_load_approvals_.push_back(pending);
+    }
+  }
+}
+
 Status BasicManager::ApproveUnload(LoaderHarness* harness) {
   // Transition to state kQuiescing inside the decision phase, to prevent any
   // concurrent unload requests from executing.
@@ -720,8 +928,7 @@ Status BasicManager::ReserveResources(LoaderHarness* harness,
     const Status reserve_resources_status = Retry(
         strings::StrCat("Reserving resources for servable: ",
                         harness->id().DebugString()),
-        harness_options_.max_num_load_retries,
-        harness_options_.load_retry_interval_micros,
+        harness->load_retry_options(),
         [&]() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
           return resource_tracker_->ReserveResources(*harness->loader(),
                                                      &resources_reserved);
@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_SERVING_CORE_BASIC_MANAGER_H_
 
 #include <atomic>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -41,6 +43,7 @@ limitations under the License.
 #include "tensorflow_serving/util/event_bus.h"
 #include "tensorflow_serving/util/executor.h"
 #include "tensorflow_serving/util/fast_read_dynamic_ptr.h"
+#include "tensorflow_serving/util/retrier.h"
 
 namespace tensorflow {
 namespace serving {
@@ -125,6 +128,10 @@ class BasicManager : public Manager {
     // If set as 0, we don't use a thread-pool, and UnloadServable() blocks.
     uint32 num_unload_threads = 0;
 
+    // Whether the load thread-pool is a WorkStealingExecutor, rather than a
+    // single-queue thread-pool.
+    bool work_stealing_load_executor = false;
+
     // EventBus to publish servable state changes. This is optional, if unset,
     // we don't publish.
     EventBus<ServableState>* servable_event_bus = nullptr;
@@ -140,12 +147,38 @@ class BasicManager : public Manager {
     // Default: 1 minute.
     int64_t load_retry_interval_micros = 1LL * 60 * 1000 * 1000;
 
+    // How the interval between load retries grows, from
+    // 'load_retry_interval_micros'. By default it doesn't.
+    RetryBackoff load_retry_backoff;
+
+    // The budget the load retries of all servables are taken from, if any.
+    std::shared_ptr<RetryBudget> load_retry_budget;
+
     // If true, and there are not multiple load threads, filesystem caches will
     // be flushed after each servable is loaded. (Cache flush is skipped when
     // multiple load threads are active, in order to avoid setting back a
     // concurrent load on another thread.)
     bool flush_filesystem_caches = false;
 
+    // If true, the handles to servables ready to be served are reference
+    // counted per thread that gets them, instead of per CPU. This keeps the
+    // reference counts touched by GetServableHandle() on cache lines of the
+    // calling thread, at the cost of memory per thread and servable stream.
+    // Suited to a bounded set of long-lived request threads, such as those of
+    // an RPC server, e.g. when many of them share few CPUs.
+    bool use_per_thread_handle_refs = false;
+
+    // If true, and there is a resource tracker, the loads are approved in
+    // batches: the load threads estimate the resources of their servables
+    // before entering the (serialized) decision phase, and a decision phase
+    // that approves a load also approves the other pending loads that fit in
+    // the remaining resources, largest first. This takes the first resource
+    // estimates, which are often expensive (e.g. summing up the sizes of a
+    // model's files), out of the decision phase, and speeds up loading many
+    // servables at once, e.g. at server startup. Only useful with multiple
+    // load threads.
+    bool enable_batch_load_approval = false;
+
     // The environment to use for starting threads in the thread-pool.
     Env* env = Env::Default();
 
@@ -264,13 +297,33 @@ class BasicManager : public Manager {
   /// those will succeed and the rest will fail with an error status.
   void UnloadServable(const ServableId& id, DoneCallback done_callback);
 
+  /// How the loads of the servables of a stream are retried, in place of the
+  /// retry options of the manager.
+  struct LoadRetryPolicy {
+    uint32 max_num_load_retries = 0;
+    int64_t load_retry_interval_micros = 0;
+    RetryBackoff load_retry_backoff;
+  };
+
+  /// Sets the load retry policies of servable streams, by name. They apply to
+  /// servables managed from then on; streams not in 'load_retry_policies' use
+  /// the retry options of the manager. Retries still draw on the budget of the
+  /// manager.
+  void SetLoadRetryPolicies(
+      std::map<string, LoadRetryPolicy> load_retry_policies)
+      TF_LOCKS_EXCLUDED(load_retry_policies_mu_);
+
  private:
   friend class AspiredVersionsManager;
   friend class test_util::BasicManagerTestAccess;
 
   BasicManager(Env* env, uint32 num_load_threads, uint32 num_unload_threads,
-               uint32 max_num_load_retries, int64_t load_retry_interval_micros,
-               bool flush_filesystem_caches,
+               bool work_stealing_load_executor, uint32 max_num_load_retries,
+               int64_t load_retry_interval_micros,
+               const RetryBackoff& load_retry_backoff,
+               std::shared_ptr<RetryBudget> load_retry_budget,
+               bool flush_filesystem_caches, bool use_per_thread_handle_refs,
+               bool enable_batch_load_approval,
                std::unique_ptr<ResourceTracker> resource_tracker,
                EventBus<ServableState>* servable_event_bus,
                PreLoadHook pre_load_hook);
@@ -334,6 +387,17 @@ class BasicManager : public Manager {
   Status ApproveLoadOrUnload(const LoadOrUnloadRequest& request,
                              LoaderHarness** harness) TF_LOCKS_EXCLUDED(mu_);
 
+  // If batch load approval is enabled, estimates the resources of the servable
+  // to load, and adds it to 'pending_load_approvals_'. Runs before the
+  // decision phase of the load request, outside of it.
+  void PrepareLoadApproval(const ServableId& id) TF_LOCKS_EXCLUDED(mu_);
+
+  // Called by the decision phase that just approved a load. Approves the
+  // pending loads that fit in the remaining resources, largest first, and
+  // signals their entrance to the execution phase. The loads that don't fit
+  // stay pending, for their own decision phases.
+  void ApprovePendingLoads() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // The decision phase of whether to approve a load request.
   //
   // If it succeeds, places the servable into state kApprovedForLoad. Among
@@ -377,9 +441,10 @@ class BasicManager : public Manager {
   // Unloads all the managed servables.
   Status UnloadAllServables() TF_LOCKS_EXCLUDED(mu_);
 
-  // Updates the serving map by copying servables from the managed map, which
-  // are ready to be served.
-  void UpdateServingMap() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Updates the serving map by copying the servables of the stream
+  // 'servable_name' from the managed map, which are ready to be served.
+  void UpdateServingMap(const string& servable_name)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // Sets the number of load threads.
   //
@@ -406,8 +471,20 @@ class BasicManager : public Manager {
   // options, if not we ignore it.
   void PublishOnEventBus(const ServableState& state);
 
+  // The options of the harness of a new servable of the stream
+  // 'servable_name', i.e. 'harness_options_' with its load retry policy.
+  LoaderHarness::Options GetHarnessOptions(const string& servable_name) const
+      TF_LOCKS_EXCLUDED(load_retry_policies_mu_);
+
   LoaderHarness::Options harness_options_;
 
+  // Owns the budget of 'harness_options_', if any.
+  const std::shared_ptr<RetryBudget> load_retry_budget_;
+
+  mutable mutex load_retry_policies_mu_;
+  std::map<string, LoadRetryPolicy> load_retry_policies_
+      TF_GUARDED_BY(load_retry_policies_mu_);
+
   // The event bus to which to publish servable state change events, or nullptr
   // if no bus has been configured.
   EventBus<ServableState>* servable_event_bus_;
@@ -425,10 +502,23 @@ class BasicManager : public Manager {
   // This map is updated occasionally from the main manager loop thread while
   // being accessed from multiple threads to get ServableHandles.
   //
-  // This class is thread-safe.
+  // The map is sharded by servable stream: each stream's servables are held
+  // by a FastReadDynamicPtr of their own, so that a change to one stream only
+  // rebuilds, and waits for the handles given out by, that stream's shard.
+  //
+  // Each thread caches the last few handles it was given, so that repeated
+  // requests for the same servable skip the lookups in the map (and, for
+  // auto-versioned requests, the choice of the version). The cache holds the
+  // servables weakly, and any change to the map invalidates it.
+  //
+  // This class is thread-safe, except that calls to Update() must be
+  // serialized.
   class ServingMap {
    public:
-    ServingMap();
+    // If 'per_thread_refs' is true, the shards reference count the handles
+    // they give out per reading thread rather than per CPU. See
+    // Options::use_per_thread_handle_refs.
+    explicit ServingMap(bool per_thread_refs);
 
     // Gets a list of all servable ids.
     std::vector<ServableId> ListAvailableServableIds() const;
@@ -445,25 +535,84 @@ class BasicManager : public Manager {
     std::map<ServableId, std::unique_ptr<UntypedServableHandle>>
     GetAvailableUntypedServableHandles() const;
 
-    // Updates the serving map by copying servables from the managed map, which
-    // are ready to be served.
-    void Update(const ManagedMap& managed_map);
+    // Updates the shard of the servable stream 'servable_name' by copying its
+    // servables from the managed map, which are ready to be served. Does not
+    // touch the shard, nor block, if they are unchanged. Otherwise blocks
+    // until the last handle given out by the old shard is freed.
+    void Update(const ManagedMap& managed_map, const string& servable_name);
 
    private:
-    struct EqRequest;
-    // Hash and equality functors for ServableRequest.
-    // Forward-declared here and defined in the cc file.
-    struct HashRequest;
-
-    // Map from ServableRequest to corresponding harness. For the latest version
-    // of a servable stream, we add an extra entry for it, where key is the
-    // ServableRequest without the version set, so that requests for the latest,
-    // can be directly queried on this map.
-    using HandlesMap =
-        std::unordered_multimap<ServableRequest,
-                                std::shared_ptr<const LoaderHarness>,
-                                HashRequest, EqRequest>;
-    FastReadDynamicPtr<HandlesMap> handles_map_;
+    // A FastReadDynamicPtr with a ReadPtrHolder chosen at construction:
+    // ThreadLocalReadPtrs if 'per_thread_refs' is true, and the default one
+    // otherwise.
+    template <typename T>
+    class SelectablePtr {
+     public:
+      SelectablePtr(bool per_thread_refs, std::unique_ptr<T> object) {
+        if (per_thread_refs) {
+          per_thread_.reset(new PerThreadPtr(std::move(object)));
+        } else {
+          per_cpu_.reset(new FastReadDynamicPtr<T>(std::move(object)));
+        }
+      }
+
+      std::shared_ptr<const T> get() const {
+        return per_thread_ != nullptr ? per_thread_->get() : per_cpu_->get();
+      }
+
+      // Blocks until the last ReadPtr to the old object is freed.
+      void Update(std::unique_ptr<T> object) {
+        if (per_thread_ != nullptr) {
+          per_thread_->Update(std::move(object));
+        } else {
+          per_cpu_->Update(std::move(object));
+        }
+      }
+
+     private:
+      using PerThreadPtr = FastReadDynamicPtr<
+          T, internal_read_ptr_holder::ThreadLocalReadPtrs<T>>;
+      std::unique_ptr<FastReadDynamicPtr<T>> per_cpu_;
+      std::unique_ptr<PerThreadPtr> per_thread_;
+    };
+
+    // The servables of one servable stream that are ready to be served, by
+    // version, with extra entries for the earliest and latest versions so
+    // that auto-versioned requests can be directly queried.
+    struct StreamHandles {
+      std::unordered_map<int64_t, std::shared_ptr<const LoaderHarness>>
+          versions;
+      std::shared_ptr<const LoaderHarness> earliest;
+      std::shared_ptr<const LoaderHarness> latest;
+    };
+    using Shard = SelectablePtr<StreamHandles>;
+
+    const bool per_thread_refs_;
+
+    // Map from servable stream name to its shard, for the streams with at
+    // least one servable ready to be served. Only replaced when a stream is
+    // added or removed.
+    using ShardsMap = std::unordered_map<string, std::shared_ptr<Shard>>;
+    SelectablePtr<ShardsMap> shards_map_;
+
+    // The updater's view of the shards: for each stream in 'shards_map_', its
+    // shard and the versions in it. Only accessed by Update().
+    struct ShardState {
+      std::shared_ptr<Shard> shard;
+      std::vector<int64_t> versions;
+    };
+    std::unordered_map<string, ShardState> shard_states_;
+
+    // Identifies this map in the per-thread handle caches, without ever being
+    // reused.
+    const uint64_t id_;
+
+    // Odd while Update() is changing the shards, and advanced by two by each
+    // change. Handles are only cached, and cached handles only used, while it
+    // is even and unchanged since they were looked up. So they never outlive
+    // a change, nor hold up Update() while it waits for the handles given out
+    // by an old shard.
+    std::atomic<uint64_t> generation_{0};
   };
   ServingMap serving_map_;
 
@@ -485,6 +634,8 @@ class BasicManager : public Manager {
   // The number of load threads. Can be changed after instantiation of the
   // manager via SetNumLoadThreads().
   std::atomic<uint32> num_load_threads_;
+  // Whether load executors are WorkStealingExecutors.
+  const bool work_stealing_load_executor_;
   // Whether to flush filesystem caches (if num_load_threads_ == 1)
   const bool flush_filesystem_caches_ = false;
   // The executor (and associated mutex) used for executing loads of servables.
@@ -505,6 +656,23 @@ class BasicManager : public Manager {
   // The number of load/unload requests currently in their execution phase.
   int num_ongoing_load_unload_executions_ TF_GUARDED_BY(mu_) = 0;
 
+  // Whether to approve loads in batches. See
+  // Options::enable_batch_load_approval.
+  const bool enable_batch_load_approval_;
+
+  // A load request between PrepareLoadApproval() and its decision phase.
+  struct PendingLoadApproval {
+    LoaderHarness* harness;
+    // The sum of the quantities of the servable's resource estimate, by which
+    // the pending loads are approved largest first.
+    uint64_t total_resource_quantity;
+  };
+  std::vector<PendingLoadApproval> pending_load_approvals_ TF_GUARDED_BY(mu_);
+
+  // The loads approved by ApprovePendingLoads() whose own decision phase has
+  // yet to run. They count as ongoing executions already.
+  std::set<ServableId> batch_approved_loads_ TF_GUARDED_BY(mu_);
+
   // Used to wake up threads that are waiting for 'num_ongoing_executions' to
   // decrease.
   condition_variable num_ongoing_load_unload_executions_cv_;
@@ -528,7 +696,7 @@ Status BasicManager::ManageServableWithAdditionalState(
                                 std::unique_ptr<Loader> loader) {
         return std::make_shared<LoaderHarness>(id, std::move(loader),
                                                std::move(additional_state),
-                                               harness_options_);
+                                               GetHarnessOptions(id.name));
       });
 }
 
@@ -84,10 +84,12 @@ ServableData<std::unique_ptr<Loader>> CreateServable(
 }
 
 // We parameterize this test with the number of load & unload threads. (Zero
-// means use an in-line executor instead of a thread pool.)
+// means use an in-line executor instead of a thread pool.) Some of the
+// configurations also reference count servable handles per thread.
 struct ThreadPoolSizes {
   uint64_t num_load_threads;
   uint64_t num_unload_threads;
+  bool use_per_thread_handle_refs = false;
 };
 class BasicManagerTest : public ::testing::TestWithParam<ThreadPoolSizes> {
  protected:
@@ -98,6 +100,8 @@ class BasicManagerTest : public ::testing::TestWithParam<ThreadPoolSizes> {
     BasicManager::Options options;
     options.num_load_threads = thread_pool_sizes_.num_load_threads;
     options.num_unload_threads = thread_pool_sizes_.num_unload_threads;
+    options.use_per_thread_handle_refs =
+        thread_pool_sizes_.use_per_thread_handle_refs;
     options.servable_event_bus = servable_event_bus_.get();
     options.max_num_load_retries = 10;
     options.load_retry_interval_micros = 0;
@@ -136,7 +140,10 @@ INSTANTIATE_TEST_CASE_P(
         ThreadPoolSizes{0, 0} /* without load or unload threadpools */,
         ThreadPoolSizes{2, 0} /* with just a load threadpool */,
         ThreadPoolSizes{0, 2} /* with just an unload threadpool */,
-        ThreadPoolSizes{4, 4} /* with load and unload threadpools */));
+        ThreadPoolSizes{4, 4} /* with load and unload threadpools */,
+        ThreadPoolSizes{0, 0, true} /* with per-thread handle refs */,
+        ThreadPoolSizes{4, 4, true} /* with threadpools and per-thread handle
+                                       refs */));
 
 TEST_P(BasicManagerTest, ServableHandleNotFoundMissingLoaderName) {
   ServableHandle<int64_t> handle;
@@ -181,6 +188,52 @@ TEST_P(BasicManagerTest, ServableHandleLatest) {
   EXPECT_EQ(kNumVersionsPerServable + 1, *handle);
 }
 
+// Loading a version of one servable stream doesn't wait for the handles given
+// out for other streams, since the serving map is sharded by stream.
+TEST_P(BasicManagerTest, LoadDoesNotWaitForHandlesOfOtherServables) {
+  ServableHandle<int64_t> other_handle;
+  TF_ASSERT_OK(basic_manager_->GetServableHandle(
+      ServableRequest::Latest(kServableName2), &other_handle));
+
+  const ServableId id = {kServableName, kNumVersionsPerServable + 1};
+  TF_ASSERT_OK(basic_manager_->ManageServable(CreateServable(id)));
+  basic_manager_->LoadServable(
+      id, [](const Status& status) { TF_ASSERT_OK(status); });
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor_, id, {ServableState::ManagerState::kAvailable});
+
+  ServableHandle<int64_t> handle;
+  TF_ASSERT_OK(basic_manager_->GetServableHandle(
+      ServableRequest::Latest(kServableName), &handle));
+  EXPECT_EQ(kNumVersionsPerServable + 1, *handle);
+  EXPECT_EQ(kNumVersionsPerServable, *other_handle);
+}
+
+// Handles cached by the getting thread don't delay unloading, and don't
+// outlive changes to the serving map.
+TEST_P(BasicManagerTest, CachedHandlesDoNotDelayUnload) {
+  for (int i = 0; i < 3; ++i) {
+    ServableHandle<int64_t> handle;
+    TF_ASSERT_OK(basic_manager_->GetServableHandle(
+        ServableRequest::Latest(kServableName), &handle));
+    EXPECT_EQ(kNumVersionsPerServable, *handle);
+  }
+
+  const ServableId id = {kServableName, kNumVersionsPerServable};
+  basic_manager_->UnloadServable(
+      id, [](const Status& status) { TF_EXPECT_OK(status); });
+  WaitUntilServableManagerStateIsOneOf(servable_state_monitor_, id,
+                                       {ServableState::ManagerState::kEnd});
+
+  ServableHandle<int64_t> handle;
+  TF_ASSERT_OK(basic_manager_->GetServableHandle(
+      ServableRequest::Latest(kServableName), &handle));
+  EXPECT_EQ(kNumVersionsPerServable - 1, *handle);
+  const Status status = basic_manager_->GetServableHandle(
+      ServableRequest::Specific(kServableName, id.version), &handle);
+  EXPECT_EQ(error::NOT_FOUND, status.code());
+}
+
 TEST_P(BasicManagerTest, AlreadyManagedError) {
   const ServableId id = {"banana", 42};
   TF_ASSERT_OK(basic_manager_->ManageServable(CreateServable(id)));
@@ -242,6 +295,38 @@ TEST_P(BasicManagerTest, StopManagingDisabledServable) {
   EXPECT_FALSE(basic_manager_->GetManagedServableStateSnapshot(id));
 }
 
+TEST_P(BasicManagerTest, ReloadedServablesHaveNewLoadGenerations) {
+  const ServableId id = {kServableName3, 1};
+  const auto load = [&]() {
+    TF_ASSERT_OK(basic_manager_->ManageServable(CreateServable(id)));
+    basic_manager_->LoadServable(
+        id, [](const Status& status) { TF_EXPECT_OK(status); });
+    WaitUntilServableManagerStateIsOneOf(
+        servable_state_monitor_, id, {ServableState::ManagerState::kAvailable});
+  };
+  const auto get_load_generation = [&]() {
+    ServableHandle<int64_t> handle;
+    TF_CHECK_OK(basic_manager_->GetServableHandle(
+        ServableRequest::Specific(kServableName3, 1), &handle));
+    return handle.load_generation();
+  };
+  load();
+  const uint64_t load_generation = get_load_generation();
+  EXPECT_NE(0, load_generation);
+  // Also when the handle comes from the handles cached by the thread.
+  EXPECT_EQ(load_generation, get_load_generation());
+
+  basic_manager_->UnloadServable(
+      id, [](const Status& status) { TF_EXPECT_OK(status); });
+  WaitUntilServableManagerStateIsOneOf(servable_state_monitor_, id,
+                                       {ServableState::ManagerState::kEnd});
+  TF_ASSERT_OK(basic_manager_->StopManagingServable(id));
+  load();
+  const uint64_t reload_generation = get_load_generation();
+  EXPECT_NE(0, reload_generation);
+  EXPECT_NE(load_generation, reload_generation);
+}
+
 TEST_P(BasicManagerTest, DontStopManagingOnError) {
   const ServableId id = {kServableName, 7};
   const Status error_status = errors::Internal("An error.");
@@ -876,6 +961,29 @@ TEST_F(SetNumLoadThreadsBasicManagerTest, ThreadPoolSwapped) {
   basic_manager_.reset();
 }
 
+TEST(BasicManagerWorkStealingTest, LoadsOnWorkStealingExecutor) {
+  BasicManager::Options options;
+  options.num_load_threads = 2;
+  options.work_stealing_load_executor = true;
+  options.load_retry_interval_micros = 0;
+  std::unique_ptr<BasicManager> basic_manager;
+  TF_ASSERT_OK(BasicManager::Create(std::move(options), &basic_manager));
+
+  const int kNumServables = 10;
+  BlockingCounter loads_done(kNumServables);
+  for (int i = 0; i < kNumServables; ++i) {
+    const ServableId id = {kServableName3, i};
+    TF_ASSERT_OK(basic_manager->ManageServable(CreateServable(id)));
+    basic_manager->LoadServable(id, [&loads_done](const Status& status) {
+      TF_EXPECT_OK(status);
+      loads_done.DecrementCount();
+    });
+  }
+  loads_done.Wait();
+  EXPECT_EQ(kNumServables,
+            basic_manager->ListAvailableServableIds().size());
+}
+
 TEST_F(SetNumLoadThreadsBasicManagerTest, ThreadPoolsNotAliveSimultaneously) {
   test_util::BasicManagerTestAccess manager_test_access(basic_manager_.get());
   manager_test_access.SetNumLoadThreads(1);
@@ -1138,6 +1246,23 @@ TEST_P(BasicManagerTest, RetryOnLoadErrorFinallyFails) {
   });
 }
 
+TEST_P(BasicManagerTest, LoadRetryPolicyOfStream) {
+  // The stream retries less than the manager.
+  BasicManager::LoadRetryPolicy policy;
+  policy.max_num_load_retries = 1;
+  basic_manager_->SetLoadRetryPolicies({{kServableName, policy}});
+  const ServableId id = {kServableName, 7};
+  test_util::MockLoader* loader = new NiceMock<test_util::MockLoader>();
+  TF_ASSERT_OK(
+      basic_manager_->ManageServable({id, std::unique_ptr<Loader>(loader)}));
+  EXPECT_CALL(*loader, LoadWithMetadata(Loader::Metadata{id}))
+      .Times(2)
+      .WillRepeatedly(Return(errors::Internal("Load error.")));
+  basic_manager_->LoadServable(id, [](const Status& status) {
+    EXPECT_EQ(errors::Internal("Load error."), status);
+  });
+}
+
 // Tests cancelling load retries.
 TEST_P(BasicManagerTest, RetryOnLoadErrorCancelledLoad) {
   const ServableId id = {kServableName, 7};
@@ -1317,6 +1442,80 @@ TEST_F(ResourceConstrainedBasicManagerTest, ConcurrentLoads) {
   basic_manager_.reset();
 }
 
+// A loader whose first resource estimate calls into a blocking counter, and
+// which requires 3 resource units.
+class EstimateBarrierLoader : public Loader {
+ public:
+  explicit EstimateBarrierLoader(BlockingCounter* counter)
+      : counter_(counter) {}
+  ~EstimateBarrierLoader() override = default;
+
+  Status EstimateResources(ResourceAllocation* estimate) const override {
+    if (!estimated_.exchange(true)) {
+      counter_->DecrementCount();
+      counter_->Wait();
+    }
+    *estimate = CreateResourceQuantity(3);
+    return OkStatus();
+  }
+
+  Status Load() override { return OkStatus(); }
+
+  void Unload() override {}
+
+  AnyPtr servable() override { return AnyPtr(); }
+
+ private:
+  BlockingCounter* const counter_;
+  mutable std::atomic<bool> estimated_{false};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EstimateBarrierLoader);
+};
+
+TEST(BatchLoadApprovalTest, EstimatesResourcesConcurrently) {
+  std::shared_ptr<EventBus<ServableState>> servable_event_bus =
+      EventBus<ServableState>::CreateEventBus();
+  ServableStateMonitor servable_state_monitor(servable_event_bus.get());
+  BasicManager::Options options;
+  options.resource_tracker = CreateSimpleResourceTracker(10);
+  options.servable_event_bus = servable_event_bus.get();
+  options.num_load_threads = 3;
+  options.max_num_load_retries = 0;
+  options.enable_batch_load_approval = true;
+  std::unique_ptr<BasicManager> basic_manager;
+  TF_CHECK_OK(BasicManager::Create(std::move(options), &basic_manager));
+
+  // The first estimates only finish once all three of them have started, i.e.
+  // they don't run in the serialized decision phase. All three loads fit.
+  constexpr int kNumLoaders = 3;
+  BlockingCounter barrier(kNumLoaders);
+  for (int i = 0; i < kNumLoaders; ++i) {
+    const ServableId id = {"estimate_barrier", i};
+    TF_ASSERT_OK(basic_manager->ManageServable(CreateServableData(
+        id, std::unique_ptr<Loader>(new EstimateBarrierLoader(&barrier)))));
+    basic_manager->LoadServable(
+        id, [](const Status& status) { TF_EXPECT_OK(status); });
+  }
+  for (int i = 0; i < kNumLoaders; ++i) {
+    WaitUntilServableManagerStateIsOneOf(
+        servable_state_monitor, {"estimate_barrier", i},
+        {ServableState::ManagerState::kAvailable});
+  }
+
+  // A fourth servable doesn't fit anymore.
+  const ServableId id = {"estimate_barrier", kNumLoaders};
+  BlockingCounter single_barrier(1);
+  std::unique_ptr<Loader> loader(new EstimateBarrierLoader(&single_barrier));
+  TF_ASSERT_OK(
+      basic_manager->ManageServable(CreateServableData(id, std::move(loader))));
+  Notification done;
+  basic_manager->LoadServable(id, [&done](const Status& status) {
+    EXPECT_EQ(error::RESOURCE_EXHAUSTED, status.code());
+    done.Notify();
+  });
+  done.WaitForNotification();
+}
+
 TEST_F(ResourceConstrainedBasicManagerTest, InsufficientResources) {
   // A first loader that succeeds and consumes all of the serving system's
   // resources.
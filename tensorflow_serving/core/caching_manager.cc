@@ -28,10 +28,55 @@ limitations under the License.
 #include "tensorflow_serving/core/servable_data.h"
 #include "tensorflow_serving/core/servable_handle.h"
 #include "tensorflow_serving/core/servable_id.h"
+#include "tensorflow_serving/resources/resource_values.h"
+#include "tensorflow_serving/resources/resources.pb.h"
 
 namespace tensorflow {
 namespace serving {
 
+namespace {
+
+// Returns the main-memory RAM of 'allocation'.
+uint64_t MainRamBytes(const ResourceAllocation& allocation) {
+  uint64_t ram_bytes = 0;
+  for (const auto& entry : allocation.resource_quantities()) {
+    if (entry.resource().device() == device_types::kMain &&
+        entry.resource().kind() == resource_kinds::kRamBytes) {
+      ram_bytes += entry.quantity();
+    }
+  }
+  return ram_bytes;
+}
+
+}  // namespace
+
+class CachingManager::InUseHandle final : public UntypedServableHandle {
+ public:
+  InUseHandle(CachingManager* manager,
+              std::unique_ptr<UntypedServableHandle> handle)
+      : manager_(manager), handle_(std::move(handle)) {}
+
+  ~InUseHandle() override {
+    const ServableId id = handle_->id();
+    // Release the wrapped handle first, so that an eviction started by the
+    // release isn't blocked by it.
+    handle_.reset();
+    manager_->ReleaseUse(id);
+  }
+
+  const ServableId& id() const override { return handle_->id(); }
+
+  AnyPtr servable() override { return handle_->servable(); }
+
+  uint64_t load_generation() const override {
+    return handle_->load_generation();
+  }
+
+ private:
+  CachingManager* const manager_;
+  std::unique_ptr<UntypedServableHandle> handle_;
+};
+
 Status CachingManager::Create(
     Options options, std::unique_ptr<LoaderFactory> loader_factory,
     std::unique_ptr<CachingManager>* caching_manager) {
@@ -51,14 +96,18 @@ Status CachingManager::Create(
   TF_RETURN_IF_ERROR(
       BasicManager::Create(std::move(basic_manager_options), &basic_manager));
 
-  caching_manager->reset(
-      new CachingManager(std::move(loader_factory), std::move(basic_manager)));
+  caching_manager->reset(new CachingManager(
+      options, std::move(loader_factory), std::move(basic_manager)));
   return OkStatus();
 }
 
-CachingManager::CachingManager(std::unique_ptr<LoaderFactory> loader_factory,
+CachingManager::CachingManager(const Options& options,
+                               std::unique_ptr<LoaderFactory> loader_factory,
                                std::unique_ptr<BasicManager> basic_manager)
-    : loader_factory_(std::move(loader_factory)),
+    : max_num_loaded_servables_(options.max_num_loaded_servables),
+      max_loaded_ram_bytes_(options.max_loaded_ram_bytes),
+      eviction_policy_(options.eviction_policy),
+      loader_factory_(std::move(loader_factory)),
       basic_manager_(std::move(basic_manager)) {}
 
 CachingManager::~CachingManager() {}
@@ -88,6 +137,9 @@ Status CachingManager::GetUntypedServableHandleForId(
   // If the servable is already managed and loaded by the basic manager, serve
   // it.
   if (handle_status.ok() || handle_status.code() != error::NOT_FOUND) {
+    if (handle_status.ok() && bounded()) {
+      RecordUse(handle);
+    }
     return handle_status;
   }
 
@@ -102,24 +154,21 @@ Status CachingManager::GetUntypedServableHandleForId(
   TF_RETURN_IF_ERROR(LoadServable(std::move(loader_data)));
 
   // Return the handle using the loaded servable data now.
-  return basic_manager_->GetUntypedServableHandle(
-      ServableRequest::FromId(servable_id), handle);
+  TF_RETURN_IF_ERROR(basic_manager_->GetUntypedServableHandle(
+      ServableRequest::FromId(servable_id), handle));
+  if (bounded()) {
+    // The handle keeps the servable from being evicted to make room for it.
+    RecordUse(handle);
+    MaybeEvictServables(servable_id);
+  }
+  return OkStatus();
 }
 
 Status CachingManager::LoadServable(
     ServableData<std::unique_ptr<Loader>> loader_data) {
   const ServableId servable_id = loader_data.id();
 
-  std::shared_ptr<mutex> servable_id_mu;
-  {
-    mutex_lock l(load_mutex_map_mu_);
-    auto iter = load_mutex_map_.find(servable_id);
-    if (iter == load_mutex_map_.end()) {
-      iter =
-          load_mutex_map_.emplace(servable_id, std::make_shared<mutex>()).first;
-    }
-    servable_id_mu = iter->second;
-  }
+  std::shared_ptr<mutex> servable_id_mu = GetLoadMutex(servable_id);
 
   {
     // Ensure only one thread attempts to load the servable at a time.
@@ -150,6 +199,13 @@ Status CachingManager::LoadServable(
       // the functionality of the event-bus and the servable state monitor are
       // automatically available in the caching-manager as well (via the basic
       // manager).
+      uint64_t ram_bytes = 0;
+      if (bounded() && loader_data.status().ok()) {
+        ResourceAllocation estimate;
+        if (loader_data.DataOrDie()->EstimateResources(&estimate).ok()) {
+          ram_bytes = MainRamBytes(estimate);
+        }
+      }
       const Status manage_status =
           basic_manager_->ManageServable(std::move(loader_data));
       if (!manage_status.ok()) {
@@ -168,6 +224,10 @@ Status CachingManager::LoadServable(
       });
       load_done.WaitForNotification();
       TF_RETURN_IF_ERROR(load_status);
+      if (bounded()) {
+        mutex_lock l(usage_mu_);
+        usages_[servable_id].ram_bytes = ram_bytes;
+      }
     }
   }
   servable_id_mu.reset();
@@ -186,6 +246,118 @@ void CachingManager::MaybeEraseLoadMutexMapEntry(
   }
 }
 
+std::shared_ptr<mutex> CachingManager::GetLoadMutex(
+    const ServableId& servable_id) {
+  mutex_lock l(load_mutex_map_mu_);
+  auto iter = load_mutex_map_.find(servable_id);
+  if (iter == load_mutex_map_.end()) {
+    iter =
+        load_mutex_map_.emplace(servable_id, std::make_shared<mutex>()).first;
+  }
+  return iter->second;
+}
+
+void CachingManager::RecordUse(
+    std::unique_ptr<UntypedServableHandle>* const handle) {
+  mutex_lock l(usage_mu_);
+  auto it = usages_.find((*handle)->id());
+  if (it == usages_.end()) {
+    return;
+  }
+  ServableUsage& usage = it->second;
+  usage.last_use = ++use_clock_;
+  ++usage.num_uses;
+  ++usage.num_in_use;
+  handle->reset(new InUseHandle(this, std::move(*handle)));
+}
+
+void CachingManager::ReleaseUse(const ServableId& servable_id) {
+  mutex_lock l(usage_mu_);
+  // A servable in use isn't evicted, so its entry is still there.
+  auto it = usages_.find(servable_id);
+  DCHECK(it != usages_.end());
+  if (it != usages_.end()) {
+    --it->second.num_in_use;
+  }
+}
+
+void CachingManager::MaybeEvictServables(const ServableId& servable_id) {
+  // Returns true if 'a' is to be evicted before 'b'.
+  const auto evict_before = [this](const ServableUsage& a,
+                                   const ServableUsage& b) {
+    if (eviction_policy_ == EvictionPolicy::kLeastFrequentlyUsed &&
+        a.num_uses != b.num_uses) {
+      return a.num_uses < b.num_uses;
+    }
+    return a.last_use < b.last_use;
+  };
+  while (true) {
+    ServableId victim;
+    {
+      mutex_lock l(usage_mu_);
+      uint64_t total_ram_bytes = 0;
+      for (const auto& entry : usages_) {
+        total_ram_bytes += entry.second.ram_bytes;
+      }
+      if ((max_num_loaded_servables_ == 0 ||
+           usages_.size() <= max_num_loaded_servables_) &&
+          (max_loaded_ram_bytes_ == 0 ||
+           total_ram_bytes <= max_loaded_ram_bytes_)) {
+        return;
+      }
+      auto victim_it = usages_.end();
+      for (auto it = usages_.begin(); it != usages_.end(); ++it) {
+        if (it->first == servable_id || it->second.num_in_use > 0) {
+          continue;
+        }
+        if (victim_it == usages_.end() ||
+            evict_before(it->second, victim_it->second)) {
+          victim_it = it;
+        }
+      }
+      if (victim_it == usages_.end()) {
+        VLOG(1) << "Caching manager is over its bounds, but has no idle "
+                   "servable to evict";
+        return;
+      }
+      victim = victim_it->first;
+      // Stop tracking the servable, so that it can't be picked again and isn't
+      // counted as in use in the meantime.
+      usages_.erase(victim_it);
+    }
+    EvictServable(victim);
+  }
+}
+
+void CachingManager::EvictServable(const ServableId& servable_id) {
+  VLOG(1) << "Evicting servable " << servable_id;
+  std::shared_ptr<mutex> servable_id_mu = GetLoadMutex(servable_id);
+  {
+    // Requests for the servable that find it unloaded block on the mutex until
+    // it is no longer managed, and then load it again.
+    mutex_lock l(*servable_id_mu);
+    Notification unload_done;
+    Status unload_status;
+    basic_manager_->UnloadServable(servable_id, [&](const Status& status) {
+      unload_status = status;
+      unload_done.Notify();
+    });
+    unload_done.WaitForNotification();
+    if (!unload_status.ok()) {
+      LOG(ERROR) << "Failed to evict servable " << servable_id << ": "
+                 << unload_status;
+    }
+    const Status stop_status =
+        basic_manager_->StopManagingServable(servable_id);
+    if (!stop_status.ok()) {
+      LOG(ERROR) << "Failed to stop managing evicted servable "
+                 << servable_id << ": " << stop_status;
+    }
+  }
+  servable_id_mu.reset();
+  MaybeEraseLoadMutexMapEntry(servable_id);
+}
+
 int64_t CachingManager::GetLoadMutexMapSize() const {
   mutex_lock l(load_mutex_map_mu_);
   return load_mutex_map_.size();
@@ -39,11 +39,23 @@ class CachingManagerTestAccess;
 ///
 /// The manager blocks on the load operation and returns the handle when the
 /// servable has been loaded, or upon error.
-//
-// TODO(b/25449742): Add support for evictions of loaded servables from the
-// caching-manager.
+///
+/// The manager can optionally be bounded by the number of loaded servables
+/// and by their estimated RAM. When a load takes it over a bound, it evicts
+/// (unloads) idle servables, i.e. ones without outstanding handles, in the
+/// order of the eviction policy until it is back within the bounds. An evicted
+/// servable is loaded again by the next request for it.
 class CachingManager : public Manager {
  public:
+  /// The order in which idle servables are evicted.
+  enum class EvictionPolicy {
+    /// The servable whose last handle was requested the longest ago first.
+    kLeastRecentlyUsed,
+    /// The servable with the fewest handle requests since its load first,
+    /// breaking ties by least recent use.
+    kLeastFrequentlyUsed,
+  };
+
   /// Config options and pluggable objects that will be used by the
   /// CachingManager.
   struct Options {
@@ -76,6 +88,19 @@ class CachingManager : public Manager {
 
     // The environment to use for starting threads in the thread-pool.
     Env* env = Env::Default();
+
+    // The maximum number of servables to keep loaded. If set to 0, the number
+    // is unbounded.
+    uint32 max_num_loaded_servables = 0;
+
+    // The maximum sum of the main-memory RAM estimates (see
+    // Loader::EstimateResources()) of the servables to keep loaded. If set to
+    // 0, the RAM is unbounded.
+    uint64_t max_loaded_ram_bytes = 0;
+
+    // The order in which idle servables are evicted when one of the bounds
+    // above is exceeded.
+    EvictionPolicy eviction_policy = EvictionPolicy::kLeastRecentlyUsed;
   };
 
   /// An abstraction for a loader-factory to map from a servable request to the
@@ -111,9 +136,31 @@ class CachingManager : public Manager {
  private:
   friend class test_util::CachingManagerTestAccess;
 
-  CachingManager(std::unique_ptr<LoaderFactory> loader_factory,
+  // A handle that counts as an outstanding use of its servable, which keeps
+  // the servable from being evicted, until it is destroyed.
+  class InUseHandle;
+
+  // The usage of a loaded servable, tracked when the manager is bounded.
+  struct ServableUsage {
+    // The value of 'use_clock_' at the last handle request.
+    uint64_t last_use = 0;
+    // The number of handle requests since the servable was loaded.
+    uint64_t num_uses = 0;
+    // The number of outstanding handles.
+    int64_t num_in_use = 0;
+    // The main-memory RAM estimate of the servable.
+    uint64_t ram_bytes = 0;
+  };
+
+  CachingManager(const Options& options,
+                 std::unique_ptr<LoaderFactory> loader_factory,
                  std::unique_ptr<BasicManager> basic_manager);
 
+  // Returns true if the number of loaded servables or their RAM is bounded.
+  bool bounded() const {
+    return max_num_loaded_servables_ > 0 || max_loaded_ram_bytes_ > 0;
+  }
+
   // Returns the untyped handle for the servable request.
   //
   // Semantics related to a ServableRequest for "latest":
@@ -144,6 +191,33 @@ class CachingManager : public Manager {
   // only one remaining reference to the mutex.
   void MaybeEraseLoadMutexMapEntry(const ServableId& servable_id);
 
+  // Returns the mutex of 'load_mutex_map_' for the servable-id, adding it if
+  // needed.
+  std::shared_ptr<mutex> GetLoadMutex(const ServableId& servable_id)
+      TF_LOCKS_EXCLUDED(load_mutex_map_mu_);
+
+  // Records a handle request for a tracked servable, and wraps 'handle' so that
+  // it counts as in use. Leaves 'handle' alone if the servable isn't tracked,
+  // e.g. since it is being evicted.
+  void RecordUse(std::unique_ptr<UntypedServableHandle>* handle)
+      TF_LOCKS_EXCLUDED(usage_mu_);
+
+  // Called by InUseHandle upon destruction.
+  void ReleaseUse(const ServableId& servable_id) TF_LOCKS_EXCLUDED(usage_mu_);
+
+  // Evicts idle servables other than 'servable_id' until the manager is within
+  // its bounds, or no idle servable is left.
+  void MaybeEvictServables(const ServableId& servable_id)
+      TF_LOCKS_EXCLUDED(usage_mu_, load_mutex_map_mu_);
+
+  // Unloads the servable and stops managing it.
+  void EvictServable(const ServableId& servable_id)
+      TF_LOCKS_EXCLUDED(load_mutex_map_mu_);
+
+  const uint32 max_num_loaded_servables_;
+  const uint64_t max_loaded_ram_bytes_;
+  const EvictionPolicy eviction_policy_;
+
   std::unique_ptr<LoaderFactory> loader_factory_;
 
   std::unique_ptr<BasicManager> basic_manager_;
@@ -158,6 +232,15 @@ class CachingManager : public Manager {
   std::map<ServableId, std::shared_ptr<mutex>> load_mutex_map_
       TF_GUARDED_BY(load_mutex_map_mu_);
 
+  mutable mutex usage_mu_;
+
+  // The usage of the servables loaded by this manager that aren't being
+  // evicted. Only used if the manager is bounded.
+  std::map<ServableId, ServableUsage> usages_ TF_GUARDED_BY(usage_mu_);
+
+  // Incremented at every handle request of a tracked servable.
+  uint64_t use_clock_ TF_GUARDED_BY(usage_mu_) = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(CachingManager);
 };
 
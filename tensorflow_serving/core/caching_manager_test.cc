@@ -35,6 +35,8 @@ limitations under the License.
 #include "tensorflow_serving/core/simple_loader.h"
 #include "tensorflow_serving/core/test_util/fake_loader_source_adapter.h"
 #include "tensorflow_serving/core/test_util/manager_test_util.h"
+#include "tensorflow_serving/resources/resource_values.h"
+#include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/util/event_bus.h"
 #include "tensorflow_serving/util/threadpool_executor.h"
 
@@ -67,9 +69,20 @@ class StringLoaderFactory : public CachingManager::LoaderFactory {
       **servable = strings::StrCat(id.name, "-", id.version);
       return OkStatus();
     };
+    const uint64_t ram_bytes = ram_bytes_per_servable();
+    auto resource_estimator = [ram_bytes](ResourceAllocation* estimate) {
+      estimate->Clear();
+      if (ram_bytes > 0) {
+        auto* entry = estimate->add_resource_quantities();
+        entry->mutable_resource()->set_device(device_types::kMain);
+        entry->mutable_resource()->set_kind(resource_kinds::kRamBytes);
+        entry->set_quantity(ram_bytes);
+      }
+      return OkStatus();
+    };
     std::unique_ptr<Loader> loader;
-    loader.reset(new SimpleLoader<string>(
-        servable_creator, SimpleLoader<string>::EstimateNoResources()));
+    loader.reset(
+        new SimpleLoader<string>(servable_creator, resource_estimator));
     return ServableData<std::unique_ptr<Loader>>(id, std::move(loader));
   }
 
@@ -104,6 +117,17 @@ class StringLoaderFactory : public CachingManager::LoaderFactory {
     return num_loaders_dispensed_;
   }
 
+  // Sets the main-memory RAM estimate of the servables created from now on.
+  void set_ram_bytes_per_servable(uint64_t ram_bytes) {
+    mutex_lock l(mu_);
+    ram_bytes_per_servable_ = ram_bytes;
+  }
+
+  uint64_t ram_bytes_per_servable() const {
+    mutex_lock l(mu_);
+    return ram_bytes_per_servable_;
+  }
+
  private:
   // Used to protect updates to 'earliest_version_' and 'latest_version_'.
   mutable mutex mu_;
@@ -117,6 +141,9 @@ class StringLoaderFactory : public CachingManager::LoaderFactory {
   // Tracks the number of loaders dispensed by the loader-factory.
   int64_t num_loaders_dispensed_ TF_GUARDED_BY(mu_) = 0;
 
+  // The main-memory RAM estimate of the servables.
+  uint64_t ram_bytes_per_servable_ TF_GUARDED_BY(mu_) = 0;
+
   TF_DISALLOW_COPY_AND_ASSIGN(StringLoaderFactory);
 };
 
@@ -132,9 +159,20 @@ class ErrorLoaderFactory : public CachingManager::LoaderFactory {
     auto servable_creator = [&](std::unique_ptr<string>* servable) {
       return errors::Unknown("error loader-factory");
     };
+    const uint64_t ram_bytes = ram_bytes_per_servable();
+    auto resource_estimator = [ram_bytes](ResourceAllocation* estimate) {
+      estimate->Clear();
+      if (ram_bytes > 0) {
+        auto* entry = estimate->add_resource_quantities();
+        entry->mutable_resource()->set_device(device_types::kMain);
+        entry->mutable_resource()->set_kind(resource_kinds::kRamBytes);
+        entry->set_quantity(ram_bytes);
+      }
+      return OkStatus();
+    };
     std::unique_ptr<Loader> loader;
-    loader.reset(new SimpleLoader<string>(
-        servable_creator, SimpleLoader<string>::EstimateNoResources()));
+    loader.reset(
+        new SimpleLoader<string>(servable_creator, resource_estimator));
     return ServableData<std::unique_ptr<Loader>>(id, std::move(loader));
   }
 
@@ -203,6 +241,41 @@ class CachingManagerTest : public ::testing::TestWithParam<ThreadPoolSizes> {
     return error_manager;
   }
 
+  // Replaces 'manager_' with a manager bounded as given, whose servables have
+  // the given RAM estimate.
+  void ResetManagerWithBounds(uint32 max_num_loaded_servables,
+                              uint64_t max_loaded_ram_bytes,
+                              CachingManager::EvictionPolicy eviction_policy,
+                              uint64_t ram_bytes_per_servable = 0) {
+    manager_.reset();
+    CachingManager::Options options;
+    options.env = Env::Default();
+    options.servable_event_bus = servable_event_bus_.get();
+    options.num_load_threads = GetParam().num_load_threads;
+    options.num_unload_threads = GetParam().num_unload_threads;
+    options.max_num_load_retries = 1;
+    options.load_retry_interval_micros = 0;
+    options.max_num_loaded_servables = max_num_loaded_servables;
+    options.max_loaded_ram_bytes = max_loaded_ram_bytes;
+    options.eviction_policy = eviction_policy;
+
+    std::unique_ptr<StringLoaderFactory> string_loader_factory;
+    string_loader_factory.reset(new StringLoaderFactory(0));
+    string_loader_factory->set_ram_bytes_per_servable(ram_bytes_per_servable);
+    string_loader_factory_ = string_loader_factory.get();
+
+    TF_CHECK_OK(CachingManager::Create(
+        std::move(options), std::move(string_loader_factory), &manager_));
+  }
+
+  // Requests a handle to the servable, and drops it right away.
+  void UseServable(const ServableId& id) {
+    ServableHandle<string> handle;
+    TF_ASSERT_OK(
+        manager_->GetServableHandle(ServableRequest::FromId(id), &handle));
+    EXPECT_EQ(strings::StrCat(id.name, "-", id.version), *handle);
+  }
+
   // Helper function to return the size of the load-mutex map from the
   // caching-manager.
   int64_t GetLoadMutexMapSize() {
@@ -580,6 +653,106 @@ TEST_P(CachingManagerTest, ConcurrentIntersectingRequests) {
   EXPECT_EQ(0, GetLoadMutexMapSize());
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Eviction.
+
+TEST_P(CachingManagerTest, EvictsLeastRecentlyUsedServable) {
+  ResetManagerWithBounds(/*max_num_loaded_servables=*/2,
+                         /*max_loaded_ram_bytes=*/0,
+                         CachingManager::EvictionPolicy::kLeastRecentlyUsed);
+  const ServableId id_a = {kServableName, 1};
+  const ServableId id_b = {kServableName, 2};
+  const ServableId id_c = {kServableName, 3};
+  UseServable(id_a);
+  UseServable(id_b);
+  UseServable(id_a);
+  UseServable(id_c);
+  EXPECT_THAT(manager_->ListAvailableServableIds(),
+              UnorderedElementsAreArray({id_a, id_c}));
+  EXPECT_EQ(3, string_loader_factory_->num_loaders_dispensed());
+
+  // The evicted servable is loaded again on demand.
+  UseServable(id_b);
+  EXPECT_THAT(manager_->ListAvailableServableIds(),
+              UnorderedElementsAreArray({id_b, id_c}));
+  EXPECT_EQ(4, string_loader_factory_->num_loaders_dispensed());
+  EXPECT_EQ(0, GetLoadMutexMapSize());
+}
+
+TEST_P(CachingManagerTest, EvictsLeastFrequentlyUsedServable) {
+  ResetManagerWithBounds(/*max_num_loaded_servables=*/2,
+                         /*max_loaded_ram_bytes=*/0,
+                         CachingManager::EvictionPolicy::kLeastFrequentlyUsed);
+  const ServableId id_a = {kServableName, 1};
+  const ServableId id_b = {kServableName, 2};
+  const ServableId id_c = {kServableName, 3};
+  UseServable(id_a);
+  UseServable(id_a);
+  UseServable(id_b);
+  UseServable(id_c);
+  EXPECT_THAT(manager_->ListAvailableServableIds(),
+              UnorderedElementsAreArray({id_a, id_c}));
+}
+
+TEST_P(CachingManagerTest, EvictsToStayWithinRamBound) {
+  ResetManagerWithBounds(/*max_num_loaded_servables=*/0,
+                         /*max_loaded_ram_bytes=*/250,
+                         CachingManager::EvictionPolicy::kLeastRecentlyUsed,
+                         /*ram_bytes_per_servable=*/100);
+  const ServableId id_a = {kServableName, 1};
+  const ServableId id_b = {kServableName, 2};
+  const ServableId id_c = {kServableName, 3};
+  UseServable(id_a);
+  UseServable(id_b);
+  EXPECT_EQ(2, manager_->ListAvailableServableIds().size());
+  UseServable(id_c);
+  EXPECT_THAT(manager_->ListAvailableServableIds(),
+              UnorderedElementsAreArray({id_b, id_c}));
+}
+
+TEST_P(CachingManagerTest, DoesNotEvictServablesInUse) {
+  ResetManagerWithBounds(/*max_num_loaded_servables=*/1,
+                         /*max_loaded_ram_bytes=*/0,
+                         CachingManager::EvictionPolicy::kLeastRecentlyUsed);
+  const ServableId id_a = {kServableName, 1};
+  const ServableId id_b = {kServableName, 2};
+  const ServableId id_c = {kServableName, 3};
+  {
+    ServableHandle<string> handle_a;
+    TF_ASSERT_OK(
+        manager_->GetServableHandle(ServableRequest::FromId(id_a), &handle_a));
+    // The manager goes over its bound rather than evict 'id_a'.
+    UseServable(id_b);
+    EXPECT_THAT(manager_->ListAvailableServableIds(),
+                UnorderedElementsAreArray({id_a, id_b}));
+    EXPECT_EQ("kServableName-1", *handle_a);
+  }
+  // Once idle, both go to make room for the next load.
+  UseServable(id_c);
+  EXPECT_THAT(manager_->ListAvailableServableIds(),
+              UnorderedElementsAreArray({id_c}));
+}
+
+TEST_P(CachingManagerTest, ConcurrentRequestsWithEviction) {
+  ResetManagerWithBounds(/*max_num_loaded_servables=*/2,
+                         /*max_loaded_ram_bytes=*/0,
+                         CachingManager::EvictionPolicy::kLeastRecentlyUsed);
+  {
+    ThreadPoolExecutor request_executor(Env::Default(), "GetHandles",
+                                        kNumThreads);
+    for (int i = 0; i < 40; ++i) {
+      request_executor.Schedule([this, i]() {
+        UseServable({kServableName, i % 5});
+      });
+    }
+  }
+  // Loads that raced with requests may have left the manager over its bound,
+  // until the next load.
+  UseServable({kServableName, 5});
+  EXPECT_EQ(2, manager_->ListAvailableServableIds().size());
+  EXPECT_EQ(0, GetLoadMutexMapSize());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 TEST(PathPrefixLoaderFactoryTest, Basic) {
@@ -0,0 +1,247 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/columnar_log_collector.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr int kDefaultMaxLogsPerBatch = 1024;
+constexpr int64_t kDefaultMaxFileBytes = 256 << 20;
+
+// Returns the compression type of RecordWriterOptions for 'config'.
+string GetCompressionType(const ColumnarLogCollectorConfig& config) {
+  if (config.compression_type().empty()) {
+    return "ZLIB";
+  }
+  if (config.compression_type() == "NONE") {
+    return "";
+  }
+  return config.compression_type();
+}
+
+Status CreateColumnarLogCollector(
+    const LogCollectorConfig& config, const uint32 id,
+    std::unique_ptr<LogCollector>* const log_collector) {
+  return ColumnarLogCollector::Create(config, id, Env::Default(),
+                                      log_collector);
+}
+
+}  // namespace
+
+Status ColumnarLogCollector::Create(
+    const LogCollectorConfig& config, const uint32 id, Env* const env,
+    std::unique_ptr<LogCollector>* const log_collector) {
+  if (config.filename_prefix().empty()) {
+    return errors::InvalidArgument(
+        "The columnar log collector needs a filename_prefix");
+  }
+  const string& compression_type =
+      config.columnar_config().compression_type();
+  if (!compression_type.empty() && compression_type != "ZLIB" &&
+      compression_type != "GZIP" && compression_type != "NONE") {
+    return errors::InvalidArgument("Invalid compression_type: ",
+                                   compression_type);
+  }
+  log_collector->reset(new ColumnarLogCollector(config, id, env));
+  return OkStatus();
+}
+
+ColumnarLogCollector::ColumnarLogCollector(const LogCollectorConfig& config,
+                                           const uint32 id, Env* const env)
+    : filename_prefix_(config.filename_prefix()),
+      id_(id),
+      env_(env),
+      max_logs_per_batch_(config.columnar_config().max_logs_per_batch() > 0
+                              ? config.columnar_config().max_logs_per_batch()
+                              : kDefaultMaxLogsPerBatch),
+      max_file_bytes_(config.columnar_config().max_file_bytes() > 0
+                          ? config.columnar_config().max_file_bytes()
+                          : kDefaultMaxFileBytes),
+      max_file_age_micros_(config.columnar_config().max_file_age_secs() *
+                           1000 * 1000),
+      compression_type_(GetCompressionType(config.columnar_config())) {}
+
+ColumnarLogCollector::~ColumnarLogCollector() {
+  mutex_lock l(mu_);
+  Status status = WriteBatch();
+  status.Update(CloseFile());
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to write the columnar logs of " << filename_prefix_
+               << ": " << status;
+  }
+}
+
+Status ColumnarLogCollector::CollectMessage(
+    const google::protobuf::Message& message) {
+  mutex_lock l(mu_);
+  return Collect(message);
+}
+
+Status ColumnarLogCollector::CollectMessages(
+    const std::vector<const google::protobuf::Message*>& messages) {
+  mutex_lock l(mu_);
+  Status status;
+  for (const google::protobuf::Message* message : messages) {
+    status.Update(Collect(*message));
+  }
+  return status;
+}
+
+Status ColumnarLogCollector::Flush() {
+  mutex_lock l(mu_);
+  TF_RETURN_IF_ERROR(WriteBatch());
+  if (writer_ != nullptr) {
+    TF_RETURN_IF_ERROR(writer_->Flush());
+  }
+  return OkStatus();
+}
+
+Status ColumnarLogCollector::Collect(
+    const google::protobuf::Message& message) {
+  if (message.GetDescriptor() != PredictionLog::descriptor()) {
+    return errors::InvalidArgument(
+        "The columnar log collector only collects PredictionLogs, not ",
+        message.GetDescriptor()->full_name());
+  }
+  const PredictionLog& log = static_cast<const PredictionLog&>(message);
+
+  const int64_t log_index = batch_.num_logs();
+  const ModelSpec& model_spec = log.log_metadata().model_spec();
+  batch_.add_model_name(model_spec.name());
+  batch_.add_model_version(model_spec.version().value());
+  batch_.add_signature_name(model_spec.signature_name());
+  batch_.add_timestamp_secs(log.log_metadata().timestamp_secs());
+  batch_.set_num_logs(log_index + 1);
+
+  // The tensors of a log are all added to columns, or the log is kept whole.
+  std::vector<ParsedTensor> inputs, outputs;
+  if (log.has_predict_log() &&
+      ParseTensors(log.predict_log().request().inputs(), batch_.inputs(),
+                   &inputs) &&
+      ParseTensors(log.predict_log().response().outputs(), batch_.outputs(),
+                   &outputs)) {
+    AddToColumns(inputs, log_index, batch_.mutable_inputs());
+    AddToColumns(outputs, log_index, batch_.mutable_outputs());
+  } else {
+    batch_.add_other_log_index(log_index);
+    *batch_.add_other_logs() = log;
+  }
+
+  if (batch_.num_logs() >= max_logs_per_batch_) {
+    return WriteBatch();
+  }
+  return OkStatus();
+}
+
+bool ColumnarLogCollector::ParseTensors(
+    const google::protobuf::Map<string, TensorProto>& tensors,
+    const google::protobuf::Map<string, TensorColumn>& columns,
+    std::vector<ParsedTensor>* const parsed) {
+  parsed->reserve(tensors.size());
+  for (const auto& entry : tensors) {
+    Tensor tensor;
+    if (!tensor.FromProto(entry.second)) {
+      return false;
+    }
+    if (tensor.dtype() != DT_STRING && !DataTypeCanUseMemcpy(tensor.dtype())) {
+      return false;
+    }
+    const auto column = columns.find(entry.first);
+    if (column != columns.end() && column->second.dtype() != tensor.dtype()) {
+      return false;
+    }
+    parsed->emplace_back(&entry.first, std::move(tensor));
+  }
+  return true;
+}
+
+void ColumnarLogCollector::AddToColumns(
+    const std::vector<ParsedTensor>& parsed, const int64_t log_index,
+    google::protobuf::Map<string, TensorColumn>* const columns) {
+  for (const ParsedTensor& entry : parsed) {
+    const Tensor& tensor = entry.second;
+    TensorColumn* const column = &(*columns)[*entry.first];
+    column->set_dtype(tensor.dtype());
+    column->add_log_index(log_index);
+    tensor.shape().AsProto(column->add_shape());
+    if (tensor.dtype() == DT_STRING) {
+      for (const tstring& value : tensor.flat<tstring>()) {
+        column->add_string_val(value.data(), value.size());
+      }
+    } else {
+      const StringPiece content = tensor.tensor_data();
+      column->mutable_content()->append(content.data(), content.size());
+    }
+  }
+}
+
+Status ColumnarLogCollector::WriteBatch() {
+  if (batch_.num_logs() == 0) {
+    return OkStatus();
+  }
+  if (writer_ != nullptr && max_file_age_micros_ > 0 &&
+      env_->NowMicros() - file_start_micros_ >=
+          static_cast<uint64_t>(max_file_age_micros_)) {
+    TF_RETURN_IF_ERROR(CloseFile());
+  }
+  if (writer_ == nullptr) {
+    file_start_micros_ = env_->NowMicros();
+    const string filename = strings::StrCat(filename_prefix_, "-", id_, "-",
+                                            file_start_micros_, ".columnar");
+    TF_RETURN_IF_ERROR(env_->NewWritableFile(filename, &file_));
+    writer_ = std::make_unique<io::RecordWriter>(
+        file_.get(),
+        io::RecordWriterOptions::CreateRecordWriterOptions(compression_type_));
+    file_bytes_ = 0;
+  }
+
+  string record;
+  batch_.SerializeToString(&record);
+  batch_.Clear();
+  TF_RETURN_IF_ERROR(writer_->WriteRecord(record));
+  file_bytes_ += record.size();
+  if (file_bytes_ >= max_file_bytes_) {
+    TF_RETURN_IF_ERROR(CloseFile());
+  }
+  return OkStatus();
+}
+
+Status ColumnarLogCollector::CloseFile() {
+  if (writer_ == nullptr) {
+    return OkStatus();
+  }
+  Status status = writer_->Close();
+  status.Update(file_->Close());
+  writer_.reset();
+  file_.reset();
+  return status;
+}
+
+REGISTER_LOG_COLLECTOR("columnar", CreateColumnarLogCollector);
+
+}  // namespace serving
+}  // namespace tensorflow
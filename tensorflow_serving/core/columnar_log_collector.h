@@ -0,0 +1,127 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_CORE_COLUMNAR_LOG_COLLECTOR_H_
+#define TENSORFLOW_SERVING_CORE_COLUMNAR_LOG_COLLECTOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/map.h"
+#include "google/protobuf/message.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/apis/columnar_prediction_log.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/config/log_collector_config.pb.h"
+#include "tensorflow_serving/core/log_collector.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A LogCollector of PredictionLogs, registered as the "columnar" type, which
+// buffers the logs and writes them by column, in ColumnarPredictionLogBatch
+// records: the tensors of PredictRequests and PredictResponses with the same
+// name and type (i.e. of the same signature) are stored together, and
+// offline analyses don't convert the logs to columns themselves.
+//
+// The batches are written to compressed TFRecord files named
+// '<filename_prefix>-<id>-<micros>.columnar', where <micros> is when the
+// file was started. A new file is started once a file grows past
+// max_file_bytes, or is older than max_file_age_secs (see
+// ColumnarLogCollectorConfig).
+//
+// Buffered logs are written once there are max_logs_per_batch of them, on
+// Flush(), and on destruction.
+//
+// This class is thread-safe.
+class ColumnarLogCollector : public LogCollector {
+ public:
+  static Status Create(const LogCollectorConfig& config, uint32 id, Env* env,
+                       std::unique_ptr<LogCollector>* log_collector);
+
+  // Writes the buffered logs.
+  ~ColumnarLogCollector() override;
+
+  // 'message' must be a PredictionLog.
+  Status CollectMessage(const google::protobuf::Message& message) override;
+  Status CollectMessages(
+      const std::vector<const google::protobuf::Message*>& messages) override;
+
+  // Writes the buffered logs, and flushes the file.
+  Status Flush() override;
+
+ private:
+  ColumnarLogCollector(const LogCollectorConfig& config, uint32 id, Env* env);
+
+  // Adds 'message' to the batch, and writes the batch if it's full.
+  Status Collect(const google::protobuf::Message& message)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // A tensor of a log, and its name.
+  using ParsedTensor = std::pair<const string*, Tensor>;
+
+  // Parses 'tensors' into 'parsed'. Returns false if any of them doesn't fit
+  // its column of 'columns', e.g. has another type.
+  static bool ParseTensors(
+      const google::protobuf::Map<string, TensorProto>& tensors,
+      const google::protobuf::Map<string, TensorColumn>& columns,
+      std::vector<ParsedTensor>* parsed);
+
+  // Adds the tensors of the log at 'log_index' to their columns.
+  static void AddToColumns(
+      const std::vector<ParsedTensor>& parsed, int64_t log_index,
+      google::protobuf::Map<string, TensorColumn>* columns);
+
+  // Writes the batch, if it has logs, starting and finishing files as
+  // needed.
+  Status WriteBatch() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Status CloseFile() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string filename_prefix_;
+  const uint32 id_;
+  Env* const env_;
+  const int max_logs_per_batch_;
+  const int64_t max_file_bytes_;
+  const int64_t max_file_age_micros_;
+  const string compression_type_;
+
+  mutex mu_;
+
+  ColumnarPredictionLogBatch batch_ TF_GUARDED_BY(mu_);
+
+  // The file being written, if any, and how much was written to it.
+  std::unique_ptr<WritableFile> file_ TF_GUARDED_BY(mu_);
+  std::unique_ptr<io::RecordWriter> writer_ TF_GUARDED_BY(mu_);
+  int64_t file_bytes_ TF_GUARDED_BY(mu_) = 0;
+  uint64_t file_start_micros_ TF_GUARDED_BY(mu_) = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ColumnarLogCollector);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_CORE_COLUMNAR_LOG_COLLECTOR_H_
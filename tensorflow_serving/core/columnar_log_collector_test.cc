@@ -0,0 +1,152 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/columnar_log_collector.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/apis/columnar_prediction_log.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/config/log_collector_config.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::ElementsAre;
+
+PredictionLog CreatePredictLog(const string& model_name, const float x,
+                               const string& y) {
+  PredictionLog log;
+  log.mutable_log_metadata()->mutable_model_spec()->set_name(model_name);
+  PredictLog* const predict_log = log.mutable_predict_log();
+  test::AsTensor<float>({x, x}, {1, 2}).AsProtoTensorContent(
+      &(*predict_log->mutable_request()->mutable_inputs())["x"]);
+  test::AsTensor<tstring>({y}).AsProtoField(
+      &(*predict_log->mutable_response()->mutable_outputs())["y"]);
+  return log;
+}
+
+// Reads the batches of the files of 'filename_prefix', in order.
+std::vector<ColumnarPredictionLogBatch> ReadBatches(
+    const string& filename_prefix) {
+  std::vector<string> filenames;
+  TF_CHECK_OK(
+      Env::Default()->GetMatchingPaths(filename_prefix + "*", &filenames));
+  std::sort(filenames.begin(), filenames.end());
+  std::vector<ColumnarPredictionLogBatch> batches;
+  for (const string& filename : filenames) {
+    std::unique_ptr<RandomAccessFile> file;
+    TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename, &file));
+    io::SequentialRecordReader reader(
+        file.get(), io::RecordReaderOptions::CreateRecordReaderOptions("ZLIB"));
+    tstring record;
+    while (reader.ReadRecord(&record).ok()) {
+      batches.emplace_back();
+      CHECK(batches.back().ParseFromArray(record.data(), record.size()));
+    }
+  }
+  return batches;
+}
+
+TEST(ColumnarLogCollectorTest, WritesLogsByColumn) {
+  LogCollectorConfig config;
+  config.set_type("columnar");
+  config.set_filename_prefix(
+      io::JoinPath(testing::TmpDir(), "WritesLogsByColumn"));
+  std::unique_ptr<LogCollector> log_collector;
+  TF_ASSERT_OK(LogCollector::Create(config, 7, &log_collector));
+
+  const PredictionLog log0 = CreatePredictLog("m", 1, "a");
+  const PredictionLog log1 = CreatePredictLog("m", 2, "b");
+  PredictionLog classify_log;
+  classify_log.mutable_log_metadata()->mutable_model_spec()->set_name("c");
+  classify_log.mutable_classify_log();
+  TF_ASSERT_OK(log_collector->CollectMessages({&log0, &classify_log, &log1}));
+  TF_ASSERT_OK(log_collector->Flush());
+
+  const std::vector<ColumnarPredictionLogBatch> batches =
+      ReadBatches(config.filename_prefix());
+  ASSERT_EQ(1, batches.size());
+  const ColumnarPredictionLogBatch& batch = batches[0];
+  EXPECT_EQ(3, batch.num_logs());
+  EXPECT_THAT(batch.model_name(), ElementsAre("m", "c", "m"));
+
+  const TensorColumn& x = batch.inputs().at("x");
+  EXPECT_EQ(DT_FLOAT, x.dtype());
+  EXPECT_THAT(x.log_index(), ElementsAre(0, 2));
+  ASSERT_EQ(4 * sizeof(float), x.content().size());
+  const float* values = reinterpret_cast<const float*>(x.content().data());
+  EXPECT_THAT(std::vector<float>(values, values + 4),
+              ElementsAre(1, 1, 2, 2));
+  EXPECT_THAT(batch.outputs().at("y").string_val(), ElementsAre("a", "b"));
+
+  // Logs that don't fit in columns are kept whole.
+  EXPECT_THAT(batch.other_log_index(), ElementsAre(1));
+  ASSERT_EQ(1, batch.other_logs_size());
+  EXPECT_TRUE(batch.other_logs(0).has_classify_log());
+
+  EXPECT_FALSE(log_collector->CollectMessage(TensorProto()).ok());
+}
+
+TEST(ColumnarLogCollectorTest, RotatesFilesBySize) {
+  LogCollectorConfig config;
+  config.set_filename_prefix(
+      io::JoinPath(testing::TmpDir(), "RotatesFilesBySize"));
+  config.mutable_columnar_config()->set_max_logs_per_batch(1);
+  config.mutable_columnar_config()->set_max_file_bytes(1);
+  std::unique_ptr<LogCollector> log_collector;
+  TF_ASSERT_OK(ColumnarLogCollector::Create(config, 0, Env::Default(),
+                                            &log_collector));
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(log_collector->CollectMessage(CreatePredictLog("m", i, "")));
+    // Files are named by the microsecond they're started at.
+    Env::Default()->SleepForMicroseconds(10);
+  }
+  log_collector.reset();
+
+  std::vector<string> filenames;
+  TF_ASSERT_OK(Env::Default()->GetMatchingPaths(
+      config.filename_prefix() + "*", &filenames));
+  EXPECT_EQ(3, filenames.size());
+  EXPECT_EQ(3, ReadBatches(config.filename_prefix()).size());
+}
+
+TEST(ColumnarLogCollectorTest, InvalidConfig) {
+  std::unique_ptr<LogCollector> log_collector;
+  LogCollectorConfig config;
+  EXPECT_FALSE(ColumnarLogCollector::Create(config, 0, Env::Default(),
+                                            &log_collector)
+                   .ok());
+  config.set_filename_prefix("/tmp/logs");
+  config.mutable_columnar_config()->set_compression_type("LZ4");
+  EXPECT_FALSE(ColumnarLogCollector::Create(config, 0, Env::Default(),
+                                            &log_collector)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
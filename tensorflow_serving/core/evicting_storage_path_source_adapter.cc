@@ -0,0 +1,105 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/evicting_storage_path_source_adapter.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+EvictingStoragePathSourceAdapter::~EvictingStoragePathSourceAdapter() {
+  Detach();
+}
+
+void EvictingStoragePathSourceAdapter::Evict(const string& servable_name) {
+  {
+    mutex_lock l(mu_);
+    if (aspired_versions_.count(servable_name) == 0 ||
+        !evicted_.insert(servable_name).second) {
+      return;
+    }
+  }
+  LOG(INFO) << "Evicting servable " << servable_name;
+  ReaspireVersions(servable_name);
+}
+
+void EvictingStoragePathSourceAdapter::Restore(const string& servable_name) {
+  {
+    mutex_lock l(mu_);
+    if (evicted_.erase(servable_name) == 0) {
+      return;
+    }
+  }
+  LOG(INFO) << "Restoring evicted servable " << servable_name;
+  ReaspireVersions(servable_name);
+}
+
+bool EvictingStoragePathSourceAdapter::IsEvicted(
+    const string& servable_name) const {
+  mutex_lock l(mu_);
+  return evicted_.count(servable_name) > 0;
+}
+
+std::vector<string> EvictingStoragePathSourceAdapter::GetServedServables()
+    const {
+  mutex_lock l(mu_);
+  std::vector<string> servables;
+  for (const auto& entry : aspired_versions_) {
+    if (!entry.second.empty() && evicted_.count(entry.first) == 0) {
+      servables.push_back(entry.first);
+    }
+  }
+  return servables;
+}
+
+void EvictingStoragePathSourceAdapter::ReaspireVersions(
+    const string& servable_name) {
+  std::vector<ServableData<StoragePath>> versions;
+  {
+    mutex_lock l(mu_);
+    auto it = aspired_versions_.find(servable_name);
+    if (it == aspired_versions_.end()) {
+      return;
+    }
+    versions = it->second;
+  }
+  // Goes through the target's callback, which serializes it with the calls of
+  // the source.
+  GetAspiredVersionsCallback()(servable_name, std::move(versions));
+}
+
+std::vector<ServableData<StoragePath>> EvictingStoragePathSourceAdapter::Adapt(
+    const StringPiece servable_name,
+    std::vector<ServableData<StoragePath>> versions) {
+  const string name(servable_name);
+  mutex_lock l(mu_);
+  if (versions.empty()) {
+    // The servable is no longer aspired, so there is nothing left to evict.
+    aspired_versions_.erase(name);
+    evicted_.erase(name);
+    return versions;
+  }
+  aspired_versions_[name] = versions;
+  if (evicted_.count(name) > 0) {
+    return {};
+  }
+  return versions;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
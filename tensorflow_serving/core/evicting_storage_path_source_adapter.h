@@ -0,0 +1,78 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_CORE_EVICTING_STORAGE_PATH_SOURCE_ADAPTER_H_
+#define TENSORFLOW_SERVING_CORE_EVICTING_STORAGE_PATH_SOURCE_ADAPTER_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/core/source_adapter.h"
+#include "tensorflow_serving/core/storage_path.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A SourceAdapter that can evict servables: it passes the aspired versions of
+// each servable through, except for evicted servables, for which it aspires no
+// versions, so that the manager unloads them, until they are restored.
+//
+// The adapter keeps the last aspired versions of each servable, to aspire
+// them again when it is evicted or restored, rather than waiting for the
+// source to.
+class EvictingStoragePathSourceAdapter final
+    : public SourceAdapter<StoragePath, StoragePath> {
+ public:
+  EvictingStoragePathSourceAdapter() = default;
+  ~EvictingStoragePathSourceAdapter() override;
+
+  // Evicts the servable 'servable_name', until Restore(), if it has aspired
+  // versions.
+  void Evict(const string& servable_name) TF_LOCKS_EXCLUDED(mu_);
+
+  // Restores the servable 'servable_name', if evicted.
+  void Restore(const string& servable_name) TF_LOCKS_EXCLUDED(mu_);
+
+  bool IsEvicted(const string& servable_name) const TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the servables with aspired versions that are not evicted.
+  std::vector<string> GetServedServables() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  std::vector<ServableData<StoragePath>> Adapt(
+      StringPiece servable_name,
+      std::vector<ServableData<StoragePath>> versions) override
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Aspires the last aspired versions of 'servable_name' again.
+  void ReaspireVersions(const string& servable_name) TF_LOCKS_EXCLUDED(mu_);
+
+  mutable mutex mu_;
+  std::map<string, std::vector<ServableData<StoragePath>>> aspired_versions_
+      TF_GUARDED_BY(mu_);
+  std::set<string> evicted_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EvictingStoragePathSourceAdapter);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_CORE_EVICTING_STORAGE_PATH_SOURCE_ADAPTER_H_
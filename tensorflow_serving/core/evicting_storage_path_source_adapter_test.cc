@@ -0,0 +1,83 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/evicting_storage_path_source_adapter.h"
+
+#include <memory>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/core/storage_path.h"
+#include "tensorflow_serving/core/target.h"
+#include "tensorflow_serving/core/test_util/mock_storage_path_target.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::StrictMock;
+
+TEST(EvictingStoragePathSourceAdapterTest, EvictsAndRestores) {
+  EvictingStoragePathSourceAdapter adapter;
+  std::unique_ptr<test_util::MockStoragePathTarget> target(
+      new StrictMock<test_util::MockStoragePathTarget>);
+  ConnectSourceToTarget(&adapter, target.get());
+  const ServableData<StoragePath> foo_1({"foo", 1}, "/foo/1");
+
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("foo"), ElementsAre(foo_1)));
+  adapter.GetAspiredVersionsCallback()("foo", {foo_1});
+  EXPECT_THAT(adapter.GetServedServables(), ElementsAre("foo"));
+
+  // Evicting the servable aspires no versions of it, also when the source
+  // aspires them again.
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("foo"), IsEmpty())).Times(2);
+  adapter.Evict("foo");
+  EXPECT_TRUE(adapter.IsEvicted("foo"));
+  EXPECT_THAT(adapter.GetServedServables(), IsEmpty());
+  adapter.GetAspiredVersionsCallback()("foo", {foo_1});
+
+  // Restoring the servable aspires the versions the source last aspired.
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("foo"), ElementsAre(foo_1)));
+  adapter.Restore("foo");
+  EXPECT_FALSE(adapter.IsEvicted("foo"));
+}
+
+TEST(EvictingStoragePathSourceAdapterTest, ForgetsServablesNoLongerAspired) {
+  EvictingStoragePathSourceAdapter adapter;
+  std::unique_ptr<test_util::MockStoragePathTarget> target(
+      new StrictMock<test_util::MockStoragePathTarget>);
+  ConnectSourceToTarget(&adapter, target.get());
+  const ServableData<StoragePath> foo_1({"foo", 1}, "/foo/1");
+
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("foo"), ElementsAre(foo_1)));
+  adapter.GetAspiredVersionsCallback()("foo", {foo_1});
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("foo"), IsEmpty())).Times(2);
+  adapter.Evict("foo");
+  adapter.GetAspiredVersionsCallback()("foo", {});
+  EXPECT_FALSE(adapter.IsEvicted("foo"));
+
+  // Nothing to aspire again, and servables without versions aren't evicted.
+  adapter.Restore("foo");
+  adapter.Evict("bar");
+  EXPECT_FALSE(adapter.IsEvicted("bar"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
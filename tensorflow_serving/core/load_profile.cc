@@ -0,0 +1,120 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow_serving/core/load_profile.h"
+
+#include <utility>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+auto* load_phase_latency = monitoring::Sampler<2>::New(
+    {
+        "/tensorflow/serving/load_phase_latency",
+        "Distribution of wall time (in microseconds) for the phases of loading "
+        "servables.",
+        "model_name",
+        "phase",
+    },  // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+    monitoring::Buckets::Exponential(10, 1.8, 33));
+
+thread_local ScopedLoadProfile* current_profile = nullptr;
+
+// Returns the bytes in use by the CPU allocator, if it keeps statistics.
+absl::optional<int64_t> CpuRamBytesInUse() {
+  const absl::optional<AllocatorStats> stats = cpu_allocator()->GetStats();
+  if (!stats.has_value()) {
+    return absl::nullopt;
+  }
+  return stats->bytes_in_use;
+}
+
+}  // namespace
+
+ScopedLoadProfile::ScopedLoadProfile(const ServableId& servable_id)
+    : servable_id_(servable_id),
+      start_micros_(Env::Default()->NowMicros()),
+      enclosing_profile_(current_profile) {
+  current_profile = this;
+}
+
+ScopedLoadProfile::~ScopedLoadProfile() {
+  current_profile = enclosing_profile_;
+  if (discarded_) {
+    return;
+  }
+  profile_.total_micros = Env::Default()->NowMicros() - start_micros_;
+  LoadProfileRegistry::Global()->Publish(servable_id_, std::move(profile_));
+}
+
+ScopedLoadPhase::ScopedLoadPhase(absl::string_view name)
+    : profile_(current_profile),
+      name_(name),
+      start_micros_(Env::Default()->NowMicros()),
+      start_ram_bytes_(profile_ == nullptr ? absl::nullopt
+                                           : CpuRamBytesInUse()) {}
+
+ScopedLoadPhase::~ScopedLoadPhase() {
+  if (profile_ == nullptr) {
+    return;
+  }
+  LoadProfile::Phase phase;
+  phase.name = name_;
+  phase.start_offset_micros = start_micros_ - profile_->start_micros_;
+  phase.duration_micros = Env::Default()->NowMicros() - start_micros_;
+  if (start_ram_bytes_.has_value()) {
+    const absl::optional<int64_t> end_ram_bytes = CpuRamBytesInUse();
+    if (end_ram_bytes.has_value()) {
+      phase.ram_bytes_delta = *end_ram_bytes - *start_ram_bytes_;
+    }
+  }
+  load_phase_latency->GetCell(profile_->servable_id_.name, name_)
+      ->Add(phase.duration_micros);
+  profile_->profile_.phases.push_back(std::move(phase));
+}
+
+LoadProfileRegistry* LoadProfileRegistry::Global() {
+  static LoadProfileRegistry* const registry = new LoadProfileRegistry();
+  return registry;
+}
+
+void LoadProfileRegistry::Publish(const ServableId& servable_id,
+                                  LoadProfile profile) {
+  mutex_lock l(mu_);
+  profiles_[servable_id] = std::move(profile);
+}
+
+absl::optional<LoadProfile> LoadProfileRegistry::Get(
+    const ServableId& servable_id) const {
+  mutex_lock l(mu_);
+  auto it = profiles_.find(servable_id);
+  if (it == profiles_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+void LoadProfileRegistry::Erase(const ServableId& servable_id) {
+  mutex_lock l(mu_);
+  profiles_.erase(servable_id);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
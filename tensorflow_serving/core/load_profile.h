@@ -0,0 +1,135 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_SERVING_CORE_LOAD_PROFILE_H_
+#define TENSORFLOW_SERVING_CORE_LOAD_PROFILE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/core/servable_id.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A report of where the time and memory of loading a servable went, broken
+// down by the phases of the load (e.g. reading the metagraph, restoring the
+// variables, warming up).
+//
+// Profiles are recorded per load thread: the manager profiles each load on
+// the thread that approves and executes it (see ScopedLoadProfile), and the
+// phases timed on that thread by ScopedLoadPhase are added to its profile.
+// Phases may nest (e.g. "restore" within "load"), and are listed in the order
+// in which they end.
+struct LoadProfile {
+  struct Phase {
+    string name;
+
+    // When the phase started, relative to the start of the load.
+    int64_t start_offset_micros = 0;
+
+    int64_t duration_micros = 0;
+
+    // The growth of the bytes in use by the CPU allocator over the phase. Only
+    // set if the allocator keeps statistics (see
+    // AllocatorStats::bytes_in_use).
+    absl::optional<int64_t> ram_bytes_delta;
+  };
+
+  std::vector<Phase> phases;
+
+  // The time from the start of the load to the end of its profile.
+  int64_t total_micros = 0;
+};
+
+// Profiles the load of 'servable_id' on the calling thread while it exists,
+// and publishes the profile to LoadProfileRegistry::Global() when destroyed.
+// Nests: an inner profile records its own phases until destroyed.
+class ScopedLoadProfile {
+ public:
+  explicit ScopedLoadProfile(const ServableId& servable_id);
+  ~ScopedLoadProfile();
+
+  // Drops the profile instead of publishing it, e.g. if the load did not go
+  // ahead, so that the profile of an earlier load of the servable is kept.
+  void Discard() { discarded_ = true; }
+
+ private:
+  friend class ScopedLoadPhase;
+
+  const ServableId servable_id_;
+  const uint64_t start_micros_;
+  LoadProfile profile_;
+  ScopedLoadProfile* const enclosing_profile_;
+  bool discarded_ = false;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedLoadProfile);
+};
+
+// Times the phase 'name' of the load profiled on the calling thread, if any,
+// from construction to destruction. The durations of the phases are also
+// exported as the /tensorflow/serving/load_phase_latency metric, by model
+// name and phase.
+class ScopedLoadPhase {
+ public:
+  explicit ScopedLoadPhase(absl::string_view name);
+  ~ScopedLoadPhase();
+
+ private:
+  ScopedLoadProfile* const profile_;
+  const string name_;
+  const uint64_t start_micros_;
+  const absl::optional<int64_t> start_ram_bytes_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedLoadPhase);
+};
+
+// The profiles of the latest loads of the servables of the process, kept
+// until the servables are unloaded. This class is thread-safe.
+class LoadProfileRegistry {
+ public:
+  static LoadProfileRegistry* Global();
+
+  LoadProfileRegistry() = default;
+
+  // Records 'profile' as the latest profile of the load of 'servable_id'.
+  void Publish(const ServableId& servable_id, LoadProfile profile)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the latest profile of the load of 'servable_id', if any.
+  absl::optional<LoadProfile> Get(const ServableId& servable_id) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Drops the profile of 'servable_id', e.g. once it has been unloaded.
+  void Erase(const ServableId& servable_id) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  mutable mutex mu_;
+  std::unordered_map<ServableId, LoadProfile, HashServableId> profiles_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LoadProfileRegistry);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_CORE_LOAD_PROFILE_H_
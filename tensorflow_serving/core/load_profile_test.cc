@@ -0,0 +1,96 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow_serving/core/load_profile.h"
+
+#include <gtest/gtest.h>
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(LoadProfileTest, RecordsPhasesOfTheCurrentLoad) {
+  const ServableId id = {"profiled", 3};
+  {
+    ScopedLoadProfile profile(id);
+    {
+      ScopedLoadPhase load("load");
+      { ScopedLoadPhase restore("restore"); }
+    }
+    { ScopedLoadPhase warmup("warmup"); }
+  }
+  const absl::optional<LoadProfile> profile =
+      LoadProfileRegistry::Global()->Get(id);
+  ASSERT_TRUE(profile.has_value());
+  ASSERT_EQ(3, profile->phases.size());
+  // Phases are listed in the order in which they end.
+  EXPECT_EQ("restore", profile->phases[0].name);
+  EXPECT_EQ("load", profile->phases[1].name);
+  EXPECT_EQ("warmup", profile->phases[2].name);
+  EXPECT_LE(profile->phases[1].start_offset_micros,
+            profile->phases[0].start_offset_micros);
+  EXPECT_GE(profile->phases[1].duration_micros,
+            profile->phases[0].duration_micros);
+  EXPECT_GE(profile->total_micros, profile->phases[2].start_offset_micros +
+                                       profile->phases[2].duration_micros);
+
+  LoadProfileRegistry::Global()->Erase(id);
+  EXPECT_FALSE(LoadProfileRegistry::Global()->Get(id).has_value());
+}
+
+TEST(LoadProfileTest, IgnoresPhasesOutsideOfLoads) {
+  { ScopedLoadPhase phase("orphan"); }
+  const ServableId id = {"nested", 1};
+  const ServableId inner_id = {"nested", 2};
+  {
+    ScopedLoadProfile profile(id);
+    {
+      ScopedLoadProfile inner_profile(inner_id);
+      ScopedLoadPhase inner_phase("inner");
+    }
+    ScopedLoadPhase outer_phase("outer");
+  }
+  const absl::optional<LoadProfile> profile =
+      LoadProfileRegistry::Global()->Get(id);
+  ASSERT_TRUE(profile.has_value());
+  ASSERT_EQ(1, profile->phases.size());
+  EXPECT_EQ("outer", profile->phases[0].name);
+  const absl::optional<LoadProfile> inner_profile =
+      LoadProfileRegistry::Global()->Get(inner_id);
+  ASSERT_TRUE(inner_profile.has_value());
+  ASSERT_EQ(1, inner_profile->phases.size());
+  EXPECT_EQ("inner", inner_profile->phases[0].name);
+}
+
+TEST(LoadProfileTest, Discard) {
+  const ServableId id = {"discarded", 1};
+  {
+    ScopedLoadProfile profile(id);
+    ScopedLoadPhase phase("load");
+  }
+  {
+    ScopedLoadProfile profile(id);
+    profile.Discard();
+  }
+  // The profile of the earlier load is kept.
+  const absl::optional<LoadProfile> profile =
+      LoadProfileRegistry::Global()->Get(id);
+  ASSERT_TRUE(profile.has_value());
+  ASSERT_EQ(1, profile->phases.size());
+  EXPECT_EQ("load", profile->phases[0].name);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow_serving/core/load_servables_fast.h"
 
 #include <algorithm>
+#include <deque>
 #include <functional>
 #include <map>
 #include <memory>
@@ -25,16 +26,100 @@ limitations under the License.
 
 #include "absl/types/optional.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/core/servable_data.h"
 #include "tensorflow_serving/core/servable_state.h"
 #include "tensorflow_serving/core/source.h"
-#include "tensorflow_serving/core/target.h"
+#include "tensorflow_serving/resources/resources.pb.h"
+#include "tensorflow_serving/util/executor.h"
+#include "tensorflow_serving/util/threadpool_executor.h"
 
 namespace tensorflow {
 namespace serving {
 
+namespace {
+
+auto* initial_load_servables_loaded = monitoring::Counter<0>::New(
+    "/tensorflow/serving/initial_load/servables_loaded",
+    "The number of servables that became available during the fast initial "
+    "load of the model server. Its rate is the startup rate.");
+
+auto* initial_load_latency = monitoring::Gauge<int64_t, 0>::New(
+    "/tensorflow/serving/initial_load/latency_microseconds",
+    "The time the last fast initial load took, from connecting the sources "
+    "until the initial servables were loaded.");
+
+}  // namespace
+
 namespace internal {
 
+ResourceEstimationStage::ResourceEstimationStage(
+    Source<std::unique_ptr<Loader>>::AspiredVersionsCallback forward,
+    const uint32 num_threads)
+    : forward_(std::move(forward)),
+      executor_(new ThreadPoolExecutor(Env::Default(),
+                                       "FastInitialLoad_Estimate_ThreadPool",
+                                       std::max<uint32>(1, num_threads))) {}
+
+void ResourceEstimationStage::SetAspiredVersions(
+    const StringPiece servable_name, LoaderVersions versions) {
+  const string name(servable_name);
+  {
+    mutex_lock l(mu_);
+    auto queue = pending_.find(name);
+    if (queue != pending_.end()) {
+      queue->second.push_back(std::move(versions));
+      return;
+    }
+    if (executor_ != nullptr) {
+      pending_[name].push_back(std::move(versions));
+      executor_->Schedule([this, name]() { EstimateAndForward(name); });
+      return;
+    }
+  }
+  forward_(servable_name, std::move(versions));
+}
+
+void ResourceEstimationStage::Stop() {
+  std::unique_ptr<Executor> executor;
+  {
+    mutex_lock l(mu_);
+    executor = std::move(executor_);
+  }
+  executor.reset();
+}
+
+void ResourceEstimationStage::EstimateAndForward(const string& name) {
+  while (true) {
+    LoaderVersions versions;
+    {
+      mutex_lock l(mu_);
+      versions = std::move(pending_[name].front());
+    }
+    for (const ServableData<std::unique_ptr<Loader>>& version : versions) {
+      if (version.status().ok()) {
+        ResourceAllocation estimate;
+        // Errors are reported when the manager estimates the resources.
+        version.DataOrDie()->EstimateResources(&estimate).IgnoreError();
+      }
+    }
+    forward_(name, std::move(versions));
+
+    mutex_lock l(mu_);
+    auto queue = pending_.find(name);
+    queue->second.pop_front();
+    if (queue->second.empty()) {
+      pending_.erase(queue);
+      return;
+    }
+  }
+}
+
 uint32 GetManagerNumLoadThreads(AspiredVersionsManager* manager) {
   return manager->num_load_threads();
 }
@@ -53,10 +138,18 @@ Status ConnectSourcesWithFastInitialLoad(
   std::function<void(const uint32)> set_manager_num_load_threads =
       SetManagerNumLoadThreadsNotifier(manager);
   set_manager_num_load_threads(num_threads);
+  auto estimation_stage = std::make_shared<ResourceEstimationStage>(
+      manager->GetAspiredVersionsCallback(), num_threads);
   for (Source<std::unique_ptr<Loader>>* source : sources) {
-    ConnectSourceToTarget(source, manager);
+    source->SetAspiredVersionsCallback(
+        [estimation_stage](const StringPiece servable_name,
+                           ResourceEstimationStage::LoaderVersions versions) {
+          estimation_stage->SetAspiredVersions(servable_name,
+                                               std::move(versions));
+        });
   }
   const Status status = wait_until_loaded_fn();
+  estimation_stage->Stop();
   set_manager_num_load_threads(prev_num_load_threads);
   return status;
 }
@@ -79,7 +172,15 @@ Status ConnectSourcesWithFastInitialLoad(
     ServableStateMonitor* servable_state_monitor,
     const std::vector<ServableRequest>& initial_servables,
     const uint32 num_threads) {
-  return internal::ConnectSourcesWithFastInitialLoad(
+  const uint64_t start_micros = Env::Default()->NowMicros();
+  // Counts the servables loaded until the initial load is over.
+  const int64_t notify_id =
+      servable_state_monitor->Notify([](const ServableState& state) {
+        if (state.manager_state == ServableState::ManagerState::kAvailable) {
+          initial_load_servables_loaded->GetCell()->IncrementBy(1);
+        }
+      });
+  const Status status = internal::ConnectSourcesWithFastInitialLoad(
       manager, sources,
       [&]() {
         std::map<ServableId, ServableState::ManagerState> states_reached;
@@ -119,6 +220,10 @@ Status ConnectSourcesWithFastInitialLoad(
         return OkStatus();
       },
       num_threads);
+  servable_state_monitor->StopNotifying(notify_id);
+  initial_load_latency->GetCell()->Set(Env::Default()->NowMicros() -
+                                       start_micros);
+  return status;
 }
 
 }  // namespace serving
@@ -16,15 +16,24 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_CORE_LOAD_SERVABLES_FAST_H_
 #define TENSORFLOW_SERVING_CORE_LOAD_SERVABLES_FAST_H_
 
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow_serving/core/aspired_versions_manager.h"
 #include "tensorflow_serving/core/loader.h"
 #include "tensorflow_serving/core/manager.h"
+#include "tensorflow_serving/core/servable_data.h"
 #include "tensorflow_serving/core/servable_state_monitor.h"
+#include "tensorflow_serving/core/source.h"
+#include "tensorflow_serving/util/executor.h"
 
 namespace tensorflow {
 namespace serving {
@@ -33,6 +42,8 @@ namespace serving {
 // matching 'initial_servables'. The speeding up is accomplished by boosting the
 // number of threads used for loading until the initial servables have been
 // loaded, and then resetting it to the manager's originally configured value.
+// Meanwhile, the resources of the servables are estimated by a separate pool of
+// 'num_threads' threads as they are aspired, in a pipeline with the loads.
 Status ConnectSourceWithFastInitialLoad(
     AspiredVersionsManager* manager, Source<std::unique_ptr<Loader>>* source,
     ServableStateMonitor* servable_state_monitor,
@@ -53,6 +64,44 @@ Status ConnectSourcesWithFastInitialLoad(
 
 namespace internal {
 
+// The stage of the initial load between the sources and the manager that
+// estimates the resources of the aspired versions, on its own threads, before
+// forwarding them to the manager. Estimates read the storage of the servables,
+// so they then overlap with the loads of the servables aspired before, and the
+// load threads of the manager find them memoized by the loaders. The aspired
+// versions of each servable are forwarded in order.
+class ResourceEstimationStage {
+ public:
+  using LoaderVersions = std::vector<ServableData<std::unique_ptr<Loader>>>;
+
+  ResourceEstimationStage(
+      Source<std::unique_ptr<Loader>>::AspiredVersionsCallback forward,
+      uint32 num_threads);
+
+  void SetAspiredVersions(StringPiece servable_name, LoaderVersions versions)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Waits for the aspired versions in the stage to be forwarded. Later ones
+  // are forwarded directly.
+  void Stop() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Forwards the pending aspired versions of 'name', in order, once their
+  // resources are estimated.
+  void EstimateAndForward(const string& name) TF_LOCKS_EXCLUDED(mu_);
+
+  const Source<std::unique_ptr<Loader>>::AspiredVersionsCallback forward_;
+
+  mutex mu_;
+
+  // Null once stopped.
+  std::unique_ptr<Executor> executor_ TF_GUARDED_BY(mu_);
+
+  // The aspired versions in the stage, by servable name. The front of each
+  // queue is being estimated.
+  std::map<string, std::deque<LoaderVersions>> pending_ TF_GUARDED_BY(mu_);
+};
+
 Status ConnectSourcesWithFastInitialLoad(
     AspiredVersionsManager* manager,
     std::vector<Source<std::unique_ptr<Loader>>*> sources,
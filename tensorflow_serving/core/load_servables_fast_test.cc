@@ -0,0 +1,183 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/load_servables_fast.h"
+
+#include <map>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow_serving/core/availability_preserving_policy.h"
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/core/test_util/availability_test_util.h"
+#include "tensorflow_serving/core/test_util/fake_loader.h"
+#include "tensorflow_serving/util/event_bus.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::ElementsAre;
+using internal::ResourceEstimationStage;
+using test_util::FakeLoader;
+using test_util::WaitUntilServableManagerStateIsOneOf;
+
+// Returns aspired versions with the single version 'id', with an error rather
+// than a loader.
+ResourceEstimationStage::LoaderVersions ErroneousVersions(
+    const ServableId& id) {
+  ResourceEstimationStage::LoaderVersions versions;
+  versions.push_back(
+      ServableData<std::unique_ptr<Loader>>(id, errors::Unknown("error")));
+  return versions;
+}
+
+TEST(ResourceEstimationStageTest, ForwardsTheVersionsOfEachServableInOrder) {
+  constexpr int kNumServables = 4;
+  constexpr int kNumVersions = 100;
+  mutex mu;
+  std::map<string, std::vector<int64_t>> forwarded_versions;
+  ResourceEstimationStage stage(
+      [&](const StringPiece servable_name,
+          ResourceEstimationStage::LoaderVersions versions) {
+        mutex_lock l(mu);
+        for (const auto& version : versions) {
+          forwarded_versions[string(servable_name)].push_back(
+              version.id().version);
+        }
+      },
+      kNumServables);
+  {
+    // Each servable is aspired by its own thread, concurrently with the
+    // others.
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < kNumServables; ++i) {
+      threads.emplace_back(Env::Default()->StartThread(
+          {}, "Aspirer", [&stage, i]() {
+            const string name = strings::StrCat("servable", i);
+            for (int64_t version = 0; version < kNumVersions; ++version) {
+              stage.SetAspiredVersions(name,
+                                       ErroneousVersions({name, version}));
+            }
+          }));
+    }
+  }
+  stage.Stop();
+
+  std::vector<int64_t> expected_versions(kNumVersions);
+  std::iota(expected_versions.begin(), expected_versions.end(), 0);
+  mutex_lock l(mu);
+  ASSERT_EQ(kNumServables, forwarded_versions.size());
+  for (const auto& name_and_versions : forwarded_versions) {
+    EXPECT_EQ(expected_versions, name_and_versions.second)
+        << name_and_versions.first;
+  }
+}
+
+TEST(ResourceEstimationStageTest, ForwardsDirectlyAfterStop) {
+  std::vector<int64_t> forwarded_versions;
+  ResourceEstimationStage stage(
+      [&](const StringPiece servable_name,
+          ResourceEstimationStage::LoaderVersions versions) {
+        forwarded_versions.push_back(versions[0].id().version);
+      },
+      1);
+  stage.Stop();
+  // Forwarded before SetAspiredVersions() returns.
+  stage.SetAspiredVersions("servable", ErroneousVersions({"servable", 1}));
+  EXPECT_THAT(forwarded_versions, ElementsAre(1));
+  stage.SetAspiredVersions("servable", ErroneousVersions({"servable", 2}));
+  EXPECT_THAT(forwarded_versions, ElementsAre(1, 2));
+}
+
+// Returns the value of the servables_loaded counter.
+int64_t NumInitialLoadServablesLoaded() {
+  std::unique_ptr<monitoring::CollectedMetrics> collected =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  const auto point_set = collected->point_set_map.find(
+      "/tensorflow/serving/initial_load/servables_loaded");
+  if (point_set == collected->point_set_map.end() ||
+      point_set->second->points.empty()) {
+    return 0;
+  }
+  return point_set->second->points[0]->int64_value;
+}
+
+// A source that aspires 'initial_servable' as soon as it is connected.
+class FakeSource : public Source<std::unique_ptr<Loader>> {
+ public:
+  explicit FakeSource(const ServableId& initial_servable)
+      : initial_servable_(initial_servable) {}
+
+  void SetAspiredVersionsCallback(AspiredVersionsCallback callback) override {
+    callback_ = std::move(callback);
+    Aspire(initial_servable_);
+  }
+
+  void Aspire(const ServableId& id) {
+    std::vector<ServableData<std::unique_ptr<Loader>>> versions;
+    versions.push_back(CreateServableData(
+        id, std::unique_ptr<Loader>(new FakeLoader(id.version))));
+    callback_(id.name, std::move(versions));
+  }
+
+ private:
+  const ServableId initial_servable_;
+  AspiredVersionsCallback callback_;
+};
+
+TEST(ConnectSourcesWithFastInitialLoadTest, CountsOnlyTheInitialLoad) {
+  auto servable_event_bus = EventBus<ServableState>::CreateEventBus();
+  ServableStateMonitor servable_state_monitor(servable_event_bus.get());
+  AspiredVersionsManager::Options manager_options;
+  manager_options.servable_event_bus = servable_event_bus.get();
+  manager_options.aspired_version_policy.reset(
+      new AvailabilityPreservingPolicy());
+  std::unique_ptr<AspiredVersionsManager> manager;
+  TF_ASSERT_OK(
+      AspiredVersionsManager::Create(std::move(manager_options), &manager));
+
+  const ServableId initial_servable = {"initial", 1};
+  FakeSource source(initial_servable);
+  const int64_t num_loaded_before = NumInitialLoadServablesLoaded();
+  TF_ASSERT_OK(ConnectSourceWithFastInitialLoad(
+      manager.get(), &source, &servable_state_monitor,
+      {ServableRequest::FromId(initial_servable)}, 2));
+  EXPECT_EQ(num_loaded_before + 1, NumInitialLoadServablesLoaded());
+
+  // Servables loaded after the initial load are not counted.
+  const ServableId later_servable = {"later", 1};
+  source.Aspire(later_servable);
+  WaitUntilServableManagerStateIsOneOf(
+      servable_state_monitor, later_servable,
+      {ServableState::ManagerState::kAvailable});
+  EXPECT_EQ(num_loaded_before + 1, NumInitialLoadServablesLoaded());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -16,12 +16,14 @@ limitations under the License.
 #include "tensorflow_serving/core/loader_harness.h"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <utility>
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/core/load_profile.h"
 #include "tensorflow_serving/util/retrier.h"
 
 namespace tensorflow {
@@ -31,17 +33,27 @@ LoaderHarness::LoaderHarness(const ServableId& id,
                              std::unique_ptr<Loader> loader,
                              const Options& options)
     : id_(id),
+      load_generation_(NextLoadGeneration()),
       loader_(std::move(loader)),
       additional_state_(nullptr),
       options_(options) {
   VLOG(1) << "Starting to manage servable version " << id_;
 }
 
+uint64_t LoaderHarness::NextLoadGeneration() {
+  static std::atomic<uint64_t> next_load_generation{1};
+  return next_load_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
 LoaderHarness::~LoaderHarness() {
   mutex_lock l(mu_);
   DCHECK(state_ == State::kNew || state_ == State::kDisabled ||
          state_ == State::kError)
       << "Servable: " << id_ << " state: " << state_;
+  // The profiles of failed loads are kept, to tell what went wrong.
+  if (state_ == State::kDisabled) {
+    LoadProfileRegistry::Global()->Erase(id_);
+  }
 }
 
 LoaderHarness::State LoaderHarness::state() const {
@@ -76,11 +88,15 @@ Status LoaderHarness::Load() {
     LOG(INFO) << "Loading servable version " << id_;
   }
 
-  const Status status = Retry(
-      strings::StrCat("Loading servable: ", id_.DebugString()),
-      options_.max_num_load_retries, options_.load_retry_interval_micros,
-      [&]() { return loader_->LoadWithMetadata({id_}); },
-      [&]() { return cancel_load_retry(); });
+  Status status;
+  {
+    ScopedLoadPhase load_phase("load");
+    status = Retry(
+        strings::StrCat("Loading servable: ", id_.DebugString()),
+        load_retry_options(),
+        [&]() { return loader_->LoadWithMetadata({id_}); },
+        [&]() { return cancel_load_retry(); });
+  }
 
   if (status.ok()) {
     if (cancel_load_retry()) {
@@ -104,6 +120,15 @@ Status LoaderHarness::Load() {
   return status;
 }
 
+RetryOptions LoaderHarness::load_retry_options() const {
+  RetryOptions retry_options;
+  retry_options.max_num_retries = options_.max_num_load_retries;
+  retry_options.retry_interval_micros = options_.load_retry_interval_micros;
+  retry_options.backoff = options_.load_retry_backoff;
+  retry_options.budget = options_.load_retry_budget;
+  return retry_options;
+}
+
 Status LoaderHarness::UnloadRequested() {
   mutex_lock l(mu_);
   if (state_ != State::kReady) {
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_serving/core/loader.h"
 #include "tensorflow_serving/core/servable_id.h"
+#include "tensorflow_serving/util/retrier.h"
 
 namespace tensorflow {
 namespace serving {
@@ -103,6 +104,13 @@ class LoaderHarness final {
     /// The interval, in microseconds, between each servable load retry.
     uint64_t load_retry_interval_micros = 0;
 
+    /// How the interval between load retries grows.
+    RetryBackoff load_retry_backoff;
+
+    /// The budget load retries are taken from, if any, e.g. shared by all
+    /// servables of a manager. Not owned.
+    RetryBudget* load_retry_budget = nullptr;
+
     /// An (optional) function to call upon transitioning to state kError.
     std::function<void(const ServableId& id, const Status& error)>
         error_callback;
@@ -118,6 +126,7 @@ class LoaderHarness final {
                 std::unique_ptr<T> additional_state,
                 const Options& options = Options())
       : id_(id),
+        load_generation_(NextLoadGeneration()),
         loader_(std::move(loader)),
         additional_state_(std::move(additional_state)),
         options_(options) {}
@@ -129,6 +138,12 @@ class LoaderHarness final {
   /// Returns the identifier of underlying Servable.
   ServableId id() const { return id_; }
 
+  /// Returns a positive number that is distinct for every harness of the
+  /// process, unlike the id, which a reloaded servable keeps. State derived
+  /// from the servable, e.g. pointers into it, is only valid for the servable
+  /// of the same load generation. See ServableScopedCache.
+  uint64_t load_generation() const { return load_generation_; }
+
   /// Returns the current state of underlying Servable.
   State state() const TF_LOCKS_EXCLUDED(mu_);
 
@@ -163,6 +178,10 @@ class LoaderHarness final {
   /// transitions to state kError and invokes 'options_.error_callback'.
   Status Load() TF_LOCKS_EXCLUDED(mu_);
 
+  /// The retry options of loads and of the steps before them, per the options
+  /// of this harness.
+  RetryOptions load_retry_options() const;
+
   /// Transitions the state of the harness to kUnloadRequested iff its current
   /// state is kReady. The test-and-change is done transactionally, so this
   /// method can be used to ensure that at most one Load() request can proceed.
@@ -232,7 +251,10 @@ class LoaderHarness final {
   Status UnloadInternal(State from_state) TF_LOCKS_EXCLUDED(mu_);
   Status UnloadDueToCancelledLoad() TF_LOCKS_EXCLUDED(mu_);
 
+  static uint64_t NextLoadGeneration();
+
   const ServableId id_;
+  const uint64_t load_generation_;
   const std::unique_ptr<Loader> loader_;
   // Additional state that the manager uses.
   const UniqueAnyPtr additional_state_;
@@ -0,0 +1,743 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/local_cache_storage_path_source_adapter.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/hash/crc32c.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/numbers.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// The size of the chunks files are read and written in.
+constexpr size_t kChunkBytes = 4 << 20;
+
+// The subdirectories of the cache directory: the files by content, the
+// versions by servable, and the files being fetched.
+constexpr char kBlobsDir[] = "blobs";
+constexpr char kServablesDir[] = "servables";
+constexpr char kTmpDir[] = "tmp";
+
+// The suffix of the directories of versions being fetched.
+constexpr char kPartialSuffix[] = ".partial";
+
+// The suffix of the manifests of the cached versions, which list their files.
+constexpr char kManifestSuffix[] = ".manifest";
+
+bool IsLocalPath(const string& path) {
+  StringPiece scheme, host, unused_path;
+  io::ParseURI(path, &scheme, &host, &unused_path);
+  return scheme.empty();
+}
+
+// Lowers the I/O priority of the calling thread to the lowest level of the
+// best-effort class, so that its I/O yields to that of serving (e.g. to the
+// reads of models being loaded).
+void LowerIoPriority() {
+#if defined(__linux__) && defined(SYS_ioprio_set)
+  // See ioprio_set(2).
+  constexpr int kIoprioWhoProcess = 1;
+  constexpr int kIoprioClassShift = 13;
+  constexpr int kIoprioClassBestEffort = 2;
+  constexpr int kIoprioLowestLevel = 7;
+  thread_local bool lowered = false;
+  if (!lowered) {
+    // A process id of 0 sets the priority of the calling thread.
+    syscall(SYS_ioprio_set, kIoprioWhoProcess, 0,
+            (kIoprioClassBestEffort << kIoprioClassShift) | kIoprioLowestLevel);
+    lowered = true;
+  }
+#endif
+}
+
+// Adds the directories and files below 'root', relative to it, to 'dirs' and
+// 'files'. 'relative_dir' is the directory to list, relative to 'root'.
+Status ListRecursively(Env* env, const string& root,
+                       const string& relative_dir, std::vector<string>* dirs,
+                       std::vector<string>* files) {
+  std::vector<string> children;
+  TF_RETURN_IF_ERROR(
+      env->GetChildren(io::JoinPath(root, relative_dir), &children));
+  // GetChildren() returns all descendants for cloud storage like GCS, so only
+  // the direct children are taken.
+  std::set<string> direct_children;
+  for (const string& child : children) {
+    direct_children.insert(child.substr(0, child.find_first_of('/')));
+  }
+  for (const string& child : direct_children) {
+    const string relative_path =
+        relative_dir.empty() ? child : io::JoinPath(relative_dir, child);
+    if (env->IsDirectory(io::JoinPath(root, relative_path)).ok()) {
+      dirs->push_back(relative_path);
+      TF_RETURN_IF_ERROR(
+          ListRecursively(env, root, relative_path, dirs, files));
+    } else {
+      files->push_back(relative_path);
+    }
+  }
+  return OkStatus();
+}
+
+// Reads the file at 'path' in chunks, passing each to 'fn'. Sets 'size' to the
+// number of bytes read.
+Status ReadChunks(Env* env, const string& path,
+                  const std::function<Status(StringPiece)>& fn,
+                  uint64_t* size) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(path, &file));
+  string buffer(kChunkBytes, '\0');
+  *size = 0;
+  while (true) {
+    StringPiece chunk;
+    const Status status = file->Read(*size, kChunkBytes, &chunk, &buffer[0]);
+    if (!status.ok() && !errors::IsOutOfRange(status)) {
+      return status;
+    }
+    if (chunk.empty()) {
+      return OkStatus();
+    }
+    TF_RETURN_IF_ERROR(fn(chunk));
+    *size += chunk.size();
+  }
+}
+
+// Returns the manifest listing 'files', one per line as
+// "<d|f> <size> <crc32c> <relative path>".
+string SerializeManifest(const std::vector<CachedVersionFile>& files) {
+  string manifest;
+  for (const CachedVersionFile& file : files) {
+    absl::StrAppend(&manifest, file.is_directory ? "d" : "f", " ", file.size,
+                    " ", absl::Hex(file.crc32c, absl::kZeroPad8), " ",
+                    file.relative_path, "\n");
+  }
+  return manifest;
+}
+
+Status ParseManifest(const string& manifest,
+                     std::vector<CachedVersionFile>* files) {
+  files->clear();
+  for (absl::string_view line :
+       absl::StrSplit(manifest, '\n', absl::SkipEmpty())) {
+    const std::vector<string> fields =
+        absl::StrSplit(line, absl::MaxSplits(' ', 3));
+    CachedVersionFile file;
+    if (fields.size() != 4 || (fields[0] != "d" && fields[0] != "f") ||
+        !absl::SimpleAtoi(fields[1], &file.size) ||
+        !absl::SimpleHexAtoi(fields[2], &file.crc32c)) {
+      return errors::DataLoss("Malformed manifest line: ", line);
+    }
+    file.is_directory = fields[0] == "d";
+    file.relative_path = fields[3];
+    files->push_back(std::move(file));
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+Status LocalCacheStoragePathSourceAdapter::Create(
+    const Options& options,
+    std::unique_ptr<LocalCacheStoragePathSourceAdapter>* adapter) {
+  if (options.cache_dir.empty()) {
+    return errors::InvalidArgument("cache_dir must be set");
+  }
+  if (options.num_versions_to_retain < 1 || options.num_fetch_threads < 1) {
+    return errors::InvalidArgument(
+        "num_versions_to_retain and num_fetch_threads must be positive");
+  }
+  Env* const env = options.env;
+  // Files left behind by fetches that were interrupted.
+  const string tmp_dir = io::JoinPath(options.cache_dir, kTmpDir);
+  if (env->FileExists(tmp_dir).ok()) {
+    int64_t undeleted_files, undeleted_dirs;
+    TF_RETURN_IF_ERROR(
+        env->DeleteRecursively(tmp_dir, &undeleted_files, &undeleted_dirs));
+  }
+  for (const char* dir : {kBlobsDir, kServablesDir, kTmpDir}) {
+    TF_RETURN_IF_ERROR(
+        env->RecursivelyCreateDir(io::JoinPath(options.cache_dir, dir)));
+  }
+  adapter->reset(new LocalCacheStoragePathSourceAdapter(options));
+  return OkStatus();
+}
+
+LocalCacheStoragePathSourceAdapter::LocalCacheStoragePathSourceAdapter(
+    const Options& options)
+    : options_(options),
+      fetch_thread_pool_(options.env, "LocalCacheStoragePathSourceAdapter",
+                         options.num_fetch_threads) {
+  if (options_.fetch_in_background) {
+    background_thread_.reset(new thread::ThreadPool(
+        options_.env, "LocalCacheStoragePathSourceAdapter_Background", 1));
+  }
+}
+
+LocalCacheStoragePathSourceAdapter::~LocalCacheStoragePathSourceAdapter() {
+  Detach();
+  {
+    mutex_lock l(mu_);
+    stopped_ = true;
+  }
+  // Waits for the background fetches.
+  background_thread_.reset();
+}
+
+string LocalCacheStoragePathSourceAdapter::GetVersionDir(
+    const string& storage_path) const {
+  const string servable_dir = io::JoinPath(
+      options_.cache_dir, kServablesDir,
+      absl::StrCat(absl::Hex(Hash64(string(io::Dirname(storage_path))),
+                             absl::kZeroPad16)));
+  return io::JoinPath(servable_dir, string(io::Basename(storage_path)));
+}
+
+Status LocalCacheStoragePathSourceAdapter::LookUpCachedVersion(
+    const string& storage_path, string* version_dir,
+    std::vector<CachedVersionFile>* files) const {
+  *version_dir = GetVersionDir(storage_path);
+  string manifest;
+  const Status status =
+      ReadFileToString(options_.env,
+                       absl::StrCat(*version_dir, kManifestSuffix), &manifest);
+  if (!status.ok() || !options_.env->IsDirectory(*version_dir).ok()) {
+    return errors::NotFound(storage_path, " is not cached");
+  }
+  return ParseManifest(manifest, files);
+}
+
+void LocalCacheStoragePathSourceAdapter::SetAspiredVersions(
+    const StringPiece servable_name,
+    std::vector<ServableData<StoragePath>> versions) {
+  if (!options_.fetch_in_background) {
+    // Fetches versions in the calling thread, so mustn't serialize the calls.
+    SourceAdapter::SetAspiredVersions(servable_name, std::move(versions));
+    return;
+  }
+  mutex_lock passing_lock(passing_mu_);
+  SourceAdapter::SetAspiredVersions(servable_name, std::move(versions));
+}
+
+std::vector<ServableData<StoragePath>>
+LocalCacheStoragePathSourceAdapter::Adapt(
+    const StringPiece servable_name,
+    std::vector<ServableData<StoragePath>> versions) {
+  if (options_.fetch_in_background) {
+    return AdaptInBackground(string(servable_name), std::move(versions));
+  }
+  std::vector<ServableData<StoragePath>> adapted_versions;
+  for (const ServableData<StoragePath>& version : versions) {
+    if (!version.status().ok()) {
+      adapted_versions.push_back(version);
+      continue;
+    }
+    StoragePath destination;
+    const Status status = Convert(version.DataOrDie(), &destination);
+    if (status.ok()) {
+      adapted_versions.emplace_back(
+          ServableData<StoragePath>{version.id(), std::move(destination)});
+    } else {
+      adapted_versions.emplace_back(
+          ServableData<StoragePath>{version.id(), status});
+    }
+  }
+  return adapted_versions;
+}
+
+std::vector<ServableData<StoragePath>>
+LocalCacheStoragePathSourceAdapter::AdaptInBackground(
+    const string& servable_name,
+    std::vector<ServableData<StoragePath>> versions) {
+  std::vector<ServableData<StoragePath>> adapted_versions;
+  bool withheld = false;
+  mutex_lock l(mu_);
+  for (const ServableData<StoragePath>& version : versions) {
+    if (!version.status().ok() ||
+        (!options_.cache_local_paths && IsLocalPath(version.DataOrDie()))) {
+      adapted_versions.push_back(version);
+      continue;
+    }
+    const string& source = version.DataOrDie();
+    const string version_dir = GetVersionDir(source);
+    const bool being_fetched = versions_being_fetched_.count(version_dir) > 0;
+    if (!being_fetched && options_.env->IsDirectory(version_dir).ok()) {
+      adapted_versions.emplace_back(
+          ServableData<StoragePath>{version.id(), version_dir});
+      continue;
+    }
+    // A version whose fetch failed is passed on with the error, like without
+    // fetching in the background, and fetched again when next aspired.
+    auto error = fetch_errors_.find(version_dir);
+    if (!being_fetched &&
+        (error == fetch_errors_.end() || error->second.passed_on)) {
+      versions_being_fetched_.insert(version_dir);
+      background_thread_->Schedule(
+          [this, servable_name, source, version_dir]() {
+            FetchInBackground(servable_name, source, version_dir);
+          });
+    }
+    if (error != fetch_errors_.end()) {
+      adapted_versions.emplace_back(
+          ServableData<StoragePath>{version.id(), error->second.status});
+      error->second.passed_on = true;
+    } else {
+      withheld = true;
+    }
+  }
+  if (withheld) {
+    // Keeps the versions passed on before, until the withheld ones are cached.
+    for (const ServableData<StoragePath>& passed :
+         passed_versions_[servable_name]) {
+      if (std::none_of(adapted_versions.begin(), adapted_versions.end(),
+                       [&](const ServableData<StoragePath>& adapted) {
+                         return adapted.id() == passed.id();
+                       })) {
+        adapted_versions.push_back(passed);
+      }
+    }
+  }
+  aspired_versions_[servable_name] = std::move(versions);
+  passed_versions_[servable_name] = adapted_versions;
+  return adapted_versions;
+}
+
+void LocalCacheStoragePathSourceAdapter::FetchInBackground(
+    const string& servable_name, const string& source,
+    const string& version_dir) {
+  LowerIoPriority();
+  const Status status = FetchVersion(source, version_dir);
+  if (status.ok()) {
+    EvictVersions(string(io::Dirname(version_dir)), version_dir);
+  }
+  // Passes on the latest aspired versions while holding 'passing_mu_', so that
+  // they are not overtaken by older ones.
+  mutex_lock passing_lock(passing_mu_);
+  std::vector<ServableData<StoragePath>> versions;
+  {
+    mutex_lock l(mu_);
+    versions_being_fetched_.erase(version_dir);
+    fetched_cv_.notify_all();
+    if (status.ok()) {
+      fetch_errors_.erase(version_dir);
+    } else {
+      fetch_errors_[version_dir] = {status, false};
+    }
+    if (stopped_) {
+      return;
+    }
+    versions = aspired_versions_[servable_name];
+  }
+  SourceAdapter::SetAspiredVersions(servable_name, std::move(versions));
+}
+
+Status LocalCacheStoragePathSourceAdapter::Convert(const StoragePath& source,
+                                                   StoragePath* destination) {
+  if (!options_.cache_local_paths && IsLocalPath(source)) {
+    *destination = source;
+    return OkStatus();
+  }
+  const string version_dir = GetVersionDir(source);
+  {
+    mutex_lock l(mu_);
+    while (versions_being_fetched_.count(version_dir) > 0) {
+      fetched_cv_.wait(l);
+    }
+    if (options_.env->IsDirectory(version_dir).ok()) {
+      *destination = version_dir;
+      return OkStatus();
+    }
+    versions_being_fetched_.insert(version_dir);
+  }
+  const Status status = FetchVersion(source, version_dir);
+  {
+    mutex_lock l(mu_);
+    versions_being_fetched_.erase(version_dir);
+    fetched_cv_.notify_all();
+  }
+  TF_RETURN_IF_ERROR(status);
+  EvictVersions(string(io::Dirname(version_dir)), version_dir);
+  *destination = version_dir;
+  return OkStatus();
+}
+
+Status LocalCacheStoragePathSourceAdapter::FetchVersion(
+    const string& source, const string& version_dir) {
+  Env* const env = options_.env;
+  const uint64_t start_micros = env->NowMicros();
+  const string partial_dir = absl::StrCat(version_dir, kPartialSuffix);
+  const auto delete_partial_dir = [env, &partial_dir]() -> Status {
+    if (!env->FileExists(partial_dir).ok()) {
+      return OkStatus();
+    }
+    int64_t undeleted_files, undeleted_dirs;
+    return env->DeleteRecursively(partial_dir, &undeleted_files,
+                                  &undeleted_dirs);
+  };
+  TF_RETURN_IF_ERROR(delete_partial_dir());
+
+  std::vector<CachedVersionFile> files;
+  bool fetched = false;
+  if (options_.peer_fetcher != nullptr) {
+    const Status status = FetchVersionFromPeers(source, partial_dir, &files);
+    if (status.ok()) {
+      fetched = true;
+    } else {
+      VLOG(1) << "Fetching " << source << " from its origin: " << status;
+      TF_RETURN_IF_ERROR(delete_partial_dir());
+    }
+  }
+  if (!fetched) {
+    TF_RETURN_IF_ERROR(FetchVersionFromOrigin(source, partial_dir, &files));
+  }
+
+  // The manifest is written before the version directory is renamed, so every
+  // complete version has one.
+  const string manifest_path = absl::StrCat(version_dir, kManifestSuffix);
+  TF_RETURN_IF_ERROR(
+      WriteStringToFile(env, manifest_path, SerializeManifest(files)));
+  TF_RETURN_IF_ERROR(env->RenameFile(partial_dir, version_dir));
+  LOG(INFO) << "Cached " << source << " (" << files.size() << " files) from "
+            << (fetched ? "peers" : "its origin") << " in " << version_dir
+            << " in " << (env->NowMicros() - start_micros) / 1000 << " ms";
+  return OkStatus();
+}
+
+Status LocalCacheStoragePathSourceAdapter::FetchVersionFromPeers(
+    const string& source, const string& partial_dir,
+    std::vector<CachedVersionFile>* files) {
+  PeerVersionFetcher* const fetcher = options_.peer_fetcher.get();
+  std::vector<string> peers;
+  TF_RETURN_IF_ERROR(fetcher->FindVersion(source, &peers, files));
+  if (peers.empty()) {
+    return errors::NotFound("No peer has ", source);
+  }
+  // The files are joined to 'partial_dir', so a path listed by a peer must not
+  // reach outside of it.
+  for (const CachedVersionFile& file : *files) {
+    TF_RETURN_IF_ERROR(ValidateRelativePath(file.relative_path));
+  }
+  // Spreads the chunks of the files across the peers, and reads each chunk
+  // from the other peers if the first one fails.
+  std::atomic<uint64_t> next_peer{0};
+  const auto make_reader = [fetcher, &source, &peers, &next_peer](
+                               const CachedVersionFile& file,
+                               std::unique_ptr<ChunkReader>* reader) {
+    reader->reset(new ChunkReader([fetcher, &source, &peers, &next_peer,
+                                   &file](uint64_t offset, string* chunk) {
+      chunk->clear();
+      if (offset >= file.size) {
+        return OkStatus();
+      }
+      const uint64_t first_peer = next_peer++;
+      Status status;
+      for (int i = 0; i < peers.size(); ++i) {
+        const string& peer = peers[(first_peer + i) % peers.size()];
+        status = fetcher->ReadFile(peer, source, file.relative_path, offset,
+                                   kChunkBytes, chunk);
+        if (status.ok() && !chunk->empty()) {
+          return OkStatus();
+        }
+        if (status.ok()) {
+          status = errors::DataLoss("Peer ", peer, " has no data at offset ",
+                                    offset, " of ", file.relative_path);
+        }
+      }
+      return status;
+    }));
+    return OkStatus();
+  };
+  return FetchFiles(partial_dir, make_reader, /*set_checksums=*/false, files);
+}
+
+Status LocalCacheStoragePathSourceAdapter::FetchVersionFromOrigin(
+    const string& source, const string& partial_dir,
+    std::vector<CachedVersionFile>* files) {
+  Env* const env = options_.env;
+  std::vector<string> dirs, file_paths;
+  TF_RETURN_IF_ERROR(ListRecursively(env, source, "", &dirs, &file_paths));
+  files->clear();
+  for (const string& dir : dirs) {
+    CachedVersionFile file;
+    file.relative_path = dir;
+    file.is_directory = true;
+    files->push_back(file);
+  }
+  for (const string& path : file_paths) {
+    CachedVersionFile file;
+    file.relative_path = path;
+    files->push_back(file);
+  }
+  const auto make_reader = [env, &source](
+                               const CachedVersionFile& file,
+                               std::unique_ptr<ChunkReader>* reader) {
+    const string path = io::JoinPath(source, file.relative_path);
+    std::shared_ptr<RandomAccessFile> random_access_file;
+    {
+      std::unique_ptr<RandomAccessFile> opened_file;
+      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(path, &opened_file));
+      random_access_file = std::move(opened_file);
+    }
+    auto buffer = std::make_shared<string>(kChunkBytes, '\0');
+    reader->reset(new ChunkReader(
+        [random_access_file, buffer](uint64_t offset, string* chunk) {
+          StringPiece piece;
+          const Status status = random_access_file->Read(
+              offset, kChunkBytes, &piece, &(*buffer)[0]);
+          if (!status.ok() && !errors::IsOutOfRange(status)) {
+            return status;
+          }
+          chunk->assign(piece.data(), piece.size());
+          return OkStatus();
+        }));
+    return OkStatus();
+  };
+  TF_RETURN_IF_ERROR(
+      FetchFiles(partial_dir, make_reader, /*set_checksums=*/true, files));
+  // Checks that the files did not change while they were read.
+  for (const CachedVersionFile& file : *files) {
+    if (file.is_directory) {
+      continue;
+    }
+    uint64_t size;
+    TF_RETURN_IF_ERROR(
+        env->GetFileSize(io::JoinPath(source, file.relative_path), &size));
+    if (size != file.size) {
+      return errors::DataLoss("Read ", file.size, " bytes of ",
+                              io::JoinPath(source, file.relative_path),
+                              ", which has ", size);
+    }
+  }
+  return OkStatus();
+}
+
+Status LocalCacheStoragePathSourceAdapter::FetchFiles(
+    const string& partial_dir,
+    const std::function<Status(const CachedVersionFile& file,
+                               std::unique_ptr<ChunkReader>* reader)>&
+        make_reader,
+    bool set_checksums, std::vector<CachedVersionFile>* files) {
+  Env* const env = options_.env;
+  TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(partial_dir));
+  std::vector<int> file_indices;
+  for (int i = 0; i < files->size(); ++i) {
+    const CachedVersionFile& file = (*files)[i];
+    if (file.is_directory) {
+      TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(
+          io::JoinPath(partial_dir, file.relative_path)));
+    } else {
+      file_indices.push_back(i);
+    }
+  }
+
+  std::vector<Status> statuses(file_indices.size());
+  BlockingCounter done(file_indices.size());
+  for (int i = 0; i < file_indices.size(); ++i) {
+    fetch_thread_pool_.Schedule([&, i]() {
+      if (options_.fetch_in_background) {
+        LowerIoPriority();
+      }
+      CachedVersionFile& file = (*files)[file_indices[i]];
+      statuses[i] = [&]() -> Status {
+        std::unique_ptr<ChunkReader> reader;
+        TF_RETURN_IF_ERROR(make_reader(file, &reader));
+        uint64_t size;
+        uint32 crc;
+        TF_RETURN_IF_ERROR(
+            FetchFile(*reader, io::JoinPath(partial_dir, file.relative_path),
+                      &size, &crc));
+        if (set_checksums) {
+          file.size = size;
+          file.crc32c = crc;
+        } else if (size != file.size || crc != file.crc32c) {
+          return errors::DataLoss("Fetched ", file.relative_path,
+                                  " does not match its manifest");
+        }
+        return OkStatus();
+      }();
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return OkStatus();
+}
+
+Status LocalCacheStoragePathSourceAdapter::FetchFile(
+    const ChunkReader& read_chunk, const string& destination, uint64_t* size,
+    uint32* crc) {
+  Env* const env = options_.env;
+  const string tmp_path =
+      io::JoinPath(options_.cache_dir, kTmpDir,
+                   absl::StrCat(random::New64(), ".tmp"));
+  std::unique_ptr<WritableFile> tmp_file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(tmp_path, &tmp_file));
+  *crc = 0;
+  *size = 0;
+  uint64_t hash = 0;
+  string chunk;
+  while (true) {
+    TF_RETURN_IF_ERROR(read_chunk(*size, &chunk));
+    if (chunk.empty()) {
+      break;
+    }
+    *crc = crc32c::Extend(*crc, chunk.data(), chunk.size());
+    hash = Hash64Combine(hash, Hash64(chunk.data(), chunk.size()));
+    TF_RETURN_IF_ERROR(tmp_file->Append(chunk));
+    *size += chunk.size();
+  }
+  TF_RETURN_IF_ERROR(tmp_file->Close());
+
+  uint32 cached_crc = 0;
+  uint64_t cached_size;
+  TF_RETURN_IF_ERROR(ReadChunks(
+      env, tmp_path,
+      [&cached_crc](StringPiece chunk) {
+        cached_crc = crc32c::Extend(cached_crc, chunk.data(), chunk.size());
+        return OkStatus();
+      },
+      &cached_size));
+  if (cached_size != *size || cached_crc != *crc) {
+    env->DeleteFile(tmp_path).IgnoreError();
+    return errors::DataLoss("Cached copy of ", destination,
+                            " does not match the data read: ", *size,
+                            " bytes read, ", cached_size,
+                            " bytes cached with ",
+                            cached_crc == *crc ? "matching" : "mismatching",
+                            " CRC32C");
+  }
+
+  // Files of equal size and checksums are taken to have the same content.
+  const string blob_path = io::JoinPath(
+      options_.cache_dir, kBlobsDir,
+      absl::StrCat(*size, "-", absl::Hex(*crc, absl::kZeroPad8), "-",
+                   absl::Hex(hash, absl::kZeroPad16)));
+  mutex_lock l(blobs_mu_);
+  if (env->FileExists(blob_path).ok()) {
+    TF_RETURN_IF_ERROR(env->DeleteFile(tmp_path));
+  } else {
+    TF_RETURN_IF_ERROR(env->RenameFile(tmp_path, blob_path));
+  }
+  if (link(blob_path.c_str(), destination.c_str()) != 0) {
+    return errors::Internal("Could not link ", blob_path, " at ", destination,
+                            ": ", strerror(errno));
+  }
+  return OkStatus();
+}
+
+void LocalCacheStoragePathSourceAdapter::EvictVersions(
+    const string& servable_dir, const string& version_dir) {
+  Env* const env = options_.env;
+  std::vector<string> children;
+  if (!env->GetChildren(servable_dir, &children).ok()) {
+    return;
+  }
+  // The cached versions, by version number, highest first. Directories whose
+  // names are not numbers are evicted first.
+  std::vector<std::pair<int64_t, string>> versions;
+  for (const string& child : children) {
+    if (absl::EndsWith(child, kPartialSuffix) ||
+        absl::EndsWith(child, kManifestSuffix)) {
+      continue;
+    }
+    int64_t version;
+    if (!strings::safe_strto64(child, &version)) {
+      version = -1;
+    }
+    versions.push_back({version, io::JoinPath(servable_dir, child)});
+  }
+  if (versions.size() <= options_.num_versions_to_retain) {
+    return;
+  }
+  std::sort(versions.begin(), versions.end(),
+            [](const std::pair<int64_t, string>& a,
+               const std::pair<int64_t, string>& b) {
+              return a.first > b.first;
+            });
+
+  bool evicted = false;
+  for (int i = options_.num_versions_to_retain; i < versions.size(); ++i) {
+    const string& evicted_dir = versions[i].second;
+    if (evicted_dir == version_dir) {
+      continue;
+    }
+    {
+      mutex_lock l(mu_);
+      if (versions_being_fetched_.count(evicted_dir) > 0) {
+        continue;
+      }
+    }
+    // Deletes the manifest first, so the version is no longer served to peers.
+    env->DeleteFile(absl::StrCat(evicted_dir, kManifestSuffix)).IgnoreError();
+    int64_t undeleted_files, undeleted_dirs;
+    const Status status =
+        env->DeleteRecursively(evicted_dir, &undeleted_files, &undeleted_dirs);
+    if (!status.ok()) {
+      LOG(WARNING) << "Could not evict " << evicted_dir << " from the cache: "
+                   << status;
+      continue;
+    }
+    LOG(INFO) << "Evicted " << evicted_dir << " from the cache";
+    evicted = true;
+  }
+  if (!evicted) {
+    return;
+  }
+
+  // Deletes the files that are no longer linked by any version.
+  mutex_lock l(blobs_mu_);
+  const string blobs_dir = io::JoinPath(options_.cache_dir, kBlobsDir);
+  std::vector<string> blobs;
+  if (!env->GetChildren(blobs_dir, &blobs).ok()) {
+    return;
+  }
+  for (const string& blob : blobs) {
+    const string blob_path = io::JoinPath(blobs_dir, blob);
+    struct stat blob_stat;
+    if (stat(blob_path.c_str(), &blob_stat) == 0 && blob_stat.st_nlink <= 1) {
+      env->DeleteFile(blob_path).IgnoreError();
+    }
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,216 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_CORE_LOCAL_CACHE_STORAGE_PATH_SOURCE_ADAPTER_H_
+#define TENSORFLOW_SERVING_CORE_LOCAL_CACHE_STORAGE_PATH_SOURCE_ADAPTER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow_serving/core/peer_version_fetcher.h"
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/core/source_adapter.h"
+#include "tensorflow_serving/core/storage_path.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A SourceAdapter that caches the servable versions at remote storage paths
+// (e.g. on GCS) in a local directory, and emits the paths of the cached copies,
+// so that loaders read the versions from local disk, and versions cached before
+// a restart are not fetched again.
+//
+// The files of a version are fetched in parallel, and each is verified by
+// comparing the CRC32C of the data read from the remote file with that of the
+// cached copy. Cached files are stored once by content and hard-linked into
+// the versions that contain them, so versions and models sharing files (e.g.
+// unchanged assets or embeddings) share their disk space.
+//
+// For each servable, i.e. each base path, the cache retains the versions with
+// the highest version numbers, and evicts the others.
+//
+// If a PeerVersionFetcher is configured, versions are fetched from the caches
+// of peers that have them, with the chunks of the files spread across the
+// peers, and only fetched from their origin storage if no peer has them (or
+// fetching from the peers fails). The cached versions can in turn be served to
+// peers, see LookUpCachedVersion().
+//
+// Versions are fetched when they are first aspired, before they are passed on:
+// by default on the thread that emits the aspired versions, or else in the
+// background (see Options::fetch_in_background).
+class LocalCacheStoragePathSourceAdapter final
+    : public SourceAdapter<StoragePath, StoragePath> {
+ public:
+  struct Options {
+    // The local directory to cache the versions in. Must be on a file system
+    // that supports hard links.
+    string cache_dir;
+
+    // The number of versions of each servable to retain in the cache. Should be
+    // at least the number of versions of a servable that are served at a time.
+    int num_versions_to_retain = 2;
+
+    // The number of files to fetch in parallel.
+    int num_fetch_threads = 8;
+
+    // Whether to cache versions at local paths, i.e. paths without a
+    // file-system scheme, too. Otherwise they are passed through as they are.
+    bool cache_local_paths = false;
+
+    // If set, fetches the versions from peers that have them cached.
+    std::shared_ptr<PeerVersionFetcher> peer_fetcher;
+
+    // Whether to fetch versions in the background, at a low I/O priority,
+    // rather than block the source that emits them until they are cached.
+    // Until a version is cached, it is withheld from the aspired versions, and
+    // the versions of its servable that were passed on before are aspired in
+    // its place, so that they keep serving. Once it is cached, the latest
+    // aspired versions of the servable are passed on again.
+    bool fetch_in_background = false;
+
+    Env* env = Env::Default();
+  };
+
+  static Status Create(
+      const Options& options,
+      std::unique_ptr<LocalCacheStoragePathSourceAdapter>* adapter);
+
+  ~LocalCacheStoragePathSourceAdapter() override;
+
+  // Looks up the cached copy of the version at 'storage_path', and lists its
+  // files. Returns a NotFound error unless the version is completely cached.
+  Status LookUpCachedVersion(const string& storage_path, string* version_dir,
+                             std::vector<CachedVersionFile>* files) const;
+
+  void SetAspiredVersions(StringPiece servable_name,
+                          std::vector<ServableData<StoragePath>> versions) final
+      TF_LOCKS_EXCLUDED(passing_mu_);
+
+  std::vector<ServableData<StoragePath>> Adapt(
+      StringPiece servable_name,
+      std::vector<ServableData<StoragePath>> versions) final;
+
+ private:
+  explicit LocalCacheStoragePathSourceAdapter(const Options& options);
+
+  // Fetches the version at 'source' into the cache unless it is cached
+  // already, and sets 'destination' to the cached copy.
+  Status Convert(const StoragePath& source, StoragePath* destination);
+
+  // Adapt() for Options::fetch_in_background.
+  std::vector<ServableData<StoragePath>> AdaptInBackground(
+      const string& servable_name,
+      std::vector<ServableData<StoragePath>> versions) TF_LOCKS_EXCLUDED(mu_);
+
+  // Fetches the version at 'source' of 'servable_name' into 'version_dir' on
+  // the background thread, and then passes on the latest aspired versions of
+  // the servable again.
+  void FetchInBackground(const string& servable_name, const string& source,
+                         const string& version_dir) TF_LOCKS_EXCLUDED(mu_);
+
+  // Reads the chunk of a file at 'offset' into 'chunk', which is left empty at
+  // the end of the file.
+  using ChunkReader = std::function<Status(uint64_t offset, string* chunk)>;
+
+  // Returns the directory of the cached copy of the version at 'storage_path'.
+  string GetVersionDir(const string& storage_path) const;
+
+  // Fetches the version at 'source' into the cache, as 'version_dir'.
+  Status FetchVersion(const string& source, const string& version_dir);
+
+  // Fetches the version at 'source' from peers, or from its origin, into
+  // 'partial_dir', and sets 'files' to its files.
+  Status FetchVersionFromPeers(const string& source, const string& partial_dir,
+                               std::vector<CachedVersionFile>* files);
+  Status FetchVersionFromOrigin(const string& source,
+                                const string& partial_dir,
+                                std::vector<CachedVersionFile>* files);
+
+  // Creates the directories of 'files' in 'partial_dir', and fetches the other
+  // files in parallel, reading each with the reader 'make_reader' returns for
+  // it. Sets their sizes and checksums in 'files' if 'set_checksums', or
+  // verifies them otherwise.
+  Status FetchFiles(
+      const string& partial_dir,
+      const std::function<Status(const CachedVersionFile& file,
+                                 std::unique_ptr<ChunkReader>* reader)>&
+          make_reader,
+      bool set_checksums, std::vector<CachedVersionFile>* files);
+
+  // Fetches a file with 'read_chunk' into the content store of the cache, and
+  // links it at 'destination'. Sets 'size' and 'crc' to those of the file.
+  Status FetchFile(const ChunkReader& read_chunk, const string& destination,
+                   uint64_t* size, uint32* crc) TF_LOCKS_EXCLUDED(blobs_mu_);
+
+  // Evicts the versions in 'servable_dir' beyond the retained ones, except
+  // 'version_dir', and then the files no version links any more.
+  void EvictVersions(const string& servable_dir, const string& version_dir)
+      TF_LOCKS_EXCLUDED(mu_, blobs_mu_);
+
+  const Options options_;
+
+  thread::ThreadPool fetch_thread_pool_;
+
+  // Runs FetchInBackground(), if Options::fetch_in_background.
+  std::unique_ptr<thread::ThreadPool> background_thread_;
+
+  // For Options::fetch_in_background: serializes passing on aspired versions,
+  // so that those passed on after a background fetch are not overtaken by
+  // older ones. Taken before 'mu_'.
+  mutex passing_mu_;
+
+  mutex mu_;
+  condition_variable fetched_cv_;
+  // The version directories being fetched.
+  std::set<string> versions_being_fetched_ TF_GUARDED_BY(mu_);
+
+  // For Options::fetch_in_background: by servable, the latest aspired
+  // versions, and the versions passed on last.
+  std::map<string, std::vector<ServableData<StoragePath>>> aspired_versions_
+      TF_GUARDED_BY(mu_);
+  std::map<string, std::vector<ServableData<StoragePath>>> passed_versions_
+      TF_GUARDED_BY(mu_);
+  // The errors of the background fetches that failed, by version directory,
+  // until the versions are fetched.
+  struct FetchError {
+    Status status;
+    // Whether the error has been passed on since the fetch failed.
+    bool passed_on;
+  };
+  std::map<string, FetchError> fetch_errors_ TF_GUARDED_BY(mu_);
+  // Set once the adapter is being destroyed, to stop passing on versions.
+  bool stopped_ TF_GUARDED_BY(mu_) = false;
+
+  // Serializes adding files to and linking them from the content store with
+  // deleting the unlinked ones.
+  mutex blobs_mu_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(LocalCacheStoragePathSourceAdapter);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_CORE_LOCAL_CACHE_STORAGE_PATH_SOURCE_ADAPTER_H_
@@ -0,0 +1,393 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/local_cache_storage_path_source_adapter.h"
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow_serving/core/peer_version_fetcher.h"
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/core/storage_path.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// A PeerVersionFetcher that reads the versions cached by adapters in this
+// process.
+class FakePeerVersionFetcher : public PeerVersionFetcher {
+ public:
+  void AddPeer(const string& peer,
+               const LocalCacheStoragePathSourceAdapter* adapter) {
+    peers_[peer] = adapter;
+  }
+
+  // Makes the reads from 'peer' fail.
+  void FailReadsFrom(const string& peer) { failing_peers_.insert(peer); }
+
+  // Lists 'file' among the files of every version found.
+  void ListExtraFile(const CachedVersionFile& file) {
+    extra_files_.push_back(file);
+  }
+
+  Status FindVersion(const string& storage_path, std::vector<string>* peers,
+                     std::vector<CachedVersionFile>* files) override {
+    for (const auto& peer : peers_) {
+      string version_dir;
+      if (peer.second->LookUpCachedVersion(storage_path, &version_dir, files)
+              .ok()) {
+        peers->push_back(peer.first);
+      }
+    }
+    if (peers->empty()) {
+      return errors::NotFound(storage_path, " is not cached by any peer");
+    }
+    files->insert(files->end(), extra_files_.begin(), extra_files_.end());
+    return OkStatus();
+  }
+
+  Status ReadFile(const string& peer, const string& storage_path,
+                  const string& relative_path, uint64_t offset,
+                  uint64_t length, string* data) override {
+    ++num_reads_;
+    if (failing_peers_.count(peer) > 0) {
+      ++num_failed_reads_;
+      return errors::Unavailable("Peer ", peer, " is down");
+    }
+    string version_dir;
+    std::vector<CachedVersionFile> files;
+    TF_RETURN_IF_ERROR(peers_.at(peer)->LookUpCachedVersion(
+        storage_path, &version_dir, &files));
+    string contents;
+    TF_RETURN_IF_ERROR(ReadFileToString(
+        Env::Default(), io::JoinPath(version_dir, relative_path), &contents));
+    *data = offset < contents.size() ? contents.substr(offset, length) : "";
+    return OkStatus();
+  }
+
+  int num_reads() const { return num_reads_; }
+  int num_failed_reads() const { return num_failed_reads_; }
+
+ private:
+  std::map<string, const LocalCacheStoragePathSourceAdapter*> peers_;
+  std::set<string> failing_peers_;
+  std::vector<CachedVersionFile> extra_files_;
+  std::atomic<int> num_reads_{0};
+  std::atomic<int> num_failed_reads_{0};
+};
+
+class LocalCacheStoragePathSourceAdapterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const string test_dir = io::JoinPath(
+        testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    remote_dir_ = io::JoinPath(test_dir, "remote");
+    options_.cache_dir = io::JoinPath(test_dir, "cache");
+    options_.cache_local_paths = true;
+    options_.num_versions_to_retain = 1;
+  }
+
+  // Writes a version of 'model' with a model file and a variables file.
+  string WriteVersion(const string& model, int version,
+                      const string& variables) {
+    const string version_dir =
+        io::JoinPath(remote_dir_, model, std::to_string(version));
+    TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(version_dir, "variables")));
+    TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(version_dir, "assets")));
+    TF_CHECK_OK(WriteStringToFile(Env::Default(),
+                                  io::JoinPath(version_dir, "saved_model.pb"),
+                                  model + std::to_string(version)));
+    TF_CHECK_OK(WriteStringToFile(
+        Env::Default(), io::JoinPath(version_dir, "variables", "variables"),
+        variables));
+    return version_dir;
+  }
+
+  // Adapts the version at 'path', and returns the path of the cached copy.
+  string Adapt(LocalCacheStoragePathSourceAdapter* adapter,
+               const string& path) {
+    ServableData<StoragePath> output = adapter->AdaptOneVersion(
+        ServableData<StoragePath>({"servable", 1}, path));
+    TF_CHECK_OK(output.status());
+    return output.DataOrDie();
+  }
+
+  string remote_dir_;
+  LocalCacheStoragePathSourceAdapter::Options options_;
+};
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, CachesVersions) {
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &adapter));
+  const string remote_path = WriteVersion("model", 1, "weights");
+  const string cached_path = Adapt(adapter.get(), remote_path);
+  EXPECT_NE(remote_path, cached_path);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(
+      Env::Default(), io::JoinPath(cached_path, "variables", "variables"),
+      &contents));
+  EXPECT_EQ("weights", contents);
+  TF_EXPECT_OK(
+      Env::Default()->IsDirectory(io::JoinPath(cached_path, "assets")));
+
+  // Versions cached before a restart are used as they are.
+  TF_ASSERT_OK(Env::Default()->DeleteFile(
+      io::JoinPath(remote_path, "variables", "variables")));
+  adapter.reset();
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &adapter));
+  EXPECT_EQ(cached_path, Adapt(adapter.get(), remote_path));
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, SharesFilesAcrossModels) {
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &adapter));
+  const string a = Adapt(adapter.get(), WriteVersion("a", 1, "shared"));
+  const string b = Adapt(adapter.get(), WriteVersion("b", 1, "shared"));
+  struct stat a_stat, b_stat;
+  ASSERT_EQ(0, stat(io::JoinPath(a, "variables", "variables").c_str(),
+                    &a_stat));
+  ASSERT_EQ(0, stat(io::JoinPath(b, "variables", "variables").c_str(),
+                    &b_stat));
+  EXPECT_EQ(a_stat.st_ino, b_stat.st_ino);
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, EvictsOldVersions) {
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &adapter));
+  const string v1 = Adapt(adapter.get(), WriteVersion("model", 1, "old"));
+  const string v2 = Adapt(adapter.get(), WriteVersion("model", 2, "new"));
+  EXPECT_FALSE(Env::Default()->FileExists(v1).ok());
+  TF_EXPECT_OK(Env::Default()->FileExists(v2));
+  // The files only v1 had are deleted too.
+  std::vector<string> blobs;
+  TF_ASSERT_OK(Env::Default()->GetChildren(
+      io::JoinPath(options_.cache_dir, "blobs"), &blobs));
+  EXPECT_EQ(2, blobs.size());
+
+  // An older version is kept while it is in use, even beyond the retained
+  // ones.
+  const string v1_again = Adapt(adapter.get(), WriteVersion("model", 1, "old"));
+  TF_EXPECT_OK(Env::Default()->FileExists(v1_again));
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, FetchesFromPeers) {
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> peer;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &peer));
+  const string remote_path = WriteVersion("model", 1, "weights");
+  Adapt(peer.get(), remote_path);
+  std::vector<CachedVersionFile> files;
+  string version_dir;
+  TF_ASSERT_OK(peer->LookUpCachedVersion(remote_path, &version_dir, &files));
+  EXPECT_EQ(4, files.size());
+
+  auto fetcher = std::make_shared<FakePeerVersionFetcher>();
+  fetcher->AddPeer("peer", peer.get());
+  LocalCacheStoragePathSourceAdapter::Options options = options_;
+  options.cache_dir = io::JoinPath(options_.cache_dir, "..", "local_cache");
+  options.peer_fetcher = fetcher;
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options, &adapter));
+
+  // The origin no longer has the weights, but the peer does.
+  TF_ASSERT_OK(Env::Default()->DeleteFile(
+      io::JoinPath(remote_path, "variables", "variables")));
+  const string cached_path = Adapt(adapter.get(), remote_path);
+  EXPECT_GT(fetcher->num_reads(), 0);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(
+      Env::Default(), io::JoinPath(cached_path, "variables", "variables"),
+      &contents));
+  EXPECT_EQ("weights", contents);
+  TF_EXPECT_OK(
+      Env::Default()->IsDirectory(io::JoinPath(cached_path, "assets")));
+
+  // Versions no peer has are fetched from their origin.
+  const string remote_path_2 = WriteVersion("model", 2, "weights 2");
+  TF_ASSERT_OK(ReadFileToString(
+      Env::Default(),
+      io::JoinPath(Adapt(adapter.get(), remote_path_2), "variables",
+                   "variables"),
+      &contents));
+  EXPECT_EQ("weights 2", contents);
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, ReadsChunksFromOtherPeers) {
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> peer;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &peer));
+  const string remote_path = WriteVersion("model", 1, "weights");
+  Adapt(peer.get(), remote_path);
+
+  // Both peers have the version, but the reads from the first one fail.
+  auto fetcher = std::make_shared<FakePeerVersionFetcher>();
+  fetcher->AddPeer("a_down", peer.get());
+  fetcher->AddPeer("b_up", peer.get());
+  fetcher->FailReadsFrom("a_down");
+  LocalCacheStoragePathSourceAdapter::Options options = options_;
+  options.cache_dir = io::JoinPath(options_.cache_dir, "..", "local_cache");
+  options.peer_fetcher = fetcher;
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options, &adapter));
+
+  // The origin no longer has the weights, so they can only come from the peer
+  // that is up.
+  TF_ASSERT_OK(Env::Default()->DeleteFile(
+      io::JoinPath(remote_path, "variables", "variables")));
+  const string cached_path = Adapt(adapter.get(), remote_path);
+  EXPECT_GT(fetcher->num_failed_reads(), 0);
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(
+      Env::Default(), io::JoinPath(cached_path, "variables", "variables"),
+      &contents));
+  EXPECT_EQ("weights", contents);
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, RejectsUnsafePeerPaths) {
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> peer;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &peer));
+  const string remote_path = WriteVersion("model", 1, "weights");
+  Adapt(peer.get(), remote_path);
+
+  const std::vector<string> unsafe_paths = {"../escaped", "/tmp/escaped",
+                                            "variables//x", "./saved_model.pb"};
+  for (int i = 0; i < unsafe_paths.size(); ++i) {
+    const string& path = unsafe_paths[i];
+    auto fetcher = std::make_shared<FakePeerVersionFetcher>();
+    fetcher->AddPeer("peer", peer.get());
+    CachedVersionFile file;
+    file.relative_path = path;
+    file.size = 1;
+    fetcher->ListExtraFile(file);
+    LocalCacheStoragePathSourceAdapter::Options options = options_;
+    options.cache_dir = io::JoinPath(options_.cache_dir, "..",
+                                     absl::StrCat("local_cache_", i));
+    options.peer_fetcher = fetcher;
+    std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+    TF_ASSERT_OK(
+        LocalCacheStoragePathSourceAdapter::Create(options, &adapter));
+
+    // Nothing is read from the peer, and the version is fetched from its
+    // origin instead.
+    const string cached_path = Adapt(adapter.get(), remote_path);
+    EXPECT_EQ(0, fetcher->num_reads()) << path;
+    std::vector<CachedVersionFile> files;
+    string version_dir;
+    TF_ASSERT_OK(
+        adapter->LookUpCachedVersion(remote_path, &version_dir, &files));
+    EXPECT_EQ(4, files.size()) << path;
+  }
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, FetchesInBackground) {
+  options_.fetch_in_background = true;
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &adapter));
+  mutex mu;
+  condition_variable passed_cv;
+  std::vector<std::vector<ServableData<StoragePath>>> passed;
+  adapter->SetAspiredVersionsCallback(
+      [&](const StringPiece servable_name,
+          std::vector<ServableData<StoragePath>> versions) {
+        mutex_lock l(mu);
+        passed.push_back(std::move(versions));
+        passed_cv.notify_all();
+      });
+  // Returns the 'n'th list of versions the adapter passes on.
+  auto wait_for_passed = [&](int n) {
+    mutex_lock l(mu);
+    while (passed.size() < n) {
+      passed_cv.wait(l);
+    }
+    return passed[n - 1];
+  };
+
+  const string v1 = WriteVersion("model", 1, "old");
+  adapter->SetAspiredVersions(
+      "servable", {ServableData<StoragePath>({"servable", 1}, v1)});
+  // The version is withheld until it is cached.
+  EXPECT_TRUE(wait_for_passed(1).empty());
+  std::vector<ServableData<StoragePath>> versions = wait_for_passed(2);
+  ASSERT_EQ(1, versions.size());
+  TF_ASSERT_OK(versions[0].status());
+  EXPECT_NE(v1, versions[0].DataOrDie());
+
+  // Version 1 is aspired in place of version 2 until version 2 is cached.
+  const string v2 = WriteVersion("model", 2, "new");
+  adapter->SetAspiredVersions(
+      "servable", {ServableData<StoragePath>({"servable", 2}, v2)});
+  versions = wait_for_passed(3);
+  ASSERT_EQ(1, versions.size());
+  EXPECT_EQ(1, versions[0].id().version);
+  versions = wait_for_passed(4);
+  ASSERT_EQ(1, versions.size());
+  EXPECT_EQ(2, versions[0].id().version);
+  TF_ASSERT_OK(versions[0].status());
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(
+      Env::Default(),
+      io::JoinPath(versions[0].DataOrDie(), "variables", "variables"),
+      &contents));
+  EXPECT_EQ("new", contents);
+
+  // Failed fetches are passed on as errors.
+  adapter->SetAspiredVersions(
+      "servable", {ServableData<StoragePath>(
+                      {"servable", 3}, io::JoinPath(remote_dir_, "missing"))});
+  versions = wait_for_passed(5);
+  ASSERT_EQ(1, versions.size());
+  EXPECT_EQ(2, versions[0].id().version);
+  versions = wait_for_passed(6);
+  ASSERT_EQ(1, versions.size());
+  EXPECT_EQ(3, versions[0].id().version);
+  EXPECT_FALSE(versions[0].status().ok());
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, PassesThroughLocalPaths) {
+  options_.cache_local_paths = false;
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &adapter));
+  const string remote_path = WriteVersion("model", 1, "weights");
+  EXPECT_EQ(remote_path, Adapt(adapter.get(), remote_path));
+}
+
+TEST_F(LocalCacheStoragePathSourceAdapterTest, FailsForMissingVersion) {
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> adapter;
+  TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options_, &adapter));
+  ServableData<StoragePath> output =
+      adapter->AdaptOneVersion(ServableData<StoragePath>(
+          {"servable", 1}, io::JoinPath(remote_dir_, "missing", "1")));
+  EXPECT_FALSE(output.status().ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/scanner.h"
@@ -80,5 +81,14 @@ Status LogCollector::Create(
   return (*factory)(config, id, log_collector);
 }
 
+Status LogCollector::CollectMessages(
+    const std::vector<const google::protobuf::Message*>& messages) {
+  Status status;
+  for (const google::protobuf::Message* message : messages) {
+    status.Update(CollectMessage(*message));
+  }
+  return status;
+}
+
 }  // namespace serving
 }  // namespace tensorflow
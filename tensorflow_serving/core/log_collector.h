@@ -19,6 +19,7 @@ limitations under the License.
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/message.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -54,6 +55,12 @@ class LogCollector {
   // Collects the log as a protocol buffer.
   virtual Status CollectMessage(const google::protobuf::Message& message) = 0;
 
+  // Collects a batch of logs. Returns the first error, after trying to
+  // collect all of them. Implementations that can write batches more
+  // efficiently than one log at a time should override it.
+  virtual Status CollectMessages(
+      const std::vector<const google::protobuf::Message*>& messages);
+
   // Flushes buffered data so that the data can survive an application crash
   // (but not an OS crash).
   virtual Status Flush() = 0;
@@ -0,0 +1,227 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/memory_pressure_evictor.h"
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+auto* memory_pressure_evictions = monitoring::Counter<1>::New(
+    "/tensorflow/serving/memory_pressure/evictions",
+    "The number of times a model was unloaded under memory pressure.",
+    "model_name");
+
+// cgroup v1 reports a limit near 2^63 for no limit.
+constexpr int64_t kNoLimitBytes = int64_t{1} << 60;
+
+// Reads the number in the file at 'path'. Returns false if there is none, e.g.
+// for "max", which cgroup v2 reports for no limit.
+bool ReadNumberFile(const string& path, int64_t* value) {
+  string contents;
+  if (!ReadFileToString(Env::Default(), path, &contents).ok()) {
+    return false;
+  }
+  return absl::SimpleAtoi(absl::StripAsciiWhitespace(contents), value);
+}
+
+// Reads the value of 'key' in the file at 'path', of lines like "key value"
+// or "key: value kB". Returns false if there is none.
+bool ReadKeyedNumber(const string& path, absl::string_view key,
+                     int64_t* value) {
+  string contents;
+  if (!ReadFileToString(Env::Default(), path, &contents).ok()) {
+    return false;
+  }
+  for (absl::string_view line : absl::StrSplit(contents, '\n')) {
+    std::vector<absl::string_view> fields =
+        absl::StrSplit(line, ' ', absl::SkipWhitespace());
+    if (fields.size() >= 2 && absl::StripSuffix(fields[0], ":") == key) {
+      return absl::SimpleAtoi(fields[1], value);
+    }
+  }
+  return false;
+}
+
+// Reads the memory of the cgroup at 'dir', less the inactive file cache the
+// kernel can reclaim (the "working set", as kubelet counts it).
+bool ReadCgroupMemory(const string& dir, const string& usage_file,
+                      const string& limit_file, const string& inactive_key,
+                      int64_t* usage_bytes, int64_t* limit_bytes) {
+  if (!ReadNumberFile(dir + usage_file, usage_bytes) ||
+      !ReadNumberFile(dir + limit_file, limit_bytes) ||
+      *limit_bytes >= kNoLimitBytes) {
+    return false;
+  }
+  int64_t inactive_file_bytes;
+  if (ReadKeyedNumber(dir + "memory.stat", inactive_key,
+                      &inactive_file_bytes) &&
+      inactive_file_bytes < *usage_bytes) {
+    *usage_bytes -= inactive_file_bytes;
+  }
+  return true;
+}
+
+}  // namespace
+
+Status ReadMemoryUsage(int64_t* usage_bytes, int64_t* limit_bytes) {
+  if (ReadCgroupMemory("/sys/fs/cgroup/", "memory.current", "memory.max",
+                       "inactive_file", usage_bytes, limit_bytes) ||
+      ReadCgroupMemory("/sys/fs/cgroup/memory/", "memory.usage_in_bytes",
+                       "memory.limit_in_bytes", "total_inactive_file",
+                       usage_bytes, limit_bytes)) {
+    return OkStatus();
+  }
+  int64_t total_kb, available_kb;
+  if (ReadKeyedNumber("/proc/meminfo", "MemTotal", &total_kb) &&
+      ReadKeyedNumber("/proc/meminfo", "MemAvailable", &available_kb)) {
+    *usage_bytes = (total_kb - available_kb) * 1024;
+    *limit_bytes = total_kb * 1024;
+    return OkStatus();
+  }
+  return errors::Unavailable("The memory in use is not known on this host");
+}
+
+Status MemoryPressureEvictor::Create(
+    const Options& options, EvictingStoragePathSourceAdapter* adapter,
+    std::unique_ptr<MemoryPressureEvictor>* evictor) {
+  if (!(options.low_watermark > 0 &&
+        options.low_watermark <= options.high_watermark &&
+        options.high_watermark <= 1)) {
+    return errors::InvalidArgument(
+        "The watermarks of the memory pressure evictor must satisfy 0 < low "
+        "<= high <= 1; were ",
+        options.low_watermark, " and ", options.high_watermark);
+  }
+  evictor->reset(new MemoryPressureEvictor(options, adapter));
+  return OkStatus();
+}
+
+MemoryPressureEvictor::MemoryPressureEvictor(
+    const Options& options, EvictingStoragePathSourceAdapter* adapter)
+    : options_(options), adapter_(adapter) {
+  if (options_.check_interval_micros > 0) {
+    PeriodicFunction::Options pf_options;
+    pf_options.thread_name_prefix = "memory_pressure_evictor";
+    pf_options.env = options_.env;
+    check_thread_.reset(new PeriodicFunction(
+        [this]() { Check(); }, options_.check_interval_micros, pf_options));
+  }
+}
+
+void MemoryPressureEvictor::SetPriorities(std::map<string, int32> priorities) {
+  mutex_lock l(mu_);
+  priorities_ = std::move(priorities);
+}
+
+void MemoryPressureEvictor::RecordRequest(const string& model_name) {
+  {
+    tf_shared_lock l(mu_);
+    auto it = request_counts_.find(model_name);
+    if (it != request_counts_.end()) {
+      it->second->num_requests.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  mutex_lock l(mu_);
+  std::unique_ptr<RequestCount>& count = request_counts_[model_name];
+  if (count == nullptr) {
+    count.reset(new RequestCount);
+  }
+  count->num_requests.fetch_add(1, std::memory_order_relaxed);
+}
+
+Status MemoryPressureEvictor::CheckEvicted(const string& model_name) {
+  if (!adapter_->IsEvicted(model_name)) {
+    return OkStatus();
+  }
+  if (memory_usage_.load(std::memory_order_relaxed) >=
+      options_.low_watermark) {
+    return errors::ResourceExhausted(
+        "Model ", model_name,
+        " was unloaded under memory pressure, and there is not yet the memory "
+        "to reload it");
+  }
+  adapter_->Restore(model_name);
+  return errors::Unavailable("Model ", model_name,
+                             " was unloaded under memory pressure, and is "
+                             "being reloaded");
+}
+
+void MemoryPressureEvictor::Check() {
+  int64_t usage_bytes, limit_bytes;
+  const Status status = options_.read_memory_usage(&usage_bytes, &limit_bytes);
+  if (!status.ok() || limit_bytes <= 0) {
+    VLOG(1) << "Unable to read the memory in use: " << status;
+    return;
+  }
+  const double usage = static_cast<double>(usage_bytes) / limit_bytes;
+  memory_usage_.store(usage, std::memory_order_relaxed);
+
+  // The models are picked among the ones served, of which the adapter knows.
+  const std::vector<string> served_models = adapter_->GetServedServables();
+  string model_to_evict;
+  {
+    mutex_lock l(mu_);
+    std::map<string, int64_t> recent_requests;
+    for (auto& entry : request_counts_) {
+      RequestCount& count = *entry.second;
+      const int64_t num_requests =
+          count.num_requests.load(std::memory_order_relaxed);
+      recent_requests[entry.first] =
+          num_requests - count.num_requests_at_last_check;
+      count.num_requests_at_last_check = num_requests;
+    }
+    if (usage < options_.high_watermark) {
+      return;
+    }
+    std::pair<int32, int64_t> lowest = {std::numeric_limits<int32>::max(),
+                                        std::numeric_limits<int64_t>::max()};
+    for (const string& model : served_models) {
+      auto priority = priorities_.find(model);
+      const std::pair<int32, int64_t> key = {
+          priority == priorities_.end() ? 0 : priority->second,
+          recent_requests[model]};
+      if (key < lowest) {
+        lowest = key;
+        model_to_evict = model;
+      }
+    }
+  }
+  if (model_to_evict.empty()) {
+    LOG(WARNING) << "Memory in use is " << usage_bytes << " of "
+                 << limit_bytes << " bytes, but there is no model to evict";
+    return;
+  }
+  LOG(WARNING) << "Memory in use is " << usage_bytes << " of " << limit_bytes
+               << " bytes; unloading model " << model_to_evict;
+  memory_pressure_evictions->GetCell(model_to_evict)->IncrementBy(1);
+  adapter_->Evict(model_to_evict);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,125 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_CORE_MEMORY_PRESSURE_EVICTOR_H_
+#define TENSORFLOW_SERVING_CORE_MEMORY_PRESSURE_EVICTOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/kernels/batching_util/periodic_function.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/core/evicting_storage_path_source_adapter.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Reads the memory in use by the cgroup of the process, and its limit. Where
+// the cgroup has no limit, or on hosts without cgroups, reads the memory in
+// use on the host and its total memory.
+Status ReadMemoryUsage(int64_t* usage_bytes, int64_t* limit_bytes);
+
+// Unloads models when the memory in use nears its limit, before the OOM killer
+// steps in, and reloads them when they are requested again.
+//
+// Every 'check_interval_micros', if the memory in use is at least
+// 'high_watermark' of the limit, the evictor evicts (see
+// EvictingStoragePathSourceAdapter) one model: of those with the lowest load
+// priority, the one with the lowest request rate since the previous check. A
+// request to an evicted model (see CheckEvicted()) restores it once the memory
+// in use is below 'low_watermark' of the limit; until the model has loaded
+// again, its requests fail.
+//
+// This class is thread-safe.
+class MemoryPressureEvictor {
+ public:
+  struct Options {
+    // The shares of the memory limit at which models are evicted, and below
+    // which they are restored. 0 < low_watermark <= high_watermark <= 1.
+    double high_watermark = 0.9;
+    double low_watermark = 0.8;
+
+    // How often to check the memory in use. 0 to only check on Check().
+    int64_t check_interval_micros = 1000 * 1000;
+
+    // Reads the memory in use and its limit.
+    std::function<Status(int64_t* usage_bytes, int64_t* limit_bytes)>
+        read_memory_usage = ReadMemoryUsage;
+
+    Env* env = Env::Default();
+  };
+
+  // 'adapter' must outlive the evictor.
+  static Status Create(const Options& options,
+                       EvictingStoragePathSourceAdapter* adapter,
+                       std::unique_ptr<MemoryPressureEvictor>* evictor);
+
+  ~MemoryPressureEvictor() = default;
+
+  // Sets the load priorities of the models (see ModelConfig.load_priority).
+  // Models not in 'priorities' have priority 0.
+  void SetPriorities(std::map<string, int32> priorities)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Counts a request to 'model_name', towards its request rate.
+  void RecordRequest(const string& model_name) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns OK if 'model_name' isn't evicted. Else restores it, if the memory
+  // allows, and returns an Unavailable error, or returns a ResourceExhausted
+  // error if it doesn't.
+  Status CheckEvicted(const string& model_name) TF_LOCKS_EXCLUDED(mu_);
+
+  // Checks the memory in use and evicts a model if it is too high.
+  void Check() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  MemoryPressureEvictor(const Options& options,
+                        EvictingStoragePathSourceAdapter* adapter);
+
+  const Options options_;
+  EvictingStoragePathSourceAdapter* const adapter_;
+
+  // The share of the limit in use at the last check.
+  std::atomic<double> memory_usage_{0};
+
+  mutable mutex mu_;
+  std::map<string, int32> priorities_ TF_GUARDED_BY(mu_);
+  // The requests to each model, in all and as of the last check. The counts
+  // are added to under a shared lock.
+  struct RequestCount {
+    std::atomic<int64_t> num_requests{0};
+    int64_t num_requests_at_last_check = 0;
+  };
+  std::map<string, std::unique_ptr<RequestCount>> request_counts_
+      TF_GUARDED_BY(mu_);
+
+  // Declared last, to be stopped first.
+  std::unique_ptr<PeriodicFunction> check_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPressureEvictor);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_CORE_MEMORY_PRESSURE_EVICTOR_H_
@@ -0,0 +1,112 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/memory_pressure_evictor.h"
+
+#include <memory>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/core/target.h"
+#include "tensorflow_serving/core/test_util/mock_storage_path_target.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::NiceMock;
+using ::testing::UnorderedElementsAre;
+
+class MemoryPressureEvictorTest : public ::testing::Test {
+ protected:
+  MemoryPressureEvictorTest()
+      : target_(new NiceMock<test_util::MockStoragePathTarget>) {
+    ConnectSourceToTarget(&adapter_, target_.get());
+    for (const string& model : {"a", "b", "c"}) {
+      adapter_.GetAspiredVersionsCallback()(
+          model, {ServableData<StoragePath>({model, 1}, "/" + model + "/1")});
+    }
+    MemoryPressureEvictor::Options options;
+    options.check_interval_micros = 0;
+    options.read_memory_usage = [this](int64_t* usage_bytes,
+                                       int64_t* limit_bytes) {
+      *usage_bytes = usage_bytes_;
+      *limit_bytes = 100;
+      return OkStatus();
+    };
+    TF_CHECK_OK(MemoryPressureEvictor::Create(options, &adapter_, &evictor_));
+  }
+
+  EvictingStoragePathSourceAdapter adapter_;
+  std::unique_ptr<test_util::MockStoragePathTarget> target_;
+  int64_t usage_bytes_ = 0;
+  std::unique_ptr<MemoryPressureEvictor> evictor_;
+};
+
+TEST_F(MemoryPressureEvictorTest, EvictsLowPriorityAndIdleModels) {
+  evictor_->SetPriorities({{"a", 1}});
+  evictor_->RecordRequest("b");
+  evictor_->RecordRequest("b");
+  evictor_->RecordRequest("c");
+
+  // Below the high watermark, nothing is evicted.
+  usage_bytes_ = 85;
+  evictor_->Check();
+  EXPECT_THAT(adapter_.GetServedServables(),
+              UnorderedElementsAre("a", "b", "c"));
+
+  // Of the models of the lowest priority, the one with the fewest requests
+  // since the last check goes first.
+  evictor_->RecordRequest("b");
+  usage_bytes_ = 95;
+  evictor_->Check();
+  EXPECT_TRUE(adapter_.IsEvicted("c"));
+  evictor_->Check();
+  EXPECT_TRUE(adapter_.IsEvicted("b"));
+  evictor_->Check();
+  EXPECT_TRUE(adapter_.IsEvicted("a"));
+}
+
+TEST_F(MemoryPressureEvictorTest, RestoresRequestedModelsOnceMemoryAllows) {
+  usage_bytes_ = 95;
+  evictor_->SetPriorities({{"a", 1}, {"b", 1}});
+  evictor_->Check();
+  ASSERT_TRUE(adapter_.IsEvicted("c"));
+  TF_EXPECT_OK(evictor_->CheckEvicted("a"));
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED, evictor_->CheckEvicted("c").code());
+  EXPECT_TRUE(adapter_.IsEvicted("c"));
+
+  usage_bytes_ = 50;
+  evictor_->Check();
+  EXPECT_EQ(error::UNAVAILABLE, evictor_->CheckEvicted("c").code());
+  EXPECT_FALSE(adapter_.IsEvicted("c"));
+}
+
+TEST(MemoryPressureEvictorCreateTest, InvalidWatermarks) {
+  EvictingStoragePathSourceAdapter adapter;
+  std::unique_ptr<MemoryPressureEvictor> evictor;
+  MemoryPressureEvictor::Options options;
+  options.low_watermark = 0.95;
+  EXPECT_FALSE(MemoryPressureEvictor::Create(options, &adapter, &evictor).ok());
+  options.low_watermark = 0;
+  EXPECT_FALSE(MemoryPressureEvictor::Create(options, &adapter, &evictor).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,41 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/peer_version_fetcher.h"
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+Status ValidateRelativePath(const string& relative_path) {
+  if (relative_path.empty() || absl::StartsWith(relative_path, "/")) {
+    return errors::InvalidArgument("Not a relative path: '", relative_path,
+                                   "'");
+  }
+  for (absl::string_view component : absl::StrSplit(relative_path, '/')) {
+    if (component.empty() || component == "." || component == "..") {
+      return errors::InvalidArgument("Unsafe relative path: '", relative_path,
+                                     "'");
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
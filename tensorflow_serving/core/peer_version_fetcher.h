@@ -0,0 +1,71 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_CORE_PEER_VERSION_FETCHER_H_
+#define TENSORFLOW_SERVING_CORE_PEER_VERSION_FETCHER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A file, or directory, of a servable version in a local model cache.
+struct CachedVersionFile {
+  // The path of the file relative to the version directory.
+  string relative_path;
+  bool is_directory = false;
+  uint64_t size = 0;
+  uint32 crc32c = 0;
+};
+
+// Returns an InvalidArgument error unless 'relative_path' stays inside the
+// version directory it is relative to, i.e. is non-empty, is not absolute and
+// has no empty, "." or ".." components. The files listed by peers are checked
+// with it before anything is fetched, as peers are not trusted to list safe
+// paths.
+Status ValidateRelativePath(const string& relative_path);
+
+// Fetches servable versions from the local model caches of other servers
+// (peers) that have them cached, rather than from the storage the versions
+// originate from. See LocalCacheStoragePathSourceAdapter.
+//
+// Implementations must be thread-safe.
+class PeerVersionFetcher {
+ public:
+  virtual ~PeerVersionFetcher() = default;
+
+  // Finds the peers that have the version at 'storage_path' cached, and lists
+  // its files. Returns a NotFound error if no peer has it.
+  virtual Status FindVersion(const string& storage_path,
+                             std::vector<string>* peers,
+                             std::vector<CachedVersionFile>* files) = 0;
+
+  // Reads up to 'length' bytes, at 'offset', of the file at 'relative_path' in
+  // the version at 'storage_path', from 'peer'. Sets 'data' empty at the end of
+  // the file.
+  virtual Status ReadFile(const string& peer, const string& storage_path,
+                          const string& relative_path, uint64_t offset,
+                          uint64_t length, string* data) = 0;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_CORE_PEER_VERSION_FETCHER_H_
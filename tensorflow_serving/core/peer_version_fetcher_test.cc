@@ -0,0 +1,43 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/peer_version_fetcher.h"
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(ValidateRelativePathTest, AcceptsPathsInsideTheVersion) {
+  TF_EXPECT_OK(ValidateRelativePath("saved_model.pb"));
+  TF_EXPECT_OK(ValidateRelativePath("variables/variables.index"));
+  TF_EXPECT_OK(ValidateRelativePath("assets/..vocab"));
+}
+
+TEST(ValidateRelativePathTest, RejectsPathsOutsideTheVersion) {
+  for (const string& path :
+       {"", "/etc/passwd", "..", "../model", "variables/../../model",
+        "variables//variables", "variables/", "./saved_model.pb"}) {
+    EXPECT_TRUE(errors::IsInvalidArgument(ValidateRelativePath(path)))
+        << path;
+  }
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -15,14 +15,23 @@ limitations under the License.
 
 #include "tensorflow_serving/core/request_logger.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <random>
+#include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "google/protobuf/descriptor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
@@ -36,21 +45,114 @@ auto* request_log_count = monitoring::Counter<2>::New(
     "The total number of requests logged from the model server sliced "
     "down by model_name and status code.",
     "model_name", "status_code");
+
+auto* request_log_dropped_count = monitoring::Counter<2>::New(
+    "/tensorflow/serving/request_log_dropped_count",
+    "The total number of request logs dropped by asynchronous logging "
+    "because the log writers fell behind, sliced down by model_name and "
+    "reason.",
+    "model_name", "reason");
+
+constexpr int kDefaultMaxBatchSize = 64;
+
+// How long idle writer threads wait for logs before checking the queue
+// again, which bounds the delay of a log if a wakeup is missed.
+constexpr int64_t kWriterPollMicros = 100 * 1000;
+
+// Clears the fields of 'message' named in 'redacted_fields', truncates its
+// string and bytes values to 'max_string_bytes' if positive, and does the same
+// to its message fields.
+void RedactMessage(const std::unordered_set<string>& redacted_fields,
+                   const int64_t max_string_bytes,
+                   google::protobuf::Message* message) {
+  const google::protobuf::Reflection* reflection = message->GetReflection();
+  std::vector<const google::protobuf::FieldDescriptor*> fields;
+  reflection->ListFields(*message, &fields);
+  for (const google::protobuf::FieldDescriptor* field : fields) {
+    if (redacted_fields.count(field->full_name()) > 0) {
+      reflection->ClearField(message, field);
+      continue;
+    }
+    if (field->cpp_type() ==
+        google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE) {
+      if (field->is_repeated()) {
+        for (int i = 0; i < reflection->FieldSize(*message, field); ++i) {
+          RedactMessage(redacted_fields, max_string_bytes,
+                        reflection->MutableRepeatedMessage(message, field, i));
+        }
+      } else {
+        RedactMessage(redacted_fields, max_string_bytes,
+                      reflection->MutableMessage(message, field));
+      }
+    } else if (field->cpp_type() ==
+                   google::protobuf::FieldDescriptor::CPPTYPE_STRING &&
+               max_string_bytes > 0) {
+      if (field->is_repeated()) {
+        for (int i = 0; i < reflection->FieldSize(*message, field); ++i) {
+          const string& value =
+              reflection->GetRepeatedString(*message, field, i);
+          if (value.size() > static_cast<size_t>(max_string_bytes)) {
+            reflection->SetRepeatedString(message, field, i,
+                                          value.substr(0, max_string_bytes));
+          }
+        }
+      } else {
+        const string& value = reflection->GetString(*message, field);
+        if (value.size() > static_cast<size_t>(max_string_bytes)) {
+          reflection->SetString(message, field,
+                                value.substr(0, max_string_bytes));
+        }
+      }
+    }
+  }
+}
+
+void IncrementRequestLogCount(const string& model_name, const Status& status) {
+  request_log_count
+      ->GetCell(model_name,
+                error::Code_Name(static_cast<error::Code>(status.code())))
+      ->IncrementBy(1);
 }
 
+}  // namespace
+
 RequestLogger::RequestLogger(const LoggingConfig& logging_config,
                              const std::vector<string>& saved_model_tags,
                              std::unique_ptr<LogCollector> log_collector)
     : logging_config_(logging_config),
       saved_model_tags_(saved_model_tags),
-      log_collector_(std::move(log_collector)),
-      uniform_sampler_() {}
+      log_collector_(std::move(log_collector)) {
+  const AsyncLoggingConfig& async_config =
+      logging_config_.async_logging_config();
+  if (async_config.queue_capacity() <= 0) {
+    return;
+  }
+  queue_ =
+      std::make_unique<MpmcQueue<QueuedLog>>(async_config.queue_capacity());
+  const int num_threads = std::max(1, async_config.num_threads());
+  for (int i = 0; i < num_threads; ++i) {
+    writer_threads_.emplace_back(Env::Default()->StartThread(
+        {}, "request_log_writer", [this]() { WriteQueuedLogs(); }));
+  }
+}
 
-Status RequestLogger::Log(const google::protobuf::Message& request,
-                          const google::protobuf::Message& response,
-                          const LogMetadata& log_metadata) {
-  const double sampling_rate =
-      logging_config_.sampling_config().sampling_rate();
+RequestLogger::~RequestLogger() { StopWriters(); }
+
+void RequestLogger::StopWriters() {
+  if (queue_ == nullptr) {
+    return;
+  }
+  {
+    mutex_lock l(writers_mu_);
+    stopping_.store(true);
+    logs_queued_.notify_all();
+  }
+  // Joins the writer threads, once they've drained the queue.
+  writer_threads_.clear();
+}
+
+LogMetadata RequestLogger::CompleteLogMetadata(
+    const LogMetadata& log_metadata) const {
   LogMetadata log_metadata_with_config = log_metadata;
   *log_metadata_with_config.mutable_sampling_config() =
       logging_config_.sampling_config();
@@ -58,24 +160,225 @@ Status RequestLogger::Log(const google::protobuf::Message& request,
     *log_metadata_with_config.mutable_saved_model_tags() = {
         saved_model_tags_.begin(), saved_model_tags_.end()};
   }
-  if (uniform_sampler_.Sample(sampling_rate)) {
-    const auto status = [&]() {
-      std::unique_ptr<google::protobuf::Message> log;
-      TF_RETURN_IF_ERROR(
-          CreateLogMessage(request, response, log_metadata_with_config, &log));
-      return Log(*log);
-    }();
-    request_log_count
-        ->GetCell(log_metadata.model_spec().name(),
-                  error::Code_Name(static_cast<error::Code>(status.code())))
-        ->IncrementBy(1);
-    return status;
+  return log_metadata_with_config;
+}
+
+double RequestLogger::DrawSample(const LogMetadata& log_metadata) {
+  if (!log_metadata.sampling_key().empty()) {
+    // The top 53 bits of the fingerprint, as a double in [0, 1).
+    return (Fingerprint64(log_metadata.sampling_key()) >> 11) * 0x1.0p-53;
+  }
+  thread_local std::mt19937_64 generator(random::New64());
+  return std::uniform_real_distribution<double>(0, 1)(generator);
+}
+
+Status RequestLogger::Log(const google::protobuf::Message& request,
+                          const google::protobuf::Message& response,
+                          const LogMetadata& log_metadata) {
+  return LogWithSample(DrawSample(log_metadata), request, response,
+                       log_metadata);
+}
+
+Status RequestLogger::Log(
+    std::shared_ptr<const google::protobuf::Message> request,
+    std::shared_ptr<const google::protobuf::Message> response,
+    const LogMetadata& log_metadata) {
+  return LogWithSample(DrawSample(log_metadata), std::move(request),
+                       std::move(response), log_metadata);
+}
+
+Status RequestLogger::LogWithSample(const double sample,
+                                    const google::protobuf::Message& request,
+                                    const google::protobuf::Message& response,
+                                    const LogMetadata& log_metadata) {
+  if (sample >= logging_config_.sampling_config().sampling_rate()) {
+    return OkStatus();
   }
+  return LogSampled(request, response, log_metadata);
+}
+
+Status RequestLogger::LogWithSample(
+    const double sample,
+    std::shared_ptr<const google::protobuf::Message> request,
+    std::shared_ptr<const google::protobuf::Message> response,
+    const LogMetadata& log_metadata) {
+  if (sample >= logging_config_.sampling_config().sampling_rate()) {
+    return OkStatus();
+  }
+  return LogSampled(std::move(request), std::move(response), log_metadata);
+}
+
+Status RequestLogger::LogSampled(const google::protobuf::Message& request,
+                                 const google::protobuf::Message& response,
+                                 const LogMetadata& log_metadata) {
+  const string& model_name = log_metadata.model_spec().name();
+  std::unique_ptr<google::protobuf::Message> log;
+  Status status = CreateLogMessage(request, response,
+                                   CompleteLogMetadata(log_metadata), &log);
+  if (status.ok() && queue_ != nullptr) {
+    // Counted once written.
+    QueuedLog queued_log;
+    queued_log.log = std::move(log);
+    queued_log.model_name = model_name;
+    Enqueue(std::move(queued_log));
+    return OkStatus();
+  }
+  if (status.ok()) {
+    Redact(log.get());
+    status = log_collector_->CollectMessage(*log);
+  }
+  IncrementRequestLogCount(model_name, status);
+  return status;
+}
+
+Status RequestLogger::LogSampled(
+    std::shared_ptr<const google::protobuf::Message> request,
+    std::shared_ptr<const google::protobuf::Message> response,
+    const LogMetadata& log_metadata) {
+  if (queue_ == nullptr) {
+    return LogSampled(*request, *response, log_metadata);
+  }
+  QueuedLog queued_log;
+  queued_log.request = std::move(request);
+  queued_log.response = std::move(response);
+  queued_log.log_metadata = CompleteLogMetadata(log_metadata);
+  queued_log.model_name = log_metadata.model_spec().name();
+  Enqueue(std::move(queued_log));
+  return OkStatus();
+}
+
+Status RequestLogger::Log(const google::protobuf::Message& log,
+                          const string& model_name) {
+  const LogRedactionConfig& redaction_config =
+      logging_config_.redaction_config();
+  const bool redacts = redaction_config.redacted_fields_size() > 0 ||
+                       redaction_config.max_string_bytes() > 0;
+  if (queue_ == nullptr && !redacts) {
+    return log_collector_->CollectMessage(log);
+  }
+  std::unique_ptr<google::protobuf::Message> copy(log.New());
+  copy->CopyFrom(log);
+  if (queue_ == nullptr) {
+    Redact(copy.get());
+    return log_collector_->CollectMessage(*copy);
+  }
+  QueuedLog queued_log;
+  queued_log.log = std::move(copy);
+  queued_log.model_name = model_name;
+  Enqueue(std::move(queued_log));
   return OkStatus();
 }
 
-Status RequestLogger::Log(const google::protobuf::Message& log) {
-  return log_collector_->CollectMessage(log);
+void RequestLogger::Redact(google::protobuf::Message* log) const {
+  const LogRedactionConfig& redaction_config =
+      logging_config_.redaction_config();
+  if (redaction_config.redacted_fields_size() == 0 &&
+      redaction_config.max_string_bytes() <= 0) {
+    return;
+  }
+  const std::unordered_set<string> redacted_fields(
+      redaction_config.redacted_fields().begin(),
+      redaction_config.redacted_fields().end());
+  RedactMessage(redacted_fields, redaction_config.max_string_bytes(), log);
+}
+
+void RequestLogger::Enqueue(QueuedLog queued_log) {
+  const string& model_name = queued_log.model_name;
+  if (MemoryAccountingEnabled()) {
+    const int64_t bytes =
+        queued_log.log != nullptr
+            ? queued_log.log->SpaceUsedLong()
+            : queued_log.request->SpaceUsedLong() +
+                  queued_log.response->SpaceUsedLong();
+    queued_log.memory_charge = MemoryCharge(MemorySubsystem::kLogging, bytes);
+  }
+  if (logging_config_.async_logging_config().backpressure_policy() ==
+      AsyncLoggingConfig::SAMPLE_DOWN) {
+    const double occupancy =
+        static_cast<double>(queue_->ApproximateSize()) / queue_->capacity();
+    const double keep_rate = std::min(1.0, 2 * (1 - occupancy));
+    if (keep_rate < 1 &&
+        random::New64() >
+            keep_rate * std::numeric_limits<uint64_t>::max()) {
+      request_log_dropped_count->GetCell(model_name, "sampled_down")
+          ->IncrementBy(1);
+      return;
+    }
+  }
+  if (!queue_->TryPush(std::move(queued_log))) {
+    request_log_dropped_count->GetCell(model_name, "queue_full")
+        ->IncrementBy(1);
+    return;
+  }
+  if (num_waiting_writers_.load() > 0) {
+    mutex_lock l(writers_mu_);
+    logs_queued_.notify_one();
+  }
+}
+
+void RequestLogger::WriteQueuedLogs() {
+  const size_t max_batch_size =
+      logging_config_.async_logging_config().max_batch_size() > 0
+          ? logging_config_.async_logging_config().max_batch_size()
+          : kDefaultMaxBatchSize;
+  std::vector<QueuedLog> batch;
+  for (;;) {
+    batch.clear();
+    QueuedLog queued_log;
+    while (batch.size() < max_batch_size && queue_->TryPop(&queued_log)) {
+      batch.push_back(std::move(queued_log));
+    }
+    if (!batch.empty()) {
+      WriteBatch(&batch);
+      continue;
+    }
+    // The queue is drained, so exit if the logger is going away.
+    if (stopping_.load()) {
+      return;
+    }
+    mutex_lock l(writers_mu_);
+    num_waiting_writers_.fetch_add(1);
+    if (queue_->ApproximateSize() == 0 && !stopping_.load()) {
+      logs_queued_.wait_for(l, std::chrono::microseconds(kWriterPollMicros));
+    }
+    num_waiting_writers_.fetch_sub(1);
+  }
+}
+
+void RequestLogger::WriteBatch(std::vector<QueuedLog>* batch) {
+  std::vector<const google::protobuf::Message*> messages;
+  messages.reserve(batch->size());
+  std::vector<const QueuedLog*> written;
+  written.reserve(batch->size());
+  for (QueuedLog& queued_log : *batch) {
+    if (queued_log.log == nullptr) {
+      // The log of a shared request and response is created here, off the
+      // request thread.
+      const Status status =
+          CreateLogMessage(*queued_log.request, *queued_log.response,
+                           queued_log.log_metadata, &queued_log.log);
+      queued_log.request.reset();
+      queued_log.response.reset();
+      if (!status.ok()) {
+        IncrementRequestLogCount(queued_log.model_name, status);
+        continue;
+      }
+    }
+    Redact(queued_log.log.get());
+    messages.push_back(queued_log.log.get());
+    written.push_back(&queued_log);
+  }
+  if (messages.empty()) {
+    return;
+  }
+  const Status status = log_collector_->CollectMessages(messages);
+  if (!status.ok()) {
+    LOG_EVERY_N_SEC(WARNING, 60)
+        << "Failed to write a batch of request logs: " << status;
+  }
+  for (const QueuedLog* queued_log : written) {
+    IncrementRequestLogCount(queued_log->model_name, status);
+  }
 }
 
 }  // namespace serving
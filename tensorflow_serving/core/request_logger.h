@@ -16,15 +16,20 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_CORE_REQUEST_LOGGER_H_
 #define TENSORFLOW_SERVING_CORE_REQUEST_LOGGER_H_
 
-#include <random>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include "google/protobuf/message.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow_serving/apis/logging.pb.h"
 #include "tensorflow_serving/config/logging_config.pb.h"
 #include "tensorflow_serving/core/log_collector.h"
 #include "tensorflow_serving/core/stream_logger.h"
+#include "tensorflow_serving/util/memory_accounting.h"
+#include "tensorflow_serving/util/mpmc_queue.h"
 
 namespace tensorflow {
 namespace serving {
@@ -33,19 +38,55 @@ namespace serving {
 // is handled by the log-collector. We sample requests based on the config.
 // All subclasses must only implement a factory method that returns a
 // shared_ptr.
+//
+// With an AsyncLoggingConfig, logs are created on the request threads but
+// written to the log-collector by background threads, in batches, through a
+// bounded lock-free queue. Logs that don't fit (or are sampled down under
+// backpressure) are dropped and counted. Requests and responses that are
+// passed in shared, through the second Log() overload, aren't copied on the
+// request thread at all: the background threads create their logs.
+//
+// Logs are redacted per the LogRedactionConfig before they're written.
 class RequestLogger : public std::enable_shared_from_this<RequestLogger> {
  public:
   RequestLogger(const LoggingConfig& logging_config,
                 const std::vector<string>& saved_model_tags,
                 std::unique_ptr<LogCollector> log_collector);
 
-  virtual ~RequestLogger() = default;
+  // Writes the queued logs before returning.
+  virtual ~RequestLogger();
 
   // Writes the log for the particular request, response and metadata, if we
   // decide to sample it.
   Status Log(const google::protobuf::Message& request, const google::protobuf::Message& response,
              const LogMetadata& log_metadata);
 
+  // As above, but when logging asynchronously, holds on to 'request' and
+  // 'response' and creates the log on the background threads, so that the
+  // request thread doesn't copy them. The messages must not be modified
+  // afterwards.
+  Status Log(std::shared_ptr<const google::protobuf::Message> request,
+             std::shared_ptr<const google::protobuf::Message> response,
+             const LogMetadata& log_metadata);
+
+  // Like Log(), but for requests sampled ahead with 'sample', a draw from
+  // DrawSample(): they're logged if 'sample' is below the sampling rate. A
+  // caller fronting several loggers can draw once per request, and skip all
+  // of them without a lookup when the draw is above all their rates.
+  Status LogWithSample(double sample, const google::protobuf::Message& request,
+                       const google::protobuf::Message& response,
+                       const LogMetadata& log_metadata);
+  Status LogWithSample(
+      double sample, std::shared_ptr<const google::protobuf::Message> request,
+      std::shared_ptr<const google::protobuf::Message> response,
+      const LogMetadata& log_metadata);
+
+  // Draws the sample in [0, 1) for a request with 'log_metadata'. If it has a
+  // sampling_key, the sample is a hash of the key, so all the requests and
+  // streams with the key are logged alike, by each logger, and across runs.
+  // Otherwise it's uniformly random, from a generator local to the thread.
+  static double DrawSample(const LogMetadata& log_metadata);
+
   // Starts logging a stream through returning a StreamLogger through
   // `get_stream_logger_fn` and registers a log callback. Returns NULL if the
   // stream should not be logged.
@@ -58,6 +99,13 @@ class RequestLogger : public std::enable_shared_from_this<RequestLogger> {
 
   const LoggingConfig& logging_config() const { return logging_config_; }
 
+ protected:
+  // Writes the queued logs, and stops the writer threads. Subclasses whose
+  // logs may be created on the writer threads (see the shared Log()) must
+  // call it in their destructor, before their CreateLogMessage() stops
+  // working.
+  void StopWriters();
+
  private:
   // Creates the log message given the request, response and metadata.
   // Implementations override it to create the particular message that they want
@@ -70,28 +118,61 @@ class RequestLogger : public std::enable_shared_from_this<RequestLogger> {
   // Implementations can fill up additional information to LogMetadata.
   virtual LogMetadata FillLogMetadata(const LogMetadata& lm_in) = 0;
 
-  // Writes the log.
-  Status Log(const google::protobuf::Message& log);
+  // Writes the log, of the model named 'model_name'.
+  Status Log(const google::protobuf::Message& log, const string& model_name);
+
+  // Logs a request that was sampled.
+  Status LogSampled(const google::protobuf::Message& request,
+                    const google::protobuf::Message& response,
+                    const LogMetadata& log_metadata);
+  Status LogSampled(std::shared_ptr<const google::protobuf::Message> request,
+                    std::shared_ptr<const google::protobuf::Message> response,
+                    const LogMetadata& log_metadata);
+
+  // Returns 'log_metadata' with the sampling config and model tags of the
+  // logger.
+  LogMetadata CompleteLogMetadata(const LogMetadata& log_metadata) const;
+
+  // Clears and truncates the fields of 'log' per the redaction config.
+  void Redact(google::protobuf::Message* log) const;
+
+  // A log waiting in the queue to be written. Either the log itself, or the
+  // request and response to create it from with 'log_metadata'.
+  struct QueuedLog {
+    std::unique_ptr<google::protobuf::Message> log;
+    std::shared_ptr<const google::protobuf::Message> request;
+    std::shared_ptr<const google::protobuf::Message> response;
+    LogMetadata log_metadata;
+    string model_name;
+    // Charges the memory of the log to the logging subsystem while queued.
+    MemoryCharge memory_charge;
+  };
 
-  // A sampler which samples uniformly at random.
-  class UniformSampler {
-   public:
-    UniformSampler() : rd_(), gen_(rd_()), dist_(0, 1) {}
+  // Queues the log to be written by the writer threads, or drops it under
+  // the backpressure policy.
+  void Enqueue(QueuedLog queued_log);
 
-    // Returns true if the sampler decides to sample it with a probability
-    // 'rate'.
-    bool Sample(const double rate) { return dist_(gen_) < rate; }
+  // The loop of the writer threads.
+  void WriteQueuedLogs();
 
-   private:
-    std::random_device rd_;
-    std::mt19937 gen_;
-    std::uniform_real_distribution<double> dist_;
-  };
+  // Writes a batch of queued logs to the log-collector.
+  void WriteBatch(std::vector<QueuedLog>* batch);
 
   const LoggingConfig logging_config_;
   const std::vector<string> saved_model_tags_;
   std::unique_ptr<LogCollector> log_collector_;
-  UniformSampler uniform_sampler_;
+
+  // The queue of logs to write, if logging asynchronously.
+  std::unique_ptr<MpmcQueue<QueuedLog>> queue_;
+  // Set on destruction, for the writer threads to exit once the queue is
+  // drained.
+  std::atomic<bool> stopping_{false};
+  // The number of writer threads waiting for logs, so that requests only
+  // take the mutex to wake them up if there are any.
+  std::atomic<int> num_waiting_writers_{0};
+  mutex writers_mu_;
+  condition_variable logs_queued_;
+  std::vector<std::unique_ptr<Thread>> writer_threads_;
 };
 
 /**************************Implementation Detail******************************/
@@ -102,8 +183,8 @@ void RequestLogger::MaybeStartLoggingStream(
   // Sampling happens at the beginning of logging to avoid logging overhead.
   // if request logger goes away during a stream which could happen due to
   // loggin config update, the stream won't be logged.
-  if (!uniform_sampler_.Sample(
-          logging_config_.sampling_config().sampling_rate())) {
+  if (DrawSample(log_metadata) >=
+      logging_config_.sampling_config().sampling_rate()) {
     return;
   }
 
@@ -113,12 +194,14 @@ void RequestLogger::MaybeStartLoggingStream(
   LogMetadata lm_out = FillLogMetadata(log_metadata);
   std::weak_ptr<RequestLogger> logger_ref(shared_from_this());
   stream_logger->AddLogCallback(
-      lm_out, [logger_ref = std::move(logger_ref)](const google::protobuf::Message& log) {
+      lm_out, [logger_ref = std::move(logger_ref),
+               model_name = lm_out.model_spec().name()](
+                  const google::protobuf::Message& log) {
         // The callback refers back to the request logger. If the
         // request logger goes away after creation but before stream
         // ends, we simply skip this sink.
         if (auto logger = logger_ref.lock(); logger != nullptr) {
-          TF_RETURN_IF_ERROR(logger->Log(log));
+          TF_RETURN_IF_ERROR(logger->Log(log, model_name));
         }
         return OkStatus();
       });
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow_serving/core/request_logger.h"
 
+#include <atomic>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
@@ -26,8 +28,10 @@ limitations under the License.
 #include "tensorflow/cc/saved_model/tag_constants.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow_serving/apis/logging.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
 #include "tensorflow_serving/apis/predict.pb.h"
@@ -132,6 +136,164 @@ TEST_F(RequestLoggerTest, ErroringCollectMessage) {
   EXPECT_THAT(error_status.message(), HasSubstr("Error"));
 }
 
+// Returns a logger that writes its logs asynchronously to `log_collector`
+// through a queue that holds `queue_capacity` logs.
+std::unique_ptr<NiceMock<MockRequestLogger>> CreateAsyncRequestLogger(
+    int queue_capacity, NiceMock<MockLogCollector>* log_collector) {
+  LoggingConfig logging_config;
+  logging_config.mutable_sampling_config()->set_sampling_rate(1.0);
+  logging_config.mutable_async_logging_config()->set_queue_capacity(
+      queue_capacity);
+  auto request_logger = std::make_unique<NiceMock<MockRequestLogger>>(
+      logging_config, std::vector<string>(), log_collector);
+  ON_CALL(*request_logger, CreateLogMessage(_, _, _, _))
+      .WillByDefault(Invoke([](const google::protobuf::Message& request,
+                               const google::protobuf::Message& response,
+                               const LogMetadata& log_metadata,
+                               std::unique_ptr<google::protobuf::Message>* log) {
+        *log =
+            std::unique_ptr<google::protobuf::Any>(new google::protobuf::Any());
+        return OkStatus();
+      }));
+  return request_logger;
+}
+
+TEST(AsyncRequestLoggerTest, WritesQueuedLogs) {
+  auto* log_collector = new NiceMock<MockLogCollector>();
+  auto request_logger = CreateAsyncRequestLogger(16, log_collector);
+  std::atomic<int> num_collected{0};
+  ON_CALL(*log_collector, CollectMessage(_))
+      .WillByDefault(Invoke([&](const google::protobuf::Message& message) {
+        ++num_collected;
+        return OkStatus();
+      }));
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(request_logger->Log(PredictRequest(), PredictResponse(),
+                                     LogMetadata()));
+  }
+  // The logger writes all the queued logs before it goes away.
+  request_logger.reset();
+  EXPECT_EQ(10, num_collected.load());
+}
+
+TEST(AsyncRequestLoggerTest, DropsLogsWhenQueueIsFull) {
+  auto* log_collector = new NiceMock<MockLogCollector>();
+  auto request_logger = CreateAsyncRequestLogger(2, log_collector);
+  Notification collecting, unblock;
+  std::atomic<int> num_collected{0};
+  ON_CALL(*log_collector, CollectMessage(_))
+      .WillByDefault(Invoke([&](const google::protobuf::Message& message) {
+        if (num_collected++ == 0) {
+          collecting.Notify();
+          unblock.WaitForNotification();
+        }
+        return OkStatus();
+      }));
+  TF_ASSERT_OK(
+      request_logger->Log(PredictRequest(), PredictResponse(), LogMetadata()));
+  // While the writer is stuck on the first log, only two more fit, and the
+  // rest are dropped without failing the requests.
+  collecting.WaitForNotification();
+  for (int i = 0; i < 9; ++i) {
+    TF_ASSERT_OK(request_logger->Log(PredictRequest(), PredictResponse(),
+                                     LogMetadata()));
+  }
+  unblock.Notify();
+  request_logger.reset();
+  EXPECT_EQ(3, num_collected.load());
+}
+
+TEST(AsyncRequestLoggerTest, CreatesLogsOfSharedRequestsOffRequestThread) {
+  auto* log_collector = new NiceMock<MockLogCollector>();
+  auto request_logger = CreateAsyncRequestLogger(16, log_collector);
+  std::atomic<int> num_collected{0};
+  ON_CALL(*log_collector, CollectMessage(_))
+      .WillByDefault(Invoke([&](const google::protobuf::Message& message) {
+        ++num_collected;
+        return OkStatus();
+      }));
+  auto request = std::make_shared<PredictRequest>();
+  request->mutable_model_spec()->set_name("model");
+  const PredictRequest* const request_ptr = request.get();
+  const std::thread::id request_thread = std::this_thread::get_id();
+  EXPECT_CALL(*request_logger, CreateLogMessage(_, _, _, _))
+      .WillOnce(Invoke([&](const google::protobuf::Message& actual_request,
+                           const google::protobuf::Message& actual_response,
+                           const LogMetadata& actual_log_metadata,
+                           std::unique_ptr<google::protobuf::Message>* log) {
+        // The request logged is the caller's, not a copy.
+        EXPECT_EQ(request_ptr, &actual_request);
+        EXPECT_NE(request_thread, std::this_thread::get_id());
+        *log =
+            std::unique_ptr<google::protobuf::Any>(new google::protobuf::Any());
+        return OkStatus();
+      }));
+  TF_ASSERT_OK(request_logger->Log(std::move(request),
+                                   std::make_shared<PredictResponse>(),
+                                   LogMetadata()));
+  request_logger.reset();
+  EXPECT_EQ(1, num_collected.load());
+}
+
+TEST(RequestLoggerRedactionTest, ClearsAndTruncatesFields) {
+  LoggingConfig logging_config;
+  logging_config.mutable_sampling_config()->set_sampling_rate(1.0);
+  logging_config.mutable_redaction_config()->add_redacted_fields(
+      "tensorflow.serving.ModelSpec.signature_name");
+  logging_config.mutable_redaction_config()->set_max_string_bytes(4);
+  auto* log_collector = new NiceMock<MockLogCollector>();
+  auto request_logger = std::make_unique<NiceMock<MockRequestLogger>>(
+      logging_config, std::vector<string>(), log_collector);
+
+  PredictRequest request;
+  request.mutable_model_spec()->set_name("model");
+  request.mutable_model_spec()->set_signature_name("serving_default");
+  (*request.mutable_inputs())["x"].set_tensor_content(string(100, 'a'));
+  EXPECT_CALL(*request_logger, CreateLogMessage(_, _, _, _))
+      .WillOnce(Invoke([&](const google::protobuf::Message& actual_request,
+                           const google::protobuf::Message& actual_response,
+                           const LogMetadata& actual_log_metadata,
+                           std::unique_ptr<google::protobuf::Message>* log) {
+        auto log_request = std::make_unique<PredictRequest>();
+        log_request->CopyFrom(actual_request);
+        *log = std::move(log_request);
+        return OkStatus();
+      }));
+  PredictRequest written;
+  EXPECT_CALL(*log_collector, CollectMessage(_))
+      .WillOnce(Invoke([&](const google::protobuf::Message& message) {
+        written.CopyFrom(message);
+        return OkStatus();
+      }));
+  TF_ASSERT_OK(request_logger->Log(request, PredictResponse(), LogMetadata()));
+  EXPECT_THAT(written, test_util::EqualsProto(R"pb(
+                model_spec { name: "mode" }
+                inputs {
+                  key: "x"
+                  value { tensor_content: "aaaa" }
+                }
+              )pb"));
+}
+
+TEST(RequestLoggerSamplingTest, SamplesByKey) {
+  LogMetadata log_metadata;
+  int num_sampled = 0;
+  for (int i = 0; i < 1000; ++i) {
+    log_metadata.set_sampling_key(strings::StrCat("session-", i));
+    const double sample = RequestLogger::DrawSample(log_metadata);
+    ASSERT_GE(sample, 0);
+    ASSERT_LT(sample, 1);
+    // The same key always draws the same sample.
+    EXPECT_EQ(sample, RequestLogger::DrawSample(log_metadata));
+    if (sample < 0.5) {
+      ++num_sampled;
+    }
+  }
+  // And the keys are still sampled at the rate.
+  EXPECT_GT(num_sampled, 400);
+  EXPECT_LT(num_sampled, 600);
+}
+
 TEST_F(RequestLoggerTest, LoggingStreamSucceeds) {
   auto logger = std::make_unique<MockPredictionStreamLogger>();
 
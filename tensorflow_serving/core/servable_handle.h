@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <type_traits>
 
@@ -39,6 +40,9 @@ class UntypedServableHandle {
   virtual const ServableId& id() const = 0;
 
   virtual AnyPtr servable() = 0;
+
+  /// The load generation of the servable (see LoaderHarness), or 0 if unknown.
+  virtual uint64_t load_generation() const { return 0; }
 };
 
 /// A smart pointer to the underlying servable object T retrieved from the
@@ -83,6 +87,12 @@ class ServableHandle {
 
   const ServableId& id() const { return untyped_handle_->id(); }
 
+  /// Distinct for every load of a servable, even of the same id, or 0 if
+  /// unknown. See LoaderHarness::load_generation().
+  uint64_t load_generation() const {
+    return untyped_handle_ == nullptr ? 0 : untyped_handle_->load_generation();
+  }
+
   // Smart pointer operations.
 
   T& operator*() const { return *get(); }
@@ -115,16 +125,23 @@ class SharedPtrHandle final : public UntypedServableHandle {
  public:
   ~SharedPtrHandle() override = default;
 
-  explicit SharedPtrHandle(const ServableId& id, std::shared_ptr<Loader> loader)
-      : id_(id), loader_(std::move(loader)) {}
+  explicit SharedPtrHandle(const ServableId& id,
+                           std::shared_ptr<Loader> loader,
+                           uint64_t load_generation = 0)
+      : id_(id),
+        loader_(std::move(loader)),
+        load_generation_(load_generation) {}
 
   AnyPtr servable() override { return loader_->servable(); }
 
   const ServableId& id() const override { return id_; }
 
+  uint64_t load_generation() const override { return load_generation_; }
+
  private:
   const ServableId id_;
   std::shared_ptr<Loader> loader_;
+  const uint64_t load_generation_;
 };
 
 // We compare handles using both the servable pointer and the id. So if you
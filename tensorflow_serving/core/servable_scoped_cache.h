@@ -0,0 +1,135 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_CORE_SERVABLE_SCOPED_CACHE_H_
+#define TENSORFLOW_SERVING_CORE_SERVABLE_SCOPED_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_serving/core/servable_handle.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Caches values derived from loaded servables, e.g. the plans of their
+// signatures, which may point into the servables.
+//
+// The values are keyed by the load generation of their servable (see
+// ServableHandle::load_generation()) and a key within the servable. Every load
+// of a servable has its own generation, so the values of a servable are never
+// returned for a later load of it, even of the same id at the same address;
+// they are evicted, least recently used first, once the cache is full.
+// Servables of unknown load generation (0) are not cached.
+//
+// This class is thread-safe.
+template <typename Value>
+class ServableScopedCache {
+ public:
+  // Creates the value of a key.
+  using Creator = std::function<Status(Value* value)>;
+
+  // Holds up to 'max_entries' values.
+  explicit ServableScopedCache(size_t max_entries = 1024)
+      : max_entries_(max_entries) {}
+
+  // Sets 'value' to the value of 'key' of the servable of 'handle', which is
+  // created with 'create' unless cached. Values that fail to be created are
+  // not cached.
+  template <typename T>
+  Status Get(const ServableHandle<T>& handle, const string& key,
+             const Creator& create, std::shared_ptr<const Value>* value)
+      TF_LOCKS_EXCLUDED(mu_) {
+    return Get(handle.load_generation(), key, create, value);
+  }
+
+  // Like above, for the servable of 'load_generation'.
+  Status Get(uint64_t load_generation, const string& key,
+             const Creator& create, std::shared_ptr<const Value>* value)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of cached values.
+  size_t size() const TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return lru_.size();
+  }
+
+ private:
+  using Key = std::pair<uint64_t, string>;
+  using Entry = std::pair<Key, std::shared_ptr<const Value>>;
+
+  const size_t max_entries_;
+
+  mutable mutex mu_;
+  // The entries, most recently used first.
+  std::list<Entry> lru_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<Key, typename std::list<Entry>::iterator> entries_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ServableScopedCache);
+};
+
+// Implementation details follow. API users need not read.
+
+template <typename Value>
+Status ServableScopedCache<Value>::Get(uint64_t load_generation,
+                                       const string& key,
+                                       const Creator& create,
+                                       std::shared_ptr<const Value>* value) {
+  Key entry_key(load_generation, key);
+  if (load_generation != 0) {
+    mutex_lock l(mu_);
+    auto entry = entries_.find(entry_key);
+    if (entry != entries_.end()) {
+      lru_.splice(lru_.begin(), lru_, entry->second);
+      *value = entry->second->second;
+      return Status();
+    }
+  }
+  auto new_value = std::make_shared<Value>();
+  TF_RETURN_IF_ERROR(create(new_value.get()));
+  *value = new_value;
+  if (load_generation == 0 || max_entries_ == 0) {
+    return Status();
+  }
+  mutex_lock l(mu_);
+  // Another request may have created the value meanwhile.
+  if (entries_.contains(entry_key)) {
+    return Status();
+  }
+  if (lru_.size() >= max_entries_) {
+    entries_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+  lru_.emplace_front(entry_key, std::move(new_value));
+  entries_.emplace(std::move(entry_key), lru_.begin());
+  return Status();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_CORE_SERVABLE_SCOPED_CACHE_H_
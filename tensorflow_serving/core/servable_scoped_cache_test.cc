@@ -0,0 +1,87 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/core/servable_scoped_cache.h"
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class ServableScopedCacheTest : public ::testing::Test {
+ protected:
+  // Gets the value of 'key' of the servable of 'load_generation', which is
+  // created as "<key>@<load_generation>#<number of creations>".
+  string Get(uint64_t load_generation, const string& key) {
+    std::shared_ptr<const string> value;
+    TF_CHECK_OK(cache_.Get(
+        load_generation, key,
+        [&](string* value) {
+          *value = absl::StrCat(key, "@", load_generation, "#", ++creations_);
+          return OkStatus();
+        },
+        &value));
+    return *value;
+  }
+
+  ServableScopedCache<string> cache_{/*max_entries=*/2};
+  int creations_ = 0;
+};
+
+TEST_F(ServableScopedCacheTest, CachesValuesPerLoadGeneration) {
+  EXPECT_EQ("a@1#1", Get(1, "a"));
+  EXPECT_EQ("a@1#1", Get(1, "a"));
+  // A reload of the servable, e.g. under the same id, has a new generation.
+  EXPECT_EQ("a@2#2", Get(2, "a"));
+  EXPECT_EQ("a@2#2", Get(2, "a"));
+  EXPECT_EQ(2, cache_.size());
+}
+
+TEST_F(ServableScopedCacheTest, DoesNotCacheUnknownLoadGenerations) {
+  EXPECT_EQ("a@0#1", Get(0, "a"));
+  EXPECT_EQ("a@0#2", Get(0, "a"));
+  EXPECT_EQ(0, cache_.size());
+}
+
+TEST_F(ServableScopedCacheTest, EvictsLeastRecentlyUsedValues) {
+  EXPECT_EQ("a@1#1", Get(1, "a"));
+  EXPECT_EQ("b@1#2", Get(1, "b"));
+  EXPECT_EQ("a@1#1", Get(1, "a"));
+  // Evicts "b", which was used less recently than "a".
+  EXPECT_EQ("c@1#3", Get(1, "c"));
+  EXPECT_EQ(2, cache_.size());
+  EXPECT_EQ("a@1#1", Get(1, "a"));
+  EXPECT_EQ("b@1#4", Get(1, "b"));
+}
+
+TEST_F(ServableScopedCacheTest, DoesNotCacheFailures) {
+  std::shared_ptr<const string> value;
+  EXPECT_TRUE(errors::IsInvalidArgument(cache_.Get(
+      1, "a", [](string*) { return errors::InvalidArgument("Invalid"); },
+      &value)));
+  EXPECT_EQ(0, cache_.size());
+  EXPECT_EQ("a@1#1", Get(1, "a"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -15,7 +15,9 @@ limitations under the License.
 
 #include "tensorflow_serving/core/servable_state_monitor.h"
 
+#include <algorithm>
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -166,6 +168,50 @@ ServableStateMonitor::VersionMap ServableStateMonitor::GetVersionStates(
   return it->second;
 }
 
+std::shared_ptr<const ServableStateMonitor::VersionMap>
+ServableStateMonitor::GetVersionStatesSnapshot(
+    const string& servable_name) const {
+  const std::shared_ptr<const SnapshotMap> snapshots =
+      std::atomic_load(&snapshots_);
+  if (snapshots == nullptr) {
+    return nullptr;
+  }
+  auto it = snapshots->find(servable_name);
+  if (it == snapshots->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void ServableStateMonitor::PublishSnapshot(const ServableName& servable_name) {
+  const std::shared_ptr<const SnapshotMap> snapshots =
+      std::atomic_load(&snapshots_);
+  auto new_snapshots = snapshots == nullptr
+                           ? std::make_shared<SnapshotMap>()
+                           : std::make_shared<SnapshotMap>(*snapshots);
+  auto it = states_.find(servable_name);
+  if (it == states_.end() || it->second.empty()) {
+    new_snapshots->erase(servable_name);
+  } else {
+    (*new_snapshots)[servable_name] =
+        std::make_shared<const VersionMap>(it->second);
+  }
+  std::shared_ptr<const SnapshotMap> published = std::move(new_snapshots);
+  std::atomic_store(&snapshots_, std::move(published));
+}
+
+void ServableStateMonitor::PublishAllSnapshots() {
+  auto new_snapshots = std::make_shared<SnapshotMap>();
+  for (const auto& state : states_) {
+    if (!state.second.empty()) {
+      (*new_snapshots)[state.first] =
+          std::make_shared<const VersionMap>(state.second);
+    }
+  }
+  std::shared_ptr<const SnapshotMap> published = std::move(new_snapshots);
+  std::atomic_store(&snapshots_, std::move(published));
+}
+
 ServableStateMonitor::ServableMap ServableStateMonitor::GetAllServableStates()
     const {
   mutex_lock l(mu_);
@@ -179,8 +225,11 @@ ServableStateMonitor::ServableMap ServableStateMonitor::GetLiveServableStates()
 }
 
 void ServableStateMonitor::ForgetUnloadedServableStates() {
-  mutex_lock l(mu_);
+  std::vector<StateReachedNotification> notifications;
+  auto cleanup = gtl::MakeCleanup(
+      [&]() { SendStateReachedNotifications(notifications); });
 
+  mutex_lock l(mu_);
   for (auto& state : states_) {
     std::vector<Version> versions_to_forget;
     auto& version_map = state.second;
@@ -194,6 +243,18 @@ void ServableStateMonitor::ForgetUnloadedServableStates() {
       version_map.erase(version);
     }
   }
+  PublishAllSnapshots();
+
+  // Forgetting states may change which servables have reached their states, so
+  // re-evaluate all pending notification requests.
+  std::vector<int64_t> request_ids;
+  for (auto& id_and_request : servable_state_notification_requests_) {
+    EvaluateNotificationRequest(&id_and_request.second);
+    request_ids.push_back(id_and_request.first);
+  }
+  for (const int64_t request_id : request_ids) {
+    MaybeTakeStateReachedNotification(request_id, &notifications);
+  }
 }
 
 ServableStateMonitor::ServableSet
@@ -216,22 +277,44 @@ ServableStateMonitor::GetAvailableServableStates() const {
 
 ServableStateMonitor::BoundedLog ServableStateMonitor::GetBoundedLog() const {
   mutex_lock l(mu_);
-  return log_;
+  // Until the ring buffer is full, 'log_next_' is 0.
+  BoundedLog log(log_.begin() + log_next_, log_.end());
+  log.insert(log.end(), log_.begin(), log_.begin() + log_next_);
+  return log;
 }
 
 void ServableStateMonitor::NotifyWhenServablesReachState(
     const std::vector<ServableRequest>& servables,
     const ServableState::ManagerState goal_state,
     const ServableStateNotifierFn& notifier_fn) {
+  std::vector<StateReachedNotification> notifications;
+  auto cleanup = gtl::MakeCleanup(
+      [&]() { SendStateReachedNotifications(notifications); });
+
   mutex_lock l(mu_);
-  servable_state_notification_requests_.push_back(
-      {servables, goal_state, notifier_fn});
-  MaybeSendStateReachedNotifications();
+  const int64_t request_id = next_notification_request_id_++;
+  ServableStateNotificationRequest& request =
+      servable_state_notification_requests_[request_id];
+  request.servables = servables;
+  request.goal_state = goal_state;
+  request.notifier_fn = notifier_fn;
+  EvaluateNotificationRequest(&request);
+  for (int i = 0; i < servables.size(); ++i) {
+    notification_request_index_[servables[i].name].emplace_back(request_id, i);
+  }
+  MaybeTakeStateReachedNotification(request_id, &notifications);
+}
+
+int64_t ServableStateMonitor::Notify(const NotifyFn& notify_fn) {
+  mutex_lock l(notify_mu_);
+  const int64_t notify_id = next_notify_id_++;
+  notify_fns_[notify_id] = notify_fn;
+  return notify_id;
 }
 
-void ServableStateMonitor::Notify(const NotifyFn& notify_fn) {
+void ServableStateMonitor::StopNotifying(const int64_t notify_id) {
   mutex_lock l(notify_mu_);
-  notify_fns_.push_back(notify_fn);
+  notify_fns_.erase(notify_id);
 }
 
 bool ServableStateMonitor::WaitUntilServablesReachState(
@@ -262,8 +345,13 @@ void ServableStateMonitor::HandleEvent(
     const EventBus<ServableState>::EventAndTime& event_and_time) {
   PreHandleEvent(event_and_time);
 
-  auto cleanup =
-      gtl::MakeCleanup([&]() { SendNotifications(event_and_time.event); });
+  std::vector<StateReachedNotification> notifications;
+  // Subscribers see the event before waiters on it are woken up, so a waiter
+  // finds every subscriber notified of the states it waited for.
+  auto cleanup = gtl::MakeCleanup([&]() {
+    SendNotifications(event_and_time.event);
+    SendStateReachedNotifications(notifications);
+  });
 
   mutex_lock l(mu_);
   const ServableStateAndTime state_and_time = {
@@ -271,15 +359,18 @@ void ServableStateMonitor::HandleEvent(
   states_[state_and_time.state.id.name][state_and_time.state.id.version] =
       state_and_time;
   UpdateLiveStates(state_and_time, &live_states_);
-  MaybeSendStateReachedNotifications();
+  PublishSnapshot(state_and_time.state.id.name);
+  TakeStateReachedNotifications(state_and_time.state.id.name, &notifications);
 
   if (options_.max_count_log_events == 0) {
     return;
   }
-  while (log_.size() >= options_.max_count_log_events) {
-    log_.pop_front();
+  if (log_.size() < options_.max_count_log_events) {
+    log_.push_back(state_and_time);
+  } else {
+    log_[log_next_] = state_and_time;
+    log_next_ = (log_next_ + 1) % log_.size();
   }
-  log_.emplace_back(state_and_time.state, state_and_time.event_time_micros);
 }
 
 absl::optional<
@@ -321,29 +412,118 @@ ServableStateMonitor::ShouldSendStateReachedNotification(
   return {{reached_goal_state, states_reached}};
 }
 
-void ServableStateMonitor::MaybeSendStateReachedNotifications() {
-  for (auto iter = servable_state_notification_requests_.begin();
-       iter != servable_state_notification_requests_.end();) {
-    const ServableStateNotificationRequest& notification_request = *iter;
-    const absl::optional<
-        std::pair<bool, std::map<ServableId, ServableState::ManagerState>>>
-        opt_state_and_states_reached =
-            ShouldSendStateReachedNotification(notification_request);
-    if (opt_state_and_states_reached) {
-      notification_request.notifier_fn(opt_state_and_states_reached->first,
-                                       opt_state_and_states_reached->second);
-      iter = servable_state_notification_requests_.erase(iter);
-    } else {
-      ++iter;
+bool ServableStateMonitor::HasServableReachedState(
+    const ServableRequest& servable_request,
+    const ServableState::ManagerState goal_state) const {
+  if (servable_request.version) {
+    const ServableId servable_id = {servable_request.name,
+                                    *servable_request.version};
+    return HasSpecificServableReachedState(
+               servable_id, goal_state, GetStateAndTimeInternal(servable_id))
+        .has_value();
+  }
+  return HasAnyServableInStreamReachedState(servable_request.name, goal_state,
+                                            states_)
+      .has_value();
+}
+
+void ServableStateMonitor::EvaluateNotificationRequest(
+    ServableStateNotificationRequest* const request) {
+  request->servables_reached.resize(request->servables.size());
+  request->num_servables_not_reached = 0;
+  for (int i = 0; i < request->servables.size(); ++i) {
+    const bool reached =
+        HasServableReachedState(request->servables[i], request->goal_state);
+    request->servables_reached[i] = reached;
+    if (!reached) {
+      ++request->num_servables_not_reached;
+    }
+  }
+}
+
+void ServableStateMonitor::MaybeTakeStateReachedNotification(
+    const int64_t request_id,
+    std::vector<StateReachedNotification>* const notifications) {
+  auto request_it = servable_state_notification_requests_.find(request_id);
+  if (request_it == servable_state_notification_requests_.end() ||
+      request_it->second.num_servables_not_reached > 0) {
+    return;
+  }
+  ServableStateNotificationRequest& request = request_it->second;
+  absl::optional<
+      std::pair<bool, std::map<ServableId, ServableState::ManagerState>>>
+      opt_state_and_states_reached =
+          ShouldSendStateReachedNotification(request);
+  if (!opt_state_and_states_reached) {
+    DCHECK(false) << "Notification request is not due, but all of its "
+                     "servables have reached their state";
+    return;
+  }
+  notifications->push_back({std::move(request.notifier_fn),
+                            opt_state_and_states_reached->first,
+                            std::move(opt_state_and_states_reached->second)});
+
+  for (const ServableRequest& servable_request : request.servables) {
+    auto index_it = notification_request_index_.find(servable_request.name);
+    if (index_it == notification_request_index_.end()) {
+      // Already removed for an earlier servable with the same name.
+      continue;
     }
+    auto& entries = index_it->second;
+    entries.erase(
+        std::remove_if(entries.begin(), entries.end(),
+                       [request_id](const std::pair<int64_t, int>& entry) {
+                         return entry.first == request_id;
+                       }),
+        entries.end());
+    if (entries.empty()) {
+      notification_request_index_.erase(index_it);
+    }
+  }
+  servable_state_notification_requests_.erase(request_it);
+}
+
+void ServableStateMonitor::TakeStateReachedNotifications(
+    const ServableName& servable_name,
+    std::vector<StateReachedNotification>* const notifications) {
+  auto index_it = notification_request_index_.find(servable_name);
+  if (index_it == notification_request_index_.end()) {
+    return;
+  }
+  std::vector<int64_t> due_request_ids;
+  for (const std::pair<int64_t, int>& entry : index_it->second) {
+    ServableStateNotificationRequest& request =
+        servable_state_notification_requests_.at(entry.first);
+    const bool reached = HasServableReachedState(
+        request.servables[entry.second], request.goal_state);
+    if (reached != request.servables_reached[entry.second]) {
+      request.servables_reached[entry.second] = reached;
+      request.num_servables_not_reached += reached ? -1 : 1;
+    }
+    if (request.num_servables_not_reached == 0 &&
+        (due_request_ids.empty() || due_request_ids.back() != entry.first)) {
+      due_request_ids.push_back(entry.first);
+    }
+  }
+  // Taking a notification modifies the index, so do it after the loop.
+  for (const int64_t request_id : due_request_ids) {
+    MaybeTakeStateReachedNotification(request_id, notifications);
+  }
+}
+
+void ServableStateMonitor::SendStateReachedNotifications(
+    const std::vector<StateReachedNotification>& notifications) {
+  for (const StateReachedNotification& notification : notifications) {
+    notification.notifier_fn(notification.reached_goal_state,
+                             notification.states_reached);
   }
 }
 
 void ServableStateMonitor::SendNotifications(
     const ServableState& servable_state) {
   mutex_lock l(notify_mu_);
-  for (const auto& notify_fn : notify_fns_) {
-    notify_fn(servable_state);
+  for (const auto& id_and_notify_fn : notify_fns_) {
+    id_and_notify_fn.second(servable_state);
   }
 }
 
@@ -19,6 +19,10 @@ limitations under the License.
 #include <deque>
 #include <functional>
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "absl/types/optional.h"
 #include "tensorflow/core/platform/env.h"
@@ -99,6 +103,13 @@ class ServableStateMonitor {
   VersionMap GetVersionStates(const string& servable_name) const
       TF_LOCKS_EXCLUDED(mu_);
 
+  /// Like GetVersionStates(), but returns an immutable snapshot of the states,
+  /// or null if no version is tracked, without taking the monitor's lock. This
+  /// way frequent polling, e.g. of model status, doesn't contend with the
+  /// state updates of the manager.
+  std::shared_ptr<const VersionMap> GetVersionStatesSnapshot(
+      const string& servable_name) const;
+
   /// Returns the current states of all tracked versions of all servables.
   ServableMap GetAllServableStates() const TF_LOCKS_EXCLUDED(mu_);
 
@@ -132,7 +143,9 @@ class ServableStateMonitor {
   ///   'goal_state' or kEnd.
   ///   2. All of the latest servable requests have reached 'goal_state' or
   ///   kEnd.
-  /// The 'notifier_fn' will be called only once, and not repeatedly.
+  /// The 'notifier_fn' will be called only once, and not repeatedly. It is
+  /// called without holding the monitor's lock, possibly from the thread that
+  /// publishes the last state event needed.
   ///
   /// The 'reached_goal_state' argument is set as true iff all of the specific
   /// servables have reached 'goal_state'.  So callers should verify that
@@ -163,9 +176,16 @@ class ServableStateMonitor {
           nullptr) TF_LOCKS_EXCLUDED(mu_) TF_MUST_USE_RESULT;
 
   // Subscribes to all servable state changes hitting this monitor. This is
-  // called after the monitor updates its own state based on the event.
+  // called after the monitor updates its own state based on the event, and
+  // before the notifications of NotifyWhenServablesReachState(...) for the
+  // event are sent. Returns an id to pass to StopNotifying().
   using NotifyFn = std::function<void(const ServableState&)>;
-  void Notify(const NotifyFn& notify_fn) TF_LOCKS_EXCLUDED(notify_mu_);
+  int64_t Notify(const NotifyFn& notify_fn) TF_LOCKS_EXCLUDED(notify_mu_);
+
+  // Unsubscribes the 'notify_fn' of the Notify() call that returned
+  // 'notify_id'. Once this returns, 'notify_fn' is not running and won't be
+  // called again. Must not be called from a 'notify_fn'.
+  void StopNotifying(int64_t notify_id) TF_LOCKS_EXCLUDED(notify_mu_);
 
  private:
   absl::optional<ServableStateMonitor::ServableStateAndTime>
@@ -178,6 +198,20 @@ class ServableStateMonitor {
     std::vector<ServableRequest> servables;
     ServableState::ManagerState goal_state;
     ServableStateNotifierFn notifier_fn;
+
+    // Whether each of 'servables' has reached 'goal_state' or kEnd, as of the
+    // last event for its servable name.
+    std::vector<bool> servables_reached;
+
+    // The number of false entries of 'servables_reached'.
+    int64_t num_servables_not_reached = 0;
+  };
+
+  // A notification that is due, to be sent without holding 'mu_'.
+  struct StateReachedNotification {
+    ServableStateNotifierFn notifier_fn;
+    bool reached_goal_state;
+    std::map<ServableId, ServableState::ManagerState> states_reached;
   };
 
   // Checks whether the notification request is satisfied and we cand send it.
@@ -189,9 +223,33 @@ class ServableStateMonitor {
       const ServableStateNotificationRequest& notification_request)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  // Goes through the notification requests and tries to see if any of them can
-  // be sent. If a notification is sent, the corresponding request is removed.
-  void MaybeSendStateReachedNotifications() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns true iff the servable, or for a latest request any servable of the
+  // stream, has reached 'goal_state' or kEnd.
+  bool HasServableReachedState(const ServableRequest& servable_request,
+                               ServableState::ManagerState goal_state) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Re-evaluates all of the servables of 'request', and sets its counts.
+  void EvaluateNotificationRequest(ServableStateNotificationRequest* request)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // If all of the servables of the request have reached their state, removes
+  // the request and appends its notification to 'notifications'.
+  void MaybeTakeStateReachedNotification(
+      int64_t request_id,
+      std::vector<StateReachedNotification>* notifications)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Re-evaluates the servables with the given name of the pending notification
+  // requests, and appends the notifications that are due to 'notifications'.
+  void TakeStateReachedNotifications(
+      const ServableName& servable_name,
+      std::vector<StateReachedNotification>* notifications)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Calls the notifier_fn of each of the notifications.
+  static void SendStateReachedNotifications(
+      const std::vector<StateReachedNotification>& notifications);
 
   // Goes through the notify_fns list and calls each one with the currently
   // received ServableState.
@@ -205,6 +263,12 @@ class ServableStateMonitor {
   virtual void PreHandleEvent(
       const EventBus<ServableState>::EventAndTime& state_and_time);
 
+  // Publishes a new snapshot of the version states of 'servable_name', or of
+  // all servables.
+  void PublishSnapshot(const ServableName& servable_name)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void PublishAllSnapshots() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   // Handles a bus event.
   void HandleEvent(const EventBus<ServableState>::EventAndTime& event_and_time)
       TF_LOCKS_EXCLUDED(mu_, notify_mu_);
@@ -223,20 +287,42 @@ class ServableStateMonitor {
   // state ServableState::ManagerState::kEnd.
   ServableMap live_states_ TF_GUARDED_BY(mu_);
 
-  // Deque of pairs of timestamp and ServableState, corresponding to the most
-  // recent servable state events handled by the monitor. The size of this deque
-  // is upper bounded by max_count_log_events in Options.
-  BoundedLog log_ TF_GUARDED_BY(mu_);
-
-  std::vector<ServableStateNotificationRequest>
+  // Immutable copies of the version maps of 'states_', read with
+  // std::atomic_load() and replaced with std::atomic_store() under 'mu_'. An
+  // event copies the outer map, which only holds pointers, and the version map
+  // of its servable.
+  using SnapshotMap =
+      std::unordered_map<ServableName, std::shared_ptr<const VersionMap>>;
+  std::shared_ptr<const SnapshotMap> snapshots_;
+
+  // Ring buffer of pairs of timestamp and ServableState, corresponding to the
+  // most recent servable state events handled by the monitor. Its size is upper
+  // bounded by max_count_log_events in Options. Once full, 'log_next_' is the
+  // index of the oldest event, which the next event overwrites.
+  std::vector<ServableStateAndTime> log_ TF_GUARDED_BY(mu_);
+  size_t log_next_ TF_GUARDED_BY(mu_) = 0;
+
+  // The pending notification requests, by id.
+  std::map<int64_t, ServableStateNotificationRequest>
       servable_state_notification_requests_ TF_GUARDED_BY(mu_);
 
+  // For each servable name, the ids of the pending notification requests that
+  // wait on servables with that name, and the indices of those servables in
+  // the requests. This way an event only re-evaluates the servables it can
+  // affect.
+  std::unordered_map<ServableName, std::vector<std::pair<int64_t, int>>>
+      notification_request_index_ TF_GUARDED_BY(mu_);
+
+  int64_t next_notification_request_id_ TF_GUARDED_BY(mu_) = 0;
+
   // Separate mutex to protect the notify_fns_ so that they can be updated
   // independently. This also allows these notify_fns_ to call other methods
   // in ServableStateMonitor which don't depend on this mutex without being
   // deadlocked.
   mutable mutex notify_mu_;
-  std::vector<NotifyFn> notify_fns_ TF_GUARDED_BY(notify_mu_);
+  // By the id returned by Notify().
+  std::map<int64_t, NotifyFn> notify_fns_ TF_GUARDED_BY(notify_mu_);
+  int64_t next_notify_id_ TF_GUARDED_BY(notify_mu_) = 0;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ServableStateMonitor);
 };
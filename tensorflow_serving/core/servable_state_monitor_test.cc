@@ -23,6 +23,7 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
@@ -384,6 +385,41 @@ TEST(ServableStateMonitorTest, ForgetUnloadedServableStates) {
                   Pair("bar", ElementsAre(Pair(1, state_1_and_time)))));
 }
 
+TEST(ServableStateMonitorTest, GetVersionStatesSnapshot) {
+  test_util::FakeClockEnv env(Env::Default());
+  EventBus<ServableState>::Options bus_options;
+  bus_options.env = &env;
+  auto bus = EventBus<ServableState>::CreateEventBus(bus_options);
+  ServableStateMonitor monitor(bus.get());
+  EXPECT_EQ(nullptr, monitor.GetVersionStatesSnapshot("foo"));
+
+  const ServableState state_0 = {ServableId{"foo", 42},
+                                 ServableState::ManagerState::kLoading,
+                                 OkStatus()};
+  env.AdvanceByMicroseconds(1);
+  const ServableStateAndTime state_0_and_time = {state_0, 1};
+  bus->Publish(state_0);
+  const std::shared_ptr<const ServableStateMonitor::VersionMap> snapshot =
+      monitor.GetVersionStatesSnapshot("foo");
+  ASSERT_NE(nullptr, snapshot);
+  EXPECT_THAT(*snapshot, ElementsAre(Pair(42, state_0_and_time)));
+
+  // A later event publishes a new snapshot, and leaves the old one untouched.
+  const ServableState state_1 = {ServableId{"foo", 42},
+                                 ServableState::ManagerState::kEnd,
+                                 OkStatus()};
+  env.AdvanceByMicroseconds(1);
+  const ServableStateAndTime state_1_and_time = {state_1, 2};
+  bus->Publish(state_1);
+  EXPECT_THAT(*monitor.GetVersionStatesSnapshot("foo"),
+              ElementsAre(Pair(42, state_1_and_time)));
+  EXPECT_THAT(*snapshot, ElementsAre(Pair(42, state_0_and_time)));
+  EXPECT_EQ(nullptr, monitor.GetVersionStatesSnapshot("bar"));
+
+  monitor.ForgetUnloadedServableStates();
+  EXPECT_EQ(nullptr, monitor.GetVersionStatesSnapshot("foo"));
+}
+
 TEST(ServableStateMonitorTest, NotifyWhenServablesReachStateZeroServables) {
   auto bus = EventBus<ServableState>::CreateEventBus({});
   ServableStateMonitor monitor(bus.get());
@@ -580,6 +616,44 @@ TEST(ServableStateMonitorTest, NotifyWhenServablesReachStateOnlyNotifiedOnce) {
   bus->Publish(specific_goal_state);
 }
 
+TEST(ServableStateMonitorTest, NotifyWhenManyServablesReachState) {
+  using ManagerState = ServableState::ManagerState;
+  constexpr int kNumServables = 1000;
+
+  auto bus = EventBus<ServableState>::CreateEventBus({});
+  ServableStateMonitor monitor(bus.get());
+  std::vector<ServableRequest> servables;
+  for (int i = 0; i < kNumServables; ++i) {
+    servables.push_back(
+        ServableRequest::FromId({strings::StrCat("servable", i), 1}));
+  }
+
+  Notification notified;
+  monitor.NotifyWhenServablesReachState(
+      servables, ManagerState::kAvailable,
+      [&](const bool reached,
+          std::map<ServableId, ManagerState> states_reached) {
+        ASSERT_FALSE(notified.HasBeenNotified());
+        EXPECT_TRUE(reached);
+        EXPECT_EQ(kNumServables, states_reached.size());
+        // The notifier is called without holding the monitor's lock.
+        EXPECT_EQ(ManagerState::kAvailable,
+                  monitor.GetState({"servable0", 1})->manager_state);
+        notified.Notify();
+      });
+  // A servable that went back from its goal state counts as not reached.
+  bus->Publish({{"servable0", 1}, ManagerState::kAvailable, OkStatus()});
+  bus->Publish({{"servable0", 1}, ManagerState::kUnloading, OkStatus()});
+  for (int i = 1; i < kNumServables; ++i) {
+    bus->Publish({{strings::StrCat("servable", i), 1},
+                  ManagerState::kAvailable, OkStatus()});
+  }
+  bus->Publish({{"other_servable", 1}, ManagerState::kAvailable, OkStatus()});
+  EXPECT_FALSE(notified.HasBeenNotified());
+  bus->Publish({{"servable0", 1}, ManagerState::kAvailable, OkStatus()});
+  EXPECT_TRUE(notified.HasBeenNotified());
+}
+
 TEST(ServableStateMonitorTest, WaitUntilServablesReachStateFullFunctionality) {
   using ManagerState = ServableState::ManagerState;
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_serving/core/server_request_logger.h"
 
+#include <algorithm>
 #include <functional>
 #include <map>
 #include <memory>
@@ -93,6 +94,8 @@ Status ServerRequestLogger::Update(
       new StringToRequestLoggersMap());
   StringToUniqueRequestLoggerMap new_config_to_logger_map;
 
+  double new_max_sampling_rate = 0;
+
   mutex_lock l(update_mu_);
 
   for (const auto& model_and_logging_config : logging_config_map) {
@@ -102,10 +105,19 @@ Status ServerRequestLogger::Update(
           logging_config, &new_config_to_logger_map, &logger));
       const string& model_name = model_and_logging_config.first;
       (*new_model_to_loggers_map)[model_name].push_back(logger);
+      new_max_sampling_rate =
+          std::max(new_max_sampling_rate,
+                   logging_config.sampling_config().sampling_rate());
     }
   }
 
+  // Raised before the new loggers are published, and lowered after, so no
+  // request a logger of either map would sample is skipped.
+  if (new_max_sampling_rate > max_sampling_rate_.load()) {
+    max_sampling_rate_.store(new_max_sampling_rate);
+  }
   model_to_loggers_map_.Update(std::move(new_model_to_loggers_map));
+  max_sampling_rate_.store(new_max_sampling_rate);
   // Any remaining loggers in config_to_logger_map_ will not be needed anymore
   // and destructed at this point.
   config_to_logger_map_ = std::move(new_config_to_logger_map);
@@ -116,12 +128,37 @@ Status ServerRequestLogger::Update(
 Status ServerRequestLogger::Log(const google::protobuf::Message& request,
                                 const google::protobuf::Message& response,
                                 const LogMetadata& log_metadata) {
+  // Sampled before the loggers are looked up, so most requests skip that.
+  const double sample = RequestLogger::DrawSample(log_metadata);
+  if (sample >= max_sampling_rate_.load(std::memory_order_relaxed)) {
+    return OkStatus();
+  }
+  Status status;
+  InvokeLoggerForModel(
+      log_metadata, [&status, sample, &request, &response, &log_metadata](
+                        const std::shared_ptr<RequestLogger>& logger) {
+        // Note: Only first error will be tracked/returned.
+        status.Update(
+            logger->LogWithSample(sample, request, response, log_metadata));
+      });
+  return status;
+}
+
+Status ServerRequestLogger::Log(
+    std::shared_ptr<const google::protobuf::Message> request,
+    std::shared_ptr<const google::protobuf::Message> response,
+    const LogMetadata& log_metadata) {
+  const double sample = RequestLogger::DrawSample(log_metadata);
+  if (sample >= max_sampling_rate_.load(std::memory_order_relaxed)) {
+    return OkStatus();
+  }
   Status status;
   InvokeLoggerForModel(
-      log_metadata, [&status, &request, &response, &log_metadata](
+      log_metadata, [&status, sample, &request, &response, &log_metadata](
                         const std::shared_ptr<RequestLogger>& logger) {
         // Note: Only first error will be tracked/returned.
-        status.Update(logger->Log(request, response, log_metadata));
+        status.Update(
+            logger->LogWithSample(sample, request, response, log_metadata));
       });
   return status;
 }
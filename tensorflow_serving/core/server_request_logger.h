@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_CORE_SERVER_REQUEST_LOGGER_H_
 #define TENSORFLOW_SERVING_CORE_SERVER_REQUEST_LOGGER_H_
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -62,12 +63,23 @@ class ServerRequestLogger {
 
   // Similar to RequestLogger::Log().
   //
+  // A single sample is drawn per request, before the loggers of the model are
+  // looked up, and the request is logged by each of them whose sampling rate
+  // is above it. So each logger still logs at its rate, but the requests its
+  // loggers log overlap, and requests sampled by no logger are cheap to skip.
+  //
   // If request is logged/written to multiple sinks, we return error from
   // the first failed write (and continue attempting to write to all).
   virtual Status Log(const google::protobuf::Message& request,
                      const google::protobuf::Message& response,
                      const LogMetadata& log_metadata);
 
+  // Similar to the shared RequestLogger::Log(), which doesn't copy 'request'
+  // and 'response' on the calling thread when logging asynchronously.
+  virtual Status Log(std::shared_ptr<const google::protobuf::Message> request,
+                     std::shared_ptr<const google::protobuf::Message> response,
+                     const LogMetadata& log_metadata);
+
   // Starts logging a stream. Returns a StreamLogger created through
   // `create_stream_logger_fn`. Returns NULL if the stream should not be logged.
   //
@@ -118,6 +130,9 @@ class ServerRequestLogger {
   // The RequestLoggers are owned by config_to_logger_map_.
   FastReadDynamicPtr<StringToRequestLoggersMap> model_to_loggers_map_;
 
+  // The highest sampling rate of the loggers in model_to_loggers_map_.
+  std::atomic<double> max_sampling_rate_{0};
+
   LoggerCreator request_logger_creator_;
 };
 
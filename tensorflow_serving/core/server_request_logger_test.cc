@@ -197,6 +197,29 @@ TEST_F(ServerRequestLoggerTest, MultipleModels) {
   EXPECT_EQ(1, log_collector_map_["/file/model1"]->collect_count());
 }
 
+TEST_F(ServerRequestLoggerTest, SkipsRequestsNoLoggerSamples) {
+  auto model_config = CreateLoggingConfigForModel("model0");
+  model_config.second.mutable_sampling_config()->set_sampling_rate(0);
+  TF_ASSERT_OK(
+      server_request_logger_->Update(CreateLoggingConfigMap({model_config})));
+
+  LogMetadata log_metadata;
+  log_metadata.mutable_model_spec()->set_name("model0");
+  for (int i = 0; i < 100; ++i) {
+    TF_ASSERT_OK(server_request_logger_->Log(
+        PredictRequest(), PredictResponse(), log_metadata));
+  }
+  EXPECT_EQ(0, log_collector_map_["/file/model0"]->collect_count());
+
+  // Raising the rate takes effect with the update.
+  model_config.second.mutable_sampling_config()->set_sampling_rate(1.0);
+  TF_ASSERT_OK(
+      server_request_logger_->Update(CreateLoggingConfigMap({model_config})));
+  TF_ASSERT_OK(server_request_logger_->Log(PredictRequest(), PredictResponse(),
+                                           log_metadata));
+  EXPECT_EQ(1, log_collector_map_["/file/model0"]->collect_count());
+}
+
 TEST_F(ServerRequestLoggerTest, CreateAndDeleteLogger) {
   auto model_logging_configs =
       CreateLoggingConfigMap({CreateLoggingConfigForModel("model0")});
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow_serving/resources/resource_util.h"
 #include "tensorflow_serving/resources/resource_values.h"
 #include "tensorflow_serving/util/any_ptr.h"
+#include "tensorflow_serving/util/memory_reclaimer.h"
 
 namespace tensorflow {
 namespace serving {
@@ -354,19 +355,27 @@ void SimpleLoader<ServableType>::Unload() {
   // estimation routine calls into the servable behind the scenes.)
   ResourceAllocation resource_estimate;
   Status resource_status = EstimateResources(&resource_estimate);
+  // If we have a main-memory footprint estimate, release that amount of memory
+  // to the OS after destroying the servable.
+  const uint64_t memory_estimate =
+      resource_status.ok()
+          ? resource_util_->GetQuantity(ram_resource_, resource_estimate)
+          : 0;
+
+  // With deferred release, the servable is destroyed and its memory returned to
+  // the OS in the background, so that freeing it doesn't hold up the unload or
+  // get in the way of the servables still serving.
+  MemoryReclaimer* const reclaimer = MemoryReclaimer::Global();
+  if (reclaimer != nullptr) {
+    ServableType* const servable = servable_.release();
+    reclaimer->Release([servable]() { delete servable; }, memory_estimate);
+    return;
+  }
 
   // Delete the servable no matter what (even if the resource estimator had some
   // error).
   servable_.reset();
 
-  if (!resource_status.ok()) {
-    return;
-  }
-
-  // If we have a main-memory footprint estimate, release that amount of memory
-  // to the OS.
-  const uint64_t memory_estimate =
-      resource_util_->GetQuantity(ram_resource_, resource_estimate);
   if (memory_estimate > 0) {
     LOG(INFO) << "Calling MallocExtension_ReleaseToSystem() after servable "
                  "unload with "
@@ -61,9 +61,12 @@ class SourceAdapter : public TargetBase<InputType>, public Source<OutputType> {
   ~SourceAdapter() override = 0;
 
   /// This method is implemented in terms of Adapt(), which the implementing
-  /// subclass must supply.
+  /// subclass must supply. Subclasses may override it to order the calls,
+  /// e.g. with aspired versions they pass on asynchronously, but must call
+  /// this implementation.
   void SetAspiredVersions(const StringPiece servable_name,
-                          std::vector<ServableData<InputType>> versions) final;
+                          std::vector<ServableData<InputType>> versions)
+      override;
 
   void SetAspiredVersionsCallback(
       typename Source<OutputType>::AspiredVersionsCallback callback) final;
@@ -43,6 +43,7 @@ class MockRequestLogger : public RequestLogger {
         notify_destruction_(std::move(notify_destruction)) {}
 
   virtual ~MockRequestLogger() {
+    StopWriters();
     if (notify_destruction_) {
       notify_destruction_();
     }
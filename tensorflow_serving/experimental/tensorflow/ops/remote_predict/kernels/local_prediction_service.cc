@@ -0,0 +1,90 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow_serving/experimental/tensorflow/ops/remote_predict/kernels/local_prediction_service.h"
+
+#include <map>
+#include <utility>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ServiceMap =
+    std::map<std::string,
+             std::shared_ptr<const LocalPredictionServices::PredictFn>>;
+
+absl::Mutex* GetMutex() {
+  static absl::Mutex* mu = new absl::Mutex();
+  return mu;
+}
+
+// Guarded by GetMutex().
+ServiceMap* GetServices() {
+  static ServiceMap* services = new ServiceMap();
+  return services;
+}
+
+}  // namespace
+
+void LocalPredictionServices::Register(const std::string& address,
+                                       PredictFn predict) {
+  absl::MutexLock l(GetMutex());
+  (*GetServices())[Canonicalize(address)] =
+      std::make_shared<const PredictFn>(std::move(predict));
+}
+
+void LocalPredictionServices::Unregister(const std::string& address) {
+  absl::MutexLock l(GetMutex());
+  GetServices()->erase(Canonicalize(address));
+}
+
+std::shared_ptr<const LocalPredictionServices::PredictFn>
+LocalPredictionServices::Find(const std::string& address) {
+  const std::string canonical_address = Canonicalize(address);
+  absl::MutexLock l(GetMutex());
+  auto it = GetServices()->find(canonical_address);
+  return it == GetServices()->end() ? nullptr : it->second;
+}
+
+std::string LocalPredictionServices::Canonicalize(const std::string& address) {
+  absl::string_view rest = address;
+  if (absl::ConsumePrefix(&rest, "unix:")) {
+    absl::ConsumePrefix(&rest, "//");
+    return absl::StrCat("unix:", rest);
+  }
+  if (!absl::ConsumePrefix(&rest, "dns:///")) {
+    if (!absl::ConsumePrefix(&rest, "ipv4:")) {
+      absl::ConsumePrefix(&rest, "ipv6:");
+    }
+  }
+  const size_t colon = rest.rfind(':');
+  if (colon == absl::string_view::npos) {
+    return std::string(rest);
+  }
+  const absl::string_view host = rest.substr(0, colon);
+  if (host == "localhost" || host == "127.0.0.1" || host == "0.0.0.0" ||
+      host == "[::1]" || host == "[::]") {
+    return absl::StrCat("localhost", rest.substr(colon));
+  }
+  return std::string(rest);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
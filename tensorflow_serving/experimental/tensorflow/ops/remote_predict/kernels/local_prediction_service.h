@@ -0,0 +1,64 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_SERVING_EXPERIMENTAL_TENSORFLOW_OPS_REMOTE_PREDICT_KERNELS_LOCAL_PREDICTION_SERVICE_H_
+#define TENSORFLOW_SERVING_EXPERIMENTAL_TENSORFLOW_OPS_REMOTE_PREDICT_KERNELS_LOCAL_PREDICTION_SERVICE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The PredictionServices hosted by this process, by the addresses they serve
+// at. RemotePredict ops whose target is one of them call it directly, rather
+// than over a loopback gRPC connection, which saves serializing the request
+// and the response, and the round trip through the network stack.
+//
+// This class is thread-safe.
+class LocalPredictionServices {
+ public:
+  // Serves 'request' by 'deadline' into 'response', and calls 'done' with the
+  // status. 'request' and 'response' stay valid until 'done' is called.
+  using PredictFn = std::function<void(
+      absl::Time deadline, const PredictRequest* request,
+      PredictResponse* response, std::function<void(absl::Status)> done)>;
+
+  // Registers 'predict' as the service at 'address', e.g. "localhost:8500" or
+  // "unix:/tmp/socket". Replaces any service already registered at it.
+  static void Register(const std::string& address, PredictFn predict);
+
+  // Unregisters the service at 'address'. Calls in flight complete.
+  static void Unregister(const std::string& address);
+
+  // Returns the service at 'address', or null if it isn't hosted by this
+  // process.
+  static std::shared_ptr<const PredictFn> Find(const std::string& address);
+
+  // Returns 'address' in the form the services are registered by, with the
+  // name resolver prefixes of gRPC ("dns:///", "ipv4:", ...) stripped, and
+  // the loopback and wildcard hosts spelt "localhost", so that e.g.
+  // "dns:///127.0.0.1:8500" and "0.0.0.0:8500" are the same address.
+  static std::string Canonicalize(const std::string& address);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_EXPERIMENTAL_TENSORFLOW_OPS_REMOTE_PREDICT_KERNELS_LOCAL_PREDICTION_SERVICE_H_
@@ -0,0 +1,69 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow_serving/experimental/tensorflow/ops/remote_predict/kernels/local_prediction_service.h"
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(LocalPredictionServicesTest, Canonicalize) {
+  EXPECT_EQ("localhost:8500",
+            LocalPredictionServices::Canonicalize("localhost:8500"));
+  EXPECT_EQ("localhost:8500",
+            LocalPredictionServices::Canonicalize("127.0.0.1:8500"));
+  EXPECT_EQ("localhost:8500",
+            LocalPredictionServices::Canonicalize("dns:///0.0.0.0:8500"));
+  EXPECT_EQ("localhost:8500",
+            LocalPredictionServices::Canonicalize("ipv6:[::1]:8500"));
+  EXPECT_EQ("example.com:8500",
+            LocalPredictionServices::Canonicalize("dns:///example.com:8500"));
+  EXPECT_EQ("unix:/tmp/socket",
+            LocalPredictionServices::Canonicalize("unix:///tmp/socket"));
+}
+
+TEST(LocalPredictionServicesTest, RegisterAndFind) {
+  EXPECT_EQ(nullptr, LocalPredictionServices::Find("localhost:9000"));
+
+  LocalPredictionServices::Register(
+      "0.0.0.0:9000",
+      [](absl::Time deadline, const PredictRequest* request,
+         PredictResponse* response, std::function<void(absl::Status)> done) {
+        *response->mutable_model_spec() = request->model_spec();
+        done(absl::OkStatus());
+      });
+  auto predict = LocalPredictionServices::Find("dns:///localhost:9000");
+  ASSERT_NE(nullptr, predict);
+  EXPECT_EQ(nullptr, LocalPredictionServices::Find("localhost:9001"));
+
+  PredictRequest request;
+  request.mutable_model_spec()->set_name("model");
+  PredictResponse response;
+  absl::Status status = absl::UnknownError("not done");
+  (*predict)(absl::InfiniteFuture(), &request, &response,
+             [&](absl::Status s) { status = s; });
+  EXPECT_TRUE(status.ok());
+  EXPECT_EQ("model", response.model_spec().name());
+
+  LocalPredictionServices::Unregister("127.0.0.1:9000");
+  EXPECT_EQ(nullptr, LocalPredictionServices::Find("localhost:9000"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
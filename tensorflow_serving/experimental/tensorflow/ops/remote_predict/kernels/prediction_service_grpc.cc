@@ -14,12 +14,24 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow_serving/experimental/tensorflow/ops/remote_predict/kernels/prediction_service_grpc.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
+#include "grpcpp/alarm.h"
+#include "grpcpp/completion_queue.h"
 #include "grpcpp/create_channel.h"
 #include "grpcpp/security/credentials.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
+#include "tensorflow_serving/experimental/tensorflow/ops/remote_predict/kernels/local_prediction_service.h"
 
 using namespace tensorflow;  // NOLINT(build/namespaces)
 namespace tensorflow {
@@ -34,16 +46,286 @@ absl::Status FromGrpcStatus(const ::grpc::Status& s) {
                       s.error_message());
 }
 
+// The tag of an event on a completion queue, which runs 'done' with whether
+// the event succeeded, and deletes itself.
+struct CompletionTag {
+  std::function<void(bool ok)> done;
+};
+
+// The completion queues shared by all the RPCs of the process.
+class CompletionQueuePool {
+ public:
+  static constexpr int kNumQueues = 4;
+
+  static CompletionQueuePool* Get() {
+    static CompletionQueuePool* pool = new CompletionQueuePool();
+    return pool;
+  }
+
+  // Returns the next queue, round-robin.
+  ::grpc::CompletionQueue* Next() {
+    return &queues_[next_.fetch_add(1, std::memory_order_relaxed) %
+                    kNumQueues];
+  }
+
+ private:
+  CompletionQueuePool() {
+    for (int i = 0; i < kNumQueues; ++i) {
+      // The pool is never destroyed, so neither are its threads joined.
+      std::thread([queue = &queues_[i]]() {
+        void* tag;
+        bool ok;
+        while (queue->Next(&tag, &ok)) {
+          CompletionTag* completion_tag = static_cast<CompletionTag*>(tag);
+          completion_tag->done(ok);
+          delete completion_tag;
+        }
+      }).detach();
+    }
+  }
+
+  ::grpc::CompletionQueue queues_[kNumQueues];
+  std::atomic<uint32_t> next_{0};
+};
+
 }  // namespace
 
-PredictionServiceGrpc::PredictionServiceGrpc(
-    const std::string& target_address) {
-  // TODO(b/159739577): Set security channel from incoming rpc request.
-  auto channel = ::grpc::CreateChannel(target_address,
-                                       ::grpc::InsecureChannelCredentials());
-  stub_ = tensorflow::serving::PredictionService::NewStub(channel);
+// A channel of a pool.
+struct PredictionServiceGrpc::Channel {
+  std::unique_ptr<tensorflow::serving::PredictionService::Stub> stub;
+  std::atomic<int64_t> num_rpcs_in_flight{0};
+};
+
+// The channels to a target, and the latency of the RPCs to it.
+struct PredictionServiceGrpc::ChannelPool {
+  // The number of latencies the hedging delay is computed over, and how often
+  // it is recomputed.
+  static constexpr int kLatencyWindow = 1000;
+  static constexpr int kLatencyRecomputeInterval = 100;
+  // At most one in this many RPCs gets a backup.
+  static constexpr int kMaxHedgeRatio = 20;
+
+  // Returns the channel with the fewest RPCs in flight, other than 'exclude'.
+  Channel* PickChannel(const Channel* exclude) {
+    const uint32_t start = next_channel.fetch_add(1, std::memory_order_relaxed);
+    Channel* picked = nullptr;
+    for (int i = 0; i < channels.size(); ++i) {
+      Channel* const candidate = channels[(start + i) % channels.size()].get();
+      if (candidate == exclude) {
+        continue;
+      }
+      if (picked == nullptr ||
+          candidate->num_rpcs_in_flight.load(std::memory_order_relaxed) <
+              picked->num_rpcs_in_flight.load(std::memory_order_relaxed)) {
+        picked = candidate;
+      }
+    }
+    return picked;
+  }
+
+  // Records the latency of a successful attempt.
+  void RecordLatency(int64_t latency_micros) ABSL_LOCKS_EXCLUDED(mu) {
+    absl::MutexLock l(&mu);
+    if (latencies_micros.size() < kLatencyWindow) {
+      latencies_micros.push_back(latency_micros);
+    } else {
+      latencies_micros[num_latencies % kLatencyWindow] = latency_micros;
+    }
+    ++num_latencies;
+    if (num_latencies >= kLatencyRecomputeInterval &&
+        num_latencies % kLatencyRecomputeInterval == 0) {
+      std::vector<int64_t> sorted = latencies_micros;
+      auto p95 = sorted.begin() + sorted.size() * 95 / 100;
+      std::nth_element(sorted.begin(), p95, sorted.end());
+      hedge_delay_micros.store(*p95, std::memory_order_relaxed);
+    }
+  }
+
+  void CountRpc() { num_rpcs.fetch_add(1, std::memory_order_relaxed); }
+
+  // Counts a backup RPC, if that keeps within the budget of kMaxHedgeRatio.
+  // Returns whether it did.
+  bool TryCountHedge() {
+    int64_t hedges = num_hedges.load(std::memory_order_relaxed);
+    do {
+      if ((hedges + 1) * kMaxHedgeRatio >
+          num_rpcs.load(std::memory_order_relaxed)) {
+        return false;
+      }
+    } while (!num_hedges.compare_exchange_weak(hedges, hedges + 1,
+                                               std::memory_order_relaxed));
+    return true;
+  }
+
+  std::vector<std::unique_ptr<Channel>> channels;
+  // Where the search for the least loaded channel starts, which rotates so
+  // that ties go round-robin.
+  std::atomic<uint32_t> next_channel{0};
+
+  // The 95th percentile of the recent latencies, after which RPCs are hedged,
+  // or -1 until enough latencies are recorded.
+  std::atomic<int64_t> hedge_delay_micros{-1};
+  std::atomic<int64_t> num_rpcs{0};
+  std::atomic<int64_t> num_hedges{0};
+
+  absl::Mutex mu;
+  // A ring of the latencies of the last kLatencyWindow successful attempts.
+  std::vector<int64_t> latencies_micros ABSL_GUARDED_BY(mu);
+  int64_t num_latencies ABSL_GUARDED_BY(mu) = 0;
+};
+
+// An RPC, made of a primary attempt and possibly a backup. Keeps itself alive
+// until all its attempts and its alarm complete.
+class PredictionServiceGrpc::HedgedRpc
+    : public std::enable_shared_from_this<HedgedRpc> {
+ public:
+  HedgedRpc(std::shared_ptr<ChannelPool> pool,
+            std::chrono::system_clock::time_point deadline,
+            PredictRequest* request, PredictResponse* response,
+            std::function<void(absl::Status status)> callback)
+      : pool_(std::move(pool)),
+        deadline_(deadline),
+        request_(request),
+        response_(response),
+        callback_(std::move(callback)) {}
+
+  void Start() {
+    pool_->CountRpc();
+    Channel* channel = pool_->PickChannel(nullptr);
+    const int64_t hedge_delay_micros =
+        pool_->hedge_delay_micros.load(std::memory_order_relaxed);
+    absl::MutexLock l(&mu_);
+    StartAttempt(channel);
+    if (hedge_delay_micros >= 0 && pool_->channels.size() > 1) {
+      alarm_pending_ = true;
+      auto* tag = new CompletionTag{
+          [self = shared_from_this(), channel](bool ok) {
+            self->OnAlarm(ok, channel);
+          }};
+      alarm_.Set(CompletionQueuePool::Get()->Next(),
+                 std::chrono::system_clock::now() +
+                     std::chrono::microseconds(hedge_delay_micros),
+                 tag);
+    }
+  }
+
+ private:
+  struct Attempt {
+    Channel* channel;
+    ::grpc::ClientContext context;
+    PredictResponse response;
+    ::grpc::Status status;
+    int64_t start_micros;
+    std::unique_ptr<::grpc::ClientAsyncResponseReader<PredictResponse>>
+        reader;
+  };
+
+  void StartAttempt(Channel* channel) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    attempts_.emplace_back(new Attempt());
+    Attempt* attempt = attempts_.back().get();
+    attempt->channel = channel;
+    attempt->context.set_deadline(deadline_);
+    attempt->start_micros = absl::GetCurrentTimeNanos() / 1000;
+    channel->num_rpcs_in_flight.fetch_add(1, std::memory_order_relaxed);
+    ++num_attempts_in_flight_;
+    attempt->reader = channel->stub->PrepareAsyncPredict(
+        &attempt->context, *request_, CompletionQueuePool::Get()->Next());
+    attempt->reader->StartCall();
+    auto* tag = new CompletionTag{
+        [self = shared_from_this(), attempt](bool ok) {
+          self->OnAttemptDone(attempt);
+        }};
+    attempt->reader->Finish(&attempt->response, &attempt->status, tag);
+  }
+
+  void OnAlarm(bool ok, Channel* primary) ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    alarm_pending_ = false;
+    // The alarm is cancelled once the RPC is done.
+    if (!ok || done_ || !pool_->TryCountHedge()) {
+      return;
+    }
+    StartAttempt(pool_->PickChannel(primary));
+  }
+
+  void OnAttemptDone(Attempt* attempt) ABSL_LOCKS_EXCLUDED(mu_) {
+    attempt->channel->num_rpcs_in_flight.fetch_sub(1,
+                                                   std::memory_order_relaxed);
+    if (attempt->status.ok()) {
+      pool_->RecordLatency(absl::GetCurrentTimeNanos() / 1000 -
+                           attempt->start_micros);
+    }
+    absl::Status status;
+    {
+      absl::MutexLock l(&mu_);
+      --num_attempts_in_flight_;
+      // The first success wins; failures only count once there is no other
+      // attempt that might still succeed.
+      if (done_ || (!attempt->status.ok() && num_attempts_in_flight_ > 0)) {
+        return;
+      }
+      done_ = true;
+      response_->Swap(&attempt->response);
+      status = FromGrpcStatus(attempt->status);
+      for (const auto& other : attempts_) {
+        if (other.get() != attempt) {
+          other->context.TryCancel();
+        }
+      }
+      if (alarm_pending_) {
+        alarm_.Cancel();
+      }
+    }
+    callback_(status);
+  }
+
+  const std::shared_ptr<ChannelPool> pool_;
+  const std::chrono::system_clock::time_point deadline_;
+  PredictRequest* const request_;
+  PredictResponse* const response_;
+  const std::function<void(absl::Status status)> callback_;
+
+  absl::Mutex mu_;
+  ::grpc::Alarm alarm_;
+  bool alarm_pending_ ABSL_GUARDED_BY(mu_) = false;
+  std::vector<std::unique_ptr<Attempt>> attempts_ ABSL_GUARDED_BY(mu_);
+  int num_attempts_in_flight_ ABSL_GUARDED_BY(mu_) = 0;
+  bool done_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+std::shared_ptr<PredictionServiceGrpc::ChannelPool>
+PredictionServiceGrpc::GetChannelPool(const std::string& target_address) {
+  static absl::Mutex mu(absl::kConstInit);
+  static auto* pools = new std::map<std::string, std::weak_ptr<ChannelPool>>();
+  absl::MutexLock l(&mu);
+  std::weak_ptr<ChannelPool>& weak_pool = (*pools)[target_address];
+  std::shared_ptr<ChannelPool> pool = weak_pool.lock();
+  if (pool != nullptr) {
+    return pool;
+  }
+  pool = std::make_shared<ChannelPool>();
+  for (int i = 0; i < kNumChannelsPerTarget; ++i) {
+    ::grpc::ChannelArguments args;
+    // Without this, channels with the same arguments share their connections.
+    args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    // Spreads the RPCs of each channel over the addresses of the target too.
+    args.SetLoadBalancingPolicyName("round_robin");
+    // TODO(b/159739577): Set security channel from incoming rpc request.
+    auto channel = ::grpc::CreateCustomChannel(
+        target_address, ::grpc::InsecureChannelCredentials(), args);
+    pool->channels.emplace_back(new Channel());
+    pool->channels.back()->stub =
+        tensorflow::serving::PredictionService::NewStub(channel);
+  }
+  weak_pool = pool;
+  return pool;
 }
 
+PredictionServiceGrpc::PredictionServiceGrpc(
+    const std::string& target_address)
+    : target_address_(target_address),
+      channel_pool_(GetChannelPool(target_address)) {}
+
 StatusOr<::grpc::ClientContext*> PredictionServiceGrpc::CreateRpc(
     absl::Duration max_rpc_deadline) {
   ::grpc::ClientContext* rpc = new ::grpc::ClientContext();
@@ -58,11 +340,16 @@ void PredictionServiceGrpc::Predict(
     ::grpc::ClientContext* rpc, PredictRequest* request,
     PredictResponse* response,
     std::function<void(absl::Status status)> callback) {
-  std::function<void(::grpc::Status)> wrapped_callback =
-      [callback](::grpc::Status status) { callback(FromGrpcStatus(status)); };
-
-  stub_->experimental_async()->Predict(rpc, request, response,
-                                       wrapped_callback);
+  const std::shared_ptr<const LocalPredictionServices::PredictFn>
+      local_predict = LocalPredictionServices::Find(target_address_);
+  if (local_predict != nullptr) {
+    (*local_predict)(absl::FromChrono(rpc->deadline()), request, response,
+                     std::move(callback));
+    return;
+  }
+  std::make_shared<HedgedRpc>(channel_pool_, rpc->deadline(), request,
+                              response, std::move(callback))
+      ->Start();
 }
 
 }  // namespace serving
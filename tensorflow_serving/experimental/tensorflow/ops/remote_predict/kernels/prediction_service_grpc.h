@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #ifndef THIRD_PARTY_TENSORFLOW_SERVING_EXPERIMENTAL_TENSORFLOW_OPS_REMOTE_PREDICT_KERNELS_PREDICTION_SERVICE_GRPC_H_
 #define THIRD_PARTY_TENSORFLOW_SERVING_EXPERIMENTAL_TENSORFLOW_OPS_REMOTE_PREDICT_KERNELS_PREDICTION_SERVICE_GRPC_H_
+#include <functional>
+#include <memory>
 #include <string>
 
 #include "absl/status/status.h"
@@ -25,8 +27,28 @@ namespace tensorflow {
 namespace serving {
 
 // gRPC based communication point with PredictionService.
+//
+// RPCs to a target are spread over a pool of channels, each with its own
+// connection, which is shared by all the instances for the target in the
+// process. Each RPC goes to the channel with the fewest RPCs in flight.
+//
+// RPCs are hedged: once the latency of the RPCs to a target is known, an RPC
+// that is still in flight after the 95th percentile of it gets a backup RPC on
+// another channel. Whichever succeeds first completes the RPC, and the other
+// is cancelled. Backup RPCs are limited to a small fraction of the RPCs, so
+// that a slow target isn't swamped with them.
+//
+// The RPCs of all the instances in the process complete on a shared pool of
+// completion queues, each polled by a thread of its own, which also runs the
+// callbacks of Predict().
+//
+// If the target is a PredictionService of this process (see
+// LocalPredictionServices), RPCs call it directly instead.
 class PredictionServiceGrpc {
  public:
+  // The number of channels in the pool of each target.
+  static constexpr int kNumChannelsPerTarget = 4;
+
   // Creates a new instance. Returns an error if the creation fails.
   static absl::Status Create(const std::string& target_address,
                              std::unique_ptr<PredictionServiceGrpc>* service) {
@@ -36,13 +58,27 @@ class PredictionServiceGrpc {
 
   StatusOr<::grpc::ClientContext*> CreateRpc(absl::Duration max_rpc_deadline);
 
+  // Sends 'request' by the deadline of 'rpc'. The attempts at the RPC have
+  // their own contexts, so 'rpc' may be deleted once 'callback' is called,
+  // even if an attempt is still being cancelled.
   void Predict(::grpc::ClientContext* rpc, PredictRequest* request,
                PredictResponse* response,
                std::function<void(absl::Status status)> callback);
 
  private:
+  struct Channel;
+  struct ChannelPool;
+  class HedgedRpc;
+
+  // Returns the pool of 'target_address', which is created by the first
+  // instance for the target, and destroyed with the last.
+  static std::shared_ptr<ChannelPool> GetChannelPool(
+      const std::string& target_address);
+
   PredictionServiceGrpc(const std::string& target_address);
-  std::unique_ptr<tensorflow::serving::PredictionService::Stub> stub_;
+
+  const std::string target_address_;
+  const std::shared_ptr<ChannelPool> channel_pool_;
 };
 
 }  // namespace serving
@@ -16,8 +16,11 @@ limitations under the License.
 
 #include <memory>
 
+#include "absl/status/status.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 
 namespace tensorflow {
 namespace serving {
@@ -45,6 +48,26 @@ TEST_F(PredictionServiceGrpcTest, TestSetDeadline) {
               10);
 }
 
+TEST_F(PredictionServiceGrpcTest, TestPredictFailsWithoutServer) {
+  std::unique_ptr<PredictionServiceGrpc> service;
+  TF_ASSERT_OK(PredictionServiceGrpc::Create("localhost:1", &service));
+  auto rpc_or = service->CreateRpc(absl::Seconds(5));
+  ASSERT_TRUE(rpc_or.ok());
+  rpc_.reset(rpc_or.value());
+
+  PredictRequest request;
+  PredictResponse response;
+  absl::Notification done;
+  absl::Status status;
+  service->Predict(rpc_.get(), &request, &response,
+                   [&](absl::Status s) {
+                     status = s;
+                     done.Notify();
+                   });
+  done.WaitForNotification();
+  EXPECT_FALSE(status.ok());
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -15,20 +15,36 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_EXPERIMENTAL_TENSORFLOW_OPS_REMOTE_PREDICT_KERNELS_REMOTE_PREDICT_OP_KERNEL_H_
 #define TENSORFLOW_SERVING_EXPERIMENTAL_TENSORFLOW_OPS_REMOTE_PREDICT_KERNELS_REMOTE_PREDICT_OP_KERNEL_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "google/protobuf/wrappers.pb.h"
 #include "google/protobuf/map.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_util.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/refcount.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/protobuf/named_tensor.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
@@ -39,8 +55,73 @@ namespace serving {
 
 typedef google::protobuf::Map<tensorflow::string, tensorflow::TensorProto> AliasTensorMap;
 
+namespace internal {
+
+// A tensor buffer that owns the 'tensor_content' bytes moved out of a
+// TensorProto, so that a tensor can alias them rather than copy them.
+class StringTensorBuffer : public TensorBuffer {
+ public:
+  explicit StringTensorBuffer(std::unique_ptr<std::string> bytes)
+      : TensorBuffer(&(*bytes)[0]), bytes_(std::move(bytes)) {}
+
+  size_t size() const override { return bytes_->size(); }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(bytes_->size());
+    proto->set_allocator_name("StringTensorBuffer");
+  }
+  bool OwnsMemory() const override { return true; }
+
+  // Gives the bytes back, for when they can't be aliased after all.
+  std::string Release() { return std::move(*bytes_); }
+
+ private:
+  ~StringTensorBuffer() override = default;
+
+  const std::unique_ptr<std::string> bytes_;
+};
+
+// Converts 'proto' to '*tensor'. If the proto holds its values in
+// 'tensor_content', the tensor takes those bytes over, leaving 'proto'
+// without them, rather than copying them; otherwise it is a plain
+// Tensor::FromProto(). Returns false if 'proto' isn't a valid tensor.
+inline bool TensorFromProtoAliasingContent(TensorProto* proto,
+                                           Tensor* tensor) {
+  if (!DataTypeCanUseMemcpy(proto->dtype()) ||
+      proto->tensor_content().empty() ||
+      !TensorShape::IsValid(proto->tensor_shape())) {
+    return tensor->FromProto(*proto);
+  }
+  const TensorShape shape(proto->tensor_shape());
+  if (shape.num_elements() * DataTypeSize(proto->dtype()) !=
+      proto->tensor_content().size()) {
+    return false;
+  }
+  auto* buffer = new StringTensorBuffer(absl::make_unique<std::string>(
+      std::move(*proto->mutable_tensor_content())));
+  core::ScopedUnref unref(buffer);
+  // Eigen expects tensors to be aligned, which the bytes of a string may not
+  // be, in which case they are copied after all.
+  if (reinterpret_cast<uintptr_t>(buffer->data()) % EIGEN_MAX_ALIGN_BYTES !=
+      0) {
+    *proto->mutable_tensor_content() = buffer->Release();
+    return tensor->FromProto(*proto);
+  }
+  *tensor = Tensor(proto->dtype(), shape, buffer);
+  return true;
+}
+
+}  // namespace internal
+
 // Remote Predict Op kernel implementation class templated on different
 // PredictionServiceStubTypes.
+//
+// If 'max_batch_size' is positive, concurrent calls of the op whose inputs are
+// batched along their 0th dimension are coalesced, up to 'max_batch_size' rows,
+// into one Predict RPC: the inputs of the calls are concatenated, and the
+// outputs of the RPC are split back into the outputs of each call. A batch is
+// sent once it is full, or 'batch_timeout_micros' after its first call. Calls
+// are coalesced across the instances of the op with the same attributes.
 template <typename PredictionServiceStubType>
 class RemotePredictOp : public AsyncOpKernel {
  public:
@@ -57,28 +138,207 @@ class RemotePredictOp : public AsyncOpKernel {
                                              &fail_op_on_rpc_error_));
     OP_REQUIRES_OK(context,
                    context->GetAttr("signature_name", &signature_name_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("max_batch_size", &max_batch_size_));
+    OP_REQUIRES_OK(context, context->GetAttr("batch_timeout_micros",
+                                             &batch_timeout_micros_));
     absl::Status prediction_service_status =
         PredictionServiceStubType::Create(target_address, &prediction_service_);
     OP_REQUIRES(context, prediction_service_status.ok(),
                 tensorflow::Status(static_cast<tensorflow::errors::Code>(
                                        prediction_service_status.code()),
                                    prediction_service_status.message()));
+    if (max_batch_size_ > 0) {
+      batcher_ = GetBatcher(absl::StrCat(
+          target_address, "|", model_name_, "|", model_version_, "|",
+          signature_name_, "|", max_rpc_deadline_millis_, "|",
+          fail_op_on_rpc_error_, "|", max_batch_size_, "|",
+          batch_timeout_micros_));
+    }
   }
 
   void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    PendingCall call;
+    call.context = context;
     // Get the input tensor alias names.
-    const auto& input_tensor_aliases = context->input(0).flat<tstring>();
+    call.input_tensor_aliases = context->input(0);
 
     // Get the input tensors.
     OpInputList input_tensors;
     OP_REQUIRES_OK_ASYNC(
         context, context->input_list("input_tensors", &input_tensors), done);
+    call.input_tensors.assign(input_tensors.begin(), input_tensors.end());
     // Get the output tensor alias names.
     // Directly index to output_tensor_aliases by moving past all the input
     // before it, including the input_tensor_aliases and input_tensors.
-    auto output_tensor_aliases =
-        context->input(1 + input_tensors.size()).flat<tstring>();
+    call.output_tensor_aliases = context->input(1 + input_tensors.size());
+    call.done = std::move(done);
+
+    string batch_key;
+    if (GetBatchKey(&call, &batch_key)) {
+      Enqueue(std::move(call), std::move(batch_key));
+      return;
+    }
+    std::vector<PendingCall> calls;
+    calls.push_back(std::move(call));
+    SendBatch(std::move(calls));
+  }
+
+  static void PostProcessResponse(
+      OpKernelContext* context, PredictResponse* response,
+      const absl::Status& rpc_status, bool fail_op_on_rpc_error,
+      TTypes<const tstring>::Flat output_tensor_aliases,
+      DoneCallback rpc_done) {
+    auto rpc_cleaner = gtl::MakeCleanup([&] { rpc_done(); });
+    std::vector<Tensor> output_tensors;
+    if (rpc_status.ok()) {
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          ResponseToTensors(response, output_tensor_aliases, &output_tensors),
+          rpc_cleaner.release());
+    }
+    SetOutputs(context, rpc_status, fail_op_on_rpc_error, output_tensors,
+               rpc_cleaner.release());
+  }
+
+ private:
+  // A call of the op, waiting to be sent.
+  struct PendingCall {
+    OpKernelContext* context;
+    DoneCallback done;
+    // The string vectors of the aliases of the inputs and outputs.
+    Tensor input_tensor_aliases;
+    std::vector<Tensor> input_tensors;
+    Tensor output_tensor_aliases;
+    // The size of the 0th dimension of the inputs, if they're batched.
+    int64_t num_rows = 0;
+  };
+
+  // The calls that are coalesced into the next batch, by the instances of the
+  // op with the same attributes. Shared with the timeouts of batches, which
+  // may fire after the ops are gone.
+  struct Batcher {
+    mutex mu;
+    // The calls of the open batch, which all have the same key.
+    std::vector<PendingCall> calls TF_GUARDED_BY(mu);
+    string key TF_GUARDED_BY(mu);
+    int64_t num_rows TF_GUARDED_BY(mu) = 0;
+    // Incremented as each batch is closed, so that its timeout knows.
+    int64_t batch_id TF_GUARDED_BY(mu) = 0;
+  };
+
+  // Returns whether 'call' can be batched with others, and if so the key of
+  // the calls it can be batched with: those with the same aliases, and inputs
+  // of the same types and shapes but for the 0th dimension.
+  bool GetBatchKey(PendingCall* call, string* key) const {
+    if (max_batch_size_ <= 0 || call->input_tensors.empty()) {
+      return false;
+    }
+    const auto input_tensor_aliases =
+        call->input_tensor_aliases.flat<tstring>();
+    for (int i = 0; i < call->input_tensors.size(); ++i) {
+      const Tensor& tensor = call->input_tensors[i];
+      if (tensor.dims() == 0 ||
+          tensor.dim_size(0) != call->input_tensors[0].dim_size(0)) {
+        return false;
+      }
+      TensorShape row_shape = tensor.shape();
+      row_shape.RemoveDim(0);
+      absl::StrAppend(key, input_tensor_aliases(i), ":",
+                      DataTypeString(tensor.dtype()), row_shape.DebugString(),
+                      ";");
+    }
+    call->num_rows = call->input_tensors[0].dim_size(0);
+    if (call->num_rows == 0 || call->num_rows > max_batch_size_) {
+      return false;
+    }
+    absl::StrAppend(key, "->");
+    const auto output_tensor_aliases =
+        call->output_tensor_aliases.flat<tstring>();
+    for (int i = 0; i < output_tensor_aliases.size(); ++i) {
+      absl::StrAppend(key, output_tensor_aliases(i), ";");
+    }
+    return true;
+  }
+
+  // Returns the batcher of the instances of the op with the attributes 'key',
+  // which lives as long as any of them.
+  static std::shared_ptr<Batcher> GetBatcher(const string& key) {
+    static mutex mu(LINKER_INITIALIZED);
+    static auto* batchers = new std::map<string, std::weak_ptr<Batcher>>();
+    mutex_lock l(mu);
+    std::weak_ptr<Batcher>& weak_batcher = (*batchers)[key];
+    std::shared_ptr<Batcher> batcher = weak_batcher.lock();
+    if (batcher == nullptr) {
+      batcher = std::make_shared<Batcher>();
+      weak_batcher = batcher;
+    }
+    return batcher;
+  }
+
+  // Takes the calls of the open batch of 'batcher', and closes it.
+  static std::vector<PendingCall> TakeBatch(Batcher* batcher)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(batcher->mu) {
+    std::vector<PendingCall> calls;
+    calls.swap(batcher->calls);
+    batcher->num_rows = 0;
+    ++batcher->batch_id;
+    return calls;
+  }
 
+  // Adds 'call' to the open batch, and sends the batch if it's full.
+  void Enqueue(PendingCall call, string key) {
+    std::vector<PendingCall> previous_batch;
+    std::vector<PendingCall> full_batch;
+    bool opened_batch = false;
+    int64_t batch_id = 0;
+    {
+      mutex_lock l(batcher_->mu);
+      if (!batcher_->calls.empty() &&
+          (key != batcher_->key ||
+           batcher_->num_rows + call.num_rows > max_batch_size_)) {
+        previous_batch = TakeBatch(batcher_.get());
+      }
+      if (batcher_->calls.empty()) {
+        batcher_->key = std::move(key);
+        opened_batch = true;
+        batch_id = batcher_->batch_id;
+      }
+      batcher_->num_rows += call.num_rows;
+      batcher_->calls.push_back(std::move(call));
+      if (batcher_->num_rows >= max_batch_size_) {
+        full_batch = TakeBatch(batcher_.get());
+        opened_batch = false;
+      }
+    }
+    if (!previous_batch.empty()) {
+      SendBatch(std::move(previous_batch));
+    }
+    if (!full_batch.empty()) {
+      SendBatch(std::move(full_batch));
+    }
+    if (opened_batch) {
+      // While the batch is open, its first call keeps this op alive.
+      std::shared_ptr<Batcher> batcher = batcher_;
+      Env::Default()->SchedClosureAfter(
+          std::max<int64_t>(0, batch_timeout_micros_),
+          [this, batcher, batch_id]() {
+            std::vector<PendingCall> calls;
+            {
+              mutex_lock l(batcher->mu);
+              if (batcher->batch_id != batch_id) {
+                return;
+              }
+              calls = TakeBatch(batcher.get());
+            }
+            SendBatch(std::move(calls));
+          });
+    }
+  }
+
+  // Sends the calls 'calls', which have the same batch key if there are
+  // several, in one Predict RPC.
+  void SendBatch(std::vector<PendingCall> calls) {
     // Build the PredictRequest.
     PredictRequest* request = new PredictRequest();
 
@@ -91,11 +351,33 @@ class RemotePredictOp : public AsyncOpKernel {
           model_version_);
     }
 
+    const PendingCall& first_call = calls[0];
+    const auto input_tensor_aliases =
+        first_call.input_tensor_aliases.flat<tstring>();
+    const auto output_tensor_aliases =
+        first_call.output_tensor_aliases.flat<tstring>();
     AliasTensorMap& inputs = *request->mutable_inputs();
     for (int i = 0; i < input_tensor_aliases.size(); ++i) {
-      tensorflow::TensorProto proto;
-      input_tensors[i].AsProtoField(&proto);
-      inputs[input_tensor_aliases(i)] = proto;
+      // Inputs go as 'tensor_content', which is a single copy of the tensor
+      // bytes, rather than one repeated field entry per value.
+      tensorflow::TensorProto& proto = inputs[input_tensor_aliases(i)];
+      if (calls.size() == 1) {
+        first_call.input_tensors[i].AsProtoTensorContent(&proto);
+      } else {
+        std::vector<Tensor> rows;
+        rows.reserve(calls.size());
+        for (const PendingCall& call : calls) {
+          rows.push_back(call.input_tensors[i]);
+        }
+        Tensor batched;
+        const Status concat_status = tensor::Concat(rows, &batched);
+        if (!concat_status.ok()) {
+          delete request;
+          FailCalls(concat_status, &calls);
+          return;
+        }
+        batched.AsProtoTensorContent(&proto);
+      }
     }
 
     for (int i = 0; i < output_tensor_aliases.size(); ++i) {
@@ -106,35 +388,129 @@ class RemotePredictOp : public AsyncOpKernel {
 
     auto rpc_or = prediction_service_->CreateRpc(
         absl::Milliseconds(max_rpc_deadline_millis_));
-    OP_REQUIRES_ASYNC(context, rpc_or.ok(),
-                      tensorflow::Status(static_cast<tensorflow::errors::Code>(
-                                             rpc_or.status().code()),
-                                         rpc_or.status().message()),
-                      [&]() {
-                        delete request;
-                        delete response;
-                        done();
-                      });
+    if (!rpc_or.ok()) {
+      delete request;
+      delete response;
+      FailCalls(tensorflow::Status(static_cast<tensorflow::errors::Code>(
+                                       rpc_or.status().code()),
+                                   rpc_or.status().message()),
+                &calls);
+      return;
+    }
     auto rpc = rpc_or.value();
-    auto callback = [this, context, rpc, request, response,
-                     output_tensor_aliases, done](const absl::Status& status) {
-      PostProcessResponse(context, response, status, fail_op_on_rpc_error_,
-                          output_tensor_aliases, [&]() {
-                            delete rpc;
-                            delete request;
-                            delete response;
-                            done();
-                          });
+    auto shared_calls =
+        std::make_shared<std::vector<PendingCall>>(std::move(calls));
+    // The ops of the calls may be gone once their calls are done, so this
+    // doesn't use 'this'.
+    auto callback = [fail_op_on_rpc_error = fail_op_on_rpc_error_, rpc,
+                     request, response,
+                     shared_calls](const absl::Status& status) {
+      if (shared_calls->size() == 1) {
+        PendingCall& call = (*shared_calls)[0];
+        PostProcessResponse(call.context, response, status,
+                            fail_op_on_rpc_error,
+                            call.output_tensor_aliases.flat<tstring>(),
+                            std::move(call.done));
+      } else {
+        PostProcessBatchResponse(response, status, fail_op_on_rpc_error,
+                                 shared_calls.get());
+      }
+      delete rpc;
+      delete request;
+      delete response;
     };
     // Make the RPC call.
     prediction_service_->Predict(rpc, request, response, callback);
   }
 
-  void PostProcessResponse(OpKernelContext* context, PredictResponse* response,
-                           const absl::Status& rpc_status,
-                           bool fail_op_on_rpc_error,
-                           TTypes<const tstring>::Flat output_tensor_aliases,
-                           DoneCallback rpc_done) {
+  // Splits the outputs of the batched RPC of 'calls' among them.
+  static void PostProcessBatchResponse(PredictResponse* response,
+                                       const absl::Status& rpc_status,
+                                       bool fail_op_on_rpc_error,
+                                       std::vector<PendingCall>* calls) {
+    std::vector<std::vector<Tensor>> call_outputs(calls->size());
+    if (rpc_status.ok()) {
+      const auto output_tensor_aliases =
+          (*calls)[0].output_tensor_aliases.flat<tstring>();
+      std::vector<Tensor> batched_outputs;
+      Status status =
+          ResponseToTensors(response, output_tensor_aliases, &batched_outputs);
+      std::vector<int64_t> num_rows;
+      int64_t total_rows = 0;
+      for (const PendingCall& call : *calls) {
+        num_rows.push_back(call.num_rows);
+        total_rows += call.num_rows;
+      }
+      for (int i = 0; status.ok() && i < batched_outputs.size(); ++i) {
+        const Tensor& batched = batched_outputs[i];
+        if (batched.dims() == 0 || batched.dim_size(0) != total_rows) {
+          status = errors::InvalidArgument(
+              "Output ", tensorflow::string(output_tensor_aliases(i)),
+              " of a batched request has shape ", batched.shape().DebugString(),
+              ", which isn't batched along the 0th dimension of the ",
+              total_rows, " rows of the inputs");
+          break;
+        }
+        std::vector<Tensor> split;
+        status = tensor::Split(batched, num_rows, &split);
+        for (int j = 0; status.ok() && j < split.size(); ++j) {
+          call_outputs[j].push_back(std::move(split[j]));
+        }
+      }
+      if (!status.ok()) {
+        FailCalls(status, calls);
+        return;
+      }
+    }
+    for (int i = 0; i < calls->size(); ++i) {
+      PendingCall& call = (*calls)[i];
+      SetOutputs(call.context, rpc_status, fail_op_on_rpc_error,
+                 call_outputs[i], std::move(call.done));
+    }
+  }
+
+  // Fails each of 'calls' with 'status'.
+  static void FailCalls(const Status& status, std::vector<PendingCall>* calls) {
+    for (PendingCall& call : *calls) {
+      call.context->SetStatus(status);
+      call.done();
+    }
+  }
+
+  // Converts the outputs 'output_tensor_aliases' of 'response' to tensors,
+  // which take over the bytes of the response where they can.
+  static Status ResponseToTensors(
+      PredictResponse* response,
+      TTypes<const tstring>::Flat output_tensor_aliases,
+      std::vector<Tensor>* output_tensors) {
+    AliasTensorMap& outputs = *response->mutable_outputs();
+    // Converting a proto takes its bytes, so an alias asked for several times
+    // is converted once.
+    std::map<tstring, Tensor> converted;
+    for (int i = 0; i < output_tensor_aliases.size(); i++) {
+      auto it = converted.find(output_tensor_aliases(i));
+      if (it == converted.end()) {
+        Tensor output_tensor;
+        if (!internal::TensorFromProtoAliasingContent(
+                &outputs[output_tensor_aliases(i)], &output_tensor)) {
+          return errors::Internal("Response tensor proto: ",
+                                  tensorflow::string(output_tensor_aliases(i)),
+                                  " cannot be converted back to a tensor.");
+        }
+        it = converted.emplace(output_tensor_aliases(i), output_tensor).first;
+      }
+      output_tensors->push_back(it->second);
+    }
+    return Status();
+  }
+
+  // Sets the outputs of the op from the status of its RPC, and from
+  // 'output_tensors' if the RPC succeeded, and calls 'rpc_done'.
+  static void SetOutputs(OpKernelContext* context,
+                         const absl::Status& rpc_status,
+                         bool fail_op_on_rpc_error,
+                         const std::vector<Tensor>& output_tensors,
+                         DoneCallback rpc_done) {
     auto rpc_cleaner = gtl::MakeCleanup([&] { rpc_done(); });
     Tensor* status_code;
     OP_REQUIRES_OK_ASYNC(
@@ -173,32 +549,26 @@ class RemotePredictOp : public AsyncOpKernel {
       }
     }
     OP_REQUIRES_ASYNC(
-        context, output_tensors_list.size() == output_tensor_aliases.size(),
+        context, output_tensors_list.size() == output_tensors.size(),
         errors::Internal(
             "Response doesn't have the right number of outputs; actual: ",
-            output_tensors_list.size(),
-            " expected: ", output_tensor_aliases.size()),
+            output_tensors_list.size(), " expected: ", output_tensors.size()),
         rpc_cleaner.release());
-    AliasTensorMap& outputs = *response->mutable_outputs();
-    for (int i = 0; i < output_tensor_aliases.size(); i++) {
-      Tensor output_tensor;
-      OP_REQUIRES_ASYNC(
-          context, output_tensor.FromProto(outputs[output_tensor_aliases(i)]),
-          errors::Internal("Response tensor proto: ",
-                           tensorflow::string(output_tensor_aliases(i)),
-                           " cannot be converted back to a tensor."),
-          rpc_cleaner.release());
-      output_tensors_list.set(i, output_tensor);
+    for (int i = 0; i < output_tensors.size(); i++) {
+      output_tensors_list.set(i, output_tensors[i]);
     }
   }
 
- private:
   string model_name_;
   int64_t model_version_;
   bool fail_op_on_rpc_error_;
   int64_t max_rpc_deadline_millis_;
   string signature_name_;
+  int64_t max_batch_size_;
+  int64_t batch_timeout_micros_;
   std::unique_ptr<PredictionServiceStubType> prediction_service_;
+  // Null unless 'max_batch_size' is positive.
+  std::shared_ptr<Batcher> batcher_;
 };
 
 }  // namespace serving
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow_serving/experimental/tensorflow/ops/remote_predict/kernels/remote_predict_op_kernel.h"
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
@@ -56,12 +57,16 @@ class MockPredictionService {
   static constexpr char kGoodModel[] = "good_model";
   static constexpr char kBadModel[] = "bad_model";
 
+  // The number of Predict calls so far.
+  static std::atomic<int> num_predict_calls;
+
  private:
   MockPredictionService(const string& target_address);
 };
 
 constexpr char MockPredictionService::kGoodModel[];
 constexpr char MockPredictionService::kBadModel[];
+std::atomic<int> MockPredictionService::num_predict_calls{0};
 
 typedef google::protobuf::Map<tensorflow::string, tensorflow::TensorProto> AliasTensorMap;
 
@@ -70,6 +75,7 @@ MockPredictionService::MockPredictionService(const string& target_address) {}
 void MockPredictionService::Predict(
     MockRpc* rpc, PredictRequest* request, PredictResponse* response,
     std::function<void(absl::Status status)> callback) {
+  ++num_predict_calls;
   // Use model name to specify the behavior of each test.
   std::string model_name = request->model_spec().name();
   if (model_name == kGoodModel) {
@@ -172,6 +178,64 @@ TEST(RemotePredictTest, TestRpcErrorReturnStatus) {
   EXPECT_EQ("Aborted", outputs[1].scalar<tensorflow::tstring>()());
 }
 
+TEST(RemotePredictTest, TestCoalescesCalls) {
+  const Scope scope = Scope::DisabledShapeInferenceScope();
+  const auto attrs = RemotePredict::Attrs()
+                         .TargetAddress("batching_target_address")
+                         .ModelName(MockPredictionService::kGoodModel)
+                         .MaxBatchSize(3)
+                         // Long enough that the test times out unless the
+                         // calls fill the batch.
+                         .BatchTimeoutMicros(600 * 1000 * 1000);
+  auto input_tensor_aliases = ops::Const(
+      scope.WithOpName("input_tensor_aliases"), {"input0", "input1"});
+  auto output_tensor_aliases = ops::Const(
+      scope.WithOpName("output_tensor_aliases"), {"output0", "output1"});
+  auto remote_predict_a = RemotePredict(
+      scope.WithOpName("remote_predict_a"), input_tensor_aliases,
+      {ops::Const(scope, {1, 2}), ops::Const(scope, {3, 4})},
+      output_tensor_aliases, {DT_INT32, DT_INT32}, attrs);
+  auto remote_predict_b = RemotePredict(
+      scope.WithOpName("remote_predict_b"), input_tensor_aliases,
+      {ops::Const(scope, {5}), ops::Const(scope, {6})}, output_tensor_aliases,
+      {DT_INT32, DT_INT32}, attrs);
+  TF_ASSERT_OK(scope.status());
+
+  const int num_predict_calls = MockPredictionService::num_predict_calls;
+  ClientSession session(scope);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run(
+      {remote_predict_a.output_tensors[0], remote_predict_a.output_tensors[1],
+       remote_predict_b.output_tensors[0], remote_predict_b.output_tensors[1]},
+      &outputs));
+  EXPECT_EQ(1, MockPredictionService::num_predict_calls - num_predict_calls);
+  ASSERT_EQ(4, outputs.size());
+  test::ExpectTensorEqual<int>(outputs[0], test::AsTensor<int>({1, 2}));
+  test::ExpectTensorEqual<int>(outputs[1], test::AsTensor<int>({3, 4}));
+  test::ExpectTensorEqual<int>(outputs[2], test::AsTensor<int>({5}));
+  test::ExpectTensorEqual<int>(outputs[3], test::AsTensor<int>({6}));
+}
+
+TEST(RemotePredictTest, TestTensorFromProtoAliasingContent) {
+  const Tensor expected =
+      test::AsTensor<float>(std::vector<float>(1024, 0.5), {32, 32});
+  TensorProto proto;
+  expected.AsProtoTensorContent(&proto);
+  Tensor tensor;
+  ASSERT_TRUE(internal::TensorFromProtoAliasingContent(&proto, &tensor));
+  test::ExpectTensorEqual<float>(expected, tensor);
+
+  // Values in repeated fields are converted as usual.
+  expected.AsProtoField(&proto);
+  ASSERT_TRUE(internal::TensorFromProtoAliasingContent(&proto, &tensor));
+  test::ExpectTensorEqual<float>(expected, tensor);
+
+  // Content that doesn't match the shape is rejected.
+  expected.AsProtoTensorContent(&proto);
+  proto.mutable_tensor_shape()->mutable_dim(0)->set_size(31);
+  EXPECT_FALSE(internal::TensorFromProtoAliasingContent(&proto, &tensor));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -28,6 +28,8 @@ REGISTER_OP("TfServingRemotePredict")
     .Attr("fail_op_on_rpc_error: bool = true")
     .Attr("max_rpc_deadline_millis: int = 30000")
     .Attr("signature_name: string = 'serving_default'")
+    .Attr("max_batch_size: int = 0")
+    .Attr("batch_timeout_micros: int = 1000")
     .Input("input_tensor_aliases: string")
     .Input("input_tensors: T")
     .Input("output_tensor_aliases: string")
@@ -89,6 +91,13 @@ max_rpc_deadline_millis: The rpc deadline for remote predict. The actual
 deadline is min(incoming_rpc_deadline, max_rpc_deadline_millis).
 signature_name: the signature def for remote graph inference, defaulting to 
 "serving_default".
+max_batch_size: If positive, concurrent calls to the same remote model (i.e. of
+  ops with the same attributes) whose inputs have the same aliases, types and
+  shapes but for the 0th dimension are coalesced into one Predict call, of up to
+  this many rows: the inputs are concatenated along the 0th dimension, and the
+  outputs, which must be batched along it too, are split back.
+batch_timeout_micros: The longest a call waits for others to coalesce with,
+  when max_batch_size is positive.
 target_address: Address of the server hosting the remote graph.
 model_name: Model name of the remote TF graph.
 model_version: the target version for the Predict call. When unset, the
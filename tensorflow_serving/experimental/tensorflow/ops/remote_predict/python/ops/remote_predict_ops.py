@@ -42,7 +42,9 @@ def run(input_tensor_alias,
         max_rpc_deadline_millis=3000,
         output_types=None,
         name=None,
-        signature_name='serving_default'):
+        signature_name='serving_default',
+        max_batch_size=0,
+        batch_timeout_micros=1000):
   """Runs a predict in remote process through rpc.
 
   Args:
@@ -57,6 +59,10 @@ def run(input_tensor_alias,
     output_types: output types for Predict
     name: name for the op in the graph
     signature_name: the signature def for remote graph inference
+    max_batch_size: if positive, concurrent calls to the same remote model are
+      coalesced into Predict calls of up to this many rows, batched along the
+      0th dimension of the inputs and outputs
+    batch_timeout_micros: the longest a call waits for others to coalesce with
 
   Returns:
     output_tensors as a result of the Predict.
@@ -75,6 +81,8 @@ def run(input_tensor_alias,
       fail_op_on_rpc_error=True,
       max_rpc_deadline_millis=max_rpc_deadline_millis,
       signature_name=signature_name,
+      max_batch_size=max_batch_size,
+      batch_timeout_micros=batch_timeout_micros,
       output_types=output_types,
       name=name))[2]
 
@@ -88,7 +96,9 @@ def run_returning_status(input_tensor_alias,
                          max_rpc_deadline_millis=3000,
                          output_types=None,
                          name=None,
-                         signature_name='serving_default'):
+                         signature_name='serving_default',
+                         max_batch_size=0,
+                         batch_timeout_micros=1000):
   """Runs a predict in remote process through rpc.
 
   Args:
@@ -103,6 +113,10 @@ def run_returning_status(input_tensor_alias,
     output_types: output types for Predict
     name: name for the op in the graph
     signature_name: the signature def for remote graph inference
+    max_batch_size: if positive, concurrent calls to the same remote model are
+      coalesced into Predict calls of up to this many rows, batched along the
+      0th dimension of the inputs and outputs
+    batch_timeout_micros: the longest a call waits for others to coalesce with
 
   Returns:
     status_code, status_error_message and output_tensors.
@@ -121,5 +135,7 @@ def run_returning_status(input_tensor_alias,
       fail_op_on_rpc_error=False,
       max_rpc_deadline_millis=max_rpc_deadline_millis,
       signature_name=signature_name,
+      max_batch_size=max_batch_size,
+      batch_timeout_micros=batch_timeout_micros,
       output_types=output_types,
       name=name))
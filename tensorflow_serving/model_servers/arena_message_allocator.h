@@ -0,0 +1,135 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_ARENA_MESSAGE_ALLOCATOR_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_ARENA_MESSAGE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/arena.h"
+#include "grpcpp/support/message_allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A gRPC MessageAllocator, for methods on the callback API, that allocates the
+// request and response of each call on a protobuf Arena, so that their many
+// sub-messages (e.g. the TensorProtos of a PredictRequest) are not allocated
+// and freed one by one.
+//
+// The arenas are reused across calls: each starts with a block of
+// 'initial_block_bytes', which is kept when the arena is reset at the end of a
+// call, so calls whose messages fit in it do not allocate at all.
+//
+// The allocator must outlive the calls it allocates for. This class is
+// thread-safe.
+template <typename RequestT, typename ResponseT>
+class ArenaMessageAllocator
+    : public ::grpc::MessageAllocator<RequestT, ResponseT> {
+ public:
+  struct Options {
+    // The size of the first block of each arena, which is kept across calls.
+    size_t initial_block_bytes = 64 << 10;
+
+    // The most idle arenas kept for reuse.
+    int max_free_arenas = 256;
+  };
+
+  explicit ArenaMessageAllocator(const Options& options) : options_(options) {}
+
+  ~ArenaMessageAllocator() override = default;
+
+  ::grpc::MessageHolder<RequestT, ResponseT>* AllocateMessages() override {
+    std::unique_ptr<Holder> holder;
+    {
+      mutex_lock l(mu_);
+      if (!free_holders_.empty()) {
+        holder = std::move(free_holders_.back());
+        free_holders_.pop_back();
+      }
+    }
+    if (holder == nullptr) {
+      holder.reset(new Holder(this, options_.initial_block_bytes));
+    }
+    holder->CreateMessages();
+    return holder.release();
+  }
+
+  // Returns the number of idle arenas.
+  int num_free_arenas() const {
+    mutex_lock l(mu_);
+    return free_holders_.size();
+  }
+
+ private:
+  class Holder : public ::grpc::MessageHolder<RequestT, ResponseT> {
+   public:
+    Holder(ArenaMessageAllocator* allocator, size_t initial_block_bytes)
+        : allocator_(allocator),
+          initial_block_(new char[initial_block_bytes]),
+          arena_(ArenaOptions(initial_block_.get(), initial_block_bytes)) {}
+
+    void CreateMessages() {
+      this->set_request(::google::protobuf::Arena::Create<RequestT>(&arena_));
+      this->set_response(
+          ::google::protobuf::Arena::Create<ResponseT>(&arena_));
+    }
+
+    void Release() override {
+      arena_.Reset();
+      allocator_->Recycle(std::unique_ptr<Holder>(this));
+    }
+
+   private:
+    static ::google::protobuf::ArenaOptions ArenaOptions(char* block,
+                                                         size_t size) {
+      ::google::protobuf::ArenaOptions options;
+      options.initial_block = block;
+      options.initial_block_size = size;
+      return options;
+    }
+
+    ArenaMessageAllocator* const allocator_;
+    const std::unique_ptr<char[]> initial_block_;
+    ::google::protobuf::Arena arena_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Holder);
+  };
+
+  void Recycle(std::unique_ptr<Holder> holder) {
+    mutex_lock l(mu_);
+    if (free_holders_.size() < options_.max_free_arenas) {
+      free_holders_.push_back(std::move(holder));
+    }
+  }
+
+  const Options options_;
+
+  mutable mutex mu_;
+  std::vector<std::unique_ptr<Holder>> free_holders_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ArenaMessageAllocator);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_ARENA_MESSAGE_ALLOCATOR_H_
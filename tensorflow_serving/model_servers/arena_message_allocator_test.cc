@@ -0,0 +1,65 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/arena_message_allocator.h"
+
+#include <gtest/gtest.h>
+#include "tensorflow_serving/apis/predict.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using Allocator = ArenaMessageAllocator<PredictRequest, PredictResponse>;
+
+TEST(ArenaMessageAllocatorTest, AllocatesOnReusedArenas) {
+  Allocator::Options options;
+  options.initial_block_bytes = 1024;
+  Allocator allocator(options);
+
+  auto* holder = allocator.AllocateMessages();
+  ASSERT_NE(nullptr, holder->request()->GetArena());
+  EXPECT_EQ(holder->request()->GetArena(), holder->response()->GetArena());
+  TensorProto tensor;
+  tensor.add_float_val(1);
+  (*holder->request()->mutable_inputs())["x"] = tensor;
+  const auto* arena = holder->request()->GetArena();
+  holder->Release();
+  EXPECT_EQ(1, allocator.num_free_arenas());
+
+  // The arena is reused, with fresh messages.
+  holder = allocator.AllocateMessages();
+  EXPECT_EQ(0, allocator.num_free_arenas());
+  EXPECT_EQ(arena, holder->request()->GetArena());
+  EXPECT_TRUE(holder->request()->inputs().empty());
+  holder->Release();
+}
+
+TEST(ArenaMessageAllocatorTest, KeepsAtMostMaxFreeArenas) {
+  Allocator::Options options;
+  options.max_free_arenas = 1;
+  Allocator allocator(options);
+
+  auto* first = allocator.AllocateMessages();
+  auto* second = allocator.AllocateMessages();
+  EXPECT_NE(first->request()->GetArena(), second->request()->GetArena());
+  first->Release();
+  second->Release();
+  EXPECT_EQ(1, allocator.num_free_arenas());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,113 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/concurrency_limiter.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "absl/time/clock.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+auto* concurrency_limit_requests = monitoring::Counter<2>::New(
+    "/tensorflow/serving/concurrency_limit/requests",
+    "The number of requests subject to a concurrency limit, by the limit and "
+    "by whether they were admitted right away, admitted after queueing, "
+    "rejected or timed out in the queue.",
+    "limit", "outcome");
+
+}  // namespace
+
+ConcurrencyLimiter::ConcurrencyLimiter(const Options& options)
+    : options_(options) {
+  if (!options_.model_name.empty()) {
+    saturation_registration_ = SaturationMonitor::Global()->Register(
+        options_.model_name, "concurrency", [this]() {
+          mutex_lock l(mu_);
+          return static_cast<double>(num_in_flight_requests_ +
+                                     num_queued_requests_) /
+                 options_.max_in_flight_requests;
+        });
+  }
+}
+
+Status ConcurrencyLimiter::Admit(absl::Time deadline,
+                                 std::unique_ptr<Permit>* permit) {
+  {
+    mutex_lock l(mu_);
+    // Requests don't jump the queue.
+    if (num_queued_requests_ == 0 &&
+        num_in_flight_requests_ < options_.max_in_flight_requests) {
+      ++num_in_flight_requests_;
+      concurrency_limit_requests->GetCell(options_.name, "admitted")
+          ->IncrementBy(1);
+    } else if (num_queued_requests_ >= options_.max_queued_requests) {
+      concurrency_limit_requests->GetCell(options_.name, "rejected")
+          ->IncrementBy(1);
+      return errors::ResourceExhausted(
+          "Too many concurrent requests to ", options_.name, ": ",
+          num_in_flight_requests_, " in flight, ", num_queued_requests_,
+          " queued");
+    } else {
+      ++num_queued_requests_;
+      // Waiters check for room before their deadline, so that a wakeup is not
+      // lost on a waiter that times out at the same time.
+      while (num_in_flight_requests_ >= options_.max_in_flight_requests) {
+        const absl::Duration time_left = deadline - absl::Now();
+        if (time_left <= absl::ZeroDuration()) {
+          --num_queued_requests_;
+          concurrency_limit_requests->GetCell(options_.name, "timed_out")
+              ->IncrementBy(1);
+          return errors::DeadlineExceeded(
+              "Deadline exceeded while queueing for a concurrency slot of ",
+              options_.name);
+        }
+        if (deadline == absl::InfiniteFuture()) {
+          released_cv_.wait(l);
+        } else {
+          released_cv_.wait_for(
+              l, std::chrono::microseconds(
+                     absl::ToInt64Microseconds(time_left) + 1));
+        }
+      }
+      --num_queued_requests_;
+      ++num_in_flight_requests_;
+      concurrency_limit_requests->GetCell(options_.name, "queued")
+          ->IncrementBy(1);
+    }
+  }
+  permit->reset(new Permit(shared_from_this()));
+  return OkStatus();
+}
+
+int64_t ConcurrencyLimiter::num_in_flight_requests() const {
+  mutex_lock l(mu_);
+  return num_in_flight_requests_;
+}
+
+void ConcurrencyLimiter::Release() {
+  mutex_lock l(mu_);
+  --num_in_flight_requests_;
+  if (num_queued_requests_ > 0) {
+    released_cv_.notify_one();
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
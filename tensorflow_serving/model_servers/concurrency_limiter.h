@@ -0,0 +1,118 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_CONCURRENCY_LIMITER_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_CONCURRENCY_LIMITER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/time/time.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Limits the requests to a model, or to a labeled version of it, that are
+// served at once, so that a traffic spike on one model cannot take all of the
+// threads of the server.
+//
+// Up to 'max_in_flight_requests' requests are admitted at once. Beyond that,
+// up to 'max_queued_requests' requests wait, on their calling threads, for
+// admitted requests to finish; the rest are rejected right away with a
+// ResourceExhausted error.
+//
+// The requests in flight and queued, relative to 'max_in_flight_requests', are
+// the "concurrency" saturation signal of 'model_name' (see SaturationMonitor),
+// which exceeds 1 while requests queue.
+//
+// This class is thread-safe.
+class ConcurrencyLimiter
+    : public std::enable_shared_from_this<ConcurrencyLimiter> {
+ public:
+  struct Options {
+    // Identifies the limit in the metrics, e.g. the name of the model.
+    string name;
+
+    // The most requests that are admitted at once. Must be positive.
+    int64_t max_in_flight_requests = 1;
+
+    // The most requests that wait to be admitted.
+    int64_t max_queued_requests = 0;
+
+    // The model whose saturation signal the limiter is. None if empty.
+    string model_name;
+  };
+
+  explicit ConcurrencyLimiter(const Options& options);
+  ~ConcurrencyLimiter() = default;
+
+  // Admits a request, for as long as 'permit' lives. Waits in the queue, if
+  // the limit is reached and the queue has room, until the request is admitted
+  // or 'deadline' passes, which gives a DeadlineExceeded error. Returns a
+  // ResourceExhausted error if the queue is full.
+  class Permit;
+  Status Admit(absl::Time deadline, std::unique_ptr<Permit>* permit)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // The number of requests that are admitted and not yet done.
+  int64_t num_in_flight_requests() const TF_LOCKS_EXCLUDED(mu_);
+
+  const Options& options() const { return options_; }
+
+ private:
+  void Release() TF_LOCKS_EXCLUDED(mu_);
+
+  const Options options_;
+
+  mutable mutex mu_;
+  condition_variable released_cv_;
+  int64_t num_in_flight_requests_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_queued_requests_ TF_GUARDED_BY(mu_) = 0;
+
+  // Declared last, to be unregistered first.
+  std::unique_ptr<SaturationMonitor::Registration> saturation_registration_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ConcurrencyLimiter);
+};
+
+// The admission of a request by a ConcurrencyLimiter. Keeps the limiter alive.
+class ConcurrencyLimiter::Permit {
+ public:
+  // Marks the request as done.
+  ~Permit() { limiter_->Release(); }
+
+ private:
+  friend class ConcurrencyLimiter;
+
+  explicit Permit(std::shared_ptr<ConcurrencyLimiter> limiter)
+      : limiter_(std::move(limiter)) {}
+
+  const std::shared_ptr<ConcurrencyLimiter> limiter_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Permit);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_CONCURRENCY_LIMITER_H_
@@ -0,0 +1,121 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/concurrency_limiter.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+std::shared_ptr<ConcurrencyLimiter> CreateLimiter(int64_t max_in_flight,
+                                                  int64_t max_queued) {
+  ConcurrencyLimiter::Options options;
+  options.name = "test_model";
+  options.max_in_flight_requests = max_in_flight;
+  options.max_queued_requests = max_queued;
+  return std::make_shared<ConcurrencyLimiter>(options);
+}
+
+TEST(ConcurrencyLimiterTest, RejectsBeyondLimit) {
+  auto limiter = CreateLimiter(2, 0);
+  std::unique_ptr<ConcurrencyLimiter::Permit> a, b, c;
+  TF_ASSERT_OK(limiter->Admit(absl::InfiniteFuture(), &a));
+  TF_ASSERT_OK(limiter->Admit(absl::InfiniteFuture(), &b));
+  EXPECT_EQ(2, limiter->num_in_flight_requests());
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED,
+            limiter->Admit(absl::InfiniteFuture(), &c).code());
+
+  // Finishing a request makes room for another.
+  a.reset();
+  EXPECT_EQ(1, limiter->num_in_flight_requests());
+  TF_EXPECT_OK(limiter->Admit(absl::InfiniteFuture(), &c));
+}
+
+TEST(ConcurrencyLimiterTest, ReportsSaturation) {
+  ConcurrencyLimiter::Options options;
+  options.name = "test_model";
+  options.model_name = "test_model";
+  options.max_in_flight_requests = 4;
+  auto limiter = std::make_shared<ConcurrencyLimiter>(options);
+  std::unique_ptr<ConcurrencyLimiter::Permit> a;
+  TF_ASSERT_OK(limiter->Admit(absl::InfiniteFuture(), &a));
+
+  // The only sample of the global monitor in this test.
+  const SaturationMonitor::Report report =
+      SaturationMonitor::Global()->Sample();
+  ASSERT_EQ(1, report.models.size());
+  EXPECT_EQ("test_model", report.models[0].model_name);
+  EXPECT_DOUBLE_EQ(0.25, report.models[0].signals.at("concurrency"));
+}
+
+TEST(ConcurrencyLimiterTest, QueuesUntilAdmitted) {
+  auto limiter = CreateLimiter(1, 1);
+  std::unique_ptr<ConcurrencyLimiter::Permit> a;
+  TF_ASSERT_OK(limiter->Admit(absl::InfiniteFuture(), &a));
+
+  absl::Notification admitted;
+  std::unique_ptr<Thread> queued_request(Env::Default()->StartThread(
+      ThreadOptions(), "queued_request", [&limiter, &admitted] {
+        std::unique_ptr<ConcurrencyLimiter::Permit> b;
+        TF_EXPECT_OK(limiter->Admit(absl::InfiniteFuture(), &b));
+        admitted.Notify();
+      }));
+  // Wait for the request to queue, which fills the queue. Until then, other
+  // requests queue and time out right away.
+  std::unique_ptr<ConcurrencyLimiter::Permit> c;
+  while (limiter->Admit(absl::Now(), &c).code() !=
+         error::RESOURCE_EXHAUSTED) {
+    Env::Default()->SleepForMicroseconds(100);
+  }
+  EXPECT_FALSE(admitted.HasBeenNotified());
+
+  a.reset();
+  admitted.WaitForNotification();
+  queued_request.reset();
+  EXPECT_EQ(0, limiter->num_in_flight_requests());
+}
+
+TEST(ConcurrencyLimiterTest, QueueingTimesOut) {
+  auto limiter = CreateLimiter(1, 1);
+  std::unique_ptr<ConcurrencyLimiter::Permit> a, b;
+  TF_ASSERT_OK(limiter->Admit(absl::InfiniteFuture(), &a));
+  EXPECT_EQ(error::DEADLINE_EXCEEDED,
+            limiter->Admit(absl::Now() + absl::Milliseconds(10), &b).code());
+
+  // The request that timed out left the queue.
+  a.reset();
+  TF_EXPECT_OK(limiter->Admit(absl::InfiniteFuture(), &b));
+}
+
+TEST(ConcurrencyLimiterTest, PermitOutlivesOwner) {
+  auto limiter = CreateLimiter(1, 0);
+  std::unique_ptr<ConcurrencyLimiter::Permit> a;
+  TF_ASSERT_OK(limiter->Admit(absl::InfiniteFuture(), &a));
+  limiter.reset();
+  a.reset();
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
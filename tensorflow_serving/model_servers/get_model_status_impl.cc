@@ -15,10 +15,12 @@ limitations under the License.
 
 #include "tensorflow_serving/model_servers/get_model_status_impl.h"
 
+#include <memory>
 #include <string>
 
 #include "absl/types/optional.h"
 #include "tensorflow_serving/apis/status.pb.h"
+#include "tensorflow_serving/core/load_profile.h"
 #include "tensorflow_serving/core/servable_state.h"
 #include "tensorflow_serving/core/servable_state_monitor.h"
 #include "tensorflow_serving/util/status_util.h"
@@ -50,8 +52,23 @@ ModelVersionStatus_State ManagerStateToStateProtoEnum(
   }
 }
 
+// Converts the profile of a load to its LoadProfile proto.
+void LoadProfileToProto(const LoadProfile& profile, LoadProfileProto* proto) {
+  for (const LoadProfile::Phase& phase : profile.phases) {
+    LoadProfileProto::Phase* phase_proto = proto->add_phases();
+    phase_proto->set_name(phase.name);
+    phase_proto->set_start_offset_micros(phase.start_offset_micros);
+    phase_proto->set_duration_micros(phase.duration_micros);
+    if (phase.ram_bytes_delta.has_value()) {
+      phase_proto->set_ram_bytes_delta(*phase.ram_bytes_delta);
+    }
+  }
+  proto->set_total_micros(profile.total_micros);
+}
+
 // Adds ModelVersionStatus to GetModelStatusResponse
-void AddModelVersionStatusToResponse(GetModelStatusResponse* response,
+void AddModelVersionStatusToResponse(const GetModelStatusRequest& request,
+                                     GetModelStatusResponse* response,
                                      const int64& version,
                                      const ServableState& servable_state) {
   ModelVersionStatus* version_status = response->add_model_version_status();
@@ -59,6 +76,13 @@ void AddModelVersionStatusToResponse(GetModelStatusResponse* response,
   version_status->set_state(
       ManagerStateToStateProtoEnum(servable_state.manager_state));
   *version_status->mutable_status() = ToStatusProto(servable_state.health);
+  if (request.include_load_profile()) {
+    const absl::optional<LoadProfile> profile =
+        LoadProfileRegistry::Global()->Get(servable_state.id);
+    if (profile.has_value()) {
+      LoadProfileToProto(*profile, version_status->mutable_load_profile());
+    }
+  }
 }
 
 }  // namespace
@@ -78,31 +102,31 @@ Status GetModelStatusImpl::GetModelStatusWithModelSpec(
     const GetModelStatusRequest& request, GetModelStatusResponse* response) {
   const string& model_name = model_spec.name();
   const ServableStateMonitor& monitor = *core->servable_state_monitor();
+  // Reads a snapshot, so that status polling doesn't take the monitor's lock.
+  const std::shared_ptr<const ServableStateMonitor::VersionMap>
+      versions_and_states = monitor.GetVersionStatesSnapshot(model_name);
 
   if (model_spec.has_version()) {
     // Only gets status for specified version of specified model.
     const int64_t version = model_spec.version().value();
-    const ServableId id = {model_name, version};
-    const absl::optional<ServableState> opt_servable_state =
-        monitor.GetState(id);
-    if (!opt_servable_state) {
+    if (versions_and_states == nullptr ||
+        versions_and_states->count(version) == 0) {
       return tensorflow::errors::NotFound("Could not find version ", version,
                                           " of model ", model_name);
     }
-    AddModelVersionStatusToResponse(response, version,
-                                    opt_servable_state.value());
+    AddModelVersionStatusToResponse(
+        request, response, version, versions_and_states->at(version).state);
   } else {
     // Gets status for all versions of specified model.
-    const ServableStateMonitor::VersionMap versions_and_states =
-        monitor.GetVersionStates(model_name);
-    if (versions_and_states.empty()) {
+    if (versions_and_states == nullptr) {
       return tensorflow::errors::NotFound(
           "Could not find any versions of model ", model_name);
     }
-    for (const auto& version_and_state : versions_and_states) {
+    for (const auto& version_and_state : *versions_and_states) {
       const int64_t version = version_and_state.first;
       const ServableState& servable_state = version_and_state.second.state;
-      AddModelVersionStatusToResponse(response, version, servable_state);
+      AddModelVersionStatusToResponse(request, response, version,
+                                      servable_state);
     }
   }
   return absl::OkStatus();
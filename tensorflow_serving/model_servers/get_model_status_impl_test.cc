@@ -177,6 +177,39 @@ TEST_F(GetModelStatusImplTest, SingleVersionSuccess) {
   EXPECT_EQ("", response.model_version_status(0).status().error_message());
 }
 
+TEST_F(GetModelStatusImplTest, LoadProfile) {
+  GetModelStatusRequest request;
+  ModelSpec* model_spec = request.mutable_model_spec();
+  model_spec->set_name(kTestModelName);
+  model_spec->mutable_version()->set_value(kTestModelVersion1);
+
+  // Profiles are only returned on request.
+  GetModelStatusResponse response;
+  TF_ASSERT_OK(
+      GetModelStatusImpl::GetModelStatus(GetServerCore(), request, &response));
+  ASSERT_EQ(1, response.model_version_status_size());
+  EXPECT_FALSE(response.model_version_status(0).has_load_profile());
+
+  request.set_include_load_profile(true);
+  response.Clear();
+  TF_ASSERT_OK(
+      GetModelStatusImpl::GetModelStatus(GetServerCore(), request, &response));
+  ASSERT_EQ(1, response.model_version_status_size());
+  const LoadProfileProto& profile =
+      response.model_version_status(0).load_profile();
+  std::set<string> phase_names;
+  for (const LoadProfileProto::Phase& phase : profile.phases()) {
+    phase_names.insert(phase.name());
+    EXPECT_LE(phase.start_offset_micros() + phase.duration_micros(),
+              profile.total_micros());
+  }
+  for (const string& phase_name :
+       {"approve_load", "load", "create_bundle", "read_meta_graph",
+        "create_session", "restore", "init_op"}) {
+    EXPECT_EQ(1, phase_names.count(phase_name)) << phase_name;
+  }
+}
+
 // Verifies that GetModelStatusWithModelSpec() uses the model spec override
 // rather than the one in the request.
 TEST_F(GetModelStatusImplTest, ModelSpecOverride) {
@@ -0,0 +1,168 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/grpc_peer_version_fetcher.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "grpcpp/client_context.h"
+#include "grpcpp/create_channel.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+Status FromGrpcStatus(const ::grpc::Status& status) {
+  if (status.ok()) {
+    return OkStatus();
+  }
+  return Status(static_cast<absl::StatusCode>(status.error_code()),
+                status.error_message());
+}
+
+bool SameFiles(const std::vector<CachedVersionFile>& a,
+               const std::vector<CachedVersionFile>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (int i = 0; i < a.size(); ++i) {
+    if (a[i].relative_path != b[i].relative_path ||
+        a[i].is_directory != b[i].is_directory || a[i].size != b[i].size ||
+        a[i].crc32c != b[i].crc32c) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status GrpcPeerVersionFetcher::Create(
+    const Options& options, std::unique_ptr<GrpcPeerVersionFetcher>* fetcher) {
+  if (options.peers.empty()) {
+    return errors::InvalidArgument("There must be at least one peer");
+  }
+  if (options.max_peers_per_version < 1) {
+    return errors::InvalidArgument("max_peers_per_version must be positive");
+  }
+  fetcher->reset(new GrpcPeerVersionFetcher(options));
+  return OkStatus();
+}
+
+GrpcPeerVersionFetcher::GrpcPeerVersionFetcher(const Options& options)
+    : options_(options) {
+  const std::shared_ptr<::grpc::ChannelCredentials> credentials =
+      options_.channel_credentials != nullptr
+          ? options_.channel_credentials
+          : ::grpc::InsecureChannelCredentials();
+  for (const string& peer : options_.peers) {
+    stubs_[peer] =
+        ModelFileService::NewStub(::grpc::CreateChannel(peer, credentials));
+  }
+}
+
+Status GrpcPeerVersionFetcher::FindVersion(
+    const string& storage_path, std::vector<string>* peers,
+    std::vector<CachedVersionFile>* files) {
+  peers->clear();
+  files->clear();
+  // Starts at a random peer, so that servers fetching the same version spread
+  // over the peers.
+  const int first_peer = random::New64() % options_.peers.size();
+  for (int i = 0; i < options_.peers.size() &&
+                  peers->size() < options_.max_peers_per_version;
+       ++i) {
+    const string& peer =
+        options_.peers[(first_peer + i) % options_.peers.size()];
+    ::grpc::ClientContext context;
+    context.set_deadline(
+        std::chrono::system_clock::now() +
+        std::chrono::microseconds(options_.rpc_timeout_micros));
+    ListVersionFilesRequest request;
+    request.set_storage_path(storage_path);
+    ListVersionFilesResponse response;
+    const ::grpc::Status status =
+        stubs_.at(peer)->ListVersionFiles(&context, request, &response);
+    if (!status.ok()) {
+      VLOG(1) << "Peer " << peer << " does not have " << storage_path << ": "
+              << status.error_message();
+      continue;
+    }
+    std::vector<CachedVersionFile> peer_files;
+    Status files_status;
+    for (const VersionFile& version_file : response.files()) {
+      files_status = ValidateRelativePath(version_file.relative_path());
+      if (!files_status.ok()) {
+        break;
+      }
+      CachedVersionFile file;
+      file.relative_path = version_file.relative_path();
+      file.is_directory = version_file.is_directory();
+      file.size = version_file.size();
+      file.crc32c = version_file.crc32c();
+      peer_files.push_back(std::move(file));
+    }
+    if (!files_status.ok()) {
+      LOG(WARNING) << "Peer " << peer << " lists an invalid file of "
+                   << storage_path << ": " << files_status;
+      continue;
+    }
+    // Peers that cached a different copy of the version, e.g. one that was
+    // overwritten at its origin, are not mixed.
+    if (peers->empty()) {
+      *files = std::move(peer_files);
+    } else if (!SameFiles(*files, peer_files)) {
+      LOG(WARNING) << "Peer " << peer << " has a different copy of "
+                   << storage_path;
+      continue;
+    }
+    peers->push_back(peer);
+  }
+  if (peers->empty()) {
+    return errors::NotFound("No peer has ", storage_path);
+  }
+  return OkStatus();
+}
+
+Status GrpcPeerVersionFetcher::ReadFile(const string& peer,
+                                        const string& storage_path,
+                                        const string& relative_path,
+                                        uint64_t offset, uint64_t length,
+                                        string* data) {
+  auto stub = stubs_.find(peer);
+  if (stub == stubs_.end()) {
+    return errors::InvalidArgument("Unknown peer ", peer);
+  }
+  ::grpc::ClientContext context;
+  context.set_deadline(std::chrono::system_clock::now() +
+                       std::chrono::microseconds(options_.rpc_timeout_micros));
+  ReadVersionFileRequest request;
+  request.set_storage_path(storage_path);
+  request.set_relative_path(relative_path);
+  request.set_offset(offset);
+  request.set_length(length);
+  ReadVersionFileResponse response;
+  TF_RETURN_IF_ERROR(FromGrpcStatus(
+      stub->second->ReadVersionFile(&context, request, &response)));
+  *data = std::move(*response.mutable_data());
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
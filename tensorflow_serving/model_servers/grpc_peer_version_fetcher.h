@@ -0,0 +1,80 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_GRPC_PEER_VERSION_FETCHER_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_GRPC_PEER_VERSION_FETCHER_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "grpcpp/security/credentials.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow_serving/apis/model_file_service.grpc.pb.h"
+#include "tensorflow_serving/core/peer_version_fetcher.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A PeerVersionFetcher that fetches the versions from a static set of peer
+// model servers, through their ModelFileService. Peers that list files with
+// unsafe paths (see ValidateRelativePath()), or a different copy of a version
+// than the first peer found, are skipped.
+class GrpcPeerVersionFetcher final : public PeerVersionFetcher {
+ public:
+  struct Options {
+    // The addresses ("host:port") of the peers.
+    std::vector<string> peers;
+
+    // The deadline of each RPC to a peer.
+    int64_t rpc_timeout_micros = 30 * 1000 * 1000;
+
+    // The most peers to fetch each version from.
+    int max_peers_per_version = 4;
+
+    // The credentials of the channels to the peers, which should match those
+    // the peers serve with. Insecure if null.
+    std::shared_ptr<::grpc::ChannelCredentials> channel_credentials;
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<GrpcPeerVersionFetcher>* fetcher);
+
+  ~GrpcPeerVersionFetcher() override = default;
+
+  Status FindVersion(const string& storage_path, std::vector<string>* peers,
+                     std::vector<CachedVersionFile>* files) override;
+
+  Status ReadFile(const string& peer, const string& storage_path,
+                  const string& relative_path, uint64_t offset,
+                  uint64_t length, string* data) override;
+
+ private:
+  explicit GrpcPeerVersionFetcher(const Options& options);
+
+  const Options options_;
+
+  // The stubs of the peers, by address.
+  std::map<string, std::unique_ptr<ModelFileService::Stub>> stubs_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GrpcPeerVersionFetcher);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_GRPC_PEER_VERSION_FETCHER_H_
@@ -0,0 +1,210 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/grpc_peer_version_fetcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow_serving/apis/model_file_service.grpc.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr char kStoragePath[] = "gs://bucket/model/1";
+
+// A peer that has kStoragePath cached as a single file, "data".
+class FakeModelFileService final : public ModelFileService::Service {
+ public:
+  FakeModelFileService(const string& relative_path, const string& data,
+                       uint32 crc32c)
+      : data_(data) {
+    VersionFile* file = files_.add_files();
+    file->set_relative_path(relative_path);
+    file->set_size(data.size());
+    file->set_crc32c(crc32c);
+  }
+
+  void set_fail_reads(bool fail_reads) { fail_reads_ = fail_reads; }
+
+  ::grpc::Status ListVersionFiles(::grpc::ServerContext* context,
+                                  const ListVersionFilesRequest* request,
+                                  ListVersionFilesResponse* response) override {
+    if (request->storage_path() != kStoragePath) {
+      return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "Not cached");
+    }
+    *response = files_;
+    return ::grpc::Status::OK;
+  }
+
+  ::grpc::Status ReadVersionFile(::grpc::ServerContext* context,
+                                 const ReadVersionFileRequest* request,
+                                 ReadVersionFileResponse* response) override {
+    if (fail_reads_) {
+      return ::grpc::Status(::grpc::StatusCode::UNAVAILABLE, "Down");
+    }
+    if (request->offset() < data_.size()) {
+      response->set_data(data_.substr(request->offset(), request->length()));
+    }
+    return ::grpc::Status::OK;
+  }
+
+ private:
+  const string data_;
+  ListVersionFilesResponse files_;
+  std::atomic<bool> fail_reads_{false};
+};
+
+class GrpcPeerVersionFetcherTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    for (const auto& server : servers_) {
+      server->Shutdown();
+    }
+  }
+
+  // Starts a peer serving 'service', and returns its address.
+  string StartPeer(std::unique_ptr<FakeModelFileService> service) {
+    ::grpc::ServerBuilder builder;
+    int port = 0;
+    builder.AddListeningPort("localhost:0", ::grpc::InsecureServerCredentials(),
+                             &port);
+    builder.RegisterService(service.get());
+    servers_.push_back(builder.BuildAndStart());
+    services_.push_back(std::move(service));
+    return absl::StrCat("localhost:", port);
+  }
+
+  std::unique_ptr<GrpcPeerVersionFetcher> CreateFetcher(
+      const std::vector<string>& peers) {
+    GrpcPeerVersionFetcher::Options options;
+    options.peers = peers;
+    std::unique_ptr<GrpcPeerVersionFetcher> fetcher;
+    TF_CHECK_OK(GrpcPeerVersionFetcher::Create(options, &fetcher));
+    return fetcher;
+  }
+
+  std::vector<std::unique_ptr<FakeModelFileService>> services_;
+  std::vector<std::unique_ptr<::grpc::Server>> servers_;
+};
+
+TEST_F(GrpcPeerVersionFetcherTest, RejectsInvalidOptions) {
+  GrpcPeerVersionFetcher::Options options;
+  std::unique_ptr<GrpcPeerVersionFetcher> fetcher;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      GrpcPeerVersionFetcher::Create(options, &fetcher)));
+  options.peers = {"localhost:1"};
+  options.max_peers_per_version = 0;
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      GrpcPeerVersionFetcher::Create(options, &fetcher)));
+}
+
+TEST_F(GrpcPeerVersionFetcherTest, FindsThePeersWithTheVersion) {
+  const string a =
+      StartPeer(std::make_unique<FakeModelFileService>("data", "abc", 1));
+  const string b =
+      StartPeer(std::make_unique<FakeModelFileService>("data", "abc", 1));
+  std::unique_ptr<GrpcPeerVersionFetcher> fetcher = CreateFetcher({a, b});
+  std::vector<string> peers;
+  std::vector<CachedVersionFile> files;
+  TF_ASSERT_OK(fetcher->FindVersion(kStoragePath, &peers, &files));
+  std::sort(peers.begin(), peers.end());
+  std::vector<string> expected_peers = {a, b};
+  std::sort(expected_peers.begin(), expected_peers.end());
+  EXPECT_EQ(expected_peers, peers);
+  ASSERT_EQ(1, files.size());
+  EXPECT_EQ("data", files[0].relative_path);
+  EXPECT_EQ(3, files[0].size);
+  EXPECT_EQ(1, files[0].crc32c);
+
+  EXPECT_TRUE(errors::IsNotFound(
+      fetcher->FindVersion("gs://bucket/model/2", &peers, &files)));
+  EXPECT_TRUE(peers.empty());
+}
+
+TEST_F(GrpcPeerVersionFetcherTest, SkipsPeersWithADifferentCopy) {
+  const string a =
+      StartPeer(std::make_unique<FakeModelFileService>("data", "abc", 1));
+  const string b =
+      StartPeer(std::make_unique<FakeModelFileService>("data", "abd", 2));
+  std::unique_ptr<GrpcPeerVersionFetcher> fetcher = CreateFetcher({a, b});
+  // Whichever peer is asked first, the copy of the other one is not mixed in.
+  for (int i = 0; i < 10; ++i) {
+    std::vector<string> peers;
+    std::vector<CachedVersionFile> files;
+    TF_ASSERT_OK(fetcher->FindVersion(kStoragePath, &peers, &files));
+    ASSERT_EQ(1, peers.size());
+    ASSERT_EQ(1, files.size());
+    EXPECT_EQ(peers[0] == a ? 1 : 2, files[0].crc32c);
+  }
+}
+
+TEST_F(GrpcPeerVersionFetcherTest, SkipsPeersWithUnsafePaths) {
+  std::vector<string> addresses;
+  for (const string& path :
+       {"../escaped", "/etc/passwd", "variables//variables", "./data", ""}) {
+    addresses.push_back(
+        StartPeer(std::make_unique<FakeModelFileService>(path, "abc", 1)));
+  }
+  std::unique_ptr<GrpcPeerVersionFetcher> fetcher = CreateFetcher(addresses);
+  std::vector<string> peers;
+  std::vector<CachedVersionFile> files;
+  EXPECT_TRUE(
+      errors::IsNotFound(fetcher->FindVersion(kStoragePath, &peers, &files)));
+
+  const string safe =
+      StartPeer(std::make_unique<FakeModelFileService>("data", "abc", 1));
+  addresses.push_back(safe);
+  fetcher = CreateFetcher(addresses);
+  TF_ASSERT_OK(fetcher->FindVersion(kStoragePath, &peers, &files));
+  EXPECT_EQ(std::vector<string>{safe}, peers);
+}
+
+TEST_F(GrpcPeerVersionFetcherTest, ReadsFiles) {
+  auto service = std::make_unique<FakeModelFileService>("data", "abcdef", 1);
+  FakeModelFileService* const service_ptr = service.get();
+  const string peer = StartPeer(std::move(service));
+  std::unique_ptr<GrpcPeerVersionFetcher> fetcher = CreateFetcher({peer});
+  string data;
+  TF_ASSERT_OK(fetcher->ReadFile(peer, kStoragePath, "data", 2, 3, &data));
+  EXPECT_EQ("cde", data);
+  TF_ASSERT_OK(fetcher->ReadFile(peer, kStoragePath, "data", 6, 3, &data));
+  EXPECT_EQ("", data);
+
+  // The errors of the peer are passed on, and peers that were not configured
+  // are not read from.
+  service_ptr->set_fail_reads(true);
+  EXPECT_TRUE(errors::IsUnavailable(
+      fetcher->ReadFile(peer, kStoragePath, "data", 0, 3, &data)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      fetcher->ReadFile("localhost:1", kStoragePath, "data", 0, 3, &data)));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
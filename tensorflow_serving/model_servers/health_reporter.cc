@@ -0,0 +1,102 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/health_reporter.h"
+
+#include <utility>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+HealthReporter::HealthReporter(const Options& options,
+                               ServableStateMonitor* monitor,
+                               SaturationMonitor* saturation_monitor,
+                               SetServingStatusFn set_serving_status)
+    : options_(options),
+      monitor_(monitor),
+      saturation_monitor_(saturation_monitor),
+      set_serving_status_(std::move(set_serving_status)) {
+  Update();
+  if (options_.update_interval_micros > 0) {
+    PeriodicFunction::Options pf_options;
+    pf_options.thread_name_prefix = "health_reporter";
+    update_thread_.reset(new PeriodicFunction([this]() { Update(); },
+                                              options_.update_interval_micros,
+                                              pf_options));
+  }
+}
+
+void HealthReporter::Update() {
+  std::map<string, double> model_saturation;
+  double server_saturation = 0;
+  if (options_.max_saturation > 0) {
+    const SaturationMonitor::Report report = saturation_monitor_->Sample();
+    server_saturation = report.saturation;
+    for (const SaturationMonitor::ModelSaturation& model : report.models) {
+      model_saturation[model.model_name] = model.saturation;
+    }
+  }
+  const auto shedding = [this](const double saturation) {
+    return options_.max_saturation > 0 &&
+           saturation >= options_.max_saturation;
+  };
+
+  mutex_lock l(mu_);
+  std::map<string, bool> model_statuses;
+  bool all_ready = true;
+  for (const auto& model : monitor_->GetLiveServableStates()) {
+    bool ready = false;
+    for (const auto& version : model.second) {
+      if (version.second.state.manager_state ==
+          ServableState::ManagerState::kAvailable) {
+        ready = true;
+        break;
+      }
+    }
+    all_ready = all_ready && ready;
+    model_statuses[model.first] =
+        ready && !shedding(model_saturation[model.first]);
+  }
+  // The models no longer served stop serving.
+  for (const auto& status : statuses_) {
+    if (!status.first.empty() && status.first != "ModelService" &&
+        status.first != "PredictionService") {
+      model_statuses.emplace(status.first, false);
+    }
+  }
+  for (const auto& status : model_statuses) {
+    SetStatus(status.first, status.second);
+  }
+  const bool serving = all_ready && !shedding(server_saturation);
+  SetStatus("", serving);
+  SetStatus("PredictionService", serving);
+  SetStatus("ModelService", true);
+}
+
+void HealthReporter::SetStatus(const string& service, const bool serving) {
+  auto it = statuses_.find(service);
+  if (it != statuses_.end() && it->second == serving) {
+    return;
+  }
+  LOG(INFO) << "Health of service '" << service << "' is now "
+            << (serving ? "SERVING" : "NOT_SERVING");
+  statuses_[service] = serving;
+  set_serving_status_(service, serving);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,99 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_HEALTH_REPORTER_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_HEALTH_REPORTER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/kernels/batching_util/periodic_function.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_serving/core/servable_state_monitor.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Keeps the serving status of the gRPC health check services in line with
+// whether the server can take traffic, so load balancers only route to
+// replicas that are warm and not overloaded.
+//
+// Each model is a service of its own, named after the model, which serves once
+// a version of the model is available (i.e. loaded and warmed up), and while
+// the model's saturation is below 'max_saturation'. The server as a whole (the
+// service "") and the "PredictionService" serve while every model that has a
+// version being loaded or served has an available one, and the saturation of
+// the server is below 'max_saturation'; otherwise they drain. "ModelService"
+// always serves, for the admin calls.
+//
+// The statuses are updated every 'update_interval_micros', and on Update().
+//
+// This class is thread-safe.
+class HealthReporter {
+ public:
+  struct Options {
+    // How often to update the statuses. 0 to only update on Update().
+    int64_t update_interval_micros = 1000 * 1000;
+
+    // The saturation (see SaturationMonitor) at which a model, or the server,
+    // sheds load by reporting NOT_SERVING. 0 never sheds load.
+    double max_saturation = 0;
+  };
+
+  // Sets the serving status of the health check service 'service'.
+  using SetServingStatusFn =
+      std::function<void(const string& service, bool serving)>;
+
+  // 'monitor' and 'saturation_monitor' must outlive the reporter.
+  HealthReporter(const Options& options, ServableStateMonitor* monitor,
+                 SaturationMonitor* saturation_monitor,
+                 SetServingStatusFn set_serving_status);
+
+  // Stops updating the statuses.
+  ~HealthReporter() = default;
+
+  // Updates the statuses now.
+  void Update() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Sets the status of 'service' if it changed.
+  void SetStatus(const string& service, bool serving)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+  ServableStateMonitor* const monitor_;
+  SaturationMonitor* const saturation_monitor_;
+  const SetServingStatusFn set_serving_status_;
+
+  mutex mu_;
+  // The statuses last set, by service.
+  std::map<string, bool> statuses_ TF_GUARDED_BY(mu_);
+
+  // Declared last, to be stopped first.
+  std::unique_ptr<PeriodicFunction> update_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(HealthReporter);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_HEALTH_REPORTER_H_
@@ -0,0 +1,103 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/health_reporter.h"
+
+#include <map>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/core/servable_state.h"
+#include "tensorflow_serving/util/event_bus.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class HealthReporterTest : public ::testing::Test {
+ protected:
+  HealthReporterTest()
+      : bus_(EventBus<ServableState>::CreateEventBus()),
+        monitor_(bus_.get()),
+        saturation_monitor_(SaturationMonitor::Options()) {}
+
+  std::unique_ptr<HealthReporter> CreateReporter(double max_saturation) {
+    HealthReporter::Options options;
+    options.update_interval_micros = 0;
+    options.max_saturation = max_saturation;
+    return std::unique_ptr<HealthReporter>(new HealthReporter(
+        options, &monitor_, &saturation_monitor_,
+        [this](const string& service, bool serving) {
+          statuses_[service] = serving;
+        }));
+  }
+
+  void PublishState(const string& model, int64_t version,
+                    ServableState::ManagerState state) {
+    bus_->Publish({ServableId{model, version}, state, OkStatus()});
+  }
+
+  std::shared_ptr<EventBus<ServableState>> bus_;
+  ServableStateMonitor monitor_;
+  SaturationMonitor saturation_monitor_;
+  std::map<string, bool> statuses_;
+};
+
+TEST_F(HealthReporterTest, ServesOnceModelsAreAvailable) {
+  PublishState("a", 1, ServableState::ManagerState::kAvailable);
+  PublishState("b", 1, ServableState::ManagerState::kLoading);
+  auto reporter = CreateReporter(0);
+  EXPECT_TRUE(statuses_.at("a"));
+  EXPECT_FALSE(statuses_.at("b"));
+  EXPECT_FALSE(statuses_.at(""));
+  EXPECT_FALSE(statuses_.at("PredictionService"));
+  EXPECT_TRUE(statuses_.at("ModelService"));
+
+  PublishState("b", 1, ServableState::ManagerState::kAvailable);
+  reporter->Update();
+  EXPECT_TRUE(statuses_.at("b"));
+  EXPECT_TRUE(statuses_.at(""));
+  EXPECT_TRUE(statuses_.at("PredictionService"));
+
+  // A new version loading does not stop a model from serving.
+  PublishState("b", 2, ServableState::ManagerState::kLoading);
+  reporter->Update();
+  EXPECT_TRUE(statuses_.at("b"));
+
+  // Nor does a model that is no longer served stop the server.
+  PublishState("a", 1, ServableState::ManagerState::kUnloading);
+  PublishState("a", 1, ServableState::ManagerState::kEnd);
+  reporter->Update();
+  EXPECT_FALSE(statuses_.at("a"));
+  EXPECT_TRUE(statuses_.at(""));
+}
+
+TEST_F(HealthReporterTest, ShedsLoadWhenSaturated) {
+  PublishState("a", 1, ServableState::ManagerState::kAvailable);
+  PublishState("b", 1, ServableState::ManagerState::kAvailable);
+  auto registration =
+      saturation_monitor_.Register("a", "concurrency", []() { return 1.5; });
+  auto reporter = CreateReporter(1.0);
+  EXPECT_FALSE(statuses_.at("a"));
+  EXPECT_TRUE(statuses_.at("b"));
+  EXPECT_FALSE(statuses_.at(""));
+  EXPECT_FALSE(statuses_.at("PredictionService"));
+  EXPECT_TRUE(statuses_.at("ModelService"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_serving/model_servers/http_rest_api_handler.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -27,10 +28,13 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow_serving/apis/model.pb.h"
@@ -43,7 +47,13 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/get_model_metadata_impl.h"
 #include "tensorflow_serving/servables/tensorflow/predict_impl.h"
 #include "tensorflow_serving/servables/tensorflow/regression_service.h"
+#include "tensorflow_serving/servables/tensorflow/slow_requests.h"
+#include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
+#include "tensorflow_serving/servables/tensorflow/util.h"
 #include "tensorflow_serving/util/json_tensor.h"
+#include "tensorflow_serving/util/request_arena.h"
+#include "tensorflow_serving/util/request_deadline.h"
+#include "tensorflow_serving/util/safetensors.h"
 
 namespace tensorflow {
 namespace serving {
@@ -51,10 +61,51 @@ namespace serving {
 using tensorflow::serving::ServerCore;
 using tensorflow::serving::TensorflowPredictor;
 
+namespace {
+
+// Returns the dedicated thread pools of the model 'model_name', if any.
+ScopedThreadPools GetThreadPools(ServerCore* core,
+                                 const absl::string_view model_name) {
+  const std::shared_ptr<ThreadPoolFactory> thread_pool_factory =
+      core->GetThreadPoolFactory(string(model_name));
+  return thread_pool_factory == nullptr ? ScopedThreadPools()
+                                        : thread_pool_factory->GetThreadPools();
+}
+
+// Ends the stage 'timer' is in, and captures 'request', which succeeded, with
+// the latencies of its stages if it was slow (see SlowRequests).
+template <typename Request>
+void MaybeCaptureSlowRequest(const absl::string_view model_name,
+                             const Request& request, RequestStageTimer* timer) {
+  timer->EndStage();
+  int64_t total_micros = 0;
+  for (const auto& stage_latency : timer->stage_latencies()) {
+    total_micros += stage_latency.second;
+  }
+  if (!SlowRequests::Global()->IsSlow(total_micros)) {
+    return;
+  }
+  RequestLatency latency;
+  latency.set_total_micros(total_micros);
+  for (const auto& stage_latency : timer->stage_latencies()) {
+    RequestLatency::Stage* stage = latency.add_stages();
+    stage->set_name(stage_latency.first);
+    stage->set_micros(stage_latency.second);
+  }
+  SlowRequests::Global()->Capture(string(model_name), request, latency);
+}
+
+}  // namespace
+
 const char* const HttpRestApiHandler::kPathRegex = kHTTPRestApiHandlerPathRegex;
 
 HttpRestApiHandler::HttpRestApiHandler(int timeout_in_ms, ServerCore* core)
-    : run_options_(), core_(core), predictor_(new TensorflowPredictor()) {
+    : run_options_(),
+      core_(core),
+      predictor_(new TensorflowPredictor()),
+      json_decode_thread_pool_(new thread::ThreadPool(
+          Env::Default(), "rest_json_decode", port::NumSchedulableCPUs())),
+      model_metadata_cache_(core) {
   if (timeout_in_ms > 0) {
     run_options_.set_timeout_in_ms(timeout_in_ms);
   }
@@ -67,9 +118,26 @@ Status HttpRestApiHandler::ProcessRequest(
     const absl::string_view request_body,
     std::vector<std::pair<string, string>>* headers, string* model_name,
     string* method, string* output) {
+  return ProcessRequest(http_method, request_path, request_body,
+                        HttpRequestHeaders(), headers, model_name, method,
+                        output);
+}
+
+Status HttpRestApiHandler::ProcessRequest(
+    const absl::string_view http_method, const absl::string_view request_path,
+    const absl::string_view request_body,
+    const HttpRequestHeaders& request_headers,
+    std::vector<std::pair<string, string>>* headers, string* model_name,
+    string* method, string* output) {
   headers->clear();
   output->clear();
   AddHeaders(headers);
+  // Charge the parsing of the request, and all else, to its timeout.
+  ScopedRequestDeadline deadline_scope(std::make_shared<RequestDeadline>(
+      run_options_.timeout_in_ms() > 0
+          ? absl::Now() + absl::Milliseconds(run_options_.timeout_in_ms())
+          : absl::InfiniteFuture(),
+      /*is_cancelled=*/nullptr));
   string model_subresource;
   Status status = errors::InvalidArgument("Malformed request: ", http_method,
                                           " ", request_path);
@@ -77,22 +145,49 @@ Status HttpRestApiHandler::ProcessRequest(
   absl::optional<string> model_version_label;
   bool parse_successful;
 
-  TF_RETURN_IF_ERROR(ParseModelInfo(
-      http_method, request_path, model_name, &model_version,
-      &model_version_label, method, &model_subresource, &parse_successful));
+  absl::string_view path;
+  JsonOutputFormat json_output_format = core_->compact_json_responses()
+                                            ? JsonOutputFormat::kCompact
+                                            : JsonOutputFormat::kPretty;
+  TF_RETURN_IF_ERROR(
+      ParseRequestQuery(request_path, &path, &json_output_format));
+  TF_RETURN_IF_ERROR(ParseModelInfo(http_method, path, model_name,
+                                    &model_version, &model_version_label,
+                                    method, &model_subresource,
+                                    &parse_successful));
+  const bool safetensors_request =
+      HasSafetensorsMediaType(request_headers.content_type);
+  const bool safetensors_response =
+      HasSafetensorsMediaType(request_headers.accept);
 
   // Dispatch request to appropriate processor
   if (http_method == "POST" && parse_successful) {
-    if (*method == "classify") {
-      status =
-          ProcessClassifyRequest(*model_name, model_version,
-                                 model_version_label, request_body, output);
+    RequestStageTimer timer(*model_name, *method);
+    if (safetensors_request && *method != "predict") {
+      status = errors::InvalidArgument(
+          "Only predict requests can have a ", kSafetensorsContentType,
+          " body");
+    } else if (*method == "classify") {
+      status = ProcessClassifyRequest(*model_name, model_version,
+                                      model_version_label, request_body,
+                                      json_output_format, &timer, output);
     } else if (*method == "regress") {
       status = ProcessRegressRequest(*model_name, model_version,
-                                     model_version_label, request_body, output);
+                                     model_version_label, request_body,
+                                     json_output_format, &timer, output);
     } else if (*method == "predict") {
-      status = ProcessPredictRequest(*model_name, model_version,
-                                     model_version_label, request_body, output);
+      status = ProcessPredictRequest(
+          *model_name, model_version, model_version_label, request_body,
+          safetensors_request, safetensors_response, json_output_format,
+          request_headers.response_body_writer, &timer, output);
+      if (status.ok() && safetensors_response) {
+        SetContentType(kSafetensorsContentType, headers);
+      }
+    }
+    timer.EndStage();
+    // Not sent with streamed responses, whose headers went out already.
+    if (core_->server_timing_header()) {
+      headers->push_back({"Server-Timing", timer.ServerTiming()});
     }
   } else if (http_method == "GET" && parse_successful) {
     if (!model_subresource.empty() && model_subresource == "metadata") {
@@ -112,20 +207,28 @@ Status HttpRestApiHandler::ProcessClassifyRequest(
     const absl::string_view model_name,
     const absl::optional<int64_t>& model_version,
     const absl::optional<absl::string_view>& model_version_label,
-    const absl::string_view request_body, string* output) {
-  ::google::protobuf::Arena arena;
+    const absl::string_view request_body, JsonOutputFormat json_output_format,
+    RequestStageTimer* timer, string* output) {
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<ClassificationRequest>(&arena);
+  timer->StartStage("parse");
+  auto* request =
+      ::google::protobuf::Arena::Create<ClassificationRequest>(arena.get());
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
   TF_RETURN_IF_ERROR(FillClassificationRequestFromJson(request_body, request));
 
-  auto* response = ::google::protobuf::Arena::Create<ClassificationResponse>(&arena);
+  timer->StartStage("run");
+  auto* response =
+      ::google::protobuf::Arena::Create<ClassificationResponse>(arena.get());
   TF_RETURN_IF_ERROR(TensorflowClassificationServiceImpl::Classify(
-      run_options_, core_, thread::ThreadPoolOptions(), *request, response));
-  TF_RETURN_IF_ERROR(
-      MakeJsonFromClassificationResult(response->result(), output));
+      run_options_, core_, GetThreadPools(core_, model_name).get(), *request,
+      response));
+  timer->StartStage("serialize");
+  TF_RETURN_IF_ERROR(MakeJsonFromClassificationResult(
+      response->result(), json_output_format, output));
+  MaybeCaptureSlowRequest(model_name, *request, timer);
   return absl::OkStatus();
 }
 
@@ -133,19 +236,28 @@ Status HttpRestApiHandler::ProcessRegressRequest(
     const absl::string_view model_name,
     const absl::optional<int64_t>& model_version,
     const absl::optional<absl::string_view>& model_version_label,
-    const absl::string_view request_body, string* output) {
-  ::google::protobuf::Arena arena;
+    const absl::string_view request_body, JsonOutputFormat json_output_format,
+    RequestStageTimer* timer, string* output) {
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<RegressionRequest>(&arena);
+  timer->StartStage("parse");
+  auto* request =
+      ::google::protobuf::Arena::Create<RegressionRequest>(arena.get());
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
   TF_RETURN_IF_ERROR(FillRegressionRequestFromJson(request_body, request));
 
-  auto* response = ::google::protobuf::Arena::Create<RegressionResponse>(&arena);
+  timer->StartStage("run");
+  auto* response =
+      ::google::protobuf::Arena::Create<RegressionResponse>(arena.get());
   TF_RETURN_IF_ERROR(TensorflowRegressionServiceImpl::Regress(
-      run_options_, core_, thread::ThreadPoolOptions(), *request, response));
-  TF_RETURN_IF_ERROR(MakeJsonFromRegressionResult(response->result(), output));
+      run_options_, core_, GetThreadPools(core_, model_name).get(), *request,
+      response));
+  timer->StartStage("serialize");
+  TF_RETURN_IF_ERROR(MakeJsonFromRegressionResult(
+      response->result(), json_output_format, output));
+  MaybeCaptureSlowRequest(model_name, *request, timer);
   return absl::OkStatus();
 }
 
@@ -153,27 +265,55 @@ Status HttpRestApiHandler::ProcessPredictRequest(
     const absl::string_view model_name,
     const absl::optional<int64_t>& model_version,
     const absl::optional<absl::string_view>& model_version_label,
-    const absl::string_view request_body, string* output) {
-  ::google::protobuf::Arena arena;
+    const absl::string_view request_body, bool safetensors_request,
+    bool safetensors_response, JsonOutputFormat json_output_format,
+    HttpResponseBodyWriter* response_body_writer, RequestStageTimer* timer,
+    string* output) {
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<PredictRequest>(&arena);
+  timer->StartStage("parse");
+  auto* request =
+      ::google::protobuf::Arena::Create<PredictRequest>(arena.get());
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
 
-  JsonPredictRequestFormat format;
-  TF_RETURN_IF_ERROR(FillPredictRequestFromJson(
-      request_body,
-      [this, request](const string& sig,
-                      ::google::protobuf::Map<string, TensorInfo>* map) {
-        return this->GetInfoMap(request->model_spec(), sig, map);
-      },
-      request, &format));
+  // Inputs in safetensors are named, like "inputs" in JSON.
+  JsonPredictRequestFormat format = JsonPredictRequestFormat::kColumnar;
+  if (safetensors_request) {
+    TF_RETURN_IF_ERROR(
+        FillPredictRequestFromSafetensors(request_body, request));
+  } else {
+    TF_RETURN_IF_ERROR(FillPredictRequestFromJsonInParallel(
+        request_body,
+        [this, request](const string& sig,
+                        ::google::protobuf::Map<string, TensorInfo>* map) {
+          return this->GetInfoMap(request->model_spec(), sig, map);
+        },
+        json_decode_thread_pool_.get(), request, &format));
+  }
 
-  auto* response = ::google::protobuf::Arena::Create<PredictResponse>(&arena);
+  timer->StartStage("run");
+  auto* response =
+      ::google::protobuf::Arena::Create<PredictResponse>(arena.get());
   TF_RETURN_IF_ERROR(
       predictor_->Predict(run_options_, core_, *request, response));
-  TF_RETURN_IF_ERROR(MakeJsonFromTensors(response->outputs(), format, output));
+  timer->StartStage("serialize");
+  if (safetensors_response) {
+    TF_RETURN_IF_ERROR(MakeSafetensorsFromTensors(response->outputs(), output));
+  } else if (response_body_writer != nullptr &&
+             response->ByteSizeLong() >= kMinStreamedResponseBytes) {
+    TF_RETURN_IF_ERROR(MakeJsonFromTensors(
+        response->outputs(), format, json_output_format,
+        kStreamedResponseChunkBytes,
+        [response_body_writer](absl::string_view chunk) {
+          response_body_writer->WriteChunk(chunk);
+        }));
+  } else {
+    TF_RETURN_IF_ERROR(MakeJsonFromTensors(response->outputs(), format,
+                                           json_output_format, output));
+  }
+  MaybeCaptureSlowRequest(model_name, *request, timer);
   return absl::OkStatus();
 }
 
@@ -188,14 +328,16 @@ Status HttpRestApiHandler::ProcessModelStatusRequest(
     return errors::InvalidArgument("Missing model name in request.");
   }
 
-  ::google::protobuf::Arena arena;
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<GetModelStatusRequest>(&arena);
+  auto* request =
+      ::google::protobuf::Arena::Create<GetModelStatusRequest>(arena.get());
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
 
-  auto* response = ::google::protobuf::Arena::Create<GetModelStatusResponse>(&arena);
+  auto* response =
+      ::google::protobuf::Arena::Create<GetModelStatusResponse>(arena.get());
   TF_RETURN_IF_ERROR(
       GetModelStatusImpl::GetModelStatus(core_, *request, response));
   return ToJsonString(*response, output);
@@ -210,19 +352,20 @@ Status HttpRestApiHandler::ProcessModelMetadataRequest(
     return errors::InvalidArgument("Missing model name in request.");
   }
 
-  ::google::protobuf::Arena arena;
-
-  auto* request = ::google::protobuf::Arena::Create<GetModelMetadataRequest>(&arena);
-  // We currently only support the kSignatureDef metadata field
-  request->add_metadata_field(GetModelMetadataImpl::kSignatureDef);
+  // We currently only support the kSignatureDef metadata field, the JSON of
+  // which is serialized once per servable.
+  ModelSpec model_spec;
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
-      model_name, model_version, model_version_label,
-      request->mutable_model_spec()));
-
-  auto* response = ::google::protobuf::Arena::Create<GetModelMetadataResponse>(&arena);
-  TF_RETURN_IF_ERROR(
-      GetModelMetadataImpl::GetModelMetadata(core_, *request, response));
-  return ToJsonString(*response, output);
+      model_name, model_version, model_version_label, &model_spec));
+  std::shared_ptr<const string> json;
+  TF_RETURN_IF_ERROR(model_metadata_cache_.GetSerializedModelMetadata(
+      model_spec, "json",
+      [](const GetModelMetadataResponse& response, string* output) {
+        return ToJsonString(response, output);
+      },
+      &json));
+  *output = *json;
+  return OkStatus();
 }
 
 Status HttpRestApiHandler::GetInfoMap(
@@ -230,15 +373,9 @@ Status HttpRestApiHandler::GetInfoMap(
     ::google::protobuf::Map<string, tensorflow::TensorInfo>* infomap) {
   ServableHandle<SavedModelBundle> bundle;
   TF_RETURN_IF_ERROR(core_->GetServableHandle(model_spec, &bundle));
-  const string& signame =
-      signature_name.empty() ? kDefaultServingSignatureDefKey : signature_name;
-  auto iter = bundle->meta_graph_def.signature_def().find(signame);
-  if (iter == bundle->meta_graph_def.signature_def().end()) {
-    return errors::InvalidArgument("Serving signature name: \"", signame,
-                                   "\" not found in signature def");
-  }
-  *infomap = iter->second.inputs();
-  return absl::OkStatus();
+  return signature_inputs_cache_.GetInputs(
+      bundle.load_generation(), signature_name,
+      bundle->meta_graph_def.signature_def(), infomap);
 }
 
 }  // namespace serving
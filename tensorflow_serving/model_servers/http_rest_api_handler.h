@@ -24,9 +24,14 @@ limitations under the License.
 #include "absl/types/optional.h"
 #include "re2/re2.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow_serving/model_servers/http_rest_api_handler_base.h"
+#include "tensorflow_serving/model_servers/signature_inputs_cache.h"
+#include "tensorflow_serving/servables/tensorflow/get_model_metadata_impl.h"
+#include "tensorflow_serving/servables/tensorflow/util.h"
+#include "tensorflow_serving/util/json_tensor.h"
 
 namespace tensorflow {
 
@@ -75,7 +80,9 @@ class HttpRestApiHandler : public HttpRestApiHandlerBase {
 
   ~HttpRestApiHandler() override;
 
-  // Process a HTTP request.
+  // Process a HTTP request. Predict requests and responses are in JSON or, as
+  // chosen by the Content-Type and Accept headers, in the safetensors format
+  // (see util/safetensors.h).
   //
   // In case of errors, the `headers` and `output` are still relevant as they
   // contain detailed error messages, that can be relayed back to the client.
@@ -85,23 +92,37 @@ class HttpRestApiHandler : public HttpRestApiHandlerBase {
                         std::vector<std::pair<string, string>>* headers,
                         string* model_name, string* method,
                         string* output) override;
+  Status ProcessRequest(const absl::string_view http_method,
+                        const absl::string_view request_path,
+                        const absl::string_view request_body,
+                        const HttpRequestHeaders& request_headers,
+                        std::vector<std::pair<string, string>>* headers,
+                        string* model_name, string* method,
+                        string* output) override;
 
  private:
   Status ProcessClassifyRequest(
       const absl::string_view model_name,
       const absl::optional<int64_t>& model_version,
       const absl::optional<absl::string_view>& model_version_label,
-      const absl::string_view request_body, string* output);
+      const absl::string_view request_body,
+      JsonOutputFormat json_output_format, RequestStageTimer* timer,
+      string* output);
   Status ProcessRegressRequest(
       const absl::string_view model_name,
       const absl::optional<int64_t>& model_version,
       const absl::optional<absl::string_view>& model_version_label,
-      const absl::string_view request_body, string* output);
+      const absl::string_view request_body,
+      JsonOutputFormat json_output_format, RequestStageTimer* timer,
+      string* output);
   Status ProcessPredictRequest(
       const absl::string_view model_name,
       const absl::optional<int64_t>& model_version,
       const absl::optional<absl::string_view>& model_version_label,
-      const absl::string_view request_body, string* output);
+      const absl::string_view request_body, bool safetensors_request,
+      bool safetensors_response, JsonOutputFormat json_output_format,
+      HttpResponseBodyWriter* response_body_writer, RequestStageTimer* timer,
+      string* output);
   Status ProcessModelStatusRequest(
       const absl::string_view model_name,
       const absl::optional<int64_t>& model_version,
@@ -118,6 +139,10 @@ class HttpRestApiHandler : public HttpRestApiHandlerBase {
   RunOptions run_options_;
   ServerCore* core_;
   std::unique_ptr<TensorflowPredictor> predictor_;
+  // Decodes large JSON predict requests in parallel.
+  std::unique_ptr<thread::ThreadPool> json_decode_thread_pool_;
+  SignatureInputsCache signature_inputs_cache_;
+  ModelMetadataCache model_metadata_cache_;
 };
 
 }  // namespace serving
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_MODEL_SERVERS_HTTP_REST_API_HANDLER_BASE_H_
 #define TENSORFLOW_SERVING_MODEL_SERVERS_HTTP_REST_API_HANDLER_BASE_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
@@ -27,6 +28,34 @@ limitations under the License.
 namespace tensorflow {
 namespace serving {
 
+// Predict responses of at least this many bytes are streamed to the client in
+// chunks of kStreamedResponseChunkBytes, when the server supports it.
+constexpr size_t kMinStreamedResponseBytes = 1 << 20;
+constexpr size_t kStreamedResponseChunkBytes = 256 << 10;
+
+// Writes the body of a HTTP response to the client as it is produced.
+class HttpResponseBodyWriter {
+ public:
+  virtual ~HttpResponseBodyWriter() = default;
+
+  // Sends the next 'chunk' of the body. The first chunk starts an OK response
+  // with the response headers set so far, so once a chunk is written the
+  // status and headers can no longer change.
+  virtual void WriteChunk(absl::string_view chunk) = 0;
+};
+
+// The headers of a HTTP request that the handlers act on, and how the server
+// can send the response.
+struct HttpRequestHeaders {
+  // The media type of the request body.
+  absl::string_view content_type;
+  // The media types accepted for the response body.
+  absl::string_view accept;
+  // If set, large responses may be streamed through it instead of returned
+  // in 'output'.
+  HttpResponseBodyWriter* response_body_writer = nullptr;
+};
+
 // Base class of HttpRestApiHandler classes that handles HTTP/REST APIs of TF
 // serving.
 //
@@ -65,6 +94,19 @@ class HttpRestApiHandlerBase {
                                 std::vector<std::pair<string, string>>* headers,
                                 string* model_name, string* method,
                                 string* output) = 0;
+
+  // As above, for a request with `request_headers`. By default, they are
+  // ignored.
+  virtual Status ProcessRequest(const absl::string_view http_method,
+                                const absl::string_view request_path,
+                                const absl::string_view request_body,
+                                const HttpRequestHeaders& request_headers,
+                                std::vector<std::pair<string, string>>* headers,
+                                string* model_name, string* method,
+                                string* output) {
+    return ProcessRequest(http_method, request_path, request_body, headers,
+                          model_name, method, output);
+  }
 };
 
 }  // namespace serving
@@ -43,6 +43,7 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_source_adapter.pb.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 #include "tensorflow_serving/test_util/test_util.h"
+#include "tensorflow_serving/util/safetensors.h"
 
 namespace tensorflow {
 namespace serving {
@@ -383,6 +384,55 @@ TEST_F(HttpRestApiHandlerTest, Predict) {
                            (HeaderList){{"Content-Type", "application/json"}}));
 }
 
+TEST_F(HttpRestApiHandlerTest, PredictSafetensors) {
+  ::google::protobuf::Map<string, TensorProto> inputs;
+  inputs["x"] = test_util::CreateProto<TensorProto>(
+      "dtype: DT_FLOAT "
+      "tensor_shape { dim { size: 2 } } "
+      "float_val: 1.0 "
+      "float_val: 2.0 ");
+  string body;
+  TF_ASSERT_OK(MakeSafetensorsFromTensors(inputs, &body));
+  HttpRequestHeaders request_headers;
+  request_headers.content_type = kSafetensorsContentType;
+  request_headers.accept = kSafetensorsContentType;
+
+  HeaderList headers;
+  string model_name, method, output;
+  TF_ASSERT_OK(handler_.ProcessRequest(
+      "POST", absl::StrCat("/v1/models/", kTestModelName, ":predict"), body,
+      request_headers, &headers, &model_name, &method, &output));
+  EXPECT_THAT(headers,
+              UnorderedElementsAreArray(
+                  (HeaderList){{"Content-Type", kSafetensorsContentType}}));
+  PredictRequest outputs;
+  TF_ASSERT_OK(FillPredictRequestFromSafetensors(output, &outputs));
+  ASSERT_EQ(1, outputs.inputs().count("y"));
+  const TensorProto& y = outputs.inputs().at("y");
+  EXPECT_EQ(DT_FLOAT, y.dtype());
+  ASSERT_EQ(2 * sizeof(float), y.tensor_content().size());
+  float values[2];
+  memcpy(values, y.tensor_content().data(), sizeof(values));
+  EXPECT_EQ(2.5, values[0]);
+  EXPECT_EQ(3.0, values[1]);
+
+  // Safetensors inputs, with JSON outputs.
+  request_headers.accept = "application/json";
+  TF_ASSERT_OK(handler_.ProcessRequest(
+      "POST", absl::StrCat("/v1/models/", kTestModelName, ":predict"), body,
+      request_headers, &headers, &model_name, &method, &output));
+  TF_EXPECT_OK(CompareJson(output, R"({ "outputs": [2.5, 3.0] })"));
+  EXPECT_THAT(headers, UnorderedElementsAreArray(
+                           (HeaderList){{"Content-Type", "application/json"}}));
+
+  // Only predict requests take safetensors.
+  const Status status = handler_.ProcessRequest(
+      "POST", absl::StrCat("/v1/models/", kTestModelName, ":regress"), body,
+      request_headers, &headers, &model_name, &method, &output);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("Only predict requests"));
+}
+
 TEST_F(HttpRestApiHandlerTest, Regress) {
   HeaderList headers;
   string model_name, method, output;
@@ -417,6 +467,14 @@ TEST_F(HttpRestApiHandlerTest, Regress) {
   TF_EXPECT_OK(CompareJson(output, R"({ "results": [42] })"));
   EXPECT_THAT(headers, UnorderedElementsAreArray(
                            (HeaderList){{"Content-Type", "application/json"}}));
+
+  // Ask for compact JSON.
+  TF_EXPECT_OK(handler_.ProcessRequest(
+      "POST",
+      absl::StrCat("/v1/models/", kTestModelName, ":regress?pretty=false"),
+      R"({"signature_name": "regress_x_to_y", "examples": [ { "x": 80.0 } ] })",
+      &headers, &model_name, &method, &output));
+  EXPECT_EQ(R"({"results":[42.0]})", output);
 }
 
 TEST_F(HttpRestApiHandlerTest, Classify) {
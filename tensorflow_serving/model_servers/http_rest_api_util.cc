@@ -19,19 +19,135 @@ limitations under the License.
 #include <vector>
 
 #include "google/protobuf/util/json_util.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include <curl/curl.h>
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow_serving/servables/tensorflow/get_model_metadata_impl.h"
+#include "tensorflow_serving/util/safetensors.h"
 
 namespace tensorflow {
 namespace serving {
 
-const char* const kPredictionApiGegex =
-    R"((?i)/v1/models/([^/:]+)(?:(?:/versions/(\d+))|(?:/labels/([^/:]+)))?:(classify|regress|predict))";
-const char* const kModelStatusApiRegex =
-    R"((?i)/v1/models(?:/([^/:]+))?(?:(?:/versions/(\d+))|(?:/labels/([^/:]+)))?(?:\/(metadata))?)";
+namespace {
+
+// The paths are matched segment by segment rather than with regexes, as this
+// runs on every request. The grammar, matched case-insensitively, is
+//
+//   POST /v1/models/<name>[/versions/<digits>|/labels/<label>]:<verb>
+//   GET  /v1/models[/<name>][/versions/<digits>|/labels/<label>][/metadata]
+//
+// where names and labels are runs of characters other than '/' and ':'.
+
+// Consumes 'prefix' from the front of 'path', ignoring case.
+bool ConsumePrefix(absl::string_view prefix, absl::string_view* path) {
+  if (!absl::StartsWithIgnoreCase(*path, prefix)) {
+    return false;
+  }
+  path->remove_prefix(prefix.size());
+  return true;
+}
+
+// Consumes the longest non-empty run of characters of 'path' that are not '/'
+// or ':', or of digits if 'digits_only'.
+bool ConsumeSegment(bool digits_only, absl::string_view* path,
+                    absl::string_view* segment) {
+  size_t size = 0;
+  while (size < path->size() && (*path)[size] != '/' && (*path)[size] != ':' &&
+         (!digits_only || absl::ascii_isdigit((*path)[size]))) {
+    ++size;
+  }
+  if (size == 0) {
+    return false;
+  }
+  *segment = path->substr(0, size);
+  path->remove_prefix(size);
+  return true;
+}
+
+// Consumes an optional "/versions/<digits>" or "/labels/<label>". The segments
+// are greedy, so when they match there is no shorter match to fall back on
+// that the rest of the grammar could accept.
+void ConsumeVersionOrLabel(absl::string_view* path, absl::string_view* version,
+                           absl::string_view* label) {
+  absl::string_view rest = *path;
+  if (ConsumePrefix("/versions/", &rest) &&
+      ConsumeSegment(/*digits_only=*/true, &rest, version)) {
+    *path = rest;
+    return;
+  }
+  rest = *path;
+  if (ConsumePrefix("/labels/", &rest) &&
+      ConsumeSegment(/*digits_only=*/false, &rest, label)) {
+    *path = rest;
+  }
+}
+
+struct ModelPath {
+  absl::string_view model_name;
+  absl::string_view version;
+  absl::string_view label;
+  absl::string_view method;
+  absl::string_view subresource;
+};
+
+bool MatchPredictionApiPath(absl::string_view path, ModelPath* match) {
+  if (!ConsumePrefix("/v1/models/", &path) ||
+      !ConsumeSegment(/*digits_only=*/false, &path, &match->model_name)) {
+    return false;
+  }
+  ConsumeVersionOrLabel(&path, &match->version, &match->label);
+  if (!ConsumePrefix(":", &path)) {
+    return false;
+  }
+  for (const absl::string_view method :
+       {"classify", "regress", "predict", "predictStreamed"}) {
+    if (absl::EqualsIgnoreCase(path, method)) {
+      match->method = path;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Matches the rest of a model status path after the model name, if any.
+bool MatchModelStatusApiSuffix(absl::string_view path, ModelPath* match) {
+  ConsumeVersionOrLabel(&path, &match->version, &match->label);
+  if (path.empty()) {
+    return true;
+  }
+  if (absl::EqualsIgnoreCase(path, "/metadata")) {
+    match->subresource = path.substr(1);
+    return true;
+  }
+  return false;
+}
+
+bool MatchModelStatusApiPath(absl::string_view path, ModelPath* match) {
+  if (!ConsumePrefix("/v1/models", &path)) {
+    return false;
+  }
+  // A leading segment is the model name unless the rest only matches without
+  // one, e.g. "/versions/1", which is the version of no model in particular.
+  absl::string_view rest = path;
+  ModelPath named;
+  if (ConsumePrefix("/", &rest) &&
+      ConsumeSegment(/*digits_only=*/false, &rest, &named.model_name) &&
+      MatchModelStatusApiSuffix(rest, &named)) {
+    *match = named;
+    return true;
+  }
+  return MatchModelStatusApiSuffix(path, match);
+}
+
+}  // namespace
+
+bool IsRestApiPath(absl::string_view path) {
+  return absl::StartsWithIgnoreCase(path, "/v1/");
+}
 
 void AddHeaders(std::vector<std::pair<string, string>>* headers) {
   headers->push_back({"Content-Type", "application/json"});
@@ -43,6 +159,17 @@ void AddCORSHeaders(std::vector<std::pair<string, string>>* headers) {
   headers->push_back({"Access-Control-Allow-Headers", "Content-Type"});
 }
 
+void SetContentType(absl::string_view content_type,
+                    std::vector<std::pair<string, string>>* headers) {
+  for (auto& header : *headers) {
+    if (header.first == "Content-Type") {
+      header.second = string(content_type);
+      return;
+    }
+  }
+  headers->push_back({"Content-Type", string(content_type)});
+}
+
 Status FillModelSpecWithNameVersionAndLabel(
     const absl::string_view model_name,
     const absl::optional<int64_t>& model_version,
@@ -67,6 +194,10 @@ Status FillModelSpecWithNameVersionAndLabel(
 }
 
 bool DecodeArg(string* arg) {
+  if (arg->find('%') == string::npos) {
+    // Nothing is escaped, which is the common case.
+    return true;
+  }
   static const bool run_once ABSL_ATTRIBUTE_UNUSED = [&]() {
     curl_global_init(CURL_GLOBAL_ALL);
     return true;
@@ -87,6 +218,38 @@ bool DecodeArg(string* arg) {
   return false;
 }
 
+Status ParseRequestQuery(absl::string_view request_path,
+                         absl::string_view* path,
+                         JsonOutputFormat* json_output_format) {
+  const size_t query_start = request_path.find('?');
+  *path = request_path.substr(0, query_start);
+  if (query_start == absl::string_view::npos) {
+    return absl::OkStatus();
+  }
+  for (absl::string_view parameter : absl::StrSplit(
+           request_path.substr(query_start + 1), '&', absl::SkipEmpty())) {
+    std::pair<absl::string_view, absl::string_view> key_value =
+        absl::StrSplit(parameter, absl::MaxSplits('=', 1));
+    if (key_value.first != "pretty") {
+      continue;
+    }
+    if (key_value.second == "true") {
+      *json_output_format = JsonOutputFormat::kPretty;
+    } else if (key_value.second == "false") {
+      *json_output_format = JsonOutputFormat::kCompact;
+    } else {
+      return errors::InvalidArgument(
+          "Query parameter 'pretty' must be 'true' or 'false', got: '",
+          key_value.second, "'");
+    }
+  }
+  return absl::OkStatus();
+}
+
+bool HasSafetensorsMediaType(absl::string_view media_types) {
+  return absl::StrContainsIgnoreCase(media_types, kSafetensorsContentType);
+}
+
 Status ParseModelInfo(const absl::string_view http_method,
                       const absl::string_view request_path, string* model_name,
                       absl::optional<int64_t>* model_version,
@@ -96,14 +259,20 @@ Status ParseModelInfo(const absl::string_view http_method,
   string model_version_str;
   string model_version_label_str;
   // Parse request parameters
-  if (http_method == "POST") {
-    *parse_successful =
-        RE2::FullMatch(string(request_path), kPredictionApiGegex, model_name,
-                       &model_version_str, &model_version_label_str, method);
-  } else if (http_method == "GET") {
-    *parse_successful = RE2::FullMatch(
-        string(request_path), kModelStatusApiRegex, model_name,
-        &model_version_str, &model_version_label_str, model_subresource);
+  ModelPath match;
+  *parse_successful = false;
+  if (http_method == "POST" && MatchPredictionApiPath(request_path, &match)) {
+    *method = string(match.method);
+    *parse_successful = true;
+  } else if (http_method == "GET" &&
+             MatchModelStatusApiPath(request_path, &match)) {
+    *model_subresource = string(match.subresource);
+    *parse_successful = true;
+  }
+  if (*parse_successful) {
+    *model_name = string(match.model_name);
+    model_version_str = string(match.version);
+    model_version_label_str = string(match.label);
   }
   if (!model_name->empty()) {
     if (!DecodeArg(model_name)) {
@@ -26,22 +26,46 @@ limitations under the License.
 #include "tensorflow_serving/apis/get_model_metadata.pb.h"
 #include "tensorflow_serving/apis/get_model_status.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
+#include "tensorflow_serving/util/json_tensor.h"
 
 namespace tensorflow {
 namespace serving {
 
 const char* const kHTTPRestApiHandlerPathRegex = "(?i)/v1/.*";
 
+// The media type of streamed predict responses, sent as server-sent events.
+const char* const kEventStreamContentType = "text/event-stream";
+
+// Returns whether 'path' matches kHTTPRestApiHandlerPathRegex, without the
+// cost of a regex.
+bool IsRestApiPath(absl::string_view path);
+
 void AddHeaders(std::vector<std::pair<string, string>>* headers);
 
 void AddCORSHeaders(std::vector<std::pair<string, string>>* headers);
 
+// Sets the Content-Type of `headers`, as added by AddHeaders().
+void SetContentType(absl::string_view content_type,
+                    std::vector<std::pair<string, string>>* headers);
+
 Status FillModelSpecWithNameVersionAndLabel(
     const absl::string_view model_name,
     const absl::optional<int64_t>& model_version,
     const absl::optional<absl::string_view> model_version_label,
     ::tensorflow::serving::ModelSpec* model_spec);
 
+// Splits the query (after '?') off `request_path` into `path`. If the query
+// has a `pretty` parameter, "true" or "false", sets `json_output_format` to
+// kPretty or kCompact respectively, and leaves it as is otherwise. Other
+// query parameters are ignored.
+Status ParseRequestQuery(absl::string_view request_path,
+                         absl::string_view* path,
+                         JsonOutputFormat* json_output_format);
+
+// Returns whether `media_types`, a Content-Type or Accept header value, names
+// the safetensors body format.
+bool HasSafetensorsMediaType(absl::string_view media_types);
+
 // Parse model information from the request.
 Status ParseModelInfo(const absl::string_view http_method,
                       const absl::string_view request_path, string* model_name,
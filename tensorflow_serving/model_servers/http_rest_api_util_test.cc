@@ -19,6 +19,7 @@ limitations under the License.
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow_serving/test_util/test_util.h"
 
@@ -115,6 +116,63 @@ TEST_F(HttpRestApiUtilTest, TestParseModelInfoForGet) {
                               &model_name, &model_version, &model_version_label,
                               &method, &model_subresource, &parse_successful));
   EXPECT_FALSE(parse_successful);
+
+  // A leading segment is only the model name if the rest of the path matches
+  // after it.
+  model_version.reset();
+  TF_EXPECT_OK(ParseModelInfo("GET", "/v1/models/versions/3", &model_name,
+                              &model_version, &model_version_label, &method,
+                              &model_subresource, &parse_successful));
+  EXPECT_TRUE(parse_successful);
+  EXPECT_EQ(model_name, "");
+  EXPECT_EQ(model_version.value(), 3);
+  TF_EXPECT_OK(ParseModelInfo("GET", "/V1/Models/metadata", &model_name,
+                              &model_version, &model_version_label, &method,
+                              &model_subresource, &parse_successful));
+  EXPECT_TRUE(parse_successful);
+  EXPECT_EQ(model_name, "metadata");
+  EXPECT_EQ(model_subresource, "");
+}
+
+TEST_F(HttpRestApiUtilTest, TestIsRestApiPath) {
+  EXPECT_TRUE(IsRestApiPath("/v1/models"));
+  EXPECT_TRUE(IsRestApiPath("/V1/models/m:predict"));
+  EXPECT_FALSE(IsRestApiPath("/v1"));
+  EXPECT_FALSE(IsRestApiPath("/statuspage"));
+}
+
+TEST_F(HttpRestApiUtilTest, TestParseRequestQuery) {
+  absl::string_view path;
+  JsonOutputFormat format = JsonOutputFormat::kPretty;
+  TF_EXPECT_OK(ParseRequestQuery("/v1/models/m:predict", &path, &format));
+  EXPECT_EQ("/v1/models/m:predict", path);
+  EXPECT_EQ(JsonOutputFormat::kPretty, format);
+
+  TF_EXPECT_OK(ParseRequestQuery("/v1/models/m:predict?other=1&pretty=false",
+                                 &path, &format));
+  EXPECT_EQ("/v1/models/m:predict", path);
+  EXPECT_EQ(JsonOutputFormat::kCompact, format);
+
+  // Without the parameter, the format is left as is.
+  TF_EXPECT_OK(ParseRequestQuery("/v1/models/m?", &path, &format));
+  EXPECT_EQ("/v1/models/m", path);
+  EXPECT_EQ(JsonOutputFormat::kCompact, format);
+
+  TF_EXPECT_OK(ParseRequestQuery("/v1/models/m?pretty=true", &path, &format));
+  EXPECT_EQ(JsonOutputFormat::kPretty, format);
+
+  const Status status =
+      ParseRequestQuery("/v1/models/m?pretty", &path, &format);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("'pretty' must be"));
+}
+
+TEST_F(HttpRestApiUtilTest, TestHasSafetensorsMediaType) {
+  EXPECT_TRUE(HasSafetensorsMediaType("application/x-safetensors"));
+  EXPECT_TRUE(HasSafetensorsMediaType(
+      "application/json;q=0.5, Application/X-Safetensors"));
+  EXPECT_FALSE(HasSafetensorsMediaType("application/json"));
+  EXPECT_FALSE(HasSafetensorsMediaType(""));
 }
 
 TEST_F(HttpRestApiUtilTest, TestParseModelInfoForPost) {
@@ -21,22 +21,34 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "re2/re2.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
 #include "tensorflow_serving/model_servers/http_rest_api_handler.h"
 #include "tensorflow_serving/model_servers/http_rest_api_util.h"
 #include "tensorflow_serving/model_servers/server_core.h"
 #include "tensorflow_serving/model_servers/server_init.h"
+#include "tensorflow_serving/servables/tensorflow/slow_requests.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
+#include "tensorflow_serving/util/cpu_profiler.h"
+#include "tensorflow_serving/util/memory_accounting.h"
 #include "tensorflow_serving/util/net_http/public/response_code_enum.h"
 #include "tensorflow_serving/util/net_http/server/public/httpserver.h"
 #include "tensorflow_serving/util/net_http/server/public/server_request_interface.h"
 #include "tensorflow_serving/util/prometheus_exporter.h"
+#include "tensorflow_serving/util/request_trace.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
 #include "tensorflow_serving/util/threadpool_executor.h"
+#include "tensorflow_serving/util/work_stealing_executor.h"
 
 namespace tensorflow {
 namespace serving {
@@ -100,7 +112,11 @@ void ProcessPrometheusRequest(PrometheusExporter* exporter, const string& path,
                         absl::StatusCode::kInvalidArgument),
                     output);
   } else {
-    status = exporter->GeneratePage(&output);
+    // Refreshes the saturation gauges, which are sampled on demand.
+    SaturationMonitor::Global()->Sample();
+    // Written as it's rendered, without first joining the whole page.
+    status = exporter->WritePage(
+        [req](absl::string_view piece) { req->WriteResponseString(piece); });
   }
   const net_http::HTTPStatusCode http_status = ToHTTPStatusCode(status);
   // Note: we add headers+output for non successful status too, in case the
@@ -116,21 +132,186 @@ void ProcessPrometheusRequest(PrometheusExporter* exporter, const string& path,
   req->ReplyWithStatus(http_status);
 }
 
+constexpr char kDefaultCpuProfilerPath[] = "/monitoring/profile/cpu";
+
+// Takes a CPU profile as asked by the query parameters of 'req' (see
+// CpuProfilerConfig), holding an executor thread for as long as it samples.
+void ProcessCpuProfileRequest(net_http::ServerRequestInterface* req) {
+  CpuProfileOptions options;
+  bool pprof = false;
+  Status status;
+  const absl::string_view uri = req->uri_path();
+  const size_t query_start = uri.find('?');
+  if (query_start != absl::string_view::npos) {
+    for (absl::string_view param : absl::StrSplit(
+             uri.substr(query_start + 1), '&', absl::SkipEmpty())) {
+      const std::pair<absl::string_view, absl::string_view> kv =
+          absl::StrSplit(param, absl::MaxSplits('=', 1));
+      int64_t value;
+      if (kv.first == "seconds" && absl::SimpleAtoi(kv.second, &value) &&
+          value > 0 && value <= 300) {
+        options.duration_micros = value * 1000 * 1000;
+      } else if (kv.first == "hz" && absl::SimpleAtoi(kv.second, &value) &&
+                 value > 0 && value <= 10000) {
+        options.frequency_hz = value;
+      } else if (kv.first == "format" &&
+                 (kv.second == "folded" || kv.second == "pprof")) {
+        pprof = kv.second == "pprof";
+      } else {
+        status = errors::InvalidArgument("Invalid query parameter: ", param);
+        break;
+      }
+    }
+  }
+  CpuProfile profile;
+  if (status.ok()) {
+    status = ProfileCpu(options, &profile);
+  }
+  if (status.ok()) {
+    if (profile.num_dropped > 0) {
+      LOG(WARNING) << "Dropped " << profile.num_dropped
+                   << " samples of the CPU profile";
+    }
+    req->OverwriteResponseHeader(
+        "Content-Type", pprof ? "application/octet-stream" : "text/plain");
+    req->WriteResponseBuffer(pprof ? CpuProfileToPprof(profile)
+                                   : CpuProfileToFoldedStacks(profile));
+  } else {
+    req->OverwriteResponseHeader("Content-Type", "text/plain");
+    req->WriteResponseString(status.ToString());
+    VLOG(1) << "Error processing CPU profile request. Error: "
+            << status.ToString();
+  }
+  req->ReplyWithStatus(ToHTTPStatusCode(status));
+}
+
+constexpr char kSlowRequestsPath[] = "/monitoring/slow_requests";
+
+// Serves the requests captured by SlowRequests. Without a 'model' query
+// parameter, lists the models with captured requests and how many each has.
+// With one, returns the requests of the model as PredictionLogs: in text
+// format, or with 'format=tfrecord' as a TFRecord file for the replay mode of
+// the load generator.
+void ProcessSlowRequestsRequest(net_http::ServerRequestInterface* req) {
+  string model_name;
+  bool tfrecord = false;
+  Status status;
+  const absl::string_view uri = req->uri_path();
+  const size_t query_start = uri.find('?');
+  if (query_start != absl::string_view::npos) {
+    for (absl::string_view param : absl::StrSplit(
+             uri.substr(query_start + 1), '&', absl::SkipEmpty())) {
+      const std::pair<absl::string_view, absl::string_view> kv =
+          absl::StrSplit(param, absl::MaxSplits('=', 1));
+      if (kv.first == "model" && !kv.second.empty()) {
+        model_name = string(kv.second);
+      } else if (kv.first == "format" &&
+                 (kv.second == "text" || kv.second == "tfrecord")) {
+        tfrecord = kv.second == "tfrecord";
+      } else {
+        status = errors::InvalidArgument("Invalid query parameter: ", param);
+        break;
+      }
+    }
+  }
+  if (!status.ok()) {
+    req->OverwriteResponseHeader("Content-Type", "text/plain");
+    req->WriteResponseString(status.ToString());
+    req->ReplyWithStatus(ToHTTPStatusCode(status));
+    return;
+  }
+
+  if (model_name.empty()) {
+    req->OverwriteResponseHeader("Content-Type", "text/plain");
+    for (const auto& model : SlowRequests::Global()->GetModels()) {
+      req->WriteResponseString(
+          absl::StrCat(model.first, " ", model.second, "\n"));
+    }
+  } else if (tfrecord) {
+    req->OverwriteResponseHeader("Content-Type", "application/octet-stream");
+    for (const tstring& record :
+         SlowRequests::Global()->GetRecords(model_name)) {
+      char header[io::RecordWriter::kHeaderSize];
+      char footer[io::RecordWriter::kFooterSize];
+      io::RecordWriter::PopulateHeader(header, record.data(), record.size());
+      io::RecordWriter::PopulateFooter(footer, record.data(), record.size());
+      req->WriteResponseBytes(header, sizeof(header));
+      req->WriteResponseBytes(record.data(), record.size());
+      req->WriteResponseBytes(footer, sizeof(footer));
+    }
+  } else {
+    req->OverwriteResponseHeader("Content-Type", "text/plain");
+    for (const tstring& record :
+         SlowRequests::Global()->GetRecords(model_name)) {
+      PredictionLog log;
+      if (log.ParseFromArray(record.data(), record.size())) {
+        req->WriteResponseString(absl::StrCat(log.DebugString(), "\n"));
+      }
+    }
+  }
+  req->ReplyWithStatus(net_http::HTTPStatusCode::OK);
+}
+
 class RequestExecutor final : public net_http::EventExecutor {
  public:
-  explicit RequestExecutor(int num_threads)
-      : executor_(Env::Default(), "httprestserver", num_threads) {}
+  RequestExecutor(int num_threads, bool work_stealing) {
+    if (work_stealing) {
+      executor_ = absl::make_unique<WorkStealingExecutor>(
+          Env::Default(), "httprestserver", num_threads);
+    } else {
+      executor_ = absl::make_unique<ThreadPoolExecutor>(
+          Env::Default(), "httprestserver", num_threads);
+    }
+  }
+
+  void Schedule(std::function<void()> fn) override {
+    executor_->Schedule(std::move(fn));
+  }
+
+ private:
+  std::unique_ptr<Executor> executor_;
+};
+
+// Streams a response body to 'req', starting the response on the first chunk.
+class ChunkedResponseBodyWriter final : public HttpResponseBodyWriter {
+ public:
+  ChunkedResponseBodyWriter(net_http::ServerRequestInterface* req,
+                            const std::vector<std::pair<string, string>>*
+                                headers,
+                            bool enable_cors_support)
+      : req_(req),
+        headers_(headers),
+        enable_cors_support_(enable_cors_support) {}
+
+  void WriteChunk(absl::string_view chunk) override {
+    if (!started_) {
+      std::vector<std::pair<string, string>> headers = *headers_;
+      if (enable_cors_support_) {
+        AddCORSHeaders(&headers);
+      }
+      for (const auto& kv : headers) {
+        req_->OverwriteResponseHeader(kv.first, kv.second);
+      }
+      started_ = true;
+    }
+    req_->WriteResponseString(chunk);
+    req_->PartialReply();
+  }
 
-  void Schedule(std::function<void()> fn) override { executor_.Schedule(fn); }
+  // Whether any of the response has been sent.
+  bool started() const { return started_; }
 
  private:
-  ThreadPoolExecutor executor_;
+  net_http::ServerRequestInterface* const req_;
+  const std::vector<std::pair<string, string>>* const headers_;
+  const bool enable_cors_support_;
+  bool started_ = false;
 };
 
 class RestApiRequestDispatcher {
  public:
   RestApiRequestDispatcher(int timeout_in_ms, ServerCore* core)
-      : regex_(HttpRestApiHandler::kPathRegex), core_(core) {
+      : core_(core) {
     auto* tf_serving_registry = tensorflow::serving::init::
         TensorflowServingFunctionRegistration::GetRegistry();
     handler_ =
@@ -138,7 +319,7 @@ class RestApiRequestDispatcher {
   }
 
   net_http::RequestHandler Dispatch(net_http::ServerRequestInterface* req) {
-    if (RE2::FullMatch(string(req->uri_path()), regex_)) {
+    if (IsRestApiPath(req->uri_path())) {
       return [this](net_http::ServerRequestInterface* req) {
         this->ProcessRequest(req);
       };
@@ -151,13 +332,15 @@ class RestApiRequestDispatcher {
  private:
   void ProcessRequest(net_http::ServerRequestInterface* req) {
     const uint64_t start = Env::Default()->NowMicros();
-    string body;
-    int64_t num_bytes = 0;
-    auto request_chunk = req->ReadRequestBytes(&num_bytes);
-    while (request_chunk != nullptr) {
-      absl::StrAppend(&body, absl::string_view(request_chunk.get(), num_bytes));
-      request_chunk = req->ReadRequestBytes(&num_bytes);
-    }
+    ScopedSpan span(RequestTracer::Global(),
+                    req->GetRequestHeader("traceparent"), "REST");
+    span.AddAttribute("http.method", req->http_method());
+    span.AddAttribute("http.target", req->uri_path());
+    // Parsed in place, rather than copied out a block at a time.
+    const absl::string_view body = req->ReadRequestBody();
+    // The request body and the response are buffers of the JSON subsystem
+    // until the response is written.
+    MemoryCharge json_memory(MemorySubsystem::kJson, body.size());
 
     std::vector<std::pair<string, string>> headers;
     string model_name;
@@ -166,8 +349,14 @@ class RestApiRequestDispatcher {
     VLOG(1) << "Processing HTTP request: " << req->http_method() << " "
             << req->uri_path() << " body: " << body.size() << " bytes.";
 
+    ChunkedResponseBodyWriter body_writer(req, &headers,
+                                          core_->enable_cors_support());
     Status status;
-    if (req->http_method() == "OPTIONS") {
+    if (req->request_body_status() ==
+        net_http::ServerRequestInterface::BodyStatus::FAILED) {
+      // E.g. a gzipped body that fails to uncompress.
+      status = errors::InvalidArgument("Failed to read the request body");
+    } else if (req->http_method() == "OPTIONS") {
       absl::string_view origin_header = req->GetRequestHeader("Origin");
       if (RE2::PartialMatch(origin_header, "https?://")) {
         status = absl::OkStatus();
@@ -176,9 +365,30 @@ class RestApiRequestDispatcher {
             "Origin header is missing in CORS preflight");
       }
     } else {
-      status =
-          handler_->ProcessRequest(req->http_method(), req->uri_path(), body,
-                                   &headers, &model_name, &method, &output);
+      HttpRequestHeaders request_headers;
+      request_headers.content_type = req->GetRequestHeader("Content-Type");
+      request_headers.accept = req->GetRequestHeader("Accept");
+      request_headers.response_body_writer = &body_writer;
+      status = handler_->ProcessRequest(req->http_method(), req->uri_path(),
+                                        body, request_headers, &headers,
+                                        &model_name, &method, &output);
+      span.AddAttribute("model_name", model_name);
+      json_memory.Add(output.size());
+    }
+    if (body_writer.started()) {
+      // The OK status and the headers are already sent, so an error can only
+      // cut the response short.
+      if (status.ok()) {
+        RecordRequestLatency(model_name, /*api=*/method, /*entrypoint=*/"REST",
+                             Env::Default()->NowMicros() - start);
+      } else {
+        LOG(ERROR) << "Error streaming HTTP/REST response: "
+                   << req->http_method() << " " << req->uri_path()
+                   << " Error: " << status.ToString();
+      }
+      RecordModelRequestCount(model_name, status);
+      req->ReplyWithStatus(net_http::HTTPStatusCode::OK);
+      return;
     }
     if (core_->enable_cors_support()) {
       AddCORSHeaders(&headers);
@@ -190,7 +400,8 @@ class RestApiRequestDispatcher {
     for (const auto& kv : headers) {
       req->OverwriteResponseHeader(kv.first, kv.second);
     }
-    req->WriteResponseString(output);
+    // Handed over rather than copied, as predict responses can be large.
+    req->WriteResponseBuffer(std::move(output));
     if (http_status == net_http::HTTPStatusCode::OK) {
       RecordRequestLatency(model_name, /*api=*/method, /*entrypoint=*/"REST",
                            Env::Default()->NowMicros() - start);
@@ -202,7 +413,6 @@ class RestApiRequestDispatcher {
     req->ReplyWithStatus(http_status);
   }
 
-  const RE2 regex_;
   ServerCore* core_;
   std::unique_ptr<HttpRestApiHandlerBase> handler_;
 };
@@ -210,11 +420,27 @@ class RestApiRequestDispatcher {
 }  // namespace
 
 std::unique_ptr<net_http::HTTPServerInterface> CreateAndStartHttpServer(
-    int port, int num_threads, int timeout_in_ms,
+    int port, int http2_port, int num_threads, bool work_stealing,
+    int num_event_loops, bool reuse_port,
+    int timeout_in_ms, int idle_timeout_in_ms,
+    int64_t max_requests_per_connection,
     const MonitoringConfig& monitoring_config, ServerCore* core) {
   auto options = absl::make_unique<net_http::ServerOptions>();
   options->AddPort(static_cast<uint32_t>(port));
-  options->SetExecutor(absl::make_unique<RequestExecutor>(num_threads));
+  if (http2_port != 0) {
+    options->SetHttp2Port(http2_port);
+  }
+  options->SetNumEventLoops(num_event_loops);
+  options->SetReusePort(reuse_port);
+  if (idle_timeout_in_ms > 0) {
+    options->SetConnectionTimeout(absl::Milliseconds(idle_timeout_in_ms));
+  }
+  options->SetMaxRequestsPerConnection(max_requests_per_connection);
+  // Each event loop holds a thread of the executor. The single loop of old
+  // has always shared 'num_threads', so only the others add threads.
+  options->SetExecutor(
+      absl::make_unique<RequestExecutor>(num_threads + num_event_loops - 1,
+                                         work_stealing));
 
   auto server = net_http::CreateEvHTTPServer(std::move(options));
   if (server == nullptr) {
@@ -238,6 +464,27 @@ std::unique_ptr<net_http::HTTPServerInterface> CreateAndStartHttpServer(
         prometheus_request_options);
   }
 
+  // Register handler for the CPU profiler endpoint.
+  if (monitoring_config.cpu_profiler_config().enable()) {
+    const string& path = monitoring_config.cpu_profiler_config().path();
+    server->RegisterRequestHandler(
+        path.empty() ? kDefaultCpuProfilerPath : path,
+        [](net_http::ServerRequestInterface* req) {
+          ProcessCpuProfileRequest(req);
+        },
+        net_http::RequestHandlerOptions());
+  }
+
+  // Register handler for the requests captured as slow.
+  if (SlowRequests::Global()->enabled()) {
+    server->RegisterRequestHandler(
+        kSlowRequestsPath,
+        [](net_http::ServerRequestInterface* req) {
+          ProcessSlowRequestsRequest(req);
+        },
+        net_http::RequestHandlerOptions());
+  }
+
   std::shared_ptr<RestApiRequestDispatcher> dispatcher =
       std::make_shared<RestApiRequestDispatcher>(timeout_in_ms, core);
   net_http::RequestHandlerOptions handler_options;
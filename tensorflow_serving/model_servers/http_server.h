@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_MODEL_SERVERS_HTTP_SERVER_H_
 #define TENSORFLOW_SERVING_MODEL_SERVERS_HTTP_SERVER_H_
 
+#include <cstdint>
 #include <memory>
 
 #include "tensorflow_serving/config/monitoring_config.pb.h"
@@ -28,10 +29,22 @@ class ServerCore;
 // Returns a HTTP Server that has following endpoints:
 //
 //   o HTTP/REST API (under /v1/models/...)
+//   o Prometheus metrics and the sampling CPU profiler, if enabled in
+//     'monitoring_config'
 //
-// The returned server is in a state of accepting new requests.
+// The returned server is in a state of accepting new requests. Its
+// 'num_event_loops' event loops share the port and do the socket I/O, and
+// 'num_threads' threads run the handlers. Keep-alive connections are closed
+// after 'idle_timeout_in_ms' of inactivity (0 for the libevent default), or
+// after 'max_requests_per_connection' requests (0 for no limit). If
+// 'http2_port' is not 0, HTTP/2 over cleartext (h2c, with prior knowledge) is
+// served on it too. With 'reuse_port', the port is bound with SO_REUSEPORT so
+// that other processes can listen on it too.
 std::unique_ptr<net_http::HTTPServerInterface> CreateAndStartHttpServer(
-    int port, int num_threads, int timeout_in_ms,
+    int port, int http2_port, int num_threads, bool work_stealing,
+    int num_event_loops, bool reuse_port,
+    int timeout_in_ms, int idle_timeout_in_ms,
+    int64_t max_requests_per_connection,
     const MonitoringConfig& monitoring_config, ServerCore* core);
 
 }  // namespace serving
@@ -0,0 +1,327 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/load_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Values below this each have a bucket of their own.
+constexpr int kNumLinearBuckets = 128;
+
+// The number of buckets per power of two above kNumLinearBuckets.
+constexpr int kSubBucketBits = 6;
+constexpr int kNumSubBuckets = 1 << kSubBucketBits;
+
+// Enough powers of two for any non-negative int64.
+constexpr int kNumBuckets = kNumLinearBuckets + 56 * kNumSubBuckets;
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() : counts_(kNumBuckets, 0) {}
+
+int LatencyHistogram::BucketIndex(const int64_t micros) {
+  if (micros < kNumLinearBuckets) {
+    return std::max<int64_t>(micros, 0);
+  }
+  // The top kSubBucketBits + 1 bits of the value pick its bucket.
+  const int shift = Log2Floor64(micros) - kSubBucketBits;
+  const int sub_bucket = (micros >> shift) - kNumSubBuckets;
+  return kNumLinearBuckets + (shift - 1) * kNumSubBuckets + sub_bucket;
+}
+
+int64_t LatencyHistogram::BucketUpperBound(const int index) {
+  if (index < kNumLinearBuckets) {
+    return index;
+  }
+  const int shift = (index - kNumLinearBuckets) / kNumSubBuckets + 1;
+  const int64_t sub_bucket =
+      (index - kNumLinearBuckets) % kNumSubBuckets + kNumSubBuckets;
+  return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::Add(int64_t micros) {
+  micros = std::max<int64_t>(micros, 0);
+  ++counts_[BucketIndex(micros)];
+  min_ = count_ == 0 ? micros : std::min(min_, micros);
+  max_ = std::max(max_, micros);
+  sum_ += micros;
+  ++count_;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  if (other.count_ == 0) {
+    return;
+  }
+  for (int i = 0; i < kNumBuckets; ++i) {
+    counts_[i] += other.counts_[i];
+  }
+  min_ = count_ == 0 ? other.min_ : std::min(min_, other.min_);
+  max_ = std::max(max_, other.max_);
+  sum_ += other.sum_;
+  count_ += other.count_;
+}
+
+int64_t LatencyHistogram::Percentile(const double percentile) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  const int64_t rank = std::max<int64_t>(
+      1, std::ceil(std::min(std::max(percentile, 0.0), 100.0) / 100 * count_));
+  int64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(BucketUpperBound(i), max_);
+    }
+  }
+  return max_;
+}
+
+double LoadGeneratorResult::Throughput() const {
+  return elapsed_micros == 0 ? 0 : 1e6 * num_ok / elapsed_micros;
+}
+
+string LoadGeneratorResult::DebugString() const {
+  int64_t total_errors = 0;
+  string errors_by_code;
+  for (const auto& entry : num_errors) {
+    total_errors += entry.second;
+    absl::StrAppend(&errors_by_code, errors_by_code.empty() ? " (" : ", ",
+                    error::Code_Name(entry.first), ": ", entry.second);
+  }
+  if (!errors_by_code.empty()) {
+    errors_by_code += ")";
+  }
+  return absl::StrCat(
+      "Requests: ", num_ok, " ok, ", total_errors, " failed", errors_by_code,
+      "\n",
+      absl::StrFormat("Throughput: %.1f requests/s over %.3f s\n",
+                      Throughput(), elapsed_micros / 1e6),
+      absl::StrFormat("Latency (us): min %d mean %.1f p50 %d p90 %d p99 %d "
+                      "p99.9 %d max %d\n",
+                      latency.min(), latency.mean(), latency.Percentile(50),
+                      latency.Percentile(90), latency.Percentile(99),
+                      latency.Percentile(99.9), latency.max()));
+}
+
+Status RunLoadGenerator(const LoadGeneratorOptions& options,
+                        const std::vector<PredictionLog>& requests,
+                        const LoadRequestSender& sender,
+                        LoadGeneratorResult* result) {
+  using Mode = LoadGeneratorOptions::Mode;
+  if (requests.empty()) {
+    return errors::InvalidArgument("There are no requests to send");
+  }
+  if (options.mode == Mode::kClosedLoop && options.concurrency < 1) {
+    return errors::InvalidArgument("concurrency must be positive; was ",
+                                   options.concurrency);
+  }
+  if (options.mode == Mode::kPoisson && !(options.qps > 0)) {
+    return errors::InvalidArgument("qps must be positive; was ", options.qps);
+  }
+  if (options.mode == Mode::kTraceReplay && !(options.trace_speedup > 0)) {
+    return errors::InvalidArgument("trace_speedup must be positive; was ",
+                                   options.trace_speedup);
+  }
+  std::vector<int64_t> trace_offsets_micros;
+  if (options.mode == Mode::kTraceReplay) {
+    TF_RETURN_IF_ERROR(
+        ComputeTraceOffsetsMicros(requests, &trace_offsets_micros));
+  }
+
+  int64_t num_requests = options.num_requests;
+  if (options.mode == Mode::kTraceReplay) {
+    num_requests = num_requests > 0
+                       ? std::min<int64_t>(num_requests, requests.size())
+                       : requests.size();
+  } else if (num_requests <= 0 && options.duration_micros <= 0) {
+    num_requests = requests.size();
+  }
+
+  *result = LoadGeneratorResult();
+  mutex mu;
+  condition_variable in_flight_changed;
+  int64_t num_in_flight = 0;
+  int64_t last_done_micros = 0;
+
+  Env* const env = options.env;
+  std::mt19937_64 random(options.seed);
+  std::exponential_distribution<double> interval_micros(options.qps / 1e6);
+  double next_arrival_micros = 0;
+  const uint64_t start_micros = env->NowMicros();
+  for (int64_t i = 0; num_requests <= 0 || i < num_requests; ++i) {
+    uint64_t due_micros;
+    if (options.mode == Mode::kClosedLoop) {
+      {
+        mutex_lock l(mu);
+        while (num_in_flight >= options.concurrency) {
+          in_flight_changed.wait(l);
+        }
+      }
+      due_micros = env->NowMicros();
+    } else if (options.mode == Mode::kPoisson) {
+      next_arrival_micros += interval_micros(random);
+      due_micros = start_micros + next_arrival_micros;
+    } else {
+      due_micros =
+          start_micros + trace_offsets_micros[i] / options.trace_speedup;
+    }
+    if (options.duration_micros > 0 &&
+        due_micros - start_micros >=
+            static_cast<uint64_t>(options.duration_micros)) {
+      break;
+    }
+    const uint64_t now_micros = env->NowMicros();
+    if (due_micros > now_micros) {
+      env->SleepForMicroseconds(due_micros - now_micros);
+    }
+    {
+      mutex_lock l(mu);
+      ++num_in_flight;
+    }
+    sender(i % requests.size(), [&, due_micros](const Status& status) {
+      const uint64_t done_micros = env->NowMicros();
+      mutex_lock l(mu);
+      if (status.ok()) {
+        ++result->num_ok;
+        result->latency.Add(done_micros - due_micros);
+      } else {
+        ++result->num_errors[static_cast<error::Code>(status.code())];
+      }
+      last_done_micros = std::max<int64_t>(last_done_micros, done_micros);
+      --num_in_flight;
+      in_flight_changed.notify_all();
+    });
+  }
+
+  mutex_lock l(mu);
+  while (num_in_flight > 0) {
+    in_flight_changed.wait(l);
+  }
+  result->elapsed_micros =
+      std::max<int64_t>(last_done_micros - start_micros, 0);
+  return OkStatus();
+}
+
+Status ReplayRequests(const std::vector<PredictionLog>& requests,
+                      const int repetitions, const LoadRequestSender& sender,
+                      Env* const env, std::vector<ReplayedRequest>* replayed) {
+  if (repetitions < 1) {
+    return errors::InvalidArgument("repetitions must be positive; was ",
+                                   repetitions);
+  }
+  replayed->clear();
+  replayed->resize(requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    ReplayedRequest* const request = &(*replayed)[i];
+    if (requests[i].log_metadata().has_latency()) {
+      request->logged_latency_micros =
+          requests[i].log_metadata().latency().total_micros();
+    }
+    for (int repetition = 0; repetition < repetitions; ++repetition) {
+      Notification done;
+      Status status;
+      const uint64_t start_micros = env->NowMicros();
+      sender(i, [&](const Status& s) {
+        status = s;
+        done.Notify();
+      });
+      done.WaitForNotification();
+      if (status.ok()) {
+        request->latencies_micros.push_back(env->NowMicros() - start_micros);
+      } else if (request->status.ok()) {
+        request->status = status;
+      }
+    }
+  }
+  return OkStatus();
+}
+
+Status ReadPredictionLogs(const string& path, const int64_t max_logs,
+                          std::vector<PredictionLog>* logs) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(path, &file));
+  io::SequentialRecordReader reader(file.get());
+  logs->clear();
+  tstring record;
+  while (max_logs <= 0 || static_cast<int64_t>(logs->size()) < max_logs) {
+    const Status status = reader.ReadRecord(&record);
+    if (errors::IsOutOfRange(status)) {
+      break;
+    }
+    TF_RETURN_IF_ERROR(status);
+    logs->emplace_back();
+    if (!logs->back().ParseFromArray(record.data(), record.size())) {
+      return errors::InvalidArgument("Failed to parse PredictionLog ",
+                                     logs->size() - 1, " of ", path);
+    }
+  }
+  return OkStatus();
+}
+
+Status ComputeTraceOffsetsMicros(const std::vector<PredictionLog>& logs,
+                                 std::vector<int64_t>* offsets_micros) {
+  offsets_micros->clear();
+  if (logs.empty()) {
+    return OkStatus();
+  }
+  const auto timestamp_secs = [&logs](size_t i) -> int64_t {
+    return logs[i].log_metadata().timestamp_secs();
+  };
+  const int64_t first_secs = timestamp_secs(0);
+  size_t second_begin = 0;
+  while (second_begin < logs.size()) {
+    const int64_t secs = timestamp_secs(second_begin);
+    if (secs <= 0) {
+      return errors::InvalidArgument(
+          "Trace replay needs log_metadata.timestamp_secs, which log ",
+          second_begin, " lacks");
+    }
+    if (second_begin > 0 && secs < timestamp_secs(second_begin - 1)) {
+      return errors::InvalidArgument(
+          "Trace replay needs the logs in time order, but log ", second_begin,
+          " is earlier than the one before it");
+    }
+    size_t second_end = second_begin + 1;
+    while (second_end < logs.size() && timestamp_secs(second_end) == secs) {
+      ++second_end;
+    }
+    const int64_t num_in_second = second_end - second_begin;
+    for (size_t i = second_begin; i < second_end; ++i) {
+      offsets_micros->push_back((secs - first_secs) * 1000000 +
+                                (i - second_begin) * 1000000 / num_in_second);
+    }
+    second_begin = second_end;
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,177 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_LOAD_GENERATOR_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_LOAD_GENERATOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A histogram of latencies in the style of HdrHistogram: buckets are linear
+// up to 128 microseconds and log-linear above, with 64 buckets per power of
+// two, so that every recorded value is reported to within 1/64 (~1.6%) of
+// itself whatever its magnitude, in constant memory.
+//
+// This class is not thread-safe.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  void Add(int64_t micros);
+  void Merge(const LatencyHistogram& other);
+
+  int64_t count() const { return count_; }
+  int64_t min() const { return count_ == 0 ? 0 : min_; }
+  int64_t max() const { return max_; }
+  double mean() const {
+    return count_ == 0 ? 0 : static_cast<double>(sum_) / count_;
+  }
+
+  // Returns the latency at or below which 'percentile' percent of the values
+  // fall, rounded up to the top of its bucket (but no higher than max()).
+  int64_t Percentile(double percentile) const;
+
+ private:
+  static int BucketIndex(int64_t micros);
+  static int64_t BucketUpperBound(int index);
+
+  std::vector<int64_t> counts_;
+  int64_t count_ = 0;
+  int64_t sum_ = 0;
+  int64_t min_ = 0;
+  int64_t max_ = 0;
+};
+
+// Sends the request of the PredictionLog at 'request_index' of the requests
+// of RunLoadGenerator() to the model server, and calls 'done' with the outcome
+// once the response arrives. 'done' may be called on any thread, including the
+// calling thread before returning. Senders are expected to convert the
+// requests to their wire format up front, so as not to time the conversion.
+using LoadRequestSender = std::function<void(
+    size_t request_index, std::function<void(const Status&)> done)>;
+
+struct LoadGeneratorOptions {
+  enum class Mode {
+    // Keeps 'concurrency' requests in flight, sending the next request as
+    // soon as one completes. Measures the throughput the server sustains.
+    kClosedLoop,
+    // Sends requests at exponentially distributed intervals, with a mean rate
+    // of 'qps', regardless of how quickly the server responds.
+    kPoisson,
+    // Sends requests at the times they were logged (scaled by
+    // 'trace_speedup'), regardless of how quickly the server responds.
+    kTraceReplay,
+  };
+  Mode mode = Mode::kClosedLoop;
+
+  // The number of requests in flight in closed-loop mode.
+  int concurrency = 1;
+
+  // The mean request rate in Poisson mode.
+  double qps = 1;
+
+  // How many times faster than logged the trace is replayed.
+  double trace_speedup = 1;
+
+  // Stops after sending this many requests, or after this long, whichever
+  // comes first; 0 for no limit. Requests are sent in a loop over the given
+  // ones, except in trace replay mode, which sends each once. If neither limit
+  // is set, each request is sent once.
+  int64_t num_requests = 0;
+  int64_t duration_micros = 0;
+
+  // Seeds the intervals of Poisson mode.
+  uint64_t seed = 0;
+
+  Env* env = Env::Default();
+};
+
+struct LoadGeneratorResult {
+  int64_t num_ok = 0;
+  std::map<error::Code, int64_t> num_errors;
+
+  // From the first request sent until the last response received.
+  int64_t elapsed_micros = 0;
+
+  // The latencies of the successful requests. In the open-loop modes, a
+  // latency runs from when the request was due to be sent rather than when
+  // the generator got round to sending it, so that a stalled server is not
+  // hidden by the generator stalling with it.
+  LatencyHistogram latency;
+
+  // Successful requests per second.
+  double Throughput() const;
+
+  // A human-readable report of the run.
+  string DebugString() const;
+};
+
+// Sends 'requests' to the server with 'sender', as 'options' say, and blocks
+// until all their responses have arrived.
+Status RunLoadGenerator(const LoadGeneratorOptions& options,
+                        const std::vector<PredictionLog>& requests,
+                        const LoadRequestSender& sender,
+                        LoadGeneratorResult* result);
+
+// Reads the PredictionLogs of the TFRecord file at 'path' (e.g. a warmup file
+// or a request log), up to 'max_logs' of them if positive.
+Status ReadPredictionLogs(const string& path, int64_t max_logs,
+                          std::vector<PredictionLog>* logs);
+
+// Returns the times of 'logs' from the first of them, from their
+// log_metadata.timestamp_secs, for trace replay. As the timestamps only have
+// second granularity, the logs of each second are spread evenly across it.
+// The timestamps must be present and non-decreasing.
+Status ComputeTraceOffsetsMicros(const std::vector<PredictionLog>& logs,
+                                 std::vector<int64_t>* offsets_micros);
+
+// The outcome of replaying a request with ReplayRequests().
+struct ReplayedRequest {
+  // The latency the server logged for the request, from
+  // log_metadata.latency.total_micros, or -1 if it logged none.
+  int64_t logged_latency_micros = -1;
+
+  // The latency of each successful replay of the request.
+  std::vector<int64_t> latencies_micros;
+
+  // The error of the first failed replay, if any.
+  Status status;
+};
+
+// Sends each of 'requests' (e.g. the slow requests captured by a server, see
+// SlowRequests) 'repetitions' times with 'sender', one request at a time so
+// that their latencies are not inflated by one another, and reports the
+// latencies against the logged ones in 'replayed', in the order of
+// 'requests'. Whether a slow request is slow again when sent alone tells
+// whether it is slow in itself or was slowed down by the rest of the load.
+Status ReplayRequests(const std::vector<PredictionLog>& requests,
+                      int repetitions, const LoadRequestSender& sender,
+                      Env* env, std::vector<ReplayedRequest>* replayed);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_LOAD_GENERATOR_H_
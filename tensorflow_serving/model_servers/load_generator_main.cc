@@ -0,0 +1,475 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Drives a model server with the requests of a PredictionLog file (e.g. the
+// warmup file of a SavedModel, or a request log), over gRPC or REST, and
+// reports the throughput and latency percentiles it measured.
+//
+// Closed loop, to find the throughput the server sustains at a concurrency:
+//
+//   load_generator --target=localhost:8500 --requests_file=/path/to/requests \
+//       --mode=closed_loop --concurrency=16 --duration_secs=60
+//
+// Open loop, to measure latencies at a given rate of Poisson arrivals, or by
+// replaying a request log at the times it was logged:
+//
+//   load_generator --target=localhost:8501 --protocol=rest --mode=poisson \
+//       --qps=500 --requests_file=/path/to/requests --duration_secs=60
+//
+// Replay, to send the slow requests a server captured (see
+// --slow_request_threshold_ms of the model server) one at a time, and compare
+// their latencies alone with those they were captured with:
+//
+//   curl -o /tmp/slow \
+//       'localhost:8501/monitoring/slow_requests?model=m&format=tfrecord'
+//   load_generator --target=localhost:8500 --requests_file=/tmp/slow \
+//       --mode=replay --replay_repetitions=3
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "grpcpp/create_channel.h"
+#include "grpcpp/security/credentials.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow_serving/apis/prediction_service.grpc.pb.h"
+#include "tensorflow_serving/model_servers/load_generator.h"
+#include "tensorflow_serving/util/json_tensor.h"
+#include "tensorflow_serving/util/net_http/client/test_client/public/httpclient.h"
+
+ABSL_FLAG(std::string, target, "localhost:8500",
+          "The server to send to (host:port): the gRPC port, or the REST API "
+          "port with --protocol=rest.");
+ABSL_FLAG(std::string, protocol, "grpc", "The API to use: grpc or rest.");
+ABSL_FLAG(std::string, requests_file, "",
+          "TFRecord file of PredictionLogs, whose requests are sent.");
+ABSL_FLAG(int64_t, max_requests_to_read, 0,
+          "If positive, reads at most this many requests from the file.");
+ABSL_FLAG(std::string, mode, "closed_loop",
+          "closed_loop keeps --concurrency requests in flight; poisson sends "
+          "at a mean rate of --qps; trace replays the requests at the times "
+          "they were logged; replay sends each request --replay_repetitions "
+          "times, one at a time, and reports its latencies against the "
+          "logged ones.");
+ABSL_FLAG(int, concurrency, 1, "Requests in flight in closed_loop mode.");
+ABSL_FLAG(double, qps, 1, "Mean request rate in poisson mode.");
+ABSL_FLAG(double, trace_speedup, 1,
+          "How many times faster than logged to replay in trace mode.");
+ABSL_FLAG(int, replay_repetitions, 3,
+          "How many times each request is sent in replay mode.");
+ABSL_FLAG(int64_t, num_requests, 0,
+          "If positive, stops after this many requests. If neither this nor "
+          "--duration_secs is set, each request is sent once.");
+ABSL_FLAG(double, duration_secs, 0,
+          "If positive, stops sending after this many seconds.");
+ABSL_FLAG(int, num_rest_connections, 16,
+          "The number of REST connections, each of which has one request in "
+          "flight at a time. Must be at least --concurrency in closed_loop "
+          "mode, and should cover the requests in flight in the open-loop "
+          "modes, lest they queue in the generator.");
+ABSL_FLAG(std::string, model_name, "",
+          "If set, overrides the model name of the requests.");
+ABSL_FLAG(int64_t, model_version, -1,
+          "If non-negative, overrides the model version of the requests.");
+ABSL_FLAG(int, rpc_deadline_ms, 10000, "Request deadline in milliseconds.");
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using DoneCallback = std::function<void(const Status&)>;
+
+// Returns the model spec of the request of 'log', or null if it is not of a
+// kind the generator sends.
+ModelSpec* MutableModelSpec(PredictionLog* log) {
+  switch (log->log_type_case()) {
+    case PredictionLog::kClassifyLog:
+      return log->mutable_classify_log()
+          ->mutable_request()
+          ->mutable_model_spec();
+    case PredictionLog::kRegressLog:
+      return log->mutable_regress_log()
+          ->mutable_request()
+          ->mutable_model_spec();
+    case PredictionLog::kPredictLog:
+      return log->mutable_predict_log()
+          ->mutable_request()
+          ->mutable_model_spec();
+    default:
+      return nullptr;
+  }
+}
+
+// Sends requests over gRPC, asynchronously, reaping the responses on a thread
+// of its own.
+class GrpcSender {
+ public:
+  static Status Create(const string& target, const int deadline_ms,
+                       const std::vector<PredictionLog>& requests,
+                       std::unique_ptr<GrpcSender>* sender) {
+    for (int i = 0; i < requests.size(); ++i) {
+      const PredictionLog::LogTypeCase log_type = requests[i].log_type_case();
+      if (log_type != PredictionLog::kClassifyLog &&
+          log_type != PredictionLog::kRegressLog &&
+          log_type != PredictionLog::kPredictLog) {
+        return errors::Unimplemented(
+            "Only classify, regress and predict requests can be sent; request ",
+            i, " is not one");
+      }
+    }
+    sender->reset(new GrpcSender(target, deadline_ms, requests));
+    return OkStatus();
+  }
+
+  ~GrpcSender() {
+    cq_.Shutdown();
+    reaper_.reset();
+  }
+
+  void Send(const size_t request_index, DoneCallback done) {
+    const PredictionLog& log = requests_[request_index];
+    switch (log.log_type_case()) {
+      case PredictionLog::kClassifyLog:
+        Start<ClassificationResponse>(log.classify_log().request(),
+                                      &PredictionService::Stub::AsyncClassify,
+                                      std::move(done));
+        break;
+      case PredictionLog::kRegressLog:
+        Start<RegressionResponse>(log.regress_log().request(),
+                                  &PredictionService::Stub::AsyncRegress,
+                                  std::move(done));
+        break;
+      default:
+        Start<PredictResponse>(log.predict_log().request(),
+                               &PredictionService::Stub::AsyncPredict,
+                               std::move(done));
+        break;
+    }
+  }
+
+ private:
+  struct Call {
+    virtual ~Call() = default;
+
+    grpc::ClientContext context;
+    grpc::Status status;
+    DoneCallback done;
+  };
+
+  template <typename Response>
+  struct TypedCall : Call {
+    Response response;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader;
+  };
+
+  GrpcSender(const string& target, const int deadline_ms,
+             const std::vector<PredictionLog>& requests)
+      : stub_(PredictionService::NewStub(
+            grpc::CreateChannel(target, grpc::InsecureChannelCredentials()))),
+        deadline_ms_(deadline_ms),
+        requests_(requests) {
+    reaper_.reset(Env::Default()->StartThread({}, "load_generator_reaper",
+                                              [this]() { Reap(); }));
+  }
+
+  template <typename Response, typename Request>
+  void Start(const Request& request,
+             std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> (
+                 PredictionService::Stub::*method)(grpc::ClientContext*,
+                                                   const Request&,
+                                                   grpc::CompletionQueue*),
+             DoneCallback done) {
+    auto* call = new TypedCall<Response>();
+    call->done = std::move(done);
+    call->context.set_deadline(std::chrono::system_clock::now() +
+                               std::chrono::milliseconds(deadline_ms_));
+    call->reader = (stub_.get()->*method)(&call->context, request, &cq_);
+    call->reader->Finish(&call->response, &call->status, call);
+  }
+
+  void Reap() {
+    void* tag;
+    bool ok;
+    while (cq_.Next(&tag, &ok)) {
+      std::unique_ptr<Call> call(static_cast<Call*>(tag));
+      call->done(call->status.ok()
+                     ? OkStatus()
+                     : Status(static_cast<absl::StatusCode>(
+                                  call->status.error_code()),
+                              call->status.error_message()));
+    }
+  }
+
+  const std::unique_ptr<PredictionService::Stub> stub_;
+  const int deadline_ms_;
+  const std::vector<PredictionLog>& requests_;
+  grpc::CompletionQueue cq_;
+  std::unique_ptr<Thread> reaper_;
+};
+
+// Sends predict requests to the REST API, each from a thread of its own over
+// a connection of its own, as the HTTP client only sends synchronously.
+class RestSender {
+ public:
+  static Status Create(const string& target, const int num_connections,
+                       const std::vector<PredictionLog>& requests,
+                       std::unique_ptr<RestSender>* sender) {
+    const std::vector<string> host_port = absl::StrSplit(target, ':');
+    int port;
+    if (host_port.size() != 2 || !absl::SimpleAtoi(host_port[1], &port)) {
+      return errors::InvalidArgument("Invalid target: ", target);
+    }
+    if (num_connections < 1) {
+      return errors::InvalidArgument(
+          "num_rest_connections must be positive; was ", num_connections);
+    }
+    std::unique_ptr<RestSender> rest_sender(new RestSender());
+    for (int i = 0; i < requests.size(); ++i) {
+      if (requests[i].log_type_case() != PredictionLog::kPredictLog) {
+        return errors::Unimplemented(
+            "Only predict requests can be sent over REST; request ", i,
+            " is not one");
+      }
+      const PredictRequest& request = requests[i].predict_log().request();
+      HttpRequest http_request;
+      http_request.uri_path =
+          absl::StrCat("/v1/models/", request.model_spec().name());
+      if (request.model_spec().has_version()) {
+        absl::StrAppend(&http_request.uri_path, "/versions/",
+                        request.model_spec().version().value());
+      }
+      absl::StrAppend(&http_request.uri_path, ":predict");
+      // The columnar response format is the columnar request format, bar its
+      // key and the signature name.
+      string json;
+      TF_RETURN_IF_ERROR(MakeJsonFromTensors(
+          request.inputs(), JsonPredictRequestFormat::kColumnar,
+          JsonOutputFormat::kCompact, &json));
+      constexpr char kOutputsPrefix[] = "{\"outputs\":";
+      if (!absl::StartsWith(json, kOutputsPrefix)) {
+        return errors::Internal("Unexpected JSON for request ", i);
+      }
+      http_request.body = absl::StrCat(
+          "{\"signature_name\":\"", request.model_spec().signature_name(),
+          "\",\"inputs\":", json.substr(strlen(kOutputsPrefix)));
+      rest_sender->requests_.push_back(std::move(http_request));
+    }
+    for (int i = 0; i < num_connections; ++i) {
+      auto connection = net_http::CreateEvHTTPConnection(host_port[0], port);
+      if (connection == nullptr) {
+        return errors::Unavailable("Failed to connect to ", target);
+      }
+      rest_sender->idle_connections_.push_back(std::move(connection));
+    }
+    rest_sender->thread_pool_.reset(new thread::ThreadPool(
+        Env::Default(), "load_generator_rest", num_connections));
+    *sender = std::move(rest_sender);
+    return OkStatus();
+  }
+
+  ~RestSender() {
+    // Waits for the requests in flight.
+    thread_pool_.reset();
+  }
+
+  void Send(const size_t request_index, DoneCallback done) {
+    thread_pool_->Schedule([this, request_index, done = std::move(done)]() {
+      std::unique_ptr<net_http::TestHTTPClientInterface> connection;
+      {
+        mutex_lock l(mu_);
+        connection = std::move(idle_connections_.back());
+        idle_connections_.pop_back();
+      }
+      const HttpRequest& request = requests_[request_index];
+      net_http::TestClientResponse response;
+      Status status;
+      if (!connection->BlockingSendRequest(
+              {request.uri_path, "POST", {}, request.body}, &response)) {
+        status = errors::Unavailable("Failed to send request");
+      } else if (response.status != net_http::HTTPStatusCode::OK) {
+        status = errors::Unknown("HTTP status ",
+                                 static_cast<int>(response.status), ": ",
+                                 response.body);
+      }
+      {
+        mutex_lock l(mu_);
+        idle_connections_.push_back(std::move(connection));
+      }
+      done(status);
+    });
+  }
+
+ private:
+  struct HttpRequest {
+    string uri_path;
+    string body;
+  };
+
+  RestSender() = default;
+
+  std::vector<HttpRequest> requests_;
+
+  mutex mu_;
+  // There is a connection per thread of the pool, so one is always idle when
+  // a thread takes a request.
+  std::vector<std::unique_ptr<net_http::TestHTTPClientInterface>>
+      idle_connections_ TF_GUARDED_BY(mu_);
+
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
+};
+
+// Prints the latencies of the requests replayed in replay mode, against those
+// logged for them, e.g.
+//
+//   Request 0: logged 1520342 us (parse 12 us, run 1520101 us, ...),
+//       replayed 20114 21002 19875 us
+void PrintReplayedRequests(const std::vector<PredictionLog>& requests,
+                           const std::vector<ReplayedRequest>& replayed) {
+  for (size_t i = 0; i < replayed.size(); ++i) {
+    const RequestLatency& logged = requests[i].log_metadata().latency();
+    string line = absl::StrCat("Request ", i, ": logged ");
+    if (replayed[i].logged_latency_micros < 0) {
+      absl::StrAppend(&line, "-");
+    } else {
+      absl::StrAppend(&line, replayed[i].logged_latency_micros, " us");
+    }
+    std::vector<string> stages;
+    for (const RequestLatency::Stage& stage : logged.stages()) {
+      stages.push_back(absl::StrCat(stage.name(), " ", stage.micros(), " us"));
+    }
+    if (!stages.empty()) {
+      absl::StrAppend(&line, " (", absl::StrJoin(stages, ", "), ")");
+    }
+    absl::StrAppend(&line, ", replayed ",
+                    replayed[i].latencies_micros.empty()
+                        ? "-"
+                        : absl::StrCat(absl::StrJoin(
+                                           replayed[i].latencies_micros, " "),
+                                       " us"));
+    if (!replayed[i].status.ok()) {
+      absl::StrAppend(&line, ", failed: ", replayed[i].status.ToString());
+    }
+    std::cout << line << "\n";
+  }
+}
+
+Status Run() {
+  LoadGeneratorOptions options;
+  const string mode = absl::GetFlag(FLAGS_mode);
+  // Replay mode sends with ReplayRequests() rather than RunLoadGenerator().
+  const bool replay = mode == "replay";
+  if (mode == "closed_loop") {
+    options.mode = LoadGeneratorOptions::Mode::kClosedLoop;
+  } else if (mode == "poisson") {
+    options.mode = LoadGeneratorOptions::Mode::kPoisson;
+  } else if (mode == "trace") {
+    options.mode = LoadGeneratorOptions::Mode::kTraceReplay;
+  } else if (!replay) {
+    return errors::InvalidArgument("Invalid mode: ", mode);
+  }
+  options.concurrency = absl::GetFlag(FLAGS_concurrency);
+  options.qps = absl::GetFlag(FLAGS_qps);
+  options.trace_speedup = absl::GetFlag(FLAGS_trace_speedup);
+  options.num_requests = absl::GetFlag(FLAGS_num_requests);
+  options.duration_micros = absl::GetFlag(FLAGS_duration_secs) * 1e6;
+  options.seed = Env::Default()->NowMicros();
+
+  std::vector<PredictionLog> requests;
+  TF_RETURN_IF_ERROR(
+      ReadPredictionLogs(absl::GetFlag(FLAGS_requests_file),
+                         absl::GetFlag(FLAGS_max_requests_to_read), &requests));
+  for (PredictionLog& log : requests) {
+    ModelSpec* const model_spec = MutableModelSpec(&log);
+    if (model_spec == nullptr) {
+      continue;
+    }
+    if (!absl::GetFlag(FLAGS_model_name).empty()) {
+      model_spec->set_name(absl::GetFlag(FLAGS_model_name));
+    }
+    if (absl::GetFlag(FLAGS_model_version) >= 0) {
+      model_spec->mutable_version()->set_value(
+          absl::GetFlag(FLAGS_model_version));
+    }
+  }
+
+  // Sends the requests with 'sender' as the mode says, and reports on them.
+  const auto send = [&](const LoadRequestSender& sender) -> Status {
+    if (replay) {
+      std::vector<ReplayedRequest> replayed;
+      TF_RETURN_IF_ERROR(ReplayRequests(
+          requests, absl::GetFlag(FLAGS_replay_repetitions), sender,
+          Env::Default(), &replayed));
+      PrintReplayedRequests(requests, replayed);
+      return OkStatus();
+    }
+    LoadGeneratorResult result;
+    TF_RETURN_IF_ERROR(RunLoadGenerator(options, requests, sender, &result));
+    std::cout << result.DebugString();
+    return OkStatus();
+  };
+
+  const string target = absl::GetFlag(FLAGS_target);
+  const string protocol = absl::GetFlag(FLAGS_protocol);
+  if (protocol == "grpc") {
+    std::unique_ptr<GrpcSender> sender;
+    TF_RETURN_IF_ERROR(GrpcSender::Create(
+        target, absl::GetFlag(FLAGS_rpc_deadline_ms), requests, &sender));
+    return send([&sender](size_t request_index, DoneCallback done) {
+      sender->Send(request_index, std::move(done));
+    });
+  } else if (protocol == "rest") {
+    const int num_connections = absl::GetFlag(FLAGS_num_rest_connections);
+    if (!replay && options.mode == LoadGeneratorOptions::Mode::kClosedLoop &&
+        num_connections < options.concurrency) {
+      return errors::InvalidArgument(
+          "num_rest_connections must be at least concurrency");
+    }
+    std::unique_ptr<RestSender> sender;
+    TF_RETURN_IF_ERROR(
+        RestSender::Create(target, num_connections, requests, &sender));
+    return send([&sender](size_t request_index, DoneCallback done) {
+      sender->Send(request_index, std::move(done));
+    });
+  }
+  return errors::InvalidArgument("Invalid protocol: ", protocol);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  const tensorflow::Status status = tensorflow::serving::Run();
+  if (!status.ok()) {
+    std::cerr << status << std::endl;
+    return 1;
+  }
+  return 0;
+}
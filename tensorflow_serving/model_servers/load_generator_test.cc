@@ -0,0 +1,241 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/load_generator.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+PredictionLog LogAt(const int64_t timestamp_secs) {
+  PredictionLog log;
+  log.mutable_log_metadata()->set_timestamp_secs(timestamp_secs);
+  log.mutable_predict_log()->mutable_request()->mutable_model_spec()->set_name(
+      "m");
+  return log;
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.Percentile(50));
+  for (int i = 1000; i >= 1; --i) {
+    histogram.Add(i);
+  }
+  EXPECT_EQ(1000, histogram.count());
+  EXPECT_EQ(1, histogram.min());
+  EXPECT_EQ(1000, histogram.max());
+  EXPECT_DOUBLE_EQ(500.5, histogram.mean());
+  // Small values are exact; the rest are within 1/64 above.
+  EXPECT_EQ(10, histogram.Percentile(1));
+  EXPECT_GE(histogram.Percentile(50), 500);
+  EXPECT_LE(histogram.Percentile(50), 500 + 500 / 64);
+  EXPECT_GE(histogram.Percentile(99), 990);
+  EXPECT_LE(histogram.Percentile(99), 990 + 990 / 64);
+  EXPECT_EQ(1000, histogram.Percentile(100));
+}
+
+TEST(LatencyHistogramTest, LargeValuesAndMerge) {
+  LatencyHistogram histogram;
+  histogram.Add(123456789);
+  LatencyHistogram other;
+  other.Add(1000000000);
+  histogram.Merge(other);
+  EXPECT_EQ(2, histogram.count());
+  EXPECT_EQ(123456789, histogram.min());
+  EXPECT_GE(histogram.Percentile(50), 123456789);
+  EXPECT_LE(histogram.Percentile(50), 123456789 + 123456789 / 64);
+  EXPECT_EQ(1000000000, histogram.Percentile(99.9));
+}
+
+TEST(LoadGeneratorTest, ClosedLoopKeepsConcurrencyInFlight) {
+  thread::ThreadPool responders(Env::Default(), "responders", 8);
+  mutex mu;
+  int num_in_flight = 0;
+  int max_in_flight = 0;
+  std::vector<int> num_sent(3, 0);
+  const LoadRequestSender sender =
+      [&](size_t request_index, std::function<void(const Status&)> done) {
+        {
+          mutex_lock l(mu);
+          max_in_flight = std::max(max_in_flight, ++num_in_flight);
+          ++num_sent[request_index];
+        }
+        responders.Schedule([&, request_index, done]() {
+          Env::Default()->SleepForMicroseconds(1000);
+          {
+            mutex_lock l(mu);
+            --num_in_flight;
+          }
+          done(request_index == 2 ? errors::Unavailable("down") : OkStatus());
+        });
+      };
+
+  LoadGeneratorOptions options;
+  options.concurrency = 4;
+  options.num_requests = 30;
+  LoadGeneratorResult result;
+  TF_ASSERT_OK(RunLoadGenerator(options, {LogAt(1), LogAt(1), LogAt(1)},
+                                sender, &result));
+  EXPECT_EQ(4, max_in_flight);
+  EXPECT_EQ(std::vector<int>({10, 10, 10}), num_sent);
+  EXPECT_EQ(20, result.num_ok);
+  EXPECT_EQ(20, result.latency.count());
+  EXPECT_GE(result.latency.min(), 1000);
+  ASSERT_EQ(1, result.num_errors.size());
+  EXPECT_EQ(10, result.num_errors.at(error::UNAVAILABLE));
+  EXPECT_GT(result.Throughput(), 0);
+}
+
+TEST(LoadGeneratorTest, PoissonSendsAtRate) {
+  int num_sent = 0;
+  const LoadRequestSender sender =
+      [&](size_t request_index, std::function<void(const Status&)> done) {
+        ++num_sent;
+        done(OkStatus());
+      };
+  LoadGeneratorOptions options;
+  options.mode = LoadGeneratorOptions::Mode::kPoisson;
+  options.qps = 1000;
+  options.num_requests = 100;
+  LoadGeneratorResult result;
+  const uint64_t start_micros = Env::Default()->NowMicros();
+  TF_ASSERT_OK(RunLoadGenerator(options, {LogAt(1)}, sender, &result));
+  EXPECT_EQ(100, num_sent);
+  EXPECT_EQ(100, result.num_ok);
+  // 100 requests at 1000 per second take about 100ms.
+  EXPECT_GE(Env::Default()->NowMicros() - start_micros, 30 * 1000);
+
+  options.qps = 0;
+  EXPECT_FALSE(RunLoadGenerator(options, {LogAt(1)}, sender, &result).ok());
+}
+
+TEST(LoadGeneratorTest, TraceReplaySendsEachRequestOnce) {
+  std::vector<size_t> sent;
+  const LoadRequestSender sender =
+      [&](size_t request_index, std::function<void(const Status&)> done) {
+        sent.push_back(request_index);
+        done(OkStatus());
+      };
+  LoadGeneratorOptions options;
+  options.mode = LoadGeneratorOptions::Mode::kTraceReplay;
+  options.trace_speedup = 100;
+  options.num_requests = 1000;
+  LoadGeneratorResult result;
+  TF_ASSERT_OK(RunLoadGenerator(options, {LogAt(5), LogAt(5), LogAt(6)},
+                                sender, &result));
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2}), sent);
+  // The last request is due 10ms in.
+  EXPECT_GE(result.elapsed_micros, 10 * 1000);
+}
+
+TEST(LoadGeneratorTest, ComputeTraceOffsets) {
+  std::vector<int64_t> offsets_micros;
+  TF_ASSERT_OK(ComputeTraceOffsetsMicros(
+      {LogAt(10), LogAt(10), LogAt(11), LogAt(13), LogAt(13), LogAt(13),
+       LogAt(13)},
+      &offsets_micros));
+  EXPECT_EQ(std::vector<int64_t>(
+                {0, 500000, 1000000, 3000000, 3250000, 3500000, 3750000}),
+            offsets_micros);
+
+  EXPECT_FALSE(
+      ComputeTraceOffsetsMicros({LogAt(10), LogAt(0)}, &offsets_micros).ok());
+  EXPECT_FALSE(
+      ComputeTraceOffsetsMicros({LogAt(10), LogAt(9)}, &offsets_micros).ok());
+}
+
+TEST(LoadGeneratorTest, ReplayRequestsOneAtATime) {
+  test_util::FakeClockEnv env(Env::Default());
+  thread::ThreadPool responders(Env::Default(), "responders", 4);
+  mutex mu;
+  int num_in_flight = 0;
+  int max_in_flight = 0;
+  int num_sent = 0;
+  const LoadRequestSender sender =
+      [&](size_t request_index, std::function<void(const Status&)> done) {
+        {
+          mutex_lock l(mu);
+          max_in_flight = std::max(max_in_flight, ++num_in_flight);
+          ++num_sent;
+        }
+        responders.Schedule([&, request_index, done]() {
+          // Request i takes (i + 1) ms; the last replay of request 1 fails.
+          env.AdvanceByMicroseconds((request_index + 1) * 1000);
+          bool fail;
+          {
+            mutex_lock l(mu);
+            --num_in_flight;
+            fail = num_sent == 4;
+          }
+          done(fail ? errors::Unavailable("down") : OkStatus());
+        });
+      };
+
+  std::vector<PredictionLog> requests = {LogAt(1), LogAt(2)};
+  requests[0].mutable_log_metadata()->mutable_latency()->set_total_micros(
+      5000);
+  std::vector<ReplayedRequest> replayed;
+  TF_ASSERT_OK(ReplayRequests(requests, 2, sender, &env, &replayed));
+  EXPECT_EQ(1, max_in_flight);
+  ASSERT_EQ(2, replayed.size());
+  EXPECT_EQ(5000, replayed[0].logged_latency_micros);
+  EXPECT_EQ(std::vector<int64_t>({1000, 1000}), replayed[0].latencies_micros);
+  TF_EXPECT_OK(replayed[0].status);
+  EXPECT_EQ(-1, replayed[1].logged_latency_micros);
+  EXPECT_EQ(std::vector<int64_t>({2000}), replayed[1].latencies_micros);
+  EXPECT_TRUE(errors::IsUnavailable(replayed[1].status));
+
+  EXPECT_FALSE(ReplayRequests(requests, 0, sender, &env, &replayed).ok());
+}
+
+TEST(LoadGeneratorTest, ReadPredictionLogs) {
+  const string path =
+      io::JoinPath(testing::TmpDir(), "load_generator_test_requests");
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(path, &file));
+    io::RecordWriter writer(file.get());
+    for (int i = 1; i <= 3; ++i) {
+      TF_ASSERT_OK(writer.WriteRecord(LogAt(i).SerializeAsString()));
+    }
+    TF_ASSERT_OK(writer.Close());
+    TF_ASSERT_OK(file->Close());
+  }
+
+  std::vector<PredictionLog> logs;
+  TF_ASSERT_OK(ReadPredictionLogs(path, 0, &logs));
+  ASSERT_EQ(3, logs.size());
+  EXPECT_EQ(3, logs[2].log_metadata().timestamp_secs());
+  TF_ASSERT_OK(ReadPredictionLogs(path, 2, &logs));
+  EXPECT_EQ(2, logs.size());
+  EXPECT_FALSE(ReadPredictionLogs(path + "_missing", 0, &logs).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -53,6 +53,7 @@ limitations under the License.
 #include "tensorflow/core/util/command_line_flags.h"
 #include "tensorflow_serving/model_servers/server.h"
 #include "tensorflow_serving/model_servers/version.h"
+#include "tensorflow_serving/model_servers/worker_processes.h"
 
 #if defined(LIBTPU_ON_GCE) || defined(PLATFORM_CLOUD_TPU)
 #include "tensorflow/core/protobuf/tpu/topology.pb.h"
@@ -91,6 +92,16 @@ int main(int argc, char** argv) {
                        "If non-empty, listen to a UNIX socket for gRPC API "
                        "on the given path. Can be either relative or absolute "
                        "path."),
+      tensorflow::Flag("num_worker_processes", &options.num_worker_processes,
+                       "Number of worker processes to serve with, each "
+                       "loading the models and listening on the gRPC and "
+                       "HTTP/REST API ports with SO_REUSEPORT, under a "
+                       "supervisor process that restarts crashed workers. "
+                       "Raise this if a single process stops scaling with "
+                       "the cores of the host. Workers share the memory of "
+                       "memory-mapped variables (see "
+                       "--memmapped_variables_dir). Cannot be combined with "
+                       "--grpc_socket_path."),
       tensorflow::Flag("rest_api_port", &options.http_port,
                        "Port to listen on for HTTP/REST API. If set to zero "
                        "HTTP/REST API will not be exported. This port must be "
@@ -98,11 +109,48 @@ int main(int argc, char** argv) {
       tensorflow::Flag("rest_api_num_threads", &options.http_num_threads,
                        "Number of threads for HTTP/REST API processing. If not "
                        "set, will be auto set based on number of CPUs."),
+      tensorflow::Flag("rest_api_work_stealing_executor",
+                       &options.http_work_stealing_executor,
+                       "If true, HTTP/REST API requests are processed by a "
+                       "work-stealing thread-pool, with a queue per thread, "
+                       "rather than by a thread-pool with a single queue."),
+      tensorflow::Flag("rest_api_http2_port", &options.http2_port,
+                       "Port to also serve the HTTP/REST API on over "
+                       "HTTP/2 without TLS (h2c), to clients that connect "
+                       "with prior knowledge of HTTP/2. If not set, HTTP/2 "
+                       "is not served."),
+      tensorflow::Flag("rest_api_num_event_loops",
+                       &options.http_num_event_loops,
+                       "Number of event loops that accept HTTP/REST API "
+                       "connections and parse requests and write responses, "
+                       "each listening on the port with SO_REUSEPORT. Raise "
+                       "this if a single core saturates on HTTP I/O."),
       tensorflow::Flag("rest_api_timeout_in_ms", &options.http_timeout_in_ms,
                        "Timeout for HTTP/REST API calls."),
+      tensorflow::Flag("rest_api_idle_timeout_in_ms",
+                       &options.http_idle_timeout_in_ms,
+                       "How long an idle HTTP/REST API keep-alive connection "
+                       "is kept open. If not set, defaults to 50 seconds."),
+      tensorflow::Flag("rest_api_max_requests_per_connection",
+                       &options.http_max_requests_per_connection,
+                       "The most HTTP/REST API requests served on a "
+                       "keep-alive connection before it is closed. If not "
+                       "set, connections serve any number of requests."),
       tensorflow::Flag("rest_api_enable_cors_support",
                        &options.enable_cors_support,
                        "Enable CORS headers in response"),
+      tensorflow::Flag("rest_api_compact_json_responses",
+                       &options.compact_json_responses,
+                       "Write HTTP/REST API predict, classify and regress "
+                       "responses as compact JSON, without indentation. "
+                       "Requests can override this with a 'pretty=true' or "
+                       "'pretty=false' query parameter."),
+      tensorflow::Flag("rest_api_server_timing_header",
+                       &options.server_timing_header,
+                       "Add a Server-Timing header to HTTP/REST API predict, "
+                       "classify and regress responses, with the latency of "
+                       "parsing the request, running it and serializing the "
+                       "response."),
       tensorflow::Flag("enable_batching", &options.enable_batching,
                        "enable batching"),
       tensorflow::Flag(
@@ -153,6 +201,12 @@ int main(int argc, char** argv) {
                        "and servable loads are performed serially in the "
                        "manager's main work loop, may casue the Serving "
                        "request to be delayed. Default: 0"),
+      tensorflow::Flag("work_stealing_load_executor",
+                       &options.work_stealing_load_executor,
+                       "If true, and num_load_threads > 0, servables are "
+                       "loaded by a work-stealing thread-pool, with a queue "
+                       "per thread, rather than by a thread-pool with a single "
+                       "queue."),
       tensorflow::Flag("num_unload_threads", &options.num_unload_threads,
                        "The number of threads in the thread-pool used to "
                        "unload servables. If set as 0, we don't use a "
@@ -169,6 +223,31 @@ int main(int argc, char** argv) {
                        "The interval, in microseconds, between each servable "
                        "load retry. If set negative, it doesn't wait. "
                        "Default: 1 minute"),
+      tensorflow::Flag("load_retry_backoff_multiplier",
+                       &options.load_retry_backoff_multiplier,
+                       "Each load retry after the first waits this many times "
+                       "the interval of the previous one. Default: 1"),
+      tensorflow::Flag("max_load_retry_interval_micros",
+                       &options.max_load_retry_interval_micros,
+                       "If positive, the longest interval, in microseconds, "
+                       "between load retries, once grown by "
+                       "--load_retry_backoff_multiplier."),
+      tensorflow::Flag("load_retry_jitter", &options.load_retry_jitter,
+                       "The fraction, in [0, 1], of each load retry interval "
+                       "that is drawn at random, so that replicas whose loads "
+                       "failed together don't retry together. Default: 0"),
+      tensorflow::Flag("transient_load_retry_interval_micros",
+                       &options.transient_load_retry_interval_micros,
+                       "If non-negative, the interval, in microseconds, of the "
+                       "first load retry after a transient error "
+                       "(UNAVAILABLE, DEADLINE_EXCEEDED or ABORTED)."),
+      tensorflow::Flag("load_retries_per_second",
+                       &options.load_retries_per_second,
+                       "If positive, limits the load retries of all models to "
+                       "this rate, in bursts of up to --max_load_retry_burst."),
+      tensorflow::Flag("max_load_retry_burst", &options.max_load_retry_burst,
+                       "The burst of load retries allowed by "
+                       "--load_retries_per_second. Default: 10"),
       tensorflow::Flag("file_system_poll_wait_seconds",
                        &options.file_system_poll_wait_seconds,
                        "Interval in seconds between each poll of the "
@@ -178,6 +257,79 @@ int main(int argc, char** argv) {
                        "entirely causing ModelServer to indefinitely wait for "
                        "a new model at startup. Negative values are reserved "
                        "for testing purposes only."),
+      tensorflow::Flag("watch_file_system_for_changes",
+                       &options.watch_file_system_for_changes,
+                       "If true, the model base paths are also watched for "
+                       "changes (with inotify for local paths), so that new "
+                       "model versions are found without waiting for the "
+                       "next poll of the filesystem. Polling remains as a "
+                       "fallback, so file_system_poll_wait_seconds can be "
+                       "made larger."),
+      tensorflow::Flag("num_file_system_poll_threads",
+                       &options.num_file_system_poll_threads,
+                       "The number of threads to poll the base paths of the "
+                       "models with in parallel. If 0 or 1, the models are "
+                       "polled one after another."),
+      tensorflow::Flag("max_file_system_poll_backoff_seconds",
+                       &options.max_file_system_poll_backoff_seconds,
+                       "If positive, models whose polls find no change, or "
+                       "fail, are polled exponentially less often, but at "
+                       "least every this many seconds. A change found by a "
+                       "poll, or notified, resumes regular polling."),
+      tensorflow::Flag("model_cache_dir", &options.model_cache_dir,
+                       "If non-empty, model versions at remote storage paths "
+                       "(e.g. on GCS or S3) are cached in this local directory "
+                       "and loaded from it. Cached versions are kept across "
+                       "restarts."),
+      tensorflow::Flag("num_cached_model_versions_to_retain",
+                       &options.num_cached_model_versions_to_retain,
+                       "The number of versions of each model to retain in "
+                       "model_cache_dir: the ones with the highest version "
+                       "numbers. Should be at least the number of versions "
+                       "of a model served at a time."),
+      tensorflow::Flag("fetch_model_versions_in_background",
+                       &options.fetch_model_versions_in_background,
+                       "If true, new model versions are fetched into "
+                       "model_cache_dir in the background, at a low I/O "
+                       "priority, while the earlier versions keep serving, "
+                       "and are loaded once cached. Otherwise the polls of "
+                       "the file system wait for the fetches."),
+      tensorflow::Flag("model_peers", &options.model_peers,
+                       "Comma-separated addresses (host:port) of peer model "
+                       "servers with a model_cache_dir. Model versions are "
+                       "fetched from the caches of the peers that have them, "
+                       "and from their origin otherwise. Requires "
+                       "model_cache_dir. The peers are connected to with the "
+                       "credentials of this server (use_alts_credentials or "
+                       "ssl_config_file)."),
+      tensorflow::Flag("enable_model_file_service",
+                       &options.enable_model_file_service,
+                       "If true, the versions in model_cache_dir are served "
+                       "to the peers of this server, i.e. the servers whose "
+                       "model_peers include it, on the gRPC ports. Requires "
+                       "model_cache_dir."),
+      tensorflow::Flag("memory_pressure_high_watermark",
+                       &options.memory_pressure_high_watermark,
+                       "If positive, the share of its limit (of the cgroup "
+                       "of the server, or else of the host) at which the "
+                       "memory in use makes the server unload models, one "
+                       "per second, of the lowest load_priority and with "
+                       "the fewest requests first. Their requests then fail "
+                       "until they are reloaded, which the first of them "
+                       "starts once memory_pressure_low_watermark allows."),
+      tensorflow::Flag("memory_pressure_low_watermark",
+                       &options.memory_pressure_low_watermark,
+                       "The share of the memory limit below which the "
+                       "models unloaded under memory pressure are reloaded "
+                       "when requested."),
+      tensorflow::Flag("state_snapshot_path", &options.state_snapshot_path,
+                       "If non-empty, the served model versions, and the "
+                       "order in which the models became available, are saved "
+                       "to this local file. On restart, the saved versions of "
+                       "models whose config is unchanged are loaded in that "
+                       "order without waiting to find them in storage. Best "
+                       "combined with model_cache_dir and "
+                       "resource_measurement_history_path."),
       tensorflow::Flag("flush_filesystem_caches",
                        &options.flush_filesystem_caches,
                        "If true (the default), filesystem caches will be "
@@ -187,6 +339,37 @@ int main(int argc, char** argv) {
                        "consumption of the model server, at the potential cost "
                        "of cache misses if model files are accessed after "
                        "servables are loaded."),
+      tensorflow::Flag("use_per_thread_handle_refs",
+                       &options.use_per_thread_handle_refs,
+                       "If true, servable handles are reference counted per "
+                       "request thread instead of per CPU, so that requests "
+                       "don't write to cache lines shared with other threads "
+                       "when getting a handle. This can reduce the cost of "
+                       "handle acquisition for small models served at high "
+                       "QPS, at the cost of some memory per request thread "
+                       "and model."),
+      tensorflow::Flag("enable_batch_load_approval",
+                       &options.enable_batch_load_approval,
+                       "If true, the resources of models to load are "
+                       "estimated in parallel on the load threads, and loads "
+                       "are approved in batches that are packed against the "
+                       "resource budget, largest first. This speeds up "
+                       "loading many models at startup, when there are "
+                       "multiple load threads."),
+      tensorflow::Flag("async_servable_event_publication",
+                       &options.async_servable_event_publication,
+                       "If true, servable state events are delivered to their "
+                       "subscribers, such as the servable state monitor, on "
+                       "threads of their own instead of on the threads that "
+                       "load and unload models. This keeps slow subscribers "
+                       "from stalling loads when many models change state."),
+      tensorflow::Flag("max_num_concurrent_version_transitions",
+                       &options.max_num_concurrent_version_transitions,
+                       "The maximum number of models whose versions are "
+                       "swapped (new version loaded while the old one still "
+                       "serves) at the same time. Limiting it bounds the peak "
+                       "memory of refreshing many large models at once. 0 "
+                       "(the default) means no limit."),
       tensorflow::Flag("tensorflow_session_parallelism",
                        &options.tensorflow_session_parallelism,
                        "Number of threads to use for running a "
@@ -241,6 +424,16 @@ int main(int argc, char** argv) {
                        "grpc.max_connection_age_ms=2000)"),
       tensorflow::Flag("grpc_max_threads", &options.grpc_max_threads,
                        "Max grpc server threads to handle grpc messages."),
+      tensorflow::Flag("enable_async_predict", &options.enable_async_predict,
+                       "If true, Predict requests are served with the gRPC "
+                       "callback API, and do not hold a gRPC thread while "
+                       "they wait to be batched, so many more of them can "
+                       "be in flight than --grpc_max_threads."),
+      tensorflow::Flag(
+          "in_process_remote_predict", &options.in_process_remote_predict,
+          "If true, RemotePredict ops in the models of this server that "
+          "target its gRPC port or socket call its PredictionService "
+          "directly, without serializing the request and response."),
       tensorflow::Flag("enable_model_warmup", &options.enable_model_warmup,
                        "Enables model warmup, which triggers lazy "
                        "initializations (such as TF optimizations) at load "
@@ -249,11 +442,52 @@ int main(int argc, char** argv) {
                        &options.num_request_iterations_for_warmup,
                        "Number of times a request is iterated during warmup "
                        "replay. This value is used only if > 0."),
+      tensorflow::Flag("num_model_warmup_threads",
+                       &options.num_model_warmup_threads,
+                       "Number of threads replaying the warmup requests of "
+                       "each model in parallel, which lets batching models "
+                       "batch them. This value is used only if > 0."),
+      tensorflow::Flag("max_concurrent_warmup_requests",
+                       &options.max_concurrent_warmup_requests,
+                       "Maximum number of warmup requests executed at the "
+                       "same time across all models warming up concurrently. "
+                       "This value is used only if > 0."),
+      tensorflow::Flag("capture_warmup_requests",
+                       &options.capture_warmup_requests,
+                       "If true, keeps a sample of the live requests to each "
+                       "model, one per distinct signature and input shape, "
+                       "and replays them to warm up the next versions of "
+                       "the model whose SavedModels ship no warmup data."),
+      tensorflow::Flag("max_captured_warmup_requests_per_model",
+                       &options.max_captured_warmup_requests_per_model,
+                       "The maximum number of requests kept per model by "
+                       "--capture_warmup_requests."),
+      tensorflow::Flag("slow_request_threshold_ms",
+                       &options.slow_request_threshold_ms,
+                       "If > 0, captures the requests to each model that "
+                       "take at least this many milliseconds to serve, with "
+                       "the breakdown of their latency, and serves them at "
+                       "/monitoring/slow_requests on the HTTP port, for "
+                       "the replay mode of the load generator."),
+      tensorflow::Flag("max_slow_requests_per_model",
+                       &options.max_slow_requests_per_model,
+                       "The maximum number of requests kept per model by "
+                       "--slow_request_threshold_ms; the oldest are evicted "
+                       "first."),
       tensorflow::Flag("version", &display_version, "Display version"),
       tensorflow::Flag(
           "monitoring_config_file", &options.monitoring_config_file,
           "If non-empty, read an ascii MonitoringConfig protobuf from "
           "the supplied file name"),
+      tensorflow::Flag("trace_sampling_rate", &options.trace_sampling_rate,
+                       "The fraction of requests to trace, of those that "
+                       "carry no W3C 'traceparent' header. Requests with one "
+                       "are traced if it's sampled, when tracing is on."),
+      tensorflow::Flag("trace_export_file", &options.trace_export_file,
+                       "If non-empty, turns request tracing on, and appends "
+                       "the spans of traced requests to this file as "
+                       "OTLP/JSON, for the OpenTelemetry Collector's "
+                       "otlpjsonfile receiver."),
       tensorflow::Flag(
           "remove_unused_fields_from_bundle_metagraph",
           &options.remove_unused_fields_from_bundle_metagraph,
@@ -292,17 +526,142 @@ int main(int argc, char** argv) {
           "on first compilation request."),
       tensorflow::Flag("enable_profiler", &options.enable_profiler,
                        "Enable profiler service."),
+      tensorflow::Flag("enable_shared_memory", &options.enable_shared_memory,
+                       "Enable the SharedMemoryService, for clients on the "
+                       "same host to register POSIX shared memory regions "
+                       "and pass the tensors of predict requests in them "
+                       "instead of in the messages. Only the clients on "
+                       "--grpc_socket_path, which is required, can use "
+                       "shared memory, and they share the region names."),
       tensorflow::Flag("thread_pool_factory_config_file",
                        &options.thread_pool_factory_config_file,
                        "If non-empty, read an ascii ThreadPoolConfig protobuf "
                        "from the supplied file name."),
       tensorflow::Flag("mixed_precision", &options.mixed_precision,
                        "specify mixed_precision mode"),
+      tensorflow::Flag("measure_resources_after_load",
+                       &options.measure_resources_after_load,
+                       "Measure the RAM each model takes once loaded from the "
+                       "allocators of its devices, and account for the "
+                       "measurement instead of the estimate from the model's "
+                       "size on disk. Loads that overlap with other loads are "
+                       "not measured."),
+      tensorflow::Flag("resource_measurement_history_path",
+                       &options.resource_measurement_history_path,
+                       "If non-empty (and --measure_resources_after_load is "
+                       "set), the file in which the resource measurements of "
+                       "the models are kept across restarts, to correct the "
+                       "estimates of their later versions."),
+      tensorflow::Flag("memmapped_variables_dir",
+                       &options.memmapped_variables_dir,
+                       "If non-empty, the read-only variables of SavedModels "
+                       "are memory-mapped from aligned copies of their "
+                       "checkpoints, kept in this local directory, instead of "
+                       "being restored into heap memory. Models with the same "
+                       "variables share their pages."),
+      tensorflow::Flag("enable_delta_loading", &options.enable_delta_loading,
+                       "If true, a model version with a delta manifest is "
+                       "loaded by restoring only the variables in its "
+                       "checkpoint, and copying the rest from the loaded "
+                       "version it names as its base."),
+      tensorflow::Flag("num_parallel_restore_threads",
+                       &options.num_parallel_restore_threads,
+                       "If greater than 1, the variables of SavedModels are "
+                       "read from their checkpoints by this many threads, "
+                       "rather than one at a time. Speeds up loading large "
+                       "models from high-latency storage."),
+      tensorflow::Flag("overlap_init_op_with_restore",
+                       &options.overlap_init_op_with_restore,
+                       "If true, the session of a SavedModel is created, and "
+                       "the parts of its init op that don't depend on "
+                       "variables (e.g. lookup table initializers) run, while "
+                       "its variables are read from the checkpoint."),
+      tensorflow::Flag("enable_prebuilt_lookup_tables",
+                       &options.enable_prebuilt_lookup_tables,
+                       "If true, lookup tables initialized from an asset with "
+                       "a prebuilt table in assets.extra (named after the "
+                       "asset, with suffix .table) memory-map the prebuilt "
+                       "table rather than parsing the asset at load."),
+      tensorflow::Flag("share_identical_variables",
+                       &options.share_identical_variables,
+                       "If true, read-only variables with the same content "
+                       "are held once in the process, and shared by the "
+                       "model versions and models that load them."),
+      tensorflow::Flag("freeze_read_only_variables",
+                       &options.freeze_read_only_variables,
+                       "If true, read-only variables are frozen into "
+                       "constants at load, so that the ops that only depend "
+                       "on them are folded away when the graph is optimized."),
+      tensorflow::Flag("inline_run_max_graph_nodes",
+                       &options.inline_run_max_graph_nodes,
+                       "If positive, models that are not batched and whose "
+                       "graph has at most this many nodes run their sessions "
+                       "on the threads of the requests, without the inter- "
+                       "and intra-op thread pools."),
+      tensorflow::Flag("enable_cost_accounting",
+                       &options.enable_cost_accounting,
+                       "If true, the CPU time, GPU time and tensor bytes of "
+                       "the session runs of each model version are exported "
+                       "in the /tensorflow/serving/model_cost/... metrics."),
+      tensorflow::Flag("cost_accounting_trace_interval",
+                       &options.cost_accounting_trace_interval,
+                       "With --enable_cost_accounting, one in this many "
+                       "session runs of each model version is traced to "
+                       "estimate the time of its ops on CPUs and GPUs. 0 "
+                       "traces none."),
+      tensorflow::Flag("enable_memory_accounting",
+                       &options.enable_memory_accounting,
+                       "If true, the memory of the server is broken down by "
+                       "model version, by serving subsystem (batching, JSON, "
+                       "request logging) and by TF allocator in the "
+                       "/tensorflow/serving/memory/... metrics. Turns on the "
+                       "statistics of the CPU allocator, which cost a lock "
+                       "per allocation."),
+      tensorflow::Flag("enable_deferred_unload_release",
+                       &options.enable_deferred_unload_release,
+                       "If true, unloaded servables are destroyed, and their "
+                       "memory returned to the OS, on a low-priority "
+                       "background thread rather than on the unload path, so "
+                       "that version swaps don't slow down the models still "
+                       "serving."),
+      tensorflow::Flag("unload_release_bytes_per_second",
+                       &options.unload_release_bytes_per_second,
+                       "With --enable_deferred_unload_release, the rate in "
+                       "bytes per second to return the memory of unloaded "
+                       "servables to the OS at. 0 returns it as fast as it "
+                       "is freed."),
+      tensorflow::Flag("grpc_cpus", &options.grpc_cpus,
+                       "If non-empty, the gRPC threads only run on these "
+                       "CPUs, as a list like 0-3,8 (on Linux)."),
+      tensorflow::Flag("http_cpus", &options.http_cpus,
+                       "If non-empty, the HTTP event loop and handler threads "
+                       "only run on these CPUs, as a list like 0-3,8 (on "
+                       "Linux)."),
+      tensorflow::Flag("batch_thread_cpus", &options.batch_thread_cpus,
+                       "If non-empty, the batch threads only run on these "
+                       "CPUs, as a list like 0-3,8 (on Linux). Ignored with "
+                       "enable_numa_aware_batching in the batching "
+                       "parameters."),
+      tensorflow::Flag("session_thread_cpus", &options.session_thread_cpus,
+                       "If non-empty, the inter-op and intra-op threads of "
+                       "the sessions only run on these CPUs, as a list like "
+                       "0-3,8 (on Linux). Models with their own thread pools "
+                       "set their CPUs in their thread_pool_config."),
       tensorflow::Flag("skip_initialize_tpu", &options.skip_initialize_tpu,
                        "Whether to skip auto initializing TPU."),
       tensorflow::Flag("enable_grpc_healthcheck_service",
                        &options.enable_grpc_healthcheck_service,
-                       "Enable the standard gRPC healthcheck service.")};
+                       "Enable the standard gRPC healthcheck service. Each "
+                       "model is a service of its own, which serves once a "
+                       "version of it is loaded and warmed up; the server "
+                       "serves once all models do."),
+      tensorflow::Flag("grpc_healthcheck_max_saturation",
+                       &options.grpc_healthcheck_max_saturation,
+                       "If positive, the saturation of a model (or of the "
+                       "server) at which the gRPC health check reports it as "
+                       "NOT_SERVING, to shed load. E.g. 1 sheds load once "
+                       "requests queue beyond the limits or exceed their "
+                       "latency objective.")};
 
   const auto& usage = tensorflow::Flags::Usage(argv[0], flag_list);
   if (!tensorflow::Flags::Parse(&argc, argv, flag_list)) {
@@ -329,12 +688,15 @@ int main(int argc, char** argv) {
     tensorflow::DisableXlaCompilation();
   }
 
-  tensorflow::serving::main::Server server;
-  const auto& status = server.BuildAndStart(options);
-  if (!status.ok()) {
-    std::cout << "Failed to start server. Error: " << status << "\n";
-    return -1;
-  }
-  server.WaitForTermination();
-  return 0;
+  return tensorflow::serving::RunWorkerProcesses(
+      options.num_worker_processes, [&options](int worker_index) {
+        tensorflow::serving::main::Server server;
+        const auto& status = server.BuildAndStart(options);
+        if (!status.ok()) {
+          std::cout << "Failed to start server. Error: " << status << "\n";
+          return -1;
+        }
+        server.WaitForTermination();
+        return 0;
+      });
 }
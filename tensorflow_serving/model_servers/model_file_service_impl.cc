@@ -0,0 +1,131 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/model_file_service_impl.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/model_servers/grpc_status_util.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+const LocalCacheStoragePathSourceAdapter *GetModelCache(
+    const std::function<const LocalCacheStoragePathSourceAdapter *()>
+        &model_cache,
+    Status *status) {
+  const LocalCacheStoragePathSourceAdapter *cache = model_cache();
+  if (cache == nullptr) {
+    *status = errors::Unavailable("The server has no model cache");
+  }
+  return cache;
+}
+
+Status ReadVersionFileRange(const LocalCacheStoragePathSourceAdapter *cache,
+                            const ReadVersionFileRequest &request,
+                            ReadVersionFileResponse *response) {
+  string version_dir;
+  std::vector<CachedVersionFile> files;
+  TF_RETURN_IF_ERROR(
+      cache->LookUpCachedVersion(request.storage_path(), &version_dir, &files));
+  // Only files listed in the manifest are served, so that requests cannot
+  // reach outside the version.
+  const auto file = std::find_if(
+      files.begin(), files.end(), [&request](const CachedVersionFile &file) {
+        return !file.is_directory &&
+               file.relative_path == request.relative_path();
+      });
+  if (file == files.end()) {
+    return errors::NotFound("No file ", request.relative_path(), " in ",
+                            request.storage_path());
+  }
+  if (request.offset() >= file->size) {
+    return OkStatus();
+  }
+  const uint64_t length = std::min(
+      {request.length(), ModelFileServiceImpl::kMaxReadBytes,
+       file->size - request.offset()});
+  std::unique_ptr<RandomAccessFile> random_access_file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(
+      io::JoinPath(version_dir, file->relative_path), &random_access_file));
+  string *const data = response->mutable_data();
+  data->resize(length);
+  StringPiece result;
+  const Status status =
+      random_access_file->Read(request.offset(), length, &result, &(*data)[0]);
+  if (!status.ok() && !errors::IsOutOfRange(status)) {
+    return status;
+  }
+  if (result.data() != data->data()) {
+    data->assign(result.data(), result.size());
+  } else {
+    data->resize(result.size());
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+::grpc::Status ModelFileServiceImpl::ListVersionFiles(
+    ::grpc::ServerContext *context, const ListVersionFilesRequest *request,
+    ListVersionFilesResponse *response) {
+  Status status;
+  const LocalCacheStoragePathSourceAdapter *cache =
+      GetModelCache(model_cache_, &status);
+  string version_dir;
+  std::vector<CachedVersionFile> files;
+  if (cache != nullptr) {
+    status = cache->LookUpCachedVersion(request->storage_path(), &version_dir,
+                                        &files);
+  }
+  if (!status.ok()) {
+    VLOG(1) << "ListVersionFiles failed: " << status;
+    return ToGRPCStatus(status);
+  }
+  for (const CachedVersionFile &file : files) {
+    VersionFile *version_file = response->add_files();
+    version_file->set_relative_path(file.relative_path);
+    version_file->set_is_directory(file.is_directory);
+    version_file->set_size(file.size);
+    version_file->set_crc32c(file.crc32c);
+  }
+  return ::grpc::Status::OK;
+}
+
+::grpc::Status ModelFileServiceImpl::ReadVersionFile(
+    ::grpc::ServerContext *context, const ReadVersionFileRequest *request,
+    ReadVersionFileResponse *response) {
+  Status status;
+  const LocalCacheStoragePathSourceAdapter *cache =
+      GetModelCache(model_cache_, &status);
+  if (cache != nullptr) {
+    status = ReadVersionFileRange(cache, *request, response);
+  }
+  if (!status.ok()) {
+    VLOG(1) << "ReadVersionFile failed: " << status;
+  }
+  return ToGRPCStatus(status);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
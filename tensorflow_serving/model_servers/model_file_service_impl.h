@@ -0,0 +1,64 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_MODEL_FILE_SERVICE_IMPL_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_MODEL_FILE_SERVICE_IMPL_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "tensorflow_serving/apis/model_file_service.grpc.pb.h"
+#include "tensorflow_serving/apis/model_file_service.pb.h"
+#include "tensorflow_serving/core/local_cache_storage_path_source_adapter.h"
+#include "tensorflow_serving/model_servers/server_core.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Serves the versions in the local model cache of the server to its peers.
+// Fails with UNAVAILABLE while the server has no model cache.
+class ModelFileServiceImpl final : public ModelFileService::Service {
+ public:
+  // The most data returned by a ReadVersionFile call.
+  static constexpr uint64_t kMaxReadBytes = 4 << 20;
+
+  explicit ModelFileServiceImpl(ServerCore *core)
+      : model_cache_([core]() { return core->model_cache(); }) {}
+
+  // Serves the versions in 'model_cache', which may be null, rather than those
+  // of a ServerCore.
+  explicit ModelFileServiceImpl(
+      const LocalCacheStoragePathSourceAdapter *model_cache)
+      : model_cache_([model_cache]() { return model_cache; }) {}
+
+  ::grpc::Status ListVersionFiles(::grpc::ServerContext *context,
+                                  const ListVersionFilesRequest *request,
+                                  ListVersionFilesResponse *response) override;
+
+  ::grpc::Status ReadVersionFile(::grpc::ServerContext *context,
+                                 const ReadVersionFileRequest *request,
+                                 ReadVersionFileResponse *response) override;
+
+ private:
+  const std::function<const LocalCacheStoragePathSourceAdapter *()>
+      model_cache_;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_MODEL_FILE_SERVICE_IMPL_H_
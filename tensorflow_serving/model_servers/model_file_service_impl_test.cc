@@ -0,0 +1,163 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/model_file_service_impl.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow_serving/core/local_cache_storage_path_source_adapter.h"
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/core/storage_path.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class ModelFileServiceImplTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const string test_dir = io::JoinPath(
+        testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    storage_path_ = io::JoinPath(test_dir, "remote", "model", "1");
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(storage_path_, "variables")));
+    TF_ASSERT_OK(WriteStringToFile(Env::Default(),
+                                   io::JoinPath(storage_path_, "data"),
+                                   "0123456789"));
+    TF_ASSERT_OK(WriteStringToFile(
+        Env::Default(), io::JoinPath(storage_path_, "variables", "variables"),
+        string(ModelFileServiceImpl::kMaxReadBytes + 1, 'v')));
+
+    LocalCacheStoragePathSourceAdapter::Options options;
+    options.cache_dir = io::JoinPath(test_dir, "cache");
+    options.cache_local_paths = true;
+    TF_ASSERT_OK(LocalCacheStoragePathSourceAdapter::Create(options, &cache_));
+    TF_ASSERT_OK(cache_
+                     ->AdaptOneVersion(ServableData<StoragePath>(
+                         {"model", 1}, storage_path_))
+                     .status());
+    service_ = std::make_unique<ModelFileServiceImpl>(cache_.get());
+  }
+
+  // Reads 'length' bytes at 'offset' of 'relative_path' into 'data'.
+  ::grpc::Status Read(const string& relative_path, uint64_t offset,
+                      uint64_t length, string* data) {
+    ::grpc::ServerContext context;
+    ReadVersionFileRequest request;
+    request.set_storage_path(storage_path_);
+    request.set_relative_path(relative_path);
+    request.set_offset(offset);
+    request.set_length(length);
+    ReadVersionFileResponse response;
+    const ::grpc::Status status =
+        service_->ReadVersionFile(&context, &request, &response);
+    *data = response.data();
+    return status;
+  }
+
+  string storage_path_;
+  std::unique_ptr<LocalCacheStoragePathSourceAdapter> cache_;
+  std::unique_ptr<ModelFileServiceImpl> service_;
+};
+
+TEST_F(ModelFileServiceImplTest, ListsCachedFiles) {
+  ::grpc::ServerContext context;
+  ListVersionFilesRequest request;
+  request.set_storage_path(storage_path_);
+  ListVersionFilesResponse response;
+  ASSERT_TRUE(service_->ListVersionFiles(&context, &request, &response).ok());
+  std::map<string, uint64_t> sizes;
+  for (const VersionFile& file : response.files()) {
+    sizes[file.relative_path()] = file.is_directory() ? 0 : file.size();
+  }
+  EXPECT_EQ((std::map<string, uint64_t>{
+                {"data", 10},
+                {"variables", 0},
+                {"variables/variables", ModelFileServiceImpl::kMaxReadBytes +
+                                            1}}),
+            sizes);
+
+  request.set_storage_path(io::JoinPath(io::Dirname(storage_path_), "2"));
+  EXPECT_EQ(::grpc::StatusCode::NOT_FOUND,
+            service_->ListVersionFiles(&context, &request, &response)
+                .error_code());
+}
+
+TEST_F(ModelFileServiceImplTest, ServesOnlyFilesInTheManifest) {
+  string data;
+  ASSERT_TRUE(Read("data", 0, 10, &data).ok());
+  EXPECT_EQ("0123456789", data);
+  // The directories, the files of the cache and the paths that reach outside
+  // of the version are not in the manifest.
+  for (const string& path :
+       {"missing", "variables", "./data", "../1/data", "/etc/passwd"}) {
+    EXPECT_EQ(::grpc::StatusCode::NOT_FOUND,
+              Read(path, 0, 10, &data).error_code())
+        << path;
+  }
+}
+
+TEST_F(ModelFileServiceImplTest, ClampsTheReadRange) {
+  string data;
+  ASSERT_TRUE(Read("data", 3, 4, &data).ok());
+  EXPECT_EQ("3456", data);
+  ASSERT_TRUE(Read("data", 8, 100, &data).ok());
+  EXPECT_EQ("89", data);
+  // Reads at or past the end of the file return no data.
+  ASSERT_TRUE(Read("data", 10, 100, &data).ok());
+  EXPECT_EQ("", data);
+  ASSERT_TRUE(Read("data", 1000, 100, &data).ok());
+  EXPECT_EQ("", data);
+}
+
+TEST_F(ModelFileServiceImplTest, ReadsAtMostMaxReadBytes) {
+  string data;
+  ASSERT_TRUE(Read("variables/variables", 0,
+                   2 * ModelFileServiceImpl::kMaxReadBytes, &data)
+                  .ok());
+  EXPECT_EQ(ModelFileServiceImpl::kMaxReadBytes, data.size());
+  ASSERT_TRUE(Read("variables/variables", ModelFileServiceImpl::kMaxReadBytes,
+                   2 * ModelFileServiceImpl::kMaxReadBytes, &data)
+                  .ok());
+  EXPECT_EQ("v", data);
+}
+
+TEST_F(ModelFileServiceImplTest, FailsWithoutAModelCache) {
+  ModelFileServiceImpl service(
+      static_cast<const LocalCacheStoragePathSourceAdapter*>(nullptr));
+  ::grpc::ServerContext context;
+  ReadVersionFileRequest request;
+  request.set_storage_path(storage_path_);
+  request.set_relative_path("data");
+  ReadVersionFileResponse response;
+  EXPECT_EQ(::grpc::StatusCode::UNAVAILABLE,
+            service.ReadVersionFile(&context, &request, &response)
+                .error_code());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -21,6 +21,10 @@ namespace serving {
 
 constexpr char kTensorFlowModelPlatform[] = "tensorflow";
 
+// Decision forests served natively, with no TensorFlow graph (see
+// servables/decision_forest/decision_forest.h).
+constexpr char kDecisionForestModelPlatform[] = "decision_forest";
+
 }  // namespace serving
 }  // namespace tensorflow
 
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow_serving/model_servers/get_model_status_impl.h"
 #include "tensorflow_serving/model_servers/grpc_status_util.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
 #include "tensorflow_serving/util/status_util.h"
 
 namespace tensorflow {
@@ -25,8 +26,18 @@ namespace serving {
 ::grpc::Status ModelServiceImpl::GetModelStatus(
     ::grpc::ServerContext *context, const GetModelStatusRequest *request,
     GetModelStatusResponse *response) {
+  Status reload_status;
+  if (!request->reload_operation_id().empty()) {
+    reload_status = staged_reloader_.GetProgress(
+        request->reload_operation_id(), response->mutable_reload_progress());
+    if (reload_status.ok() && !request->has_model_spec()) {
+      return ::grpc::Status::OK;
+    }
+  }
   const ::grpc::Status status = tensorflow::serving::ToGRPCStatus(
-      GetModelStatusImpl::GetModelStatus(core_, *request, response));
+      reload_status.ok()
+          ? GetModelStatusImpl::GetModelStatus(core_, *request, response)
+          : reload_status);
   if (!status.ok()) {
     VLOG(1) << "GetModelStatus failed: " << status.error_message();
   }
@@ -50,7 +61,16 @@ namespace serving {
                   << "\n\tname : " << config.name()
                   << "\n\tplatform : " << config.model_platform();
       }
-      status = core_->ReloadConfig(server_config);
+      if (request->async()) {
+        string operation_id;
+        status = staged_reloader_.Start(*request, &operation_id);
+        response->set_operation_id(operation_id);
+      } else if (staged_reloader_.in_progress()) {
+        status = errors::FailedPrecondition(
+            "An async config reload is in progress");
+      } else {
+        status = core_->ReloadConfig(server_config);
+      }
       break;
     }
     default:
@@ -68,5 +88,35 @@ namespace serving {
   return ToGRPCStatus(status);
 }
 
+namespace {
+
+void FillModelSaturation(const string &model_name, const double saturation,
+                         const std::map<string, double> &signals,
+                         ModelSaturation *output) {
+  output->set_model_name(model_name);
+  output->set_saturation(saturation);
+  output->set_headroom(1 - saturation);
+  output->mutable_signals()->insert(signals.begin(), signals.end());
+}
+
+}  // namespace
+
+::grpc::Status ModelServiceImpl::GetSaturation(
+    ::grpc::ServerContext *context, const GetSaturationRequest *request,
+    GetSaturationResponse *response) {
+  const SaturationMonitor::Report report =
+      SaturationMonitor::Global()->Sample();
+  FillModelSaturation("", report.saturation, report.signals,
+                      response->mutable_server());
+  for (const SaturationMonitor::ModelSaturation &model : report.models) {
+    if (request->model_name().empty() ||
+        request->model_name() == model.model_name) {
+      FillModelSaturation(model.model_name, model.saturation, model.signals,
+                          response->add_models());
+    }
+  }
+  return ::grpc::Status::OK;
+}
+
 }  // namespace serving
 }  // namespace tensorflow
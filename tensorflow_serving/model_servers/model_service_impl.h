@@ -22,13 +22,15 @@ limitations under the License.
 #include "tensorflow_serving/apis/model_service.grpc.pb.h"
 #include "tensorflow_serving/apis/model_service.pb.h"
 #include "tensorflow_serving/model_servers/server_core.h"
+#include "tensorflow_serving/model_servers/staged_config_reloader.h"
 
 namespace tensorflow {
 namespace serving {
 
 class ModelServiceImpl final : public ModelService::Service {
  public:
-  explicit ModelServiceImpl(ServerCore *core) : core_(core) {}
+  explicit ModelServiceImpl(ServerCore *core)
+      : core_(core), staged_reloader_(StagedConfigReloader::Options(), core) {}
 
   ::grpc::Status GetModelStatus(::grpc::ServerContext *context,
                                 const GetModelStatusRequest *request,
@@ -38,8 +40,14 @@ class ModelServiceImpl final : public ModelService::Service {
                                            const ReloadConfigRequest *request,
                                            ReloadConfigResponse *response);
 
+  ::grpc::Status GetSaturation(::grpc::ServerContext *context,
+                               const GetSaturationRequest *request,
+                               GetSaturationResponse *response) override;
+
  private:
   ServerCore *core_;
+  // Applies the async reloads.
+  StagedConfigReloader staged_reloader_;
 };
 
 }  // namespace serving
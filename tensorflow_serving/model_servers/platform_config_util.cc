@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "google/protobuf/any.pb.h"
 #include "tensorflow_serving/model_servers/model_platform_types.h"
+#include "tensorflow_serving/servables/decision_forest/decision_forest_source_adapter.pb.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_source_adapter.pb.h"
 
 namespace tensorflow {
@@ -32,6 +33,11 @@ PlatformConfigMap CreateTensorFlowPlatformConfigMap(
   source_adapter_config.PackFrom(saved_model_bundle_source_adapter_config);
   (*(*platform_config_map.mutable_platform_configs())[kTensorFlowModelPlatform]
         .mutable_source_adapter_config()) = source_adapter_config;
+  PlatformConfig& decision_forest_config =
+      (*platform_config_map
+            .mutable_platform_configs())[kDecisionForestModelPlatform];
+  decision_forest_config.mutable_source_adapter_config()->PackFrom(
+      DecisionForestSourceAdapterConfig());
   return platform_config_map;
 }
 
@@ -22,9 +22,10 @@ limitations under the License.
 namespace tensorflow {
 namespace serving {
 
-// Creates a PlatformConfigMap containing a single entry with the key as
+// Creates a PlatformConfigMap containing an entry with the key as
 // kTensorFlowModelPlatform and the value as a SourceAdapter config proto
-// for SavedModelBundleSourceAdapter.
+// for SavedModelBundleSourceAdapter, and one for kDecisionForestModelPlatform
+// and DecisionForestSourceAdapter.
 PlatformConfigMap CreateTensorFlowPlatformConfigMap(
     const SessionBundleConfig& session_bundle_config);
 
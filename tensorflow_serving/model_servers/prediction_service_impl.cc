@@ -15,84 +15,417 @@ limitations under the License.
 
 #include "tensorflow_serving/model_servers/prediction_service_impl.h"
 
+#include <deque>
+#include <functional>
+#include <memory>
+#include <utility>
+
 #include "grpc/grpc.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow_serving/model_servers/grpc_status_util.h"
+#include "tensorflow_serving/model_servers/request_coalescer.h"
+#include "tensorflow_serving/model_servers/response_cache.h"
+#include "tensorflow_serving/model_servers/shared_memory_service_impl.h"
 #include "tensorflow_serving/servables/tensorflow/classification_service.h"
 #include "tensorflow_serving/servables/tensorflow/get_model_metadata_impl.h"
 #include "tensorflow_serving/servables/tensorflow/multi_inference_helper.h"
 #include "tensorflow_serving/servables/tensorflow/regression_service.h"
+#include "tensorflow_serving/servables/tensorflow/slow_requests.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
+#include "tensorflow_serving/util/request_deadline.h"
+#include "tensorflow_serving/util/request_trace.h"
 
 namespace tensorflow {
 namespace serving {
 
 namespace {
 
-ScopedThreadPools GetThreadPools(ThreadPoolFactory *thread_pool_factory) {
+// Returns the dedicated thread pools of the model 'model_name' if it has any,
+// else those of 'thread_pool_factory'.
+ScopedThreadPools GetThreadPools(ServerCore *core, const string &model_name,
+                                 ThreadPoolFactory *thread_pool_factory) {
+  const std::shared_ptr<ThreadPoolFactory> model_thread_pool_factory =
+      core->GetThreadPoolFactory(model_name);
+  if (model_thread_pool_factory != nullptr) {
+    return model_thread_pool_factory->GetThreadPools();
+  }
   return thread_pool_factory == nullptr ? ScopedThreadPools()
                                         : thread_pool_factory->GetThreadPools();
 }
 
-}  // namespace
-
-::grpc::Status PredictionServiceImpl::Predict(::grpc::ServerContext *context,
-                                              const PredictRequest *request,
-                                              PredictResponse *response) {
-  const uint64_t start = Env::Default()->NowMicros();
+tensorflow::RunOptions GetRunOptions(bool enforce_session_run_timeout,
+                                     ::grpc::ServerContextBase *context) {
   tensorflow::RunOptions run_options = tensorflow::RunOptions();
-  if (enforce_session_run_timeout_) {
+  // By default, this is infinite which is the same default as RunOptions.
+  if (enforce_session_run_timeout) {
     run_options.set_timeout_in_ms(
         DeadlineToTimeoutMillis(context->raw_deadline()));
   }
+  return run_options;
+}
 
-  const ::tensorflow::Status tf_status =
-      predictor_->Predict(run_options, core_, *request, response);
-  const ::grpc::Status status = ToGRPCStatus(tf_status);
+// Returns the deadline of the request of 'context', for the layers below (see
+// RequestDeadline): the deadline of the call if 'enforce_session_run_timeout',
+// and none otherwise. Either way, the request is cancelled with the call.
+std::shared_ptr<const RequestDeadline> GetRequestDeadline(
+    bool enforce_session_run_timeout, ::grpc::ServerContextBase *context) {
+  const absl::Time deadline =
+      enforce_session_run_timeout
+          ? absl::Now() + absl::Milliseconds(
+                              DeadlineToTimeoutMillis(context->raw_deadline()))
+          : absl::InfiniteFuture();
+  return std::make_shared<RequestDeadline>(
+      deadline, [context]() { return context->IsCancelled(); });
+}
+
+// Returns the W3C trace context the caller sent with the request of
+// 'context', or "" if none.
+absl::string_view GetTraceparent(::grpc::ServerContextBase *context) {
+  const auto &metadata = context->client_metadata();
+  const auto it = metadata.find("traceparent");
+  return it == metadata.end()
+             ? absl::string_view()
+             : absl::string_view(it->second.data(), it->second.size());
+}
+
+// Captures 'request', which succeeded in 'latency_micros', if it was slow (see
+// SlowRequests).
+template <typename Request>
+void MaybeCaptureSlowRequest(const Request &request,
+                             const int64_t latency_micros) {
+  if (!SlowRequests::Global()->IsSlow(latency_micros)) {
+    return;
+  }
+  RequestLatency latency;
+  latency.set_total_micros(latency_micros);
+  SlowRequests::Global()->Capture(request.model_spec().name(), request,
+                                  latency);
+}
 
+// Records the metrics of a Predict request that started at 'start', and
+// returns its status.
+::grpc::Status FinishPredict(const PredictRequest &request,
+                             const ::tensorflow::Status &tf_status,
+                             uint64_t start) {
+  const ::grpc::Status status = ToGRPCStatus(tf_status);
   if (status.ok()) {
-    RecordRequestLatency(request->model_spec().name(), /*api=*/"Predict",
-                         /*entrypoint=*/"GRPC",
-                         Env::Default()->NowMicros() - start);
+    const int64_t latency_micros = Env::Default()->NowMicros() - start;
+    RecordRequestLatency(request.model_spec().name(), /*api=*/"Predict",
+                         /*entrypoint=*/"GRPC", latency_micros);
+    MaybeCaptureSlowRequest(request, latency_micros);
   } else {
     VLOG(1) << "Predict failed: " << status.error_message();
   }
-  RecordModelRequestCount(request->model_spec().name(), tf_status);
-
+  RecordModelRequestCount(request.model_spec().name(), tf_status);
   return status;
 }
 
-::grpc::Status PredictionServiceImpl::GetModelMetadata(
-    ::grpc::ServerContext *context, const GetModelMetadataRequest *request,
-    GetModelMetadataResponse *response) {
-  const ::grpc::Status status = ToGRPCStatus(
-      GetModelMetadataImpl::GetModelMetadata(core_, *request, response));
+// The response cache of the model of a request, if it has one, and the key of
+// the request in it.
+struct ResponseCacheLookup {
+  std::shared_ptr<ResponseCache> cache;
+  ResponseCache::Key key;
+};
+
+// Whether the response to 'request' can be cached, or shared with identical
+// requests: requests passing tensors in shared memory have contents, and
+// outputs, outside the messages.
+template <typename Request>
+bool IsCacheable(const Request &request) {
+  return true;
+}
+
+bool IsCacheable(const PredictRequest &request) {
+  return request.shared_memory_inputs().empty() &&
+         request.shared_memory_outputs().empty();
+}
+
+// Returns an error if 'request' passes tensors in shared memory but the client
+// of 'context' may not use shared memory (see IsSharedMemoryPeer()).
+::tensorflow::Status CheckSharedMemoryPeer(
+    const ::grpc::ServerContextBase &context, const PredictRequest &request) {
+  if ((!request.shared_memory_inputs().empty() ||
+       !request.shared_memory_outputs().empty()) &&
+      !IsSharedMemoryPeer(context)) {
+    return errors::PermissionDenied(
+        "Shared memory can only be used over the UNIX socket of the server");
+  }
+  return OkStatus();
+}
+
+// Looks up the response to 'request', of the method 'method', in the response
+// cache of its model, if it has one. Returns true on a hit. On a miss, sets up
+// '*lookup' for CacheResponse().
+template <typename Request>
+bool LookupCachedResponse(ServerCore *core, const string &method,
+                          const Request &request,
+                          protobuf::Message *response,
+                          ResponseCacheLookup *lookup) {
+  lookup->cache = IsCacheable(request)
+                      ? core->GetResponseCache(request.model_spec().name())
+                      : nullptr;
+  if (lookup->cache == nullptr) {
+    return false;
+  }
+  // Of whatever type of servable, without taking a handle the run also takes.
+  ServableId id;
+  if (!core->GetServableId(request.model_spec(), &id).ok()) {
+    // Let the request fail as it would without the cache.
+    lookup->cache = nullptr;
+    return false;
+  }
+  lookup->key = ResponseCache::MakeKey(
+      method, id.version, request,
+      core->GetFloatOutputDtype(request.model_spec().name()));
+  return lookup->cache->Lookup(lookup->key, response);
+}
+
+// Caches 'response' per 'lookup', if it succeeded. Responses from a version
+// other than the one looked up, which was replaced in between, are not cached.
+template <typename Response>
+void CacheResponse(const ResponseCacheLookup &lookup,
+                   const ::tensorflow::Status &status,
+                   const Response &response) {
+  if (lookup.cache != nullptr && status.ok() &&
+      response.model_spec().version().value() == lookup.key.version) {
+    lookup.cache->Insert(lookup.key, response);
+  }
+}
+
+// Returns the request coalescer of the model of 'request', if it coalesces
+// requests and 'request' can be coalesced, else null.
+template <typename Request>
+std::shared_ptr<RequestCoalescer> GetRequestCoalescer(ServerCore *core,
+                                                      const Request &request) {
+  return IsCacheable(request)
+             ? core->GetRequestCoalescer(request.model_spec().name())
+             : nullptr;
+}
+
+// Runs 'run', which fills 'response' for 'request' to the method 'method',
+// unless the model of 'request' coalesces requests and an identical one is in
+// flight, whose outcome is then shared.
+template <typename Request>
+::tensorflow::Status RunCoalesced(
+    ServerCore *core, const string &method, const Request &request,
+    protobuf::Message *response,
+    const std::function<::tensorflow::Status()> &run) {
+  const std::shared_ptr<RequestCoalescer> coalescer =
+      GetRequestCoalescer(core, request);
+  return coalescer != nullptr
+             ? coalescer->Run(
+                   method, request, response, run,
+                   core->GetFloatOutputDtype(request.model_spec().name()))
+             : run();
+}
+
+// Sets the status of 'response' to 'status', if it is an error.
+void SetStreamResponseStatus(const ::tensorflow::Status &status,
+                             PredictStreamResponse *response) {
+  if (!status.ok()) {
+    response->clear_response();
+    response->mutable_status()->set_error_code(
+        static_cast<error::Code>(status.code()));
+    response->mutable_status()->set_error_message(string(status.message()));
+  }
+}
+
+// Serves a PredictStream call on the callback API: starts each request as soon
+// as it is read, and writes the responses as they complete. Deletes itself
+// when the call is done.
+class PredictStreamReactor
+    : public ::grpc::ServerBidiReactor<PredictStreamRequest,
+                                       PredictStreamResponse> {
+ public:
+  PredictStreamReactor(::grpc::CallbackServerContext *context,
+                       bool enforce_session_run_timeout, ServerCore *core,
+                       TensorflowPredictor *predictor)
+      : context_(context),
+        enforce_session_run_timeout_(enforce_session_run_timeout),
+        core_(core),
+        predictor_(predictor) {
+    StartRead(&read_request_);
+  }
+
+  void OnReadDone(bool ok) override {
+    if (!ok || context_->IsCancelled()) {
+      // The client is done sending, or the call is cancelled.
+      bool finish;
+      {
+        mutex_lock l(mu_);
+        reads_done_ = true;
+        finish = ShouldFinish();
+      }
+      if (finish) {
+        Finish(::grpc::Status::OK);
+      }
+      return;
+    }
+    auto call = std::make_shared<Call>();
+    call->start = Env::Default()->NowMicros();
+    call->request.Swap(read_request_.mutable_request());
+    call->response.set_id(read_request_.id());
+    {
+      mutex_lock l(mu_);
+      ++num_running_;
+    }
+    StartRead(&read_request_);
+    // Each request gets what is left of the deadline of the call.
+    const tensorflow::RunOptions run_options =
+        GetRunOptions(enforce_session_run_timeout_, context_);
+    ScopedRequestDeadline deadline_scope(
+        GetRequestDeadline(enforce_session_run_timeout_, context_));
+    const auto done = [this, call](const ::tensorflow::Status &status) {
+      FinishPredict(call->request, status, call->start);
+      SetStreamResponseStatus(status, &call->response);
+      OnPredictDone(call);
+    };
+    const ::tensorflow::Status peer_status =
+        CheckSharedMemoryPeer(*context_, call->request);
+    if (!peer_status.ok()) {
+      done(peer_status);
+      return;
+    }
+    predictor_->PredictAsync(run_options, core_, call->request,
+                             call->response.mutable_response(), done);
+  }
+
+  void OnWriteDone(bool ok) override {
+    const PredictStreamResponse *next = nullptr;
+    bool finish;
+    {
+      mutex_lock l(mu_);
+      writes_.pop_front();
+      if (!ok) {
+        // The call is broken; drop the other responses.
+        write_failed_ = true;
+        writes_.clear();
+      }
+      writing_ = !writes_.empty();
+      if (writing_) {
+        next = &writes_.front()->response;
+      }
+      finish = ShouldFinish();
+    }
+    if (next != nullptr) {
+      StartWrite(next);
+    }
+    if (finish) {
+      Finish(::grpc::Status::OK);
+    }
+  }
+
+  void OnDone() override { delete this; }
+
+ private:
+  // A request of the stream, and its response.
+  struct Call {
+    uint64_t start;
+    PredictRequest request;
+    PredictStreamResponse response;
+  };
+
+  void OnPredictDone(std::shared_ptr<Call> call) {
+    const PredictStreamResponse *next = nullptr;
+    bool finish;
+    {
+      mutex_lock l(mu_);
+      --num_running_;
+      if (!write_failed_) {
+        writes_.push_back(std::move(call));
+        if (!writing_) {
+          writing_ = true;
+          next = &writes_.front()->response;
+        }
+      }
+      finish = ShouldFinish();
+    }
+    if (next != nullptr) {
+      StartWrite(next);
+    }
+    if (finish) {
+      Finish(::grpc::Status::OK);
+    }
+  }
+
+  // Returns whether the call should be finished now, at most once.
+  bool ShouldFinish() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (finished_ || !reads_done_ || num_running_ > 0 || writing_) {
+      return false;
+    }
+    finished_ = true;
+    return true;
+  }
+
+  ::grpc::CallbackServerContext *const context_;
+  const bool enforce_session_run_timeout_;
+  ServerCore *const core_;
+  TensorflowPredictor *const predictor_;
+
+  // Only used by the reads, which do not overlap.
+  PredictStreamRequest read_request_;
+
+  mutex mu_;
+  bool reads_done_ TF_GUARDED_BY(mu_) = false;
+  int num_running_ TF_GUARDED_BY(mu_) = 0;
+  // The responses to write, in order. The first is being written if
+  // 'writing_'.
+  std::deque<std::shared_ptr<Call>> writes_ TF_GUARDED_BY(mu_);
+  bool writing_ TF_GUARDED_BY(mu_) = false;
+  bool write_failed_ TF_GUARDED_BY(mu_) = false;
+  bool finished_ TF_GUARDED_BY(mu_) = false;
+};
+
+::grpc::Status GetModelMetadata(ModelMetadataCache *model_metadata_cache,
+                                const GetModelMetadataRequest *request,
+                                GetModelMetadataResponse *response) {
+  if (!request->has_model_spec()) {
+    return ToGRPCStatus(
+        errors::InvalidArgument("Missing ModelSpec"));
+  }
+  const ::grpc::Status status =
+      ToGRPCStatus(model_metadata_cache->GetModelMetadata(
+          request->model_spec(), *request, response));
   if (!status.ok()) {
     VLOG(1) << "GetModelMetadata failed: " << status.error_message();
   }
   return status;
 }
 
-::grpc::Status PredictionServiceImpl::Classify(
-    ::grpc::ServerContext *context, const ClassificationRequest *request,
-    ClassificationResponse *response) {
+::grpc::Status Classify(const tensorflow::RunOptions &run_options,
+                        ServerCore *core,
+                        ThreadPoolFactory *thread_pool_factory,
+                        const ClassificationRequest *request,
+                        ClassificationResponse *response) {
   const uint64_t start = Env::Default()->NowMicros();
-  tensorflow::RunOptions run_options = tensorflow::RunOptions();
-  // By default, this is infinite which is the same default as RunOptions.
-  if (enforce_session_run_timeout_) {
-    run_options.set_timeout_in_ms(
-        DeadlineToTimeoutMillis(context->raw_deadline()));
+  ResponseCacheLookup cache_lookup;
+  ::tensorflow::Status tf_status;
+  if (!LookupCachedResponse(core, "Classify", *request, response,
+                            &cache_lookup)) {
+    tf_status = RunCoalesced(core, "Classify", *request, response, [&]() {
+      const ::tensorflow::Status status =
+          TensorflowClassificationServiceImpl::Classify(
+              run_options, core,
+              GetThreadPools(core, request->model_spec().name(),
+                             thread_pool_factory)
+                  .get(),
+              *request, response);
+      CacheResponse(cache_lookup, status, *response);
+      return status;
+    });
   }
-
-  const ::tensorflow::Status tf_status =
-      TensorflowClassificationServiceImpl::Classify(
-          run_options, core_, GetThreadPools(thread_pool_factory_).get(),
-          *request, response);
   const ::grpc::Status status = ToGRPCStatus(tf_status);
 
   if (status.ok()) {
+    const int64_t latency_micros = Env::Default()->NowMicros() - start;
     RecordRequestLatency(request->model_spec().name(), /*api=*/"Classify",
-                         /*entrypoint=*/"GRPC",
-                         Env::Default()->NowMicros() - start);
+                         /*entrypoint=*/"GRPC", latency_micros);
+    MaybeCaptureSlowRequest(*request, latency_micros);
   } else {
     VLOG(1) << "Classify request failed: " << status.error_message();
   }
@@ -101,27 +434,25 @@ ScopedThreadPools GetThreadPools(ThreadPoolFactory *thread_pool_factory) {
   return status;
 }
 
-::grpc::Status PredictionServiceImpl::Regress(::grpc::ServerContext *context,
-                                              const RegressionRequest *request,
-                                              RegressionResponse *response) {
+::grpc::Status Regress(const tensorflow::RunOptions &run_options,
+                       ServerCore *core, ThreadPoolFactory *thread_pool_factory,
+                       const RegressionRequest *request,
+                       RegressionResponse *response) {
   const uint64_t start = Env::Default()->NowMicros();
-  tensorflow::RunOptions run_options = tensorflow::RunOptions();
-  // By default, this is infinite which is the same default as RunOptions.
-  if (enforce_session_run_timeout_) {
-    run_options.set_timeout_in_ms(
-        DeadlineToTimeoutMillis(context->raw_deadline()));
-  }
-
   const ::tensorflow::Status tf_status =
       TensorflowRegressionServiceImpl::Regress(
-          run_options, core_, GetThreadPools(thread_pool_factory_).get(),
+          run_options, core,
+          GetThreadPools(core, request->model_spec().name(),
+                         thread_pool_factory)
+              .get(),
           *request, response);
   const ::grpc::Status status = ToGRPCStatus(tf_status);
 
   if (status.ok()) {
+    const int64_t latency_micros = Env::Default()->NowMicros() - start;
     RecordRequestLatency(request->model_spec().name(), /*api=*/"Regress",
-                         /*entrypoint=*/"GRPC",
-                         Env::Default()->NowMicros() - start);
+                         /*entrypoint=*/"GRPC", latency_micros);
+    MaybeCaptureSlowRequest(*request, latency_micros);
   } else {
     VLOG(1) << "Regress request failed: " << status.error_message();
   }
@@ -130,23 +461,253 @@ ScopedThreadPools GetThreadPools(ThreadPoolFactory *thread_pool_factory) {
   return status;
 }
 
-::grpc::Status PredictionServiceImpl::MultiInference(
-    ::grpc::ServerContext *context, const MultiInferenceRequest *request,
-    MultiInferenceResponse *response) {
-  tensorflow::RunOptions run_options = tensorflow::RunOptions();
-  // By default, this is infinite which is the same default as RunOptions.
-  if (enforce_session_run_timeout_) {
-    run_options.set_timeout_in_ms(
-        DeadlineToTimeoutMillis(context->raw_deadline()));
-  }
+::grpc::Status MultiInference(const tensorflow::RunOptions &run_options,
+                              ServerCore *core,
+                              ThreadPoolFactory *thread_pool_factory,
+                              const MultiInferenceRequest *request,
+                              MultiInferenceResponse *response) {
   const ::grpc::Status status = ToGRPCStatus(RunMultiInferenceWithServerCore(
-      run_options, core_, GetThreadPools(thread_pool_factory_).get(), *request,
-      response));
+      run_options, core,
+      GetThreadPools(core,
+                     request->tasks().empty()
+                         ? ""
+                         : request->tasks(0).model_spec().name(),
+                     thread_pool_factory)
+          .get(),
+      *request, response));
   if (!status.ok()) {
     VLOG(1) << "MultiInference request failed: " << status.error_message();
   }
   return status;
 }
 
+}  // namespace
+
+::grpc::Status PredictionServiceImpl::Predict(::grpc::ServerContext *context,
+                                              const PredictRequest *request,
+                                              PredictResponse *response) {
+  const uint64_t start = Env::Default()->NowMicros();
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  ScopedSpan span(RequestTracer::Global(), GetTraceparent(context), "Predict");
+  span.AddAttribute("model_name", request->model_spec().name());
+  const ::tensorflow::Status peer_status =
+      CheckSharedMemoryPeer(*context, *request);
+  if (!peer_status.ok()) {
+    return FinishPredict(*request, peer_status, start);
+  }
+  ResponseCacheLookup cache_lookup;
+  if (LookupCachedResponse(core_, "Predict", *request, response,
+                           &cache_lookup)) {
+    return FinishPredict(*request, OkStatus(), start);
+  }
+  const ::tensorflow::Status tf_status =
+      RunCoalesced(core_, "Predict", *request, response, [&]() {
+        const ::tensorflow::Status status = predictor_->Predict(
+            GetRunOptions(enforce_session_run_timeout_, context), core_,
+            *request, response);
+        CacheResponse(cache_lookup, status, *response);
+        return status;
+      });
+  return FinishPredict(*request, tf_status, start);
+}
+
+::grpc::Status PredictionServiceImpl::PredictStream(
+    ::grpc::ServerContext *context,
+    ::grpc::ServerReaderWriter<PredictStreamResponse, PredictStreamRequest>
+        *stream) {
+  PredictStreamRequest request;
+  while (!context->IsCancelled() && stream->Read(&request)) {
+    const uint64_t start = Env::Default()->NowMicros();
+    // Each request gets what is left of the deadline of the call.
+    const tensorflow::RunOptions run_options =
+        GetRunOptions(enforce_session_run_timeout_, context);
+    ScopedRequestDeadline deadline_scope(
+        GetRequestDeadline(enforce_session_run_timeout_, context));
+    ScopedSpan span(RequestTracer::Global(), GetTraceparent(context),
+                    "PredictStream");
+    span.AddAttribute("model_name", request.request().model_spec().name());
+    PredictStreamResponse response;
+    response.set_id(request.id());
+    ::tensorflow::Status tf_status =
+        CheckSharedMemoryPeer(*context, request.request());
+    if (tf_status.ok()) {
+      tf_status = predictor_->Predict(run_options, core_, request.request(),
+                                      response.mutable_response());
+    }
+    FinishPredict(request.request(), tf_status, start);
+    SetStreamResponseStatus(tf_status, &response);
+    if (!stream->Write(response)) {
+      break;
+    }
+  }
+  return context->IsCancelled() ? ::grpc::Status::CANCELLED
+                                : ::grpc::Status::OK;
+}
+
+::grpc::Status PredictionServiceImpl::GetModelMetadata(
+    ::grpc::ServerContext *context, const GetModelMetadataRequest *request,
+    GetModelMetadataResponse *response) {
+  return serving::GetModelMetadata(&model_metadata_cache_, request, response);
+}
+
+::grpc::Status PredictionServiceImpl::Classify(
+    ::grpc::ServerContext *context, const ClassificationRequest *request,
+    ClassificationResponse *response) {
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  ScopedSpan span(RequestTracer::Global(), GetTraceparent(context),
+                  "Classify");
+  span.AddAttribute("model_name", request->model_spec().name());
+  return serving::Classify(GetRunOptions(enforce_session_run_timeout_, context),
+                           core_, thread_pool_factory_, request, response);
+}
+
+::grpc::Status PredictionServiceImpl::Regress(::grpc::ServerContext *context,
+                                              const RegressionRequest *request,
+                                              RegressionResponse *response) {
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  ScopedSpan span(RequestTracer::Global(), GetTraceparent(context), "Regress");
+  span.AddAttribute("model_name", request->model_spec().name());
+  return serving::Regress(GetRunOptions(enforce_session_run_timeout_, context),
+                          core_, thread_pool_factory_, request, response);
+}
+
+::grpc::Status PredictionServiceImpl::MultiInference(
+    ::grpc::ServerContext *context, const MultiInferenceRequest *request,
+    MultiInferenceResponse *response) {
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  ScopedSpan span(RequestTracer::Global(), GetTraceparent(context),
+                  "MultiInference");
+  return serving::MultiInference(
+      GetRunOptions(enforce_session_run_timeout_, context), core_,
+      thread_pool_factory_, request, response);
+}
+
+::grpc::ServerUnaryReactor *AsyncPredictionServiceImpl::Predict(
+    ::grpc::CallbackServerContext *context, const PredictRequest *request,
+    PredictResponse *response) {
+  const uint64_t start = Env::Default()->NowMicros();
+  ::grpc::ServerUnaryReactor *reactor = context->DefaultReactor();
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  const ::tensorflow::Status peer_status =
+      CheckSharedMemoryPeer(*context, *request);
+  if (!peer_status.ok()) {
+    reactor->Finish(FinishPredict(*request, peer_status, start));
+    return reactor;
+  }
+  ResponseCacheLookup cache_lookup;
+  if (LookupCachedResponse(core_, "Predict", *request, response,
+                           &cache_lookup)) {
+    reactor->Finish(FinishPredict(*request, OkStatus(), start));
+    return reactor;
+  }
+  // Runs the request, as the leader of the identical ones in flight if
+  // 'coalescer' is set.
+  const auto run = [this, context, request, response, reactor, start](
+                       const ResponseCacheLookup &cache_lookup,
+                       std::shared_ptr<RequestCoalescer> coalescer,
+                       const string &coalescer_key) {
+    predictor_->PredictAsync(
+        GetRunOptions(enforce_session_run_timeout_, context), core_, *request,
+        response,
+        [request, response, reactor, start, cache_lookup,
+         coalescer = std::move(coalescer),
+         coalescer_key](const Status &tf_status) {
+          CacheResponse(cache_lookup, tf_status, *response);
+          // Before finishing, which may free 'response'.
+          if (coalescer != nullptr) {
+            coalescer->Complete(coalescer_key, tf_status, *response);
+          }
+          reactor->Finish(FinishPredict(*request, tf_status, start));
+        });
+  };
+  std::shared_ptr<RequestCoalescer> coalescer =
+      GetRequestCoalescer(core_, *request);
+  string coalescer_key;
+  if (coalescer != nullptr) {
+    coalescer_key = RequestCoalescer::MakeKey(
+        "Predict", *request,
+        core_->GetFloatOutputDtype(request->model_spec().name()));
+    if (!coalescer->Join(
+            coalescer_key,
+            [this, context, request, response, reactor, start, run,
+             cache_lookup](bool run_itself, const Status &tf_status,
+                           const protobuf::Message *leader_response) {
+              if (run_itself) {
+                // Called from a thread that serves another request.
+                ScopedRequestDeadline deadline_scope(
+                    GetRequestDeadline(enforce_session_run_timeout_, context));
+                run(cache_lookup, nullptr, "");
+                return;
+              }
+              if (tf_status.ok()) {
+                response->CopyFrom(*leader_response);
+              }
+              reactor->Finish(FinishPredict(*request, tf_status, start));
+            })) {
+      return reactor;
+    }
+  }
+  run(cache_lookup, std::move(coalescer), coalescer_key);
+  return reactor;
+}
+
+::grpc::ServerBidiReactor<PredictStreamRequest, PredictStreamResponse>
+    *AsyncPredictionServiceImpl::PredictStream(
+        ::grpc::CallbackServerContext *context) {
+  return new PredictStreamReactor(context, enforce_session_run_timeout_, core_,
+                                  predictor_.get());
+}
+
+::grpc::ServerUnaryReactor *AsyncPredictionServiceImpl::GetModelMetadata(
+    ::grpc::CallbackServerContext *context,
+    const GetModelMetadataRequest *request,
+    GetModelMetadataResponse *response) {
+  ::grpc::ServerUnaryReactor *reactor = context->DefaultReactor();
+  reactor->Finish(
+      serving::GetModelMetadata(&model_metadata_cache_, request, response));
+  return reactor;
+}
+
+::grpc::ServerUnaryReactor *AsyncPredictionServiceImpl::Classify(
+    ::grpc::CallbackServerContext *context,
+    const ClassificationRequest *request, ClassificationResponse *response) {
+  ::grpc::ServerUnaryReactor *reactor = context->DefaultReactor();
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  reactor->Finish(
+      serving::Classify(GetRunOptions(enforce_session_run_timeout_, context),
+                        core_, thread_pool_factory_, request, response));
+  return reactor;
+}
+
+::grpc::ServerUnaryReactor *AsyncPredictionServiceImpl::Regress(
+    ::grpc::CallbackServerContext *context, const RegressionRequest *request,
+    RegressionResponse *response) {
+  ::grpc::ServerUnaryReactor *reactor = context->DefaultReactor();
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  reactor->Finish(
+      serving::Regress(GetRunOptions(enforce_session_run_timeout_, context),
+                       core_, thread_pool_factory_, request, response));
+  return reactor;
+}
+
+::grpc::ServerUnaryReactor *AsyncPredictionServiceImpl::MultiInference(
+    ::grpc::CallbackServerContext *context,
+    const MultiInferenceRequest *request, MultiInferenceResponse *response) {
+  ::grpc::ServerUnaryReactor *reactor = context->DefaultReactor();
+  ScopedRequestDeadline deadline_scope(
+      GetRequestDeadline(enforce_session_run_timeout_, context));
+  reactor->Finish(serving::MultiInference(
+      GetRunOptions(enforce_session_run_timeout_, context), core_,
+      thread_pool_factory_, request, response));
+  return reactor;
+}
+
 }  // namespace serving
 }  // namespace tensorflow
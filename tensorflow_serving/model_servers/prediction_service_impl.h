@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_SERVING_MODEL_SERVERS_PREDICTION_SERVICE_IMPL_H_
 
 #include "tensorflow_serving/apis/prediction_service.grpc.pb.h"
+#include "tensorflow_serving/model_servers/arena_message_allocator.h"
 #include "tensorflow_serving/model_servers/prediction_service_util.h"
+#include "tensorflow_serving/servables/tensorflow/get_model_metadata_impl.h"
 #include "tensorflow_serving/servables/tensorflow/predict_impl.h"
 
 namespace tensorflow {
@@ -28,6 +30,7 @@ class PredictionServiceImpl final : public PredictionService::Service {
   explicit PredictionServiceImpl(const PredictionServiceOptions& options)
       : core_(options.server_core),
         predictor_(new TensorflowPredictor(options.thread_pool_factory)),
+        model_metadata_cache_(options.server_core),
         enforce_session_run_timeout_(options.enforce_session_run_timeout),
         thread_pool_factory_(options.thread_pool_factory) {}
 
@@ -35,6 +38,12 @@ class PredictionServiceImpl final : public PredictionService::Service {
                          const PredictRequest* request,
                          PredictResponse* response) override;
 
+  // Runs the requests one at a time, in the order they are read.
+  ::grpc::Status PredictStream(
+      ::grpc::ServerContext* context,
+      ::grpc::ServerReaderWriter<PredictStreamResponse, PredictStreamRequest>*
+          stream) override;
+
   ::grpc::Status GetModelMetadata(::grpc::ServerContext* context,
                                   const GetModelMetadataRequest* request,
                                   GetModelMetadataResponse* response) override;
@@ -54,10 +63,82 @@ class PredictionServiceImpl final : public PredictionService::Service {
  private:
   ServerCore* core_;
   std::unique_ptr<TensorflowPredictor> predictor_;
+  ModelMetadataCache model_metadata_cache_;
   const bool enforce_session_run_timeout_;
   ThreadPoolFactory* thread_pool_factory_;
 };
 
+// A PredictionService on the gRPC callback API. Predict() returns to gRPC
+// while the request waits, e.g. in the batch queue of its model, and the
+// response is sent from the thread that completes it, so in-flight Predict
+// requests do not hold threads. The other methods run in the gRPC callback
+// threads.
+class AsyncPredictionServiceImpl final
+    : public PredictionService::CallbackService {
+ public:
+  explicit AsyncPredictionServiceImpl(const PredictionServiceOptions& options)
+      : core_(options.server_core),
+        predictor_(new TensorflowPredictor(options.thread_pool_factory)),
+        model_metadata_cache_(options.server_core),
+        enforce_session_run_timeout_(options.enforce_session_run_timeout),
+        thread_pool_factory_(options.thread_pool_factory),
+        predict_allocator_({}),
+        classify_allocator_({}),
+        regress_allocator_({}),
+        multi_inference_allocator_({}) {
+    // The requests and responses of the unary methods are allocated on arenas,
+    // which saves allocating and freeing each of their sub-messages.
+    SetMessageAllocatorFor_Predict(&predict_allocator_);
+    SetMessageAllocatorFor_Classify(&classify_allocator_);
+    SetMessageAllocatorFor_Regress(&regress_allocator_);
+    SetMessageAllocatorFor_MultiInference(&multi_inference_allocator_);
+  }
+
+  ::grpc::ServerUnaryReactor* Predict(::grpc::CallbackServerContext* context,
+                                      const PredictRequest* request,
+                                      PredictResponse* response) override;
+
+  // Runs the requests concurrently, as they are read.
+  ::grpc::ServerBidiReactor<PredictStreamRequest, PredictStreamResponse>*
+  PredictStream(::grpc::CallbackServerContext* context) override;
+
+  ::grpc::ServerUnaryReactor* GetModelMetadata(
+      ::grpc::CallbackServerContext* context,
+      const GetModelMetadataRequest* request,
+      GetModelMetadataResponse* response) override;
+
+  ::grpc::ServerUnaryReactor* Classify(
+      ::grpc::CallbackServerContext* context,
+      const ClassificationRequest* request,
+      ClassificationResponse* response) override;
+
+  ::grpc::ServerUnaryReactor* Regress(::grpc::CallbackServerContext* context,
+                                      const RegressionRequest* request,
+                                      RegressionResponse* response) override;
+
+  ::grpc::ServerUnaryReactor* MultiInference(
+      ::grpc::CallbackServerContext* context,
+      const MultiInferenceRequest* request,
+      MultiInferenceResponse* response) override;
+
+ private:
+  ServerCore* core_;
+  std::unique_ptr<TensorflowPredictor> predictor_;
+  ModelMetadataCache model_metadata_cache_;
+  const bool enforce_session_run_timeout_;
+  ThreadPoolFactory* thread_pool_factory_;
+
+  ArenaMessageAllocator<PredictRequest, PredictResponse> predict_allocator_;
+  ArenaMessageAllocator<ClassificationRequest, ClassificationResponse>
+      classify_allocator_;
+  ArenaMessageAllocator<RegressionRequest, RegressionResponse>
+      regress_allocator_;
+  ArenaMessageAllocator<MultiInferenceRequest, MultiInferenceResponse>
+      multi_inference_allocator_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncPredictionServiceImpl);
+};
+
 }  // namespace serving
 }  // namespace tensorflow
 
@@ -0,0 +1,257 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/prediction_service_impl.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "grpcpp/create_channel.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/security/server_credentials.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow_serving/core/availability_preserving_policy.h"
+#include "tensorflow_serving/model_servers/model_platform_types.h"
+#include "tensorflow_serving/model_servers/platform_config_util.h"
+#include "tensorflow_serving/model_servers/server_core.h"
+#include "tensorflow_serving/model_servers/server_init.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr char kTestModelBasePath[] = "cc/saved_model/testdata/half_plus_two";
+constexpr char kTestModelName[] = "half_plus_two";
+constexpr int kNumRequests = 16;
+
+using PredictStream =
+    ::grpc::ClientReaderWriter<PredictStreamRequest, PredictStreamResponse>;
+
+// Runs the PredictStream tests against PredictionServiceImpl if the parameter
+// is false, and against AsyncPredictionServiceImpl if it is true.
+class PredictStreamTest : public ::testing::TestWithParam<bool> {
+ public:
+  static void SetUpTestSuite() {
+    ModelServerConfig config;
+    auto* model_config = config.mutable_model_config_list()->add_config();
+    model_config->set_name(kTestModelName);
+    model_config->set_base_path(
+        test_util::TensorflowTestSrcDirPath(kTestModelBasePath));
+    model_config->set_model_platform(kTensorFlowModelPlatform);
+
+    ServerCore::Options options;
+    options.model_server_config = config;
+    auto* tf_serving_registry =
+        init::TensorflowServingFunctionRegistration::GetRegistry();
+    TF_ASSERT_OK(tf_serving_registry->GetSetupPlatformConfigMap()(
+        SessionBundleConfig(), options.platform_config_map));
+    options.num_initial_load_threads = options.num_load_threads;
+    options.aspired_version_policy =
+        std::unique_ptr<AspiredVersionPolicy>(new AvailabilityPreservingPolicy);
+    TF_ASSERT_OK(ServerCore::Create(std::move(options), &server_core_));
+    while (server_core_->ListAvailableServableIds().empty()) {
+      LOG(INFO) << "Waiting for " << kTestModelName << " to load";
+      absl::SleepFor(absl::Milliseconds(100));
+    }
+  }
+
+  static void TearDownTestSuite() { server_core_.reset(); }
+
+ protected:
+  void SetUp() override {
+    PredictionServiceOptions options;
+    options.server_core = server_core_.get();
+    options.enforce_session_run_timeout = true;
+    if (GetParam()) {
+      service_.reset(new AsyncPredictionServiceImpl(options));
+    } else {
+      service_.reset(new PredictionServiceImpl(options));
+    }
+    ::grpc::ServerBuilder builder;
+    int port = 0;
+    builder.AddListeningPort("localhost:0", ::grpc::InsecureServerCredentials(),
+                             &port);
+    builder.RegisterService(service_.get());
+    server_ = builder.BuildAndStart();
+    ASSERT_NE(nullptr, server_);
+    stub_ = PredictionService::NewStub(
+        ::grpc::CreateChannel(absl::StrCat("localhost:", port),
+                              ::grpc::InsecureChannelCredentials()));
+  }
+
+  void TearDown() override {
+    server_->Shutdown();
+    server_->Wait();
+  }
+
+  // Returns a request of the stream with 'id' for 'x', to 'model_name'.
+  static PredictStreamRequest CreateRequest(
+      int64_t id, float x, const string& model_name = kTestModelName) {
+    PredictStreamRequest request;
+    request.set_id(id);
+    request.mutable_request()->mutable_model_spec()->set_name(model_name);
+    TensorProto& input = (*request.mutable_request()->mutable_inputs())["x"];
+    input.set_dtype(DT_FLOAT);
+    input.add_float_val(x);
+    return request;
+  }
+
+  // Reads the responses of 'stream' until it ends, by id.
+  static std::map<int64_t, PredictStreamResponse> ReadAll(
+      PredictStream* stream) {
+    std::map<int64_t, PredictStreamResponse> responses;
+    PredictStreamResponse response;
+    while (stream->Read(&response)) {
+      EXPECT_EQ(0, responses.count(response.id())) << response.id();
+      responses[response.id()] = response;
+    }
+    return responses;
+  }
+
+  static std::unique_ptr<ServerCore> server_core_;
+  std::unique_ptr<::grpc::Service> service_;
+  std::unique_ptr<::grpc::Server> server_;
+  std::unique_ptr<PredictionService::Stub> stub_;
+};
+
+std::unique_ptr<ServerCore> PredictStreamTest::server_core_;
+
+TEST_P(PredictStreamTest, ResponsesCarryTheIdsOfTheirRequests) {
+  ::grpc::ClientContext context;
+  std::unique_ptr<PredictStream> stream = stub_->PredictStream(&context);
+  // The ids are not in order, so that responses can only be matched by id.
+  for (int i = 0; i < kNumRequests; ++i) {
+    ASSERT_TRUE(stream->Write(CreateRequest(1000 - i, i)));
+  }
+  ASSERT_TRUE(stream->WritesDone());
+  const std::map<int64_t, PredictStreamResponse> responses =
+      ReadAll(stream.get());
+  ASSERT_TRUE(stream->Finish().ok());
+
+  ASSERT_EQ(kNumRequests, responses.size());
+  for (int i = 0; i < kNumRequests; ++i) {
+    const auto it = responses.find(1000 - i);
+    ASSERT_NE(responses.end(), it) << i;
+    EXPECT_FALSE(it->second.has_status());
+    const auto output = it->second.response().outputs().find("y");
+    ASSERT_NE(it->second.response().outputs().end(), output);
+    ASSERT_EQ(1, output->second.float_val_size());
+    EXPECT_FLOAT_EQ(i / 2.0 + 2, output->second.float_val(0));
+  }
+}
+
+TEST_P(PredictStreamTest, FailedRequestsGetResponsesWithTheirStatus) {
+  ::grpc::ClientContext context;
+  std::unique_ptr<PredictStream> stream = stub_->PredictStream(&context);
+  ASSERT_TRUE(stream->Write(CreateRequest(1, 1)));
+  ASSERT_TRUE(stream->Write(CreateRequest(2, 1, "nonexistent_model")));
+  ASSERT_TRUE(stream->Write(CreateRequest(3, 1)));
+  ASSERT_TRUE(stream->WritesDone());
+  const std::map<int64_t, PredictStreamResponse> responses =
+      ReadAll(stream.get());
+  // The failed request does not fail the stream.
+  ASSERT_TRUE(stream->Finish().ok());
+
+  ASSERT_EQ(3, responses.size());
+  EXPECT_FALSE(responses.at(1).has_status());
+  EXPECT_EQ(1, responses.at(1).response().outputs().count("y"));
+  EXPECT_EQ(error::NOT_FOUND, responses.at(2).status().error_code());
+  EXPECT_FALSE(responses.at(2).has_response());
+  EXPECT_FALSE(responses.at(3).has_status());
+  EXPECT_EQ(1, responses.at(3).response().outputs().count("y"));
+}
+
+TEST_P(PredictStreamTest, HalfCloseWaitsForTheRequestsInFlight) {
+  ::grpc::ClientContext context;
+  std::unique_ptr<PredictStream> stream = stub_->PredictStream(&context);
+  for (int i = 0; i < kNumRequests; ++i) {
+    ASSERT_TRUE(stream->Write(CreateRequest(i, i)));
+  }
+  // Half-closes before reading anything, while the requests are running.
+  ASSERT_TRUE(stream->WritesDone());
+  EXPECT_EQ(kNumRequests, ReadAll(stream.get()).size());
+  EXPECT_TRUE(stream->Finish().ok());
+}
+
+TEST_P(PredictStreamTest, CancellingWithResponsesPendingFinishesTheStream) {
+  {
+    ::grpc::ClientContext context;
+    std::unique_ptr<PredictStream> stream = stub_->PredictStream(&context);
+    for (int i = 0; i < kNumRequests; ++i) {
+      ASSERT_TRUE(stream->Write(CreateRequest(i, i)));
+    }
+    // The responses are never read, so writing them fails on the server.
+    context.TryCancel();
+    EXPECT_EQ(::grpc::StatusCode::CANCELLED, stream->Finish().error_code());
+  }
+
+  // The cancelled stream is done with, and the server serves new ones.
+  ::grpc::ClientContext context;
+  std::unique_ptr<PredictStream> stream = stub_->PredictStream(&context);
+  ASSERT_TRUE(stream->Write(CreateRequest(1, 1)));
+  ASSERT_TRUE(stream->WritesDone());
+  EXPECT_EQ(1, ReadAll(stream.get()).size());
+  EXPECT_TRUE(stream->Finish().ok());
+}
+
+TEST_P(PredictStreamTest, CancellingAnIdleStreamFinishesIt) {
+  ::grpc::ClientContext context;
+  std::unique_ptr<PredictStream> stream = stub_->PredictStream(&context);
+  ASSERT_TRUE(stream->Write(CreateRequest(1, 1)));
+  PredictStreamResponse response;
+  ASSERT_TRUE(stream->Read(&response));
+  EXPECT_EQ(1, response.id());
+  // The server is waiting for the next request.
+  context.TryCancel();
+  EXPECT_FALSE(stream->Read(&response));
+  EXPECT_EQ(::grpc::StatusCode::CANCELLED, stream->Finish().error_code());
+}
+
+TEST_P(PredictStreamTest, DeniesSharedMemoryOverTcp) {
+  ::grpc::ClientContext context;
+  std::unique_ptr<PredictStream> stream = stub_->PredictStream(&context);
+  PredictStreamRequest request = CreateRequest(1, 1);
+  request.mutable_request()->mutable_inputs()->clear();
+  SharedMemoryTensor& input =
+      (*request.mutable_request()->mutable_shared_memory_inputs())["x"];
+  input.set_region_name("region");
+  input.set_byte_size(4);
+  input.set_dtype(DT_FLOAT);
+  ASSERT_TRUE(stream->Write(request));
+  ASSERT_TRUE(stream->WritesDone());
+  const std::map<int64_t, PredictStreamResponse> responses =
+      ReadAll(stream.get());
+  EXPECT_TRUE(stream->Finish().ok());
+  ASSERT_EQ(1, responses.size());
+  EXPECT_EQ(error::PERMISSION_DENIED, responses.at(1).status().error_code());
+}
+
+INSTANTIATE_TEST_SUITE_P(SyncAndAsync, PredictStreamTest, ::testing::Bool());
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
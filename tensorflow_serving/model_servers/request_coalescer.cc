@@ -0,0 +1,199 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/request_coalescer.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/platform/notification.h"
+#include "tensorflow_serving/model_servers/request_key.h"
+#include "tensorflow_serving/util/request_deadline.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+auto* coalescer_requests = monitoring::Counter<2>::New(
+    "/tensorflow/serving/request_coalescer/requests",
+    "The number of requests to a model that coalesces requests, by whether "
+    "they were coalesced with an identical request in flight.",
+    "model_name", "coalesced");
+
+}  // namespace
+
+RequestCoalescer::RequestCoalescer(const string& model_name)
+    : model_name_(model_name) {
+  expiry_thread_.reset(Env::Default()->StartThread(
+      {}, "request_coalescer_expiry", [this]() { ExpireFollowers(); }));
+}
+
+RequestCoalescer::~RequestCoalescer() {
+  {
+    mutex_lock l(mu_);
+    stopping_ = true;
+  }
+  deadlines_changed_.notify_all();
+  expiry_thread_.reset();
+}
+
+string RequestCoalescer::MakeKey(const string& method,
+                                 const protobuf::Message& request,
+                                 DataType float_output_dtype) {
+  return MakeRequestKey(method, request, float_output_dtype);
+}
+
+bool RequestCoalescer::Join(const string& key, FollowerCallback follower) {
+  const std::shared_ptr<const RequestDeadline> request_deadline =
+      RequestDeadline::Current();
+  bool leader = false;
+  bool earliest_deadline = false;
+  {
+    mutex_lock l(mu_);
+    auto it = in_flight_.find(key);
+    if (it == in_flight_.end()) {
+      in_flight_.emplace(key, std::vector<std::shared_ptr<Follower>>());
+      leader = true;
+    } else {
+      auto state = std::make_shared<Follower>();
+      {
+        mutex_lock follower_lock(state->mu);
+        state->callback = std::move(follower);
+      }
+      if (request_deadline != nullptr &&
+          request_deadline->deadline() != absl::InfiniteFuture()) {
+        state->has_deadline = true;
+        state->deadline =
+            deadlines_.emplace(request_deadline->deadline(), state);
+        earliest_deadline = state->deadline == deadlines_.begin();
+      }
+      it->second.push_back(std::move(state));
+    }
+  }
+  if (earliest_deadline) {
+    deadlines_changed_.notify_all();
+  }
+  coalescer_requests->GetCell(model_name_, leader ? "false" : "true")
+      ->IncrementBy(1);
+  return leader;
+}
+
+void RequestCoalescer::Complete(const string& key, const Status& status,
+                                const protobuf::Message& response) {
+  std::vector<std::shared_ptr<Follower>> followers;
+  {
+    mutex_lock l(mu_);
+    auto it = in_flight_.find(key);
+    if (it == in_flight_.end()) {
+      return;
+    }
+    followers = std::move(it->second);
+    in_flight_.erase(it);
+    for (const std::shared_ptr<Follower>& follower : followers) {
+      if (follower->has_deadline) {
+        deadlines_.erase(follower->deadline);
+        follower->has_deadline = false;
+      }
+    }
+  }
+  // The leader's cancellation or deadline is not an outcome of the request.
+  const bool run_itself =
+      errors::IsCancelled(status) || errors::IsDeadlineExceeded(status);
+  for (const std::shared_ptr<Follower>& follower : followers) {
+    Call(follower.get(), run_itself, status, &response);
+  }
+}
+
+void RequestCoalescer::Call(Follower* follower, bool run_itself,
+                            const Status& status,
+                            const protobuf::Message* response) {
+  FollowerCallback callback;
+  {
+    mutex_lock l(follower->mu);
+    callback.swap(follower->callback);
+  }
+  if (callback != nullptr) {
+    callback(run_itself, status, response);
+  }
+}
+
+void RequestCoalescer::ExpireFollowers() {
+  for (;;) {
+    std::vector<std::shared_ptr<Follower>> expired;
+    {
+      mutex_lock l(mu_);
+      for (;;) {
+        if (stopping_) {
+          return;
+        }
+        const absl::Time now = absl::Now();
+        if (deadlines_.empty()) {
+          deadlines_changed_.wait(l);
+        } else if (deadlines_.begin()->first > now) {
+          deadlines_changed_.wait_for(
+              l, absl::ToChronoMicroseconds(deadlines_.begin()->first - now));
+        } else {
+          while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+            expired.push_back(deadlines_.begin()->second);
+            expired.back()->has_deadline = false;
+            deadlines_.erase(deadlines_.begin());
+          }
+          break;
+        }
+      }
+    }
+    // The followers stay with their leader, which skips them on completion.
+    for (const std::shared_ptr<Follower>& follower : expired) {
+      Call(follower.get(), /*run_itself=*/false,
+           errors::DeadlineExceeded(
+               "Deadline exceeded waiting for an identical request"),
+           nullptr);
+    }
+  }
+}
+
+Status RequestCoalescer::Run(const string& method,
+                             const protobuf::Message& request,
+                             protobuf::Message* response,
+                             const std::function<Status()>& run,
+                             DataType float_output_dtype) {
+  const string key = MakeKey(method, request, float_output_dtype);
+  Notification done;
+  bool run_itself = false;
+  Status follower_status;
+  const bool leader =
+      Join(key, [response, &done, &run_itself, &follower_status](
+                    bool leader_run_itself, const Status& status,
+                    const protobuf::Message* leader_response) {
+        run_itself = leader_run_itself;
+        follower_status = status;
+        if (!run_itself && status.ok()) {
+          response->CopyFrom(*leader_response);
+        }
+        done.Notify();
+      });
+  if (leader) {
+    const Status status = run();
+    Complete(key, status, *response);
+    return status;
+  }
+  done.WaitForNotification();
+  return run_itself ? run() : follower_status;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,138 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_REQUEST_COALESCER_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_REQUEST_COALESCER_H_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/time/time.h"
+#include "google/protobuf/message.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Coalesces identical requests to a model that are in flight at once: the
+// first, the leader, runs the model, and the others, its followers, get a copy
+// of its response (or its error) when it completes, rather than running the
+// model again. Unlike a ResponseCache, nothing is kept once the leader
+// completes, so this flattens the bursts of identical requests without
+// serving stale responses. Only suitable for models whose responses depend on
+// nothing but the request and the version, since requests for the same
+// version label or for the latest version may be coalesced across versions.
+//
+// A leader that is cancelled or exceeds its deadline says nothing of the
+// requests of its followers, which then run their requests themselves. Each
+// follower waits at most until its own deadline (see RequestDeadline).
+//
+// This class is thread-safe.
+class RequestCoalescer {
+ public:
+  // 'model_name' is for the metrics.
+  explicit RequestCoalescer(const string& model_name);
+
+  ~RequestCoalescer();
+
+  // Returns the key of 'request', to the method 'method' of the model whose
+  // ModelConfig has 'float_output_dtype' (see MakeRequestKey()).
+  static string MakeKey(const string& method, const protobuf::Message& request,
+                        DataType float_output_dtype = DT_INVALID);
+
+  // Called once for each follower, with the outcome of its leader: 'status',
+  // and 'response' if it is OK. If 'run_itself', the leader was cancelled or
+  // exceeded its deadline, and the follower must run its request itself. If
+  // the deadline of the follower passes first, it is called with a
+  // DeadlineExceeded error instead, from another thread.
+  using FollowerCallback =
+      std::function<void(bool run_itself, const Status& status,
+                         const protobuf::Message* response)>;
+
+  // If no request of 'key' is in flight, makes the caller its leader and
+  // returns true: the caller must then run the request and call Complete()
+  // with its outcome. Else returns false, and 'follower' will be called with
+  // the outcome of the leader, or on the deadline of the request the calling
+  // thread serves, if it has one (see RequestDeadline::Current()).
+  bool Join(const string& key, FollowerCallback follower)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Completes the request of 'key' that the caller leads, with 'status' and
+  // 'response': calls its followers, and lets a later request of 'key' lead.
+  void Complete(const string& key, const Status& status,
+                const protobuf::Message& response) TF_LOCKS_EXCLUDED(mu_);
+
+  // Runs 'run', which fills 'response', for 'request' to 'method', unless an
+  // identical request is in flight, in which case waits for it and copies its
+  // response. Returns the status of 'run' or of the request waited for.
+  // 'float_output_dtype' is as in MakeKey().
+  Status Run(const string& method, const protobuf::Message& request,
+             protobuf::Message* response, const std::function<Status()>& run,
+             DataType float_output_dtype = DT_INVALID) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Follower;
+  using DeadlineMap = std::multimap<absl::Time, std::shared_ptr<Follower>>;
+
+  struct Follower {
+    mutex mu;
+    // Reset once called.
+    FollowerCallback callback TF_GUARDED_BY(mu);
+
+    // The entry of the follower in 'deadlines_', if it has a deadline.
+    // Guarded by the 'mu_' of the coalescer.
+    bool has_deadline = false;
+    DeadlineMap::iterator deadline;
+  };
+
+  // Calls the callback of 'follower', unless it has been called already.
+  static void Call(Follower* follower, bool run_itself, const Status& status,
+                   const protobuf::Message* response);
+
+  // Run by 'expiry_thread_': calls the followers whose deadlines pass.
+  void ExpireFollowers() TF_LOCKS_EXCLUDED(mu_);
+
+  const string model_name_;
+
+  mutex mu_;
+
+  // The followers of the requests in flight, by key.
+  absl::flat_hash_map<string, std::vector<std::shared_ptr<Follower>>>
+      in_flight_ TF_GUARDED_BY(mu_);
+
+  // The followers in flight that have a deadline, by deadline.
+  DeadlineMap deadlines_ TF_GUARDED_BY(mu_);
+  condition_variable deadlines_changed_;
+  bool stopping_ TF_GUARDED_BY(mu_) = false;
+
+  std::unique_ptr<Thread> expiry_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RequestCoalescer);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_REQUEST_COALESCER_H_
@@ -0,0 +1,205 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/request_coalescer.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/util/request_deadline.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+PredictRequest MakeRequest(float value) {
+  PredictRequest request;
+  request.mutable_model_spec()->set_name("model");
+  TensorProto& input = (*request.mutable_inputs())["x"];
+  input.set_dtype(DT_FLOAT);
+  input.add_float_val(value);
+  return request;
+}
+
+PredictResponse MakeResponse(float value) {
+  PredictResponse response;
+  TensorProto& output = (*response.mutable_outputs())["y"];
+  output.set_dtype(DT_FLOAT);
+  output.add_float_val(value);
+  return response;
+}
+
+TEST(RequestCoalescerTest, KeysDependOnMethodAndRequest) {
+  const string key = RequestCoalescer::MakeKey("Predict", MakeRequest(1));
+  EXPECT_EQ(key, RequestCoalescer::MakeKey("Predict", MakeRequest(1)));
+  EXPECT_NE(key, RequestCoalescer::MakeKey("Predict", MakeRequest(2)));
+  EXPECT_NE(key, RequestCoalescer::MakeKey("Classify", MakeRequest(1)));
+  EXPECT_NE(key,
+            RequestCoalescer::MakeKey("Predict", MakeRequest(1), DT_HALF));
+}
+
+TEST(RequestCoalescerTest, FollowersGetTheOutcomeOfTheLeader) {
+  RequestCoalescer coalescer("model");
+  const string key = RequestCoalescer::MakeKey("Predict", MakeRequest(1));
+  const string other_key =
+      RequestCoalescer::MakeKey("Predict", MakeRequest(2));
+
+  int num_followers_called = 0;
+  auto follower = [&num_followers_called](
+                      bool run_itself, const Status& status,
+                      const protobuf::Message* response) {
+    EXPECT_FALSE(run_itself);
+    TF_EXPECT_OK(status);
+    EXPECT_EQ(2, static_cast<const PredictResponse*>(response)
+                     ->outputs()
+                     .at("y")
+                     .float_val(0));
+    ++num_followers_called;
+  };
+  EXPECT_TRUE(coalescer.Join(key, follower));
+  EXPECT_FALSE(coalescer.Join(key, follower));
+  EXPECT_FALSE(coalescer.Join(key, follower));
+  // Other requests lead their own.
+  EXPECT_TRUE(coalescer.Join(other_key, follower));
+  EXPECT_EQ(0, num_followers_called);
+
+  coalescer.Complete(key, OkStatus(), MakeResponse(2));
+  EXPECT_EQ(2, num_followers_called);
+
+  // Nothing is kept once the leader completes.
+  EXPECT_TRUE(coalescer.Join(key, follower));
+  coalescer.Complete(key, OkStatus(), MakeResponse(2));
+  coalescer.Complete(other_key, OkStatus(), MakeResponse(2));
+  EXPECT_EQ(2, num_followers_called);
+}
+
+TEST(RequestCoalescerTest, RunWaitsForTheRequestInFlight) {
+  RequestCoalescer coalescer("model");
+  const PredictRequest request = MakeRequest(1);
+  const string key = RequestCoalescer::MakeKey("Predict", request);
+  ASSERT_TRUE(coalescer.Join(key, nullptr));
+
+  bool ran = false;
+  PredictResponse response;
+  Status status;
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      {}, "follower", [&coalescer, &request, &ran, &response, &status]() {
+        status = coalescer.Run("Predict", request, &response, [&ran]() {
+          ran = true;
+          return OkStatus();
+        });
+      }));
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+  coalescer.Complete(key, OkStatus(), MakeResponse(2));
+  thread.reset();
+  EXPECT_FALSE(ran);
+  TF_EXPECT_OK(status);
+  EXPECT_EQ(2, response.outputs().at("y").float_val(0));
+}
+
+TEST(RequestCoalescerTest, RunSharesErrors) {
+  RequestCoalescer coalescer("model");
+  const PredictRequest request = MakeRequest(1);
+  const string key = RequestCoalescer::MakeKey("Predict", request);
+  ASSERT_TRUE(coalescer.Join(key, nullptr));
+
+  PredictResponse response;
+  Status status;
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      {}, "follower", [&coalescer, &request, &response, &status]() {
+        status = coalescer.Run("Predict", request, &response,
+                               []() { return OkStatus(); });
+      }));
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+  coalescer.Complete(key, errors::InvalidArgument("bad input"),
+                     MakeResponse(2));
+  thread.reset();
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+  EXPECT_TRUE(response.outputs().empty());
+
+  // Without a request in flight, Run() runs the request itself.
+  TF_EXPECT_OK(coalescer.Run("Predict", request, &response, [&response]() {
+    *response.mutable_outputs() = MakeResponse(3).outputs();
+    return OkStatus();
+  }));
+  EXPECT_EQ(3, response.outputs().at("y").float_val(0));
+}
+
+TEST(RequestCoalescerTest, FollowersOfCancelledLeadersRunThemselves) {
+  for (const Status& leader_status :
+       {errors::DeadlineExceeded("too slow"), errors::Cancelled("gone")}) {
+    RequestCoalescer coalescer("model");
+    const PredictRequest request = MakeRequest(1);
+    const string key = RequestCoalescer::MakeKey("Predict", request);
+    ASSERT_TRUE(coalescer.Join(key, nullptr));
+
+    bool ran = false;
+    PredictResponse response;
+    Status status;
+    std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+        {}, "follower", [&coalescer, &request, &ran, &response, &status]() {
+          status = coalescer.Run("Predict", request, &response,
+                                 [&ran, &response]() {
+                                   ran = true;
+                                   *response.mutable_outputs() =
+                                       MakeResponse(3).outputs();
+                                   return OkStatus();
+                                 });
+        }));
+    Env::Default()->SleepForMicroseconds(10 * 1000);
+    coalescer.Complete(key, leader_status, MakeResponse(2));
+    thread.reset();
+    EXPECT_TRUE(ran);
+    TF_EXPECT_OK(status);
+    EXPECT_EQ(3, response.outputs().at("y").float_val(0));
+  }
+}
+
+TEST(RequestCoalescerTest, FollowersWaitUntilTheirOwnDeadline) {
+  RequestCoalescer coalescer("model");
+  const PredictRequest request = MakeRequest(1);
+  const string key = RequestCoalescer::MakeKey("Predict", request);
+  ASSERT_TRUE(coalescer.Join(key, nullptr));
+
+  PredictResponse response;
+  Status status;
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      {}, "follower", [&coalescer, &request, &response, &status]() {
+        ScopedRequestDeadline deadline_scope(
+            std::make_shared<RequestDeadline>(
+                absl::Now() + absl::Milliseconds(10), nullptr));
+        status = coalescer.Run("Predict", request, &response,
+                               []() { return OkStatus(); });
+      }));
+  // The follower gives up while the leader is still in flight.
+  thread.reset();
+  EXPECT_EQ(error::DEADLINE_EXCEEDED, status.code());
+  EXPECT_TRUE(response.outputs().empty());
+
+  // Which no longer calls the follower once it completes.
+  coalescer.Complete(key, OkStatus(), MakeResponse(2));
+  EXPECT_TRUE(response.outputs().empty());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
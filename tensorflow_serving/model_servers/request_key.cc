@@ -0,0 +1,43 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/request_key.h"
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/fingerprint.h"
+
+namespace tensorflow {
+namespace serving {
+
+string MakeRequestKey(const string& method, const protobuf::Message& request,
+                      DataType float_output_dtype) {
+  // Maps are serialized in an unspecified order unless asked otherwise.
+  string serialized_request;
+  {
+    protobuf::io::StringOutputStream stream(&serialized_request);
+    protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    request.SerializeToCodedStream(&coded_stream);
+  }
+  const Fprint128 fingerprint = Fingerprint128(serialized_request);
+  string key = strings::StrCat(method, ":", float_output_dtype, ":");
+  key.append(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+  return key;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,40 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_REQUEST_KEY_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_REQUEST_KEY_H_
+
+#include <string>
+
+#include "google/protobuf/message.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Returns the key of 'request' to the method 'method' of a model, which
+// identical requests share: the method and the float_output_dtype of the
+// ModelConfig of the model ('float_output_dtype', DT_INVALID if none), which
+// the responses depend on besides the request, followed by a fingerprint of
+// the deterministic serialization of the request. Shared by the ResponseCache
+// and the RequestCoalescer.
+string MakeRequestKey(const string& method, const protobuf::Message& request,
+                      DataType float_output_dtype = DT_INVALID);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_REQUEST_KEY_H_
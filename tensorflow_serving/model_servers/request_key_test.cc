@@ -0,0 +1,61 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/request_key.h"
+
+#include <gtest/gtest.h>
+#include "tensorflow_serving/apis/predict.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+PredictRequest MakeRequest(float value) {
+  PredictRequest request;
+  request.mutable_model_spec()->set_name("model");
+  TensorProto& input = (*request.mutable_inputs())["x"];
+  input.set_dtype(DT_FLOAT);
+  input.add_float_val(value);
+  return request;
+}
+
+TEST(RequestKeyTest, DependsOnMethodAndRequest) {
+  const string key = MakeRequestKey("Predict", MakeRequest(1));
+  EXPECT_EQ(key, MakeRequestKey("Predict", MakeRequest(1)));
+  EXPECT_NE(key, MakeRequestKey("Predict", MakeRequest(2)));
+  EXPECT_NE(key, MakeRequestKey("Classify", MakeRequest(1)));
+}
+
+TEST(RequestKeyTest, DependsOnFloatOutputDtypeOfModel) {
+  const string key = MakeRequestKey("Predict", MakeRequest(1), DT_BFLOAT16);
+  EXPECT_EQ(key, MakeRequestKey("Predict", MakeRequest(1), DT_BFLOAT16));
+  EXPECT_NE(key, MakeRequestKey("Predict", MakeRequest(1), DT_HALF));
+  EXPECT_NE(key, MakeRequestKey("Predict", MakeRequest(1)));
+}
+
+TEST(RequestKeyTest, IgnoresTheOrderOfMapEntries) {
+  PredictRequest request = MakeRequest(1);
+  PredictRequest reordered;
+  reordered.mutable_model_spec()->set_name("model");
+  (*reordered.mutable_inputs())["z"].set_dtype(DT_INT32);
+  (*reordered.mutable_inputs())["x"] = request.inputs().at("x");
+  (*request.mutable_inputs())["z"].set_dtype(DT_INT32);
+  EXPECT_EQ(MakeRequestKey("Predict", request),
+            MakeRequestKey("Predict", reordered));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
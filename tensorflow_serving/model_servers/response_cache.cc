@@ -0,0 +1,129 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/response_cache.h"
+
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow_serving/model_servers/request_key.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// The memory accounted to an entry beyond its key and response.
+constexpr int64_t kEntryOverheadBytes = 128;
+
+auto* response_cache_lookups = monitoring::Counter<2>::New(
+    "/tensorflow/serving/response_cache/lookups",
+    "The number of lookups in the response cache of a model, by whether they "
+    "hit.",
+    "model_name", "hit");
+
+}  // namespace
+
+ResponseCache::ResponseCache(const Options& options) : options_(options) {}
+
+ResponseCache::Key ResponseCache::MakeKey(const string& method,
+                                          int64_t version,
+                                          const protobuf::Message& request,
+                                          DataType float_output_dtype) {
+  Key key;
+  key.version = version;
+  key.bytes = strings::StrCat(
+      version, ":", MakeRequestKey(method, request, float_output_dtype));
+  return key;
+}
+
+bool ResponseCache::Lookup(const Key& key, protobuf::Message* response) {
+  bool hit = false;
+  {
+    mutex_lock l(mu_);
+    auto it = entries_by_key_.find(key.bytes);
+    if (it != entries_by_key_.end()) {
+      if (it->second->expiry_micros <= options_.env->NowMicros()) {
+        Erase(it->second);
+      } else {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        hit = response->ParseFromString(entries_.front().serialized_response);
+      }
+    }
+  }
+  response_cache_lookups->GetCell(options_.model_name, hit ? "true" : "false")
+      ->IncrementBy(1);
+  return hit;
+}
+
+void ResponseCache::Insert(const Key& key, const protobuf::Message& response) {
+  Entry entry;
+  entry.key = key.bytes;
+  entry.version = key.version;
+  if (!response.SerializeToString(&entry.serialized_response)) {
+    return;
+  }
+  entry.expiry_micros = options_.ttl_micros > 0
+                            ? options_.env->NowMicros() + options_.ttl_micros
+                            : std::numeric_limits<uint64_t>::max();
+  const int64_t entry_bytes = EntryBytes(entry);
+  if (entry_bytes > options_.max_bytes) {
+    return;
+  }
+
+  mutex_lock l(mu_);
+  if (key.version > latest_version_) {
+    latest_version_ = key.version;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      auto next = std::next(it);
+      if (it->version < latest_version_) {
+        Erase(it);
+      }
+      it = next;
+    }
+  }
+  auto existing = entries_by_key_.find(key.bytes);
+  if (existing != entries_by_key_.end()) {
+    Erase(existing->second);
+  }
+  while (size_bytes_ + entry_bytes > options_.max_bytes) {
+    Erase(std::prev(entries_.end()));
+  }
+  entries_.push_front(std::move(entry));
+  entries_by_key_[entries_.front().key] = entries_.begin();
+  size_bytes_ += entry_bytes;
+}
+
+int64_t ResponseCache::size_bytes() const {
+  mutex_lock l(mu_);
+  return size_bytes_;
+}
+
+int64_t ResponseCache::EntryBytes(const Entry& entry) {
+  return entry.key.size() + entry.serialized_response.size() +
+         kEntryOverheadBytes;
+}
+
+void ResponseCache::Erase(EntryList::iterator it) {
+  size_bytes_ -= EntryBytes(*it);
+  entries_by_key_.erase(it->key);
+  entries_.erase(it);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,124 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_RESPONSE_CACHE_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_RESPONSE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "google/protobuf/message.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A memory-bounded cache of the responses of a model, keyed by the method, the
+// version and float_output_dtype of the model and a fingerprint of the
+// request. Only suitable for models whose responses depend on nothing else.
+//
+// The least recently used responses are evicted to keep within 'max_bytes',
+// and responses expire 'ttl_micros' after they are cached. Once a newer
+// version of the model serves a response, the responses of the older versions
+// are dropped.
+//
+// This class is thread-safe.
+class ResponseCache {
+ public:
+  struct Options {
+    // The name of the model, for the metrics.
+    string model_name;
+
+    // The most memory the cached responses may take, including their keys.
+    int64_t max_bytes = 0;
+
+    // How long a response stays cached. 0 keeps responses until evicted.
+    int64_t ttl_micros = 0;
+
+    // The environment to use for timing the expiry of responses.
+    Env* env = Env::Default();
+  };
+
+  explicit ResponseCache(const Options& options);
+
+  ~ResponseCache() = default;
+
+  struct Key {
+    int64_t version;
+    string bytes;
+  };
+
+  // Returns the key of 'request', to the method 'method' of version 'version'
+  // of the model whose ModelConfig has 'float_output_dtype' (see
+  // MakeRequestKey()).
+  static Key MakeKey(const string& method, int64_t version,
+                     const protobuf::Message& request,
+                     DataType float_output_dtype = DT_INVALID);
+
+  // Looks up the response cached for 'key' into 'response'. Returns false on a
+  // miss.
+  bool Lookup(const Key& key, protobuf::Message* response)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Caches 'response' for 'key', unless it alone exceeds 'max_bytes'.
+  void Insert(const Key& key, const protobuf::Message& response)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the memory taken by the cached responses.
+  int64_t size_bytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    string key;
+    int64_t version;
+    string serialized_response;
+    uint64_t expiry_micros;
+  };
+  using EntryList = std::list<Entry>;
+
+  // Returns the memory accounted to 'entry'.
+  static int64_t EntryBytes(const Entry& entry);
+
+  void Erase(EntryList::iterator it) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+
+  mutable mutex mu_;
+
+  // The entries, most recently used first.
+  EntryList entries_ TF_GUARDED_BY(mu_);
+
+  absl::flat_hash_map<string, EntryList::iterator> entries_by_key_
+      TF_GUARDED_BY(mu_);
+
+  int64_t size_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  // The newest version that has had a response cached.
+  int64_t latest_version_ TF_GUARDED_BY(mu_) = -1;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ResponseCache);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_RESPONSE_CACHE_H_
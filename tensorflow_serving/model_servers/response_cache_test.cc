@@ -0,0 +1,145 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/response_cache.h"
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+PredictRequest MakeRequest(float value) {
+  PredictRequest request;
+  request.mutable_model_spec()->set_name("model");
+  TensorProto& input = (*request.mutable_inputs())["x"];
+  input.set_dtype(DT_FLOAT);
+  input.add_float_val(value);
+  return request;
+}
+
+PredictResponse MakeResponse(float value) {
+  PredictResponse response;
+  TensorProto& output = (*response.mutable_outputs())["y"];
+  output.set_dtype(DT_FLOAT);
+  output.add_float_val(value);
+  return response;
+}
+
+TEST(ResponseCacheTest, LooksUpInsertedResponses) {
+  ResponseCache::Options options;
+  options.max_bytes = 1 << 20;
+  ResponseCache cache(options);
+
+  const ResponseCache::Key key =
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(1));
+  PredictResponse response;
+  EXPECT_FALSE(cache.Lookup(key, &response));
+  cache.Insert(key, MakeResponse(2));
+  ASSERT_TRUE(cache.Lookup(key, &response));
+  EXPECT_EQ(2, response.outputs().at("y").float_val(0));
+
+  // Other inputs, methods and versions miss.
+  EXPECT_FALSE(cache.Lookup(
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(3)), &response));
+  EXPECT_FALSE(cache.Lookup(
+      ResponseCache::MakeKey("Classify", 1, MakeRequest(1)), &response));
+  EXPECT_FALSE(cache.Lookup(
+      ResponseCache::MakeKey("Predict", 2, MakeRequest(1)), &response));
+  // Nor do the same requests once the model reduces its float outputs.
+  EXPECT_FALSE(cache.Lookup(
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(1), DT_BFLOAT16),
+      &response));
+}
+
+TEST(ResponseCacheTest, EvictsLeastRecentlyUsed) {
+  const ResponseCache::Key key1 =
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(1));
+  const ResponseCache::Key key2 =
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(2));
+  const ResponseCache::Key key3 =
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(3));
+
+  // Measure one entry, and make room for two.
+  ResponseCache::Options options;
+  options.max_bytes = 1 << 20;
+  int64_t entry_bytes;
+  {
+    ResponseCache cache(options);
+    cache.Insert(key1, MakeResponse(1));
+    entry_bytes = cache.size_bytes();
+  }
+  options.max_bytes = 2 * entry_bytes;
+  ResponseCache cache(options);
+
+  PredictResponse response;
+  cache.Insert(key1, MakeResponse(1));
+  cache.Insert(key2, MakeResponse(2));
+  ASSERT_TRUE(cache.Lookup(key1, &response));
+  cache.Insert(key3, MakeResponse(3));
+  EXPECT_EQ(2 * entry_bytes, cache.size_bytes());
+  EXPECT_TRUE(cache.Lookup(key1, &response));
+  EXPECT_FALSE(cache.Lookup(key2, &response));
+  EXPECT_TRUE(cache.Lookup(key3, &response));
+
+  // A response larger than the whole cache is not cached.
+  options.max_bytes = entry_bytes - 1;
+  ResponseCache small_cache(options);
+  small_cache.Insert(key1, MakeResponse(1));
+  EXPECT_FALSE(small_cache.Lookup(key1, &response));
+  EXPECT_EQ(0, small_cache.size_bytes());
+}
+
+TEST(ResponseCacheTest, ExpiresResponses) {
+  test_util::FakeClockEnv env(Env::Default());
+  ResponseCache::Options options;
+  options.max_bytes = 1 << 20;
+  options.ttl_micros = 1000;
+  options.env = &env;
+  ResponseCache cache(options);
+
+  const ResponseCache::Key key =
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(1));
+  PredictResponse response;
+  cache.Insert(key, MakeResponse(1));
+  env.AdvanceByMicroseconds(999);
+  EXPECT_TRUE(cache.Lookup(key, &response));
+  env.AdvanceByMicroseconds(1);
+  EXPECT_FALSE(cache.Lookup(key, &response));
+  EXPECT_EQ(0, cache.size_bytes());
+}
+
+TEST(ResponseCacheTest, DropsOlderVersions) {
+  ResponseCache::Options options;
+  options.max_bytes = 1 << 20;
+  ResponseCache cache(options);
+
+  const ResponseCache::Key v1 =
+      ResponseCache::MakeKey("Predict", 1, MakeRequest(1));
+  const ResponseCache::Key v2 =
+      ResponseCache::MakeKey("Predict", 2, MakeRequest(1));
+  PredictResponse response;
+  cache.Insert(v1, MakeResponse(1));
+  cache.Insert(v2, MakeResponse(2));
+  EXPECT_FALSE(cache.Lookup(v1, &response));
+  ASSERT_TRUE(cache.Lookup(v2, &response));
+  EXPECT_EQ(2, response.outputs().at("y").float_val(0));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <unistd.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -27,11 +28,15 @@ limitations under the License.
 #include "grpc/grpc.h"
 #include "grpcpp/health_check_service_interface.h"
 #include "grpcpp/resource_quota.h"
+#include "grpcpp/security/credentials.h"
 #include "grpcpp/security/server_credentials.h"
 #include "grpcpp/server_builder.h"
 #include "grpcpp/server_context.h"
 #include "grpcpp/support/status.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
 #include "tensorflow/c/c_api.h"
 #include "tensorflow/cc/saved_model/tag_constants.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -48,14 +53,24 @@ limitations under the License.
 #include "tensorflow_serving/config/platform_config.pb.h"
 #include "tensorflow_serving/config/ssl_config.pb.h"
 #include "tensorflow_serving/core/availability_preserving_policy.h"
+#include "tensorflow_serving/experimental/tensorflow/ops/remote_predict/kernels/local_prediction_service.h"
+#include "tensorflow_serving/model_servers/grpc_peer_version_fetcher.h"
 #include "tensorflow_serving/model_servers/grpc_status_util.h"
 #include "tensorflow_serving/model_servers/model_platform_types.h"
 #include "tensorflow_serving/model_servers/server_core.h"
 #include "tensorflow_serving/model_servers/server_init.h"
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+#include "tensorflow_serving/servables/tensorflow/slow_requests.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory_config.pb.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
+#include "tensorflow_serving/util/cpu_set_env.h"
+#include "tensorflow_serving/util/memory_accounting.h"
+#include "tensorflow_serving/util/memory_reclaimer.h"
 #include "tensorflow_serving/util/proto_util.h"
+#include "tensorflow_serving/util/request_deadline.h"
+#include "tensorflow_serving/util/request_trace.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
 
 namespace tensorflow {
 namespace serving {
@@ -108,22 +123,36 @@ std::vector<GrpcChannelArgument> parseGrpcChannelArgs(
   return result;
 }
 
-// If 'use_alts_credentials', build secure server credentials using ALTS.
-// Else if 'ssl_config_file' is non-empty, build using ssl.
-// Otherwise use insecure channel.
-std::shared_ptr<::grpc::ServerCredentials> BuildServerCredentials(
-    bool use_alts_credentials, const string& ssl_config_file) {
+// Builds the credentials of the gRPC listening ports into '*credentials':
+// ALTS if 'use_alts_credentials', else SSL from the SSLConfig in
+// 'ssl_config_file' if it is non-empty, else insecure. They are built once and
+// shared by the ports, so the SSL config is read once. Returns an error if the
+// SSL config cannot be read, or lacks the server key or certificate.
+Status BuildServerCredentials(
+    bool use_alts_credentials, const string& ssl_config_file,
+    std::shared_ptr<::grpc::ServerCredentials>* credentials) {
   if (use_alts_credentials) {
     LOG(INFO) << "Using ALTS credentials";
     ::grpc::experimental::AltsServerCredentialsOptions alts_opts;
-    return ::grpc::experimental::AltsServerCredentials(alts_opts);
+    *credentials = ::grpc::experimental::AltsServerCredentials(alts_opts);
+    return OkStatus();
   } else if (ssl_config_file.empty()) {
     LOG(INFO) << "Using InsecureServerCredentials";
-    return ::grpc::InsecureServerCredentials();
+    *credentials = ::grpc::InsecureServerCredentials();
+    return OkStatus();
   }
 
   SSLConfig ssl_config;
-  TF_CHECK_OK(ParseProtoTextFile<SSLConfig>(ssl_config_file, &ssl_config));
+  TF_RETURN_IF_ERROR(
+      ParseProtoTextFile<SSLConfig>(ssl_config_file, &ssl_config));
+  if (ssl_config.server_key().empty() || ssl_config.server_cert().empty()) {
+    return errors::InvalidArgument(
+        "The SSLConfig in ", ssl_config_file,
+        " must have both a server_key and a server_cert");
+  }
+  // The TLS library resumes the sessions of clients that cache them, e.g.
+  // gRPC clients with a "grpc.ssl_session_cache", with the session tickets it
+  // issues, which spares them a full handshake on reconnecting.
   LOG(INFO) << "Using SSL credentials";
 
   ::grpc::SslServerCredentialsOptions ssl_ops(
@@ -142,7 +171,35 @@ std::shared_ptr<::grpc::ServerCredentials> BuildServerCredentials(
 
   ssl_ops.pem_key_cert_pairs.push_back(keycert);
 
-  return ::grpc::SslServerCredentials(ssl_ops);
+  *credentials = ::grpc::SslServerCredentials(ssl_ops);
+  return OkStatus();
+}
+
+// Builds the credentials of the channels to the model peers into
+// '*credentials'. The peers are servers configured like this one, so they
+// match BuildServerCredentials(): ALTS if 'use_alts_credentials', else SSL
+// trusting the custom CA of the SSLConfig in 'ssl_config_file', and presenting
+// the server certificate to peers that verify their clients, else insecure.
+Status BuildPeerChannelCredentials(
+    bool use_alts_credentials, const string& ssl_config_file,
+    std::shared_ptr<::grpc::ChannelCredentials>* credentials) {
+  if (use_alts_credentials) {
+    *credentials = ::grpc::experimental::AltsCredentials(
+        ::grpc::experimental::AltsCredentialsOptions());
+    return OkStatus();
+  } else if (ssl_config_file.empty()) {
+    *credentials = ::grpc::InsecureChannelCredentials();
+    return OkStatus();
+  }
+  SSLConfig ssl_config;
+  TF_RETURN_IF_ERROR(
+      ParseProtoTextFile<SSLConfig>(ssl_config_file, &ssl_config));
+  ::grpc::SslCredentialsOptions ssl_ops;
+  ssl_ops.pem_root_certs = ssl_config.custom_ca();
+  ssl_ops.pem_private_key = ssl_config.server_key();
+  ssl_ops.pem_cert_chain = ssl_config.server_cert();
+  *credentials = ::grpc::SslCredentials(ssl_ops);
+  return OkStatus();
 }
 
 }  // namespace
@@ -157,6 +214,11 @@ Server::~Server() {
   // until the thread has terminated.
   fs_config_polling_thread_.reset();
   WaitForTermination();
+  for (const string& address : local_prediction_addresses_) {
+    LocalPredictionServices::Unregister(address);
+  }
+  // Waits for the in-process requests in flight.
+  local_predict_thread_pool_.reset();
 }
 
 void Server::PollFilesystemAndReloadConfig(const string& config_file_path) {
@@ -176,6 +238,59 @@ void Server::PollFilesystemAndReloadConfig(const string& config_file_path) {
   }
 }
 
+void Server::RegisterLocalPredictionService(const Options& server_options) {
+  local_predictor_ =
+      absl::make_unique<TensorflowPredictor>(thread_pool_factory_.get());
+  // The requests run in threads of their own, like those of gRPC, rather than
+  // in the threads of the ops that send them, which may be needed to run them.
+  local_predict_thread_pool_ = absl::make_unique<thread::ThreadPool>(
+      Env::Default(), "local_predict",
+      std::max(1, server_options.grpc_max_threads));
+  const bool enforce_session_run_timeout =
+      server_options.enforce_session_run_timeout;
+  LocalPredictionServices::PredictFn predict =
+      [this, enforce_session_run_timeout](
+          absl::Time deadline, const PredictRequest* request,
+          PredictResponse* response, std::function<void(absl::Status)> done) {
+        local_predict_thread_pool_->Schedule([this, enforce_session_run_timeout,
+                                              deadline, request, response,
+                                              done]() {
+          const uint64_t start = Env::Default()->NowMicros();
+          RunOptions run_options;
+          if (enforce_session_run_timeout) {
+            run_options.set_timeout_in_ms(std::max<int64_t>(
+                1, absl::ToInt64Milliseconds(deadline - absl::Now())));
+          }
+          ScopedRequestDeadline deadline_scope(
+              std::make_shared<RequestDeadline>(
+                  enforce_session_run_timeout ? deadline
+                                              : absl::InfiniteFuture(),
+                  nullptr));
+          const Status status = local_predictor_->Predict(
+              run_options, server_core_.get(), *request, response);
+          const string& model_name = request->model_spec().name();
+          if (status.ok()) {
+            RecordRequestLatency(model_name, /*api=*/"Predict",
+                                 /*entrypoint=*/"InProcess",
+                                 Env::Default()->NowMicros() - start);
+          }
+          RecordModelRequestCount(model_name, status);
+          done(status);
+        });
+      };
+  if (server_options.grpc_port != 0) {
+    local_prediction_addresses_.push_back(
+        absl::StrCat("localhost:", server_options.grpc_port));
+  }
+  if (!server_options.grpc_socket_path.empty()) {
+    local_prediction_addresses_.push_back(
+        absl::StrCat("unix:", server_options.grpc_socket_path));
+  }
+  for (const string& address : local_prediction_addresses_) {
+    LocalPredictionServices::Register(address, predict);
+  }
+}
+
 Status Server::BuildAndStart(const Options& server_options) {
   if (server_options.grpc_port == 0 &&
       server_options.grpc_socket_path.empty()) {
@@ -191,6 +306,17 @@ Status Server::BuildAndStart(const Options& server_options) {
         "ssl_config_file must be empty.");
   }
 
+  std::vector<int> grpc_cpus;
+  std::vector<int> http_cpus;
+  std::vector<int> batch_thread_cpus;
+  std::vector<int> session_thread_cpus;
+  TF_RETURN_IF_ERROR(ParseCpuList(server_options.grpc_cpus, &grpc_cpus));
+  TF_RETURN_IF_ERROR(ParseCpuList(server_options.http_cpus, &http_cpus));
+  TF_RETURN_IF_ERROR(
+      ParseCpuList(server_options.batch_thread_cpus, &batch_thread_cpus));
+  TF_RETURN_IF_ERROR(
+      ParseCpuList(server_options.session_thread_cpus, &session_thread_cpus));
+
   if (server_options.model_base_path.empty() &&
       server_options.model_config_file.empty()) {
     return errors::InvalidArgument(
@@ -198,9 +324,70 @@ Status Server::BuildAndStart(const Options& server_options) {
         "server_options.model_config_file are empty!");
   }
 
+  if (server_options.http_num_event_loops < 1) {
+    return errors::InvalidArgument(
+        "server_options.http_num_event_loops must be positive; got ",
+        server_options.http_num_event_loops);
+  }
+  if (server_options.num_worker_processes > 1 &&
+      !server_options.grpc_socket_path.empty()) {
+    return errors::InvalidArgument(
+        "server_options.grpc_socket_path cannot be shared by ",
+        server_options.num_worker_processes, " worker processes");
+  }
+  if (server_options.http2_port < 0) {
+    return errors::InvalidArgument(
+        "server_options.http2_port must not be negative; got ",
+        server_options.http2_port);
+  }
+  if (server_options.http2_port != 0 &&
+      (server_options.http2_port == server_options.http_port ||
+       server_options.http2_port == server_options.grpc_port)) {
+    return errors::InvalidArgument(
+        "server_options.http2_port must differ from the HTTP/REST API and "
+        "gRPC ports; got ",
+        server_options.http2_port);
+  }
+  if (server_options.http_idle_timeout_in_ms < 0 ||
+      server_options.http_max_requests_per_connection < 0) {
+    return errors::InvalidArgument(
+        "server_options.http_idle_timeout_in_ms and "
+        "server_options.http_max_requests_per_connection must not be "
+        "negative");
+  }
+
   SetSignatureMethodNameCheckFeature(
       server_options.enable_signature_method_name_check);
 
+  if (server_options.trace_sampling_rate < 0 ||
+      server_options.trace_sampling_rate > 1) {
+    return errors::InvalidArgument(
+        "server_options.trace_sampling_rate must be in [0, 1]; got ",
+        server_options.trace_sampling_rate);
+  }
+  if (server_options.trace_sampling_rate > 0 ||
+      !server_options.trace_export_file.empty()) {
+    RequestTracer::Options tracer_options;
+    tracer_options.sampling_rate = server_options.trace_sampling_rate;
+    if (!server_options.trace_export_file.empty()) {
+      TF_RETURN_IF_ERROR(OtlpJsonFileSpanExporter::Create(
+          server_options.trace_export_file, &tracer_options.exporter));
+    }
+    TF_RETURN_IF_ERROR(RequestTracer::SetGlobal(
+        absl::make_unique<RequestTracer>(std::move(tracer_options))));
+  }
+  if (server_options.enable_memory_accounting) {
+    // Before models load, so that their memory is accounted for.
+    EnableMemoryAccounting();
+  }
+  if (server_options.enable_deferred_unload_release) {
+    MemoryReclaimer::Options reclaimer_options;
+    reclaimer_options.release_bytes_per_second =
+        server_options.unload_release_bytes_per_second;
+    TF_RETURN_IF_ERROR(MemoryReclaimer::SetGlobal(
+        absl::make_unique<MemoryReclaimer>(reclaimer_options)));
+  }
+
   // For ServerCore Options, we leave servable_state_monitor_creator unspecified
   // so the default servable_state_monitor_creator will be used.
   ServerCore::Options options;
@@ -230,6 +417,10 @@ Status Server::BuildAndStart(const Options& server_options) {
         TF_RETURN_IF_ERROR(ParseProtoTextFile<BatchingParameters>(
             server_options.batching_parameters_file, batching_parameters));
       }
+      if (!batch_thread_cpus.empty()) {
+        batching_parameters->mutable_batch_thread_cpus()->Assign(
+            batch_thread_cpus.begin(), batch_thread_cpus.end());
+      }
       if (server_options.enable_per_model_batching_params) {
         session_bundle_config.set_enable_per_model_batching_params(true);
       }
@@ -287,6 +478,33 @@ Status Server::BuildAndStart(const Options& server_options) {
           ->mutable_num_request_iterations()
           ->set_value(server_options.num_request_iterations_for_warmup);
     }
+    if (server_options.num_model_warmup_threads > 0) {
+      session_bundle_config.mutable_model_warmup_options()
+          ->mutable_num_model_warmup_threads()
+          ->set_value(server_options.num_model_warmup_threads);
+    }
+    if (server_options.max_concurrent_warmup_requests > 0) {
+      session_bundle_config.mutable_model_warmup_options()
+          ->mutable_max_concurrent_warmup_requests()
+          ->set_value(server_options.max_concurrent_warmup_requests);
+    }
+    if (server_options.capture_warmup_requests) {
+      CapturedWarmupRequests::Options captured_warmup_requests_options;
+      captured_warmup_requests_options.max_requests_per_model =
+          server_options.max_captured_warmup_requests_per_model;
+      CapturedWarmupRequests::Global()->Enable(
+          captured_warmup_requests_options);
+      session_bundle_config.mutable_model_warmup_options()
+          ->set_use_captured_warmup_requests(true);
+    }
+    if (server_options.slow_request_threshold_ms > 0) {
+      SlowRequests::Options slow_requests_options;
+      slow_requests_options.latency_threshold_micros =
+          server_options.slow_request_threshold_ms * 1000;
+      slow_requests_options.max_requests_per_model =
+          server_options.max_slow_requests_per_model;
+      SlowRequests::Global()->Enable(slow_requests_options);
+    }
     session_bundle_config.set_remove_unused_fields_from_bundle_metagraph(
         server_options.remove_unused_fields_from_bundle_metagraph);
     session_bundle_config.set_prefer_tflite_model(
@@ -295,6 +513,37 @@ Status Server::BuildAndStart(const Options& server_options) {
         server_options.num_tflite_interpreters_per_pool);
     session_bundle_config.set_num_tflite_pools(server_options.num_tflite_pools);
     session_bundle_config.set_mixed_precision(server_options.mixed_precision);
+    session_bundle_config.set_measure_resources_after_load(
+        server_options.measure_resources_after_load);
+    session_bundle_config.set_resource_measurement_history_path(
+        server_options.resource_measurement_history_path);
+    session_bundle_config.set_memmapped_variables_dir(
+        server_options.memmapped_variables_dir);
+    session_bundle_config.set_enable_delta_loading(
+        server_options.enable_delta_loading);
+    session_bundle_config.set_num_parallel_restore_threads(
+        server_options.num_parallel_restore_threads);
+    session_bundle_config.set_overlap_init_op_with_restore(
+        server_options.overlap_init_op_with_restore);
+    session_bundle_config.set_enable_prebuilt_lookup_tables(
+        server_options.enable_prebuilt_lookup_tables);
+    session_bundle_config.set_share_identical_variables(
+        server_options.share_identical_variables);
+    session_bundle_config.set_freeze_read_only_variables(
+        server_options.freeze_read_only_variables);
+    if (server_options.inline_run_max_graph_nodes > 0) {
+      session_bundle_config.set_inline_run_max_graph_nodes(
+          server_options.inline_run_max_graph_nodes);
+    }
+    session_bundle_config.mutable_session_thread_cpus()->Assign(
+        session_thread_cpus.begin(), session_thread_cpus.end());
+    if (server_options.enable_cost_accounting) {
+      // The costs are labeled by the names in the session metadata.
+      session_bundle_config.set_enable_session_metadata(true);
+      session_bundle_config.set_enable_cost_accounting(true);
+      session_bundle_config.set_cost_accounting_trace_interval(
+          server_options.cost_accounting_trace_interval);
+    }
 
     TF_RETURN_IF_ERROR(tf_serving_registry->GetSetupPlatformConfigMap()(
         session_bundle_config, options.platform_config_map));
@@ -310,17 +559,70 @@ Status Server::BuildAndStart(const Options& server_options) {
       std::unique_ptr<AspiredVersionPolicy>(new AvailabilityPreservingPolicy);
   options.num_load_threads = server_options.num_load_threads;
   options.num_unload_threads = server_options.num_unload_threads;
+  options.work_stealing_load_executor =
+      server_options.work_stealing_load_executor;
   options.max_num_load_retries = server_options.max_num_load_retries;
   options.load_retry_interval_micros =
       server_options.load_retry_interval_micros;
+  options.load_retry_backoff.multiplier =
+      server_options.load_retry_backoff_multiplier;
+  options.load_retry_backoff.max_interval_micros =
+      server_options.max_load_retry_interval_micros;
+  options.load_retry_backoff.jitter = server_options.load_retry_jitter;
+  options.load_retry_backoff.transient_error_interval_micros =
+      server_options.transient_load_retry_interval_micros;
+  options.load_retries_per_second = server_options.load_retries_per_second;
+  options.max_load_retry_burst = server_options.max_load_retry_burst;
   options.file_system_poll_wait_seconds =
       server_options.file_system_poll_wait_seconds;
+  options.watch_file_system_for_changes =
+      server_options.watch_file_system_for_changes;
+  options.num_file_system_poll_threads =
+      server_options.num_file_system_poll_threads;
+  options.max_file_system_poll_backoff_seconds =
+      server_options.max_file_system_poll_backoff_seconds;
+  options.model_cache_dir = server_options.model_cache_dir;
+  options.memory_pressure_high_watermark =
+      server_options.memory_pressure_high_watermark;
+  options.memory_pressure_low_watermark =
+      server_options.memory_pressure_low_watermark;
+  options.num_cached_model_versions_to_retain =
+      server_options.num_cached_model_versions_to_retain;
+  options.fetch_model_versions_in_background =
+      server_options.fetch_model_versions_in_background;
+  options.state_snapshot_path = server_options.state_snapshot_path;
+  if (!server_options.model_peers.empty()) {
+    if (server_options.model_cache_dir.empty()) {
+      return errors::InvalidArgument(
+          "model_peers requires model_cache_dir to be set");
+    }
+    GrpcPeerVersionFetcher::Options fetcher_options;
+    fetcher_options.peers = absl::StrSplit(server_options.model_peers, ',',
+                                           absl::SkipEmpty());
+    TF_RETURN_IF_ERROR(BuildPeerChannelCredentials(
+        server_options.use_alts_credentials, server_options.ssl_config_file,
+        &fetcher_options.channel_credentials));
+    std::unique_ptr<GrpcPeerVersionFetcher> fetcher;
+    TF_RETURN_IF_ERROR(
+        GrpcPeerVersionFetcher::Create(fetcher_options, &fetcher));
+    options.model_peer_fetcher = std::move(fetcher);
+  }
   options.flush_filesystem_caches = server_options.flush_filesystem_caches;
+  options.use_per_thread_handle_refs =
+      server_options.use_per_thread_handle_refs;
+  options.enable_batch_load_approval =
+      server_options.enable_batch_load_approval;
+  options.async_servable_event_publication =
+      server_options.async_servable_event_publication;
+  options.max_num_concurrent_version_transitions =
+      server_options.max_num_concurrent_version_transitions;
   options.allow_version_labels_for_unavailable_models =
       server_options.allow_version_labels_for_unavailable_models;
   options.force_allow_any_version_labels_for_unavailable_models =
       server_options.force_allow_any_version_labels_for_unavailable_models;
   options.enable_cors_support = server_options.enable_cors_support;
+  options.compact_json_responses = server_options.compact_json_responses;
+  options.server_timing_header = server_options.server_timing_header;
 
   TF_RETURN_IF_ERROR(ServerCore::Create(std::move(options), &server_core_));
 
@@ -361,26 +663,47 @@ Status Server::BuildAndStart(const Options& server_options) {
         &thread_pool_factory_));
   }
   predict_server_options.thread_pool_factory = thread_pool_factory_.get();
-  prediction_service_ =
-      tf_serving_registry->GetCreatePredictionService()(predict_server_options);
+  if (server_options.enable_async_predict) {
+    prediction_service_ =
+        absl::make_unique<AsyncPredictionServiceImpl>(predict_server_options);
+  } else {
+    prediction_service_ = tf_serving_registry->GetCreatePredictionService()(
+        predict_server_options);
+  }
 
+  std::shared_ptr<::grpc::ServerCredentials> server_credentials;
+  TF_RETURN_IF_ERROR(BuildServerCredentials(
+      server_options.use_alts_credentials, server_options.ssl_config_file,
+      &server_credentials));
   ::grpc::ServerBuilder builder;
   // If defined, listen to a tcp port for gRPC/HTTP.
   if (server_options.grpc_port != 0) {
-    builder.AddListeningPort(
-        server_address,
-        BuildServerCredentials(server_options.use_alts_credentials,
-                               server_options.ssl_config_file));
+    builder.AddListeningPort(server_address, server_credentials);
   }
   // If defined, listen to a UNIX socket for gRPC.
   if (!server_options.grpc_socket_path.empty()) {
     const string grpc_socket_uri = "unix:" + server_options.grpc_socket_path;
-    builder.AddListeningPort(
-        grpc_socket_uri,
-        BuildServerCredentials(server_options.use_alts_credentials,
-                               server_options.ssl_config_file));
+    builder.AddListeningPort(grpc_socket_uri, server_credentials);
   }
   builder.RegisterService(model_service_.get());
+  if (server_options.enable_model_file_service) {
+    if (server_options.model_cache_dir.empty()) {
+      return errors::InvalidArgument(
+          "--enable_model_file_service requires --model_cache_dir");
+    }
+    model_file_service_ =
+        absl::make_unique<ModelFileServiceImpl>(server_core_.get());
+    builder.RegisterService(model_file_service_.get());
+  }
+  if (server_options.enable_shared_memory) {
+    if (server_options.grpc_socket_path.empty()) {
+      return errors::InvalidArgument(
+          "--enable_shared_memory requires --grpc_socket_path, as only the "
+          "clients on the UNIX socket can use shared memory");
+    }
+    shared_memory_service_ = absl::make_unique<SharedMemoryServiceImpl>();
+    builder.RegisterService(shared_memory_service_.get());
+  }
   builder.RegisterService(prediction_service_.get());
   if (server_options.enable_profiler) {
     profiler_service_ = tensorflow::profiler::CreateProfilerService();
@@ -388,6 +711,10 @@ Status Server::BuildAndStart(const Options& server_options) {
     LOG(INFO) << "Profiler service is enabled";
   }
   builder.SetMaxMessageSize(tensorflow::kint32max);
+  if (server_options.num_worker_processes > 1) {
+    // Lets the other worker processes listen on the port too.
+    builder.AddChannelArgument(GRPC_ARG_ALLOW_REUSEPORT, 1);
+  }
   const std::vector<GrpcChannelArgument> channel_arguments =
       parseGrpcChannelArgs(server_options.grpc_channel_arguments);
   for (const GrpcChannelArgument& channel_argument : channel_arguments) {
@@ -407,18 +734,28 @@ Status Server::BuildAndStart(const Options& server_options) {
   builder.SetResourceQuota(res_quota);
   ::grpc::EnableDefaultHealthCheckService(
       server_options.enable_grpc_healthcheck_service);
-  grpc_server_ = builder.BuildAndStart();
-
-  if (server_options.enable_grpc_healthcheck_service) {
-    grpc_server_->GetHealthCheckService()->SetServingStatus("ModelService",
-                                                            true);
-    grpc_server_->GetHealthCheckService()->SetServingStatus("PredictionService",
-                                                            true);
+  {
+    // The threads gRPC starts inherit the CPUs.
+    ScopedThreadCpus scoped_cpus(grpc_cpus);
+    grpc_server_ = builder.BuildAndStart();
   }
 
   if (grpc_server_ == nullptr) {
     return errors::InvalidArgument("Failed to BuildAndStart gRPC server");
   }
+  if (server_options.enable_grpc_healthcheck_service) {
+    HealthReporter::Options health_options;
+    health_options.max_saturation =
+        server_options.grpc_healthcheck_max_saturation;
+    ::grpc::HealthCheckServiceInterface* health_service =
+        grpc_server_->GetHealthCheckService();
+    health_reporter_ = absl::make_unique<HealthReporter>(
+        health_options, server_core_->servable_state_monitor(),
+        SaturationMonitor::Global(),
+        [health_service](const string& service, bool serving) {
+          health_service->SetServingStatus(service, serving);
+        });
+  }
   if (server_options.grpc_port != 0) {
     LOG(INFO) << "Running gRPC ModelServer at " << server_address << " ...";
   }
@@ -426,6 +763,9 @@ Status Server::BuildAndStart(const Options& server_options) {
     LOG(INFO) << "Running gRPC ModelServer at UNIX socket "
               << server_options.grpc_socket_path << " ...";
   }
+  if (server_options.in_process_remote_predict) {
+    RegisterLocalPredictionService(server_options);
+  }
 
   if (server_options.http_port != 0) {
     if (server_options.http_port != server_options.grpc_port) {
@@ -436,9 +776,17 @@ Status Server::BuildAndStart(const Options& server_options) {
         TF_RETURN_IF_ERROR(ParseProtoTextFile<MonitoringConfig>(
             server_options.monitoring_config_file, &monitoring_config));
       }
+      // As for gRPC, the event loop and handler threads inherit the CPUs.
+      ScopedThreadCpus scoped_cpus(http_cpus);
       http_server_ = CreateAndStartHttpServer(
-          server_options.http_port, server_options.http_num_threads,
-          server_options.http_timeout_in_ms, monitoring_config,
+          server_options.http_port, server_options.http2_port,
+          server_options.http_num_threads,
+          server_options.http_work_stealing_executor,
+          server_options.http_num_event_loops,
+          /*reuse_port=*/server_options.num_worker_processes > 1,
+          server_options.http_timeout_in_ms,
+          server_options.http_idle_timeout_in_ms,
+          server_options.http_max_requests_per_connection, monitoring_config,
           server_core_.get());
       if (http_server_ != nullptr) {
         LOG(INFO) << "Exporting HTTP/REST API at:" << server_address << " ...";
@@ -17,17 +17,22 @@ limitations under the License.
 #define TENSORFLOW_SERVING_MODEL_SERVERS_SERVER_H_
 
 #include <memory>
+#include <vector>
 
 #include "grpcpp/server.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/profiler/rpc/profiler_service_impl.h"
 #include "tensorflow_serving/model_servers/http_server.h"
+#include "tensorflow_serving/model_servers/model_file_service_impl.h"
+#include "tensorflow_serving/model_servers/health_reporter.h"
 #include "tensorflow_serving/model_servers/model_service_impl.h"
 #include "tensorflow_serving/model_servers/prediction_service_impl.h"
 #include "tensorflow_serving/model_servers/server_core.h"
+#include "tensorflow_serving/model_servers/shared_memory_service_impl.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 
 namespace tensorflow {
@@ -44,14 +49,37 @@ class Server {
     tensorflow::string grpc_channel_arguments;
     tensorflow::string grpc_socket_path;
     tensorflow::int32 grpc_max_threads = 4.0 * port::NumSchedulableCPUs();
+    // If true, the PredictionService uses the gRPC callback API, so Predict
+    // requests waiting to be batched do not hold gRPC threads.
+    bool enable_async_predict = false;
+    // If true, RemotePredict ops run by this process that target its gRPC
+    // port or socket call its PredictionService directly, rather than over
+    // gRPC.
+    bool in_process_remote_predict = true;
+
+    //
+    // Worker process options.
+    //
+    // The number of processes serving the models, each running a Server (see
+    // worker_processes.h). With more than one, each process binds the gRPC
+    // and HTTP ports with SO_REUSEPORT, so that the kernel spreads the
+    // connections across them.
+    tensorflow::int32 num_worker_processes = 1;
 
     //
     // HTTP Server options.
     //
     tensorflow::int32 http_port = 0;
+    tensorflow::int32 http2_port = 0;  // No HTTP/2.
     tensorflow::int32 http_num_threads = 4.0 * port::NumSchedulableCPUs();
+    bool http_work_stealing_executor = false;
+    tensorflow::int32 http_num_event_loops = 1;
+    tensorflow::int32 http_idle_timeout_in_ms = 0;  // libevent's default.
+    tensorflow::int64 http_max_requests_per_connection = 0;  // No limit.
     tensorflow::int32 http_timeout_in_ms = 30000;  // 30 seconds.
     bool enable_cors_support = false;
+    bool compact_json_responses = false;
+    bool server_timing_header = false;
 
     //
     // Model Server options.
@@ -65,10 +93,32 @@ class Server {
     tensorflow::string model_name;
     tensorflow::int32 num_load_threads = 0;
     tensorflow::int32 num_unload_threads = 0;
+    bool work_stealing_load_executor = false;
     tensorflow::int32 max_num_load_retries = 5;
     int64_t load_retry_interval_micros = 1LL * 60 * 1000 * 1000;
+    float load_retry_backoff_multiplier = 1;
+    int64_t max_load_retry_interval_micros = 0;
+    float load_retry_jitter = 0;
+    int64_t transient_load_retry_interval_micros = -1;
+    float load_retries_per_second = 0;
+    float max_load_retry_burst = 10;
     tensorflow::int32 file_system_poll_wait_seconds = 1;
+    bool watch_file_system_for_changes = false;
+    tensorflow::int32 num_file_system_poll_threads = 0;
+    int64_t max_file_system_poll_backoff_seconds = 0;
+    tensorflow::string model_cache_dir;
+    tensorflow::int32 num_cached_model_versions_to_retain = 2;
+    bool fetch_model_versions_in_background = false;
+    tensorflow::string model_peers;
+    bool enable_model_file_service = false;
+    tensorflow::string state_snapshot_path;
+    float memory_pressure_high_watermark = 0;
+    float memory_pressure_low_watermark = 0.8;
     bool flush_filesystem_caches = true;
+    bool use_per_thread_handle_refs = false;
+    bool enable_batch_load_approval = false;
+    bool async_servable_event_publication = false;
+    tensorflow::int32 max_num_concurrent_version_transitions = 0;
     tensorflow::string model_base_path;
     tensorflow::string saved_model_tags;
     // Tensorflow session parallelism of zero means that both inter and intra op
@@ -91,7 +141,24 @@ class Server {
     bool enable_model_warmup = true;
     // This value is used only if > 0.
     tensorflow::int32 num_request_iterations_for_warmup = 0;
+    // These values are used only if > 0.
+    tensorflow::int32 num_model_warmup_threads = 0;
+    tensorflow::int32 max_concurrent_warmup_requests = 0;
+    // If true, samples the live requests to each model, to warm up later
+    // versions of the model that ship no warmup data.
+    bool capture_warmup_requests = false;
+    tensorflow::int32 max_captured_warmup_requests_per_model = 1000;
+    // If > 0, captures the requests to each model that take at least this
+    // long, with their latency breakdown, for the /monitoring/slow_requests
+    // HTTP endpoint.
+    tensorflow::int64 slow_request_threshold_ms = 0;
+    tensorflow::int32 max_slow_requests_per_model = 100;
     tensorflow::string monitoring_config_file;
+    // The fraction of requests to trace, of those whose callers sent no W3C
+    // trace context, and the file to export the spans of traced requests to,
+    // as OTLP/JSON. Tracing is off unless either is set.
+    double trace_sampling_rate = 0;
+    tensorflow::string trace_export_file;
     // Tensorflow session run options.
     bool enforce_session_run_timeout = true;
     bool remove_unused_fields_from_bundle_metagraph = true;
@@ -101,10 +168,40 @@ class Server {
     tensorflow::string thread_pool_factory_config_file;
     bool enable_signature_method_name_check = false;
     bool enable_profiler = true;
+    bool enable_shared_memory = false;
     tensorflow::string mixed_precision;
+    bool measure_resources_after_load = false;
+    tensorflow::string resource_measurement_history_path;
+    tensorflow::string memmapped_variables_dir;
+    bool enable_delta_loading = false;
+    tensorflow::int32 num_parallel_restore_threads = 0;
+    bool overlap_init_op_with_restore = false;
+    bool enable_prebuilt_lookup_tables = false;
+    bool share_identical_variables = false;
+    bool freeze_read_only_variables = false;
+    tensorflow::int32 inline_run_max_graph_nodes = 0;
+    bool enable_cost_accounting = false;
+    tensorflow::int32 cost_accounting_trace_interval = 1000;
+    // If true, exports the memory breakdown of MemoryAccounting.
+    bool enable_memory_accounting = false;
+    // If true, unloaded servables are freed by a MemoryReclaimer, which
+    // returns their memory to the OS at up to this rate (0 for no limit).
+    bool enable_deferred_unload_release = false;
+    tensorflow::int64 unload_release_bytes_per_second = 0;
+    // The CPUs to run the threads of the server on, as lists like "0-3,8"
+    // (on Linux): the gRPC threads, the HTTP event loops and handler threads,
+    // the batch threads and the thread pools of the sessions. Partitioning
+    // the CPUs between them keeps e.g. the network threads from preempting
+    // the session threads. Empty lists run them on all CPUs.
+    tensorflow::string grpc_cpus;
+    tensorflow::string http_cpus;
+    tensorflow::string batch_thread_cpus;
+    tensorflow::string session_thread_cpus;
     bool skip_initialize_tpu = false;
     // Misc GRPC features
     bool enable_grpc_healthcheck_service = false;
+    // If positive, the saturation at which the health check sheds load.
+    float grpc_healthcheck_max_saturation = 0;
     Options();
   };
 
@@ -125,16 +222,30 @@ class Server {
   // ServerCore::ReloadConfig with the captured model config.
   void PollFilesystemAndReloadConfig(const string& config_file_path);
 
+  // Registers the PredictionService of this server with
+  // LocalPredictionServices, at the addresses it serves gRPC at.
+  void RegisterLocalPredictionService(const Options& server_options);
+
   std::unique_ptr<ServerCore> server_core_;
   std::unique_ptr<ModelServiceImpl> model_service_;
+  std::unique_ptr<ModelFileServiceImpl> model_file_service_;
+  std::unique_ptr<SharedMemoryServiceImpl> shared_memory_service_;
   std::unique_ptr<PredictionService::Service> prediction_service_;
   std::unique_ptr<tensorflow::grpc::ProfilerService::Service> profiler_service_;
   std::unique_ptr<::grpc::Server> grpc_server_;
+  // Sets the health check statuses, if 'enable_grpc_healthcheck_service'.
+  // Declared after 'grpc_server_', to be destroyed before it.
+  std::unique_ptr<HealthReporter> health_reporter_;
   std::unique_ptr<net_http::HTTPServerInterface> http_server_;
   // A thread that calls PollFilesystemAndReloadConfig() periodically if
   // fs_model_config_poll_wait_seconds > 0.
   std::unique_ptr<PeriodicFunction> fs_config_polling_thread_;
   std::unique_ptr<ThreadPoolFactory> thread_pool_factory_;
+  // Serve the requests of the RemotePredict ops of this process that target
+  // this server, if 'in_process_remote_predict'.
+  std::unique_ptr<TensorflowPredictor> local_predictor_;
+  std::unique_ptr<thread::ThreadPool> local_predict_thread_pool_;
+  std::vector<string> local_prediction_addresses_;
 };
 
 }  // namespace main
@@ -16,24 +16,38 @@ limitations under the License.
 #include "tensorflow_serving/model_servers/server_core.h"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 #include <map>
 #include <memory>
 #include <set>
 #include <utility>
 #include <vector>
 
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "google/protobuf/any.pb.h"
 #include "google/protobuf/wrappers.pb.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/hash.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow_serving/config/file_system_storage_path_source.pb.h"
 #include "tensorflow_serving/core/load_servables_fast.h"
 #include "tensorflow_serving/model_servers/model_platform_types.h"
 #include "tensorflow_serving/resources/resource_values.h"
+#include "tensorflow_serving/servables/tensorflow/bundle_factory_util.h"
+#include "tensorflow_serving/servables/tensorflow/dedicated_thread_pool_factory.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_source_adapter.h"
 #include "tensorflow_serving/sources/storage_path/file_system_storage_path_source.h"
+#include "tensorflow_serving/util/request_deadline.h"
+#include "tensorflow_serving/util/sharded_metrics.h"
 
 namespace tensorflow {
 namespace serving {
@@ -82,12 +96,234 @@ bool UriIsRelativePath(StringPiece uri) {
   return scheme.empty() && host.empty() && !io::IsAbsolutePath(path);
 }
 
+// Returns an error if 'config' of the model 'model_name' is invalid.
+Status ValidateConcurrencyLimitConfig(const string& model_name,
+                                      const ConcurrencyLimitConfig& config) {
+  if (config.max_in_flight_requests() <= 0 ||
+      config.max_queued_requests() < 0) {
+    return errors::InvalidArgument(
+        "Expected the concurrency limits of model ", model_name,
+        " to allow a positive number of requests in flight, and a "
+        "non-negative number queued; got ",
+        config.ShortDebugString());
+  }
+  return absl::OkStatus();
+}
+
+// Returns the key of the allocation of dedicated thread pools of the model
+// with 'config', which models with the same pool name share.
+string ThreadPoolKey(const ModelConfig& config) {
+  const string& pool_name = config.thread_pool_config().pool_name();
+  return pool_name.empty() ? strings::StrCat("model/", config.name())
+                           : strings::StrCat("pool/", pool_name);
+}
+
+// Returns whether 'options' create the pools configured by 'config'.
+bool ThreadPoolOptionsMatch(const DedicatedThreadPoolFactory::Options& options,
+                            const ModelThreadPoolConfig& config) {
+  return options.num_inter_op_threads == config.num_inter_op_threads() &&
+         options.num_intra_op_threads == config.num_intra_op_threads() &&
+         options.inline_max_cost_micros == config.inline_max_cost_micros() &&
+         options.large_min_cost_micros == config.large_min_cost_micros() &&
+         options.num_large_intra_op_threads ==
+             config.num_large_intra_op_threads() &&
+         std::equal(options.cpus.begin(), options.cpus.end(),
+                    config.cpus().begin(), config.cpus().end());
+}
+
+// Returns the load priorities of the models of 'config' that have one.
+std::map<string, int32> GetLoadPriorities(const ModelConfigList& config) {
+  std::map<string, int32> load_priorities;
+  for (const ModelConfig& model : config.config()) {
+    if (model.load_priority() != 0) {
+      load_priorities[model.name()] = model.load_priority();
+    }
+  }
+  return load_priorities;
+}
+
+// Returns 'existing' if it limits concurrency per 'config', else a new limiter
+// named 'name', of the model 'model_name'.
+std::shared_ptr<ConcurrencyLimiter> ReuseOrCreateConcurrencyLimiter(
+    const string& name, const string& model_name,
+    const ConcurrencyLimitConfig& config,
+    std::shared_ptr<ConcurrencyLimiter> existing) {
+  if (existing != nullptr &&
+      existing->options().max_in_flight_requests ==
+          config.max_in_flight_requests() &&
+      existing->options().max_queued_requests ==
+          config.max_queued_requests()) {
+    return existing;
+  }
+  ConcurrencyLimiter::Options options;
+  options.name = name;
+  options.model_name = model_name;
+  options.max_in_flight_requests = config.max_in_flight_requests();
+  options.max_queued_requests = config.max_queued_requests();
+  return std::make_shared<ConcurrencyLimiter>(options);
+}
+
+auto* version_request_count = ShardedCounter<2>::New(
+    "/tensorflow/serving/version_request_count",
+    "The number of requests to each version of the models with weighted "
+    "version labels.",
+    "model_name", "version");
+
+auto* version_request_latency = ShardedSampler<2>::New(
+    {
+        "/tensorflow/serving/version_request_latency",
+        "Distribution of the time (in microseconds) that requests to each "
+        "version of the models with weighted version labels hold it.",
+        "model_name",
+        "version",
+    },  // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+    monitoring::Buckets::Exponential(10, 1.8, 33));
+
+// A servable handle that counts its request towards the metrics of its
+// version, and times how long it is held.
+class TimedServableHandle final : public UntypedServableHandle {
+ public:
+  explicit TimedServableHandle(std::unique_ptr<UntypedServableHandle> handle)
+      : handle_(std::move(handle)),
+        version_(std::to_string(handle_->id().version)),
+        start_micros_(Env::Default()->NowMicros()) {
+    version_request_count->GetCell(handle_->id().name, version_)
+        ->IncrementBy(1);
+  }
+  ~TimedServableHandle() override {
+    version_request_latency->GetCell(handle_->id().name, version_)
+        ->Add(Env::Default()->NowMicros() - start_micros_);
+  }
+
+  AnyPtr servable() override { return handle_->servable(); }
+
+  const ServableId& id() const override { return handle_->id(); }
+
+  uint64_t load_generation() const override {
+    return handle_->load_generation();
+  }
+
+ private:
+  const std::unique_ptr<UntypedServableHandle> handle_;
+  const string version_;
+  const uint64_t start_micros_;
+};
+
+// A servable handle that holds the admissions of its request by concurrency
+// limiters.
+class AdmittedServableHandle final : public UntypedServableHandle {
+ public:
+  AdmittedServableHandle(
+      std::unique_ptr<UntypedServableHandle> handle,
+      std::vector<std::unique_ptr<ConcurrencyLimiter::Permit>> permits)
+      : handle_(std::move(handle)), permits_(std::move(permits)) {}
+  ~AdmittedServableHandle() override = default;
+
+  AnyPtr servable() override { return handle_->servable(); }
+
+  const ServableId& id() const override { return handle_->id(); }
+
+  uint64_t load_generation() const override {
+    return handle_->load_generation();
+  }
+
+ private:
+  const std::unique_ptr<UntypedServableHandle> handle_;
+  const std::vector<std::unique_ptr<ConcurrencyLimiter::Permit>> permits_;
+};
+
 // Returns an error if 'config_list' is invalid in some way, e.g. a model name
 // appearing multiple times.
+// The load retry policies of the models of 'config_list' that have them, by
+// model name.
+std::map<string, BasicManager::LoadRetryPolicy> GetLoadRetryPolicies(
+    const ModelConfigList& config_list) {
+  std::map<string, BasicManager::LoadRetryPolicy> policies;
+  for (const ModelConfig& config : config_list.config()) {
+    if (!config.has_load_retry_policy()) {
+      continue;
+    }
+    const LoadRetryPolicy& proto = config.load_retry_policy();
+    BasicManager::LoadRetryPolicy& policy = policies[config.name()];
+    policy.max_num_load_retries = proto.max_num_retries();
+    policy.load_retry_interval_micros = proto.retry_interval_micros();
+    policy.load_retry_backoff.multiplier =
+        proto.backoff_multiplier() == 0 ? 1 : proto.backoff_multiplier();
+    policy.load_retry_backoff.max_interval_micros =
+        proto.max_retry_interval_micros();
+    policy.load_retry_backoff.jitter = proto.jitter();
+    policy.load_retry_backoff.transient_error_interval_micros =
+        proto.transient_error_retry_interval_micros() > 0
+            ? proto.transient_error_retry_interval_micros()
+            : -1;
+  }
+  return policies;
+}
+
+// Returns an error if a pipeline of 'config_list' is invalid, e.g. takes a
+// tensor of a stage that does not run before it. 'model_names' are the names
+// of the models of 'config_list'.
+Status ValidateModelPipelines(const ModelConfigList& config_list,
+                              const std::set<string>& model_names) {
+  std::set<string> pipeline_names;
+  for (const ModelPipelineConfig& pipeline : config_list.pipelines()) {
+    if (pipeline.name().empty() || model_names.count(pipeline.name()) > 0 ||
+        !pipeline_names.insert(pipeline.name()).second) {
+      return errors::InvalidArgument(
+          "Expected pipeline names to be non-empty, and distinct from each "
+          "other and from the model names; got ",
+          pipeline.name());
+    }
+    if (pipeline.stages().empty() || pipeline.outputs().empty()) {
+      return errors::InvalidArgument("Pipeline ", pipeline.name(),
+                                     " has no stages or no outputs");
+    }
+    // The stages before the one being validated.
+    std::set<string> stage_names;
+    auto validate_tensor = [&](const PipelineTensor& tensor) -> Status {
+      if (tensor.alias().empty() ||
+          (!tensor.stage().empty() && stage_names.count(tensor.stage()) == 0)) {
+        return errors::InvalidArgument(
+            "Pipeline ", pipeline.name(),
+            " takes a tensor that is not the output of an earlier stage or "
+            "an input: ",
+            tensor.ShortDebugString());
+      }
+      return OkStatus();
+    };
+    for (const PipelineStage& stage : pipeline.stages()) {
+      if (model_names.count(stage.model_name()) == 0) {
+        return errors::InvalidArgument("Model ", stage.model_name(),
+                                       " of pipeline ", pipeline.name(),
+                                       " is not in the config list");
+      }
+      for (const auto& input : stage.inputs()) {
+        TF_RETURN_IF_ERROR(validate_tensor(input.second));
+      }
+      if (stage.name().empty() || !stage_names.insert(stage.name()).second) {
+        return errors::InvalidArgument(
+            "Expected the stages of pipeline ", pipeline.name(),
+            " to have distinct non-empty names; got ", stage.name());
+      }
+    }
+    for (const auto& output : pipeline.outputs()) {
+      if (output.second.stage().empty()) {
+        return errors::InvalidArgument("Output ", output.first,
+                                       " of pipeline ", pipeline.name(),
+                                       " is not the output of a stage");
+      }
+      TF_RETURN_IF_ERROR(validate_tensor(output.second));
+    }
+  }
+  return OkStatus();
+}
+
 Status ValidateModelConfigList(const ModelConfigList& config_list,
                                const ServerCore::Options& options) {
   // Unique model-names.
   std::set<string> model_names;
+  // The thread pool config of each allocation of dedicated pools.
+  std::map<string, const ModelThreadPoolConfig*> thread_pool_configs;
   for (const ModelConfig& config : config_list.config()) {
     if (model_names.find(config.name()) != model_names.end()) {
       return errors::InvalidArgument(
@@ -95,7 +331,124 @@ Status ValidateModelConfigList(const ModelConfigList& config_list,
                           " multiple times in config list"));
     }
     model_names.insert(config.name());
+    if (config.has_response_cache_config() &&
+        config.response_cache_config().max_bytes() <= 0) {
+      return errors::InvalidArgument(
+          "Expected model ", config.name(),
+          " to have a positive response_cache_config.max_bytes; got ",
+          config.response_cache_config().max_bytes());
+    }
+    if (config.has_concurrency_limit()) {
+      TF_RETURN_IF_ERROR(ValidateConcurrencyLimitConfig(
+          config.name(), config.concurrency_limit()));
+    }
+    if (config.float_output_dtype() != DT_INVALID &&
+        config.float_output_dtype() != DT_FLOAT &&
+        config.float_output_dtype() != DT_BFLOAT16 &&
+        config.float_output_dtype() != DT_HALF) {
+      return errors::InvalidArgument(
+          "Expected model ", config.name(),
+          " to have a float_output_dtype of DT_FLOAT, DT_BFLOAT16 or DT_HALF; "
+          "got ",
+          DataTypeString(config.float_output_dtype()));
+    }
+    if (config.has_batching_parameters()) {
+      const Status status =
+          ValidateLiveBatchingParameters(config.batching_parameters());
+      if (!status.ok()) {
+        return errors::InvalidArgument(
+            "Invalid batching_parameters of model ", config.name(), ": ",
+            status.message());
+      }
+    }
+    for (const auto& label_and_limit :
+         config.version_label_concurrency_limits()) {
+      TF_RETURN_IF_ERROR(ValidateConcurrencyLimitConfig(
+          config.name(), label_and_limit.second));
+    }
+    for (const auto& label_and_versions : config.weighted_version_labels()) {
+      const string& label = label_and_versions.first;
+      if (config.version_labels().count(label) > 0) {
+        return errors::InvalidArgument(
+            "Label ", label, " of model ", config.name(),
+            " can't be both a version label and a weighted version label");
+      }
+      if (label_and_versions.second.weights().empty()) {
+        return errors::InvalidArgument("Weighted version label ", label,
+                                       " of model ", config.name(),
+                                       " has no versions");
+      }
+      for (const auto& version_and_weight :
+           label_and_versions.second.weights()) {
+        if (!(version_and_weight.second > 0) ||
+            !std::isfinite(version_and_weight.second)) {
+          return errors::InvalidArgument(
+              "Expected the weights of weighted version label ", label,
+              " of model ", config.name(), " to be positive; got ",
+              version_and_weight.second, " for version ",
+              version_and_weight.first);
+        }
+      }
+    }
+    for (const ModelVariant& variant : config.variants()) {
+      if (variant.model_name() == config.name() ||
+          variant.max_batch_size() < 0 ||
+          variant.min_latency_budget_micros() < 0) {
+        return errors::InvalidArgument(
+            "Expected the variants of model ", config.name(),
+            " to be other models, with non-negative limits; got ",
+            variant.ShortDebugString());
+      }
+    }
+    if (config.has_load_retry_policy()) {
+      const LoadRetryPolicy& policy = config.load_retry_policy();
+      if ((policy.backoff_multiplier() != 0 &&
+           !(policy.backoff_multiplier() >= 1)) ||
+          !std::isfinite(policy.backoff_multiplier()) ||
+          !(policy.jitter() >= 0 && policy.jitter() <= 1)) {
+        return errors::InvalidArgument(
+            "Expected the load retry policy of model ", config.name(),
+            " to have a backoff_multiplier of at least 1 and a jitter in "
+            "[0, 1]; got ",
+            policy.ShortDebugString());
+      }
+    }
+    if (config.has_thread_pool_config()) {
+      const ModelThreadPoolConfig& pool_config = config.thread_pool_config();
+      if (pool_config.num_inter_op_threads() < 0 ||
+          pool_config.num_intra_op_threads() < 0 ||
+          std::any_of(pool_config.cpus().begin(), pool_config.cpus().end(),
+                      [](int cpu) { return cpu < 0; })) {
+        return errors::InvalidArgument(
+            "Expected the thread pools of model ", config.name(),
+            " to have non-negative numbers of threads and CPUs; got ",
+            pool_config.ShortDebugString());
+      }
+      const ModelThreadPoolConfig*& shared_config =
+          thread_pool_configs[ThreadPoolKey(config)];
+      if (shared_config != nullptr &&
+          shared_config->SerializeAsString() !=
+              pool_config.SerializeAsString()) {
+        return errors::InvalidArgument(
+            "Models sharing the thread pools ", pool_config.pool_name(),
+            " must configure them identically; got ",
+            shared_config->ShortDebugString(), " and ",
+            pool_config.ShortDebugString(), " for model ", config.name());
+      }
+      shared_config = &pool_config;
+    }
+  }
+
+  for (const ModelConfig& config : config_list.config()) {
+    for (const ModelVariant& variant : config.variants()) {
+      if (model_names.count(variant.model_name()) == 0) {
+        return errors::InvalidArgument("Variant ", variant.model_name(),
+                                       " of model ", config.name(),
+                                       " is not in the config list");
+      }
+    }
   }
+  TF_RETURN_IF_ERROR(ValidateModelPipelines(config_list, model_names));
 
   // Base-paths are either all relative, or all absolute.
   // WARNING: abuse of terminology!  These "paths" may be URIs :-(
@@ -170,6 +523,56 @@ Status UnionRoutes(const DynamicSourceRouter<StoragePath>::Routes& a,
   return absl::OkStatus();
 }
 
+// Returns whether 'a' and 'b' are the same, comparing their deterministic
+// serializations, so that the order of map entries doesn't matter.
+bool ProtosEqual(const protobuf::MessageLite& a,
+                 const protobuf::MessageLite& b) {
+  string serialized_a;
+  string serialized_b;
+  return SerializeToStringDeterministic(a, &serialized_a) &&
+         SerializeToStringDeterministic(b, &serialized_b) &&
+         serialized_a == serialized_b;
+}
+
+// Returns the weighted version labels of 'model_config', ordered.
+std::map<string, std::map<int64_t, double>> GetWeightedVersionLabels(
+    const ModelConfig& model_config) {
+  std::map<string, std::map<int64_t, double>> labels;
+  for (const auto& label_and_versions :
+       model_config.weighted_version_labels()) {
+    labels[label_and_versions.first].insert(
+        label_and_versions.second.weights().begin(),
+        label_and_versions.second.weights().end());
+  }
+  return labels;
+}
+
+// Finds the models of 'new_config_list' whose version labels need to be
+// checked: those that aren't in 'old_config_list', and those whose labels
+// (weighted or not) differ from it.
+std::set<string> ModelNamesWithNewVersionLabels(
+    const ModelConfigList& old_config_list,
+    const ModelConfigList& new_config_list) {
+  std::map<string, const ModelConfig*> old_models;
+  for (const ModelConfig& model_config : old_config_list.config()) {
+    old_models[model_config.name()] = &model_config;
+  }
+  std::set<string> models;
+  for (const ModelConfig& model_config : new_config_list.config()) {
+    auto it = old_models.find(model_config.name());
+    if (it == old_models.end() ||
+        std::map<string, int64_t>(it->second->version_labels().begin(),
+                                  it->second->version_labels().end()) !=
+            std::map<string, int64_t>(model_config.version_labels().begin(),
+                                      model_config.version_labels().end()) ||
+        GetWeightedVersionLabels(*it->second) !=
+            GetWeightedVersionLabels(model_config)) {
+      models.insert(model_config.name());
+    }
+  }
+  return models;
+}
+
 // Finds all models that occur in 'new_config' but not in 'old_config'.
 std::set<string> NewModelNamesInSourceConfig(
     const FileSystemStoragePathSourceConfig& old_config,
@@ -220,6 +623,24 @@ Status UpdateModelConfigListRelativePaths(
   return absl::OkStatus();
 }
 
+// A version label resolved by a ServerCore, which its thread caches so that
+// repeated requests for the label skip the lookups in the label map.
+struct CachedVersionLabel {
+  const ServerCore* server_core;
+  uint64_t generation;
+  string model_name;
+  string label;
+  int64_t version;
+};
+
+// The number of labels each thread caches, over all ServerCores.
+constexpr int kMaxCachedVersionLabelsPerThread = 8;
+
+uint64_t NextModelLabelsGeneration() {
+  static std::atomic<uint64_t> next_generation{1};
+  return next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
 }  // namespace
 
 // ************************************************************************
@@ -257,9 +678,11 @@ Status ServerCore::Create(Options options,
 // Server Setup and Initialization.
 // ************************************************************************
 
-ServerCore::ServerCore(Options options)
-    : options_(std::move(options)),
-      servable_event_bus_(EventBus<ServableState>::CreateEventBus()) {
+ServerCore::ServerCore(Options options) : options_(std::move(options)) {
+  EventBus<ServableState>::Options bus_options;
+  bus_options.async_publication = options_.async_servable_event_publication;
+  servable_event_bus_ = EventBus<ServableState>::CreateEventBus(bus_options);
+
   // Number the platforms. (The proto map iteration order is nondeterministic,
   // but we don't care since the numbering is arbitrary.)
   int port_num = 0;
@@ -280,6 +703,23 @@ Status ServerCore::Initialize(std::unique_ptr<AspiredVersionPolicy> policy) {
 
   servable_state_monitor_ = std::move(servable_state_monitor);
 
+  if (!options_.state_snapshot_path.empty()) {
+    if (Env::Default()->FileExists(options_.state_snapshot_path).ok()) {
+      mutex_lock l(config_mu_);
+      const Status status = ReadTextProto(
+          Env::Default(), options_.state_snapshot_path, &restart_snapshot_);
+      if (!status.ok()) {
+        LOG(WARNING) << "Ignoring the state snapshot at "
+                     << options_.state_snapshot_path << ": " << status;
+        restart_snapshot_.Clear();
+      }
+    }
+    snapshot_subscription_ = servable_event_bus_->Subscribe(
+        [this](const EventBus<ServableState>::EventAndTime& state_and_time) {
+          UpdateStateSnapshotVersions(state_and_time.event);
+        });
+  }
+
   std::unique_ptr<AspiredVersionsManager> aspired_versions_manager;
   TF_RETURN_IF_ERROR(CreateAspiredVersionsManager(std::move(policy),
                                                   &aspired_versions_manager));
@@ -344,13 +784,37 @@ Status ServerCore::AddModelsViaModelConfigList() {
     TF_RETURN_IF_ERROR(CreateAdapters(&adapters));
     std::unique_ptr<DynamicSourceRouter<StoragePath>> router;
     TF_RETURN_IF_ERROR(CreateRouter(routes, &adapters, &router));
+    // Under memory pressure, models are evicted ahead of the router.
+    std::unique_ptr<EvictingStoragePathSourceAdapter> evicting_source_adapter;
+    std::unique_ptr<MemoryPressureEvictor> evictor;
+    Target<StoragePath>* source_target = router.get();
+    if (options_.memory_pressure_high_watermark > 0) {
+      evicting_source_adapter =
+          absl::make_unique<EvictingStoragePathSourceAdapter>();
+      MemoryPressureEvictor::Options evictor_options;
+      evictor_options.high_watermark = options_.memory_pressure_high_watermark;
+      evictor_options.low_watermark = options_.memory_pressure_low_watermark;
+      TF_RETURN_IF_ERROR(MemoryPressureEvictor::Create(
+          evictor_options, evicting_source_adapter.get(), &evictor));
+      ConnectSourceToTarget(evicting_source_adapter.get(), router.get());
+      source_target = evicting_source_adapter.get();
+    }
     std::unique_ptr<FileSystemStoragePathSource> source;
     std::unique_ptr<PrefixStoragePathSourceAdapter> prefix_source_adapter;
-    TF_RETURN_IF_ERROR(CreateStoragePathSource(
-        source_config, router.get(), &source, &prefix_source_adapter));
+    std::unique_ptr<LocalCacheStoragePathSourceAdapter> cache_source_adapter;
+    TF_RETURN_IF_ERROR(CreateStoragePathSource(source_config, source_target,
+                                               &source, &prefix_source_adapter,
+                                               &cache_source_adapter));
 
     // Connect the adapters to the manager, and wait for the models to load.
-    TF_RETURN_IF_ERROR(ConnectAdaptersToManagerAndAwaitModelLoads(&adapters));
+    // The versions that load are taken into the state snapshot as they do.
+    snapshot_source_.store(source.get(), std::memory_order_release);
+    const Status load_status =
+        ConnectAdaptersToManagerAndAwaitModelLoads(&adapters);
+    if (!load_status.ok()) {
+      snapshot_source_.store(nullptr, std::memory_order_release);
+      return load_status;
+    }
 
     // Stow the source components.
     storage_path_source_and_router_ = {source.get(), router.get()};
@@ -358,12 +822,25 @@ Status ServerCore::AddModelsViaModelConfigList() {
     if (prefix_source_adapter != nullptr) {
       manager_.AddDependency(std::move(prefix_source_adapter));
     }
+    if (cache_source_adapter != nullptr) {
+      model_cache_.store(cache_source_adapter.get(), std::memory_order_release);
+      manager_.AddDependency(std::move(cache_source_adapter));
+    }
+    if (evicting_source_adapter != nullptr) {
+      manager_.AddDependency(std::move(evicting_source_adapter));
+    }
     manager_.AddDependency(std::move(router));
     for (auto& entry : adapters.platform_adapters) {
       auto& adapter = entry.second;
       manager_.AddDependency(std::move(adapter));
     }
     manager_.AddDependency(std::move(adapters.error_adapter));
+    if (evictor != nullptr) {
+      // Added last, to stop before the adapters it evicts through go away.
+      evictor->SetPriorities(GetLoadPriorities(config_.model_config_list()));
+      memory_pressure_evictor_.store(evictor.get(), std::memory_order_release);
+      manager_.AddDependency(std::move(evictor));
+    }
   } else {
     // Create a fresh servable state monitor, to avoid getting confused if we're
     // re-loading a model-version that has previously been unloaded.
@@ -377,24 +854,40 @@ Status ServerCore::AddModelsViaModelConfigList() {
     // Now we're ready to start reconfiguring the elements of the Source->
     // Manager pipeline ...
 
+    // Only the parts of the pipeline whose config changed are updated, so
+    // that e.g. changing the labels of a model leaves the routes and the
+    // source alone.
+    const DynamicSourceRouter<StoragePath>::Routes old_routes =
+        storage_path_source_and_router_->router->GetRoutes();
+    const bool routes_changed = routes != old_routes;
+    const bool source_config_changed = !ProtosEqual(
+        storage_path_source_and_router_->source->config(), source_config);
+
     // First, add the new routes without removing the old ones.
-    DynamicSourceRouter<StoragePath>::Routes old_and_new_routes;
-    const Status union_status =
-        UnionRoutes(storage_path_source_and_router_->router->GetRoutes(),
-                    routes, &old_and_new_routes);
-    if (!union_status.ok()) {
-      // ValidateNoModelsChangePlatforms() should have detected any conflict.
-      DCHECK(false);
-      return errors::Internal("Old and new routes conflict.");
+    if (routes_changed) {
+      DynamicSourceRouter<StoragePath>::Routes old_and_new_routes;
+      const Status union_status =
+          UnionRoutes(old_routes, routes, &old_and_new_routes);
+      if (!union_status.ok()) {
+        // ValidateNoModelsChangePlatforms() should have detected any conflict.
+        DCHECK(false);
+        return errors::Internal("Old and new routes conflict.");
+      }
+      if (old_and_new_routes != old_routes) {
+        TF_RETURN_IF_ERROR(ReloadRoutes(old_and_new_routes));
+      }
     }
-    TF_RETURN_IF_ERROR(ReloadRoutes(old_and_new_routes));
 
     // Change the source config. Among other things this will cause it to emit
     // tear-downs of any models that aren't present in the new config.
-    TF_RETURN_IF_ERROR(ReloadStoragePathSourceConfig(source_config));
+    if (source_config_changed) {
+      TF_RETURN_IF_ERROR(ReloadStoragePathSourceConfig(source_config));
+    }
 
     // Now that any old models are out of the picture, remove the old routes.
-    TF_RETURN_IF_ERROR(ReloadRoutes(routes));
+    if (routes_changed) {
+      TF_RETURN_IF_ERROR(ReloadRoutes(routes));
+    }
 
     // Wait for any new models to get loaded and become available.
     TF_RETURN_IF_ERROR(
@@ -464,18 +957,42 @@ Status ServerCore::ReloadConfig(const ModelServerConfig& new_config) {
     TF_RETURN_IF_ERROR(ValidateNoModelsChangePlatforms(
         config_.model_config_list(), new_config.model_config_list()));
   }
-  config_ = new_config;
+  ModelServerConfig config = new_config;
+  if (config.config_case() == ModelServerConfig::kModelConfigList &&
+      options_.model_config_list_root_dir) {
+    TF_RETURN_IF_ERROR(UpdateModelConfigListRelativePaths(
+        *options_.model_config_list_root_dir,
+        config.mutable_model_config_list()));
+  }
+  // E.g. the config file is polled, and hasn't changed since.
+  if (config_applied_ && ProtosEqual(config_, config)) {
+    VLOG(1) << "Taking no action for unchanged config.";
+    return absl::OkStatus();
+  }
+  // Only the labels of models that are new or whose labels changed are
+  // checked again; those of the other models stand.
+  std::set<string> models_with_new_labels;
+  if (!is_first_config) {
+    models_with_new_labels = ModelNamesWithNewVersionLabels(
+        config_.model_config_list(), config.model_config_list());
+  }
+  config_ = std::move(config);
+  config_applied_ = false;
 
-  TF_RETURN_IF_ERROR(UpdateModelVersionLabelMap());
+  TF_RETURN_IF_ERROR(UpdateModelVersionLabelMap(
+      is_first_config ? nullptr : &models_with_new_labels));
 
   LOG(INFO) << "Adding/updating models.";
   switch (config_.config_case()) {
     case ModelServerConfig::kModelConfigList: {
-      if (options_.model_config_list_root_dir) {
-        TF_RETURN_IF_ERROR(UpdateModelConfigListRelativePaths(
-            *options_.model_config_list_root_dir,
-            config_.mutable_model_config_list()));
+      manager_->SetLoadPriorities(
+          GetLoadPriorities(config_.model_config_list()));
+      if (MemoryPressureEvictor* evictor =
+              memory_pressure_evictor_.load(std::memory_order_acquire)) {
+        evictor->SetPriorities(GetLoadPriorities(config_.model_config_list()));
       }
+      manager_->SetLoadRetryPolicies(
+          GetLoadRetryPolicies(config_.model_config_list()));
       TF_RETURN_IF_ERROR(AddModelsViaModelConfigList());
       break;
     }
@@ -492,6 +1009,20 @@ Status ServerCore::ReloadConfig(const ModelServerConfig& new_config) {
   LOG(INFO) << "Finished adding/updating models";
 
   TF_RETURN_IF_ERROR(MaybeUpdateServerRequestLogger(config_.config_case()));
+  UpdateResponseCaches();
+  UpdateRequestCoalescers();
+  UpdateConcurrencyLimiters();
+  UpdateLatencyTracking();
+  UpdateModelVariants();
+  UpdateModelPipelines();
+  UpdateFloatOutputDtypes();
+  TF_RETURN_IF_ERROR(UpdateBatchingParameters());
+  TF_RETURN_IF_ERROR(UpdateThreadPoolFactories());
+  config_applied_ = true;
+  if (!options_.state_snapshot_path.empty() &&
+      config_.config_case() == ModelServerConfig::kModelConfigList) {
+    UpdateStateSnapshotModels();
+  }
 
   if (options_.flush_filesystem_caches) {
     return Env::Default()->FlushFileSystemCaches();
@@ -501,13 +1032,507 @@ Status ServerCore::ReloadConfig(const ModelServerConfig& new_config) {
   return absl::OkStatus();
 }
 
-Status ServerCore::UpdateModelVersionLabelMap() {
+void ServerCore::UpdateResponseCaches() {
+  auto new_response_caches =
+      std::make_unique<std::map<string, ResponseCacheAndConfig>>();
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    // The caches are only replaced here, under 'config_mu_'.
+    const auto response_caches = response_caches_.get();
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (!model_config.has_response_cache_config()) {
+        continue;
+      }
+      const ResponseCacheConfig& cache_config =
+          model_config.response_cache_config();
+      if (response_caches != nullptr) {
+        auto existing = response_caches->find(model_config.name());
+        if (existing != response_caches->end() &&
+            existing->second.config.max_bytes() == cache_config.max_bytes() &&
+            existing->second.config.ttl_seconds() ==
+                cache_config.ttl_seconds()) {
+          new_response_caches->insert(*existing);
+          continue;
+        }
+      }
+      ResponseCache::Options cache_options;
+      cache_options.model_name = model_config.name();
+      cache_options.max_bytes = cache_config.max_bytes();
+      cache_options.ttl_micros = cache_config.ttl_seconds() * 1000 * 1000;
+      (*new_response_caches)[model_config.name()] = {
+          cache_config, std::make_shared<ResponseCache>(cache_options)};
+    }
+  }
+  const bool has_response_caches = !new_response_caches->empty();
+  response_caches_.Update(std::move(new_response_caches));
+  has_response_caches_.store(has_response_caches, std::memory_order_release);
+}
+
+std::shared_ptr<ResponseCache> ServerCore::GetResponseCache(
+    const string& model_name) const {
+  if (!has_response_caches_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  const auto response_caches = response_caches_.get();
+  if (response_caches == nullptr) {
+    return nullptr;
+  }
+  auto it = response_caches->find(model_name);
+  return it == response_caches->end() ? nullptr : it->second.cache;
+}
+
+void ServerCore::UpdateRequestCoalescers() {
+  std::map<string, std::shared_ptr<RequestCoalescer>> new_request_coalescers;
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    mutex_lock l(request_coalescers_mu_);
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (!model_config.coalesce_requests()) {
+        continue;
+      }
+      auto existing = request_coalescers_.find(model_config.name());
+      new_request_coalescers[model_config.name()] =
+          existing != request_coalescers_.end()
+              ? existing->second
+              : std::make_shared<RequestCoalescer>(model_config.name());
+    }
+  }
+  mutex_lock l(request_coalescers_mu_);
+  request_coalescers_ = std::move(new_request_coalescers);
+  has_request_coalescers_.store(!request_coalescers_.empty(),
+                                std::memory_order_release);
+}
+
+std::shared_ptr<RequestCoalescer> ServerCore::GetRequestCoalescer(
+    const string& model_name) const {
+  if (!has_request_coalescers_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  mutex_lock l(request_coalescers_mu_);
+  auto it = request_coalescers_.find(model_name);
+  return it == request_coalescers_.end() ? nullptr : it->second;
+}
+
+void ServerCore::UpdateConcurrencyLimiters() {
+  std::map<string, ModelConcurrencyLimiters> new_concurrency_limiters;
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    mutex_lock l(concurrency_limiters_mu_);
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (!model_config.has_concurrency_limit() &&
+          model_config.version_label_concurrency_limits().empty()) {
+        continue;
+      }
+      const ModelConcurrencyLimiters& existing =
+          concurrency_limiters_[model_config.name()];
+      ModelConcurrencyLimiters& limiters =
+          new_concurrency_limiters[model_config.name()];
+      if (model_config.has_concurrency_limit()) {
+        limiters.model_limiter = ReuseOrCreateConcurrencyLimiter(
+            model_config.name(), model_config.name(),
+            model_config.concurrency_limit(), existing.model_limiter);
+      }
+      for (const auto& label_and_limit :
+           model_config.version_label_concurrency_limits()) {
+        auto existing_it = existing.label_limiters.find(label_and_limit.first);
+        limiters.label_limiters[label_and_limit.first] =
+            ReuseOrCreateConcurrencyLimiter(
+                strings::StrCat(model_config.name(), ":",
+                                label_and_limit.first),
+                model_config.name(), label_and_limit.second,
+                existing_it == existing.label_limiters.end()
+                    ? nullptr
+                    : existing_it->second);
+      }
+    }
+  }
+  mutex_lock l(concurrency_limiters_mu_);
+  concurrency_limiters_ = std::move(new_concurrency_limiters);
+  has_concurrency_limiters_.store(!concurrency_limiters_.empty(),
+                                  std::memory_order_release);
+}
+
+void ServerCore::UpdateLatencyTracking() {
+  std::map<string, LatencyTracking> new_latency_tracking;
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (model_config.latency_slo_micros() <= 0) {
+        continue;
+      }
+      auto existing = latency_tracking_.find(model_config.name());
+      if (existing != latency_tracking_.end() &&
+          existing->second.latency_slo_micros ==
+              model_config.latency_slo_micros()) {
+        new_latency_tracking[model_config.name()] = std::move(existing->second);
+        continue;
+      }
+      new_latency_tracking[model_config.name()] = {
+          model_config.latency_slo_micros(),
+          SaturationMonitor::Global()->EnableLatencyTracking(
+              model_config.name(), model_config.latency_slo_micros())};
+    }
+  }
+  latency_tracking_ = std::move(new_latency_tracking);
+}
+
+void ServerCore::UpdateModelVariants() {
+  auto new_model_variants =
+      std::make_unique<std::map<string, std::vector<ModelVariant>>>();
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (model_config.variants().empty()) {
+        continue;
+      }
+      (*new_model_variants)[model_config.name()].assign(
+          model_config.variants().begin(), model_config.variants().end());
+    }
+  }
+  const bool has_model_variants = !new_model_variants->empty();
+  model_variants_.Update(std::move(new_model_variants));
+  has_model_variants_.store(has_model_variants, std::memory_order_release);
+}
+
+void ServerCore::UpdateModelPipelines() {
+  auto new_model_pipelines =
+      std::make_unique<std::map<string, ModelPipelineConfig>>();
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    for (const ModelPipelineConfig& pipeline :
+         config_.model_config_list().pipelines()) {
+      (*new_model_pipelines)[pipeline.name()] = pipeline;
+    }
+  }
+  const bool has_model_pipelines = !new_model_pipelines->empty();
+  model_pipelines_.Update(std::move(new_model_pipelines));
+  has_model_pipelines_.store(has_model_pipelines, std::memory_order_release);
+}
+
+void ServerCore::UpdateFloatOutputDtypes() {
+  auto new_float_output_dtypes = std::make_unique<std::map<string, DataType>>();
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (model_config.float_output_dtype() != DT_INVALID) {
+        (*new_float_output_dtypes)[model_config.name()] =
+            model_config.float_output_dtype();
+      }
+    }
+  }
+  const bool has_float_output_dtypes = !new_float_output_dtypes->empty();
+  float_output_dtypes_.Update(std::move(new_float_output_dtypes));
+  has_float_output_dtypes_.store(has_float_output_dtypes,
+                                 std::memory_order_release);
+}
+
+Status ServerCore::UpdateBatchingParameters() {
+  std::map<string, BatchingParameters> new_batching_parameters;
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (model_config.has_batching_parameters()) {
+        new_batching_parameters[model_config.name()] =
+            model_config.batching_parameters();
+      }
+    }
+  }
+  // Restores the loaded parameters of the models that no longer override
+  // them.
+  for (const auto& entry : batching_parameters_) {
+    if (new_batching_parameters.count(entry.first) == 0) {
+      TF_RETURN_IF_ERROR(
+          UpdateLiveBatchingParameters(entry.first, BatchingParameters()));
+    }
+  }
+  for (const auto& entry : new_batching_parameters) {
+    auto previous = batching_parameters_.find(entry.first);
+    if (previous == batching_parameters_.end() ||
+        previous->second.SerializeAsString() !=
+            entry.second.SerializeAsString()) {
+      TF_RETURN_IF_ERROR(
+          UpdateLiveBatchingParameters(entry.first, entry.second));
+    }
+  }
+  batching_parameters_ = std::move(new_batching_parameters);
+  return OkStatus();
+}
+
+DataType ServerCore::GetFloatOutputDtype(const string& model_name) const {
+  if (!has_float_output_dtypes_.load(std::memory_order_acquire)) {
+    return DT_INVALID;
+  }
+  const auto float_output_dtypes = float_output_dtypes_.get();
+  if (float_output_dtypes == nullptr) {
+    return DT_INVALID;
+  }
+  auto dtype = float_output_dtypes->find(model_name);
+  return dtype == float_output_dtypes->end() ? DT_INVALID : dtype->second;
+}
+
+std::shared_ptr<const ModelPipelineConfig> ServerCore::GetModelPipeline(
+    const string& name) const {
+  if (!has_model_pipelines_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  const std::shared_ptr<const std::map<string, ModelPipelineConfig>>
+      model_pipelines = model_pipelines_.get();
+  if (model_pipelines == nullptr) {
+    return nullptr;
+  }
+  auto pipeline = model_pipelines->find(name);
+  if (pipeline == model_pipelines->end()) {
+    return nullptr;
+  }
+  // Keeps the map of the pipelines alive.
+  return std::shared_ptr<const ModelPipelineConfig>(model_pipelines,
+                                                    &pipeline->second);
+}
+
+ModelSpec ServerCore::SelectModelVariant(const ModelSpec& model_spec,
+                                         int64_t batch_size) const {
+  if (!has_model_variants_.load(std::memory_order_acquire) ||
+      model_spec.version_choice_case() != ModelSpec::VERSION_CHOICE_NOT_SET) {
+    return model_spec;
+  }
+  const auto model_variants = model_variants_.get();
+  if (model_variants == nullptr) {
+    return model_spec;
+  }
+  auto variants = model_variants->find(model_spec.name());
+  if (variants == model_variants->end()) {
+    return model_spec;
+  }
+  const std::shared_ptr<const RequestDeadline> request_deadline =
+      RequestDeadline::Current();
+  const absl::Duration time_left = request_deadline == nullptr
+                                       ? absl::InfiniteDuration()
+                                       : request_deadline->deadline() -
+                                             absl::Now();
+  for (const ModelVariant& variant : variants->second) {
+    if (variant.max_batch_size() > 0 && batch_size > variant.max_batch_size()) {
+      continue;
+    }
+    if (time_left < absl::Microseconds(variant.min_latency_budget_micros())) {
+      continue;
+    }
+    ModelSpec variant_spec = model_spec;
+    variant_spec.set_name(variant.model_name());
+    return variant_spec;
+  }
+  return model_spec;
+}
+
+Status ServerCore::UpdateThreadPoolFactories() {
+  std::map<string, std::shared_ptr<ThreadPoolFactory>> new_factories;
+  std::map<string, std::shared_ptr<DedicatedThreadPoolFactory>>
+      new_factories_by_key;
+  if (config_.config_case() == ModelServerConfig::kModelConfigList) {
+    std::map<string, std::shared_ptr<DedicatedThreadPoolFactory>>
+        existing_factories_by_key;
+    {
+      mutex_lock l(thread_pool_factories_mu_);
+      existing_factories_by_key = thread_pool_factories_by_key_;
+    }
+    for (const ModelConfig& model_config :
+         config_.model_config_list().config()) {
+      if (!model_config.has_thread_pool_config()) {
+        continue;
+      }
+      const ModelThreadPoolConfig& pool_config =
+          model_config.thread_pool_config();
+      const string key = ThreadPoolKey(model_config);
+      std::shared_ptr<DedicatedThreadPoolFactory>& factory =
+          new_factories_by_key[key];
+      if (factory == nullptr) {
+        auto existing = existing_factories_by_key.find(key);
+        if (existing != existing_factories_by_key.end() &&
+            ThreadPoolOptionsMatch(existing->second->options(), pool_config)) {
+          factory = existing->second;
+        } else {
+          DedicatedThreadPoolFactory::Options options;
+          options.name = pool_config.pool_name().empty()
+                             ? model_config.name()
+                             : pool_config.pool_name();
+          options.num_inter_op_threads = pool_config.num_inter_op_threads();
+          options.num_intra_op_threads = pool_config.num_intra_op_threads();
+          options.cpus.assign(pool_config.cpus().begin(),
+                              pool_config.cpus().end());
+          options.inline_max_cost_micros = pool_config.inline_max_cost_micros();
+          options.large_min_cost_micros = pool_config.large_min_cost_micros();
+          options.num_large_intra_op_threads =
+              pool_config.num_large_intra_op_threads();
+          std::unique_ptr<DedicatedThreadPoolFactory> new_factory;
+          TF_RETURN_IF_ERROR(
+              DedicatedThreadPoolFactory::Create(options, &new_factory));
+          factory = std::move(new_factory);
+        }
+      }
+      new_factories[model_config.name()] = factory;
+    }
+  }
+  mutex_lock l(thread_pool_factories_mu_);
+  thread_pool_factories_ = std::move(new_factories);
+  thread_pool_factories_by_key_ = std::move(new_factories_by_key);
+  has_thread_pool_factories_.store(!thread_pool_factories_.empty(),
+                                   std::memory_order_release);
+  return absl::OkStatus();
+}
+
+std::shared_ptr<ThreadPoolFactory> ServerCore::GetThreadPoolFactory(
+    const string& model_name) const {
+  if (!has_thread_pool_factories_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+  mutex_lock l(thread_pool_factories_mu_);
+  auto it = thread_pool_factories_.find(model_name);
+  return it == thread_pool_factories_.end() ? nullptr : it->second;
+}
+
+std::vector<std::shared_ptr<ConcurrencyLimiter>>
+ServerCore::GetConcurrencyLimiters(const ServableId& id) const {
+  ModelConcurrencyLimiters model_limiters;
+  {
+    mutex_lock l(concurrency_limiters_mu_);
+    auto it = concurrency_limiters_.find(id.name);
+    if (it == concurrency_limiters_.end()) {
+      return {};
+    }
+    model_limiters = it->second;
+  }
+  std::vector<std::shared_ptr<ConcurrencyLimiter>> limiters;
+  for (const auto& label_and_limiter : model_limiters.label_limiters) {
+    int64_t label_version;
+    if (GetModelVersionForLabel(id.name, label_and_limiter.first,
+                                &label_version)
+            .ok() &&
+        label_version == id.version) {
+      limiters.push_back(label_and_limiter.second);
+    }
+  }
+  if (model_limiters.model_limiter != nullptr) {
+    limiters.push_back(model_limiters.model_limiter);
+  }
+  return limiters;
+}
+
+Status ServerCore::GetServableId(const ModelSpec& model_spec, ServableId* id) {
+  ServableRequest servable_request;
+  TF_RETURN_IF_ERROR(
+      ServableRequestFromModelSpec(model_spec, &servable_request));
+  std::unique_ptr<UntypedServableHandle> untyped_handle;
+  TF_RETURN_IF_ERROR(
+      manager_->GetUntypedServableHandle(servable_request, &untyped_handle));
+  *id = untyped_handle->id();
+  return absl::OkStatus();
+}
+
+Status ServerCore::GetUntypedServableHandle(
+    const ServableRequest& request,
+    std::unique_ptr<UntypedServableHandle>* untyped_handle) {
+  TF_RETURN_IF_ERROR(
+      manager_->GetUntypedServableHandle(request, untyped_handle));
+  // The versions of models with weighted labels are compared by all their
+  // requests, whether they name a label or not. The time includes that spent
+  // waiting for the concurrency limits below.
+  if (has_weighted_version_labels_.load(std::memory_order_acquire)) {
+    const auto weighted_labels = weighted_version_labels_.get();
+    if (weighted_labels != nullptr &&
+        weighted_labels->count((*untyped_handle)->id().name) > 0) {
+      *untyped_handle =
+          std::make_unique<TimedServableHandle>(std::move(*untyped_handle));
+    }
+  }
+  if (!has_concurrency_limiters_.load(std::memory_order_acquire)) {
+    return absl::OkStatus();
+  }
+  // The limits are looked up by the version that serves, which isn't known
+  // before the handle is, e.g. for requests for the latest version.
+  const std::vector<std::shared_ptr<ConcurrencyLimiter>> limiters =
+      GetConcurrencyLimiters((*untyped_handle)->id());
+  if (limiters.empty()) {
+    return absl::OkStatus();
+  }
+  const std::shared_ptr<const RequestDeadline> request_deadline =
+      RequestDeadline::Current();
+  const absl::Time deadline = request_deadline == nullptr
+                                  ? absl::InfiniteFuture()
+                                  : request_deadline->deadline();
+  std::vector<std::unique_ptr<ConcurrencyLimiter::Permit>> permits(
+      limiters.size());
+  for (int i = 0; i < limiters.size(); ++i) {
+    const Status status = limiters[i]->Admit(deadline, &permits[i]);
+    if (!status.ok()) {
+      untyped_handle->reset();
+      return status;
+    }
+  }
+  *untyped_handle = std::make_unique<AdmittedServableHandle>(
+      std::move(*untyped_handle), std::move(permits));
+  return absl::OkStatus();
+}
+
+Status ServerCore::UpdateModelVersionLabelMap(
+    const std::set<string>* models_to_update) {
   std::unique_ptr<std::map<string, std::map<string, int64_t>>> new_label_map(
       new std::map<string, std::map<string, int64_t>>);
+  auto new_weighted_labels = std::make_unique<WeightedVersionLabelMap>();
+  std::map<string, std::map<string, int64_t>> old_label_map;
+  WeightedVersionLabelMap old_weighted_labels;
+  if (models_to_update != nullptr) {
+    const auto current_label_map = model_labels_to_versions_.get();
+    if (current_label_map != nullptr) {
+      old_label_map = *current_label_map;
+    }
+    const auto current_weighted_labels = weighted_version_labels_.get();
+    if (current_weighted_labels != nullptr) {
+      old_weighted_labels = *current_weighted_labels;
+    }
+  }
   for (const ModelConfig& model_config : config_.model_config_list().config()) {
+    if (models_to_update != nullptr &&
+        models_to_update->count(model_config.name()) == 0) {
+      auto it = old_label_map.find(model_config.name());
+      if (it != old_label_map.end()) {
+        (*new_label_map)[model_config.name()] = std::move(it->second);
+      }
+      auto weighted_it = old_weighted_labels.find(model_config.name());
+      if (weighted_it != old_weighted_labels.end()) {
+        (*new_weighted_labels)[model_config.name()] =
+            std::move(weighted_it->second);
+      }
+      continue;
+    }
     ServableStateMonitor::VersionMap serving_states =
         servable_state_monitor_->GetVersionStates(model_config.name());
 
+    for (const auto& label_and_versions :
+         GetWeightedVersionLabels(model_config)) {
+      const string& label = label_and_versions.first;
+      double total_weight = 0;
+      for (const auto& version_and_weight : label_and_versions.second) {
+        total_weight += version_and_weight.second;
+      }
+      std::vector<WeightedVersion>& versions =
+          (*new_weighted_labels)[model_config.name()][label];
+      double cumulative_weight = 0;
+      for (const auto& version_and_weight : label_and_versions.second) {
+        const int64_t version = version_and_weight.first;
+        auto serving_states_it = serving_states.find(version);
+        if (!options_.force_allow_any_version_labels_for_unavailable_models &&
+            !options_.allow_version_labels_for_unavailable_models &&
+            (serving_states_it == serving_states.end() ||
+             serving_states_it->second.state.manager_state !=
+                 ServableState::ManagerState::kAvailable)) {
+          return errors::FailedPrecondition(
+              "Request to assign weighted label ", label, " to version ",
+              version, " of model ", model_config.name(),
+              ", which is not currently available for inference");
+        }
+        cumulative_weight += version_and_weight.second;
+        versions.push_back({version, cumulative_weight / total_weight});
+      }
+    }
+
     for (const auto& entry : model_config.version_labels()) {
       const string& label = entry.first;
       const int64_t version = entry.second;
@@ -543,7 +1568,7 @@ Status ServerCore::UpdateModelVersionLabelMap() {
   }
 
   if (!options_.allow_version_labels) {
-    if (!new_label_map->empty()) {
+    if (!new_label_map->empty() || !new_weighted_labels->empty()) {
       return errors::FailedPrecondition(
           "Model version labels are not currently allowed by the server.");
     }
@@ -562,8 +1587,14 @@ Status ServerCore::UpdateModelVersionLabelMap() {
     }
   }
 
-  mutex_lock l(model_labels_to_versions_mu_);
-  model_labels_to_versions_.swap(new_label_map);
+  // Waits for the lookups in the old map to finish, and frees it.
+  model_labels_to_versions_.Update(std::move(new_label_map));
+  model_labels_to_versions_generation_.store(NextModelLabelsGeneration(),
+                                             std::memory_order_release);
+  const bool has_weighted_version_labels = !new_weighted_labels->empty();
+  weighted_version_labels_.Update(std::move(new_weighted_labels));
+  has_weighted_version_labels_.store(has_weighted_version_labels,
+                                     std::memory_order_release);
 
   return absl::OkStatus();
 }
@@ -592,6 +1623,11 @@ FileSystemStoragePathSourceConfig ServerCore::CreateStoragePathSourceConfig(
   FileSystemStoragePathSourceConfig source_config;
   source_config.set_file_system_poll_wait_seconds(
       options_.file_system_poll_wait_seconds);
+  source_config.set_watch_for_changes(options_.watch_file_system_for_changes);
+  source_config.set_num_file_system_poll_threads(
+      options_.num_file_system_poll_threads);
+  source_config.set_max_file_system_poll_backoff_seconds(
+      options_.max_file_system_poll_backoff_seconds);
   source_config.set_fail_if_zero_versions_at_startup(
       options_.fail_if_no_model_versions_found);
   source_config.set_servable_versions_always_present(
@@ -625,25 +1661,160 @@ Status ServerCore::CreateStoragePathRoutes(
   return absl::OkStatus();
 }
 
+void ServerCore::GetRestartSnapshotVersions(
+    std::map<string, std::vector<ServableData<StoragePath>>>* versions,
+    std::vector<string>* load_order) const {
+  std::map<string, const ModelConfig*> model_configs;
+  for (const ModelConfig& model_config : config_.model_config_list().config()) {
+    model_configs[model_config.name()] = &model_config;
+  }
+  for (const ServerCoreSnapshot::Model& model : restart_snapshot_.models()) {
+    auto it = model_configs.find(model.name());
+    if (it == model_configs.end() ||
+        it->second->base_path() != model.base_path() ||
+        !ProtosEqual(it->second->model_version_policy(),
+                     model.model_version_policy())) {
+      continue;
+    }
+    std::vector<ServableData<StoragePath>>& model_versions =
+        (*versions)[model.name()];
+    for (const ServerCoreSnapshot::Version& version : model.versions()) {
+      model_versions.emplace_back(ServableId{model.name(), version.version()},
+                                  version.path());
+    }
+    load_order->push_back(model.name());
+  }
+}
+
+void ServerCore::UpdateStateSnapshotModels() {
+  mutex_lock l(snapshot_mu_);
+  snapshot_models_.clear();
+  for (const ModelConfig& model_config : config_.model_config_list().config()) {
+    ServerCoreSnapshot::Model& model = snapshot_models_[model_config.name()];
+    model.set_name(model_config.name());
+    model.set_base_path(model_config.base_path());
+    *model.mutable_model_version_policy() = model_config.model_version_policy();
+  }
+  WriteStateSnapshot();
+}
+
+void ServerCore::UpdateStateSnapshotVersions(const ServableState& state) {
+  mutex_lock l(snapshot_mu_);
+  switch (state.manager_state) {
+    case ServableState::ManagerState::kAvailable: {
+      FileSystemStoragePathSource* source =
+          snapshot_source_.load(std::memory_order_acquire);
+      const string path =
+          source == nullptr ? "" : source->GetAspiredVersionPath(state.id);
+      if (path.empty()) {
+        // E.g. a version of a custom source; it can't be aspired on restart.
+        return;
+      }
+      snapshot_versions_[state.id.name][state.id.version] = {
+          path, ++num_snapshot_events_};
+      break;
+    }
+    case ServableState::ManagerState::kUnloading:
+    case ServableState::ManagerState::kEnd: {
+      auto it = snapshot_versions_.find(state.id.name);
+      if (it == snapshot_versions_.end() ||
+          it->second.erase(state.id.version) == 0) {
+        return;
+      }
+      if (it->second.empty()) {
+        snapshot_versions_.erase(it);
+      }
+      break;
+    }
+    default:
+      return;
+  }
+  WriteStateSnapshot();
+}
+
+void ServerCore::WriteStateSnapshot() {
+  if (snapshot_models_.empty()) {
+    return;
+  }
+  // Orders the models by the earliest of their available versions.
+  std::vector<std::pair<uint64_t, string>> models_in_order;
+  for (const auto& model_and_versions : snapshot_versions_) {
+    if (snapshot_models_.count(model_and_versions.first) == 0) {
+      continue;
+    }
+    uint64_t first_event_number = std::numeric_limits<uint64_t>::max();
+    for (const auto& version : model_and_versions.second) {
+      first_event_number =
+          std::min(first_event_number, version.second.event_number);
+    }
+    models_in_order.emplace_back(first_event_number, model_and_versions.first);
+  }
+  std::sort(models_in_order.begin(), models_in_order.end());
+
+  ServerCoreSnapshot snapshot;
+  for (const auto& model_in_order : models_in_order) {
+    ServerCoreSnapshot::Model* model = snapshot.add_models();
+    *model = snapshot_models_.at(model_in_order.second);
+    for (const auto& version : snapshot_versions_.at(model_in_order.second)) {
+      ServerCoreSnapshot::Version* snapshot_version = model->add_versions();
+      snapshot_version->set_version(version.first);
+      snapshot_version->set_path(version.second.path);
+    }
+  }
+  const string tmp_path = options_.state_snapshot_path + ".tmp";
+  Status status = WriteTextProto(Env::Default(), tmp_path, snapshot);
+  if (status.ok()) {
+    status = Env::Default()->RenameFile(tmp_path, options_.state_snapshot_path);
+  }
+  if (!status.ok()) {
+    LOG(WARNING) << "Unable to write the state snapshot to "
+                 << options_.state_snapshot_path << ": " << status;
+  }
+}
+
 Status ServerCore::CreateStoragePathSource(
     const FileSystemStoragePathSourceConfig& config,
     Target<StoragePath>* target,
     std::unique_ptr<FileSystemStoragePathSource>* source,
-    std::unique_ptr<PrefixStoragePathSourceAdapter>* prefix_source_adapter) {
+    std::unique_ptr<PrefixStoragePathSourceAdapter>* prefix_source_adapter,
+    std::unique_ptr<LocalCacheStoragePathSourceAdapter>* cache_source_adapter) {
   const Status status = FileSystemStoragePathSource::Create(config, source);
   if (!status.ok()) {
     VLOG(1) << "Unable to create FileSystemStoragePathSource due to: "
             << status;
     return status;
   }
-  if (options_.storage_path_prefix.empty()) {
-    ConnectSourceToTarget(source->get(), target);
-  } else {
+  if (!restart_snapshot_.models().empty()) {
+    std::map<string, std::vector<ServableData<StoragePath>>> versions;
+    std::vector<string> load_order;
+    GetRestartSnapshotVersions(&versions, &load_order);
+    LOG(INFO) << "Aspiring the versions of " << versions.size()
+              << " model(s) from the state snapshot";
+    manager_->SetLoadOrder(load_order);
+    (*source)->SetInitialAspiredVersions(std::move(versions));
+    restart_snapshot_.Clear();
+  }
+  Source<StoragePath>* last_source = source->get();
+  if (!options_.storage_path_prefix.empty()) {
     *prefix_source_adapter = absl::make_unique<PrefixStoragePathSourceAdapter>(
         options_.storage_path_prefix);
-    ConnectSourceToTarget(source->get(), prefix_source_adapter->get());
-    ConnectSourceToTarget(prefix_source_adapter->get(), target);
+    ConnectSourceToTarget(last_source, prefix_source_adapter->get());
+    last_source = prefix_source_adapter->get();
   }
+  if (!options_.model_cache_dir.empty()) {
+    LocalCacheStoragePathSourceAdapter::Options cache_options;
+    cache_options.cache_dir = options_.model_cache_dir;
+    cache_options.num_versions_to_retain =
+        options_.num_cached_model_versions_to_retain;
+    cache_options.peer_fetcher = options_.model_peer_fetcher;
+    cache_options.fetch_in_background =
+        options_.fetch_model_versions_in_background;
+    TF_RETURN_IF_ERROR(LocalCacheStoragePathSourceAdapter::Create(
+        cache_options, cache_source_adapter));
+    ConnectSourceToTarget(last_source, cache_source_adapter->get());
+    last_source = cache_source_adapter->get();
+  }
+  ConnectSourceToTarget(last_source, target);
   return absl::OkStatus();
 }
 
@@ -748,11 +1919,24 @@ Status ServerCore::CreateAspiredVersionsManager(
   manager_options.aspired_version_policy = std::move(aspired_version_policy);
   manager_options.num_load_threads = options_.num_load_threads;
   manager_options.num_unload_threads = options_.num_unload_threads;
+  manager_options.work_stealing_load_executor =
+      options_.work_stealing_load_executor;
   manager_options.max_num_load_retries = options_.max_num_load_retries;
   manager_options.load_retry_interval_micros =
       options_.load_retry_interval_micros;
+  manager_options.load_retry_backoff = options_.load_retry_backoff;
+  if (options_.load_retries_per_second > 0) {
+    manager_options.load_retry_budget = std::make_shared<RetryBudget>(
+        options_.load_retries_per_second, options_.max_load_retry_burst);
+  }
   manager_options.pre_load_hook = std::move(options_.pre_load_hook);
   manager_options.flush_filesystem_caches = options_.flush_filesystem_caches;
+  manager_options.use_per_thread_handle_refs =
+      options_.use_per_thread_handle_refs;
+  manager_options.enable_batch_load_approval =
+      options_.enable_batch_load_approval;
+  manager_options.max_num_concurrent_version_transitions =
+      options_.max_num_concurrent_version_transitions;
   manager_options.enable_reload_servables_with_error =
       options_.enable_reload_servables_with_error;
   manager_options.with_current_context = options_.with_current_context;
@@ -806,8 +1990,11 @@ Status ServerCore::ServableRequestFromModelSpec(
             "allowed by the server.");
       }
       int64_t version;
-      TF_RETURN_IF_ERROR(GetModelVersionForLabel(
-          model_spec.name(), model_spec.version_label(), &version));
+      if (!has_weighted_version_labels_.load(std::memory_order_acquire) ||
+          !GetModelVersionForWeightedLabel(model_spec, &version)) {
+        TF_RETURN_IF_ERROR(GetModelVersionForLabel(
+            model_spec.name(), model_spec.version_label(), &version));
+      }
       *servable_request = ServableRequest::Specific(model_spec.name(), version);
       break;
     }
@@ -819,20 +2006,77 @@ Status ServerCore::ServableRequestFromModelSpec(
   return absl::OkStatus();
 }
 
+bool ServerCore::GetModelVersionForWeightedLabel(const ModelSpec& model_spec,
+                                                 int64_t* version) const {
+  const auto weighted_labels = weighted_version_labels_.get();
+  if (weighted_labels == nullptr) {
+    return false;
+  }
+  auto model_it = weighted_labels->find(model_spec.name());
+  if (model_it == weighted_labels->end()) {
+    return false;
+  }
+  auto label_it = model_it->second.find(model_spec.version_label());
+  if (label_it == model_it->second.end()) {
+    return false;
+  }
+  // A point of [0, 1), from the top 53 bits of the hash of the routing key,
+  // which falls in the share of one of the versions. A change of the weights
+  // only moves the keys whose points change share.
+  const uint64_t hash = model_spec.routing_key().empty()
+                            ? random::New64()
+                            : Hash64(model_spec.routing_key());
+  const double point =
+      static_cast<double>(hash >> 11) / static_cast<double>(uint64_t{1} << 53);
+  const std::vector<WeightedVersion>& versions = label_it->second;
+  auto version_it = std::upper_bound(
+      versions.begin(), versions.end(), point,
+      [](double point, const WeightedVersion& weighted_version) {
+        return point < weighted_version.cumulative_weight;
+      });
+  *version = version_it == versions.end() ? versions.back().version
+                                          : version_it->version;
+  return true;
+}
+
 Status ServerCore::GetModelVersionForLabel(const string& model_name,
                                            const string& label,
                                            int64_t* version) const {
-  mutex_lock l(model_labels_to_versions_mu_);
-  if (model_labels_to_versions_ == nullptr) {
+  thread_local std::vector<CachedVersionLabel> cached_labels;
+  auto cached_it = std::find_if(
+      cached_labels.begin(), cached_labels.end(),
+      [&](const CachedVersionLabel& cached) {
+        return cached.server_core == this && cached.model_name == model_name &&
+               cached.label == label;
+      });
+  if (cached_it != cached_labels.end() &&
+      cached_it->generation == model_labels_to_versions_generation_.load(
+                                   std::memory_order_acquire)) {
+    *version = cached_it->version;
+    return absl::OkStatus();
+  }
+
+  const auto label_map = model_labels_to_versions_.get();
+  if (label_map == nullptr) {
     return errors::Unavailable(
         strings::StrCat("Model labels does not init yet.", label));
   }
-  auto version_map_it = model_labels_to_versions_->find(model_name);
-  if (version_map_it != model_labels_to_versions_->end()) {
+  auto version_map_it = label_map->find(model_name);
+  if (version_map_it != label_map->end()) {
     const std::map<string, int64_t>& version_map = version_map_it->second;
     auto version_it = version_map.find(label);
     if (version_it != version_map.end()) {
       *version = version_it->second;
+      if (cached_it == cached_labels.end()) {
+        if (cached_labels.size() >= kMaxCachedVersionLabelsPerThread) {
+          cached_labels.erase(cached_labels.begin());
+        }
+        cached_it = cached_labels.emplace(cached_labels.end());
+      }
+      *cached_it = {this,
+                    model_labels_to_versions_generation_.load(
+                        std::memory_order_relaxed),
+                    model_name, label, *version};
       return absl::OkStatus();
     }
   }
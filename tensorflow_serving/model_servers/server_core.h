@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_MODEL_SERVERS_SERVER_CORE_H_
 #define TENSORFLOW_SERVING_MODEL_SERVERS_SERVER_CORE_H_
 
+#include <atomic>
 #include <limits>
 #include <map>
 #include <memory>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/any.pb.h"
 #include "absl/base/macros.h"
@@ -36,6 +39,10 @@ limitations under the License.
 #include "tensorflow_serving/config/platform_config.pb.h"
 #include "tensorflow_serving/core/aspired_versions_manager.h"
 #include "tensorflow_serving/core/dynamic_source_router.h"
+#include "tensorflow_serving/core/evicting_storage_path_source_adapter.h"
+#include "tensorflow_serving/core/local_cache_storage_path_source_adapter.h"
+#include "tensorflow_serving/core/memory_pressure_evictor.h"
+#include "tensorflow_serving/core/peer_version_fetcher.h"
 #include "tensorflow_serving/core/prefix_storage_path_source_adapter.h"
 #include "tensorflow_serving/core/servable_state_monitor.h"
 #include "tensorflow_serving/core/server_request_logger.h"
@@ -43,10 +50,20 @@ limitations under the License.
 #include "tensorflow_serving/core/source_adapter.h"
 #include "tensorflow_serving/core/storage_path.h"
 #include "tensorflow_serving/core/stream_logger.h"
+#include "tensorflow_serving/model_servers/concurrency_limiter.h"
+#include "tensorflow_serving/model_servers/request_coalescer.h"
+#include "tensorflow_serving/model_servers/response_cache.h"
+#include "tensorflow_serving/model_servers/server_core_snapshot.pb.h"
 #include "tensorflow_serving/servables/tensorflow/predict_util.h"
+#include "tensorflow_serving/servables/tensorflow/dedicated_thread_pool_factory.h"
 #include "tensorflow_serving/servables/tensorflow/servable.h"
+#include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 #include "tensorflow_serving/sources/storage_path/file_system_storage_path_source.h"
 #include "tensorflow_serving/util/event_bus.h"
+#include "tensorflow_serving/util/fast_read_dynamic_ptr.h"
+#include "tensorflow_serving/util/request_trace.h"
+#include "tensorflow_serving/util/retrier.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
 #include "tensorflow_serving/util/unique_ptr_with_deps.h"
 
 namespace tensorflow {
@@ -113,6 +130,10 @@ class ServerCore : public Manager {
     // pool is used and unloads are performed serially in the manager thread.
     int32 num_unload_threads = 0;
 
+    // Whether models are loaded by a WorkStealingExecutor, rather than by a
+    // thread pool with a single queue.
+    bool work_stealing_load_executor = false;
+
     // Total model size limit, in terms of main memory, in bytes.
     uint64_t total_model_memory_limit_bytes =
         std::numeric_limits<uint64_t>::max();
@@ -128,9 +149,35 @@ class ServerCore : public Manager {
     // Default: 1 minute.
     int64_t load_retry_interval_micros = 1LL * 60 * 1000 * 1000;
 
+    // How the interval between load retries grows, from
+    // 'load_retry_interval_micros'. By default it doesn't. Models can override
+    // the retry options in ModelConfig.load_retry_policy.
+    RetryBackoff load_retry_backoff;
+
+    // If positive, the load retries of all models are limited to this rate,
+    // in bursts of up to 'max_load_retry_burst', e.g. to keep the retries of
+    // every model from hammering the storage as it recovers from an outage.
+    double load_retries_per_second = 0;
+    double max_load_retry_burst = 10;
+
     // Time interval between file-system polls, in seconds.
     int32 file_system_poll_wait_seconds = 30;
 
+    // If true, the base paths of the models are also watched for changes
+    // (e.g. with inotify for local paths), so that new versions are found
+    // without waiting for the next file-system poll. Polling remains as a
+    // fallback, so 'file_system_poll_wait_seconds' can then be made larger.
+    bool watch_file_system_for_changes = false;
+
+    // The number of threads to poll the base paths of the models with in
+    // parallel. If 0 or 1, the models are polled one after another.
+    int32 num_file_system_poll_threads = 0;
+
+    // If positive, models whose polls find no change (or fail) are polled
+    // exponentially less often, at least every this many seconds. See
+    // FileSystemStoragePathSourceConfig.max_file_system_poll_backoff_seconds.
+    int64_t max_file_system_poll_backoff_seconds = 0;
+
     // If true, filesystem caches are flushed in the following cases:
     //
     // 1) After the initial models are loaded.
@@ -142,6 +189,27 @@ class ServerCore : public Manager {
     // the initial load, and after every subsequent load of every model version.
     bool flush_filesystem_caches = false;
 
+    // If true, servable handles are reference counted per thread that gets
+    // them, instead of per CPU. This suits servers whose many request threads
+    // share few CPUs. See BasicManager::Options.
+    bool use_per_thread_handle_refs = false;
+
+    // If true, loads are approved in batches, packed against the resource
+    // budget, which speeds up loading many models at startup. See
+    // BasicManager::Options.
+    bool enable_batch_load_approval = false;
+
+    // The maximum number of models whose versions are swapped at the same
+    // time, which bounds the peak memory of refreshing many large models at
+    // once. 0 means unbounded. See AspiredVersionsManager::Options.
+    int32 max_num_concurrent_version_transitions = 0;
+
+    // If true, servable state events are delivered to their subscribers (such
+    // as the servable state monitor) on threads of their own, so that slow
+    // subscribers don't stall the threads that load and unload servables. See
+    // EventBus::Options.
+    bool async_servable_event_publication = false;
+
     // Configuration for the supported platforms.
     PlatformConfigMap platform_config_map;
 
@@ -202,8 +270,51 @@ class ServerCore : public Manager {
     // The prefix to append to the file system storage paths.
     std::string storage_path_prefix;
 
+    // If positive, models are unloaded when the memory in use (of the cgroup
+    // of the server, or of the host) reaches this share of its limit, and
+    // reloaded when requested once it is below 'memory_pressure_low_watermark'
+    // (see MemoryPressureEvictor). Only for models from a ModelConfigList.
+    double memory_pressure_high_watermark = 0;
+    double memory_pressure_low_watermark = 0.8;
+
+    // If set, the model versions at remote storage paths are cached in this
+    // local directory before they are loaded, and loaded from there. See
+    // LocalCacheStoragePathSourceAdapter.
+    std::string model_cache_dir;
+
+    // The number of versions of each model to retain in 'model_cache_dir'.
+    int32 num_cached_model_versions_to_retain = 2;
+
+    // Whether to fetch the model versions into 'model_cache_dir' in the
+    // background, while the earlier versions keep serving, rather than block
+    // the polls of the file system until they are cached.
+    bool fetch_model_versions_in_background = false;
+
+    // If set, the model versions are fetched into 'model_cache_dir' from the
+    // caches of peers that have them, where possible.
+    std::shared_ptr<PeerVersionFetcher> model_peer_fetcher;
+
+    // If set, the available versions of the models, and the order in which
+    // the models became available, are saved to this file once a config is
+    // applied, and as versions come and go. On creation, the saved versions of
+    // the models whose base path and version policy are unchanged are aspired
+    // right away, without waiting for the first poll of the file system, and
+    // loaded in the saved order (after 'load_priority'). Together with
+    // 'model_cache_dir' (and the resource measurement history of
+    // SessionBundleConfig), this speeds up restarts.
+    std::string state_snapshot_path;
+
     bool enable_cors_support = false;
 
+    // If true, REST API responses are written as compact JSON, rather than
+    // indented, unless a request asks otherwise with a 'pretty' query
+    // parameter.
+    bool compact_json_responses = false;
+
+    // If true, REST API predict, classify and regress responses carry a
+    // Server-Timing header with the latency of the stages of the request.
+    bool server_timing_header = false;
+
     // If true, propagate current context to children threads (periodic
     // functions) in AspiredVersionsManager.
     bool with_current_context = false;
@@ -223,6 +334,12 @@ class ServerCore : public Manager {
     return manager_->ListAvailableServableIds();
   }
 
+  /// Returns the local model cache, or null if 'model_cache_dir' is not set or
+  /// no file-system models have been configured yet.
+  const LocalCacheStoragePathSourceAdapter* model_cache() const {
+    return model_cache_.load(std::memory_order_acquire);
+  }
+
   /// Updates the server core with all the models and sources per the
   /// ModelServerConfig. Like Create(), waits for all statically configured
   /// servables to be made available before returning, and returns an error if
@@ -251,9 +368,14 @@ class ServerCore : public Manager {
   /// If 'options_.allow_version_labels==true', recognizes two specific model
   /// version labels -- "stable" and "canary" -- and resolves them to the
   /// smallest and largest available version, respectively.
+  ///
+  /// The handle counts towards the concurrency limits of the model and of the
+  /// labels of its version, if configured, for as long as it is held. Returns
+  /// a ResourceExhausted error beyond the limits (see ConcurrencyLimitConfig).
   template <typename T>
   Status GetServableHandle(const ModelSpec& model_spec,
                            ServableHandle<T>* const handle) {
+    ScopedSpan span("GetServableHandle");
     ServableRequest servable_request;
     tensorflow::Status status =
         ServableRequestFromModelSpec(model_spec, &servable_request);
@@ -261,14 +383,49 @@ class ServerCore : public Manager {
       VLOG(1) << "Unable to get servable handle due to: " << status;
       return status;
     }
-    status = manager_->GetServableHandle(servable_request, handle);
+    status = Manager::GetServableHandle(servable_request, handle);
+    MemoryPressureEvictor* const evictor =
+        memory_pressure_evictor_.load(std::memory_order_acquire);
     if (!status.ok()) {
+      if (evictor != nullptr) {
+        // The model may have been evicted, and is reloaded if so.
+        const Status evicted_status = evictor->CheckEvicted(model_spec.name());
+        if (!evicted_status.ok()) {
+          status = evicted_status;
+        }
+      }
       VLOG(1) << "Unable to get servable handle due to: " << status;
       return status;
     }
+    if (evictor != nullptr) {
+      evictor->RecordRequest(model_spec.name());
+    }
     return Status();
   }
 
+  /// Returns the spec of the variant of the model of 'model_spec' that fits a
+  /// request with a batch of 'batch_size', and the time left before the
+  /// deadline of the current request, if any (see ModelConfig.variants).
+  /// Returns 'model_spec' itself if the model has no variant that fits, or
+  /// if 'model_spec' names a version or a version label.
+  ModelSpec SelectModelVariant(const ModelSpec& model_spec,
+                               int64_t batch_size) const;
+
+  /// Returns the pipeline named 'name' (see ModelConfigList.pipelines), or
+  /// null if there is none.
+  std::shared_ptr<const ModelPipelineConfig> GetModelPipeline(
+      const string& name) const;
+
+  /// Returns the float_output_dtype of the ModelConfig of 'model_name', or
+  /// DT_INVALID if it has none.
+  DataType GetFloatOutputDtype(const string& model_name) const;
+
+  /// Returns the id of the servable that 'model_spec' resolves to, like the
+  /// handle from GetServableHandle() would have, whatever the type of the
+  /// servable. Doesn't hold the servable or count towards the concurrency
+  /// limits, so is cheap enough for every request, e.g. to key its response.
+  Status GetServableId(const ModelSpec& model_spec, ServableId* id);
+
   // This specialized version allows us to override GetServableHandle for
   // Servables in sub-classes. Useful for testing.
   virtual Status GetServableHandle(const ModelSpec& model_spec,
@@ -282,9 +439,20 @@ class ServerCore : public Manager {
   virtual Status Log(const google::protobuf::Message& request,
                      const google::protobuf::Message& response,
                      const LogMetadata& log_metadata) {
+    ScopedSpan span("Log");
     return options_.server_request_logger->Log(request, response, log_metadata);
   }
 
+  /// As above, but without copying 'request' and 'response' on the calling
+  /// thread if the model logs asynchronously. They must not be modified
+  /// afterwards.
+  virtual Status Log(std::shared_ptr<const google::protobuf::Message> request,
+                     std::shared_ptr<const google::protobuf::Message> response,
+                     const LogMetadata& log_metadata) {
+    return options_.server_request_logger->Log(
+        std::move(request), std::move(response), log_metadata);
+  }
+
   // Starts logging a stream through returning a StreamLogger created through
   // `create_stream_logger_fn`. Returns NULL if the stream should not be logged.
   template <typename Request, typename Response>
@@ -296,6 +464,25 @@ class ServerCore : public Manager {
         log_metadata, std::move(create_stream_logger_fn));
   }
 
+  /// Returns the response cache of the model 'model_name', per the
+  /// response_cache_config of its ModelConfig, or null if it has none.
+  /// Doesn't take any lock.
+  std::shared_ptr<ResponseCache> GetResponseCache(
+      const string& model_name) const;
+
+  /// Returns the request coalescer of the model 'model_name', if its
+  /// ModelConfig sets coalesce_requests, else null.
+  std::shared_ptr<RequestCoalescer> GetRequestCoalescer(
+      const string& model_name) const
+      TF_LOCKS_EXCLUDED(request_coalescers_mu_);
+
+  /// Returns the factory of the dedicated thread pools of the model
+  /// 'model_name', per the thread_pool_config of its ModelConfig, or null if
+  /// it has none.
+  std::shared_ptr<ThreadPoolFactory> GetThreadPoolFactory(
+      const string& model_name) const
+      TF_LOCKS_EXCLUDED(thread_pool_factories_mu_);
+
   internal::PredictResponseTensorSerializationOption
   predict_response_tensor_serialization_option() const {
     return options_.predict_response_tensor_serialization_option;
@@ -303,6 +490,12 @@ class ServerCore : public Manager {
 
   bool enable_cors_support() const { return options_.enable_cors_support; }
 
+  bool compact_json_responses() const {
+    return options_.compact_json_responses;
+  }
+
+  bool server_timing_header() const { return options_.server_timing_header; }
+
  protected:
   ServerCore(Options options);
 
@@ -348,13 +541,37 @@ class ServerCore : public Manager {
   Status WaitUntilModelsAvailable(const std::set<string>& models,
                                   ServableStateMonitor* monitor);
 
+  // Returns the versions of 'restart_snapshot_' of the models of 'config_'
+  // whose base path and version policy are unchanged, and those models in the
+  // order they became available.
+  void GetRestartSnapshotVersions(
+      std::map<string, std::vector<ServableData<StoragePath>>>* versions,
+      std::vector<string>* load_order) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
+
+  // Takes the models of the state snapshot from 'config_', and writes it.
+  void UpdateStateSnapshotModels() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_)
+      TF_LOCKS_EXCLUDED(snapshot_mu_);
+
+  // Tracks the available versions of the state snapshot by 'state', and
+  // writes it if they changed.
+  void UpdateStateSnapshotVersions(const ServableState& state)
+      TF_LOCKS_EXCLUDED(snapshot_mu_);
+
+  // Writes the state snapshot to 'options_.state_snapshot_path', once the
+  // first config is applied. Failures are logged, since the snapshot only
+  // speeds up restarts.
+  void WriteStateSnapshot() TF_EXCLUSIVE_LOCKS_REQUIRED(snapshot_mu_);
+
   // Creates a FileSystemStoragePathSource and an optional
-  // PrefixStoragePathSourceAdapter, and connects them to the supplied target.
+  // PrefixStoragePathSourceAdapter and LocalCacheStoragePathSourceAdapter, and
+  // connects them to the supplied target.
   Status CreateStoragePathSource(
       const FileSystemStoragePathSourceConfig& config,
       Target<StoragePath>* target,
       std::unique_ptr<FileSystemStoragePathSource>* source,
-      std::unique_ptr<PrefixStoragePathSourceAdapter>* prefix_source_adapter)
+      std::unique_ptr<PrefixStoragePathSourceAdapter>* prefix_source_adapter,
+      std::unique_ptr<LocalCacheStoragePathSourceAdapter>* cache_source_adapter)
       TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
 
   // The source adapters to deploy, to handle the configured platforms as well
@@ -407,13 +624,56 @@ class ServerCore : public Manager {
       ModelServerConfig::ConfigCase config_case)
       TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
 
+  // Updates 'response_caches_' based on the ModelConfigList of 'config_',
+  // keeping the caches of models whose cache config is unchanged.
+  void UpdateResponseCaches() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
+
+  // Updates 'request_coalescers_' based on the ModelConfigList of 'config_',
+  // keeping the coalescers of models that still coalesce requests.
+  void UpdateRequestCoalescers() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_)
+      TF_LOCKS_EXCLUDED(request_coalescers_mu_);
+
+  // Updates 'concurrency_limiters_' based on the ModelConfigList of 'config_',
+  // keeping the limiters whose config is unchanged.
+  void UpdateConcurrencyLimiters() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_)
+      TF_LOCKS_EXCLUDED(concurrency_limiters_mu_);
+
+  // Updates 'latency_tracking_' based on the ModelConfigList of 'config_'.
+  void UpdateLatencyTracking() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
+
+  // Updates 'model_variants_' based on the ModelConfigList of 'config_'.
+  void UpdateModelVariants() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
+
+  // Updates 'model_pipelines_' based on the ModelConfigList of 'config_'.
+  void UpdateModelPipelines() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
+
+  // Updates 'float_output_dtypes_' based on the ModelConfigList of 'config_'.
+  void UpdateFloatOutputDtypes() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
+
+  // Applies the batching_parameters of the ModelConfigList of 'config_' that
+  // changed to the batched sessions of their models (see
+  // UpdateLiveBatchingParameters()), and updates 'batching_parameters_'.
+  Status UpdateBatchingParameters() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
+
+  // Updates 'thread_pool_factories_' based on the ModelConfigList of 'config_',
+  // keeping the pools whose config is unchanged.
+  Status UpdateThreadPoolFactories() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_)
+      TF_LOCKS_EXCLUDED(thread_pool_factories_mu_);
+
+  // Returns the concurrency limiters that apply to the servable 'id': those of
+  // the labels pointing at its version, then that of its model.
+  std::vector<std::shared_ptr<ConcurrencyLimiter>> GetConcurrencyLimiters(
+      const ServableId& id) const TF_LOCKS_EXCLUDED(concurrency_limiters_mu_);
+
   // Updates 'model_labels_to_versions_' based on 'config_'. Throws an error if
   // requesting to assign an existing label to a version not in state
   // kAvailable. For a new version label, it can be assigned to a version that
   // is not in state kAvailable yet if
-  // allow_version_labels_for_unavailable_models is true.
-  Status UpdateModelVersionLabelMap() TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_)
-      TF_LOCKS_EXCLUDED(model_labels_to_versions_mu_);
+  // allow_version_labels_for_unavailable_models is true. If
+  // 'models_to_update' is set, only the labels of those models are checked and
+  // updated, and those of the other models are kept as they are.
+  Status UpdateModelVersionLabelMap(const std::set<string>* models_to_update)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(config_mu_);
 
   // ************************************************************************
   // Request Processing.
@@ -423,16 +683,23 @@ class ServerCore : public Manager {
   Status ServableRequestFromModelSpec(const ModelSpec& model_spec,
                                       ServableRequest* servable_request) const;
 
-  // Gets the version associated with 'label', for the given model name.
+  // If 'model_spec.version_label' is a weighted version label of the model,
+  // picks one of its versions by 'model_spec.routing_key' into '*version' and
+  // returns true. Returns false otherwise.
+  bool GetModelVersionForWeightedLabel(const ModelSpec& model_spec,
+                                       int64_t* version) const;
+
+  // Gets the version associated with 'label', for the given model name. The
+  // calling thread caches the result until the label map is replaced. Doesn't
+  // take any lock.
   Status GetModelVersionForLabel(const string& model_name, const string& label,
-                                 int64_t* version) const
-      TF_LOCKS_EXCLUDED(model_labels_to_versions_mu_);
+                                 int64_t* version) const;
 
+  // Admits the request to the servable under the concurrency limits, then
+  // returns a handle that releases its admission when destroyed.
   Status GetUntypedServableHandle(
       const ServableRequest& request,
-      std::unique_ptr<UntypedServableHandle>* untyped_handle) override {
-    return manager_->GetUntypedServableHandle(request, untyped_handle);
-  }
+      std::unique_ptr<UntypedServableHandle>* untyped_handle) override;
 
   std::map<ServableId, std::unique_ptr<UntypedServableHandle>>
   GetAvailableUntypedServableHandles() const override {
@@ -454,9 +721,36 @@ class ServerCore : public Manager {
   // The most recent config supplied to ReloadConfig().
   ModelServerConfig config_ TF_GUARDED_BY(config_mu_);
 
-  // A model_name->label->version# map.
-  std::unique_ptr<std::map<string, std::map<string, int64_t>>>
-      model_labels_to_versions_ TF_GUARDED_BY(model_labels_to_versions_mu_);
+  // Whether all of 'config_' has been applied, i.e. the last ReloadConfig()
+  // succeeded, in which case reloading the same config is a no-op.
+  bool config_applied_ TF_GUARDED_BY(config_mu_) = false;
+
+  // A model_name->label->version# map, which is immutable once published, and
+  // replaced whole by UpdateModelVersionLabelMap(). Null until the first
+  // config with labels is applied.
+  FastReadDynamicPtr<std::map<string, std::map<string, int64_t>>>
+      model_labels_to_versions_;
+
+  // A version of a weighted version label, and the upper end of its share of
+  // [0, 1), after the shares of the lower versions of the label.
+  struct WeightedVersion {
+    int64_t version;
+    double cumulative_weight;
+  };
+  // A model_name->label->versions map of the weighted version labels, in
+  // increasing version order. Replaced with 'model_labels_to_versions_'.
+  using WeightedVersionLabelMap =
+      std::map<string, std::map<string, std::vector<WeightedVersion>>>;
+  FastReadDynamicPtr<WeightedVersionLabelMap> weighted_version_labels_;
+  // Whether 'weighted_version_labels_' is non-empty, so that the requests of
+  // servers without weighted labels skip looking them up.
+  std::atomic<bool> has_weighted_version_labels_{false};
+
+  // Identifies the current 'model_labels_to_versions_' among all the label
+  // maps of the process, so that the per-thread caches of the resolved labels
+  // (see GetModelVersionForLabel()) know when they are stale. Zero while there
+  // is no label map.
+  std::atomic<uint64_t> model_labels_to_versions_generation_{0};
 
   struct StoragePathSourceAndRouter {
     FileSystemStoragePathSource* source;
@@ -469,12 +763,131 @@ class ServerCore : public Manager {
   absl::optional<StoragePathSourceAndRouter> storage_path_source_and_router_
       TF_GUARDED_BY(config_mu_);
 
+  // The local model cache, if any, which is owned by 'manager_'. Set along
+  // with 'storage_path_source_and_router_'.
+  std::atomic<LocalCacheStoragePathSourceAdapter*> model_cache_{nullptr};
+
+  // The evictor of models under memory pressure, if any, which is owned by
+  // 'manager_'. Set along with 'storage_path_source_and_router_'.
+  std::atomic<MemoryPressureEvictor*> memory_pressure_evictor_{nullptr};
+
+  // The response caches of the models that have one, by model name, with the
+  // config each was created from.
+  struct ResponseCacheAndConfig {
+    ResponseCacheConfig config;
+    std::shared_ptr<ResponseCache> cache;
+  };
+  // Published like 'model_variants_', since every request that may be cached
+  // looks it up.
+  FastReadDynamicPtr<std::map<string, ResponseCacheAndConfig>>
+      response_caches_;
+
+  // Whether 'response_caches_' is non-empty, which spares the requests to
+  // models without caches from looking them up.
+  std::atomic<bool> has_response_caches_{false};
+
+  // The request coalescers of the models that coalesce requests, by model
+  // name.
+  std::map<string, std::shared_ptr<RequestCoalescer>> request_coalescers_
+      TF_GUARDED_BY(request_coalescers_mu_);
+
+  // Whether 'request_coalescers_' is non-empty, like 'has_response_caches_'.
+  std::atomic<bool> has_request_coalescers_{false};
+
+  mutable mutex request_coalescers_mu_;
+
+  // The concurrency limiters of the models that have any, by model name.
+  struct ModelConcurrencyLimiters {
+    // Null if the model itself has no limit.
+    std::shared_ptr<ConcurrencyLimiter> model_limiter;
+    std::map<string, std::shared_ptr<ConcurrencyLimiter>> label_limiters;
+  };
+  std::map<string, ModelConcurrencyLimiters> concurrency_limiters_
+      TF_GUARDED_BY(concurrency_limiters_mu_);
+
+  // Whether 'concurrency_limiters_' is non-empty, like 'has_response_caches_'.
+  std::atomic<bool> has_concurrency_limiters_{false};
+
+  mutable mutex concurrency_limiters_mu_;
+
+  // The tracking of the latency of the models with a 'latency_slo_micros', for
+  // their saturation signals, by model name.
+  struct LatencyTracking {
+    int64_t latency_slo_micros;
+    std::unique_ptr<SaturationMonitor::Registration> registration;
+  };
+  std::map<string, LatencyTracking> latency_tracking_
+      TF_GUARDED_BY(config_mu_);
+
+  // The variants of the models that have them, by model name, in config
+  // order. Immutable once published, and replaced whole on config reloads.
+  FastReadDynamicPtr<std::map<string, std::vector<ModelVariant>>>
+      model_variants_;
+  // Whether 'model_variants_' is non-empty, so that the requests of servers
+  // without variants skip looking them up.
+  std::atomic<bool> has_model_variants_{false};
+
+  // The pipelines of the config list, by name, published like
+  // 'model_variants_'.
+  FastReadDynamicPtr<std::map<string, ModelPipelineConfig>> model_pipelines_;
+  std::atomic<bool> has_model_pipelines_{false};
+
+  // The float_output_dtype of the models that have one, by model name,
+  // published like 'model_variants_'.
+  FastReadDynamicPtr<std::map<string, DataType>> float_output_dtypes_;
+  std::atomic<bool> has_float_output_dtypes_{false};
+
+  // The batching_parameters of the models that have them, by model name, as
+  // last applied.
+  std::map<string, BatchingParameters> batching_parameters_
+      TF_GUARDED_BY(config_mu_);
+
+  // The factories of the dedicated thread pools of the models that have them,
+  // by model name, and by the key of their allocation (see ThreadPoolKey()).
+  std::map<string, std::shared_ptr<ThreadPoolFactory>> thread_pool_factories_
+      TF_GUARDED_BY(thread_pool_factories_mu_);
+  std::map<string, std::shared_ptr<DedicatedThreadPoolFactory>>
+      thread_pool_factories_by_key_ TF_GUARDED_BY(thread_pool_factories_mu_);
+
+  // Whether 'thread_pool_factories_' is non-empty, like
+  // 'has_response_caches_'.
+  std::atomic<bool> has_thread_pool_factories_{false};
+
+  mutable mutex thread_pool_factories_mu_;
+
   // A mutex for reconfiguration, used by ReloadConfig().
   mutable mutex config_mu_;
 
-  // A mutex for swapping the model version label map. Should only be held for
-  // a short time (i.e. pointer swap) to avoid holding up inference requests.
-  mutable mutex model_labels_to_versions_mu_;
+  // The snapshot read from 'options_.state_snapshot_path' on creation, which
+  // applies to the first config only.
+  ServerCoreSnapshot restart_snapshot_ TF_GUARDED_BY(config_mu_);
+
+  // The storage path source, for the paths of the versions of the state
+  // snapshot. Set along with 'storage_path_source_and_router_'.
+  std::atomic<FileSystemStoragePathSource*> snapshot_source_{nullptr};
+
+  mutex snapshot_mu_;
+
+  // The models of the state snapshot, without their versions, by name. Empty
+  // until the first config is applied.
+  std::map<string, ServerCoreSnapshot::Model> snapshot_models_
+      TF_GUARDED_BY(snapshot_mu_);
+
+  // The available versions of each model, with their storage paths, and the
+  // number of the state event that made them available (for the order of the
+  // models).
+  struct SnapshotVersion {
+    string path;
+    uint64_t event_number;
+  };
+  std::map<string, std::map<int64_t, SnapshotVersion>> snapshot_versions_
+      TF_GUARDED_BY(snapshot_mu_);
+  uint64_t num_snapshot_events_ TF_GUARDED_BY(snapshot_mu_) = 0;
+
+  // Feeds UpdateStateSnapshotVersions(). Declared last, so that it is
+  // destroyed first: the versions unloaded when 'manager_' is torn down are
+  // not taken out of the snapshot.
+  std::unique_ptr<EventBus<ServableState>::Subscription> snapshot_subscription_;
 };
 
 }  // namespace serving
@@ -24,12 +24,15 @@ limitations under the License.
 #include "google/protobuf/any.pb.h"
 #include "absl/status/status.h"
 #include "absl/strings/strip.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tensorflow/cc/saved_model/tag_constants.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
@@ -43,11 +46,13 @@ limitations under the License.
 #include "tensorflow_serving/core/test_util/mock_prediction_stream_logger.h"
 #include "tensorflow_serving/core/test_util/mock_request_logger.h"
 #include "tensorflow_serving/model_servers/model_platform_types.h"
+#include "tensorflow_serving/model_servers/server_core_snapshot.pb.h"
 #include "tensorflow_serving/model_servers/test_util/server_core_test_util.h"
 #include "tensorflow_serving/model_servers/test_util/storage_path_error_injecting_source_adapter.h"
 #include "tensorflow_serving/model_servers/test_util/storage_path_error_injecting_source_adapter.pb.h"
 #include "tensorflow_serving/test_util/test_util.h"
 #include "tensorflow_serving/util/oss_or_google.h"
+#include "tensorflow_serving/util/request_deadline.h"
 
 namespace tensorflow {
 namespace serving {
@@ -584,6 +589,103 @@ TEST_P(ServerCoreTest, IllegalToChangeModelPlatform) {
               ::testing::HasSubstr("Illegal to change a model's platform"));
 }
 
+TEST_P(ServerCoreTest, ResponseCaches) {
+  std::unique_ptr<ServerCore> server_core;
+  ModelServerConfig config = GetTestModelServerConfigForTensorflowPlatform();
+  TF_ASSERT_OK(CreateServerCore(config, &server_core));
+  EXPECT_EQ(nullptr, server_core->GetResponseCache(kTestModelName));
+
+  ModelConfig* model_config =
+      config.mutable_model_config_list()->mutable_config(0);
+  model_config->mutable_response_cache_config()->set_max_bytes(1 << 20);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  const std::shared_ptr<ResponseCache> cache =
+      server_core->GetResponseCache(kTestModelName);
+  ASSERT_NE(nullptr, cache);
+  EXPECT_EQ(nullptr, server_core->GetResponseCache("other_model"));
+
+  // The cache is kept while its config is unchanged.
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_EQ(cache, server_core->GetResponseCache(kTestModelName));
+  model_config->mutable_response_cache_config()->set_ttl_seconds(60);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_NE(cache, server_core->GetResponseCache(kTestModelName));
+
+  model_config->mutable_response_cache_config()->set_max_bytes(0);
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+}
+
+TEST_P(ServerCoreTest, GetServableId) {
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(GetTestModelServerConfigForFakePlatform(),
+                                &server_core));
+  ModelSpec model_spec;
+  model_spec.set_name(test_util::kTestModelName);
+  ServableId id;
+  TF_ASSERT_OK(server_core->GetServableId(model_spec, &id));
+  EXPECT_EQ(ServableId({test_util::kTestModelName,
+                        test_util::kTestModelVersion}),
+            id);
+
+  model_spec.mutable_version()->set_value(test_util::kTestModelVersion + 1);
+  EXPECT_FALSE(server_core->GetServableId(model_spec, &id).ok());
+}
+
+TEST_P(ServerCoreTest, RequestCoalescers) {
+  std::unique_ptr<ServerCore> server_core;
+  ModelServerConfig config = GetTestModelServerConfigForTensorflowPlatform();
+  TF_ASSERT_OK(CreateServerCore(config, &server_core));
+  EXPECT_EQ(nullptr, server_core->GetRequestCoalescer(kTestModelName));
+
+  ModelConfig* model_config =
+      config.mutable_model_config_list()->mutable_config(0);
+  model_config->set_coalesce_requests(true);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  const std::shared_ptr<RequestCoalescer> coalescer =
+      server_core->GetRequestCoalescer(kTestModelName);
+  ASSERT_NE(nullptr, coalescer);
+  EXPECT_EQ(nullptr, server_core->GetRequestCoalescer("other_model"));
+
+  // The coalescer, and the requests in flight in it, are kept across reloads.
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_EQ(coalescer, server_core->GetRequestCoalescer(kTestModelName));
+
+  model_config->set_coalesce_requests(false);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_EQ(nullptr, server_core->GetRequestCoalescer(kTestModelName));
+}
+
+TEST_P(ServerCoreTest, ThreadPools) {
+  std::unique_ptr<ServerCore> server_core;
+  ModelServerConfig config = GetTestModelServerConfigForTensorflowPlatform();
+  TF_ASSERT_OK(CreateServerCore(config, &server_core));
+  EXPECT_EQ(nullptr, server_core->GetThreadPoolFactory(kTestModelName));
+
+  ModelConfig* model_config =
+      config.mutable_model_config_list()->mutable_config(0);
+  model_config->mutable_thread_pool_config()->set_num_intra_op_threads(2);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  const std::shared_ptr<ThreadPoolFactory> factory =
+      server_core->GetThreadPoolFactory(kTestModelName);
+  ASSERT_NE(nullptr, factory);
+  const thread::ThreadPoolOptions thread_pools =
+      factory->GetThreadPools().get();
+  EXPECT_EQ(nullptr, thread_pools.inter_op_threadpool);
+  ASSERT_NE(nullptr, thread_pools.intra_op_threadpool);
+  EXPECT_EQ(2, thread_pools.intra_op_threadpool->NumThreads());
+  EXPECT_EQ(nullptr, server_core->GetThreadPoolFactory("other_model"));
+
+  // The pools are kept while their config is unchanged.
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_EQ(factory, server_core->GetThreadPoolFactory(kTestModelName));
+  model_config->mutable_thread_pool_config()->set_num_inter_op_threads(1);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_NE(factory, server_core->GetThreadPoolFactory(kTestModelName));
+
+  model_config->mutable_thread_pool_config()->add_cpus(-1);
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+}
+
 TEST_P(ServerCoreTest, RequestLoggingOff) {
   // Create a ServerCore with deprecated config.
   std::unique_ptr<ServerCore> server_core;
@@ -759,6 +861,333 @@ TEST_P(ServerCoreTest, ModelSpecMultipleVersionsAvailable) {
   }
 }
 
+TEST_P(ServerCoreTest, WeightedVersionLabels) {
+  ModelServerConfig two_version_config =
+      GetTestModelServerConfigForFakePlatform();
+  SwitchToHalfPlusTwoWith2Versions(&two_version_config);
+  ServerCore::Options server_core_options = GetDefaultOptions();
+  server_core_options.allow_version_labels = true;
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(two_version_config,
+                                std::move(server_core_options), &server_core));
+  test_util::WaitUntilVersionsAvailable(*server_core->servable_state_monitor(),
+                                        test_util::kTestModelName,
+                                        test_util::kAspiredVersions);
+
+  ModelConfig* model_config =
+      two_version_config.mutable_model_config_list()->mutable_config(0);
+  auto* weights =
+      (*model_config->mutable_weighted_version_labels())["canary"]
+          .mutable_weights();
+  (*weights)[test_util::kTestModelVersion] = 9;
+  (*weights)[test_util::kTestModelLargerVersion] = 1;
+  TF_ASSERT_OK(server_core->ReloadConfig(two_version_config));
+
+  auto get_version = [&](const string& routing_key) {
+    ModelSpec model_spec;
+    model_spec.set_name(test_util::kTestModelName);
+    model_spec.set_version_label("canary");
+    model_spec.set_routing_key(routing_key);
+    ServableHandle<string> servable_handle;
+    TF_CHECK_OK(
+        server_core->GetServableHandle<string>(model_spec, &servable_handle));
+    return servable_handle.id().version;
+  };
+
+  // Requests with the same routing key go to the same version, and requests
+  // with different keys are split by the weights.
+  std::map<int64_t, int> version_counts;
+  for (int i = 0; i < 1000; ++i) {
+    const string routing_key = strings::StrCat("user", i);
+    const int64_t version = get_version(routing_key);
+    EXPECT_EQ(version, get_version(routing_key));
+    ++version_counts[version];
+  }
+  EXPECT_GT(version_counts[test_util::kTestModelVersion], 800);
+  EXPECT_GT(version_counts[test_util::kTestModelLargerVersion], 50);
+
+  // Moving all of the weight to one version sends all requests to it, with or
+  // without a routing key.
+  weights->clear();
+  (*weights)[test_util::kTestModelLargerVersion] = 1;
+  TF_ASSERT_OK(server_core->ReloadConfig(two_version_config));
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(test_util::kTestModelLargerVersion,
+              get_version(strings::StrCat("user", i)));
+  }
+  EXPECT_EQ(test_util::kTestModelLargerVersion, get_version(""));
+}
+
+TEST_P(ServerCoreTest, InvalidWeightedVersionLabels) {
+  ModelServerConfig two_version_config =
+      GetTestModelServerConfigForFakePlatform();
+  SwitchToHalfPlusTwoWith2Versions(&two_version_config);
+  ServerCore::Options server_core_options = GetDefaultOptions();
+  server_core_options.allow_version_labels = true;
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(two_version_config,
+                                std::move(server_core_options), &server_core));
+  test_util::WaitUntilVersionsAvailable(*server_core->servable_state_monitor(),
+                                        test_util::kTestModelName,
+                                        test_util::kAspiredVersions);
+
+  // A label with no versions.
+  {
+    ModelServerConfig config = two_version_config;
+    (*config.mutable_model_config_list()
+          ->mutable_config(0)
+          ->mutable_weighted_version_labels())["canary"];
+    EXPECT_EQ(error::INVALID_ARGUMENT,
+              server_core->ReloadConfig(config).code());
+  }
+
+  // A non-positive weight.
+  {
+    ModelServerConfig config = two_version_config;
+    (*(*config.mutable_model_config_list()
+            ->mutable_config(0)
+            ->mutable_weighted_version_labels())["canary"]
+          .mutable_weights())[test_util::kTestModelVersion] = 0;
+    EXPECT_EQ(error::INVALID_ARGUMENT,
+              server_core->ReloadConfig(config).code());
+  }
+
+  // A label that is also a plain version label.
+  {
+    ModelServerConfig config = two_version_config;
+    ModelConfig* model_config =
+        config.mutable_model_config_list()->mutable_config(0);
+    (*model_config->mutable_version_labels())["canary"] =
+        test_util::kTestModelVersion;
+    (*(*model_config->mutable_weighted_version_labels())["canary"]
+          .mutable_weights())[test_util::kTestModelVersion] = 1;
+    EXPECT_EQ(error::INVALID_ARGUMENT,
+              server_core->ReloadConfig(config).code());
+  }
+
+  // A version that isn't available.
+  {
+    ModelServerConfig config = two_version_config;
+    (*(*config.mutable_model_config_list()
+            ->mutable_config(0)
+            ->mutable_weighted_version_labels())["canary"]
+          .mutable_weights())[99999] = 1;
+    EXPECT_EQ(error::FAILED_PRECONDITION,
+              server_core->ReloadConfig(config).code());
+  }
+}
+
+TEST_P(ServerCoreTest, ConcurrencyLimits) {
+  ModelServerConfig two_version_config =
+      GetTestModelServerConfigForFakePlatform();
+  SwitchToHalfPlusTwoWith2Versions(&two_version_config);
+  ServerCore::Options server_core_options = GetDefaultOptions();
+  server_core_options.allow_version_labels = true;
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(two_version_config,
+                                std::move(server_core_options), &server_core));
+  test_util::WaitUntilVersionsAvailable(*server_core->servable_state_monitor(),
+                                        test_util::kTestModelName,
+                                        test_util::kAspiredVersions);
+
+  // Allow two requests to the model at once, of which one to the version
+  // labeled "canary".
+  test_util::MutateModelConfig(&two_version_config)
+      .SetLabelVersion("canary", test_util::kTestModelLargerVersion);
+  ModelConfig* model_config =
+      two_version_config.mutable_model_config_list()->mutable_config(0);
+  model_config->mutable_concurrency_limit()->set_max_in_flight_requests(2);
+  (*model_config->mutable_version_label_concurrency_limits())["canary"]
+      .set_max_in_flight_requests(1);
+  TF_ASSERT_OK(server_core->ReloadConfig(two_version_config));
+
+  ModelSpec latest_spec;
+  latest_spec.set_name(test_util::kTestModelName);
+  ModelSpec canary_spec = latest_spec;
+  canary_spec.set_version_label("canary");
+  ModelSpec stable_spec = latest_spec;
+  stable_spec.mutable_version()->set_value(test_util::kTestModelVersion);
+
+  // The label limit applies to the version however it is requested.
+  auto get_handle = [&server_core](const ModelSpec& model_spec,
+                                   ServableHandle<string>* handle) {
+    return server_core->GetServableHandle<string>(model_spec, handle);
+  };
+  ServableHandle<string> canary_handle, latest_handle, stable_handle;
+  TF_ASSERT_OK(get_handle(canary_spec, &canary_handle));
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED,
+            get_handle(latest_spec, &latest_handle).code());
+
+  // The model limit applies to all versions.
+  TF_ASSERT_OK(get_handle(stable_spec, &stable_handle));
+  ServableHandle<string> other_stable_handle;
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED,
+            get_handle(stable_spec, &other_stable_handle).code());
+
+  // Releasing a handle releases its share of the limits.
+  canary_handle = ServableHandle<string>();
+  TF_EXPECT_OK(get_handle(latest_spec, &latest_handle));
+
+  // Unchanged limits are kept on reload, including the requests in flight.
+  TF_ASSERT_OK(server_core->ReloadConfig(two_version_config));
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED,
+            get_handle(stable_spec, &other_stable_handle).code());
+
+  model_config->mutable_concurrency_limit()->set_max_in_flight_requests(0);
+  EXPECT_FALSE(server_core->ReloadConfig(two_version_config).ok());
+}
+
+TEST_P(ServerCoreTest, ModelVariants) {
+  ModelServerConfig config = GetTestModelServerConfigForFakePlatform();
+  ModelConfig* model_config =
+      config.mutable_model_config_list()->mutable_config(0);
+  ModelConfig* small_config = config.mutable_model_config_list()->add_config();
+  *small_config = *model_config;
+  small_config->set_name("small");
+  ModelConfig* fast_config = config.mutable_model_config_list()->add_config();
+  *fast_config = *model_config;
+  fast_config->set_name("fast");
+  ModelVariant* small_variant = model_config->add_variants();
+  small_variant->set_model_name("small");
+  small_variant->set_max_batch_size(4);
+  small_variant->set_min_latency_budget_micros(1000 * 1000);
+  model_config->add_variants()->set_model_name("fast");
+
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(config, &server_core));
+  ModelSpec model_spec;
+  model_spec.set_name(kTestModelName);
+  model_spec.set_signature_name("serving_default");
+
+  // The first variant that fits the request is picked.
+  ModelSpec variant_spec = server_core->SelectModelVariant(model_spec, 4);
+  EXPECT_EQ("small", variant_spec.name());
+  EXPECT_EQ("serving_default", variant_spec.signature_name());
+  EXPECT_EQ("fast", server_core->SelectModelVariant(model_spec, 5).name());
+  {
+    ScopedRequestDeadline scoped_deadline(std::make_shared<RequestDeadline>(
+        absl::Now() + absl::Milliseconds(100), []() { return false; }));
+    EXPECT_EQ("fast", server_core->SelectModelVariant(model_spec, 1).name());
+  }
+
+  // Requests for a version, and for models without variants, are not routed.
+  ModelSpec version_spec = model_spec;
+  version_spec.mutable_version()->set_value(test_util::kTestModelVersion);
+  EXPECT_EQ(kTestModelName,
+            server_core->SelectModelVariant(version_spec, 1).name());
+  EXPECT_EQ("small", server_core->SelectModelVariant(variant_spec, 1).name());
+
+  // Variants must be other models in the config.
+  model_config->add_variants()->set_model_name("missing");
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+  model_config->mutable_variants()->RemoveLast();
+  model_config->add_variants()->set_model_name(kTestModelName);
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+
+  model_config->clear_variants();
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_EQ(kTestModelName,
+            server_core->SelectModelVariant(model_spec, 1).name());
+}
+
+TEST_P(ServerCoreTest, ModelPipelines) {
+  ModelServerConfig config = GetTestModelServerConfigForFakePlatform();
+  ModelPipelineConfig* pipeline =
+      config.mutable_model_config_list()->add_pipelines();
+  *pipeline = test_util::CreateProto<ModelPipelineConfig>(R"(
+    name: "pipeline"
+    stages {
+      name: "first"
+      inputs {
+        key: "x"
+        value { alias: "x" }
+      }
+    }
+    stages {
+      name: "second"
+      inputs {
+        key: "x"
+        value { stage: "first" alias: "y" }
+      }
+    }
+    outputs {
+      key: "y"
+      value { stage: "second" alias: "y" }
+    })");
+  for (PipelineStage& stage : *pipeline->mutable_stages()) {
+    stage.set_model_name(kTestModelName);
+  }
+
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(config, &server_core));
+  const std::shared_ptr<const ModelPipelineConfig> published =
+      server_core->GetModelPipeline("pipeline");
+  ASSERT_NE(nullptr, published);
+  EXPECT_THAT(*published, test_util::EqualsProto(*pipeline));
+  EXPECT_EQ(nullptr, server_core->GetModelPipeline(kTestModelName));
+
+  // Stages take the tensors of earlier stages only.
+  (*pipeline->mutable_stages(0)->mutable_inputs())["x"].set_stage("second");
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+  (*pipeline->mutable_stages(0)->mutable_inputs())["x"].clear_stage();
+  // Stages run models of the config list.
+  pipeline->mutable_stages(1)->set_model_name("missing");
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+  pipeline->mutable_stages(1)->set_model_name(kTestModelName);
+  // Pipelines are named apart from the models.
+  pipeline->set_name(kTestModelName);
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+  pipeline->set_name("pipeline");
+  // Outputs are stage outputs.
+  (*pipeline->mutable_outputs())["y"].clear_stage();
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+
+  config.mutable_model_config_list()->clear_pipelines();
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_EQ(nullptr, server_core->GetModelPipeline("pipeline"));
+}
+
+TEST_P(ServerCoreTest, FloatOutputDtypes) {
+  ModelServerConfig config = GetTestModelServerConfigForFakePlatform();
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(config, &server_core));
+  EXPECT_EQ(DT_INVALID, server_core->GetFloatOutputDtype(kTestModelName));
+
+  ModelConfig* model_config =
+      config.mutable_model_config_list()->mutable_config(0);
+  model_config->set_float_output_dtype(DT_BFLOAT16);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  EXPECT_EQ(DT_BFLOAT16, server_core->GetFloatOutputDtype(kTestModelName));
+  EXPECT_EQ(DT_INVALID, server_core->GetFloatOutputDtype("missing"));
+
+  // Outputs are only returned as floats of some precision.
+  model_config->set_float_output_dtype(DT_INT32);
+  EXPECT_FALSE(server_core->ReloadConfig(config).ok());
+  EXPECT_EQ(DT_BFLOAT16, server_core->GetFloatOutputDtype(kTestModelName));
+}
+
+TEST_P(ServerCoreTest, BatchingParameters) {
+  ModelServerConfig config = GetTestModelServerConfigForFakePlatform();
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(config, &server_core));
+
+  ModelConfig* model_config =
+      config.mutable_model_config_list()->mutable_config(0);
+  BatchingParameters* batching_params =
+      model_config->mutable_batching_parameters();
+  batching_params->mutable_max_batch_size()->set_value(8);
+  batching_params->mutable_batch_timeout_micros()->set_value(500);
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+  model_config->clear_batching_parameters();
+  TF_ASSERT_OK(server_core->ReloadConfig(config));
+
+  // Only some of the batching parameters can change without a reload.
+  model_config->mutable_batching_parameters()->set_enable_input_row_dedup(
+      true);
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            server_core->ReloadConfig(config).code());
+}
+
 TEST_P(ServerCoreTest, AssignLabelToUnavailableVersion) {
   ModelServerConfig two_version_config =
       GetTestModelServerConfigForFakePlatform();
@@ -784,6 +1213,88 @@ TEST_P(ServerCoreTest, AssignLabelToUnavailableVersion) {
               ::testing::HasSubstr("not currently available for inference"));
 }
 
+TEST_P(ServerCoreTest, RestartFromStateSnapshot) {
+  const string snapshot_path = io::JoinPath(
+      testing::TmpDir(), strings::StrCat("state_snapshot_", random::New64()));
+  ModelServerConfig two_version_config =
+      GetTestModelServerConfigForFakePlatform();
+  SwitchToHalfPlusTwoWith2Versions(&two_version_config);
+  {
+    ServerCore::Options server_core_options = GetDefaultOptions();
+    server_core_options.state_snapshot_path = snapshot_path;
+    std::unique_ptr<ServerCore> server_core;
+    TF_ASSERT_OK(CreateServerCore(two_version_config,
+                                  std::move(server_core_options),
+                                  &server_core));
+  }
+
+  ServerCoreSnapshot snapshot;
+  TF_ASSERT_OK(ReadTextProto(Env::Default(), snapshot_path, &snapshot));
+  ASSERT_EQ(1, snapshot.models_size());
+  EXPECT_EQ(test_util::kTestModelName, snapshot.models(0).name());
+  EXPECT_EQ(two_version_config.model_config_list().config(0).base_path(),
+            snapshot.models(0).base_path());
+  ASSERT_GT(snapshot.models(0).versions_size(), 0);
+
+  // Without file-system polls, the model can only be found by the snapshot.
+  ServerCore::Options server_core_options = GetDefaultOptions();
+  server_core_options.state_snapshot_path = snapshot_path;
+  server_core_options.file_system_poll_wait_seconds = -1;
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(two_version_config,
+                                std::move(server_core_options), &server_core));
+  ModelSpec model_spec;
+  model_spec.set_name(test_util::kTestModelName);
+  model_spec.mutable_version()->set_value(
+      snapshot.models(0).versions(0).version());
+  ServableHandle<string> servable_handle;
+  TF_ASSERT_OK(
+      server_core->GetServableHandle<string>(model_spec, &servable_handle));
+}
+
+TEST_P(ServerCoreTest, ReloadSameConfigAfterFailureRetries) {
+  ModelServerConfig two_version_config =
+      GetTestModelServerConfigForFakePlatform();
+  SwitchToHalfPlusTwoWith2Versions(&two_version_config);
+  ServerCore::Options server_core_options = GetDefaultOptions();
+  server_core_options.allow_version_labels = true;
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(two_version_config,
+                                std::move(server_core_options), &server_core));
+  test_util::WaitUntilVersionsAvailable(*server_core->servable_state_monitor(),
+                                        test_util::kTestModelName,
+                                        test_util::kAspiredVersions);
+
+  // Reloading an unchanged config is a no-op.
+  TF_ASSERT_OK(server_core->ReloadConfig(two_version_config));
+
+  // A config that failed to apply isn't taken as applied when it comes again.
+  ModelServerConfig bogus_label_config = two_version_config;
+  test_util::MutateModelConfig(&bogus_label_config)
+      .SetLabelVersion("nice try", test_util::kTestModelBogusVersion);
+  EXPECT_FALSE(server_core->ReloadConfig(bogus_label_config).ok());
+  EXPECT_FALSE(server_core->ReloadConfig(bogus_label_config).ok());
+
+  // Labels that didn't change stay valid when other labels change.
+  test_util::MutateModelConfig(&two_version_config)
+      .SetLabelVersion("A", test_util::kTestModelVersion);
+  TF_ASSERT_OK(server_core->ReloadConfig(two_version_config));
+  test_util::MutateModelConfig(&two_version_config)
+      .SetLabelVersion("B", test_util::kTestModelLargerVersion);
+  TF_ASSERT_OK(server_core->ReloadConfig(two_version_config));
+  for (const auto& label_and_version :
+       {std::make_pair("A", test_util::kTestModelVersion),
+        std::make_pair("B", test_util::kTestModelLargerVersion)}) {
+    ModelSpec model_spec;
+    model_spec.set_name(test_util::kTestModelName);
+    model_spec.set_version_label(label_and_version.first);
+    ServableHandle<string> servable_handle;
+    TF_ASSERT_OK(
+        server_core->GetServableHandle<string>(model_spec, &servable_handle));
+    EXPECT_EQ(label_and_version.second, servable_handle.id().version);
+  }
+}
+
 TEST_P(ServerCoreTest, AssignLabelToUnavailableVersionAllowed) {
   ModelServerConfig two_version_config =
       GetTestModelServerConfigForFakePlatform();
@@ -0,0 +1,305 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// End-to-end benchmarks of the serving hot path: requests go through
+// PredictionServiceImpl or HttpRestApiHandler into an in-process ServerCore
+// serving fixed reference models, with and without batching, so that they
+// catch regressions anywhere between request parsing and response
+// serialization that the benchmarks of the individual pieces miss.
+//
+// Run with:
+// bazel run -c opt --dynamic_mode=off \
+// tensorflow_serving/model_servers:serving_benchmark -- --benchmarks=.
+//
+// The first argument of each benchmark is the reference model (see
+// ReferenceModel), the second whether batching is enabled. Throughput is
+// reported as items per second; compare runs at the same thread counts.
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow_serving/apis/classification.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/core/availability_preserving_policy.h"
+#include "tensorflow_serving/model_servers/http_rest_api_handler.h"
+#include "tensorflow_serving/model_servers/model_platform_types.h"
+#include "tensorflow_serving/model_servers/prediction_service_impl.h"
+#include "tensorflow_serving/model_servers/server_core.h"
+#include "tensorflow_serving/model_servers/server_init.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// The reference models, by benchmark argument.
+enum ReferenceModel {
+  // A SavedModel computing y = x / 2 + 2, i.e. the fixed cost of a request.
+  kHalfPlusTwo = 0,
+  // A quantized MobileNet image classifier, served by TF Lite.
+  kMobileNet = 1,
+  // A SavedModel using TF Text ops, computing y = x + 1.
+  kTextRegression = 2,
+};
+
+constexpr char kHalfPlusTwoName[] = "half_plus_two";
+constexpr char kMobileNetName[] = "mobilenet";
+constexpr char kTextRegressionName[] = "text_regression";
+
+// MobileNet takes a batch of 224x224 RGB images.
+constexpr int kImageSize = 224 * 224 * 3;
+
+std::unique_ptr<ServerCore> CreateServerCore(const bool enable_batching) {
+  ModelServerConfig config;
+  const auto add_model = [&config](const string& name, const string& path) {
+    auto* model_config = config.mutable_model_config_list()->add_config();
+    model_config->set_name(name);
+    model_config->set_base_path(path);
+    model_config->set_model_platform(kTensorFlowModelPlatform);
+  };
+  add_model(kHalfPlusTwoName, test_util::TensorflowTestSrcDirPath(
+                                  "cc/saved_model/testdata/half_plus_two"));
+  add_model(kMobileNetName,
+            test_util::TestSrcDirPath(
+                "servables/tensorflow/testdata/mobilenet_v1_quant_tflite"));
+  add_model(kTextRegressionName,
+            test_util::TestSrcDirPath(
+                "servables/tensorflow/testdata/tf_text_regression"));
+
+  SessionBundleConfig session_bundle_config;
+  // Serves MobileNet with TF Lite; the other models have no TF Lite form.
+  session_bundle_config.set_prefer_tflite_model(true);
+  if (enable_batching) {
+    BatchingParameters* batching_parameters =
+        session_bundle_config.mutable_batching_parameters();
+    batching_parameters->mutable_max_batch_size()->set_value(32);
+    batching_parameters->mutable_batch_timeout_micros()->set_value(500);
+    batching_parameters->mutable_num_batch_threads()->set_value(4);
+    batching_parameters->mutable_max_enqueued_batches()->set_value(1000);
+  }
+
+  ServerCore::Options options;
+  options.model_server_config = config;
+  TF_CHECK_OK(init::TensorflowServingFunctionRegistration::GetRegistry()
+                  ->GetSetupPlatformConfigMap()(session_bundle_config,
+                                                options.platform_config_map));
+  options.aspired_version_policy =
+      std::unique_ptr<AspiredVersionPolicy>(new AvailabilityPreservingPolicy);
+  std::unique_ptr<ServerCore> server_core;
+  // Returns once the models have loaded.
+  TF_CHECK_OK(ServerCore::Create(std::move(options), &server_core));
+  return server_core;
+}
+
+// The serving stack under benchmark, one per batching setting, created on
+// first use and shared by the benchmarks (and their threads).
+struct Server {
+  explicit Server(const bool enable_batching)
+      : core(CreateServerCore(enable_batching)),
+        prediction_service({core.get(), /*enforce_session_run_timeout=*/true}),
+        http_handler(/*timeout_in_ms=*/-1, core.get()) {}
+
+  std::unique_ptr<ServerCore> core;
+  PredictionServiceImpl prediction_service;
+  HttpRestApiHandler http_handler;
+};
+
+Server* GetServer(const bool enable_batching) {
+  if (enable_batching) {
+    static Server* const batched_server = new Server(true);
+    return batched_server;
+  }
+  static Server* const server = new Server(false);
+  return server;
+}
+
+PredictRequest MakePredictRequest(const int model) {
+  PredictRequest request;
+  switch (model) {
+    case kHalfPlusTwo:
+      request.mutable_model_spec()->set_name(kHalfPlusTwoName);
+      test::AsTensor<float>({2.0}, TensorShape({1}))
+          .AsProtoField(&(*request.mutable_inputs())["x"]);
+      request.add_output_filter("y");
+      break;
+    case kMobileNet:
+      request.mutable_model_spec()->set_name(kMobileNetName);
+      test::AsTensor<uint8>(std::vector<uint8>(kImageSize, 1),
+                            TensorShape({1, 224, 224, 3}))
+          .AsProtoField(&(*request.mutable_inputs())["input"]);
+      break;
+    case kTextRegression:
+      request.mutable_model_spec()->set_name(kTextRegressionName);
+      test::AsTensor<float>({2.0}, TensorShape({1}))
+          .AsProtoField(&(*request.mutable_inputs())["x"]);
+      request.add_output_filter("y");
+      break;
+    default:
+      LOG(FATAL) << "Unknown reference model " << model;
+  }
+  return request;
+}
+
+// Returns the path and body of the REST predict request equivalent to
+// MakePredictRequest(model).
+std::pair<string, string> MakeRestPredictRequest(const int model) {
+  switch (model) {
+    case kHalfPlusTwo:
+      return {absl::StrCat("/v1/models/", kHalfPlusTwoName, ":predict"),
+              R"({"instances": [2.0]})"};
+    case kMobileNet: {
+      // A single image, in rows of pixels of channels.
+      const string pixel = "[1,1,1]";
+      string row = "[";
+      for (int x = 0; x < 224; ++x) {
+        absl::StrAppend(&row, x == 0 ? "" : ",", pixel);
+      }
+      row += "]";
+      string image = "[";
+      for (int y = 0; y < 224; ++y) {
+        absl::StrAppend(&image, y == 0 ? "" : ",", row);
+      }
+      image += "]";
+      return {absl::StrCat("/v1/models/", kMobileNetName, ":predict"),
+              absl::StrCat(R"({"instances": [)", image, "]}")};
+    }
+    case kTextRegression:
+      return {absl::StrCat("/v1/models/", kTextRegressionName, ":predict"),
+              R"({"instances": [2.0]})"};
+    default:
+      LOG(FATAL) << "Unknown reference model " << model;
+  }
+}
+
+void BM_Predict(benchmark::State& state) {
+  Server* const server = GetServer(state.range(1));
+  const PredictRequest request = MakePredictRequest(state.range(0));
+  PredictResponse response;
+  for (auto s : state) {
+    ::grpc::ServerContext context;
+    response.Clear();
+    const ::grpc::Status status =
+        server->prediction_service.Predict(&context, &request, &response);
+    CHECK(status.ok()) << status.error_message();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Predict)
+    ->ArgPair(kHalfPlusTwo, false)
+    ->ArgPair(kHalfPlusTwo, true)
+    ->ArgPair(kMobileNet, false)
+    ->ArgPair(kMobileNet, true)
+    ->ArgPair(kTextRegression, false)
+    ->ArgPair(kTextRegression, true)
+    ->UseRealTime()
+    ->ThreadRange(1, 16);
+
+void BM_Classify(benchmark::State& state) {
+  Server* const server = GetServer(state.range(1));
+  ClassificationRequest request;
+  request.mutable_model_spec()->set_name(kHalfPlusTwoName);
+  request.mutable_model_spec()->set_signature_name("classify_x_to_y");
+  Feature feature;
+  feature.mutable_float_list()->add_value(2.0);
+  (*request.mutable_input()
+        ->mutable_example_list()
+        ->add_examples()
+        ->mutable_features()
+        ->mutable_feature())["x"] = feature;
+  ClassificationResponse response;
+  for (auto s : state) {
+    ::grpc::ServerContext context;
+    response.Clear();
+    const ::grpc::Status status =
+        server->prediction_service.Classify(&context, &request, &response);
+    CHECK(status.ok()) << status.error_message();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Classify)
+    ->ArgPair(kHalfPlusTwo, false)
+    ->ArgPair(kHalfPlusTwo, true)
+    ->UseRealTime()
+    ->ThreadRange(1, 16);
+
+void BM_RestPredict(benchmark::State& state) {
+  Server* const server = GetServer(state.range(1));
+  const std::pair<string, string> request =
+      MakeRestPredictRequest(state.range(0));
+  std::vector<std::pair<string, string>> headers;
+  string model_name, method, output;
+  for (auto s : state) {
+    headers.clear();
+    output.clear();
+    TF_CHECK_OK(server->http_handler.ProcessRequest(
+        "POST", request.first, request.second, &headers, &model_name, &method,
+        &output));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * request.second.size());
+}
+BENCHMARK(BM_RestPredict)
+    ->ArgPair(kHalfPlusTwo, false)
+    ->ArgPair(kHalfPlusTwo, true)
+    ->ArgPair(kMobileNet, false)
+    ->ArgPair(kMobileNet, true)
+    ->ArgPair(kTextRegression, false)
+    ->ArgPair(kTextRegression, true)
+    ->UseRealTime()
+    ->ThreadRange(1, 16);
+
+void BM_RestClassify(benchmark::State& state) {
+  Server* const server = GetServer(state.range(1));
+  const string path =
+      absl::StrCat("/v1/models/", kHalfPlusTwoName, ":classify");
+  const string body =
+      R"({"signature_name": "classify_x_to_y", "examples": [{"x": 2.0}]})";
+  std::vector<std::pair<string, string>> headers;
+  string model_name, method, output;
+  for (auto s : state) {
+    headers.clear();
+    output.clear();
+    TF_CHECK_OK(server->http_handler.ProcessRequest(
+        "POST", path, body, &headers, &model_name, &method, &output));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RestClassify)
+    ->ArgPair(kHalfPlusTwo, false)
+    ->ArgPair(kHalfPlusTwo, true)
+    ->UseRealTime()
+    ->ThreadRange(1, 16);
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  tensorflow::testing::RunBenchmarks();
+  return 0;
+}
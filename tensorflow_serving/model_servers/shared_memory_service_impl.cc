@@ -0,0 +1,73 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/shared_memory_service_impl.h"
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow_serving/model_servers/grpc_status_util.h"
+#include "tensorflow_serving/servables/tensorflow/shared_memory_registry.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+Status CheckSharedMemoryPeer(const ::grpc::ServerContext &context) {
+  if (!IsSharedMemoryPeer(context)) {
+    return errors::PermissionDenied(
+        "Shared memory can only be used over the UNIX socket of the server");
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+bool IsSharedMemoryPeer(const ::grpc::ServerContextBase &context) {
+  return absl::StartsWith(context.peer(), "unix:");
+}
+
+::grpc::Status SharedMemoryServiceImpl::RegisterSharedMemory(
+    ::grpc::ServerContext *context, const RegisterSharedMemoryRequest *request,
+    RegisterSharedMemoryResponse *response) {
+  Status status = CheckSharedMemoryPeer(*context);
+  if (status.ok()) {
+    status = SharedMemoryRegistry::Register(request->name(), request->key(),
+                                            request->offset(),
+                                            request->byte_size());
+  }
+  if (!status.ok()) {
+    VLOG(1) << "RegisterSharedMemory failed: " << status;
+  }
+  return ToGRPCStatus(status);
+}
+
+::grpc::Status SharedMemoryServiceImpl::UnregisterSharedMemory(
+    ::grpc::ServerContext *context,
+    const UnregisterSharedMemoryRequest *request,
+    UnregisterSharedMemoryResponse *response) {
+  Status status = CheckSharedMemoryPeer(*context);
+  if (status.ok()) {
+    status = SharedMemoryRegistry::Unregister(request->name());
+  }
+  if (!status.ok()) {
+    VLOG(1) << "UnregisterSharedMemory failed: " << status;
+  }
+  return ToGRPCStatus(status);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
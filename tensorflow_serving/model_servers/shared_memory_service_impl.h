@@ -0,0 +1,52 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_SHARED_MEMORY_SERVICE_IMPL_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_SHARED_MEMORY_SERVICE_IMPL_H_
+
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "tensorflow_serving/apis/shared_memory_service.grpc.pb.h"
+#include "tensorflow_serving/apis/shared_memory_service.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Returns whether the client of 'context' may use shared memory, i.e. whether
+// it is connected over a UNIX socket of the server (see SharedMemoryRegistry).
+bool IsSharedMemoryPeer(const ::grpc::ServerContextBase& context);
+
+// Registers the shared memory regions of clients on the host of the server
+// with SharedMemoryRegistry, for their predict requests to pass tensors in.
+// Rejects the clients for which IsSharedMemoryPeer() is false.
+class SharedMemoryServiceImpl final : public SharedMemoryService::Service {
+ public:
+  SharedMemoryServiceImpl() = default;
+
+  ::grpc::Status RegisterSharedMemory(
+      ::grpc::ServerContext *context,
+      const RegisterSharedMemoryRequest *request,
+      RegisterSharedMemoryResponse *response) override;
+
+  ::grpc::Status UnregisterSharedMemory(
+      ::grpc::ServerContext *context,
+      const UnregisterSharedMemoryRequest *request,
+      UnregisterSharedMemoryResponse *response) override;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_SHARED_MEMORY_SERVICE_IMPL_H_
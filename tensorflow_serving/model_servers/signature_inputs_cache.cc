@@ -0,0 +1,53 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/signature_inputs_cache.h"
+
+#include <memory>
+
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+Status SignatureInputsCache::GetInputs(
+    uint64_t load_generation, const string& signature_name,
+    const ::google::protobuf::Map<string, SignatureDef>& signature_defs,
+    ::google::protobuf::Map<string, TensorInfo>* inputs) {
+  const string& signame =
+      signature_name.empty() ? kDefaultServingSignatureDefKey : signature_name;
+  auto iter = signature_defs.find(signame);
+  if (iter == signature_defs.end()) {
+    return errors::InvalidArgument("Serving signature name: \"", signame,
+                                   "\" not found in signature def");
+  }
+  const SignatureDef& signature_def = iter->second;
+  std::shared_ptr<const ::google::protobuf::Map<string, TensorInfo>> cached;
+  TF_RETURN_IF_ERROR(cache_.Get(
+      load_generation, signame,
+      [&signature_def](::google::protobuf::Map<string, TensorInfo>* stripped) {
+        for (const auto& kv : signature_def.inputs()) {
+          (*stripped)[kv.first].set_dtype(kv.second.dtype());
+        }
+        return OkStatus();
+      },
+      &cached));
+  *inputs = *cached;
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,59 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_SIGNATURE_INPUTS_CACHE_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_SIGNATURE_INPUTS_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow_serving/core/servable_scoped_cache.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Caches the inputs of the signatures of servables as the REST handlers need
+// them to decode JSON, i.e. their names and dtypes, so that requests don't
+// copy the full TensorInfo of every input of their signature (once per chunk
+// of a request decoded in parallel).
+//
+// This class is thread-safe.
+class SignatureInputsCache {
+ public:
+  // Holds up to 'max_entries' signatures, evicting the least recently used.
+  explicit SignatureInputsCache(size_t max_entries = 1024)
+      : cache_(max_entries) {}
+
+  // Sets 'inputs' to the names and dtypes of the inputs of the signature named
+  // 'signature_name' (the default serving signature if empty) among
+  // 'signature_defs', the signatures of the servable of 'load_generation' (see
+  // ServableHandle::load_generation()). Returns an InvalidArgument error if
+  // there is no such signature.
+  Status GetInputs(
+      uint64_t load_generation, const string& signature_name,
+      const ::google::protobuf::Map<string, SignatureDef>& signature_defs,
+      ::google::protobuf::Map<string, TensorInfo>* inputs);
+
+ private:
+  ServableScopedCache<::google::protobuf::Map<string, TensorInfo>> cache_;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_SIGNATURE_INPUTS_CACHE_H_
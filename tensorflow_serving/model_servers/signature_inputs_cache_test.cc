@@ -0,0 +1,94 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/signature_inputs_cache.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::EqualsProto;
+
+::google::protobuf::Map<string, SignatureDef> MakeSignatureDefs(
+    DataType dtype) {
+  ::google::protobuf::Map<string, SignatureDef> signature_defs;
+  SignatureDef& signature_def =
+      signature_defs[kDefaultServingSignatureDefKey];
+  TensorInfo& input = (*signature_def.mutable_inputs())["x"];
+  input.set_name("x:0");
+  input.set_dtype(dtype);
+  input.mutable_tensor_shape()->add_dim()->set_size(-1);
+  return signature_defs;
+}
+
+TEST(SignatureInputsCacheTest, KeepsNamesAndDtypes) {
+  SignatureInputsCache cache;
+  const auto signature_defs = MakeSignatureDefs(DT_FLOAT);
+  for (int i = 0; i < 2; ++i) {
+    ::google::protobuf::Map<string, TensorInfo> inputs;
+    TF_ASSERT_OK(cache.GetInputs(/*load_generation=*/1, "", signature_defs,
+                                 &inputs));
+    ASSERT_EQ(1, inputs.size());
+    EXPECT_THAT(inputs.at("x"), EqualsProto("dtype: DT_FLOAT"));
+  }
+}
+
+TEST(SignatureInputsCacheTest, MissesOnReloadedServable) {
+  SignatureInputsCache cache;
+  ::google::protobuf::Map<string, TensorInfo> inputs;
+  const auto signature_defs = MakeSignatureDefs(DT_FLOAT);
+  TF_ASSERT_OK(cache.GetInputs(/*load_generation=*/1,
+                               kDefaultServingSignatureDefKey, signature_defs,
+                               &inputs));
+  // The same version with new signatures, as after a reload.
+  const auto reloaded = MakeSignatureDefs(DT_INT32);
+  TF_ASSERT_OK(
+      cache.GetInputs(/*load_generation=*/2, "", reloaded, &inputs));
+  EXPECT_EQ(DT_INT32, inputs.at("x").dtype());
+}
+
+TEST(SignatureInputsCacheTest, EvictsWhenFull) {
+  SignatureInputsCache cache(/*max_entries=*/1);
+  ::google::protobuf::Map<string, TensorInfo> inputs;
+  TF_ASSERT_OK(cache.GetInputs(/*load_generation=*/1, "",
+                               MakeSignatureDefs(DT_STRING), &inputs));
+  TF_ASSERT_OK(cache.GetInputs(/*load_generation=*/2, "",
+                               MakeSignatureDefs(DT_INT64), &inputs));
+  // The first servable's inputs were evicted, so they are read again.
+  TF_ASSERT_OK(cache.GetInputs(/*load_generation=*/1, "",
+                               MakeSignatureDefs(DT_BOOL), &inputs));
+  EXPECT_EQ(DT_BOOL, inputs.at("x").dtype());
+}
+
+TEST(SignatureInputsCacheTest, MissingSignature) {
+  SignatureInputsCache cache;
+  ::google::protobuf::Map<string, TensorInfo> inputs;
+  const Status status =
+      cache.GetInputs(/*load_generation=*/1, "other",
+                      MakeSignatureDefs(DT_FLOAT), &inputs);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), ::testing::HasSubstr("\"other\" not found"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,193 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/staged_config_reloader.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow_serving/util/status_util.h"
+
+namespace tensorflow {
+namespace serving {
+
+StagedConfigReloader::StagedConfigReloader(const Options& options,
+                                           ServerCore* core)
+    : options_(options), core_(core) {}
+
+StagedConfigReloader::~StagedConfigReloader() { thread_.reset(); }
+
+std::vector<ModelServerConfig> StagedConfigReloader::PlanStages(
+    const ModelServerConfig& config, const std::set<string>& served_models,
+    const int max_concurrent_model_loads) {
+  std::vector<const ModelConfig*> new_models;
+  ModelServerConfig stage;
+  for (const ModelConfig& model : config.model_config_list().config()) {
+    if (served_models.count(model.name()) > 0) {
+      *stage.mutable_model_config_list()->add_config() = model;
+    } else {
+      new_models.push_back(&model);
+    }
+  }
+  std::vector<ModelServerConfig> stages;
+  if (max_concurrent_model_loads > 0 && !new_models.empty()) {
+    // Without models served, the first stage adds some, to not apply an empty
+    // config.
+    if (stage.model_config_list().config_size() > 0) {
+      stages.push_back(stage);
+    }
+    for (int i = 0; i + max_concurrent_model_loads < new_models.size();
+         i += max_concurrent_model_loads) {
+      for (int j = i; j < i + max_concurrent_model_loads; ++j) {
+        *stage.mutable_model_config_list()->add_config() = *new_models[j];
+      }
+      stages.push_back(stage);
+    }
+  }
+  // The last stage keeps the order of the models, and the rest of 'config'.
+  stages.push_back(config);
+  return stages;
+}
+
+Status StagedConfigReloader::Start(const ReloadConfigRequest& request,
+                                   string* operation_id) {
+  if (request.config().config_case() != ModelServerConfig::kModelConfigList) {
+    return errors::InvalidArgument(
+        "Only ModelConfigList configs can be reloaded asynchronously");
+  }
+  if (request.max_concurrent_model_loads() < 0 ||
+      request.min_free_memory_bytes() < 0 ||
+      request.memory_wait_timeout_seconds() < 0) {
+    return errors::InvalidArgument(
+        "The limits of an async reload must be non-negative");
+  }
+  std::set<string> served_models;
+  for (const auto& model :
+       core_->servable_state_monitor()->GetLiveServableStates()) {
+    served_models.insert(model.first);
+  }
+  const std::vector<ModelServerConfig> stages = PlanStages(
+      request.config(), served_models, request.max_concurrent_model_loads());
+
+  mutex_lock l(mu_);
+  if (running_) {
+    return errors::FailedPrecondition(
+        "Another async config reload is in progress");
+  }
+  *operation_id = strings::StrCat("reload-", options_.env->NowMicros(), "-",
+                                  ++num_reloads_);
+  ReloadProgress& progress = progress_[*operation_id];
+  progress.set_operation_id(*operation_id);
+  progress.set_state(ReloadProgress::RUNNING);
+  progress.set_num_stages(stages.size());
+  for (const ModelConfig& model :
+       request.config().model_config_list().config()) {
+    if (served_models.count(model.name()) == 0) {
+      progress.add_pending_models(model.name());
+    }
+  }
+  running_ = true;
+  LOG(INFO) << "Starting config reload " << *operation_id << " in "
+            << stages.size() << " stages";
+  // The previous reload, if any, has finished.
+  thread_.reset(options_.env->StartThread(
+      {}, "staged_config_reload",
+      [this, id = *operation_id, request, stages]() {
+        Run(id, request, stages);
+      }));
+  return OkStatus();
+}
+
+void StagedConfigReloader::Run(const string& operation_id,
+                               const ReloadConfigRequest& request,
+                               const std::vector<ModelServerConfig>& stages) {
+  Status status;
+  for (int i = 0; i < stages.size() && status.ok(); ++i) {
+    if (request.min_free_memory_bytes() > 0) {
+      status = WaitForFreeMemory(
+          request.min_free_memory_bytes(),
+          request.memory_wait_timeout_seconds() * EnvTime::kSecondsToMicros);
+    }
+    if (status.ok()) {
+      status = core_->ReloadConfig(stages[i]);
+    }
+    if (status.ok()) {
+      std::set<string> loaded_models;
+      for (const ModelConfig& model : stages[i].model_config_list().config()) {
+        loaded_models.insert(model.name());
+      }
+      mutex_lock l(mu_);
+      ReloadProgress& progress = progress_[operation_id];
+      progress.set_num_stages_done(i + 1);
+      auto* pending = progress.mutable_pending_models();
+      pending->erase(std::remove_if(pending->begin(), pending->end(),
+                                    [&loaded_models](const string& model) {
+                                      return loaded_models.count(model) > 0;
+                                    }),
+                     pending->end());
+    }
+  }
+  if (!status.ok()) {
+    LOG(ERROR) << "Config reload " << operation_id << " failed: " << status;
+  } else {
+    LOG(INFO) << "Finished config reload " << operation_id;
+  }
+
+  mutex_lock l(mu_);
+  ReloadProgress& progress = progress_[operation_id];
+  progress.set_state(status.ok() ? ReloadProgress::DONE
+                                 : ReloadProgress::FAILED);
+  *progress.mutable_status() = ToStatusProto(status);
+  finished_.push_back(operation_id);
+  while (finished_.size() > options_.max_finished_reloads) {
+    progress_.erase(finished_.front());
+    finished_.pop_front();
+  }
+  running_ = false;
+}
+
+Status StagedConfigReloader::WaitForFreeMemory(
+    const int64_t min_free_memory_bytes, const int64_t timeout_micros) {
+  const uint64_t deadline_micros = options_.env->NowMicros() + timeout_micros;
+  for (;;) {
+    const int64_t free_bytes = options_.free_memory_bytes();
+    if (free_bytes >= min_free_memory_bytes) {
+      return OkStatus();
+    }
+    if (options_.env->NowMicros() >= deadline_micros) {
+      return errors::ResourceExhausted(
+          "The host has ", free_bytes, " bytes of free memory, short of the ",
+          min_free_memory_bytes, " bytes the next stage of the reload needs");
+    }
+    options_.env->SleepForMicroseconds(options_.memory_poll_interval_micros);
+  }
+}
+
+Status StagedConfigReloader::GetProgress(const string& operation_id,
+                                         ReloadProgress* progress) const {
+  mutex_lock l(mu_);
+  auto it = progress_.find(operation_id);
+  if (it == progress_.end()) {
+    return errors::NotFound("No config reload ", operation_id);
+  }
+  *progress = it->second;
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,130 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_STAGED_CONFIG_RELOADER_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_STAGED_CONFIG_RELOADER_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/apis/get_model_status.pb.h"
+#include "tensorflow_serving/apis/model_management.pb.h"
+#include "tensorflow_serving/config/model_server_config.pb.h"
+#include "tensorflow_serving/model_servers/server_core.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Applies ModelServerConfigs in the background, in stages, so that pushing a
+// config that adds many models to many replicas doesn't load all the models
+// at once on each of them.
+//
+// The first stage removes the models the config drops and updates those that
+// are already served; each further stage adds up to
+// 'max_concurrent_model_loads' of the new models, in the order of the config,
+// once the previous stage's models have loaded (ServerCore::ReloadConfig()
+// returns) and, optionally, the host has enough free memory. The last stage is
+// the config itself.
+//
+// This class is thread-safe.
+class StagedConfigReloader {
+ public:
+  struct Options {
+    Env* env = Env::Default();
+
+    // Returns the free memory of the host, in bytes.
+    std::function<int64_t()> free_memory_bytes = []() {
+      return port::AvailableRam();
+    };
+
+    // How often to check the free memory while waiting for it.
+    int64_t memory_poll_interval_micros = 1000 * 1000;
+
+    // How many finished reloads to keep the progress of.
+    int max_finished_reloads = 16;
+  };
+
+  // 'core' must outlive the reloader.
+  StagedConfigReloader(const Options& options, ServerCore* core);
+
+  // Waits for the reload in progress, if any.
+  ~StagedConfigReloader();
+
+  // Starts reloading 'request.config' in stages, per the other fields of
+  // 'request'. Returns a FailedPrecondition error if a reload is in progress.
+  Status Start(const ReloadConfigRequest& request, string* operation_id)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns whether a reload is in progress.
+  bool in_progress() const TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    return running_;
+  }
+
+  // Returns the progress of the reload 'operation_id', or a NotFound error if
+  // it is unknown.
+  Status GetProgress(const string& operation_id, ReloadProgress* progress) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Splits the transition to 'config' into the configs of its stages, given
+  // the models already served. Exposed for tests.
+  static std::vector<ModelServerConfig> PlanStages(
+      const ModelServerConfig& config, const std::set<string>& served_models,
+      int max_concurrent_model_loads);
+
+ private:
+  // Applies 'stages' as the reload 'operation_id'.
+  void Run(const string& operation_id, const ReloadConfigRequest& request,
+           const std::vector<ModelServerConfig>& stages)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Waits for the host to have 'min_free_memory_bytes' free, at most
+  // 'timeout_micros'.
+  Status WaitForFreeMemory(int64_t min_free_memory_bytes,
+                           int64_t timeout_micros);
+
+  const Options options_;
+  ServerCore* const core_;
+
+  mutable mutex mu_;
+  int64_t num_reloads_ TF_GUARDED_BY(mu_) = 0;
+  bool running_ TF_GUARDED_BY(mu_) = false;
+  // The progress of the running and recent reloads, by operation id, and the
+  // ids of the finished ones, oldest first.
+  std::map<string, ReloadProgress> progress_ TF_GUARDED_BY(mu_);
+  std::deque<string> finished_ TF_GUARDED_BY(mu_);
+
+  // Runs the reload in progress. Declared last, to be joined first.
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StagedConfigReloader);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_STAGED_CONFIG_RELOADER_H_
@@ -0,0 +1,92 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/staged_config_reloader.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow_serving/config/model_server_config.pb.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::EqualsProto;
+using ::testing::ElementsAre;
+
+ModelServerConfig CreateConfig(const std::vector<string>& model_names) {
+  ModelServerConfig config;
+  for (const string& name : model_names) {
+    ModelConfig* model = config.mutable_model_config_list()->add_config();
+    model->set_name(name);
+    model->set_base_path("/models/" + name);
+  }
+  return config;
+}
+
+std::vector<std::vector<string>> ModelNames(
+    const std::vector<ModelServerConfig>& stages) {
+  std::vector<std::vector<string>> names;
+  for (const ModelServerConfig& stage : stages) {
+    names.emplace_back();
+    for (const ModelConfig& model : stage.model_config_list().config()) {
+      names.back().push_back(model.name());
+    }
+  }
+  return names;
+}
+
+TEST(StagedConfigReloaderTest, PlanStagesAddsModelsInBatches) {
+  const ModelServerConfig config =
+      CreateConfig({"new_1", "served", "new_2", "new_3", "new_4", "new_5"});
+  const std::vector<ModelServerConfig> stages =
+      StagedConfigReloader::PlanStages(config, {"served", "removed"}, 2);
+  EXPECT_THAT(
+      ModelNames(stages),
+      ElementsAre(std::vector<string>({"served"}),
+                  std::vector<string>({"served", "new_1", "new_2"}),
+                  std::vector<string>({"served", "new_1", "new_2", "new_3",
+                                       "new_4"}),
+                  std::vector<string>({"new_1", "served", "new_2", "new_3",
+                                       "new_4", "new_5"})));
+  // The last stage is the config itself.
+  EXPECT_THAT(stages.back(), EqualsProto(config));
+}
+
+TEST(StagedConfigReloaderTest, PlanStagesWithoutModelsServed) {
+  const ModelServerConfig config = CreateConfig({"a", "b", "c"});
+  EXPECT_THAT(ModelNames(StagedConfigReloader::PlanStages(config, {}, 2)),
+              ElementsAre(std::vector<string>({"a", "b"}),
+                          std::vector<string>({"a", "b", "c"})));
+}
+
+TEST(StagedConfigReloaderTest, PlanStagesInOneStage) {
+  const ModelServerConfig config = CreateConfig({"a", "b", "c"});
+  // Without a limit, or without new models, the config is applied at once.
+  EXPECT_THAT(ModelNames(StagedConfigReloader::PlanStages(config, {"a"}, 0)),
+              ElementsAre(std::vector<string>({"a", "b", "c"})));
+  EXPECT_THAT(
+      ModelNames(StagedConfigReloader::PlanStages(config, {"a", "b", "c"}, 1)),
+      ElementsAre(std::vector<string>({"a", "b", "c"})));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_serving/model_servers/tfrt_http_rest_api_handler.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -31,6 +32,8 @@ limitations under the License.
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/tfrt/saved_model/saved_model.h"
@@ -45,6 +48,8 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/tfrt_get_model_metadata_impl.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_servable.h"
 #include "tensorflow_serving/util/json_tensor.h"
+#include "tensorflow_serving/util/request_arena.h"
+#include "tensorflow_serving/util/safetensors.h"
 
 namespace tensorflow {
 namespace serving {
@@ -58,7 +63,9 @@ TFRTHttpRestApiHandler::TFRTHttpRestApiHandler(int timeout_in_ms,
                                                ServerCore* core)
     : run_options_(),
       timeout_(absl::Milliseconds(timeout_in_ms)),
-      core_(core) {}
+      core_(core),
+      json_decode_thread_pool_(new thread::ThreadPool(
+          Env::Default(), "rest_json_decode", port::NumSchedulableCPUs())) {}
 
 TFRTHttpRestApiHandler::~TFRTHttpRestApiHandler() {}
 
@@ -67,6 +74,17 @@ Status TFRTHttpRestApiHandler::ProcessRequest(
     const absl::string_view request_body,
     std::vector<std::pair<std::string, std::string>>* headers,
     std::string* model_name, std::string* method, std::string* output) {
+  return ProcessRequest(http_method, request_path, request_body,
+                        HttpRequestHeaders(), headers, model_name, method,
+                        output);
+}
+
+Status TFRTHttpRestApiHandler::ProcessRequest(
+    const absl::string_view http_method, const absl::string_view request_path,
+    const absl::string_view request_body,
+    const HttpRequestHeaders& request_headers,
+    std::vector<std::pair<std::string, std::string>>* headers,
+    std::string* model_name, std::string* method, std::string* output) {
   headers->clear();
   output->clear();
   AddHeaders(headers);
@@ -78,27 +96,50 @@ Status TFRTHttpRestApiHandler::ProcessRequest(
   absl::optional<std::string> model_version_label;
   bool parse_successful;
 
-  TF_RETURN_IF_ERROR(ParseModelInfo(
-      http_method, request_path, model_name, &model_version,
-      &model_version_label, method, &model_subresource, &parse_successful));
+  absl::string_view path;
+  JsonOutputFormat json_output_format = core_->compact_json_responses()
+                                            ? JsonOutputFormat::kCompact
+                                            : JsonOutputFormat::kPretty;
+  TF_RETURN_IF_ERROR(
+      ParseRequestQuery(request_path, &path, &json_output_format));
+  TF_RETURN_IF_ERROR(ParseModelInfo(http_method, path, model_name,
+                                    &model_version, &model_version_label,
+                                    method, &model_subresource,
+                                    &parse_successful));
+  const bool safetensors_request =
+      HasSafetensorsMediaType(request_headers.content_type);
+  const bool safetensors_response =
+      HasSafetensorsMediaType(request_headers.accept);
 
   auto run_options = run_options_;
   run_options.deadline = absl::Now() + timeout_;
 
   // Dispatch request to appropriate processor
   if (http_method == "POST" && parse_successful) {
-    if (*method == "classify") {
+    if (safetensors_request && *method != "predict") {
+      status = errors::InvalidArgument(
+          "Only predict requests can have a ", kSafetensorsContentType,
+          " body");
+    } else if (*method == "classify") {
       status = ProcessClassifyRequest(*model_name, model_version,
                                       model_version_label, request_body,
-                                      run_options, output);
+                                      run_options, json_output_format, output);
     } else if (*method == "regress") {
-      status =
-          ProcessRegressRequest(*model_name, model_version, model_version_label,
-                                request_body, run_options, output);
+      status = ProcessRegressRequest(*model_name, model_version,
+                                     model_version_label, request_body,
+                                     run_options, json_output_format, output);
     } else if (*method == "predict") {
-      status =
-          ProcessPredictRequest(*model_name, model_version, model_version_label,
-                                request_body, run_options, output);
+      status = ProcessPredictRequest(
+          *model_name, model_version, model_version_label, request_body,
+          run_options, safetensors_request, safetensors_response,
+          json_output_format, request_headers.response_body_writer, output);
+      if (status.ok() && safetensors_response) {
+        SetContentType(kSafetensorsContentType, headers);
+      }
+    } else if (*method == "predictStreamed") {
+      status = ProcessPredictStreamedRequest(
+          *model_name, model_version, model_version_label, request_body,
+          run_options, headers, request_headers.response_body_writer, output);
     }
   } else if (http_method == "GET" && parse_successful) {
     if (!model_subresource.empty() && model_subresource == "metadata") {
@@ -119,22 +160,25 @@ Status TFRTHttpRestApiHandler::ProcessClassifyRequest(
     const absl::optional<int64_t>& model_version,
     const absl::optional<absl::string_view>& model_version_label,
     const absl::string_view request_body,
-    const Servable::RunOptions& run_options, std::string* output) {
-  ::google::protobuf::Arena arena;
+    const Servable::RunOptions& run_options,
+    JsonOutputFormat json_output_format, std::string* output) {
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<ClassificationRequest>(&arena);
+  auto* request =
+      ::google::protobuf::Arena::Create<ClassificationRequest>(arena.get());
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
   TF_RETURN_IF_ERROR(FillClassificationRequestFromJson(request_body, request));
 
-  auto* response = ::google::protobuf::Arena::Create<ClassificationResponse>(&arena);
+  auto* response =
+      ::google::protobuf::Arena::Create<ClassificationResponse>(arena.get());
   ServableHandle<Servable> servable;
   TF_RETURN_IF_ERROR(
       core_->GetServableHandle(request->model_spec(), &servable));
   TF_RETURN_IF_ERROR(servable->Classify(run_options, *request, response));
-  TF_RETURN_IF_ERROR(
-      MakeJsonFromClassificationResult(response->result(), output));
+  TF_RETURN_IF_ERROR(MakeJsonFromClassificationResult(
+      response->result(), json_output_format, output));
   return Status();
 }
 
@@ -143,56 +187,151 @@ Status TFRTHttpRestApiHandler::ProcessRegressRequest(
     const absl::optional<int64_t>& model_version,
     const absl::optional<absl::string_view>& model_version_label,
     const absl::string_view request_body,
-    const Servable::RunOptions& run_options, std::string* output) {
-  ::google::protobuf::Arena arena;
+    const Servable::RunOptions& run_options,
+    JsonOutputFormat json_output_format, std::string* output) {
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<RegressionRequest>(&arena);
+  auto* request =
+      ::google::protobuf::Arena::Create<RegressionRequest>(arena.get());
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
   TF_RETURN_IF_ERROR(FillRegressionRequestFromJson(request_body, request));
 
-  auto* response = ::google::protobuf::Arena::Create<RegressionResponse>(&arena);
+  auto* response =
+      ::google::protobuf::Arena::Create<RegressionResponse>(arena.get());
   ServableHandle<Servable> servable;
   TF_RETURN_IF_ERROR(
       core_->GetServableHandle(request->model_spec(), &servable));
   TF_RETURN_IF_ERROR(servable->Regress(run_options, *request, response));
-  return MakeJsonFromRegressionResult(response->result(), output);
+  return MakeJsonFromRegressionResult(response->result(), json_output_format,
+                                      output);
 }
 
-Status TFRTHttpRestApiHandler::ProcessPredictRequest(
+Status TFRTHttpRestApiHandler::FillPredictRequest(
     const absl::string_view model_name,
     const absl::optional<int64_t>& model_version,
     const absl::optional<absl::string_view>& model_version_label,
-    const absl::string_view request_body,
-    const Servable::RunOptions& run_options, std::string* output) {
-  ::google::protobuf::Arena arena;
-
-  auto* request = ::google::protobuf::Arena::Create<PredictRequest>(&arena);
+    const absl::string_view request_body, bool safetensors_request,
+    PredictRequest* request, JsonPredictRequestFormat* format) {
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
 
-  JsonPredictRequestFormat format;
-  TF_RETURN_IF_ERROR(FillPredictRequestFromJson(
+  // Inputs in safetensors are named, like "inputs" in JSON.
+  *format = JsonPredictRequestFormat::kColumnar;
+  if (safetensors_request) {
+    return FillPredictRequestFromSafetensors(request_body, request);
+  }
+  return FillPredictRequestFromJsonInParallel(
       request_body,
       [this, request](const std::string& sig,
                       ::google::protobuf::Map<std::string, TensorInfo>* map) {
         return this->GetInfoMap(request->model_spec(), sig, map);
       },
-      request, &format));
+      json_decode_thread_pool_.get(), request, format);
+}
 
-  auto* response = ::google::protobuf::Arena::Create<PredictResponse>(&arena);
+Status TFRTHttpRestApiHandler::ProcessPredictRequest(
+    const absl::string_view model_name,
+    const absl::optional<int64_t>& model_version,
+    const absl::optional<absl::string_view>& model_version_label,
+    const absl::string_view request_body,
+    const Servable::RunOptions& run_options, bool safetensors_request,
+    bool safetensors_response, JsonOutputFormat json_output_format,
+    HttpResponseBodyWriter* response_body_writer, std::string* output) {
+  RequestArena arena;
+
+  auto* request =
+      ::google::protobuf::Arena::Create<PredictRequest>(arena.get());
+  JsonPredictRequestFormat format;
+  TF_RETURN_IF_ERROR(FillPredictRequest(
+      model_name, model_version, model_version_label, request_body,
+      safetensors_request, request, &format));
+
+  auto* response =
+      ::google::protobuf::Arena::Create<PredictResponse>(arena.get());
 
   ServableHandle<Servable> servable;
   TF_RETURN_IF_ERROR(
       core_->GetServableHandle(request->model_spec(), &servable));
   TF_RETURN_IF_ERROR(servable->Predict(run_options, *request, response));
 
-  TF_RETURN_IF_ERROR(MakeJsonFromTensors(response->outputs(), format, output));
+  if (safetensors_response) {
+    return MakeSafetensorsFromTensors(response->outputs(), output);
+  }
+  if (response_body_writer != nullptr &&
+      response->ByteSizeLong() >= kMinStreamedResponseBytes) {
+    return MakeJsonFromTensors(
+        response->outputs(), format, json_output_format,
+        kStreamedResponseChunkBytes,
+        [response_body_writer](absl::string_view chunk) {
+          response_body_writer->WriteChunk(chunk);
+        });
+  }
+  TF_RETURN_IF_ERROR(MakeJsonFromTensors(response->outputs(), format,
+                                         json_output_format, output));
   return Status();
 }
 
+Status TFRTHttpRestApiHandler::ProcessPredictStreamedRequest(
+    const absl::string_view model_name,
+    const absl::optional<int64_t>& model_version,
+    const absl::optional<absl::string_view>& model_version_label,
+    const absl::string_view request_body,
+    const Servable::RunOptions& run_options,
+    std::vector<std::pair<std::string, std::string>>* headers,
+    HttpResponseBodyWriter* response_body_writer, std::string* output) {
+  RequestArena arena;
+
+  auto* request =
+      ::google::protobuf::Arena::Create<PredictRequest>(arena.get());
+  JsonPredictRequestFormat format;
+  TF_RETURN_IF_ERROR(FillPredictRequest(
+      model_name, model_version, model_version_label, request_body,
+      /*safetensors_request=*/false, request, &format));
+
+  ServableHandle<Servable> servable;
+  TF_RETURN_IF_ERROR(
+      core_->GetServableHandle(request->model_spec(), &servable));
+
+  // Each response is sent as a server-sent event of its outputs in compact
+  // JSON, which has no line breaks to split the event's data on.
+  SetContentType(kEventStreamContentType, headers);
+  bool started = false;
+  const Status status = RunPredictStreamed(
+      *servable, run_options, *request,
+      [&](const PredictResponse& response) -> absl::Status {
+        std::string json;
+        TF_RETURN_IF_ERROR(MakeJsonFromTensors(
+            response.outputs(), format, JsonOutputFormat::kCompact, &json));
+        const std::string event = absl::StrCat("data: ", json, "\n\n");
+        if (response_body_writer != nullptr) {
+          response_body_writer->WriteChunk(event);
+          started = true;
+        } else {
+          absl::StrAppend(output, event);
+        }
+        return absl::OkStatus();
+      });
+  if (status.ok()) {
+    return status;
+  }
+  if (started) {
+    // The OK status is already sent, so the error ends the stream as an
+    // event of its own.
+    std::string json;
+    MakeJsonFromStatus(status, &json);
+    response_body_writer->WriteChunk(absl::StrCat(
+        "event: error\ndata: ",
+        absl::StrReplaceAll(json, {{"\n    ", ""}, {"\n", ""}}), "\n\n"));
+  } else {
+    SetContentType("application/json", headers);
+    output->clear();
+  }
+  return status;
+}
+
 Status TFRTHttpRestApiHandler::ProcessModelStatusRequest(
     const absl::string_view model_name,
     const absl::optional<int64_t>& model_version,
@@ -204,14 +343,16 @@ Status TFRTHttpRestApiHandler::ProcessModelStatusRequest(
     return errors::InvalidArgument("Missing model name in request.");
   }
 
-  ::google::protobuf::Arena arena;
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<GetModelStatusRequest>(&arena);
+  auto* request =
+      ::google::protobuf::Arena::Create<GetModelStatusRequest>(arena.get());
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
 
-  auto* response = ::google::protobuf::Arena::Create<GetModelStatusResponse>(&arena);
+  auto* response =
+      ::google::protobuf::Arena::Create<GetModelStatusResponse>(arena.get());
   TF_RETURN_IF_ERROR(
       GetModelStatusImpl::GetModelStatus(core_, *request, response));
   return ToJsonString(*response, output);
@@ -226,16 +367,18 @@ Status TFRTHttpRestApiHandler::ProcessModelMetadataRequest(
     return errors::InvalidArgument("Missing model name in request.");
   }
 
-  ::google::protobuf::Arena arena;
+  RequestArena arena;
 
-  auto* request = ::google::protobuf::Arena::Create<GetModelMetadataRequest>(&arena);
+  auto* request =
+      ::google::protobuf::Arena::Create<GetModelMetadataRequest>(arena.get());
   // We currently only support the kSignatureDef metadata field
   request->add_metadata_field(std::string(kSignatureDef));
   TF_RETURN_IF_ERROR(FillModelSpecWithNameVersionAndLabel(
       model_name, model_version, model_version_label,
       request->mutable_model_spec()));
 
-  auto* response = ::google::protobuf::Arena::Create<GetModelMetadataResponse>(&arena);
+  auto* response =
+      ::google::protobuf::Arena::Create<GetModelMetadataResponse>(arena.get());
   TF_RETURN_IF_ERROR(
       TFRTGetModelMetadataImpl::GetModelMetadata(core_, *request, response));
 
@@ -249,15 +392,9 @@ Status TFRTHttpRestApiHandler::GetInfoMap(
   TF_RETURN_IF_ERROR(core_->GetServableHandle(model_spec, &servable));
   auto& saved_model =
       down_cast<TfrtSavedModelServable*>(servable.get())->saved_model();
-  const std::string& signame =
-      signature_name.empty() ? kDefaultServingSignatureDefKey : signature_name;
-  auto iter = saved_model.GetMetaGraphDef().signature_def().find(signame);
-  if (iter == saved_model.GetMetaGraphDef().signature_def().end()) {
-    return errors::InvalidArgument("Serving signature name: \"", signame,
-                                   "\" not found in signature def");
-  }
-  *infomap = iter->second.inputs();
-  return Status();
+  return signature_inputs_cache_.GetInputs(
+      servable.load_generation(), signature_name,
+      saved_model.GetMetaGraphDef().signature_def(), infomap);
 }
 
 }  // namespace serving
@@ -26,10 +26,13 @@ limitations under the License.
 #include "absl/types/optional.h"
 #include "re2/re2.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow_serving/model_servers/http_rest_api_handler_base.h"
+#include "tensorflow_serving/model_servers/signature_inputs_cache.h"
 #include "tensorflow_serving/servables/tensorflow/servable.h"
+#include "tensorflow_serving/util/json_tensor.h"
 
 namespace tensorflow {
 
@@ -50,6 +53,11 @@ class ModelSpec;
 //   POST /v1/models/<model_name>:(classify|regress)
 //   POST /v1/models/<model_name>/versions/<ver>:(classify|regress)
 //
+// o Streamed inference - the outputs of models that stream them, sent as
+//   server-sent events as they are produced
+//
+//   POST /v1/models/<model_name>[/versions/<ver>]:predictStreamed
+//
 // o Model status
 //
 //   GET /v1/models/<model_name> (status of all versions)
@@ -78,7 +86,9 @@ class TFRTHttpRestApiHandler : public HttpRestApiHandlerBase {
 
   ~TFRTHttpRestApiHandler() override;
 
-  // Process a HTTP request.
+  // Process a HTTP request. Predict requests and responses are in JSON or, as
+  // chosen by the Content-Type and Accept headers, in the safetensors format
+  // (see util/safetensors.h).
   //
   // In case of errors, the `headers` and `output` are still relevant as they
   // contain detailed error messages, that can be relayed back to the client.
@@ -88,6 +98,13 @@ class TFRTHttpRestApiHandler : public HttpRestApiHandlerBase {
                         std::vector<std::pair<string, string>>* headers,
                         string* model_name, string* method,
                         string* output) override;
+  Status ProcessRequest(const absl::string_view http_method,
+                        const absl::string_view request_path,
+                        const absl::string_view request_body,
+                        const HttpRequestHeaders& request_headers,
+                        std::vector<std::pair<string, string>>* headers,
+                        string* model_name, string* method,
+                        string* output) override;
 
  private:
   Status ProcessClassifyRequest(
@@ -95,19 +112,42 @@ class TFRTHttpRestApiHandler : public HttpRestApiHandlerBase {
       const absl::optional<int64_t>& model_version,
       const absl::optional<absl::string_view>& model_version_label,
       const absl::string_view request_body,
-      const Servable::RunOptions& run_options, string* output);
+      const Servable::RunOptions& run_options,
+      JsonOutputFormat json_output_format, string* output);
   Status ProcessRegressRequest(
       const absl::string_view model_name,
       const absl::optional<int64_t>& model_version,
       const absl::optional<absl::string_view>& model_version_label,
       const absl::string_view request_body,
-      const Servable::RunOptions& run_options, string* output);
+      const Servable::RunOptions& run_options,
+      JsonOutputFormat json_output_format, string* output);
   Status ProcessPredictRequest(
       const absl::string_view model_name,
       const absl::optional<int64_t>& model_version,
       const absl::optional<absl::string_view>& model_version_label,
       const absl::string_view request_body,
-      const Servable::RunOptions& run_options, string* output);
+      const Servable::RunOptions& run_options, bool safetensors_request,
+      bool safetensors_response, JsonOutputFormat json_output_format,
+      HttpResponseBodyWriter* response_body_writer, string* output);
+  // Sends each response streamed by the servable as a server-sent event
+  // through `response_body_writer`, or appends them all to `output` without
+  // one. An error after the first event ends the stream with an "error"
+  // event.
+  Status ProcessPredictStreamedRequest(
+      const absl::string_view model_name,
+      const absl::optional<int64_t>& model_version,
+      const absl::optional<absl::string_view>& model_version_label,
+      const absl::string_view request_body,
+      const Servable::RunOptions& run_options,
+      std::vector<std::pair<string, string>>* headers,
+      HttpResponseBodyWriter* response_body_writer, string* output);
+  // Parses the body of a predict request into `request`.
+  Status FillPredictRequest(
+      const absl::string_view model_name,
+      const absl::optional<int64_t>& model_version,
+      const absl::optional<absl::string_view>& model_version_label,
+      const absl::string_view request_body, bool safetensors_request,
+      PredictRequest* request, JsonPredictRequestFormat* format);
   Status ProcessModelStatusRequest(
       const absl::string_view model_name,
       const absl::optional<int64_t>& model_version,
@@ -124,6 +164,9 @@ class TFRTHttpRestApiHandler : public HttpRestApiHandlerBase {
   const Servable::RunOptions run_options_;
   absl::Duration timeout_;
   ServerCore* core_;
+  // Decodes large JSON predict requests in parallel.
+  std::unique_ptr<thread::ThreadPool> json_decode_thread_pool_;
+  SignatureInputsCache signature_inputs_cache_;
 };
 
 }  // namespace serving
@@ -388,6 +388,28 @@ TEST_F(TFRTHttpRestApiHandlerTest, Predict) {
                            (HeaderList){{"Content-Type", "application/json"}}));
 }
 
+TEST_F(TFRTHttpRestApiHandlerTest, PredictStreamed) {
+  HeaderList headers;
+  string model_name, method, output;
+  // The test model streams no outputs, so the stream ends without events.
+  TF_EXPECT_OK(handler_.ProcessRequest(
+      "POST", absl::StrCat("/v1/models/", kTestModelName, ":predictStreamed"),
+      R"({"instances": [[1.0, 2.0], [3.0, 4.0]]})", &headers, &model_name,
+      &method, &output));
+  EXPECT_EQ(output, "");
+  EXPECT_THAT(headers, UnorderedElementsAreArray((HeaderList){
+                           {"Content-Type", "text/event-stream"}}));
+
+  // Errors before the first event are sent as for other requests.
+  Status status = handler_.ProcessRequest(
+      "POST", "/v1/models/foo:predictStreamed", R"({"instances": [1.0]})",
+      &headers, &model_name, &method, &output);
+  EXPECT_TRUE(errors::IsNotFound(status));
+  EXPECT_THAT(GetJsonErrorMsg(output), HasSubstr("foo"));
+  EXPECT_THAT(headers, UnorderedElementsAreArray(
+                           (HeaderList){{"Content-Type", "application/json"}}));
+}
+
 TEST_F(TFRTHttpRestApiHandlerTest, Regress) {
   HeaderList headers;
   string model_name, method, output;
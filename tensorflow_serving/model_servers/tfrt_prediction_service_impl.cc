@@ -14,10 +14,14 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow_serving/model_servers/tfrt_prediction_service_impl.h"
 
+#include <memory>
+
 #include "grpc/grpc.h"
 #include "grpcpp/server_context.h"
 #include "absl/time/clock.h"
+#include "absl/status/status.h"
 #include "absl/time/time.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tsl/platform/errors.h"
 #include "tensorflow_serving/apis/inference.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
@@ -27,10 +31,23 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/servable.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_get_model_metadata_impl.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
+#include "tensorflow_serving/util/request_deadline.h"
 
 namespace tensorflow {
 namespace serving {
 
+namespace {
+
+// Returns the deadline of the request of 'context', for the layers below (see
+// RequestDeadline). The request is cancelled with the call.
+std::shared_ptr<const RequestDeadline> MakeRequestDeadline(
+    absl::Time deadline, ::grpc::ServerContext *context) {
+  return std::make_shared<RequestDeadline>(
+      deadline, [context]() { return context->IsCancelled(); });
+}
+
+}  // namespace
+
 absl::Time TfrtPredictionServiceImpl::GetRequestDeadline(
     ::grpc::ServerContext *context) const {
   if (enforce_session_run_timeout_) {
@@ -47,6 +64,8 @@ absl::Time TfrtPredictionServiceImpl::GetRequestDeadline(
 
   Servable::RunOptions run_options;
   run_options.deadline = GetRequestDeadline(context);
+  ScopedRequestDeadline deadline_scope(
+      MakeRequestDeadline(run_options.deadline, context));
   ServableHandle<Servable> servable;
   auto tf_status = core_->GetServableHandle(request->model_spec(), &servable);
   if (!tf_status.ok()) {
@@ -71,6 +90,46 @@ absl::Time TfrtPredictionServiceImpl::GetRequestDeadline(
   return status;
 }
 
+::grpc::Status TfrtPredictionServiceImpl::PredictStreamed(
+    ::grpc::ServerContext *context, const PredictRequest *request,
+    ::grpc::ServerWriter<PredictResponse> *writer) {
+  const uint64_t start = Env::Default()->NowMicros();
+
+  Servable::RunOptions run_options;
+  run_options.deadline = GetRequestDeadline(context);
+  ScopedRequestDeadline deadline_scope(
+      MakeRequestDeadline(run_options.deadline, context));
+  ServableHandle<Servable> servable;
+  auto tf_status = core_->GetServableHandle(request->model_spec(), &servable);
+  if (!tf_status.ok()) {
+    VLOG(1) << "TFRT PredictStreamed get servable handle failed: "
+            << tf_status.message();
+    return ToGRPCStatus(tf_status);
+  }
+
+  tf_status = RunPredictStreamed(
+      *servable, run_options, *request,
+      [writer](const PredictResponse &response) -> absl::Status {
+        if (!writer->Write(response)) {
+          return errors::Cancelled("The PredictStreamed stream is closed");
+        }
+        return absl::OkStatus();
+      });
+
+  const ::grpc::Status status = ToGRPCStatus(tf_status);
+
+  if (status.ok()) {
+    RecordRequestLatency(request->model_spec().name(),
+                         /*api=*/"PredictStreamed", /*entrypoint=*/"GRPC",
+                         Env::Default()->NowMicros() - start);
+  } else {
+    VLOG(1) << "TFRT PredictStreamed failed: " << status.error_message();
+  }
+  RecordModelRequestCount(request->model_spec().name(), tf_status);
+
+  return status;
+}
+
 ::grpc::Status TfrtPredictionServiceImpl::GetModelMetadata(
     ::grpc::ServerContext *context, const GetModelMetadataRequest *request,
     GetModelMetadataResponse *response) {
@@ -90,6 +149,8 @@ absl::Time TfrtPredictionServiceImpl::GetRequestDeadline(
 
   Servable::RunOptions run_options;
   run_options.deadline = GetRequestDeadline(context);
+  ScopedRequestDeadline deadline_scope(
+      MakeRequestDeadline(run_options.deadline, context));
   ServableHandle<Servable> servable;
   auto tf_status = core_->GetServableHandle(request->model_spec(), &servable);
   if (!tf_status.ok()) {
@@ -120,6 +181,8 @@ absl::Time TfrtPredictionServiceImpl::GetRequestDeadline(
 
   Servable::RunOptions run_options;
   run_options.deadline = GetRequestDeadline(context);
+  ScopedRequestDeadline deadline_scope(
+      MakeRequestDeadline(run_options.deadline, context));
   ServableHandle<Servable> servable;
   auto tf_status = core_->GetServableHandle(request->model_spec(), &servable);
   if (!tf_status.ok()) {
@@ -160,6 +223,8 @@ const ModelSpec &GetModelSpecFromRequest(const MultiInferenceRequest &request) {
     MultiInferenceResponse *response) {
   Servable::RunOptions run_options;
   run_options.deadline = GetRequestDeadline(context);
+  ScopedRequestDeadline deadline_scope(
+      MakeRequestDeadline(run_options.deadline, context));
   ServableHandle<Servable> servable;
 
   auto tf_status =
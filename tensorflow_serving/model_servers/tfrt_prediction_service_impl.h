@@ -34,6 +34,11 @@ class TfrtPredictionServiceImpl final
                          const PredictRequest* request,
                          PredictResponse* response) override;
 
+  // Sends each response streamed by the servable as soon as it is produced.
+  ::grpc::Status PredictStreamed(
+      ::grpc::ServerContext* context, const PredictRequest* request,
+      ::grpc::ServerWriter<PredictResponse>* writer) override;
+
   ::grpc::Status GetModelMetadata(::grpc::ServerContext* context,
                                   const GetModelMetadataRequest* request,
                                   GetModelMetadataResponse* response) override;
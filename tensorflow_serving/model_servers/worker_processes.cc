@@ -0,0 +1,162 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/worker_processes.h"
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// How long the supervisor waits before restarting a crashed worker, which
+// keeps a worker that crashes on start from spinning.
+constexpr int kRestartBackoffSeconds = 1;
+
+}  // namespace
+
+int RunWorkerProcesses(int num_workers,
+                       const std::function<int(int worker_index)>& run_worker) {
+  if (num_workers <= 1) {
+    return run_worker(0);
+  }
+
+  // The supervisor takes the signals synchronously, with sigwaitinfo(), so
+  // none is lost between checking for one and waiting on the workers.
+  sigset_t signals, old_mask;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGCHLD);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigprocmask(SIG_BLOCK, &signals, &old_mask);
+
+  // The index of each running worker, by pid.
+  std::map<pid_t, int> workers;
+  // The crashed workers to restart once the backoff is over.
+  std::vector<int> crashed_workers;
+  time_t restart_time = 0;
+  bool terminating = false;
+  bool failed = false;
+
+  const auto terminate_workers = [&](int signal) {
+    terminating = true;
+    crashed_workers.clear();
+    for (const auto& worker : workers) {
+      kill(worker.first, signal);
+    }
+  };
+  const auto start_worker = [&](int worker_index) {
+    const pid_t pid = fork();
+    if (pid == 0) {
+      sigprocmask(SIG_SETMASK, &old_mask, nullptr);
+      _exit(run_worker(worker_index));
+    }
+    if (pid < 0) {
+      LOG(ERROR) << "Failed to fork worker process " << worker_index << ": "
+                 << strerror(errno);
+      failed = true;
+      terminate_workers(SIGTERM);
+      return;
+    }
+    LOG(INFO) << "Started worker process " << worker_index << " as pid "
+              << pid;
+    workers[pid] = worker_index;
+  };
+
+  for (int i = 0; i < num_workers && !terminating; ++i) {
+    start_worker(i);
+  }
+
+  while (!workers.empty() || !crashed_workers.empty()) {
+    siginfo_t info;
+    int signal;
+    if (crashed_workers.empty()) {
+      signal = sigwaitinfo(&signals, &info);
+    } else {
+      const time_t now = time(nullptr);
+      if (now >= restart_time) {
+        std::vector<int> to_restart;
+        to_restart.swap(crashed_workers);
+        for (const int worker_index : to_restart) {
+          if (!terminating) {
+            start_worker(worker_index);
+          }
+        }
+        continue;
+      }
+      const struct timespec timeout = {restart_time - now, 0};
+      signal = sigtimedwait(&signals, &info, &timeout);
+    }
+    if (signal < 0) {
+      // Timed out waiting for a restart, or interrupted.
+      continue;
+    }
+    if (signal == SIGINT || signal == SIGTERM) {
+      LOG(INFO) << "Forwarding signal " << signal << " to the "
+                << workers.size() << " worker processes";
+      terminate_workers(signal);
+      continue;
+    }
+
+    // SIGCHLD, which may stand for several workers that are done.
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+      auto worker = workers.find(pid);
+      if (worker == workers.end()) {
+        continue;
+      }
+      const int worker_index = worker->second;
+      workers.erase(worker);
+      if (WIFEXITED(status)) {
+        if (WEXITSTATUS(status) == 0) {
+          continue;
+        }
+        LOG(ERROR) << "Worker process " << worker_index
+                   << " exited with status " << WEXITSTATUS(status)
+                   << "; terminating the others";
+        failed = true;
+        if (!terminating) {
+          terminate_workers(SIGTERM);
+        }
+      } else if (WIFSIGNALED(status) && !terminating) {
+        LOG(ERROR) << "Worker process " << worker_index
+                   << " was killed by signal " << WTERMSIG(status)
+                   << "; restarting it in " << kRestartBackoffSeconds << "s";
+        if (crashed_workers.empty()) {
+          restart_time = time(nullptr) + kRestartBackoffSeconds;
+        }
+        crashed_workers.push_back(worker_index);
+      }
+    }
+  }
+
+  sigprocmask(SIG_SETMASK, &old_mask, nullptr);
+  return failed ? 1 : 0;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
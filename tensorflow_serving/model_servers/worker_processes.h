@@ -0,0 +1,44 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_MODEL_SERVERS_WORKER_PROCESSES_H_
+#define TENSORFLOW_SERVING_MODEL_SERVERS_WORKER_PROCESSES_H_
+
+#include <functional>
+
+namespace tensorflow {
+namespace serving {
+
+// Runs 'run_worker' in 'num_workers' worker processes forked from this one,
+// which supervises them, and returns once they are all done. Each worker
+// exits with what 'run_worker' returns for its index, in [0, num_workers).
+// With 1 worker or fewer, runs 'run_worker(0)' in this process instead.
+//
+// The supervisor forwards SIGTERM and SIGINT to the workers. A worker killed
+// by any other signal, e.g. on a crash, is restarted with the same index after
+// a backoff. A worker that exits with a non-zero status, e.g. because its
+// server failed to start, makes the supervisor terminate the others. Returns
+// 0 if every worker exited with 0 or was terminated by a forwarded signal,
+// else non-zero.
+//
+// Must be called before this process starts threads, since only the calling
+// thread is forked.
+int RunWorkerProcesses(int num_workers,
+                       const std::function<int(int worker_index)>& run_worker);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_MODEL_SERVERS_WORKER_PROCESSES_H_
@@ -0,0 +1,74 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/model_servers/worker_processes.h"
+
+#include <signal.h>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(WorkerProcessesTest, RunsASingleWorkerInProcess) {
+  int worker_index = -1;
+  EXPECT_EQ(7, RunWorkerProcesses(1, [&worker_index](int index) {
+              worker_index = index;
+              return 7;
+            }));
+  EXPECT_EQ(0, worker_index);
+}
+
+TEST(WorkerProcessesTest, RunsEachWorker) {
+  const string dir = io::JoinPath(testing::TmpDir(), "runs_each_worker");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(dir));
+  EXPECT_EQ(0, RunWorkerProcesses(3, [&dir](int index) {
+              const Status status = WriteStringToFile(
+                  Env::Default(), io::JoinPath(dir, strings::StrCat(index)),
+                  "");
+              return status.ok() ? 0 : 1;
+            }));
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(
+        Env::Default()->FileExists(io::JoinPath(dir, strings::StrCat(i))));
+  }
+}
+
+TEST(WorkerProcessesTest, FailsIfAWorkerFails) {
+  EXPECT_NE(0, RunWorkerProcesses(
+                   3, [](int index) { return index == 1 ? 3 : 0; }));
+}
+
+TEST(WorkerProcessesTest, RestartsCrashedWorkers) {
+  const string marker = io::JoinPath(testing::TmpDir(), "crashed_once");
+  EXPECT_EQ(0, RunWorkerProcesses(2, [&marker](int index) {
+              if (index == 1 && !Env::Default()->FileExists(marker).ok()) {
+                // Crashes on its first run only.
+                WriteStringToFile(Env::Default(), marker, "").IgnoreError();
+                raise(SIGKILL);
+              }
+              return 0;
+            }));
+  TF_EXPECT_OK(Env::Default()->FileExists(marker));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,230 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/resources/compact_resource_util.h"
+
+#include <algorithm>
+
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// Returns a copy of 'devices', stripped of any entries whose value is 0.
+std::map<string, uint32> StripDevicesWithZeroInstances(
+    const std::map<string, uint32>& devices) {
+  std::map<string, uint32> result;
+  for (const auto& entry : devices) {
+    if (entry.second > 0) {
+      result.insert(entry);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+CompactResourceUtil::CompactResourceUtil(
+    const std::map<string, uint32>& devices)
+    : devices_(StripDevicesWithZeroInstances(devices)) {}
+
+int CompactResourceUtil::InternRow(const string& device, const string& kind) {
+  auto it = row_by_device_kind_.find({device, kind});
+  if (it != row_by_device_kind_.end()) {
+    return it->second;
+  }
+  auto device_it = devices_.find(device);
+  if (device_it == devices_.end()) {
+    return -1;
+  }
+  const int row = rows_.size();
+  const uint32 num_instances = device_it->second;
+  rows_.push_back(
+      {device, kind, num_instances, static_cast<int>(slots_.size())});
+  for (int instance = 0; instance < num_instances; ++instance) {
+    slots_.push_back({row, instance});
+  }
+  slots_.push_back({row, -1});
+  row_by_device_kind_[{device, kind}] = row;
+  return row;
+}
+
+void CompactResourceUtil::AddToSlot(int slot, uint64_t quantity,
+                                    CompactResourceAllocation* allocation) {
+  if (quantity == 0) {
+    return;
+  }
+  if (slot >= allocation->quantities_.size()) {
+    allocation->quantities_.resize(slot + 1, 0);
+  }
+  if (allocation->quantities_[slot] == 0) {
+    allocation->present_slots_.push_back(slot);
+  }
+  allocation->quantities_[slot] += quantity;
+}
+
+Status CompactResourceUtil::FromProto(const ResourceAllocation& allocation,
+                                      CompactResourceAllocation* compact) {
+  *compact = CompactResourceAllocation();
+  // Bound and unbound entries of a single-instance device are distinct
+  // resources, even though they share a slot once normalized.
+  absl::flat_hash_set<std::pair<int, bool>> seen_resources;
+  for (const ResourceAllocation::Entry& entry :
+       allocation.resource_quantities()) {
+    const Resource& resource = entry.resource();
+    const int row = InternRow(resource.device(), resource.kind());
+    if (row < 0) {
+      return errors::InvalidArgument(
+          "Invalid resource allocation: Invalid device ", resource.device());
+    }
+    const Row& row_info = rows_[row];
+    int slot;
+    if (resource.has_device_instance()) {
+      if (resource.device_instance().value() >= row_info.num_instances) {
+        return errors::InvalidArgument(
+            "Invalid resource allocation: Invalid device instance ",
+            resource.device(), ":", resource.device_instance().value());
+      }
+      slot = row_info.first_slot + resource.device_instance().value();
+    } else if (row_info.num_instances == 1) {
+      slot = row_info.first_slot;
+    } else {
+      slot = row_info.first_slot + row_info.num_instances;
+    }
+    if (!seen_resources.insert({slot, resource.has_device_instance()})
+             .second) {
+      return errors::InvalidArgument(
+          "Invalid resource allocation: Repeated resource\n",
+          resource.DebugString(), "in allocation\n", allocation.DebugString());
+    }
+    AddToSlot(slot, entry.quantity(), compact);
+  }
+  return OkStatus();
+}
+
+ResourceAllocation CompactResourceUtil::ToProto(
+    const CompactResourceAllocation& compact) const {
+  ResourceAllocation allocation;
+  for (const int slot : compact.present_slots_) {
+    const Slot& slot_info = slots_[slot];
+    const Row& row = rows_[slot_info.row];
+    ResourceAllocation::Entry* entry = allocation.add_resource_quantities();
+    Resource* resource = entry->mutable_resource();
+    resource->set_device(row.device);
+    if (slot_info.instance >= 0) {
+      resource->mutable_device_instance()->set_value(slot_info.instance);
+    }
+    resource->set_kind(row.kind);
+    entry->set_quantity(compact.quantities_[slot]);
+  }
+  return allocation;
+}
+
+void CompactResourceUtil::Add(const CompactResourceAllocation& to_add,
+                              CompactResourceAllocation* base) const {
+  for (const int slot : to_add.present_slots_) {
+    AddToSlot(slot, to_add.quantities_[slot], base);
+  }
+}
+
+bool CompactResourceUtil::Subtract(
+    const CompactResourceAllocation& to_subtract,
+    CompactResourceAllocation* base) const {
+  for (const int slot : to_subtract.present_slots_) {
+    if (base->quantity(slot) < to_subtract.quantities_[slot]) {
+      return false;
+    }
+  }
+  for (const int slot : to_subtract.present_slots_) {
+    base->quantities_[slot] -= to_subtract.quantities_[slot];
+  }
+  auto& present_slots = base->present_slots_;
+  present_slots.erase(
+      std::remove_if(present_slots.begin(), present_slots.end(),
+                     [base](int slot) { return base->quantities_[slot] == 0; }),
+      present_slots.end());
+  return true;
+}
+
+CompactResourceAllocation CompactResourceUtil::Overbind(
+    const CompactResourceAllocation& allocation) const {
+  CompactResourceAllocation result = allocation;
+  bool has_unbound_slots = false;
+  for (const int slot : allocation.present_slots_) {
+    const Slot& slot_info = slots_[slot];
+    if (slot_info.instance >= 0) {
+      continue;
+    }
+    has_unbound_slots = true;
+    const Row& row = rows_[slot_info.row];
+    for (int instance = 0; instance < row.num_instances; ++instance) {
+      AddToSlot(row.first_slot + instance, allocation.quantities_[slot],
+                &result);
+    }
+    result.quantities_[slot] = 0;
+  }
+  if (has_unbound_slots) {
+    auto& present_slots = result.present_slots_;
+    present_slots.erase(
+        std::remove_if(
+            present_slots.begin(), present_slots.end(),
+            [&result](int slot) { return result.quantities_[slot] == 0; }),
+        present_slots.end());
+  }
+  return result;
+}
+
+bool CompactResourceUtil::LessThanOrEqual(
+    const CompactResourceAllocation& lhs,
+    const CompactResourceAllocation& rhs) const {
+  for (const int slot : lhs.present_slots_) {
+    const uint64_t quantity = lhs.quantities_[slot];
+    const Slot& slot_info = slots_[slot];
+    if (slot_info.instance >= 0) {
+      if (quantity > rhs.quantity(slot)) {
+        return false;
+      }
+      continue;
+    }
+    const Row& row = rows_[slot_info.row];
+    bool fits = false;
+    for (int instance = 0; instance < row.num_instances; ++instance) {
+      if (quantity <= rhs.quantity(row.first_slot + instance)) {
+        fits = true;
+        break;
+      }
+    }
+    if (!fits) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CompactResourceUtil::IsBound(
+    const CompactResourceAllocation& allocation) const {
+  for (const int slot : allocation.present_slots_) {
+    if (slots_[slot].instance < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_RESOURCES_COMPACT_RESOURCE_UTIL_H_
+#define TENSORFLOW_SERVING_RESOURCES_COMPACT_RESOURCE_UTIL_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_serving/resources/resources.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A resource allocation in the compact form of a CompactResourceUtil: a dense
+// array of quantities, indexed by the slots the util interned the resources
+// to. Only meaningful together with the util that created it.
+class CompactResourceAllocation {
+ public:
+  CompactResourceAllocation() = default;
+
+  // Returns the quantity of 'slot'; slots beyond the array are implicitly 0.
+  uint64_t quantity(int slot) const {
+    return slot < quantities_.size() ? quantities_[slot] : 0;
+  }
+
+ private:
+  friend class CompactResourceUtil;
+
+  absl::InlinedVector<uint64_t, 8> quantities_;
+
+  // The slots with non-zero quantities, in the order they became non-zero.
+  // This is the order of the entries of the proto form, which ResourceUtil
+  // would have produced with the same sequence of operations.
+  absl::InlinedVector<int, 8> present_slots_;
+};
+
+// Like ResourceUtil, but operates on CompactResourceAllocations, so that
+// repeated arithmetic on allocations neither compares device and kind strings
+// nor normalizes. Allocations are converted from and to ResourceAllocation
+// protos only at the boundary, and are always normalized (in the sense of
+// ResourceUtil::Normalize()).
+//
+// Each distinct (device, kind) pair is interned on first sight, to one slot
+// per instance of the device plus one for quantities unbound to an instance
+// (which stays empty for devices with a single instance). Interning is
+// append-only, so allocations stay valid as the util learns new kinds.
+//
+// The semantics of the operations are those of the ResourceUtil methods of the
+// same name. This class is not thread-safe.
+class CompactResourceUtil {
+ public:
+  // 'devices' are the devices managed by the system, and the number of
+  // instances of each, as in ResourceUtil::Options. Devices with no instances
+  // are ignored.
+  explicit CompactResourceUtil(const std::map<string, uint32>& devices);
+  ~CompactResourceUtil() = default;
+
+  // Converts 'allocation' to compact form, interning the resources it refers
+  // to. Returns an error if it is invalid (see ResourceUtil::VerifyValidity()).
+  Status FromProto(const ResourceAllocation& allocation,
+                   CompactResourceAllocation* compact);
+
+  // Converts 'compact' to a normalized proto.
+  ResourceAllocation ToProto(const CompactResourceAllocation& compact) const;
+
+  // Adds 'to_add' to 'base'.
+  void Add(const CompactResourceAllocation& to_add,
+           CompactResourceAllocation* base) const;
+
+  // Subtracts 'to_subtract' from 'base' and returns true, unless that would
+  // produce negative quantities, in which case returns false and leaves 'base'
+  // untouched.
+  bool Subtract(const CompactResourceAllocation& to_subtract,
+                CompactResourceAllocation* base) const;
+
+  // Binds every unbound quantity of 'allocation' to every instance of its
+  // device.
+  CompactResourceAllocation Overbind(
+      const CompactResourceAllocation& allocation) const;
+
+  // Determines whether 'lhs' fits into 'rhs', which must be bound: each bound
+  // quantity of 'lhs' into the same quantity of 'rhs', and each unbound one
+  // into some instance of its device.
+  bool LessThanOrEqual(const CompactResourceAllocation& lhs,
+                       const CompactResourceAllocation& rhs) const;
+
+  // Determines whether 'allocation' has no unbound quantities.
+  bool IsBound(const CompactResourceAllocation& allocation) const;
+
+ private:
+  // An interned (device, kind) pair.
+  struct Row {
+    string device;
+    string kind;
+    uint32 num_instances;
+    // The slot of instance 0; instance i has slot 'first_slot + i', and the
+    // unbound quantity slot 'first_slot + num_instances'.
+    int first_slot;
+  };
+
+  // What a slot stands for.
+  struct Slot {
+    int row;
+    // The bound instance, or -1 for the unbound quantity.
+    int instance;
+  };
+
+  // Returns the row of (device, kind), interning it if needed. Returns -1 if
+  // 'device' is not a managed device.
+  int InternRow(const string& device, const string& kind);
+
+  // Adds 'quantity' to 'slot' of 'allocation'.
+  static void AddToSlot(int slot, uint64_t quantity,
+                        CompactResourceAllocation* allocation);
+
+  const std::map<string, uint32> devices_;
+
+  std::vector<Row> rows_;
+  absl::flat_hash_map<std::pair<string, string>, int> row_by_device_kind_;
+  std::vector<Slot> slots_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CompactResourceUtil);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_RESOURCES_COMPACT_RESOURCE_UTIL_H_
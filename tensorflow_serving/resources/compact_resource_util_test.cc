@@ -0,0 +1,253 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/resources/compact_resource_util.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+using ::tensorflow::serving::test_util::CreateProto;
+using ::tensorflow::serving::test_util::EqualsProto;
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class CompactResourceUtilTest : public ::testing::Test {
+ protected:
+  CompactResourceUtilTest() : util_({{"main", 1}, {"gpu", 2}, {"tpu", 0}}) {}
+
+  // Converts the text proto 'allocation' to compact form.
+  CompactResourceAllocation Compact(const string& allocation) {
+    CompactResourceAllocation compact;
+    TF_CHECK_OK(
+        util_.FromProto(CreateProto<ResourceAllocation>(allocation), &compact));
+    return compact;
+  }
+
+  // The object under testing.
+  CompactResourceUtil util_;
+};
+
+TEST_F(CompactResourceUtilTest, FromProtoNormalizes) {
+  // Zero quantities are dropped, and the single main memory instance is bound.
+  EXPECT_THAT(util_.ToProto(Compact("resource_quantities { "
+                                    "  resource { device: 'main' kind: 'ram' } "
+                                    "  quantity: 8 "
+                                    "} "
+                                    "resource_quantities { "
+                                    "  resource { device: 'gpu' kind: 'ram' } "
+                                    "  quantity: 0 "
+                                    "} ")),
+              EqualsProto("resource_quantities { "
+                          "  resource { "
+                          "    device: 'main' "
+                          "    device_instance { value: 0 } "
+                          "    kind: 'ram' "
+                          "  } "
+                          "  quantity: 8 "
+                          "} "));
+}
+
+TEST_F(CompactResourceUtilTest, FromProtoRejectsInvalidAllocations) {
+  CompactResourceAllocation compact;
+  // Unknown device, and device with no instances.
+  EXPECT_FALSE(util_
+                   .FromProto(CreateProto<ResourceAllocation>(
+                                  "resource_quantities { "
+                                  "  resource { device: 'bogus' kind: 'ram' } "
+                                  "  quantity: 1 "
+                                  "} "),
+                              &compact)
+                   .ok());
+  EXPECT_FALSE(util_
+                   .FromProto(CreateProto<ResourceAllocation>(
+                                  "resource_quantities { "
+                                  "  resource { device: 'tpu' kind: 'ram' } "
+                                  "  quantity: 1 "
+                                  "} "),
+                              &compact)
+                   .ok());
+  // Invalid instance.
+  EXPECT_FALSE(util_
+                   .FromProto(CreateProto<ResourceAllocation>(
+                                  "resource_quantities { "
+                                  "  resource { "
+                                  "    device: 'gpu' "
+                                  "    device_instance { value: 2 } "
+                                  "    kind: 'ram' "
+                                  "  } "
+                                  "  quantity: 1 "
+                                  "} "),
+                              &compact)
+                   .ok());
+  // Repeated resource.
+  EXPECT_FALSE(util_
+                   .FromProto(CreateProto<ResourceAllocation>(
+                                  "resource_quantities { "
+                                  "  resource { device: 'gpu' kind: 'ram' } "
+                                  "  quantity: 1 "
+                                  "} "
+                                  "resource_quantities { "
+                                  "  resource { device: 'gpu' kind: 'ram' } "
+                                  "  quantity: 2 "
+                                  "} "),
+                              &compact)
+                   .ok());
+}
+
+TEST_F(CompactResourceUtilTest, AddKeepsEntryOrder) {
+  CompactResourceAllocation base =
+      Compact("resource_quantities { "
+              "  resource { device: 'gpu' kind: 'ram' } "
+              "  quantity: 12 "
+              "} ");
+  util_.Add(Compact("resource_quantities { "
+                    "  resource { device: 'main' kind: 'ram' } "
+                    "  quantity: 1 "
+                    "} "
+                    "resource_quantities { "
+                    "  resource { device: 'gpu' kind: 'ram' } "
+                    "  quantity: 3 "
+                    "} "
+                    "resource_quantities { "
+                    "  resource { "
+                    "    device: 'gpu' "
+                    "    device_instance { value: 1 } "
+                    "    kind: 'ram' "
+                    "  } "
+                    "  quantity: 5 "
+                    "} "),
+            &base);
+  EXPECT_THAT(util_.ToProto(base),
+              EqualsProto("resource_quantities { "
+                          "  resource { device: 'gpu' kind: 'ram' } "
+                          "  quantity: 15 "
+                          "} "
+                          "resource_quantities { "
+                          "  resource { "
+                          "    device: 'main' "
+                          "    device_instance { value: 0 } "
+                          "    kind: 'ram' "
+                          "  } "
+                          "  quantity: 1 "
+                          "} "
+                          "resource_quantities { "
+                          "  resource { "
+                          "    device: 'gpu' "
+                          "    device_instance { value: 1 } "
+                          "    kind: 'ram' "
+                          "  } "
+                          "  quantity: 5 "
+                          "} "));
+  EXPECT_FALSE(util_.IsBound(base));
+}
+
+TEST_F(CompactResourceUtilTest, Subtract) {
+  CompactResourceAllocation base =
+      Compact("resource_quantities { "
+              "  resource { device: 'main' kind: 'ram' } "
+              "  quantity: 10 "
+              "} "
+              "resource_quantities { "
+              "  resource { device: 'main' kind: 'processing' } "
+              "  quantity: 5 "
+              "} ");
+  // Would go negative, so 'base' is left untouched.
+  EXPECT_FALSE(
+      util_.Subtract(Compact("resource_quantities { "
+                             "  resource { device: 'main' kind: 'ram' } "
+                             "  quantity: 1 "
+                             "} "
+                             "resource_quantities { "
+                             "  resource { device: 'gpu' kind: 'ram' } "
+                             "  quantity: 1 "
+                             "} "),
+                     &base));
+  EXPECT_TRUE(
+      util_.Subtract(Compact("resource_quantities { "
+                             "  resource { device: 'main' kind: 'ram' } "
+                             "  quantity: 10 "
+                             "} "
+                             "resource_quantities { "
+                             "  resource { device: 'main' kind: 'processing' } "
+                             "  quantity: 2 "
+                             "} "),
+                     &base));
+  EXPECT_THAT(util_.ToProto(base),
+              EqualsProto("resource_quantities { "
+                          "  resource { "
+                          "    device: 'main' "
+                          "    device_instance { value: 0 } "
+                          "    kind: 'processing' "
+                          "  } "
+                          "  quantity: 3 "
+                          "} "));
+}
+
+TEST_F(CompactResourceUtilTest, OverbindAndLessThanOrEqual) {
+  const CompactResourceAllocation total =
+      Compact("resource_quantities { "
+              "  resource { "
+              "    device: 'gpu' "
+              "    device_instance { value: 0 } "
+              "    kind: 'ram' "
+              "  } "
+              "  quantity: 4 "
+              "} "
+              "resource_quantities { "
+              "  resource { "
+              "    device: 'gpu' "
+              "    device_instance { value: 1 } "
+              "    kind: 'ram' "
+              "  } "
+              "  quantity: 8 "
+              "} ");
+  const CompactResourceAllocation unbound =
+      Compact("resource_quantities { "
+              "  resource { device: 'gpu' kind: 'ram' } "
+              "  quantity: 6 "
+              "} ");
+  // An unbound quantity fits if some instance has room for it.
+  EXPECT_TRUE(util_.LessThanOrEqual(unbound, total));
+
+  const CompactResourceAllocation overbound = util_.Overbind(unbound);
+  EXPECT_TRUE(util_.IsBound(overbound));
+  EXPECT_THAT(util_.ToProto(overbound),
+              EqualsProto("resource_quantities { "
+                          "  resource { "
+                          "    device: 'gpu' "
+                          "    device_instance { value: 0 } "
+                          "    kind: 'ram' "
+                          "  } "
+                          "  quantity: 6 "
+                          "} "
+                          "resource_quantities { "
+                          "  resource { "
+                          "    device: 'gpu' "
+                          "    device_instance { value: 1 } "
+                          "    kind: 'ram' "
+                          "  } "
+                          "  quantity: 6 "
+                          "} "));
+  EXPECT_FALSE(util_.LessThanOrEqual(overbound, total));
+  EXPECT_TRUE(util_.LessThanOrEqual(CompactResourceAllocation(), total));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
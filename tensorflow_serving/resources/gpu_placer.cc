@@ -0,0 +1,176 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/resources/gpu_placer.h"
+
+#include <limits>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+Status GpuPlacer::Create(const Options& options,
+                         std::shared_ptr<GpuPlacer>* placer) {
+  if (options.gpu_memory_bytes.empty()) {
+    return errors::InvalidArgument(
+        "There must be at least one GPU to place on");
+  }
+  if (options.max_concurrent_runs < 0) {
+    return errors::InvalidArgument(
+        "max_concurrent_runs must be non-negative; was ",
+        options.max_concurrent_runs);
+  }
+  if (options.load_balance_weight < 0) {
+    return errors::InvalidArgument(
+        "load_balance_weight must be non-negative; was ",
+        options.load_balance_weight);
+  }
+  placer->reset(new GpuPlacer(options));
+  return OkStatus();
+}
+
+GpuPlacer::GpuPlacer(const Options& options)
+    : options_(options),
+      free_memory_bytes_(options.gpu_memory_bytes),
+      gpu_runs_in_flight_(options.gpu_memory_bytes.size(), 0) {}
+
+Status GpuPlacer::Place(const string& servable_path, const string& model_path,
+                        uint64_t memory_bytes,
+                        std::unique_ptr<Placement>* placement) {
+  mutex_lock l(mu_);
+  SampleLoads();
+
+  std::vector<double> gpu_qps(free_memory_bytes_.size(), 0);
+  double total_qps = 0;
+  for (const PlacementState& state : placements_) {
+    gpu_qps[state.gpu] += state.qps;
+    total_qps += state.qps;
+  }
+  auto model_qps = model_qps_.find(model_path);
+  const double expected_qps =
+      model_qps == model_qps_.end() ? 0 : model_qps->second;
+
+  int best_gpu = -1;
+  double best_score = std::numeric_limits<double>::infinity();
+  for (int gpu = 0; gpu < free_memory_bytes_.size(); ++gpu) {
+    if (free_memory_bytes_[gpu] < memory_bytes) {
+      continue;
+    }
+    const double fit_score =
+        static_cast<double>(free_memory_bytes_[gpu] - memory_bytes) /
+        options_.gpu_memory_bytes[gpu];
+    const double load_score =
+        total_qps + expected_qps > 0
+            ? (gpu_qps[gpu] + expected_qps) / (total_qps + expected_qps)
+            : 0;
+    const double score = fit_score + options_.load_balance_weight * load_score;
+    if (score < best_score) {
+      best_gpu = gpu;
+      best_score = score;
+    }
+  }
+  if (best_gpu < 0) {
+    return errors::ResourceExhausted("No GPU has ", memory_bytes,
+                                     " bytes of free memory for ",
+                                     servable_path);
+  }
+
+  free_memory_bytes_[best_gpu] -= memory_bytes;
+  placements_.emplace_back();
+  PlacementState* state = &placements_.back();
+  state->servable_path = servable_path;
+  state->model_path = model_path;
+  state->gpu = best_gpu;
+  state->memory_bytes = memory_bytes;
+  state->last_sample_micros = options_.env->NowMicros();
+  VLOG(1) << "Placed " << servable_path << " on GPU " << best_gpu;
+  placement->reset(new Placement(shared_from_this(), state));
+  return OkStatus();
+}
+
+std::vector<uint64_t> GpuPlacer::GetFreeMemoryBytes() const {
+  mutex_lock l(mu_);
+  return free_memory_bytes_;
+}
+
+void GpuPlacer::SampleLoads() {
+  const uint64_t now_micros = options_.env->NowMicros();
+  std::map<string, double> sampled_model_qps;
+  for (PlacementState& state : placements_) {
+    const uint64_t elapsed_micros = now_micros - state.last_sample_micros;
+    if (elapsed_micros > 0 &&
+        elapsed_micros >= static_cast<uint64_t>(
+                              options_.min_load_sample_interval_micros)) {
+      const int64_t num_requests =
+          state.num_requests.load(std::memory_order_relaxed);
+      state.qps = 1e6 * (num_requests - state.num_requests_at_last_sample) /
+                  elapsed_micros;
+      state.num_requests_at_last_sample = num_requests;
+      state.last_sample_micros = now_micros;
+    }
+    sampled_model_qps[state.model_path] += state.qps;
+  }
+  for (const auto& entry : sampled_model_qps) {
+    model_qps_[entry.first] = entry.second;
+  }
+}
+
+void GpuPlacer::Release(PlacementState* state) {
+  mutex_lock l(mu_);
+  // Keep the final rate of the servable's model for its later versions.
+  SampleLoads();
+  free_memory_bytes_[state->gpu] += state->memory_bytes;
+  for (auto it = placements_.begin(); it != placements_.end(); ++it) {
+    if (&*it == state) {
+      placements_.erase(it);
+      break;
+    }
+  }
+}
+
+void GpuPlacer::BeginRun(PlacementState* state) {
+  mutex_lock l(runs_mu_);
+  int& gpu_runs = gpu_runs_in_flight_[state->gpu];
+  while (options_.max_concurrent_runs > 0 &&
+         gpu_runs >= options_.max_concurrent_runs) {
+    run_ended_.wait(l);
+  }
+  ++gpu_runs;
+  if (state->num_runs_in_flight++ == 0) {
+    state->busy_since_micros = options_.env->NowMicros();
+  }
+}
+
+uint64_t GpuPlacer::EndRun(PlacementState* state) {
+  uint64_t busy_micros = 0;
+  {
+    mutex_lock l(runs_mu_);
+    --gpu_runs_in_flight_[state->gpu];
+    if (--state->num_runs_in_flight == 0) {
+      busy_micros = options_.env->NowMicros() - state->busy_since_micros;
+    }
+  }
+  if (options_.max_concurrent_runs > 0) {
+    run_ended_.notify_all();
+  }
+  return busy_micros;
+}
+
+GpuPlacer::Placement::~Placement() { placer_->Release(state_); }
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,195 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_RESOURCES_GPU_PLACER_H_
+#define TENSORFLOW_SERVING_RESOURCES_GPU_PLACER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Picks the GPU instance to load each servable on, balancing the servables
+// across the GPUs of the host by memory and by measured load.
+//
+// Of the GPUs with enough free memory for a servable, the placer picks the one
+// with the lowest score
+//
+//   (free memory left after placing) / (memory of the GPU)
+//     + 'load_balance_weight' * (share of the load on the GPU after placing),
+//
+// i.e. best fit on memory, which keeps room for large servables, traded off
+// against spreading the traffic. The load of a GPU is the sum of the measured
+// query rates of the servables placed on it; a servable that is being placed
+// is expected to serve the rate its model has served so far (e.g. the rate of
+// the version it replaces).
+//
+// The placer can also cap the session runs in flight on each GPU instance,
+// which bounds the kernels queued on it concurrently, and measures the time
+// each servable keeps its GPU busy, i.e. has runs in flight on it.
+//
+// This class is thread-safe.
+class GpuPlacer : public std::enable_shared_from_this<GpuPlacer> {
+ public:
+  struct Options {
+    // The memory of each GPU instance, in bytes, indexed by instance.
+    std::vector<uint64_t> gpu_memory_bytes;
+
+    // The weight of the load balancing term of the score, relative to the
+    // best-fit term. 0 places by memory alone.
+    double load_balance_weight = 1.0;
+
+    // The query rates of servables are sampled when servables are placed, at
+    // most once per this interval.
+    int64_t min_load_sample_interval_micros = 1000 * 1000;
+
+    // The most session runs in flight at once on each GPU instance (see
+    // Placement::BeginRun()); further runs wait for one to end. 0 for no
+    // limit.
+    int max_concurrent_runs = 0;
+
+    // The environment to use for timing query rates.
+    Env* env = Env::Default();
+  };
+
+  static Status Create(const Options& options,
+                       std::shared_ptr<GpuPlacer>* placer);
+
+  ~GpuPlacer() = default;
+
+  class Placement;
+
+  // Places the servable at 'servable_path', of the model at 'model_path',
+  // which needs 'memory_bytes' of GPU memory. Returns a ResourceExhausted error
+  // if no GPU has enough free memory. The servable holds its GPU memory until
+  // 'placement' is destroyed.
+  Status Place(const string& servable_path, const string& model_path,
+               uint64_t memory_bytes, std::unique_ptr<Placement>* placement)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the free memory of each GPU instance.
+  std::vector<uint64_t> GetFreeMemoryBytes() const TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct PlacementState {
+    string servable_path;
+    string model_path;
+    int gpu;
+    uint64_t memory_bytes;
+
+    // The number of requests served, as of the last sample, and when it was
+    // taken.
+    int64_t num_requests_at_last_sample = 0;
+    uint64_t last_sample_micros;
+
+    // The query rate measured at the last sample.
+    double qps = 0;
+
+    // Counted by Placement::RecordRequest().
+    std::atomic<int64_t> num_requests{0};
+
+    // The runs of the servable in flight, and since when there have been
+    // any. Guarded by 'runs_mu_'.
+    int num_runs_in_flight = 0;
+    uint64_t busy_since_micros = 0;
+  };
+
+  explicit GpuPlacer(const Options& options);
+
+  // Samples the query rates of the placed servables, and updates the rates of
+  // their models.
+  void SampleLoads() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  void Release(PlacementState* state) TF_LOCKS_EXCLUDED(mu_);
+
+  void BeginRun(PlacementState* state) TF_LOCKS_EXCLUDED(runs_mu_);
+  uint64_t EndRun(PlacementState* state) TF_LOCKS_EXCLUDED(runs_mu_);
+
+  const Options options_;
+
+  mutable mutex mu_;
+
+  std::vector<uint64_t> free_memory_bytes_ TF_GUARDED_BY(mu_);
+
+  std::list<PlacementState> placements_ TF_GUARDED_BY(mu_);
+
+  // The query rate each model served at the last sample of its servables.
+  // Kept after the servables are released, for later versions.
+  std::map<string, double> model_qps_ TF_GUARDED_BY(mu_);
+
+  // Guards the runs in flight, apart from 'mu_' so that runs do not wait on
+  // placements.
+  mutable mutex runs_mu_;
+  condition_variable run_ended_;
+
+  // The runs in flight on each GPU instance.
+  std::vector<int> gpu_runs_in_flight_ TF_GUARDED_BY(runs_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuPlacer);
+};
+
+// The placement of a servable on a GPU instance by a GpuPlacer.
+class GpuPlacer::Placement {
+ public:
+  // Releases the GPU memory of the servable.
+  ~Placement();
+
+  // The GPU instance the servable is placed on.
+  int gpu() const { return state_->gpu; }
+
+  // Counts a request served by the servable, towards the load of its GPU.
+  void RecordRequest() {
+    state_->num_requests.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Marks the start of a session run of the servable on its GPU, first
+  // waiting for one of the runs in flight on the GPU to end if the placer caps
+  // them. Each call must be paired with a call to EndRun().
+  void BeginRun() { placer_->BeginRun(state_); }
+
+  // Marks the end of a run started by BeginRun(). If it was the last run of
+  // the servable in flight, returns the time, in microseconds, the servable
+  // has had runs in flight since it had none; else returns 0.
+  uint64_t EndRun() { return placer_->EndRun(state_); }
+
+ private:
+  friend class GpuPlacer;
+
+  Placement(std::shared_ptr<GpuPlacer> placer, PlacementState* state)
+      : placer_(std::move(placer)), state_(state) {}
+
+  const std::shared_ptr<GpuPlacer> placer_;
+  PlacementState* const state_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Placement);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_RESOURCES_GPU_PLACER_H_
@@ -0,0 +1,161 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/resources/gpu_placer.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(GpuPlacerTest, BestFitOnMemory) {
+  GpuPlacer::Options options;
+  options.gpu_memory_bytes = {100, 100, 100};
+  std::shared_ptr<GpuPlacer> placer;
+  TF_ASSERT_OK(GpuPlacer::Create(options, &placer));
+
+  std::unique_ptr<GpuPlacer::Placement> a, b, c, d;
+  TF_ASSERT_OK(placer->Place("/m/a/1", "/m/a", 60, &a));
+  // Without traffic, servables go where they fit most tightly.
+  TF_ASSERT_OK(placer->Place("/m/b/1", "/m/b", 30, &b));
+  EXPECT_EQ(a->gpu(), b->gpu());
+  TF_ASSERT_OK(placer->Place("/m/c/1", "/m/c", 50, &c));
+  EXPECT_NE(a->gpu(), c->gpu());
+  EXPECT_EQ(std::vector<uint64_t>({10, 50, 100}),
+            placer->GetFreeMemoryBytes());
+
+  // Nothing has room for 60 bytes but the empty GPU.
+  TF_ASSERT_OK(placer->Place("/m/d/1", "/m/d", 60, &d));
+  EXPECT_EQ(2, d->gpu());
+  std::unique_ptr<GpuPlacer::Placement> e;
+  EXPECT_EQ(error::RESOURCE_EXHAUSTED,
+            placer->Place("/m/e/1", "/m/e", 60, &e).code());
+
+  // Releasing a placement frees its memory.
+  d.reset();
+  TF_EXPECT_OK(placer->Place("/m/e/1", "/m/e", 60, &e));
+}
+
+TEST(GpuPlacerTest, BalancesMeasuredLoad) {
+  test_util::FakeClockEnv env(Env::Default());
+  GpuPlacer::Options options;
+  options.gpu_memory_bytes = {100, 100};
+  options.load_balance_weight = 10;
+  options.env = &env;
+  std::shared_ptr<GpuPlacer> placer;
+  TF_ASSERT_OK(GpuPlacer::Create(options, &placer));
+
+  std::unique_ptr<GpuPlacer::Placement> busy;
+  TF_ASSERT_OK(placer->Place("/m/busy/1", "/m/busy", 10, &busy));
+  for (int i = 0; i < 100; ++i) {
+    busy->RecordRequest();
+  }
+  env.AdvanceByMicroseconds(1000 * 1000);
+
+  // Best fit alone would pick the GPU of the busy servable, but its load
+  // outweighs that.
+  std::unique_ptr<GpuPlacer::Placement> idle;
+  TF_ASSERT_OK(placer->Place("/m/idle/1", "/m/idle", 10, &idle));
+  EXPECT_NE(busy->gpu(), idle->gpu());
+
+  // A new version of the busy model is expected to take over its traffic, so
+  // goes to the GPU without load too.
+  std::unique_ptr<GpuPlacer::Placement> busy_v2;
+  TF_ASSERT_OK(placer->Place("/m/busy/2", "/m/busy", 10, &busy_v2));
+  EXPECT_EQ(idle->gpu(), busy_v2->gpu());
+}
+
+TEST(GpuPlacerTest, MeasuresBusyTime) {
+  test_util::FakeClockEnv env(Env::Default());
+  GpuPlacer::Options options;
+  options.gpu_memory_bytes = {100};
+  options.env = &env;
+  std::shared_ptr<GpuPlacer> placer;
+  TF_ASSERT_OK(GpuPlacer::Create(options, &placer));
+  std::unique_ptr<GpuPlacer::Placement> placement;
+  TF_ASSERT_OK(placer->Place("/m/a/1", "/m/a", 10, &placement));
+
+  // Overlapping runs count once, when the last of them ends.
+  placement->BeginRun();
+  env.AdvanceByMicroseconds(10);
+  placement->BeginRun();
+  env.AdvanceByMicroseconds(20);
+  EXPECT_EQ(0, placement->EndRun());
+  env.AdvanceByMicroseconds(5);
+  EXPECT_EQ(35, placement->EndRun());
+
+  // Idle time is not counted.
+  env.AdvanceByMicroseconds(100);
+  placement->BeginRun();
+  env.AdvanceByMicroseconds(7);
+  EXPECT_EQ(7, placement->EndRun());
+}
+
+TEST(GpuPlacerTest, CapsConcurrentRuns) {
+  GpuPlacer::Options options;
+  options.gpu_memory_bytes = {100, 100};
+  options.max_concurrent_runs = 1;
+  std::shared_ptr<GpuPlacer> placer;
+  TF_ASSERT_OK(GpuPlacer::Create(options, &placer));
+  std::unique_ptr<GpuPlacer::Placement> a, b, c;
+  TF_ASSERT_OK(placer->Place("/m/a/1", "/m/a", 60, &a));
+  TF_ASSERT_OK(placer->Place("/m/b/1", "/m/b", 30, &b));
+  TF_ASSERT_OK(placer->Place("/m/c/1", "/m/c", 60, &c));
+  ASSERT_EQ(a->gpu(), b->gpu());
+  ASSERT_NE(a->gpu(), c->gpu());
+
+  a->BeginRun();
+  // Another GPU has its own runs.
+  c->BeginRun();
+  c->EndRun();
+
+  std::atomic<bool> b_started{false};
+  std::unique_ptr<Thread> thread(Env::Default()->StartThread(
+      {}, "run_b", [&b, &b_started]() {
+        b->BeginRun();
+        b_started = true;
+        b->EndRun();
+      }));
+  Env::Default()->SleepForMicroseconds(10 * 1000);
+  EXPECT_FALSE(b_started);
+  a->EndRun();
+  thread.reset();
+  EXPECT_TRUE(b_started);
+}
+
+TEST(GpuPlacerTest, InvalidOptions) {
+  std::shared_ptr<GpuPlacer> placer;
+  EXPECT_FALSE(GpuPlacer::Create({}, &placer).ok());
+  GpuPlacer::Options options;
+  options.gpu_memory_bytes = {100};
+  options.load_balance_weight = -1;
+  EXPECT_FALSE(GpuPlacer::Create(options, &placer).ok());
+  options.load_balance_weight = 1;
+  options.max_concurrent_runs = -1;
+  EXPECT_FALSE(GpuPlacer::Create(options, &placer).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
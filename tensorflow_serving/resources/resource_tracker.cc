@@ -23,7 +23,10 @@ limitations under the License.
 
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow_serving/resources/resource_values.h"
 #include "tensorflow_serving/resources/resources.pb.h"
+#include "tensorflow_serving/util/memory_reclaimer.h"
 
 namespace tensorflow {
 namespace serving {
@@ -46,25 +49,44 @@ Status ResourceTracker::Create(const ResourceAllocation& total_resources,
 Status ResourceTracker::ReserveResources(const Loader& servable,
                                          bool* success) {
   ResourceAllocation servable_resources;
-  TF_RETURN_IF_ERROR(servable.EstimateResources(&servable_resources));
-  TF_RETURN_IF_ERROR(util_->VerifyValidity(servable_resources));
+  CompactResourceAllocation compact_servable_resources;
+  TF_RETURN_IF_ERROR(GetEstimate(servable, &servable_resources,
+                                 &compact_servable_resources));
 
-  ResourceAllocation conservative_proposed_used_resources =
-      util_->Overbind(used_resources_);
-  util_->Add(servable_resources, &conservative_proposed_used_resources);
+  CompactResourceAllocation conservative_proposed_used_resources =
+      compact_util_.Overbind(used_resources_);
+  compact_util_.Add(compact_servable_resources,
+                    &conservative_proposed_used_resources);
+  MemoryReclaimer* const reclaimer = MemoryReclaimer::Global();
+  const uint64_t reclaim_bytes =
+      reclaimer != nullptr ? reclaimer->pending_bytes() : 0;
+  if (reclaim_bytes > 0 && util_->devices().count(device_types::kMain) > 0) {
+    ResourceAllocation reclaim_resources;
+    ResourceAllocation::Entry* const entry =
+        reclaim_resources.add_resource_quantities();
+    entry->mutable_resource()->set_device(device_types::kMain);
+    entry->mutable_resource()->set_kind(resource_kinds::kRamBytes);
+    entry->set_quantity(reclaim_bytes);
+    CompactResourceAllocation compact_reclaim_resources;
+    TF_RETURN_IF_ERROR(
+        compact_util_.FromProto(reclaim_resources, &compact_reclaim_resources));
+    compact_util_.Add(compact_reclaim_resources,
+                      &conservative_proposed_used_resources);
+  }
 
-  if (util_->LessThanOrEqual(conservative_proposed_used_resources,
-                             total_resources_)) {
-    util_->Add(servable_resources, &used_resources_);
+  if (compact_util_.LessThanOrEqual(conservative_proposed_used_resources,
+                                    compact_total_resources_)) {
+    compact_util_.Add(compact_servable_resources, &used_resources_);
     *success = true;
   } else {
     LOG(WARNING) << "Insufficient resources to load servable "
                  << "\ntotal resources:\n"
                  << total_resources_.DebugString()
                  << "used/reserved resources:\n"
-                 << used_resources_.DebugString()
+                 << used_resources().DebugString()
                  << "resources requested by servable:\n"
-                 << servable_resources.DebugString();
+                 << servable_resources.DebugString()
+                 << "RAM bytes pending reclamation: " << reclaim_bytes;
     *success = false;
   }
 
@@ -73,19 +95,38 @@ Status ResourceTracker::ReserveResources(const Loader& servable,
 
 Status ResourceTracker::RecomputeUsedResources(
     const std::vector<const Loader*>& servables) {
-  used_resources_.Clear();
+  used_resources_ = CompactResourceAllocation();
   for (const Loader* servable : servables) {
     ResourceAllocation servable_resources;
-    TF_RETURN_IF_ERROR(servable->EstimateResources(&servable_resources));
-    TF_RETURN_IF_ERROR(util_->VerifyValidity(servable_resources));
-    util_->Add(servable_resources, &used_resources_);
+    CompactResourceAllocation compact_servable_resources;
+    TF_RETURN_IF_ERROR(GetEstimate(*servable, &servable_resources,
+                                   &compact_servable_resources));
+    compact_util_.Add(compact_servable_resources, &used_resources_);
   }
   return Status();
 }
 
+const ResourceAllocation& ResourceTracker::used_resources() const {
+  used_resources_proto_ = compact_util_.ToProto(used_resources_);
+  return used_resources_proto_;
+}
+
+Status ResourceTracker::GetEstimate(const Loader& servable,
+                                    ResourceAllocation* estimate,
+                                    CompactResourceAllocation* compact) {
+  TF_RETURN_IF_ERROR(servable.EstimateResources(estimate));
+  TF_RETURN_IF_ERROR(util_->VerifyValidity(*estimate));
+  return compact_util_.FromProto(*estimate, compact);
+}
+
 ResourceTracker::ResourceTracker(const ResourceAllocation& total_resources,
                                  std::unique_ptr<ResourceUtil> util)
-    : util_(std::move(util)), total_resources_(total_resources) {}
+    : util_(std::move(util)),
+      compact_util_(util_->devices()),
+      total_resources_(total_resources) {
+  TF_CHECK_OK(compact_util_.FromProto(total_resources_,
+                                      &compact_total_resources_));
+}
 
 }  // namespace serving
 }  // namespace tensorflow
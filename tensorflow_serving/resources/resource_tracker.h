@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow_serving/core/loader.h"
+#include "tensorflow_serving/resources/compact_resource_util.h"
 #include "tensorflow_serving/resources/resource_util.h"
 
 namespace tensorflow {
@@ -29,6 +30,10 @@ namespace serving {
 // serving system. It can decide whether enough resources are available to load
 // a new servable.
 //
+// The used and total resources are kept in the compact form of a
+// CompactResourceUtil, so that reservations only convert the estimate of the
+// servable at hand rather than operating on protos throughout.
+//
 // This class is not thread-safe.
 class ResourceTracker {
  public:
@@ -43,6 +48,10 @@ class ResourceTracker {
   // sets 'success' to true. Otherwise, leaves the used resources unchanged and
   // sets 'success' to false. Upon encountering illegal data, e.g. if 'servable'
   // emits an invalid resource estimate, returns an error status.
+  //
+  // The main-memory RAM that the global MemoryReclaimer has yet to free (see
+  // MemoryReclaimer::pending_bytes()) counts as used too: the servables it
+  // holds are unloaded and no longer have reservations.
   Status ReserveResources(const Loader& servable, bool* success);
 
   // Recomputes the used resources from scratch, given every loader whose
@@ -55,24 +64,37 @@ class ResourceTracker {
   Status RecomputeUsedResources(const std::vector<const Loader*>& servables);
 
   const ResourceAllocation& total_resources() const { return total_resources_; }
-  const ResourceAllocation& used_resources() const { return used_resources_; }
+  const ResourceAllocation& used_resources() const;
 
  private:
   ResourceTracker(const ResourceAllocation& total_resources,
                   std::unique_ptr<ResourceUtil> util);
 
-  // A ResourceUtil object to use for operations and comparisons on allocations.
+  // Gets the resource estimate of 'servable', verifies it and converts it to
+  // compact form.
+  Status GetEstimate(const Loader& servable, ResourceAllocation* estimate,
+                     CompactResourceAllocation* compact);
+
+  // A ResourceUtil object to use for validating allocations.
   const std::unique_ptr<ResourceUtil> util_;
 
+  // A CompactResourceUtil object to use for operations and comparisons on
+  // allocations, for the devices of 'util_'.
+  CompactResourceUtil compact_util_;
+
   // The total resources the system has. Must be bound. Kept normalized.
   const ResourceAllocation total_resources_;
+  CompactResourceAllocation compact_total_resources_;
 
   // The resources currently set aside for servables that are loaded, or
-  // transitioning to/from being loaded. May be bound or unbound. Kept
-  // normalized.
+  // transitioning to/from being loaded. May be bound or unbound.
   //
   // Under normal conditions, less than or equal to 'total_resources_'.
-  ResourceAllocation used_resources_;
+  CompactResourceAllocation used_resources_;
+
+  // The proto form of 'used_resources_', as of the last call to
+  // used_resources().
+  mutable ResourceAllocation used_resources_proto_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ResourceTracker);
 };
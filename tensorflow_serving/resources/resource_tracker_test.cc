@@ -21,13 +21,16 @@ limitations under the License.
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_serving/core/test_util/mock_loader.h"
+#include "tensorflow_serving/resources/resource_values.h"
 #include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/test_util/test_util.h"
 #include "tensorflow_serving/util/any_ptr.h"
+#include "tensorflow_serving/util/memory_reclaimer.h"
 
 using ::tensorflow::serving::test_util::CreateProto;
 using ::tensorflow::serving::test_util::EqualsProto;
@@ -452,6 +455,52 @@ TEST_F(ResourceTrackerTest, InvalidResourceEstimate) {
                    .ok());
 }
 
+TEST(ResourceTrackerReclaimTest, CountsMemoryPendingReclamationAsUsed) {
+  ResourceAllocation total_resources;
+  ResourceAllocation::Entry* const total =
+      total_resources.add_resource_quantities();
+  total->mutable_resource()->set_device(device_types::kMain);
+  total->mutable_resource()->mutable_device_instance()->set_value(0);
+  total->mutable_resource()->set_kind(resource_kinds::kRamBytes);
+  total->set_quantity(16);
+  std::unique_ptr<ResourceTracker> tracker;
+  TF_ASSERT_OK(ResourceTracker::Create(
+      total_resources,
+      std::unique_ptr<ResourceUtil>(
+          new ResourceUtil({{{device_types::kMain, 1}}})),
+      &tracker));
+
+  NiceMock<test_util::MockLoader> loader;
+  ON_CALL(loader, EstimateResources(_))
+      .WillByDefault(Invoke([](ResourceAllocation* estimate) {
+        ResourceAllocation::Entry* const entry =
+            estimate->add_resource_quantities();
+        entry->mutable_resource()->set_device(device_types::kMain);
+        entry->mutable_resource()->set_kind(resource_kinds::kRamBytes);
+        entry->set_quantity(10);
+        return Status();
+      }));
+
+  MemoryReclaimer::Options options;
+  options.low_priority = false;
+  TF_ASSERT_OK(
+      MemoryReclaimer::SetGlobal(std::make_unique<MemoryReclaimer>(options)));
+  MemoryReclaimer* const reclaimer = MemoryReclaimer::Global();
+
+  // An unloaded servable of 8 bytes is yet to be destroyed, so 10 more bytes
+  // don't fit.
+  Notification unblock;
+  reclaimer->Release([&]() { unblock.WaitForNotification(); }, 8);
+  bool success;
+  TF_ASSERT_OK(tracker->ReserveResources(loader, &success));
+  EXPECT_FALSE(success);
+
+  unblock.Notify();
+  reclaimer->WaitUntilIdle();
+  TF_ASSERT_OK(tracker->ReserveResources(loader, &success));
+  EXPECT_TRUE(success);
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -40,6 +40,10 @@ class ResourceUtil {
   explicit ResourceUtil(const Options& options);
   virtual ~ResourceUtil() = default;
 
+  // The devices managed by the system (those with at least one instance), and
+  // the number of instances of each.
+  const std::map<string, uint32>& devices() const { return devices_; }
+
   // Determines whether 'allocation' is valid, i.e.:
   //  1. It only refers to valid devices, i.e. those supplied via Options.
   //  2. Each entry is either unbound, or bound to a valid device instance.
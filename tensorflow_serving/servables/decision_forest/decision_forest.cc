@@ -0,0 +1,297 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/decision_forest/decision_forest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Sets 'values' to the feature values of 'example' that 'feature_indices'
+// knows, by index.
+Status GetExampleFeatures(
+    const Example& example,
+    const std::unordered_map<string, int>& feature_indices, float* values) {
+  for (const auto& entry : example.features().feature()) {
+    auto index = feature_indices.find(entry.first);
+    if (index == feature_indices.end()) {
+      continue;
+    }
+    const Feature& feature = entry.second;
+    if (feature.kind_case() == Feature::kFloatList &&
+        feature.float_list().value_size() == 1) {
+      values[index->second] = feature.float_list().value(0);
+    } else if (feature.kind_case() == Feature::kInt64List &&
+               feature.int64_list().value_size() == 1) {
+      values[index->second] = feature.int64_list().value(0);
+    } else {
+      return errors::InvalidArgument(
+          "Feature ", entry.first,
+          " must have exactly one float or int64 value");
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+Status DecisionForestModel::Create(
+    const DecisionForest& forest, std::unique_ptr<DecisionForestModel>* model) {
+  std::unique_ptr<DecisionForestModel> new_model(new DecisionForestModel());
+  new_model->task_ = forest.task();
+  new_model->initial_prediction_ = forest.initial_prediction();
+  switch (forest.task()) {
+    case DecisionForest::REGRESSION:
+      break;
+    case DecisionForest::BINARY_CLASSIFICATION:
+      if (forest.class_labels().empty()) {
+        new_model->negative_label_ = "0";
+        new_model->positive_label_ = "1";
+      } else if (forest.class_labels_size() == 2) {
+        new_model->negative_label_ = forest.class_labels(0);
+        new_model->positive_label_ = forest.class_labels(1);
+      } else {
+        return errors::InvalidArgument(
+            "A binary classifier must have no or two class labels; has ",
+            forest.class_labels_size());
+      }
+      break;
+    default:
+      return errors::InvalidArgument("Unknown decision forest task ",
+                                     forest.task());
+  }
+
+  new_model->features_.assign(forest.features().begin(),
+                              forest.features().end());
+  for (int i = 0; i < forest.features_size(); ++i) {
+    const string& name = forest.features(i).name();
+    if (name.empty() ||
+        !new_model->feature_indices_.emplace(name, i).second) {
+      return errors::InvalidArgument(
+          "Decision forest features must have distinct names; feature ", i,
+          " is named '", name, "'");
+    }
+  }
+
+  std::vector<Condition> conditions;
+  for (int t = 0; t < forest.trees_size(); ++t) {
+    const DecisionTree& tree = forest.trees(t);
+    if (tree.nodes().empty()) {
+      return errors::InvalidArgument("Tree ", t, " has no nodes");
+    }
+    new_model->tree_leaf_offsets_.push_back(new_model->leaf_values_.size());
+    std::vector<bool> visited(tree.nodes_size(), false);
+    TF_RETURN_IF_ERROR(
+        new_model->CompileSubtree(tree, t, 0, &visited, &conditions));
+    if (std::find(visited.begin(), visited.end(), false) != visited.end()) {
+      return errors::InvalidArgument("Tree ", t,
+                                     " has nodes not reachable from its root");
+    }
+  }
+
+  // Lay out the conditions by feature, then threshold.
+  std::stable_sort(conditions.begin(), conditions.end(),
+                   [](const Condition& a, const Condition& b) {
+                     return a.feature != b.feature ? a.feature < b.feature
+                                                   : a.threshold < b.threshold;
+                   });
+  new_model->feature_offsets_.assign(forest.features_size() + 1, 0);
+  new_model->thresholds_.reserve(conditions.size());
+  new_model->condition_trees_.reserve(conditions.size());
+  new_model->condition_masks_.reserve(conditions.size());
+  for (const Condition& condition : conditions) {
+    ++new_model->feature_offsets_[condition.feature + 1];
+    new_model->thresholds_.push_back(condition.threshold);
+    new_model->condition_trees_.push_back(condition.tree);
+    new_model->condition_masks_.push_back(condition.mask);
+  }
+  for (int f = 0; f < forest.features_size(); ++f) {
+    new_model->feature_offsets_[f + 1] += new_model->feature_offsets_[f];
+  }
+
+  *model = std::move(new_model);
+  return OkStatus();
+}
+
+Status DecisionForestModel::CompileSubtree(const DecisionTree& tree,
+                                           int tree_index, int node,
+                                           std::vector<bool>* visited,
+                                           std::vector<Condition>* conditions) {
+  if ((*visited)[node]) {
+    return errors::InvalidArgument("Node ", node, " of tree ", tree_index,
+                                   " has more than one parent");
+  }
+  (*visited)[node] = true;
+  const DecisionNode& decision_node = tree.nodes(node);
+  const int first_leaf =
+      leaf_values_.size() - tree_leaf_offsets_[tree_index];
+  if (decision_node.left_child() == 0 && decision_node.right_child() == 0) {
+    if (first_leaf >= kMaxLeavesPerTree) {
+      return errors::InvalidArgument("Tree ", tree_index, " has more than ",
+                                     kMaxLeavesPerTree, " leaves");
+    }
+    leaf_values_.push_back(decision_node.leaf_value());
+    return OkStatus();
+  }
+  for (const int child :
+       {decision_node.left_child(), decision_node.right_child()}) {
+    if (child <= 0 || child >= tree.nodes_size()) {
+      return errors::InvalidArgument("Node ", node, " of tree ", tree_index,
+                                     " has invalid child ", child);
+    }
+  }
+  if (decision_node.feature() < 0 ||
+      decision_node.feature() >= features_.size()) {
+    return errors::InvalidArgument("Node ", node, " of tree ", tree_index,
+                                   " tests unknown feature ",
+                                   decision_node.feature());
+  }
+  if (std::isnan(decision_node.threshold())) {
+    return errors::InvalidArgument("Node ", node, " of tree ", tree_index,
+                                   " has a NaN threshold");
+  }
+  TF_RETURN_IF_ERROR(CompileSubtree(tree, tree_index,
+                                    decision_node.left_child(), visited,
+                                    conditions));
+  const int num_left_leaves =
+      leaf_values_.size() - tree_leaf_offsets_[tree_index] - first_leaf;
+  // The right subtree has a leaf at least.
+  if (first_leaf + num_left_leaves >= kMaxLeavesPerTree) {
+    return errors::InvalidArgument("Tree ", tree_index, " has more than ",
+                                   kMaxLeavesPerTree, " leaves");
+  }
+  const uint64_t left_leaves = ((uint64_t{1} << num_left_leaves) - 1)
+                               << first_leaf;
+  conditions->push_back({decision_node.feature(), decision_node.threshold(),
+                         static_cast<uint32_t>(tree_index), ~left_leaves});
+  return CompileSubtree(tree, tree_index, decision_node.right_child(), visited,
+                        conditions);
+}
+
+void DecisionForestModel::Score(const float* features, int num_examples,
+                                float* scores) const {
+  const int num_trees = tree_leaf_offsets_.size();
+  std::vector<uint64_t> leaves(num_trees);
+  for (int i = 0; i < num_examples; ++i) {
+    const float* values = features + static_cast<int64_t>(i) * num_features();
+    std::fill(leaves.begin(), leaves.end(), ~uint64_t{0});
+    for (int f = 0; f < num_features(); ++f) {
+      const float value = values[f];
+      const int end = feature_offsets_[f + 1];
+      // The example fails the conditions on 'f' up to the first threshold
+      // above its value (and none if the value is NaN).
+      for (int c = feature_offsets_[f]; c < end && thresholds_[c] <= value;
+           ++c) {
+        leaves[condition_trees_[c]] &= condition_masks_[c];
+      }
+    }
+    float score = initial_prediction_;
+    for (int t = 0; t < num_trees; ++t) {
+      score +=
+          leaf_values_[tree_leaf_offsets_[t] + absl::countr_zero(leaves[t])];
+    }
+    scores[i] = score;
+  }
+}
+
+Status DecisionForestModel::GetFeatures(const Input& input,
+                                        std::vector<float>* features,
+                                        int* num_examples) const {
+  const ::google::protobuf::RepeatedPtrField<Example>* examples = nullptr;
+  std::vector<float> defaults(num_features());
+  for (int f = 0; f < num_features(); ++f) {
+    defaults[f] = features_[f].missing_value();
+  }
+  switch (input.kind_case()) {
+    case Input::KindCase::kExampleList:
+      examples = &input.example_list().examples();
+      break;
+    case Input::KindCase::kExampleListWithContext:
+      examples = &input.example_list_with_context().examples();
+      TF_RETURN_IF_ERROR(
+          GetExampleFeatures(input.example_list_with_context().context(),
+                             feature_indices_, defaults.data()));
+      break;
+    default:
+      break;
+  }
+  if (examples == nullptr || examples->empty()) {
+    return errors::InvalidArgument("Input is empty.");
+  }
+  *num_examples = examples->size();
+  features->resize(static_cast<int64_t>(*num_examples) * num_features());
+  for (int i = 0; i < *num_examples; ++i) {
+    float* values = features->data() + static_cast<int64_t>(i) * num_features();
+    std::copy(defaults.begin(), defaults.end(), values);
+    TF_RETURN_IF_ERROR(
+        GetExampleFeatures((*examples)[i], feature_indices_, values));
+  }
+  return OkStatus();
+}
+
+Status DecisionForestModel::Classify(const Input& input,
+                                     ClassificationResult* result) const {
+  if (task_ != DecisionForest::BINARY_CLASSIFICATION) {
+    return errors::InvalidArgument(
+        "Classify is only supported by classifier decision forests");
+  }
+  std::vector<float> features;
+  int num_examples;
+  TF_RETURN_IF_ERROR(GetFeatures(input, &features, &num_examples));
+  std::vector<float> scores(num_examples);
+  Score(features.data(), num_examples, scores.data());
+  result->clear_classifications();
+  for (const float score : scores) {
+    const float probability = 1 / (1 + std::exp(-score));
+    Classifications* classifications = result->add_classifications();
+    Class* negative = classifications->add_classes();
+    negative->set_label(negative_label_);
+    negative->set_score(1 - probability);
+    Class* positive = classifications->add_classes();
+    positive->set_label(positive_label_);
+    positive->set_score(probability);
+  }
+  return OkStatus();
+}
+
+Status DecisionForestModel::Regress(const Input& input,
+                                    RegressionResult* result) const {
+  if (task_ != DecisionForest::REGRESSION) {
+    return errors::InvalidArgument(
+        "Regress is only supported by regression decision forests");
+  }
+  std::vector<float> features;
+  int num_examples;
+  TF_RETURN_IF_ERROR(GetFeatures(input, &features, &num_examples));
+  std::vector<float> scores(num_examples);
+  Score(features.data(), num_examples, scores.data());
+  result->clear_regressions();
+  for (const float score : scores) {
+    result->add_regressions()->set_value(score);
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
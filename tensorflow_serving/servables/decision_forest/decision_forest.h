@@ -0,0 +1,139 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_DECISION_FOREST_DECISION_FOREST_H_
+#define TENSORFLOW_SERVING_SERVABLES_DECISION_FOREST_DECISION_FOREST_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow_serving/apis/classification.pb.h"
+#include "tensorflow_serving/apis/input.pb.h"
+#include "tensorflow_serving/apis/regression.pb.h"
+#include "tensorflow_serving/servables/decision_forest/decision_forest.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A DecisionForest compiled for scoring batches of examples natively, without
+// a TensorFlow graph, with QuickScorer (Lucchese et al., "QuickScorer: a Fast
+// Algorithm to Rank Documents with Additive Ensembles of Regression Trees",
+// SIGIR 2015).
+//
+// Rather than walking each tree from its root, which jumps around memory and
+// mispredicts branches, QuickScorer goes over the conditions of all the trees
+// feature by feature. The leaves of each tree are numbered from left to right,
+// and each condition has a mask of the leaves outside of its left subtree. The
+// conditions an example fails, i.e. whose threshold is at most its value, are
+// found by scanning the thresholds of each feature in increasing order, and
+// their masks are ANDed into a bitvector per tree; the leaf the example
+// reaches in a tree is then the lowest bit of the tree left set. The
+// thresholds, trees and masks of the conditions are kept in flat arrays by
+// feature, which the scans read sequentially.
+//
+// Trees can have at most 64 leaves, one per bit of the bitvectors, which
+// covers the depths of up to 6 usual for gradient boosted trees.
+//
+// This class is thread-safe.
+class DecisionForestModel {
+ public:
+  // The most leaves a tree can have.
+  static constexpr int kMaxLeavesPerTree = 64;
+
+  // Compiles 'forest', or returns an InvalidArgument error if it is not a
+  // valid forest of trees of at most kMaxLeavesPerTree leaves.
+  static Status Create(const DecisionForest& forest,
+                       std::unique_ptr<DecisionForestModel>* model);
+
+  ~DecisionForestModel() = default;
+
+  DecisionForest::Task task() const { return task_; }
+
+  int num_features() const { return features_.size(); }
+  int num_trees() const { return tree_leaf_offsets_.size(); }
+
+  // Sets 'scores[i]' to the score of the i-th of 'num_examples' examples, whose
+  // 'num_features()' feature values, in the order of DecisionForest.features,
+  // start at 'features' + i * 'num_features()'. The scores of classifiers are
+  // logits.
+  void Score(const float* features, int num_examples, float* scores) const;
+
+  // Sets 'features' to the feature values of the Examples of 'input', in the
+  // layout of Score(), and 'num_examples' to their number. Examples that don't
+  // have a feature, nor does the context of an example_list_with_context,
+  // have its missing_value.
+  Status GetFeatures(const Input& input, std::vector<float>* features,
+                     int* num_examples) const;
+
+  // Sets 'result' to the classes of the Examples of 'input', with their
+  // probabilities as scores. Returns an InvalidArgument error if the forest
+  // is not a classifier.
+  Status Classify(const Input& input, ClassificationResult* result) const;
+
+  // Sets 'result' to the scores of the Examples of 'input'. Returns an
+  // InvalidArgument error if the forest is not a regressor.
+  Status Regress(const Input& input, RegressionResult* result) const;
+
+ private:
+  DecisionForestModel() = default;
+
+  // A condition of a tree, before the conditions are laid out by feature.
+  struct Condition {
+    int feature;
+    float threshold;
+    uint32_t tree;
+    uint64_t mask;
+  };
+
+  // Appends the values of the leaves of the subtree of 'tree', the
+  // 'tree_index'-th tree, rooted at 'node' to 'leaf_values_', from left to
+  // right, and its conditions to 'conditions'. 'visited' marks the nodes of
+  // the tree compiled so far.
+  Status CompileSubtree(const DecisionTree& tree, int tree_index, int node,
+                        std::vector<bool>* visited,
+                        std::vector<Condition>* conditions);
+
+  DecisionForest::Task task_;
+  float initial_prediction_;
+  std::vector<DecisionForestFeature> features_;
+  std::unordered_map<string, int> feature_indices_;
+  string negative_label_;
+  string positive_label_;
+
+  // The conditions of feature f are at ['feature_offsets_[f]',
+  // 'feature_offsets_[f + 1]') of the following, in increasing order of
+  // threshold.
+  std::vector<int> feature_offsets_;
+  std::vector<float> thresholds_;
+  std::vector<uint32_t> condition_trees_;
+  std::vector<uint64_t> condition_masks_;
+
+  // The values of the leaves of tree t start at 'tree_leaf_offsets_[t]' of
+  // 'leaf_values_', from left to right.
+  std::vector<int> tree_leaf_offsets_;
+  std::vector<float> leaf_values_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DecisionForestModel);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_DECISION_FOREST_DECISION_FOREST_H_
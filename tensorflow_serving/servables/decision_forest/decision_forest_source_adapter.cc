@@ -0,0 +1,71 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/decision_forest/decision_forest_source_adapter.h"
+
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Loads and compiles the DecisionForest at 'path'.
+Status LoadDecisionForest(const string& path,
+                          std::unique_ptr<DecisionForestModel>* model) {
+  DecisionForest forest;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(Env::Default(), path, &forest));
+  return DecisionForestModel::Create(forest, model);
+}
+
+}  // namespace
+
+DecisionForestSourceAdapter::DecisionForestSourceAdapter(
+    const DecisionForestSourceAdapterConfig& config)
+    : SimpleLoaderSourceAdapter<StoragePath, DecisionForestModel>(
+          [config](const StoragePath& path,
+                   std::unique_ptr<DecisionForestModel>* model) {
+            return LoadDecisionForest(
+                io::JoinPath(path, config.file_name().empty()
+                                       ? kDecisionForestFileName
+                                       : config.file_name()),
+                model);
+          },
+          // Decline to supply a resource footprint estimate.
+          SimpleLoaderSourceAdapter<StoragePath, DecisionForestModel>::
+              EstimateNoResources()) {}
+
+DecisionForestSourceAdapter::~DecisionForestSourceAdapter() { Detach(); }
+
+// Creates the DecisionForestSourceAdapters of the "decision_forest" model
+// platform (see platform_config_util.h).
+class DecisionForestSourceAdapterCreator {
+ public:
+  static Status Create(
+      const DecisionForestSourceAdapterConfig& config,
+      std::unique_ptr<SourceAdapter<StoragePath, std::unique_ptr<Loader>>>*
+          adapter) {
+    adapter->reset(new DecisionForestSourceAdapter(config));
+    return OkStatus();
+  }
+};
+REGISTER_STORAGE_PATH_SOURCE_ADAPTER(DecisionForestSourceAdapterCreator,
+                                     DecisionForestSourceAdapterConfig);
+
+}  // namespace serving
+}  // namespace tensorflow
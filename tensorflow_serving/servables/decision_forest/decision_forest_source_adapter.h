@@ -0,0 +1,48 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_DECISION_FOREST_DECISION_FOREST_SOURCE_ADAPTER_H_
+#define TENSORFLOW_SERVING_SERVABLES_DECISION_FOREST_DECISION_FOREST_SOURCE_ADAPTER_H_
+
+#include "tensorflow_serving/core/simple_loader.h"
+#include "tensorflow_serving/core/source_adapter.h"
+#include "tensorflow_serving/core/storage_path.h"
+#include "tensorflow_serving/servables/decision_forest/decision_forest.h"
+#include "tensorflow_serving/servables/decision_forest/decision_forest_source_adapter.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The default name of the serialized DecisionForest in a version directory.
+constexpr char kDecisionForestFileName[] = "decision_forest.pb";
+
+// A SourceAdapter for decision forests. It takes storage paths of version
+// directories that hold serialized DecisionForest protos, and produces loaders
+// for the forests, compiled into DecisionForestModels.
+class DecisionForestSourceAdapter final
+    : public SimpleLoaderSourceAdapter<StoragePath, DecisionForestModel> {
+ public:
+  explicit DecisionForestSourceAdapter(
+      const DecisionForestSourceAdapterConfig& config);
+  ~DecisionForestSourceAdapter() override;
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(DecisionForestSourceAdapter);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_DECISION_FOREST_DECISION_FOREST_SOURCE_ADAPTER_H_
@@ -0,0 +1,76 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/decision_forest/decision_forest_source_adapter.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow_serving/core/loader.h"
+#include "tensorflow_serving/core/servable_data.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(DecisionForestSourceAdapterTest, Basic) {
+  const string path = io::JoinPath(testing::TmpDir(), "Basic");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(path));
+  TF_ASSERT_OK(WriteBinaryProto(
+      Env::Default(), io::JoinPath(path, "forest.pb"),
+      test_util::CreateProto<DecisionForest>(
+          "features { name: 'a' } "
+          "trees { "
+          "  nodes { feature: 0 threshold: 1 left_child: 1 right_child: 2 } "
+          "  nodes { leaf_value: 1 } "
+          "  nodes { leaf_value: 2 } "
+          "} ")));
+
+  DecisionForestSourceAdapterConfig config;
+  config.set_file_name("forest.pb");
+  auto adapter = std::make_unique<DecisionForestSourceAdapter>(config);
+  ServableData<std::unique_ptr<Loader>> loader_data =
+      adapter->AdaptOneVersion({{"", 0}, path});
+  TF_ASSERT_OK(loader_data.status());
+  std::unique_ptr<Loader> loader = loader_data.ConsumeDataOrDie();
+
+  TF_ASSERT_OK(loader->Load());
+  const DecisionForestModel* model =
+      loader->servable().get<DecisionForestModel>();
+  ASSERT_NE(nullptr, model);
+  const float features[] = {0, 1};
+  float scores[2];
+  model->Score(features, 2, scores);
+  EXPECT_EQ(1, scores[0]);
+  EXPECT_EQ(2, scores[1]);
+  loader->Unload();
+
+  // The default file is missing.
+  adapter = std::make_unique<DecisionForestSourceAdapter>(
+      DecisionForestSourceAdapterConfig());
+  loader_data = adapter->AdaptOneVersion({{"", 0}, path});
+  TF_ASSERT_OK(loader_data.status());
+  loader = loader_data.ConsumeDataOrDie();
+  EXPECT_FALSE(loader->Load().ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
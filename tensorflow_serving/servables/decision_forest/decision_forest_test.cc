@@ -0,0 +1,247 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/decision_forest/decision_forest.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+using test_util::EqualsProto;
+
+// A depth-2 tree on features 'a' and 'b', with leaves 1 to 4 from left to
+// right, and a stump on 'b'.
+constexpr char kForest[] = R"(
+  features { name: "a" missing_value: 0.5 }
+  features { name: "b" missing_value: -1 }
+  trees {
+    nodes { feature: 0 threshold: 1 left_child: 1 right_child: 2 }
+    nodes { feature: 1 threshold: 0 left_child: 3 right_child: 4 }
+    nodes { feature: 1 threshold: 2 left_child: 5 right_child: 6 }
+    nodes { leaf_value: 1 }
+    nodes { leaf_value: 2 }
+    nodes { leaf_value: 3 }
+    nodes { leaf_value: 4 }
+  }
+  trees {
+    nodes { feature: 1 threshold: 0 left_child: 1 right_child: 2 }
+    nodes { leaf_value: 10 }
+    nodes { leaf_value: 20 }
+  }
+  initial_prediction: 100
+)";
+
+// Scores 'example' by walking the trees of 'forest'.
+float WalkForest(const DecisionForest& forest, const float* example) {
+  float score = forest.initial_prediction();
+  for (const DecisionTree& tree : forest.trees()) {
+    const DecisionNode* node = &tree.nodes(0);
+    while (node->left_child() != 0) {
+      node = &tree.nodes(example[node->feature()] < node->threshold()
+                             ? node->left_child()
+                             : node->right_child());
+    }
+    score += node->leaf_value();
+  }
+  return score;
+}
+
+TEST(DecisionForestModelTest, Score) {
+  std::unique_ptr<DecisionForestModel> model;
+  TF_ASSERT_OK(DecisionForestModel::Create(
+      CreateProto<DecisionForest>(kForest), &model));
+  EXPECT_EQ(2, model->num_features());
+  EXPECT_EQ(2, model->num_trees());
+  // Thresholds are inclusive on the right.
+  const std::vector<float> features = {0, -1, 0, 0, 1, 2, 5, 1};
+  std::vector<float> scores(4);
+  model->Score(features.data(), 4, scores.data());
+  EXPECT_THAT(scores, ::testing::ElementsAre(111, 122, 124, 123));
+}
+
+TEST(DecisionForestModelTest, MatchesTreeWalks) {
+  // A random forest of random trees, of up to the most leaves.
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<float> value(-1, 1);
+  DecisionForest forest;
+  constexpr int kNumFeatures = 5;
+  for (int f = 0; f < kNumFeatures; ++f) {
+    forest.add_features()->set_name(strings::StrCat("f", f));
+  }
+  for (int t = 0; t < 20; ++t) {
+    DecisionTree* tree = forest.add_trees();
+    tree->add_nodes()->set_leaf_value(value(generator));
+    // Split random leaves until the tree has its number of leaves.
+    const int num_leaves =
+        1 + t * (DecisionForestModel::kMaxLeavesPerTree - 1) / 19;
+    std::vector<int> leaves = {0};
+    while (static_cast<int>(leaves.size()) < num_leaves) {
+      const int index = generator() % leaves.size();
+      const int node = leaves[index];
+      DecisionNode* split = tree->mutable_nodes(node);
+      split->set_feature(generator() % kNumFeatures);
+      split->set_threshold(value(generator));
+      split->set_left_child(tree->nodes_size());
+      split->set_right_child(tree->nodes_size() + 1);
+      leaves[index] = tree->nodes_size();
+      leaves.push_back(tree->nodes_size() + 1);
+      tree->add_nodes()->set_leaf_value(value(generator));
+      tree->add_nodes()->set_leaf_value(value(generator));
+    }
+  }
+  std::unique_ptr<DecisionForestModel> model;
+  TF_ASSERT_OK(DecisionForestModel::Create(forest, &model));
+
+  constexpr int kNumExamples = 1000;
+  std::vector<float> features(kNumExamples * kNumFeatures);
+  for (float& feature : features) {
+    feature = value(generator);
+  }
+  std::vector<float> scores(kNumExamples);
+  model->Score(features.data(), kNumExamples, scores.data());
+  for (int i = 0; i < kNumExamples; ++i) {
+    EXPECT_FLOAT_EQ(WalkForest(forest, &features[i * kNumFeatures]),
+                    scores[i]);
+  }
+}
+
+TEST(DecisionForestModelTest, InvalidForests) {
+  std::unique_ptr<DecisionForestModel> model;
+  // Unknown feature.
+  EXPECT_FALSE(DecisionForestModel::Create(
+                   CreateProto<DecisionForest>(
+                       "features { name: 'a' } "
+                       "trees { "
+                       "  nodes { feature: 1 left_child: 1 right_child: 2 } "
+                       "  nodes { } nodes { } "
+                       "} "),
+                   &model)
+                   .ok());
+  // Shared and unreachable nodes.
+  EXPECT_FALSE(DecisionForestModel::Create(
+                   CreateProto<DecisionForest>(
+                       "features { name: 'a' } "
+                       "trees { "
+                       "  nodes { left_child: 1 right_child: 1 } "
+                       "  nodes { } "
+                       "} "),
+                   &model)
+                   .ok());
+  EXPECT_FALSE(DecisionForestModel::Create(
+                   CreateProto<DecisionForest>(
+                       "trees { nodes { } nodes { } }"),
+                   &model)
+                   .ok());
+  // Duplicate feature names.
+  EXPECT_FALSE(
+      DecisionForestModel::Create(
+          CreateProto<DecisionForest>("features { name: 'a' } "
+                                      "features { name: 'a' } "),
+          &model)
+          .ok());
+
+  // Too many leaves.
+  DecisionForest forest;
+  forest.add_features()->set_name("a");
+  DecisionTree* tree = forest.add_trees();
+  for (int i = 0; i < DecisionForestModel::kMaxLeavesPerTree; ++i) {
+    DecisionNode* node = tree->add_nodes();
+    node->set_left_child(2 * i + 1);
+    node->set_right_child(2 * i + 2);
+    tree->add_nodes();
+  }
+  tree->add_nodes();
+  EXPECT_FALSE(DecisionForestModel::Create(forest, &model).ok());
+  tree->mutable_nodes()->RemoveLast();
+  tree->mutable_nodes()->RemoveLast();
+  tree->mutable_nodes(tree->nodes_size() - 1)->clear_left_child();
+  tree->mutable_nodes(tree->nodes_size() - 1)->clear_right_child();
+  TF_EXPECT_OK(DecisionForestModel::Create(forest, &model));
+}
+
+TEST(DecisionForestModelTest, Regress) {
+  std::unique_ptr<DecisionForestModel> model;
+  TF_ASSERT_OK(DecisionForestModel::Create(
+      CreateProto<DecisionForest>(kForest), &model));
+  // Missing features come from the context, else their missing value.
+  const Input input = CreateProto<Input>(R"(
+    example_list_with_context {
+      examples {
+        features { feature { key: "a" value { float_list { value: 2 } } } }
+      }
+      examples {
+        features { feature { key: "b" value { int64_list { value: 3 } } } }
+      }
+      context {
+        features { feature { key: "b" value { float_list { value: 1 } } } }
+      }
+    }
+  )");
+  RegressionResult result;
+  TF_ASSERT_OK(model->Regress(input, &result));
+  EXPECT_THAT(result, EqualsProto("regressions { value: 123 } "
+                                  "regressions { value: 122 } "));
+
+  ClassificationResult classification;
+  EXPECT_FALSE(model->Classify(input, &classification).ok());
+  EXPECT_FALSE(model->Regress(Input(), &result).ok());
+  EXPECT_FALSE(model->Regress(CreateProto<Input>(R"(
+    example_list {
+      examples {
+        features { feature { key: "a" value { float_list { value: [1, 2] } } } }
+      }
+    }
+  )"),
+                              &result)
+                   .ok());
+}
+
+TEST(DecisionForestModelTest, Classify) {
+  DecisionForest forest = CreateProto<DecisionForest>(kForest);
+  forest.set_task(DecisionForest::BINARY_CLASSIFICATION);
+  forest.set_initial_prediction(-11);
+  forest.add_class_labels("no");
+  forest.add_class_labels("yes");
+  std::unique_ptr<DecisionForestModel> model;
+  TF_ASSERT_OK(DecisionForestModel::Create(forest, &model));
+  ClassificationResult result;
+  TF_ASSERT_OK(model->Classify(CreateProto<Input>(R"(
+    example_list {
+      examples {
+        features { feature { key: "b" value { float_list { value: -1 } } } }
+      }
+    }
+  )"),
+                               &result));
+  EXPECT_THAT(result, EqualsProto("classifications { "
+                                  "  classes { label: 'no' score: 0.5 } "
+                                  "  classes { label: 'yes' score: 0.5 } "
+                                  "} "));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
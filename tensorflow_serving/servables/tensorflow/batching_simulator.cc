@@ -0,0 +1,278 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/batching_simulator.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow_serving/batching/batching_session.h"
+#include "tensorflow_serving/servables/tensorflow/bundle_factory_util.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr char kInputName[] = "x";
+constexpr char kOutputName[] = "y";
+
+// A session that takes as long to run a batch as the cost model of
+// BatchingSimulatorOptions says, returns its input "x" as output "y", and
+// records the sizes of the batches.
+class CostModelSession : public ServingSession {
+ public:
+  explicit CostModelSession(const BatchingSimulatorOptions& options)
+      : options_(options) {}
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    RunMetadata run_metadata;
+    return Run(RunOptions(), inputs, output_tensor_names, target_node_names,
+               outputs, &run_metadata);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    if (inputs.size() != 1 || inputs[0].first != kInputName ||
+        output_tensor_names.size() != 1 ||
+        output_tensor_names[0] != kOutputName) {
+      return errors::InvalidArgument(
+          "The simulated model maps input 'x' to output 'y'");
+    }
+    const Tensor& input = inputs[0].second;
+    Env::Default()->SleepForMicroseconds(
+        options_.batch_overhead_micros +
+        static_cast<int64_t>(options_.micros_per_element *
+                             input.NumElements()));
+    {
+      mutex_lock l(mu_);
+      ++num_batches_;
+      num_rows_ += input.dim_size(0);
+      num_elements_ += input.NumElements();
+    }
+    outputs->push_back(input);
+    return OkStatus();
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    return Run(run_options, inputs, output_tensor_names, target_node_names,
+               outputs, run_metadata);
+  }
+
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return errors::Unimplemented("ListDevices");
+  }
+
+  int64_t num_batches() const {
+    mutex_lock l(mu_);
+    return num_batches_;
+  }
+
+  int64_t num_rows() const {
+    mutex_lock l(mu_);
+    return num_rows_;
+  }
+
+  int64_t num_elements() const {
+    mutex_lock l(mu_);
+    return num_elements_;
+  }
+
+ private:
+  const BatchingSimulatorOptions options_;
+
+  mutable mutex mu_;
+  int64_t num_batches_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_rows_ TF_GUARDED_BY(mu_) = 0;
+  int64_t num_elements_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// Returns the 'fraction' percentile of 'sorted_values', which must not be
+// empty.
+int64_t Percentile(const std::vector<int64_t>& sorted_values,
+                   double fraction) {
+  const size_t index = std::min(
+      sorted_values.size() - 1,
+      static_cast<size_t>(fraction * sorted_values.size()));
+  return sorted_values[index];
+}
+
+}  // namespace
+
+Status SimulateBatching(const BatchingParameters& batching_params,
+                        const BatchingSimulatorOptions& options,
+                        const std::vector<BatchingTraceRequest>& trace,
+                        BatchingSimulationResult* result) {
+  if (options.num_client_threads <= 0) {
+    return errors::InvalidArgument("num_client_threads must be positive; was ",
+                                   options.num_client_threads);
+  }
+  for (int i = 0; i < trace.size(); ++i) {
+    if (trace[i].num_rows <= 0 || trace[i].sequence_length <= 0) {
+      return errors::InvalidArgument(
+          "Trace request ", i, " must have a positive shape; was [",
+          trace[i].num_rows, ", ", trace[i].sequence_length, "]");
+    }
+    if (i > 0 && trace[i].arrival_micros < trace[i - 1].arrival_micros) {
+      return errors::InvalidArgument(
+          "The trace must be sorted by arrival time; request ", i,
+          " arrives before request ", i - 1);
+    }
+  }
+
+  std::shared_ptr<SharedBatchScheduler<BatchingSessionTask>> batch_scheduler;
+  TF_RETURN_IF_ERROR(CreateBatchScheduler<BatchingSessionTask>(
+      batching_params, &batch_scheduler));
+  auto* cost_model_session = new CostModelSession(options);
+  std::unique_ptr<Session> session(cost_model_session);
+  SignatureDef signature;
+  (*signature.mutable_inputs())[kInputName].set_name(kInputName);
+  (*signature.mutable_outputs())[kOutputName].set_name(kOutputName);
+  TF_RETURN_IF_ERROR(WrapSessionForBatching(batching_params, batch_scheduler,
+                                            {signature}, &session));
+
+  mutex mu;
+  std::vector<int64_t> latencies_micros;
+  int64_t num_failed_requests = 0;
+  Env* const env = Env::Default();
+  const uint64_t start_micros = env->NowMicros();
+  {
+    thread::ThreadPool client_threads(env, "batching_simulator_clients",
+                                      options.num_client_threads);
+    for (const BatchingTraceRequest& request : trace) {
+      const uint64_t arrival_micros = start_micros + request.arrival_micros;
+      const uint64_t now_micros = env->NowMicros();
+      if (arrival_micros > now_micros) {
+        env->SleepForMicroseconds(arrival_micros - now_micros);
+      }
+      client_threads.Schedule([&, request, arrival_micros] {
+        Tensor input(DT_FLOAT,
+                     TensorShape({request.num_rows, request.sequence_length}));
+        input.flat<float>().setZero();
+        std::vector<Tensor> outputs;
+        const Status status =
+            session->Run({{kInputName, input}}, {kOutputName}, {}, &outputs);
+        const int64_t latency_micros = env->NowMicros() - arrival_micros;
+        mutex_lock l(mu);
+        if (status.ok()) {
+          latencies_micros.push_back(latency_micros);
+        } else {
+          ++num_failed_requests;
+        }
+      });
+    }
+    // The thread pool destructor waits for the requests to finish.
+  }
+  const uint64_t end_micros = env->NowMicros();
+
+  *result = BatchingSimulationResult();
+  result->num_requests = trace.size();
+  result->num_failed_requests = num_failed_requests;
+  if (end_micros > start_micros) {
+    result->throughput_requests_per_second =
+        1e6 * latencies_micros.size() / (end_micros - start_micros);
+  }
+  if (!latencies_micros.empty()) {
+    std::sort(latencies_micros.begin(), latencies_micros.end());
+    result->latency_p50_micros = Percentile(latencies_micros, 0.5);
+    result->latency_p90_micros = Percentile(latencies_micros, 0.9);
+    result->latency_p99_micros = Percentile(latencies_micros, 0.99);
+    result->latency_max_micros = latencies_micros.back();
+  }
+
+  result->num_batches = cost_model_session->num_batches();
+  const int64_t max_batch_size =
+      batching_params.has_max_batch_size()
+          ? batching_params.max_batch_size().value()
+          : SharedBatchScheduler<BatchingSessionTask>::QueueOptions()
+                .input_batch_size_limit;
+  if (result->num_batches > 0 && max_batch_size > 0) {
+    result->mean_batch_fill =
+        static_cast<double>(cost_model_session->num_rows()) /
+        (result->num_batches * max_batch_size);
+  }
+  int64_t num_request_elements = 0;
+  for (const BatchingTraceRequest& request : trace) {
+    num_request_elements += request.num_rows * request.sequence_length;
+  }
+  const int64_t num_processed_elements = cost_model_session->num_elements();
+  if (num_processed_elements > 0) {
+    result->padding_waste = std::max(
+        0.0, 1.0 - static_cast<double>(num_request_elements) /
+                       num_processed_elements);
+  }
+  return OkStatus();
+}
+
+Status BatchingTraceFromPredictionLogs(
+    const std::vector<PredictionLog>& logs, const string& input_name,
+    double requests_per_second, std::vector<BatchingTraceRequest>* trace) {
+  if (requests_per_second <= 0) {
+    return errors::InvalidArgument(
+        "requests_per_second must be positive; was ", requests_per_second);
+  }
+  trace->clear();
+  for (const PredictionLog& log : logs) {
+    if (!log.has_predict_log()) {
+      continue;
+    }
+    const auto& inputs = log.predict_log().request().inputs();
+    auto it = inputs.find(input_name);
+    if (it == inputs.end()) {
+      return errors::InvalidArgument("Logged request has no input ",
+                                     input_name);
+    }
+    const TensorShapeProto& shape = it->second.tensor_shape();
+    if (shape.dim_size() == 0) {
+      return errors::InvalidArgument("Input ", input_name,
+                                     " of a logged request is a scalar");
+    }
+    BatchingTraceRequest request;
+    request.arrival_micros =
+        static_cast<int64_t>(1e6 * trace->size() / requests_per_second);
+    request.num_rows = shape.dim(0).size();
+    for (int d = 1; d < shape.dim_size(); ++d) {
+      request.sequence_length =
+          std::max<int64_t>(request.sequence_length, shape.dim(d).size());
+    }
+    trace->push_back(request);
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,109 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_BATCHING_SIMULATOR_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_BATCHING_SIMULATOR_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Utilities for choosing batching parameters offline: a dry run replays an
+// arrival trace of requests against a BatchingSession, configured by a
+// BatchingParameters as in the model server, that wraps a mock session whose
+// processing time follows a simple cost model. No model is loaded.
+
+// One request of an arrival trace. Each request has a single input, of shape
+// [num_rows, sequence_length].
+struct BatchingTraceRequest {
+  // The time at which the request arrives, relative to the start of the trace.
+  int64_t arrival_micros = 0;
+
+  // The size of the 0th (batch) dimension of the request's input.
+  int64_t num_rows = 1;
+
+  // The size of the other dimension of the request's input. Requests with
+  // different sizes are only batchable if 'pad_variable_length_inputs' is set
+  // in the batching parameters.
+  int64_t sequence_length = 1;
+};
+
+// The cost model of the mock session, and the replay setup.
+struct BatchingSimulatorOptions {
+  // The time to process a batch is 'batch_overhead_micros' plus
+  // 'micros_per_element' times the number of elements of the merged input,
+  // including padding.
+  int64_t batch_overhead_micros = 1000;
+  double micros_per_element = 1.0;
+
+  // The number of client threads that issue the requests. A request that
+  // arrives while all of them are busy waits for one, and the wait counts into
+  // its latency, as it would for an open-loop load. Should be at least the
+  // number of expected concurrent requests.
+  int num_client_threads = 64;
+};
+
+// The outcome of a dry run. Latencies count from a request's arrival time in
+// the trace until its Run() call returns.
+struct BatchingSimulationResult {
+  int64_t num_requests = 0;
+  int64_t num_failed_requests = 0;
+
+  // Successful requests per second of wall time, over the whole replay.
+  double throughput_requests_per_second = 0;
+
+  int64_t latency_p50_micros = 0;
+  int64_t latency_p90_micros = 0;
+  int64_t latency_p99_micros = 0;
+  int64_t latency_max_micros = 0;
+
+  int64_t num_batches = 0;
+
+  // The mean size of the processed batches (including padding rows) as a
+  // fraction of 'max_batch_size'.
+  double mean_batch_fill = 0;
+
+  // The fraction of the processed input elements that are padding, whether
+  // added to reach an allowed batch size or to equalize sequence lengths.
+  double padding_waste = 0;
+};
+
+// Replays 'trace', which must be sorted by arrival time, in real time against
+// a BatchingSession with the given batching parameters wrapping the mock
+// session of 'options', and sets 'result'. Blocks until all requests are done,
+// i.e. for roughly the duration of the trace.
+Status SimulateBatching(const BatchingParameters& batching_params,
+                        const BatchingSimulatorOptions& options,
+                        const std::vector<BatchingTraceRequest>& trace,
+                        BatchingSimulationResult* result);
+
+// Builds an arrival trace from logged Predict requests (see PredictionLog),
+// taking the shape of each request from its input 'input_name'. Since the logs
+// carry no timestamps, the requests arrive at the constant rate
+// 'requests_per_second', in log order. Logs of other types are skipped.
+Status BatchingTraceFromPredictionLogs(
+    const std::vector<PredictionLog>& logs, const string& input_name,
+    double requests_per_second, std::vector<BatchingTraceRequest>* trace);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_BATCHING_SIMULATOR_H_
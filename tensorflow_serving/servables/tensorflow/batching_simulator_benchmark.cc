@@ -0,0 +1,111 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Run with:
+// bazel run -c opt --dynamic_mode=off \
+// tensorflow_serving/servables/tensorflow:batching_simulator_benchmark --
+// --benchmarks=.
+//
+// Each benchmark replays one second of synthetic Poisson traffic against the
+// batching parameters given by its arguments, and reports the latency
+// percentiles, batch fill and padding waste of the replay as counters. To
+// evaluate your own parameters, replay a trace of your traffic (e.g. built
+// with BatchingTraceFromPredictionLogs()) with SimulateBatching() instead.
+
+#include <cmath>
+#include <vector>
+
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow_serving/servables/tensorflow/batching_simulator.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr int kRequestsPerSecond = 2000;
+constexpr int kTraceDurationMicros = 1000 * 1000;
+constexpr int kMaxSequenceLength = 64;
+
+// Returns a trace of single-row requests with exponentially distributed
+// inter-arrival times and uniformly distributed sequence lengths.
+std::vector<BatchingTraceRequest> PoissonTrace() {
+  random::PhiloxRandom philox(/*seed=*/42);
+  random::SimplePhilox random(&philox);
+  std::vector<BatchingTraceRequest> trace;
+  double arrival_micros = 0;
+  while (true) {
+    arrival_micros -=
+        std::log(1.0 - random.RandDouble()) * 1e6 / kRequestsPerSecond;
+    if (arrival_micros >= kTraceDurationMicros) {
+      break;
+    }
+    BatchingTraceRequest request;
+    request.arrival_micros = static_cast<int64_t>(arrival_micros);
+    request.sequence_length = 1 + random.Uniform(kMaxSequenceLength);
+    trace.push_back(request);
+  }
+  return trace;
+}
+
+void BM_SimulateBatching(::testing::benchmark::State& state) {
+  const int max_batch_size = state.range(0);
+  const int batch_timeout_micros = state.range(1);
+  BatchingParameters batching_params;
+  batching_params.mutable_max_batch_size()->set_value(max_batch_size);
+  batching_params.mutable_batch_timeout_micros()->set_value(
+      batch_timeout_micros);
+  batching_params.mutable_num_batch_threads()->set_value(4);
+  batching_params.mutable_max_enqueued_batches()->set_value(1000);
+  batching_params.set_pad_variable_length_inputs(true);
+
+  BatchingSimulatorOptions options;
+  options.batch_overhead_micros = 2000;
+  options.micros_per_element = 0.5;
+
+  static const std::vector<BatchingTraceRequest>* const trace =
+      new std::vector<BatchingTraceRequest>(PoissonTrace());
+  BatchingSimulationResult result;
+  for (auto s : state) {
+    TF_CHECK_OK(SimulateBatching(batching_params, options, *trace, &result));
+  }
+  state.counters["p50_latency_us"] = result.latency_p50_micros;
+  state.counters["p99_latency_us"] = result.latency_p99_micros;
+  state.counters["batch_fill"] = result.mean_batch_fill;
+  state.counters["padding_waste"] = result.padding_waste;
+  state.counters["failed"] = result.num_failed_requests;
+  state.SetItemsProcessed(state.iterations() * trace->size());
+}
+BENCHMARK(BM_SimulateBatching)
+    ->UseRealTime()
+    ->ArgPair(8, 1000)
+    ->ArgPair(8, 5000)
+    ->ArgPair(32, 1000)
+    ->ArgPair(32, 5000)
+    ->ArgPair(128, 5000);
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  tensorflow::testing::RunBenchmarks();
+  return 0;
+}
@@ -0,0 +1,136 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/batching_simulator.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+BatchingSimulatorOptions FreeCostModel() {
+  BatchingSimulatorOptions options;
+  options.batch_overhead_micros = 0;
+  options.micros_per_element = 0;
+  return options;
+}
+
+std::vector<BatchingTraceRequest> SimultaneousRequests(
+    const std::vector<int64_t>& sequence_lengths) {
+  std::vector<BatchingTraceRequest> trace;
+  for (const int64_t sequence_length : sequence_lengths) {
+    BatchingTraceRequest request;
+    request.sequence_length = sequence_length;
+    trace.push_back(request);
+  }
+  return trace;
+}
+
+TEST(BatchingSimulatorTest, FullBatches) {
+  const BatchingParameters batching_params = CreateProto<BatchingParameters>(
+      "max_batch_size { value: 4 } "
+      "batch_timeout_micros { value: 10000000 } "
+      "num_batch_threads { value: 1 }");
+  BatchingSimulationResult result;
+  TF_ASSERT_OK(SimulateBatching(batching_params, FreeCostModel(),
+                                SimultaneousRequests({1, 1, 1, 1, 1, 1, 1, 1}),
+                                &result));
+  EXPECT_EQ(8, result.num_requests);
+  EXPECT_EQ(0, result.num_failed_requests);
+  EXPECT_EQ(2, result.num_batches);
+  EXPECT_DOUBLE_EQ(1.0, result.mean_batch_fill);
+  EXPECT_DOUBLE_EQ(0.0, result.padding_waste);
+  EXPECT_GT(result.throughput_requests_per_second, 0);
+  EXPECT_LE(result.latency_p50_micros, result.latency_p99_micros);
+  EXPECT_LE(result.latency_p99_micros, result.latency_max_micros);
+}
+
+TEST(BatchingSimulatorTest, PaddingToAllowedBatchSize) {
+  const BatchingParameters batching_params = CreateProto<BatchingParameters>(
+      "max_batch_size { value: 4 } "
+      "batch_timeout_micros { value: 10000 } "
+      "num_batch_threads { value: 1 } "
+      "allowed_batch_sizes: 2 "
+      "allowed_batch_sizes: 4");
+  BatchingSimulationResult result;
+  TF_ASSERT_OK(SimulateBatching(batching_params, FreeCostModel(),
+                                SimultaneousRequests({1, 1, 1}), &result));
+  EXPECT_EQ(0, result.num_failed_requests);
+  EXPECT_EQ(1, result.num_batches);
+  // The batch of three rows is padded to four.
+  EXPECT_DOUBLE_EQ(1.0, result.mean_batch_fill);
+  EXPECT_DOUBLE_EQ(0.25, result.padding_waste);
+}
+
+TEST(BatchingSimulatorTest, PaddingOfVariableLengthInputs) {
+  const BatchingParameters batching_params = CreateProto<BatchingParameters>(
+      "max_batch_size { value: 4 } "
+      "batch_timeout_micros { value: 10000000 } "
+      "num_batch_threads { value: 1 } "
+      "pad_variable_length_inputs: true");
+  BatchingSimulationResult result;
+  TF_ASSERT_OK(SimulateBatching(batching_params, FreeCostModel(),
+                                SimultaneousRequests({1, 3, 3, 1}), &result));
+  EXPECT_EQ(0, result.num_failed_requests);
+  EXPECT_EQ(1, result.num_batches);
+  // Two of the rows are padded from one to three elements.
+  EXPECT_DOUBLE_EQ(4.0 / 12, result.padding_waste);
+}
+
+TEST(BatchingSimulatorTest, InvalidTrace) {
+  const BatchingParameters batching_params;
+  BatchingSimulationResult result;
+  std::vector<BatchingTraceRequest> trace = SimultaneousRequests({1, 1});
+  trace[0].arrival_micros = 100;
+  EXPECT_FALSE(
+      SimulateBatching(batching_params, FreeCostModel(), trace, &result).ok());
+  trace = SimultaneousRequests({0});
+  EXPECT_FALSE(
+      SimulateBatching(batching_params, FreeCostModel(), trace, &result).ok());
+}
+
+TEST(BatchingSimulatorTest, TraceFromPredictionLogs) {
+  std::vector<PredictionLog> logs = {
+      CreateProto<PredictionLog>(
+          "predict_log { request { inputs { key: 'x' value { "
+          "tensor_shape { dim { size: 2 } dim { size: 7 } } } } } }"),
+      CreateProto<PredictionLog>("classify_log {}"),
+      CreateProto<PredictionLog>(
+          "predict_log { request { inputs { key: 'x' value { "
+          "tensor_shape { dim { size: 3 } } } } } }")};
+  std::vector<BatchingTraceRequest> trace;
+  TF_ASSERT_OK(BatchingTraceFromPredictionLogs(
+      logs, "x", /*requests_per_second=*/1000, &trace));
+  ASSERT_EQ(2, trace.size());
+  EXPECT_EQ(0, trace[0].arrival_micros);
+  EXPECT_EQ(2, trace[0].num_rows);
+  EXPECT_EQ(7, trace[0].sequence_length);
+  EXPECT_EQ(1000, trace[1].arrival_micros);
+  EXPECT_EQ(3, trace[1].num_rows);
+  EXPECT_EQ(1, trace[1].sequence_length);
+
+  EXPECT_FALSE(BatchingTraceFromPredictionLogs(logs, "y", 1000, &trace).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
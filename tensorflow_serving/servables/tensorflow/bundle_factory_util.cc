@@ -15,18 +15,36 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/bundle_factory_util.h"
 
+#include <algorithm>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "google/protobuf/wrappers.pb.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/kernels/batching_util/batch_scheduler.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow_serving/batching/adaptive_timeout_batch_scheduler.h"
+#include "tensorflow_serving/batching/batch_scheduler_retrier.h"
 #include "tensorflow_serving/batching/batching_session.h"
+#include "tensorflow_serving/batching/batching_util.h"
+#include "tensorflow_serving/batching/deadline_admission_batch_scheduler.h"
+#include "tensorflow_serving/batching/reconfigurable_batch_scheduler.h"
+#include "tensorflow_serving/batching/streaming_batch_scheduler.h"
 #include "tensorflow_serving/resources/resource_values.h"
 #include "tensorflow_serving/servables/tensorflow/serving_session.h"
 #include "tensorflow_serving/util/proto_util.h"
@@ -40,17 +58,161 @@ using Batcher = SharedBatchScheduler<BatchingSessionTask>;
 
 const char kBatchingParamsFilename[] = "batching_params.pbtxt";
 
+// Adds the 'allowed_batch_sizes' of the BatchFunction ops among 'nodes' to
+// 'batch_sizes'.
+template <typename Nodes>
+void AddBatchFunctionSizes(const Nodes& nodes, std::set<int64_t>* batch_sizes) {
+  for (const NodeDef& node : nodes) {
+    if (node.op() != "BatchFunction") {
+      continue;
+    }
+    auto attr = node.attr().find("allowed_batch_sizes");
+    if (attr == node.attr().end()) {
+      continue;
+    }
+    for (const int64_t batch_size : attr->second.list().i()) {
+      batch_sizes->insert(batch_size);
+    }
+  }
+}
+
+// Forwards to the batch queue of a signature of a model, and reports the fill
+// of the queue as the "batch_queue" saturation signal of the model while it
+// lives.
+class SaturationReportingBatchScheduler
+    : public BatchScheduler<BatchingSessionTask> {
+ public:
+  SaturationReportingBatchScheduler(
+      const string& model_name,
+      std::unique_ptr<BatchScheduler<BatchingSessionTask>> wrapped)
+      : wrapped_(std::move(wrapped)) {
+    BatchScheduler<BatchingSessionTask>* const queue = wrapped_.get();
+    // The queue is empty, so has all of its capacity.
+    const double capacity = queue->SchedulingCapacity();
+    registration_ = SaturationMonitor::Global()->Register(
+        model_name, "batch_queue", [queue, capacity]() {
+          return capacity > 0 ? 1 - queue->SchedulingCapacity() / capacity
+                              : 0.0;
+        });
+  }
+
+  ~SaturationReportingBatchScheduler() override = default;
+
+  Status Schedule(std::unique_ptr<BatchingSessionTask>* task) override {
+    return wrapped_->Schedule(task);
+  }
+
+  size_t NumEnqueuedTasks() const override {
+    return wrapped_->NumEnqueuedTasks();
+  }
+
+  size_t SchedulingCapacity() const override {
+    return wrapped_->SchedulingCapacity();
+  }
+
+  size_t max_task_size() const override { return wrapped_->max_task_size(); }
+
+ private:
+  const std::unique_ptr<BatchScheduler<BatchingSessionTask>> wrapped_;
+  // Declared after 'wrapped_', to be unregistered before it is destroyed.
+  std::unique_ptr<SaturationMonitor::Registration> registration_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SaturationReportingBatchScheduler);
+};
+
 bool BatchingParamsFound(const string& model_dir) {
   const string& fname = io::JoinPath(model_dir, kBatchingParamsFilename);
   return Env::Default()->FilesExist({fname}, nullptr);
 }
 
+// Adds to 'ragged_tensors' the tensor names of the 'aliases' found among the
+// inputs, or among the outputs, of each of 'signatures'.
+void AddRaggedTensorNames(
+    const protobuf::RepeatedPtrField<RaggedTensorAliases>& aliases,
+    const std::vector<SignatureDef>& signatures,
+    std::vector<RaggedTensorNames>* ragged_tensors) {
+  std::set<std::pair<string, string>> added;
+  for (const SignatureDef& signature : signatures) {
+    for (const auto* tensors : {&signature.inputs(), &signature.outputs()}) {
+      for (const RaggedTensorAliases& ragged_aliases : aliases) {
+        auto values = tensors->find(ragged_aliases.values());
+        auto row_splits = tensors->find(ragged_aliases.row_splits());
+        if (values == tensors->end() || row_splits == tensors->end()) {
+          continue;
+        }
+        RaggedTensorNames names;
+        names.values = values->second.name();
+        names.row_splits = row_splits->second.name();
+        if (added.emplace(names.values, names.row_splits).second) {
+          ragged_tensors->push_back(std::move(names));
+        }
+      }
+    }
+  }
+}
+
+// The resource estimates of the model versions last estimated from their
+// paths by EstimateResourceFromPath(), by path and 'use_validation_result'.
+// The files of a version do not change once it is exported, so they are only
+// walked for its first estimate, rather than for each (e.g. before and after
+// its load, and on retries), which takes a while for models of many files on
+// remote file systems.
+//
+// This class is thread-safe.
+class ResourceEstimateCache {
+ public:
+  using Key = std::pair<string, bool>;
+
+  static ResourceEstimateCache* Global() {
+    static ResourceEstimateCache* const cache = new ResourceEstimateCache;
+    return cache;
+  }
+
+  bool Lookup(const Key& key, ResourceAllocation* estimate)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    auto it = estimates_.find(key);
+    if (it == estimates_.end()) {
+      return false;
+    }
+    *estimate = it->second;
+    return true;
+  }
+
+  void Insert(const Key& key, const ResourceAllocation& estimate)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    if (!estimates_.emplace(key, estimate).second) {
+      return;
+    }
+    insertion_order_.push_back(key);
+    if (insertion_order_.size() > kCapacity) {
+      estimates_.erase(insertion_order_.front());
+      insertion_order_.pop_front();
+    }
+  }
+
+ private:
+  // The most versions whose estimates are kept, evicting the oldest first.
+  static constexpr int kCapacity = 1024;
+
+  ResourceEstimateCache() = default;
+
+  mutex mu_;
+  std::map<Key, ResourceAllocation> estimates_ TF_GUARDED_BY(mu_);
+  std::deque<Key> insertion_order_ TF_GUARDED_BY(mu_);
+};
+
 }  // namespace
 
 SessionOptions GetSessionOptions(const SessionBundleConfig& config) {
   SessionOptions options;
   options.target = config.session_target();
   options.config = config.session_config();
+  if (config.session_thread_cpus_size() > 0) {
+    options.env = CpuSetEnv::ForCpus({config.session_thread_cpus().begin(),
+                                      config.session_thread_cpus().end()});
+  }
   return options;
 }
 
@@ -85,6 +247,88 @@ Status GetPerModelBatchingParams(const string& path,
   return OkStatus();
 }
 
+std::vector<int64_t> GetCompiledBatchSizes(const MetaGraphDef& meta_graph_def) {
+  std::set<int64_t> batch_sizes;
+  AddBatchFunctionSizes(meta_graph_def.graph_def().node(), &batch_sizes);
+  for (const FunctionDef& function :
+       meta_graph_def.graph_def().library().function()) {
+    AddBatchFunctionSizes(function.node_def(), &batch_sizes);
+  }
+  return std::vector<int64_t>(batch_sizes.begin(), batch_sizes.end());
+}
+
+int64_t CountGraphNodes(const MetaGraphDef& meta_graph_def) {
+  int64_t num_nodes = meta_graph_def.graph_def().node_size();
+  for (const FunctionDef& function :
+       meta_graph_def.graph_def().library().function()) {
+    num_nodes += function.node_def_size();
+  }
+  return num_nodes;
+}
+
+void ApplyTpuBatchingProfile(const std::vector<int64_t>& compiled_batch_sizes,
+                             BatchingParameters* params) {
+  if (!params->tpu_batching_profile()) {
+    return;
+  }
+  if (params->allowed_batch_sizes().empty() && !compiled_batch_sizes.empty()) {
+    for (const int64_t batch_size : compiled_batch_sizes) {
+      params->add_allowed_batch_sizes(batch_size);
+    }
+    // The batches, or the splits of larger ones, fill up to the largest
+    // compiled batch size.
+    params->mutable_max_batch_size()->set_value(compiled_batch_sizes.back());
+    if (params->has_max_execution_batch_size()) {
+      params->mutable_max_execution_batch_size()->set_value(
+          compiled_batch_sizes.back());
+    }
+  }
+  if (!params->padded_dim_bucket_boundaries().empty()) {
+    params->set_pad_variable_length_inputs(true);
+    params->set_pad_to_bucket_boundaries(true);
+  }
+}
+
+UtilizationMeter* BatchThreadUtilizationMeter() {
+  static UtilizationMeter* const meter = []() {
+    auto* const meter =
+        new UtilizationMeter(Batcher::Options().num_batch_threads);
+    // Stays registered for the rest of the process, like the meter.
+    SaturationMonitor::Global()
+        ->Register("", "batch_threads",
+                   [meter]() { return meter->TakeUtilization(); })
+        .release();
+    return meter;
+  }();
+  return meter;
+}
+
+Status SetWarmupBatchSizes(const string& path,
+                           const BatchingParameters& common_params,
+                           bool per_model_configured,
+                           ModelWarmupOptions* warmup_options) {
+  if (!warmup_options->enable_allowed_batch_sizes_warmup() ||
+      !warmup_options->batch_sizes().empty()) {
+    return OkStatus();
+  }
+  absl::optional<BatchingParameters> params;
+  TF_RETURN_IF_ERROR(GetPerModelBatchingParams(path, common_params,
+                                               per_model_configured, &params));
+  if (!params.has_value()) {
+    return OkStatus();
+  }
+  if (!params->allowed_batch_sizes().empty()) {
+    *warmup_options->mutable_batch_sizes() = params->allowed_batch_sizes();
+  } else if (params->task_cost_model() == BatchingParameters::ROWS) {
+    // (Under other cost models the max batch size is not a number of rows.)
+    warmup_options->add_batch_sizes(
+        params->has_max_batch_size()
+            ? params->max_batch_size().value()
+            : Batcher::QueueOptions().input_batch_size_limit);
+  }
+  return OkStatus();
+}
+
 Status EstimateResourceFromValidationResult(const string& path,
                                             ResourceAllocation* estimate) {
   return EstimateMainRamBytesFromValidationResult(path, estimate);
@@ -92,25 +336,47 @@ Status EstimateResourceFromValidationResult(const string& path,
 
 Status EstimateResourceFromPath(const string& path, bool use_validation_result,
                                 ResourceAllocation* estimate) {
+  const ResourceEstimateCache::Key key(path, use_validation_result);
+  if (ResourceEstimateCache::Global()->Lookup(key, estimate)) {
+    return OkStatus();
+  }
   TensorflowFileProbingEnv env(Env::Default());
-  return EstimateMainRamBytesFromPath(path, use_validation_result, &env,
-                                      estimate);
+  TF_RETURN_IF_ERROR(EstimateMainRamBytesFromPath(path, use_validation_result,
+                                                  &env, estimate));
+  ResourceEstimateCache::Global()->Insert(key, *estimate);
+  return OkStatus();
 }
 
 Status WrapSessionForBatching(const BatchingParameters& batching_config,
                               std::shared_ptr<Batcher> batch_scheduler,
                               const std::vector<SignatureDef>& signatures,
                               std::unique_ptr<Session>* session) {
-  LOG(INFO) << "Wrapping session to perform batch processing";
+  return WrapSessionForBatching(batching_config, std::move(batch_scheduler),
+                                /*fair_batch_gate=*/nullptr,
+                                /*queue_name=*/"", signatures, session);
+}
 
-  if (batch_scheduler == nullptr) {
-    return errors::Internal("batch_scheduler not set");
-  }
-  if (*session == nullptr) {
-    return errors::Internal("session not set");
-  }
+Status WrapSessionForBatching(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<Batcher> batch_scheduler,
+    std::shared_ptr<WeightedFairBatchGate> fair_batch_gate,
+    const string& queue_name, const std::vector<SignatureDef>& signatures,
+    std::unique_ptr<Session>* session) {
+  return WrapSessionForBatching(batching_config, std::move(batch_scheduler),
+                                std::move(fair_batch_gate), queue_name,
+                                /*batch_input_allocator=*/nullptr, signatures,
+                                session);
+}
 
-  if (!batching_config.allowed_batch_sizes().empty()) {
+namespace {
+
+// Returns an error if the allowed batch sizes of 'batching_config' do not end
+// with its max batch size.
+Status ValidateAllowedBatchSizes(const BatchingParameters& batching_config) {
+  // With a task cost model other than rows, the batch size limits are not in
+  // rows, so they cannot be checked against 'allowed_batch_sizes'.
+  if (!batching_config.allowed_batch_sizes().empty() &&
+      batching_config.task_cost_model() == BatchingParameters::ROWS) {
     // Verify that the last allowed batch size matches the max batch size.
     const int last_allowed_size = batching_config.allowed_batch_sizes(
         batching_config.allowed_batch_sizes().size() - 1);
@@ -124,7 +390,44 @@ Status WrapSessionForBatching(const BatchingParameters& batching_config,
           last_allowed_size, "; expected ", max_size);
     }
   }
+  return OkStatus();
+}
+
+// Overrides the fields of 'params' that are set in 'live_params', of those
+// that UpdateLiveBatchingParameters() can change.
+void ApplyLiveBatchingParameters(const BatchingParameters& live_params,
+                                 BatchingParameters* params) {
+  if (live_params.has_max_batch_size()) {
+    *params->mutable_max_batch_size() = live_params.max_batch_size();
+  }
+  if (live_params.has_batch_timeout_micros()) {
+    *params->mutable_batch_timeout_micros() =
+        live_params.batch_timeout_micros();
+  }
+  if (live_params.has_max_enqueued_batches()) {
+    *params->mutable_max_enqueued_batches() =
+        live_params.max_enqueued_batches();
+  }
+  if (live_params.has_max_execution_batch_size()) {
+    *params->mutable_max_execution_batch_size() =
+        live_params.max_execution_batch_size();
+  }
+  if (live_params.has_num_batch_threads()) {
+    *params->mutable_num_batch_threads() = live_params.num_batch_threads();
+  }
+  if (!live_params.allowed_batch_sizes().empty()) {
+    *params->mutable_allowed_batch_sizes() = live_params.allowed_batch_sizes();
+  }
+}
 
+// Returns the creator of the queues of a session batched with
+// 'batching_config' on 'batch_scheduler'. If 'gate_queue' is non-null, the
+// batches also wait for its slots.
+BatchingSessionSchedulerCreator CreateQueueCreator(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<Batcher> batch_scheduler,
+    std::shared_ptr<WeightedFairBatchGate::Queue> gate_queue,
+    const string& queue_name) {
   auto queue_options = GetQueueOptions<
       tensorflow::serving::BatchingSessionTask>(
       batching_config,
@@ -136,6 +439,331 @@ Status WrapSessionForBatching(const BatchingParameters& batching_config,
                               max_batch_size, output_tasks);
       });
 
+  BatchingSessionSchedulerCreator create_queue =
+      [batch_scheduler, queue_options](
+          std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+              process_batch_callback,
+          std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
+        TF_RETURN_IF_ERROR(batch_scheduler->AddQueue(
+            queue_options, process_batch_callback, queue));
+        return OkStatus();
+      };
+  if (batching_config.use_streaming_batch_scheduler()) {
+    StreamingBatchScheduler<BatchingSessionTask>::Options streaming_options;
+    streaming_options.max_batch_size = queue_options.input_batch_size_limit;
+    streaming_options.batch_timeout_micros =
+        queue_options.batch_timeout_micros;
+    if (batching_config.has_num_batch_threads()) {
+      streaming_options.num_batch_threads =
+          batching_config.num_batch_threads().value();
+    }
+    if (batching_config.has_thread_pool_name()) {
+      streaming_options.thread_pool_name =
+          batching_config.thread_pool_name().value();
+    }
+    streaming_options.enable_large_batch_splitting =
+        queue_options.enable_large_batch_splitting;
+    streaming_options.split_input_task_func =
+        queue_options.split_input_task_func;
+    create_queue = [streaming_options](
+        std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+            process_batch_callback,
+        std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
+      return CreateRetryingStreamingBatchScheduler<BatchingSessionTask>(
+          streaming_options,
+          BatchSchedulerRetrier<BatchingSessionTask>::Options(),
+          process_batch_callback, queue);
+    };
+  } else if (batching_config.batch_latency_slo_micros() > 0) {
+    AdaptiveBatchTimeoutController::Options adaptive_options;
+    adaptive_options.max_batch_timeout_micros =
+        queue_options.batch_timeout_micros;
+    adaptive_options.latency_slo_micros =
+        batching_config.batch_latency_slo_micros();
+    create_queue = [batch_scheduler, queue_options, adaptive_options](
+        std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+            process_batch_callback,
+        std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
+      std::unique_ptr<AdaptiveTimeoutBatchScheduler<BatchingSessionTask>>
+          adaptive_scheduler;
+      TF_RETURN_IF_ERROR(
+          AdaptiveTimeoutBatchScheduler<BatchingSessionTask>::Create(
+              adaptive_options, process_batch_callback,
+              [&](int64_t batch_timeout_micros,
+                  std::function<void(
+                      std::unique_ptr<Batch<BatchingSessionTask>>)>
+                      level_process_batch_callback,
+                  std::unique_ptr<BatchScheduler<BatchingSessionTask>>*
+                      level_queue) {
+                Batcher::QueueOptions level_queue_options = queue_options;
+                level_queue_options.batch_timeout_micros =
+                    batch_timeout_micros;
+                return batch_scheduler->AddQueue(level_queue_options,
+                                                 level_process_batch_callback,
+                                                 level_queue);
+              },
+              &adaptive_scheduler));
+      *queue = std::move(adaptive_scheduler);
+      return OkStatus();
+    };
+  }
+  if (gate_queue != nullptr) {
+    create_queue = [gate_queue, create_queue](
+        std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+            process_batch_callback,
+        std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
+      return create_queue(
+          [gate_queue, process_batch_callback](
+              std::unique_ptr<Batch<BatchingSessionTask>> batch) {
+            gate_queue->Run([&] { process_batch_callback(std::move(batch)); });
+          },
+          queue);
+    };
+  }
+  if (batching_config.enable_deadline_aware_load_shedding()) {
+    DeadlineAdmissionBatchScheduler<BatchingSessionTask>::Options
+        admission_options;
+    admission_options.estimator_options.max_batch_size =
+        queue_options.enable_large_batch_splitting
+            ? queue_options.max_execution_batch_size
+            : queue_options.input_batch_size_limit;
+    admission_options.estimator_options.num_batch_threads =
+        batching_config.has_num_batch_threads()
+            ? batching_config.num_batch_threads().value()
+            : Batcher::Options().num_batch_threads;
+    admission_options.deadline_micros_func =
+        [](const BatchingSessionTask& task) { return task.deadline_micros(); };
+    create_queue = [admission_options, create_queue](
+        std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+            process_batch_callback,
+        std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
+      std::unique_ptr<DeadlineAdmissionBatchScheduler<BatchingSessionTask>>
+          admission_scheduler;
+      TF_RETURN_IF_ERROR(
+          DeadlineAdmissionBatchScheduler<BatchingSessionTask>::Create(
+              admission_options, process_batch_callback, create_queue,
+              &admission_scheduler));
+      *queue = std::move(admission_scheduler);
+      return OkStatus();
+    };
+  }
+
+  // Outermost, to count the whole processing of the batches, and to report
+  // the fill of the queues as scheduled to.
+  create_queue = [queue_name, create_queue](
+      std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+          process_batch_callback,
+      std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
+    std::unique_ptr<BatchScheduler<BatchingSessionTask>> wrapped;
+    TF_RETURN_IF_ERROR(create_queue(
+        [process_batch_callback](
+            std::unique_ptr<Batch<BatchingSessionTask>> batch) {
+          UtilizationMeter* const meter = BatchThreadUtilizationMeter();
+          meter->Begin();
+          process_batch_callback(std::move(batch));
+          meter->End();
+        },
+        &wrapped));
+    if (queue_name.empty()) {
+      *queue = std::move(wrapped);
+    } else {
+      queue->reset(new SaturationReportingBatchScheduler(queue_name,
+                                                         std::move(wrapped)));
+    }
+    return OkStatus();
+  };
+  return create_queue;
+}
+
+// The batching of a session that WrapSessionForBatching() wrapped for a model,
+// which UpdateLiveBatchingParameters() changes.
+struct LiveSessionBatching {
+  // The batching parameters the session was loaded with.
+  BatchingParameters loaded_config;
+  std::shared_ptr<Batcher> batch_scheduler;
+  std::shared_ptr<WeightedFairBatchGate::Queue> gate_queue;
+  string queue_name;
+
+  std::shared_ptr<ReconfigurableBatchQueues<BatchingSessionTask>> queues;
+  std::shared_ptr<LiveAllowedBatchSizes> allowed_batch_sizes;
+};
+
+// The batching of the sessions of each model, and the live batching parameters
+// they were last updated with.
+//
+// Sessions are added and updated under one lock, so that a session that is
+// loaded while its model is updated gets the new parameters. The lock is held
+// while the previous queues process their tasks, which may delay the loading
+// of batched sessions by a batch.
+//
+// This class is thread-safe.
+class LiveBatchingRegistry {
+ public:
+  static LiveBatchingRegistry* Global() {
+    static LiveBatchingRegistry* const registry = new LiveBatchingRegistry;
+    return registry;
+  }
+
+  // Creates the batching of a session of 'model_name', loaded with
+  // 'loaded_config' and overridden by the live parameters of the model.
+  Status Add(const string& model_name, const BatchingParameters& loaded_config,
+             std::shared_ptr<Batcher> batch_scheduler,
+             std::shared_ptr<WeightedFairBatchGate::Queue> gate_queue,
+             std::shared_ptr<LiveSessionBatching>* batching)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    BatchingParameters batching_config = loaded_config;
+    auto live_params = live_params_.find(model_name);
+    if (live_params != live_params_.end()) {
+      ApplyLiveBatchingParameters(live_params->second, &batching_config);
+      TF_RETURN_IF_ERROR(ValidateAllowedBatchSizes(batching_config));
+    }
+    auto result = std::make_shared<LiveSessionBatching>();
+    result->loaded_config = loaded_config;
+    result->batch_scheduler = std::move(batch_scheduler);
+    result->gate_queue = std::move(gate_queue);
+    result->queue_name = model_name;
+    result->queues = ReconfigurableBatchQueues<BatchingSessionTask>::Create(
+        CreateQueueCreator(batching_config, result->batch_scheduler,
+                           result->gate_queue, model_name));
+    result->allowed_batch_sizes = std::make_shared<LiveAllowedBatchSizes>(
+        std::vector<int>(batching_config.allowed_batch_sizes().begin(),
+                         batching_config.allowed_batch_sizes().end()));
+
+    std::vector<std::weak_ptr<LiveSessionBatching>>& sessions =
+        sessions_[model_name];
+    sessions.erase(
+        std::remove_if(sessions.begin(), sessions.end(),
+                       [](const std::weak_ptr<LiveSessionBatching>& session) {
+                         return session.expired();
+                       }),
+        sessions.end());
+    sessions.push_back(result);
+    *batching = std::move(result);
+    return OkStatus();
+  }
+
+  Status Update(const string& model_name,
+                const BatchingParameters& live_params) TF_LOCKS_EXCLUDED(mu_) {
+    TF_RETURN_IF_ERROR(ValidateLiveBatchingParameters(live_params));
+    mutex_lock l(mu_);
+    std::vector<std::shared_ptr<LiveSessionBatching>> sessions;
+    for (const auto& weak_session : sessions_[model_name]) {
+      std::shared_ptr<LiveSessionBatching> session = weak_session.lock();
+      if (session != nullptr) {
+        sessions.push_back(std::move(session));
+      }
+    }
+    // Check the parameters against all sessions before changing any.
+    std::vector<BatchingParameters> batching_configs;
+    for (const auto& session : sessions) {
+      BatchingParameters batching_config = session->loaded_config;
+      ApplyLiveBatchingParameters(live_params, &batching_config);
+      TF_RETURN_IF_ERROR(ValidateAllowedBatchSizes(batching_config));
+      batching_configs.push_back(std::move(batching_config));
+    }
+    for (int i = 0; i < sessions.size(); ++i) {
+      const LiveSessionBatching& session = *sessions[i];
+      const BatchingParameters& batching_config = batching_configs[i];
+      TF_RETURN_IF_ERROR(session.queues->Reconfigure(
+          CreateQueueCreator(batching_config, session.batch_scheduler,
+                             session.gate_queue, session.queue_name)));
+      // After the previous queues are drained, so that their batches are
+      // padded to the previous sizes.
+      session.allowed_batch_sizes->Set(
+          std::vector<int>(batching_config.allowed_batch_sizes().begin(),
+                           batching_config.allowed_batch_sizes().end()));
+    }
+    if (live_params.ByteSizeLong() == 0) {
+      live_params_.erase(model_name);
+    } else {
+      live_params_[model_name] = live_params;
+    }
+    LOG(INFO) << "Updated the batching parameters of " << sessions.size()
+              << " sessions of model " << model_name << " to "
+              << live_params.ShortDebugString();
+    return OkStatus();
+  }
+
+ private:
+  LiveBatchingRegistry() = default;
+
+  mutex mu_;
+
+  // The batching of the sessions of each model.
+  std::map<string, std::vector<std::weak_ptr<LiveSessionBatching>>> sessions_
+      TF_GUARDED_BY(mu_);
+
+  // The parameters of the last UpdateLiveBatchingParameters() of each model,
+  // which also apply to the sessions that are loaded later.
+  std::map<string, BatchingParameters> live_params_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+Status ValidateLiveBatchingParameters(const BatchingParameters& params) {
+  BatchingParameters other_params = params;
+  other_params.clear_max_batch_size();
+  other_params.clear_batch_timeout_micros();
+  other_params.clear_max_enqueued_batches();
+  other_params.clear_max_execution_batch_size();
+  other_params.clear_num_batch_threads();
+  other_params.clear_allowed_batch_sizes();
+  if (other_params.ByteSizeLong() > 0) {
+    return errors::InvalidArgument(
+        "Only max_batch_size, batch_timeout_micros, max_enqueued_batches, "
+        "max_execution_batch_size, num_batch_threads and allowed_batch_sizes "
+        "can change without reloading the model; got ",
+        other_params.ShortDebugString());
+  }
+  if ((params.has_max_batch_size() && params.max_batch_size().value() <= 0) ||
+      (params.has_max_enqueued_batches() &&
+       params.max_enqueued_batches().value() <= 0) ||
+      (params.has_max_execution_batch_size() &&
+       params.max_execution_batch_size().value() <= 0) ||
+      (params.has_num_batch_threads() &&
+       params.num_batch_threads().value() <= 0)) {
+    return errors::InvalidArgument(
+        "Batch sizes, queue lengths and thread counts must be positive; got ",
+        params.ShortDebugString());
+  }
+  if (params.has_batch_timeout_micros() &&
+      params.batch_timeout_micros().value() < 0) {
+    return errors::InvalidArgument(
+        "batch_timeout_micros must be non-negative; got ",
+        params.batch_timeout_micros().value());
+  }
+  for (int i = 1; i < params.allowed_batch_sizes().size(); ++i) {
+    if (params.allowed_batch_sizes(i) <= params.allowed_batch_sizes(i - 1)) {
+      return errors::InvalidArgument(
+          "allowed_batch_sizes entries must be monotonically increasing");
+    }
+  }
+  return OkStatus();
+}
+
+Status UpdateLiveBatchingParameters(const string& model_name,
+                                    const BatchingParameters& params) {
+  return LiveBatchingRegistry::Global()->Update(model_name, params);
+}
+
+Status WrapSessionForBatching(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<Batcher> batch_scheduler,
+    std::shared_ptr<WeightedFairBatchGate> fair_batch_gate,
+    const string& queue_name, Allocator* batch_input_allocator,
+    const std::vector<SignatureDef>& signatures,
+    std::unique_ptr<Session>* session) {
+  LOG(INFO) << "Wrapping session to perform batch processing";
+
+  if (batch_scheduler == nullptr) {
+    return errors::Internal("batch_scheduler not set");
+  }
+  if (*session == nullptr) {
+    return errors::Internal("session not set");
+  }
+  TF_RETURN_IF_ERROR(ValidateAllowedBatchSizes(batching_config));
+
   BatchingSessionOptions batching_session_options;
   for (int allowed_batch_size : batching_config.allowed_batch_sizes()) {
     batching_session_options.allowed_batch_sizes.push_back(allowed_batch_size);
@@ -143,15 +771,83 @@ Status WrapSessionForBatching(const BatchingParameters& batching_config,
 
   batching_session_options.pad_variable_length_inputs =
       batching_config.pad_variable_length_inputs();
+  batching_session_options.enable_pooled_batch_assembly =
+      batching_config.enable_pooled_batch_assembly();
+  for (int64_t boundary : batching_config.padded_dim_bucket_boundaries()) {
+    batching_session_options.padded_dim_bucket_boundaries.push_back(boundary);
+  }
+  batching_session_options.pad_to_bucket_boundaries =
+      batching_config.pad_to_bucket_boundaries();
+  batching_session_options.enable_criticality_lanes =
+      batching_config.enable_criticality_lanes();
+  if (batching_config.max_enqueued_critical_tasks_for_sheddable() < 0) {
+    return errors::InvalidArgument(
+        "max_enqueued_critical_tasks_for_sheddable must be non-negative; got ",
+        batching_config.max_enqueued_critical_tasks_for_sheddable());
+  }
+  batching_session_options.max_enqueued_critical_tasks_for_sheddable =
+      batching_config.max_enqueued_critical_tasks_for_sheddable();
+  batching_session_options.enable_input_row_dedup =
+      batching_config.enable_input_row_dedup();
+  batching_session_options.model_name = queue_name;
+  batching_session_options.batch_input_allocator = batch_input_allocator;
+  batching_session_options.enable_joint_signature_batching =
+      batching_config.enable_joint_signature_batching();
+  batching_session_options.enable_combining_enqueue =
+      batching_config.enable_combining_enqueue();
+  if (!batching_config.ragged_tensors().empty()) {
+    if (batching_config.enable_large_batch_splitting().value()) {
+      return errors::InvalidArgument(
+          "Ragged tensors cannot be batched with enable_large_batch_splitting");
+    }
+    AddRaggedTensorNames(batching_config.ragged_tensors(), signatures,
+                         &batching_session_options.ragged_tensors);
+  }
+  if (batching_config.task_cost_model() ==
+      BatchingParameters::ROWS_TIMES_MAX_NON_BATCH_DIM) {
+    batching_session_options.row_cost_func =
+        [](const std::vector<std::pair<std::string, Tensor>>& inputs) {
+          return MaxNonBatchDimSize(inputs);
+        };
+  }
+
+  batching_session_options.shed_expired_tasks =
+      batching_config.enable_deadline_aware_load_shedding();
+
+  std::shared_ptr<WeightedFairBatchGate::Queue> gate_queue;
+  if (fair_batch_gate != nullptr) {
+    const double weight = batching_config.fair_share_weight() > 0
+                              ? batching_config.fair_share_weight()
+                              : 1.0;
+    std::unique_ptr<WeightedFairBatchGate::Queue> unique_gate_queue;
+    TF_RETURN_IF_ERROR(
+        fair_batch_gate->AddQueue(queue_name, weight, &unique_gate_queue));
+    // Shared by the queues of all signatures of the session.
+    gate_queue = std::move(unique_gate_queue);
+  }
+
+  BatchingSessionSchedulerCreator create_queue;
+  if (queue_name.empty()) {
+    create_queue = CreateQueueCreator(batching_config, batch_scheduler,
+                                      gate_queue, queue_name);
+  } else {
+    // The queues of the sessions of a model can change while they serve, see
+    // UpdateLiveBatchingParameters(). The session owns them.
+    std::shared_ptr<LiveSessionBatching> live_batching;
+    TF_RETURN_IF_ERROR(LiveBatchingRegistry::Global()->Add(
+        queue_name, batching_config, batch_scheduler, gate_queue,
+        &live_batching));
+    batching_session_options.live_allowed_batch_sizes =
+        live_batching->allowed_batch_sizes;
+    create_queue = [live_batching](
+        std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
+            process_batch_callback,
+        std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
+      return live_batching->queues->CreateScheduler(process_batch_callback,
+                                                    queue);
+    };
+  }
 
-  auto create_queue = [batch_scheduler, queue_options](
-      std::function<void(std::unique_ptr<Batch<BatchingSessionTask>>)>
-          process_batch_callback,
-      std::unique_ptr<BatchScheduler<BatchingSessionTask>>* queue) {
-    TF_RETURN_IF_ERROR(batch_scheduler->AddQueue(
-        queue_options, process_batch_callback, queue));
-    return OkStatus();
-  };
   std::vector<SignatureWithBatchingSessionSchedulerCreator>
       signatures_with_scheduler_creators;
   for (const SignatureDef& signature : signatures) {
@@ -166,6 +862,18 @@ Status WrapSessionForBatching(const BatchingParameters& batching_config,
                                std::move(*session), session);
 }
 
+Status CreateFairBatchGate(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<WeightedFairBatchGate>* fair_batch_gate) {
+  if (batching_config.num_fair_share_batch_slots() <= 0) {
+    fair_batch_gate->reset();
+    return OkStatus();
+  }
+  WeightedFairBatchGate::Options options;
+  options.num_slots = batching_config.num_fair_share_batch_slots();
+  return WeightedFairBatchGate::Create(options, fair_batch_gate);
+}
+
 Status WrapSession(std::unique_ptr<Session>* session) {
   session->reset(new ServingSessionWrapper(std::move(*session)));
   return OkStatus();
@@ -177,5 +885,10 @@ Status WrapSessionIgnoreThreadPoolOptions(std::unique_ptr<Session>* session) {
   return OkStatus();
 }
 
+Status WrapSessionForInlineRuns(std::unique_ptr<Session>* session) {
+  session->reset(new SessionWrapperRunInline(std::move(*session)));
+  return OkStatus();
+}
+
 }  // namespace serving
 }  // namespace tensorflow
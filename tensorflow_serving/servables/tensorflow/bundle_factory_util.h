@@ -18,16 +18,23 @@ limitations under the License.
 
 #include "google/protobuf/wrappers.pb.h"
 #include "absl/types/optional.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow_serving/batching/batching_session.h"
+#include "tensorflow_serving/batching/weighted_fair_batch_gate.h"
 #include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/servables/tensorflow/resource_estimator.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 #include "tensorflow_serving/util/file_probing_env.h"
+#include "tensorflow_serving/util/cpu_set_env.h"
+#include "tensorflow_serving/util/numa_node_env.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
 
 namespace tensorflow {
 namespace serving {
@@ -53,11 +60,35 @@ Status GetPerModelBatchingParams(const string& path,
                                  bool per_model_configured,
                                  absl::optional<BatchingParameters>* params);
 
-// Creates a BatchScheduler based on the batching configuration.
+// Returns the batch sizes that the model of 'meta_graph_def' was compiled for:
+// the union of the 'allowed_batch_sizes' of the BatchFunction ops of its graph
+// and function library, in increasing order.
+std::vector<int64_t> GetCompiledBatchSizes(const MetaGraphDef& meta_graph_def);
+
+// Returns the number of nodes of the graph of 'meta_graph_def' and of the
+// functions of its library.
+int64_t CountGraphNodes(const MetaGraphDef& meta_graph_def);
+
+// If 'params' has 'tpu_batching_profile' set, fits them to the shapes the
+// model was compiled for, given its 'compiled_batch_sizes' (see
+// GetCompiledBatchSizes()). See BatchingParameters.tpu_batching_profile.
+void ApplyTpuBatchingProfile(const std::vector<int64_t>& compiled_batch_sizes,
+                             BatchingParameters* params);
+
+// If 'warmup_options' has 'enable_allowed_batch_sizes_warmup' set and no
+// 'batch_sizes', sets 'batch_sizes' to the batch sizes that the model at
+// 'path' is batched with: the 'allowed_batch_sizes' of its batching parameters
+// (see GetPerModelBatchingParams()), or their 'max_batch_size' if those are
+// not set. Leaves 'warmup_options' unchanged if the model is not batched.
+Status SetWarmupBatchSizes(const string& path,
+                           const BatchingParameters& common_params,
+                           bool per_model_configured,
+                           ModelWarmupOptions* warmup_options);
+
+// Returns the SharedBatchScheduler options of the batching configuration.
 template <typename TaskType>
-Status CreateBatchScheduler(
-    const BatchingParameters& batching_config,
-    std::shared_ptr<SharedBatchScheduler<TaskType>>* batch_scheduler) {
+typename SharedBatchScheduler<TaskType>::Options GetBatchSchedulerOptions(
+    const BatchingParameters& batching_config) {
   typename SharedBatchScheduler<TaskType>::Options options;
   if (batching_config.has_num_batch_threads()) {
     options.num_batch_threads = batching_config.num_batch_threads().value();
@@ -65,9 +96,63 @@ Status CreateBatchScheduler(
   if (batching_config.has_thread_pool_name()) {
     options.thread_pool_name = batching_config.thread_pool_name().value();
   }
+  if (batching_config.batch_thread_cpus_size() > 0) {
+    options.env = CpuSetEnv::ForCpus(
+        {batching_config.batch_thread_cpus().begin(),
+         batching_config.batch_thread_cpus().end()});
+  }
+  return options;
+}
+
+// Measures the busy time of the batch threads of the process, as processing
+// the batches of the sessions wrapped by WrapSessionForBatching(), and reports
+// it as the "batch_threads" saturation signal of the server (see
+// SaturationMonitor). Its capacity is the number of batch threads of the
+// scheduler(s) created last by CreateBatchScheduler() or
+// CreateNumaBatchSchedulers().
+UtilizationMeter* BatchThreadUtilizationMeter();
+
+// Creates a BatchScheduler based on the batching configuration.
+template <typename TaskType>
+Status CreateBatchScheduler(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<SharedBatchScheduler<TaskType>>* batch_scheduler) {
+  const typename SharedBatchScheduler<TaskType>::Options options =
+      GetBatchSchedulerOptions<TaskType>(batching_config);
+  BatchThreadUtilizationMeter()->SetCapacity(options.num_batch_threads);
   return SharedBatchScheduler<TaskType>::Create(options, batch_scheduler);
 }
 
+// Creates one BatchScheduler per NUMA node, for 'num_numa_nodes' nodes, whose
+// batch threads are pinned to the node (see NumaNodeEnv). The node's index is
+// appended to the thread pool name, and the 'num_batch_threads' of the
+// batching configuration are divided among the nodes, rounding up.
+template <typename TaskType>
+Status CreateNumaBatchSchedulers(
+    const BatchingParameters& batching_config, int num_numa_nodes,
+    std::vector<std::shared_ptr<SharedBatchScheduler<TaskType>>>*
+        batch_schedulers) {
+  const typename SharedBatchScheduler<TaskType>::Options base_options =
+      GetBatchSchedulerOptions<TaskType>(batching_config);
+  const int num_batch_threads_per_node =
+      (base_options.num_batch_threads + num_numa_nodes - 1) / num_numa_nodes;
+  batch_schedulers->clear();
+  for (int numa_node = 0; numa_node < num_numa_nodes; ++numa_node) {
+    typename SharedBatchScheduler<TaskType>::Options options = base_options;
+    options.num_batch_threads = num_batch_threads_per_node;
+    options.thread_pool_name =
+        strings::StrCat(base_options.thread_pool_name, "_numa", numa_node);
+    options.env = NumaNodeEnv::ForNode(numa_node);
+    std::shared_ptr<SharedBatchScheduler<TaskType>> batch_scheduler;
+    TF_RETURN_IF_ERROR(
+        SharedBatchScheduler<TaskType>::Create(options, &batch_scheduler));
+    batch_schedulers->push_back(std::move(batch_scheduler));
+  }
+  BatchThreadUtilizationMeter()->SetCapacity(num_numa_nodes *
+                                             num_batch_threads_per_node);
+  return OkStatus();
+}
+
 // Estimates the resources a session bundle or saved model bundle will use once
 // loaded, from infra validation.
 Status EstimateResourceFromValidationResult(const string& path,
@@ -82,6 +167,9 @@ Status EstimateResourceFromValidationResult(const string& path,
 // RAM = (combined size of all exported file(s)) *
 // kResourceEstimateRAMMultiplier + kResourceEstimateRAMPadBytes.
 // TODO(b/27694447): Improve the heuristic. At a minimum, account for GPU RAM.
+//
+// The estimates of recently estimated paths are cached, since the files of a
+// model version do not change once it is exported.
 Status EstimateResourceFromPath(const string& path, bool use_validation_result,
                                 ResourceAllocation* estimate);
 
@@ -92,6 +180,63 @@ Status WrapSessionForBatching(
     const std::vector<SignatureDef>& signatures,
     std::unique_ptr<Session>* session);
 
+// Same as above, but if 'fair_batch_gate' is non-null, the batches of the
+// session additionally wait for one of its slots, as a queue named
+// 'queue_name' (typically the model name) with weight
+// 'batching_config.fair_share_weight()'.
+Status WrapSessionForBatching(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<SharedBatchScheduler<BatchingSessionTask>> batch_scheduler,
+    std::shared_ptr<WeightedFairBatchGate> fair_batch_gate,
+    const string& queue_name, const std::vector<SignatureDef>& signatures,
+    std::unique_ptr<Session>* session);
+
+// Same as above, but if 'batch_input_allocator' is non-null, the merged batch
+// inputs of the session are allocated from it (see
+// BatchingOptions::batch_input_allocator), e.g. from memory local to the NUMA
+// node that the threads of 'batch_scheduler' are pinned to.
+Status WrapSessionForBatching(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<SharedBatchScheduler<BatchingSessionTask>> batch_scheduler,
+    std::shared_ptr<WeightedFairBatchGate> fair_batch_gate,
+    const string& queue_name, Allocator* batch_input_allocator,
+    const std::vector<SignatureDef>& signatures,
+    std::unique_ptr<Session>* session);
+
+// Changes the batching of the sessions that WrapSessionForBatching() wrapped
+// with 'model_name' as their 'queue_name', while they serve: the fields set in
+// 'params' override the batching parameters the sessions were loaded with,
+// for them and for the sessions of the model loaded later, replacing the
+// 'params' of the previous update. An empty 'params' restores the parameters
+// the sessions were loaded with.
+//
+// Only 'max_batch_size', 'batch_timeout_micros', 'max_enqueued_batches',
+// 'max_execution_batch_size', 'allowed_batch_sizes' and 'num_batch_threads'
+// can change this way (see ValidateLiveBatchingParameters()). The latter only
+// changes the batch threads of sessions batched with
+// 'use_streaming_batch_scheduler' (and the estimates of
+// 'enable_deadline_aware_load_shedding'): the threads of a shared batch
+// scheduler serve all models, and are fixed when it is created.
+//
+// The queues of the sessions are replaced by queues with the new parameters;
+// the tasks already in the previous queues are still batched with the previous
+// parameters, which this waits for. If the parameters are invalid for one of
+// the sessions, returns an error and changes none.
+Status UpdateLiveBatchingParameters(const string& model_name,
+                                    const BatchingParameters& params);
+
+// Returns an error if 'params' sets fields that UpdateLiveBatchingParameters()
+// cannot change, or invalid values.
+Status ValidateLiveBatchingParameters(const BatchingParameters& params);
+
+// Creates a WeightedFairBatchGate with
+// 'batching_config.num_fair_share_batch_slots()' slots, to be shared by all
+// models that use 'batching_config', if that is positive. Otherwise leaves
+// 'fair_batch_gate' null.
+Status CreateFairBatchGate(
+    const BatchingParameters& batching_config,
+    std::shared_ptr<WeightedFairBatchGate>* fair_batch_gate);
+
 // Wraps a session in a new session that only supports Run() without batching.
 Status WrapSession(std::unique_ptr<Session>* session);
 
@@ -99,6 +244,10 @@ Status WrapSession(std::unique_ptr<Session>* session);
 // parameters.
 Status WrapSessionIgnoreThreadPoolOptions(std::unique_ptr<Session>* session);
 
+// Wraps a session in a new session that runs the Run() calls without thread
+// pools of their own on the calling thread (see SessionWrapperRunInline).
+Status WrapSessionForInlineRuns(std::unique_ptr<Session>* session);
+
 // Construct Queue Options from BatchingParameters.
 template <typename TaskType>
 typename SharedBatchScheduler<TaskType>::QueueOptions GetQueueOptions(
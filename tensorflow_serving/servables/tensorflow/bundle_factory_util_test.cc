@@ -28,8 +28,10 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/public/version.h"
@@ -39,6 +41,7 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 #include "tensorflow_serving/session_bundle/session_bundle_util.h"
 #include "tensorflow_serving/test_util/test_util.h"
+#include "tensorflow_serving/util/cpu_set_env.h"
 #include "tensorflow_serving/util/test_util/mock_file_probing_env.h"
 
 namespace tensorflow {
@@ -104,6 +107,13 @@ TEST_F(BundleFactoryUtilTest, GetSessionOptions) {
   SessionOptions session_options = GetSessionOptions(bundle_config);
   EXPECT_EQ(session_options.target, kTarget);
   EXPECT_THAT(session_options.config, EqualsProto(*config_proto));
+  EXPECT_EQ(Env::Default(), session_options.env);
+
+  // The session thread pools are pinned with the env.
+  bundle_config.add_session_thread_cpus(0);
+  bundle_config.add_session_thread_cpus(1);
+  session_options = GetSessionOptions(bundle_config);
+  EXPECT_EQ(CpuSetEnv::ForCpus({0, 1}), session_options.env);
 }
 
 TEST_F(BundleFactoryUtilTest, GetRunOptions) {
@@ -132,6 +142,14 @@ TEST_F(BundleFactoryUtilTest, WrapSessionIgnoreThreadPoolOptions) {
   test_util::TestSingleRequest(session.get());
 }
 
+TEST_F(BundleFactoryUtilTest, WrapSessionForInlineRuns) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                              {"serve"}, &bundle));
+  TF_ASSERT_OK(WrapSessionForInlineRuns(&bundle.session));
+  test_util::TestSingleRequest(bundle.session.get());
+}
+
 TEST_F(BundleFactoryUtilTest, WrapSessionForBatching) {
   SavedModelBundle bundle;
   TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
@@ -154,6 +172,128 @@ TEST_F(BundleFactoryUtilTest, WrapSessionForBatching) {
   test_util::TestMultipleRequests(bundle.session.get(), 10, 2);
 }
 
+TEST_F(BundleFactoryUtilTest, WrapSessionForBatchingWithFairBatchGate) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                              {"serve"}, &bundle));
+
+  BatchingParameters batching_params;
+  batching_params.mutable_max_batch_size()->set_value(2);
+  batching_params.mutable_max_enqueued_batches()->set_value(INT_MAX);
+  batching_params.set_num_fair_share_batch_slots(1);
+  batching_params.set_fair_share_weight(2);
+
+  std::shared_ptr<Batcher> batcher;
+  TF_ASSERT_OK(CreateBatchScheduler(batching_params, &batcher));
+  std::shared_ptr<WeightedFairBatchGate> fair_batch_gate;
+  TF_ASSERT_OK(CreateFairBatchGate(batching_params, &fair_batch_gate));
+  ASSERT_NE(nullptr, fair_batch_gate);
+  EXPECT_EQ(1, fair_batch_gate->num_slots());
+
+  TF_ASSERT_OK(WrapSessionForBatching(
+      batching_params, batcher, fair_batch_gate, "half_plus_two",
+      {test_util::GetTestSessionSignature()}, &bundle.session));
+
+  test_util::TestMultipleRequests(bundle.session.get(), 10, 2);
+}
+
+TEST_F(BundleFactoryUtilTest, WrapSessionForBatchingWithNumaBatchSchedulers) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                              {"serve"}, &bundle));
+  BatchingParameters batching_params;
+  batching_params.mutable_max_batch_size()->set_value(2);
+  batching_params.mutable_max_enqueued_batches()->set_value(INT_MAX);
+  batching_params.mutable_num_batch_threads()->set_value(3);
+
+  std::vector<std::shared_ptr<Batcher>> batchers;
+  TF_ASSERT_OK(CreateNumaBatchSchedulers(batching_params, /*num_numa_nodes=*/2,
+                                         &batchers));
+  ASSERT_EQ(2, batchers.size());
+
+  TF_ASSERT_OK(WrapSessionForBatching(
+      batching_params, batchers[1], /*fair_batch_gate=*/nullptr,
+      "half_plus_two", cpu_allocator(), {test_util::GetTestSessionSignature()},
+      &bundle.session));
+  test_util::TestMultipleRequests(bundle.session.get(), 10, 2);
+}
+
+TEST_F(BundleFactoryUtilTest, UpdateLiveBatchingParameters) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                              {"serve"}, &bundle));
+  BatchingParameters batching_params;
+  batching_params.mutable_max_batch_size()->set_value(2);
+  batching_params.mutable_max_enqueued_batches()->set_value(INT_MAX);
+  std::shared_ptr<Batcher> batcher;
+  TF_ASSERT_OK(CreateBatchScheduler(batching_params, &batcher));
+  TF_ASSERT_OK(WrapSessionForBatching(
+      batching_params, batcher, /*fair_batch_gate=*/nullptr, "live_model",
+      {test_util::GetTestSessionSignature()}, &bundle.session));
+  test_util::TestMultipleRequests(bundle.session.get(), 10, 2);
+
+  // Requests of 4 rows fit in the batches once the max batch size is raised.
+  BatchingParameters live_params;
+  live_params.mutable_max_batch_size()->set_value(4);
+  live_params.mutable_batch_timeout_micros()->set_value(1000);
+  live_params.add_allowed_batch_sizes(2);
+  live_params.add_allowed_batch_sizes(4);
+  TF_ASSERT_OK(UpdateLiveBatchingParameters("live_model", live_params));
+  test_util::TestMultipleRequests(bundle.session.get(), 10, 4);
+
+  // Sessions of the model loaded later get the live parameters too.
+  SavedModelBundle next_bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                              {"serve"}, &next_bundle));
+  TF_ASSERT_OK(WrapSessionForBatching(
+      batching_params, batcher, /*fair_batch_gate=*/nullptr, "live_model",
+      {test_util::GetTestSessionSignature()}, &next_bundle.session));
+  test_util::TestMultipleRequests(next_bundle.session.get(), 10, 4);
+
+  // Invalid parameters change nothing.
+  BatchingParameters mismatched_params;
+  mismatched_params.mutable_max_batch_size()->set_value(8);
+  mismatched_params.add_allowed_batch_sizes(4);
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      UpdateLiveBatchingParameters("live_model", mismatched_params)));
+  BatchingParameters not_live_params;
+  not_live_params.set_num_fair_share_batch_slots(2);
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      UpdateLiveBatchingParameters("live_model", not_live_params)));
+  test_util::TestMultipleRequests(bundle.session.get(), 10, 4);
+
+  // Empty parameters restore the loaded ones.
+  TF_ASSERT_OK(
+      UpdateLiveBatchingParameters("live_model", BatchingParameters()));
+  test_util::TestMultipleRequests(bundle.session.get(), 10, 2);
+}
+
+TEST_F(BundleFactoryUtilTest, ValidateLiveBatchingParameters) {
+  BatchingParameters params;
+  TF_EXPECT_OK(ValidateLiveBatchingParameters(params));
+  params.mutable_max_batch_size()->set_value(4);
+  params.add_allowed_batch_sizes(2);
+  params.add_allowed_batch_sizes(4);
+  params.mutable_num_batch_threads()->set_value(2);
+  TF_EXPECT_OK(ValidateLiveBatchingParameters(params));
+
+  BatchingParameters decreasing_params = params;
+  decreasing_params.add_allowed_batch_sizes(3);
+  EXPECT_FALSE(ValidateLiveBatchingParameters(decreasing_params).ok());
+  BatchingParameters negative_params = params;
+  negative_params.mutable_batch_timeout_micros()->set_value(-1);
+  EXPECT_FALSE(ValidateLiveBatchingParameters(negative_params).ok());
+  BatchingParameters not_live_params = params;
+  not_live_params.set_enable_input_row_dedup(true);
+  EXPECT_FALSE(ValidateLiveBatchingParameters(not_live_params).ok());
+}
+
+TEST_F(BundleFactoryUtilTest, CreateFairBatchGateDisabledByDefault) {
+  std::shared_ptr<WeightedFairBatchGate> fair_batch_gate;
+  TF_ASSERT_OK(CreateFairBatchGate(BatchingParameters(), &fair_batch_gate));
+  EXPECT_EQ(nullptr, fair_batch_gate);
+}
+
 TEST_F(BundleFactoryUtilTest, WrapSessionForBatchingConfigError) {
   BatchingParameters batching_params;
   batching_params.mutable_max_batch_size()->set_value(2);
@@ -174,6 +314,25 @@ TEST_F(BundleFactoryUtilTest, WrapSessionForBatchingConfigError) {
   ASSERT_TRUE(errors::IsInvalidArgument(status));
 }
 
+TEST_F(BundleFactoryUtilTest,
+       WrapSessionForBatchingNegativeCriticalTaskLimit) {
+  BatchingParameters batching_params;
+  batching_params.mutable_max_batch_size()->set_value(2);
+  batching_params.set_enable_criticality_lanes(true);
+  batching_params.set_max_enqueued_critical_tasks_for_sheddable(-1);
+
+  std::shared_ptr<Batcher> batch_scheduler;
+  TF_ASSERT_OK(CreateBatchScheduler(batching_params, &batch_scheduler));
+
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), export_dir_,
+                              {"serve"}, &bundle));
+  auto status = WrapSessionForBatching(batching_params, batch_scheduler,
+                                       {test_util::GetTestSessionSignature()},
+                                       &bundle.session);
+  ASSERT_TRUE(errors::IsInvalidArgument(status));
+}
+
 TEST_F(BundleFactoryUtilTest, GetPerModelBatchingParams) {
   const BatchingParameters common_params =
       test_util::CreateProto<BatchingParameters>(R"(
@@ -217,6 +376,112 @@ TEST_F(BundleFactoryUtilTest, GetPerModelBatchingParams) {
   EXPECT_THAT(params.value(), test_util::EqualsProto(per_model_params_pbtxt));
 }
 
+TEST_F(BundleFactoryUtilTest, SetWarmupBatchSizes) {
+  const BatchingParameters params = test_util::CreateProto<BatchingParameters>(
+      R"(
+    allowed_batch_sizes: 8
+    allowed_batch_sizes: 16
+    max_batch_size { value: 16 })");
+
+  // Left alone unless enabled.
+  ModelWarmupOptions warmup_options;
+  TF_ASSERT_OK(SetWarmupBatchSizes("does/not/exist", params,
+                                   /*per_model_configured=*/false,
+                                   &warmup_options));
+  EXPECT_TRUE(warmup_options.batch_sizes().empty());
+
+  warmup_options.set_enable_allowed_batch_sizes_warmup(true);
+  TF_ASSERT_OK(SetWarmupBatchSizes("does/not/exist", params,
+                                   /*per_model_configured=*/false,
+                                   &warmup_options));
+  EXPECT_THAT(warmup_options.batch_sizes(), ::testing::ElementsAre(8, 16));
+
+  // Without allowed batch sizes, the max batch size is warmed up.
+  warmup_options.clear_batch_sizes();
+  TF_ASSERT_OK(SetWarmupBatchSizes(
+      "does/not/exist",
+      test_util::CreateProto<BatchingParameters>(
+          "max_batch_size { value: 32 }"),
+      /*per_model_configured=*/false, &warmup_options));
+  EXPECT_THAT(warmup_options.batch_sizes(), ::testing::ElementsAre(32));
+
+  // Explicit batch sizes take precedence.
+  warmup_options.clear_batch_sizes();
+  warmup_options.add_batch_sizes(4);
+  TF_ASSERT_OK(SetWarmupBatchSizes("does/not/exist", params,
+                                   /*per_model_configured=*/false,
+                                   &warmup_options));
+  EXPECT_THAT(warmup_options.batch_sizes(), ::testing::ElementsAre(4));
+}
+
+TEST_F(BundleFactoryUtilTest, GetCompiledBatchSizes) {
+  const MetaGraphDef meta_graph_def = test_util::CreateProto<MetaGraphDef>(R"(
+    graph_def {
+      node {
+        name: "batch"
+        op: "BatchFunction"
+        attr {
+          key: "allowed_batch_sizes"
+          value { list { i: 16 i: 4 } }
+        }
+      }
+      node { name: "other" op: "Identity" }
+      library {
+        function {
+          node_def {
+            name: "inner_batch"
+            op: "BatchFunction"
+            attr {
+              key: "allowed_batch_sizes"
+              value { list { i: 8 i: 16 } }
+            }
+          }
+        }
+      }
+    })");
+  EXPECT_THAT(GetCompiledBatchSizes(meta_graph_def),
+              ::testing::ElementsAre(4, 8, 16));
+  EXPECT_TRUE(GetCompiledBatchSizes(MetaGraphDef()).empty());
+  EXPECT_EQ(3, CountGraphNodes(meta_graph_def));
+  EXPECT_EQ(0, CountGraphNodes(MetaGraphDef()));
+}
+
+TEST_F(BundleFactoryUtilTest, ApplyTpuBatchingProfile) {
+  // Left alone unless enabled.
+  BatchingParameters params;
+  ApplyTpuBatchingProfile({4, 8}, &params);
+  EXPECT_THAT(params, EqualsProto(BatchingParameters()));
+
+  params = test_util::CreateProto<BatchingParameters>(R"(
+    tpu_batching_profile: true
+    max_batch_size { value: 64 }
+    padded_dim_bucket_boundaries: 128
+    padded_dim_bucket_boundaries: 512)");
+  ApplyTpuBatchingProfile({4, 8}, &params);
+  EXPECT_THAT(params.allowed_batch_sizes(), ::testing::ElementsAre(4, 8));
+  EXPECT_EQ(8, params.max_batch_size().value());
+  EXPECT_FALSE(params.has_max_execution_batch_size());
+  EXPECT_TRUE(params.pad_variable_length_inputs());
+  EXPECT_TRUE(params.pad_to_bucket_boundaries());
+
+  // Explicit batch sizes take precedence.
+  params = test_util::CreateProto<BatchingParameters>(R"(
+    tpu_batching_profile: true
+    allowed_batch_sizes: 32
+    max_batch_size { value: 32 })");
+  ApplyTpuBatchingProfile({4, 8}, &params);
+  EXPECT_THAT(params.allowed_batch_sizes(), ::testing::ElementsAre(32));
+  EXPECT_FALSE(params.pad_to_bucket_boundaries());
+
+  // Split batches fill up to the largest compiled size.
+  params = test_util::CreateProto<BatchingParameters>(R"(
+    tpu_batching_profile: true
+    enable_large_batch_splitting { value: true }
+    max_execution_batch_size { value: 64 })");
+  ApplyTpuBatchingProfile({4, 8}, &params);
+  EXPECT_EQ(8, params.max_execution_batch_size().value());
+}
+
 TEST_F(BundleFactoryUtilTest, EstimateResourceFromPathWithBadExport) {
   ResourceAllocation resource_requirement;
   const Status status = EstimateResourceFromPath(
@@ -237,6 +502,23 @@ TEST_F(BundleFactoryUtilTest, EstimateResourceFromPathWithGoodExport) {
   EXPECT_THAT(actual, EqualsProto(expected));
 }
 
+TEST_F(BundleFactoryUtilTest, EstimateResourceFromPathIsCached) {
+  const string export_dir = io::JoinPath(testing::TmpDir(), "cached_estimate");
+  test_util::CopyDirOrDie(export_dir_, export_dir);
+  ResourceAllocation first;
+  TF_ASSERT_OK(EstimateResourceFromPath(
+      export_dir, /*use_validation_result=*/false, &first));
+
+  // The files of the version are not walked again.
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(),
+                                 io::JoinPath(export_dir, "extra_file"),
+                                 string(1000, 'x')));
+  ResourceAllocation second;
+  TF_ASSERT_OK(EstimateResourceFromPath(
+      export_dir, /*use_validation_result=*/false, &second));
+  EXPECT_THAT(second, EqualsProto(first));
+}
+
 #ifdef PLATFORM_GOOGLE
 // This benchmark relies on https://github.com/google/benchmark features,
 // not available in open-sourced TF codebase.
@@ -0,0 +1,210 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// Returns the number of examples of 'input'.
+int NumExamples(const Input& input) {
+  switch (input.kind_case()) {
+    case Input::kExampleList:
+      return input.example_list().examples_size();
+    case Input::kExampleListWithContext:
+      return input.example_list_with_context().examples_size();
+    default:
+      return 0;
+  }
+}
+
+void SetRequest(const ClassificationRequest& request, PredictionLog* log) {
+  *log->mutable_classify_log()->mutable_request() = request;
+}
+
+void SetRequest(const RegressionRequest& request, PredictionLog* log) {
+  *log->mutable_regress_log()->mutable_request() = request;
+}
+
+void SetRequest(const PredictRequest& request, PredictionLog* log) {
+  *log->mutable_predict_log()->mutable_request() = request;
+}
+
+void SetRequest(const MultiInferenceRequest& request, PredictionLog* log) {
+  *log->mutable_multi_inference_log()->mutable_request() = request;
+}
+
+}  // namespace
+
+CapturedWarmupRequests* CapturedWarmupRequests::Global() {
+  static CapturedWarmupRequests* const captured_warmup_requests =
+      new CapturedWarmupRequests();
+  return captured_warmup_requests;
+}
+
+void CapturedWarmupRequests::Enable(const Options& options) {
+  mutex_lock l(mu_);
+  options_ = options;
+  for (auto& entry : models_) {
+    Evict(0, entry.second.get());
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void CapturedWarmupRequests::Capture(const string& model_name,
+                                     const ClassificationRequest& request) {
+  if (!enabled()) return;
+  CaptureRequest(model_name,
+                 strings::StrCat("classify/",
+                                 request.model_spec().signature_name(), "/",
+                                 NumExamples(request.input())),
+                 request);
+}
+
+void CapturedWarmupRequests::Capture(const string& model_name,
+                                     const RegressionRequest& request) {
+  if (!enabled()) return;
+  CaptureRequest(model_name,
+                 strings::StrCat("regress/",
+                                 request.model_spec().signature_name(), "/",
+                                 NumExamples(request.input())),
+                 request);
+}
+
+void CapturedWarmupRequests::Capture(const string& model_name,
+                                     const PredictRequest& request) {
+  if (!enabled()) return;
+  // The inputs are a map, so are sorted to make the key canonical.
+  std::vector<string> inputs;
+  inputs.reserve(request.inputs().size());
+  for (const auto& input : request.inputs()) {
+    string shape;
+    for (const auto& dim : input.second.tensor_shape().dim()) {
+      strings::StrAppend(&shape, "x", dim.size());
+    }
+    inputs.push_back(
+        strings::StrCat(input.first, ":", input.second.dtype(), ":", shape));
+  }
+  std::sort(inputs.begin(), inputs.end());
+  std::vector<string> output_filter(request.output_filter().begin(),
+                                    request.output_filter().end());
+  std::sort(output_filter.begin(), output_filter.end());
+  CaptureRequest(model_name,
+                 strings::StrCat("predict/",
+                                 request.model_spec().signature_name(), "/",
+                                 absl::StrJoin(inputs, ","), "/",
+                                 absl::StrJoin(output_filter, ",")),
+                 request);
+}
+
+void CapturedWarmupRequests::Capture(const string& model_name,
+                                     const MultiInferenceRequest& request) {
+  if (!enabled()) return;
+  string key = "multi_inference";
+  for (const InferenceTask& task : request.tasks()) {
+    strings::StrAppend(&key, "/", task.model_spec().signature_name(), ":",
+                       task.method_name());
+  }
+  strings::StrAppend(&key, "/", NumExamples(request.input()));
+  CaptureRequest(model_name, key, request);
+}
+
+template <typename Request>
+void CapturedWarmupRequests::CaptureRequest(const string& model_name,
+                                            const string& key,
+                                            const Request& request) {
+  {
+    mutex_lock l(mu_);
+    std::unique_ptr<Model>& model = models_[model_name];
+    if (model == nullptr) {
+      model.reset(new Model());
+    }
+    auto it = model->entries_by_key.find(key);
+    if (it != model->entries_by_key.end()) {
+      model->entries.splice(model->entries.end(), model->entries, it->second);
+      return;
+    }
+  }
+
+  // Serializes the request outside of the lock; a concurrent request with the
+  // same key is then captured only once, below.
+  PredictionLog log;
+  SetRequest(request, &log);
+  tstring record;
+  if (!log.SerializeToString(&record)) {
+    return;
+  }
+
+  mutex_lock l(mu_);
+  std::unique_ptr<Model>& model = models_[model_name];
+  if (model == nullptr) {
+    model.reset(new Model());
+  }
+  if (model->entries_by_key.contains(key) ||
+      static_cast<int64_t>(record.size()) > options_.max_bytes_per_model ||
+      options_.max_requests_per_model <= 0) {
+    return;
+  }
+  Evict(record.size(), model.get());
+  model->num_bytes += record.size();
+  model->entries.push_back({key, std::move(record)});
+  model->entries_by_key[key] = std::prev(model->entries.end());
+}
+
+void CapturedWarmupRequests::Evict(const int64_t num_new_bytes,
+                                   Model* model) const {
+  const int max_requests =
+      options_.max_requests_per_model - (num_new_bytes > 0 ? 1 : 0);
+  while (!model->entries.empty() &&
+         (static_cast<int>(model->entries.size()) > max_requests ||
+          model->num_bytes + num_new_bytes > options_.max_bytes_per_model)) {
+    const Entry& entry = model->entries.front();
+    model->num_bytes -= entry.record.size();
+    model->entries_by_key.erase(entry.key);
+    model->entries.pop_front();
+  }
+}
+
+std::vector<tstring> CapturedWarmupRequests::GetRecords(
+    const string& model_name) const {
+  std::vector<tstring> records;
+  mutex_lock l(mu_);
+  auto it = models_.find(model_name);
+  if (it == models_.end()) {
+    return records;
+  }
+  records.reserve(it->second->entries.size());
+  for (const Entry& entry : it->second->entries) {
+    records.push_back(entry.record);
+  }
+  return records;
+}
+
+void CapturedWarmupRequests::Clear() {
+  mutex_lock l(mu_);
+  models_.clear();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,139 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_CAPTURED_WARMUP_REQUESTS_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_CAPTURED_WARMUP_REQUESTS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_serving/apis/classification.pb.h"
+#include "tensorflow_serving/apis/inference.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/apis/regression.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Captures a sample of the live requests to each model, to warm up the later
+// versions of the model whose SavedModels ship no warmup data (see
+// ModelWarmupOptions.use_captured_warmup_requests).
+//
+// For each model, one request is kept per distinct combination of the
+// signature(s) it invokes and the shapes of its inputs (i.e. its batch size),
+// so the captured requests cover the shapes of the real traffic rather than
+// repeating the most frequent one. The requests of a model are bounded in
+// number and in size; when a new combination does not fit, the requests whose
+// combination was seen least recently are evicted.
+//
+// Only requests that succeeded should be captured, so that replaying them only
+// fails if the new version of the model is incompatible with the traffic.
+//
+// This class is thread-safe.
+class CapturedWarmupRequests {
+ public:
+  struct Options {
+    // The maximum number of requests kept per model.
+    int max_requests_per_model = 1000;
+
+    // The maximum total size of the serialized requests kept per model.
+    int64_t max_bytes_per_model = 16 << 20;
+  };
+
+  // Constructs an instance that captures nothing until Enable() is called.
+  CapturedWarmupRequests() = default;
+  ~CapturedWarmupRequests() = default;
+
+  // Returns the instance of the process, which request handlers capture
+  // into and model loading replays from.
+  static CapturedWarmupRequests* Global();
+
+  // Starts capturing requests, with the bounds of 'options'. Requests
+  // captured already are kept until they are evicted under the new bounds.
+  void Enable(const Options& options) TF_LOCKS_EXCLUDED(mu_);
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Captures 'request', served by the model 'model_name', if its combination
+  // of signature(s) and input shapes is new for the model. Otherwise only
+  // marks that combination as recently seen. No-op unless enabled().
+  void Capture(const string& model_name, const ClassificationRequest& request)
+      TF_LOCKS_EXCLUDED(mu_);
+  void Capture(const string& model_name, const RegressionRequest& request)
+      TF_LOCKS_EXCLUDED(mu_);
+  void Capture(const string& model_name, const PredictRequest& request)
+      TF_LOCKS_EXCLUDED(mu_);
+  void Capture(const string& model_name, const MultiInferenceRequest& request)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the serialized PredictionLogs of the requests captured for
+  // 'model_name', least recently seen first.
+  std::vector<tstring> GetRecords(const string& model_name) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Drops the requests captured for all models.
+  void Clear() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    string key;
+    tstring record;
+  };
+
+  // The captured requests of a model, least recently seen first.
+  struct Model {
+    std::list<Entry> entries;
+    absl::flat_hash_map<string, std::list<Entry>::iterator> entries_by_key;
+    int64_t num_bytes = 0;
+  };
+
+  // Captures 'request' under 'key', converting it to a PredictionLog only if
+  // 'key' is new for the model.
+  template <typename Request>
+  void CaptureRequest(const string& model_name, const string& key,
+                      const Request& request) TF_LOCKS_EXCLUDED(mu_);
+
+  // Evicts the least recently seen requests of 'model' until a new request of
+  // 'num_new_bytes' fits in the bounds or, if 'num_new_bytes' is 0, until the
+  // requests fit in them.
+  void Evict(int64_t num_new_bytes, Model* model) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::atomic<bool> enabled_{false};
+
+  mutable mutex mu_;
+
+  Options options_ TF_GUARDED_BY(mu_);
+
+  absl::flat_hash_map<string, std::unique_ptr<Model>> models_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CapturedWarmupRequests);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_CAPTURED_WARMUP_REQUESTS_H_
@@ -0,0 +1,133 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow_serving/apis/classification.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+PredictRequest CreatePredictRequest(const int batch_size) {
+  PredictRequest request;
+  request.mutable_model_spec()->set_signature_name("serving_default");
+  TensorProto& tensor = (*request.mutable_inputs())["x"];
+  tensor.set_dtype(DT_FLOAT);
+  tensor.mutable_tensor_shape()->add_dim()->set_size(batch_size);
+  for (int i = 0; i < batch_size; ++i) {
+    tensor.add_float_val(i);
+  }
+  return request;
+}
+
+ClassificationRequest CreateClassificationRequest(const int num_examples) {
+  ClassificationRequest request;
+  request.mutable_model_spec()->set_signature_name("classify");
+  for (int i = 0; i < num_examples; ++i) {
+    request.mutable_input()->mutable_example_list()->add_examples();
+  }
+  return request;
+}
+
+// Returns the batch sizes of the captured Predict requests of 'model_name'.
+std::vector<int64_t> GetPredictBatchSizes(
+    const CapturedWarmupRequests& captured, const string& model_name) {
+  std::vector<int64_t> batch_sizes;
+  for (const tstring& record : captured.GetRecords(model_name)) {
+    PredictionLog log;
+    EXPECT_TRUE(log.ParseFromArray(record.data(), record.size()));
+    batch_sizes.push_back(log.predict_log()
+                              .request()
+                              .inputs()
+                              .at("x")
+                              .tensor_shape()
+                              .dim(0)
+                              .size());
+  }
+  return batch_sizes;
+}
+
+TEST(CapturedWarmupRequestsTest, CapturesNothingUntilEnabled) {
+  CapturedWarmupRequests captured;
+  captured.Capture("m", CreatePredictRequest(1));
+  EXPECT_TRUE(captured.GetRecords("m").empty());
+
+  captured.Enable({});
+  captured.Capture("m", CreatePredictRequest(1));
+  EXPECT_EQ(1, captured.GetRecords("m").size());
+  EXPECT_TRUE(captured.GetRecords("other").empty());
+}
+
+TEST(CapturedWarmupRequestsTest, KeepsOneRequestPerShape) {
+  CapturedWarmupRequests captured;
+  captured.Enable({});
+  captured.Capture("m", CreatePredictRequest(1));
+  captured.Capture("m", CreatePredictRequest(2));
+  captured.Capture("m", CreatePredictRequest(1));
+  captured.Capture("m", CreateClassificationRequest(2));
+  captured.Capture("m", CreateClassificationRequest(2));
+
+  const std::vector<tstring> records = captured.GetRecords("m");
+  ASSERT_EQ(3, records.size());
+  // The request of batch size 1 was seen most recently among the Predict ones.
+  PredictionLog log;
+  ASSERT_TRUE(log.ParseFromArray(records[0].data(), records[0].size()));
+  EXPECT_EQ(2, log.predict_log().request().inputs().at("x").float_val_size());
+  ASSERT_TRUE(log.ParseFromArray(records[2].data(), records[2].size()));
+  EXPECT_EQ(2, log.classify_log()
+                   .request()
+                   .input()
+                   .example_list()
+                   .examples_size());
+}
+
+TEST(CapturedWarmupRequestsTest, EvictsLeastRecentlySeen) {
+  CapturedWarmupRequests captured;
+  CapturedWarmupRequests::Options options;
+  options.max_requests_per_model = 2;
+  captured.Enable(options);
+  captured.Capture("m", CreatePredictRequest(1));
+  captured.Capture("m", CreatePredictRequest(2));
+  captured.Capture("m", CreatePredictRequest(1));
+  captured.Capture("m", CreatePredictRequest(3));
+  EXPECT_EQ(std::vector<int64_t>({1, 3}), GetPredictBatchSizes(captured, "m"));
+
+  // Tightening the bounds evicts right away.
+  options.max_requests_per_model = 1;
+  captured.Enable(options);
+  EXPECT_EQ(std::vector<int64_t>({3}), GetPredictBatchSizes(captured, "m"));
+
+  // So does shrinking the size bound, and larger requests are not captured.
+  options.max_bytes_per_model = 16;
+  captured.Enable(options);
+  captured.Capture("m", CreatePredictRequest(100));
+  EXPECT_TRUE(GetPredictBatchSizes(captured, "m").empty());
+
+  captured.Clear();
+  EXPECT_TRUE(captured.GetRecords("m").empty());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
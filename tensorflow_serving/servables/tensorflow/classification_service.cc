@@ -21,6 +21,8 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow_serving/apis/classifier.h"
 #include "tensorflow_serving/core/servable_handle.h"
+#include "tensorflow_serving/servables/decision_forest/decision_forest.h"
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
 #include "tensorflow_serving/servables/tensorflow/classifier.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
 
@@ -50,11 +52,30 @@ Status TensorflowClassificationServiceImpl::ClassifyWithModelSpec(
   TRACELITERAL("TensorflowClassificationServiceImpl::ClassifyWithModelSpec");
 
   ServableHandle<SavedModelBundle> saved_model_bundle;
-  TF_RETURN_IF_ERROR(core->GetServableHandle(model_spec, &saved_model_bundle));
-  return RunClassify(run_options, saved_model_bundle->meta_graph_def,
-                     saved_model_bundle.id().version,
-                     saved_model_bundle->session.get(), request, response,
-                     thread_pool_options);
+  const Status status =
+      core->GetServableHandle(model_spec, &saved_model_bundle);
+  if (!status.ok()) {
+    // Models of the decision forest platform are scored natively. (The handle
+    // is released first, so as not to count twice towards concurrency limits.)
+    saved_model_bundle = ServableHandle<SavedModelBundle>();
+    ServableHandle<DecisionForestModel> forest;
+    if (!core->GetServableHandle(model_spec, &forest).ok()) {
+      return status;
+    }
+    TF_RETURN_IF_ERROR(
+        forest->Classify(request.input(), response->mutable_result()));
+    MakeModelSpec(forest.id().name, /*signature_name=*/{}, forest.id().version,
+                  response->mutable_model_spec());
+    return OkStatus();
+  }
+  TF_RETURN_IF_ERROR(
+      RunClassify(run_options, saved_model_bundle->meta_graph_def,
+                  saved_model_bundle.id().version,
+                  saved_model_bundle->session.get(), request, response,
+                  thread_pool_options));
+  CapturedWarmupRequests::Global()->Capture(saved_model_bundle.id().name,
+                                            request);
+  return OkStatus();
 }
 
 }  // namespace serving
@@ -0,0 +1,243 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/cost_accounting_session.h"
+
+#include <time.h>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+auto* run_thread_cpu_micros = ShardedCounter<2>::New(
+    "/tensorflow/serving/model_cost/run_thread_cpu_micros",
+    "The CPU time (in microseconds) of the threads running the sessions of "
+    "the model, e.g. its batch threads.",
+    "model_name", "version");
+
+auto* estimated_op_cpu_micros = ShardedCounter<2>::New(
+    "/tensorflow/serving/model_cost/estimated_op_cpu_micros",
+    "The compute time (in microseconds) of the ops of the model on CPU "
+    "threads, estimated from traced session runs.",
+    "model_name", "version");
+
+auto* estimated_gpu_micros = ShardedCounter<2>::New(
+    "/tensorflow/serving/model_cost/estimated_gpu_micros",
+    "The time (in microseconds) of the GPU kernels of the model, estimated "
+    "from traced session runs.",
+    "model_name", "version");
+
+auto* input_bytes = ShardedCounter<2>::New(
+    "/tensorflow/serving/model_cost/input_bytes",
+    "The total size of the tensors fed to the sessions of the model.",
+    "model_name", "version");
+
+auto* output_bytes = ShardedCounter<2>::New(
+    "/tensorflow/serving/model_cost/output_bytes",
+    "The total size of the tensors fetched from the sessions of the model.",
+    "model_name", "version");
+
+int64_t ThreadCpuMicros() {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Adds the op times in 'step_stats' to 'cpu_micros' and 'gpu_micros'. The
+// kernels of a GPU are the stats of its "stream:all" device, which sums those
+// of its streams.
+void AddOpTimes(const StepStats& step_stats, int64_t* cpu_micros,
+                int64_t* gpu_micros) {
+  for (const DeviceStepStats& device_stats : step_stats.dev_stats()) {
+    const string& device = device_stats.device();
+    int64_t* micros = cpu_micros;
+    if (absl::EndsWith(device, "/stream:all")) {
+      micros = gpu_micros;
+    } else if (absl::StrContains(device, "/stream:") ||
+               absl::StrContains(device, "/memcpy")) {
+      continue;
+    }
+    for (const NodeExecStats& node_stats : device_stats.node_stats()) {
+      *micros +=
+          node_stats.op_end_rel_micros() - node_stats.op_start_rel_micros();
+    }
+  }
+}
+
+int64_t TotalBytes(const std::vector<std::pair<string, Tensor>>& tensors) {
+  int64_t bytes = 0;
+  for (const auto& tensor : tensors) {
+    bytes += tensor.second.TotalBytes();
+  }
+  return bytes;
+}
+
+int64_t TotalBytes(const std::vector<Tensor>& tensors) {
+  int64_t bytes = 0;
+  for (const Tensor& tensor : tensors) {
+    bytes += tensor.TotalBytes();
+  }
+  return bytes;
+}
+
+}  // namespace
+
+ServableCosts GetServableCosts(const ServableId& servable_id) {
+  const string version = absl::StrCat(servable_id.version);
+  ServableCosts costs;
+  costs.run_thread_cpu_micros =
+      run_thread_cpu_micros->GetCell(servable_id.name, version)->value();
+  costs.estimated_op_cpu_micros =
+      estimated_op_cpu_micros->GetCell(servable_id.name, version)->value();
+  costs.estimated_gpu_micros =
+      estimated_gpu_micros->GetCell(servable_id.name, version)->value();
+  costs.input_bytes = input_bytes->GetCell(servable_id.name, version)->value();
+  costs.output_bytes =
+      output_bytes->GetCell(servable_id.name, version)->value();
+  return costs;
+}
+
+CostAccountingSession::CostAccountingSession(std::unique_ptr<Session> wrapped,
+                                             const ServableId& servable_id,
+                                             int trace_interval)
+    : ServingSessionWrapper(std::move(wrapped)),
+      trace_interval_(trace_interval),
+      run_thread_cpu_micros_(run_thread_cpu_micros->GetCell(
+          servable_id.name, absl::StrCat(servable_id.version))),
+      estimated_op_cpu_micros_(estimated_op_cpu_micros->GetCell(
+          servable_id.name, absl::StrCat(servable_id.version))),
+      estimated_gpu_micros_(estimated_gpu_micros->GetCell(
+          servable_id.name, absl::StrCat(servable_id.version))),
+      input_bytes_(input_bytes->GetCell(servable_id.name,
+                                        absl::StrCat(servable_id.version))),
+      output_bytes_(output_bytes->GetCell(
+          servable_id.name, absl::StrCat(servable_id.version))) {}
+
+Status CostAccountingSession::MeteredRun(
+    const RunOptions* run_options, RunMetadata* run_metadata,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<Tensor>* outputs,
+    const std::function<Status(const RunOptions*, RunMetadata*)>& run) {
+  const bool sampled =
+      trace_interval_ > 0 &&
+      num_runs_.fetch_add(1, std::memory_order_relaxed) % trace_interval_ == 0;
+  // The traces callers ask for themselves are left alone, and not counted
+  // since they are not sampled.
+  const bool trace =
+      sampled && (run_options == nullptr ||
+                  run_options->trace_level() == RunOptions::NO_TRACE);
+  RunOptions traced_run_options;
+  RunMetadata traced_run_metadata;
+  if (trace) {
+    if (run_options != nullptr) {
+      traced_run_options = *run_options;
+    }
+    traced_run_options.set_trace_level(RunOptions::HARDWARE_TRACE);
+    run_options = &traced_run_options;
+    if (run_metadata == nullptr) {
+      run_metadata = &traced_run_metadata;
+    }
+  }
+
+  const int64_t start_cpu_micros = ThreadCpuMicros();
+  const Status status = run(run_options, run_metadata);
+  run_thread_cpu_micros_->IncrementBy(ThreadCpuMicros() - start_cpu_micros);
+  input_bytes_->IncrementBy(TotalBytes(inputs));
+  if (status.ok()) {
+    output_bytes_->IncrementBy(TotalBytes(*outputs));
+  }
+  if (trace) {
+    int64_t cpu_micros = 0;
+    int64_t gpu_micros = 0;
+    AddOpTimes(run_metadata->step_stats(), &cpu_micros, &gpu_micros);
+    estimated_op_cpu_micros_->IncrementBy(cpu_micros * trace_interval_);
+    estimated_gpu_micros_->IncrementBy(gpu_micros * trace_interval_);
+    // The caller did not ask for the trace.
+    run_metadata->clear_step_stats();
+  }
+  return status;
+}
+
+Status CostAccountingSession::Run(
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names,
+    std::vector<Tensor>* outputs) {
+  return MeteredRun(
+      nullptr, nullptr, inputs, outputs,
+      [&](const RunOptions* run_options, RunMetadata* run_metadata) {
+        if (run_options == nullptr) {
+          return ServingSessionWrapper::Run(inputs, output_tensor_names,
+                                            target_node_names, outputs);
+        }
+        return ServingSessionWrapper::Run(*run_options, inputs,
+                                          output_tensor_names,
+                                          target_node_names, outputs,
+                                          run_metadata);
+      });
+}
+
+Status CostAccountingSession::Run(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
+    RunMetadata* run_metadata) {
+  return MeteredRun(
+      &run_options, run_metadata, inputs, outputs,
+      [&](const RunOptions* metered_run_options,
+          RunMetadata* metered_run_metadata) {
+        return ServingSessionWrapper::Run(
+            *metered_run_options, inputs, output_tensor_names,
+            target_node_names, outputs, metered_run_metadata);
+      });
+}
+
+Status CostAccountingSession::Run(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
+    RunMetadata* run_metadata,
+    const thread::ThreadPoolOptions& thread_pool_options) {
+  return MeteredRun(
+      &run_options, run_metadata, inputs, outputs,
+      [&](const RunOptions* metered_run_options,
+          RunMetadata* metered_run_metadata) {
+        return ServingSessionWrapper::Run(
+            *metered_run_options, inputs, output_tensor_names,
+            target_node_names, outputs, metered_run_metadata,
+            thread_pool_options);
+      });
+}
+
+void CostAccountingSession::RunAsync(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
+    RunMetadata* run_metadata, std::function<void(const Status&)> done) {
+  done(Run(run_options, inputs, output_tensor_names, target_node_names,
+           outputs, run_metadata));
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,127 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_COST_ACCOUNTING_SESSION_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_COST_ACCOUNTING_SESSION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow_serving/core/servable_id.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+#include "tensorflow_serving/util/sharded_metrics.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The costs of the Runs of a servable's session, as recorded by a
+// CostAccountingSession.
+struct ServableCosts {
+  // The CPU time of the threads that called Run().
+  int64_t run_thread_cpu_micros = 0;
+  // Estimated from traced Runs: the compute time of the ops on CPU threads,
+  // including those of the inter-op thread pools, and the time of the kernels
+  // on GPU streams.
+  int64_t estimated_op_cpu_micros = 0;
+  int64_t estimated_gpu_micros = 0;
+  // The total size of the feeds and fetches of the Runs.
+  int64_t input_bytes = 0;
+  int64_t output_bytes = 0;
+};
+
+// Returns the costs recorded for 'servable_id' so far.
+ServableCosts GetServableCosts(const ServableId& servable_id);
+
+// A session that attributes the costs of its Runs to a servable, in the
+// /tensorflow/serving/model_cost/... counters labeled by model name and
+// version, e.g. to bill the owners of models or to find the models worth
+// optimizing first.
+//
+// It goes innermost of the session wrappers of the servable, so that it runs on
+// the thread that does the work: with batching that is the batch thread, and
+// the costs of a batch, padding included, go to the servable as a whole. The
+// CPU time of that thread is measured around each Run. Work the Run hands to
+// other threads, such as the inter-op thread pools and the GPU, is only seen in
+// the step stats of traced Runs, so every 'trace_interval'-th Run is traced
+// (0 for none) and its op times count 'trace_interval' times.
+class CostAccountingSession : public ServingSessionWrapper {
+ public:
+  CostAccountingSession(std::unique_ptr<Session> wrapped,
+                        const ServableId& servable_id, int trace_interval);
+
+  ~CostAccountingSession() override = default;
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override;
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override;
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override;
+
+  // Runs synchronously, like the sessions of servables do, so that the thread
+  // doing the work is the one measured.
+  void RunAsync(const RunOptions& run_options,
+                const std::vector<std::pair<string, Tensor>>& inputs,
+                const std::vector<string>& output_tensor_names,
+                const std::vector<string>& target_node_names,
+                std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+                std::function<void(const Status&)> done) override;
+
+ private:
+  // Calls 'run' with the RunOptions and RunMetadata to run with, which trace
+  // the Run if it is sampled, and records the costs of the Run.
+  Status MeteredRun(
+      const RunOptions* run_options, RunMetadata* run_metadata,
+      const std::vector<std::pair<string, Tensor>>& inputs,
+      const std::vector<Tensor>* outputs,
+      const std::function<Status(const RunOptions*, RunMetadata*)>& run);
+
+  const int trace_interval_;
+  std::atomic<uint64_t> num_runs_{0};
+
+  // The cells of the servable in the cost counters.
+  ShardedCounterCell* const run_thread_cpu_micros_;
+  ShardedCounterCell* const estimated_op_cpu_micros_;
+  ShardedCounterCell* const estimated_gpu_micros_;
+  ShardedCounterCell* const input_bytes_;
+  ShardedCounterCell* const output_bytes_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CostAccountingSession);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_COST_ACCOUNTING_SESSION_H_
@@ -0,0 +1,165 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/cost_accounting_session.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// A session that returns its feeds as fetches after spinning for a while, and
+// reports ops on a CPU and on a GPU when traced.
+class FakeSession : public ServingSession {
+ public:
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    return Run(RunOptions(), inputs, output_tensor_names, target_node_names,
+               outputs, nullptr);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    trace_levels_.push_back(run_options.trace_level());
+    const uint64_t end_micros = Env::Default()->NowMicros() + 10 * 1000;
+    while (Env::Default()->NowMicros() < end_micros) {
+    }
+    for (const auto& input : inputs) {
+      outputs->push_back(input.second);
+    }
+    if (run_options.trace_level() != RunOptions::NO_TRACE &&
+        run_metadata != nullptr) {
+      AddDeviceStats("/job:localhost/replica:0/task:0/device:CPU:0", 100,
+                     run_metadata);
+      AddDeviceStats("/device:GPU:0/stream:all", 30, run_metadata);
+      AddDeviceStats("/device:GPU:0/stream:7", 30, run_metadata);
+    }
+    return OkStatus();
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    return Run(run_options, inputs, output_tensor_names, target_node_names,
+               outputs, run_metadata);
+  }
+
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return OkStatus();
+  }
+
+  const std::vector<RunOptions::TraceLevel>& trace_levels() const {
+    return trace_levels_;
+  }
+
+ private:
+  static void AddDeviceStats(const string& device, int64_t op_micros,
+                             RunMetadata* run_metadata) {
+    DeviceStepStats* device_stats =
+        run_metadata->mutable_step_stats()->add_dev_stats();
+    device_stats->set_device(device);
+    NodeExecStats* node_stats = device_stats->add_node_stats();
+    node_stats->set_op_start_rel_micros(5);
+    node_stats->set_op_end_rel_micros(5 + op_micros);
+  }
+
+  std::vector<RunOptions::TraceLevel> trace_levels_;
+};
+
+std::vector<std::pair<string, Tensor>> MakeInputs() {
+  return {{"x", test::AsTensor<float>(std::vector<float>(10, 1.0),
+                                      TensorShape({10}))}};
+}
+
+TEST(CostAccountingSessionTest, RecordsCpuAndBytes) {
+  const ServableId id = {"bytes_model", 3};
+  CostAccountingSession session(std::make_unique<FakeSession>(), id,
+                                /*trace_interval=*/0);
+  for (int i = 0; i < 2; ++i) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session.Run(RunOptions(), MakeInputs(), {"x"}, {}, &outputs,
+                             nullptr));
+  }
+
+  const ServableCosts costs = GetServableCosts(id);
+  EXPECT_GT(costs.run_thread_cpu_micros, 0);
+  EXPECT_EQ(0, costs.estimated_op_cpu_micros);
+  EXPECT_EQ(0, costs.estimated_gpu_micros);
+  EXPECT_EQ(2 * 10 * sizeof(float), costs.input_bytes);
+  EXPECT_EQ(2 * 10 * sizeof(float), costs.output_bytes);
+  // Other versions have costs of their own.
+  EXPECT_EQ(0, GetServableCosts({"bytes_model", 4}).input_bytes);
+}
+
+TEST(CostAccountingSessionTest, SamplesTracedRuns) {
+  const ServableId id = {"traced_model", 1};
+  auto wrapped = std::make_unique<FakeSession>();
+  FakeSession* fake = wrapped.get();
+  CostAccountingSession session(std::move(wrapped), id,
+                                /*trace_interval=*/2);
+  for (int i = 0; i < 4; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session.Run(RunOptions(), MakeInputs(), {"x"}, {}, &outputs,
+                             &run_metadata));
+    // The caller gets no trace it did not ask for.
+    EXPECT_FALSE(run_metadata.has_step_stats());
+  }
+
+  EXPECT_EQ(std::vector<RunOptions::TraceLevel>(
+                {RunOptions::HARDWARE_TRACE, RunOptions::NO_TRACE,
+                 RunOptions::HARDWARE_TRACE, RunOptions::NO_TRACE}),
+            fake->trace_levels());
+  // Two traced Runs, each standing for two.
+  const ServableCosts costs = GetServableCosts(id);
+  EXPECT_EQ(2 * 2 * 100, costs.estimated_op_cpu_micros);
+  EXPECT_EQ(2 * 2 * 30, costs.estimated_gpu_micros);
+}
+
+TEST(CostAccountingSessionTest, LeavesTracesOfCallersAlone) {
+  const ServableId id = {"caller_traced_model", 1};
+  CostAccountingSession session(std::make_unique<FakeSession>(), id,
+                                /*trace_interval=*/1);
+  RunOptions run_options;
+  run_options.set_trace_level(RunOptions::SOFTWARE_TRACE);
+  std::vector<Tensor> outputs;
+  RunMetadata run_metadata;
+  TF_ASSERT_OK(session.Run(run_options, MakeInputs(), {"x"}, {}, &outputs,
+                           &run_metadata));
+
+  EXPECT_EQ(3, run_metadata.step_stats().dev_stats_size());
+  EXPECT_EQ(0, GetServableCosts(id).estimated_op_cpu_micros);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,178 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/dedicated_thread_pool_factory.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow_serving/util/cpu_set_env.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// A thread pool along with the Env that started its threads.
+class OwnedThreadPool final : public thread::ThreadPoolInterface {
+ public:
+  OwnedThreadPool(std::shared_ptr<Env> env, const string& name,
+                  int num_threads)
+      : env_(std::move(env)), pool_(env_.get(), name, num_threads) {}
+
+  void Schedule(std::function<void()> fn) override {
+    pool_.AsEigenThreadPool()->Schedule(std::move(fn));
+  }
+  int NumThreads() const override { return pool_.NumThreads(); }
+  int CurrentThreadId() const override { return pool_.CurrentThreadId(); }
+
+ private:
+  const std::shared_ptr<Env> env_;
+  thread::ThreadPool pool_;
+};
+
+// Returns a pool of 'num_threads' threads started by 'env', or null if
+// 'num_threads' is 0.
+std::shared_ptr<thread::ThreadPoolInterface> CreateThreadPool(
+    std::shared_ptr<Env> env, const string& name, int num_threads) {
+  if (num_threads == 0) {
+    return nullptr;
+  }
+  return std::make_shared<OwnedThreadPool>(std::move(env), name, num_threads);
+}
+
+}  // namespace
+
+constexpr int RequestCostModel::kMinRuns;
+
+void RequestCostModel::Record(const int64_t input_bytes,
+                              const int64_t run_micros) {
+  ++num_runs_;
+  // The first runs weigh equally, to start from their plain mean.
+  const double weight = std::max(decay_, 1.0 / num_runs_);
+  const double bytes_delta = input_bytes - mean_bytes_;
+  const double micros_delta = run_micros - mean_micros_;
+  mean_bytes_ += weight * bytes_delta;
+  mean_micros_ += weight * micros_delta;
+  bytes_variance_ =
+      (1 - weight) * (bytes_variance_ + weight * bytes_delta * bytes_delta);
+  covariance_ =
+      (1 - weight) * (covariance_ + weight * bytes_delta * micros_delta);
+}
+
+int64_t RequestCostModel::PredictMicros(const int64_t input_bytes) const {
+  if (num_runs_ < kMinRuns) {
+    return -1;
+  }
+  // Larger inputs never make for shorter runs.
+  const double micros_per_byte =
+      bytes_variance_ > 0 ? std::max(0.0, covariance_ / bytes_variance_) : 0;
+  return std::max<int64_t>(
+      0, mean_micros_ + micros_per_byte * (input_bytes - mean_bytes_));
+}
+
+Status DedicatedThreadPoolFactory::Create(
+    const Options& options,
+    std::unique_ptr<DedicatedThreadPoolFactory>* result) {
+  if (options.num_inter_op_threads < 0 || options.num_intra_op_threads < 0 ||
+      options.num_large_intra_op_threads < 0) {
+    return errors::InvalidArgument(
+        "Thread pools of ", options.name,
+        " must not have a negative number of threads");
+  }
+  for (const int cpu : options.cpus) {
+    if (cpu < 0) {
+      return errors::InvalidArgument("Invalid CPU ", cpu,
+                                     " for the threads of ", options.name);
+    }
+  }
+  if (options.inline_max_cost_micros < 0 || options.large_min_cost_micros < 0) {
+    return errors::InvalidArgument("Cost thresholds of ", options.name,
+                                   " must not be negative");
+  }
+  if (options.large_min_cost_micros > 0 &&
+      options.large_min_cost_micros <= options.inline_max_cost_micros) {
+    return errors::InvalidArgument(
+        "The large requests of ", options.name,
+        " must cost more than the inline ones; got large_min_cost_micros ",
+        options.large_min_cost_micros, " and inline_max_cost_micros ",
+        options.inline_max_cost_micros);
+  }
+  auto env = std::make_shared<CpuSetEnv>(Env::Default(), options.cpus);
+  result->reset(new DedicatedThreadPoolFactory(
+      options,
+      CreateThreadPool(env, strings::StrCat(options.name, "_inter_op"),
+                       options.num_inter_op_threads),
+      CreateThreadPool(env, strings::StrCat(options.name, "_intra_op"),
+                       options.num_intra_op_threads),
+      CreateThreadPool(env, strings::StrCat(options.name, "_large_intra_op"),
+                       options.large_min_cost_micros > 0
+                           ? options.num_large_intra_op_threads
+                           : 0)));
+  return OkStatus();
+}
+
+DedicatedThreadPoolFactory::DedicatedThreadPoolFactory(
+    const Options& options,
+    std::shared_ptr<thread::ThreadPoolInterface> inter_op_thread_pool,
+    std::shared_ptr<thread::ThreadPoolInterface> intra_op_thread_pool,
+    std::shared_ptr<thread::ThreadPoolInterface> large_intra_op_thread_pool)
+    : options_(options),
+      inter_op_thread_pool_(std::move(inter_op_thread_pool)),
+      intra_op_thread_pool_(std::move(intra_op_thread_pool)),
+      large_intra_op_thread_pool_(std::move(large_intra_op_thread_pool)) {}
+
+ScopedThreadPools DedicatedThreadPoolFactory::GetThreadPoolsForRequest(
+    const string& cost_key, const int64_t input_bytes) {
+  if (!options_.adaptive()) {
+    return GetThreadPools();
+  }
+  int64_t expected_micros = -1;
+  {
+    mutex_lock l(mu_);
+    auto it = cost_models_.find(cost_key);
+    if (it != cost_models_.end()) {
+      expected_micros = it->second.PredictMicros(input_bytes);
+    }
+  }
+  if (expected_micros < 0) {
+    return GetThreadPools();
+  }
+  if (expected_micros < options_.inline_max_cost_micros) {
+    return ScopedThreadPools(GetInlineThreadPool(), GetInlineThreadPool());
+  }
+  if (large_intra_op_thread_pool_ != nullptr &&
+      expected_micros >= options_.large_min_cost_micros) {
+    return ScopedThreadPools(inter_op_thread_pool_,
+                             large_intra_op_thread_pool_);
+  }
+  return GetThreadPools();
+}
+
+void DedicatedThreadPoolFactory::RecordRequestCost(const string& cost_key,
+                                                   const int64_t input_bytes,
+                                                   const int64_t run_micros) {
+  if (!options_.adaptive()) {
+    return;
+  }
+  mutex_lock l(mu_);
+  cost_models_[cost_key].Record(input_bytes, run_micros);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,149 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_DEDICATED_THREAD_POOL_FACTORY_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_DEDICATED_THREAD_POOL_FACTORY_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Learns the run time of the requests of a signature as a linear function of
+// the size of their inputs, by least squares over their runs, weighted to
+// favor the recent ones.
+//
+// This class is not thread-safe.
+class RequestCostModel {
+ public:
+  // The runs after which PredictMicros() trusts the model.
+  static constexpr int kMinRuns = 8;
+
+  // 'decay' is the weight of each new run against those before it, once
+  // there have been 1 / 'decay' runs.
+  explicit RequestCostModel(double decay = 0.05) : decay_(decay) {}
+
+  void Record(int64_t input_bytes, int64_t run_micros);
+
+  // Returns the expected run time of a request with 'input_bytes' of inputs,
+  // or -1 until kMinRuns runs are recorded.
+  int64_t PredictMicros(int64_t input_bytes) const;
+
+ private:
+  const double decay_;
+  int64_t num_runs_ = 0;
+  // The weighted means of the input sizes and run times, the variance of the
+  // input sizes and their covariance with the run times.
+  double mean_bytes_ = 0;
+  double mean_micros_ = 0;
+  double bytes_variance_ = 0;
+  double covariance_ = 0;
+};
+
+// A ThreadPoolFactory that owns inter- and intra-op thread pools, and returns
+// them for every request, e.g. to run the requests of one model (or a class of
+// models) on threads of their own. See ModelConfig.thread_pool_config.
+//
+// In adaptive mode, the factory picks the pools of each request by its
+// expected run time (see RequestCostModel), so that small requests skip the
+// handoffs to the pools and large ones parallelize wider:
+//
+//   * below 'inline_max_cost_micros', the request runs all its ops on the
+//     thread that calls Session::Run();
+//   * from 'large_min_cost_micros', its ops parallelize on an intra-op pool
+//     of 'num_large_intra_op_threads';
+//   * other requests, and those of signatures with too few runs to tell, get
+//     the pools of GetThreadPools().
+//
+// This class is thread-safe.
+class DedicatedThreadPoolFactory final : public ThreadPoolFactory {
+ public:
+  struct Options {
+    // Names the threads of the pools.
+    string name = "dedicated";
+
+    // The number of threads of each pool. 0 creates no pool, so that
+    // TensorFlow falls back to the pool of the session.
+    int num_inter_op_threads = 0;
+    int num_intra_op_threads = 0;
+
+    // If non-empty, the threads only run on these CPUs (on Linux).
+    std::vector<int> cpus;
+
+    // Adaptive mode, which is on if either threshold is positive. 0 turns off
+    // the inline or the large requests, respectively.
+    int64_t inline_max_cost_micros = 0;
+    int64_t large_min_cost_micros = 0;
+    int num_large_intra_op_threads = 0;
+
+    bool adaptive() const {
+      return inline_max_cost_micros > 0 || large_min_cost_micros > 0;
+    }
+  };
+
+  static Status Create(const Options& options,
+                       std::unique_ptr<DedicatedThreadPoolFactory>* result);
+
+  ~DedicatedThreadPoolFactory() override = default;
+
+  // The pools outlive this factory for as long as the returned
+  // ScopedThreadPools hold them.
+  ScopedThreadPools GetThreadPools() override {
+    return ScopedThreadPools(inter_op_thread_pool_, intra_op_thread_pool_);
+  }
+
+  ScopedThreadPools GetThreadPoolsForRequest(const string& cost_key,
+                                             int64_t input_bytes) override
+      TF_LOCKS_EXCLUDED(mu_);
+
+  void RecordRequestCost(const string& cost_key, int64_t input_bytes,
+                         int64_t run_micros) override TF_LOCKS_EXCLUDED(mu_);
+
+  const Options& options() const { return options_; }
+
+ private:
+  DedicatedThreadPoolFactory(
+      const Options& options,
+      std::shared_ptr<thread::ThreadPoolInterface> inter_op_thread_pool,
+      std::shared_ptr<thread::ThreadPoolInterface> intra_op_thread_pool,
+      std::shared_ptr<thread::ThreadPoolInterface> large_intra_op_thread_pool);
+
+  const Options options_;
+  const std::shared_ptr<thread::ThreadPoolInterface> inter_op_thread_pool_;
+  const std::shared_ptr<thread::ThreadPoolInterface> intra_op_thread_pool_;
+  const std::shared_ptr<thread::ThreadPoolInterface>
+      large_intra_op_thread_pool_;
+
+  mutex mu_;
+  std::map<string, RequestCostModel> cost_models_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DedicatedThreadPoolFactory);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_DEDICATED_THREAD_POOL_FACTORY_H_
@@ -0,0 +1,146 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/dedicated_thread_pool_factory.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(DedicatedThreadPoolFactoryTest, CreatesPools) {
+  DedicatedThreadPoolFactory::Options options;
+  options.num_inter_op_threads = 2;
+  options.num_intra_op_threads = 3;
+  std::unique_ptr<DedicatedThreadPoolFactory> factory;
+  TF_ASSERT_OK(DedicatedThreadPoolFactory::Create(options, &factory));
+
+  ScopedThreadPools thread_pools = factory->GetThreadPools();
+  const thread::ThreadPoolOptions pool_options = thread_pools.get();
+  ASSERT_NE(nullptr, pool_options.inter_op_threadpool);
+  ASSERT_NE(nullptr, pool_options.intra_op_threadpool);
+  EXPECT_EQ(2, pool_options.inter_op_threadpool->NumThreads());
+  EXPECT_EQ(3, pool_options.intra_op_threadpool->NumThreads());
+  // Every request gets the same pools.
+  EXPECT_EQ(pool_options.inter_op_threadpool,
+            factory->GetThreadPools().get().inter_op_threadpool);
+
+  // The pools outlive the factory while in use.
+  factory.reset();
+  Notification ran;
+  pool_options.inter_op_threadpool->Schedule([&ran] { ran.Notify(); });
+  ran.WaitForNotification();
+}
+
+TEST(DedicatedThreadPoolFactoryTest, ZeroThreadsCreatesNoPool) {
+  DedicatedThreadPoolFactory::Options options;
+  options.num_intra_op_threads = 1;
+  options.cpus = {0};
+  std::unique_ptr<DedicatedThreadPoolFactory> factory;
+  TF_ASSERT_OK(DedicatedThreadPoolFactory::Create(options, &factory));
+  EXPECT_EQ(nullptr, factory->GetThreadPools().get().inter_op_threadpool);
+  EXPECT_NE(nullptr, factory->GetThreadPools().get().intra_op_threadpool);
+}
+
+TEST(RequestCostModelTest, LearnsLinearCost) {
+  RequestCostModel model;
+  // Runs take 100us plus 1us per 10 bytes.
+  for (int i = 0; i < RequestCostModel::kMinRuns - 1; ++i) {
+    model.Record(1000 * (i % 3), 100 + 100 * (i % 3));
+    EXPECT_EQ(-1, model.PredictMicros(0));
+  }
+  for (int i = 0; i < 100; ++i) {
+    model.Record(1000 * (i % 3), 100 + 100 * (i % 3));
+  }
+  EXPECT_NEAR(100, model.PredictMicros(0), 1);
+  EXPECT_NEAR(1100, model.PredictMicros(10000), 1);
+}
+
+TEST(RequestCostModelTest, NeverPredictsShorterRunsForLargerInputs) {
+  RequestCostModel model;
+  for (int i = 0; i < 100; ++i) {
+    model.Record(1000 * (i % 2), 500 - 100 * (i % 2));
+  }
+  EXPECT_EQ(model.PredictMicros(0), model.PredictMicros(1000000));
+}
+
+TEST(DedicatedThreadPoolFactoryTest, AdaptivePicksPoolsByCost) {
+  DedicatedThreadPoolFactory::Options options;
+  options.num_inter_op_threads = 1;
+  options.num_intra_op_threads = 2;
+  options.inline_max_cost_micros = 100;
+  options.large_min_cost_micros = 1000;
+  options.num_large_intra_op_threads = 4;
+  std::unique_ptr<DedicatedThreadPoolFactory> factory;
+  TF_ASSERT_OK(DedicatedThreadPoolFactory::Create(options, &factory));
+  const thread::ThreadPoolOptions default_pools =
+      factory->GetThreadPools().get();
+
+  // Until the signature has runs to learn from, it gets the default pools.
+  EXPECT_EQ(default_pools.intra_op_threadpool,
+            factory->GetThreadPoolsForRequest("m/small", 10)
+                .get()
+                .intra_op_threadpool);
+  for (int i = 0; i < RequestCostModel::kMinRuns; ++i) {
+    factory->RecordRequestCost("m/small", 10, 20);
+    factory->RecordRequestCost("m/medium", 10, 500);
+    factory->RecordRequestCost("m/large", 10, 5000);
+  }
+
+  // Small requests run inline.
+  ScopedThreadPools small_pools =
+      factory->GetThreadPoolsForRequest("m/small", 10);
+  thread::ThreadPoolInterface* const inline_pool =
+      small_pools.get().inter_op_threadpool;
+  ASSERT_NE(nullptr, inline_pool);
+  EXPECT_NE(default_pools.inter_op_threadpool, inline_pool);
+  int ran_on = 0;
+  inline_pool->Schedule([&ran_on]() { ran_on = 1; });
+  EXPECT_EQ(1, ran_on);
+
+  EXPECT_EQ(default_pools.intra_op_threadpool,
+            factory->GetThreadPoolsForRequest("m/medium", 10)
+                .get()
+                .intra_op_threadpool);
+
+  const thread::ThreadPoolOptions large_pools =
+      factory->GetThreadPoolsForRequest("m/large", 10).get();
+  EXPECT_EQ(default_pools.inter_op_threadpool, large_pools.inter_op_threadpool);
+  ASSERT_NE(nullptr, large_pools.intra_op_threadpool);
+  EXPECT_EQ(4, large_pools.intra_op_threadpool->NumThreads());
+}
+
+TEST(DedicatedThreadPoolFactoryTest, InvalidOptions) {
+  std::unique_ptr<DedicatedThreadPoolFactory> factory;
+  DedicatedThreadPoolFactory::Options options;
+  options.num_inter_op_threads = -1;
+  EXPECT_FALSE(DedicatedThreadPoolFactory::Create(options, &factory).ok());
+  options.num_inter_op_threads = 1;
+  options.cpus = {-1};
+  EXPECT_FALSE(DedicatedThreadPoolFactory::Create(options, &factory).ok());
+  options.cpus.clear();
+  options.inline_max_cost_micros = 1000;
+  options.large_min_cost_micros = 100;
+  EXPECT_FALSE(DedicatedThreadPoolFactory::Create(options, &factory).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
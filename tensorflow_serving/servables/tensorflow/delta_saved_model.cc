@@ -0,0 +1,194 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/delta_saved_model.h"
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/saver.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace serving {
+
+const char kDeltaManifestFilename[] = "delta_manifest.pb";
+
+namespace {
+
+// A RestoreV2 or SaveV2 node of a saver, and the checkpoint keys it restores
+// or saves.
+struct SaverNode {
+  const NodeDef* node;
+  std::vector<string> keys;
+};
+
+// Finds the nodes of 'graph_def' with op 'op', which take the checkpoint keys
+// and slices as inputs 1 and 2, like RestoreV2 and SaveV2. Fails if they
+// restore or save variables in slices.
+Status FindSaverNodes(const GraphDef& graph_def, const string& op,
+                      std::vector<SaverNode>* saver_nodes) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  const auto get_const_value = [&nodes](const string& input, Tensor* value) {
+    auto it = nodes.find(string(ParseTensorName(input).node()));
+    if (it == nodes.end() || it->second->op() != "Const" ||
+        !value->FromProto(it->second->attr().at("value").tensor())) {
+      return errors::Unimplemented("Input ", input, " is not a constant");
+    }
+    return OkStatus();
+  };
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() != op) {
+      continue;
+    }
+    Tensor keys, shape_and_slices;
+    TF_RETURN_IF_ERROR(get_const_value(node.input(1), &keys));
+    TF_RETURN_IF_ERROR(get_const_value(node.input(2), &shape_and_slices));
+    SaverNode saver_node = {&node, {}};
+    for (int i = 0; i < keys.NumElements(); ++i) {
+      saver_node.keys.push_back(string(keys.flat<tstring>()(i)));
+      if (!shape_and_slices.flat<tstring>()(i).empty()) {
+        return errors::Unimplemented("Variable ", saver_node.keys.back(),
+                                     " is saved in slices");
+      }
+    }
+    saver_nodes->push_back(std::move(saver_node));
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+Status ReadDeltaManifest(const string& export_dir, DeltaManifest* manifest,
+                         bool* found) {
+  const string path = io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                                   kDeltaManifestFilename);
+  *found = Env::Default()->FileExists(path).ok();
+  if (!*found) {
+    return OkStatus();
+  }
+  return ReadBinaryProto(Env::Default(), path, manifest);
+}
+
+Status GetSavedTensors(const MetaGraphDef& meta_graph_def,
+                       std::map<string, string>* tensor_by_key) {
+  std::vector<SaverNode> save_nodes;
+  TF_RETURN_IF_ERROR(
+      FindSaverNodes(meta_graph_def.graph_def(), "SaveV2", &save_nodes));
+  // SaveV2 takes the tensors to save after the prefix, keys and slices.
+  for (const SaverNode& save_node : save_nodes) {
+    for (int i = 0; i < save_node.keys.size(); ++i) {
+      (*tensor_by_key)[save_node.keys[i]] = save_node.node->input(3 + i);
+    }
+  }
+  return OkStatus();
+}
+
+Status LoadDeltaSavedModel(const SessionOptions& session_options,
+                           const RunOptions& run_options,
+                           const string& export_dir,
+                           const std::unordered_set<string>& tags,
+                           Session* base_session,
+                           const std::map<string, string>& base_tensor_by_key,
+                           SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  MetaGraphDef& meta_graph_def = bundle->meta_graph_def;
+  if (!meta_graph_def.has_saver_def()) {
+    return errors::FailedPrecondition("Delta SavedModel ", export_dir,
+                                      " has no variables");
+  }
+  std::vector<SaverNode> restore_nodes;
+  TF_RETURN_IF_ERROR(
+      FindSaverNodes(meta_graph_def.graph_def(), "RestoreV2", &restore_nodes));
+
+  // Feeds the outputs of the restore ops with the changed variables from the
+  // delta checkpoint and the others from the base session, so that the
+  // restore ops themselves do not run.
+  const string checkpoint_prefix = io::JoinPath(
+      export_dir, kSavedModelVariablesDirectory, kSavedModelVariablesFilename);
+  BundleReader delta_reader(Env::Default(), checkpoint_prefix);
+  TF_RETURN_IF_ERROR(delta_reader.status());
+  std::vector<std::pair<string, Tensor>> feeds;
+  std::vector<string> base_fetches, base_feeds;
+  for (const SaverNode& restore_node : restore_nodes) {
+    for (int i = 0; i < restore_node.keys.size(); ++i) {
+      const string& key = restore_node.keys[i];
+      const string restored_tensor =
+          TensorId(restore_node.node->name(), i).ToString();
+      if (delta_reader.Contains(key)) {
+        Tensor value;
+        TF_RETURN_IF_ERROR(delta_reader.Lookup(key, &value));
+        feeds.push_back({restored_tensor, std::move(value)});
+        continue;
+      }
+      auto base_tensor = base_tensor_by_key.find(key);
+      if (base_tensor == base_tensor_by_key.end()) {
+        return errors::NotFound("Variable ", key, " of delta SavedModel ",
+                                export_dir,
+                                " is in neither its checkpoint nor its base");
+      }
+      base_fetches.push_back(base_tensor->second);
+      base_feeds.push_back(restored_tensor);
+    }
+  }
+  const int num_changed = feeds.size();
+  if (!base_fetches.empty()) {
+    std::vector<Tensor> base_values;
+    TF_RETURN_IF_ERROR(base_session->Run(run_options, {}, base_fetches, {},
+                                         &base_values, nullptr));
+    for (int i = 0; i < base_values.size(); ++i) {
+      feeds.push_back({base_feeds[i], std::move(base_values[i])});
+    }
+  }
+  Tensor prefix(DT_STRING, TensorShape({}));
+  prefix.scalar<tstring>()() = checkpoint_prefix;
+  feeds.push_back({meta_graph_def.saver_def().filename_tensor_name(), prefix});
+
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(session_options, meta_graph_def,
+                                              &bundle->session));
+  std::vector<Tensor> unused_outputs;
+  TF_RETURN_IF_ERROR(bundle->session->Run(
+      run_options, feeds, {}, {meta_graph_def.saver_def().restore_op_name()},
+      &unused_outputs, nullptr));
+
+  // Runs the init op, but does not restore the variables again.
+  std::unique_ptr<SaverDef> saver_def(meta_graph_def.release_saver_def());
+  const Status status =
+      RestoreSession(run_options, meta_graph_def, export_dir, &bundle->session);
+  meta_graph_def.set_allocated_saver_def(saver_def.release());
+  TF_RETURN_IF_ERROR(status);
+  LOG(INFO) << "Loaded delta SavedModel " << export_dir << " with "
+            << num_changed << " changed variables and " << base_fetches.size()
+            << " copied from its base version";
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
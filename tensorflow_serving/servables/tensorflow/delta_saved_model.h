@@ -0,0 +1,66 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_DELTA_SAVED_MODEL_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_DELTA_SAVED_MODEL_H_
+
+#include <map>
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow_serving/servables/tensorflow/delta_manifest.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The name of the DeltaManifest in the assets.extra directory of a SavedModel.
+extern const char kDeltaManifestFilename[];
+
+// Reads the DeltaManifest of the SavedModel at 'export_dir', and sets 'found'
+// to whether it has one.
+Status ReadDeltaManifest(const string& export_dir, DeltaManifest* manifest,
+                         bool* found);
+
+// Sets 'tensor_by_key' to the tensors the saver of 'meta_graph_def' saves the
+// variables from, by checkpoint key.
+Status GetSavedTensors(const MetaGraphDef& meta_graph_def,
+                       std::map<string, string>* tensor_by_key);
+
+// Loads the SavedModel at 'export_dir', whose checkpoint only has the variables
+// that changed since its base version, like LoadSavedModel(). The other
+// variables are fetched from 'base_session', which serves the base version and
+// whose saver saves them from the tensors 'base_tensor_by_key' (see
+// GetSavedTensors()).
+//
+// Only 'base_session' is read, so the copied variables take memory of their
+// own, but loading does not read or parse them from storage.
+Status LoadDeltaSavedModel(const SessionOptions& session_options,
+                           const RunOptions& run_options,
+                           const string& export_dir,
+                           const std::unordered_set<string>& tags,
+                           Session* base_session,
+                           const std::map<string, string>& base_tensor_by_key,
+                           SavedModelBundle* bundle);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_DELTA_SAVED_MODEL_H_
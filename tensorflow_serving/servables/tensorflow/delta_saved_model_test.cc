@@ -0,0 +1,226 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/delta_saved_model.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+// Returns the text of a float node.
+string FloatNode(const string& name, const string& op,
+                 const std::vector<string>& inputs, const string& type_attr) {
+  string node = absl::StrCat("node { name: '", name, "' op: '", op, "' ");
+  for (const string& input : inputs) {
+    absl::StrAppend(&node, "input: '", input, "' ");
+  }
+  absl::StrAppend(&node, "attr { key: '", type_attr,
+                  "' value { type: DT_FLOAT } } }");
+  return node;
+}
+
+// Returns the text of a Const node with the string vector 'values'.
+string StringsNode(const string& name, const std::vector<string>& values) {
+  string node = absl::StrCat(
+      "node { name: '", name, "' op: 'Const' ",
+      "attr { key: 'dtype' value { type: DT_STRING } } ",
+      "attr { key: 'value' value { tensor { dtype: DT_STRING ",
+      "tensor_shape { dim { size: ", values.size(), " } } ");
+  for (const string& value : values) {
+    absl::StrAppend(&node, "string_val: '", value, "' ");
+  }
+  absl::StrAppend(&node, "} } } }");
+  return node;
+}
+
+// A graph that adds a bias to looked up embeddings, with a tf.compat.v1 Saver
+// for both variables.
+string Graph() {
+  return absl::StrCat(
+      "node { name: 'embeddings' op: 'VarHandleOp' ",
+      "attr { key: 'dtype' value { type: DT_FLOAT } } ",
+      "attr { key: 'shape' value { shape { dim { size: 4 } dim { size: 2 } } ",
+      "} } attr { key: 'shared_name' value { s: 'embeddings' } } } ",
+      "node { name: 'bias' op: 'VarHandleOp' ",
+      "attr { key: 'dtype' value { type: DT_FLOAT } } ",
+      "attr { key: 'shape' value { shape { dim { size: 2 } } } } ",
+      "attr { key: 'shared_name' value { s: 'bias' } } } ",
+      "node { name: 'ids' op: 'Placeholder' ",
+      "attr { key: 'dtype' value { type: DT_INT32 } } } ",
+      "node { name: 'lookup' op: 'ResourceGather' input: 'embeddings' ",
+      "input: 'ids' attr { key: 'dtype' value { type: DT_FLOAT } } ",
+      "attr { key: 'Tindices' value { type: DT_INT32 } } } ",
+      FloatNode("bias_read", "ReadVariableOp", {"bias"}, "dtype"),
+      FloatNode("output", "Add", {"lookup", "bias_read"}, "T"),
+      "node { name: 'save/Const' op: 'Placeholder' ",
+      "attr { key: 'dtype' value { type: DT_STRING } } } ",
+      StringsNode("save/tensor_names", {"bias", "embeddings"}),
+      StringsNode("save/shape_and_slices", {"", ""}),
+      FloatNode("save/read_bias", "ReadVariableOp", {"bias"}, "dtype"),
+      FloatNode("save/read_embeddings", "ReadVariableOp", {"embeddings"},
+                "dtype"),
+      "node { name: 'save/SaveV2' op: 'SaveV2' input: 'save/Const' ",
+      "input: 'save/tensor_names' input: 'save/shape_and_slices' ",
+      "input: 'save/read_bias' input: 'save/read_embeddings' ",
+      "attr { key: 'dtypes' value { list { type: DT_FLOAT type: DT_FLOAT } ",
+      "} } } ",
+      "node { name: 'save/RestoreV2' op: 'RestoreV2' input: 'save/Const' ",
+      "input: 'save/tensor_names' input: 'save/shape_and_slices' ",
+      "attr { key: 'dtypes' value { list { type: DT_FLOAT type: DT_FLOAT } ",
+      "} } } ",
+      FloatNode("save/assign_bias", "AssignVariableOp",
+                {"bias", "save/RestoreV2:0"}, "dtype"),
+      FloatNode("save/assign_embeddings", "AssignVariableOp",
+                {"embeddings", "save/RestoreV2:1"}, "dtype"),
+      "node { name: 'save/restore_all' op: 'NoOp' ",
+      "input: '^save/assign_bias' input: '^save/assign_embeddings' }");
+}
+
+class DeltaSavedModelTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_dir_ = io::JoinPath(
+        testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+  }
+
+  // Writes version 'version' with the variables 'variables' in its checkpoint,
+  // as a delta on 'base_version' if it is positive.
+  string WriteVersion(int version, const std::map<string, Tensor>& variables,
+                      int base_version) {
+    const string export_dir =
+        io::JoinPath(model_dir_, absl::StrCat(version));
+    TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(export_dir, kSavedModelVariablesDirectory)));
+    BundleWriter writer(
+        Env::Default(),
+        io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                     kSavedModelVariablesFilename));
+    for (const auto& variable : variables) {
+      TF_CHECK_OK(writer.Add(variable.first, variable.second));
+    }
+    TF_CHECK_OK(writer.Finish());
+
+    SavedModel saved_model;
+    MetaGraphDef* meta_graph_def = saved_model.add_meta_graphs();
+    meta_graph_def->mutable_meta_info_def()->add_tags(kSavedModelTagServe);
+    *meta_graph_def->mutable_graph_def() = CreateProto<GraphDef>(Graph());
+    meta_graph_def->mutable_saver_def()->set_filename_tensor_name(
+        "save/Const:0");
+    meta_graph_def->mutable_saver_def()->set_restore_op_name(
+        "save/restore_all");
+    TF_CHECK_OK(WriteBinaryProto(
+        Env::Default(), io::JoinPath(export_dir, kSavedModelFilenamePb),
+        saved_model));
+    if (base_version > 0) {
+      DeltaManifest manifest;
+      manifest.set_base_version(base_version);
+      TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(
+          io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory)));
+      TF_CHECK_OK(WriteBinaryProto(
+          Env::Default(),
+          io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                       kDeltaManifestFilename),
+          manifest));
+    }
+    return export_dir;
+  }
+
+  // Loads version 1, with all of its variables.
+  void LoadBase(SavedModelBundle* base) {
+    const string base_dir = WriteVersion(
+        1,
+        {{"embeddings", test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7},
+                                              TensorShape({4, 2}))},
+         {"bias", test::AsTensor<float>({0, 0})}},
+        0);
+    TF_ASSERT_OK(LoadSavedModel(SessionOptions(), RunOptions(), base_dir,
+                                {kSavedModelTagServe}, base));
+  }
+
+  string model_dir_;
+};
+
+TEST_F(DeltaSavedModelTest, ReadDeltaManifest) {
+  DeltaManifest manifest;
+  bool found;
+  TF_ASSERT_OK(ReadDeltaManifest(WriteVersion(1, {}, 0), &manifest, &found));
+  EXPECT_FALSE(found);
+  TF_ASSERT_OK(ReadDeltaManifest(WriteVersion(2, {}, 1), &manifest, &found));
+  EXPECT_TRUE(found);
+  EXPECT_EQ(1, manifest.base_version());
+}
+
+TEST_F(DeltaSavedModelTest, LoadsChangedVariablesAndCopiesOthers) {
+  SavedModelBundle base;
+  LoadBase(&base);
+  std::map<string, string> base_tensor_by_key;
+  TF_ASSERT_OK(GetSavedTensors(base.meta_graph_def, &base_tensor_by_key));
+  EXPECT_EQ((std::map<string, string>{{"bias", "save/read_bias"},
+                                      {"embeddings", "save/read_embeddings"}}),
+            base_tensor_by_key);
+
+  // Only the bias changed.
+  const string delta_dir =
+      WriteVersion(2, {{"bias", test::AsTensor<float>({10, 20})}}, 1);
+  SavedModelBundle delta;
+  TF_ASSERT_OK(LoadDeltaSavedModel(
+      SessionOptions(), RunOptions(), delta_dir, {kSavedModelTagServe},
+      base.session.get(), base_tensor_by_key, &delta));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(delta.session->Run({{"ids:0", test::AsTensor<int32>({3, 1})}},
+                                  {"output:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({16, 27, 12, 23}, TensorShape({2, 2})),
+      outputs[0]);
+}
+
+TEST_F(DeltaSavedModelTest, FailsForVariableInNeitherDeltaNorBase) {
+  SavedModelBundle base;
+  LoadBase(&base);
+  const string delta_dir =
+      WriteVersion(2, {{"bias", test::AsTensor<float>({10, 20})}}, 1);
+  SavedModelBundle delta;
+  EXPECT_EQ(error::NOT_FOUND,
+            LoadDeltaSavedModel(SessionOptions(), RunOptions(), delta_dir,
+                                {kSavedModelTagServe}, base.session.get(), {},
+                                &delta)
+                .code());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,159 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/embedding_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+Status EmbeddingCache::Create(const Options& options,
+                              std::shared_ptr<EmbeddingCache>* cache) {
+  if (options.max_rows < 0) {
+    return errors::InvalidArgument("max_rows must be non-negative; was ",
+                                   options.max_rows);
+  }
+  if (options.refresh_interval <= 0) {
+    return errors::InvalidArgument("refresh_interval must be positive; was ",
+                                   options.refresh_interval);
+  }
+  if (options.sample_period <= 0) {
+    return errors::InvalidArgument("sample_period must be positive; was ",
+                                   options.sample_period);
+  }
+  cache->reset(new EmbeddingCache(options));
+  return OkStatus();
+}
+
+EmbeddingCache::EmbeddingCache(const Options& options) : options_(options) {
+  if (options_.max_rows > 0) {
+    refresh_thread_.reset(options_.env->StartThread(
+        {}, "EmbeddingCacheRefresh", [this]() { RefreshLoop(); }));
+  }
+}
+
+EmbeddingCache::~EmbeddingCache() {
+  {
+    mutex_lock l(counts_mu_);
+    stopped_ = true;
+  }
+  refresh_requested_.notify_all();
+  refresh_thread_.reset();
+}
+
+void EmbeddingCache::CountIds(const std::vector<int64_t>& ids,
+                              const Tensor& table) {
+  bool request_refresh = false;
+  {
+    mutex_lock l(counts_mu_);
+    if (!table_.IsInitialized()) {
+      table_ = table;
+    }
+    for (const int64_t id : ids) {
+      ++counts_[id];
+    }
+    num_counted_ += ids.size();
+    if (num_counted_ >= options_.refresh_interval && !refresh_pending_) {
+      refresh_pending_ = true;
+      request_refresh = true;
+    }
+  }
+  if (request_refresh) {
+    refresh_requested_.notify_one();
+  }
+}
+
+void EmbeddingCache::RefreshLoop() {
+  while (true) {
+    {
+      mutex_lock l(counts_mu_);
+      while (!refresh_pending_ && !stopped_) {
+        refresh_requested_.wait(l);
+      }
+      if (stopped_) {
+        return;
+      }
+    }
+    Refresh();
+  }
+}
+
+void EmbeddingCache::RefreshForTesting() { Refresh(); }
+
+void EmbeddingCache::Refresh() {
+  mutex_lock refresh_lock(refresh_mu_);
+  std::vector<std::pair<int64_t, int64_t>> counts;
+  Tensor table;
+  {
+    mutex_lock l(counts_mu_);
+    refresh_pending_ = false;
+    num_counted_ = 0;
+    table = table_;
+    counts.assign(counts_.begin(), counts_.end());
+    // Halves the counts, so that older lookups weigh less in the next builds,
+    // and forgets the ids no longer counted.
+    for (auto it = counts_.begin(); it != counts_.end();) {
+      it->second /= 2;
+      if (it->second == 0) {
+        counts_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+  }
+  if (!table.IsInitialized() || table.dim_size(0) == 0) {
+    return;
+  }
+
+  const auto more_counted = [](const std::pair<int64_t, int64_t>& a,
+                               const std::pair<int64_t, int64_t>& b) {
+    return a.second > b.second;
+  };
+  if (static_cast<int64_t>(counts.size()) > options_.max_rows) {
+    std::nth_element(counts.begin(), counts.begin() + options_.max_rows,
+                     counts.end(), more_counted);
+    counts.resize(options_.max_rows);
+  }
+  // Rows in table order, to read the table sequentially.
+  std::sort(counts.begin(), counts.end());
+
+  const size_t row_bytes = table.tensor_data().size() / table.dim_size(0);
+  const char* const table_data = table.tensor_data().data();
+  auto hot_rows = absl::make_unique<HotRows>();
+  hot_rows->slots.reserve(counts.size());
+  hot_rows->rows.reset(new char[counts.size() * row_bytes]);
+  for (int64_t slot = 0; slot < counts.size(); ++slot) {
+    const int64_t id = counts[slot].first;
+    memcpy(hot_rows->rows.get() + slot * row_bytes,
+           table_data + id * row_bytes, row_bytes);
+    hot_rows->slots[id] = slot;
+  }
+  VLOG(1) << "Cached " << counts.size() << " of the " << table.dim_size(0)
+          << " rows of an embedding table";
+  hot_rows_.Update(std::move(hot_rows));
+}
+
+int64_t EmbeddingCache::num_cached_rows() const {
+  const auto hot_rows = hot_rows_.get();
+  return hot_rows == nullptr ? 0 : hot_rows->slots.size();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,189 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_EMBEDDING_CACHE_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_EMBEDDING_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/util/fast_read_dynamic_ptr.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A cache of the most looked-up rows of an embedding table, e.g. a
+// memory-mapped variable whose pages are mostly cold.
+//
+// Lookups gather their rows from the cache, a compact copy of the hot rows in
+// heap memory, and the other rows from the table. The ids looked up are
+// counted (a sample of them, see Options::sample_period), and once enough are
+// counted a background thread rebuilds the cache with the rows counted most,
+// then halves the counts, so that the cache follows shifts in the traffic.
+// Lookups do not wait for the rebuilds.
+//
+// This class is thread-safe.
+class EmbeddingCache {
+ public:
+  struct Options {
+    // The most rows kept in the cache.
+    int64_t max_rows = 0;
+
+    // The cache is rebuilt once this many ids are counted since the last
+    // build.
+    int64_t refresh_interval = 100 * 1000;
+
+    // One in this many looked-up ids is counted.
+    int sample_period = 1;
+
+    // The environment to run the rebuilds in.
+    Env* env = Env::Default();
+  };
+
+  static Status Create(const Options& options,
+                       std::shared_ptr<EmbeddingCache>* cache);
+
+  // Waits for a rebuild in progress, if any.
+  ~EmbeddingCache();
+
+  // Gathers the rows 'ids' of 'table', a tensor of memcpy-able type with one
+  // row per index of its first dimension, into 'output', which has room for
+  // them. 'table' must be the same, and its buffer must stay valid, in every
+  // call. Returns an InvalidArgument error for an id out of range.
+  template <typename Index>
+  Status Gather(const Tensor& table, absl::Span<const Index> ids,
+                char* output);
+
+  // Rebuilds the cache from the counts now, rather than in the background.
+  void RefreshForTesting() TF_LOCKS_EXCLUDED(counts_mu_, refresh_mu_);
+
+  // The number of rows in the cache.
+  int64_t num_cached_rows() const;
+
+  // The number of ids looked up, and of those found in the cache.
+  int64_t num_lookups() const {
+    return num_lookups_.load(std::memory_order_relaxed);
+  }
+  int64_t num_hits() const { return num_hits_.load(std::memory_order_relaxed); }
+
+ private:
+  // The rows in the cache, and their slots in 'rows'.
+  struct HotRows {
+    absl::flat_hash_map<int64_t, int64_t> slots;
+    std::unique_ptr<char[]> rows;
+  };
+
+  explicit EmbeddingCache(const Options& options);
+
+  // Counts the ids of a lookup, and requests a rebuild when enough are
+  // counted.
+  void CountIds(const std::vector<int64_t>& ids, const Tensor& table)
+      TF_LOCKS_EXCLUDED(counts_mu_);
+
+  // Rebuilds the cache whenever requested, until the cache is destroyed.
+  void RefreshLoop() TF_LOCKS_EXCLUDED(counts_mu_);
+
+  // Rebuilds the cache with the rows counted most.
+  void Refresh() TF_LOCKS_EXCLUDED(counts_mu_, refresh_mu_);
+
+  const Options options_;
+
+  FastReadDynamicPtr<HotRows> hot_rows_;
+
+  // Guards the lookup counts, and the table and rebuild requests.
+  mutable mutex counts_mu_;
+  condition_variable refresh_requested_;
+  absl::flat_hash_map<int64_t, int64_t> counts_ TF_GUARDED_BY(counts_mu_);
+  // The ids counted since the last build.
+  int64_t num_counted_ TF_GUARDED_BY(counts_mu_) = 0;
+  // Shares the buffer of the table the lookups read, once one is made.
+  Tensor table_ TF_GUARDED_BY(counts_mu_);
+  bool refresh_pending_ TF_GUARDED_BY(counts_mu_) = false;
+  bool stopped_ TF_GUARDED_BY(counts_mu_) = false;
+
+  // Serializes the rebuilds.
+  mutex refresh_mu_;
+
+  std::atomic<int64_t> num_lookups_{0};
+  std::atomic<int64_t> num_hits_{0};
+
+  // Declared last, so started after the members it uses are constructed.
+  std::unique_ptr<Thread> refresh_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(EmbeddingCache);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+template <typename Index>
+Status EmbeddingCache::Gather(const Tensor& table, absl::Span<const Index> ids,
+                              char* output) {
+  const int64_t num_rows = table.dim_size(0);
+  const size_t row_bytes =
+      num_rows == 0 ? 0 : table.tensor_data().size() / num_rows;
+  const char* const table_data = table.tensor_data().data();
+  // The position of the first id among all ids looked up, which picks the
+  // ids sampled.
+  const int64_t first_position =
+      num_lookups_.fetch_add(ids.size(), std::memory_order_relaxed);
+  std::vector<int64_t> counted_ids;
+  counted_ids.reserve(ids.size() / options_.sample_period + 1);
+  int64_t num_hits = 0;
+  {
+    const auto hot_rows = hot_rows_.get();
+    for (size_t i = 0; i < ids.size(); ++i) {
+      const int64_t id = ids[i];
+      if (id < 0 || id >= num_rows) {
+        return errors::InvalidArgument("Id ", id, " is not in [0, ", num_rows,
+                                       ")");
+      }
+      const char* row = table_data + id * row_bytes;
+      if (hot_rows != nullptr) {
+        auto slot = hot_rows->slots.find(id);
+        if (slot != hot_rows->slots.end()) {
+          row = hot_rows->rows.get() + slot->second * row_bytes;
+          ++num_hits;
+        }
+      }
+      memcpy(output + i * row_bytes, row, row_bytes);
+      if ((first_position + i) % options_.sample_period == 0) {
+        counted_ids.push_back(id);
+      }
+    }
+  }
+  num_hits_.fetch_add(num_hits, std::memory_order_relaxed);
+  if (options_.max_rows > 0) {
+    CountIds(counted_ids, table);
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_EMBEDDING_CACHE_H_
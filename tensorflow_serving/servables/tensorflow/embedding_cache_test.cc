@@ -0,0 +1,121 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/embedding_cache.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Looks up 'ids' in 'table' through 'cache', and checks the rows.
+void ExpectGather(const Tensor& table, const std::vector<int32>& ids,
+                  EmbeddingCache* cache) {
+  Tensor output(DT_FLOAT, TensorShape({static_cast<int64_t>(ids.size()), 2}));
+  TF_ASSERT_OK(cache->Gather<int32>(
+      table, ids, const_cast<char*>(output.tensor_data().data())));
+  for (int i = 0; i < ids.size(); ++i) {
+    EXPECT_EQ(table.matrix<float>()(ids[i], 0), output.matrix<float>()(i, 0));
+    EXPECT_EQ(table.matrix<float>()(ids[i], 1), output.matrix<float>()(i, 1));
+  }
+}
+
+TEST(EmbeddingCacheTest, CachesHotRows) {
+  const Tensor table =
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2}));
+  EmbeddingCache::Options options;
+  options.max_rows = 2;
+  options.refresh_interval = 1000;
+  std::shared_ptr<EmbeddingCache> cache;
+  TF_ASSERT_OK(EmbeddingCache::Create(options, &cache));
+
+  ExpectGather(table, {3, 1, 3, 0, 1, 3}, cache.get());
+  EXPECT_EQ(0, cache->num_cached_rows());
+  EXPECT_EQ(0, cache->num_hits());
+
+  // The two rows looked up most are cached, and lookups read them from there.
+  cache->RefreshForTesting();
+  EXPECT_EQ(2, cache->num_cached_rows());
+  ExpectGather(table, {3, 0, 1, 2}, cache.get());
+  EXPECT_EQ(10, cache->num_lookups());
+  EXPECT_EQ(2, cache->num_hits());
+
+  // The counts decay, so rows looked up since take over the cache.
+  ExpectGather(table, {2, 2, 2, 2, 0, 0, 0, 0}, cache.get());
+  cache->RefreshForTesting();
+  ExpectGather(table, {0, 1, 2, 3}, cache.get());
+  EXPECT_EQ(22, cache->num_lookups());
+  EXPECT_EQ(2 + 2, cache->num_hits());
+}
+
+TEST(EmbeddingCacheTest, RefreshesInBackground) {
+  const Tensor table =
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2}));
+  EmbeddingCache::Options options;
+  options.max_rows = 1;
+  options.refresh_interval = 4;
+  options.sample_period = 2;
+  std::shared_ptr<EmbeddingCache> cache;
+  TF_ASSERT_OK(EmbeddingCache::Create(options, &cache));
+
+  // Counts the ids at even positions.
+  ExpectGather(table, {2, 0, 2, 1, 2, 3, 2}, cache.get());
+  while (cache->num_cached_rows() == 0) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  ExpectGather(table, {2}, cache.get());
+  EXPECT_EQ(1, cache->num_hits());
+}
+
+TEST(EmbeddingCacheTest, RejectsIdsOutOfRange) {
+  const Tensor table =
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2}));
+  std::shared_ptr<EmbeddingCache> cache;
+  TF_ASSERT_OK(EmbeddingCache::Create({}, &cache));
+  Tensor output(DT_FLOAT, TensorShape({1, 2}));
+  for (const int32 id : {-1, 4}) {
+    EXPECT_EQ(error::INVALID_ARGUMENT,
+              cache
+                  ->Gather<int32>(
+                      table, {id},
+                      const_cast<char*>(output.tensor_data().data()))
+                  .code());
+  }
+}
+
+TEST(EmbeddingCacheTest, InvalidOptions) {
+  std::shared_ptr<EmbeddingCache> cache;
+  EmbeddingCache::Options options;
+  options.max_rows = -1;
+  EXPECT_FALSE(EmbeddingCache::Create(options, &cache).ok());
+  options.max_rows = 1;
+  options.refresh_interval = 0;
+  EXPECT_FALSE(EmbeddingCache::Create(options, &cache).ok());
+  options.refresh_interval = 1;
+  options.sample_period = 0;
+  EXPECT_FALSE(EmbeddingCache::Create(options, &cache).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,198 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/example_features.h"
+
+#include <algorithm>
+
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// A feature input of a signature.
+struct FeatureInput {
+  absl::string_view feature_name;
+  const TensorInfo* tensor_info;
+  // Whether there is one value per Example, i.e. the shape is [batch].
+  bool scalar;
+  // The number of values per Example.
+  int64_t num_values;
+};
+
+Status GetFeatureInput(const string& key, const TensorInfo& tensor_info,
+                       FeatureInput* feature_input) {
+  feature_input->feature_name =
+      absl::string_view(key).substr(
+          absl::string_view(kExampleFeatureInputsPrefix).size());
+  feature_input->tensor_info = &tensor_info;
+  const DataType dtype = tensor_info.dtype();
+  if (dtype != DT_FLOAT && dtype != DT_INT64 && dtype != DT_STRING) {
+    return errors::InvalidArgument("Feature input ", key, " has type ",
+                                   DataTypeString(dtype),
+                                   ", not float, int64 or string");
+  }
+  const TensorShapeProto& shape = tensor_info.tensor_shape();
+  if (shape.unknown_rank() || shape.dim_size() < 1 || shape.dim_size() > 2 ||
+      (shape.dim_size() == 2 && shape.dim(1).size() < 0)) {
+    return errors::InvalidArgument(
+        "Feature input ", key, " must have shape [batch] or [batch, n]; was ",
+        TensorShape::DebugString(shape));
+  }
+  feature_input->scalar = shape.dim_size() == 1;
+  feature_input->num_values = feature_input->scalar ? 1 : shape.dim(1).size();
+  return OkStatus();
+}
+
+// Returns the feature 'name' of 'example', or else of 'context', or null.
+const Feature* FindFeature(absl::string_view name, const Example& example,
+                           const Example* context) {
+  const auto& features = example.features().feature();
+  auto iter = features.find(string(name));
+  if (iter != features.end()) {
+    return &iter->second;
+  }
+  if (context != nullptr) {
+    const auto& context_features = context->features().feature();
+    auto context_iter = context_features.find(string(name));
+    if (context_iter != context_features.end()) {
+      return &context_iter->second;
+    }
+  }
+  return nullptr;
+}
+
+// Copies the values of 'feature' into 'tensor', at Example 'index'.
+Status CopyFeatureValues(const FeatureInput& feature_input,
+                         const Feature& feature, int index, Tensor* tensor) {
+  const int64_t num_values = feature_input.num_values;
+  const int64_t offset = index * num_values;
+  int64_t size = -1;
+  switch (tensor->dtype()) {
+    case DT_FLOAT:
+      if (feature.kind_case() == Feature::kFloatList) {
+        const auto& values = feature.float_list().value();
+        size = values.size();
+        if (size == num_values) {
+          std::copy(values.begin(), values.end(),
+                    tensor->flat<float>().data() + offset);
+        }
+      }
+      break;
+    case DT_INT64:
+      if (feature.kind_case() == Feature::kInt64List) {
+        const auto& values = feature.int64_list().value();
+        size = values.size();
+        if (size == num_values) {
+          std::copy(values.begin(), values.end(),
+                    tensor->flat<int64_t>().data() + offset);
+        }
+      }
+      break;
+    default:
+      if (feature.kind_case() == Feature::kBytesList) {
+        const auto& values = feature.bytes_list().value();
+        size = values.size();
+        if (size == num_values) {
+          auto flat = tensor->flat<tstring>();
+          for (int i = 0; i < size; ++i) {
+            flat(offset + i) = values[i];
+          }
+        }
+      }
+      break;
+  }
+  if (size < 0) {
+    return errors::InvalidArgument(
+        "Feature ", feature_input.feature_name, " of Example ", index,
+        " is not of type ", DataTypeString(tensor->dtype()));
+  }
+  if (size != num_values) {
+    return errors::InvalidArgument("Feature ", feature_input.feature_name,
+                                   " of Example ", index, " has ", size,
+                                   " values; expected ", num_values);
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+bool HasExampleFeatureInputs(const SignatureDef& signature) {
+  if (signature.inputs().empty()) {
+    return false;
+  }
+  for (const auto& input : signature.inputs()) {
+    if (!absl::StartsWith(input.first, kExampleFeatureInputsPrefix)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Status ExampleFeaturesToTensors(
+    const Input& input, const SignatureDef& signature,
+    std::vector<std::pair<string, Tensor>>* tensors, int* num_examples) {
+  const ::google::protobuf::RepeatedPtrField<Example>* examples = nullptr;
+  const Example* context = nullptr;
+  switch (input.kind_case()) {
+    case Input::KindCase::kExampleList:
+      examples = &input.example_list().examples();
+      break;
+    case Input::KindCase::kExampleListWithContext:
+      examples = &input.example_list_with_context().examples();
+      context = &input.example_list_with_context().context();
+      break;
+    default:
+      break;
+  }
+  if (examples == nullptr || examples->empty()) {
+    return errors::InvalidArgument("Input is empty.");
+  }
+  *num_examples = examples->size();
+
+  tensors->clear();
+  tensors->reserve(signature.inputs().size());
+  for (const auto& kv : signature.inputs()) {
+    FeatureInput feature_input;
+    TF_RETURN_IF_ERROR(GetFeatureInput(kv.first, kv.second, &feature_input));
+    TensorShape shape({*num_examples});
+    if (!feature_input.scalar) {
+      shape.AddDim(feature_input.num_values);
+    }
+    tensors->emplace_back(kv.second.name(), Tensor(kv.second.dtype(), shape));
+    Tensor* tensor = &tensors->back().second;
+    for (int i = 0; i < *num_examples; ++i) {
+      const Feature* feature =
+          FindFeature(feature_input.feature_name, (*examples)[i], context);
+      if (feature == nullptr) {
+        return errors::InvalidArgument("Example ", i, " has no feature ",
+                                       feature_input.feature_name);
+      }
+      TF_RETURN_IF_ERROR(
+          CopyFeatureValues(feature_input, *feature, i, tensor));
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
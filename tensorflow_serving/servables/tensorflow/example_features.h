@@ -0,0 +1,61 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_EXAMPLE_FEATURES_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_EXAMPLE_FEATURES_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow_serving/apis/input.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The prefix of the input keys of Classification and Regression signatures
+// that take the features of the Examples, rather than the serialized
+// Examples.
+//
+// A signature whose input keys all have this prefix is fed by the server,
+// which reads each feature "features/<name>" out of the Examples of the
+// request into a dense tensor of its input's dtype (DT_FLOAT, DT_INT64 or
+// DT_STRING) and shape: [batch] for one value per Example, or [batch, n] for
+// n values. The graph then starts after its ParseExample, which saves
+// serializing the Examples and parsing them again in the graph.
+//
+// Every Example must have every feature, with exactly the number of values of
+// its input; features of the context of an example_list_with_context are used
+// for Examples that don't have them.
+constexpr char kExampleFeatureInputsPrefix[] = "features/";
+
+// Returns whether the inputs of 'signature' are Example features, as described
+// for kExampleFeatureInputsPrefix.
+bool HasExampleFeatureInputs(const SignatureDef& signature);
+
+// Sets 'tensors' to the feeds of the feature inputs of 'signature', by tensor
+// name, with the features of the Examples of 'input', and 'num_examples' to
+// the number of Examples.
+Status ExampleFeaturesToTensors(
+    const Input& input, const SignatureDef& signature,
+    std::vector<std::pair<string, Tensor>>* tensors, int* num_examples);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_EXAMPLE_FEATURES_H_
@@ -0,0 +1,143 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/example_features.h"
+
+#include <map>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+using ::testing::HasSubstr;
+
+const char kSignature[] = R"(
+  inputs {
+    key: "features/age"
+    value { name: "age:0" dtype: DT_INT64 tensor_shape { dim { size: -1 } } }
+  }
+  inputs {
+    key: "features/embedding"
+    value {
+      name: "embedding:0"
+      dtype: DT_FLOAT
+      tensor_shape { dim { size: -1 } dim { size: 2 } }
+    }
+  }
+  inputs {
+    key: "features/country"
+    value {
+      name: "country:0"
+      dtype: DT_STRING
+      tensor_shape { dim { size: -1 } }
+    }
+  })";
+
+Example MakeExample(int64_t age, float x, float y) {
+  return CreateProto<Example>(absl::StrCat(
+      "features { "
+      "  feature { key: 'age' value { int64_list { value: ",
+      age,
+      " } } } "
+      "  feature { key: 'embedding' value { float_list { value: [",
+      x, ", ", y, "] } } } "
+      "}"));
+}
+
+TEST(ExampleFeaturesTest, HasExampleFeatureInputs) {
+  EXPECT_TRUE(HasExampleFeatureInputs(CreateProto<SignatureDef>(kSignature)));
+  EXPECT_FALSE(HasExampleFeatureInputs(SignatureDef()));
+  EXPECT_FALSE(HasExampleFeatureInputs(CreateProto<SignatureDef>(
+      "inputs { key: 'inputs' value { name: 'x:0' } } "
+      "inputs { key: 'features/a' value { name: 'a:0' } }")));
+}
+
+TEST(ExampleFeaturesTest, FillsDenseTensors) {
+  Input input;
+  auto* list = input.mutable_example_list_with_context();
+  *list->add_examples() = MakeExample(30, 1, 2);
+  *list->add_examples() = MakeExample(40, 3, 4);
+  // The context has the feature missing from the Examples.
+  *list->mutable_context() = CreateProto<Example>(
+      "features { "
+      "  feature { key: 'country' value { bytes_list { value: 'ch' } } } "
+      "  feature { key: 'age' value { int64_list { value: 99 } } } "
+      "}");
+
+  std::vector<std::pair<string, Tensor>> tensors;
+  int num_examples;
+  TF_ASSERT_OK(ExampleFeaturesToTensors(
+      input, CreateProto<SignatureDef>(kSignature), &tensors, &num_examples));
+  EXPECT_EQ(2, num_examples);
+  ASSERT_EQ(3, tensors.size());
+  std::map<string, Tensor> by_name(tensors.begin(), tensors.end());
+  test::ExpectTensorEqual<int64_t>(
+      by_name["age:0"], test::AsTensor<int64_t>({30, 40}, TensorShape({2})));
+  test::ExpectTensorEqual<float>(
+      by_name["embedding:0"],
+      test::AsTensor<float>({1, 2, 3, 4}, TensorShape({2, 2})));
+  test::ExpectTensorEqual<tstring>(
+      by_name["country:0"],
+      test::AsTensor<tstring>({"ch", "ch"}, TensorShape({2})));
+}
+
+TEST(ExampleFeaturesTest, InvalidFeatures) {
+  const SignatureDef signature = CreateProto<SignatureDef>(kSignature);
+  std::vector<std::pair<string, Tensor>> tensors;
+  int num_examples;
+
+  Input input;
+  *input.mutable_example_list()->add_examples() = MakeExample(30, 1, 2);
+  Status status =
+      ExampleFeaturesToTensors(input, signature, &tensors, &num_examples);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("has no feature country"));
+
+  input.Clear();
+  Example example = MakeExample(30, 1, 2);
+  (*example.mutable_features()->mutable_feature())["country"]
+      .mutable_int64_list()
+      ->add_value(1);
+  *input.mutable_example_list()->add_examples() = example;
+  status = ExampleFeaturesToTensors(input, signature, &tensors, &num_examples);
+  EXPECT_THAT(status.message(), HasSubstr("is not of type string"));
+
+  (*example.mutable_features()->mutable_feature())["country"]
+      .mutable_bytes_list()
+      ->add_value("ch");
+  (*example.mutable_features()->mutable_feature())["embedding"]
+      .mutable_float_list()
+      ->add_value(5);
+  *input.mutable_example_list()->mutable_examples(0) = example;
+  status = ExampleFeaturesToTensors(input, signature, &tensors, &num_examples);
+  EXPECT_THAT(status.message(), HasSubstr("has 3 values; expected 2"));
+
+  input.Clear();
+  status = ExampleFeaturesToTensors(input, signature, &tensors, &num_examples);
+  EXPECT_THAT(status.message(), HasSubstr("Input is empty"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -45,11 +45,9 @@ Status ValidateGetModelMetadataRequest(const GetModelMetadataRequest& request) {
   return tensorflow::OkStatus();
 }
 
-Status SavedModelGetSignatureDef(ServerCore* core, const ModelSpec& model_spec,
-                                 const GetModelMetadataRequest& request,
-                                 GetModelMetadataResponse* response) {
-  ServableHandle<SavedModelBundle> bundle;
-  TF_RETURN_IF_ERROR(core->GetServableHandle(model_spec, &bundle));
+// Fills in the signature def metadata of the servable of 'bundle'.
+void FillSignatureDefMetadata(const ServableHandle<SavedModelBundle>& bundle,
+                              GetModelMetadataResponse* response) {
   SignatureDefMap signature_def_map;
   for (const auto& signature : bundle->meta_graph_def.signature_def()) {
     (*signature_def_map.mutable_signature_def())[signature.first] =
@@ -61,6 +59,14 @@ Status SavedModelGetSignatureDef(ServerCore* core, const ModelSpec& model_spec,
 
   (*response->mutable_metadata())[GetModelMetadataImpl::kSignatureDef].PackFrom(
       signature_def_map);
+}
+
+Status SavedModelGetSignatureDef(ServerCore* core, const ModelSpec& model_spec,
+                                 const GetModelMetadataRequest& request,
+                                 GetModelMetadataResponse* response) {
+  ServableHandle<SavedModelBundle> bundle;
+  TF_RETURN_IF_ERROR(core->GetServableHandle(model_spec, &bundle));
+  FillSignatureDefMetadata(bundle, response);
   return tensorflow::OkStatus();
 }
 
@@ -97,5 +103,86 @@ Status GetModelMetadataImpl::GetModelMetadataWithModelSpec(
   return tensorflow::OkStatus();
 }
 
+ModelMetadataCache::ModelMetadataCache(ServerCore* core)
+    : core_(core), state_(std::make_shared<State>()) {
+  if (core == nullptr || core->servable_state_monitor() == nullptr) {
+    return;
+  }
+  std::weak_ptr<State> weak_state = state_;
+  core->servable_state_monitor()->Notify(
+      [core, weak_state](const ServableState& servable_state) {
+        std::shared_ptr<State> state = weak_state.lock();
+        if (state == nullptr) {
+          return;
+        }
+        switch (servable_state.manager_state) {
+          case ServableState::ManagerState::kAvailable: {
+            ModelSpec model_spec;
+            model_spec.set_name(servable_state.id.name);
+            model_spec.mutable_version()->set_value(
+                servable_state.id.version);
+            ServableHandle<SavedModelBundle> bundle;
+            // Servables of other types have no cached metadata.
+            if (core->GetServableHandle(model_spec, &bundle).ok()) {
+              GetEntry(state.get(), bundle);
+            }
+            break;
+          }
+          case ServableState::ManagerState::kEnd: {
+            mutex_lock l(state->mu);
+            state->entries.erase(servable_state.id);
+            break;
+          }
+          default:
+            break;
+        }
+      });
+}
+
+std::shared_ptr<ModelMetadataCache::Entry> ModelMetadataCache::GetEntry(
+    State* state, const ServableHandle<SavedModelBundle>& bundle) {
+  {
+    mutex_lock l(state->mu);
+    auto it = state->entries.find(bundle.id());
+    if (it != state->entries.end() && bundle.load_generation() != 0 &&
+        it->second->load_generation == bundle.load_generation()) {
+      return it->second;
+    }
+  }
+  auto entry = std::make_shared<Entry>();
+  entry->load_generation = bundle.load_generation();
+  FillSignatureDefMetadata(bundle, &entry->response);
+  mutex_lock l(state->mu);
+  state->entries[bundle.id()] = entry;
+  return entry;
+}
+
+Status ModelMetadataCache::GetModelMetadata(
+    const ModelSpec& model_spec, const GetModelMetadataRequest& request,
+    GetModelMetadataResponse* response) {
+  TF_RETURN_IF_ERROR(ValidateGetModelMetadataRequest(request));
+  ServableHandle<SavedModelBundle> bundle;
+  TF_RETURN_IF_ERROR(core_->GetServableHandle(model_spec, &bundle));
+  *response = GetEntry(state_.get(), bundle)->response;
+  return tensorflow::OkStatus();
+}
+
+Status ModelMetadataCache::GetSerializedModelMetadata(
+    const ModelSpec& model_spec, const string& format,
+    const Serializer& serializer, std::shared_ptr<const string>* serialized) {
+  ServableHandle<SavedModelBundle> bundle;
+  TF_RETURN_IF_ERROR(core_->GetServableHandle(model_spec, &bundle));
+  std::shared_ptr<Entry> entry = GetEntry(state_.get(), bundle);
+  mutex_lock l(entry->mu);
+  std::shared_ptr<const string>& cached = entry->serialized[format];
+  if (cached == nullptr) {
+    auto output = std::make_shared<string>();
+    TF_RETURN_IF_ERROR(serializer(entry->response, output.get()));
+    cached = std::move(output);
+  }
+  *serialized = cached;
+  return tensorflow::OkStatus();
+}
+
 }  // namespace serving
 }  // namespace tensorflow
@@ -16,8 +16,19 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_GET_MODEL_METADATA_IMPL_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_GET_MODEL_METADATA_IMPL_H_
 
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow_serving/apis/get_model_metadata.pb.h"
+#include "tensorflow_serving/core/servable_handle.h"
+#include "tensorflow_serving/core/servable_id.h"
 #include "tensorflow_serving/model_servers/server_core.h"
 
 namespace tensorflow {
@@ -39,6 +50,61 @@ class GetModelMetadataImpl {
       GetModelMetadataResponse* response);
 };
 
+// Caches the metadata responses of the servables of a ServerCore, built as
+// each servable becomes available and dropped as it is unloaded, so that
+// requests for metadata, e.g. frequent health checks, copy bytes rather than
+// rebuilding the response from every SignatureDef of the servable.
+//
+// This class is thread-safe.
+class ModelMetadataCache {
+ public:
+  // Serializes a response, e.g. to JSON.
+  using Serializer =
+      std::function<Status(const GetModelMetadataResponse&, string*)>;
+
+  // Watches the servables of 'core', if not null.
+  explicit ModelMetadataCache(ServerCore* core);
+
+  // Like GetModelMetadataImpl::GetModelMetadataWithModelSpec().
+  Status GetModelMetadata(const ModelSpec& model_spec,
+                          const GetModelMetadataRequest& request,
+                          GetModelMetadataResponse* response);
+
+  // Sets 'serialized' to the signature def metadata response of the servable
+  // 'model_spec' resolves to, as serialized by 'serializer' the first time the
+  // servable is asked for in 'format'.
+  Status GetSerializedModelMetadata(const ModelSpec& model_spec,
+                                    const string& format,
+                                    const Serializer& serializer,
+                                    std::shared_ptr<const string>* serialized);
+
+ private:
+  struct Entry {
+    // The load of the servable the entry is of (see
+    // ServableHandle::load_generation()). A servable reloaded under the same
+    // version is a different load, so doesn't match a stale entry.
+    uint64_t load_generation;
+    GetModelMetadataResponse response;
+
+    mutex mu;
+    std::map<string, std::shared_ptr<const string>> serialized
+        TF_GUARDED_BY(mu);
+  };
+
+  // Outlives the cache in the callback of the servable state monitor.
+  struct State {
+    mutex mu;
+    std::map<ServableId, std::shared_ptr<Entry>> entries TF_GUARDED_BY(mu);
+  };
+
+  // Returns the entry of the servable of 'bundle', creating it if needed.
+  static std::shared_ptr<Entry> GetEntry(
+      State* state, const ServableHandle<SavedModelBundle>& bundle);
+
+  ServerCore* const core_;
+  const std::shared_ptr<State> state_;
+};
+
 }  // namespace serving
 }  // namespace tensorflow
 
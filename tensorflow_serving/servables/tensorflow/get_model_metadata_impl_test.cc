@@ -25,6 +25,7 @@ limitations under the License.
 #include <gtest/gtest.h>
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -230,6 +231,56 @@ TEST_P(GetModelMetadataImplTest, ModelSpecOverride) {
                 .code());
 }
 
+TEST_P(GetModelMetadataImplTest, CachesResponses) {
+  ModelMetadataCache cache(GetServerCore());
+  GetModelMetadataRequest request;
+  ModelSpec* model_spec = request.mutable_model_spec();
+  model_spec->set_name(kTestModelName);
+  model_spec->mutable_version()->set_value(kTestModelVersion);
+  request.add_metadata_field(GetModelMetadataImpl::kSignatureDef);
+
+  GetModelMetadataResponse expected_response;
+  TF_ASSERT_OK(GetModelMetadataImpl::GetModelMetadata(GetServerCore(), request,
+                                                      &expected_response));
+  GetModelMetadataResponse response;
+  TF_ASSERT_OK(cache.GetModelMetadata(request.model_spec(), request,
+                                      &response));
+  EXPECT_THAT(response, test_util::EqualsProto(expected_response));
+
+  // The serialized form is built once per servable.
+  int num_serialized = 0;
+  auto serializer = [&num_serialized](const GetModelMetadataResponse& response,
+                                      string* output) {
+    ++num_serialized;
+    return response.SerializeToString(output)
+               ? OkStatus()
+               : errors::Internal("Failed to serialize");
+  };
+  std::shared_ptr<const string> serialized;
+  TF_ASSERT_OK(cache.GetSerializedModelMetadata(request.model_spec(), "proto",
+                                                serializer, &serialized));
+  std::shared_ptr<const string> serialized_again;
+  TF_ASSERT_OK(cache.GetSerializedModelMetadata(
+      request.model_spec(), "proto", serializer, &serialized_again));
+  EXPECT_EQ(1, num_serialized);
+  EXPECT_EQ(serialized.get(), serialized_again.get());
+  GetModelMetadataResponse parsed;
+  ASSERT_TRUE(parsed.ParseFromString(*serialized));
+  EXPECT_THAT(parsed, test_util::EqualsProto(expected_response));
+
+  // Requests are validated as without the cache.
+  GetModelMetadataRequest invalid_request = request;
+  invalid_request.add_metadata_field("some_stuff");
+  EXPECT_EQ(tensorflow::error::INVALID_ARGUMENT,
+            cache.GetModelMetadata(request.model_spec(), invalid_request,
+                                   &response)
+                .code());
+  model_spec->set_name("nonexistent_model");
+  EXPECT_EQ(tensorflow::error::NOT_FOUND,
+            cache.GetModelMetadata(request.model_spec(), request, &response)
+                .code());
+}
+
 // Test all ClassifierTest test cases with both SessionBundle and SavedModel.
 INSTANTIATE_TEST_CASE_P(UseSavedModel, GetModelMetadataImplTest,
                         IsTensorflowServingOSS() ? ::testing::Values(true)
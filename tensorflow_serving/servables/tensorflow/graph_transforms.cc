@@ -0,0 +1,509 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/graph_transforms.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/servables/tensorflow/memmapped_variables.h"
+#include "tensorflow_serving/servables/tensorflow/predict_util.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_warmup_util.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// Smaller weights are not worth quantizing.
+constexpr int64_t kMinQuantizedWeightElements = 1024;
+
+// The nodes with the quantized values of a weight and their range.
+struct QuantizedWeight {
+  string values;
+  string min;
+  string max;
+};
+
+bool IsQuantizable(const Tensor& weight) {
+  return weight.dtype() == DT_FLOAT &&
+         weight.NumElements() >= kMinQuantizedWeightElements;
+}
+
+// Sets 'weight' to the value of the variable with handle 'handle_input', and
+// 'key' to its name, if the variable is in 'variable_values' and quantizable.
+bool GetVariableWeight(const std::map<string, Tensor>& variable_values,
+                       const string& handle_input, string* key,
+                       Tensor* weight) {
+  const TensorId id = ParseTensorName(handle_input);
+  auto it = variable_values.find(string(id.node()));
+  if (id.index() != 0 || it == variable_values.end() ||
+      !IsQuantizable(it->second)) {
+    return false;
+  }
+  *key = it->first;
+  *weight = it->second;
+  return true;
+}
+
+// Sets 'weight' to the value of the tensor 'input', and 'key' to its name, if
+// it is constant once loaded and quantizable.
+bool GetConstantWeight(const std::unordered_map<string, const NodeDef*>& nodes,
+                       const std::map<string, Tensor>& variable_values,
+                       const string& input, string* key, Tensor* weight) {
+  const TensorId id = ParseTensorName(input);
+  auto it = nodes.find(string(id.node()));
+  if (id.index() != 0 || it == nodes.end()) {
+    return false;
+  }
+  const NodeDef& source = *it->second;
+  if (source.op() == "ReadVariableOp" && source.input_size() > 0) {
+    return GetVariableWeight(variable_values, source.input(0), key, weight);
+  }
+  if (source.op() != "Const" ||
+      !weight->FromProto(source.attr().at("value").tensor()) ||
+      !IsQuantizable(*weight)) {
+    return false;
+  }
+  *key = source.name();
+  return true;
+}
+
+int64_t GetBatchDims(const NodeDef& node) {
+  auto batch_dims = node.attr().find("batch_dims");
+  return batch_dims == node.attr().end() ? 0 : batch_dims->second.i();
+}
+
+NodeDef MakeNode(const string& name, const string& op, const string& device,
+                 const std::vector<string>& inputs) {
+  NodeDef node;
+  node.set_name(name);
+  node.set_op(op);
+  node.set_device(device);
+  for (const string& input : inputs) {
+    node.add_input(input);
+  }
+  return node;
+}
+
+NodeDef MakeConstNode(const string& name, const string& device,
+                      const Tensor& value) {
+  NodeDef node = MakeNode(name, "Const", device, {});
+  AddNodeAttr("dtype", value.dtype(), &node);
+  value.AsProtoTensorContent((*node.mutable_attr())["value"].mutable_tensor());
+  return node;
+}
+
+// Turns 'node' into a Dequantize node of the output of 'quantized_node', with
+// its range, leaving the control inputs of 'node' to 'quantized_node'.
+void ReplaceWithDequantize(const string& min, const string& max,
+                           DataType quantized_type, NodeDef* quantized_node,
+                           NodeDef* node) {
+  for (const string& input : node->input()) {
+    if (absl::StartsWith(input, "^")) {
+      quantized_node->add_input(input);
+    }
+  }
+  node->set_op("Dequantize");
+  node->clear_input();
+  node->add_input(quantized_node->name());
+  node->add_input(min);
+  node->add_input(max);
+  node->mutable_attr()->clear();
+  AddNodeAttr("T", quantized_type, node);
+  AddNodeAttr("mode", "MIN_FIRST", node);
+}
+
+// Quantizes 'weight' over its range, extended to include 0 so that 0 is
+// exact. Weights used by several ops are quantized once, by 'key'.
+const QuantizedWeight& QuantizeWeight(
+    const string& key, const Tensor& weight, const string& device,
+    std::map<string, QuantizedWeight>* quantized_weights,
+    std::vector<NodeDef>* new_nodes) {
+  auto it = quantized_weights->find(key);
+  if (it != quantized_weights->end()) {
+    return it->second;
+  }
+  const auto values = weight.flat<float>();
+  float min_value = 0;
+  float max_value = 0;
+  for (int64_t i = 0; i < values.size(); ++i) {
+    min_value = std::min(min_value, values(i));
+    max_value = std::max(max_value, values(i));
+  }
+  if (min_value == max_value) {
+    max_value = min_value + 1;
+  }
+  Tensor quantized(DT_QUINT8, weight.shape());
+  auto quantized_values = quantized.flat<quint8>();
+  for (int64_t i = 0; i < values.size(); ++i) {
+    quantized_values(i) =
+        FloatToQuantized<quint8>(values(i), min_value, max_value);
+  }
+  Tensor min(DT_FLOAT, TensorShape({}));
+  min.scalar<float>()() = min_value;
+  Tensor max(DT_FLOAT, TensorShape({}));
+  max.scalar<float>()() = max_value;
+
+  QuantizedWeight& result = (*quantized_weights)[key];
+  result.values = absl::StrCat(key, "/quantized_int8");
+  result.min = absl::StrCat(result.values, "_min");
+  result.max = absl::StrCat(result.values, "_max");
+  new_nodes->push_back(MakeConstNode(result.values, device, quantized));
+  new_nodes->push_back(MakeConstNode(result.min, device, min));
+  new_nodes->push_back(MakeConstNode(result.max, device, max));
+  return result;
+}
+
+// Rewrites the MatMul 'node' to multiply its first input, quantized over its
+// range in each run, by 'weight'.
+void QuantizeMatMul(const QuantizedWeight& weight, NodeDef* node,
+                    std::vector<NodeDef>* new_nodes) {
+  const string& name = node->name();
+  const string& device = node->device();
+  const string input = node->input(0);
+
+  Tensor axes(DT_INT32, TensorShape({2}));
+  axes.flat<int32>()(0) = 0;
+  axes.flat<int32>()(1) = 1;
+  NodeDef axes_node =
+      MakeConstNode(absl::StrCat(name, "/input_axes"), device, axes);
+  NodeDef min_node = MakeNode(absl::StrCat(name, "/input_min"), "Min", device,
+                              {input, axes_node.name()});
+  AddNodeAttr("T", DT_FLOAT, &min_node);
+  AddNodeAttr("Tidx", DT_INT32, &min_node);
+  NodeDef max_node = min_node;
+  max_node.set_name(absl::StrCat(name, "/input_max"));
+  max_node.set_op("Max");
+
+  const string quantized_input = absl::StrCat(name, "/quantized_input");
+  NodeDef quantize_node = MakeNode(quantized_input, "QuantizeV2", device,
+                                   {input, min_node.name(), max_node.name()});
+  AddNodeAttr("T", DT_QUINT8, &quantize_node);
+  AddNodeAttr("mode", "MIN_FIRST", &quantize_node);
+
+  NodeDef matmul_node = MakeNode(
+      absl::StrCat(name, "/quantized_matmul"), "QuantizedMatMul", device,
+      {quantized_input, weight.values, absl::StrCat(quantized_input, ":1"),
+       absl::StrCat(quantized_input, ":2"), weight.min, weight.max});
+  AddNodeAttr("T1", DT_QUINT8, &matmul_node);
+  AddNodeAttr("T2", DT_QUINT8, &matmul_node);
+  AddNodeAttr("Toutput", DT_QINT32, &matmul_node);
+  for (const char* transpose : {"transpose_a", "transpose_b"}) {
+    auto attr = node->attr().find(transpose);
+    AddNodeAttr(transpose, attr != node->attr().end() && attr->second.b(),
+                &matmul_node);
+  }
+  ReplaceWithDequantize(absl::StrCat(matmul_node.name(), ":1"),
+                        absl::StrCat(matmul_node.name(), ":2"), DT_QINT32,
+                        &matmul_node, node);
+
+  new_nodes->push_back(std::move(axes_node));
+  new_nodes->push_back(std::move(min_node));
+  new_nodes->push_back(std::move(max_node));
+  new_nodes->push_back(std::move(quantize_node));
+  new_nodes->push_back(std::move(matmul_node));
+}
+
+// Rewrites the lookup 'node' to gather the rows of 'weight' at 'indices' along
+// 'axis', and dequantize them.
+void QuantizeGather(const QuantizedWeight& weight, const string& indices,
+                    const string& axis, DataType axis_type, NodeDef* node,
+                    std::vector<NodeDef>* new_nodes) {
+  NodeDef gather_node =
+      MakeNode(absl::StrCat(node->name(), "/quantized_gather"), "GatherV2",
+               node->device(), {weight.values, indices, axis});
+  AddNodeAttr("Tparams", DT_QUINT8, &gather_node);
+  AddNodeAttr("Tindices", node->attr().at("Tindices").type(), &gather_node);
+  AddNodeAttr("Taxis", axis_type, &gather_node);
+  ReplaceWithDequantize(weight.min, weight.max, DT_QUINT8, &gather_node, node);
+  new_nodes->push_back(std::move(gather_node));
+}
+
+// Returns the largest absolute difference between the elements of 'a' and
+// 'b', which have the same shape.
+template <typename T>
+double MaxAbsDifference(const Tensor& a, const Tensor& b) {
+  const auto a_values = a.flat<T>();
+  const auto b_values = b.flat<T>();
+  double difference = 0;
+  for (int64_t i = 0; i < a_values.size(); ++i) {
+    const double element_difference =
+        std::abs(static_cast<double>(a_values(i)) - b_values(i));
+    // NaNs count as different unless both are.
+    if (std::isnan(element_difference) &&
+        std::isnan(a_values(i)) != std::isnan(b_values(i))) {
+      return std::numeric_limits<double>::infinity();
+    }
+    if (element_difference > difference) {
+      difference = element_difference;
+    }
+  }
+  return difference;
+}
+
+// Fails if the output 'alias' of the transformed graph, 'actual', differs from
+// the output of the original graph, 'expected', by more than 'tolerance'.
+// Outputs that are not floating point must be equal.
+Status CheckTransformedOutput(const string& alias, const Tensor& expected,
+                              const Tensor& actual, double tolerance) {
+  if (expected.dtype() != actual.dtype() ||
+      expected.shape() != actual.shape()) {
+    return errors::FailedPrecondition(
+        "Output ", alias, " changed from ", expected.DebugString(), " to ",
+        actual.DebugString());
+  }
+  double difference;
+  switch (expected.dtype()) {
+    case DT_FLOAT:
+      difference = MaxAbsDifference<float>(expected, actual);
+      break;
+    case DT_DOUBLE:
+      difference = MaxAbsDifference<double>(expected, actual);
+      break;
+    case DT_STRING:
+      difference =
+          std::equal(expected.flat<tstring>().data(),
+                     expected.flat<tstring>().data() + expected.NumElements(),
+                     actual.flat<tstring>().data())
+              ? 0
+              : std::numeric_limits<double>::infinity();
+      break;
+    default:
+      difference =
+          DataTypeCanUseMemcpy(expected.dtype()) &&
+                  expected.tensor_data() == actual.tensor_data()
+              ? 0
+              : std::numeric_limits<double>::infinity();
+  }
+  if (difference > tolerance) {
+    return errors::FailedPrecondition("Output ", alias, " differs by ",
+                                      difference, " from the original "
+                                      "graph's, above the tolerance of ",
+                                      tolerance);
+  }
+  return OkStatus();
+}
+
+// Runs the Predict requests of the warmup data of the SavedModel at
+// 'export_dir' on both 'original' and 'transformed', its bundles without and
+// with the graph transforms, and fails if their outputs differ by more than
+// 'tolerance' or there are no such requests.
+Status ValidateGraphTransforms(const RunOptions& run_options,
+                               const string& export_dir,
+                               const SavedModelBundle& original,
+                               const SavedModelBundle& transformed,
+                               double tolerance) {
+  std::atomic<int> num_validated{0};
+  TF_RETURN_IF_ERROR(internal::RunSavedModelWarmup(
+      ModelWarmupOptions(), export_dir,
+      [&](PredictionLog prediction_log) -> Status {
+        // Other warmup requests are not compared.
+        if (prediction_log.log_type_case() != PredictionLog::kPredictLog) {
+          return OkStatus();
+        }
+        const PredictRequest& request = prediction_log.predict_log().request();
+        const string signature_name =
+            request.model_spec().signature_name().empty()
+                ? kDefaultServingSignatureDefKey
+                : request.model_spec().signature_name();
+        auto signature =
+            original.meta_graph_def.signature_def().find(signature_name);
+        if (signature == original.meta_graph_def.signature_def().end()) {
+          return errors::FailedPrecondition(
+              "Serving signature key \"", signature_name, "\" not found.");
+        }
+        std::vector<std::pair<string, Tensor>> inputs;
+        std::vector<string> output_tensor_names;
+        std::vector<string> output_tensor_aliases;
+        TF_RETURN_IF_ERROR(internal::PreProcessPrediction(
+            signature->second, request, &inputs, &output_tensor_names,
+            &output_tensor_aliases));
+        std::vector<Tensor> expected;
+        std::vector<Tensor> actual;
+        RunMetadata run_metadata;
+        TF_RETURN_IF_ERROR(original.session->Run(run_options, inputs,
+                                                 output_tensor_names, {},
+                                                 &expected, &run_metadata));
+        TF_RETURN_IF_ERROR(transformed.session->Run(run_options, inputs,
+                                                    output_tensor_names, {},
+                                                    &actual, &run_metadata));
+        for (int i = 0; i < output_tensor_aliases.size(); ++i) {
+          TF_RETURN_IF_ERROR(CheckTransformedOutput(
+              output_tensor_aliases[i], expected[i], actual[i], tolerance));
+        }
+        ++num_validated;
+        return OkStatus();
+      }));
+  if (num_validated == 0) {
+    return errors::FailedPrecondition(
+        "The warmup data of ", export_dir,
+        " has no Predict requests to validate the transformed graph with");
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+bool HasGraphTransforms(const GraphTransformConfig& config) {
+  return !config.mixed_precision().empty() || config.quantize_weights_int8();
+}
+
+Status EnableAutoMixedPrecision(const string& precision,
+                                SessionOptions* session_options) {
+  GraphOptions* graph_options = session_options->config.mutable_graph_options();
+  RewriterConfig* rewrite_options = graph_options->mutable_rewrite_options();
+  if (precision == "bfloat16") {
+    rewrite_options->set_auto_mixed_precision_onednn_bfloat16(
+        RewriterConfig::ON);
+  } else if (precision == "float16") {
+    rewrite_options->set_auto_mixed_precision(RewriterConfig::ON);
+  } else {
+    return errors::InvalidArgument(
+        precision,
+        " auto mixed precision is not supported. Valid options: bfloat16, "
+        "float16");
+  }
+  return OkStatus();
+}
+
+Status QuantizeWeightsToInt8(const string& export_dir,
+                             MetaGraphDef* meta_graph_def, int* num_quantized) {
+  *num_quantized = 0;
+  std::map<string, Tensor> variable_values;
+  const Status status = internal::ReadReadOnlyVariables(
+      export_dir, *meta_graph_def, &variable_values);
+  if (!status.ok()) {
+    VLOG(1) << "Only quantizing the Const weights of " << export_dir << ": "
+            << status;
+    variable_values.clear();
+  }
+
+  GraphDef* graph_def = meta_graph_def->mutable_graph_def();
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def->node()) {
+    nodes[node.name()] = &node;
+  }
+  std::map<string, QuantizedWeight> quantized_weights;
+  std::vector<NodeDef> new_nodes;
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    string key;
+    Tensor weight;
+    if (node.op() == "MatMul" && node.input_size() >= 2 &&
+        GetConstantWeight(nodes, variable_values, node.input(1), &key,
+                          &weight)) {
+      QuantizeMatMul(QuantizeWeight(key, weight, node.device(),
+                                    &quantized_weights, &new_nodes),
+                     &node, &new_nodes);
+    } else if (node.op() == "GatherV2" && node.input_size() >= 3 &&
+               GetBatchDims(node) == 0 &&
+               GetConstantWeight(nodes, variable_values, node.input(0), &key,
+                                 &weight)) {
+      QuantizeGather(QuantizeWeight(key, weight, node.device(),
+                                    &quantized_weights, &new_nodes),
+                     node.input(1), node.input(2),
+                     node.attr().at("Taxis").type(), &node, &new_nodes);
+    } else if (node.op() == "ResourceGather" && node.input_size() >= 2 &&
+               GetBatchDims(node) == 0 &&
+               GetVariableWeight(variable_values, node.input(0), &key,
+                                 &weight)) {
+      // ResourceGather gathers along axis 0.
+      Tensor axis(DT_INT32, TensorShape({}));
+      axis.scalar<int32>()() = 0;
+      NodeDef axis_node = MakeConstNode(absl::StrCat(node.name(), "/axis"),
+                                        node.device(), axis);
+      QuantizeGather(QuantizeWeight(key, weight, node.device(),
+                                    &quantized_weights, &new_nodes),
+                     node.input(1), axis_node.name(), DT_INT32, &node,
+                     &new_nodes);
+      new_nodes.push_back(std::move(axis_node));
+    } else {
+      continue;
+    }
+    ++*num_quantized;
+  }
+  for (NodeDef& node : new_nodes) {
+    *graph_def->add_node() = std::move(node);
+  }
+  return OkStatus();
+}
+
+Status LoadSavedModelWithGraphTransforms(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    const GraphTransformConfig& config, SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  SessionOptions transformed_session_options = session_options;
+  if (!config.mixed_precision().empty()) {
+    TF_RETURN_IF_ERROR(EnableAutoMixedPrecision(config.mixed_precision(),
+                                                &transformed_session_options));
+  }
+  if (config.quantize_weights_int8()) {
+    int num_quantized;
+    TF_RETURN_IF_ERROR(QuantizeWeightsToInt8(
+        export_dir, &bundle->meta_graph_def, &num_quantized));
+    LOG(INFO) << "Quantized the weights of " << num_quantized << " ops of "
+              << export_dir << " to 8 bits";
+  }
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+      transformed_session_options, bundle->meta_graph_def, &bundle->session));
+  TF_RETURN_IF_ERROR(RestoreSession(run_options, bundle->meta_graph_def,
+                                    export_dir, &bundle->session));
+  if (config.validation_tolerance() <= 0) {
+    return OkStatus();
+  }
+
+  SavedModelBundle original;
+  TF_RETURN_IF_ERROR(LoadSavedModel(session_options, run_options, export_dir,
+                                    tags, &original));
+  const Status status =
+      ValidateGraphTransforms(run_options, export_dir, original, *bundle,
+                              config.validation_tolerance());
+  if (!status.ok()) {
+    LOG(WARNING) << "Serving " << export_dir
+                 << " without its graph transforms, which failed validation: "
+                 << status;
+    bundle->meta_graph_def = std::move(original.meta_graph_def);
+    bundle->session = std::move(original.session);
+    return OkStatus();
+  }
+  LOG(INFO) << "Validated the graph transforms of " << export_dir;
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
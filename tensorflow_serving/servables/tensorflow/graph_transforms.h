@@ -0,0 +1,69 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_GRAPH_TRANSFORMS_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_GRAPH_TRANSFORMS_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Returns whether 'config' transforms graphs at all.
+bool HasGraphTransforms(const GraphTransformConfig& config);
+
+// Enables grappler's auto mixed precision in 'session_options' for
+// 'precision', "bfloat16" or "float16". Returns an InvalidArgument error for
+// other types.
+Status EnableAutoMixedPrecision(const string& precision,
+                                SessionOptions* session_options);
+
+// Rewrites the MatMul ops of 'meta_graph_def' whose float weights (their
+// second input) are constant once loaded, and its embedding lookups (GatherV2
+// and ResourceGather ops) of such weights, to use the weights quantized to 8
+// bits, with the range of each weight:
+//
+//   MatMul(a, w) -> Dequantize(QuantizedMatMul(QuantizeV2(a), quantized w))
+//   Gather(w, ids) -> Dequantize(GatherV2(quantized w, ids))
+//
+// with 'a' quantized over its range in each run. The rewritten nodes keep
+// their names, so their consumers are unchanged. Constant weights are the
+// values of Const nodes and of the read-only variables of the SavedModel at
+// 'export_dir' (see memmapped_variables.h). Sets 'num_quantized' to the number
+// of ops rewritten.
+Status QuantizeWeightsToInt8(const string& export_dir,
+                             MetaGraphDef* meta_graph_def, int* num_quantized);
+
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but with the
+// transformations of 'config' applied to its graph, and validated against its
+// warmup data if 'config.validation_tolerance' is set. If validation fails, the
+// original graph is loaded instead.
+Status LoadSavedModelWithGraphTransforms(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    const GraphTransformConfig& config, SavedModelBundle* bundle);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_GRAPH_TRANSFORMS_H_
@@ -0,0 +1,244 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/graph_transforms.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_warmup_test_util.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_warmup_util.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+// A graph that multiplies 'x' by the weights 'w', and by the small weights
+// 'v', and looks up 'ids' in 'w'. The values of the weights are set by
+// CreateGraph().
+constexpr char kGraph[] = R"(
+  node {
+    name: 'x'
+    op: 'Placeholder'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'w'
+    op: 'Const'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'product'
+    op: 'MatMul'
+    input: 'x'
+    input: 'w'
+    attr { key: 'T' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'v'
+    op: 'Const'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'small_product'
+    op: 'MatMul'
+    input: 'x'
+    input: 'v'
+    attr { key: 'T' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'ids'
+    op: 'Placeholder'
+    attr { key: 'dtype' value { type: DT_INT32 } }
+  }
+  node {
+    name: 'axis'
+    op: 'Const'
+    attr { key: 'dtype' value { type: DT_INT32 } }
+    attr {
+      key: 'value'
+      value { tensor { dtype: DT_INT32 tensor_shape {} int_val: 0 } }
+    }
+  }
+  node {
+    name: 'lookup'
+    op: 'GatherV2'
+    input: 'w'
+    input: 'ids'
+    input: 'axis'
+    attr { key: 'Tparams' value { type: DT_FLOAT } }
+    attr { key: 'Tindices' value { type: DT_INT32 } }
+    attr { key: 'Taxis' value { type: DT_INT32 } }
+  }
+)";
+
+constexpr int kSize = 32;
+
+// Returns a 'rows' x 'columns' tensor of values in [-0.32, 0.32).
+Tensor CreateWeights(int rows, int columns) {
+  Tensor weights(DT_FLOAT, TensorShape({rows, columns}));
+  for (int i = 0; i < rows * columns; ++i) {
+    weights.flat<float>()(i) = ((i * 37) % 64 - 32) / 100.0;
+  }
+  return weights;
+}
+
+Tensor CreateInput() {
+  Tensor x(DT_FLOAT, TensorShape({2, kSize}));
+  for (int i = 0; i < 2 * kSize; ++i) {
+    x.flat<float>()(i) = (i % 10) / 10.0;
+  }
+  return x;
+}
+
+GraphDef CreateGraph() {
+  GraphDef graph_def = CreateProto<GraphDef>(kGraph);
+  for (NodeDef& node : *graph_def.mutable_node()) {
+    if (node.name() == "w") {
+      CreateWeights(kSize, kSize).AsProtoTensorContent(
+          (*node.mutable_attr())["value"].mutable_tensor());
+    } else if (node.name() == "v") {
+      CreateWeights(kSize, 2).AsProtoTensorContent(
+          (*node.mutable_attr())["value"].mutable_tensor());
+    }
+  }
+  return graph_def;
+}
+
+bool HasOp(const GraphDef& graph_def, const string& op) {
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() == op) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<Tensor> Run(const GraphDef& graph_def) {
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  TF_CHECK_OK(session->Create(graph_def));
+  std::vector<Tensor> outputs;
+  TF_CHECK_OK(session->Run(
+      {{"x", CreateInput()}, {"ids", test::AsTensor<int32>({3, 1})}},
+      {"product", "small_product", "lookup"}, {}, &outputs));
+  return outputs;
+}
+
+TEST(GraphTransformsTest, QuantizesMatMulAndGatherWeights) {
+  MetaGraphDef meta_graph_def;
+  *meta_graph_def.mutable_graph_def() = CreateGraph();
+  int num_quantized;
+  TF_ASSERT_OK(QuantizeWeightsToInt8("", &meta_graph_def, &num_quantized));
+  // The weights 'v' are too small to be quantized.
+  EXPECT_EQ(2, num_quantized);
+  EXPECT_TRUE(HasOp(meta_graph_def.graph_def(), "QuantizedMatMul"));
+
+  const std::vector<Tensor> expected = Run(CreateGraph());
+  const std::vector<Tensor> actual = Run(meta_graph_def.graph_def());
+  ASSERT_EQ(3, actual.size());
+  test::ExpectClose(expected[0], actual[0], /*atol=*/0.1, /*rtol=*/0);
+  test::ExpectTensorEqual<float>(expected[1], actual[1]);
+  test::ExpectClose(expected[2], actual[2], /*atol=*/0.01, /*rtol=*/0);
+}
+
+TEST(GraphTransformsTest, InvalidMixedPrecision) {
+  SessionOptions session_options;
+  TF_EXPECT_OK(EnableAutoMixedPrecision("bfloat16", &session_options));
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            EnableAutoMixedPrecision("int4", &session_options).code());
+}
+
+class GraphTransformsLoadTest : public ::testing::Test {
+ protected:
+  // Writes a SavedModel of the graph, with a Predict warmup request.
+  void SetUp() override {
+    export_dir_ = io::JoinPath(testing::TmpDir(), "graph_transforms");
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(export_dir_, kSavedModelAssetsExtraDirectory)));
+    SavedModel saved_model;
+    MetaGraphDef* meta_graph_def = saved_model.add_meta_graphs();
+    meta_graph_def->mutable_meta_info_def()->add_tags(kSavedModelTagServe);
+    *meta_graph_def->mutable_graph_def() = CreateGraph();
+    SignatureDef* signature = &(*meta_graph_def->mutable_signature_def())
+        [kDefaultServingSignatureDefKey];
+    signature->set_method_name(kPredictMethodName);
+    (*signature->mutable_inputs())["x"].set_name("x:0");
+    (*signature->mutable_outputs())["product"].set_name("product:0");
+    TF_ASSERT_OK(WriteBinaryProto(
+        Env::Default(), io::JoinPath(export_dir_, kSavedModelFilenamePb),
+        saved_model));
+
+    PredictionLog prediction_log;
+    CreateInput().AsProtoTensorContent(
+        &(*prediction_log.mutable_predict_log()
+               ->mutable_request()
+               ->mutable_inputs())["x"]);
+    TF_ASSERT_OK(WriteWarmupData(
+        io::JoinPath(export_dir_, kSavedModelAssetsExtraDirectory,
+                     internal::WarmupConsts::kRequestsFileName),
+        {prediction_log.SerializeAsString()}, 1));
+  }
+
+  Status Load(double validation_tolerance, SavedModelBundle* bundle) {
+    GraphTransformConfig config;
+    config.set_quantize_weights_int8(true);
+    config.set_validation_tolerance(validation_tolerance);
+    return LoadSavedModelWithGraphTransforms(SessionOptions(), RunOptions(),
+                                             export_dir_, {kSavedModelTagServe},
+                                             config, bundle);
+  }
+
+  string export_dir_;
+};
+
+TEST_F(GraphTransformsLoadTest, KeepsTransformsWithinTolerance) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(Load(0.1, &bundle));
+  EXPECT_TRUE(HasOp(bundle.meta_graph_def.graph_def(), "QuantizedMatMul"));
+}
+
+TEST_F(GraphTransformsLoadTest, RejectsTransformsBeyondTolerance) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(Load(1e-9, &bundle));
+  EXPECT_FALSE(HasOp(bundle.meta_graph_def.graph_def(), "QuantizedMatMul"));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({{"x:0", CreateInput()}}, {"product:0"}, {},
+                                   &outputs));
+  test::ExpectTensorEqual<float>(Run(CreateGraph())[0], outputs[0]);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,929 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/memmapped_variables.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/protobuf/saver.pb.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+#include "tensorflow_serving/servables/tensorflow/embedding_cache.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// A resource variable that is restored whole from the checkpoint.
+struct RestoredVariable {
+  string checkpoint_key;
+  DataType dtype;
+  TensorShape shape;
+  // The name of the region of the package with its value, when memory-mapped.
+  string memory_region_name;
+  // The id of its value in the SharedTensorRegistry, when shared.
+  int64_t shared_tensor_id = 0;
+  // Its value, when frozen into a constant.
+  Tensor value;
+};
+
+// The read-only tensors shared by the bundles of the process, by content.
+// The registry holds weak references: a tensor lives as long as a bundle that
+// reads it.
+class SharedTensorRegistry {
+ public:
+  static SharedTensorRegistry* Global() {
+    static SharedTensorRegistry* const registry = new SharedTensorRegistry;
+    return registry;
+  }
+
+  // Returns the registered tensor equal to 'value', or else registers
+  // 'value'. Sets 'id' to the id of the returned tensor.
+  std::shared_ptr<const Tensor> Share(const Tensor& value, int64_t* id)
+      TF_LOCKS_EXCLUDED(mu_) {
+    const StringPiece data = value.tensor_data();
+    uint64_t hash = Hash64(data.data(), data.size());
+    hash = Hash64Combine(hash, value.dtype());
+    hash = Hash64Combine(hash, Hash64(value.shape().DebugString()));
+    mutex_lock l(mu_);
+    auto range = ids_by_hash_.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      std::shared_ptr<const Tensor> shared = tensors_by_id_[it->second].lock();
+      if (shared != nullptr && shared->dtype() == value.dtype() &&
+          shared->shape() == value.shape() &&
+          shared->tensor_data() == data) {
+        *id = it->second;
+        return shared;
+      }
+    }
+    if (tensors_by_id_.size() >= 2 * num_tensors_at_last_sweep_) {
+      Sweep();
+    }
+    *id = next_id_++;
+    auto shared = std::make_shared<const Tensor>(value);
+    tensors_by_id_[*id] = shared;
+    ids_by_hash_.insert({hash, *id});
+    return shared;
+  }
+
+  // Returns the tensor 'id', or null if it is no longer shared.
+  std::shared_ptr<const Tensor> Find(int64_t id) TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    auto it = tensors_by_id_.find(id);
+    return it == tensors_by_id_.end() ? nullptr : it->second.lock();
+  }
+
+ private:
+  // Forgets the tensors that no bundle reads any more.
+  void Sweep() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    for (auto it = ids_by_hash_.begin(); it != ids_by_hash_.end();) {
+      if (tensors_by_id_[it->second].expired()) {
+        tensors_by_id_.erase(it->second);
+        it = ids_by_hash_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    num_tensors_at_last_sweep_ = std::max<size_t>(tensors_by_id_.size(), 64);
+  }
+
+  mutex mu_;
+  std::unordered_map<int64_t, std::weak_ptr<const Tensor>> tensors_by_id_
+      TF_GUARDED_BY(mu_);
+  std::unordered_multimap<uint64_t, int64_t> ids_by_hash_ TF_GUARDED_BY(mu_);
+  int64_t next_id_ TF_GUARDED_BY(mu_) = 1;
+  size_t num_tensors_at_last_sweep_ TF_GUARDED_BY(mu_) = 64;
+};
+
+// Outputs the shared tensor 'id'. The kernel holds the tensor, and its
+// consumers see it shared, so never update it in place.
+class SharedTensorOp : public OpKernel {
+ public:
+  explicit SharedTensorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    int64_t id;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("id", &id));
+    value_ = SharedTensorRegistry::Global()->Find(id);
+    OP_REQUIRES(ctx, value_ != nullptr,
+                errors::FailedPrecondition("Shared tensor ", id,
+                                           " is no longer shared"));
+  }
+
+  void Compute(OpKernelContext* ctx) override { ctx->set_output(0, *value_); }
+
+  bool IsExpensive() override { return false; }
+
+ private:
+  std::shared_ptr<const Tensor> value_;
+};
+
+// Stateful, so that it is neither folded into a constant nor deduplicated.
+REGISTER_OP("TfServingSharedTensor")
+    .Output("tensor: dtype")
+    .Attr("dtype: type")
+    .Attr("shape: shape")
+    .Attr("id: int")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ExplicitShape);
+
+REGISTER_KERNEL_BUILDER(Name("TfServingSharedTensor").Device(DEVICE_CPU),
+                        SharedTensorOp);
+
+// The embedding caches of the bundles of the process, by id, for the kernels
+// of their lookups to find. Holds weak references, like SharedTensorRegistry.
+class EmbeddingCacheRegistry {
+ public:
+  static EmbeddingCacheRegistry* Global() {
+    static EmbeddingCacheRegistry* const registry = new EmbeddingCacheRegistry;
+    return registry;
+  }
+
+  // Registers 'cache', and returns its id.
+  int64_t Register(std::shared_ptr<EmbeddingCache> cache)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    for (auto it = caches_by_id_.begin(); it != caches_by_id_.end();) {
+      if (it->second.expired()) {
+        it = caches_by_id_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    const int64_t id = next_id_++;
+    caches_by_id_[id] = cache;
+    return id;
+  }
+
+  // Returns the cache 'id', or null if it is destroyed.
+  std::shared_ptr<EmbeddingCache> Find(int64_t id) TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    auto it = caches_by_id_.find(id);
+    return it == caches_by_id_.end() ? nullptr : it->second.lock();
+  }
+
+ private:
+  mutex mu_;
+  std::unordered_map<int64_t, std::weak_ptr<EmbeddingCache>> caches_by_id_
+      TF_GUARDED_BY(mu_);
+  int64_t next_id_ TF_GUARDED_BY(mu_) = 1;
+};
+
+// Gathers the rows 'indices' of 'params', like GatherV2 along axis 0, through
+// the EmbeddingCache 'cache_id'.
+template <typename Index>
+class CachedGatherOp : public OpKernel {
+ public:
+  explicit CachedGatherOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    int64_t id;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("cache_id", &id));
+    cache_ = EmbeddingCacheRegistry::Global()->Find(id);
+    OP_REQUIRES(ctx, cache_ != nullptr,
+                errors::FailedPrecondition("Embedding cache ", id,
+                                           " is destroyed"));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& params = ctx->input(0);
+    const Tensor& indices = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(params.shape()),
+                errors::InvalidArgument("params must be at least 1-D"));
+    TensorShape output_shape = indices.shape();
+    for (int d = 1; d < params.dims(); ++d) {
+      output_shape.AddDim(params.dim_size(d));
+    }
+    Tensor* output;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output));
+    OP_REQUIRES_OK(
+        ctx, cache_->Gather<Index>(
+                 params,
+                 absl::MakeConstSpan(indices.flat<Index>().data(),
+                                     indices.NumElements()),
+                 const_cast<char*>(output->tensor_data().data())));
+  }
+
+ private:
+  std::shared_ptr<EmbeddingCache> cache_;
+};
+
+// Stateful, as it counts the lookups.
+REGISTER_OP("TfServingCachedGather")
+    .Input("params: dtype")
+    .Input("indices: Tindices")
+    .Output("output: dtype")
+    .Attr("dtype: type")
+    .Attr("Tindices: {int32, int64}")
+    .Attr("cache_id: int")
+    .SetIsStateful()
+    .SetShapeFn([](shape_inference::InferenceContext* c) {
+      shape_inference::ShapeHandle params;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &params));
+      shape_inference::ShapeHandle row;
+      TF_RETURN_IF_ERROR(c->Subshape(params, 1, &row));
+      shape_inference::ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(c->input(1), row, &output));
+      c->set_output(0, output);
+      return OkStatus();
+    });
+
+REGISTER_KERNEL_BUILDER(Name("TfServingCachedGather")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<int32>("Tindices"),
+                        CachedGatherOp<int32>);
+REGISTER_KERNEL_BUILDER(Name("TfServingCachedGather")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<int64_t>("Tindices"),
+                        CachedGatherOp<int64_t>);
+
+// A session that owns what its read-only variables are read from: the
+// MemmappedEnv they are mapped from, which must outlive the wrapped session,
+// and the caches of their hot rows, or the shared tensors with their values.
+class MemmappedVariablesSession : public ServingSession {
+ public:
+  MemmappedVariablesSession(
+      std::unique_ptr<MemmappedEnv> env,
+      std::vector<std::shared_ptr<EmbeddingCache>> caches,
+      std::vector<std::shared_ptr<const Tensor>> shared_values,
+      std::unique_ptr<Session> wrapped)
+      : env_(std::move(env)),
+        caches_(std::move(caches)),
+        shared_values_(std::move(shared_values)),
+        wrapped_(std::move(wrapped)) {}
+
+  ~MemmappedVariablesSession() override = default;
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    return wrapped_->Run(inputs, output_tensor_names, target_node_names,
+                         outputs);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    return wrapped_->Run(run_options, inputs, output_tensor_names,
+                         target_node_names, outputs, run_metadata);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    return wrapped_->Run(run_options, inputs, output_tensor_names,
+                         target_node_names, outputs, run_metadata,
+                         thread_pool_options);
+  }
+
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return wrapped_->ListDevices(response);
+  }
+
+ private:
+  // Declared before 'wrapped_', so destroyed after it.
+  const std::unique_ptr<MemmappedEnv> env_;
+  // Keeps the caches registered until the kernels hold them. Destroyed before
+  // 'env_', as they share the mapped buffers of the variables.
+  const std::vector<std::shared_ptr<EmbeddingCache>> caches_;
+  // Keeps the values shared until the kernels hold them.
+  const std::vector<std::shared_ptr<const Tensor>> shared_values_;
+  const std::unique_ptr<Session> wrapped_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedVariablesSession);
+};
+
+string NodeName(const string& input) {
+  return string(ParseTensorName(input).node());
+}
+
+// Returns the value of the Const node 'name' in 'nodes'.
+Status GetConstValue(const std::unordered_map<string, const NodeDef*>& nodes,
+                     const string& name, Tensor* value) {
+  auto it = nodes.find(name);
+  if (it == nodes.end() || it->second->op() != "Const" ||
+      !value->FromProto(it->second->attr().at("value").tensor())) {
+    return errors::Unimplemented("Node ", name, " is not a constant");
+  }
+  return OkStatus();
+}
+
+// Finds the resource variables the restore ops of 'graph_def' restore, keyed
+// by the names of their VarHandleOp nodes. Fails unless every restored tensor
+// is assigned whole to a resource variable.
+Status FindRestoredVariables(
+    const GraphDef& graph_def,
+    std::map<string, RestoredVariable>* variables_by_handle) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  // The nodes consuming each tensor, by tensor name ("node:index").
+  std::unordered_map<string, std::vector<const NodeDef*>> consumers;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+    for (const string& input : node.input()) {
+      const TensorId id = ParseTensorName(input);
+      if (id.index() >= 0) {
+        consumers[id.ToString()].push_back(&node);
+      }
+    }
+  }
+
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() == "Restore" || node.op() == "RestoreSlice") {
+      return errors::Unimplemented("Legacy restore op ", node.name());
+    }
+    if (node.op() != "RestoreV2") {
+      continue;
+    }
+    Tensor tensor_names, shape_and_slices;
+    TF_RETURN_IF_ERROR(
+        GetConstValue(nodes, NodeName(node.input(1)), &tensor_names));
+    TF_RETURN_IF_ERROR(
+        GetConstValue(nodes, NodeName(node.input(2)), &shape_and_slices));
+    const auto keys = tensor_names.flat<tstring>();
+    for (int i = 0; i < keys.size(); ++i) {
+      const string key(keys(i));
+      if (!shape_and_slices.flat<tstring>()(i).empty()) {
+        return errors::Unimplemented("Variable ", key,
+                                     " is restored in slices");
+      }
+      // Follows the restored tensor through Identity ops to its assignment.
+      std::vector<string> tensors = {TensorId(node.name(), i).ToString()};
+      string handle;
+      while (!tensors.empty() && handle.empty()) {
+        const string tensor = tensors.back();
+        tensors.pop_back();
+        for (const NodeDef* consumer : consumers[tensor]) {
+          if (consumer->op() == "Identity") {
+            tensors.push_back(TensorId(consumer->name(), 0).ToString());
+          } else if (consumer->op() == "AssignVariableOp" &&
+                     ParseTensorName(consumer->input(1)).ToString() == tensor) {
+            handle = NodeName(consumer->input(0));
+            break;
+          } else if (consumer->op() == "Assign") {
+            return errors::Unimplemented("Variable ", key,
+                                         " is not a resource variable");
+          }
+        }
+      }
+      auto handle_node = nodes.find(handle);
+      if (handle_node == nodes.end() ||
+          handle_node->second->op() != "VarHandleOp") {
+        return errors::Unimplemented("Variable ", key,
+                                     " is not restored into a VarHandleOp");
+      }
+      (*variables_by_handle)[handle].checkpoint_key = key;
+    }
+  }
+  if (variables_by_handle->empty()) {
+    return errors::Unimplemented("No variables are restored");
+  }
+  return OkStatus();
+}
+
+// Fails unless the nodes the signatures of 'meta_graph_def' depend on only
+// read the variables 'variables_by_handle'.
+Status CheckVariablesAreReadOnly(
+    const MetaGraphDef& meta_graph_def,
+    const std::map<string, RestoredVariable>& variables_by_handle) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : meta_graph_def.graph_def().node()) {
+    nodes[node.name()] = &node;
+  }
+  std::vector<string> to_visit;
+  for (const auto& signature : meta_graph_def.signature_def()) {
+    for (const auto& output : signature.second.outputs()) {
+      to_visit.push_back(NodeName(output.second.name()));
+    }
+  }
+  std::set<string> visited;
+  while (!to_visit.empty()) {
+    const string name = to_visit.back();
+    to_visit.pop_back();
+    auto node = nodes.find(name);
+    if (node == nodes.end() || !visited.insert(name).second) {
+      continue;
+    }
+    for (const string& input : node->second->input()) {
+      const TensorId id = ParseTensorName(input);
+      const string input_node(id.node());
+      if (id.index() >= 0 && variables_by_handle.count(input_node) > 0 &&
+          node->second->op() != "ReadVariableOp" &&
+          node->second->op() != "ResourceGather") {
+        return errors::Unimplemented("Variable ", input_node, " is used by ",
+                                     node->second->op(), " op ", name);
+      }
+      to_visit.push_back(input_node);
+    }
+  }
+  return OkStatus();
+}
+
+// Writes the variables to a package at 'package_path', unless one exists.
+Status WriteVariablesPackage(
+    const string& checkpoint_prefix,
+    const std::map<string, RestoredVariable>& variables_by_handle,
+    const string& package_path) {
+  Env* const env = Env::Default();
+  if (env->FileExists(package_path).ok()) {
+    return OkStatus();
+  }
+  // Processes loading the same variables write their own packages, and the
+  // last one to finish takes the place of the others.
+  const string tmp_path =
+      absl::StrCat(package_path, ".", random::New64(), ".tmp");
+  BundleReader reader(env, checkpoint_prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  MemmappedFileSystemWriter writer;
+  TF_RETURN_IF_ERROR(writer.InitializeToFile(env, tmp_path));
+  for (const auto& entry : variables_by_handle) {
+    const RestoredVariable& variable = entry.second;
+    Tensor value;
+    TF_RETURN_IF_ERROR(reader.Lookup(variable.checkpoint_key, &value));
+    TF_RETURN_IF_ERROR(writer.SaveTensor(value, variable.memory_region_name));
+  }
+  TF_RETURN_IF_ERROR(writer.FlushAndClose());
+  return env->RenameFile(tmp_path, package_path);
+}
+
+// Sets the op and attrs of 'value', the node with the value of 'variable'.
+using ValueNodeFn =
+    std::function<void(const RestoredVariable& variable, NodeDef* value)>;
+
+// Sets the attrs of 'value' for nodes that make tensors of the type and shape
+// of 'variable'.
+void SetDtypeAndShape(const RestoredVariable& variable, NodeDef* value) {
+  SetAttrValue(variable.dtype, &(*value->mutable_attr())["dtype"]);
+  SetAttrValue(variable.shape, &(*value->mutable_attr())["shape"]);
+}
+
+// Rewrites the reads of the variables in 'graph_def' into reads of nodes with
+// their values, made by 'value_node_fn'.
+void RewriteVariableReads(
+    const std::map<string, RestoredVariable>& variables_by_handle,
+    const string& value_suffix, const ValueNodeFn& value_node_fn,
+    GraphDef* graph_def) {
+  std::map<string, string> value_by_handle;
+  for (const auto& entry : variables_by_handle) {
+    const RestoredVariable& variable = entry.second;
+    NodeDef value;
+    value.set_name(absl::StrCat(entry.first, "/", value_suffix));
+    value_node_fn(variable, &value);
+    value_by_handle[entry.first] = value.name();
+    *graph_def->add_node() = std::move(value);
+  }
+
+  std::vector<NodeDef> axes;
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if ((node.op() != "ReadVariableOp" && node.op() != "ResourceGather") ||
+        node.input_size() == 0) {
+      continue;
+    }
+    auto value = value_by_handle.find(NodeName(node.input(0)));
+    if (value == value_by_handle.end()) {
+      continue;
+    }
+    const DataType dtype = variables_by_handle.at(value->first).dtype;
+    // The rewritten nodes keep their names, so their consumers are unchanged.
+    // Colocation with the variable is dropped along with the other attrs.
+    if (node.op() == "ReadVariableOp") {
+      node.set_op("Identity");
+      node.mutable_attr()->clear();
+      SetAttrValue(dtype, &(*node.mutable_attr())["T"]);
+      node.set_input(0, value->second);
+      continue;
+    }
+    // ResourceGather(resource, indices) gathers along axis 'batch_dims'.
+    const auto batch_dims = node.attr().find("batch_dims");
+    const int64_t axis =
+        batch_dims == node.attr().end() ? 0 : batch_dims->second.i();
+    const AttrValue indices_type = node.attr().at("Tindices");
+    NodeDef axis_node;
+    axis_node.set_name(absl::StrCat(node.name(), "/", value_suffix, "_axis"));
+    axis_node.set_op("Const");
+    axis_node.set_device(node.device());
+    SetAttrValue(DT_INT32, &(*axis_node.mutable_attr())["dtype"]);
+    Tensor axis_value(DT_INT32, TensorShape({}));
+    axis_value.scalar<int32>()() = axis;
+    axis_value.AsProtoTensorContent(
+        (*axis_node.mutable_attr())["value"].mutable_tensor());
+
+    std::vector<string> inputs = {value->second, node.input(1),
+                                  axis_node.name()};
+    for (int i = 2; i < node.input_size(); ++i) {
+      inputs.push_back(node.input(i));
+    }
+    node.set_op("GatherV2");
+    node.clear_input();
+    for (const string& input : inputs) {
+      node.add_input(input);
+    }
+    node.mutable_attr()->clear();
+    SetAttrValue(dtype, &(*node.mutable_attr())["Tparams"]);
+    (*node.mutable_attr())["Tindices"] = indices_type;
+    SetAttrValue(DT_INT32, &(*node.mutable_attr())["Taxis"]);
+    SetAttrValue(axis, &(*node.mutable_attr())["batch_dims"]);
+    axes.push_back(std::move(axis_node));
+  }
+  for (NodeDef& axis_node : axes) {
+    *graph_def->add_node() = std::move(axis_node);
+  }
+}
+
+// Rewrites the lookups of the variables of 'config' in 'graph_def', the
+// GatherV2 ops along axis 0 that RewriteVariableReads() made of their
+// ResourceGather ops with 'value_suffix', into lookups through an
+// EmbeddingCache for each variable, which it adds to 'caches'.
+Status CacheEmbeddingLookups(
+    const std::map<string, RestoredVariable>& variables_by_handle,
+    const string& value_suffix, const EmbeddingCacheConfig& config,
+    GraphDef* graph_def, std::vector<std::shared_ptr<EmbeddingCache>>* caches) {
+  if (config.variables().empty() || config.max_rows() <= 0) {
+    return OkStatus();
+  }
+  EmbeddingCache::Options options;
+  options.max_rows = config.max_rows();
+  if (config.refresh_interval() > 0) {
+    options.refresh_interval = config.refresh_interval();
+  }
+  if (config.sample_period() > 0) {
+    options.sample_period = config.sample_period();
+  }
+  std::set<string> uncached(config.variables().begin(),
+                            config.variables().end());
+  // The ids of the caches, by the names of the nodes with the values of their
+  // variables.
+  std::map<string, int64_t> cache_ids;
+  for (const auto& entry : variables_by_handle) {
+    const RestoredVariable& variable = entry.second;
+    if (uncached.erase(variable.checkpoint_key) == 0 ||
+        variable.shape.dims() == 0) {
+      continue;
+    }
+    std::shared_ptr<EmbeddingCache> cache;
+    TF_RETURN_IF_ERROR(EmbeddingCache::Create(options, &cache));
+    cache_ids[absl::StrCat(entry.first, "/", value_suffix)] =
+        EmbeddingCacheRegistry::Global()->Register(cache);
+    caches->push_back(std::move(cache));
+  }
+  for (const string& variable : uncached) {
+    LOG(WARNING) << "Not caching the lookups of variable " << variable
+                 << ", which is not a memory-mapped variable";
+  }
+
+  int num_cached = 0;
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if (node.op() != "GatherV2" || node.input_size() != 3 ||
+        node.attr().at("batch_dims").i() != 0) {
+      continue;
+    }
+    auto cache_id = cache_ids.find(node.input(0));
+    if (cache_id == cache_ids.end()) {
+      continue;
+    }
+    const AttrValue dtype = node.attr().at("Tparams");
+    const AttrValue indices_type = node.attr().at("Tindices");
+    node.set_op("TfServingCachedGather");
+    // Drops the axis, and leaves its node unused.
+    node.mutable_input()->RemoveLast();
+    node.mutable_attr()->clear();
+    (*node.mutable_attr())["dtype"] = dtype;
+    (*node.mutable_attr())["Tindices"] = indices_type;
+    SetAttrValue(cache_id->second, &(*node.mutable_attr())["cache_id"]);
+    ++num_cached;
+  }
+  LOG(INFO) << "Caching the hot rows of " << num_cached << " lookups of "
+            << cache_ids.size() << " variables";
+  return OkStatus();
+}
+
+// Memory-maps the variables of the SavedModel at 'export_dir', with meta graph
+// 'meta_graph_def': writes the package of its variables to 'package_dir' if
+// needed, rewrites 'meta_graph_def' to read them from it, with the lookups of
+// the variables of 'embedding_cache' through the caches it adds to 'caches',
+// and creates the env to run it in. Leaves 'meta_graph_def' unchanged on
+// failure.
+Status MemmapVariables(const string& export_dir, const string& package_dir,
+                       const EmbeddingCacheConfig& embedding_cache,
+                       MetaGraphDef* meta_graph_def,
+                       std::unique_ptr<MemmappedEnv>* env,
+                       std::vector<std::shared_ptr<EmbeddingCache>>* caches) {
+  if (!meta_graph_def->has_saver_def()) {
+    return errors::Unimplemented("The SavedModel has no variables");
+  }
+  std::map<string, RestoredVariable> variables_by_handle;
+  TF_RETURN_IF_ERROR(
+      FindRestoredVariables(meta_graph_def->graph_def(), &variables_by_handle));
+  TF_RETURN_IF_ERROR(
+      CheckVariablesAreReadOnly(*meta_graph_def, variables_by_handle));
+
+  // The package is named by the checkpoint index, which has the checksums of
+  // the variables, and by the restored keys, so versions with the same
+  // variables share a package.
+  const string checkpoint_prefix = io::JoinPath(
+      export_dir, kSavedModelVariablesDirectory, kSavedModelVariablesFilename);
+  string index;
+  TF_RETURN_IF_ERROR(ReadFileToString(
+      Env::Default(), MetaFilename(checkpoint_prefix), &index));
+  uint64_t package_hash = Hash64(index);
+  BundleReader reader(Env::Default(), checkpoint_prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  int region = 0;
+  for (auto& entry : variables_by_handle) {
+    RestoredVariable& variable = entry.second;
+    TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(
+        variable.checkpoint_key, &variable.dtype, &variable.shape));
+    if (!DataTypeCanUseMemcpy(variable.dtype)) {
+      return errors::Unimplemented("Variable ", variable.checkpoint_key,
+                                   " has type ",
+                                   DataTypeString(variable.dtype));
+    }
+    variable.memory_region_name = absl::StrCat(
+        MemmappedFileSystem::kMemmappedPackagePrefix, "variable_", region++);
+    package_hash = Hash64Combine(package_hash, Hash64(variable.checkpoint_key));
+  }
+  TF_RETURN_IF_ERROR(Env::Default()->RecursivelyCreateDir(package_dir));
+  const string package_path = io::JoinPath(
+      package_dir,
+      absl::StrCat(absl::Hex(package_hash, absl::kZeroPad16), ".mmap"));
+  TF_RETURN_IF_ERROR(WriteVariablesPackage(checkpoint_prefix,
+                                           variables_by_handle, package_path));
+
+  auto memmapped_env = absl::make_unique<MemmappedEnv>(Env::Default());
+  TF_RETURN_IF_ERROR(memmapped_env->InitializeFromFile(package_path));
+  GraphDef graph_def = meta_graph_def->graph_def();
+  RewriteVariableReads(variables_by_handle, "memmapped_value",
+                       [](const RestoredVariable& variable, NodeDef* value) {
+                         value->set_op("ImmutableConst");
+                         SetDtypeAndShape(variable, value);
+                         SetAttrValue(
+                             variable.memory_region_name,
+                             &(*value->mutable_attr())["memory_region_name"]);
+                       },
+                       &graph_def);
+  TF_RETURN_IF_ERROR(CacheEmbeddingLookups(variables_by_handle,
+                                           "memmapped_value", embedding_cache,
+                                           &graph_def, caches));
+  *meta_graph_def->mutable_graph_def() = std::move(graph_def);
+  *env = std::move(memmapped_env);
+  return OkStatus();
+}
+
+// Reads the variables of the SavedModel at 'export_dir', with meta graph
+// 'meta_graph_def', into tensors shared by content with the other bundles of
+// the process, and rewrites 'meta_graph_def' to read them from those. Leaves
+// 'meta_graph_def' unchanged on failure.
+Status ShareVariables(const string& export_dir, MetaGraphDef* meta_graph_def,
+                      std::vector<std::shared_ptr<const Tensor>>* values) {
+  if (!meta_graph_def->has_saver_def()) {
+    return errors::Unimplemented("The SavedModel has no variables");
+  }
+  std::map<string, RestoredVariable> variables_by_handle;
+  TF_RETURN_IF_ERROR(
+      FindRestoredVariables(meta_graph_def->graph_def(), &variables_by_handle));
+  TF_RETURN_IF_ERROR(
+      CheckVariablesAreReadOnly(*meta_graph_def, variables_by_handle));
+
+  BundleReader reader(
+      Env::Default(),
+      io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename));
+  TF_RETURN_IF_ERROR(reader.status());
+  int num_shared = 0;
+  for (auto& entry : variables_by_handle) {
+    RestoredVariable& variable = entry.second;
+    Tensor value;
+    TF_RETURN_IF_ERROR(reader.Lookup(variable.checkpoint_key, &value));
+    if (!DataTypeCanUseMemcpy(value.dtype())) {
+      return errors::Unimplemented("Variable ", variable.checkpoint_key,
+                                   " has type ", DataTypeString(value.dtype()));
+    }
+    variable.dtype = value.dtype();
+    variable.shape = value.shape();
+    values->push_back(SharedTensorRegistry::Global()->Share(
+        value, &variable.shared_tensor_id));
+    // The read value is dropped if an equal one was already shared.
+    if (values->back()->tensor_data().data() != value.tensor_data().data()) {
+      ++num_shared;
+    }
+  }
+  LOG(INFO) << num_shared << " of the " << variables_by_handle.size()
+            << " variables of " << export_dir
+            << " are shared with other bundles";
+  RewriteVariableReads(variables_by_handle, "shared_value",
+                       [](const RestoredVariable& variable, NodeDef* value) {
+                         value->set_op("TfServingSharedTensor");
+                         SetDtypeAndShape(variable, value);
+                         SetAttrValue(variable.shared_tensor_id,
+                                      &(*value->mutable_attr())["id"]);
+                       },
+                       meta_graph_def->mutable_graph_def());
+  return OkStatus();
+}
+
+// Reads the variables of the SavedModel at 'export_dir', with meta graph
+// 'meta_graph_def', and rewrites 'meta_graph_def' to read Const nodes with
+// their values instead. Leaves 'meta_graph_def' unchanged on failure.
+Status FreezeVariables(const string& export_dir, MetaGraphDef* meta_graph_def) {
+  if (!meta_graph_def->has_saver_def()) {
+    return errors::Unimplemented("The SavedModel has no variables");
+  }
+  std::map<string, RestoredVariable> variables_by_handle;
+  TF_RETURN_IF_ERROR(
+      FindRestoredVariables(meta_graph_def->graph_def(), &variables_by_handle));
+  TF_RETURN_IF_ERROR(
+      CheckVariablesAreReadOnly(*meta_graph_def, variables_by_handle));
+
+  BundleReader reader(
+      Env::Default(),
+      io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename));
+  TF_RETURN_IF_ERROR(reader.status());
+  for (auto& entry : variables_by_handle) {
+    RestoredVariable& variable = entry.second;
+    TF_RETURN_IF_ERROR(reader.Lookup(variable.checkpoint_key, &variable.value));
+    variable.dtype = variable.value.dtype();
+    variable.shape = variable.value.shape();
+  }
+  RewriteVariableReads(variables_by_handle, "frozen_value",
+                       [](const RestoredVariable& variable, NodeDef* value) {
+                         value->set_op("Const");
+                         SetAttrValue(variable.dtype,
+                                      &(*value->mutable_attr())["dtype"]);
+                         variable.value.AsProtoTensorContent(
+                             (*value->mutable_attr())["value"]
+                                 .mutable_tensor());
+                       },
+                       meta_graph_def->mutable_graph_def());
+  return OkStatus();
+}
+
+// Runs the init op of the SavedModel at 'export_dir' in 'session', but does
+// not restore the variables.
+Status RunInitOpWithoutRestore(const RunOptions& run_options,
+                               const string& export_dir,
+                               MetaGraphDef* meta_graph_def,
+                               std::unique_ptr<Session>* session) {
+  std::unique_ptr<SaverDef> saver_def(meta_graph_def->release_saver_def());
+  const Status status =
+      RestoreSession(run_options, *meta_graph_def, export_dir, session);
+  meta_graph_def->set_allocated_saver_def(saver_def.release());
+  return status;
+}
+
+}  // namespace
+
+Status LoadSavedModelWithMemmappedVariables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    const string& package_dir, const EmbeddingCacheConfig& embedding_cache,
+    SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  std::unique_ptr<MemmappedEnv> env;
+  std::vector<std::shared_ptr<EmbeddingCache>> caches;
+  const Status status =
+      MemmapVariables(export_dir, package_dir, embedding_cache,
+                      &bundle->meta_graph_def, &env, &caches);
+  if (!status.ok()) {
+    LOG(INFO) << "Restoring the variables of " << export_dir
+              << " instead of memory-mapping them: " << status;
+    TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+        session_options, bundle->meta_graph_def, &bundle->session));
+    return RestoreSession(run_options, bundle->meta_graph_def, export_dir,
+                          &bundle->session);
+  }
+
+  SessionOptions memmapped_session_options = session_options;
+  memmapped_session_options.env = env.get();
+  std::unique_ptr<Session> session;
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+      memmapped_session_options, bundle->meta_graph_def, &session));
+  TF_RETURN_IF_ERROR(RunInitOpWithoutRestore(
+      run_options, export_dir, &bundle->meta_graph_def, &session));
+  LOG(INFO) << "Memory-mapped the variables of " << export_dir;
+  bundle->session.reset(new MemmappedVariablesSession(
+      std::move(env), std::move(caches), {}, std::move(session)));
+  return OkStatus();
+}
+
+Status LoadSavedModelWithSharedVariables(const SessionOptions& session_options,
+                                         const RunOptions& run_options,
+                                         const string& export_dir,
+                                         const std::unordered_set<string>& tags,
+                                         SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  std::vector<std::shared_ptr<const Tensor>> values;
+  const Status status =
+      ShareVariables(export_dir, &bundle->meta_graph_def, &values);
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+      session_options, bundle->meta_graph_def, &bundle->session));
+  if (!status.ok()) {
+    LOG(INFO) << "Restoring the variables of " << export_dir
+              << " instead of sharing them: " << status;
+    return RestoreSession(run_options, bundle->meta_graph_def, export_dir,
+                          &bundle->session);
+  }
+  TF_RETURN_IF_ERROR(RunInitOpWithoutRestore(
+      run_options, export_dir, &bundle->meta_graph_def, &bundle->session));
+  bundle->session.reset(new MemmappedVariablesSession(
+      nullptr, {}, std::move(values), std::move(bundle->session)));
+  return OkStatus();
+}
+
+Status LoadSavedModelWithFrozenVariables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  const Status status = FreezeVariables(export_dir, &bundle->meta_graph_def);
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+      session_options, bundle->meta_graph_def, &bundle->session));
+  if (!status.ok()) {
+    LOG(INFO) << "Restoring the variables of " << export_dir
+              << " instead of freezing them: " << status;
+    return RestoreSession(run_options, bundle->meta_graph_def, export_dir,
+                          &bundle->session);
+  }
+  LOG(INFO) << "Froze the variables of " << export_dir << " into constants";
+  return RunInitOpWithoutRestore(run_options, export_dir,
+                                 &bundle->meta_graph_def, &bundle->session);
+}
+
+namespace internal {
+
+Status ReadReadOnlyVariables(const string& export_dir,
+                             const MetaGraphDef& meta_graph_def,
+                             std::map<string, Tensor>* values_by_handle) {
+  if (!meta_graph_def.has_saver_def()) {
+    return errors::Unimplemented("The SavedModel has no variables");
+  }
+  std::map<string, RestoredVariable> variables_by_handle;
+  TF_RETURN_IF_ERROR(
+      FindRestoredVariables(meta_graph_def.graph_def(), &variables_by_handle));
+  TF_RETURN_IF_ERROR(
+      CheckVariablesAreReadOnly(meta_graph_def, variables_by_handle));
+  BundleReader reader(
+      Env::Default(),
+      io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                   kSavedModelVariablesFilename));
+  TF_RETURN_IF_ERROR(reader.status());
+  for (const auto& entry : variables_by_handle) {
+    TF_RETURN_IF_ERROR(reader.Lookup(entry.second.checkpoint_key,
+                                     &(*values_by_handle)[entry.first]));
+  }
+  return OkStatus();
+}
+
+}  // namespace internal
+
+}  // namespace serving
+}  // namespace tensorflow
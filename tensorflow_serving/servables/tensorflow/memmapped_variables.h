@@ -0,0 +1,103 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_MEMMAPPED_VARIABLES_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_MEMMAPPED_VARIABLES_H_
+
+#include <map>
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but with its
+// read-only variables memory-mapped rather than restored into heap tensors.
+//
+// The variables are copied once, in the aligned format of
+// MemmappedFileSystem, into a package in the local directory 'package_dir',
+// which is named by the content of the checkpoint. The reads of the variables
+// are then rewritten into ImmutableConst ops that map their values from the
+// package, so versions and processes with the same variables share one copy
+// in the page cache, and loading does not read the variables.
+//
+// The lookups (ResourceGather ops along the first dimension) of the variables
+// of 'embedding_cache' read their hot rows from an EmbeddingCache, a compact
+// copy in heap memory, so that the pages of the cold rows can stay on disk.
+//
+// Only graphs whose variables are all resource variables that the signatures
+// just read (through ReadVariableOp or ResourceGather, not e.g. inside
+// functions) and that are restored whole can be memory-mapped. Other
+// SavedModels are loaded normally.
+Status LoadSavedModelWithMemmappedVariables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    const string& package_dir, const EmbeddingCacheConfig& embedding_cache,
+    SavedModelBundle* bundle);
+
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but with its
+// read-only variables shared by content with the other SavedModels loaded so
+// in the process, e.g. the same model under another name, or the variables a
+// new version leaves unchanged.
+//
+// The variables are read from the checkpoint and hashed. A variable equal to
+// one that is already shared is dropped, and the reads of the variables are
+// rewritten into reads of the shared tensors. The same SavedModels as for
+// LoadSavedModelWithMemmappedVariables() can be shared, and others are loaded
+// normally.
+Status LoadSavedModelWithSharedVariables(const SessionOptions& session_options,
+                                         const RunOptions& run_options,
+                                         const string& export_dir,
+                                         const std::unordered_set<string>& tags,
+                                         SavedModelBundle* bundle);
+
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but with its
+// read-only variables frozen: their values are read from the checkpoint into
+// Const nodes that replace the reads of the variables. Grappler then folds
+// the ops that only depend on the variables, and prunes the Identity chains
+// around them, when it optimizes the graph for each signature, so that Runs
+// execute fewer trivial ops. The frozen values are held by the graph of the
+// bundle as well as the session. The same SavedModels as for
+// LoadSavedModelWithMemmappedVariables() can be frozen, and others are loaded
+// normally.
+Status LoadSavedModelWithFrozenVariables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    SavedModelBundle* bundle);
+
+namespace internal {
+
+// Reads the values of the read-only resource variables of the SavedModel at
+// 'export_dir', with meta graph 'meta_graph_def', from its checkpoint, keyed
+// by the names of their VarHandleOp nodes. Fails unless the variables could be
+// memory-mapped.
+Status ReadReadOnlyVariables(const string& export_dir,
+                             const MetaGraphDef& meta_graph_def,
+                             std::map<string, Tensor>* values_by_handle);
+
+}  // namespace internal
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_MEMMAPPED_VARIABLES_H_
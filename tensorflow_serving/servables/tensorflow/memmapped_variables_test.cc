@@ -0,0 +1,377 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/memmapped_variables.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+// A graph with an embedding variable that is looked up and read, and restored
+// like by a tf.compat.v1 Saver.
+constexpr char kGraph[] = R"(
+  node {
+    name: 'embeddings'
+    op: 'VarHandleOp'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+    attr {
+      key: 'shape'
+      value { shape { dim { size: 4 } dim { size: 2 } } }
+    }
+    attr { key: 'shared_name' value { s: 'embeddings' } }
+    attr { key: 'container' value { s: '' } }
+  }
+  node {
+    name: 'ids'
+    op: 'Placeholder'
+    attr { key: 'dtype' value { type: DT_INT32 } }
+  }
+  node {
+    name: 'lookup'
+    op: 'ResourceGather'
+    input: 'embeddings'
+    input: 'ids'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+    attr { key: 'Tindices' value { type: DT_INT32 } }
+  }
+  node {
+    name: 'read'
+    op: 'ReadVariableOp'
+    input: 'embeddings'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'save/Const'
+    op: 'Placeholder'
+    attr { key: 'dtype' value { type: DT_STRING } }
+  }
+  node {
+    name: 'save/tensor_names'
+    op: 'Const'
+    attr { key: 'dtype' value { type: DT_STRING } }
+    attr {
+      key: 'value'
+      value {
+        tensor {
+          dtype: DT_STRING
+          tensor_shape { dim { size: 1 } }
+          string_val: 'embeddings'
+        }
+      }
+    }
+  }
+  node {
+    name: 'save/shape_and_slices'
+    op: 'Const'
+    attr { key: 'dtype' value { type: DT_STRING } }
+    attr {
+      key: 'value'
+      value {
+        tensor {
+          dtype: DT_STRING
+          tensor_shape { dim { size: 1 } }
+          string_val: ''
+        }
+      }
+    }
+  }
+  node {
+    name: 'save/RestoreV2'
+    op: 'RestoreV2'
+    input: 'save/Const'
+    input: 'save/tensor_names'
+    input: 'save/shape_and_slices'
+    attr { key: 'dtypes' value { list { type: DT_FLOAT } } }
+  }
+  node {
+    name: 'save/Identity'
+    op: 'Identity'
+    input: 'save/RestoreV2'
+    attr { key: 'T' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'save/Assign'
+    op: 'AssignVariableOp'
+    input: 'embeddings'
+    input: 'save/Identity'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'save/restore_all'
+    op: 'NoOp'
+    input: '^save/Assign'
+  }
+)";
+
+// Nodes that make a signature update the variable before reading it.
+constexpr char kUpdateNodes[] = R"(
+  node {
+    name: 'ones'
+    op: 'Const'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+    attr {
+      key: 'value'
+      value {
+        tensor {
+          dtype: DT_FLOAT
+          tensor_shape { dim { size: 4 } dim { size: 2 } }
+          float_val: 1
+        }
+      }
+    }
+  }
+  node {
+    name: 'update'
+    op: 'AssignAddVariableOp'
+    input: 'embeddings'
+    input: 'ones'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+  }
+  node {
+    name: 'read_updated'
+    op: 'ReadVariableOp'
+    input: 'embeddings'
+    input: '^update'
+    attr { key: 'dtype' value { type: DT_FLOAT } }
+  }
+)";
+
+class MemmappedVariablesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    test_dir_ = io::JoinPath(
+        testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    package_dir_ = io::JoinPath(test_dir_, "packages");
+  }
+
+  // Writes a SavedModel with the embedding variable, whose signature also
+  // updates the variable if 'with_update'.
+  string WriteSavedModel(const string& name, bool with_update) {
+    const string export_dir = io::JoinPath(test_dir_, name);
+    TF_CHECK_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(export_dir, kSavedModelVariablesDirectory)));
+    BundleWriter writer(
+        Env::Default(),
+        io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                     kSavedModelVariablesFilename));
+    TF_CHECK_OK(writer.Add(
+        "embeddings",
+        test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2}))));
+    TF_CHECK_OK(writer.Finish());
+
+    SavedModel saved_model;
+    MetaGraphDef* meta_graph_def = saved_model.add_meta_graphs();
+    meta_graph_def->mutable_meta_info_def()->add_tags(kSavedModelTagServe);
+    *meta_graph_def->mutable_graph_def() = CreateProto<GraphDef>(
+        with_update ? absl::StrCat(kGraph, kUpdateNodes) : kGraph);
+    meta_graph_def->mutable_saver_def()->set_filename_tensor_name(
+        "save/Const:0");
+    meta_graph_def->mutable_saver_def()->set_restore_op_name(
+        "save/restore_all");
+    SignatureDef* signature =
+        &(*meta_graph_def->mutable_signature_def())["serving_default"];
+    (*signature->mutable_inputs())["ids"].set_name("ids:0");
+    (*signature->mutable_outputs())["embeddings"].set_name("lookup:0");
+    (*signature->mutable_outputs())["all"].set_name(
+        with_update ? "read_updated:0" : "read:0");
+    TF_CHECK_OK(WriteBinaryProto(
+        Env::Default(), io::JoinPath(export_dir, kSavedModelFilenamePb),
+        saved_model));
+    return export_dir;
+  }
+
+  Status Load(const string& export_dir, SavedModelBundle* bundle,
+              const EmbeddingCacheConfig& embedding_cache = {}) {
+    return LoadSavedModelWithMemmappedVariables(
+        SessionOptions(), RunOptions(), export_dir, {kSavedModelTagServe},
+        package_dir_, embedding_cache, bundle);
+  }
+
+  // Returns the packages in 'package_dir_'.
+  std::vector<string> GetPackages() {
+    std::vector<string> children, packages;
+    if (Env::Default()->GetChildren(package_dir_, &children).ok()) {
+      for (const string& child : children) {
+        if (absl::EndsWith(child, ".mmap")) {
+          packages.push_back(child);
+        }
+      }
+    }
+    return packages;
+  }
+
+  void ExpectLookUp(Session* session, const std::vector<float>& expected) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({{"ids:0", test::AsTensor<int32>({3, 1})}},
+                              {"lookup:0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>(expected, TensorShape({2, 2})), outputs[0]);
+  }
+
+  string test_dir_;
+  string package_dir_;
+};
+
+TEST_F(MemmappedVariablesTest, MemoryMapsReadOnlyVariables) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(Load(WriteSavedModel("1", false), &bundle));
+  EXPECT_EQ(1, GetPackages().size());
+  ExpectLookUp(bundle.session.get(), {6, 7, 2, 3});
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2})),
+      outputs[0]);
+
+  // Another version with the same variables shares the package.
+  SavedModelBundle other_bundle;
+  TF_ASSERT_OK(Load(WriteSavedModel("2", false), &other_bundle));
+  EXPECT_EQ(1, GetPackages().size());
+  ExpectLookUp(other_bundle.session.get(), {6, 7, 2, 3});
+}
+
+TEST_F(MemmappedVariablesTest, CachesEmbeddingLookups) {
+  EmbeddingCacheConfig embedding_cache;
+  embedding_cache.add_variables("embeddings");
+  embedding_cache.set_max_rows(1);
+  embedding_cache.set_refresh_interval(2);
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(Load(WriteSavedModel("1", false), &bundle, embedding_cache));
+  int num_cached_lookups = 0;
+  for (const NodeDef& node : bundle.meta_graph_def.graph_def().node()) {
+    if (node.op() == "TfServingCachedGather") {
+      ++num_cached_lookups;
+    }
+  }
+  EXPECT_EQ(1, num_cached_lookups);
+
+  // Lookups return the same rows as the cache fills.
+  for (int i = 0; i < 10; ++i) {
+    ExpectLookUp(bundle.session.get(), {6, 7, 2, 3});
+  }
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2})),
+      outputs[0]);
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            bundle.session
+                ->Run({{"ids:0", test::AsTensor<int32>({4})}}, {"lookup:0"},
+                      {}, &outputs)
+                .code());
+}
+
+TEST_F(MemmappedVariablesTest, RestoresVariablesThatAreWritten) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(Load(WriteSavedModel("1", true), &bundle));
+  EXPECT_TRUE(GetPackages().empty());
+  ExpectLookUp(bundle.session.get(), {6, 7, 2, 3});
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read_updated:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6, 7, 8}, TensorShape({4, 2})),
+      outputs[0]);
+}
+
+TEST_F(MemmappedVariablesTest, SharesIdenticalVariables) {
+  SavedModelBundle bundle, other_bundle;
+  TF_ASSERT_OK(LoadSavedModelWithSharedVariables(
+      SessionOptions(), RunOptions(), WriteSavedModel("1", false),
+      {kSavedModelTagServe}, &bundle));
+  TF_ASSERT_OK(LoadSavedModelWithSharedVariables(
+      SessionOptions(), RunOptions(), WriteSavedModel("2", false),
+      {kSavedModelTagServe}, &other_bundle));
+  ExpectLookUp(bundle.session.get(), {6, 7, 2, 3});
+  ExpectLookUp(other_bundle.session.get(), {6, 7, 2, 3});
+
+  // Both versions read the same buffer.
+  std::vector<Tensor> outputs, other_outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read:0"}, {}, &outputs));
+  TF_ASSERT_OK(other_bundle.session->Run({}, {"read:0"}, {}, &other_outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2})),
+      outputs[0]);
+  EXPECT_EQ(outputs[0].tensor_data().data(),
+            other_outputs[0].tensor_data().data());
+}
+
+TEST_F(MemmappedVariablesTest, DoesNotShareVariablesThatAreWritten) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModelWithSharedVariables(
+      SessionOptions(), RunOptions(), WriteSavedModel("1", true),
+      {kSavedModelTagServe}, &bundle));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read_updated:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6, 7, 8}, TensorShape({4, 2})),
+      outputs[0]);
+}
+
+TEST_F(MemmappedVariablesTest, FreezesReadOnlyVariables) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModelWithFrozenVariables(
+      SessionOptions(), RunOptions(), WriteSavedModel("1", false),
+      {kSavedModelTagServe}, &bundle));
+  for (const NodeDef& node : bundle.meta_graph_def.graph_def().node()) {
+    EXPECT_NE("ReadVariableOp", node.op());
+    EXPECT_NE("ResourceGather", node.op());
+  }
+  ExpectLookUp(bundle.session.get(), {6, 7, 2, 3});
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({0, 1, 2, 3, 4, 5, 6, 7}, TensorShape({4, 2})),
+      outputs[0]);
+}
+
+TEST_F(MemmappedVariablesTest, DoesNotFreezeVariablesThatAreWritten) {
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModelWithFrozenVariables(
+      SessionOptions(), RunOptions(), WriteSavedModel("1", true),
+      {kSavedModelTagServe}, &bundle));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"read_updated:0"}, {}, &outputs));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6, 7, 8}, TensorShape({4, 2})),
+      outputs[0]);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
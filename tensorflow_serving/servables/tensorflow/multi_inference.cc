@@ -15,14 +15,18 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/multi_inference.h"
 
+#include <algorithm>
 #include <set>
+#include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow_serving/apis/input.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
 #include "tensorflow_serving/servables/tensorflow/classifier.h"
 #include "tensorflow_serving/servables/tensorflow/regressor.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
@@ -30,15 +34,70 @@ limitations under the License.
 namespace tensorflow {
 namespace serving {
 
-Status TensorFlowMultiInferenceRunner::Infer(
-    const RunOptions& run_options, const MultiInferenceRequest& request,
-    MultiInferenceResponse* response) {
-  TRACELITERAL("TensorFlowMultiInferenceRunner::Infer");
+namespace {
+
+const string& GetSignatureName(const InferenceTask& task) {
+  static const string* const kDefaultSignatureName =
+      new string(kDefaultServingSignatureDefKey);
+  return task.model_spec().signature_name().empty()
+             ? *kDefaultSignatureName
+             : task.model_spec().signature_name();
+}
+
+// Like PreProcessClassification() and PreProcessRegression(), for a task of
+// the predict method.
+Status PreProcessPredictTask(const SignatureDef& signature,
+                             string* input_tensor_name,
+                             std::vector<string>* output_tensor_names) {
+  if (signature.inputs().size() != 1) {
+    return errors::InvalidArgument(
+        "Expected one input Tensor for a predict task in MultiInference, "
+        "found ",
+        signature.inputs().size());
+  }
+  const TensorInfo& input = signature.inputs().begin()->second;
+  if (input.dtype() != DT_STRING) {
+    return errors::InvalidArgument(
+        "The input Tensor of a predict task in MultiInference must be of type "
+        "string to take the serialized Examples");
+  }
+  *input_tensor_name = input.name();
+  for (const auto& output : signature.outputs()) {
+    output_tensor_names->push_back(output.second.name());
+  }
+  return OkStatus();
+}
+
+// Fills 'result' with the outputs of 'signature' among 'outputs', which are
+// of 'output_tensor_names'.
+Status PostProcessPredictTaskResult(
+    const SignatureDef& signature,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<Tensor>& outputs, PredictResponse* result) {
+  for (const auto& output : signature.outputs()) {
+    auto it = std::lower_bound(output_tensor_names.begin(),
+                               output_tensor_names.end(), output.second.name());
+    if (it == output_tensor_names.end() || *it != output.second.name()) {
+      return errors::Internal("Missing output Tensor ", output.second.name());
+    }
+    outputs[it - output_tensor_names.begin()].AsProtoField(
+        &(*result->mutable_outputs())[output.first]);
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+Status CreateMultiInferencePlan(const MetaGraphDef& meta_graph_def,
+                                const MultiInferenceRequest& request,
+                                MultiInferencePlan* plan) {
+  TRACELITERAL("CreateMultiInferencePlan");
 
   string model_name = "";
   std::set<string> signature_names;
   std::set<string> input_tensor_name_set;
   std::set<string> output_tensor_name_set;
+  std::vector<MultiInferencePlan::Task> tasks;
   for (const auto& task : request.tasks()) {
     if (task.model_spec().name().empty()) {
       return errors::InvalidArgument(
@@ -52,9 +111,7 @@ Status TensorFlowMultiInferenceRunner::Infer(
           "model name.");
     }
 
-    const string signature_name = task.model_spec().signature_name().empty()
-                                      ? kDefaultServingSignatureDefKey
-                                      : task.model_spec().signature_name();
+    const string& signature_name = GetSignatureName(task);
 
     if (signature_names.find(signature_name) != signature_names.end()) {
       return errors::InvalidArgument(strings::StrCat(
@@ -62,66 +119,113 @@ Status TensorFlowMultiInferenceRunner::Infer(
     }
     signature_names.insert(signature_name);
 
-    auto iter = meta_graph_def_->signature_def().find(signature_name);
-    if (iter == meta_graph_def_->signature_def().end()) {
+    auto iter = meta_graph_def.signature_def().find(signature_name);
+    if (iter == meta_graph_def.signature_def().end()) {
       return errors::InvalidArgument(strings::StrCat(
           "Requested signature not found in model graph: ", signature_name));
     }
     string input_name;
+    string context_name;
     std::vector<string> output_names;
 
     if (task.method_name() == kClassifyMethodName) {
-      TF_RETURN_IF_ERROR(
-          PreProcessClassification(iter->second, &input_name, &output_names));
+      TF_RETURN_IF_ERROR(PreProcessClassification(
+          iter->second, &input_name, &output_names, &context_name));
     } else if (task.method_name() == kRegressMethodName) {
+      TF_RETURN_IF_ERROR(PreProcessRegression(iter->second, &input_name,
+                                              &output_names, &context_name));
+    } else if (task.method_name() == kPredictMethodName) {
       TF_RETURN_IF_ERROR(
-          PreProcessRegression(iter->second, &input_name, &output_names));
+          PreProcessPredictTask(iter->second, &input_name, &output_names));
     } else {
       return errors::Unimplemented("Unsupported signature method_name: ",
                                    task.method_name());
     }
+    if (input_name.empty() || !context_name.empty()) {
+      return errors::Unimplemented("Signature ", signature_name, " has a \"",
+                                   kExampleContextInputs,
+                                   "\" input or Example feature inputs, which "
+                                   "MultiInference does not support");
+    }
     input_tensor_name_set.insert(input_name);
     for (const auto& output_tensor_name : output_names) {
       output_tensor_name_set.insert(output_tensor_name);
     }
+    tasks.push_back({task.method_name(), &iter->second});
+  }
+
+  plan->model_name = std::move(model_name);
+  plan->input_tensor_names = std::move(input_tensor_name_set);
+  plan->output_tensor_names.assign(output_tensor_name_set.begin(),
+                                   output_tensor_name_set.end());
+  plan->tasks = std::move(tasks);
+  return OkStatus();
+}
+
+Status MultiInferencePlanCache::GetPlan(
+    uint64_t load_generation, const MetaGraphDef& meta_graph_def,
+    const MultiInferenceRequest& request,
+    std::shared_ptr<const MultiInferencePlan>* plan) {
+  string key;
+  for (const auto& task : request.tasks()) {
+    // The names can't contain '\0', so the key is unambiguous.
+    strings::StrAppend(&key, absl::string_view("\0", 1),
+                       task.model_spec().name(), absl::string_view("\0", 1),
+                       GetSignatureName(task), absl::string_view("\0", 1),
+                       task.method_name());
   }
+  return cache_.Get(
+      load_generation, key,
+      [&](MultiInferencePlan* new_plan) {
+        return CreateMultiInferencePlan(meta_graph_def, request, new_plan);
+      },
+      plan);
+}
+
+Status TensorFlowMultiInferenceRunner::Infer(
+    const RunOptions& run_options, const MultiInferenceRequest& request,
+    MultiInferenceResponse* response) {
+  TRACELITERAL("TensorFlowMultiInferenceRunner::Infer");
 
-  const std::vector<string> output_tensor_names(output_tensor_name_set.begin(),
-                                                output_tensor_name_set.end());
+  std::shared_ptr<const MultiInferencePlan> plan;
+  if (plan_cache_ != nullptr) {
+    TF_RETURN_IF_ERROR(plan_cache_->GetPlan(load_generation_, *meta_graph_def_,
+                                            request, &plan));
+  } else {
+    auto new_plan = std::make_shared<MultiInferencePlan>();
+    TF_RETURN_IF_ERROR(
+        CreateMultiInferencePlan(*meta_graph_def_, request, new_plan.get()));
+    plan = std::move(new_plan);
+  }
 
   std::vector<Tensor> outputs;
   int num_examples;
   TF_RETURN_IF_ERROR(PerformOneShotTensorComputation(
-      run_options, request.input(), input_tensor_name_set, output_tensor_names,
-      session_, &outputs, &num_examples, thread_pool_options_));
-  RecordRequestExampleCount(model_name, num_examples);
+      run_options, request.input(), plan->input_tensor_names,
+      plan->output_tensor_names, session_, &outputs, &num_examples,
+      thread_pool_options_));
+  RecordRequestExampleCount(plan->model_name, num_examples);
 
   TRACELITERAL("PostProcessResults");
-  for (const auto& task : request.tasks()) {
-    const string signature_name = task.model_spec().signature_name().empty()
-                                      ? kDefaultServingSignatureDefKey
-                                      : task.model_spec().signature_name();
-    auto iter = meta_graph_def_->signature_def().find(signature_name);
-    if (iter == meta_graph_def_->signature_def().end()) {
-      return errors::InvalidArgument(strings::StrCat(
-          "Requested signature not found in model graph: ", signature_name));
-    }
-    if (task.method_name() == kClassifyMethodName) {
+  for (int i = 0; i < plan->tasks.size(); ++i) {
+    const MultiInferencePlan::Task& task = plan->tasks[i];
+    InferenceResult* result = response->add_results();
+    if (task.method_name == kClassifyMethodName) {
       TF_RETURN_IF_ERROR(PostProcessClassificationResult(
-          iter->second, num_examples, output_tensor_names, outputs,
-          response->add_results()->mutable_classification_result()));
-    } else if (task.method_name() == kRegressMethodName) {
+          *task.signature, num_examples, plan->output_tensor_names, outputs,
+          result->mutable_classification_result()));
+    } else if (task.method_name == kRegressMethodName) {
       TF_RETURN_IF_ERROR(PostProcessRegressionResult(
-          iter->second, num_examples, output_tensor_names, outputs,
-          response->add_results()->mutable_regression_result()));
+          *task.signature, num_examples, plan->output_tensor_names, outputs,
+          result->mutable_regression_result()));
     } else {
-      return errors::InvalidArgument("Unrecognized signature method_name: ",
-                                     task.method_name());
+      TF_RETURN_IF_ERROR(PostProcessPredictTaskResult(
+          *task.signature, plan->output_tensor_names, outputs,
+          result->mutable_predict_result()));
     }
-    MakeModelSpec(task.model_spec().name(), task.model_spec().signature_name(),
-                  servable_version_,
-                  response->mutable_results(response->results_size() - 1)
-                      ->mutable_model_spec());
+    const ModelSpec& model_spec = request.tasks(i).model_spec();
+    MakeModelSpec(model_spec.name(), model_spec.signature_name(),
+                  servable_version_, result->mutable_model_spec());
   }
   return OkStatus();
 }
@@ -130,11 +234,13 @@ Status RunMultiInference(
     const RunOptions& run_options, const MetaGraphDef& meta_graph_def,
     const absl::optional<int64_t>& servable_version, Session* session,
     const MultiInferenceRequest& request, MultiInferenceResponse* response,
-    const tensorflow::thread::ThreadPoolOptions& thread_pool_options) {
+    const tensorflow::thread::ThreadPoolOptions& thread_pool_options,
+    MultiInferencePlanCache* plan_cache, uint64_t load_generation) {
   TRACELITERAL("RunMultiInference");
 
   TensorFlowMultiInferenceRunner inference_runner(
-      session, &meta_graph_def, servable_version, thread_pool_options);
+      session, &meta_graph_def, servable_version, thread_pool_options,
+      plan_cache, load_generation);
   return inference_runner.Infer(run_options, request, response);
 }
 
@@ -16,16 +16,77 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_MULTI_INFERENCE_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_MULTI_INFERENCE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "absl/types/optional.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow_serving/apis/inference.pb.h"
+#include "tensorflow_serving/core/servable_scoped_cache.h"
 
 namespace tensorflow {
 namespace serving {
 
+// The validated tasks of a MultiInferenceRequest against the signatures of a
+// servable: the single Session::Run() that computes all of them.
+struct MultiInferencePlan {
+  struct Task {
+    string method_name;
+    const SignatureDef* signature;
+  };
+
+  string model_name;
+  // Each fed the serialized Examples of the request.
+  std::set<string> input_tensor_names;
+  // Sorted. Requests with the same set of tasks, in any order, run the same
+  // tensors, so a batching session (see BatchingSession) batches them together.
+  std::vector<string> output_tensor_names;
+  // In the order of the tasks of the request.
+  std::vector<Task> tasks;
+};
+
+// Validates the tasks of 'request' against the signatures in
+// 'meta_graph_def', which must outlive 'plan'.
+//
+// Tasks of the classify and regress methods take the serialized Examples of
+// the request like Classify and Regress do, and get the same results. Tasks of
+// the predict method run arbitrary signatures with a single string input,
+// which is fed the serialized Examples, and get all outputs of their signature
+// like Predict does.
+Status CreateMultiInferencePlan(const MetaGraphDef& meta_graph_def,
+                                const MultiInferenceRequest& request,
+                                MultiInferencePlan* plan);
+
+// Caches the MultiInferencePlans of servables, so that requests with the same
+// tasks as earlier ones skip validating the signatures. The plans are scoped to
+// the loads of the servables (see ServableHandle::load_generation()), so they
+// never outlive the signatures they point to for the requests that get them.
+//
+// This class is thread-safe.
+class MultiInferencePlanCache {
+ public:
+  // Holds up to 'max_entries' plans, evicting the least recently used.
+  explicit MultiInferencePlanCache(size_t max_entries = 1024)
+      : cache_(max_entries) {}
+
+  // Sets 'plan' to the plan of 'request' on the servable of 'load_generation',
+  // whose signatures are in 'meta_graph_def'. Requests that fail validation
+  // are not cached.
+  Status GetPlan(uint64_t load_generation, const MetaGraphDef& meta_graph_def,
+                 const MultiInferenceRequest& request,
+                 std::shared_ptr<const MultiInferencePlan>* plan);
+
+ private:
+  ServableScopedCache<MultiInferencePlan> cache_;
+};
+
 // TensorFlow implementation of the MultiInference.
 // Only supports Models in the SavedModel format.
 class TensorFlowMultiInferenceRunner {
@@ -35,15 +96,22 @@ class TensorFlowMultiInferenceRunner {
       : TensorFlowMultiInferenceRunner(session, meta_graph_def,
                                        /*servable_version=*/{}) {}
 
+  // If 'plan_cache' is set, the plans of requests are looked up in
+  // 'plan_cache', which must outlive the runner, as those of the servable of
+  // 'load_generation'.
   TensorFlowMultiInferenceRunner(
       Session* session, const MetaGraphDef* meta_graph_def,
       absl::optional<int64_t> servable_version,
       const thread::ThreadPoolOptions& thread_pool_options =
-          thread::ThreadPoolOptions())
+          thread::ThreadPoolOptions(),
+      MultiInferencePlanCache* plan_cache = nullptr,
+      uint64_t load_generation = 0)
       : session_(session),
         meta_graph_def_(meta_graph_def),
         servable_version_(servable_version),
-        thread_pool_options_(thread_pool_options) {}
+        thread_pool_options_(thread_pool_options),
+        plan_cache_(plan_cache),
+        load_generation_(load_generation) {}
 
   // Run inference and return the inference results in the same order as the
   // InferenceTasks in the request.
@@ -60,6 +128,8 @@ class TensorFlowMultiInferenceRunner {
   // InferenceResults of the MultiInferenceResponse.
   const absl::optional<int64_t> servable_version_;
   const tensorflow::thread::ThreadPoolOptions thread_pool_options_;
+  MultiInferencePlanCache* const plan_cache_;
+  const uint64_t load_generation_;
 };
 
 // Creates TensorFlowMultiInferenceRunner and calls Infer on it.
@@ -68,7 +138,9 @@ Status RunMultiInference(
     const absl::optional<int64_t>& servable_version, Session* session,
     const MultiInferenceRequest& request, MultiInferenceResponse* response,
     const tensorflow::thread::ThreadPoolOptions& thread_pool_options =
-        tensorflow::thread::ThreadPoolOptions());
+        tensorflow::thread::ThreadPoolOptions(),
+    MultiInferencePlanCache* plan_cache = nullptr,
+    uint64_t load_generation = 0);
 
 }  // namespace serving
 }  // namespace tensorflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow_serving/apis/input.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
 #include "tensorflow_serving/servables/tensorflow/multi_inference.h"
 
 namespace tensorflow {
@@ -32,6 +33,14 @@ const ModelSpec& GetModelSpecFromRequest(const MultiInferenceRequest& request) {
   return ModelSpec::default_instance();
 }
 
+// Shared by the servables of all ServerCores, whose entries are keyed apart by
+// the loads of the servables.
+MultiInferencePlanCache* GetPlanCache() {
+  static MultiInferencePlanCache* const plan_cache =
+      new MultiInferencePlanCache();
+  return plan_cache;
+}
+
 }  // namespace
 
 Status RunMultiInferenceWithServerCore(
@@ -51,9 +60,12 @@ Status RunMultiInferenceWithServerCoreWithModelSpec(
   ServableHandle<SavedModelBundle> bundle;
   TF_RETURN_IF_ERROR(core->GetServableHandle(model_spec, &bundle));
 
-  return RunMultiInference(run_options, bundle->meta_graph_def,
-                           bundle.id().version, bundle->session.get(), request,
-                           response, thread_pool_options);
+  TF_RETURN_IF_ERROR(RunMultiInference(
+      run_options, bundle->meta_graph_def, bundle.id().version,
+      bundle->session.get(), request, response, thread_pool_options,
+      GetPlanCache(), bundle.load_generation()));
+  CapturedWarmupRequests::Global()->Capture(bundle.id().name, request);
+  return OkStatus();
 }
 
 }  // namespace serving
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/multi_inference.h"
 
+#include <algorithm>
 #include <memory>
 #include <type_traits>
 #include <utility>
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow_serving/apis/classification.pb.h"
 #include "tensorflow_serving/apis/input.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
 #include "tensorflow_serving/apis/regression.pb.h"
 #include "tensorflow_serving/core/availability_preserving_policy.h"
 #include "tensorflow_serving/model_servers/model_platform_types.h"
@@ -270,7 +272,8 @@ TYPED_TEST_P(MultiInferenceTest, UsupportedSignatureTypeTest) {
 
   MultiInferenceRequest request;
   AddInput({{"x", 2}}, &request);
-  PopulateTask("serving_default", kPredictMethodName, request.add_tasks());
+  PopulateTask("serving_default", "tensorflow/serving/unknown",
+               request.add_tasks());
 
   MultiInferenceResponse response;
   ExpectStatusError(
@@ -434,12 +437,111 @@ TYPED_TEST_P(MultiInferenceTest, ThreadPoolOptions) {
   ASSERT_GE(inter_op_threadpool.NumScheduled(), 1);
 }
 
+TYPED_TEST_P(MultiInferenceTest, PredictAndRegressSignaturesTest) {
+  std::unique_ptr<TensorFlowMultiInferenceRunner> inference_runner;
+  TF_ASSERT_OK(this->GetInferenceRunner(&inference_runner));
+
+  MultiInferenceRequest request;
+  AddInput({{"x", 2}}, &request);
+  // Any signature with a single string input can be run as a predict task.
+  PopulateTask("regress_x_to_y", kPredictMethodName, request.add_tasks());
+  PopulateTask("regress_x_to_y2", kRegressMethodName, request.add_tasks());
+
+  MultiInferenceResponse response;
+  TF_ASSERT_OK(inference_runner->Infer(RunOptions(), request, &response));
+  ASSERT_EQ(2, response.results_size());
+  const InferenceResult& predict_result = response.results(0);
+  EXPECT_EQ(this->servable_version_,
+            predict_result.model_spec().version().value());
+  ASSERT_TRUE(predict_result.has_predict_result());
+  const auto& outputs = predict_result.predict_result().outputs();
+  ASSERT_EQ(1, outputs.size());
+  Tensor y;
+  ASSERT_TRUE(y.FromProto(outputs.begin()->second));
+  ASSERT_EQ(1, y.NumElements());
+  EXPECT_EQ(3.0, y.flat<float>()(0));
+  ASSERT_TRUE(response.results(1).has_regression_result());
+  EXPECT_EQ(4.0,
+            response.results(1).regression_result().regressions(0).value());
+
+  // Predict tasks need the serialized Examples as their single input.
+  request.clear_tasks();
+  PopulateTask("predict_x_to_y", kPredictMethodName, request.add_tasks());
+  ExpectStatusError(
+      inference_runner->Infer(RunOptions(), request, &response),
+      static_cast<tsl::errors::Code>(absl::StatusCode::kInvalidArgument),
+      "must be of type string");
+}
+
+TYPED_TEST_P(MultiInferenceTest, PlanCacheTest) {
+  ServableHandle<SavedModelBundle> bundle;
+  TF_ASSERT_OK(this->GetServableHandle(&bundle));
+  MultiInferencePlanCache plan_cache;
+
+  MultiInferenceRequest request;
+  AddInput({{"x", 2}}, &request);
+  PopulateTask("regress_x_to_y", kRegressMethodName, request.add_tasks());
+  PopulateTask("classify_x_to_y", kClassifyMethodName, request.add_tasks());
+
+  std::shared_ptr<const MultiInferencePlan> plan;
+  const uint64_t load_generation = bundle.load_generation();
+  ASSERT_NE(0, load_generation);
+  TF_ASSERT_OK(plan_cache.GetPlan(load_generation, bundle->meta_graph_def,
+                                  request, &plan));
+  ASSERT_EQ(2, plan->tasks.size());
+  EXPECT_EQ(kRegressMethodName, plan->tasks[0].method_name);
+  EXPECT_EQ(&bundle->meta_graph_def.signature_def().at("regress_x_to_y"),
+            plan->tasks[0].signature);
+  EXPECT_TRUE(std::is_sorted(plan->output_tensor_names.begin(),
+                             plan->output_tensor_names.end()));
+
+  // The same tasks get the same plan, other loads and tasks don't.
+  std::shared_ptr<const MultiInferencePlan> cached_plan;
+  TF_ASSERT_OK(plan_cache.GetPlan(load_generation, bundle->meta_graph_def,
+                                  request, &cached_plan));
+  EXPECT_EQ(plan, cached_plan);
+  TF_ASSERT_OK(plan_cache.GetPlan(load_generation + 1, bundle->meta_graph_def,
+                                  request, &cached_plan));
+  EXPECT_NE(plan, cached_plan);
+  request.mutable_tasks()->SwapElements(0, 1);
+  TF_ASSERT_OK(plan_cache.GetPlan(load_generation, bundle->meta_graph_def,
+                                  request, &cached_plan));
+  EXPECT_NE(plan, cached_plan);
+  EXPECT_EQ(kClassifyMethodName, cached_plan->tasks[0].method_name);
+  EXPECT_EQ(plan->output_tensor_names, cached_plan->output_tensor_names);
+
+  // Invalid requests fail every time.
+  PopulateTask("regress_x_to_y", kRegressMethodName, request.add_tasks());
+  for (int i = 0; i < 2; ++i) {
+    ExpectStatusError(
+        plan_cache.GetPlan(load_generation, bundle->meta_graph_def, request,
+                           &cached_plan),
+        static_cast<tsl::errors::Code>(absl::StatusCode::kInvalidArgument),
+        "Duplicate evaluation of signature: regress_x_to_y");
+  }
+
+  // Runs with the cached plans get the same results.
+  request.mutable_tasks()->RemoveLast();
+  MultiInferenceResponse expected_response;
+  TF_ASSERT_OK(RunMultiInference(RunOptions(), bundle->meta_graph_def,
+                                 this->servable_version_, bundle->session.get(),
+                                 request, &expected_response));
+  for (int i = 0; i < 2; ++i) {
+    MultiInferenceResponse response;
+    TF_ASSERT_OK(RunMultiInference(
+        RunOptions(), bundle->meta_graph_def, this->servable_version_,
+        bundle->session.get(), request, &response,
+        thread::ThreadPoolOptions(), &plan_cache, load_generation));
+    EXPECT_THAT(response, test_util::EqualsProto(expected_response));
+  }
+}
+
 REGISTER_TYPED_TEST_SUITE_P(
     MultiInferenceTest, MissingInputTest, UndefinedSignatureTest,
     InconsistentModelSpecsInRequestTest, EvaluateDuplicateSignaturesTest,
     UsupportedSignatureTypeTest, ValidSingleSignatureTest,
     MultipleValidRegressSignaturesTest, RegressAndClassifySignaturesTest,
-    ThreadPoolOptions);
+    ThreadPoolOptions, PredictAndRegressSignaturesTest, PlanCacheTest);
 
 typedef ::testing::Types<tf1_model_t, tf2_model_t> ModelTypes;
 INSTANTIATE_TYPED_TEST_SUITE_P(MultiInference, MultiInferenceTest, ModelTypes);
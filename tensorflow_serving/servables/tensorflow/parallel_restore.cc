@@ -0,0 +1,367 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/parallel_restore.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader_util.h"
+#include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/saver.pb.h"
+#include "tensorflow/core/protobuf/tensor_bundle.pb.h"
+#include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// A tensor, or slice of a tensor, restored by a RestoreV2 op.
+struct RestoredTensor {
+  // The output of the RestoreV2 op.
+  string name;
+  string key;
+  DataType dtype;
+  // Set for slices.
+  bool is_slice = false;
+  TensorSlice slice;
+  TensorShape slice_shape;
+
+  // Where the tensor is stored in the checkpoint, and how many bytes it has.
+  int32 shard_id = 0;
+  int64_t offset = 0;
+  int64_t size = 0;
+};
+
+// Finds the tensors restored by the RestoreV2 ops of 'graph_def'.
+Status FindRestoredTensors(const GraphDef& graph_def,
+                           std::vector<RestoredTensor>* tensors) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  const auto get_const_value = [&nodes](const string& input, Tensor* value) {
+    auto it = nodes.find(string(ParseTensorName(input).node()));
+    if (it == nodes.end() || it->second->op() != "Const" ||
+        !value->FromProto(it->second->attr().at("value").tensor())) {
+      return errors::Unimplemented("Input ", input, " is not a constant");
+    }
+    return OkStatus();
+  };
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() != "RestoreV2") {
+      continue;
+    }
+    Tensor keys, shape_and_slices;
+    TF_RETURN_IF_ERROR(get_const_value(node.input(1), &keys));
+    TF_RETURN_IF_ERROR(get_const_value(node.input(2), &shape_and_slices));
+    const auto& dtypes = node.attr().at("dtypes").list();
+    if (keys.NumElements() != dtypes.type_size() ||
+        shape_and_slices.NumElements() != dtypes.type_size()) {
+      return errors::InvalidArgument("Restore op ", node.name(),
+                                     " has mismatched inputs");
+    }
+    for (int i = 0; i < keys.NumElements(); ++i) {
+      RestoredTensor tensor;
+      tensor.name = TensorId(node.name(), i).ToString();
+      tensor.key = string(keys.flat<tstring>()(i));
+      tensor.dtype = dtypes.type(i);
+      const string shape_and_slice(shape_and_slices.flat<tstring>()(i));
+      if (!shape_and_slice.empty()) {
+        tensor.is_slice = true;
+        TensorShape unused_shape;
+        TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(
+            shape_and_slice, &unused_shape, &tensor.slice,
+            &tensor.slice_shape));
+      }
+      tensors->push_back(std::move(tensor));
+    }
+  }
+  return OkStatus();
+}
+
+// Looks up where 'tensors' are stored in the checkpoint at 'prefix'.
+Status LocateTensors(const string& prefix,
+                     std::vector<RestoredTensor>* tensors) {
+  BundleReader reader(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  for (RestoredTensor& tensor : *tensors) {
+    BundleEntryProto entry;
+    TF_RETURN_IF_ERROR(reader.GetBundleEntryProto(tensor.key, &entry));
+    tensor.shard_id = entry.shard_id();
+    tensor.offset = entry.offset();
+    // The entries of sliced tensors only list their slices, which are stored
+    // under keys of their own.
+    tensor.size =
+        tensor.is_slice
+            ? tensor.slice_shape.num_elements() * DataTypeSize(tensor.dtype)
+            : entry.size();
+  }
+  return OkStatus();
+}
+
+// Reads 'tensors[begin, end)' from the checkpoint at 'prefix' into the same
+// elements of 'values'.
+Status ReadTensors(const string& prefix,
+                   const std::vector<RestoredTensor>& tensors, int begin,
+                   int end, std::vector<Tensor>* values) {
+  BundleReader reader(Env::Default(), prefix);
+  TF_RETURN_IF_ERROR(reader.status());
+  for (int i = begin; i < end; ++i) {
+    const RestoredTensor& tensor = tensors[i];
+    Tensor* value = &(*values)[i];
+    if (tensor.is_slice) {
+      *value = Tensor(tensor.dtype, tensor.slice_shape);
+      TF_RETURN_IF_ERROR(reader.LookupSlice(tensor.key, tensor.slice, value));
+    } else {
+      TF_RETURN_IF_ERROR(reader.Lookup(tensor.key, value));
+    }
+    if (value->dtype() != tensor.dtype) {
+      return errors::InvalidArgument(
+          "Variable ", tensor.key, " is restored as ",
+          DataTypeString(tensor.dtype), " but stored as ",
+          DataTypeString(value->dtype()));
+    }
+  }
+  return OkStatus();
+}
+
+// Returns true iff the node 'node_name' of 'nodes', or any of its ancestors, is
+// a variable, i.e. iff running the node may need restored variables.
+bool DependsOnVariables(
+    const std::unordered_map<string, const NodeDef*>& nodes,
+    const string& node_name) {
+  std::vector<string> to_visit = {node_name};
+  std::unordered_set<string> visited;
+  while (!to_visit.empty()) {
+    const string name = to_visit.back();
+    to_visit.pop_back();
+    if (!visited.insert(name).second) {
+      continue;
+    }
+    auto it = nodes.find(name);
+    if (it == nodes.end()) {
+      // Unknown nodes fail the run anyway; don't run them early.
+      return true;
+    }
+    const string& op = it->second->op();
+    if (op == "VarHandleOp" || op == "_VarHandlesOp" || op == "VariableV2" ||
+        op == "Variable" || op == "TemporaryVariable") {
+      return true;
+    }
+    for (const string& input : it->second->input()) {
+      to_visit.push_back(ParseTensorName(input).node());
+    }
+  }
+  return false;
+}
+
+// If the init op 'init_op_name' is a NoOp grouping control inputs, splits them
+// into the ones that don't depend on variables, and the others. Returns false
+// otherwise.
+bool SplitInitOp(const GraphDef& graph_def, const string& init_op_name,
+                 std::vector<string>* independent,
+                 std::vector<string>* dependent) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  auto it = nodes.find(ParseTensorName(init_op_name).node());
+  if (it == nodes.end() || it->second->op() != "NoOp") {
+    return false;
+  }
+  for (const string& input : it->second->input()) {
+    if (!absl::StartsWith(input, "^")) {
+      return false;
+    }
+    const string name(ParseTensorName(input).node());
+    (DependsOnVariables(nodes, name) ? dependent : independent)
+        ->push_back(name);
+  }
+  return true;
+}
+
+// Runs 'targets' of the init op, feeding the paths of the assets like
+// RestoreSession() does.
+Status RunInitOpTargets(const RunOptions& run_options, const string& export_dir,
+                        const MetaGraphDef& meta_graph_def,
+                        const std::vector<string>& targets, Session* session) {
+  if (targets.empty()) {
+    return OkStatus();
+  }
+  std::vector<AssetFileDef> asset_file_defs;
+  TF_RETURN_IF_ERROR(internal::GetAssetFileDefs(meta_graph_def,
+                                                &asset_file_defs));
+  std::vector<std::pair<string, Tensor>> feeds;
+  for (const AssetFileDef& asset_file_def : asset_file_defs) {
+    Tensor path(DT_STRING, TensorShape({}));
+    path.scalar<tstring>()() = io::JoinPath(
+        export_dir, kSavedModelAssetsDirectory, asset_file_def.filename());
+    feeds.push_back({asset_file_def.tensor_info().name(), path});
+  }
+  std::vector<Tensor> unused_outputs;
+  return session->Run(run_options, feeds, {}, targets, &unused_outputs,
+                      nullptr);
+}
+
+}  // namespace
+
+Status LoadSavedModelWithParallelRestore(const SessionOptions& session_options,
+                                         const RunOptions& run_options,
+                                         const string& export_dir,
+                                         const std::unordered_set<string>& tags,
+                                         const int num_threads,
+                                         const bool overlap_init_op,
+                                         SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  MetaGraphDef& meta_graph_def = bundle->meta_graph_def;
+  std::vector<RestoredTensor> tensors;
+  if ((num_threads > 1 || overlap_init_op) && meta_graph_def.has_saver_def()) {
+    const Status status =
+        FindRestoredTensors(meta_graph_def.graph_def(), &tensors);
+    if (!status.ok()) {
+      LOG(INFO) << "Restoring the variables of " << export_dir
+                << " normally: " << status;
+      tensors.clear();
+    }
+  }
+  if (tensors.empty()) {
+    return LoadSavedModel(session_options, run_options, export_dir, tags,
+                          bundle);
+  }
+
+  const uint64_t start_micros = Env::Default()->NowMicros();
+  const string prefix = io::JoinPath(export_dir, kSavedModelVariablesDirectory,
+                                     kSavedModelVariablesFilename);
+  TF_RETURN_IF_ERROR(LocateTensors(prefix, &tensors));
+  std::sort(tensors.begin(), tensors.end(),
+            [](const RestoredTensor& a, const RestoredTensor& b) {
+              return std::make_pair(a.shard_id, a.offset) <
+                     std::make_pair(b.shard_id, b.offset);
+            });
+
+  // Splits the tensors into runs of about the same size, one per thread.
+  int64_t total_size = 0;
+  for (const RestoredTensor& tensor : tensors) {
+    total_size += tensor.size;
+  }
+  std::vector<std::pair<int, int>> runs;
+  int64_t size = 0;
+  int begin = 0;
+  for (int i = 0; i < tensors.size(); ++i) {
+    size += tensors[i].size;
+    if ((runs.size() + 1 < num_threads &&
+         size * num_threads >= total_size * (runs.size() + 1)) ||
+        i + 1 == tensors.size()) {
+      runs.push_back({begin, i + 1});
+      begin = i + 1;
+    }
+  }
+
+  std::vector<string> early_init_targets, late_init_targets;
+  bool split_init_op = false;
+  if (overlap_init_op) {
+    string init_op_name;
+    TF_RETURN_IF_ERROR(
+        internal::GetInitOp(export_dir, meta_graph_def, &init_op_name));
+    split_init_op =
+        !init_op_name.empty() &&
+        SplitInitOp(meta_graph_def.graph_def(), init_op_name,
+                    &early_init_targets, &late_init_targets);
+  }
+
+  std::vector<Tensor> values(tensors.size());
+  std::vector<Status> statuses(runs.size());
+  // While the variables are read, creates the session and runs the parts of
+  // the init op that don't need them.
+  Status session_status;
+  {
+    thread::ThreadPool pool(Env::Default(), "parallel_restore", runs.size());
+    for (int i = 0; i < runs.size(); ++i) {
+      pool.Schedule([&prefix, &tensors, &runs, &values, &statuses, i]() {
+        statuses[i] = ReadTensors(prefix, tensors, runs[i].first,
+                                  runs[i].second, &values);
+      });
+    }
+    session_status = LoadMetagraphIntoSession(session_options, meta_graph_def,
+                                              &bundle->session);
+    if (session_status.ok() && split_init_op) {
+      session_status =
+          RunInitOpTargets(run_options, export_dir, meta_graph_def,
+                           early_init_targets, bundle->session.get());
+      LOG(INFO) << "Ran " << early_init_targets.size() << " of "
+                << early_init_targets.size() + late_init_targets.size()
+                << " parts of the init op of " << export_dir
+                << " while reading its variables";
+    }
+  }
+  TF_RETURN_IF_ERROR(session_status);
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  LOG(INFO) << "Read " << total_size << " bytes of variables of " << export_dir
+            << " with " << runs.size() << " threads in "
+            << (Env::Default()->NowMicros() - start_micros) / 1000 << " ms";
+
+  // Feeds the values to the outputs of the restore ops, so that the ops
+  // themselves do not run.
+  std::vector<std::pair<string, Tensor>> feeds;
+  for (int i = 0; i < tensors.size(); ++i) {
+    feeds.push_back({tensors[i].name, std::move(values[i])});
+  }
+  Tensor prefix_tensor(DT_STRING, TensorShape({}));
+  prefix_tensor.scalar<tstring>()() = prefix;
+  feeds.push_back(
+      {meta_graph_def.saver_def().filename_tensor_name(), prefix_tensor});
+  std::vector<Tensor> unused_outputs;
+  TF_RETURN_IF_ERROR(bundle->session->Run(
+      run_options, feeds, {}, {meta_graph_def.saver_def().restore_op_name()},
+      &unused_outputs, nullptr));
+  if (split_init_op) {
+    return RunInitOpTargets(run_options, export_dir, meta_graph_def,
+                            late_init_targets, bundle->session.get());
+  }
+
+  // Runs the init op, but does not restore the variables again.
+  std::unique_ptr<SaverDef> saver_def(meta_graph_def.release_saver_def());
+  const Status status =
+      RestoreSession(run_options, meta_graph_def, export_dir, &bundle->session);
+  meta_graph_def.set_allocated_saver_def(saver_def.release());
+  return status;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,58 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PARALLEL_RESTORE_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PARALLEL_RESTORE_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but reads its
+// variables from the checkpoint with 'num_threads' threads rather than in the
+// restore ops, one tensor at a time.
+//
+// The tensors (and slices of tensors) are ordered by where they are stored in
+// the checkpoint shards, and split into runs of about the same number of
+// bytes, one per thread. Each thread so reads its part of the files in order,
+// which keeps the read-ahead of the file system useful. The restore ops are
+// then fed the values that were read.
+//
+// The session is created while the variables are read. If 'overlap_init_op',
+// the parts of the init op that don't depend on variables, e.g. the
+// initializers of lookup tables from assets, run then too, and the rest of the
+// init op after the variables are restored. The init op must be a NoOp that
+// groups its parts as control inputs for this to apply.
+//
+// Graphs whose restore ops do not take their keys and slices as constants are
+// restored normally.
+Status LoadSavedModelWithParallelRestore(const SessionOptions& session_options,
+                                         const RunOptions& run_options,
+                                         const string& export_dir,
+                                         const std::unordered_set<string>& tags,
+                                         int num_threads, bool overlap_init_op,
+                                         SavedModelBundle* bundle);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PARALLEL_RESTORE_H_
@@ -0,0 +1,221 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/parallel_restore.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+// Returns the text of a float resource variable 'name' of shape 'dims'.
+string VariableNode(const string& name, const string& dims) {
+  return absl::StrCat(
+      "node { name: '", name, "' op: 'VarHandleOp' ",
+      "attr { key: 'dtype' value { type: DT_FLOAT } } ",
+      "attr { key: 'shape' value { shape { ", dims, " } } } ",
+      "attr { key: 'shared_name' value { s: '", name, "' } } } ");
+}
+
+// Returns the text of a float node.
+string FloatNode(const string& name, const string& op,
+                 const std::vector<string>& inputs, const string& type_attr) {
+  string node = absl::StrCat("node { name: '", name, "' op: '", op, "' ");
+  for (const string& input : inputs) {
+    absl::StrAppend(&node, "input: '", input, "' ");
+  }
+  absl::StrAppend(&node, "attr { key: '", type_attr,
+                  "' value { type: DT_FLOAT } } } ");
+  return node;
+}
+
+// Returns the text of a Const node with the string vector 'values'.
+string StringsNode(const string& name, const std::vector<string>& values) {
+  string node = absl::StrCat(
+      "node { name: '", name, "' op: 'Const' ",
+      "attr { key: 'dtype' value { type: DT_STRING } } ",
+      "attr { key: 'value' value { tensor { dtype: DT_STRING ",
+      "tensor_shape { dim { size: ", values.size(), " } } ");
+  for (const string& value : values) {
+    absl::StrAppend(&node, "string_val: '", value, "' ");
+  }
+  absl::StrAppend(&node, "} } } } ");
+  return node;
+}
+
+// Returns the text of a lookup table op 'name' from strings to floats.
+string TableNode(const string& name, const string& op,
+                 const std::vector<string>& inputs) {
+  string node = absl::StrCat("node { name: '", name, "' op: '", op, "' ");
+  for (const string& input : inputs) {
+    absl::StrAppend(&node, "input: '", input, "' ");
+  }
+  absl::StrAppend(&node, "attr { key: 'Tin' value { type: DT_STRING } } ",
+                  "attr { key: 'Tout' value { type: DT_FLOAT } } } ");
+  return node;
+}
+
+// A graph that adds variables 'a' and 'b', and reads the first two rows of the
+// variable 'w', which is partitioned in the checkpoint. Its init op copies 'a'
+// into the variable 'c', and fills the lookup table 'table', which doesn't
+// need the variables.
+string Graph() {
+  return absl::StrCat(
+      VariableNode("a", "dim { size: 2 }"),
+      VariableNode("b", "dim { size: 2 }"),
+      VariableNode("w_part_0", "dim { size: 2 } dim { size: 2 }"),
+      FloatNode("a_read", "ReadVariableOp", {"a"}, "dtype"),
+      FloatNode("b_read", "ReadVariableOp", {"b"}, "dtype"),
+      FloatNode("sum", "Add", {"a_read", "b_read"}, "T"),
+      FloatNode("w", "ReadVariableOp", {"w_part_0"}, "dtype"),
+      "node { name: 'save/Const' op: 'Placeholder' ",
+      "attr { key: 'dtype' value { type: DT_STRING } } } ",
+      StringsNode("save/tensor_names", {"a", "b", "w"}),
+      StringsNode("save/shape_and_slices", {"", "", "4 2 0,2:-"}),
+      "node { name: 'save/RestoreV2' op: 'RestoreV2' input: 'save/Const' ",
+      "input: 'save/tensor_names' input: 'save/shape_and_slices' ",
+      "attr { key: 'dtypes' value { list { type: DT_FLOAT type: DT_FLOAT ",
+      "type: DT_FLOAT } } } } ",
+      FloatNode("save/assign_a", "AssignVariableOp", {"a", "save/RestoreV2:0"},
+                "dtype"),
+      FloatNode("save/assign_b", "AssignVariableOp", {"b", "save/RestoreV2:1"},
+                "dtype"),
+      FloatNode("save/assign_w", "AssignVariableOp",
+                {"w_part_0", "save/RestoreV2:2"}, "dtype"),
+      "node { name: 'save/restore_all' op: 'NoOp' input: '^save/assign_a' ",
+      "input: '^save/assign_b' input: '^save/assign_w' }",
+      VariableNode("c", "dim { size: 2 }"),
+      FloatNode("init/assign_c", "AssignVariableOp", {"c", "a_read"}, "dtype"),
+      FloatNode("c_read", "ReadVariableOp", {"c"}, "dtype"),
+      "node { name: 'table' op: 'HashTableV2' ",
+      "attr { key: 'key_dtype' value { type: DT_STRING } } ",
+      "attr { key: 'value_dtype' value { type: DT_FLOAT } } ",
+      "attr { key: 'shared_name' value { s: 'table' } } } ",
+      StringsNode("keys", {"x"}),
+      "node { name: 'init/values' op: 'Const' ",
+      "attr { key: 'dtype' value { type: DT_FLOAT } } ",
+      "attr { key: 'value' value { tensor { dtype: DT_FLOAT ",
+      "tensor_shape { dim { size: 1 } } float_val: 5 } } } } ",
+      "node { name: 'default' op: 'Const' ",
+      "attr { key: 'dtype' value { type: DT_FLOAT } } ",
+      "attr { key: 'value' value { tensor { dtype: DT_FLOAT ",
+      "tensor_shape { } float_val: 0 } } } } ",
+      TableNode("init/table", "LookupTableImportV2",
+                {"table", "keys", "init/values"}),
+      TableNode("lookup", "LookupTableFindV2", {"table", "keys", "default"}),
+      "node { name: 'init' op: 'NoOp' input: '^init/assign_c' ",
+      "input: '^init/table' }");
+}
+
+class ParallelRestoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    export_dir_ = io::JoinPath(
+        testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(export_dir_, kSavedModelVariablesDirectory)));
+    BundleWriter writer(
+        Env::Default(),
+        io::JoinPath(export_dir_, kSavedModelVariablesDirectory,
+                     kSavedModelVariablesFilename));
+    TF_ASSERT_OK(writer.Add("a", test::AsTensor<float>({1, 2})));
+    TF_ASSERT_OK(writer.Add("b", test::AsTensor<float>({10, 20})));
+    TensorSlice top, bottom;
+    TF_ASSERT_OK(TensorSlice::Parse("0,2:-", &top));
+    TF_ASSERT_OK(TensorSlice::Parse("2,2:-", &bottom));
+    TF_ASSERT_OK(writer.AddSlice(
+        "w", TensorShape({4, 2}), top,
+        test::AsTensor<float>({0, 1, 2, 3}, TensorShape({2, 2}))));
+    TF_ASSERT_OK(writer.AddSlice(
+        "w", TensorShape({4, 2}), bottom,
+        test::AsTensor<float>({4, 5, 6, 7}, TensorShape({2, 2}))));
+    TF_ASSERT_OK(writer.Finish());
+
+    SavedModel saved_model;
+    MetaGraphDef* meta_graph_def = saved_model.add_meta_graphs();
+    meta_graph_def->mutable_meta_info_def()->add_tags(kSavedModelTagServe);
+    *meta_graph_def->mutable_graph_def() = CreateProto<GraphDef>(Graph());
+    meta_graph_def->mutable_saver_def()->set_filename_tensor_name(
+        "save/Const:0");
+    meta_graph_def->mutable_saver_def()->set_restore_op_name(
+        "save/restore_all");
+    (*meta_graph_def->mutable_collection_def())[kSavedModelMainOpKey]
+        .mutable_node_list()
+        ->add_value("init");
+    TF_ASSERT_OK(WriteBinaryProto(
+        Env::Default(), io::JoinPath(export_dir_, kSavedModelFilenamePb),
+        saved_model));
+  }
+
+  // Loads the SavedModel with 'num_threads' and checks its variables and the
+  // effects of its init op.
+  void LoadAndCheck(int num_threads, bool overlap_init_op = false) {
+    SavedModelBundle bundle;
+    TF_ASSERT_OK(LoadSavedModelWithParallelRestore(
+        SessionOptions(), RunOptions(), export_dir_, {kSavedModelTagServe},
+        num_threads, overlap_init_op, &bundle));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(bundle.session->Run(
+        {}, {"sum:0", "w:0", "c_read:0", "lookup:0"}, {}, &outputs));
+    test::ExpectTensorEqual<float>(test::AsTensor<float>({11, 22}),
+                                   outputs[0]);
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({0, 1, 2, 3}, TensorShape({2, 2})), outputs[1]);
+    test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2}), outputs[2]);
+    test::ExpectTensorEqual<float>(test::AsTensor<float>({5}), outputs[3]);
+  }
+
+  string export_dir_;
+};
+
+TEST_F(ParallelRestoreTest, RestoresInParallel) { LoadAndCheck(2); }
+
+TEST_F(ParallelRestoreTest, MoreThreadsThanTensors) { LoadAndCheck(8); }
+
+TEST_F(ParallelRestoreTest, SingleThreadLoadsNormally) { LoadAndCheck(1); }
+
+// The table is filled while the variables are read, and 'c' is assigned after
+// they are restored; assigning it earlier would fail to read 'a'.
+TEST_F(ParallelRestoreTest, OverlapsInitOpWithRestore) {
+  LoadAndCheck(2, /*overlap_init_op=*/true);
+}
+
+TEST_F(ParallelRestoreTest, OverlapsInitOpWithSingleThread) {
+  LoadAndCheck(1, /*overlap_init_op=*/true);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
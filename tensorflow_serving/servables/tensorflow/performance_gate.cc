@@ -0,0 +1,187 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/performance_gate.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "google/protobuf/wrappers.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/gauge.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_warmup.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_warmup_util.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+auto* benchmark_median_latency = monitoring::Gauge<double, 2>::New(
+    "/tensorflow/serving/performance_gate/median_latency_micros",
+    "The median latency of the warmup requests of the servable, in "
+    "microseconds, when benchmarked by the performance gate.",
+    "model_name", "version");
+
+auto* benchmark_throughput = monitoring::Gauge<double, 2>::New(
+    "/tensorflow/serving/performance_gate/throughput",
+    "The throughput of the warmup requests of the servable, in requests per "
+    "second, when benchmarked by the performance gate.",
+    "model_name", "version");
+
+auto* gate_results = monitoring::Counter<2>::New(
+    "/tensorflow/serving/performance_gate/results",
+    "The number of versions of the model the performance gate checked, by "
+    "result: 'passed', 'refused', or 'unmeasured' for versions without "
+    "warmup requests.",
+    "model_name", "result");
+
+constexpr int kDefaultNumIterations = 10;
+
+}  // namespace
+
+bool HasPerformanceGate(const PerformanceGateConfig& config) {
+  return config.max_latency_regression() > 0 ||
+         config.max_throughput_regression() > 0;
+}
+
+Status PerformanceGate::Check(const PerformanceGateConfig& config,
+                              const ModelWarmupOptions& warmup_options,
+                              const ServableId& id,
+                              const RunOptions& run_options,
+                              const string& export_dir,
+                              SavedModelBundle* bundle) {
+  Benchmark benchmark;
+  TF_RETURN_IF_ERROR(internal::BenchmarkWarmupRequests(
+      config, warmup_options, export_dir, Env::Default(),
+      [&](PredictionLog record) {
+        return RunWarmupRequest(record, run_options, bundle->meta_graph_def,
+                                bundle->GetSession());
+      },
+      &benchmark));
+  return Compare(config, id, benchmark);
+}
+
+Status PerformanceGate::Compare(const PerformanceGateConfig& config,
+                                const ServableId& id,
+                                const Benchmark& benchmark) {
+  if (benchmark.num_requests == 0) {
+    LOG(INFO) << "Not checking the performance of " << id.DebugString()
+              << ", which has no warmup requests";
+    gate_results->GetCell(id.name, "unmeasured")->IncrementBy(1);
+    return OkStatus();
+  }
+  const string version = strings::StrCat(id.version);
+  benchmark_median_latency->GetCell(id.name, version)
+      ->Set(benchmark.median_latency_micros);
+  benchmark_throughput->GetCell(id.name, version)->Set(benchmark.throughput);
+  LOG(INFO) << "Benchmarked " << id.DebugString() << " on "
+            << benchmark.num_requests << " warmup requests: median latency "
+            << benchmark.median_latency_micros << " us, throughput "
+            << benchmark.throughput << " requests/s";
+
+  mutex_lock l(mu_);
+  auto baseline = baselines_.find(id.name);
+  if (baseline != baselines_.end()) {
+    const int64_t baseline_version = baseline->second.first;
+    const Benchmark& baseline_benchmark = baseline->second.second;
+    Status status;
+    if (config.max_latency_regression() > 0 &&
+        benchmark.median_latency_micros >
+            baseline_benchmark.median_latency_micros *
+                (1 + config.max_latency_regression())) {
+      status = errors::FailedPrecondition(
+          "The median latency of ", id.DebugString(), ", ",
+          benchmark.median_latency_micros, " us, exceeds that of version ",
+          baseline_version, ", ", baseline_benchmark.median_latency_micros,
+          " us, by more than ", 100 * config.max_latency_regression(), "%");
+    } else if (config.max_throughput_regression() > 0 &&
+               benchmark.throughput <
+                   baseline_benchmark.throughput *
+                       (1 - config.max_throughput_regression())) {
+      status = errors::FailedPrecondition(
+          "The throughput of ", id.DebugString(), ", ", benchmark.throughput,
+          " requests/s, falls short of that of version ", baseline_version,
+          ", ", baseline_benchmark.throughput, " requests/s, by more than ",
+          100 * config.max_throughput_regression(), "%");
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "The performance gate refuses " << id.DebugString()
+                   << ": " << status;
+      gate_results->GetCell(id.name, "refused")->IncrementBy(1);
+      return status;
+    }
+  }
+  gate_results->GetCell(id.name, "passed")->IncrementBy(1);
+  baselines_[id.name] = {id.version, benchmark};
+  return OkStatus();
+}
+
+namespace internal {
+
+Status BenchmarkWarmupRequests(
+    const PerformanceGateConfig& config,
+    const ModelWarmupOptions& warmup_options, const string& export_dir,
+    Env* env, std::function<Status(PredictionLog)> executor,
+    PerformanceGate::Benchmark* benchmark) {
+  ModelWarmupOptions options;
+  options.mutable_num_request_iterations()->set_value(
+      config.num_iterations() > 0 ? config.num_iterations()
+                                  : kDefaultNumIterations);
+  options.mutable_num_model_warmup_threads()->set_value(
+      std::max(config.num_threads(), 1));
+  // Captured requests are looked up by model name, which otherwise is left
+  // unset so that batch ops serve the benchmark like live traffic.
+  if (warmup_options.use_captured_warmup_requests()) {
+    options.set_model_name(warmup_options.model_name());
+    options.set_model_version(warmup_options.model_version());
+    options.set_use_captured_warmup_requests(true);
+  }
+
+  mutex mu;
+  std::vector<uint64_t> latencies_micros;
+  const uint64_t start_micros = env->NowMicros();
+  TF_RETURN_IF_ERROR(RunSavedModelWarmup(
+      options, export_dir, [&](PredictionLog record) -> Status {
+        const uint64_t request_start_micros = env->NowMicros();
+        TF_RETURN_IF_ERROR(executor(std::move(record)));
+        const uint64_t latency_micros =
+            env->NowMicros() - request_start_micros;
+        mutex_lock l(mu);
+        latencies_micros.push_back(latency_micros);
+        return OkStatus();
+      }));
+  const uint64_t wall_micros = env->NowMicros() - start_micros;
+
+  *benchmark = {};
+  if (latencies_micros.empty()) {
+    return OkStatus();
+  }
+  benchmark->num_requests = latencies_micros.size();
+  auto median = latencies_micros.begin() + latencies_micros.size() / 2;
+  std::nth_element(latencies_micros.begin(), median, latencies_micros.end());
+  benchmark->median_latency_micros = *median;
+  benchmark->throughput =
+      wall_micros == 0 ? 0 : 1e6 * latencies_micros.size() / wall_micros;
+  return OkStatus();
+}
+
+}  // namespace internal
+
+}  // namespace serving
+}  // namespace tensorflow
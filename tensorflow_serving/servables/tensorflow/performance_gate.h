@@ -0,0 +1,110 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PERFORMANCE_GATE_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PERFORMANCE_GATE_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/core/servable_id.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Returns whether 'config' checks the performance of new versions at all.
+bool HasPerformanceGate(const PerformanceGateConfig& config);
+
+// Benchmarks new versions of models on their warmup requests before they
+// become available, and refuses the versions that are slower than the version
+// of their model loaded before them by more than the thresholds of a
+// PerformanceGateConfig.
+//
+// The baseline of a model is the benchmark of its last version that passed
+// the gate, taken when it was loaded; the first version of a model in the
+// process always passes. A refused version fails to load, so with the
+// availability-preserving version policy the versions already serving keep
+// serving. The benchmarks and their results are exported as metrics under
+// /tensorflow/serving/performance_gate/.
+//
+// This class is thread-safe.
+class PerformanceGate {
+ public:
+  // The performance of a servable on its warmup requests.
+  struct Benchmark {
+    // The number of requests replayed.
+    int64_t num_requests = 0;
+    double median_latency_micros = 0;
+    // In requests per second.
+    double throughput = 0;
+  };
+
+  PerformanceGate() = default;
+
+  // Benchmarks 'bundle', of the servable 'id' at 'export_dir', on its warmup
+  // requests (see ModelWarmupOptions.use_captured_warmup_requests of
+  // 'warmup_options') and compares it with the baseline of its model. Returns
+  // a FailedPrecondition error if it regresses beyond the thresholds of
+  // 'config'. The bundle must be warmed up already.
+  Status Check(const PerformanceGateConfig& config,
+               const ModelWarmupOptions& warmup_options, const ServableId& id,
+               const RunOptions& run_options, const string& export_dir,
+               SavedModelBundle* bundle) TF_LOCKS_EXCLUDED(mu_);
+
+  // Compares 'benchmark', of the servable 'id', with the baseline of its
+  // model, like Check(), and makes it the baseline if it passes. Versions
+  // without warmup requests pass, and leave the baseline as is.
+  Status Compare(const PerformanceGateConfig& config, const ServableId& id,
+                 const Benchmark& benchmark) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  mutex mu_;
+
+  // The versions of the models that last passed, and their benchmarks.
+  std::map<string, std::pair<int64_t, Benchmark>> baselines_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PerformanceGate);
+};
+
+namespace internal {
+
+// Replays the warmup requests of the model at 'export_dir' with 'executor', as
+// configured by 'config', timing them with 'env', and sets 'benchmark' to
+// their performance.
+Status BenchmarkWarmupRequests(
+    const PerformanceGateConfig& config,
+    const ModelWarmupOptions& warmup_options, const string& export_dir,
+    Env* env, std::function<Status(PredictionLog)> executor,
+    PerformanceGate::Benchmark* benchmark);
+
+}  // namespace internal
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PERFORMANCE_GATE_H_
@@ -0,0 +1,123 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/performance_gate.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_warmup_test_util.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_warmup_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+PerformanceGate::Benchmark MakeBenchmark(double median_latency_micros,
+                                         double throughput) {
+  PerformanceGate::Benchmark benchmark;
+  benchmark.num_requests = 100;
+  benchmark.median_latency_micros = median_latency_micros;
+  benchmark.throughput = throughput;
+  return benchmark;
+}
+
+TEST(PerformanceGateTest, RefusesLatencyRegressions) {
+  PerformanceGateConfig config;
+  config.set_max_latency_regression(0.5);
+  PerformanceGate gate;
+  // The first version has nothing to compare with.
+  TF_EXPECT_OK(gate.Compare(config, {"m", 1}, MakeBenchmark(100, 10)));
+  TF_EXPECT_OK(gate.Compare(config, {"m", 2}, MakeBenchmark(140, 1)));
+  EXPECT_EQ(error::FAILED_PRECONDITION,
+            gate.Compare(config, {"m", 3}, MakeBenchmark(220, 10)).code());
+  // Version 2 stays the baseline.
+  TF_EXPECT_OK(gate.Compare(config, {"m", 4}, MakeBenchmark(200, 10)));
+  // Other models have their own baselines.
+  TF_EXPECT_OK(gate.Compare(config, {"other", 1}, MakeBenchmark(1000, 10)));
+}
+
+TEST(PerformanceGateTest, RefusesThroughputRegressions) {
+  PerformanceGateConfig config;
+  config.set_max_throughput_regression(0.2);
+  PerformanceGate gate;
+  TF_EXPECT_OK(gate.Compare(config, {"m", 1}, MakeBenchmark(100, 1000)));
+  EXPECT_EQ(error::FAILED_PRECONDITION,
+            gate.Compare(config, {"m", 2}, MakeBenchmark(100, 700)).code());
+  TF_EXPECT_OK(gate.Compare(config, {"m", 3}, MakeBenchmark(1000, 900)));
+}
+
+TEST(PerformanceGateTest, PassesVersionsWithoutWarmupRequests) {
+  PerformanceGateConfig config;
+  config.set_max_latency_regression(0.1);
+  PerformanceGate gate;
+  TF_EXPECT_OK(gate.Compare(config, {"m", 1}, MakeBenchmark(100, 10)));
+  TF_EXPECT_OK(gate.Compare(config, {"m", 2}, {}));
+  EXPECT_EQ(error::FAILED_PRECONDITION,
+            gate.Compare(config, {"m", 3}, MakeBenchmark(200, 10)).code());
+}
+
+TEST(PerformanceGateTest, BenchmarksWarmupRequests) {
+  const string export_dir =
+      io::JoinPath(testing::TmpDir(), "BenchmarksWarmupRequests");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory)));
+  std::vector<string> warmup_records;
+  TF_ASSERT_OK(
+      AddMixedWarmupData(&warmup_records, {PredictionLog::kPredictLog}));
+  TF_ASSERT_OK(WriteWarmupData(
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                   internal::WarmupConsts::kRequestsFileName),
+      warmup_records, 3));
+
+  test_util::FakeClockEnv env(Env::Default());
+  PerformanceGateConfig config;
+  config.set_num_iterations(2);
+  // Requests take 10, 20 and 30 microseconds in turn.
+  int num_requests = 0;
+  PerformanceGate::Benchmark benchmark;
+  TF_ASSERT_OK(internal::BenchmarkWarmupRequests(
+      config, {}, export_dir, &env,
+      [&](PredictionLog record) {
+        env.AdvanceByMicroseconds(10 * (num_requests++ % 3 + 1));
+        return OkStatus();
+      },
+      &benchmark));
+  EXPECT_EQ(6, num_requests);
+  EXPECT_EQ(6, benchmark.num_requests);
+  EXPECT_EQ(20, benchmark.median_latency_micros);
+  EXPECT_DOUBLE_EQ(1e6 * 6 / 120, benchmark.throughput);
+
+  // Without warmup requests, nothing is measured.
+  const string empty_dir = io::JoinPath(testing::TmpDir(), "NoWarmupRequests");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(empty_dir));
+  TF_ASSERT_OK(internal::BenchmarkWarmupRequests(
+      config, {}, empty_dir, &env,
+      [](PredictionLog record) { return OkStatus(); }, &benchmark));
+  EXPECT_EQ(0, benchmark.num_requests);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
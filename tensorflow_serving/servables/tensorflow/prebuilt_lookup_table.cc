@@ -0,0 +1,561 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/prebuilt_lookup_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader_util.h"
+#include "tensorflow/cc/saved_model/reader.h"
+#include "tensorflow/core/framework/common_shape_fns.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/tensor_id.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+
+const char kPrebuiltLookupTableSuffix[] = ".table";
+
+namespace {
+
+constexpr char kPrebuiltLookupTableOp[] = "TfServingPrebuiltLookupTable";
+
+// The header of a prebuilt table. It is followed by the int64 values of the
+// entries, sorted by key, then by the keys: int64 keys, or for string keys the
+// num_entries + 1 offsets of the keys in the key bytes, then the key bytes.
+// Every array is so 8-byte aligned in a mapped file.
+struct PrebuiltLookupTableHeader {
+  char magic[8];
+  int32 key_dtype;
+  int32 value_dtype;
+  uint64 num_entries;
+  uint64 num_key_bytes;
+};
+static_assert(sizeof(PrebuiltLookupTableHeader) == 32,
+              "The header of prebuilt tables must be packed");
+
+constexpr char kMagic[8] = {'T', 'F', 'S', 'P', 'L', 'T', '1', '\0'};
+
+// The size of a prebuilt table with 'header'.
+uint64 TableSize(const PrebuiltLookupTableHeader& header) {
+  uint64 size = sizeof(header) + header.num_entries * sizeof(int64_t);
+  if (header.key_dtype == DT_STRING) {
+    return size + (header.num_entries + 1) * sizeof(uint64) +
+           header.num_key_bytes;
+  }
+  return size + header.num_entries * sizeof(int64_t);
+}
+
+// Checks that 'header', of a file of 'file_size' bytes, is of a table from
+// 'key_dtype' to 'value_dtype'.
+Status CheckHeader(const string& path, const PrebuiltLookupTableHeader& header,
+                   uint64 file_size, DataType key_dtype, DataType value_dtype) {
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+    return errors::DataLoss(path, " is not a prebuilt lookup table");
+  }
+  if (header.key_dtype != key_dtype || header.value_dtype != value_dtype) {
+    return errors::InvalidArgument(
+        "The prebuilt lookup table ", path, " is from ",
+        DataTypeString(static_cast<DataType>(header.key_dtype)), " to ",
+        DataTypeString(static_cast<DataType>(header.value_dtype)),
+        ", but its table is from ", DataTypeString(key_dtype), " to ",
+        DataTypeString(value_dtype));
+  }
+  if (TableSize(header) != file_size) {
+    return errors::DataLoss("The prebuilt lookup table ", path, " has ",
+                            file_size, " bytes, but its header describes ",
+                            TableSize(header));
+  }
+  return OkStatus();
+}
+
+// A read-only lookup table searched in place in a mapped prebuilt table.
+class PrebuiltLookupTable : public lookup::LookupInterface {
+ public:
+  static Status Open(const string& path, DataType key_dtype,
+                     DataType value_dtype,
+                     std::unique_ptr<PrebuiltLookupTable>* table) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    TF_RETURN_IF_ERROR(
+        Env::Default()->NewReadOnlyMemoryRegionFromFile(path, &region));
+    if (region->length() < sizeof(PrebuiltLookupTableHeader)) {
+      return errors::DataLoss(path, " is not a prebuilt lookup table");
+    }
+    PrebuiltLookupTableHeader header;
+    std::memcpy(&header, region->data(), sizeof(header));
+    TF_RETURN_IF_ERROR(
+        CheckHeader(path, header, region->length(), key_dtype, value_dtype));
+    table->reset(new PrebuiltLookupTable(path, std::move(region), header));
+    return OkStatus();
+  }
+
+  size_t size() const override { return num_entries_; }
+
+  Status Find(OpKernelContext* ctx, const Tensor& keys, Tensor* values,
+              const Tensor& default_value) override {
+    auto out = values->flat<int64_t>();
+    const auto defaults = default_value.flat<int64_t>();
+    const bool scalar_default = defaults.size() == 1;
+    auto set_value = [&](int64_t i, int64_t index) {
+      out(i) = index >= 0 ? values_[index]
+                          : (scalar_default ? defaults(0) : defaults(i));
+    };
+    if (key_dtype() == DT_STRING) {
+      const auto in = keys.flat<tstring>();
+      for (int64_t i = 0; i < out.size(); ++i) {
+        set_value(i, FindString(absl::string_view(in(i).data(), in(i).size())));
+      }
+    } else {
+      const auto in = keys.flat<int64_t>();
+      for (int64_t i = 0; i < out.size(); ++i) {
+        set_value(i, FindInt64(in(i)));
+      }
+    }
+    return OkStatus();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return ReadOnlyError();
+  }
+
+  Status Remove(OpKernelContext* ctx, const Tensor& keys) override {
+    return ReadOnlyError();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return ReadOnlyError();
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    const TensorShape shape({static_cast<int64_t>(num_entries_)});
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(ctx->allocate_output("keys", shape, &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_output("values", shape, &values));
+    for (uint64 i = 0; i < num_entries_; ++i) {
+      if (key_dtype() == DT_STRING) {
+        keys->flat<tstring>()(i) = string(StringKey(i));
+      } else {
+        keys->flat<int64_t>()(i) = int64_keys_[i];
+      }
+      values->flat<int64_t>()(i) = values_[i];
+    }
+    return OkStatus();
+  }
+
+  DataType key_dtype() const override {
+    return static_cast<DataType>(key_dtype_);
+  }
+  DataType value_dtype() const override { return DT_INT64; }
+  TensorShape key_shape() const override { return TensorShape(); }
+  TensorShape value_shape() const override { return TensorShape(); }
+
+  string DebugString() const override {
+    return absl::StrCat("PrebuiltLookupTable(", path_, ")");
+  }
+
+ private:
+  PrebuiltLookupTable(const string& path,
+                      std::unique_ptr<ReadOnlyMemoryRegion> region,
+                      const PrebuiltLookupTableHeader& header)
+      : path_(path),
+        region_(std::move(region)),
+        key_dtype_(header.key_dtype),
+        num_entries_(header.num_entries),
+        num_key_bytes_(header.num_key_bytes) {
+    const char* data =
+        static_cast<const char*>(region_->data()) + sizeof(header);
+    values_ = reinterpret_cast<const int64_t*>(data);
+    data += num_entries_ * sizeof(int64_t);
+    if (key_dtype_ == DT_STRING) {
+      key_offsets_ = reinterpret_cast<const uint64*>(data);
+      key_bytes_ = data + (num_entries_ + 1) * sizeof(uint64);
+    } else {
+      int64_keys_ = reinterpret_cast<const int64_t*>(data);
+    }
+  }
+
+  static Status ReadOnlyError() {
+    return errors::FailedPrecondition("Prebuilt lookup tables are read-only");
+  }
+
+  // The key of entry 'i', clamped to the key bytes.
+  absl::string_view StringKey(uint64 i) const {
+    const uint64 begin = std::min(key_offsets_[i], num_key_bytes_);
+    const uint64 end = std::min(key_offsets_[i + 1], num_key_bytes_);
+    return absl::string_view(key_bytes_ + begin, std::max(begin, end) - begin);
+  }
+
+  // Return the index of the entry with 'key', or -1.
+  int64_t FindString(absl::string_view key) const {
+    uint64 begin = 0, end = num_entries_;
+    while (begin < end) {
+      const uint64 mid = begin + (end - begin) / 2;
+      const int compare = StringKey(mid).compare(key);
+      if (compare == 0) {
+        return mid;
+      }
+      if (compare < 0) {
+        begin = mid + 1;
+      } else {
+        end = mid;
+      }
+    }
+    return -1;
+  }
+  int64_t FindInt64(int64_t key) const {
+    const int64_t* const it =
+        std::lower_bound(int64_keys_, int64_keys_ + num_entries_, key);
+    return it != int64_keys_ + num_entries_ && *it == key
+               ? it - int64_keys_
+               : -1;
+  }
+
+  const string path_;
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const int32 key_dtype_;
+  const uint64 num_entries_;
+  const uint64 num_key_bytes_;
+
+  // Point into 'region_'.
+  const int64_t* values_ = nullptr;
+  const int64_t* int64_keys_ = nullptr;
+  const uint64* key_offsets_ = nullptr;
+  const char* key_bytes_ = nullptr;
+};
+
+// Outputs the handle of the prebuilt table at the attr 'path', which is
+// mapped the first time the op runs.
+class PrebuiltLookupTableOp : public OpKernel {
+ public:
+  explicit PrebuiltLookupTableOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("path", &path_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("key_dtype", &key_dtype_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("value_dtype", &value_dtype_));
+  }
+
+  ~PrebuiltLookupTableOp() override {
+    if (table_created_ && cinfo_.resource_is_private_to_kernel()) {
+      cinfo_.resource_manager()
+          ->Delete<lookup::LookupInterface>(cinfo_.container(), cinfo_.name())
+          .IgnoreError();
+    }
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    mutex_lock l(mu_);
+    if (!table_created_) {
+      OP_REQUIRES_OK(ctx, cinfo_.Init(ctx->resource_manager(), def(),
+                                      /*use_node_name_as_default=*/true));
+      ResourceMgr* const resource_manager = cinfo_.resource_manager();
+      lookup::LookupInterface* table;
+      OP_REQUIRES_OK(ctx,
+                     resource_manager->LookupOrCreate<lookup::LookupInterface>(
+                         cinfo_.container(), cinfo_.name(), &table,
+                         [this](lookup::LookupInterface** created) {
+                           std::unique_ptr<PrebuiltLookupTable> opened;
+                           TF_RETURN_IF_ERROR(PrebuiltLookupTable::Open(
+                               path_, key_dtype_, value_dtype_, &opened));
+                           *created = opened.release();
+                           return OkStatus();
+                         }));
+      table->Unref();
+      table_created_ = true;
+    }
+    Tensor* handle;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &handle));
+    handle->scalar<ResourceHandle>()() =
+        MakeResourceHandle<lookup::LookupInterface>(ctx, cinfo_.container(),
+                                                    cinfo_.name());
+  }
+
+ private:
+  string path_;
+  DataType key_dtype_;
+  DataType value_dtype_;
+
+  mutex mu_;
+  ContainerInfo cinfo_ TF_GUARDED_BY(mu_);
+  bool table_created_ TF_GUARDED_BY(mu_) = false;
+};
+
+REGISTER_OP("TfServingPrebuiltLookupTable")
+    .Output("table_handle: resource")
+    .Attr("path: string")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("key_dtype: {string, int64}")
+    .Attr("value_dtype: {int64}")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape);
+
+REGISTER_KERNEL_BUILDER(
+    Name("TfServingPrebuiltLookupTable").Device(DEVICE_CPU),
+    PrebuiltLookupTableOp);
+
+// Reads and checks the header of the prebuilt table at 'path'.
+Status CheckPrebuiltLookupTable(const string& path, DataType key_dtype,
+                                DataType value_dtype) {
+  uint64 file_size;
+  TF_RETURN_IF_ERROR(Env::Default()->GetFileSize(path, &file_size));
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(path, &file));
+  PrebuiltLookupTableHeader header;
+  absl::string_view read;
+  TF_RETURN_IF_ERROR(file->Read(0, sizeof(header), &read,
+                                reinterpret_cast<char*>(&header)));
+  if (read.size() != sizeof(header)) {
+    return errors::DataLoss(path, " is not a prebuilt lookup table");
+  }
+  if (read.data() != reinterpret_cast<char*>(&header)) {
+    std::memcpy(&header, read.data(), sizeof(header));
+  }
+  return CheckHeader(path, header, file_size, key_dtype, value_dtype);
+}
+
+// Returns the node that the tensor 'input' is of, through Identity ops, or
+// null.
+NodeDef* ResolveNode(const std::unordered_map<string, NodeDef*>& nodes,
+                     const string& input) {
+  auto it = nodes.find(string(ParseTensorName(input).node()));
+  while (it != nodes.end() && it->second->op() == "Identity" &&
+         it->second->input_size() > 0) {
+    it = nodes.find(string(ParseTensorName(it->second->input(0)).node()));
+  }
+  return it == nodes.end() ? nullptr : it->second;
+}
+
+}  // namespace
+
+Status WritePrebuiltLookupTable(const Tensor& keys, const Tensor& values,
+                                const string& path) {
+  if (keys.dims() != 1 || values.dims() != 1 ||
+      keys.NumElements() != values.NumElements()) {
+    return errors::InvalidArgument(
+        "The keys and values of a prebuilt lookup table must be vectors of "
+        "the same length");
+  }
+  if ((keys.dtype() != DT_STRING && keys.dtype() != DT_INT64) ||
+      values.dtype() != DT_INT64) {
+    return errors::InvalidArgument(
+        "Prebuilt lookup tables are from strings or int64 to int64, not from ",
+        DataTypeString(keys.dtype()), " to ", DataTypeString(values.dtype()));
+  }
+  const bool string_keys = keys.dtype() == DT_STRING;
+  const int64_t num_entries = keys.NumElements();
+  auto string_key = [&keys](int64_t i) {
+    const tstring& key = keys.flat<tstring>()(i);
+    return absl::string_view(key.data(), key.size());
+  };
+  auto key_less = [&keys, &string_key, string_keys](int64_t a, int64_t b) {
+    return string_keys ? string_key(a) < string_key(b)
+                       : keys.flat<int64_t>()(a) < keys.flat<int64_t>()(b);
+  };
+  std::vector<int64_t> order(num_entries);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), key_less);
+  for (int64_t i = 1; i < num_entries; ++i) {
+    if (!key_less(order[i - 1], order[i])) {
+      return errors::InvalidArgument(
+          "The keys of a prebuilt lookup table must be unique");
+    }
+  }
+
+  PrebuiltLookupTableHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.key_dtype = keys.dtype();
+  header.value_dtype = values.dtype();
+  header.num_entries = num_entries;
+  header.num_key_bytes = 0;
+  if (string_keys) {
+    for (int64_t i = 0; i < num_entries; ++i) {
+      header.num_key_bytes += keys.flat<tstring>()(i).size();
+    }
+  }
+  string contents;
+  contents.reserve(TableSize(header));
+  contents.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  auto append_int64 = [&contents](int64_t value) {
+    contents.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  for (const int64_t i : order) {
+    append_int64(values.flat<int64_t>()(i));
+  }
+  if (string_keys) {
+    uint64 offset = 0;
+    append_int64(offset);
+    for (const int64_t i : order) {
+      offset += keys.flat<tstring>()(i).size();
+      append_int64(offset);
+    }
+    for (const int64_t i : order) {
+      contents.append(string_key(i).data(), string_key(i).size());
+    }
+  } else {
+    for (const int64_t i : order) {
+      append_int64(keys.flat<int64_t>()(i));
+    }
+  }
+  return WriteStringToFile(Env::Default(), path, contents);
+}
+
+Status RewritePrebuiltLookupTables(const string& export_dir,
+                                   MetaGraphDef* meta_graph_def,
+                                   int* num_rewritten) {
+  *num_rewritten = 0;
+  std::vector<AssetFileDef> asset_file_defs;
+  TF_RETURN_IF_ERROR(
+      internal::GetAssetFileDefs(*meta_graph_def, &asset_file_defs));
+  // The asset file of each node fed with the path of an asset.
+  std::unordered_map<string, string> asset_files;
+  for (const AssetFileDef& asset_file_def : asset_file_defs) {
+    asset_files[string(
+        ParseTensorName(asset_file_def.tensor_info().name()).node())] =
+        asset_file_def.filename();
+  }
+  if (asset_files.empty()) {
+    return OkStatus();
+  }
+
+  GraphDef* graph_def = meta_graph_def->mutable_graph_def();
+  std::unordered_map<string, NodeDef*> nodes;
+  std::unordered_map<string, std::vector<const NodeDef*>> consumers;
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    nodes[node.name()] = &node;
+    for (const string& input : node.input()) {
+      if (!absl::StartsWith(input, "^")) {
+        consumers[string(ParseTensorName(input).node())].push_back(&node);
+      }
+    }
+  }
+  const std::unordered_set<string> read_ops = {
+      "LookupTableFindV2", "LookupTableSizeV2", "LookupTableExportV2"};
+
+  for (NodeDef& node : *graph_def->mutable_node()) {
+    if (node.op() != "InitializeTableFromTextFileV2" ||
+        node.input_size() < 2) {
+      continue;
+    }
+    auto table_it = nodes.find(string(ParseTensorName(node.input(0)).node()));
+    const NodeDef* filename = ResolveNode(nodes, node.input(1));
+    if (table_it == nodes.end() || table_it->second->op() != "HashTableV2" ||
+        filename == nullptr || asset_files.count(filename->name()) == 0) {
+      continue;
+    }
+    NodeDef* table = table_it->second;
+    const string path = io::JoinPath(
+        export_dir, kSavedModelAssetsExtraDirectory,
+        absl::StrCat(asset_files[filename->name()],
+                     kPrebuiltLookupTableSuffix));
+    if (!Env::Default()->FileExists(path).ok()) {
+      continue;
+    }
+    bool read_only = true;
+    for (const NodeDef* consumer : consumers[table->name()]) {
+      if (consumer != &node && read_ops.count(consumer->op()) == 0) {
+        read_only = false;
+      }
+    }
+    if (!read_only) {
+      LOG(INFO) << "Initializing the lookup table " << table->name()
+                << " normally, since it is not read-only";
+      continue;
+    }
+    const DataType key_dtype = table->attr().at("key_dtype").type();
+    const DataType value_dtype = table->attr().at("value_dtype").type();
+    TF_RETURN_IF_ERROR(CheckPrebuiltLookupTable(path, key_dtype, value_dtype));
+
+    AttrValue container, shared_name;
+    if (table->attr().count("container") > 0) {
+      container = table->attr().at("container");
+    }
+    if (table->attr().count("shared_name") > 0) {
+      shared_name = table->attr().at("shared_name");
+    }
+    table->set_op(kPrebuiltLookupTableOp);
+    table->clear_attr();
+    auto& attr = *table->mutable_attr();
+    attr["path"].set_s(path);
+    attr["container"] = container;
+    attr["shared_name"] = shared_name;
+    attr["key_dtype"].set_type(key_dtype);
+    attr["value_dtype"].set_type(value_dtype);
+
+    // The initializer keeps its control inputs, since the init op may group
+    // it.
+    std::vector<string> control_inputs;
+    for (const string& input : node.input()) {
+      if (absl::StartsWith(input, "^")) {
+        control_inputs.push_back(input);
+      }
+    }
+    node.set_op("NoOp");
+    node.clear_attr();
+    node.clear_input();
+    for (const string& input : control_inputs) {
+      node.add_input(input);
+    }
+    ++*num_rewritten;
+  }
+  return OkStatus();
+}
+
+Status LoadSavedModelWithPrebuiltLookupTables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  int num_rewritten;
+  TF_RETURN_IF_ERROR(RewritePrebuiltLookupTables(
+      export_dir, &bundle->meta_graph_def, &num_rewritten));
+  if (num_rewritten == 0) {
+    return LoadSavedModel(session_options, run_options, export_dir, tags,
+                          bundle);
+  }
+  LOG(INFO) << "Mapping " << num_rewritten << " prebuilt lookup tables of "
+            << export_dir;
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+      session_options, bundle->meta_graph_def, &bundle->session));
+  return RestoreSession(run_options, bundle->meta_graph_def, export_dir,
+                        &bundle->session);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
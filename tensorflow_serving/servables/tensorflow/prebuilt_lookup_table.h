@@ -0,0 +1,66 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PREBUILT_LOOKUP_TABLE_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PREBUILT_LOOKUP_TABLE_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The suffix of the prebuilt table of an asset: the table of the asset
+// 'vocab.txt' is 'assets.extra/vocab.txt.table' in the SavedModel.
+extern const char kPrebuiltLookupTableSuffix[];
+
+// Writes the table from 'keys' to 'values', vectors of the same length, to
+// 'path' in the prebuilt format: a header, then the values and the keys sorted
+// by key, laid out so that the file can be memory-mapped and searched in
+// place. Keys are DT_STRING or DT_INT64, and values DT_INT64, as in the
+// vocabulary tables of text assets. Keys must be unique.
+Status WritePrebuiltLookupTable(const Tensor& keys, const Tensor& values,
+                                const string& path);
+
+// Rewrites the lookup tables of 'meta_graph_def' that are initialized from an
+// asset with a prebuilt table in 'export_dir' to map the prebuilt table
+// instead: the HashTableV2 op becomes a TfServingPrebuiltLookupTable op, and
+// its InitializeTableFromTextFileV2 op a NoOp. Only tables that are otherwise
+// just read (found, sized or exported) are rewritten. Sets 'num_rewritten' to
+// the number of tables rewritten.
+Status RewritePrebuiltLookupTables(const string& export_dir,
+                                   MetaGraphDef* meta_graph_def,
+                                   int* num_rewritten);
+
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but with its
+// lookup tables rewritten by RewritePrebuiltLookupTables(), so that loading
+// does not parse the vocabulary files and the tables are shared through the
+// page cache rather than held on the heap.
+Status LoadSavedModelWithPrebuiltLookupTables(
+    const SessionOptions& session_options, const RunOptions& run_options,
+    const string& export_dir, const std::unordered_set<string>& tags,
+    SavedModelBundle* bundle);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PREBUILT_LOOKUP_TABLE_H_
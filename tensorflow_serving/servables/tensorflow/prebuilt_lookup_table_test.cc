@@ -0,0 +1,193 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/prebuilt_lookup_table.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/protobuf/saved_model.pb.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+// A graph that looks up the keys 'b' and 'z' in a table initialized from the
+// asset 'vocab.txt', and optionally inserts into the table.
+string Graph(bool insert) {
+  string graph = absl::StrCat(
+      "node { name: 'asset' op: 'Const' ",
+      "attr { key: 'dtype' value { type: DT_STRING } } ",
+      "attr { key: 'value' value { tensor { dtype: DT_STRING ",
+      "tensor_shape { } string_val: 'vocab.txt' } } } } ",
+      "node { name: 'table' op: 'HashTableV2' ",
+      "attr { key: 'key_dtype' value { type: DT_STRING } } ",
+      "attr { key: 'value_dtype' value { type: DT_INT64 } } ",
+      "attr { key: 'shared_name' value { s: '' } } } ",
+      "node { name: 'init_table' op: 'InitializeTableFromTextFileV2' ",
+      "input: 'table' input: 'asset' ",
+      "attr { key: 'key_index' value { i: -2 } } ",
+      "attr { key: 'value_index' value { i: -1 } } ",
+      "attr { key: 'vocab_size' value { i: -1 } } ",
+      "attr { key: 'delimiter' value { s: '\\t' } } } ",
+      "node { name: 'keys' op: 'Const' ",
+      "attr { key: 'dtype' value { type: DT_STRING } } ",
+      "attr { key: 'value' value { tensor { dtype: DT_STRING ",
+      "tensor_shape { dim { size: 2 } } ",
+      "string_val: 'b' string_val: 'z' } } } } ",
+      "node { name: 'default' op: 'Const' ",
+      "attr { key: 'dtype' value { type: DT_INT64 } } ",
+      "attr { key: 'value' value { tensor { dtype: DT_INT64 ",
+      "tensor_shape { } int64_val: -1 } } } } ",
+      "node { name: 'lookup' op: 'LookupTableFindV2' ",
+      "input: 'table' input: 'keys' input: 'default' ",
+      "attr { key: 'Tin' value { type: DT_STRING } } ",
+      "attr { key: 'Tout' value { type: DT_INT64 } } } ",
+      "node { name: 'init' op: 'NoOp' input: '^init_table' } ");
+  if (insert) {
+    absl::StrAppend(&graph, "node { name: 'insert' op: 'LookupTableInsertV2' ",
+                    "input: 'table' input: 'keys' input: 'default' ",
+                    "attr { key: 'Tin' value { type: DT_STRING } } ",
+                    "attr { key: 'Tout' value { type: DT_INT64 } } } ");
+  }
+  return graph;
+}
+
+class PrebuiltLookupTableTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    export_dir_ = io::JoinPath(
+        testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(export_dir_, kSavedModelAssetsExtraDirectory)));
+  }
+
+  MetaGraphDef MetaGraph(bool insert) {
+    MetaGraphDef meta_graph_def;
+    meta_graph_def.mutable_meta_info_def()->add_tags(kSavedModelTagServe);
+    *meta_graph_def.mutable_graph_def() = CreateProto<GraphDef>(Graph(insert));
+    AssetFileDef* asset_file_def = meta_graph_def.add_asset_file_def();
+    asset_file_def->mutable_tensor_info()->set_name("asset:0");
+    asset_file_def->set_filename("vocab.txt");
+    (*meta_graph_def.mutable_collection_def())[kSavedModelMainOpKey]
+        .mutable_node_list()
+        ->add_value("init");
+    return meta_graph_def;
+  }
+
+  void WriteSavedModel() {
+    SavedModel saved_model;
+    *saved_model.add_meta_graphs() = MetaGraph(/*insert=*/false);
+    TF_ASSERT_OK(WriteBinaryProto(
+        Env::Default(), io::JoinPath(export_dir_, kSavedModelFilenamePb),
+        saved_model));
+  }
+
+  void WriteTable() {
+    TF_ASSERT_OK(WritePrebuiltLookupTable(
+        test::AsTensor<tstring>({"c", "a", "b"}),
+        test::AsTensor<int64_t>({2, 0, 1}),
+        io::JoinPath(export_dir_, kSavedModelAssetsExtraDirectory,
+                     absl::StrCat("vocab.txt", kPrebuiltLookupTableSuffix))));
+  }
+
+  string export_dir_;
+};
+
+TEST_F(PrebuiltLookupTableTest, LoadsPrebuiltTable) {
+  WriteSavedModel();
+  WriteTable();
+  // The vocabulary file itself is not written, so the table can only come from
+  // the prebuilt table.
+  SavedModelBundle bundle;
+  TF_ASSERT_OK(LoadSavedModelWithPrebuiltLookupTables(
+      SessionOptions(), RunOptions(), export_dir_, {kSavedModelTagServe},
+      &bundle));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(bundle.session->Run({}, {"lookup:0"}, {}, &outputs));
+  test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>({1, -1}),
+                                   outputs[0]);
+}
+
+TEST_F(PrebuiltLookupTableTest, RewritesOnlyReadOnlyTablesWithPrebuiltTables) {
+  MetaGraphDef meta_graph_def = MetaGraph(/*insert=*/false);
+  int num_rewritten;
+  TF_ASSERT_OK(RewritePrebuiltLookupTables(export_dir_, &meta_graph_def,
+                                           &num_rewritten));
+  EXPECT_EQ(0, num_rewritten);
+
+  WriteTable();
+  TF_ASSERT_OK(RewritePrebuiltLookupTables(export_dir_, &meta_graph_def,
+                                           &num_rewritten));
+  EXPECT_EQ(1, num_rewritten);
+  for (const NodeDef& node : meta_graph_def.graph_def().node()) {
+    if (node.name() == "table") {
+      EXPECT_EQ("TfServingPrebuiltLookupTable", node.op());
+    } else if (node.name() == "init_table") {
+      EXPECT_EQ("NoOp", node.op());
+      EXPECT_EQ(0, node.input_size());
+    }
+  }
+
+  meta_graph_def = MetaGraph(/*insert=*/true);
+  TF_ASSERT_OK(RewritePrebuiltLookupTables(export_dir_, &meta_graph_def,
+                                           &num_rewritten));
+  EXPECT_EQ(0, num_rewritten);
+}
+
+TEST_F(PrebuiltLookupTableTest, RejectsMismatchedTables) {
+  TF_ASSERT_OK(WritePrebuiltLookupTable(
+      test::AsTensor<int64_t>({1, 2}), test::AsTensor<int64_t>({0, 1}),
+      io::JoinPath(export_dir_, kSavedModelAssetsExtraDirectory,
+                   absl::StrCat("vocab.txt", kPrebuiltLookupTableSuffix))));
+  MetaGraphDef meta_graph_def = MetaGraph(/*insert=*/false);
+  int num_rewritten;
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            RewritePrebuiltLookupTables(export_dir_, &meta_graph_def,
+                                        &num_rewritten)
+                .code());
+}
+
+TEST_F(PrebuiltLookupTableTest, WriteRejectsInvalidTables) {
+  const string path = io::JoinPath(export_dir_, "table");
+  EXPECT_FALSE(WritePrebuiltLookupTable(test::AsTensor<tstring>({"a", "a"}),
+                                        test::AsTensor<int64_t>({0, 1}), path)
+                   .ok());
+  EXPECT_FALSE(WritePrebuiltLookupTable(test::AsTensor<tstring>({"a"}),
+                                        test::AsTensor<int64_t>({0, 1}), path)
+                   .ok());
+  EXPECT_FALSE(WritePrebuiltLookupTable(test::AsTensor<tstring>({"a"}),
+                                        test::AsTensor<float>({0}), path)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
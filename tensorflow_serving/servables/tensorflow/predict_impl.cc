@@ -15,20 +15,167 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/predict_impl.h"
 
+#include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/saved_model/loader.h"
+#include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow_serving/core/servable_handle.h"
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
 #include "tensorflow_serving/servables/tensorflow/predict_util.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
 
 namespace tensorflow {
 namespace serving {
+namespace {
+
+// Gets the bundle of the variant of the model of 'model_spec' that fits
+// 'request' (see ServerCore::SelectModelVariant()), or of the model itself if
+// the variant is not available.
+Status GetVariantServableHandle(ServerCore* core, const ModelSpec& model_spec,
+                                const PredictRequest& request,
+                                ServableHandle<SavedModelBundle>* bundle) {
+  // The batch size is that of the 0th dimension of the inputs, which all
+  // share it in batched signatures.
+  int64_t batch_size = 1;
+  if (!request.inputs().empty()) {
+    const TensorShapeProto& shape =
+        request.inputs().begin()->second.tensor_shape();
+    if (shape.dim_size() > 0) {
+      batch_size = shape.dim(0).size();
+    }
+  }
+  const ModelSpec variant_spec =
+      core->SelectModelVariant(model_spec, batch_size);
+  if (variant_spec.name() != model_spec.name()) {
+    const Status status = core->GetServableHandle(variant_spec, bundle);
+    if (status.ok()) {
+      return OkStatus();
+    }
+    VLOG(1) << "Falling back to model " << model_spec.name()
+            << " from its variant " << variant_spec.name() << ": " << status;
+  }
+  return core->GetServableHandle(model_spec, bundle);
+}
+
+// Runs the stages of 'pipeline' for 'request' in order (see
+// ModelPipelineConfig), feeding the tensors of each stage to the later ones as
+// they are.
+Status RunPipeline(const RunOptions& run_options, ServerCore* core,
+                   const ModelPipelineConfig& pipeline,
+                   const PredictRequest& request, PredictResponse* response) {
+  if (!request.model_spec().signature_name().empty() ||
+      !request.output_filter().empty()) {
+    return errors::InvalidArgument("Requests to pipeline ", pipeline.name(),
+                                   " cannot name a signature or outputs");
+  }
+  // The tensors of the pipeline, by stage (empty for the inputs of the
+  // request) and alias.
+  std::map<std::pair<string, string>, Tensor> tensors;
+  for (const auto& input : request.inputs()) {
+    Tensor tensor;
+    if (!tensor.FromProto(input.second)) {
+      return errors::InvalidArgument("Input ", input.first, " of pipeline ",
+                                     pipeline.name(), " is not a valid tensor");
+    }
+    tensors[{"", input.first}] = std::move(tensor);
+  }
+  // The stage outputs that later stages or the response take; the others are
+  // not fetched.
+  std::set<std::pair<string, string>> taken;
+  for (const PipelineStage& stage : pipeline.stages()) {
+    for (const auto& input : stage.inputs()) {
+      taken.insert({input.second.stage(), input.second.alias()});
+    }
+  }
+  for (const auto& output : pipeline.outputs()) {
+    taken.insert({output.second.stage(), output.second.alias()});
+  }
+
+  for (const PipelineStage& stage : pipeline.stages()) {
+    ModelSpec model_spec;
+    model_spec.set_name(stage.model_name());
+    ServableHandle<SavedModelBundle> bundle;
+    TF_RETURN_IF_ERROR(core->GetServableHandle(model_spec, &bundle));
+    const string signature_name = stage.signature_name().empty()
+                                      ? kDefaultServingSignatureDefKey
+                                      : stage.signature_name();
+    const auto& signature_defs = bundle->meta_graph_def.signature_def();
+    auto signature = signature_defs.find(signature_name);
+    if (signature == signature_defs.end()) {
+      return errors::FailedPrecondition("Model ", stage.model_name(),
+                                        " of pipeline ", pipeline.name(),
+                                        " has no signature ", signature_name);
+    }
+    std::vector<std::pair<string, Tensor>> feeds;
+    for (const auto& input : stage.inputs()) {
+      auto tensor_info = signature->second.inputs().find(input.first);
+      if (tensor_info == signature->second.inputs().end()) {
+        return errors::FailedPrecondition(
+            "Signature ", signature_name, " of model ", stage.model_name(),
+            " has no input ", input.first, " for pipeline ", pipeline.name());
+      }
+      auto tensor =
+          tensors.find({input.second.stage(), input.second.alias()});
+      if (tensor == tensors.end()) {
+        return errors::InvalidArgument(
+            "Pipeline ", pipeline.name(), " is missing tensor ",
+            input.second.ShortDebugString(), " for stage ", stage.name());
+      }
+      feeds.emplace_back(tensor_info->second.name(), tensor->second);
+    }
+    std::vector<string> output_aliases;
+    std::vector<string> fetches;
+    for (const auto& output : signature->second.outputs()) {
+      if (taken.count({stage.name(), output.first}) > 0) {
+        output_aliases.push_back(output.first);
+        fetches.push_back(output.second.name());
+      }
+    }
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_RETURN_IF_ERROR(bundle->session->Run(run_options, feeds, fetches, {},
+                                            &outputs, &run_metadata));
+    for (int i = 0; i < outputs.size(); ++i) {
+      tensors[{stage.name(), output_aliases[i]}] = std::move(outputs[i]);
+    }
+  }
+
+  std::vector<string> output_aliases;
+  std::vector<Tensor> output_tensors;
+  for (const auto& output : pipeline.outputs()) {
+    auto tensor = tensors.find({output.second.stage(), output.second.alias()});
+    if (tensor == tensors.end()) {
+      return errors::FailedPrecondition(
+          "Stage ", output.second.stage(), " of pipeline ", pipeline.name(),
+          " has no output ", output.second.alias());
+    }
+    output_aliases.push_back(output.first);
+    output_tensors.push_back(tensor->second);
+  }
+  TF_RETURN_IF_ERROR(internal::PostProcessPredictionResult(
+      output_aliases, output_tensors,
+      core->predict_response_tensor_serialization_option(),
+      internal::GetFloatOutputDtype(request,
+                                    core->GetFloatOutputDtype(pipeline.name())),
+      response));
+  response->mutable_model_spec()->set_name(pipeline.name());
+  return OkStatus();
+}
+
+}  // namespace
 
 Status TensorflowPredictor::Predict(const RunOptions& run_options,
                                     ServerCore* core,
@@ -48,15 +195,111 @@ Status TensorflowPredictor::PredictWithModelSpec(const RunOptions& run_options,
                                                  const ModelSpec& model_spec,
                                                  const PredictRequest& request,
                                                  PredictResponse* response) {
+  if (model_spec.version_choice_case() == ModelSpec::VERSION_CHOICE_NOT_SET) {
+    const std::shared_ptr<const ModelPipelineConfig> pipeline =
+        core->GetModelPipeline(model_spec.name());
+    if (pipeline != nullptr) {
+      return RunPipeline(run_options, core, *pipeline, request, response);
+    }
+  }
   ServableHandle<SavedModelBundle> bundle;
-  TF_RETURN_IF_ERROR(core->GetServableHandle(model_spec, &bundle));
-  return internal::RunPredict(
-      run_options, bundle->meta_graph_def, bundle.id().version,
-      core->predict_response_tensor_serialization_option(),
-      bundle->session.get(), request, response,
-      thread_pool_factory_ == nullptr
-          ? thread::ThreadPoolOptions()
-          : thread_pool_factory_->GetThreadPools().get());
+  TF_RETURN_IF_ERROR(
+      GetVariantServableHandle(core, model_spec, request, &bundle));
+  std::shared_ptr<const internal::PredictSignaturePlan> plan;
+  TF_RETURN_IF_ERROR(plan_cache_.GetPlan(
+      bundle.load_generation(), bundle->meta_graph_def,
+      request.model_spec().signature_name(), &plan));
+  // The dedicated thread pools of the model, if any, take precedence.
+  std::shared_ptr<ThreadPoolFactory> model_thread_pool_factory =
+      core->GetThreadPoolFactory(bundle.id().name);
+  ThreadPoolFactory* const thread_pool_factory =
+      model_thread_pool_factory != nullptr ? model_thread_pool_factory.get()
+                                           : thread_pool_factory_;
+  if (thread_pool_factory == nullptr) {
+    TF_RETURN_IF_ERROR(internal::RunPredict(
+        run_options, *plan, bundle.id().version,
+        core->predict_response_tensor_serialization_option(),
+        bundle->session.get(), request, response, thread::ThreadPoolOptions(),
+        core->GetFloatOutputDtype(bundle.id().name)));
+  } else {
+    // The factory may pick the pools by the expected cost of the request,
+    // which it learns per signature.
+    const string cost_key = absl::StrCat(
+        bundle.id().name, "/", request.model_spec().signature_name());
+    const int64_t input_bytes = request.ByteSizeLong();
+    ScopedThreadPools thread_pools =
+        thread_pool_factory->GetThreadPoolsForRequest(cost_key, input_bytes);
+    const uint64_t start_micros = Env::Default()->NowMicros();
+    TF_RETURN_IF_ERROR(internal::RunPredict(
+        run_options, *plan, bundle.id().version,
+        core->predict_response_tensor_serialization_option(),
+        bundle->session.get(), request, response, thread_pools.get(),
+        core->GetFloatOutputDtype(bundle.id().name)));
+    thread_pool_factory->RecordRequestCost(
+        cost_key, input_bytes, Env::Default()->NowMicros() - start_micros);
+  }
+  // The response names the variant that served, if any, with its version.
+  response->mutable_model_spec()->set_name(bundle.id().name);
+  CapturedWarmupRequests::Global()->Capture(bundle.id().name, request);
+  return OkStatus();
+}
+
+void TensorflowPredictor::PredictAsync(
+    const RunOptions& run_options, ServerCore* core,
+    const PredictRequest& request, PredictResponse* response,
+    std::function<void(const Status&)> done) {
+  // Runs on custom thread pools are synchronous, as are pipelines.
+  if (!request.has_model_spec() || thread_pool_factory_ != nullptr ||
+      core->GetThreadPoolFactory(request.model_spec().name()) != nullptr ||
+      core->GetModelPipeline(request.model_spec().name()) != nullptr) {
+    done(Predict(run_options, core, request, response));
+    return;
+  }
+  // Held until the run completes.
+  auto bundle = std::make_shared<ServableHandle<SavedModelBundle>>();
+  const Status status = GetVariantServableHandle(core, request.model_spec(),
+                                                 request, bundle.get());
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+  std::shared_ptr<const internal::PredictSignaturePlan> plan;
+  const Status plan_status = plan_cache_.GetPlan(
+      bundle->load_generation(), (**bundle).meta_graph_def,
+      request.model_spec().signature_name(), &plan);
+  if (!plan_status.ok()) {
+    done(plan_status);
+    return;
+  }
+  auto* session = dynamic_cast<ServingSession*>((**bundle).session.get());
+  if (session == nullptr) {
+    const Status run_status = internal::RunPredict(
+        run_options, *plan, bundle->id().version,
+        core->predict_response_tensor_serialization_option(),
+        (**bundle).session.get(), request, response,
+        thread::ThreadPoolOptions(),
+        core->GetFloatOutputDtype(bundle->id().name));
+    if (run_status.ok()) {
+      response->mutable_model_spec()->set_name(bundle->id().name);
+      CapturedWarmupRequests::Global()->Capture(bundle->id().name, request);
+    }
+    done(run_status);
+    return;
+  }
+  internal::RunPredictAsync(
+      run_options, std::move(plan), bundle->id().version,
+      core->predict_response_tensor_serialization_option(), session, request,
+      response,
+      [bundle, &request, response,
+       done = std::move(done)](const Status& run_status) {
+        if (run_status.ok()) {
+          response->mutable_model_spec()->set_name(bundle->id().name);
+          CapturedWarmupRequests::Global()->Capture(bundle->id().name,
+                                                    request);
+        }
+        done(run_status);
+      },
+      core->GetFloatOutputDtype(bundle->id().name));
 }
 
 }  // namespace serving
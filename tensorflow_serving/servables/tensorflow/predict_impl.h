@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PREDICT_IMPL_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PREDICT_IMPL_H_
 
+#include <functional>
+
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow_serving/apis/predict.pb.h"
 #include "tensorflow_serving/model_servers/server_core.h"
+#include "tensorflow_serving/servables/tensorflow/predict_util.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 
 namespace tensorflow {
@@ -44,8 +47,22 @@ class TensorflowPredictor {
                               const PredictRequest& request,
                               PredictResponse* response);
 
+  // Like Predict(), but calls 'done' with the status once 'response' is filled
+  // in, which may be from another thread after PredictAsync() returns: e.g.
+  // from the batch thread, if the model batches requests, so that no thread
+  // waits for the batch. 'request' and 'response' must live until then.
+  //
+  // Runs synchronously if the thread pool factory is set, since its thread
+  // pools are scoped to the call.
+  void PredictAsync(const RunOptions& run_options, ServerCore* core,
+                    const PredictRequest& request, PredictResponse* response,
+                    std::function<void(const Status&)> done);
+
  private:
   ThreadPoolFactory* thread_pool_factory_ = nullptr;
+
+  // The plans of the signatures requests have run.
+  internal::PredictSignaturePlanCache plan_cache_;
 };
 
 }  // namespace serving
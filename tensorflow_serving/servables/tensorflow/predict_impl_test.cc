@@ -17,10 +17,12 @@ limitations under the License.
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow_serving/core/availability_preserving_policy.h"
 #include "tensorflow_serving/model_servers/model_platform_types.h"
@@ -63,9 +65,13 @@ class PredictImplTest : public ::testing::Test {
   }
 
  protected:
-  static Status CreateServerCore(const string& model_path,
-                                 std::unique_ptr<ServerCore>* server_core) {
+  static Status CreateServerCore(
+      const string& model_path, std::unique_ptr<ServerCore>* server_core,
+      const std::vector<ModelPipelineConfig>& pipelines = {}) {
     ModelServerConfig config;
+    for (const ModelPipelineConfig& pipeline : pipelines) {
+      *config.mutable_model_config_list()->add_pipelines() = pipeline;
+    }
     auto model_config = config.mutable_model_config_list()->add_config();
     model_config->set_name(kTestModelName);
     model_config->set_base_path(model_path);
@@ -258,6 +264,44 @@ TEST_F(PredictImplTest, PredictionSuccess) {
   EXPECT_THAT(response, test_util::EqualsProto(expected_response));
 }
 
+TEST_F(PredictImplTest, PredictAsync) {
+  PredictRequest request;
+  PredictResponse response;
+  ModelSpec* model_spec = request.mutable_model_spec();
+  model_spec->set_name(kTestModelName);
+  model_spec->mutable_version()->set_value(kTestModelVersion);
+  TensorProto tensor_proto;
+  tensor_proto.add_float_val(2.0);
+  tensor_proto.set_dtype(tensorflow::DT_FLOAT);
+  (*request.mutable_inputs())[kInputTensorKey] = tensor_proto;
+
+  TensorflowPredictor predictor;
+  Notification done;
+  Status status;
+  predictor.PredictAsync(GetRunOptions(), GetServerCore(), request, &response,
+                         [&](const Status& predict_status) {
+                           status = predict_status;
+                           done.Notify();
+                         });
+  done.WaitForNotification();
+  TF_ASSERT_OK(status);
+  PredictResponse sync_response;
+  TF_ASSERT_OK(predictor.Predict(GetRunOptions(), GetServerCore(), request,
+                                 &sync_response));
+  EXPECT_THAT(response, test_util::EqualsProto(sync_response));
+
+  // Errors are reported through the callback too.
+  model_spec->set_name("test");
+  Notification failed;
+  predictor.PredictAsync(GetRunOptions(), GetServerCore(), request, &response,
+                         [&](const Status& predict_status) {
+                           status = predict_status;
+                           failed.Notify();
+                         });
+  failed.WaitForNotification();
+  EXPECT_EQ(tensorflow::error::NOT_FOUND, status.code());
+}
+
 // Test querying a model with a named regression signature (not default).
 TEST_F(PredictImplTest, PredictionWithNamedRegressionSignature) {
   PredictRequest request;
@@ -476,6 +520,75 @@ TEST_F(PredictImplTest, ThreadPoolFactory) {
   ASSERT_GE(inter_op_threadpool->NumScheduled(), 1);
 }
 
+TEST_F(PredictImplTest, Pipeline) {
+  // Runs half_plus_two on its own output.
+  const ModelPipelineConfig pipeline =
+      test_util::CreateProto<ModelPipelineConfig>(R"(
+        name: "pipeline"
+        stages {
+          name: "first"
+          model_name: "test_model"
+          inputs {
+            key: "x"
+            value { alias: "x" }
+          }
+        }
+        stages {
+          name: "second"
+          model_name: "test_model"
+          inputs {
+            key: "x"
+            value { stage: "first" alias: "y" }
+          }
+        }
+        outputs {
+          key: "z"
+          value { stage: "second" alias: "y" }
+        })");
+  std::unique_ptr<ServerCore> server_core;
+  TF_ASSERT_OK(CreateServerCore(test_util::TensorflowTestSrcDirPath(
+                                    "cc/saved_model/testdata/half_plus_two"),
+                                &server_core, {pipeline}));
+
+  PredictRequest request;
+  request.mutable_model_spec()->set_name("pipeline");
+  TensorProto tensor_proto;
+  tensor_proto.add_float_val(2.0);
+  tensor_proto.set_dtype(tensorflow::DT_FLOAT);
+  (*request.mutable_inputs())[kInputTensorKey] = tensor_proto;
+
+  TensorflowPredictor predictor;
+  PredictResponse response;
+  TF_ASSERT_OK(predictor.Predict(GetRunOptions(), server_core.get(), request,
+                                 &response));
+  TensorProto output_tensor_proto;
+  output_tensor_proto.add_float_val(3.5);
+  output_tensor_proto.set_dtype(tensorflow::DT_FLOAT);
+  output_tensor_proto.mutable_tensor_shape();
+  PredictResponse expected_response;
+  expected_response.mutable_model_spec()->set_name("pipeline");
+  (*expected_response.mutable_outputs())["z"] = output_tensor_proto;
+  EXPECT_THAT(response, test_util::EqualsProto(expected_response));
+
+  // Asynchronous requests run the pipeline too.
+  response.Clear();
+  Notification done;
+  predictor.PredictAsync(GetRunOptions(), server_core.get(), request,
+                         &response, [&done](const Status& status) {
+                           TF_EXPECT_OK(status);
+                           done.Notify();
+                         });
+  done.WaitForNotification();
+  EXPECT_THAT(response, test_util::EqualsProto(expected_response));
+
+  // The pipeline picks the signatures.
+  request.mutable_model_spec()->set_signature_name("regress_x_to_y");
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            predictor
+                .Predict(GetRunOptions(), server_core.get(), request, &response)
+                .code());
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/predict_util.h"
 
+#include <algorithm>
+#include <initializer_list>
 #include <map>
 #include <memory>
 #include <set>
@@ -25,11 +27,16 @@ limitations under the License.
 #include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
-#include "tensorflow/cc/saved_model/util.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/protobuf/named_tensor.pb.h"
+#include "tensorflow/core/protobuf/struct.pb.h"
+#include "tensorflow_serving/servables/tensorflow/shared_memory_registry.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
+#include "tensorflow_serving/util/composite_tensor_util.h"
 
 namespace tensorflow {
 namespace serving {
@@ -48,12 +55,34 @@ Status VerifySignature(const SignatureDef& signature) {
   return OkStatus();
 }
 
+// The number of inputs of 'request', of any kind.
+int NumRequestInputs(const PredictRequest& request) {
+  return request.inputs().size() + request.shared_memory_inputs().size() +
+         request.sparse_inputs().size() + request.ragged_inputs().size();
+}
+
+// The aliases of the inputs of 'request', of any kind.
+std::set<string> GetRequestInputAliases(const PredictRequest& request) {
+  std::set<string> aliases = GetMapKeys(request.inputs());
+  for (const auto& input : request.shared_memory_inputs()) {
+    aliases.insert(input.first);
+  }
+  for (const auto& input : request.sparse_inputs()) {
+    aliases.insert(input.first);
+  }
+  for (const auto& input : request.ragged_inputs()) {
+    aliases.insert(input.first);
+  }
+  return aliases;
+}
+
 Status VerifyRequestInputsSize(const SignatureDef& signature,
                                const PredictRequest& request) {
-  if (request.inputs().size() > signature.inputs().size() ||
-      (request.inputs().size() < signature.inputs().size() &&
+  const int num_request_inputs = NumRequestInputs(request);
+  if (num_request_inputs > signature.inputs().size() ||
+      (num_request_inputs < signature.inputs().size() &&
        signature.defaults().empty())) {
-    const std::set<string> request_inputs = GetMapKeys(request.inputs());
+    const std::set<string> request_inputs = GetRequestInputAliases(request);
     const std::set<string> signature_inputs = GetMapKeys(signature.inputs());
     const std::set<string> sent_extra =
         SetDifference(request_inputs, signature_inputs);
@@ -62,7 +91,7 @@ Status VerifyRequestInputsSize(const SignatureDef& signature,
     return tensorflow::Status(
         static_cast<tsl::errors::Code>(absl::StatusCode::kInvalidArgument),
         absl::StrCat(
-            "input size does not match signature: ", request.inputs().size(),
+            "input size does not match signature: ", num_request_inputs,
             "!=", signature.inputs().size(), " len({",
             absl::StrJoin(request_inputs, ","), "}) != len({",
             absl::StrJoin(signature_inputs, ","), "}). Sent extra: {",
@@ -72,33 +101,454 @@ Status VerifyRequestInputsSize(const SignatureDef& signature,
   return OkStatus();
 }
 
+// The smallest 'tensor_content' of a request that input tensors alias rather
+// than copy. Below this, the copy is cheaper than the extra buffer.
+constexpr size_t kMinAliasedTensorContentBytes = 64 << 10;
+
+// A TensorBuffer over the bytes of a request, which it does not own.
+class RequestTensorBuffer : public TensorBuffer {
+ public:
+  explicit RequestTensorBuffer(const string& bytes)
+      : TensorBuffer(const_cast<char*>(bytes.data())), size_(bytes.size()) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("PredictRequest");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const size_t size_;
+};
+
+// Converts 'proto', the component 'name' of the sparse or ragged input 'alias',
+// to 'tensor', and checks its dtype is one of 'dtypes' (if not empty) and its
+// rank is 'rank'.
+Status ComponentFromRequestProto(const string& alias, const char* name,
+                                 const TensorProto& proto,
+                                 std::initializer_list<DataType> dtypes,
+                                 int rank, Tensor* tensor) {
+  if (!internal::TensorFromRequestProto(proto, tensor)) {
+    return errors::InvalidArgument("tensor parsing error: ", alias, ".", name);
+  }
+  if ((dtypes.size() > 0 && std::find(dtypes.begin(), dtypes.end(),
+                                      tensor->dtype()) == dtypes.end()) ||
+      tensor->dims() != rank) {
+    std::vector<string> dtype_names;
+    for (const DataType dtype : dtypes) {
+      dtype_names.push_back(DataTypeString(dtype));
+    }
+    return errors::InvalidArgument(
+        "The ", name, " of input ", alias, " must be a rank ", rank, " tensor",
+        dtype_names.empty() ? "" : " of type ",
+        absl::StrJoin(dtype_names, " or "));
+  }
+  return OkStatus();
+}
+
+// Appends the component tensors of the sparse or ragged 'input' of 'request' to
+// 'inputs', fed as the signature lists them.
+Status GetCompositeInputValues(
+    const internal::PredictSignaturePlan::Input& input,
+    const PredictRequest& request,
+    std::vector<std::pair<string, Tensor>>* inputs) {
+  using Kind = internal::PredictSignaturePlan::Input::Kind;
+  if (request.inputs().count(input.alias) > 0 ||
+      request.shared_memory_inputs().count(input.alias) > 0) {
+    return errors::InvalidArgument(
+        "Signature input alias: ", input.alias, " is a ",
+        input.kind == Kind::kSparse ? "sparse" : "ragged",
+        " tensor, to be sent in ",
+        input.kind == Kind::kSparse ? "sparse_inputs" : "ragged_inputs");
+  }
+  const std::vector<string>& feed_names = input.component_feed_names;
+  if (input.kind == Kind::kSparse) {
+    auto iter = request.sparse_inputs().find(input.alias);
+    if (iter == request.sparse_inputs().end()) {
+      return errors::InvalidArgument("Sparse signature input alias: ",
+                                     input.alias, " not found in request");
+    }
+    Tensor indices, values, dense_shape;
+    TF_RETURN_IF_ERROR(ComponentFromRequestProto(
+        input.alias, "indices", iter->second.indices(), {DT_INT64}, 2,
+        &indices));
+    TF_RETURN_IF_ERROR(ComponentFromRequestProto(
+        input.alias, "values", iter->second.values(), {}, 1, &values));
+    TF_RETURN_IF_ERROR(ComponentFromRequestProto(input.alias, "dense_shape",
+                                                 iter->second.dense_shape(),
+                                                 {DT_INT64}, 1, &dense_shape));
+    if (values.dim_size(0) != indices.dim_size(0) ||
+        dense_shape.dim_size(0) != indices.dim_size(1)) {
+      return errors::InvalidArgument(
+          "Sparse input ", input.alias, " has indices of shape ",
+          indices.shape().DebugString(), ", values of shape ",
+          values.shape().DebugString(), " and dense_shape of shape ",
+          dense_shape.shape().DebugString(),
+          "; expected [N, rank], [N] and [rank]");
+    }
+    TF_RETURN_IF_ERROR(
+        ValidateSparseIndices(input.alias, indices, dense_shape));
+    inputs->emplace_back(feed_names[0], std::move(indices));
+    inputs->emplace_back(feed_names[1], std::move(values));
+    inputs->emplace_back(feed_names[2], std::move(dense_shape));
+    return OkStatus();
+  }
+
+  auto iter = request.ragged_inputs().find(input.alias);
+  if (iter == request.ragged_inputs().end()) {
+    return errors::InvalidArgument("Ragged signature input alias: ",
+                                   input.alias, " not found in request");
+  }
+  const RaggedTensorProto& ragged = iter->second;
+  if (ragged.nested_row_splits().size() + 1 != feed_names.size()) {
+    return errors::InvalidArgument(
+        "Ragged input ", input.alias, " has ",
+        ragged.nested_row_splits().size(), " ragged dimensions; expected ",
+        feed_names.size() - 1);
+  }
+  Tensor flat_values;
+  if (!internal::TensorFromRequestProto(ragged.flat_values(), &flat_values)) {
+    return errors::InvalidArgument("tensor parsing error: ", input.alias,
+                                   ".flat_values");
+  }
+  if (flat_values.dims() == 0) {
+    return errors::InvalidArgument("The flat_values of input ", input.alias,
+                                   " must not be a scalar");
+  }
+  // The last split of each ragged dimension is the size of the next one.
+  std::vector<Tensor> nested_row_splits(ragged.nested_row_splits().size());
+  for (int i = nested_row_splits.size() - 1; i >= 0; --i) {
+    Tensor& row_splits = nested_row_splits[i];
+    TF_RETURN_IF_ERROR(ComponentFromRequestProto(
+        input.alias, "nested_row_splits", ragged.nested_row_splits(i),
+        {DT_INT64, DT_INT32}, 1, &row_splits));
+    const int64_t next_size = i + 1 < nested_row_splits.size()
+                                  ? nested_row_splits[i + 1].dim_size(0) - 1
+                                  : flat_values.dim_size(0);
+    TF_RETURN_IF_ERROR(ValidateRowSplits(
+        strings::StrCat(input.alias, ".nested_row_splits[", i, "]"),
+        row_splits));
+    if (RowSplit(row_splits, row_splits.dim_size(0) - 1) != next_size) {
+      return errors::InvalidArgument(
+          "Row splits ", i, " of ragged input ", input.alias, " must end at ",
+          next_size);
+    }
+  }
+  inputs->emplace_back(feed_names[0], std::move(flat_values));
+  for (int i = 0; i < nested_row_splits.size(); ++i) {
+    inputs->emplace_back(feed_names[i + 1], std::move(nested_row_splits[i]));
+  }
+  return OkStatus();
+}
+
+// Converts the inputs of 'request' to the feeds of the signature of 'plan',
+// filling in its defaults for inputs the request leaves out, like
+// saved_model::GetInputValues() but with TensorFromRequestProto().
+Status GetInputValues(const internal::PredictSignaturePlan& plan,
+                      const PredictRequest& request,
+                      std::vector<std::pair<string, Tensor>>* inputs) {
+  inputs->reserve(inputs->size() + plan.inputs.size());
+  int num_request_inputs_used = 0;
+  for (const internal::PredictSignaturePlan::Input& input : plan.inputs) {
+    if (input.kind != internal::PredictSignaturePlan::Input::Kind::kDense) {
+      TF_RETURN_IF_ERROR(GetCompositeInputValues(input, request, inputs));
+      ++num_request_inputs_used;
+      continue;
+    }
+    if (input.feed_name.empty()) {
+      return errors::InvalidArgument(
+          "Signature input alias: ", input.alias,
+          " is a composite tensor of a type Predict cannot feed");
+    }
+    auto shared_iter = request.shared_memory_inputs().find(input.alias);
+    if (shared_iter != request.shared_memory_inputs().end()) {
+      if (request.inputs().count(input.alias) > 0) {
+        return errors::InvalidArgument(
+            "Input ", input.alias,
+            " is both in inputs and in shared_memory_inputs");
+      }
+      Tensor tensor;
+      TF_RETURN_IF_ERROR(
+          SharedMemoryRegistry::ReadTensor(shared_iter->second, &tensor));
+      ++num_request_inputs_used;
+      inputs->emplace_back(input.feed_name, std::move(tensor));
+      continue;
+    }
+    const TensorProto* tensor_proto;
+    auto iter = request.inputs().find(input.alias);
+    if (iter == request.inputs().end()) {
+      if (input.default_value == nullptr) {
+        return errors::InvalidArgument(
+            "Signature input alias: ", input.alias,
+            "(feed name: ", input.feed_name,
+            ") not found in request and no default value provided.");
+      }
+      tensor_proto = input.default_value;
+    } else {
+      tensor_proto = &iter->second;
+      ++num_request_inputs_used;
+    }
+    Tensor tensor;
+    if (!internal::TensorFromRequestProto(*tensor_proto, &tensor)) {
+      return errors::InvalidArgument("tensor parsing error: ", input.alias);
+    }
+    inputs->emplace_back(input.feed_name, std::move(tensor));
+  }
+  if (num_request_inputs_used != NumRequestInputs(request)) {
+    std::set<string> used_request_inputs;
+    const std::set<string> request_inputs = GetRequestInputAliases(request);
+    for (const internal::PredictSignaturePlan::Input& input : plan.inputs) {
+      if (request_inputs.count(input.alias) > 0) {
+        used_request_inputs.insert(input.alias);
+      }
+    }
+    return errors::InvalidArgument(
+        "Inputs contains invalid name. Used request inputs: ",
+        absl::StrJoin(used_request_inputs, ","), ", request input: ",
+        absl::StrJoin(request_inputs, ","));
+  }
+  return OkStatus();
+}
+
+// Writes the outputs that 'request' asks for in shared memory there, leaving
+// only their dtypes and shapes in 'response', and takes them out of
+// 'output_tensor_aliases' and 'output_tensors' for the rest to be serialized.
+Status WriteSharedMemoryOutputs(const PredictRequest& request,
+                                std::vector<string>* output_tensor_aliases,
+                                std::vector<Tensor>* output_tensors,
+                                PredictResponse* response) {
+  if (request.shared_memory_outputs().empty()) {
+    return OkStatus();
+  }
+  if (output_tensors->size() != output_tensor_aliases->size()) {
+    return errors::Unknown("Predict internal error");
+  }
+  const std::set<string> fetched(output_tensor_aliases->begin(),
+                                 output_tensor_aliases->end());
+  for (const auto& shared_output : request.shared_memory_outputs()) {
+    if (fetched.count(shared_output.first) == 0) {
+      return errors::InvalidArgument(
+          "Output ", shared_output.first,
+          " of shared_memory_outputs is not fetched. Fetched outputs: {",
+          absl::StrJoin(fetched, ","), "}");
+    }
+  }
+  int num_kept = 0;
+  for (int i = 0; i < output_tensors->size(); ++i) {
+    const string& alias = (*output_tensor_aliases)[i];
+    auto iter = request.shared_memory_outputs().find(alias);
+    if (iter == request.shared_memory_outputs().end()) {
+      (*output_tensor_aliases)[num_kept] =
+          std::move((*output_tensor_aliases)[i]);
+      (*output_tensors)[num_kept] = std::move((*output_tensors)[i]);
+      ++num_kept;
+      continue;
+    }
+    const Tensor& tensor = (*output_tensors)[i];
+    TF_RETURN_IF_ERROR(SharedMemoryRegistry::WriteTensor(tensor, iter->second));
+    TensorProto& output = (*response->mutable_outputs())[iter->first];
+    output.set_dtype(tensor.dtype());
+    tensor.shape().AsProto(output.mutable_tensor_shape());
+  }
+  output_tensor_aliases->resize(num_kept);
+  output_tensors->resize(num_kept);
+  return OkStatus();
+}
+
+// Looks up the signature named 'signature_name' (the default serving signature
+// if empty) in 'meta_graph_def'.
+Status FindSignature(const MetaGraphDef& meta_graph_def,
+                     const string& signature_name,
+                     const SignatureDef** signature) {
+  auto iter = meta_graph_def.signature_def().find(signature_name);
+  if (iter == meta_graph_def.signature_def().end()) {
+    return errors::FailedPrecondition(strings::StrCat(
+        "Serving signature key \"", signature_name, "\" not found."));
+  }
+  *signature = &iter->second;
+  return OkStatus();
+}
+
+// Sets the fetches of a run to 'fetches', pairs of tensor names and aliases,
+// sorted by tensor name. The session then sees the same fetches for any order
+// of the same outputs, e.g. in output filters, so that they share its
+// executor, rather than each order compiling its own.
+void SetFetches(std::vector<std::pair<string, string>> fetches,
+                std::vector<string>* output_tensor_names,
+                std::vector<string>* output_tensor_aliases) {
+  std::sort(fetches.begin(), fetches.end());
+  output_tensor_names->clear();
+  output_tensor_aliases->clear();
+  output_tensor_names->reserve(fetches.size());
+  output_tensor_aliases->reserve(fetches.size());
+  for (auto& fetch : fetches) {
+    output_tensor_names->push_back(std::move(fetch.first));
+    output_tensor_aliases->push_back(std::move(fetch.second));
+  }
+}
+
+// Sets the kind and component feeds of 'input' if 'tensor_info', its
+// signature input, is a sparse or a ragged tensor.
+void SetCompositeInput(const TensorInfo& tensor_info,
+                       internal::PredictSignaturePlan::Input* input) {
+  using Kind = internal::PredictSignaturePlan::Input::Kind;
+  if (tensor_info.has_coo_sparse()) {
+    const TensorInfo::CooSparse& coo_sparse = tensor_info.coo_sparse();
+    input->kind = Kind::kSparse;
+    input->component_feed_names = {coo_sparse.indices_tensor_name(),
+                                   coo_sparse.values_tensor_name(),
+                                   coo_sparse.dense_shape_tensor_name()};
+    return;
+  }
+  if (!tensor_info.has_composite_tensor()) {
+    return;
+  }
+  // The components of composite tensors are in the order of their
+  // TypeSpec's _to_components(): the indices, values and dense shape of
+  // tf.SparseTensor, and the flat values and nested row splits of
+  // tf.RaggedTensor.
+  const TensorInfo::CompositeTensor& composite = tensor_info.composite_tensor();
+  const auto type_spec_class = composite.type_spec().type_spec_class();
+  const int num_components = composite.components().size();
+  if (type_spec_class == TypeSpecProto::SPARSE_TENSOR_SPEC &&
+      num_components == 3) {
+    input->kind = Kind::kSparse;
+  } else if (type_spec_class == TypeSpecProto::RAGGED_TENSOR_SPEC &&
+             num_components >= 2) {
+    input->kind = Kind::kRagged;
+  } else {
+    return;
+  }
+  for (const TensorInfo& component : composite.components()) {
+    input->component_feed_names.push_back(component.name());
+  }
+}
+
+// Returns an error unless 'dtype' is a dtype the DT_FLOAT outputs of a
+// response can be returned as, or DT_INVALID for the default.
+Status VerifyFloatOutputDtype(DataType dtype) {
+  if (dtype != DT_INVALID && dtype != DT_FLOAT && dtype != DT_BFLOAT16 &&
+      dtype != DT_HALF) {
+    return errors::InvalidArgument(
+        "float_output_dtype must be DT_FLOAT, DT_BFLOAT16 or DT_HALF; got ",
+        DataTypeString(dtype));
+  }
+  return OkStatus();
+}
+
+// Returns 'tensor', a DT_FLOAT tensor, rounded to 'dtype', DT_BFLOAT16 or
+// DT_HALF. Eigen vectorizes the casts, which round to nearest even.
+Tensor ReduceFloatPrecision(const Tensor& tensor, DataType dtype) {
+  Tensor reduced(dtype, tensor.shape());
+  if (dtype == DT_BFLOAT16) {
+    reduced.flat<bfloat16>() = tensor.flat<float>().cast<bfloat16>();
+  } else {
+    reduced.flat<Eigen::half>() = tensor.flat<float>().cast<Eigen::half>();
+  }
+  return reduced;
+}
+
+// Lays out the plan of 'signature', named 'signature_name', once verified.
+void FillPredictSignaturePlan(const string& signature_name,
+                              const SignatureDef& signature,
+                              internal::PredictSignaturePlan* plan) {
+  plan->signature_name = signature_name;
+  plan->signature = &signature;
+  plan->inputs.clear();
+  plan->inputs.reserve(signature.inputs().size());
+  for (const auto& signature_input : signature.inputs()) {
+    auto default_iter = signature.defaults().find(signature_input.first);
+    plan->inputs.push_back(
+        {signature_input.first, signature_input.second.name(),
+         default_iter == signature.defaults().end() ? nullptr
+                                                    : &default_iter->second});
+    SetCompositeInput(signature_input.second, &plan->inputs.back());
+  }
+  std::vector<std::pair<string, string>> fetches;
+  fetches.reserve(signature.outputs().size());
+  for (const auto& output : signature.outputs()) {
+    fetches.emplace_back(output.second.name(), output.first);
+  }
+  SetFetches(std::move(fetches), &plan->output_tensor_names,
+             &plan->output_tensor_aliases);
+}
+
 }  // namespace
 
 namespace internal {
+
+bool TensorFromRequestProto(const TensorProto& proto, Tensor* tensor) {
+  const string& content = proto.tensor_content();
+  TensorShape shape;
+  if (content.size() >= kMinAliasedTensorContentBytes &&
+      DataTypeCanUseMemcpy(proto.dtype()) &&
+      TensorShape::BuildTensorShape(proto.tensor_shape(), &shape).ok() &&
+      content.size() == shape.num_elements() * DataTypeSize(proto.dtype())) {
+    auto* buffer = new RequestTensorBuffer(content);
+    Tensor aliased(proto.dtype(), shape, buffer);
+    buffer->Unref();
+    if (aliased.IsAligned()) {
+      *tensor = std::move(aliased);
+      return true;
+    }
+  }
+  return tensor->FromProto(proto);
+}
+
+Status CreatePredictSignaturePlan(const MetaGraphDef& meta_graph_def,
+                                  const string& signature_name,
+                                  PredictSignaturePlan* plan) {
+  const string& signame =
+      signature_name.empty() ? kDefaultServingSignatureDefKey : signature_name;
+  const SignatureDef* signature;
+  TF_RETURN_IF_ERROR(FindSignature(meta_graph_def, signame, &signature));
+  TF_RETURN_IF_ERROR(VerifySignature(*signature));
+  FillPredictSignaturePlan(signame, *signature, plan);
+  return OkStatus();
+}
+
+Status PredictSignaturePlanCache::GetPlan(
+    uint64_t load_generation, const MetaGraphDef& meta_graph_def,
+    const string& signature_name,
+    std::shared_ptr<const PredictSignaturePlan>* plan) {
+  const string& signame =
+      signature_name.empty() ? kDefaultServingSignatureDefKey : signature_name;
+  return cache_.Get(
+      load_generation, signame,
+      [&](PredictSignaturePlan* new_plan) {
+        return CreatePredictSignaturePlan(meta_graph_def, signame, new_plan);
+      },
+      plan);
+}
+
 Status RunPredict(
     const RunOptions& run_options, const MetaGraphDef& meta_graph_def,
     const absl::optional<int64_t>& servable_version,
     const internal::PredictResponseTensorSerializationOption option,
     Session* session, const PredictRequest& request, PredictResponse* response,
     const thread::ThreadPoolOptions& thread_pool_options) {
-  // Validate signatures.
-  const string signature_name = request.model_spec().signature_name().empty()
-                                    ? kDefaultServingSignatureDefKey
-                                    : request.model_spec().signature_name();
-  auto iter = meta_graph_def.signature_def().find(signature_name);
-  if (iter == meta_graph_def.signature_def().end()) {
-    return errors::FailedPrecondition(strings::StrCat(
-        "Serving signature key \"", signature_name, "\" not found."));
-  }
-  const SignatureDef& signature = iter->second;
-
-  MakeModelSpec(request.model_spec().name(), signature_name, servable_version,
-                response->mutable_model_spec());
+  PredictSignaturePlan plan;
+  TF_RETURN_IF_ERROR(CreatePredictSignaturePlan(
+      meta_graph_def, request.model_spec().signature_name(), &plan));
+  return RunPredict(run_options, plan, servable_version, option, session,
+                    request, response, thread_pool_options);
+}
 
+Status RunPredict(
+    const RunOptions& run_options, const PredictSignaturePlan& plan,
+    const absl::optional<int64_t>& servable_version,
+    const internal::PredictResponseTensorSerializationOption option,
+    Session* session, const PredictRequest& request, PredictResponse* response,
+    const thread::ThreadPoolOptions& thread_pool_options,
+    DataType default_float_output_dtype) {
+  MakeModelSpec(request.model_spec().name(), plan.signature_name,
+                servable_version, response->mutable_model_spec());
   std::vector<std::pair<string, Tensor>> input_tensors;
   std::vector<string> output_tensor_names;
   std::vector<string> output_tensor_aliases;
-  TF_RETURN_IF_ERROR(PreProcessPrediction(signature, request, &input_tensors,
+  TF_RETURN_IF_ERROR(PreProcessPrediction(plan, request, &input_tensors,
                                           &output_tensor_names,
                                           &output_tensor_aliases));
   std::vector<Tensor> outputs;
@@ -112,8 +562,84 @@ Status RunPredict(
                        /*runtime=*/"TF1",
                        end_microseconds - start_microseconds);
 
-  return PostProcessPredictionResult(output_tensor_aliases, outputs, option,
-                                     response);
+  TF_RETURN_IF_ERROR(WriteSharedMemoryOutputs(request, &output_tensor_aliases,
+                                              &outputs, response));
+  return PostProcessPredictionResult(
+      output_tensor_aliases, outputs, option,
+      GetFloatOutputDtype(request, default_float_output_dtype), response);
+}
+
+void RunPredictAsync(
+    const RunOptions& run_options, const MetaGraphDef& meta_graph_def,
+    const absl::optional<int64_t>& servable_version,
+    const PredictResponseTensorSerializationOption option,
+    ServingSession* session, const PredictRequest& request,
+    PredictResponse* response, std::function<void(const Status&)> done) {
+  auto plan = std::make_shared<PredictSignaturePlan>();
+  const Status status = CreatePredictSignaturePlan(
+      meta_graph_def, request.model_spec().signature_name(), plan.get());
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+  RunPredictAsync(run_options, std::move(plan), servable_version, option,
+                  session, request, response, std::move(done));
+}
+
+void RunPredictAsync(const RunOptions& run_options,
+                     std::shared_ptr<const PredictSignaturePlan> plan,
+                     const absl::optional<int64_t>& servable_version,
+                     const PredictResponseTensorSerializationOption option,
+                     ServingSession* session, const PredictRequest& request,
+                     PredictResponse* response,
+                     std::function<void(const Status&)> done,
+                     DataType default_float_output_dtype) {
+  // The tensors of the run, which must live until it completes.
+  struct RunState {
+    std::shared_ptr<const PredictSignaturePlan> plan;
+    std::vector<std::pair<string, Tensor>> input_tensors;
+    std::vector<string> output_tensor_names;
+    std::vector<string> output_tensor_aliases;
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+  };
+  auto run = std::make_shared<RunState>();
+  run->plan = std::move(plan);
+  MakeModelSpec(request.model_spec().name(), run->plan->signature_name,
+                servable_version, response->mutable_model_spec());
+  const Status status =
+      PreProcessPrediction(*run->plan, request, &run->input_tensors,
+                           &run->output_tensor_names,
+                           &run->output_tensor_aliases);
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+  const uint64_t start_microseconds = EnvTime::NowMicros();
+  const string model_name = request.model_spec().name();
+  const DataType float_output_dtype =
+      GetFloatOutputDtype(request, default_float_output_dtype);
+  session->RunAsync(
+      run_options, run->input_tensors, run->output_tensor_names, {},
+      &run->outputs, &run->run_metadata,
+      [run, start_microseconds, model_name, option, float_output_dtype,
+       &request, response, done = std::move(done)](const Status& run_status) {
+        if (!run_status.ok()) {
+          done(run_status);
+          return;
+        }
+        RecordRuntimeLatency(model_name, /*api=*/"Predict", /*runtime=*/"TF1",
+                             EnvTime::NowMicros() - start_microseconds);
+        const Status write_status = WriteSharedMemoryOutputs(
+            request, &run->output_tensor_aliases, &run->outputs, response);
+        if (!write_status.ok()) {
+          done(write_status);
+          return;
+        }
+        done(PostProcessPredictionResult(run->output_tensor_aliases,
+                                         run->outputs, option,
+                                         float_output_dtype, response));
+      });
 }
 
 Status PreProcessPrediction(const SignatureDef& signature,
@@ -122,15 +648,36 @@ Status PreProcessPrediction(const SignatureDef& signature,
                             std::vector<string>* output_tensor_names,
                             std::vector<string>* output_tensor_aliases) {
   TF_RETURN_IF_ERROR(VerifySignature(signature));
+  PredictSignaturePlan plan;
+  FillPredictSignaturePlan(request.model_spec().signature_name(), signature,
+                           &plan);
+  return PreProcessPrediction(plan, request, inputs, output_tensor_names,
+                              output_tensor_aliases);
+}
+
+Status PreProcessPrediction(const PredictSignaturePlan& plan,
+                            const PredictRequest& request,
+                            std::vector<std::pair<string, Tensor>>* inputs,
+                            std::vector<string>* output_tensor_names,
+                            std::vector<string>* output_tensor_aliases) {
+  const SignatureDef& signature = *plan.signature;
+  TF_RETURN_IF_ERROR(VerifyFloatOutputDtype(request.float_output_dtype()));
   TF_RETURN_IF_ERROR(VerifyRequestInputsSize(signature, request));
-  TF_RETURN_IF_ERROR(
-      saved_model::GetInputValues(signature, request.inputs(), *inputs));
+  TF_RETURN_IF_ERROR(GetInputValues(plan, request, inputs));
+
+  // When no output is specified, fetch all output tensors specified in
+  // the signature.
+  if (request.output_filter().empty()) {
+    *output_tensor_names = plan.output_tensor_names;
+    *output_tensor_aliases = plan.output_tensor_aliases;
+    return OkStatus();
+  }
 
   // Prepare run target.
   std::set<string> seen_outputs;
-  std::vector<string> output_filter(request.output_filter().begin(),
-                                    request.output_filter().end());
-  for (auto& alias : output_filter) {
+  std::vector<std::pair<string, string>> fetches;
+  fetches.reserve(request.output_filter().size());
+  for (const string& alias : request.output_filter()) {
     auto iter = signature.outputs().find(alias);
     if (iter == signature.outputs().end()) {
       return tensorflow::Status(
@@ -140,50 +687,66 @@ Status PreProcessPrediction(const SignatureDef& signature,
                           absl::StrJoin(GetMapKeys(signature.outputs()), ","),
                           "}."));
     }
-    if (seen_outputs.find(alias) != seen_outputs.end()) {
+    if (!seen_outputs.insert(alias).second) {
       return tensorflow::Status(
           static_cast<tsl::errors::Code>(absl::StatusCode::kInvalidArgument),
           "duplicate output tensor alias: " + alias);
     }
-    seen_outputs.insert(alias);
-    output_tensor_names->emplace_back(iter->second.name());
-    output_tensor_aliases->emplace_back(alias);
-  }
-  // When no output is specified, fetch all output tensors specified in
-  // the signature.
-  if (output_tensor_names->empty()) {
-    for (auto& iter : signature.outputs()) {
-      output_tensor_names->emplace_back(iter.second.name());
-      output_tensor_aliases->emplace_back(iter.first);
-    }
+    fetches.emplace_back(iter->second.name(), alias);
   }
+  SetFetches(std::move(fetches), output_tensor_names, output_tensor_aliases);
   return OkStatus();
 }
 
+DataType GetFloatOutputDtype(const PredictRequest& request,
+                             DataType default_float_output_dtype) {
+  if (request.float_output_dtype() != DT_INVALID) {
+    return request.float_output_dtype();
+  }
+  return default_float_output_dtype != DT_INVALID ? default_float_output_dtype
+                                                  : DT_FLOAT;
+}
+
 Status PostProcessPredictionResult(
     const std::vector<string>& output_tensor_aliases,
     const std::vector<Tensor>& output_tensors,
     const internal::PredictResponseTensorSerializationOption option,
     PredictResponse* response) {
+  return PostProcessPredictionResult(output_tensor_aliases, output_tensors,
+                                     option, DT_FLOAT, response);
+}
+
+Status PostProcessPredictionResult(
+    const std::vector<string>& output_tensor_aliases,
+    const std::vector<Tensor>& output_tensors,
+    const internal::PredictResponseTensorSerializationOption option,
+    DataType float_output_dtype, PredictResponse* response) {
   // Validate and return output.
   if (output_tensors.size() != output_tensor_aliases.size()) {
     return tensorflow::Status(
         static_cast<tensorflow::errors::Code>(absl::StatusCode::kUnknown),
         "Predict internal error");
   }
-  switch (option) {
-    case internal::PredictResponseTensorSerializationOption::kAsProtoField: {
-      for (int i = 0; i < output_tensors.size(); i++) {
-        output_tensors[i].AsProtoField(
-            &((*response->mutable_outputs())[output_tensor_aliases[i]]));
-      }
-    } break;
-    case internal::PredictResponseTensorSerializationOption::kAsProtoContent: {
-      for (int i = 0; i < output_tensors.size(); i++) {
-        output_tensors[i].AsProtoTensorContent(
-            &((*response->mutable_outputs())[output_tensor_aliases[i]]));
-      }
-    } break;
+  TF_RETURN_IF_ERROR(VerifyFloatOutputDtype(float_output_dtype));
+  const bool reduce_precision =
+      float_output_dtype == DT_BFLOAT16 || float_output_dtype == DT_HALF;
+  for (int i = 0; i < output_tensors.size(); i++) {
+    const Tensor* tensor = &output_tensors[i];
+    Tensor reduced;
+    if (reduce_precision && tensor->dtype() == DT_FLOAT) {
+      reduced = ReduceFloatPrecision(*tensor, float_output_dtype);
+      tensor = &reduced;
+    }
+    TensorProto* output =
+        &(*response->mutable_outputs())[output_tensor_aliases[i]];
+    switch (option) {
+      case internal::PredictResponseTensorSerializationOption::kAsProtoField:
+        tensor->AsProtoField(output);
+        break;
+      case internal::PredictResponseTensorSerializationOption::kAsProtoContent:
+        tensor->AsProtoTensorContent(output);
+        break;
+    }
   }
 
   return OkStatus();
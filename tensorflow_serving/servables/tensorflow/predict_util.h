@@ -16,20 +16,93 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PREDICT_UTIL_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_PREDICT_UTIL_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/types/optional.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/public/session.h"
+#include "tensorflow_serving/core/servable_scoped_cache.h"
 #include "tensorflow_serving/apis/predict.pb.h"
 #include "tensorflow_serving/servables/tensorflow/predict_response_tensor_serialization_option.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
 
 namespace tensorflow {
 namespace serving {
 
 namespace internal {
 
+// What RunPredict() needs of a signature, resolved ahead of the requests to
+// it: the signature has been looked up and verified for prediction, and its
+// feeds and default fetches laid out.
+struct PredictSignaturePlan {
+  struct Input {
+    // How the input is fed: as a dense tensor, or as the component tensors of
+    // a sparse or a ragged one, from PredictRequest.sparse_inputs or
+    // PredictRequest.ragged_inputs.
+    enum class Kind { kDense, kSparse, kRagged };
+
+    string alias;
+    // Empty for composite inputs of a type the plan cannot feed.
+    string feed_name;
+    // The default value from the signature, or null if the input is required.
+    const TensorProto* default_value;
+    Kind kind = Kind::kDense;
+    // For sparse inputs, the feed names of the indices, values and dense
+    // shape; for ragged inputs, those of the flat values and of the nested row
+    // splits, outermost first.
+    std::vector<string> component_feed_names;
+  };
+
+  // The name of the signature (the default serving signature if the request
+  // names none), and the signature, which must outlive the plan.
+  string signature_name;
+  const SignatureDef* signature;
+  std::vector<Input> inputs;
+  // All outputs of the signature, fetched for requests with no output filter.
+  std::vector<string> output_tensor_names;
+  std::vector<string> output_tensor_aliases;
+};
+
+// Creates the plan of the signature named 'signature_name' (the default
+// serving signature if empty) in 'meta_graph_def'. Returns a
+// FailedPrecondition error if there is no such signature.
+Status CreatePredictSignaturePlan(const MetaGraphDef& meta_graph_def,
+                                  const string& signature_name,
+                                  PredictSignaturePlan* plan);
+
+// Caches the PredictSignaturePlans of the signatures of servables, so that
+// requests reuse them. The plans are scoped to the loads of the servables (see
+// ServableHandle::load_generation()), so they never outlive the signatures
+// they point to for the requests that get them.
+//
+// This class is thread-safe.
+class PredictSignaturePlanCache {
+ public:
+  // Holds up to 'max_entries' plans, evicting the least recently used.
+  explicit PredictSignaturePlanCache(size_t max_entries = 1024)
+      : cache_(max_entries) {}
+
+  // Sets 'plan' to the plan of the signature named 'signature_name' in
+  // 'meta_graph_def', that of the servable of 'load_generation', like
+  // CreatePredictSignaturePlan().
+  Status GetPlan(uint64_t load_generation, const MetaGraphDef& meta_graph_def,
+                 const string& signature_name,
+                 std::shared_ptr<const PredictSignaturePlan>* plan);
+
+ private:
+  ServableScopedCache<PredictSignaturePlan> cache_;
+};
+
 // Similar to RunPredict below, but allows specification of a serialization
 // option for the TensorProtos in the response.
 Status RunPredict(
@@ -40,14 +113,72 @@ Status RunPredict(
     const thread::ThreadPoolOptions& thread_pool_options =
         thread::ThreadPoolOptions());
 
+// Like RunPredict above, but runs 'session' asynchronously (see
+// ServingSession::RunAsync()), and calls 'done' with the status once the
+// response is filled in. 'meta_graph_def', 'request' and 'response' must live
+// until then.
+void RunPredictAsync(
+    const RunOptions& run_options, const MetaGraphDef& meta_graph_def,
+    const absl::optional<int64_t>& servable_version,
+    const PredictResponseTensorSerializationOption tensor_serialization_option,
+    ServingSession* session, const PredictRequest& request,
+    PredictResponse* response, std::function<void(const Status&)> done);
+
+// Like RunPredict above, for the signature of 'plan', which must be the one
+// the request names.
+// 'default_float_output_dtype' is the dtype of the DT_FLOAT outputs for
+// requests that don't set one (see GetFloatOutputDtype()).
+Status RunPredict(
+    const RunOptions& run_options, const PredictSignaturePlan& plan,
+    const absl::optional<int64_t>& servable_version,
+    const PredictResponseTensorSerializationOption tensor_serialization_option,
+    Session* session, const PredictRequest& request, PredictResponse* response,
+    const thread::ThreadPoolOptions& thread_pool_options =
+        thread::ThreadPoolOptions(),
+    DataType default_float_output_dtype = DT_INVALID);
+
+// Like RunPredictAsync above, for the signature of 'plan', which must be the
+// one the request names, and with 'default_float_output_dtype' as in
+// RunPredict.
+void RunPredictAsync(
+    const RunOptions& run_options,
+    std::shared_ptr<const PredictSignaturePlan> plan,
+    const absl::optional<int64_t>& servable_version,
+    const PredictResponseTensorSerializationOption tensor_serialization_option,
+    ServingSession* session, const PredictRequest& request,
+    PredictResponse* response, std::function<void(const Status&)> done,
+    DataType default_float_output_dtype = DT_INVALID);
+
+// The dtype the DT_FLOAT outputs of 'request' are returned as: its
+// float_output_dtype if set, else 'default_float_output_dtype' if set (e.g.
+// the ModelConfig.float_output_dtype of the model), else DT_FLOAT.
+DataType GetFloatOutputDtype(const PredictRequest& request,
+                             DataType default_float_output_dtype);
+
+// Converts 'proto', an input of a request, to 'tensor' like
+// Tensor::FromProto(), except that a large 'tensor_content' of a plain data
+// type is aliased, not copied, when it is aligned as tensors require. 'proto'
+// must then outlive 'tensor'.
+bool TensorFromRequestProto(const TensorProto& proto, Tensor* tensor);
+
 // Validate a SignatureDef to make sure it's compatible with prediction, and
 // if so, populate the input and output tensor names.
+//
+// Large dense inputs in 'tensor_content' are not copied: their tensors alias
+// the bytes of 'request', which must outlive them.
 Status PreProcessPrediction(const SignatureDef& signature,
                             const PredictRequest& request,
                             std::vector<std::pair<string, Tensor>>* inputs,
                             std::vector<string>* output_tensor_names,
                             std::vector<string>* output_tensor_aliases);
 
+// Like PreProcessPrediction above, for the signature of 'plan'.
+Status PreProcessPrediction(const PredictSignaturePlan& plan,
+                            const PredictRequest& request,
+                            std::vector<std::pair<string, Tensor>>* inputs,
+                            std::vector<string>* output_tensor_names,
+                            std::vector<string>* output_tensor_aliases);
+
 // Validate results and populate a PredictResponse.
 // Tensors are serialized as specified.
 Status PostProcessPredictionResult(
@@ -56,6 +187,15 @@ Status PostProcessPredictionResult(
     const internal::PredictResponseTensorSerializationOption option,
     PredictResponse* response);
 
+// Like PostProcessPredictionResult above, but returns the DT_FLOAT outputs as
+// 'float_output_dtype': DT_FLOAT, or DT_BFLOAT16 or DT_HALF, to which they are
+// rounded to nearest even.
+Status PostProcessPredictionResult(
+    const std::vector<string>& output_tensor_aliases,
+    const std::vector<Tensor>& output_tensors,
+    const internal::PredictResponseTensorSerializationOption option,
+    DataType float_output_dtype, PredictResponse* response);
+
 }  // namespace internal
 
 // Implementation of Predict using the SavedModel SignatureDef format.
@@ -24,8 +24,11 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/threadpool_options.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow/core/protobuf/struct.pb.h"
 #include "tensorflow_serving/core/availability_preserving_policy.h"
 #include "tensorflow_serving/model_servers/model_platform_types.h"
 #include "tensorflow_serving/model_servers/platform_config_util.h"
@@ -606,6 +609,317 @@ TEST_F(PredictImplTest, MethodNameCheck) {
   SetSignatureMethodNameCheckFeature(old_val);
 }
 
+TEST(PreProcessPredictionTest, ConvertsLargeTensorContent) {
+  SignatureDef signature;
+  signature.set_method_name(kPredictMethodName);
+  (*signature.mutable_inputs())["x"].set_name("x:0");
+  (*signature.mutable_outputs())["y"].set_name("y:0");
+
+  const int kNumElements = 1 << 20;
+  Tensor expected(DT_FLOAT, TensorShape({kNumElements}));
+  for (int i = 0; i < kNumElements; ++i) {
+    expected.flat<float>()(i) = i;
+  }
+  PredictRequest request;
+  expected.AsProtoTensorContent(&(*request.mutable_inputs())["x"]);
+
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_tensor_names;
+  std::vector<string> output_tensor_aliases;
+  TF_ASSERT_OK(internal::PreProcessPrediction(signature, request, &inputs,
+                                              &output_tensor_names,
+                                              &output_tensor_aliases));
+  ASSERT_EQ(1, inputs.size());
+  EXPECT_EQ("x:0", inputs[0].first);
+  test::ExpectTensorEqual<float>(expected, inputs[0].second);
+  // The tensor aliases the request whenever its bytes are aligned.
+  const string& content = request.inputs().at("x").tensor_content();
+  const bool content_is_aligned =
+      reinterpret_cast<uintptr_t>(content.data()) % EIGEN_MAX_ALIGN_BYTES == 0;
+  EXPECT_EQ(content_is_aligned,
+            inputs[0].second.tensor_data().data() == content.data());
+}
+
+TEST(PreProcessPredictionTest, FetchesOutputsInCanonicalOrder) {
+  SignatureDef signature;
+  signature.set_method_name(kPredictMethodName);
+  (*signature.mutable_inputs())["x"].set_name("x:0");
+  (*signature.mutable_outputs())["first"].set_name("b:0");
+  (*signature.mutable_outputs())["second"].set_name("a:0");
+  (*signature.mutable_outputs())["third"].set_name("c:0");
+  PredictRequest request;
+  test::AsScalar<float>(1).AsProtoField(&(*request.mutable_inputs())["x"]);
+
+  // Filters listing the same outputs in any order fetch the same tensors.
+  for (const std::vector<string>& output_filter :
+       std::vector<std::vector<string>>{{"third", "second"},
+                                        {"second", "third"}}) {
+    request.mutable_output_filter()->Assign(output_filter.begin(),
+                                            output_filter.end());
+    std::vector<std::pair<string, Tensor>> inputs;
+    std::vector<string> output_tensor_names;
+    std::vector<string> output_tensor_aliases;
+    TF_ASSERT_OK(internal::PreProcessPrediction(signature, request, &inputs,
+                                                &output_tensor_names,
+                                                &output_tensor_aliases));
+    EXPECT_THAT(output_tensor_names, ::testing::ElementsAre("a:0", "c:0"));
+    EXPECT_THAT(output_tensor_aliases,
+                ::testing::ElementsAre("second", "third"));
+  }
+
+  // As do requests for all outputs, with or without a filter.
+  request.clear_output_filter();
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_tensor_names;
+  std::vector<string> output_tensor_aliases;
+  TF_ASSERT_OK(internal::PreProcessPrediction(signature, request, &inputs,
+                                              &output_tensor_names,
+                                              &output_tensor_aliases));
+  EXPECT_THAT(output_tensor_names, ::testing::ElementsAre("a:0", "b:0", "c:0"));
+}
+
+TEST(PreProcessPredictionTest, ResolvesSharedMemoryInputs) {
+  SignatureDef signature;
+  signature.set_method_name(kPredictMethodName);
+  (*signature.mutable_inputs())["x"].set_name("x:0");
+  (*signature.mutable_outputs())["y"].set_name("y:0");
+  PredictRequest request;
+  SharedMemoryTensor& shared_input =
+      (*request.mutable_shared_memory_inputs())["x"];
+  shared_input.set_region_name("unregistered");
+  shared_input.set_byte_size(4);
+  shared_input.set_dtype(DT_FLOAT);
+
+  // Shared memory inputs count towards the inputs of the signature, and are
+  // looked up in their regions.
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_tensor_names;
+  std::vector<string> output_tensor_aliases;
+  EXPECT_EQ(error::NOT_FOUND,
+            internal::PreProcessPrediction(signature, request, &inputs,
+                                           &output_tensor_names,
+                                           &output_tensor_aliases)
+                .code());
+
+  // An input can't be passed both ways.
+  test::AsScalar<float>(1).AsProtoField(&(*request.mutable_inputs())["x"]);
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            internal::PreProcessPrediction(signature, request, &inputs,
+                                           &output_tensor_names,
+                                           &output_tensor_aliases)
+                .code());
+}
+
+TEST(PreProcessPredictionTest, FeedsSparseAndRaggedInputs) {
+  SignatureDef signature;
+  signature.set_method_name(kPredictMethodName);
+  TensorInfo::CooSparse& coo_sparse =
+      *(*signature.mutable_inputs())["sparse"].mutable_coo_sparse();
+  coo_sparse.set_indices_tensor_name("indices:0");
+  coo_sparse.set_values_tensor_name("values:0");
+  coo_sparse.set_dense_shape_tensor_name("dense_shape:0");
+  TensorInfo::CompositeTensor& composite =
+      *(*signature.mutable_inputs())["ragged"].mutable_composite_tensor();
+  composite.mutable_type_spec()->set_type_spec_class(
+      TypeSpecProto::RAGGED_TENSOR_SPEC);
+  composite.add_components()->set_name("flat_values:0");
+  composite.add_components()->set_name("row_splits:0");
+  (*signature.mutable_outputs())["y"].set_name("y:0");
+
+  PredictRequest request;
+  SparseTensorProto& sparse = (*request.mutable_sparse_inputs())["sparse"];
+  test::AsTensor<int64_t>({0, 3, 1, 999}, {2, 2})
+      .AsProtoField(sparse.mutable_indices());
+  test::AsTensor<float>({1, 2}, {2}).AsProtoField(sparse.mutable_values());
+  test::AsTensor<int64_t>({2, 1000}, {2})
+      .AsProtoField(sparse.mutable_dense_shape());
+  RaggedTensorProto& ragged = (*request.mutable_ragged_inputs())["ragged"];
+  test::AsTensor<int64_t>({7, 8, 9}, {3})
+      .AsProtoField(ragged.mutable_flat_values());
+  test::AsTensor<int64_t>({0, 1, 3}, {3})
+      .AsProtoField(ragged.add_nested_row_splits());
+
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_tensor_names;
+  std::vector<string> output_tensor_aliases;
+  TF_ASSERT_OK(internal::PreProcessPrediction(signature, request, &inputs,
+                                              &output_tensor_names,
+                                              &output_tensor_aliases));
+  std::vector<string> feed_names;
+  for (const auto& input : inputs) {
+    feed_names.push_back(input.first);
+  }
+  EXPECT_THAT(feed_names, ::testing::UnorderedElementsAre(
+                              "indices:0", "values:0", "dense_shape:0",
+                              "flat_values:0", "row_splits:0"));
+  for (const auto& input : inputs) {
+    if (input.first == "values:0") {
+      test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2}, {2}),
+                                     input.second);
+    } else if (input.first == "row_splits:0") {
+      test::ExpectTensorEqual<int64_t>(test::AsTensor<int64_t>({0, 1, 3}, {3}),
+                                       input.second);
+    }
+  }
+
+  // Row splits must end at the number of flat values.
+  test::AsTensor<int64_t>({0, 1, 2}, {3})
+      .AsProtoField(ragged.mutable_nested_row_splits(0));
+  inputs.clear();
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            internal::PreProcessPrediction(signature, request, &inputs,
+                                           &output_tensor_names,
+                                           &output_tensor_aliases)
+                .code());
+
+  // Nor decrease on the way.
+  test::AsTensor<int64_t>({0, 4, 3}, {3})
+      .AsProtoField(ragged.mutable_nested_row_splits(0));
+  inputs.clear();
+  Status status = internal::PreProcessPrediction(
+      signature, request, &inputs, &output_tensor_names,
+      &output_tensor_aliases);
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+  EXPECT_THAT(status.message(), ::testing::HasSubstr("must not decrease"));
+  test::AsTensor<int64_t>({0, 1, 3}, {3})
+      .AsProtoField(ragged.mutable_nested_row_splits(0));
+
+  // Sparse indices must be within the dense shape.
+  test::AsTensor<int64_t>({0, 3, 2, 999}, {2, 2})
+      .AsProtoField(sparse.mutable_indices());
+  inputs.clear();
+  status = internal::PreProcessPrediction(signature, request, &inputs,
+                                          &output_tensor_names,
+                                          &output_tensor_aliases);
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+  EXPECT_THAT(status.message(), ::testing::HasSubstr("out of its dense shape"));
+  test::AsTensor<int64_t>({0, 3, 1, 999}, {2, 2})
+      .AsProtoField(sparse.mutable_indices());
+
+  // Composite inputs can't be sent densified.
+  request.mutable_ragged_inputs()->clear();
+  test::AsTensor<int64_t>({7, 8, 9}, {3})
+      .AsProtoField(&(*request.mutable_inputs())["ragged"]);
+  inputs.clear();
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            internal::PreProcessPrediction(signature, request, &inputs,
+                                           &output_tensor_names,
+                                           &output_tensor_aliases)
+                .code());
+}
+
+TEST(PostProcessPredictionResultTest, ReducesFloatOutputPrecision) {
+  const Tensor floats = test::AsTensor<float>({0.1f, 1000.5f}, {2});
+  const Tensor ints = test::AsTensor<int32>({1, 2}, {2});
+  for (const auto option :
+       {internal::PredictResponseTensorSerializationOption::kAsProtoField,
+        internal::PredictResponseTensorSerializationOption::kAsProtoContent}) {
+    PredictResponse response;
+    TF_ASSERT_OK(internal::PostProcessPredictionResult(
+        {"floats", "ints"}, {floats, ints}, option, DT_BFLOAT16, &response));
+    Tensor bfloat16_output;
+    ASSERT_TRUE(bfloat16_output.FromProto(response.outputs().at("floats")));
+    ASSERT_EQ(DT_BFLOAT16, bfloat16_output.dtype());
+    test::ExpectTensorEqual<bfloat16>(
+        test::AsTensor<bfloat16>(
+            {static_cast<bfloat16>(0.1f), static_cast<bfloat16>(1000.5f)},
+            {2}),
+        bfloat16_output);
+    // Only DT_FLOAT outputs are converted.
+    EXPECT_EQ(DT_INT32, response.outputs().at("ints").dtype());
+
+    TF_ASSERT_OK(internal::PostProcessPredictionResult(
+        {"floats"}, {floats}, option, DT_HALF, &response));
+    Tensor half_output;
+    ASSERT_TRUE(half_output.FromProto(response.outputs().at("floats")));
+    ASSERT_EQ(DT_HALF, half_output.dtype());
+    EXPECT_EQ(1000.5f, static_cast<float>(half_output.flat<Eigen::half>()(1)));
+  }
+
+  PredictResponse response;
+  EXPECT_EQ(
+      error::INVALID_ARGUMENT,
+      internal::PostProcessPredictionResult(
+          {"floats"}, {floats},
+          internal::PredictResponseTensorSerializationOption::kAsProtoField,
+          DT_INT8, &response)
+          .code());
+}
+
+TEST(PostProcessPredictionResultTest, GetFloatOutputDtype) {
+  PredictRequest request;
+  EXPECT_EQ(DT_FLOAT, internal::GetFloatOutputDtype(request, DT_INVALID));
+  // The default of the model applies unless the request sets a dtype.
+  EXPECT_EQ(DT_HALF, internal::GetFloatOutputDtype(request, DT_HALF));
+  request.set_float_output_dtype(DT_FLOAT);
+  EXPECT_EQ(DT_FLOAT, internal::GetFloatOutputDtype(request, DT_HALF));
+}
+
+TEST(PredictSignaturePlanCacheTest, ReusesPlansOfSameSignature) {
+  MetaGraphDef meta_graph_def;
+  SignatureDef& signature =
+      (*meta_graph_def.mutable_signature_def())[kDefaultServingSignatureDefKey];
+  signature.set_method_name(kPredictMethodName);
+  (*signature.mutable_inputs())["x"].set_name("x:0");
+  (*signature.mutable_inputs())["z"].set_name("z:0");
+  test::AsScalar<float>(1).AsProtoField(
+      &(*signature.mutable_defaults())["z"]);
+  (*signature.mutable_outputs())["y"].set_name("y:0");
+
+  internal::PredictSignaturePlanCache plan_cache;
+  std::shared_ptr<const internal::PredictSignaturePlan> plan;
+  TF_ASSERT_OK(plan_cache.GetPlan(/*load_generation=*/1, meta_graph_def, "",
+                                  &plan));
+  EXPECT_EQ(kDefaultServingSignatureDefKey, plan->signature_name);
+  EXPECT_EQ(&signature, plan->signature);
+  ASSERT_EQ(2, plan->inputs.size());
+  for (const auto& input : plan->inputs) {
+    EXPECT_EQ(input.alias == "z", input.default_value != nullptr);
+  }
+  EXPECT_THAT(plan->output_tensor_names, ::testing::ElementsAre("y:0"));
+  EXPECT_THAT(plan->output_tensor_aliases, ::testing::ElementsAre("y"));
+
+  // Requests to the same signature of the same servable share its plan.
+  std::shared_ptr<const internal::PredictSignaturePlan> cached_plan;
+  TF_ASSERT_OK(plan_cache.GetPlan(/*load_generation=*/1, meta_graph_def,
+                                  kDefaultServingSignatureDefKey,
+                                  &cached_plan));
+  EXPECT_EQ(plan, cached_plan);
+
+  // The same servable reloaded gets new plans, of its own signatures.
+  const MetaGraphDef reloaded_meta_graph_def = meta_graph_def;
+  TF_ASSERT_OK(plan_cache.GetPlan(/*load_generation=*/2,
+                                  reloaded_meta_graph_def, "", &cached_plan));
+  EXPECT_NE(plan, cached_plan);
+  EXPECT_EQ(&reloaded_meta_graph_def.signature_def().at(
+                kDefaultServingSignatureDefKey),
+            cached_plan->signature);
+
+  EXPECT_EQ(error::FAILED_PRECONDITION,
+            plan_cache
+                .GetPlan(/*load_generation=*/1, meta_graph_def, "missing",
+                         &cached_plan)
+                .code());
+
+  // Requests run with a plan like with the signature.
+  PredictRequest request;
+  test::AsTensor<float>({2}).AsProtoField(&(*request.mutable_inputs())["x"]);
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_tensor_names;
+  std::vector<string> output_tensor_aliases;
+  TF_ASSERT_OK(internal::PreProcessPrediction(*plan, request, &inputs,
+                                              &output_tensor_names,
+                                              &output_tensor_aliases));
+  ASSERT_EQ(2, inputs.size());
+  EXPECT_THAT(output_tensor_names, ::testing::ElementsAre("y:0"));
+  (*request.mutable_inputs())["bogus"] = request.inputs().at("x");
+  inputs.clear();
+  EXPECT_FALSE(internal::PreProcessPrediction(*plan, request, &inputs,
+                                              &output_tensor_names,
+                                              &output_tensor_aliases)
+                   .ok());
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
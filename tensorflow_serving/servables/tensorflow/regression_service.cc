@@ -19,6 +19,8 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow_serving/apis/regressor.h"
 #include "tensorflow_serving/core/servable_handle.h"
+#include "tensorflow_serving/servables/decision_forest/decision_forest.h"
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
 #include "tensorflow_serving/servables/tensorflow/regressor.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
 
@@ -48,11 +50,29 @@ Status TensorflowRegressionServiceImpl::RegressWithModelSpec(
   TRACELITERAL("TensorflowRegressionServiceImpl::RegressWithModelSpec");
 
   ServableHandle<SavedModelBundle> saved_model_bundle;
-  TF_RETURN_IF_ERROR(core->GetServableHandle(model_spec, &saved_model_bundle));
-  return RunRegress(run_options, saved_model_bundle->meta_graph_def,
-                    saved_model_bundle.id().version,
-                    saved_model_bundle->session.get(), request, response,
-                    thread_pool_options);
+  const Status status =
+      core->GetServableHandle(model_spec, &saved_model_bundle);
+  if (!status.ok()) {
+    // Models of the decision forest platform are scored natively. (The handle
+    // is released first, so as not to count twice towards concurrency limits.)
+    saved_model_bundle = ServableHandle<SavedModelBundle>();
+    ServableHandle<DecisionForestModel> forest;
+    if (!core->GetServableHandle(model_spec, &forest).ok()) {
+      return status;
+    }
+    TF_RETURN_IF_ERROR(
+        forest->Regress(request.input(), response->mutable_result()));
+    MakeModelSpec(forest.id().name, /*signature_name=*/{}, forest.id().version,
+                  response->mutable_model_spec());
+    return OkStatus();
+  }
+  TF_RETURN_IF_ERROR(RunRegress(run_options, saved_model_bundle->meta_graph_def,
+                                saved_model_bundle.id().version,
+                                saved_model_bundle->session.get(), request,
+                                response, thread_pool_options));
+  CapturedWarmupRequests::Global()->Capture(saved_model_bundle.id().name,
+                                            request);
+  return OkStatus();
 }
 
 }  // namespace serving
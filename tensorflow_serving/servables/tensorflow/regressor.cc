@@ -37,6 +37,7 @@ limitations under the License.
 #include "tensorflow_serving/apis/model.pb.h"
 #include "tensorflow_serving/apis/regression.pb.h"
 #include "tensorflow_serving/apis/regressor.h"
+#include "tensorflow_serving/servables/tensorflow/example_features.h"
 #include "tensorflow_serving/servables/tensorflow/util.h"
 
 namespace tensorflow {
@@ -63,17 +64,26 @@ class SavedModelTensorFlowRegressor : public RegressorInterface {
     TRACELITERAL("SavedModelTensorFlowRegressor::Regress");
 
     string input_tensor_name;
+    string context_tensor_name;
     std::vector<string> output_tensor_names;
     TF_RETURN_IF_ERROR(PreProcessRegression(*signature_, &input_tensor_name,
-                                            &output_tensor_names));
+                                            &output_tensor_names,
+                                            &context_tensor_name));
 
     std::vector<Tensor> outputs;
     int num_examples;
     int64_t runtime_latency;
-    TF_RETURN_IF_ERROR(PerformOneShotTensorComputation(
-        run_options_, request.input(), input_tensor_name, output_tensor_names,
-        session_, &outputs, &num_examples, thread_pool_options_,
-        &runtime_latency));
+    if (input_tensor_name.empty()) {
+      TF_RETURN_IF_ERROR(PerformOneShotFeatureComputation(
+          run_options_, request.input(), *signature_, output_tensor_names,
+          session_, &outputs, &num_examples, thread_pool_options_,
+          &runtime_latency));
+    } else {
+      TF_RETURN_IF_ERROR(PerformOneShotTensorComputationWithContext(
+          run_options_, request.input(), input_tensor_name,
+          context_tensor_name, output_tensor_names, session_, &outputs,
+          &num_examples, thread_pool_options_, &runtime_latency));
+    }
     RecordRuntimeLatency(request.model_spec().name(), /*api=*/"Regress",
                          /*runtime=*/"TF1", runtime_latency);
 
@@ -169,30 +179,50 @@ Status GetRegressionSignatureDef(const ModelSpec& model_spec,
 
 Status PreProcessRegression(const SignatureDef& signature,
                             string* input_tensor_name,
-                            std::vector<string>* output_tensor_names) {
+                            std::vector<string>* output_tensor_names,
+                            string* context_tensor_name) {
   if (GetSignatureMethodNameCheckFeature() &&
       signature.method_name() != kRegressMethodName) {
     return errors::InvalidArgument(strings::StrCat(
         "Expected regression signature method_name to be ", kRegressMethodName,
         ". Was: ", signature.method_name()));
   }
-  if (signature.inputs().size() != 1) {
-    return errors::InvalidArgument(
-        strings::StrCat("Expected one input Tensor."));
+  const bool has_feature_inputs = HasExampleFeatureInputs(signature);
+  auto context_iter = signature.inputs().find(kExampleContextInputs);
+  const bool has_context_input = context_iter != signature.inputs().end();
+  if (!has_feature_inputs &&
+      signature.inputs().size() != (has_context_input ? 2 : 1)) {
+    return errors::InvalidArgument(strings::StrCat(
+        "Expected one input Tensor, and optionally a \"",
+        kExampleContextInputs, "\" one."));
   }
   if (signature.outputs().size() != 1) {
     return errors::InvalidArgument(
         strings::StrCat("Expected one output Tensor."));
   }
 
-  auto input_iter = signature.inputs().find(kRegressInputs);
-  if (input_iter == signature.inputs().end()) {
-    return errors::InvalidArgument(
-        "No regression inputs found in SignatureDef: ",
-        signature.DebugString());
-  }
-  if (input_tensor_name != nullptr) {
-    *input_tensor_name = input_iter->second.name();
+  if (has_feature_inputs) {
+    // The Examples are fed as features, by PerformOneShotFeatureComputation().
+    if (input_tensor_name != nullptr) {
+      input_tensor_name->clear();
+    }
+    if (context_tensor_name != nullptr) {
+      context_tensor_name->clear();
+    }
+  } else {
+    auto input_iter = signature.inputs().find(kRegressInputs);
+    if (input_iter == signature.inputs().end()) {
+      return errors::InvalidArgument(
+          "No regression inputs found in SignatureDef: ",
+          signature.DebugString());
+    }
+    if (input_tensor_name != nullptr) {
+      *input_tensor_name = input_iter->second.name();
+    }
+    if (context_tensor_name != nullptr) {
+      *context_tensor_name =
+          has_context_input ? context_iter->second.name() : string();
+    }
   }
 
   auto output_iter = signature.outputs().find(kRegressOutputs);
@@ -62,13 +62,18 @@ Status GetRegressionSignatureDef(const ModelSpec& model_spec,
 
 // Validate a SignatureDef to make sure it's compatible with Regression.
 // Populate the input and output tensor names, if the args are not nullptr.
+// The signature may have a second input, kExampleContextInputs, whose tensor
+// name 'context_tensor_name' is set to (or cleared if there is none). If its
+// inputs are Example features instead (see kExampleFeatureInputsPrefix), the
+// input tensor name is cleared.
 //
 // NOTE: output_tensor_names may already have elements in it (e.g. when building
 // a full list of outputs from multiple signatures), and this function will just
 // append to the vector.
 Status PreProcessRegression(const SignatureDef& signature,
                             string* input_tensor_name,
-                            std::vector<string>* output_tensor_names);
+                            std::vector<string>* output_tensor_names,
+                            string* context_tensor_name = nullptr);
 
 // Validate all results and populate a RegressionResult.
 Status PostProcessRegressionResult(
@@ -0,0 +1,222 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/resource_measurer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow_serving/resources/resource_values.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Returns the key of the models in the history: the base path of the model
+// whose version is at 'path'.
+string ModelKey(const string& path) { return string(io::Dirname(path)); }
+
+Resource RamResource(const string& device, int device_instance) {
+  Resource resource;
+  resource.set_device(device);
+  resource.mutable_device_instance()->set_value(device_instance);
+  resource.set_kind(resource_kinds::kRamBytes);
+  return resource;
+}
+
+// Returns the main memory RAM entry of 'allocation', or null if there is none.
+// (ResourceUtil would reject the GPU entries of measurements, since the
+// resource trackers of the model server only know main memory.)
+ResourceAllocation::Entry* FindMainRamEntry(ResourceAllocation* allocation) {
+  for (ResourceAllocation::Entry& entry :
+       *allocation->mutable_resource_quantities()) {
+    if (entry.resource().device() == device_types::kMain &&
+        entry.resource().kind() == resource_kinds::kRamBytes) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+ResourceMeasurer::Load::~Load() { measurer_->EndLoad(*this); }
+
+Status ResourceMeasurer::Create(const string& history_path,
+                                std::unique_ptr<ResourceMeasurer>* measurer) {
+  ResourceMeasurementHistory history;
+  if (!history_path.empty() && Env::Default()->FileExists(history_path).ok()) {
+    const Status status =
+        ReadTextProto(Env::Default(), history_path, &history);
+    if (!status.ok()) {
+      // The history only refines estimates; do not let a damaged file keep
+      // models from loading.
+      LOG(WARNING) << "Ignoring the resource measurement history at "
+                   << history_path << ": " << status;
+      history.Clear();
+    }
+  }
+  // The CPU allocator only keeps statistics on request.
+  EnableCPUAllocatorStats();
+  measurer->reset(new ResourceMeasurer(history_path, history));
+  return OkStatus();
+}
+
+ResourceMeasurer::ResourceMeasurer(const string& history_path,
+                                   const ResourceMeasurementHistory& history)
+    : history_path_(history_path), history_(history) {
+  allocators_[cpu_allocator()] = RamResource(device_types::kMain, 0);
+}
+
+std::unique_ptr<ResourceMeasurer::Load> ResourceMeasurer::StartLoad() {
+  std::unique_ptr<Load> load(new Load(this));
+  mutex_lock l(mu_);
+  load->index_ = ++num_loads_started_;
+  load->overlapped_ = num_loads_in_progress_ > 0;
+  ++num_loads_in_progress_;
+  for (const auto& entry : allocators_) {
+    const absl::optional<AllocatorStats> stats = entry.first->GetStats();
+    if (stats.has_value()) {
+      load->bytes_in_use_at_start_[entry.first] = stats->bytes_in_use;
+    }
+  }
+  return load;
+}
+
+void ResourceMeasurer::EndLoad(const Load& load) {
+  mutex_lock l(mu_);
+  --num_loads_in_progress_;
+}
+
+void ResourceMeasurer::AddSessionAllocators(Session* session) {
+  const DeviceMgr* device_mgr;
+  if (!session->LocalDeviceManager(&device_mgr).ok()) {
+    return;
+  }
+  mutex_lock l(mu_);
+  for (Device* device : device_mgr->ListDevices()) {
+    string device_type;
+    if (device->device_type() == DEVICE_CPU) {
+      device_type = device_types::kMain;
+    } else if (device->device_type() == DEVICE_GPU) {
+      device_type = device_types::kGpu;
+    } else {
+      continue;
+    }
+    Allocator* const allocator = device->GetAllocator(AllocatorAttributes());
+    if (allocator != nullptr && allocators_.count(allocator) == 0) {
+      // Main memory is accounted for as a single device.
+      allocators_[allocator] = RamResource(
+          device_type,
+          device_type == device_types::kMain ? 0 : device->parsed_name().id);
+    }
+  }
+}
+
+Status ResourceMeasurer::FinishLoad(std::unique_ptr<Load> load,
+                                    const string& path,
+                                    const ResourceAllocation& estimate,
+                                    ResourceAllocation* measured) {
+  mutex_lock l(mu_);
+  if (load->overlapped_ || num_loads_started_ != load->index_) {
+    return errors::Unavailable("The load of ", path,
+                               " overlapped with other loads");
+  }
+  // The growth of the bytes in use, by device and device instance. An
+  // allocator that was not known at the start of the load was created by it.
+  std::map<std::pair<string, uint32_t>, int64_t> growth;
+  for (const auto& entry : allocators_) {
+    const absl::optional<AllocatorStats> stats = entry.first->GetStats();
+    if (!stats.has_value()) {
+      continue;
+    }
+    auto start = load->bytes_in_use_at_start_.find(entry.first);
+    const int64_t bytes_in_use_at_start =
+        start == load->bytes_in_use_at_start_.end() ? 0 : start->second;
+    const Resource& resource = entry.second;
+    growth[{resource.device(), resource.device_instance().value()}] +=
+        stats->bytes_in_use - bytes_in_use_at_start;
+  }
+  if (growth.empty()) {
+    return errors::Unavailable(
+        "None of the allocators of the load of ", path, " keeps statistics");
+  }
+
+  measured->Clear();
+  for (const auto& entry : growth) {
+    ResourceAllocation::Entry* measured_entry =
+        measured->add_resource_quantities();
+    *measured_entry->mutable_resource() =
+        RamResource(entry.first.first, entry.first.second);
+    // Frees of memory allocated before the load can outweigh its allocations.
+    measured_entry->set_quantity(std::max<int64_t>(0, entry.second));
+  }
+  VLOG(1) << "Measured the resources of " << path << ": "
+          << measured->DebugString();
+
+  ResourceMeasurement& measurement =
+      (*history_.mutable_measurements())[ModelKey(path)];
+  ResourceAllocation disk_estimate = estimate;
+  const ResourceAllocation::Entry* estimate_entry =
+      FindMainRamEntry(&disk_estimate);
+  measurement.set_estimated_ram_bytes(
+      estimate_entry == nullptr ? 0 : estimate_entry->quantity());
+  *measurement.mutable_measured_resources() = *measured;
+  if (!history_path_.empty()) {
+    const Status status = WriteHistory();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to write the resource measurement history to "
+                   << history_path_ << ": " << status;
+    }
+  }
+  return OkStatus();
+}
+
+void ResourceMeasurer::AdjustEstimate(const string& path,
+                                      ResourceAllocation* estimate) const {
+  mutex_lock l(mu_);
+  auto it = history_.measurements().find(ModelKey(path));
+  if (it == history_.measurements().end() ||
+      it->second.estimated_ram_bytes() == 0) {
+    return;
+  }
+  ResourceAllocation measured_resources = it->second.measured_resources();
+  const ResourceAllocation::Entry* measured_entry =
+      FindMainRamEntry(&measured_resources);
+  ResourceAllocation::Entry* estimate_entry = FindMainRamEntry(estimate);
+  if (measured_entry == nullptr || estimate_entry == nullptr) {
+    return;
+  }
+  const double ratio = static_cast<double>(measured_entry->quantity()) /
+                       it->second.estimated_ram_bytes();
+  estimate_entry->set_quantity(
+      static_cast<uint64_t>(ratio * estimate_entry->quantity()));
+}
+
+Status ResourceMeasurer::WriteHistory() const {
+  const string tmp_path = history_path_ + ".tmp";
+  TF_RETURN_IF_ERROR(WriteTextProto(Env::Default(), tmp_path, history_));
+  return Env::Default()->RenameFile(tmp_path, history_path_);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
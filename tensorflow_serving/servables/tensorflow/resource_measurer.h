@@ -0,0 +1,137 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_RESOURCE_MEASURER_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_RESOURCE_MEASURER_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow_serving/resources/resources.pb.h"
+#include "tensorflow_serving/servables/tensorflow/resource_measurement.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Measures the resources that models take once loaded from the allocators of
+// the devices of their sessions, main memory and GPU memory alike, instead of
+// estimating them from the size of the models on disk. Keeps the latest
+// measurement of each model, optionally persisted to a file, and uses it to
+// correct the disk-based estimates of later loads of the same model.
+//
+// A measurement is the growth of the bytes in use of the allocators over a
+// load. Since the allocators are shared by all sessions of the process, it is
+// only sound if no other load overlaps with it: the measurements of
+// overlapping loads are discarded. (Loads that do not go through this
+// measurer, e.g. of other platforms, go unnoticed.)
+//
+// This class is thread-safe.
+class ResourceMeasurer {
+ public:
+  // The state of the allocators at the start of a load.
+  class Load {
+   public:
+    ~Load();
+
+   private:
+    friend class ResourceMeasurer;
+
+    explicit Load(ResourceMeasurer* measurer) : measurer_(measurer) {}
+
+    ResourceMeasurer* const measurer_;
+
+    // The index of the load among all started loads.
+    uint64_t index_ = 0;
+
+    // Whether another load was in progress when this one started.
+    bool overlapped_ = false;
+
+    // The bytes in use of each known allocator that keeps statistics.
+    std::map<Allocator*, int64_t> bytes_in_use_at_start_;
+
+    TF_DISALLOW_COPY_AND_ASSIGN(Load);
+  };
+
+  // Creates a measurer. If 'history_path' is not empty, the history of
+  // measurements is read from it, if the file exists, and written back to it
+  // after each measurement.
+  static Status Create(const string& history_path,
+                       std::unique_ptr<ResourceMeasurer>* measurer);
+
+  ~ResourceMeasurer() = default;
+
+  // Starts measuring a load. The load lasts until the returned object is
+  // passed to FinishLoad() or destroyed.
+  std::unique_ptr<Load> StartLoad() TF_LOCKS_EXCLUDED(mu_);
+
+  // Adds the allocators of the devices of 'session' to the measured
+  // allocators. Must be called on each session that is created during a load
+  // (before it gets wrapped), since the allocators of new devices only come
+  // into existence with the sessions that use them. Sessions that do not
+  // expose their devices (e.g. TfLiteSession) are skipped.
+  void AddSessionAllocators(Session* session) TF_LOCKS_EXCLUDED(mu_);
+
+  // Finishes measuring 'load' of the model version at 'path', whose
+  // disk-based estimate is 'estimate', records the measurement in the history
+  // and sets 'measured'. Fails if the load overlapped with another one or none
+  // of the allocators keeps statistics.
+  Status FinishLoad(std::unique_ptr<Load> load, const string& path,
+                    const ResourceAllocation& estimate,
+                    ResourceAllocation* measured) TF_LOCKS_EXCLUDED(mu_);
+
+  // Scales the main memory RAM of 'estimate', a disk-based estimate for the
+  // model version at 'path', by the ratio of the measured to the estimated RAM
+  // of the latest measurement of the same model. Leaves 'estimate' untouched
+  // if the model was never measured.
+  void AdjustEstimate(const string& path, ResourceAllocation* estimate) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  ResourceMeasurer(const string& history_path,
+                   const ResourceMeasurementHistory& history);
+
+  // Called when 'load' ends.
+  void EndLoad(const Load& load) TF_LOCKS_EXCLUDED(mu_);
+
+  // Writes 'history_' to 'history_path_', atomically.
+  Status WriteHistory() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const string history_path_;
+
+  mutable mutex mu_;
+
+  // The allocators to measure, and the resource each of them allocates.
+  std::map<Allocator*, Resource> allocators_ TF_GUARDED_BY(mu_);
+
+  uint64_t num_loads_started_ TF_GUARDED_BY(mu_) = 0;
+  int num_loads_in_progress_ TF_GUARDED_BY(mu_) = 0;
+
+  ResourceMeasurementHistory history_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ResourceMeasurer);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_RESOURCE_MEASURER_H_
@@ -0,0 +1,136 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/resource_measurer.h"
+
+#include <memory>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/resources/resource_values.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+constexpr int64_t kTensorBytes = 4 << 20;
+
+ResourceAllocation RamEstimate(uint64_t ram_bytes) {
+  return CreateProto<ResourceAllocation>(
+      strings::StrCat("resource_quantities { resource { device: 'main' "
+                      "kind: 'ram_in_bytes' } quantity: ",
+                      ram_bytes, " }"));
+}
+
+uint64_t MainRamBytes(const ResourceAllocation& allocation) {
+  for (const auto& entry : allocation.resource_quantities()) {
+    if (entry.resource().device() == device_types::kMain &&
+        entry.resource().kind() == resource_kinds::kRamBytes) {
+      return entry.quantity();
+    }
+  }
+  return 0;
+}
+
+// Measures a load of the model version at 'path' that allocates a tensor of
+// 'kTensorBytes', estimated to take 'estimated_ram_bytes'.
+Status MeasureLoad(ResourceMeasurer* measurer, const string& path,
+                   uint64_t estimated_ram_bytes, ResourceAllocation* measured) {
+  std::unique_ptr<ResourceMeasurer::Load> load = measurer->StartLoad();
+  Tensor tensor(cpu_allocator(), DT_INT8, TensorShape({kTensorBytes}));
+  return measurer->FinishLoad(std::move(load), path,
+                              RamEstimate(estimated_ram_bytes), measured);
+}
+
+TEST(ResourceMeasurerTest, MeasuresAllocationsOfLoad) {
+  std::unique_ptr<ResourceMeasurer> measurer;
+  TF_ASSERT_OK(ResourceMeasurer::Create("", &measurer));
+  ResourceAllocation measured;
+  TF_ASSERT_OK(MeasureLoad(measurer.get(), "/models/m/1", 1000, &measured));
+  EXPECT_GE(MainRamBytes(measured), kTensorBytes);
+}
+
+TEST(ResourceMeasurerTest, DiscardsOverlappingLoads) {
+  std::unique_ptr<ResourceMeasurer> measurer;
+  TF_ASSERT_OK(ResourceMeasurer::Create("", &measurer));
+  ResourceAllocation measured;
+  {
+    std::unique_ptr<ResourceMeasurer::Load> other_load = measurer->StartLoad();
+    EXPECT_FALSE(
+        MeasureLoad(measurer.get(), "/models/m/1", 1000, &measured).ok());
+  }
+  std::unique_ptr<ResourceMeasurer::Load> load = measurer->StartLoad();
+  {
+    std::unique_ptr<ResourceMeasurer::Load> other_load = measurer->StartLoad();
+  }
+  EXPECT_FALSE(measurer
+                   ->FinishLoad(std::move(load), "/models/m/1",
+                                RamEstimate(1000), &measured)
+                   .ok());
+
+  // Once the other loads are over, loads are measured again.
+  TF_EXPECT_OK(MeasureLoad(measurer.get(), "/models/m/1", 1000, &measured));
+}
+
+TEST(ResourceMeasurerTest, PersistsHistoryAndAdjustsEstimates) {
+  const string history_path =
+      io::JoinPath(testing::TmpDir(), "resource_measurement_history");
+  Env::Default()->DeleteFile(history_path).IgnoreError();
+  ResourceAllocation measured;
+  {
+    std::unique_ptr<ResourceMeasurer> measurer;
+    TF_ASSERT_OK(ResourceMeasurer::Create(history_path, &measurer));
+    TF_ASSERT_OK(MeasureLoad(measurer.get(), "/models/m/1", 1000, &measured));
+  }
+  const uint64_t measured_ram_bytes = MainRamBytes(measured);
+
+  std::unique_ptr<ResourceMeasurer> measurer;
+  TF_ASSERT_OK(ResourceMeasurer::Create(history_path, &measurer));
+  // A later version of the model, twice as large on disk, is expected to take
+  // twice the measured RAM.
+  ResourceAllocation estimate = RamEstimate(2000);
+  measurer->AdjustEstimate("/models/m/2", &estimate);
+  EXPECT_NEAR(2 * measured_ram_bytes, MainRamBytes(estimate), 1);
+
+  // Estimates of other models are left alone.
+  estimate = RamEstimate(2000);
+  measurer->AdjustEstimate("/models/other/2", &estimate);
+  EXPECT_EQ(2000, MainRamBytes(estimate));
+}
+
+TEST(ResourceMeasurerTest, IgnoresDamagedHistory) {
+  const string history_path =
+      io::JoinPath(testing::TmpDir(), "damaged_resource_measurement_history");
+  TF_ASSERT_OK(
+      WriteStringToFile(Env::Default(), history_path, "not a history"));
+  std::unique_ptr<ResourceMeasurer> measurer;
+  TF_ASSERT_OK(ResourceMeasurer::Create(history_path, &measurer));
+  ResourceAllocation estimate = RamEstimate(2000);
+  measurer->AdjustEstimate("/models/m/2", &estimate);
+  EXPECT_EQ(2000, MainRamBytes(estimate));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
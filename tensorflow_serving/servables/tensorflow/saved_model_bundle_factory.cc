@@ -15,30 +15,74 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_factory.h"
 
+#include <algorithm>
+#include <functional>
 #include <memory>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/cc/saved_model/loader_util.h"
+#include "tensorflow/cc/saved_model/reader.h"
 #include "tensorflow/cc/saved_model/tag_constants.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_process_state.h"
+#include "tensorflow/core/common_runtime/process_state.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/default_device.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/protobuf/named_tensor.pb.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
+#include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow_serving/core/load_profile.h"
+#include "tensorflow_serving/resources/resource_values.h"
 #include "tensorflow_serving/servables/tensorflow/bundle_factory_util.h"
+#include "tensorflow_serving/servables/tensorflow/cost_accounting_session.h"
+#include "tensorflow_serving/servables/tensorflow/delta_saved_model.h"
+#include "tensorflow_serving/servables/tensorflow/graph_transforms.h"
+#include "tensorflow_serving/servables/tensorflow/memmapped_variables.h"
+#include "tensorflow_serving/servables/tensorflow/parallel_restore.h"
+#include "tensorflow_serving/servables/tensorflow/prebuilt_lookup_table.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_config.pb.h"
+#include "tensorflow_serving/servables/tensorflow/saved_model_config_util.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
 #include "tensorflow_serving/servables/tensorflow/tflite_session.h"
+#include "tensorflow_serving/servables/tensorflow/tokenizing_session.h"
 #include "tensorflow_serving/session_bundle/session_bundle_util.h"
+#include "tensorflow_serving/util/memory_accounting.h"
+#include "tensorflow_serving/util/sharded_metrics.h"
 
 namespace tensorflow {
 namespace serving {
 
 namespace {
 
+auto* gpu_busy_micros = ShardedCounter<2>::New(
+    "/tensorflow/serving/gpu/busy_micros",
+    "The time (in microseconds) the model had session runs in flight on its "
+    "GPU stream group; its rate is the occupancy of the stream group by the "
+    "model.",
+    "model_name", "stream_group");
+
+auto* gpu_run_wait_micros = ShardedCounter<2>::New(
+    "/tensorflow/serving/gpu/run_wait_micros",
+    "The time (in microseconds) the session runs of the model waited for the "
+    "cap on the concurrent runs of its GPU stream group.",
+    "model_name", "stream_group");
+
 // Extracts the signatures from 'bundle'.
 std::vector<SignatureDef> GetSignatureDefs(const SavedModelBundle& bundle) {
   std::vector<SignatureDef> signature_defs;
@@ -54,7 +98,9 @@ const char kTfLiteModelFilename[] = "model.tflite";
 
 Status LoadTfLiteModel(const string& model_dir, SavedModelBundle* bundle,
                        const SessionOptions& options, int num_interpreter_pools,
-                       int num_interpreters_per_pool) {
+                       int num_interpreters_per_pool,
+                       const TfLiteDelegateConfig& delegate_config,
+                       const std::vector<int>& specialized_batch_sizes) {
   std::unique_ptr<TfLiteSession> session;
 
   const string& fname = io::JoinPath(model_dir, kTfLiteModelFilename);
@@ -72,7 +118,8 @@ Status LoadTfLiteModel(const string& model_dir, SavedModelBundle* bundle,
   std::unique_ptr<TfLiteSession> tflite_session;
   TF_RETURN_IF_ERROR(TfLiteSession::Create(
       std::move(model_bytes), options, num_interpreter_pools,
-      num_interpreters_per_pool, &tflite_session,
+      num_interpreters_per_pool, delegate_config, specialized_batch_sizes,
+      &tflite_session,
       bundle->meta_graph_def.mutable_signature_def()));
   bundle->session = std::move(tflite_session);
   return OkStatus();
@@ -83,24 +130,366 @@ bool TfLiteModelFound(const string& model_dir) {
   return Env::Default()->FilesExist({fname}, nullptr);
 }
 
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but with the
+// nodes of its graph that have no device assigned placed on GPU 'gpu'. Ops
+// without GPU kernels fall back to the CPU.
+Status LoadSavedModelOnGpu(const SessionOptions& session_options,
+                           const RunOptions& run_options,
+                           const string& export_dir,
+                           const std::unordered_set<string>& tags, int gpu,
+                           SavedModelBundle* bundle) {
+  TF_RETURN_IF_ERROR(ReadMetaGraphDefFromSavedModel(export_dir, tags,
+                                                    &bundle->meta_graph_def));
+  graph::SetDefaultDevice(absl::StrCat("/device:GPU:", gpu),
+                          bundle->meta_graph_def.mutable_graph_def());
+  SessionOptions placed_session_options = session_options;
+  placed_session_options.config.set_allow_soft_placement(true);
+  TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(
+      placed_session_options, bundle->meta_graph_def, &bundle->session));
+  return RestoreSession(run_options, bundle->meta_graph_def, export_dir,
+                        &bundle->session);
+}
+
+// Loads the SavedModel at 'export_dir' like LoadSavedModel(), but in steps
+// that are each timed as a phase of the load profile: reading the metagraph,
+// importing the graph into a new session, restoring the variables and running
+// the init op.
+Status LoadSavedModelInPhases(const SessionOptions& session_options,
+                              const RunOptions& run_options,
+                              const string& export_dir,
+                              const std::unordered_set<string>& tags,
+                              SavedModelBundle* bundle) {
+  MetaGraphDef& meta_graph_def = bundle->meta_graph_def;
+  {
+    ScopedLoadPhase phase("read_meta_graph");
+    TF_RETURN_IF_ERROR(
+        ReadMetaGraphDefFromSavedModel(export_dir, tags, &meta_graph_def));
+  }
+  {
+    ScopedLoadPhase phase("create_session");
+    TF_RETURN_IF_ERROR(LoadMetagraphIntoSession(session_options,
+                                                meta_graph_def,
+                                                &bundle->session));
+  }
+  const string variables_prefix = io::JoinPath(
+      export_dir, kSavedModelVariablesDirectory, kSavedModelVariablesFilename);
+  if (meta_graph_def.has_saver_def() &&
+      Env::Default()->FileExists(MetaFilename(variables_prefix)).ok()) {
+    ScopedLoadPhase phase("restore");
+    std::vector<AssetFileDef> asset_file_defs;
+    TF_RETURN_IF_ERROR(
+        internal::GetAssetFileDefs(meta_graph_def, &asset_file_defs));
+    std::vector<std::pair<string, Tensor>> feeds;
+    for (const AssetFileDef& asset_file_def : asset_file_defs) {
+      Tensor asset_path(DT_STRING, TensorShape({}));
+      asset_path.scalar<tstring>()() = io::JoinPath(
+          export_dir, kSavedModelAssetsDirectory, asset_file_def.filename());
+      feeds.push_back({asset_file_def.tensor_info().name(), asset_path});
+    }
+    Tensor prefix_tensor(DT_STRING, TensorShape({}));
+    prefix_tensor.scalar<tstring>()() = variables_prefix;
+    feeds.push_back(
+        {meta_graph_def.saver_def().filename_tensor_name(), prefix_tensor});
+    std::vector<Tensor> unused_outputs;
+    TF_RETURN_IF_ERROR(bundle->session->Run(
+        run_options, feeds, {}, {meta_graph_def.saver_def().restore_op_name()},
+        &unused_outputs, nullptr));
+  }
+  // Runs the init op, but does not restore the variables again.
+  ScopedLoadPhase phase("init_op");
+  std::unique_ptr<SaverDef> saver_def(meta_graph_def.release_saver_def());
+  const Status status =
+      RestoreSession(run_options, meta_graph_def, export_dir, &bundle->session);
+  meta_graph_def.set_allocated_saver_def(saver_def.release());
+  return status;
+}
+
+// Returns whether 'session' has a GPU device to run its ops on.
+bool HasGpuDevice(Session* session) {
+  std::vector<DeviceAttributes> devices;
+  if (!session->ListDevices(&devices).ok()) {
+    return false;
+  }
+  for (const DeviceAttributes& device : devices) {
+    if (device.device_type() == DEVICE_GPU) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Splits each GPU of 'placement_config' into its stream groups, as virtual
+// devices of equal memory, in 'config'. A no-op unless
+// 'stream_groups_per_gpu' is greater than 1.
+void AddGpuStreamGroups(const GpuPlacementConfig& placement_config,
+                        ConfigProto* config) {
+  const int stream_groups = placement_config.stream_groups_per_gpu();
+  if (stream_groups <= 1) {
+    return;
+  }
+  GPUOptions::Experimental* experimental =
+      config->mutable_gpu_options()->mutable_experimental();
+  experimental->clear_virtual_devices();
+  for (const uint64_t memory_bytes : placement_config.gpu_memory_bytes()) {
+    GPUOptions::Experimental::VirtualDevices* virtual_devices =
+        experimental->add_virtual_devices();
+    for (int i = 0; i < stream_groups; ++i) {
+      virtual_devices->add_memory_limit_mb(
+          static_cast<float>(memory_bytes / stream_groups) / (1 << 20));
+    }
+  }
+}
+
+// A session placed on a GPU by a GpuPlacer, which holds the placement, counts
+// the calls to Run() towards the load of the GPU, and brackets the runs with
+// Placement::BeginRun() and EndRun() to cap them and measure the occupancy of
+// the GPU.
+class GpuPlacedSession : public ServingSessionWrapper {
+ public:
+  GpuPlacedSession(std::unique_ptr<Session> wrapped,
+                   std::unique_ptr<GpuPlacer::Placement> placement,
+                   const string& model_name)
+      : ServingSessionWrapper(std::move(wrapped)),
+        placement_(std::move(placement)),
+        busy_micros_(gpu_busy_micros->GetCell(
+            model_name, absl::StrCat(placement_->gpu()))),
+        run_wait_micros_(gpu_run_wait_micros->GetCell(
+            model_name, absl::StrCat(placement_->gpu()))) {}
+
+  ~GpuPlacedSession() override = default;
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    placement_->RecordRequest();
+    BeginRun();
+    const Status status = ServingSessionWrapper::Run(
+        inputs, output_tensor_names, target_node_names, outputs);
+    EndRun();
+    return status;
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    placement_->RecordRequest();
+    BeginRun();
+    const Status status =
+        ServingSessionWrapper::Run(run_options, inputs, output_tensor_names,
+                                   target_node_names, outputs, run_metadata);
+    EndRun();
+    return status;
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    placement_->RecordRequest();
+    BeginRun();
+    const Status status = ServingSessionWrapper::Run(
+        run_options, inputs, output_tensor_names, target_node_names, outputs,
+        run_metadata, thread_pool_options);
+    EndRun();
+    return status;
+  }
+
+  void RunAsync(const RunOptions& run_options,
+                const std::vector<std::pair<string, Tensor>>& inputs,
+                const std::vector<string>& output_tensor_names,
+                const std::vector<string>& target_node_names,
+                std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+                std::function<void(const Status&)> done) override {
+    placement_->RecordRequest();
+    BeginRun();
+    ServingSessionWrapper::RunAsync(
+        run_options, inputs, output_tensor_names, target_node_names, outputs,
+        run_metadata, [this, done = std::move(done)](const Status& status) {
+          EndRun();
+          done(status);
+        });
+  }
+
+ private:
+  void BeginRun() {
+    const uint64_t start_micros = Env::Default()->NowMicros();
+    placement_->BeginRun();
+    run_wait_micros_->IncrementBy(Env::Default()->NowMicros() - start_micros);
+  }
+
+  void EndRun() { busy_micros_->IncrementBy(placement_->EndRun()); }
+
+  const std::unique_ptr<GpuPlacer::Placement> placement_;
+  ShardedCounterCell* const busy_micros_;
+  ShardedCounterCell* const run_wait_micros_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuPlacedSession);
+};
+
+// A session that calls 'on_destroy' before its wrapped session is destroyed.
+class DeltaBaseSession : public ServingSessionWrapper {
+ public:
+  DeltaBaseSession(std::unique_ptr<Session> wrapped,
+                   std::function<void()> on_destroy)
+      : ServingSessionWrapper(std::move(wrapped)),
+        on_destroy_(std::move(on_destroy)) {}
+
+  ~DeltaBaseSession() override { on_destroy_(); }
+
+ private:
+  const std::function<void()> on_destroy_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DeltaBaseSession);
+};
+
 }  // namespace
 
 Status SavedModelBundleFactory::Create(
     const SessionBundleConfig& config,
     std::unique_ptr<SavedModelBundleFactory>* factory) {
+  if (config.enable_cost_accounting() && !config.enable_session_metadata()) {
+    return errors::InvalidArgument(
+        "enable_cost_accounting requires enable_session_metadata");
+  }
+  // Each of these selects how a SavedModel is loaded, and only the first one
+  // set would apply.
+  std::vector<string> load_modes;
+  if (config.gpu_placement_config().gpu_memory_bytes_size() > 0) {
+    load_modes.push_back("gpu_placement_config");
+  }
+  if (!config.memmapped_variables_dir().empty()) {
+    load_modes.push_back("memmapped_variables_dir");
+  }
+  if (config.share_identical_variables()) {
+    load_modes.push_back("share_identical_variables");
+  }
+  if (config.freeze_read_only_variables()) {
+    load_modes.push_back("freeze_read_only_variables");
+  }
+  if (config.num_parallel_restore_threads() > 1 ||
+      config.overlap_init_op_with_restore()) {
+    load_modes.push_back(
+        "num_parallel_restore_threads or overlap_init_op_with_restore");
+  }
+  if (config.enable_prebuilt_lookup_tables()) {
+    load_modes.push_back("enable_prebuilt_lookup_tables");
+  }
+  if (HasGraphTransforms(config.graph_transforms())) {
+    load_modes.push_back("graph_transforms");
+  }
+  if (load_modes.size() > 1) {
+    return errors::InvalidArgument(
+        "At most one SavedModel load mode can be enabled; got ",
+        absl::StrJoin(load_modes, ", "));
+  }
   std::shared_ptr<Batcher> batcher;
+  std::vector<std::shared_ptr<Batcher>> numa_batchers;
+  std::shared_ptr<WeightedFairBatchGate> fair_batch_gate;
   if (config.has_batching_parameters()) {
+    const int num_numa_nodes = port::NUMANumNodes();
+    if (config.batching_parameters().enable_numa_aware_batching() &&
+        num_numa_nodes > 1) {
+      LOG(INFO) << "Pinning batch threads to " << num_numa_nodes
+                << " NUMA nodes";
+      TF_RETURN_IF_ERROR(CreateNumaBatchSchedulers(
+          config.batching_parameters(), num_numa_nodes, &numa_batchers));
+      ProcessState::singleton()->EnableNUMA();
+    } else {
+      TF_RETURN_IF_ERROR(
+          CreateBatchScheduler(config.batching_parameters(), &batcher));
+    }
     TF_RETURN_IF_ERROR(
-        CreateBatchScheduler(config.batching_parameters(), &batcher));
+        CreateFairBatchGate(config.batching_parameters(), &fair_batch_gate));
+  }
+  std::unique_ptr<ResourceMeasurer> resource_measurer;
+  if (config.measure_resources_after_load()) {
+    TF_RETURN_IF_ERROR(ResourceMeasurer::Create(
+        config.resource_measurement_history_path(), &resource_measurer));
+  }
+  std::shared_ptr<GpuPlacer> gpu_placer;
+  if (config.gpu_placement_config().gpu_memory_bytes_size() > 0) {
+    const GpuPlacementConfig& placement_config = config.gpu_placement_config();
+    GpuPlacer::Options placer_options;
+    // With stream groups, the placer places on the virtual devices, which are
+    // numbered by GPU and then by stream group.
+    const int stream_groups =
+        std::max<int>(1, placement_config.stream_groups_per_gpu());
+    for (const uint64_t memory_bytes : placement_config.gpu_memory_bytes()) {
+      for (int i = 0; i < stream_groups; ++i) {
+        placer_options.gpu_memory_bytes.push_back(memory_bytes /
+                                                  stream_groups);
+      }
+    }
+    placer_options.max_concurrent_runs =
+        placement_config.max_concurrent_runs_per_stream_group();
+    if (placement_config.has_load_balance_weight()) {
+      placer_options.load_balance_weight =
+          placement_config.load_balance_weight().value();
+    }
+    TF_RETURN_IF_ERROR(GpuPlacer::Create(placer_options, &gpu_placer));
   }
-  factory->reset(new SavedModelBundleFactory(config, batcher));
+  factory->reset(new SavedModelBundleFactory(
+      config, batcher, std::move(numa_batchers), fair_batch_gate,
+      std::move(resource_measurer), std::move(gpu_placer)));
   return OkStatus();
 }
 
 Status SavedModelBundleFactory::EstimateResourceRequirement(
     const string& path, ResourceAllocation* estimate) const {
-  return EstimateResourceFromPath(
-      path, config_.resource_estimation_uses_validation_result(), estimate);
+  // A delta takes as much memory as its base, which its files do not show.
+  string estimate_path = path;
+  if (config_.enable_delta_loading()) {
+    string base_path;
+    TF_RETURN_IF_ERROR(GetDeltaBasePath(path, &base_path));
+    if (!base_path.empty() && Env::Default()->IsDirectory(base_path).ok()) {
+      estimate_path = base_path;
+    }
+  }
+  TF_RETURN_IF_ERROR(EstimateResourceFromPath(
+      estimate_path, config_.resource_estimation_uses_validation_result(),
+      estimate));
+  if (resource_measurer_ != nullptr) {
+    resource_measurer_->AdjustEstimate(path, estimate);
+  }
+  return OkStatus();
+}
+
+std::unique_ptr<ResourceMeasurer::Load>
+SavedModelBundleFactory::StartResourceMeasurement() {
+  if (resource_measurer_ == nullptr) {
+    return nullptr;
+  }
+  return resource_measurer_->StartLoad();
+}
+
+Status SavedModelBundleFactory::FinishResourceMeasurement(
+    std::unique_ptr<ResourceMeasurer::Load> measurement, const string& path,
+    ResourceAllocation* estimate) {
+  if (resource_measurer_ == nullptr || measurement == nullptr) {
+    return errors::FailedPrecondition("Resources are not being measured");
+  }
+  // The measurement relates to the estimate from the disk state, not to an
+  // estimate that was already adjusted by earlier measurements.
+  ResourceAllocation disk_estimate;
+  TF_RETURN_IF_ERROR(EstimateResourceFromPath(
+      path, config_.resource_estimation_uses_validation_result(),
+      &disk_estimate));
+  ResourceAllocation measured;
+  TF_RETURN_IF_ERROR(resource_measurer_->FinishLoad(
+      std::move(measurement), path, disk_estimate, &measured));
+  estimate->Clear();
+  for (const ResourceAllocation::Entry& entry :
+       measured.resource_quantities()) {
+    if (entry.resource().device() == device_types::kMain) {
+      *estimate->add_resource_quantities() = entry;
+    }
+  }
+  return OkStatus();
 }
 
 Status SavedModelBundleFactory::CreateSavedModelBundleWithMetadata(
@@ -117,6 +506,7 @@ Status SavedModelBundleFactory::CreateSavedModelBundle(
 Status SavedModelBundleFactory::InternalCreateSavedModelBundle(
     const absl::optional<Loader::Metadata>& metadata, const string& path,
     std::unique_ptr<SavedModelBundle>* bundle) {
+  ScopedLoadPhase create_phase("create_bundle");
   bundle->reset(new SavedModelBundle);
   std::unordered_set<string> saved_model_tags(
       config_.saved_model_tags().begin(), config_.saved_model_tags().end());
@@ -125,10 +515,26 @@ Status SavedModelBundleFactory::InternalCreateSavedModelBundle(
   if (saved_model_tags.empty()) {
     saved_model_tags.insert(kSavedModelTagServe);
   }
+  GraphTransformConfig graph_transforms = config_.graph_transforms();
+  EmbeddingCacheConfig embedding_cache = config_.embedding_cache();
+  if (config_.enable_saved_model_config()) {
+    absl::StatusOr<SavedModelConfig> saved_model_config =
+        LoadSavedModelConfigOrDefault(path);
+    TF_RETURN_IF_ERROR(saved_model_config.status());
+    if (saved_model_config->has_graph_transforms()) {
+      graph_transforms = saved_model_config->graph_transforms();
+    }
+    if (saved_model_config->has_embedding_cache()) {
+      embedding_cache = saved_model_config->embedding_cache();
+    }
+  }
   const auto& session_options = [&]() {
     auto result = GetSessionOptions(config_);
+    // The virtual devices must be the same for every session in the process.
+    AddGpuStreamGroups(config_.gpu_placement_config(), &result.config);
     string mixed_precision_value = config_.mixed_precision();
-    if (!mixed_precision_value.empty()) {
+    if (!mixed_precision_value.empty() &&
+        graph_transforms.mixed_precision().empty()) {
       if (mixed_precision_value == "bfloat16") {
         LOG(INFO) << "Running inference with bfloat16 auto mixed precision";
         tensorflow::ConfigProto& config = result.config;
@@ -150,20 +556,115 @@ Status SavedModelBundleFactory::InternalCreateSavedModelBundle(
     return result;
   }();
 
+  string delta_base_path;
+  if (config_.enable_delta_loading()) {
+    TF_RETURN_IF_ERROR(GetDeltaBasePath(path, &delta_base_path));
+  }
+
+  std::unique_ptr<GpuPlacer::Placement> placement;
   bool is_tflite = config_.prefer_tflite_model() && TfLiteModelFound(path);
   if (is_tflite) {
     int num_tflite_pools = config_.num_tflite_pools();
     if (num_tflite_pools == 0 && config_.num_tflite_interpreters() > 0) {
       num_tflite_pools = config_.num_tflite_interpreters();
     }
+    // Batches only come in the allowed batch sizes.
+    std::vector<int> specialized_batch_sizes;
+    if (config_.specialize_tflite_interpreters_by_batch_size() &&
+        config_.has_batching_parameters()) {
+      absl::optional<BatchingParameters> batching_params;
+      TF_RETURN_IF_ERROR(GetPerModelBatchingParams(
+          path, config_.batching_parameters(),
+          config_.enable_per_model_batching_params(), &batching_params));
+      if (batching_params.has_value()) {
+        specialized_batch_sizes.assign(
+            batching_params->allowed_batch_sizes().begin(),
+            batching_params->allowed_batch_sizes().end());
+      }
+    }
     TF_RETURN_IF_ERROR(LoadTfLiteModel(
         path, bundle->get(), session_options, num_tflite_pools,
-        config_.num_tflite_interpreters_per_pool()));
+        config_.num_tflite_interpreters_per_pool(),
+        config_.tflite_delegate_config(), specialized_batch_sizes));
+  } else if (!delta_base_path.empty()) {
+    TF_RETURN_IF_ERROR(LoadDeltaBundle(session_options, saved_model_tags, path,
+                                       delta_base_path, bundle->get()));
+  } else if (gpu_placer_ != nullptr) {
+    // The GPU memory the model needs is taken to be its RAM estimate.
+    ResourceAllocation estimate;
+    TF_RETURN_IF_ERROR(EstimateResourceRequirement(path, &estimate));
+    uint64_t memory_bytes = 0;
+    for (const ResourceAllocation::Entry& entry :
+         estimate.resource_quantities()) {
+      if (entry.resource().device() == device_types::kMain &&
+          entry.resource().kind() == resource_kinds::kRamBytes) {
+        memory_bytes += entry.quantity();
+      }
+    }
+    TF_RETURN_IF_ERROR(
+        gpu_placer_->Place(path, io::Dirname(path), memory_bytes, &placement));
+    TF_RETURN_IF_ERROR(LoadSavedModelOnGpu(
+        session_options, GetRunOptions(config_), path, saved_model_tags,
+        placement->gpu(), bundle->get()));
+  } else if (!config_.memmapped_variables_dir().empty()) {
+    TF_RETURN_IF_ERROR(LoadSavedModelWithMemmappedVariables(
+        session_options, GetRunOptions(config_), path, saved_model_tags,
+        config_.memmapped_variables_dir(), embedding_cache, bundle->get()));
+  } else if (config_.share_identical_variables() &&
+             MaybeSavedModelDirectory(path)) {
+    TF_RETURN_IF_ERROR(LoadSavedModelWithSharedVariables(
+        session_options, GetRunOptions(config_), path, saved_model_tags,
+        bundle->get()));
+  } else if (config_.freeze_read_only_variables() &&
+             MaybeSavedModelDirectory(path)) {
+    TF_RETURN_IF_ERROR(LoadSavedModelWithFrozenVariables(
+        session_options, GetRunOptions(config_), path, saved_model_tags,
+        bundle->get()));
+  } else if ((config_.num_parallel_restore_threads() > 1 ||
+              config_.overlap_init_op_with_restore()) &&
+             MaybeSavedModelDirectory(path)) {
+    TF_RETURN_IF_ERROR(LoadSavedModelWithParallelRestore(
+        session_options, GetRunOptions(config_), path, saved_model_tags,
+        std::max(1, config_.num_parallel_restore_threads()),
+        config_.overlap_init_op_with_restore(), bundle->get()));
+  } else if (config_.enable_prebuilt_lookup_tables() &&
+             MaybeSavedModelDirectory(path)) {
+    TF_RETURN_IF_ERROR(LoadSavedModelWithPrebuiltLookupTables(
+        session_options, GetRunOptions(config_), path, saved_model_tags,
+        bundle->get()));
+  } else if (HasGraphTransforms(graph_transforms) &&
+             MaybeSavedModelDirectory(path)) {
+    TF_RETURN_IF_ERROR(LoadSavedModelWithGraphTransforms(
+        session_options, GetRunOptions(config_), path, saved_model_tags,
+        graph_transforms, bundle->get()));
+  } else if (!config_.enable_saved_model_config() &&
+             MaybeSavedModelDirectory(path)) {
+    TF_RETURN_IF_ERROR(LoadSavedModelInPhases(session_options,
+                                              GetRunOptions(config_), path,
+                                              saved_model_tags, bundle->get()));
   } else {
     TF_RETURN_IF_ERROR(session_bundle::LoadSessionBundleOrSavedModelBundle(
         session_options, GetRunOptions(config_), path, saved_model_tags,
         config_.enable_saved_model_config(), bundle->get()));
   }
+  if (resource_measurer_ != nullptr && !is_tflite) {
+    resource_measurer_->AddSessionAllocators((*bundle)->session.get());
+  }
+  AccountSessionAllocators((*bundle)->session.get());
+  // The saver of the graph is needed to copy the variables into deltas.
+  DeltaBase delta_base = {(*bundle)->session.get(), {}};
+  if (config_.enable_delta_loading() && !is_tflite) {
+    TF_RETURN_IF_ERROR(
+        GetSavedTensors((*bundle)->meta_graph_def, &delta_base.tensor_by_key));
+  }
+  // Read before the graph is dropped below, for the TPU batching profile and
+  // inline runs.
+  const std::vector<int64_t> compiled_batch_sizes =
+      config_.has_batching_parameters()
+          ? GetCompiledBatchSizes((*bundle)->meta_graph_def)
+          : std::vector<int64_t>();
+  const int64_t num_graph_nodes =
+      is_tflite ? -1 : CountGraphNodes((*bundle)->meta_graph_def);
   if (config_.remove_unused_fields_from_bundle_metagraph()) {
     // Save memory by removing fields in MetaGraphDef proto message stored
     // in the bundle that we never use. Notably the unused graphdef submessage
@@ -176,28 +677,169 @@ Status SavedModelBundleFactory::InternalCreateSavedModelBundle(
     (*bundle)->meta_graph_def.mutable_signature_def()->swap(
         *metagraph.mutable_signature_def());
   }
+  // Innermost, to be on the threads that run the session, e.g. the batch
+  // threads.
+  if (config_.enable_cost_accounting() && metadata.has_value()) {
+    (*bundle)->session.reset(new CostAccountingSession(
+        std::move((*bundle)->session), metadata->servable_id,
+        config_.cost_accounting_trace_interval()));
+  }
+  TF_RETURN_IF_ERROR(WrapBundleSession(metadata, path, compiled_batch_sizes,
+                                       num_graph_nodes, bundle->get()));
+  if (placement != nullptr) {
+    const string model_name = metadata.has_value()
+                                  ? metadata->servable_id.name
+                                  : io::Basename(io::Dirname(path));
+    (*bundle)->session.reset(new GpuPlacedSession(
+        std::move((*bundle)->session), std::move(placement), model_name));
+  }
+  // Outermost, to tokenize on the threads of the requests, before they wait
+  // for their batch or GPU.
+  TF_RETURN_IF_ERROR(WrapSessionForTokenization(
+      path, GetSignatureDefs(**bundle), &(*bundle)->session));
+  if (config_.enable_delta_loading() && !is_tflite) {
+    RegisterDeltaBase(path, std::move(delta_base), bundle->get());
+  }
+  return OkStatus();
+}
+
+Status SavedModelBundleFactory::GetDeltaBasePath(const string& path,
+                                                 string* base_path) const {
+  base_path->clear();
+  DeltaManifest manifest;
+  bool found;
+  TF_RETURN_IF_ERROR(ReadDeltaManifest(path, &manifest, &found));
+  if (found) {
+    // Versions are sibling directories named by their version numbers.
+    *base_path =
+        io::JoinPath(io::Dirname(path), absl::StrCat(manifest.base_version()));
+  }
+  return OkStatus();
+}
+
+Status SavedModelBundleFactory::LoadDeltaBundle(
+    const SessionOptions& session_options,
+    const std::unordered_set<string>& tags, const string& path,
+    const string& base_path, SavedModelBundle* bundle) {
+  // Holding the lock keeps the base version from being destroyed while it is
+  // read.
+  mutex_lock l(delta_bases_mu_);
+  auto base = delta_bases_.find(base_path);
+  if (base == delta_bases_.end()) {
+    return errors::FailedPrecondition(
+        "The base version ", base_path, " of delta SavedModel ", path,
+        " is not loaded; deltas can only be loaded while their base is");
+  }
+  return LoadDeltaSavedModel(session_options, GetRunOptions(config_), path,
+                             tags, base->second.session,
+                             base->second.tensor_by_key, bundle);
+}
+
+void SavedModelBundleFactory::RegisterDeltaBase(const string& path,
+                                                DeltaBase base,
+                                                SavedModelBundle* bundle) {
+  Session* const session = base.session;
+  {
+    mutex_lock l(delta_bases_mu_);
+    delta_bases_[path] = std::move(base);
+  }
+  bundle->session.reset(new DeltaBaseSession(
+      std::move(bundle->session), [this, path, session]() {
+        mutex_lock l(delta_bases_mu_);
+        auto it = delta_bases_.find(path);
+        if (it != delta_bases_.end() && it->second.session == session) {
+          delta_bases_.erase(it);
+        }
+      }));
+}
+
+Status SavedModelBundleFactory::WrapBundleSession(
+    const absl::optional<Loader::Metadata>& metadata, const string& path,
+    const std::vector<int64_t>& compiled_batch_sizes, int64_t num_graph_nodes,
+    SavedModelBundle* bundle) {
   if (config_.wrap_session_with_no_threading_params()) {
-    return WrapSessionIgnoreThreadPoolOptions(&(*bundle)->session);
+    return WrapSessionIgnoreThreadPoolOptions(&bundle->session);
   } else if (config_.has_batching_parameters()) {
     absl::optional<BatchingParameters> batching_params;
     TF_RETURN_IF_ERROR(GetPerModelBatchingParams(
         path, config_.batching_parameters(),
         config_.enable_per_model_batching_params(), &batching_params));
     if (batching_params.has_value()) {
+      ApplyTpuBatchingProfile(compiled_batch_sizes, &batching_params.value());
       // Enable batching of requests to any one signature_def in the SavedModel.
       // Note that in the future, the plan is to enable explicit configuration
       // of the one or many SignatureDefs to enable.
-      const std::vector<SignatureDef> signatures = GetSignatureDefs(**bundle);
+      const std::vector<SignatureDef> signatures = GetSignatureDefs(*bundle);
+      const string queue_name =
+          metadata.has_value() ? metadata->servable_id.name : path;
+      const bool pin_batch_inputs =
+          batching_params->pin_batch_inputs_for_gpu() &&
+          HasGpuDevice(bundle->session.get());
+      if (!numa_batch_schedulers_.empty()) {
+        const int numa_node = GetNumaNode(queue_name);
+        Allocator* const batch_input_allocator =
+            pin_batch_inputs
+                ? GPUProcessState::singleton()->GetGpuHostAllocator(
+                      GetSessionOptions(config_).config.gpu_options(),
+                      numa_node)
+                : ProcessState::singleton()->GetCPUAllocator(numa_node);
+        return WrapSessionForBatching(
+            batching_params.value(), numa_batch_schedulers_[numa_node],
+            fair_batch_gate_, queue_name, batch_input_allocator, signatures,
+            &bundle->session);
+      }
+      if (pin_batch_inputs) {
+        return WrapSessionForBatching(
+            batching_params.value(), batch_scheduler_, fair_batch_gate_,
+            queue_name,
+            GPUProcessState::singleton()->GetGpuHostAllocator(
+                GetSessionOptions(config_).config.gpu_options(),
+                /*numa_node=*/0),
+            signatures, &bundle->session);
+      }
       return WrapSessionForBatching(batching_params.value(), batch_scheduler_,
-                                    signatures, &(*bundle)->session);
+                                    fair_batch_gate_, queue_name, signatures,
+                                    &bundle->session);
     }
   }
-  return WrapSession(&(*bundle)->session);
+  if (config_.inline_run_max_graph_nodes() > 0 && num_graph_nodes >= 0 &&
+      num_graph_nodes <= config_.inline_run_max_graph_nodes() &&
+      !HasGpuDevice(bundle->session.get())) {
+    VLOG(1) << "Running the " << num_graph_nodes << " graph nodes of " << path
+            << " on the threads of its requests";
+    return WrapSessionForInlineRuns(&bundle->session);
+  }
+  return WrapSession(&bundle->session);
+}
+
+int SavedModelBundleFactory::GetNumaNode(const string& model_name) {
+  mutex_lock l(numa_mu_);
+  auto it = numa_node_by_model_.find(model_name);
+  if (it != numa_node_by_model_.end()) {
+    return it->second;
+  }
+  const int numa_node =
+      std::min_element(num_models_by_numa_node_.begin(),
+                       num_models_by_numa_node_.end()) -
+      num_models_by_numa_node_.begin();
+  ++num_models_by_numa_node_[numa_node];
+  numa_node_by_model_[model_name] = numa_node;
+  return numa_node;
 }
 
 SavedModelBundleFactory::SavedModelBundleFactory(
-    const SessionBundleConfig& config, std::shared_ptr<Batcher> batch_scheduler)
-    : config_(config), batch_scheduler_(batch_scheduler) {}
+    const SessionBundleConfig& config, std::shared_ptr<Batcher> batch_scheduler,
+    std::vector<std::shared_ptr<Batcher>> numa_batch_schedulers,
+    std::shared_ptr<WeightedFairBatchGate> fair_batch_gate,
+    std::unique_ptr<ResourceMeasurer> resource_measurer,
+    std::shared_ptr<GpuPlacer> gpu_placer)
+    : config_(config),
+      batch_scheduler_(batch_scheduler),
+      numa_batch_schedulers_(std::move(numa_batch_schedulers)),
+      num_models_by_numa_node_(numa_batch_schedulers_.size(), 0),
+      fair_batch_gate_(std::move(fair_batch_gate)),
+      resource_measurer_(std::move(resource_measurer)),
+      gpu_placer_(std::move(gpu_placer)) {}
 
 }  // namespace serving
 }  // namespace tensorflow
@@ -16,14 +16,26 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SAVED_MODEL_BUNDLE_FACTORY_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SAVED_MODEL_BUNDLE_FACTORY_H_
 
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
 #include "absl/types/optional.h"
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/public/session_options.h"
 #include "tensorflow_serving/batching/batching_session.h"
+#include "tensorflow_serving/batching/weighted_fair_batch_gate.h"
 #include "tensorflow_serving/core/loader.h"
+#include "tensorflow_serving/resources/gpu_placer.h"
 #include "tensorflow_serving/resources/resources.pb.h"
+#include "tensorflow_serving/servables/tensorflow/resource_measurer.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 
 namespace tensorflow {
@@ -46,7 +58,15 @@ namespace serving {
 ///
 /// The factory can also estimate the resource (e.g. RAM) requirements of a
 /// SavedModelBundle based on the SavedModel (i.e. prior to loading the
-/// session).
+/// session), and, if the config calls for it, measure them once it is loaded.
+///
+/// If the config has a GpuPlacementConfig, each SavedModel is placed on one of
+/// the GPUs of the host, or on one of their stream groups, by a GpuPlacer owned
+/// by the factory, which also caps the concurrent runs on each.
+///
+/// If 'enable_delta_loading' is set, SavedModels that are deltas on versions
+/// loaded by the factory (see DeltaManifest) copy their unchanged variables
+/// from the loaded versions.
 ///
 /// This class is thread-safe.
 class SavedModelBundleFactory {
@@ -86,25 +106,114 @@ class SavedModelBundleFactory {
   Status EstimateResourceRequirement(const string& path,
                                      ResourceAllocation* estimate) const;
 
+  /// If 'measure_resources_after_load' is set in the config, starts measuring
+  /// the resources of a bundle that is about to be created. Returns null
+  /// otherwise.
+  std::unique_ptr<ResourceMeasurer::Load> StartResourceMeasurement();
+
+  /// Finishes 'measurement', started before the bundle at 'path' was created,
+  /// and sets 'estimate' to the resources the bundle was measured to take.
+  /// Only main memory is reported, since that is all the resource trackers of
+  /// the model server know; the measurements of GPU memory are only recorded
+  /// in the history of the measurer.
+  ///
+  /// @param measurement  Returned by StartResourceMeasurement().
+  /// @param path         Path to the model.
+  /// @param estimate     Output measured resource usage.
+  Status FinishResourceMeasurement(
+      std::unique_ptr<ResourceMeasurer::Load> measurement, const string& path,
+      ResourceAllocation* estimate);
+
   const SessionBundleConfig& config() const { return config_; }
   SessionBundleConfig& mutable_config() { return config_; }
 
  private:
   using Batcher = SharedBatchScheduler<BatchingSessionTask>;
 
-  SavedModelBundleFactory(const SessionBundleConfig& config,
-                          std::shared_ptr<Batcher> batch_scheduler);
+  // A loaded SavedModel, which later versions can be deltas on.
+  struct DeltaBase {
+    // The unwrapped session of the SavedModel.
+    Session* session;
+    // The tensors its variables are saved from, by checkpoint key.
+    std::map<string, string> tensor_by_key;
+  };
+
+  SavedModelBundleFactory(
+      const SessionBundleConfig& config,
+      std::shared_ptr<Batcher> batch_scheduler,
+      std::vector<std::shared_ptr<Batcher>> numa_batch_schedulers,
+      std::shared_ptr<WeightedFairBatchGate> fair_batch_gate,
+      std::unique_ptr<ResourceMeasurer> resource_measurer,
+      std::shared_ptr<GpuPlacer> gpu_placer);
+
+  // Returns the NUMA node of the model named 'model_name'. Assigns the node
+  // with the fewest models to models that do not have one yet.
+  int GetNumaNode(const string& model_name) TF_LOCKS_EXCLUDED(numa_mu_);
 
   Status InternalCreateSavedModelBundle(
       const absl::optional<Loader::Metadata>& metadata, const string& path,
       std::unique_ptr<SavedModelBundle>* bundle);
 
+  // Wraps the session of the newly loaded 'bundle', e.g. for batching, with
+  // the batch sizes its model was compiled for (see GetCompiledBatchSizes())
+  // and the number of nodes of its graph (-1 if unknown).
+  Status WrapBundleSession(const absl::optional<Loader::Metadata>& metadata,
+                           const string& path,
+                           const std::vector<int64_t>& compiled_batch_sizes,
+                           int64_t num_graph_nodes, SavedModelBundle* bundle);
+
+  // If the SavedModel at 'path' is a delta, sets 'base_path' to the path of
+  // its base version. Clears it otherwise.
+  Status GetDeltaBasePath(const string& path, string* base_path) const;
+
+  // Loads the delta SavedModel at 'path' from its loaded base version at
+  // 'base_path'.
+  Status LoadDeltaBundle(const SessionOptions& session_options,
+                         const std::unordered_set<string>& tags,
+                         const string& path, const string& base_path,
+                         SavedModelBundle* bundle)
+      TF_LOCKS_EXCLUDED(delta_bases_mu_);
+
+  // Registers the newly loaded 'bundle' at 'path' as 'base' for deltas, while
+  // its session lives.
+  void RegisterDeltaBase(const string& path, DeltaBase base,
+                         SavedModelBundle* bundle)
+      TF_LOCKS_EXCLUDED(delta_bases_mu_);
+
   SessionBundleConfig config_;
 
   // A shared batch scheduler. One queue is used for each session this factory
   // emits. If batching is not configured, this remains null.
   std::shared_ptr<Batcher> batch_scheduler_;
 
+  // If 'enable_numa_aware_batching' is set, one shared batch scheduler per
+  // NUMA node, whose threads are pinned to the node, in place of
+  // 'batch_scheduler_'.
+  std::vector<std::shared_ptr<Batcher>> numa_batch_schedulers_;
+
+  mutex numa_mu_;
+  // The NUMA node of each model that was loaded, and the number of models of
+  // each node.
+  std::map<string, int> numa_node_by_model_ TF_GUARDED_BY(numa_mu_);
+  std::vector<int> num_models_by_numa_node_ TF_GUARDED_BY(numa_mu_);
+
+  // Shares the batch execution slots among the sessions this factory emits.
+  // Null unless 'num_fair_share_batch_slots' is set.
+  std::shared_ptr<WeightedFairBatchGate> fair_batch_gate_;
+
+  // Measures the resources of the loaded bundles. Null unless
+  // 'measure_resources_after_load' is set.
+  std::unique_ptr<ResourceMeasurer> resource_measurer_;
+
+  // Places the SavedModels on the GPUs. Null unless the config has a
+  // GpuPlacementConfig.
+  std::shared_ptr<GpuPlacer> gpu_placer_;
+
+  mutex delta_bases_mu_;
+  // The loaded SavedModels, by path, if 'enable_delta_loading' is set. Each is
+  // removed before its session is destroyed.
+  std::map<string, DeltaBase> delta_bases_ TF_GUARDED_BY(delta_bases_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(SavedModelBundleFactory);
 };
 
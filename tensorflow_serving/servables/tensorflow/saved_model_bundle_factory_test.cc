@@ -254,6 +254,16 @@ TEST_P(SavedModelBundleFactoryTest, Batching) {
                /*batch_size=*/2);
 }
 
+TEST_P(SavedModelBundleFactoryTest, BatchingWithPinnedInputsOnCpu) {
+  // Without a GPU device, the batch inputs stay in ordinary memory.
+  TestBatching(test_util::CreateProto<BatchingParameters>(R"(
+    max_batch_size { value: 4 }
+    pin_batch_inputs_for_gpu: true)"),
+               /*enable_per_model_batching_params=*/false,
+               /*input_request_batch_size=*/2,
+               /*batch_size=*/4);
+}
+
 TEST_P(SavedModelBundleFactoryTest, PerModelBatchingParams) {
   //
   // Copy SavedModel to temp (writable) location, and add batching params.
@@ -288,6 +298,24 @@ TEST_P(SavedModelBundleFactoryTest, RunOptions) { TestRunOptions(); }
 
 TEST_P(SavedModelBundleFactoryTest, RunOptionsError) { TestRunOptionsError(); }
 
+TEST(SavedModelBundleFactoryCreateTest, RejectsSeveralLoadModes) {
+  SessionBundleConfig config;
+  config.set_share_identical_variables(true);
+  config.set_num_parallel_restore_threads(4);
+  std::unique_ptr<SavedModelBundleFactory> factory;
+  const Status status = SavedModelBundleFactory::Create(config, &factory);
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+  EXPECT_THAT(status.message(),
+              ::testing::HasSubstr("share_identical_variables"));
+}
+
+TEST(SavedModelBundleFactoryCreateTest, AcceptsOneLoadMode) {
+  SessionBundleConfig config;
+  config.set_freeze_read_only_variables(true);
+  std::unique_ptr<SavedModelBundleFactory> factory;
+  TF_EXPECT_OK(SavedModelBundleFactory::Create(config, &factory));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -15,24 +15,69 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_source_adapter.h"
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow_serving/core/load_profile.h"
 #include "tensorflow_serving/resources/resource_util.h"
 #include "tensorflow_serving/resources/resource_values.h"
 #include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/servables/tensorflow/bundle_factory_util.h"
 #include "tensorflow_serving/servables/tensorflow/file_acl.h"
 #include "tensorflow_serving/servables/tensorflow/machine_learning_metadata.h"
+#include "tensorflow_serving/servables/tensorflow/performance_gate.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_factory.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_warmup.h"
 
 namespace tensorflow {
 namespace serving {
 
+namespace {
+
+// Runs the warmup requests of the model at 'path' on 'bundle', as configured
+// by 'config'.
+Status RunWarmup(const SessionBundleConfig& config, const StoragePath& path,
+                 SavedModelBundle* bundle) {
+  ScopedLoadPhase warmup_phase("warmup");
+  ModelWarmupOptions warmup_options = config.model_warmup_options();
+  if (config.has_batching_parameters()) {
+    TF_RETURN_IF_ERROR(SetWarmupBatchSizes(
+        path, config.batching_parameters(),
+        config.enable_per_model_batching_params(), &warmup_options));
+  }
+  return RunSavedModelWarmup(warmup_options, GetRunOptions(config), path,
+                             bundle);
+}
+
+// Creates (and warms up) the bundle at 'path' with 'create_bundle'. If the
+// factory measures resources, sets 'measured_resources' to the resources the
+// bundle was measured to take, or clears it if the measurement failed.
+Status CreateMeasuredBundle(SavedModelBundleFactory* bundle_factory,
+                            const StoragePath& path,
+                            const std::function<Status()>& create_bundle,
+                            ResourceAllocation* measured_resources) {
+  std::unique_ptr<ResourceMeasurer::Load> measurement =
+      bundle_factory->StartResourceMeasurement();
+  TF_RETURN_IF_ERROR(create_bundle());
+  if (measurement != nullptr) {
+    const Status status = bundle_factory->FinishResourceMeasurement(
+        std::move(measurement), path, measured_resources);
+    if (!status.ok()) {
+      LOG(INFO) << "Falling back to the estimated resources of " << path
+                << ": " << status;
+      measured_resources->Clear();
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
 Status SavedModelBundleSourceAdapter::Create(
     const SavedModelBundleSourceAdapterConfig& config,
     std::unique_ptr<SavedModelBundleSourceAdapter>* adapter) {
@@ -47,51 +92,90 @@ SavedModelBundleSourceAdapter::~SavedModelBundleSourceAdapter() { Detach(); }
 
 SavedModelBundleSourceAdapter::SavedModelBundleSourceAdapter(
     std::unique_ptr<SavedModelBundleFactory> bundle_factory)
-    : bundle_factory_(std::move(bundle_factory)) {}
+    : bundle_factory_(std::move(bundle_factory)),
+      performance_gate_(std::make_shared<PerformanceGate>()) {}
 
 SimpleLoader<SavedModelBundle>::CreatorVariant
 SavedModelBundleSourceAdapter::GetServableCreator(
     std::shared_ptr<SavedModelBundleFactory> bundle_factory,
-    const StoragePath& path) const {
-  if (bundle_factory->config().enable_session_metadata()) {
-    return [bundle_factory, path](const Loader::Metadata& metadata,
-                                  std::unique_ptr<SavedModelBundle>* bundle) {
-      TF_RETURN_IF_ERROR(RegisterModelRoot(metadata.servable_id, path));
-      TF_RETURN_IF_ERROR(bundle_factory->CreateSavedModelBundleWithMetadata(
-          metadata, path, bundle));
-      MaybePublishMLMDStreamz(path, metadata.servable_id.name,
-                              metadata.servable_id.version);
-      if (bundle_factory->config().enable_model_warmup()) {
-        bundle_factory->mutable_config()
-            .mutable_model_warmup_options()
-            ->set_model_name(metadata.servable_id.name);
-        bundle_factory->mutable_config()
-            .mutable_model_warmup_options()
-            ->set_model_version(metadata.servable_id.version);
-        return RunSavedModelWarmup(
-            bundle_factory->config().model_warmup_options(),
-            GetRunOptions(bundle_factory->config()), path, bundle->get());
-      }
-      return OkStatus();
+    const StoragePath& path,
+    std::shared_ptr<ResourceAllocation> measured_resources) const {
+  // Replaying captured warmup requests, and comparing the performance of
+  // versions, need the name of the model, so also take the metadata.
+  if (bundle_factory->config().enable_session_metadata() ||
+      bundle_factory->config()
+          .model_warmup_options()
+          .use_captured_warmup_requests() ||
+      HasPerformanceGate(bundle_factory->config().performance_gate())) {
+    std::shared_ptr<PerformanceGate> performance_gate = performance_gate_;
+    return [bundle_factory, path, measured_resources, performance_gate](
+               const Loader::Metadata& metadata,
+               std::unique_ptr<SavedModelBundle>* bundle) {
+      return CreateMeasuredBundle(
+          bundle_factory.get(), path,
+          [&]() -> Status {
+            TF_RETURN_IF_ERROR(RegisterModelRoot(metadata.servable_id, path));
+            if (bundle_factory->config().enable_session_metadata()) {
+              TF_RETURN_IF_ERROR(
+                  bundle_factory->CreateSavedModelBundleWithMetadata(
+                      metadata, path, bundle));
+            } else {
+              TF_RETURN_IF_ERROR(
+                  bundle_factory->CreateSavedModelBundle(path, bundle));
+            }
+            MaybePublishMLMDStreamz(path, metadata.servable_id.name,
+                                    metadata.servable_id.version);
+            if (bundle_factory->config().enable_model_warmup()) {
+              bundle_factory->mutable_config()
+                  .mutable_model_warmup_options()
+                  ->set_model_name(metadata.servable_id.name);
+              bundle_factory->mutable_config()
+                  .mutable_model_warmup_options()
+                  ->set_model_version(metadata.servable_id.version);
+              TF_RETURN_IF_ERROR(
+                  RunWarmup(bundle_factory->config(), path, bundle->get()));
+            }
+            const SessionBundleConfig& config = bundle_factory->config();
+            if (HasPerformanceGate(config.performance_gate())) {
+              ScopedLoadPhase gate_phase("performance_gate");
+              ModelWarmupOptions warmup_options = config.model_warmup_options();
+              warmup_options.set_model_name(metadata.servable_id.name);
+              warmup_options.set_model_version(metadata.servable_id.version);
+              return performance_gate->Check(
+                  config.performance_gate(), warmup_options,
+                  metadata.servable_id, GetRunOptions(config), path,
+                  bundle->get());
+            }
+            return OkStatus();
+          },
+          measured_resources.get());
     };
   }
-  return [bundle_factory, path](std::unique_ptr<SavedModelBundle>* bundle) {
-    TF_RETURN_IF_ERROR(bundle_factory->CreateSavedModelBundle(path, bundle));
-    if (bundle_factory->config().enable_model_warmup()) {
-      return RunSavedModelWarmup(
-          bundle_factory->config().model_warmup_options(),
-          GetRunOptions(bundle_factory->config()), path, bundle->get());
-    }
-    return OkStatus();
+  return [bundle_factory, path,
+          measured_resources](std::unique_ptr<SavedModelBundle>* bundle) {
+    return CreateMeasuredBundle(
+        bundle_factory.get(), path,
+        [&]() -> Status {
+          TF_RETURN_IF_ERROR(
+              bundle_factory->CreateSavedModelBundle(path, bundle));
+          if (bundle_factory->config().enable_model_warmup()) {
+            return RunWarmup(bundle_factory->config(), path, bundle->get());
+          }
+          return OkStatus();
+        },
+        measured_resources.get());
   };
 }
 
 Status SavedModelBundleSourceAdapter::Convert(const StoragePath& path,
                                               std::unique_ptr<Loader>* loader) {
   std::shared_ptr<SavedModelBundleFactory> bundle_factory = bundle_factory_;
-  auto servable_creator = GetServableCreator(bundle_factory, path);
+  auto measured_resources = std::make_shared<ResourceAllocation>();
+  auto servable_creator =
+      GetServableCreator(bundle_factory, path, measured_resources);
   auto resource_estimator = [bundle_factory,
                              path](ResourceAllocation* estimate) {
+    ScopedLoadPhase estimate_phase("estimate_resources");
     TF_RETURN_IF_ERROR(
         bundle_factory->EstimateResourceRequirement(path, estimate));
 
@@ -113,8 +197,13 @@ Status SavedModelBundleSourceAdapter::Convert(const StoragePath& path,
 
     return OkStatus();
   };
-  auto post_load_resource_estimator = [bundle_factory,
-                                       path](ResourceAllocation* estimate) {
+  auto post_load_resource_estimator = [bundle_factory, path,
+                                       measured_resources](
+                                          ResourceAllocation* estimate) {
+    if (measured_resources->resource_quantities_size() > 0) {
+      *estimate = *measured_resources;
+      return OkStatus();
+    }
     return bundle_factory->EstimateResourceRequirement(path, estimate);
   };
   loader->reset(new SimpleLoader<SavedModelBundle>(
@@ -23,6 +23,8 @@ limitations under the License.
 #include "tensorflow_serving/core/simple_loader.h"
 #include "tensorflow_serving/core/source_adapter.h"
 #include "tensorflow_serving/core/storage_path.h"
+#include "tensorflow_serving/resources/resources.pb.h"
+#include "tensorflow_serving/servables/tensorflow/performance_gate.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_factory.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_bundle_source_adapter.pb.h"
 
@@ -46,9 +48,14 @@ class SavedModelBundleSourceAdapter final
   explicit SavedModelBundleSourceAdapter(
       std::unique_ptr<SavedModelBundleFactory> bundle_factory);
 
+  // Returns a creator of bundles from 'path'. If the factory measures the
+  // resources of the bundles it creates, the creator sets
+  // 'measured_resources' to the measurement (and clears it if the bundle could
+  // not be measured).
   SimpleLoader<SavedModelBundle>::CreatorVariant GetServableCreator(
       std::shared_ptr<SavedModelBundleFactory> bundle_factory,
-      const StoragePath& path) const;
+      const StoragePath& path,
+      std::shared_ptr<ResourceAllocation> measured_resources) const;
 
   Status Convert(const StoragePath& path,
                  std::unique_ptr<Loader>* loader) override;
@@ -57,6 +64,9 @@ class SavedModelBundleSourceAdapter final
   // outlive this object.
   std::shared_ptr<SavedModelBundleFactory> bundle_factory_;
 
+  // Compares the performance of the versions of each model, if configured.
+  std::shared_ptr<PerformanceGate> performance_gate_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(SavedModelBundleSourceAdapter);
 };
 
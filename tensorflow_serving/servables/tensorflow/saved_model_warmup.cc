@@ -34,8 +34,6 @@ limitations under the License.
 namespace tensorflow {
 namespace serving {
 
-namespace {
-
 Status RunWarmupRequest(const PredictionLog& warmup_record,
                         const RunOptions& run_options,
                         const MetaGraphDef& meta_graph_def, Session* session) {
@@ -76,8 +74,6 @@ Status RunWarmupRequest(const PredictionLog& warmup_record,
   return OkStatus();
 }
 
-}  // namespace
-
 Status RunSavedModelWarmup(const ModelWarmupOptions& model_warmup_options,
                            const RunOptions& run_options,
                            const string& export_dir, SavedModelBundle* bundle) {
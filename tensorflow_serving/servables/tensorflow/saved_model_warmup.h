@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/core/protobuf/saved_model.pb.h"
 #include "tensorflow/core/public/session.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_warmup_util.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 
@@ -35,6 +36,12 @@ Status RunSavedModelWarmup(const ModelWarmupOptions& model_warmup_options,
                            const RunOptions& run_options,
                            const string& export_dir, SavedModelBundle* bundle);
 
+// Runs the request of 'warmup_record' on 'session', of the model with meta
+// graph 'meta_graph_def', and drops the response.
+Status RunWarmupRequest(const PredictionLog& warmup_record,
+                        const RunOptions& run_options,
+                        const MetaGraphDef& meta_graph_def, Session* session);
+
 }  // namespace serving
 }  // namespace tensorflow
 
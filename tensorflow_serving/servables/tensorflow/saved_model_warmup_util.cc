@@ -18,18 +18,26 @@ limitations under the License.
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "google/protobuf/wrappers.pb.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/kernels/batching_util/warmup.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
 #include "tsl/platform/errors.h"
+#include "tensorflow_serving/batching/batching_util.h"
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
 #include "tensorflow_serving/util/threadpool_executor.h"
 
 namespace tensorflow {
@@ -46,6 +54,59 @@ auto* model_warm_up_latency = monitoring::Sampler<2>::New(
     },  // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
     monitoring::Buckets::Exponential(10, 1.8, 33));
 
+auto* model_warm_up_request_wait_time = monitoring::Sampler<1>::New(
+    {
+        "/tensorflow/serving/model_warmup_request_wait_time",
+        "Distribution of wall time (in microseconds) warmup requests of the "
+        "model wait for the limit on concurrent warmup requests.",
+        "model_path",
+    },  // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+    monitoring::Buckets::Exponential(10, 1.8, 33));
+
+auto* model_warm_up_requests = monitoring::Counter<1>::New(
+    "/tensorflow/serving/model_warmup_requests",
+    "The number of warmup requests executed for the model, including repeated "
+    "iterations and the replays at each warmup batch size.",
+    "model_path");
+
+// Bounds the number of warmup requests in flight across all the models of the
+// process. See ModelWarmupOptions.max_concurrent_warmup_requests.
+class WarmupRequestLimiter {
+ public:
+  // Sets the limit; 0 or less means unbounded.
+  void SetLimit(int limit) {
+    ::tensorflow::mutex_lock lock(mu_);
+    limit_ = limit;
+    cv_.notify_all();
+  }
+
+  // Blocks until a request may start.
+  void Acquire() {
+    ::tensorflow::mutex_lock lock(mu_);
+    while (limit_ > 0 && num_in_flight_ >= limit_) {
+      cv_.wait(lock);
+    }
+    ++num_in_flight_;
+  }
+
+  void Release() {
+    ::tensorflow::mutex_lock lock(mu_);
+    --num_in_flight_;
+    cv_.notify_one();
+  }
+
+ private:
+  ::tensorflow::mutex mu_;
+  ::tensorflow::condition_variable cv_;
+  int limit_ ABSL_GUARDED_BY(mu_) = 0;
+  int num_in_flight_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+WarmupRequestLimiter* GetWarmupRequestLimiter() {
+  static WarmupRequestLimiter* const limiter = new WarmupRequestLimiter();
+  return limiter;
+}
+
 uint64_t GetLatencyMicroseconds(const uint64_t start_microseconds) {
   const uint64_t end_microseconds = EnvTime::NowMicros();
   // Avoid clock skew.
@@ -53,6 +114,59 @@ uint64_t GetLatencyMicroseconds(const uint64_t start_microseconds) {
   return end_microseconds - start_microseconds;
 }
 
+// Resizes the examples of 'input' to 'batch_size'. See ResizeWarmupRecord().
+Status ResizeInput(int64_t batch_size, Input* input) {
+  google::protobuf::RepeatedPtrField<tensorflow::Example>* examples;
+  switch (input->kind_case()) {
+    case Input::kExampleList:
+      examples = input->mutable_example_list()->mutable_examples();
+      break;
+    case Input::kExampleListWithContext:
+      examples = input->mutable_example_list_with_context()->mutable_examples();
+      break;
+    default:
+      return errors::InvalidArgument("Warmup request has no input examples");
+  }
+  const int num_examples = examples->size();
+  if (num_examples == 0) {
+    return errors::InvalidArgument("Warmup request has no input examples");
+  }
+  if (batch_size < num_examples) {
+    examples->DeleteSubrange(batch_size, num_examples - batch_size);
+  }
+  for (int64_t i = num_examples; i < batch_size; ++i) {
+    tensorflow::Example* example = examples->Add();
+    *example = examples->Get(i % num_examples);
+  }
+  return OkStatus();
+}
+
+// Resizes the 0th dimension of each input of 'request' to 'batch_size'. See
+// ResizeWarmupRecord().
+Status ResizePredictRequest(int64_t batch_size, PredictRequest* request) {
+  for (auto& entry : *request->mutable_inputs()) {
+    Tensor tensor;
+    if (!tensor.FromProto(entry.second)) {
+      return errors::InvalidArgument("Warmup request input '", entry.first,
+                                     "' is not a valid tensor");
+    }
+    if (tensor.dims() == 0 || tensor.dim_size(0) == 0) {
+      return errors::InvalidArgument("Warmup request input '", entry.first,
+                                     "' has no batch dimension to resize");
+    }
+    std::vector<int64_t> rows;
+    rows.reserve(batch_size);
+    for (int64_t i = 0; i < batch_size; ++i) {
+      rows.push_back(i % tensor.dim_size(0));
+    }
+    Tensor resized;
+    TF_RETURN_IF_ERROR(GatherRows(tensor, rows, &resized));
+    entry.second.Clear();
+    resized.AsProtoField(&entry.second);
+  }
+  return OkStatus();
+}
+
 }  // namespace
 
 constexpr char WarmupConsts::kRequestsFileName[];
@@ -78,10 +192,24 @@ Status RunSavedModelWarmup(
   const string warmup_path =
       io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
                    WarmupConsts::kRequestsFileName);
+  // The requests captured from the traffic of the model, replayed if the
+  // SavedModel ships no warmup data.
+  std::vector<tstring> captured_records;
   if (!tensorflow::Env::Default()->FilesExist({warmup_path}, nullptr)) {
-    LOG(INFO) << "No warmup data file found at " << warmup_path;
-    // Having warmup data is optional, return OK
-    return OkStatus();
+    if (model_warmup_options.use_captured_warmup_requests() &&
+        !model_warmup_options.model_name().empty()) {
+      captured_records = CapturedWarmupRequests::Global()->GetRecords(
+          model_warmup_options.model_name());
+    }
+    if (captured_records.empty()) {
+      LOG(INFO) << "No warmup data file found at " << warmup_path;
+      // Having warmup data is optional, return OK
+      return OkStatus();
+    }
+    LOG(INFO) << "No warmup data file found at " << warmup_path
+              << "; replaying " << captured_records.size()
+              << " requests captured from the traffic of model "
+              << model_warmup_options.model_name();
   }
   const int num_request_iterations = [&]() {
     if (model_warmup_options.has_num_request_iterations()) {
@@ -93,22 +221,106 @@ Status RunSavedModelWarmup(
   LOG(INFO) << "Starting to read warmup data for model at " << warmup_path
             << " with model-warmup-options "
             << model_warmup_options.DebugString();
+  if (model_warmup_options.has_max_concurrent_warmup_requests()) {
+    GetWarmupRequestLimiter()->SetLimit(
+        model_warmup_options.max_concurrent_warmup_requests().value());
+  }
+  // Every request, including the replays at each batch size below, takes a
+  // slot of the process-wide limit while it executes.
+  warmup_request_executor =
+      [executor = std::move(warmup_request_executor), export_dir](
+          PredictionLog prediction_log) -> Status {
+    WarmupRequestLimiter* const limiter = GetWarmupRequestLimiter();
+    const uint64_t wait_start_microseconds = EnvTime::NowMicros();
+    limiter->Acquire();
+    model_warm_up_request_wait_time->GetCell(export_dir)
+        ->Add(GetLatencyMicroseconds(wait_start_microseconds));
+    const Status status = executor(std::move(prediction_log));
+    limiter->Release();
+    model_warm_up_requests->GetCell(export_dir)->IncrementBy(1);
+    return status;
+  };
+  if (!model_warmup_options.batch_sizes().empty()) {
+    // Also replay the first record of each signature at each batch size.
+    struct BatchSizesState {
+      ::tensorflow::mutex mu;
+      absl::flat_hash_set<string> warmed_up_signatures ABSL_GUARDED_BY(mu);
+    };
+    warmup_request_executor =
+        [executor = std::move(warmup_request_executor),
+         batch_sizes =
+             std::vector<int64_t>(model_warmup_options.batch_sizes().begin(),
+                                  model_warmup_options.batch_sizes().end()),
+         state = std::make_shared<BatchSizesState>()](
+            PredictionLog prediction_log) -> Status {
+      bool first_record_of_signature;
+      {
+        ::tensorflow::mutex_lock lock(state->mu);
+        first_record_of_signature =
+            state->warmed_up_signatures
+                .insert(WarmupSignatureKey(prediction_log))
+                .second;
+      }
+      if (first_record_of_signature) {
+        for (const int64_t batch_size : batch_sizes) {
+          PredictionLog resized_log;
+          const Status status =
+              ResizeWarmupRecord(prediction_log, batch_size, &resized_log);
+          if (errors::IsUnimplemented(status)) {
+            break;
+          }
+          TF_RETURN_IF_ERROR(status);
+          TF_RETURN_IF_ERROR(executor(std::move(resized_log)));
+        }
+      }
+      return executor(std::move(prediction_log));
+    };
+  }
+  // Reads the next warmup record, or returns an OutOfRange error at the end.
+  std::function<Status(tstring*)> read_record;
   std::unique_ptr<tensorflow::RandomAccessFile> tf_record_file;
-  TF_RETURN_IF_ERROR(tensorflow::Env::Default()->NewRandomAccessFile(
-      warmup_path, &tf_record_file));
+  std::unique_ptr<tensorflow::io::SequentialRecordReader> tf_record_file_reader;
+  if (captured_records.empty()) {
+    TF_RETURN_IF_ERROR(tensorflow::Env::Default()->NewRandomAccessFile(
+        warmup_path, &tf_record_file));
+    tf_record_file_reader.reset(
+        new tensorflow::io::SequentialRecordReader(tf_record_file.get()));
+    read_record = [reader = tf_record_file_reader.get()](tstring* record) {
+      return reader->ReadRecord(record);
+    };
+  } else {
+    read_record = [&captured_records, next = size_t{0}](
+                      tstring* record) mutable -> Status {
+      if (next == captured_records.size()) {
+        return errors::OutOfRange("End of captured warmup requests");
+      }
+      *record = std::move(captured_records[next++]);
+      return OkStatus();
+    };
+    // A captured request may not suit the new version of the model (e.g. if
+    // its signatures changed), so failing ones are skipped rather than failing
+    // the load.
+    warmup_request_executor =
+        [executor = std::move(warmup_request_executor),
+         export_dir](PredictionLog prediction_log) -> Status {
+      const Status status = executor(std::move(prediction_log));
+      if (!status.ok()) {
+        LOG(WARNING) << "Skipping captured warmup request that failed for "
+                     << export_dir << ": " << status;
+      }
+      return OkStatus();
+    };
+  }
 
   int num_model_warmup_threads =
       model_warmup_options.has_num_model_warmup_threads()
           ? std::max(model_warmup_options.num_model_warmup_threads().value(), 1)
           : 1;
-  std::unique_ptr<tensorflow::io::SequentialRecordReader> tf_record_file_reader;
   Status status;
   int num_warmup_records = 0;
   if (num_model_warmup_threads <= 1) {
-    tf_record_file_reader.reset(
-        new tensorflow::io::SequentialRecordReader(tf_record_file.get()));
     tstring record;
-    status = tf_record_file_reader->ReadRecord(&record);
+    status = read_record(&record);
     tensorflow::serving::PredictionLog prediction_log;
     while (status.ok()) {
       if (!prediction_log.ParseFromArray(record.data(), record.size())) {
@@ -125,7 +337,7 @@ Status RunSavedModelWarmup(
             "Number of warmup records exceeds the maximum (",
             WarmupConsts::kMaxNumRecords, ") at ", warmup_path);
       }
-      status = tf_record_file_reader->ReadRecord(&record);
+      status = read_record(&record);
     }
   } else {
     struct SharedState {
@@ -136,8 +348,7 @@ Status RunSavedModelWarmup(
       // Condition variable to wait until all scheduled warmup tasks are
       // executed.
       ::tensorflow::condition_variable done ABSL_GUARDED_BY(mu);
-      std::unique_ptr<tensorflow::io::SequentialRecordReader>
-          tf_record_file_reader ABSL_GUARDED_BY(mu);
+      std::function<Status(tstring*)> read_record ABSL_GUARDED_BY(mu);
     };
     const auto state = std::make_shared<SharedState>();
 
@@ -146,8 +357,7 @@ Status RunSavedModelWarmup(
                                           num_model_warmup_threads));
     {
       ::tensorflow::mutex_lock lock(state->mu);
-      state->tf_record_file_reader.reset(
-          new tensorflow::io::SequentialRecordReader(tf_record_file.get()));
+      state->read_record = std::move(read_record);
     }
     for (int i = 0; i < num_model_warmup_threads; ++i) {
       executor->Schedule([state, num_request_iterations,
@@ -169,8 +379,7 @@ Status RunSavedModelWarmup(
                   WarmupConsts::kMaxNumRecords, ") at ", warmup_path);
               break;
             }
-            execution_status =
-                state->tf_record_file_reader->ReadRecord(&record);
+            execution_status = state->read_record(&record);
             if (!execution_status.ok()) {
               state->warm_up_status = execution_status;
               break;
@@ -237,6 +446,65 @@ Status RunSavedModelWarmup(
   return OkStatus();
 }
 
+string WarmupSignatureKey(const PredictionLog& record) {
+  switch (record.log_type_case()) {
+    case PredictionLog::kClassifyLog:
+      return strings::StrCat(
+          "classify/",
+          record.classify_log().request().model_spec().signature_name());
+    case PredictionLog::kRegressLog:
+      return strings::StrCat(
+          "regress/",
+          record.regress_log().request().model_spec().signature_name());
+    case PredictionLog::kPredictLog:
+      return strings::StrCat(
+          "predict/",
+          record.predict_log().request().model_spec().signature_name());
+    case PredictionLog::kMultiInferenceLog: {
+      string key = "multi_inference";
+      for (const auto& task :
+           record.multi_inference_log().request().tasks()) {
+        strings::StrAppend(&key, "/", task.model_spec().signature_name());
+      }
+      return key;
+    }
+    default:
+      return strings::StrCat(record.log_type_case());
+  }
+}
+
+Status ResizeWarmupRecord(const PredictionLog& record, int64_t batch_size,
+                          PredictionLog* resized_record) {
+  if (batch_size <= 0) {
+    return errors::InvalidArgument("Warmup batch size must be positive; was ",
+                                   batch_size);
+  }
+  *resized_record = record;
+  switch (record.log_type_case()) {
+    case PredictionLog::kClassifyLog:
+      return ResizeInput(batch_size, resized_record->mutable_classify_log()
+                                         ->mutable_request()
+                                         ->mutable_input());
+    case PredictionLog::kRegressLog:
+      return ResizeInput(batch_size, resized_record->mutable_regress_log()
+                                         ->mutable_request()
+                                         ->mutable_input());
+    case PredictionLog::kMultiInferenceLog:
+      return ResizeInput(batch_size,
+                         resized_record->mutable_multi_inference_log()
+                             ->mutable_request()
+                             ->mutable_input());
+    case PredictionLog::kPredictLog:
+      return ResizePredictRequest(
+          batch_size,
+          resized_record->mutable_predict_log()->mutable_request());
+    default:
+      return errors::Unimplemented(
+          "Cannot resize warmup records of log_type ",
+          record.log_type_case());
+  }
+}
+
 }  // namespace internal
 }  // namespace serving
 }  // namespace tensorflow
@@ -35,10 +35,30 @@ struct WarmupConsts {
 // to trigger lazy initializations (such as TF optimizations, XLA compilations)
 // at load time, and consequently improve first request latency.
 // Warmup is skipped if no warmup file present.
+//
+// If 'model_warmup_options.batch_sizes' is set, the first record of each
+// signature is also invoked once per batch size, resized with
+// ResizeWarmupRecord().
+//
+// With 'model_warmup_options.num_model_warmup_threads' > 1 the records are
+// replayed in parallel, so that a batching model server can batch them. The
+// number of requests executing at a time across all the models of the process
+// is bounded by 'model_warmup_options.max_concurrent_warmup_requests'.
 Status RunSavedModelWarmup(
     const ModelWarmupOptions& model_warmup_options, const string export_dir,
     std::function<Status(PredictionLog)> warmup_request_executor);
 
+// Sets 'resized_record' to a copy of 'record' with exactly 'batch_size'
+// examples (for Classify, Regress and MultiInference requests) or input tensor
+// rows (for Predict requests), obtained by repeating the original ones
+// cyclically or dropping the excess ones. Returns an Unimplemented error for
+// other types of records.
+Status ResizeWarmupRecord(const PredictionLog& record, int64_t batch_size,
+                          PredictionLog* resized_record);
+
+// Returns a key that identifies the signature(s) invoked by 'record'.
+string WarmupSignatureKey(const PredictionLog& record);
+
 }  // namespace internal
 }  // namespace serving
 }  // namespace tensorflow
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/saved_model_warmup_util.h"
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -43,6 +45,7 @@ limitations under the License.
 #include "tensorflow_serving/apis/predict.pb.h"
 #include "tensorflow_serving/apis/prediction_log.pb.h"
 #include "tensorflow_serving/apis/regression.pb.h"
+#include "tensorflow_serving/servables/tensorflow/captured_warmup_requests.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_warmup_test_util.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 
@@ -253,8 +256,196 @@ TEST_P(SavedModelBundleWarmupUtilTest, RunFailure) {
       << status;
   EXPECT_THAT(status.ToString(), ::testing::HasSubstr("Run failed"));
 }
+TEST_P(SavedModelBundleWarmupUtilTest, WarmupBatchSizes) {
+  string base_path = io::JoinPath(testing::TmpDir(), "WarmupBatchSizes");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+      io::JoinPath(base_path, kSavedModelAssetsExtraDirectory)));
+  string fname = io::JoinPath(base_path, kSavedModelAssetsExtraDirectory,
+                              internal::WarmupConsts::kRequestsFileName);
+
+  const int num_warmup_records = 3;
+  std::vector<string> warmup_records;
+  TF_ASSERT_OK(AddMixedWarmupData(
+      &warmup_records, {PredictionLog::kPredictLog, PredictionLog::kClassifyLog,
+                        PredictionLog::kSessionRunLog}));
+  TF_ASSERT_OK(WriteWarmupData(fname, warmup_records, num_warmup_records));
+
+  ModelWarmupOptions options = CreateModelWarmupOptions();
+  options.add_batch_sizes(2);
+  options.add_batch_sizes(4);
+  tensorflow::mutex mu;
+  std::vector<int64_t> predict_batch_sizes;
+  std::vector<int64_t> classify_batch_sizes;
+  int num_session_run_records = 0;
+  TF_ASSERT_OK(RunSavedModelWarmup(
+      options, base_path, [&](PredictionLog prediction_log) {
+        tensorflow::mutex_lock lock(mu);
+        switch (prediction_log.log_type_case()) {
+          case PredictionLog::kPredictLog:
+            predict_batch_sizes.push_back(prediction_log.predict_log()
+                                              .request()
+                                              .inputs()
+                                              .begin()
+                                              ->second.tensor_shape()
+                                              .dim(0)
+                                              .size());
+            break;
+          case PredictionLog::kClassifyLog:
+            classify_batch_sizes.push_back(prediction_log.classify_log()
+                                               .request()
+                                               .input()
+                                               .example_list()
+                                               .examples_size());
+            break;
+          default:
+            ++num_session_run_records;
+        }
+        return OkStatus();
+      }));
+  // Only the first record of each signature is resized; records that cannot
+  // be resized are replayed as is.
+  EXPECT_THAT(predict_batch_sizes,
+              ::testing::UnorderedElementsAre(1, 1, 1, 2, 4));
+  EXPECT_THAT(classify_batch_sizes,
+              ::testing::UnorderedElementsAre(1, 1, 1, 2, 4));
+  EXPECT_EQ(num_warmup_records, num_session_run_records);
+}
+
+TEST_P(SavedModelBundleWarmupUtilTest, MaxConcurrentWarmupRequests) {
+  string base_path =
+      io::JoinPath(testing::TmpDir(), "MaxConcurrentWarmupRequests");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+      io::JoinPath(base_path, kSavedModelAssetsExtraDirectory)));
+  string fname = io::JoinPath(base_path, kSavedModelAssetsExtraDirectory,
+                              internal::WarmupConsts::kRequestsFileName);
+
+  const int num_warmup_records = 10;
+  std::vector<string> warmup_records;
+  TF_ASSERT_OK(AddMixedWarmupData(&warmup_records));
+  TF_ASSERT_OK(WriteWarmupData(fname, warmup_records, num_warmup_records));
+
+  tensorflow::mutex mu;
+  int num_in_flight = 0;
+  int max_num_in_flight = 0;
+  int num_requests = 0;
+  auto executor = [&](PredictionLog prediction_log) {
+    {
+      tensorflow::mutex_lock lock(mu);
+      max_num_in_flight = std::max(max_num_in_flight, ++num_in_flight);
+      ++num_requests;
+    }
+    Env::Default()->SleepForMicroseconds(1000);
+    tensorflow::mutex_lock lock(mu);
+    --num_in_flight;
+    return OkStatus();
+  };
+
+  // Two models warming up at the same time share the limit.
+  ModelWarmupOptions options = CreateModelWarmupOptions();
+  options.mutable_max_concurrent_warmup_requests()->set_value(1);
+  // Registering the same model twice in the WarmupStateRegistry would fail.
+  options.set_model_name("");
+  Status other_status;
+  {
+    std::unique_ptr<Thread> other_model(Env::Default()->StartThread(
+        {}, "other_model", [&]() {
+          other_status = RunSavedModelWarmup(options, base_path, executor);
+        }));
+    TF_EXPECT_OK(RunSavedModelWarmup(options, base_path, executor));
+  }
+  TF_EXPECT_OK(other_status);
+  EXPECT_EQ(1, max_num_in_flight);
+  EXPECT_EQ(2 * num_warmup_records * static_cast<int>(warmup_records.size()),
+            num_requests);
+
+  // A limit of 0 lifts it.
+  options.mutable_max_concurrent_warmup_requests()->set_value(0);
+  TF_EXPECT_OK(RunSavedModelWarmup(options, base_path, executor));
+}
+
+TEST_P(SavedModelBundleWarmupUtilTest, CapturedWarmupRequests) {
+  string base_path = io::JoinPath(testing::TmpDir(), "CapturedWarmupRequests");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(base_path));
+
+  CapturedWarmupRequests* const captured = CapturedWarmupRequests::Global();
+  captured->Enable({});
+  PredictRequest request;
+  TensorShapeProto::Dim* batch_dim =
+      (*request.mutable_inputs())["x"].mutable_tensor_shape()->add_dim();
+  batch_dim->set_size(1);
+  captured->Capture(string(kModelName), request);
+  batch_dim->set_size(2);
+  captured->Capture(string(kModelName), request);
+
+  ModelWarmupOptions options = CreateModelWarmupOptions();
+  options.set_model_name(string(kModelName));
+  // Captured requests are only used if asked for.
+  TF_ASSERT_OK(RunSavedModelWarmup(options, base_path,
+                                   [this](PredictionLog prediction_log) {
+                                     this->FakeRunWarmupRequest();
+                                     return OkStatus();
+                                   }));
+  EXPECT_EQ(0, warmup_request_counter());
+
+  options.set_use_captured_warmup_requests(true);
+  TF_ASSERT_OK(RunSavedModelWarmup(options, base_path,
+                                   [this](PredictionLog prediction_log) {
+                                     this->FakeRunWarmupRequest();
+                                     return OkStatus();
+                                   }));
+  EXPECT_EQ(2, warmup_request_counter());
+
+  // Requests that fail are skipped.
+  TF_EXPECT_OK(RunSavedModelWarmup(
+      options, base_path, [](PredictionLog prediction_log) {
+        return errors::InvalidArgument("Incompatible request");
+      }));
+  captured->Clear();
+}
+
 INSTANTIATE_TEST_SUITE_P(ParallelWarmUp, SavedModelBundleWarmupUtilTest,
                          ::testing::Bool());
+
+TEST(SavedModelWarmupUtilTest, ResizeWarmupRecord) {
+  PredictionLog classify_log;
+  TF_ASSERT_OK(
+      PopulatePredictionLog(&classify_log, PredictionLog::kClassifyLog));
+  PredictionLog resized_log;
+  TF_ASSERT_OK(ResizeWarmupRecord(classify_log, 3, &resized_log));
+  EXPECT_EQ(3, resized_log.classify_log()
+                   .request()
+                   .input()
+                   .example_list()
+                   .examples_size());
+
+  PredictionLog predict_log;
+  TF_ASSERT_OK(PopulatePredictionLog(&predict_log, PredictionLog::kPredictLog));
+  TF_ASSERT_OK(ResizeWarmupRecord(predict_log, 3, &resized_log));
+  const TensorProto& resized_input =
+      resized_log.predict_log().request().inputs().begin()->second;
+  EXPECT_EQ(3, resized_input.tensor_shape().dim(0).size());
+  EXPECT_THAT(resized_input.string_val(),
+              ::testing::ElementsAre("input_value", "input_value",
+                                     "input_value"));
+
+  // Shrinking drops the excess rows.
+  PredictionLog shrunk_log;
+  TF_ASSERT_OK(ResizeWarmupRecord(resized_log, 2, &shrunk_log));
+  EXPECT_EQ(2, shrunk_log.predict_log()
+                   .request()
+                   .inputs()
+                   .begin()
+                   ->second.tensor_shape()
+                   .dim(0)
+                   .size());
+
+  PredictionLog session_run_log;
+  TF_ASSERT_OK(
+      PopulatePredictionLog(&session_run_log, PredictionLog::kSessionRunLog));
+  EXPECT_TRUE(errors::IsUnimplemented(
+      ResizeWarmupRecord(session_run_log, 3, &resized_log)));
+  EXPECT_FALSE(ResizeWarmupRecord(predict_log, 0, &resized_log).ok());
+}
 }  // namespace
 }  // namespace internal
 }  // namespace serving
@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/servable.h"
 
+#include <memory>
 #include <utility>
 
 #include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "tensorflow_serving/apis/predict.pb.h"
 
 namespace tensorflow {
@@ -51,5 +54,28 @@ absl::Status SingleRequestPredictStreamedContext::Close() {
   return absl::OkStatus();
 }
 
+absl::Status RunPredictStreamed(
+    Servable& servable, const Servable::RunOptions& run_options,
+    const PredictRequest& request,
+    absl::FunctionRef<absl::Status(const PredictResponse&)> write) {
+  // Callbacks are serialized and end before PredictStreamed() returns, so they
+  // can share this status.
+  absl::Status status;
+  absl::StatusOr<std::unique_ptr<PredictStreamedContext>> context =
+      servable.PredictStreamed(
+          run_options, [&](absl::StatusOr<PredictResponse> response) {
+            if (!status.ok()) {
+              return;
+            }
+            status = response.ok() ? write(*response) : response.status();
+          });
+  if (!context.ok()) {
+    return context.status();
+  }
+  status.Update((*context)->ProcessRequest(request));
+  status.Update((*context)->Close());
+  return status;
+}
+
 }  // namespace serving
 }  // namespace tensorflow
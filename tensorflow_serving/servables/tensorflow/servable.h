@@ -22,6 +22,7 @@ limitations under the License.
 #include <string>
 
 #include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -187,6 +188,14 @@ class EmptyServable : public Servable {
   absl::Status error_;
 };
 
+// Runs the single `request` through `servable.PredictStreamed()`, passing each
+// streamed response to `write` as soon as it is produced. Returns the first
+// error of the servable or of `write`; responses after an error are dropped.
+absl::Status RunPredictStreamed(
+    Servable& servable, const Servable::RunOptions& run_options,
+    const PredictRequest& request,
+    absl::FunctionRef<absl::Status(const PredictResponse&)> write);
+
 }  // namespace serving
 }  // namespace tensorflow
 
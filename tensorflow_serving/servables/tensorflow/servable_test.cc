@@ -15,14 +15,54 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/servable.h"
 
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/servables/tensorflow/mock_servable.h"
 #include "tensorflow_serving/test_util/test_util.h"
 
 namespace tensorflow {
 namespace serving {
 namespace {
 
+using ::testing::_;
+using ::testing::ElementsAre;
+
+using ResponseCallback =
+    absl::AnyInvocable<void(absl::StatusOr<PredictResponse>)>;
+
+// Makes 'servable' stream a response per version in 'versions' for its single
+// request, and then fail with 'final_response' if it is an error.
+void ExpectStreamedResponses(std::vector<int64_t> versions,
+                             absl::Status final_response,
+                             MockServable* servable) {
+  EXPECT_CALL(*servable, PredictStreamed(_, _))
+      .WillOnce([versions, final_response](const Servable::RunOptions&,
+                                           ResponseCallback callback)
+                    -> absl::StatusOr<std::unique_ptr<PredictStreamedContext>> {
+        return std::make_unique<SingleRequestPredictStreamedContext>(
+            [versions, final_response, callback = std::move(callback)](
+                const PredictRequest& request) mutable {
+              for (const int64_t version : versions) {
+                PredictResponse response;
+                response.mutable_model_spec()->mutable_version()->set_value(
+                    version);
+                callback(std::move(response));
+              }
+              if (!final_response.ok()) {
+                callback(final_response);
+              }
+              return absl::OkStatus();
+            });
+      });
+}
+
 TEST(EmptyServableTest, Predict) {
   PredictResponse response;
   EXPECT_EQ(EmptyServable()
@@ -31,6 +71,61 @@ TEST(EmptyServableTest, Predict) {
             absl::StatusCode::kFailedPrecondition);
 }
 
+TEST(RunPredictStreamedTest, WritesResponsesAsProduced) {
+  MockServable servable;
+  ExpectStreamedResponses({1, 2, 3}, absl::OkStatus(), &servable);
+  std::vector<int64_t> written;
+  TF_EXPECT_OK(RunPredictStreamed(
+      servable, Servable::RunOptions(), PredictRequest(),
+      [&](const PredictResponse& response) {
+        written.push_back(response.model_spec().version().value());
+        return absl::OkStatus();
+      }));
+  EXPECT_THAT(written, ElementsAre(1, 2, 3));
+}
+
+TEST(RunPredictStreamedTest, StopsAtWriteError) {
+  MockServable servable;
+  ExpectStreamedResponses({1, 2, 3}, absl::OkStatus(), &servable);
+  std::vector<int64_t> written;
+  EXPECT_EQ(RunPredictStreamed(servable, Servable::RunOptions(),
+                               PredictRequest(),
+                               [&](const PredictResponse& response) {
+                                 written.push_back(
+                                     response.model_spec().version().value());
+                                 return written.size() < 2
+                                            ? absl::OkStatus()
+                                            : absl::CancelledError("gone");
+                               })
+                .code(),
+            absl::StatusCode::kCancelled);
+  EXPECT_THAT(written, ElementsAre(1, 2));
+}
+
+TEST(RunPredictStreamedTest, ReturnsServableError) {
+  MockServable servable;
+  ExpectStreamedResponses({1}, absl::InternalError("failed"), &servable);
+  int num_written = 0;
+  EXPECT_EQ(RunPredictStreamed(servable, Servable::RunOptions(),
+                               PredictRequest(),
+                               [&](const PredictResponse& response) {
+                                 ++num_written;
+                                 return absl::OkStatus();
+                               })
+                .code(),
+            absl::StatusCode::kInternal);
+  EXPECT_EQ(num_written, 1);
+
+  EmptyServable empty_servable;
+  EXPECT_EQ(RunPredictStreamed(empty_servable, Servable::RunOptions(),
+                               PredictRequest(),
+                               [&](const PredictResponse& response) {
+                                 return absl::OkStatus();
+                               })
+                .code(),
+            absl::StatusCode::kFailedPrecondition);
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -15,9 +15,12 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/serving_session.h"
 
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 namespace serving {
@@ -34,5 +37,129 @@ Status ServingSession::Close() {
   return errors::PermissionDenied("State changes denied via ServingSession");
 }
 
+void ServingSession::RunAsync(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
+    RunMetadata* run_metadata, std::function<void(const Status&)> done) {
+  done(Run(run_options, inputs, output_tensor_names, target_node_names,
+           outputs, run_metadata));
+}
+
+SessionCallables::~SessionCallables() {
+  for (const auto& entry : callables_) {
+    session_->ReleaseCallable(entry.second).IgnoreError();
+  }
+}
+
+Status SessionCallables::Run(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names, std::vector<Tensor>* outputs,
+    RunMetadata* run_metadata,
+    const thread::ThreadPoolOptions* thread_pool_options) {
+  Session::CallableHandle handle;
+  if (!GetCallable(run_options, inputs, output_tensor_names, target_node_names,
+                   &handle)) {
+    if (thread_pool_options != nullptr) {
+      return session_->Run(run_options, inputs, output_tensor_names,
+                           target_node_names, outputs, run_metadata,
+                           *thread_pool_options);
+    }
+    return session_->Run(run_options, inputs, output_tensor_names,
+                         target_node_names, outputs, run_metadata);
+  }
+  std::vector<Tensor> feed_tensors;
+  feed_tensors.reserve(inputs.size());
+  for (const auto& input : inputs) {
+    feed_tensors.push_back(input.second);
+  }
+  outputs->clear();
+  if (thread_pool_options == nullptr) {
+    return session_->RunCallable(handle, feed_tensors, outputs, run_metadata);
+  }
+  const Status status = session_->RunCallable(
+      handle, feed_tensors, outputs, run_metadata, *thread_pool_options);
+  if (!errors::IsUnimplemented(status)) {
+    return status;
+  }
+  // The session implements callables, but not with thread pool options.
+  outputs->clear();
+  return session_->Run(run_options, inputs, output_tensor_names,
+                       target_node_names, outputs, run_metadata,
+                       *thread_pool_options);
+}
+
+bool SessionCallables::GetCallable(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
+    const std::vector<string>& output_tensor_names,
+    const std::vector<string>& target_node_names,
+    Session::CallableHandle* handle) {
+  if (run_options.timeout_in_ms() != 0) {
+    return false;
+  }
+  // Tensor and node names can't contain '\0', so the key is unambiguous.
+  const absl::string_view separator("\0", 1);
+  const string serialized_run_options = run_options.SerializeAsString();
+  string key = strings::StrCat(serialized_run_options.size(), ":",
+                               serialized_run_options);
+  for (const auto& input : inputs) {
+    strings::StrAppend(&key, separator, "f", input.first);
+  }
+  for (const string& name : output_tensor_names) {
+    strings::StrAppend(&key, separator, "o", name);
+  }
+  for (const string& name : target_node_names) {
+    strings::StrAppend(&key, separator, "t", name);
+  }
+  {
+    mutex_lock l(mu_);
+    if (!callables_supported_) {
+      return false;
+    }
+    auto it = callables_.find(key);
+    if (it != callables_.end()) {
+      *handle = it->second;
+      return true;
+    }
+    if (callables_.size() >= max_callables_) {
+      return false;
+    }
+  }
+
+  CallableOptions callable_options;
+  *callable_options.mutable_run_options() = run_options;
+  for (const auto& input : inputs) {
+    callable_options.add_feed(input.first);
+  }
+  for (const string& name : output_tensor_names) {
+    callable_options.add_fetch(name);
+  }
+  for (const string& name : target_node_names) {
+    callable_options.add_target(name);
+  }
+  Session::CallableHandle new_handle;
+  const Status status = session_->MakeCallable(callable_options, &new_handle);
+  if (!status.ok()) {
+    // Invalid runs fail through Run(), with its errors.
+    if (errors::IsUnimplemented(status)) {
+      mutex_lock l(mu_);
+      callables_supported_ = false;
+    }
+    return false;
+  }
+  mutex_lock l(mu_);
+  auto inserted = callables_.emplace(std::move(key), new_handle);
+  if (!inserted.second) {
+    // Another run made the callable first.
+    session_->ReleaseCallable(new_handle).IgnoreError();
+  }
+  *handle = inserted.first->second;
+  return true;
+}
+
 }  // namespace serving
 }  // namespace tensorflow
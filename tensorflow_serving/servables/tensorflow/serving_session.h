@@ -16,14 +16,22 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SERVING_SESSION_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SERVING_SESSION_H_
 
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow/core/public/session.h"
+#include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
+#include "tensorflow_serving/util/request_deadline.h"
 
 namespace tensorflow {
 namespace serving {
@@ -41,15 +49,94 @@ class ServingSession : public Session {
   Status Extend(const GraphDef& graph) final;
   Status Close() final;
 
+  // Runs like Run(), but may return before the run completes, and calls 'done'
+  // with its status once it does, possibly from another thread. 'inputs',
+  // 'output_tensor_names', 'outputs' and 'run_metadata' must live until then.
+  //
+  // The default implementation calls Run() and then 'done'. Sessions that would
+  // otherwise block the calling thread while the run waits, like the sessions
+  // of BatchingSession, override it.
+  virtual void RunAsync(const RunOptions& run_options,
+                        const std::vector<std::pair<string, Tensor>>& inputs,
+                        const std::vector<string>& output_tensor_names,
+                        const std::vector<string>& target_node_names,
+                        std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+                        std::function<void(const Status&)> done);
+
   // (Subclasses just implement Run().)
 };
 
+/// Runs a session through callables (see Session::MakeCallable()), made once
+/// per combination of RunOptions, feeds, fetches and targets, so that runs
+/// skip resolving their tensor names, which e.g. DirectSession does on every
+/// Run().
+///
+/// A callable has its RunOptions baked in, so runs with a timeout (as requests
+/// with a deadline get) go through Run(), as do all runs of sessions that don't
+/// implement callables and new combinations once there are 'max_callables'.
+///
+/// This class is thread-safe.
+class SessionCallables {
+ public:
+  /// 'session' must outlive this.
+  explicit SessionCallables(Session* session, size_t max_callables = 64)
+      : session_(session), max_callables_(max_callables) {}
+
+  /// Releases the callables.
+  ~SessionCallables();
+
+  /// Runs like Session::Run(), with 'thread_pool_options' if not null.
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions* thread_pool_options)
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Sets 'handle' to the callable of the run, making it if need be. Returns
+  // false if the run should go through Run() instead.
+  bool GetCallable(const RunOptions& run_options,
+                   const std::vector<std::pair<string, Tensor>>& inputs,
+                   const std::vector<string>& output_tensor_names,
+                   const std::vector<string>& target_node_names,
+                   Session::CallableHandle* handle) TF_LOCKS_EXCLUDED(mu_);
+
+  Session* const session_;
+  const size_t max_callables_;
+
+  mutex mu_;
+
+  // Cleared if 'session_' doesn't implement callables.
+  bool callables_supported_ TF_GUARDED_BY(mu_) = true;
+
+  // By the serialized RunOptions, and the feeds, fetches and targets of the
+  // callables, in order.
+  absl::flat_hash_map<string, Session::CallableHandle> callables_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SessionCallables);
+};
+
 /// A ServingSession that wraps a given Session, and blocks all calls other than
 /// Run().
+///
+/// Runs with RunOptions are charged with the deadline of the request the
+/// calling thread serves, if any (see RequestDeadline): they fail without
+/// running if the request is cancelled or past its deadline, and their timeout
+/// is lowered to the time left.
+///
+/// Runs with RunOptions go through the callables of the wrapped session (see
+/// SessionCallables), unless it is a ServingSession.
 class ServingSessionWrapper : public ServingSession {
  public:
   explicit ServingSessionWrapper(std::unique_ptr<Session> wrapped)
-      : wrapped_(std::move(wrapped)) {
+      : wrapped_(std::move(wrapped)),
+        serving_wrapped_(dynamic_cast<ServingSession*>(wrapped_.get())),
+        callables_(serving_wrapped_ == nullptr
+                       ? new SessionCallables(wrapped_.get())
+                       : nullptr) {
     VLOG(2) << "Created the ServingSessionWrapper around the Session.";
   }
 
@@ -68,7 +155,14 @@ class ServingSessionWrapper : public ServingSession {
              const std::vector<string>& output_tensor_names,
              const std::vector<string>& target_node_names,
              std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
-    return wrapped_->Run(run_options, inputs, output_tensor_names,
+    RunOptions charged_run_options = run_options;
+    TF_RETURN_IF_ERROR(ApplyCurrentRequestDeadline(&charged_run_options));
+    if (callables_ != nullptr) {
+      return callables_->Run(charged_run_options, inputs, output_tensor_names,
+                             target_node_names, outputs, run_metadata,
+                             /*thread_pool_options=*/nullptr);
+    }
+    return wrapped_->Run(charged_run_options, inputs, output_tensor_names,
                          target_node_names, outputs, run_metadata);
   }
 
@@ -78,17 +172,54 @@ class ServingSessionWrapper : public ServingSession {
              const std::vector<string>& target_node_names,
              std::vector<Tensor>* outputs, RunMetadata* run_metadata,
              const thread::ThreadPoolOptions& thread_pool_options) override {
-    return wrapped_->Run(run_options, inputs, output_tensor_names,
+    RunOptions charged_run_options = run_options;
+    TF_RETURN_IF_ERROR(ApplyCurrentRequestDeadline(&charged_run_options));
+    if (callables_ != nullptr) {
+      return callables_->Run(charged_run_options, inputs, output_tensor_names,
+                             target_node_names, outputs, run_metadata,
+                             &thread_pool_options);
+    }
+    return wrapped_->Run(charged_run_options, inputs, output_tensor_names,
                          target_node_names, outputs, run_metadata,
                          thread_pool_options);
   }
 
+  // Forwards to the wrapped session, if it is a ServingSession. Subclasses
+  // that override Run() need to override this too.
+  void RunAsync(const RunOptions& run_options,
+                const std::vector<std::pair<string, Tensor>>& inputs,
+                const std::vector<string>& output_tensor_names,
+                const std::vector<string>& target_node_names,
+                std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+                std::function<void(const Status&)> done) override {
+    if (serving_wrapped_ == nullptr) {
+      ServingSession::RunAsync(run_options, inputs, output_tensor_names,
+                               target_node_names, outputs, run_metadata,
+                               std::move(done));
+      return;
+    }
+    RunOptions charged_run_options = run_options;
+    const Status deadline_status =
+        ApplyCurrentRequestDeadline(&charged_run_options);
+    if (!deadline_status.ok()) {
+      done(deadline_status);
+      return;
+    }
+    serving_wrapped_->RunAsync(charged_run_options, inputs,
+                               output_tensor_names, target_node_names, outputs,
+                               run_metadata, std::move(done));
+  }
+
   Status ListDevices(std::vector<DeviceAttributes>* response) override {
     return wrapped_->ListDevices(response);
   }
 
  private:
   std::unique_ptr<Session> wrapped_;
+  // 'wrapped_', if it is a ServingSession.
+  ServingSession* const serving_wrapped_;
+  // Null if 'wrapped_' is a ServingSession. Released before 'wrapped_'.
+  const std::unique_ptr<SessionCallables> callables_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(ServingSessionWrapper);
 };
@@ -120,6 +251,75 @@ class SessionWrapperIgnoreThreadPoolOptions : public ServingSessionWrapper {
   TF_DISALLOW_COPY_AND_ASSIGN(SessionWrapperIgnoreThreadPoolOptions);
 };
 
+// Subclass of SessionWrapper which runs the Run() calls that bring no thread
+// pools of their own entirely on the calling thread (see
+// GetInlineThreadPool()). For graphs small enough that handing their ops to the
+// inter- and intra-op pools, and waking the calling thread when they are done,
+// costs more than running them.
+class SessionWrapperRunInline : public ServingSessionWrapper {
+ public:
+  explicit SessionWrapperRunInline(std::unique_ptr<Session> wrapped)
+      : ServingSessionWrapper(std::move(wrapped)),
+        inline_thread_pool_(GetInlineThreadPool()) {
+    VLOG(2) << "Created the SessionWrapperRunInline around the Session.";
+  }
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    return Run(RunOptions(), inputs, output_tensor_names, target_node_names,
+               outputs, /*run_metadata=*/nullptr);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    return Run(run_options, inputs, output_tensor_names, target_node_names,
+               outputs, run_metadata, thread::ThreadPoolOptions());
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    if (thread_pool_options.inter_op_threadpool != nullptr ||
+        thread_pool_options.intra_op_threadpool != nullptr) {
+      return ServingSessionWrapper::Run(run_options, inputs,
+                                        output_tensor_names, target_node_names,
+                                        outputs, run_metadata,
+                                        thread_pool_options);
+    }
+    thread::ThreadPoolOptions inline_thread_pool_options;
+    inline_thread_pool_options.inter_op_threadpool = inline_thread_pool_.get();
+    inline_thread_pool_options.intra_op_threadpool = inline_thread_pool_.get();
+    return ServingSessionWrapper::Run(run_options, inputs, output_tensor_names,
+                                      target_node_names, outputs, run_metadata,
+                                      inline_thread_pool_options);
+  }
+
+  // Runs inline too, and so calls 'done' before returning.
+  void RunAsync(const RunOptions& run_options,
+                const std::vector<std::pair<string, Tensor>>& inputs,
+                const std::vector<string>& output_tensor_names,
+                const std::vector<string>& target_node_names,
+                std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+                std::function<void(const Status&)> done) override {
+    ServingSession::RunAsync(run_options, inputs, output_tensor_names,
+                             target_node_names, outputs, run_metadata,
+                             std::move(done));
+  }
+
+ private:
+  const std::shared_ptr<thread::ThreadPoolInterface> inline_thread_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SessionWrapperRunInline);
+};
+
 }  // namespace serving
 }  // namespace tensorflow
 
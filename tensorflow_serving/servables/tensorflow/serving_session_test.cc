@@ -0,0 +1,246 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/threadpool_interface.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// A session that returns its feeds as fetches, through Run() or through
+// callables, and counts the calls of each.
+class EchoingSession : public Session {
+ public:
+  explicit EchoingSession(bool callables_supported)
+      : callables_supported_(callables_supported) {}
+
+  Status Create(const GraphDef& graph) override { return OkStatus(); }
+  Status Extend(const GraphDef& graph) override { return OkStatus(); }
+  Status Close() override { return OkStatus(); }
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return OkStatus();
+  }
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    ++num_runs_;
+    for (const auto& input : inputs) {
+      outputs->push_back(input.second);
+    }
+    return OkStatus();
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    return Run(inputs, output_tensor_names, target_node_names, outputs);
+  }
+
+  Status MakeCallable(const CallableOptions& callable_options,
+                      CallableHandle* out_handle) override {
+    if (!callables_supported_) {
+      return errors::Unimplemented("No callables");
+    }
+    *out_handle = num_callables_made_++;
+    return OkStatus();
+  }
+
+  Status RunCallable(CallableHandle handle,
+                     const std::vector<Tensor>& feed_tensors,
+                     std::vector<Tensor>* fetch_tensors,
+                     RunMetadata* run_metadata) override {
+    ++num_callable_runs_;
+    *fetch_tensors = feed_tensors;
+    return OkStatus();
+  }
+
+  Status ReleaseCallable(CallableHandle handle) override {
+    ++num_callables_released_;
+    return OkStatus();
+  }
+
+  int num_runs() const { return num_runs_; }
+  int num_callables_made() const { return num_callables_made_; }
+  int num_callable_runs() const { return num_callable_runs_; }
+  int num_callables_released() const { return num_callables_released_; }
+
+ private:
+  const bool callables_supported_;
+  int num_runs_ = 0;
+  int num_callables_made_ = 0;
+  int num_callable_runs_ = 0;
+  int num_callables_released_ = 0;
+};
+
+Status RunEcho(SessionCallables* callables, const RunOptions& run_options,
+               const string& input_name) {
+  std::vector<Tensor> outputs;
+  TF_RETURN_IF_ERROR(callables->Run(
+      run_options, {{input_name, test::AsScalar<float>(1)}}, {"y"}, {},
+      &outputs, /*run_metadata=*/nullptr, /*thread_pool_options=*/nullptr));
+  if (outputs.size() != 1) {
+    return errors::Internal("Expected one output, got ", outputs.size());
+  }
+  test::ExpectTensorEqual<float>(test::AsScalar<float>(1), outputs[0]);
+  return OkStatus();
+}
+
+TEST(SessionCallablesTest, ReusesCallables) {
+  EchoingSession session(/*callables_supported=*/true);
+  {
+    SessionCallables callables(&session, /*max_callables=*/2);
+    TF_ASSERT_OK(RunEcho(&callables, RunOptions(), "x"));
+    TF_ASSERT_OK(RunEcho(&callables, RunOptions(), "x"));
+    EXPECT_EQ(1, session.num_callables_made());
+    EXPECT_EQ(2, session.num_callable_runs());
+
+    // Other feeds or RunOptions get their own callables, up to the limit.
+    RunOptions run_options;
+    run_options.set_inter_op_thread_pool(1);
+    TF_ASSERT_OK(RunEcho(&callables, run_options, "x"));
+    EXPECT_EQ(2, session.num_callables_made());
+    TF_ASSERT_OK(RunEcho(&callables, RunOptions(), "z"));
+    EXPECT_EQ(2, session.num_callables_made());
+    EXPECT_EQ(1, session.num_runs());
+
+    // Runs with a timeout can't use callables.
+    run_options.set_timeout_in_ms(100);
+    TF_ASSERT_OK(RunEcho(&callables, run_options, "x"));
+    EXPECT_EQ(2, session.num_runs());
+    EXPECT_EQ(3, session.num_callable_runs());
+  }
+  EXPECT_EQ(2, session.num_callables_released());
+}
+
+TEST(SessionCallablesTest, FallsBackToRun) {
+  EchoingSession session(/*callables_supported=*/false);
+  SessionCallables callables(&session);
+  TF_ASSERT_OK(RunEcho(&callables, RunOptions(), "x"));
+  TF_ASSERT_OK(RunEcho(&callables, RunOptions(), "x"));
+  EXPECT_EQ(2, session.num_runs());
+  EXPECT_EQ(0, session.num_callable_runs());
+}
+
+TEST(ServingSessionWrapperTest, RunsThroughCallables) {
+  auto session = std::make_unique<EchoingSession>(/*callables_supported=*/true);
+  EchoingSession* raw_session = session.get();
+  ServingSessionWrapper wrapper(std::move(session));
+  std::vector<Tensor> outputs;
+  RunMetadata run_metadata;
+  TF_ASSERT_OK(wrapper.Run(RunOptions(), {{"x", test::AsScalar<float>(1)}},
+                           {"y"}, {}, &outputs, &run_metadata));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(1, raw_session->num_callable_runs());
+  EXPECT_EQ(0, raw_session->num_runs());
+}
+
+// A thread pool that drops the closures scheduled on it.
+class NoopThreadPool : public thread::ThreadPoolInterface {
+ public:
+  void Schedule(std::function<void()> fn) override {}
+  int NumThreads() const override { return 1; }
+  int CurrentThreadId() const override { return -1; }
+};
+
+// An EchoingSession that records the thread pools of its last run.
+class PoolRecordingSession : public EchoingSession {
+ public:
+  PoolRecordingSession() : EchoingSession(/*callables_supported=*/false) {}
+
+  using EchoingSession::Run;
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    last_thread_pool_options_ = thread_pool_options;
+    return Run(inputs, output_tensor_names, target_node_names, outputs);
+  }
+
+  const thread::ThreadPoolOptions& last_thread_pool_options() const {
+    return last_thread_pool_options_;
+  }
+
+ private:
+  thread::ThreadPoolOptions last_thread_pool_options_;
+};
+
+TEST(SessionWrapperRunInlineTest, RunsOnInlineThreadPools) {
+  auto session = std::make_unique<PoolRecordingSession>();
+  PoolRecordingSession* raw_session = session.get();
+  SessionWrapperRunInline wrapper(std::move(session));
+  thread::ThreadPoolInterface* const inline_pool = GetInlineThreadPool().get();
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(wrapper.Run({{"x", test::AsScalar<float>(1)}}, {"y"}, {},
+                           &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(inline_pool,
+            raw_session->last_thread_pool_options().inter_op_threadpool);
+  EXPECT_EQ(inline_pool,
+            raw_session->last_thread_pool_options().intra_op_threadpool);
+
+  // Runs with thread pools of their own keep them.
+  NoopThreadPool pool;
+  thread::ThreadPoolOptions thread_pool_options;
+  thread_pool_options.intra_op_threadpool = &pool;
+  TF_ASSERT_OK(wrapper.Run(RunOptions(), {{"x", test::AsScalar<float>(1)}},
+                           {"y"}, {}, &outputs, /*run_metadata=*/nullptr,
+                           thread_pool_options));
+  EXPECT_EQ(nullptr,
+            raw_session->last_thread_pool_options().inter_op_threadpool);
+  EXPECT_EQ(&pool,
+            raw_session->last_thread_pool_options().intra_op_threadpool);
+
+  // Asynchronous runs are done by the time RunAsync() returns.
+  bool done = false;
+  outputs.clear();
+  wrapper.RunAsync(RunOptions(), {{"x", test::AsScalar<float>(1)}}, {"y"}, {},
+                   &outputs, /*run_metadata=*/nullptr,
+                   [&done](const Status& status) {
+                     TF_EXPECT_OK(status);
+                     done = true;
+                   });
+  EXPECT_TRUE(done);
+  EXPECT_EQ(1, outputs.size());
+  EXPECT_EQ(inline_pool,
+            raw_session->last_thread_pool_options().inter_op_threadpool);
+
+  // Closures scheduled on the inline pool run before Schedule() returns.
+  int num_scheduled_runs = 0;
+  inline_pool->Schedule([&num_scheduled_runs]() { ++num_scheduled_runs; });
+  EXPECT_EQ(1, num_scheduled_runs);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,240 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/shared_memory_registry.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// A mapped range of a shared memory object, unmapped on destruction.
+class Region {
+ public:
+  Region(void* mapping, size_t mapping_size, char* data, uint64_t size)
+      : mapping_(mapping),
+        mapping_size_(mapping_size),
+        data_(data),
+        size_(size) {}
+  ~Region() { munmap(mapping_, mapping_size_); }
+
+  char* data() const { return data_; }
+  uint64_t size() const { return size_; }
+
+ private:
+  void* const mapping_;
+  const size_t mapping_size_;
+  char* const data_;
+  const uint64_t size_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Region);
+};
+
+mutex* GetRegionsMutex() {
+  static mutex* mu = new mutex();
+  return mu;
+}
+
+// Guarded by GetRegionsMutex().
+std::map<string, std::shared_ptr<const Region>>* GetRegions() {
+  static auto* regions = new std::map<string, std::shared_ptr<const Region>>();
+  return regions;
+}
+
+// Looks up the region of 'shared_tensor', and checks that the range of the
+// tensor is within it.
+Status FindRange(const SharedMemoryTensor& shared_tensor,
+                 std::shared_ptr<const Region>* region) {
+  {
+    mutex_lock l(*GetRegionsMutex());
+    auto it = GetRegions()->find(shared_tensor.region_name());
+    if (it == GetRegions()->end()) {
+      return errors::NotFound("No shared memory region named ",
+                              shared_tensor.region_name());
+    }
+    *region = it->second;
+  }
+  if (shared_tensor.offset() > (*region)->size() ||
+      shared_tensor.byte_size() > (*region)->size() - shared_tensor.offset()) {
+    return errors::InvalidArgument(
+        "The range of ", shared_tensor.byte_size(), " bytes at ",
+        shared_tensor.offset(), " is outside the shared memory region ",
+        shared_tensor.region_name(), " of ", (*region)->size(), " bytes");
+  }
+  return OkStatus();
+}
+
+// A TensorBuffer over a range of a region, which it keeps mapped.
+class SharedMemoryTensorBuffer : public TensorBuffer {
+ public:
+  SharedMemoryTensorBuffer(std::shared_ptr<const Region> region, char* data,
+                           size_t size)
+      : TensorBuffer(data), region_(std::move(region)), size_(size) {}
+
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name("SharedMemory");
+  }
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<const Region> region_;
+  const size_t size_;
+};
+
+}  // namespace
+
+Status SharedMemoryRegistry::Register(const string& name, const string& key,
+                                      uint64_t offset, uint64_t byte_size) {
+  if (name.empty()) {
+    return errors::InvalidArgument("Shared memory regions must have a name");
+  }
+  if (byte_size == 0) {
+    return errors::InvalidArgument("The shared memory region ", name,
+                                   " is empty");
+  }
+  const int fd = shm_open(key.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    return errors::InvalidArgument("Unable to open the shared memory object ",
+                                   key, ": ", strerror(errno));
+  }
+  // Accessing a mapping past the end of the object raises SIGBUS.
+  struct stat object_stat;
+  if (fstat(fd, &object_stat) != 0) {
+    const int fstat_errno = errno;
+    close(fd);
+    return errors::InvalidArgument("Unable to stat the shared memory object ",
+                                   key, ": ", strerror(fstat_errno));
+  }
+  const uint64_t object_size = object_stat.st_size;
+  if (offset > object_size || byte_size > object_size - offset) {
+    close(fd);
+    return errors::InvalidArgument(
+        "The range of ", byte_size, " bytes at ", offset,
+        " is outside the shared memory object ", key, " of ", object_size,
+        " bytes");
+  }
+  // mmap() takes offsets in whole pages.
+  const uint64_t page_size = sysconf(_SC_PAGESIZE);
+  const uint64_t mapping_offset = offset - offset % page_size;
+  const size_t mapping_size = byte_size + (offset - mapping_offset);
+  void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, mapping_offset);
+  const int mmap_errno = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return errors::InvalidArgument("Unable to map ", byte_size, " bytes at ",
+                                   offset, " of the shared memory object ",
+                                   key, ": ", strerror(mmap_errno));
+  }
+  auto region = std::make_shared<const Region>(
+      mapping, mapping_size,
+      static_cast<char*>(mapping) + (offset - mapping_offset), byte_size);
+
+  mutex_lock l(*GetRegionsMutex());
+  if (!GetRegions()->emplace(name, std::move(region)).second) {
+    return errors::AlreadyExists("There is a shared memory region named ",
+                                 name);
+  }
+  return OkStatus();
+}
+
+Status SharedMemoryRegistry::Unregister(const string& name) {
+  mutex_lock l(*GetRegionsMutex());
+  if (GetRegions()->erase(name) == 0) {
+    return errors::NotFound("No shared memory region named ", name);
+  }
+  return OkStatus();
+}
+
+Status SharedMemoryRegistry::ReadTensor(const SharedMemoryTensor& shared_tensor,
+                                        Tensor* tensor) {
+  const DataType dtype = shared_tensor.dtype();
+  if (!DataTypeCanUseMemcpy(dtype)) {
+    return errors::InvalidArgument("Tensors of type ", DataTypeString(dtype),
+                                   " can't be read from shared memory");
+  }
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(
+      TensorShape::BuildTensorShape(shared_tensor.tensor_shape(), &shape));
+  if (shared_tensor.byte_size() !=
+      static_cast<uint64_t>(shape.num_elements()) * DataTypeSize(dtype)) {
+    return errors::InvalidArgument(
+        "A tensor of type ", DataTypeString(dtype), " and shape ",
+        shape.DebugString(), " can't have ", shared_tensor.byte_size(),
+        " bytes");
+  }
+  std::shared_ptr<const Region> region;
+  TF_RETURN_IF_ERROR(FindRange(shared_tensor, &region));
+  char* data = region->data() + shared_tensor.offset();
+  auto* buffer = new SharedMemoryTensorBuffer(region, data,
+                                              shared_tensor.byte_size());
+  Tensor aliased(dtype, shape, buffer);
+  buffer->Unref();
+  if (aliased.IsAligned()) {
+    *tensor = std::move(aliased);
+    return OkStatus();
+  }
+  Tensor copy(dtype, shape);
+  if (shared_tensor.byte_size() > 0) {
+    std::memcpy(const_cast<char*>(copy.tensor_data().data()), data,
+                shared_tensor.byte_size());
+  }
+  *tensor = std::move(copy);
+  return OkStatus();
+}
+
+Status SharedMemoryRegistry::WriteTensor(
+    const Tensor& tensor, const SharedMemoryTensor& shared_tensor) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype())) {
+    return errors::InvalidArgument("Tensors of type ",
+                                   DataTypeString(tensor.dtype()),
+                                   " can't be written to shared memory");
+  }
+  std::shared_ptr<const Region> region;
+  TF_RETURN_IF_ERROR(FindRange(shared_tensor, &region));
+  const StringPiece bytes = tensor.tensor_data();
+  if (bytes.size() > shared_tensor.byte_size()) {
+    return errors::InvalidArgument(
+        "A tensor of ", bytes.size(), " bytes doesn't fit in the ",
+        shared_tensor.byte_size(), " bytes given for it in the shared memory "
+        "region ", shared_tensor.region_name());
+  }
+  if (!bytes.empty()) {
+    std::memcpy(region->data() + shared_tensor.offset(), bytes.data(),
+                bytes.size());
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,73 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SHARED_MEMORY_REGISTRY_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SHARED_MEMORY_REGISTRY_H_
+
+#include <cstdint>
+#include <string>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow_serving/apis/shared_memory.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The shared memory regions that clients on the host of the server have
+// registered (see SharedMemoryService), by name, for the tensors of their
+// requests to be passed through.
+//
+// A region stays mapped while tensors aliasing it are alive, even once it is
+// unregistered. The server does not synchronize access to the regions with the
+// clients: a client must not write to the inputs of a request, or read its
+// outputs, before the request is responded to.
+//
+// The regions are in one namespace for the whole process, so any client can
+// use, unregister or (once unregistered) replace the region of another, and a
+// client that shrinks its shared memory object while it is registered crashes
+// the server. Hence only the clients that connect over the UNIX socket of the
+// server may use shared memory (see IsSharedMemoryPeer()): they have access to
+// the socket file, and are trusted alike.
+//
+// This class is thread-safe.
+class SharedMemoryRegistry {
+ public:
+  // Maps 'byte_size' bytes of the POSIX shared memory object 'key', from
+  // 'offset', as the region 'name'. Returns an AlreadyExists error if there
+  // is a region by that name, and an InvalidArgument error if the range is
+  // not within the object.
+  static Status Register(const string& name, const string& key,
+                         uint64_t offset, uint64_t byte_size);
+
+  // Unregisters the region 'name'. Returns a NotFound error if there is no
+  // such region.
+  static Status Unregister(const string& name);
+
+  // Sets 'tensor' to the input 'shared_tensor'. The tensor aliases the region
+  // if its offset in it is aligned as tensors require, and is a copy
+  // otherwise.
+  static Status ReadTensor(const SharedMemoryTensor& shared_tensor,
+                           Tensor* tensor);
+
+  // Copies 'tensor' into the room of the output 'shared_tensor'.
+  static Status WriteTensor(const Tensor& tensor,
+                            const SharedMemoryTensor& shared_tensor);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SHARED_MEMORY_REGISTRY_H_
@@ -0,0 +1,175 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/shared_memory_registry.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+
+constexpr char kKey[] = "/shared_memory_registry_test";
+constexpr size_t kSize = 4096;
+
+class SharedMemoryRegistryTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const int fd = shm_open(kKey, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, ftruncate(fd, kSize));
+    void* mapping =
+        mmap(nullptr, kSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, mapping);
+    data_ = static_cast<char*>(mapping);
+  }
+
+  void TearDown() override {
+    munmap(data_, kSize);
+    shm_unlink(kKey);
+  }
+
+  // The client's mapping of the shared memory object.
+  char* data_ = nullptr;
+};
+
+TEST_F(SharedMemoryRegistryTest, ReadAndWriteTensors) {
+  TF_ASSERT_OK(SharedMemoryRegistry::Register("region", kKey, 0, kSize));
+  EXPECT_EQ(error::ALREADY_EXISTS,
+            SharedMemoryRegistry::Register("region", kKey, 0, kSize).code());
+
+  const float input[] = {1, 2, 3, 4};
+  std::memcpy(data_ + 64, input, sizeof(input));
+  Tensor tensor;
+  TF_ASSERT_OK(SharedMemoryRegistry::ReadTensor(
+      CreateProto<SharedMemoryTensor>("region_name: 'region' "
+                                      "offset: 64 "
+                                      "byte_size: 16 "
+                                      "dtype: DT_FLOAT "
+                                      "tensor_shape { dim { size: 2 } "
+                                      "               dim { size: 2 } }"),
+      &tensor));
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({1, 2, 3, 4}, TensorShape({2, 2})), tensor);
+  // The aligned input aliases the region, so sees the writes of the client.
+  const float update = 9;
+  std::memcpy(data_ + 64, &update, sizeof(update));
+  EXPECT_EQ(9, tensor.flat<float>()(0));
+
+  // Unaligned inputs are copied.
+  std::memcpy(data_ + 4, input, sizeof(input));
+  TF_ASSERT_OK(SharedMemoryRegistry::ReadTensor(
+      CreateProto<SharedMemoryTensor>("region_name: 'region' "
+                                      "offset: 4 "
+                                      "byte_size: 16 "
+                                      "dtype: DT_FLOAT "
+                                      "tensor_shape { dim { size: 4 } }"),
+      &tensor));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2, 3, 4}), tensor);
+
+  TF_ASSERT_OK(SharedMemoryRegistry::WriteTensor(
+      test::AsTensor<int32>({5, 6}),
+      CreateProto<SharedMemoryTensor>("region_name: 'region' "
+                                      "offset: 128 "
+                                      "byte_size: 16")));
+  int32 output[2];
+  std::memcpy(output, data_ + 128, sizeof(output));
+  EXPECT_EQ(5, output[0]);
+  EXPECT_EQ(6, output[1]);
+
+  TF_ASSERT_OK(SharedMemoryRegistry::Unregister("region"));
+  EXPECT_EQ(error::NOT_FOUND,
+            SharedMemoryRegistry::Unregister("region").code());
+}
+
+TEST_F(SharedMemoryRegistryTest, RejectsRangesOutsideTheObject) {
+  EXPECT_EQ(
+      error::INVALID_ARGUMENT,
+      SharedMemoryRegistry::Register("region", kKey, 0, kSize + 1).code());
+  EXPECT_EQ(error::INVALID_ARGUMENT,
+            SharedMemoryRegistry::Register("region", kKey, kSize, 1).code());
+  EXPECT_EQ(
+      error::INVALID_ARGUMENT,
+      SharedMemoryRegistry::Register("region", kKey, kSize + 4096, 1).code());
+  // None of them was registered.
+  EXPECT_EQ(error::NOT_FOUND,
+            SharedMemoryRegistry::Unregister("region").code());
+  TF_ASSERT_OK(SharedMemoryRegistry::Register("region", kKey, kSize - 1, 1));
+  TF_ASSERT_OK(SharedMemoryRegistry::Unregister("region"));
+}
+
+TEST_F(SharedMemoryRegistryTest, RejectsInvalidTensors) {
+  TF_ASSERT_OK(SharedMemoryRegistry::Register("region", kKey, 0, kSize));
+  Tensor tensor;
+  // Unknown region.
+  EXPECT_EQ(error::NOT_FOUND,
+            SharedMemoryRegistry::ReadTensor(
+                CreateProto<SharedMemoryTensor>("region_name: 'bogus' "
+                                                "byte_size: 4 "
+                                                "dtype: DT_FLOAT "
+                                                "tensor_shape { dim { size: "
+                                                "1 } }"),
+                &tensor)
+                .code());
+  // Out of the region.
+  EXPECT_FALSE(SharedMemoryRegistry::ReadTensor(
+                   CreateProto<SharedMemoryTensor>(
+                       "region_name: 'region' "
+                       "offset: 4094 "
+                       "byte_size: 4 "
+                       "dtype: DT_FLOAT "
+                       "tensor_shape { dim { size: 1 } }"),
+                   &tensor)
+                   .ok());
+  // Size not matching the shape.
+  EXPECT_FALSE(SharedMemoryRegistry::ReadTensor(
+                   CreateProto<SharedMemoryTensor>(
+                       "region_name: 'region' "
+                       "byte_size: 8 "
+                       "dtype: DT_FLOAT "
+                       "tensor_shape { dim { size: 1 } }"),
+                   &tensor)
+                   .ok());
+  // Strings can't be passed in shared memory.
+  EXPECT_FALSE(SharedMemoryRegistry::WriteTensor(
+                   test::AsTensor<tstring>({"a"}),
+                   CreateProto<SharedMemoryTensor>("region_name: 'region' "
+                                                   "byte_size: 64"))
+                   .ok());
+  // Output too large.
+  EXPECT_FALSE(SharedMemoryRegistry::WriteTensor(
+                   test::AsTensor<float>({1, 2}),
+                   CreateProto<SharedMemoryTensor>("region_name: 'region' "
+                                                   "byte_size: 4"))
+                   .ok());
+  TF_ASSERT_OK(SharedMemoryRegistry::Unregister("region"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,146 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/slow_requests.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+void SetRequest(const ClassificationRequest& request, PredictionLog* log) {
+  *log->mutable_classify_log()->mutable_request() = request;
+}
+
+void SetRequest(const RegressionRequest& request, PredictionLog* log) {
+  *log->mutable_regress_log()->mutable_request() = request;
+}
+
+void SetRequest(const PredictRequest& request, PredictionLog* log) {
+  *log->mutable_predict_log()->mutable_request() = request;
+}
+
+}  // namespace
+
+SlowRequests* SlowRequests::Global() {
+  static SlowRequests* const slow_requests = new SlowRequests();
+  return slow_requests;
+}
+
+void SlowRequests::Enable(const Options& options) {
+  mutex_lock l(mu_);
+  options_ = options;
+  for (auto& entry : models_) {
+    Evict(0, entry.second.get());
+  }
+  latency_threshold_micros_.store(options.latency_threshold_micros,
+                                  std::memory_order_relaxed);
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void SlowRequests::Capture(const string& model_name,
+                           const ClassificationRequest& request,
+                           const RequestLatency& latency) {
+  CaptureRequest(model_name, request, latency);
+}
+
+void SlowRequests::Capture(const string& model_name,
+                           const RegressionRequest& request,
+                           const RequestLatency& latency) {
+  CaptureRequest(model_name, request, latency);
+}
+
+void SlowRequests::Capture(const string& model_name,
+                           const PredictRequest& request,
+                           const RequestLatency& latency) {
+  CaptureRequest(model_name, request, latency);
+}
+
+template <typename Request>
+void SlowRequests::CaptureRequest(const string& model_name,
+                                  const Request& request,
+                                  const RequestLatency& latency) {
+  if (!enabled()) return;
+  // Serializes the request outside of the lock.
+  PredictionLog log;
+  LogMetadata* log_metadata = log.mutable_log_metadata();
+  *log_metadata->mutable_model_spec() = request.model_spec();
+  log_metadata->set_timestamp_secs(Env::Default()->NowSeconds());
+  *log_metadata->mutable_latency() = latency;
+  SetRequest(request, &log);
+  tstring record;
+  if (!log.SerializeToString(&record)) {
+    return;
+  }
+
+  mutex_lock l(mu_);
+  if (static_cast<int64_t>(record.size()) > options_.max_bytes_per_model ||
+      options_.max_requests_per_model <= 0) {
+    return;
+  }
+  std::unique_ptr<Model>& model = models_[model_name];
+  if (model == nullptr) {
+    model.reset(new Model());
+  }
+  Evict(record.size(), model.get());
+  model->num_bytes += record.size();
+  model->records.push_back(std::move(record));
+}
+
+void SlowRequests::Evict(const int64_t num_new_bytes, Model* model) const {
+  const int max_requests =
+      options_.max_requests_per_model - (num_new_bytes > 0 ? 1 : 0);
+  while (!model->records.empty() &&
+         (static_cast<int>(model->records.size()) > max_requests ||
+          model->num_bytes + num_new_bytes > options_.max_bytes_per_model)) {
+    model->num_bytes -= model->records.front().size();
+    model->records.pop_front();
+  }
+}
+
+std::vector<tstring> SlowRequests::GetRecords(const string& model_name) const {
+  mutex_lock l(mu_);
+  auto it = models_.find(model_name);
+  if (it == models_.end()) {
+    return {};
+  }
+  return std::vector<tstring>(it->second->records.begin(),
+                              it->second->records.end());
+}
+
+std::vector<std::pair<string, int>> SlowRequests::GetModels() const {
+  std::vector<std::pair<string, int>> models;
+  mutex_lock l(mu_);
+  for (const auto& entry : models_) {
+    if (!entry.second->records.empty()) {
+      models.emplace_back(entry.first, entry.second->records.size());
+    }
+  }
+  std::sort(models.begin(), models.end());
+  return models;
+}
+
+void SlowRequests::Clear() {
+  mutex_lock l(mu_);
+  models_.clear();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
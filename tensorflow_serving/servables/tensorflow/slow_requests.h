@@ -0,0 +1,140 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SLOW_REQUESTS_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SLOW_REQUESTS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_serving/apis/classification.pb.h"
+#include "tensorflow_serving/apis/logging.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+#include "tensorflow_serving/apis/regression.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Captures the requests to each model that took longer than a threshold to
+// serve, with the breakdown of their latency, so that tail latency spikes can
+// be investigated after the fact: the captured requests are served over the
+// HTTP port as PredictionLogs, with the latency in their LogMetadata, which
+// the replay mode of the load generator sends again one at a time.
+//
+// The requests of each model are kept in a ring buffer bounded in number and in
+// size; when a new request does not fit, the oldest are evicted.
+//
+// This class is thread-safe.
+class SlowRequests {
+ public:
+  struct Options {
+    // Requests that took at least this long are captured.
+    int64_t latency_threshold_micros = 1000 * 1000;
+
+    // The maximum number of requests kept per model.
+    int max_requests_per_model = 100;
+
+    // The maximum total size of the serialized requests kept per model.
+    int64_t max_bytes_per_model = 16 << 20;
+  };
+
+  // Constructs an instance that captures nothing until Enable() is called.
+  SlowRequests() = default;
+  ~SlowRequests() = default;
+
+  // Returns the instance of the process, which request handlers capture
+  // into.
+  static SlowRequests* Global();
+
+  // Starts capturing requests, with the bounds of 'options'. Requests
+  // captured already are kept until they are evicted under the new bounds.
+  void Enable(const Options& options) TF_LOCKS_EXCLUDED(mu_);
+
+  bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Returns whether a request that took 'latency_micros' to serve is to be
+  // captured. Cheap, so that callers check it before gathering the arguments
+  // of Capture(). False unless enabled().
+  bool IsSlow(int64_t latency_micros) const {
+    return enabled() &&
+           latency_micros >=
+               latency_threshold_micros_.load(std::memory_order_relaxed);
+  }
+
+  // Captures 'request', served by the model 'model_name' in 'latency'.
+  void Capture(const string& model_name, const ClassificationRequest& request,
+               const RequestLatency& latency) TF_LOCKS_EXCLUDED(mu_);
+  void Capture(const string& model_name, const RegressionRequest& request,
+               const RequestLatency& latency) TF_LOCKS_EXCLUDED(mu_);
+  void Capture(const string& model_name, const PredictRequest& request,
+               const RequestLatency& latency) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the serialized PredictionLogs of the requests captured for
+  // 'model_name', oldest first.
+  std::vector<tstring> GetRecords(const string& model_name) const
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the names of the models that have captured requests, and how many
+  // each has.
+  std::vector<std::pair<string, int>> GetModels() const TF_LOCKS_EXCLUDED(mu_);
+
+  // Drops the requests captured for all models.
+  void Clear() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // The captured requests of a model, oldest first.
+  struct Model {
+    std::deque<tstring> records;
+    int64_t num_bytes = 0;
+  };
+
+  template <typename Request>
+  void CaptureRequest(const string& model_name, const Request& request,
+                      const RequestLatency& latency) TF_LOCKS_EXCLUDED(mu_);
+
+  // Evicts the oldest requests of 'model' until a new request of
+  // 'num_new_bytes' fits in the bounds or, if 'num_new_bytes' is 0, until the
+  // requests fit in them.
+  void Evict(int64_t num_new_bytes, Model* model) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::atomic<bool> enabled_{false};
+  std::atomic<int64_t> latency_threshold_micros_{0};
+
+  mutable mutex mu_;
+
+  Options options_ TF_GUARDED_BY(mu_);
+
+  absl::flat_hash_map<string, std::unique_ptr<Model>> models_
+      TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SlowRequests);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_SLOW_REQUESTS_H_
@@ -0,0 +1,130 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/slow_requests.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow_serving/apis/classification.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+PredictRequest CreatePredictRequest(const int batch_size) {
+  PredictRequest request;
+  request.mutable_model_spec()->set_name("m");
+  TensorProto& tensor = (*request.mutable_inputs())["x"];
+  tensor.set_dtype(DT_FLOAT);
+  tensor.mutable_tensor_shape()->add_dim()->set_size(batch_size);
+  for (int i = 0; i < batch_size; ++i) {
+    tensor.add_float_val(i);
+  }
+  return request;
+}
+
+RequestLatency CreateLatency(const int64_t total_micros) {
+  RequestLatency latency;
+  latency.set_total_micros(total_micros);
+  RequestLatency::Stage* stage = latency.add_stages();
+  stage->set_name("run");
+  stage->set_micros(total_micros);
+  return latency;
+}
+
+std::vector<PredictionLog> GetLogs(const SlowRequests& slow_requests,
+                                   const string& model_name) {
+  std::vector<PredictionLog> logs;
+  for (const tstring& record : slow_requests.GetRecords(model_name)) {
+    logs.emplace_back();
+    EXPECT_TRUE(logs.back().ParseFromArray(record.data(), record.size()));
+  }
+  return logs;
+}
+
+TEST(SlowRequestsTest, CapturesNothingUntilEnabled) {
+  SlowRequests slow_requests;
+  EXPECT_FALSE(slow_requests.IsSlow(int64_t{1} << 40));
+  slow_requests.Capture("m", CreatePredictRequest(1), CreateLatency(100));
+  EXPECT_TRUE(slow_requests.GetRecords("m").empty());
+}
+
+TEST(SlowRequestsTest, CapturesRequestsWithLatency) {
+  SlowRequests slow_requests;
+  SlowRequests::Options options;
+  options.latency_threshold_micros = 1000;
+  slow_requests.Enable(options);
+  EXPECT_FALSE(slow_requests.IsSlow(999));
+  EXPECT_TRUE(slow_requests.IsSlow(1000));
+
+  slow_requests.Capture("m", CreatePredictRequest(2), CreateLatency(1500));
+  ClassificationRequest classification_request;
+  classification_request.mutable_model_spec()->set_name("c");
+  slow_requests.Capture("c", classification_request, CreateLatency(2000));
+
+  const std::vector<PredictionLog> logs = GetLogs(slow_requests, "m");
+  ASSERT_EQ(1, logs.size());
+  EXPECT_EQ("m", logs[0].log_metadata().model_spec().name());
+  EXPECT_GT(logs[0].log_metadata().timestamp_secs(), 0);
+  EXPECT_EQ(1500, logs[0].log_metadata().latency().total_micros());
+  EXPECT_EQ("run", logs[0].log_metadata().latency().stages(0).name());
+  EXPECT_EQ(
+      2, logs[0].predict_log().request().inputs().at("x").float_val_size());
+  EXPECT_TRUE(GetLogs(slow_requests, "c")[0].has_classify_log());
+
+  EXPECT_EQ((std::vector<std::pair<string, int>>{{"c", 1}, {"m", 1}}),
+            slow_requests.GetModels());
+  slow_requests.Clear();
+  EXPECT_TRUE(slow_requests.GetModels().empty());
+}
+
+TEST(SlowRequestsTest, EvictsOldestRequests) {
+  SlowRequests slow_requests;
+  SlowRequests::Options options;
+  options.latency_threshold_micros = 0;
+  options.max_requests_per_model = 2;
+  slow_requests.Enable(options);
+  for (int i = 1; i <= 3; ++i) {
+    slow_requests.Capture("m", CreatePredictRequest(1), CreateLatency(i));
+  }
+  std::vector<PredictionLog> logs = GetLogs(slow_requests, "m");
+  ASSERT_EQ(2, logs.size());
+  EXPECT_EQ(2, logs[0].log_metadata().latency().total_micros());
+  EXPECT_EQ(3, logs[1].log_metadata().latency().total_micros());
+
+  // Bounded in size too: there is only room for one large request.
+  const int64_t large_size = CreatePredictRequest(1000).ByteSizeLong();
+  options.max_bytes_per_model = large_size * 3 / 2;
+  slow_requests.Enable(options);
+  slow_requests.Capture("m", CreatePredictRequest(1000), CreateLatency(4));
+  slow_requests.Capture("m", CreatePredictRequest(1000), CreateLatency(5));
+  logs = GetLogs(slow_requests, "m");
+  ASSERT_EQ(1, logs.size());
+  EXPECT_EQ(5, logs[0].log_metadata().latency().total_micros());
+
+  // Requests larger than the bound are not captured.
+  slow_requests.Capture("m", CreatePredictRequest(2000), CreateLatency(6));
+  EXPECT_EQ(1, GetLogs(slow_requests, "m").size());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -15,13 +15,23 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/tflite_interpreter_pool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/threadpool.h"
+#ifdef TFLITE_GPU_DELEGATE
+#include "tensorflow/lite/delegates/gpu/delegate.h"
+#endif
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
 #include "tensorflow/lite/external_cpu_backend_context.h"
 #include "tensorflow/lite/kernels/cpu_backend_context.h"
 #include "tensorflow/lite/kernels/parse_example/parse_example.h"
@@ -30,6 +40,59 @@ limitations under the License.
 namespace tensorflow {
 namespace serving {
 namespace internal {
+namespace {
+
+bool HasDelegates(const TfLiteDelegateConfig& delegate_config) {
+  return delegate_config.has_xnnpack() || delegate_config.has_gpu();
+}
+
+// Applies the delegates of `delegate_config` to `interpreter`, GPU first so
+// that XNNPACK only takes the ops left on the CPU.
+Status ApplyDelegates(const TfLiteDelegateConfig& delegate_config,
+                      tflite::Interpreter* interpreter) {
+  if (delegate_config.has_gpu()) {
+#ifdef TFLITE_GPU_DELEGATE
+    TfLiteGpuDelegateOptionsV2 gpu_options =
+        TfLiteGpuDelegateOptionsV2Default();
+    if (delegate_config.gpu().allow_precision_loss()) {
+      gpu_options.is_precision_loss_allowed = 1;
+    }
+    tflite::Interpreter::TfLiteDelegatePtr delegate(
+        TfLiteGpuDelegateV2Create(&gpu_options), &TfLiteGpuDelegateV2Delete);
+    if (interpreter->ModifyGraphWithDelegate(std::move(delegate)) !=
+        kTfLiteOk) {
+      return errors::Internal("Failed to apply the TFLite GPU delegate");
+    }
+#else
+    return errors::Unimplemented(
+        "The TFLite GPU delegate is not built in; build with "
+        "--define=tflite_gpu_delegate=true");
+#endif
+  }
+  if (delegate_config.has_xnnpack()) {
+    const TfLiteDelegateConfig::Xnnpack& config = delegate_config.xnnpack();
+    TfLiteXNNPackDelegateOptions xnnpack_options =
+        TfLiteXNNPackDelegateOptionsDefault();
+    xnnpack_options.num_threads = std::max(1, config.num_threads());
+    if (config.force_fp16()) {
+      xnnpack_options.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16;
+    }
+    if (config.enable_quantized()) {
+      xnnpack_options.flags |=
+          TFLITE_XNNPACK_DELEGATE_FLAG_QS8 | TFLITE_XNNPACK_DELEGATE_FLAG_QU8;
+    }
+    tflite::Interpreter::TfLiteDelegatePtr delegate(
+        TfLiteXNNPackDelegateCreate(&xnnpack_options),
+        &TfLiteXNNPackDelegateDelete);
+    if (interpreter->ModifyGraphWithDelegate(std::move(delegate)) !=
+        kTfLiteOk) {
+      return errors::Internal("Failed to apply the TFLite XNNPACK delegate");
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace
 
 TfLiteInterpreterWrapper::TfLiteInterpreterWrapper(
     std::unique_ptr<tflite::ExternalCpuBackendContext> external_context,
@@ -143,18 +206,43 @@ TfLiteStatus TfLiteInterpreterWrapper::Invoke() {
 tensorflow::Status TfLiteInterpreterWrapper::CreateTfLiteInterpreterWrapper(
     const tflite::FlatBufferModel& model,
     const tensorflow::SessionOptions& options,
+    const TfLiteDelegateConfig& delegate_config,
+    const std::vector<int>& specialized_batch_sizes,
     std::unique_ptr<TfLiteInterpreterWrapper>& wrapper) {
-  tflite::ops::builtin::BuiltinOpResolver resolver;
-  tflite::ops::custom::AddParseExampleOp(&resolver);
+  // Use an initial batch_size of 1, will be resized later.
+  TF_RETURN_IF_ERROR(CreateForBatchSize(model, options, delegate_config,
+                                        /*batch_size=*/1,
+                                        /*specialized=*/false, wrapper));
+  for (const int specialized_batch_size : specialized_batch_sizes) {
+    TF_RETURN_IF_ERROR(CreateForBatchSize(
+        model, options, delegate_config, specialized_batch_size,
+        /*specialized=*/true, wrapper->specialized_[specialized_batch_size]));
+  }
+  return tensorflow::OkStatus();
+}
+
+tensorflow::Status TfLiteInterpreterWrapper::CreateForBatchSize(
+    const tflite::FlatBufferModel& model,
+    const tensorflow::SessionOptions& options,
+    const TfLiteDelegateConfig& delegate_config, int batch_size,
+    bool specialized, std::unique_ptr<TfLiteInterpreterWrapper>& wrapper) {
+  // The configured delegates replace the default ones, which would otherwise
+  // claim the ops first.
+  std::unique_ptr<tflite::ops::builtin::BuiltinOpResolver> resolver;
+  if (HasDelegates(delegate_config)) {
+    resolver = absl::make_unique<
+        tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates>();
+  } else {
+    resolver = absl::make_unique<tflite::ops::builtin::BuiltinOpResolver>();
+  }
+  tflite::ops::custom::AddParseExampleOp(resolver.get());
   std::unique_ptr<tflite::Interpreter> interpreter;
 
-  // Use an initial batch_size of 1, will be resized later.
-  const int batch_size = 1;
   // Use a single thread to reduce contention across sessions.
   const int num_threads = 1;
 
-  if (tflite::InterpreterBuilder(model, resolver)(&interpreter, num_threads) !=
-      kTfLiteOk) {
+  if (tflite::InterpreterBuilder(model, *resolver)(&interpreter,
+                                                   num_threads) != kTfLiteOk) {
     return errors::Internal(
         "Failed to create a TFLite interpreter with the given model");
   }
@@ -168,10 +256,21 @@ tensorflow::Status TfLiteInterpreterWrapper::CreateTfLiteInterpreterWrapper(
       std::move(cpu_backend_context));
   interpreter->SetExternalContext(kTfLiteCpuBackendContext,
                                   external_context.get());
-  const int idx = interpreter->inputs()[0];
-  const auto* tensor = interpreter->tensor(idx);
-  if (tensor->type == kTfLiteString) {
-    if (interpreter->ResizeInputTensor(idx, {batch_size}) != kTfLiteOk) {
+  TF_RETURN_IF_ERROR(ApplyDelegates(delegate_config, interpreter.get()));
+  // String inputs are batched along their only dimension. A specialized
+  // interpreter also gets the batch dimension of its other inputs resized.
+  for (const int idx : interpreter->inputs()) {
+    const auto* tensor = interpreter->tensor(idx);
+    std::vector<int> dims;
+    if (tensor->type == kTfLiteString) {
+      dims = {batch_size};
+    } else if (specialized && tensor->dims->size > 0) {
+      dims.assign(tensor->dims->data, tensor->dims->data + tensor->dims->size);
+      dims[0] = batch_size;
+    } else {
+      continue;
+    }
+    if (interpreter->ResizeInputTensor(idx, dims) != kTfLiteOk) {
       return errors::Internal("Failed to resize input");
     }
   }
@@ -180,24 +279,128 @@ tensorflow::Status TfLiteInterpreterWrapper::CreateTfLiteInterpreterWrapper(
   }
   wrapper.reset(new TfLiteInterpreterWrapper(std::move(external_context),
                                              std::move(interpreter)));
+  wrapper->SetBatchSize(batch_size);
   return tensorflow::OkStatus();
 }
 
+TfLiteInterpreterWrapper* TfLiteInterpreterWrapper::Specialize(
+    int batch_size) {
+  auto it = specialized_.find(batch_size);
+  return it == specialized_.end() ? this : it->second.get();
+}
+
 tensorflow::Status TfLiteInterpreterPool::CreateTfLiteInterpreterPool(
     const tflite::FlatBufferModel* model,
     const tensorflow::SessionOptions& options, int pool_size,
     std::unique_ptr<TfLiteInterpreterPool>& interpreter_pool) {
+  return CreateTfLiteInterpreterPool(model, options, TfLiteDelegateConfig(),
+                                     {}, pool_size, interpreter_pool);
+}
+
+tensorflow::Status TfLiteInterpreterPool::CreateTfLiteInterpreterPool(
+    const tflite::FlatBufferModel* model,
+    const tensorflow::SessionOptions& options,
+    const TfLiteDelegateConfig& delegate_config,
+    const std::vector<int>& specialized_batch_sizes, int pool_size,
+    std::unique_ptr<TfLiteInterpreterPool>& interpreter_pool) {
   std::vector<std::unique_ptr<TfLiteInterpreterWrapper>> interpreters(
       pool_size);
-  for (int i = 0; i < pool_size; i++) {
-    auto& wrapper = interpreters[i];
-    TF_RETURN_IF_ERROR(TfLiteInterpreterWrapper::CreateTfLiteInterpreterWrapper(
-        *model, options, wrapper));
+  std::vector<Status> statuses(pool_size);
+  {
+    // Joins the threads on destruction.
+    thread::ThreadPool pool(Env::Default(), "tflite_interpreter_pool_create",
+                            std::max(1, std::min(pool_size,
+                                                 port::MaxParallelism())));
+    for (int i = 0; i < pool_size; i++) {
+      pool.Schedule([&, i]() {
+        statuses[i] = TfLiteInterpreterWrapper::CreateTfLiteInterpreterWrapper(
+            *model, options, delegate_config, specialized_batch_sizes,
+            interpreters[i]);
+      });
+    }
+  }
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
   }
   interpreter_pool.reset(new TfLiteInterpreterPool(std::move(interpreters)));
   return tensorflow::OkStatus();
 }
 
+TfLiteInterpreterPool::TfLiteInterpreterPool(
+    std::vector<std::unique_ptr<TfLiteInterpreterWrapper>> interpreters)
+    : num_slots_(interpreters.size()),
+      slots_(new std::atomic<TfLiteInterpreterWrapper*>[interpreters.size()]) {
+  for (int i = 0; i < num_slots_; ++i) {
+    slots_[i].store(interpreters[i].release(), std::memory_order_relaxed);
+  }
+}
+
+TfLiteInterpreterPool::~TfLiteInterpreterPool() {
+  for (int i = 0; i < num_slots_; ++i) {
+    delete slots_[i].load(std::memory_order_relaxed);
+  }
+}
+
+int TfLiteInterpreterPool::HomeSlot() const {
+  // Threads get consecutive home slots in the order they first use a pool.
+  static std::atomic<int> next_thread_index{0};
+  thread_local const int thread_index =
+      next_thread_index.fetch_add(1, std::memory_order_relaxed);
+  return thread_index % num_slots_;
+}
+
+TfLiteInterpreterWrapper* TfLiteInterpreterPool::TryTake() {
+  const int home_slot = HomeSlot();
+  for (int i = 0; i < num_slots_; ++i) {
+    std::atomic<TfLiteInterpreterWrapper*>& slot =
+        slots_[(home_slot + i) % num_slots_];
+    // Skips empty slots without the cost of taking their cache line.
+    if (slot.load(std::memory_order_relaxed) == nullptr) {
+      continue;
+    }
+    if (TfLiteInterpreterWrapper* interpreter = slot.exchange(nullptr)) {
+      return interpreter;
+    }
+  }
+  return nullptr;
+}
+
+std::unique_ptr<TfLiteInterpreterWrapper>
+TfLiteInterpreterPool::GetInterpreter() {
+  if (TfLiteInterpreterWrapper* interpreter = TryTake()) {
+    return absl::WrapUnique(interpreter);
+  }
+  absl::MutexLock l(&mutex_);
+  // A returner checks `num_waiters_` after refilling its slot, so either it
+  // sees this waiter and takes the mutex to signal it, or the retry below sees
+  // the refilled slot.
+  num_waiters_.fetch_add(1);
+  TfLiteInterpreterWrapper* interpreter;
+  while ((interpreter = TryTake()) == nullptr) {
+    interpreter_returned_.Wait(&mutex_);
+  }
+  num_waiters_.fetch_sub(1);
+  return absl::WrapUnique(interpreter);
+}
+
+void TfLiteInterpreterPool::ReturnInterpreter(
+    std::unique_ptr<TfLiteInterpreterWrapper> interpreter) {
+  // There are as many slots as interpreters, so one of them is empty.
+  const int home_slot = HomeSlot();
+  TfLiteInterpreterWrapper* const raw_interpreter = interpreter.release();
+  for (int i = 0;; i = (i + 1) % num_slots_) {
+    TfLiteInterpreterWrapper* expected = nullptr;
+    if (slots_[(home_slot + i) % num_slots_].compare_exchange_strong(
+            expected, raw_interpreter)) {
+      break;
+    }
+  }
+  if (num_waiters_.load() > 0) {
+    absl::MutexLock l(&mutex_);
+    interpreter_returned_.Signal();
+  }
+}
+
 }  // namespace internal
 }  // namespace serving
 }  // namespace tensorflow
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFLITE_INTERPRETER_POOL_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFLITE_INTERPRETER_POOL_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
@@ -37,6 +39,7 @@ limitations under the License.
 #include "tensorflow/lite/profiling/profile_summary_formatter.h"
 #endif
 #include "tensorflow/lite/string_util.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 
 namespace tensorflow {
 namespace serving {
@@ -49,10 +52,15 @@ class TfLiteInterpreterWrapper {
   // pool.
  public:
   // Create an interpreter and external context and wrap it in the class
-  // for use with an InterpreterPool.
+  // for use with an InterpreterPool. The delegates of `delegate_config` are
+  // applied to the interpreter. For each of `specialized_batch_sizes`, the
+  // wrapper also holds an interpreter allocated for that batch size (see
+  // Specialize()).
   static Status CreateTfLiteInterpreterWrapper(
       const tflite::FlatBufferModel& model,
       const tensorflow::SessionOptions& options,
+      const TfLiteDelegateConfig& delegate_config,
+      const std::vector<int>& specialized_batch_sizes,
       std::unique_ptr<TfLiteInterpreterWrapper>& wrapper);
 
   // Constructor for wrapper takes only an initialized interpreter.
@@ -72,6 +80,12 @@ class TfLiteInterpreterWrapper {
   // Set the batch size.
   void SetBatchSize(int batch_size) { batch_size_ = batch_size; }
 
+  // Returns the wrapper of the interpreter specialized for batches of
+  // `batch_size`, whose inputs are already allocated for that size, so that
+  // running such batches doesn't resize and reallocate the tensors. Returns
+  // this wrapper if `batch_size` isn't one of the specialized sizes.
+  TfLiteInterpreterWrapper* Specialize(int batch_size);
+
   // Invokes the interpreter.
   TfLiteStatus Invoke();
 #ifdef TFLITE_PROFILE
@@ -99,6 +113,14 @@ class TfLiteInterpreterWrapper {
                                    int tensor_index, int batch_size);
 
  private:
+  // Creates a wrapper with its string inputs allocated for `batch_size`, and
+  // if `specialized`, the batch dimension of its other inputs too.
+  static Status CreateForBatchSize(
+      const tflite::FlatBufferModel& model,
+      const tensorflow::SessionOptions& options,
+      const TfLiteDelegateConfig& delegate_config, int batch_size,
+      bool specialized, std::unique_ptr<TfLiteInterpreterWrapper>& wrapper);
+
   // External cpu context to enable caching.
   std::unique_ptr<tflite::ExternalCpuBackendContext> external_context_;
   std::unique_ptr<tflite::Interpreter> interpreter_;
@@ -106,6 +128,8 @@ class TfLiteInterpreterWrapper {
   std::map<int, std::unique_ptr<char>> tensor_buffer_;
   std::map<int, size_t> tensor_buffer_max_bytes_;
   std::vector<int32_t> offset_;
+  // The wrappers of the interpreters specialized by batch size.
+  std::map<int, std::unique_ptr<TfLiteInterpreterWrapper>> specialized_;
 #ifdef TFLITE_PROFILE
   int max_num_entries_;
   tflite::profiling::ProfileSummarizer run_summarizer_;
@@ -114,45 +138,65 @@ class TfLiteInterpreterWrapper {
 #endif
 };
 
-// Contains a vector of TfLiteInterpreterWrapper, which are protected by mutex.
-// When GetInterpreter is called, will either release a unique ptr to the
-// caller or block if the vector is empty.
+// Contains a set of TfLiteInterpreterWrapper. When GetInterpreter is called,
+// will either release a unique ptr to the caller or block if none is
+// available.
+//
+// Each interpreter has a slot that holds it while it is available, which is
+// taken and refilled with atomic operations rather than under a lock. Each
+// thread has a home slot, which it takes its interpreter from and returns it
+// to first, so that a thread mostly reuses the interpreter whose state is warm
+// in its cache; only if its home slot is empty (or full, when returning) does
+// it scan the other slots. The mutex is only taken to wait when all
+// interpreters are in use, and to wake up waiters.
 class TfLiteInterpreterPool {
  public:
   // Creates a TfLiteSessionPool with model, session options,
-  // pool_size number of interpreters.
+  // pool_size number of interpreters. The interpreters are created in
+  // parallel, since applying delegates to them can be slow. Each interpreter
+  // comes with one specialized for each of `specialized_batch_sizes`.
+  static tensorflow::Status CreateTfLiteInterpreterPool(
+      const tflite::FlatBufferModel* model,
+      const tensorflow::SessionOptions& options,
+      const TfLiteDelegateConfig& delegate_config,
+      const std::vector<int>& specialized_batch_sizes, int pool_size,
+      std::unique_ptr<TfLiteInterpreterPool>& interpreter_pool);
+
+  // As above, with TFLite's default delegates and no specialized
+  // interpreters.
   static tensorflow::Status CreateTfLiteInterpreterPool(
       const tflite::FlatBufferModel* model,
       const tensorflow::SessionOptions& options, int pool_size,
       std::unique_ptr<TfLiteInterpreterPool>& interpreter_pool);
 
+  // All the interpreters must have been returned.
+  ~TfLiteInterpreterPool();
+
   // Returns a TFLite interpreter wrapper object. Caller may *block* waiting for
   // a free interpreter pool to be available.
-  std::unique_ptr<TfLiteInterpreterWrapper> GetInterpreter() {
-    auto interpreter_available = [this]() ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
-      return !this->available_.empty();
-    };
-    mutex_.LockWhen(absl::Condition(&interpreter_available));
-    auto pool = std::move(available_.back());
-    available_.pop_back();
-    mutex_.Unlock();
-    return pool;
-  }
+  std::unique_ptr<TfLiteInterpreterWrapper> GetInterpreter();
 
   // Returns an interpreter wrapper to the available pool.
-  void ReturnInterpreter(
-      std::unique_ptr<TfLiteInterpreterWrapper> interpreter) {
-    absl::MutexLock l(&mutex_);
-    available_.emplace_back(std::move(interpreter));
-  }
+  void ReturnInterpreter(std::unique_ptr<TfLiteInterpreterWrapper> interpreter);
 
  private:
   TfLiteInterpreterPool(
-      std::vector<std::unique_ptr<TfLiteInterpreterWrapper>> interpreters)
-      : available_(std::move(interpreters)) {}
-  mutable absl::Mutex mutex_;
-  std::vector<std::unique_ptr<TfLiteInterpreterWrapper>> available_
-      ABSL_GUARDED_BY(mutex_);
+      std::vector<std::unique_ptr<TfLiteInterpreterWrapper>> interpreters);
+
+  // Returns the home slot of the calling thread.
+  int HomeSlot() const;
+
+  // Takes an interpreter from the first non-empty slot, starting at the home
+  // slot, or returns null if all are empty.
+  TfLiteInterpreterWrapper* TryTake();
+
+  const int num_slots_;
+  const std::unique_ptr<std::atomic<TfLiteInterpreterWrapper*>[]> slots_;
+
+  // The number of callers waiting for an interpreter in GetInterpreter().
+  std::atomic<int> num_waiters_{0};
+  absl::Mutex mutex_;
+  absl::CondVar interpreter_returned_;
 };
 
 }  // namespace internal
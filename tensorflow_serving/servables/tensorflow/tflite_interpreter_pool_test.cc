@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow_serving/servables/tensorflow/tflite_interpreter_pool.h"
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/lite/kernels/parse_example/parse_example.h"
 #include "tensorflow/lite/kernels/register.h"
 #include "tensorflow_serving/test_util/test_util.h"
@@ -73,6 +75,80 @@ TEST(TfLiteInterpreterPool, CreateTfLiteInterpreterPoolTest) {
   interpreter_pool.reset();
 }
 
+TEST(TfLiteInterpreterPool, SpecializedBatchSizes) {
+  string model_bytes;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(),
+                                test_util::TestSrcDirPath(kMobileNetModel),
+                                &model_bytes));
+  auto model = tflite::FlatBufferModel::BuildFromModel(
+      flatbuffers::GetRoot<tflite::Model>(model_bytes.data()));
+  std::unique_ptr<TfLiteInterpreterPool> interpreter_pool;
+  TF_ASSERT_OK(TfLiteInterpreterPool::CreateTfLiteInterpreterPool(
+      model.get(), tensorflow::SessionOptions(), TfLiteDelegateConfig(),
+      {2, 4}, 1, interpreter_pool));
+
+  auto interpreter = interpreter_pool->GetInterpreter();
+  // Other batch sizes run on the interpreter itself.
+  EXPECT_EQ(interpreter.get(), interpreter->Specialize(3));
+  for (const int batch_size : {2, 4}) {
+    TfLiteInterpreterWrapper* specialized =
+        interpreter->Specialize(batch_size);
+    ASSERT_NE(interpreter.get(), specialized);
+    EXPECT_EQ(batch_size, specialized->GetBatchSize());
+    const TfLiteTensor* input =
+        specialized->Get()->tensor(specialized->Get()->inputs()[0]);
+    EXPECT_EQ(batch_size, input->dims->data[0]);
+    EXPECT_EQ(224, input->dims->data[1]);
+  }
+  interpreter_pool->ReturnInterpreter(std::move(interpreter));
+}
+
+TEST(TfLiteInterpreterPool, ConcurrentGetAndReturn) {
+  string model_bytes;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(),
+                                test_util::TestSrcDirPath(kParseExampleModel),
+                                &model_bytes));
+  auto model = tflite::FlatBufferModel::BuildFromModel(
+      flatbuffers::GetRoot<tflite::Model>(model_bytes.data()));
+  const int pool_size = 2;
+  std::unique_ptr<TfLiteInterpreterPool> interpreter_pool;
+  TF_ASSERT_OK(TfLiteInterpreterPool::CreateTfLiteInterpreterPool(
+      model.get(), tensorflow::SessionOptions(), pool_size, interpreter_pool));
+
+  // A thread that runs alone gets the interpreter it returned back.
+  auto interpreter = interpreter_pool->GetInterpreter();
+  TfLiteInterpreterWrapper* const first_interpreter = interpreter.get();
+  interpreter_pool->ReturnInterpreter(std::move(interpreter));
+  interpreter = interpreter_pool->GetInterpreter();
+  EXPECT_EQ(first_interpreter, interpreter.get());
+  interpreter_pool->ReturnInterpreter(std::move(interpreter));
+
+  // More threads than interpreters, so that some of them block.
+  std::atomic<int> num_in_use{0};
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < 8; ++i) {
+      threads.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), "interpreter_user", [&]() {
+            for (int j = 0; j < 100; ++j) {
+              auto interpreter = interpreter_pool->GetInterpreter();
+              ASSERT_NE(nullptr, interpreter);
+              EXPECT_LE(num_in_use.fetch_add(1) + 1, pool_size);
+              num_in_use.fetch_sub(1);
+              interpreter_pool->ReturnInterpreter(std::move(interpreter));
+            }
+          }));
+    }
+  }
+
+  // All the interpreters are available again.
+  auto next_interpreter = interpreter_pool->GetInterpreter();
+  interpreter = interpreter_pool->GetInterpreter();
+  EXPECT_NE(interpreter.get(), next_interpreter.get());
+  interpreter_pool->ReturnInterpreter(std::move(interpreter));
+  interpreter_pool->ReturnInterpreter(std::move(next_interpreter));
+}
+
 int GetTensorSize(const TfLiteTensor* tflite_tensor) {
   int size = 1;
   for (int i = 0; i < tflite_tensor->dims->size; ++i) {
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/tflite_session.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
@@ -157,7 +158,7 @@ std::vector<int> TensorDims(const Tensor& tensor) {
 
 // Create output tensors making sure they are the right size. //
 Status CreateOutputTensors(
-    std::unique_ptr<internal::TfLiteInterpreterWrapper>& interpreter_wrapper,
+    internal::TfLiteInterpreterWrapper* interpreter_wrapper,
     const std::vector<string>& output_tensor_names,
     const std::map<string, int>& output_tensor_to_idx,
     std::map<int32_t, Tensor*>& tflite_idx_to_output_tensor,
@@ -184,12 +185,24 @@ Status CreateOutputTensors(
   return OkStatus();
 }
 
+// The alignment TFLite requires of tensor memory bound with
+// SetCustomAllocationForTensor(), i.e. tflite::kDefaultTensorAlignment.
+constexpr size_t kTfLiteTensorAlignment = 64;
+
+bool IsTfLiteAligned(const void* data) {
+  return reinterpret_cast<uintptr_t>(data) % kTfLiteTensorAlignment == 0;
+}
+
 Status SetInputAndInvokeMiniBatch(
-    std::unique_ptr<internal::TfLiteInterpreterWrapper>& interpreter_wrapper,
+    internal::TfLiteInterpreterWrapper* interpreter_wrapper,
     const std::vector<int>& tflite_input_indices,
     const std::vector<std::vector<const Tensor*>>& inputs, int batch_size,
     int* fixed_batch_size) {
   auto* interpreter = interpreter_wrapper->Get();
+  // Tensors whose memory the interpreter reads in place, kept alive until
+  // Invoke() returns. Reserved so the tensors are never moved while bound.
+  std::vector<Tensor> bound_tensors;
+  bound_tensors.reserve(tflite_input_indices.size());
   // Load input data from Tensorflow tensors.
   for (int i = 0; i < tflite_input_indices.size(); ++i) {
     int tflite_input_idx = tflite_input_indices[i];
@@ -197,22 +210,28 @@ Status SetInputAndInvokeMiniBatch(
     const auto& tf_input_tensors = inputs[i];
     if (tflite_input_tensor->type != kTfLiteString) {
       const Tensor* tf_input_tensor = tf_input_tensors[0];
-      // concated.tensor_data() may be accessed later.
-      Tensor concated;
       if (tf_input_tensors.size() > 1) {
         std::vector<Tensor> to_concatenate;
         to_concatenate.reserve(tf_input_tensors.size());
         for (const auto* t : tf_input_tensors) {
           to_concatenate.push_back(std::move(*t));
         }
+        Tensor concated;
         TF_RETURN_IF_ERROR(tensor::Concat(to_concatenate, &concated));
-        tf_input_tensor = &concated;
+        bound_tensors.push_back(std::move(concated));
+        tf_input_tensor = &bound_tensors.back();
+      } else if (!IsTfLiteAligned(tf_input_tensor->tensor_data().data())) {
+        // The interpreter needs aligned memory, so this is the one copy of
+        // the input, as memcpy() into the arena would be.
+        bound_tensors.push_back(tensor::DeepCopy(*tf_input_tensor));
+        tf_input_tensor = &bound_tensors.back();
       }
       auto tensor_bytes = tf_input_tensor->tensor_data();
       std::vector<int> tf_dims = TensorDims(*tf_input_tensor);
       std::vector<int> tflite_dims(
           tflite_input_tensor->dims->data,
           tflite_input_tensor->dims->data + tflite_input_tensor->dims->size);
+      bool needs_allocation = false;
       if (tensor_bytes.size() != tflite_input_tensor->bytes ||
           tf_dims != tflite_dims) {
         if (interpreter->ResizeInputTensor(tflite_input_idx, tf_dims) !=
@@ -222,12 +241,35 @@ Status SetInputAndInvokeMiniBatch(
               " from ", tflite_input_tensor->bytes, " to ", tensor_bytes.size(),
               " bytes.");
         }
-        if (interpreter->AllocateTensors() != kTfLiteOk) {
-          return errors::Internal("Failed to allocate tensors");
-        }
+        needs_allocation = true;
+      }
+      // Bind the request memory to the input rather than copying it into the
+      // arena. If the tensor can't be bound (e.g. it's empty, or a delegate
+      // owns it) and never was, fall back to the copy.
+      const bool was_bound =
+          tflite_input_tensor->allocation_type == kTfLiteCustom;
+      bool bound = false;
+      if (!tensor_bytes.empty() && IsTfLiteAligned(tensor_bytes.data())) {
+        TfLiteCustomAllocation allocation{
+            const_cast<char*>(tensor_bytes.data()), tensor_bytes.size()};
+        bound = interpreter->SetCustomAllocationForTensor(
+                    tflite_input_idx, allocation) == kTfLiteOk;
+      }
+      if (!bound && was_bound && !tensor_bytes.empty()) {
+        return errors::Internal("Failed to bind input tensor: ",
+                                tflite_input_tensor->name);
+      }
+      // A newly bound tensor takes effect on the next allocation.
+      if (bound && !was_bound) {
+        needs_allocation = true;
+      }
+      if (needs_allocation && interpreter->AllocateTensors() != kTfLiteOk) {
+        return errors::Internal("Failed to allocate tensors");
+      }
+      if (!bound) {
+        std::memcpy(tflite_input_tensor->data.raw, tensor_bytes.data(),
+                    tensor_bytes.size());
       }
-      std::memcpy(tflite_input_tensor->data.raw, tensor_bytes.data(),
-                  tensor_bytes.size());
     } else {
       // Copy the string tensor data to the input tflite tensor.
       const bool needs_resize =
@@ -255,7 +297,7 @@ Status SetInputAndInvokeMiniBatch(
 }
 
 Status SetMiniBatchOutput(
-    std::unique_ptr<internal::TfLiteInterpreterWrapper>& interpreter_wrapper,
+    internal::TfLiteInterpreterWrapper* interpreter_wrapper,
     const std::map<int, Tensor*>& tflite_idx_to_output_tensor,
     std::vector<Tensor>* outputs) {
   for (const auto& entry : tflite_idx_to_output_tensor) {
@@ -419,6 +461,17 @@ Status TfLiteSession::Create(string&& buffer, const SessionOptions& options,
                              int num_pools, int num_interpreters_per_pool,
                              std::unique_ptr<TfLiteSession>* tflite_session,
                              ::google::protobuf::Map<string, SignatureDef>* signatures) {
+  return Create(std::move(buffer), options, num_pools,
+                num_interpreters_per_pool, TfLiteDelegateConfig(), {},
+                tflite_session, signatures);
+}
+
+Status TfLiteSession::Create(string&& buffer, const SessionOptions& options,
+                             int num_pools, int num_interpreters_per_pool,
+                             const TfLiteDelegateConfig& delegate_config,
+                             const std::vector<int>& specialized_batch_sizes,
+                             std::unique_ptr<TfLiteSession>* tflite_session,
+                             ::google::protobuf::Map<string, SignatureDef>* signatures) {
   auto model = tflite::FlatBufferModel::BuildFromModel(
       flatbuffers::GetRoot<tflite::Model>(buffer.data()));
   if (model == nullptr) {
@@ -505,7 +558,8 @@ Status TfLiteSession::Create(string&& buffer, const SessionOptions& options,
   std::unique_ptr<internal::TfLiteInterpreterPool> interpreter_pool;
   TF_RETURN_IF_ERROR(
       internal::TfLiteInterpreterPool::CreateTfLiteInterpreterPool(
-          model.get(), options, num_interpreters, interpreter_pool));
+          model.get(), options, delegate_config, specialized_batch_sizes,
+          num_interpreters, interpreter_pool));
 
   tflite_session->reset(new TfLiteSession(
       std::move(input_tensor_to_index), std::move(output_tensor_to_index),
@@ -578,20 +632,24 @@ Status TfLiteSession::RunInternal(
     }                                                               \
   } while (0);
   auto interpreter = interpreter_pool_->GetInterpreter();
+  // Batches of a specialized size run on an interpreter that stays allocated
+  // for that size.
+  internal::TfLiteInterpreterWrapper* specialized =
+      interpreter->Specialize(batch_size);
   RETURN_POOL_IF_ERROR(
-      SetInputAndInvokeMiniBatch(interpreter, tflite_input_indices,
+      SetInputAndInvokeMiniBatch(specialized, tflite_input_indices,
                                  merged_inputs, batch_size, fixed_batch_size));
 
   // Create return tensors and map the tflite tensor index to the
   // index of the created tensor.
   std::map<int32_t, Tensor*> tflite_idx_to_output_tensor;
   RETURN_POOL_IF_ERROR(CreateOutputTensors(
-      interpreter, output_tensor_names, output_tensor_to_index_,
+      specialized, output_tensor_names, output_tensor_to_index_,
       tflite_idx_to_output_tensor, combined_outputs));
 
   // Set the contents of the return tensors.
   RETURN_POOL_IF_ERROR(SetMiniBatchOutput(
-      interpreter, tflite_idx_to_output_tensor, combined_outputs));
+      specialized, tflite_idx_to_output_tensor, combined_outputs));
 
 #undef RETURN_POOL_IF_ERROR
   interpreter_pool_->ReturnInterpreter(std::move(interpreter));
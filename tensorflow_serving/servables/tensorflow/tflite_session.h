@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/lite/model.h"
 #include "tensorflow_serving/batching/threadsafe_status.h"
 #include "tensorflow_serving/servables/tensorflow/serving_session.h"
+#include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 #include "tensorflow_serving/servables/tensorflow/tflite_interpreter_pool.h"
 
 namespace tensorflow {
@@ -140,6 +141,17 @@ class TfLiteSession : public ServingSession {
                        std::unique_ptr<TfLiteSession>* tflite_session,
                        ::google::protobuf::Map<string, SignatureDef>* signatures);
 
+  // As above, with the delegates of `delegate_config` applied to every
+  // interpreter, and each interpreter backed by one specialized for each of
+  // `specialized_batch_sizes`, which runs batches of that size without
+  // reallocating its tensors.
+  static Status Create(string&& buffer, const SessionOptions& options,
+                       int num_pools, int num_interpreters_per_pool,
+                       const TfLiteDelegateConfig& delegate_config,
+                       const std::vector<int>& specialized_batch_sizes,
+                       std::unique_ptr<TfLiteSession>* tflite_session,
+                       ::google::protobuf::Map<string, SignatureDef>* signatures);
+
   static Status CreateDefaultBasicBatchScheduler(
       const BasicBatchScheduler<TfLiteBatchTask>::Options& options,
       std::function<void(std::unique_ptr<Batch<TfLiteBatchTask>>)>
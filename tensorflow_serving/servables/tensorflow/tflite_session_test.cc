@@ -188,6 +188,61 @@ TEST(TfLiteSession, ResizeWithSameNumElementsTest) {
   }
 }
 
+TEST(TfLiteSession, RebindsInputsAcrossRuns) {
+  string model_bytes;
+  TF_ASSERT_OK(ReadFileToString(tensorflow::Env::Default(),
+                                test_util::TestSrcDirPath(kTestModel),
+                                &model_bytes));
+
+  ::google::protobuf::Map<string, SignatureDef> signatures;
+  std::unique_ptr<TfLiteSession> session;
+  tensorflow::SessionOptions options;
+  TF_ASSERT_OK(TfLiteSession::Create(std::move(model_bytes), options, 1, 1,
+                                     &session, &signatures));
+  // Inputs are read in place, so each run must see its own request memory,
+  // whether it's resized, the same shape as the last run, or unaligned (and
+  // copied).
+  const Tensor input =
+      test::AsTensor<float>({1.0, 2.0, 3.0, 4.0}, TensorShape({4}));
+  const std::vector<std::pair<Tensor, Tensor>> runs = {
+      {input, test::AsTensor<float>({2.5, 3, 3.5, 4}, TensorShape({4}))},
+      {test::AsTensor<float>({4.0, 3.0, 2.0, 1.0}, TensorShape({4})),
+       test::AsTensor<float>({4, 3.5, 3, 2.5}, TensorShape({4}))},
+      {input.Slice(1, 4), test::AsTensor<float>({3, 3.5, 4}, TensorShape({3}))},
+      {test::AsTensor<float>({2.0}, TensorShape({1})),
+       test::AsTensor<float>({3}, TensorShape({1}))},
+  };
+  for (const auto& run : runs) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({{"x", run.first}}, {"y"}, {}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    test::ExpectTensorEqual<float>(outputs[0], run.second);
+  }
+}
+
+TEST(TfLiteSession, XnnpackDelegate) {
+  string model_bytes;
+  TF_ASSERT_OK(ReadFileToString(tensorflow::Env::Default(),
+                                test_util::TestSrcDirPath(kTestModel),
+                                &model_bytes));
+
+  ::google::protobuf::Map<string, SignatureDef> signatures;
+  std::unique_ptr<TfLiteSession> session;
+  tensorflow::SessionOptions options;
+  TfLiteDelegateConfig delegate_config;
+  delegate_config.mutable_xnnpack()->set_num_threads(2);
+  // Every interpreter of the pools gets the delegate.
+  TF_ASSERT_OK(TfLiteSession::Create(std::move(model_bytes), options, 4, 1,
+                                     delegate_config, {}, &session,
+                                     &signatures));
+  Tensor input = test::AsTensor<float>({1.0, 2.0, 3.0}, TensorShape({3}));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({{"x", input}}, {"y"}, {}, &outputs));
+  ASSERT_EQ(outputs.size(), 1);
+  test::ExpectTensorEqual<float>(
+      outputs[0], test::AsTensor<float>({2.5, 3, 3.5}, TensorShape({3})));
+}
+
 TEST(TfLiteSession, ModelFromLegacyConverterWithSigdef) {
   // A model converted with TF v1 converter, having a signature def.
   // The signature def references an input tensor named "tflite_input:0", but
@@ -0,0 +1,182 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/tfrt_compilation_cache.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tsl/platform/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// The subdirectory of the cache directory for the entries being written.
+constexpr char kTmpDir[] = "tmp";
+
+// Adds the directories and files below `root`, relative to it, to `dirs` and
+// `files`. `relative_dir` is the directory to list, relative to `root`.
+absl::Status ListRecursively(Env* env, const std::string& root,
+                             const std::string& relative_dir,
+                             std::vector<std::string>* dirs,
+                             std::vector<std::string>* files) {
+  std::vector<std::string> children;
+  TF_RETURN_IF_ERROR(
+      env->GetChildren(io::JoinPath(root, relative_dir), &children));
+  // GetChildren() returns all descendants for cloud storage like GCS, so only
+  // the direct children are taken.
+  std::set<std::string> direct_children;
+  for (const std::string& child : children) {
+    direct_children.insert(child.substr(0, child.find_first_of('/')));
+  }
+  for (const std::string& child : direct_children) {
+    const std::string relative_path =
+        relative_dir.empty() ? child : io::JoinPath(relative_dir, child);
+    if (env->IsDirectory(io::JoinPath(root, relative_path)).ok()) {
+      dirs->push_back(relative_path);
+      TF_RETURN_IF_ERROR(
+          ListRecursively(env, root, relative_path, dirs, files));
+    } else {
+      files->push_back(relative_path);
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Whether the contents of the file at `relative_path` of a SavedModel go into
+// its key, rather than just its size: the graph and the variables index, which
+// holds the checksums of the variables.
+bool IsKeyedByContents(const std::string& relative_path) {
+  return relative_path == kSavedModelFilenamePb ||
+         relative_path == kSavedModelFilenamePbTxt ||
+         relative_path == io::JoinPath(kSavedModelVariablesDirectory,
+                                       kSavedModelVariablesFilename) +
+                              ".index";
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TfrtCompilationCache>>
+TfrtCompilationCache::Create(const Options& options) {
+  if (options.cache_dir.empty()) {
+    return absl::InvalidArgumentError("cache_dir must be set");
+  }
+  Env* const env = options.env;
+  // The entries left in the temporary directory by interrupted compilations
+  // are not removed, as other servers sharing the cache may be writing theirs.
+  TF_RETURN_IF_ERROR(
+      env->RecursivelyCreateDir(io::JoinPath(options.cache_dir, kTmpDir)));
+  return absl::WrapUnique(new TfrtCompilationCache(options));
+}
+
+absl::StatusOr<std::string> TfrtCompilationCache::GetKey(
+    const std::string& saved_model_dir,
+    const TfrtSavedModelConfig& config) const {
+  TfrtSavedModelConfig compile_config = config;
+  compile_config.clear_model_warmup_options();
+  compile_config.clear_work_queues();
+  compile_config.clear_model_work_queues();
+  compile_config.clear_compilation_cache_dir();
+  std::string fingerprinted;
+  if (!SerializeToStringDeterministic(compile_config, &fingerprinted)) {
+    return absl::InvalidArgumentError("Cannot serialize config");
+  }
+
+  Env* const env = options_.env;
+  std::vector<std::string> dirs, files;
+  TF_RETURN_IF_ERROR(ListRecursively(env, saved_model_dir, "", &dirs, &files));
+  for (const std::string& file : files) {
+    const std::string path = io::JoinPath(saved_model_dir, file);
+    if (IsKeyedByContents(file)) {
+      std::string contents;
+      TF_RETURN_IF_ERROR(ReadFileToString(env, path, &contents));
+      absl::StrAppend(&fingerprinted, "\n", file, "\n", contents.size(), "\n",
+                      contents);
+    } else {
+      uint64_t size;
+      TF_RETURN_IF_ERROR(env->GetFileSize(path, &size));
+      absl::StrAppend(&fingerprinted, "\n", file, "\n", size);
+    }
+  }
+  const Fprint128 fingerprint = Fingerprint128(fingerprinted);
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+absl::StatusOr<std::string> TfrtCompilationCache::GetOrCompile(
+    const std::string& saved_model_dir, const TfrtSavedModelConfig& config,
+    const CompileFn& compile) const {
+  Env* const env = options_.env;
+  TF_ASSIGN_OR_RETURN(const std::string key, GetKey(saved_model_dir, config));
+  const std::string entry_dir = io::JoinPath(options_.cache_dir, key);
+  if (env->IsDirectory(entry_dir).ok()) {
+    LOG(INFO) << "Using the compiled SavedModel at " << entry_dir << " for "
+              << saved_model_dir;
+    return entry_dir;
+  }
+
+  LOG(INFO) << "Compiling the SavedModel at " << saved_model_dir << " into "
+            << entry_dir;
+  const std::string tmp_dir =
+      io::JoinPath(options_.cache_dir, kTmpDir,
+                   absl::StrCat(key, ".", absl::Hex(random::New64())));
+  auto delete_tmp_dir = [&]() {
+    int64_t undeleted_files, undeleted_dirs;
+    env->DeleteRecursively(tmp_dir, &undeleted_files, &undeleted_dirs)
+        .IgnoreError();
+  };
+  absl::Status status = [&]() -> absl::Status {
+    TF_RETURN_IF_ERROR(compile(saved_model_dir, tmp_dir));
+    std::vector<std::string> dirs, files;
+    TF_RETURN_IF_ERROR(
+        ListRecursively(env, saved_model_dir, "", &dirs, &files));
+    for (const std::string& dir : dirs) {
+      TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(io::JoinPath(tmp_dir, dir)));
+    }
+    for (const std::string& file : files) {
+      const std::string destination = io::JoinPath(tmp_dir, file);
+      if (!env->FileExists(destination).ok()) {
+        TF_RETURN_IF_ERROR(
+            env->CopyFile(io::JoinPath(saved_model_dir, file), destination));
+      }
+    }
+    return env->RenameFile(tmp_dir, entry_dir);
+  }();
+  if (!status.ok()) {
+    delete_tmp_dir();
+    // Another server or load may have written the entry meanwhile.
+    if (env->IsDirectory(entry_dir).ok()) {
+      return entry_dir;
+    }
+    return status;
+  }
+  return entry_dir;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
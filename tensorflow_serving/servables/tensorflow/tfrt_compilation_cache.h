@@ -0,0 +1,82 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_COMPILATION_CACHE_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_COMPILATION_CACHE_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_source_adapter.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// An on-disk cache of compiled (i.e. imported and lowered) TFRT SavedModels,
+// so that loading a SavedModel that was compiled before, e.g. by an earlier
+// run of the server, skips its compilation.
+//
+// Each entry is a directory below `cache_dir` named by the key of the
+// SavedModel and config it was compiled from (see GetKey()), which holds a
+// SavedModel with ahead-of-time compiled packages that the TFRT loader picks
+// up. Entries are written to a temporary directory and renamed into place, so
+// that several servers can share a cache directory (e.g. on a network file
+// system). Entries are never evicted.
+//
+// This class is thread-safe.
+class TfrtCompilationCache {
+ public:
+  struct Options {
+    std::string cache_dir;
+    Env* env = Env::Default();
+  };
+
+  // Compiles the SavedModel at `saved_model_dir` into a new SavedModel at
+  // `output_dir`, e.g. with tfrt_stub::AotCompileSavedModel().
+  using CompileFn = std::function<absl::Status(
+      const std::string& saved_model_dir, const std::string& output_dir)>;
+
+  static absl::StatusOr<std::unique_ptr<TfrtCompilationCache>> Create(
+      const Options& options);
+
+  // Returns the key of the SavedModel at `saved_model_dir` compiled with
+  // `config`: a fingerprint of its graph, its variables index, the names and
+  // sizes of its other files, and of the config, less the options that do not
+  // affect compilation.
+  absl::StatusOr<std::string> GetKey(const std::string& saved_model_dir,
+                                     const TfrtSavedModelConfig& config) const;
+
+  // Returns the directory of the compiled SavedModel for `saved_model_dir` and
+  // `config`, compiling it with `compile` first if it is not cached. The files
+  // of the SavedModel that `compile` does not write (e.g. its variables and
+  // assets) are copied into the entry, so that it can be loaded on its own.
+  absl::StatusOr<std::string> GetOrCompile(const std::string& saved_model_dir,
+                                           const TfrtSavedModelConfig& config,
+                                           const CompileFn& compile) const;
+
+ private:
+  explicit TfrtCompilationCache(const Options& options) : options_(options) {}
+
+  const Options options_;
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_COMPILATION_CACHE_H_
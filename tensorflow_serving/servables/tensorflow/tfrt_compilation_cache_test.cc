@@ -0,0 +1,165 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/tfrt_compilation_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_source_adapter.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class TfrtCompilationCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const string test_dir = io::JoinPath(
+        testing::TmpDir(),
+        ::testing::UnitTest::GetInstance()->current_test_info()->name());
+    saved_model_dir_ = io::JoinPath(test_dir, "saved_model");
+    TfrtCompilationCache::Options options;
+    options.cache_dir = io::JoinPath(test_dir, "cache");
+    absl::StatusOr<std::unique_ptr<TfrtCompilationCache>> cache =
+        TfrtCompilationCache::Create(options);
+    TF_ASSERT_OK(cache.status());
+    cache_ = *std::move(cache);
+
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(saved_model_dir_, kSavedModelVariablesDirectory)));
+    WriteSavedModelFile(kSavedModelFilenamePb, "graph");
+    WriteSavedModelFile(
+        io::JoinPath(kSavedModelVariablesDirectory, "variables.index"),
+        "index");
+    WriteSavedModelFile(io::JoinPath(kSavedModelVariablesDirectory,
+                                     "variables.data-00000-of-00001"),
+                        "data");
+  }
+
+  void WriteSavedModelFile(const string& relative_path,
+                           const string& contents) {
+    TF_ASSERT_OK(WriteStringToFile(
+        Env::Default(), io::JoinPath(saved_model_dir_, relative_path),
+        contents));
+  }
+
+  // Compiles by writing a graph and an ahead-of-time package, counting the
+  // compilations.
+  TfrtCompilationCache::CompileFn FakeCompile() {
+    return [this](const string& saved_model_dir, const string& output_dir) {
+      ++num_compilations_;
+      TF_RETURN_IF_ERROR(Env::Default()->RecursivelyCreateDir(
+          io::JoinPath(output_dir, "aot_packages")));
+      TF_RETURN_IF_ERROR(WriteStringToFile(
+          Env::Default(), io::JoinPath(output_dir, kSavedModelFilenamePb),
+          "compiled graph"));
+      return WriteStringToFile(
+          Env::Default(), io::JoinPath(output_dir, "aot_packages", "package"),
+          "package");
+    };
+  }
+
+  string saved_model_dir_;
+  std::unique_ptr<TfrtCompilationCache> cache_;
+  int num_compilations_ = 0;
+};
+
+TEST_F(TfrtCompilationCacheTest, CompilesOnce) {
+  TfrtSavedModelConfig config;
+  const absl::StatusOr<string> entry_dir =
+      cache_->GetOrCompile(saved_model_dir_, config, FakeCompile());
+  TF_ASSERT_OK(entry_dir.status());
+  EXPECT_EQ(1, num_compilations_);
+
+  // The entry has the compiled files, and the other files of the SavedModel.
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(
+      Env::Default(), io::JoinPath(*entry_dir, kSavedModelFilenamePb),
+      &contents));
+  EXPECT_EQ("compiled graph", contents);
+  TF_EXPECT_OK(Env::Default()->FileExists(
+      io::JoinPath(*entry_dir, "aot_packages", "package")));
+  TF_ASSERT_OK(ReadFileToString(
+      Env::Default(),
+      io::JoinPath(*entry_dir, kSavedModelVariablesDirectory,
+                   "variables.data-00000-of-00001"),
+      &contents));
+  EXPECT_EQ("data", contents);
+
+  // Later loads, e.g. with a different warmup, use the entry.
+  config.mutable_model_warmup_options()->set_model_name("model");
+  const absl::StatusOr<string> cached_entry_dir =
+      cache_->GetOrCompile(saved_model_dir_, config, FakeCompile());
+  TF_ASSERT_OK(cached_entry_dir.status());
+  EXPECT_EQ(*entry_dir, *cached_entry_dir);
+  EXPECT_EQ(1, num_compilations_);
+}
+
+TEST_F(TfrtCompilationCacheTest, KeyCoversGraphVariablesAndConfig) {
+  TfrtSavedModelConfig config;
+  const absl::StatusOr<string> key = cache_->GetKey(saved_model_dir_, config);
+  TF_ASSERT_OK(key.status());
+
+  TfrtSavedModelConfig grappler_config;
+  grappler_config.set_enable_grappler(true);
+  const absl::StatusOr<string> grappler_key =
+      cache_->GetKey(saved_model_dir_, grappler_config);
+  TF_ASSERT_OK(grappler_key.status());
+  EXPECT_NE(*key, *grappler_key);
+
+  WriteSavedModelFile(
+      io::JoinPath(kSavedModelVariablesDirectory, "variables.index"),
+      "other index");
+  const absl::StatusOr<string> variables_key =
+      cache_->GetKey(saved_model_dir_, config);
+  TF_ASSERT_OK(variables_key.status());
+  EXPECT_NE(*key, *variables_key);
+
+  WriteSavedModelFile(kSavedModelFilenamePb, "other graph");
+  const absl::StatusOr<string> graph_key =
+      cache_->GetKey(saved_model_dir_, config);
+  TF_ASSERT_OK(graph_key.status());
+  EXPECT_NE(*variables_key, *graph_key);
+}
+
+TEST_F(TfrtCompilationCacheTest, FailedCompilationIsNotCached) {
+  const TfrtSavedModelConfig config;
+  EXPECT_FALSE(cache_
+                   ->GetOrCompile(saved_model_dir_, config,
+                                  [](const string&, const string&) {
+                                    return absl::InternalError("failed");
+                                  })
+                   .ok());
+  TF_EXPECT_OK(
+      cache_->GetOrCompile(saved_model_dir_, config, FakeCompile()).status());
+  EXPECT_EQ(1, num_compilations_);
+}
+
+TEST(TfrtCompilationCacheCreateTest, RequiresCacheDir) {
+  EXPECT_FALSE(TfrtCompilationCache::Create({}).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
 #include "tensorflow/cc/saved_model/util.h"
@@ -70,26 +71,27 @@ Status PreProcessPredictionWithoutOutputFilter(
             absl::StrJoin(missing, ","), "}."));
       }
       Tensor tensor;
-      if (!tensor.FromProto(default_input->second)) {
+      if (!internal::TensorFromRequestProto(default_input->second, &tensor)) {
         return errors::InvalidArgument(
             absl::StrCat("tensor parsing error: ", input_name));
       }
       input_tensors->emplace_back(std::move(tensor));
       continue;
     }
-    Tensor tensor;
-    if (!tensor.FromProto(input->second)) {
-      return errors::InvalidArgument(
-          absl::StrCat("tensor parsing error: ", input_name));
-    }
     const auto expected_dtype = function_metadata.GetInputSpecs()[i].dtype;
     // TODO(b/188570937): Remove this type check and update related tests.
     if (expected_dtype != DT_INVALID  // Skip if the dtype is unspecified.
-        && tensor.dtype() != expected_dtype) {
+        && input->second.dtype() != expected_dtype) {
       return errors::InvalidArgument(
           absl::StrCat("Expected input ", input_name, " to be ",
                        DataTypeString(expected_dtype), " but get ",
-                       DataTypeString(tensor.dtype()), "."));
+                       DataTypeString(input->second.dtype()), "."));
+    }
+    // Large dense inputs alias the request rather than copy it.
+    Tensor tensor;
+    if (!internal::TensorFromRequestProto(input->second, &tensor)) {
+      return errors::InvalidArgument(
+          absl::StrCat("tensor parsing error: ", input_name));
     }
     input_tensors->emplace_back(std::move(tensor));
   }
@@ -107,8 +109,8 @@ Status PostProcessPredictionResultWithoutOutputFilter(
     return errors::Unknown("Predict internal error.");
   }
 
-  std::unordered_set<string> output_filter(request.output_filter().begin(),
-                                           request.output_filter().end());
+  const absl::flat_hash_set<absl::string_view> output_filter(
+      request.output_filter().begin(), request.output_filter().end());
   int output_size = 0;
   for (int i = 0; i < output_tensors.size(); ++i) {
     if (!output_filter.empty() &&
@@ -164,6 +166,11 @@ Status RunPredict(
     tfrt::SavedModel* saved_model, const PredictRequest& request,
     PredictResponse* response,
     const thread::ThreadPoolOptions& thread_pool_options) {
+  if (!request.shared_memory_inputs().empty() ||
+      !request.shared_memory_outputs().empty()) {
+    return errors::Unimplemented(
+        "Shared memory tensors are not supported by the TFRT runtime");
+  }
   // Validate signatures.
   const std::string function_name =
       request.model_spec().signature_name().empty()
@@ -21,6 +21,8 @@ limitations under the License.
 #include "absl/time/time.h"
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/threadpool_options.h"
@@ -151,6 +153,31 @@ TEST_F(PredictImplTest, PredictionSuccess) {
   EXPECT_THAT(response, test_util::EqualsProto(expected_response));
 }
 
+TEST_F(PredictImplTest, PredictionSuccessWithLargeTensorContent) {
+  PredictRequest request;
+  PredictResponse response;
+
+  ModelSpec* model_spec = request.mutable_model_spec();
+  model_spec->set_name(kTestModelName);
+  model_spec->mutable_version()->set_value(kTestModelVersion);
+
+  // Large enough for the input tensor to alias the request.
+  constexpr int kNumElements = 64 << 10;
+  Tensor input(DT_FLOAT, TensorShape({kNumElements}));
+  for (int i = 0; i < kNumElements; ++i) {
+    input.flat<float>()(i) = i;
+  }
+  input.AsProtoTensorContent(&(*request.mutable_inputs())[kInputTensorKey]);
+
+  TF_EXPECT_OK(CallPredict(GetServerCore(), request, &response));
+  Tensor output;
+  ASSERT_TRUE(output.FromProto(response.outputs().at(kOutputTensorKey)));
+  ASSERT_EQ(output.NumElements(), kNumElements);
+  EXPECT_EQ(output.flat<float>()(0), 2);
+  EXPECT_EQ(output.flat<float>()(kNumElements - 1),
+            0.5 * (kNumElements - 1) + 2);
+}
+
 TEST_F(PredictImplTest, PredictionSuccessWithDefaultInputs) {
   PredictRequest request;
   PredictResponse response;
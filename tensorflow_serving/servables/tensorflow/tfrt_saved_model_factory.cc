@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_factory.h"
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -37,18 +38,23 @@ limitations under the License.
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/tfrt/runtime/runtime.h"
 #include "tensorflow/core/tfrt/saved_model/saved_model.h"
+#include "tensorflow/core/tfrt/saved_model/saved_model_aot_compile.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
 #include "tensorflow_serving/batching/tfrt_saved_model_with_batching.h"
+#include "tensorflow_serving/core/load_profile.h"
 #include "tensorflow_serving/core/loader.h"
 #include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/servables/tensorflow/bundle_factory_util.h"
 #include "tensorflow_serving/servables/tensorflow/machine_learning_metadata.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_config.h"
 #include "tensorflow_serving/servables/tensorflow/servable.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_compilation_cache.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_source_adapter.pb.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_warmup.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_servable.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_work_queues.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory_config.pb.h"
 #include "tensorflow_serving/session_bundle/graph_rewriter.h"
@@ -95,6 +101,14 @@ absl::Status WrapSavedModelForBatching(
 
   batching_saved_model_options.pad_variable_length_inputs =
       batching_config.pad_variable_length_inputs();
+  batching_saved_model_options.enable_pooled_batch_assembly =
+      batching_config.enable_pooled_batch_assembly();
+  batching_saved_model_options.batch_multiple_signatures =
+      batching_config.batch_multi_inference();
+  for (int64_t boundary : batching_config.padded_dim_bucket_boundaries()) {
+    batching_saved_model_options.padded_dim_bucket_boundaries.push_back(
+        boundary);
+  }
 
   auto create_queue =
       [batch_scheduler, queue_options](
@@ -185,11 +199,14 @@ absl::Status TfrtSavedModelFactory::CreateTfrtSavedModelWithMetadata(
   // TODO(b/326069213): Consider using arena allocation when loading a
   // MetaGraphDef.
   tensorflow::MetaGraphDef meta_graph_def;
-  TF_RETURN_IF_ERROR(tensorflow::ReadMetaGraphDefFromSavedModel(
-      std::string(path), saved_model_tags, &meta_graph_def));
-  if (auto& graph_rewriter = tensorflow::serving::GraphRewriter::GetGlobal();
-      graph_rewriter.IsRegistered()) {
-    TF_RETURN_IF_ERROR(graph_rewriter.Get()(&meta_graph_def));
+  {
+    ScopedLoadPhase read_phase("read_meta_graph");
+    TF_RETURN_IF_ERROR(tensorflow::ReadMetaGraphDefFromSavedModel(
+        std::string(path), saved_model_tags, &meta_graph_def));
+    if (auto& graph_rewriter = tensorflow::serving::GraphRewriter::GetGlobal();
+        graph_rewriter.IsRegistered()) {
+      TF_RETURN_IF_ERROR(graph_rewriter.Get()(&meta_graph_def));
+    }
   }
   options.enable_lazy_loading =
       meta_graph_def.signature_def_size() > config_.lazy_init_threshold();
@@ -249,9 +266,38 @@ absl::Status TfrtSavedModelFactory::CreateTfrtSavedModelWithMetadata(
   options.graph_execution_options.model_metadata.set_version(
       metadata.servable_id.version);
 
-  TF_ASSIGN_OR_RETURN(*saved_model,
-                      tfrt::SavedModelImpl::LoadSavedModel(
-                          std::move(options), std::move(meta_graph_def), path));
+  std::string load_path = path;
+  TF_ASSIGN_OR_RETURN(const TfrtCompilationCache* compilation_cache,
+                      GetCompilationCache());
+  // The compilation is keyed by the files of the SavedModel, which a graph
+  // rewriter bypasses.
+  if (compilation_cache != nullptr &&
+      !tensorflow::serving::GraphRewriter::GetGlobal().IsRegistered()) {
+    ScopedLoadPhase compile_phase("compile");
+    absl::StatusOr<std::string> compiled_path = compilation_cache->GetOrCompile(
+        path, config_,
+        [&](const std::string& saved_model_dir, const std::string& output_dir) {
+          return CompileSavedModel(saved_model_dir, saved_model_tags,
+                                   options.graph_execution_options, output_dir);
+        });
+    if (compiled_path.ok()) {
+      load_path = *std::move(compiled_path);
+    } else {
+      LOG(WARNING) << "Loading " << path
+                   << " without the compilation cache: "
+                   << compiled_path.status();
+    }
+  }
+
+  {
+    // Imports and compiles the graph, unless precompiled, restores the
+    // variables and runs the init ops.
+    ScopedLoadPhase load_phase("load_saved_model");
+    TF_ASSIGN_OR_RETURN(
+        *saved_model,
+        tfrt::SavedModelImpl::LoadSavedModel(
+            std::move(options), std::move(meta_graph_def), load_path));
+  }
   if (config_.has_batching_parameters() &&
       config_.batching_parameters().ByteSizeLong() != 0) {
     absl::optional<BatchingParameters> batching_params;
@@ -284,25 +330,109 @@ absl::Status TfrtSavedModelFactory::CreateTfrtSavedModelWithMetadata(
 
   MaybePublishMLMDStreamz(path, metadata.servable_id.name,
                           metadata.servable_id.version);
+  // The warmup records left to replay once the model is available.
+  std::vector<PredictionLog> background_warmup_records;
   if (config().enable_model_warmup()) {
+    ScopedLoadPhase warmup_phase("warmup");
     auto* warmup_options = mutable_config().mutable_model_warmup_options();
     warmup_options->set_model_name(metadata.servable_id.name);
     warmup_options->set_model_version(metadata.servable_id.version);
-    TF_RETURN_IF_ERROR(RunSavedModelWarmup(
-        *warmup_options, path, config().lazy_init_threshold(),
-        config().skip_warmup_requests_if_initialized(), saved_model.get()));
+    ModelWarmupOptions model_warmup_options = *warmup_options;
+    if (config().has_batching_parameters() &&
+        config().batching_parameters().ByteSizeLong() != 0) {
+      TF_RETURN_IF_ERROR(SetWarmupBatchSizes(
+          path, config().batching_parameters(),
+          config().enable_per_model_batching_params(), &model_warmup_options));
+    }
+    // Freezing disables the compilations a background warmup would trigger.
+    if (config().enable_background_warmup() && !config().freeze_after_init()) {
+      TF_RETURN_IF_ERROR(RunForegroundSavedModelWarmup(
+          model_warmup_options, path, config().lazy_init_threshold(),
+          config().skip_warmup_requests_if_initialized(),
+          config().num_foreground_warmup_signatures(), saved_model.get(),
+          &background_warmup_records));
+    } else {
+      TF_RETURN_IF_ERROR(RunSavedModelWarmup(
+          model_warmup_options, path, config().lazy_init_threshold(),
+          config().skip_warmup_requests_if_initialized(), saved_model.get()));
+    }
     if (config().freeze_after_init()) {
       TF_RETURN_IF_ERROR(Freeze(*saved_model));
     }
   }
 
-  *servable = std::make_unique<TfrtSavedModelServable>(
+  TF_ASSIGN_OR_RETURN(std::shared_ptr<const TfrtWorkQueues> work_queues,
+                      GetWorkQueues(metadata.servable_id.name));
+  auto tfrt_servable = std::make_unique<TfrtSavedModelServable>(
       metadata.servable_id.name, metadata.servable_id.version, config_,
-      std::move(saved_model), thread_pool_factory_.get());
+      std::move(saved_model), thread_pool_factory_.get(),
+      std::move(work_queues));
+  if (!background_warmup_records.empty()) {
+    tfrt_servable->StartBackgroundWarmup(
+        [records = std::move(background_warmup_records), path,
+         lazy_init_threshold = config().lazy_init_threshold(),
+         skip_warmup_requests_if_initialized =
+             config().skip_warmup_requests_if_initialized(),
+         saved_model = &tfrt_servable->saved_model()](
+            const std::atomic<bool>& cancelled) {
+          RunBackgroundSavedModelWarmup(records, path, lazy_init_threshold,
+                                        skip_warmup_requests_if_initialized,
+                                        cancelled, saved_model);
+        });
+  }
+  *servable = std::move(tfrt_servable);
 
   return absl::OkStatus();
 }
 
+absl::Status TfrtSavedModelFactory::CompileSavedModel(
+    const std::string& saved_model_dir,
+    const std::unordered_set<std::string>& tags,
+    const tfrt_stub::GraphExecutionOptions& options,
+    const std::string& output_dir) {
+  tfrt_stub::AotOptions aot_options;
+  aot_options.tags = tags;
+  aot_options.graph_execution_options =
+      std::make_shared<tfrt_stub::GraphExecutionOptions>(options);
+  return tfrt_stub::AotCompileSavedModel(saved_model_dir,
+                                         std::move(aot_options), output_dir);
+}
+
+absl::StatusOr<const TfrtCompilationCache*>
+TfrtSavedModelFactory::GetCompilationCache() {
+  if (config_.compilation_cache_dir().empty()) {
+    return nullptr;
+  }
+  absl::MutexLock lock(&compilation_cache_mu_);
+  if (compilation_cache_ == nullptr) {
+    TfrtCompilationCache::Options options;
+    options.cache_dir = config_.compilation_cache_dir();
+    TF_ASSIGN_OR_RETURN(compilation_cache_,
+                        TfrtCompilationCache::Create(options));
+  }
+  return compilation_cache_.get();
+}
+
+absl::StatusOr<std::shared_ptr<const TfrtWorkQueues>>
+TfrtSavedModelFactory::GetWorkQueues(const std::string& model_name) {
+  auto model_work_queues = config_.model_work_queues().find(model_name);
+  const auto& configs = model_work_queues == config_.model_work_queues().end()
+                            ? config_.work_queues()
+                            : model_work_queues->second.work_queues();
+  if (configs.empty()) {
+    return nullptr;
+  }
+  absl::MutexLock lock(&work_queues_mu_);
+  std::shared_ptr<const TfrtWorkQueues>& work_queues =
+      work_queues_[model_name];
+  if (work_queues == nullptr) {
+    std::unique_ptr<TfrtWorkQueues> created;
+    TF_RETURN_IF_ERROR(TfrtWorkQueues::Create(model_name, configs, &created));
+    work_queues = std::move(created);
+  }
+  return work_queues;
+}
+
 TfrtSavedModelFactory::TfrtSavedModelFactory(
     const TfrtSavedModelConfig& config,
     std::shared_ptr<Batcher> batch_scheduler,
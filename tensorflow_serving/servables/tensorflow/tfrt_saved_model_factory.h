@@ -16,10 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_SAVED_MODEL_FACTORY_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_SAVED_MODEL_FACTORY_H_
 
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_set>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/kernels/batching_util/shared_batch_scheduler.h"
@@ -31,8 +34,10 @@ limitations under the License.
 #include "tensorflow_serving/core/loader.h"
 #include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_compilation_cache.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_source_adapter.pb.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_servable.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_work_queues.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 
 namespace tensorflow {
@@ -110,6 +115,24 @@ class TfrtSavedModelFactory {
     return absl::OkStatus();
   }
 
+  // Compiles the SavedModel at `saved_model_dir` ahead of time with `options`
+  // into a SavedModel at `output_dir`, for the compilation cache.
+  virtual absl::Status CompileSavedModel(
+      const std::string& saved_model_dir,
+      const std::unordered_set<std::string>& tags,
+      const tfrt_stub::GraphExecutionOptions& options,
+      const std::string& output_dir);
+
+  // Returns the compilation cache, creating it on first use, or nullptr if the
+  // config has no `compilation_cache_dir`.
+  absl::StatusOr<const TfrtCompilationCache*> GetCompilationCache()
+      ABSL_LOCKS_EXCLUDED(compilation_cache_mu_);
+
+  // Returns the work queues of the model `model_name`, creating them on first
+  // use, or nullptr if the config gives it none.
+  absl::StatusOr<std::shared_ptr<const TfrtWorkQueues>> GetWorkQueues(
+      const string& model_name) ABSL_LOCKS_EXCLUDED(work_queues_mu_);
+
   TfrtSavedModelConfig config_;
 
   // A shared batch scheduler. One queue is used for each saved model this
@@ -120,6 +143,15 @@ class TfrtSavedModelFactory {
   // nullptr and then the default Tensorflow threadpools should be used.
   std::unique_ptr<ThreadPoolFactory> thread_pool_factory_;
 
+  // The work queues of each model, kept across its versions.
+  absl::Mutex work_queues_mu_;
+  std::map<string, std::shared_ptr<const TfrtWorkQueues>> work_queues_
+      ABSL_GUARDED_BY(work_queues_mu_);
+
+  absl::Mutex compilation_cache_mu_;
+  std::unique_ptr<TfrtCompilationCache> compilation_cache_
+      ABSL_GUARDED_BY(compilation_cache_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(TfrtSavedModelFactory);
 };
 
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/types.h"
 #include "tsl/platform/errors.h"
+#include "tensorflow_serving/core/load_profile.h"
 #include "tensorflow_serving/core/simple_loader.h"
 #include "tensorflow_serving/resources/resource_util.h"
 #include "tensorflow_serving/resources/resource_values.h"
@@ -68,6 +69,7 @@ Status TfrtSavedModelSourceAdapter::Convert(const StoragePath& path,
   std::shared_ptr<TfrtSavedModelFactory> factory = factory_;
   auto servable_creator = GetServableCreator(factory, path);
   auto resource_estimator = [factory, path](ResourceAllocation* estimate) {
+    ScopedLoadPhase estimate_phase("estimate_resources");
     TF_RETURN_IF_ERROR(factory->EstimateResourceRequirement(path, estimate));
 
     ResourceUtil::Options resource_util_options;
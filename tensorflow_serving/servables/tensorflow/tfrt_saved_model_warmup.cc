@@ -15,7 +15,11 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_warmup.h"
 
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "google/protobuf/wrappers.pb.h"
 #include "absl/container/flat_hash_map.h"
@@ -28,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow_serving/apis/classification.pb.h"
 #include "tensorflow_serving/apis/inference.pb.h"
@@ -130,5 +135,85 @@ Status RunSavedModelWarmup(const ModelWarmupOptions& model_warmup_options,
       });
 }
 
+Status RunForegroundSavedModelWarmup(
+    const ModelWarmupOptions& model_warmup_options, const string& export_dir,
+    int lazy_init_threshold, bool skip_warmup_requests_if_initialized,
+    int num_foreground_signatures, tfrt::SavedModel* saved_model,
+    std::vector<PredictionLog>* background_records) {
+  // Reads all the records first, including their replays at each batch size
+  // and iteration, to rank the signatures by their number of records.
+  struct Signature {
+    string key;
+    std::vector<PredictionLog> records;
+  };
+  mutex mu;
+  std::vector<Signature> signatures;
+  absl::flat_hash_map<string, int> signature_indices;
+  TF_RETURN_IF_ERROR(internal::RunSavedModelWarmup(
+      model_warmup_options, export_dir, [&](PredictionLog prediction_log) {
+        string key = internal::WarmupSignatureKey(prediction_log);
+        mutex_lock l(mu);
+        auto it = signature_indices.try_emplace(key, signatures.size()).first;
+        if (it->second == signatures.size()) {
+          signatures.push_back({std::move(key), {}});
+        }
+        signatures[it->second].records.push_back(std::move(prediction_log));
+        return OkStatus();
+      }));
+  // Signatures with equally many records keep the order of the file.
+  std::stable_sort(signatures.begin(), signatures.end(),
+                   [](const Signature& a, const Signature& b) {
+                     return a.records.size() > b.records.size();
+                   });
+
+  tfrt::SavedModel::RunOptions run_options;  // Default RunOptions.
+  background_records->clear();
+  for (int i = 0; i < signatures.size(); ++i) {
+    if (i < num_foreground_signatures) {
+      for (const PredictionLog& record : signatures[i].records) {
+        TF_RETURN_IF_ERROR(RunWarmupRequest(
+            record, run_options, lazy_init_threshold,
+            skip_warmup_requests_if_initialized, saved_model));
+      }
+      continue;
+    }
+    for (PredictionLog& record : signatures[i].records) {
+      background_records->push_back(std::move(record));
+    }
+  }
+  LOG(INFO) << "Warmed up "
+            << std::min<int>(num_foreground_signatures, signatures.size())
+            << " of " << signatures.size() << " signatures of the model at "
+            << export_dir << "; leaving " << background_records->size()
+            << " warmup records to replay in the background.";
+  return OkStatus();
+}
+
+void RunBackgroundSavedModelWarmup(const std::vector<PredictionLog>& records,
+                                   const string& export_dir,
+                                   int lazy_init_threshold,
+                                   bool skip_warmup_requests_if_initialized,
+                                   const std::atomic<bool>& cancelled,
+                                   tfrt::SavedModel* saved_model) {
+  tfrt::SavedModel::RunOptions run_options;  // Default RunOptions.
+  int num_replayed_records = 0;
+  for (const PredictionLog& record : records) {
+    if (cancelled.load(std::memory_order_relaxed)) {
+      break;
+    }
+    const Status status =
+        RunWarmupRequest(record, run_options, lazy_init_threshold,
+                         skip_warmup_requests_if_initialized, saved_model);
+    if (!status.ok()) {
+      LOG(WARNING) << "Background warmup request failed for " << export_dir
+                   << ": " << status;
+    }
+    ++num_replayed_records;
+  }
+  LOG(INFO) << "Finished background warmup of the model at " << export_dir
+            << ". Number of warmup records replayed: " << num_replayed_records
+            << " of " << records.size() << ".";
+}
+
 }  // namespace serving
 }  // namespace tensorflow
@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_SAVED_MODEL_WARMUP_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_SAVED_MODEL_WARMUP_H_
 
+#include <atomic>
 #include <string>
+#include <vector>
 
 #include "tensorflow/cc/saved_model/loader.h"
 #include "tensorflow/core/protobuf/saved_model.pb.h"
 #include "tensorflow/core/tfrt/saved_model/saved_model.h"
+#include "tensorflow_serving/apis/prediction_log.pb.h"
 #include "tensorflow_serving/servables/tensorflow/saved_model_warmup_util.h"
 #include "tensorflow_serving/servables/tensorflow/session_bundle_config.pb.h"
 
@@ -36,6 +39,29 @@ Status RunSavedModelWarmup(const ModelWarmupOptions& model_warmup_options,
                            bool skip_warmup_requests_if_initialized,
                            tfrt::SavedModel* saved_model);
 
+// Like RunSavedModelWarmup(), but only replays the warmup records of the
+// `num_foreground_signatures` signatures with the most records, so that the
+// model can be made available as soon as these hot signatures are ready. The
+// records of the other signatures are returned in `background_records`,
+// grouped by signature in decreasing order of their number of records, for
+// RunBackgroundSavedModelWarmup() to replay once the model is serving.
+Status RunForegroundSavedModelWarmup(
+    const ModelWarmupOptions& model_warmup_options, const string& export_dir,
+    int lazy_init_threshold, bool skip_warmup_requests_if_initialized,
+    int num_foreground_signatures, tfrt::SavedModel* saved_model,
+    std::vector<PredictionLog>* background_records);
+
+// Replays `records` on `saved_model` one at a time, in order, until all of them
+// are replayed or `cancelled` is set, which compiles the lazily initialized
+// signatures they invoke. As the model is already serving, a failing record is
+// logged and skipped.
+void RunBackgroundSavedModelWarmup(const std::vector<PredictionLog>& records,
+                                   const string& export_dir,
+                                   int lazy_init_threshold,
+                                   bool skip_warmup_requests_if_initialized,
+                                   const std::atomic<bool>& cancelled,
+                                   tfrt::SavedModel* saved_model);
+
 }  // namespace serving
 }  // namespace tensorflow
 
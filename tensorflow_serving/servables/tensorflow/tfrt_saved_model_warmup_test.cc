@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_warmup.h"
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/wrappers.pb.h"
 #include "tensorflow/cc/saved_model/constants.h"
@@ -268,6 +271,96 @@ TEST(TFRTSavedModelWarmupTest, SkipWarmupRequest) {
                                    saved_model.get()));
 }
 
+TEST(TFRTSavedModelWarmupTest, BackgroundWarmup) {
+  string base_path = io::JoinPath(testing::TmpDir(), "BackgroundWarmup");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+      io::JoinPath(base_path, kSavedModelAssetsExtraDirectory)));
+  string fname = io::JoinPath(base_path, kSavedModelAssetsExtraDirectory,
+                              internal::WarmupConsts::kRequestsFileName);
+
+  // Twice as many Predict records as Regress ones.
+  std::vector<string> warmup_records;
+  TF_ASSERT_OK(AddMixedWarmupData(
+      &warmup_records, {PredictionLog::kRegressLog, PredictionLog::kPredictLog,
+                        PredictionLog::kPredictLog}));
+  TF_ASSERT_OK(WriteWarmupData(fname, warmup_records, 5));
+
+  auto saved_model = std::make_unique<test_util::MockSavedModel>();
+  tfrt::internal::Signature predict_signature;
+  predict_signature.input_names = {kPredictInputs};
+  predict_signature.input_specs = {tfrt::TensorSpec(tensorflow::DT_STRING)};
+  predict_signature.output_names = {kPredictOutputs};
+  tfrt::FunctionMetadata predict_function_metadata(&predict_signature);
+  EXPECT_CALL(*saved_model, GetFunctionMetadata(kPredictMethodName))
+      .WillRepeatedly(Return(predict_function_metadata));
+  tfrt::internal::Signature regress_signature;
+  regress_signature.input_names = {kRegressInputs};
+  regress_signature.output_names = {kRegressOutputs};
+  tfrt::FunctionMetadata regress_function_metadata(&regress_signature);
+  EXPECT_CALL(*saved_model, GetFunctionMetadata(kRegressMethodName))
+      .WillRepeatedly(Return(regress_function_metadata));
+  MetaGraphDef meta_graph_def;
+  AddSignatures(&meta_graph_def);
+  EXPECT_CALL(*saved_model, GetMetaGraphDef())
+      .WillRepeatedly(ReturnRef(meta_graph_def));
+
+  Tensor scores(DT_FLOAT, TensorShape({1, 1}));
+  auto return_scores = DoAll(
+      WithArgs<3>([&](std::vector<Tensor>* output_tensors) {
+        output_tensors->push_back(scores);
+      }),
+      Return(OkStatus()));
+
+  // Only the hot Predict signature warms up in the foreground.
+  EXPECT_CALL(*saved_model, Run(_, ::testing::Eq(kPredictMethodName),
+                                ::testing::An<absl::Span<const Tensor>>(), _))
+      .Times(10)
+      .WillRepeatedly(return_scores);
+  EXPECT_CALL(*saved_model, Run(_, ::testing::Eq(kRegressMethodName),
+                                ::testing::An<absl::Span<const Tensor>>(), _))
+      .Times(0);
+  std::vector<PredictionLog> background_records;
+  TF_ASSERT_OK(RunForegroundSavedModelWarmup(
+      ModelWarmupOptions(), base_path, /*lazy_init_threshold=*/0,
+      /*skip_warmup_requests_if_initialized=*/true,
+      /*num_foreground_signatures=*/1, saved_model.get(),
+      &background_records));
+  ASSERT_EQ(5, background_records.size());
+  for (const PredictionLog& record : background_records) {
+    EXPECT_EQ(PredictionLog::kRegressLog, record.log_type_case());
+  }
+  ::testing::Mock::VerifyAndClearExpectations(saved_model.get());
+
+  // A cancelled background warmup replays nothing.
+  EXPECT_CALL(*saved_model, GetMetaGraphDef())
+      .WillRepeatedly(ReturnRef(meta_graph_def));
+  EXPECT_CALL(*saved_model, GetFunctionMetadata(kRegressMethodName))
+      .WillRepeatedly(Return(regress_function_metadata));
+  std::atomic<bool> cancelled{true};
+  EXPECT_CALL(*saved_model, Run(_, ::testing::Eq(kRegressMethodName),
+                                ::testing::An<absl::Span<const Tensor>>(), _))
+      .Times(0);
+  RunBackgroundSavedModelWarmup(background_records, base_path,
+                                /*lazy_init_threshold=*/0,
+                                /*skip_warmup_requests_if_initialized=*/true,
+                                cancelled, saved_model.get());
+  ::testing::Mock::VerifyAndClearExpectations(saved_model.get());
+
+  EXPECT_CALL(*saved_model, GetMetaGraphDef())
+      .WillRepeatedly(ReturnRef(meta_graph_def));
+  EXPECT_CALL(*saved_model, GetFunctionMetadata(kRegressMethodName))
+      .WillRepeatedly(Return(regress_function_metadata));
+  EXPECT_CALL(*saved_model, Run(_, ::testing::Eq(kRegressMethodName),
+                                ::testing::An<absl::Span<const Tensor>>(), _))
+      .Times(5)
+      .WillRepeatedly(return_scores);
+  cancelled = false;
+  RunBackgroundSavedModelWarmup(background_records, base_path,
+                                /*lazy_init_threshold=*/0,
+                                /*skip_warmup_requests_if_initialized=*/true,
+                                cancelled, saved_model.get());
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <stdint.h>
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -33,9 +35,12 @@ limitations under the License.
 #include "tensorflow/cc/saved_model/signature_constants.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/tracing.h"  // NOLINT
 #include "tensorflow/core/tfrt/saved_model/saved_model.h"
+#include "tsl/platform/criticality.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/threadpool_options.h"
@@ -51,6 +56,7 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/tfrt_predict_util.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_regressor.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_source_adapter.pb.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_work_queues.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 
 namespace tensorflow {
@@ -59,11 +65,13 @@ namespace serving {
 TfrtSavedModelServable::TfrtSavedModelServable(
     absl::string_view name, int64_t version, const TfrtSavedModelConfig& config,
     std::unique_ptr<tfrt_stub::SavedModel> saved_model,
-    ThreadPoolFactory* thread_pool_factory)
+    ThreadPoolFactory* thread_pool_factory,
+    std::shared_ptr<const TfrtWorkQueues> work_queues)
     : Servable(name, version),
       saved_model_(std::move(saved_model)),
       config_(config),
-      thread_pool_factory_(thread_pool_factory) {
+      thread_pool_factory_(thread_pool_factory),
+      work_queues_(std::move(work_queues)) {
   switch (config_.predict_response_tensor_serialization_option()) {
     case TfrtSavedModelConfig::AS_PROTO_FIELD: {
       predict_response_tensor_serialization_option_ =
@@ -83,6 +91,20 @@ TfrtSavedModelServable::TfrtSavedModelServable(
   }
 }
 
+TfrtSavedModelServable::~TfrtSavedModelServable() {
+  background_warmup_cancelled_ = true;
+  background_warmup_thread_.reset();
+}
+
+void TfrtSavedModelServable::StartBackgroundWarmup(
+    std::function<void(const std::atomic<bool>& cancelled)> warmup) {
+  DCHECK(background_warmup_thread_ == nullptr);
+  background_warmup_thread_.reset(Env::Default()->StartThread(
+      {}, "TfrtBackgroundWarmup", [this, warmup = std::move(warmup)]() {
+        warmup(background_warmup_cancelled_);
+      }));
+}
+
 tfrt_stub::SavedModel::RunOptions
 TfrtSavedModelServable::GetTFRTSavedModelRunOptions(
     const Servable::RunOptions& run_options) const {
@@ -92,9 +114,21 @@ TfrtSavedModelServable::GetTFRTSavedModelRunOptions(
   }
   options.validate_input_specs = config_.validate_input_specs();
   options.validate_input_specs_dry_run = config_.validate_input_specs_dry_run();
+  if (work_queues_ != nullptr) {
+    options.work_queue = work_queues_->Select(
+        run_options.priority, tsl::criticality::GetCriticality());
+  }
   return options;
 }
 
+ScopedThreadPools TfrtSavedModelServable::GetThreadPools(
+    const tfrt_stub::SavedModel::RunOptions& run_options) const {
+  if (run_options.work_queue != nullptr || thread_pool_factory_ == nullptr) {
+    return ScopedThreadPools();
+  }
+  return thread_pool_factory_->GetThreadPools();
+}
+
 absl::Status TfrtSavedModelServable::Classify(
     const RunOptions& run_options, const ClassificationRequest& request,
     ClassificationResponse* response) {
@@ -115,13 +149,12 @@ absl::Status TfrtSavedModelServable::Predict(const RunOptions& run_options,
                                              const PredictRequest& request,
                                              PredictResponse* response) {
   TRACELITERAL("TfrtSavedModelServable::Predict");
+  const tfrt_stub::SavedModel::RunOptions tfrt_run_options =
+      GetTFRTSavedModelRunOptions(run_options);
   return internal::RunPredict(
-      GetTFRTSavedModelRunOptions(run_options), version(),
+      tfrt_run_options, version(),
       predict_response_tensor_serialization_option_, saved_model_.get(),
-      request, response,
-      thread_pool_factory_ == nullptr
-          ? tsl::thread::ThreadPoolOptions()
-          : thread_pool_factory_->GetThreadPools().get());
+      request, response, GetThreadPools(tfrt_run_options).get());
 }
 
 // TODO(b/288096487): Add a unit test once we have the streaming model in OSS.
@@ -173,10 +206,7 @@ TfrtSavedModelServable::PredictStreamed(
         return internal::RunPredict(
             tfrt_run_options, version(),
             predict_response_tensor_serialization_option_, saved_model_.get(),
-            request, &response,
-            thread_pool_factory_ == nullptr
-                ? tsl::thread::ThreadPoolOptions()
-                : thread_pool_factory_->GetThreadPools().get());
+            request, &response, GetThreadPools(tfrt_run_options).get());
       });
 }
 
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_SERVABLE_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_SERVABLE_H_
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -24,6 +26,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/tfrt/saved_model/saved_model.h"
 #include "tensorflow_serving/apis/classification.pb.h"
 #include "tensorflow_serving/apis/get_model_metadata.pb.h"
@@ -33,6 +36,7 @@ limitations under the License.
 #include "tensorflow_serving/servables/tensorflow/predict_response_tensor_serialization_option.h"
 #include "tensorflow_serving/servables/tensorflow/servable.h"
 #include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_source_adapter.pb.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_work_queues.h"
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 
 namespace tensorflow {
@@ -46,7 +50,12 @@ class TfrtSavedModelServable : public Servable {
   TfrtSavedModelServable(absl::string_view name, int64_t version,
                          const TfrtSavedModelConfig& config,
                          std::unique_ptr<tfrt_stub::SavedModel> saved_model,
-                         ThreadPoolFactory* thread_pool_factory);
+                         ThreadPoolFactory* thread_pool_factory,
+                         std::shared_ptr<const TfrtWorkQueues> work_queues =
+                             nullptr);
+
+  // Stops the background warmup, if any, and waits for it.
+  ~TfrtSavedModelServable() override;
 
   absl::Status Classify(const RunOptions& run_options,
                         const ClassificationRequest& request,
@@ -74,10 +83,21 @@ class TfrtSavedModelServable : public Servable {
 
   tfrt_stub::SavedModel& saved_model() const { return *saved_model_; }
 
+  // Runs `warmup` on a thread of its own, so that the servable finishes warming
+  // up while it serves. `warmup` should return soon once `cancelled` is set,
+  // which happens when the servable is destroyed. Must be called at most once.
+  void StartBackgroundWarmup(
+      std::function<void(const std::atomic<bool>& cancelled)> warmup);
+
  private:
   tfrt_stub::SavedModel::RunOptions GetTFRTSavedModelRunOptions(
       const Servable::RunOptions& run_options) const;
 
+  // The thread pools for Predict to run `run_options` on, unless they already
+  // have a work queue of the model.
+  ScopedThreadPools GetThreadPools(
+      const tfrt_stub::SavedModel::RunOptions& run_options) const;
+
   std::unique_ptr<tfrt_stub::SavedModel> saved_model_;
 
   TfrtSavedModelConfig config_;
@@ -90,6 +110,15 @@ class TfrtSavedModelServable : public Servable {
   // implementation, the factory will own the `thread_pool_factory_` and it will
   // be shared across different Servables.
   ThreadPoolFactory* thread_pool_factory_ = nullptr;
+
+  // The work queues of the model, shared by its versions, which take
+  // precedence over `thread_pool_factory_`. Can be null.
+  const std::shared_ptr<const TfrtWorkQueues> work_queues_;
+
+  // Set to stop `background_warmup_thread_` before `saved_model_` is
+  // destroyed.
+  std::atomic<bool> background_warmup_cancelled_{false};
+  std::unique_ptr<Thread> background_warmup_thread_;
 };
 
 // Creates a TfrtSavedModelServable from `saved_model_dir`.
@@ -0,0 +1,76 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/tfrt_work_queues.h"
+
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+Status TfrtWorkQueues::Create(
+    const string& name,
+    const protobuf::RepeatedPtrField<TfrtWorkQueueConfig>& configs,
+    std::unique_ptr<TfrtWorkQueues>* result) {
+  std::unique_ptr<TfrtWorkQueues> work_queues(new TfrtWorkQueues());
+  for (int i = 0; i < configs.size(); ++i) {
+    const TfrtWorkQueueConfig& config = configs[i];
+    if (config.num_inter_op_threads() <= 0 ||
+        config.num_intra_op_threads() <= 0) {
+      return errors::InvalidArgument(
+          "Work queue ", i, " of ", name,
+          " must have positive numbers of inter- and intra-op threads; has ",
+          config.num_inter_op_threads(), " and ",
+          config.num_intra_op_threads());
+    }
+    Queue queue;
+    queue.config = config;
+    DedicatedThreadPoolFactory::Options options;
+    options.name = absl::StrCat(name, "_work_queue_", i);
+    options.num_inter_op_threads = config.num_inter_op_threads();
+    options.num_intra_op_threads = config.num_intra_op_threads();
+    TF_RETURN_IF_ERROR(
+        DedicatedThreadPoolFactory::Create(options, &queue.thread_pools));
+    // The pools are owned by the factory, which outlives the queue.
+    const thread::ThreadPoolOptions thread_pools =
+        queue.thread_pools->GetThreadPools().get();
+    queue.work_queue = std::make_unique<tfrt_stub::TfThreadPoolWorkQueue>(
+        /*intra_op_threadpool=*/thread_pools.intra_op_threadpool,
+        /*inter_op_threadpool=*/thread_pools.inter_op_threadpool);
+    work_queues->queues_.push_back(std::move(queue));
+  }
+  *result = std::move(work_queues);
+  return OkStatus();
+}
+
+tfrt_stub::WorkQueueInterface* TfrtWorkQueues::Select(
+    int64_t priority, tsl::criticality::Criticality criticality) const {
+  const bool sheddable =
+      criticality == tsl::criticality::Criticality::kSheddablePlus ||
+      criticality == tsl::criticality::Criticality::kSheddable;
+  for (const Queue& queue : queues_) {
+    if (priority >= queue.config.min_priority() &&
+        (sheddable || !queue.config.sheddable_only())) {
+      return queue.work_queue.get();
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
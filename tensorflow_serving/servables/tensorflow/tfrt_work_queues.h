@@ -0,0 +1,72 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_WORK_QUEUES_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_WORK_QUEUES_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/repeated_field.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/tfrt/runtime/tf_threadpool_concurrent_work_queue.h"
+#include "tsl/platform/criticality.h"
+#include "tensorflow_serving/servables/tensorflow/dedicated_thread_pool_factory.h"
+#include "tensorflow_serving/servables/tensorflow/tfrt_saved_model_source_adapter.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The TFRT work queues of a model, each with thread pools of its own, that its
+// requests run on by their priority and criticality instead of the default work
+// queue of the runtime. See TfrtSavedModelConfig.work_queues.
+//
+// This class is thread-safe.
+class TfrtWorkQueues {
+ public:
+  // Creates the queues of `configs`, naming their threads after `name`.
+  static Status Create(
+      const string& name,
+      const protobuf::RepeatedPtrField<TfrtWorkQueueConfig>& configs,
+      std::unique_ptr<TfrtWorkQueues>* result);
+
+  ~TfrtWorkQueues() = default;
+
+  // Returns the first queue that matches a request with `priority` issued with
+  // `criticality`, or nullptr if none does.
+  tfrt_stub::WorkQueueInterface* Select(
+      int64_t priority, tsl::criticality::Criticality criticality) const;
+
+ private:
+  struct Queue {
+    TfrtWorkQueueConfig config;
+    std::unique_ptr<DedicatedThreadPoolFactory> thread_pools;
+    std::unique_ptr<tfrt_stub::TfThreadPoolWorkQueue> work_queue;
+  };
+
+  TfrtWorkQueues() = default;
+
+  std::vector<Queue> queues_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TfrtWorkQueues);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TFRT_WORK_QUEUES_H_
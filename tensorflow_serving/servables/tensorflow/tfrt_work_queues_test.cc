@@ -0,0 +1,81 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/tfrt_work_queues.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using test_util::CreateProto;
+using tsl::criticality::Criticality;
+
+TEST(TfrtWorkQueuesTest, SelectsFirstMatchingQueue) {
+  const TfrtWorkQueuesConfig config = CreateProto<TfrtWorkQueuesConfig>(
+      "work_queues { "
+      "  sheddable_only: true "
+      "  num_inter_op_threads: 1 "
+      "  num_intra_op_threads: 1 "
+      "} "
+      "work_queues { "
+      "  min_priority: 2 "
+      "  num_inter_op_threads: 2 "
+      "  num_intra_op_threads: 2 "
+      "} ");
+  std::unique_ptr<TfrtWorkQueues> work_queues;
+  TF_ASSERT_OK(
+      TfrtWorkQueues::Create("model", config.work_queues(), &work_queues));
+
+  tfrt_stub::WorkQueueInterface* const bulk =
+      work_queues->Select(1, Criticality::kSheddable);
+  ASSERT_NE(nullptr, bulk);
+  EXPECT_EQ(bulk, work_queues->Select(5, Criticality::kSheddablePlus));
+
+  tfrt_stub::WorkQueueInterface* const high_priority =
+      work_queues->Select(2, Criticality::kCritical);
+  ASSERT_NE(nullptr, high_priority);
+  EXPECT_NE(bulk, high_priority);
+
+  // Interactive requests of the default priority stay on the default queue.
+  EXPECT_EQ(nullptr, work_queues->Select(1, Criticality::kCritical));
+}
+
+TEST(TfrtWorkQueuesTest, NoQueues) {
+  std::unique_ptr<TfrtWorkQueues> work_queues;
+  TF_ASSERT_OK(TfrtWorkQueues::Create(
+      "model", TfrtWorkQueuesConfig().work_queues(), &work_queues));
+  EXPECT_EQ(nullptr, work_queues->Select(1, Criticality::kSheddable));
+}
+
+TEST(TfrtWorkQueuesTest, InvalidConfig) {
+  // Both pools need threads.
+  const TfrtWorkQueuesConfig config = CreateProto<TfrtWorkQueuesConfig>(
+      "work_queues { "
+      "  num_inter_op_threads: 1 "
+      "} ");
+  std::unique_ptr<TfrtWorkQueues> work_queues;
+  EXPECT_FALSE(
+      TfrtWorkQueues::Create("model", config.work_queues(), &work_queues).ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
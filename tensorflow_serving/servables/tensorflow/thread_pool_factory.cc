@@ -15,12 +15,31 @@ limitations under the License.
 
 #include "tensorflow_serving/servables/tensorflow/thread_pool_factory.h"
 
+#include <functional>
 #include <memory>
 #include <utility>
 
 namespace tensorflow {
 namespace serving {
 
+namespace {
+
+// Runs the closures scheduled on it on the thread that schedules them.
+class InlineThreadPool final : public thread::ThreadPoolInterface {
+ public:
+  void Schedule(std::function<void()> fn) override { fn(); }
+  int NumThreads() const override { return 1; }
+  int CurrentThreadId() const override { return -1; }
+};
+
+}  // namespace
+
+std::shared_ptr<thread::ThreadPoolInterface> GetInlineThreadPool() {
+  static auto* const pool = new std::shared_ptr<thread::ThreadPoolInterface>(
+      std::make_shared<InlineThreadPool>());
+  return *pool;
+}
+
 ScopedThreadPools::ScopedThreadPools(
     std::shared_ptr<thread::ThreadPoolInterface> inter_op_thread_pool,
     std::shared_ptr<thread::ThreadPoolInterface> intra_op_thread_pool)
@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_THREAD_POOL_FACTORY_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_THREAD_POOL_FACTORY_H_
 
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow_serving/util/class_registration.h"
@@ -43,6 +47,10 @@ class ScopedThreadPools {
   std::shared_ptr<thread::ThreadPoolInterface> intra_op_thread_pool_;
 };
 
+// Returns a thread pool that runs the closures scheduled on it on the thread
+// that schedules them, e.g. to run small graphs on the thread of the request.
+std::shared_ptr<thread::ThreadPoolInterface> GetInlineThreadPool();
+
 // Factory for returning intra- and inter-op thread pools to be used by
 // Tensorflow.
 class ThreadPoolFactory {
@@ -50,6 +58,20 @@ class ThreadPoolFactory {
   virtual ~ThreadPoolFactory() = default;
 
   virtual ScopedThreadPools GetThreadPools() = 0;
+
+  // Returns the pools for a request of 'cost_key' (e.g. a signature of a
+  // model) whose inputs are 'input_bytes' long. Factories that pick the pools
+  // by the expected cost of each request override it, and learn the costs from
+  // RecordRequestCost().
+  virtual ScopedThreadPools GetThreadPoolsForRequest(const string& cost_key,
+                                                     int64_t input_bytes) {
+    return GetThreadPools();
+  }
+
+  // Reports that a request of 'cost_key' with 'input_bytes' of inputs ran for
+  // 'run_micros' on pools from GetThreadPoolsForRequest().
+  virtual void RecordRequestCost(const string& cost_key, int64_t input_bytes,
+                                 int64_t run_micros) {}
 };
 
 DEFINE_CLASS_REGISTRY(ThreadPoolFactoryRegistry, ThreadPoolFactory);
@@ -0,0 +1,289 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/tokenizing_session.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "src/sentencepiece_processor.h"
+#include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class SentencePieceTokenizer : public Tokenizer {
+ public:
+  SentencePieceTokenizer() = default;
+  ~SentencePieceTokenizer() override = default;
+
+  Status Load(const string& path) {
+    string model;
+    TF_RETURN_IF_ERROR(ReadFileToString(Env::Default(), path, &model));
+    const auto status = processor_.LoadFromSerializedProto(model);
+    if (!status.ok()) {
+      return errors::InvalidArgument("Invalid SentencePiece model ", path,
+                                     ": ", status.ToString());
+    }
+    return OkStatus();
+  }
+
+  Status Tokenize(absl::string_view text,
+                  std::vector<int>* ids) const override {
+    std::vector<int> piece_ids;
+    const auto status = processor_.Encode(text, &piece_ids);
+    if (!status.ok()) {
+      return errors::InvalidArgument("Failed to tokenize text: ",
+                                     status.ToString());
+    }
+    ids->insert(ids->end(), piece_ids.begin(), piece_ids.end());
+    return OkStatus();
+  }
+
+  // Models without a pad piece have a pad id of -1.
+  int pad_id() const override { return std::max(processor_.pad_id(), 0); }
+
+ private:
+  sentencepiece::SentencePieceProcessor processor_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SentencePieceTokenizer);
+};
+
+// A tokenized input of the signatures of a session.
+struct TokenizedInput {
+  string key;
+  DataType dtype;
+  // The number of ids of each string.
+  int64_t length;
+  std::shared_ptr<const Tokenizer> tokenizer;
+};
+
+template <typename T>
+void CopyIds(const std::vector<int>& ids, int64_t row, Tensor* tensor) {
+  auto matrix = tensor->matrix<T>();
+  for (int64_t i = 0; i < ids.size(); ++i) {
+    matrix(row, i) = ids[i];
+  }
+}
+
+// Sets 'ids' to the ids of the tokens of 'text', a tensor of strings, for
+// 'input'.
+Status TokenizeText(const TokenizedInput& input, const Tensor& text,
+                    Tensor* ids) {
+  if (text.dims() != 1) {
+    return errors::InvalidArgument("The text of tokenized input ", input.key,
+                                   " must have shape [batch]; has shape ",
+                                   text.shape().DebugString());
+  }
+  const int64_t batch_size = text.dim_size(0);
+  *ids = Tensor(input.dtype, TensorShape({batch_size, input.length}));
+  const auto strings = text.flat<tstring>();
+  std::vector<int> string_ids;
+  for (int64_t i = 0; i < batch_size; ++i) {
+    string_ids.clear();
+    TF_RETURN_IF_ERROR(input.tokenizer->Tokenize(
+        absl::string_view(strings(i).data(), strings(i).size()), &string_ids));
+    string_ids.resize(input.length, input.tokenizer->pad_id());
+    if (input.dtype == DT_INT32) {
+      CopyIds<int32>(string_ids, i, ids);
+    } else {
+      CopyIds<int64_t>(string_ids, i, ids);
+    }
+  }
+  return OkStatus();
+}
+
+// A session that tokenizes the text fed to the tokenized inputs of its
+// signatures before running the wrapped session.
+class TokenizingSession : public ServingSessionWrapper {
+ public:
+  TokenizingSession(std::unique_ptr<Session> wrapped,
+                    std::unordered_map<string, TokenizedInput> inputs)
+      : ServingSessionWrapper(std::move(wrapped)),
+        inputs_(std::move(inputs)) {}
+
+  ~TokenizingSession() override = default;
+
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    std::vector<std::pair<string, Tensor>> tokenized_inputs;
+    const std::vector<std::pair<string, Tensor>>* feeds;
+    TF_RETURN_IF_ERROR(Tokenize(inputs, &tokenized_inputs, &feeds));
+    return ServingSessionWrapper::Run(*feeds, output_tensor_names,
+                                      target_node_names, outputs);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    std::vector<std::pair<string, Tensor>> tokenized_inputs;
+    const std::vector<std::pair<string, Tensor>>* feeds;
+    TF_RETURN_IF_ERROR(Tokenize(inputs, &tokenized_inputs, &feeds));
+    return ServingSessionWrapper::Run(run_options, *feeds, output_tensor_names,
+                                      target_node_names, outputs,
+                                      run_metadata);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    std::vector<std::pair<string, Tensor>> tokenized_inputs;
+    const std::vector<std::pair<string, Tensor>>* feeds;
+    TF_RETURN_IF_ERROR(Tokenize(inputs, &tokenized_inputs, &feeds));
+    return ServingSessionWrapper::Run(run_options, *feeds, output_tensor_names,
+                                      target_node_names, outputs, run_metadata,
+                                      thread_pool_options);
+  }
+
+  void RunAsync(const RunOptions& run_options,
+                const std::vector<std::pair<string, Tensor>>& inputs,
+                const std::vector<string>& output_tensor_names,
+                const std::vector<string>& target_node_names,
+                std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+                std::function<void(const Status&)> done) override {
+    // The feeds must live until the run completes.
+    auto tokenized_inputs =
+        std::make_shared<std::vector<std::pair<string, Tensor>>>();
+    const std::vector<std::pair<string, Tensor>>* feeds;
+    const Status status = Tokenize(inputs, tokenized_inputs.get(), &feeds);
+    if (!status.ok()) {
+      done(status);
+      return;
+    }
+    ServingSessionWrapper::RunAsync(
+        run_options, *feeds, output_tensor_names, target_node_names, outputs,
+        run_metadata,
+        [tokenized_inputs, done = std::move(done)](const Status& run_status) {
+          done(run_status);
+        });
+  }
+
+ private:
+  // Points 'feeds' at 'inputs' if no text is fed to tokenized inputs, else at
+  // 'tokenized_inputs', set to 'inputs' with the text replaced by its ids.
+  Status Tokenize(const std::vector<std::pair<string, Tensor>>& inputs,
+                  std::vector<std::pair<string, Tensor>>* tokenized_inputs,
+                  const std::vector<std::pair<string, Tensor>>** feeds) const {
+    *feeds = &inputs;
+    for (int i = 0; i < inputs.size(); ++i) {
+      if (inputs[i].second.dtype() != DT_STRING) {
+        continue;
+      }
+      auto input = inputs_.find(inputs[i].first);
+      if (input == inputs_.end()) {
+        continue;
+      }
+      if (*feeds == &inputs) {
+        *tokenized_inputs = inputs;
+        *feeds = tokenized_inputs;
+      }
+      TF_RETURN_IF_ERROR(TokenizeText(input->second, inputs[i].second,
+                                      &(*tokenized_inputs)[i].second));
+    }
+    return OkStatus();
+  }
+
+  // The tokenized inputs, by feed tensor name.
+  const std::unordered_map<string, TokenizedInput> inputs_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(TokenizingSession);
+};
+
+}  // namespace
+
+Status CreateSentencePieceTokenizer(const string& path,
+                                    std::unique_ptr<Tokenizer>* tokenizer) {
+  auto sentence_piece_tokenizer = std::make_unique<SentencePieceTokenizer>();
+  TF_RETURN_IF_ERROR(sentence_piece_tokenizer->Load(path));
+  *tokenizer = std::move(sentence_piece_tokenizer);
+  return OkStatus();
+}
+
+Status WrapSessionForTokenization(const std::vector<SignatureDef>& signatures,
+                                  const TokenizerCreator& tokenizer_creator,
+                                  std::unique_ptr<Session>* session) {
+  // Tokenized inputs of the same name share their tokenizer.
+  std::map<string, std::shared_ptr<const Tokenizer>> tokenizers;
+  std::unordered_map<string, TokenizedInput> inputs;
+  for (const SignatureDef& signature : signatures) {
+    for (const auto& entry : signature.inputs()) {
+      const string& key = entry.first;
+      if (!absl::StartsWith(key, kTokenizedInputsPrefix)) {
+        continue;
+      }
+      const TensorInfo& tensor_info = entry.second;
+      const TensorShapeProto& shape = tensor_info.tensor_shape();
+      if ((tensor_info.dtype() != DT_INT32 &&
+           tensor_info.dtype() != DT_INT64) ||
+          shape.unknown_rank() || shape.dim_size() != 2 ||
+          shape.dim(1).size() <= 0) {
+        return errors::InvalidArgument(
+            "Tokenized input ", key,
+            " must be of type int32 or int64, and shape [batch, n]");
+      }
+      const string name =
+          key.substr(absl::string_view(kTokenizedInputsPrefix).size());
+      std::shared_ptr<const Tokenizer>& tokenizer = tokenizers[name];
+      if (tokenizer == nullptr) {
+        std::unique_ptr<Tokenizer> new_tokenizer;
+        TF_RETURN_IF_ERROR(tokenizer_creator(name, &new_tokenizer));
+        tokenizer = std::move(new_tokenizer);
+      }
+      inputs[tensor_info.name()] = {key, tensor_info.dtype(),
+                                    shape.dim(1).size(), tokenizer};
+    }
+  }
+  if (inputs.empty()) {
+    return OkStatus();
+  }
+  session->reset(new TokenizingSession(std::move(*session), std::move(inputs)));
+  return OkStatus();
+}
+
+Status WrapSessionForTokenization(const string& export_dir,
+                                  const std::vector<SignatureDef>& signatures,
+                                  std::unique_ptr<Session>* session) {
+  return WrapSessionForTokenization(
+      signatures,
+      [&export_dir](const string& name, std::unique_ptr<Tokenizer>* tokenizer) {
+        return CreateSentencePieceTokenizer(
+            io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                         name + ".model"),
+            tokenizer);
+      },
+      session);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,83 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TOKENIZING_SESSION_H_
+#define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TOKENIZING_SESSION_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The prefix of the input keys of signatures that take the token ids of text,
+// tokenized by the server rather than by the graph.
+//
+// An input "tokens/<name>" of type DT_INT32 or DT_INT64 and shape [batch, n]
+// can be fed a DT_STRING tensor of shape [batch] instead, e.g. by a
+// PredictRequest: the server then feeds it the ids of the tokens of each
+// string, truncated or padded to n, with the SentencePiece model
+// 'assets.extra/<name>.model' of the SavedModel. Tokenization happens on the
+// threads of the requests, before they are batched, so that the requests of a
+// batch are all tokenized in parallel and none on the batch thread.
+constexpr char kTokenizedInputsPrefix[] = "tokens/";
+
+// A tokenizer of strings into token ids.
+//
+// Implementations must be thread-safe.
+class Tokenizer {
+ public:
+  virtual ~Tokenizer() = default;
+
+  // Appends the ids of the tokens of 'text' to 'ids'.
+  virtual Status Tokenize(absl::string_view text,
+                          std::vector<int>* ids) const = 0;
+
+  // The id to pad sequences of ids with.
+  virtual int pad_id() const = 0;
+};
+
+// Creates a Tokenizer with the serialized SentencePiece model at 'path'.
+Status CreateSentencePieceTokenizer(const string& path,
+                                    std::unique_ptr<Tokenizer>* tokenizer);
+
+// Creates the tokenizer of the tokenized inputs "tokens/<name>", by name.
+using TokenizerCreator =
+    std::function<Status(const string& name, std::unique_ptr<Tokenizer>*)>;
+
+// If any of 'signatures' has tokenized inputs, wraps 'session' in one that
+// tokenizes the DT_STRING tensors fed to them, with the tokenizers
+// 'tokenizer_creator' creates, and passes the other feeds through.
+Status WrapSessionForTokenization(const std::vector<SignatureDef>& signatures,
+                                  const TokenizerCreator& tokenizer_creator,
+                                  std::unique_ptr<Session>* session);
+
+// Like above, with the SentencePiece models in 'assets.extra' of the
+// SavedModel at 'export_dir'.
+Status WrapSessionForTokenization(const string& export_dir,
+                                  const std::vector<SignatureDef>& signatures,
+                                  std::unique_ptr<Session>* session);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_TOKENIZING_SESSION_H_
@@ -0,0 +1,195 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/servables/tensorflow/tokenizing_session.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow_serving/servables/tensorflow/serving_session.h"
+#include "tensorflow_serving/test_util/test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// A session that returns its feeds as fetches.
+class EchoSession : public ServingSession {
+ public:
+  Status Run(const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs) override {
+    for (const auto& input : inputs) {
+      outputs->push_back(input.second);
+    }
+    return OkStatus();
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata) override {
+    return Run(inputs, output_tensor_names, target_node_names, outputs);
+  }
+
+  Status Run(const RunOptions& run_options,
+             const std::vector<std::pair<string, Tensor>>& inputs,
+             const std::vector<string>& output_tensor_names,
+             const std::vector<string>& target_node_names,
+             std::vector<Tensor>* outputs, RunMetadata* run_metadata,
+             const thread::ThreadPoolOptions& thread_pool_options) override {
+    return Run(inputs, output_tensor_names, target_node_names, outputs);
+  }
+
+  Status ListDevices(std::vector<DeviceAttributes>* response) override {
+    return OkStatus();
+  }
+};
+
+// Tokenizes on spaces, with the length of each word as its id.
+class WordLengthTokenizer : public Tokenizer {
+ public:
+  Status Tokenize(absl::string_view text,
+                  std::vector<int>* ids) const override {
+    for (absl::string_view word :
+         absl::StrSplit(text, ' ', absl::SkipEmpty())) {
+      ids->push_back(word.size());
+    }
+    return OkStatus();
+  }
+
+  int pad_id() const override { return 0; }
+};
+
+// Creates WordLengthTokenizers, counting them.
+TokenizerCreator CountingTokenizerCreator(int* num_created) {
+  return [num_created](const string& name,
+                       std::unique_ptr<Tokenizer>* tokenizer) {
+    ++*num_created;
+    tokenizer->reset(new WordLengthTokenizer());
+    return OkStatus();
+  };
+}
+
+// A signature with the tokenized input "tokens/text", fed by 'text_ids:0',
+// and the plain input "x".
+constexpr char kSignature[] = R"(
+  inputs {
+    key: "tokens/text"
+    value {
+      name: "text_ids:0"
+      dtype: DT_INT32
+      tensor_shape { dim { size: -1 } dim { size: 3 } }
+    }
+  }
+  inputs {
+    key: "x"
+    value { name: "x:0" dtype: DT_STRING tensor_shape { dim { size: -1 } } }
+  }
+)";
+
+TEST(TokenizingSessionTest, TokenizesText) {
+  int num_created = 0;
+  const SignatureDef signature =
+      test_util::CreateProto<SignatureDef>(kSignature);
+  std::unique_ptr<Session> session = std::make_unique<EchoSession>();
+  TF_ASSERT_OK(WrapSessionForTokenization(
+      {signature, signature}, CountingTokenizerCreator(&num_created),
+      &session));
+  // The signatures share the tokenizer of the input.
+  EXPECT_EQ(1, num_created);
+
+  // Text is padded or truncated to the length of the input. Other feeds are
+  // passed through.
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run(
+      {{"text_ids:0", test::AsTensor<tstring>({"a bb", "a bb ccc dddd"})},
+       {"x:0", test::AsTensor<tstring>({"a bb", "c"})}},
+      {}, {}, &outputs));
+  ASSERT_EQ(2, outputs.size());
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>({1, 2, 0, 1, 2, 3}, TensorShape({2, 3})),
+      outputs[0]);
+  test::ExpectTensorEqual<tstring>(test::AsTensor<tstring>({"a bb", "c"}),
+                                   outputs[1]);
+
+  // Ids are passed through.
+  outputs.clear();
+  const Tensor ids = test::AsTensor<int32>({7, 8, 9}, TensorShape({1, 3}));
+  TF_ASSERT_OK(session->Run({{"text_ids:0", ids}}, {}, {}, &outputs));
+  test::ExpectTensorEqual<int32>(ids, outputs[0]);
+
+  // Text must be a vector.
+  const Tensor text_matrix =
+      test::AsTensor<tstring>({"a"}, TensorShape({1, 1}));
+  EXPECT_FALSE(
+      session->Run({{"text_ids:0", text_matrix}}, {}, {}, &outputs).ok());
+}
+
+TEST(TokenizingSessionTest, RunAsync) {
+  int num_created = 0;
+  std::unique_ptr<Session> session = std::make_unique<EchoSession>();
+  TF_ASSERT_OK(WrapSessionForTokenization(
+      {test_util::CreateProto<SignatureDef>(kSignature)},
+      CountingTokenizerCreator(&num_created), &session));
+  auto* serving_session = dynamic_cast<ServingSession*>(session.get());
+  ASSERT_NE(nullptr, serving_session);
+  std::vector<Tensor> outputs;
+  Status run_status = errors::Unknown("Not run");
+  serving_session->RunAsync(
+      RunOptions(), {{"text_ids:0", test::AsTensor<tstring>({"ccc"})}}, {}, {},
+      &outputs, nullptr,
+      [&run_status](const Status& status) { run_status = status; });
+  TF_ASSERT_OK(run_status);
+  test::ExpectTensorEqual<int32>(
+      test::AsTensor<int32>({3, 0, 0}, TensorShape({1, 3})), outputs[0]);
+}
+
+TEST(TokenizingSessionTest, WrapsOnlySignaturesWithTokenizedInputs) {
+  int num_created = 0;
+  std::unique_ptr<Session> session = std::make_unique<EchoSession>();
+  Session* const echo_session = session.get();
+  TF_ASSERT_OK(WrapSessionForTokenization(
+      {test_util::CreateProto<SignatureDef>(
+          "inputs { key: 'x' value { name: 'x:0' dtype: DT_STRING } }")},
+      CountingTokenizerCreator(&num_created), &session));
+  EXPECT_EQ(echo_session, session.get());
+  EXPECT_EQ(0, num_created);
+
+  // Tokenized inputs must have a fixed length.
+  EXPECT_FALSE(WrapSessionForTokenization(
+                   {test_util::CreateProto<SignatureDef>(
+                       "inputs { "
+                       "  key: 'tokens/text' "
+                       "  value { "
+                       "    name: 'text_ids:0' "
+                       "    dtype: DT_INT64 "
+                       "    tensor_shape { dim { size: -1 } dim { size: -1 } } "
+                       "  } "
+                       "}")},
+                   CountingTokenizerCreator(&num_created), &session)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
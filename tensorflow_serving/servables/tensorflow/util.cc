@@ -18,13 +18,16 @@ limitations under the License.
 #include <algorithm>
 #include <atomic>
 #include <cstdlib>
-#include <deque>
+#include <cstring>
 #include <iterator>
 #include <set>
 #include <utility>
 #include <vector>
 
 #include "google/protobuf/wrappers.pb.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/cc/saved_model/signature_constants.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
@@ -34,13 +37,17 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cord.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/threadpool_options.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_serving/apis/input.pb.h"
 #include "tensorflow_serving/apis/internal/serialized_input.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
 #include "tensorflow_serving/resources/resource_values.h"
+#include "tensorflow_serving/servables/tensorflow/example_features.h"
+#include "tensorflow_serving/util/saturation_monitor.h"
 #include "tensorflow_serving/util/threadpool_executor.h"
 
 namespace tensorflow {
@@ -51,23 +58,24 @@ namespace {
 static constexpr double kResourceEstimateRAMMultiplier = 1.2;
 static constexpr int kResourceEstimateRAMPadBytes = 0;
 
-auto* example_counts = monitoring::Sampler<1>::New(
+auto* example_counts = ShardedSampler<1>::New(
     {"/tensorflow/serving/request_example_counts",
      "The number of tensorflow.Examples per request.", "model"},
     // It's 15 buckets with the last bucket being 2^14 to DBL_MAX;
     // so the limits are [1, 2, 4, 8, ..., 16 * 1024, DBL_MAX].
     monitoring::Buckets::Exponential(1, 2, 15));
 
-auto* example_count_total = monitoring::Counter<1>::New(
+auto* example_count_total = ShardedCounter<1>::New(
     "/tensorflow/serving/request_example_count_total",
     "The total number of tensorflow.Examples.", "model");
 
-// Metrics by model
-auto* model_request_status_count_total = monitoring::Counter<2>::New(
+// Metrics by model. Those updated on every request are sharded, so that
+// requests on different cores don't contend on them.
+auto* model_request_status_count_total = ShardedCounter<2>::New(
     "/tensorflow/serving/request_count", "The total number of requests.",
     "model_name", "status");
 
-auto* runtime_latency = monitoring::Sampler<3>::New(
+auto* runtime_latency = ShardedSampler<3>::New(
     {
         "/tensorflow/serving/runtime_latency",
         "Distribution of wall time (in microseconds) for Tensorflow runtime.",
@@ -77,7 +85,18 @@ auto* runtime_latency = monitoring::Sampler<3>::New(
     },  // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
     monitoring::Buckets::Exponential(10, 1.8, 33));
 
-auto* request_latency = monitoring::Sampler<3>::New(
+auto* request_stage_latency = ShardedSampler<3>::New(
+    {
+        "/tensorflow/serving/request_stage_latency",
+        "Distribution of wall time (in microseconds) for the stages of "
+        "Tensorflow Serving requests.",
+        "model_name",
+        "API",
+        "stage",
+    },  // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
+    monitoring::Buckets::Exponential(10, 1.8, 33));
+
+auto* request_latency = ShardedSampler<3>::New(
     {
         "/tensorflow/serving/request_latency",
         "Distribution of wall time (in microseconds) for Tensorflow Serving"
@@ -88,8 +107,9 @@ auto* request_latency = monitoring::Sampler<3>::New(
     },  // Scale of 10, power of 1.8 with bucket count 33 (~20 minutes).
     monitoring::Buckets::Exponential(10, 1.8, 33));
 
-// Returns the number of examples in the Input.
-int NumInputExamples(const internal::SerializedInput& input) {
+// Returns the number of examples in the Input, or in its serialized form.
+template <typename InputProto>
+int NumInputExamples(const InputProto& input) {
   switch (input.kind_case()) {
     case Input::KindCase::kExampleList:
       return input.example_list().examples_size();
@@ -101,15 +121,31 @@ int NumInputExamples(const internal::SerializedInput& input) {
   return 0;
 }
 
+#if !defined(PLATFORM_GOOGLE)
+// Sets 'out' to 'prefix' followed by the serialized 'example', allocating it
+// once.
+void SerializeExampleWithPrefix(absl::string_view prefix,
+                                const Example& example, tstring* out) {
+  const size_t example_size = example.ByteSizeLong();
+  out->resize_uninitialized(prefix.size() + example_size);
+  char* out_ptr = &(*out)[0];
+  if (!prefix.empty()) {
+    memcpy(out_ptr, prefix.data(), prefix.size());
+  }
+  example.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8_t*>(out_ptr + prefix.size()));
+}
+#endif
+
 std::atomic<bool> signature_method_check{false};
 
 }  // namespace
 
 namespace internal {
 
-monitoring::Sampler<1>* GetExampleCounts() { return example_counts; }
+ShardedSampler<1>* GetExampleCounts() { return example_counts; }
 
-monitoring::Counter<1>* GetExampleCountTotal() { return example_count_total; }
+ShardedCounter<1>* GetExampleCountTotal() { return example_count_total; }
 
 }  // namespace internal
 
@@ -130,7 +166,18 @@ void RecordRequestExampleCount(const string& model_name, size_t count) {
   example_count_total->GetCell(model_name)->IncrementBy(count);
 }
 
-Status InputToSerializedExampleTensor(const Input& input, Tensor* examples) {
+namespace {
+
+// Serializes the Examples of 'input' into 'examples'. If 'context' is null,
+// the context of an ExampleListWithContext is merged into each Example, and
+// otherwise it is serialized into the scalar 'context' instead (empty for
+// other kinds of input).
+Status SerializeInputExamples(const Input& input, Tensor* examples,
+                              Tensor* context) {
+  if (context != nullptr) {
+    *context = Tensor(DT_STRING, TensorShape({}));
+  }
+#if defined(PLATFORM_GOOGLE)
   internal::SerializedInput serialized_input;
   // There's a reason we serialize and then parse 'input' in this way:
   // 'example_list' and 'example_list_with_context' are lazily parsed
@@ -140,24 +187,18 @@ Status InputToSerializedExampleTensor(const Input& input, Tensor* examples) {
   //
   // SerializedInput proto has been created to prevent this, but at the same
   // time get the count of num_examples as well.
-  bool parse_serialized_input_ok = false;
-#if defined(PLATFORM_GOOGLE)
+  //
+  // Benchmark ('BM_InputToSerializedExample') can help measure the effect of
+  // changes in the future.
   {
-    // Benchmark ('BM_InputToSerializedExample') can help measure the effect of
-    // changes in the future.
     absl::Cord tmp;
     if (!input.SerializeToCord(&tmp)) {
       return errors::InvalidArgument("Input failed to serialize. Size = ",
                                      input.ByteSizeLong());
     }
-    parse_serialized_input_ok = serialized_input.ParseFromCord(tmp);
-  }
-#else
-  parse_serialized_input_ok =
-      serialized_input.ParseFromString(input.SerializeAsString());
-#endif
-  if (!parse_serialized_input_ok) {
-    return errors::Internal("Error parsing serialized input.");
+    if (!serialized_input.ParseFromCord(tmp)) {
+      return errors::Internal("Error parsing serialized input.");
+    }
   }
 
   const int64_t num_examples = NumInputExamples(serialized_input);
@@ -179,25 +220,27 @@ Status InputToSerializedExampleTensor(const Input& input, Tensor* examples) {
     }
 
     case Input::KindCase::kExampleListWithContext: {
-      const auto& context =
+      const auto& serialized_context =
           serialized_input.example_list_with_context().context();
       auto input_vec = examples->vec<tstring>();
       int input_vec_index = 0;
+      if (context != nullptr) {
+        context->scalar<tstring>()() = string(serialized_context);
+        for (const auto& entry :
+             serialized_input.example_list_with_context().examples()) {
+          input_vec(input_vec_index++) = string(entry);
+        }
+        break;
+      }
       for (const auto& entry :
            serialized_input.example_list_with_context().examples()) {
         tstring& input_str = input_vec(input_vec_index++);
-        input_str.resize_uninitialized(context.size() + entry.size());
+        input_str.resize_uninitialized(serialized_context.size() +
+                                       entry.size());
         // 'input_str_ptr' now points to the beginning of input_str.
         char* input_str_ptr = &input_str[0];
-#if defined(PLATFORM_GOOGLE)
-        // When absl::Cord OSS is fully shipped and protobuf open-source suports
-        // Cord, we can get rid of marco above and unify code path.
-        context.CopyToArray(input_str_ptr);
-        entry.CopyToArray(input_str_ptr + context.size());
-#else
-        memcpy(input_str_ptr, &context[0], context.size());
-        memcpy(input_str_ptr + context.size(), &entry[0], entry.size());
-#endif
+        serialized_context.CopyToArray(input_str_ptr);
+        entry.CopyToArray(input_str_ptr + serialized_context.size());
       }
     } break;
 
@@ -206,26 +249,66 @@ Status InputToSerializedExampleTensor(const Input& input, Tensor* examples) {
           "Input with kind ", serialized_input.kind_case(), " not supported.");
   }
   return OkStatus();
+#else
+  // Open-source protobuf parses the lazy 'example_list' and
+  // 'example_list_with_context' fields eagerly, so the Examples are messages
+  // already. Each is serialized straight into its element of the tensor,
+  // rather than serializing all of 'input' and parsing it back as a
+  // SerializedInput, which copied every Example twice more.
+  const int64_t num_examples = NumInputExamples(input);
+  if (num_examples == 0) {
+    return errors::InvalidArgument("Input is empty.");
+  }
+  *examples = Tensor(DT_STRING, TensorShape({num_examples}));
+  auto input_vec = examples->vec<tstring>();
+  switch (input.kind_case()) {
+    case Input::KindCase::kExampleList: {
+      int input_vec_index = 0;
+      for (const Example& example : input.example_list().examples()) {
+        SerializeExampleWithPrefix("", example, &input_vec(input_vec_index++));
+      }
+      break;
+    }
+
+    case Input::KindCase::kExampleListWithContext: {
+      const string serialized_context =
+          input.example_list_with_context().context().SerializeAsString();
+      absl::string_view prefix = serialized_context;
+      if (context != nullptr) {
+        context->scalar<tstring>()() = serialized_context;
+        prefix = "";
+      }
+      int input_vec_index = 0;
+      for (const Example& example :
+           input.example_list_with_context().examples()) {
+        SerializeExampleWithPrefix(prefix, example,
+                                   &input_vec(input_vec_index++));
+      }
+      break;
+    }
+
+    default:
+      return errors::Unimplemented("Input with kind ", input.kind_case(),
+                                   " not supported.");
+  }
+  return OkStatus();
+#endif
 }
 
-Status PerformOneShotTensorComputation(
-    const RunOptions& run_options, const Input& input,
-    const string& input_tensor_name,
+// Runs 'session' on 'inputs', timing the run into 'runtime_latency' if not
+// null.
+Status RunSessionOnInputs(
+    const RunOptions& run_options,
+    const std::vector<std::pair<string, Tensor>>& inputs,
     const std::vector<string>& output_tensor_names, Session* session,
-    std::vector<Tensor>* outputs, int* num_input_examples,
+    std::vector<Tensor>* outputs,
     const thread::ThreadPoolOptions& thread_pool_options,
     int64_t* runtime_latency) {
-  // Setup the input Tensor to be a vector of string containing the serialized
-  // tensorflow.Example.
-  Tensor input_tensor;
-  TF_RETURN_IF_ERROR(InputToSerializedExampleTensor(input, &input_tensor));
-  *num_input_examples = input_tensor.dim_size(0);
-
   const uint64_t start_microseconds = EnvTime::NowMicros();
   RunMetadata run_metadata;
-  TF_RETURN_IF_ERROR(session->Run(
-      run_options, {{input_tensor_name, input_tensor}}, output_tensor_names, {},
-      outputs, &run_metadata, thread_pool_options));
+  TF_RETURN_IF_ERROR(session->Run(run_options, inputs, output_tensor_names,
+                                  {}, outputs, &run_metadata,
+                                  thread_pool_options));
   const uint64_t end_microseconds = EnvTime::NowMicros();
   if (runtime_latency != nullptr) {
     *runtime_latency = end_microseconds - start_microseconds;
@@ -233,6 +316,149 @@ Status PerformOneShotTensorComputation(
   return OkStatus();
 }
 
+// The threads that probe the files of a model in GetModelDiskSize(). Probes
+// are mostly waiting on the file system (e.g. a round trip to GCS each), so
+// the pool is large.
+constexpr int kModelDiskSizeNumThreads = 256;
+
+// Sums the sizes of the files under a directory, probing all its
+// subdirectories and files in parallel on one pool of threads, rather than one
+// directory at a time.
+//
+// This class is thread-safe.
+class ModelDiskSizeWalker {
+ public:
+  explicit ModelDiskSizeWalker(FileProbingEnv* env)
+      : env_(env),
+        executor_(Env::Default(), "ModelDiskSizePool",
+                  kModelDiskSizeNumThreads) {}
+
+  Status Walk(const string& path, uint64_t* total_file_size) {
+    ScheduleVisit(path, /*is_dir=*/true);
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) {
+      done_.wait(l);
+    }
+    *total_file_size = total_file_size_;
+    return status_;
+  }
+
+ private:
+  // Visits 'path' on the pool, unless the walk already failed.
+  void ScheduleVisit(const string& path, bool is_dir) {
+    {
+      mutex_lock l(mu_);
+      if (!status_.ok()) {
+        return;
+      }
+      ++num_pending_;
+    }
+    executor_.Schedule([this, path, is_dir]() {
+      const Status status = is_dir ? VisitDir(path) : VisitChild(path);
+      mutex_lock l(mu_);
+      status_.Update(status);
+      if (--num_pending_ == 0) {
+        done_.notify_all();
+      }
+    });
+  }
+
+  Status VisitDir(const string& dir) {
+    std::vector<string> children;
+    // GetChildren might fail if we don't have appropriate permissions.
+    TF_RETURN_IF_ERROR(env_->GetChildren(dir, &children));
+    for (const string& child : children) {
+      ScheduleVisit(io::JoinPath(dir, child), /*is_dir=*/false);
+    }
+    return OkStatus();
+  }
+
+  Status VisitChild(const string& path) {
+    if (env_->IsDirectory(path).ok()) {
+      return VisitDir(path);
+    }
+    uint64_t file_size;
+    TF_RETURN_IF_ERROR(env_->GetFileSize(path, &file_size));
+    mutex_lock l(mu_);
+    total_file_size_ += file_size;
+    return OkStatus();
+  }
+
+  FileProbingEnv* const env_;
+
+  mutex mu_;
+  condition_variable done_;
+  int64_t num_pending_ TF_GUARDED_BY(mu_) = 0;
+  uint64_t total_file_size_ TF_GUARDED_BY(mu_) = 0;
+  Status status_ TF_GUARDED_BY(mu_);
+
+  // Declared last, so that it is destroyed, i.e. joins its threads, first.
+  ThreadPoolExecutor executor_;
+};
+
+}  // namespace
+
+Status InputToSerializedExampleTensor(const Input& input, Tensor* examples) {
+  return SerializeInputExamples(input, examples, /*context=*/nullptr);
+}
+
+Status InputToSerializedExampleAndContextTensors(const Input& input,
+                                                 Tensor* examples,
+                                                 Tensor* context) {
+  return SerializeInputExamples(input, examples, context);
+}
+
+Status PerformOneShotTensorComputation(
+    const RunOptions& run_options, const Input& input,
+    const string& input_tensor_name,
+    const std::vector<string>& output_tensor_names, Session* session,
+    std::vector<Tensor>* outputs, int* num_input_examples,
+    const thread::ThreadPoolOptions& thread_pool_options,
+    int64_t* runtime_latency) {
+  return PerformOneShotTensorComputationWithContext(
+      run_options, input, input_tensor_name, /*context_tensor_name=*/"",
+      output_tensor_names, session, outputs, num_input_examples,
+      thread_pool_options, runtime_latency);
+}
+
+Status PerformOneShotTensorComputationWithContext(
+    const RunOptions& run_options, const Input& input,
+    const string& input_tensor_name, const string& context_tensor_name,
+    const std::vector<string>& output_tensor_names, Session* session,
+    std::vector<Tensor>* outputs, int* num_input_examples,
+    const thread::ThreadPoolOptions& thread_pool_options,
+    int64_t* runtime_latency) {
+  // Setup the input Tensor to be a vector of string containing the serialized
+  // tensorflow.Example.
+  std::vector<std::pair<string, Tensor>> inputs(1);
+  inputs[0].first = input_tensor_name;
+  if (context_tensor_name.empty()) {
+    TF_RETURN_IF_ERROR(
+        InputToSerializedExampleTensor(input, &inputs[0].second));
+  } else {
+    inputs.emplace_back(context_tensor_name, Tensor());
+    TF_RETURN_IF_ERROR(InputToSerializedExampleAndContextTensors(
+        input, &inputs[0].second, &inputs[1].second));
+  }
+  *num_input_examples = inputs[0].second.dim_size(0);
+  return RunSessionOnInputs(run_options, inputs, output_tensor_names, session,
+                            outputs, thread_pool_options, runtime_latency);
+}
+
+Status PerformOneShotFeatureComputation(
+    const RunOptions& run_options, const Input& input,
+    const SignatureDef& signature,
+    const std::vector<string>& output_tensor_names, Session* session,
+    std::vector<Tensor>* outputs, int* num_input_examples,
+    const thread::ThreadPoolOptions& thread_pool_options,
+    int64_t* runtime_latency) {
+  std::vector<std::pair<string, Tensor>> inputs;
+  TF_RETURN_IF_ERROR(
+      ExampleFeaturesToTensors(input, signature, &inputs, num_input_examples));
+  return RunSessionOnInputs(run_options, inputs, output_tensor_names, session,
+                            outputs, thread_pool_options, runtime_latency);
+}
+
 Status PerformOneShotTensorComputation(
     const RunOptions& run_options, const Input& input,
     const std::set<string>& input_tensor_names,
@@ -280,53 +506,10 @@ Status GetModelDiskSize(const string& path, FileProbingEnv* env,
   // Make sure that path exists.
   TF_RETURN_IF_ERROR(env->FileExists(path));
 
-  *total_file_size = 0;
-  std::deque<string> dir_q;  // Queue for the BFS
-
-  dir_q.push_back(path);
-  // Do a BFS on the directory to discover all immediate children.
-  while (!dir_q.empty()) {
-    const string dir = dir_q.front();
-    dir_q.pop_front();
-    std::vector<string> children;
-    // GetChildren might fail if we don't have appropriate permissions.
-    TF_RETURN_IF_ERROR(env->GetChildren(dir, &children));
-    // Multi-threaded writes are safe for int but not bool, so we use int below.
-    std::vector<int> child_is_dir(children.size());
-    std::vector<StatusOr<uint64_t>> children_sizes(children.size());
-
-    {
-      // Filesystem operations may block for a long time so this process is
-      // vastly accelerated by parallelizing the iteration over children.
-      ThreadPoolExecutor executor(Env::Default(), "ModelDiskSizePool", 256);
-      for (int i = 0; i < children.size(); i++) {
-        const string child_path = io::JoinPath(dir, children[i]);
-        children[i] = child_path;
-        executor.Schedule(
-            [i, child_path, env, &child_is_dir, &children_sizes]() {
-              if (env->IsDirectory(child_path).ok()) {
-                // If the child is a directory add it to the queue.
-                child_is_dir[i] = 1;
-              } else {
-                // Otherwise, add its file size to total_file_size.
-                uint64_t file_size;
-                Status status = env->GetFileSize(child_path, &file_size);
-                children_sizes[i] =
-                    status.ok() ? absl::StatusOr<uint64_t>(file_size) : status;
-              }
-            });
-      }
-    }
-    for (int i = 0; i < children.size(); i++) {
-      if (child_is_dir[i] == 1) {
-        dir_q.push_back(children[i]);
-      } else {
-        TF_RETURN_IF_ERROR(children_sizes[i].status());
-        *total_file_size += *children_sizes[i];
-      }
-    }
-  }
-  return OkStatus();
+  // Filesystem operations may block for a long time so this process is
+  // vastly accelerated by parallelizing the walk over the tree.
+  ModelDiskSizeWalker walker(env);
+  return walker.Walk(path, total_file_size);
 }
 
 Status EstimateResourceFromPathUsingDiskState(const string& path,
@@ -356,6 +539,38 @@ void RecordRuntimeLatency(const string& model_name, const string& api,
 void RecordRequestLatency(const string& model_name, const string& api,
                           const string& entrypoint, int64_t latency_usec) {
   request_latency->GetCell(model_name, api, entrypoint)->Add(latency_usec);
+  SaturationMonitor::Global()->RecordLatency(model_name, latency_usec);
+}
+
+void RecordRequestStageLatency(const string& model_name, const string& api,
+                               const string& stage, int64_t latency_usec) {
+  request_stage_latency->GetCell(model_name, api, stage)->Add(latency_usec);
+}
+
+void RequestStageTimer::StartStage(const absl::string_view stage) {
+  EndStage();
+  stage_ = string(stage);
+  stage_start_micros_ = EnvTime::NowMicros();
+}
+
+void RequestStageTimer::EndStage() {
+  if (stage_.empty()) {
+    return;
+  }
+  const int64_t latency_usec = EnvTime::NowMicros() - stage_start_micros_;
+  RecordRequestStageLatency(model_name_, api_, stage_, latency_usec);
+  stage_latencies_.emplace_back(std::move(stage_), latency_usec);
+  stage_.clear();
+}
+
+string RequestStageTimer::ServerTiming() const {
+  std::vector<string> stages;
+  stages.reserve(stage_latencies_.size());
+  for (const auto& stage_latency : stage_latencies_) {
+    stages.push_back(absl::StrFormat("%s;dur=%.3f", stage_latency.first,
+                                     stage_latency.second / 1000.0));
+  }
+  return absl::StrJoin(stages, ", ");
 }
 
 std::set<string> SetDifference(std::set<string> set_a, std::set<string> set_b) {
@@ -16,17 +16,25 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_UTIL_H_
 #define TENSORFLOW_SERVING_SERVABLES_TENSORFLOW_UTIL_H_
 
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/threadpool_options.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow_serving/apis/input.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
 #include "tensorflow_serving/resources/resources.pb.h"
 #include "tensorflow_serving/util/file_probing_env.h"
+#include "tensorflow_serving/util/sharded_metrics.h"
 
 namespace tensorflow {
 namespace serving {
@@ -34,9 +42,9 @@ namespace serving {
 // Implementation details mainly used for testing; please don't depend on it.
 namespace internal {
 
-monitoring::Sampler<1>* GetExampleCounts();
+ShardedSampler<1>* GetExampleCounts();
 
-monitoring::Counter<1>* GetExampleCountTotal();
+ShardedCounter<1>* GetExampleCountTotal();
 
 }  // namespace internal
 
@@ -73,6 +81,21 @@ void RecordRequestExampleCount(const string& model_name, size_t count);
 // empty it will return a Tensor of shape {0}).
 Status InputToSerializedExampleTensor(const Input& input, Tensor* examples);
 
+// The key of an optional second input of Classify and Regress signatures,
+// which takes the context of an Input::example_list_with_context as a scalar
+// string holding the serialized Example (empty for other kinds of Input).
+// Signatures with it get the examples without the context merged into each,
+// so that the graph can parse the context once and broadcast it instead of
+// parsing a copy of it with every example.
+constexpr char kExampleContextInputs[] = "context";
+
+// As InputToSerializedExampleTensor(), but sets 'context' to the serialized
+// context of the input as described for kExampleContextInputs, rather than
+// merging it into the examples.
+Status InputToSerializedExampleAndContextTensors(const Input& input,
+                                                 Tensor* examples,
+                                                 Tensor* context);
+
 // Issues a single Session::Run() call with 'input' to produce 'outputs'.
 // Equivalent to InputToSerializedExampleTensor() followed by Session::Run().
 Status PerformOneShotTensorComputation(
@@ -84,6 +107,29 @@ Status PerformOneShotTensorComputation(
         thread::ThreadPoolOptions(),
     int64_t* runtime_latency = nullptr);
 
+// Same as PerformOneShotTensorComputation() above, except that the context of
+// 'input' is fed to 'context_tensor_name' separately, if not empty, as
+// described for kExampleContextInputs.
+Status PerformOneShotTensorComputationWithContext(
+    const RunOptions& run_options, const Input& input,
+    const string& input_tensor_name, const string& context_tensor_name,
+    const std::vector<string>& output_tensor_names, Session* session,
+    std::vector<Tensor>* outputs, int* num_input_examples,
+    const thread::ThreadPoolOptions& thread_pool_options =
+        thread::ThreadPoolOptions(),
+    int64_t* runtime_latency = nullptr);
+
+// Same as PerformOneShotTensorComputation() above, for a 'signature' whose
+// inputs are Example features, see kExampleFeatureInputsPrefix.
+Status PerformOneShotFeatureComputation(
+    const RunOptions& run_options, const Input& input,
+    const SignatureDef& signature,
+    const std::vector<string>& output_tensor_names, Session* session,
+    std::vector<Tensor>* outputs, int* num_input_examples,
+    const thread::ThreadPoolOptions& thread_pool_options =
+        thread::ThreadPoolOptions(),
+    int64_t* runtime_latency = nullptr);
+
 // Same as PerformOneShotTensorComputation() above, except allows for multiple
 // input tensor names (each tensor is fed the *same* `input`).
 Status PerformOneShotTensorComputation(
@@ -122,6 +168,45 @@ void RecordRuntimeLatency(const string& model_name, const string& api,
 void RecordRequestLatency(const string& model_name, const string& api,
                           const string& entrypoint, int64_t latency_usec);
 
+// Update metrics for the latency of a stage of a request, e.g. "parse".
+void RecordRequestStageLatency(const string& model_name, const string& api,
+                               const string& stage, int64_t latency_usec);
+
+// Times the consecutive stages of a request, e.g. parsing it, running it and
+// serializing its response, and records them with
+// RecordRequestStageLatency(). Each stage ends where the next one starts, or
+// at EndStage().
+//
+// This class is not thread-safe.
+class RequestStageTimer {
+ public:
+  RequestStageTimer(const string& model_name, const string& api)
+      : model_name_(model_name), api_(api) {}
+
+  // Ends the current stage, if any, and starts 'stage'.
+  void StartStage(absl::string_view stage);
+
+  // Ends the current stage, if any.
+  void EndStage();
+
+  // Returns the stages that ended, as the value of a Server-Timing HTTP
+  // header, e.g. "parse;dur=0.412, run;dur=3.071", in milliseconds.
+  string ServerTiming() const;
+
+  // Returns the stages that ended, and their latencies in microseconds.
+  const std::vector<std::pair<string, int64_t>>& stage_latencies() const {
+    return stage_latencies_;
+  }
+
+ private:
+  const string model_name_;
+  const string api_;
+  string stage_;
+  uint64_t stage_start_micros_ = 0;
+  // The stages that ended, and their latency.
+  std::vector<std::pair<string, int64_t>> stage_latencies_;
+};
+
 // Get string keys of a map.
 template <typename T>
 std::set<string> GetMapKeys(const T& map) {
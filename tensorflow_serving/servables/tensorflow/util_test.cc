@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
 #include "tensorflow_serving/servables/tensorflow/bundle_factory_test_util.h"
 #include "tensorflow_serving/test_util/test_util.h"
 #include "tensorflow_serving/util/test_util/mock_file_probing_env.h"
@@ -203,6 +204,36 @@ TEST_F(InputUtilTest, ExampleListWithContext_OnlyContext) {
   EXPECT_THAT(status.message(), HasSubstr("Input is empty"));
 }
 
+TEST_F(InputUtilTest, ExampleListWithSeparateContext) {
+  auto* examples =
+      input_.mutable_example_list_with_context()->mutable_examples();
+  *examples->Add() = example_A();
+  *examples->Add() = example_B();
+  *input_.mutable_example_list_with_context()->mutable_context() = example_C();
+
+  Tensor context;
+  TF_ASSERT_OK(
+      InputToSerializedExampleAndContextTensors(input_, &tensor_, &context));
+  const auto vec = tensor_.flat<tstring>();
+  ASSERT_EQ(vec.size(), 2);
+  Example serialized_example;
+  ASSERT_TRUE(serialized_example.ParseFromString(vec(0)));
+  EXPECT_THAT(serialized_example, EqualsProto(example_A()));
+  ASSERT_TRUE(serialized_example.ParseFromString(vec(1)));
+  EXPECT_THAT(serialized_example, EqualsProto(example_B()));
+  EXPECT_EQ(0, context.dims());
+  ASSERT_TRUE(serialized_example.ParseFromString(context.scalar<tstring>()()));
+  EXPECT_THAT(serialized_example, EqualsProto(example_C()));
+
+  // Other inputs have an empty context.
+  input_.Clear();
+  *input_.mutable_example_list()->mutable_examples()->Add() = example_A();
+  TF_ASSERT_OK(
+      InputToSerializedExampleAndContextTensors(input_, &tensor_, &context));
+  EXPECT_EQ(1, tensor_.NumElements());
+  EXPECT_EQ("", context.scalar<tstring>()());
+}
+
 TEST_F(InputUtilTest, RequestNumExamplesStreamz) {
   Input input_1;
   *input_1.mutable_example_list()->mutable_examples()->Add() = example_A();
@@ -314,6 +345,48 @@ TEST(ResourceEstimatorTest, EstimateResourceFromPathUsingDiskState) {
   EXPECT_THAT(actual, EqualsProto(expected));
 }
 
+TEST(ResourceEstimatorTest, GetModelDiskSizeWalksSubdirectories) {
+  // /foo: a (10 bytes), b/, c/
+  // /foo/b: d (20 bytes), e/
+  // /foo/b/e: f (30 bytes)
+  // /foo/c: empty
+  test_util::MockFileProbingEnv env;
+  EXPECT_CALL(env, FileExists("/foo")).WillRepeatedly(Return(OkStatus()));
+  const std::map<string, std::vector<string>> children = {
+      {"/foo", {"a", "b", "c"}},
+      {"/foo/b", {"d", "e"}},
+      {"/foo/b/e", {"f"}},
+      {"/foo/c", {}}};
+  for (const auto& dir : children) {
+    EXPECT_CALL(env, GetChildren(dir.first, _))
+        .WillRepeatedly(
+            DoAll(SetArgPointee<1>(dir.second), Return(OkStatus())));
+    if (dir.first != "/foo") {
+      EXPECT_CALL(env, IsDirectory(dir.first))
+          .WillRepeatedly(Return(OkStatus()));
+    }
+  }
+  const std::map<string, uint64_t> file_sizes = {
+      {"/foo/a", 10}, {"/foo/b/d", 20}, {"/foo/b/e/f", 30}};
+  for (const auto& file : file_sizes) {
+    EXPECT_CALL(env, IsDirectory(file.first))
+        .WillRepeatedly(Return(errors::FailedPrecondition("")));
+    EXPECT_CALL(env, GetFileSize(file.first, _))
+        .WillRepeatedly(
+            DoAll(SetArgPointee<1>(file.second), Return(OkStatus())));
+  }
+
+  uint64_t total_file_size = 0;
+  TF_ASSERT_OK(GetModelDiskSize("/foo", &env, &total_file_size));
+  EXPECT_EQ(60, total_file_size);
+
+  // An error anywhere in the tree fails the walk.
+  EXPECT_CALL(env, GetChildren("/foo/b/e", _))
+      .WillRepeatedly(Return(errors::PermissionDenied("")));
+  EXPECT_EQ(error::PERMISSION_DENIED,
+            GetModelDiskSize("/foo", &env, &total_file_size).code());
+}
+
 TEST(GetMapKeysTest, GetKeys) {
   std::map<string, string> map = {std::pair<string, string>("key1", "value1"),
                                   std::pair<string, string>("key2", "value2")};
@@ -329,6 +402,21 @@ TEST(SetDifferenceTEST, GetDiff) {
               ::testing::UnorderedElementsAre("c"));
 }
 
+TEST(RequestStageTimerTest, ServerTiming) {
+  RequestStageTimer timer("model", "predict");
+  EXPECT_EQ("", timer.ServerTiming());
+  timer.StartStage("parse");
+  timer.StartStage("run");
+  // Not ended yet.
+  EXPECT_THAT(timer.ServerTiming(),
+              ::testing::MatchesRegex("parse;dur=[0-9]+\\.[0-9]{3}"));
+  timer.EndStage();
+  timer.EndStage();
+  EXPECT_THAT(timer.ServerTiming(),
+              ::testing::MatchesRegex(
+                  "parse;dur=[0-9]+\\.[0-9]{3}, run;dur=[0-9]+\\.[0-9]{3}"));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -0,0 +1,68 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/sources/storage_path/file_system_change_notifier.h"
+
+#include <map>
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+struct FactoryRegistry {
+  mutex mu;
+  std::map<string, FileSystemChangeNotifierFactory> factories_by_scheme
+      TF_GUARDED_BY(mu);
+};
+
+FactoryRegistry* GetFactoryRegistry() {
+  static FactoryRegistry* registry = new FactoryRegistry;
+  return registry;
+}
+
+}  // namespace
+
+void RegisterFileSystemChangeNotifierFactory(
+    const string& scheme, FileSystemChangeNotifierFactory factory) {
+  FactoryRegistry* registry = GetFactoryRegistry();
+  mutex_lock l(registry->mu);
+  registry->factories_by_scheme[scheme] = std::move(factory);
+}
+
+Status CreateFileSystemChangeNotifier(
+    const string& scheme, FileSystemChangeNotifier::ChangeCallback callback,
+    std::unique_ptr<FileSystemChangeNotifier>* notifier) {
+  FileSystemChangeNotifierFactory factory;
+  {
+    FactoryRegistry* registry = GetFactoryRegistry();
+    mutex_lock l(registry->mu);
+    auto it = registry->factories_by_scheme.find(scheme);
+    if (it == registry->factories_by_scheme.end()) {
+      return errors::NotFound(
+          "No file-system change notifier is registered for scheme '", scheme,
+          "'");
+    }
+    factory = it->second;
+  }
+  return factory(std::move(callback), notifier);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
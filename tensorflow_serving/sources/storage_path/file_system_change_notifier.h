@@ -0,0 +1,78 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SOURCES_STORAGE_PATH_FILE_SYSTEM_CHANGE_NOTIFIER_H_
+#define TENSORFLOW_SERVING_SOURCES_STORAGE_PATH_FILE_SYSTEM_CHANGE_NOTIFIER_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+/// Notifies of changes to the children of watched directories, e.g. version
+/// directories being added to or removed from the base path of a servable, so
+/// that FileSystemStoragePathSource need not poll the file system for them.
+///
+/// Each implementation serves the paths of one file-system scheme (e.g. inotify
+/// for local paths, or the object notifications of a cloud storage system), and
+/// is registered for it with RegisterFileSystemChangeNotifierFactory().
+///
+/// Notifications are a hint: a notifier may send spurious ones, and may miss
+/// changes (e.g. if it drops events under load), so users should keep polling,
+/// if more slowly, for consistency.
+///
+/// Implementations must be thread-safe.
+class FileSystemChangeNotifier {
+ public:
+  /// Called with a watched path, on an arbitrary thread, when its children may
+  /// have changed. Must not call back into the notifier.
+  using ChangeCallback = std::function<void(const string& path)>;
+
+  virtual ~FileSystemChangeNotifier() = default;
+
+  /// Starts watching the directory at 'path'. Returns an error if the path
+  /// cannot be watched, e.g. because it does not exist yet.
+  virtual Status Watch(const string& path) = 0;
+
+  /// Stops watching the directory at 'path', if it is watched.
+  virtual void Unwatch(const string& path) = 0;
+};
+
+/// Creates a notifier that calls 'callback' with the paths that change.
+using FileSystemChangeNotifierFactory = std::function<Status(
+    FileSystemChangeNotifier::ChangeCallback callback,
+    std::unique_ptr<FileSystemChangeNotifier>* notifier)>;
+
+/// Registers 'factory' for the paths of the file-system 'scheme' (e.g. "gs"),
+/// or of local paths if 'scheme' is empty. Replaces any factory registered for
+/// the scheme before.
+void RegisterFileSystemChangeNotifierFactory(
+    const string& scheme, FileSystemChangeNotifierFactory factory);
+
+/// Creates a notifier for the paths of 'scheme' using the registered factory.
+/// Returns a NotFound error if no factory is registered for the scheme.
+Status CreateFileSystemChangeNotifier(
+    const string& scheme, FileSystemChangeNotifier::ChangeCallback callback,
+    std::unique_ptr<FileSystemChangeNotifier>* notifier);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SOURCES_STORAGE_PATH_FILE_SYSTEM_CHANGE_NOTIFIER_H_
@@ -25,7 +25,9 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow_serving/core/servable_data.h"
@@ -39,6 +41,15 @@ FileSystemStoragePathSource::~FileSystemStoragePathSource() {
   // thread closure stops. Hence, destruction of this object will not proceed
   // until the thread has terminated.
   fs_polling_thread_.reset();
+  {
+    mutex_lock l(changes_mu_);
+    stop_change_polling_ = true;
+    changes_cv_.notify_all();
+  }
+  change_polling_thread_.reset();
+  // Blocks until the notifiers stop calling OnBasePathChanged().
+  mutex_lock l(mu_);
+  change_notifiers_.clear();
 }
 
 namespace {
@@ -65,6 +76,29 @@ std::set<string> GetDeletedServables(
   return deleted_servables;
 }
 
+// Returns 'new_config' with only the servables that are new in it, or
+// monitored differently from 'old_config'.
+FileSystemStoragePathSourceConfig GetNewOrChangedServables(
+    const FileSystemStoragePathSourceConfig& old_config,
+    const FileSystemStoragePathSourceConfig& new_config) {
+  std::map<string, string> old_servables;
+  for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
+       old_config.servables()) {
+    old_servables[servable.servable_name()] = servable.SerializeAsString();
+  }
+  FileSystemStoragePathSourceConfig changed_config = new_config;
+  changed_config.clear_servables();
+  for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
+       new_config.servables()) {
+    auto it = old_servables.find(servable.servable_name());
+    if (it == old_servables.end() ||
+        it->second != servable.SerializeAsString()) {
+      *changed_config.add_servables() = servable;
+    }
+  }
+  return changed_config;
+}
+
 // Adds a new ServableData for the servable version to the vector of versions to
 // aspire.
 void AspireVersion(
@@ -263,30 +297,82 @@ Status PollFileSystemForServable(
   return Status();
 }
 
+// Polls the file system for each servable in 'config', in parallel on
+// 'thread_pool' unless it is null. Sets 'statuses' and 'versions' to the
+// status and the found versions of each servable, in the order of
+// 'config.servables()'.
+void PollFileSystemForServables(
+    const FileSystemStoragePathSourceConfig& config,
+    thread::ThreadPool* thread_pool, std::vector<Status>* statuses,
+    std::vector<std::vector<ServableData<StoragePath>>>* versions) {
+  const int num_servables = config.servables_size();
+  statuses->assign(num_servables, Status());
+  versions->assign(num_servables, {});
+  if (thread_pool == nullptr || num_servables <= 1) {
+    for (int i = 0; i < num_servables; ++i) {
+      (*statuses)[i] =
+          PollFileSystemForServable(config.servables(i), &(*versions)[i]);
+    }
+    return;
+  }
+  BlockingCounter done(num_servables);
+  for (int i = 0; i < num_servables; ++i) {
+    thread_pool->Schedule([&config, statuses, versions, &done, i]() {
+      (*statuses)[i] =
+          PollFileSystemForServable(config.servables(i), &(*versions)[i]);
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+}
+
 // Polls the file system, and populates 'versions_by_servable_name' with the
 // aspired-versions data FileSystemStoragePathSource should emit based on what
-// was found, indexed by servable name.
+// was found, indexed by servable name. Polls the servables in parallel on
+// 'thread_pool', unless it is null.
 Status PollFileSystemForConfig(
     const FileSystemStoragePathSourceConfig& config,
+    thread::ThreadPool* thread_pool,
     std::map<string, std::vector<ServableData<StoragePath>>>*
         versions_by_servable_name) {
-  for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
-       config.servables()) {
-    std::vector<ServableData<StoragePath>> versions;
-    TF_RETURN_IF_ERROR(PollFileSystemForServable(servable, &versions));
+  std::vector<Status> statuses;
+  std::vector<std::vector<ServableData<StoragePath>>> versions;
+  PollFileSystemForServables(config, thread_pool, &statuses, &versions);
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  for (int i = 0; i < config.servables_size(); ++i) {
     versions_by_servable_name->insert(
-        {servable.servable_name(), std::move(versions)});
+        {config.servables(i).servable_name(), std::move(versions[i])});
   }
   return Status();
 }
 
+// Returns the base paths of the servables in 'config'.
+std::set<string> GetBasePaths(const FileSystemStoragePathSourceConfig& config) {
+  std::set<string> base_paths;
+  for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
+       config.servables()) {
+    base_paths.insert(servable.base_path());
+  }
+  return base_paths;
+}
+
+// Returns the file-system scheme of 'path', empty for local paths.
+string GetScheme(const string& path) {
+  StringPiece scheme, host, unused_path;
+  io::ParseURI(path, &scheme, &host, &unused_path);
+  return string(scheme);
+}
+
 // Determines if, for any servables in 'config', the file system doesn't
 // currently contain at least one version under its base path.
-Status FailIfZeroVersions(const FileSystemStoragePathSourceConfig& config) {
+Status FailIfZeroVersions(const FileSystemStoragePathSourceConfig& config,
+                          thread::ThreadPool* thread_pool) {
   std::map<string, std::vector<ServableData<StoragePath>>>
       versions_by_servable_name;
   TF_RETURN_IF_ERROR(
-      PollFileSystemForConfig(config, &versions_by_servable_name));
+      PollFileSystemForConfig(config, thread_pool, &versions_by_servable_name));
 
   std::map<string, string> servable_name_to_base_path_map;
   for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
@@ -326,20 +412,111 @@ Status FileSystemStoragePathSource::UpdateConfig(
     return errors::InvalidArgument(
         "Changing file_system_poll_wait_seconds is not supported");
   }
+  if (aspired_versions_callback_ &&
+      config.watch_for_changes() != config_.watch_for_changes()) {
+    return errors::InvalidArgument(
+        "Changing watch_for_changes is not supported");
+  }
+
+  const int num_poll_threads = config.num_file_system_poll_threads();
+  if (num_poll_threads != config_.num_file_system_poll_threads()) {
+    poll_thread_pool_.reset(
+        num_poll_threads > 1
+            ? new thread::ThreadPool(Env::Default(),
+                                     "FileSystemStoragePathSource_poll",
+                                     num_poll_threads)
+            : nullptr);
+  }
 
   if (config.fail_if_zero_versions_at_startup() ||  // NOLINT
       config.servable_versions_always_present()) {
-    TF_RETURN_IF_ERROR(FailIfZeroVersions(config));
+    // The servables that are monitored as before were checked when they were
+    // added, so only the others are polled here.
+    TF_RETURN_IF_ERROR(FailIfZeroVersions(
+        GetNewOrChangedServables(config_, config), poll_thread_pool_.get()));
   }
 
+  const std::set<string> deleted_servables =
+      GetDeletedServables(config_, config);
   if (aspired_versions_callback_) {
-    TF_RETURN_IF_ERROR(UnaspireServables(GetDeletedServables(config_, config)));
+    TF_RETURN_IF_ERROR(UnaspireServables(deleted_servables));
+  }
+  for (const string& servable_name : deleted_servables) {
+    poll_backoffs_.erase(servable_name);
   }
+  const FileSystemStoragePathSourceConfig old_config = config_;
   config_ = config;
+  if (aspired_versions_callback_) {
+    UpdateWatchedBasePaths(old_config);
+  }
 
   return Status();
 }
 
+void FileSystemStoragePathSource::SetInitialAspiredVersions(
+    std::map<string, std::vector<ServableData<StoragePath>>>
+        versions_by_servable_name) {
+  mutex_lock l(mu_);
+  DCHECK(!aspired_versions_callback_);
+  initial_versions_ = std::move(versions_by_servable_name);
+}
+
+string FileSystemStoragePathSource::GetAspiredVersionPath(
+    const ServableId& id) const {
+  mutex_lock l(aspired_paths_mu_);
+  auto servable_it = aspired_paths_.find(id.name);
+  if (servable_it == aspired_paths_.end()) {
+    return "";
+  }
+  auto version_it = servable_it->second.find(id.version);
+  return version_it == servable_it->second.end() ? "" : version_it->second;
+}
+
+void FileSystemStoragePathSource::RecordAspiredVersions(
+    const string& servable_name,
+    const std::vector<ServableData<StoragePath>>& versions) {
+  std::map<int64_t, string> paths;
+  for (const ServableData<StoragePath>& version : versions) {
+    if (version.status().ok()) {
+      paths[version.id().version] = version.DataOrDie();
+    }
+  }
+  mutex_lock l(aspired_paths_mu_);
+  if (paths.empty()) {
+    aspired_paths_.erase(servable_name);
+  } else {
+    aspired_paths_[servable_name] = std::move(paths);
+  }
+}
+
+void FileSystemStoragePathSource::AspireInitialVersions() {
+  std::map<string, std::vector<ServableData<StoragePath>>>
+      versions_by_servable_name;
+  for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
+       config_.servables()) {
+    auto it = initial_versions_.find(servable.servable_name());
+    if (it == initial_versions_.end()) {
+      continue;
+    }
+    // Checking the version paths is cheaper than listing the base path, and
+    // keeps versions deleted since from failing to load.
+    bool all_versions_exist = !it->second.empty();
+    for (const ServableData<StoragePath>& version : it->second) {
+      if (!version.status().ok() ||
+          !Env::Default()->FileExists(version.DataOrDie()).ok()) {
+        all_versions_exist = false;
+        break;
+      }
+    }
+    if (all_versions_exist) {
+      versions_by_servable_name[servable.servable_name()] =
+          std::move(it->second);
+    }
+  }
+  initial_versions_.clear();
+  InvokeCallbackForVersions(versions_by_servable_name);
+}
+
 void FileSystemStoragePathSource::SetAspiredVersionsCallback(
     AspiredVersionsCallback callback) {
   mutex_lock l(mu_);
@@ -351,6 +528,9 @@ void FileSystemStoragePathSource::SetAspiredVersionsCallback(
     return;
   }
   aspired_versions_callback_ = callback;
+  if (!initial_versions_.empty()) {
+    AspireInitialVersions();
+  }
 
   const auto thread_fn = [this](void) {
     Status status = this->PollFileSystemAndInvokeCallback();
@@ -361,6 +541,13 @@ void FileSystemStoragePathSource::SetAspiredVersionsCallback(
     }
   };
 
+  if (config_.watch_for_changes()) {
+    change_polling_thread_.reset(Env::Default()->StartThread(
+        ThreadOptions(), "FileSystemStoragePathSource_change_polling_thread",
+        [this]() { PollChangedBasePaths(); }));
+    UpdateWatchedBasePaths(FileSystemStoragePathSourceConfig());
+  }
+
   if (config_.file_system_poll_wait_seconds() == 0) {
     // Start a thread to poll filesystem once and call the callback.
     fs_polling_thread_.reset(new FileSystemStoragePathSource::ThreadType(
@@ -382,10 +569,101 @@ void FileSystemStoragePathSource::SetAspiredVersionsCallback(
 
 Status FileSystemStoragePathSource::PollFileSystemAndInvokeCallback() {
   mutex_lock l(mu_);
+  // Retries watching the base paths that could not be watched before, e.g.
+  // because they did not exist yet.
+  UpdateWatchedBasePaths(config_);
+  if (config_.max_file_system_poll_backoff_seconds() > 0) {
+    return PollDueServablesAndInvokeCallback();
+  }
   std::map<string, std::vector<ServableData<StoragePath>>>
       versions_by_servable_name;
-  TF_RETURN_IF_ERROR(
-      PollFileSystemForConfig(config_, &versions_by_servable_name));
+  TF_RETURN_IF_ERROR(PollFileSystemForConfig(
+      config_, poll_thread_pool_.get(), &versions_by_servable_name));
+  InvokeCallbackForVersions(versions_by_servable_name);
+  return Status();
+}
+
+Status FileSystemStoragePathSource::PollDueServablesAndInvokeCallback() {
+  const uint64_t now_micros = Env::Default()->NowMicros();
+  FileSystemStoragePathSourceConfig due_config;
+  for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
+       config_.servables()) {
+    if (poll_backoffs_[servable.servable_name()].next_poll_micros <=
+        now_micros) {
+      *due_config.add_servables() = servable;
+    }
+  }
+  std::vector<Status> statuses;
+  std::vector<std::vector<ServableData<StoragePath>>> versions;
+  PollFileSystemForServables(due_config, poll_thread_pool_.get(), &statuses,
+                             &versions);
+
+  const int64_t poll_period_micros =
+      std::max<int64_t>(config_.file_system_poll_wait_seconds(), 1) * 1000000;
+  const int64_t max_backoff_micros =
+      config_.max_file_system_poll_backoff_seconds() * 1000000;
+  Status first_error;
+  std::map<string, std::vector<ServableData<StoragePath>>>
+      versions_by_servable_name;
+  for (int i = 0; i < due_config.servables_size(); ++i) {
+    const string& servable_name = due_config.servables(i).servable_name();
+    PollBackoff& backoff = poll_backoffs_[servable_name];
+    bool changed = false;
+    if (!statuses[i].ok()) {
+      LOG(ERROR) << "Failed to poll the file system for servable "
+                 << servable_name << ": " << statuses[i];
+      first_error.Update(statuses[i]);
+    } else {
+      changed = backoff.versions != versions[i];
+      backoff.versions = versions[i];
+      versions_by_servable_name[servable_name] = std::move(versions[i]);
+    }
+    if (changed) {
+      backoff.num_quiet_polls = 0;
+      backoff.next_poll_micros = 0;
+      continue;
+    }
+    // Waits 2^n periods after the n-th quiet poll, so the next poll is due a
+    // bit less than that from now.
+    backoff.num_quiet_polls = std::min(backoff.num_quiet_polls + 1, 30);
+    const int64_t backoff_micros =
+        std::min(poll_period_micros << backoff.num_quiet_polls,
+                 std::max(max_backoff_micros, poll_period_micros));
+    backoff.next_poll_micros =
+        now_micros + backoff_micros - poll_period_micros / 2;
+  }
+  InvokeCallbackForVersions(versions_by_servable_name);
+  return first_error;
+}
+
+Status FileSystemStoragePathSource::PollBasePathsAndInvokeCallback(
+    const std::set<string>& base_paths) {
+  mutex_lock l(mu_);
+  FileSystemStoragePathSourceConfig changed_config;
+  for (const FileSystemStoragePathSourceConfig::ServableToMonitor& servable :
+       config_.servables()) {
+    if (base_paths.count(servable.base_path()) > 0) {
+      *changed_config.add_servables() = servable;
+    }
+  }
+  std::map<string, std::vector<ServableData<StoragePath>>>
+      versions_by_servable_name;
+  TF_RETURN_IF_ERROR(PollFileSystemForConfig(
+      changed_config, poll_thread_pool_.get(), &versions_by_servable_name));
+  for (const auto& entry : versions_by_servable_name) {
+    // Resumes the polls of servables that were backed off.
+    PollBackoff& backoff = poll_backoffs_[entry.first];
+    backoff.versions = entry.second;
+    backoff.num_quiet_polls = 0;
+    backoff.next_poll_micros = 0;
+  }
+  InvokeCallbackForVersions(versions_by_servable_name);
+  return Status();
+}
+
+void FileSystemStoragePathSource::InvokeCallbackForVersions(
+    const std::map<string, std::vector<ServableData<StoragePath>>>&
+        versions_by_servable_name) {
   for (const auto& entry : versions_by_servable_name) {
     const string& servable = entry.first;
     const std::vector<ServableData<StoragePath>>& versions = entry.second;
@@ -402,14 +680,84 @@ Status FileSystemStoragePathSource::PollFileSystemAndInvokeCallback() {
                 << config_.file_system_poll_wait_seconds();
       }
     }
+    RecordAspiredVersions(servable, versions);
     CallAspiredVersionsCallback(servable, versions);
   }
-  return Status();
+}
+
+void FileSystemStoragePathSource::UpdateWatchedBasePaths(
+    const FileSystemStoragePathSourceConfig& old_config) {
+  if (!config_.watch_for_changes()) {
+    return;
+  }
+  const std::set<string> base_paths = GetBasePaths(config_);
+  for (const string& base_path : GetBasePaths(old_config)) {
+    if (base_paths.count(base_path) > 0) {
+      continue;
+    }
+    auto it = change_notifiers_.find(GetScheme(base_path));
+    if (it != change_notifiers_.end() && it->second != nullptr) {
+      it->second->Unwatch(base_path);
+    }
+  }
+  for (const string& base_path : base_paths) {
+    const string scheme = GetScheme(base_path);
+    auto it = change_notifiers_.find(scheme);
+    if (it == change_notifiers_.end()) {
+      std::unique_ptr<FileSystemChangeNotifier> notifier;
+      const Status status = CreateFileSystemChangeNotifier(
+          scheme,
+          [this](const string& path) { this->OnBasePathChanged(path); },
+          &notifier);
+      if (!status.ok()) {
+        LOG(WARNING) << "Not watching base paths of scheme '" << scheme
+                     << "' for changes, only polling them: " << status;
+      }
+      it = change_notifiers_.emplace(scheme, std::move(notifier)).first;
+    }
+    if (it->second == nullptr) {
+      continue;
+    }
+    const Status status = it->second->Watch(base_path);
+    if (!status.ok()) {
+      VLOG(1) << "Polling " << base_path << " until it can be watched: "
+              << status;
+    }
+  }
+}
+
+void FileSystemStoragePathSource::OnBasePathChanged(const string& base_path) {
+  mutex_lock l(changes_mu_);
+  changed_base_paths_.insert(base_path);
+  changes_cv_.notify_all();
+}
+
+void FileSystemStoragePathSource::PollChangedBasePaths() {
+  while (true) {
+    std::set<string> base_paths;
+    {
+      mutex_lock l(changes_mu_);
+      while (changed_base_paths_.empty() && !stop_change_polling_) {
+        changes_cv_.wait(l);
+      }
+      if (stop_change_polling_) {
+        return;
+      }
+      base_paths.swap(changed_base_paths_);
+    }
+    const Status status = PollBasePathsAndInvokeCallback(base_paths);
+    if (!status.ok()) {
+      LOG(ERROR) << "FileSystemStoragePathSource encountered a "
+                    "filesystem access error: "
+                 << status.message();
+    }
+  }
 }
 
 Status FileSystemStoragePathSource::UnaspireServables(
     const std::set<string>& servable_names) {
   for (const string& servable_name : servable_names) {
+    RecordAspiredVersions(servable_name, {});
     CallAspiredVersionsCallback(servable_name,
                                 std::vector<ServableData<StoragePath>>{});
   }
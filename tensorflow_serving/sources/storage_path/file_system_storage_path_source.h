@@ -17,18 +17,24 @@ limitations under the License.
 #define TENSORFLOW_SERVING_SOURCES_STORAGE_PATH_FILE_SYSTEM_STORAGE_PATH_SOURCE_H_
 
 #include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/types/variant.h"
 #include "tensorflow/core/kernels/batching_util/periodic_function.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_serving/config/file_system_storage_path_source.pb.h"
 #include "tensorflow_serving/core/source.h"
 #include "tensorflow_serving/core/storage_path.h"
+#include "tensorflow_serving/sources/storage_path/file_system_change_notifier.h"
 
 namespace tensorflow {
 namespace serving {
@@ -59,6 +65,10 @@ namespace serving {
 /// not in the new one, the source will immediately aspire zero versions for
 /// that servable (causing it to be unloaded in the Manager that ultimately
 /// consumes the aspired-versions calls).
+///
+/// If 'watch_for_changes' is set in the config, the source also watches the
+/// base paths with FileSystemChangeNotifiers, and polls a servable as soon as
+/// its base path changes, in addition to the periodic polls.
 class FileSystemStoragePathSource : public Source<StoragePath> {
  public:
   static Status Create(const FileSystemStoragePathSourceConfig& config,
@@ -67,10 +77,25 @@ class FileSystemStoragePathSource : public Source<StoragePath> {
 
   /// Supplies a new config to use. The set of servables to monitor can be
   /// changed at any time (see class comment for more information), but it is
-  /// illegal to change the file-system polling period once
-  /// SetAspiredVersionsCallback() has been called.
+  /// illegal to change the file-system polling period, or whether to watch for
+  /// changes, once SetAspiredVersionsCallback() has been called.
   Status UpdateConfig(const FileSystemStoragePathSourceConfig& config);
 
+  /// Supplies versions to aspire as soon as SetAspiredVersionsCallback() is
+  /// called, before the first file-system poll lists the base paths, e.g. the
+  /// versions served before a restart (see GetAspiredVersionPath()). Servables
+  /// that aren't in the config, or any of whose initial version paths doesn't
+  /// exist, are left to the poll. The polls that follow take over as usual.
+  /// Must be called before SetAspiredVersionsCallback().
+  void SetInitialAspiredVersions(
+      std::map<string, std::vector<ServableData<StoragePath>>>
+          versions_by_servable_name);
+
+  /// Returns the path of the version 'id' as last aspired, or an empty string
+  /// if it isn't aspired. Doesn't wait for polls in progress.
+  string GetAspiredVersionPath(const ServableId& id) const
+      TF_LOCKS_EXCLUDED(aspired_paths_mu_);
+
   void SetAspiredVersionsCallback(AspiredVersionsCallback callback) override;
 
   FileSystemStoragePathSourceConfig config() const {
@@ -90,10 +115,50 @@ class FileSystemStoragePathSource : public Source<StoragePath> {
   // such child.
   Status PollFileSystemAndInvokeCallback();
 
+  // Like PollFileSystemAndInvokeCallback(), for a
+  // 'max_file_system_poll_backoff_seconds' config: polls only the servables
+  // that are due, and backs off those that are unchanged or fail.
+  Status PollDueServablesAndInvokeCallback() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Like PollFileSystemAndInvokeCallback(), but only for the servables whose
+  // base path is in 'base_paths'.
+  Status PollBasePathsAndInvokeCallback(const std::set<string>& base_paths);
+
+  // Invokes 'aspired_versions_callback_' with 'initial_versions_' that exist.
+  void AspireInitialVersions() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Invokes 'aspired_versions_callback_' with the versions found by a poll.
+  void InvokeCallbackForVersions(
+      const std::map<string, std::vector<ServableData<StoragePath>>>&
+          versions_by_servable_name) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // If 'watch_for_changes' is set, makes sure the base paths of the servables
+  // in 'config_' are watched, creating notifiers as needed, and stops
+  // watching those in 'old_config' that are not.
+  void UpdateWatchedBasePaths(
+      const FileSystemStoragePathSourceConfig& old_config)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Called by the notifiers when the children of 'base_path' change. Queues
+  // the base path for PollChangedBasePaths().
+  void OnBasePathChanged(const string& base_path)
+      TF_LOCKS_EXCLUDED(changes_mu_);
+
+  // Run by 'change_polling_thread_': polls the servables of the base paths
+  // that changed, until the source is destroyed.
+  void PollChangedBasePaths() TF_LOCKS_EXCLUDED(mu_, changes_mu_);
+
   // Sends empty aspired-versions lists for each servable in 'servable_names'.
   Status UnaspireServables(const std::set<string>& servable_names)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // Records 'versions' as the aspired versions of 'servable_name', for
+  // GetAspiredVersionPath().
+  void RecordAspiredVersions(
+      const string& servable_name,
+      const std::vector<ServableData<StoragePath>>& versions)
+      TF_LOCKS_EXCLUDED(aspired_paths_mu_);
+
   template <typename... Args>
   void CallAspiredVersionsCallback(Args&&... args) {
     if (aspired_versions_callback_) {
@@ -118,11 +183,52 @@ class FileSystemStoragePathSource : public Source<StoragePath> {
 
   std::function<void()> aspired_versions_callback_notifier_ TF_GUARDED_BY(mu_);
 
+  // See SetInitialAspiredVersions(). Cleared once aspired.
+  std::map<string, std::vector<ServableData<StoragePath>>> initial_versions_
+      TF_GUARDED_BY(mu_);
+
+  // The path of each aspired version, by servable name and version. Guarded
+  // by a mutex of its own, since polls hold 'mu_' for their duration.
+  mutable mutex aspired_paths_mu_;
+  std::map<string, std::map<int64_t, string>> aspired_paths_
+      TF_GUARDED_BY(aspired_paths_mu_);
+
   // A thread that calls PollFileSystemAndInvokeCallback() once or periodically.
   using ThreadType =
       absl::variant<absl::monostate, PeriodicFunction, std::unique_ptr<Thread>>;
   std::unique_ptr<ThreadType> fs_polling_thread_ TF_GUARDED_BY(mu_);
 
+  // The threads to poll the servables with, if 'num_file_system_poll_threads'
+  // is more than 1.
+  std::unique_ptr<thread::ThreadPool> poll_thread_pool_ TF_GUARDED_BY(mu_);
+
+  // The backoff of the polls of a servable, for
+  // 'max_file_system_poll_backoff_seconds'.
+  struct PollBackoff {
+    // The versions found by the last successful poll.
+    std::vector<ServableData<StoragePath>> versions;
+    // The number of consecutive polls that found no change or failed.
+    int num_quiet_polls = 0;
+    // When the servable is next due to be polled.
+    uint64_t next_poll_micros = 0;
+  };
+  std::map<string /* servable name */, PollBackoff> poll_backoffs_
+      TF_GUARDED_BY(mu_);
+
+  // The change notifiers, by file-system scheme. Null for schemes without a
+  // registered notifier.
+  std::map<string, std::unique_ptr<FileSystemChangeNotifier>> change_notifiers_
+      TF_GUARDED_BY(mu_);
+
+  mutex changes_mu_;
+  condition_variable changes_cv_;
+  // The base paths that changed since the last PollChangedBasePaths() poll.
+  std::set<string> changed_base_paths_ TF_GUARDED_BY(changes_mu_);
+  bool stop_change_polling_ TF_GUARDED_BY(changes_mu_) = false;
+
+  // A thread that runs PollChangedBasePaths(), if 'watch_for_changes' is set.
+  std::unique_ptr<Thread> change_polling_thread_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(FileSystemStoragePathSource);
 };
 
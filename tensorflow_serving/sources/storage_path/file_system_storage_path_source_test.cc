@@ -185,6 +185,52 @@ TEST(FileSystemStoragePathSourceTest, MultipleVersions) {
                    .PollFileSystemAndInvokeCallback());
 }
 
+TEST(FileSystemStoragePathSourceTest, InitialAspiredVersions) {
+  const string base_path =
+      io::JoinPath(testing::TmpDir(), "InitialAspiredVersions");
+  TF_ASSERT_OK(Env::Default()->CreateDir(base_path));
+  TF_ASSERT_OK(Env::Default()->CreateDir(io::JoinPath(base_path, "0017")));
+  TF_ASSERT_OK(Env::Default()->CreateDir(io::JoinPath(base_path, "42")));
+
+  auto config = test_util::CreateProto<FileSystemStoragePathSourceConfig>(
+      strings::Printf("servables: {"
+                      "  servable_name: 'test_servable_name' "
+                      "  base_path: '%s' "
+                      "} "
+                      "servables: {"
+                      "  servable_name: 'test_deleted_servable_name' "
+                      "  base_path: '%s' "
+                      "} "
+                      // Disable the polling thread.
+                      "file_system_poll_wait_seconds: -1 ",
+                      base_path.c_str(), base_path.c_str()));
+  std::unique_ptr<FileSystemStoragePathSource> source;
+  TF_ASSERT_OK(FileSystemStoragePathSource::Create(config, &source));
+  // The initial version is aspired without a poll, even though a poll would
+  // find a later one. Servables with an initial version that is gone, and
+  // those not in the config, are left to the poll.
+  const ServableData<StoragePath> version_17(
+      {"test_servable_name", 17}, io::JoinPath(base_path, "0017"));
+  source->SetInitialAspiredVersions(
+      {{"test_servable_name", {version_17}},
+       {"test_deleted_servable_name",
+        {ServableData<StoragePath>({"test_deleted_servable_name", 17},
+                                   io::JoinPath(base_path, "0017")),
+         ServableData<StoragePath>({"test_deleted_servable_name", 99},
+                                   io::JoinPath(base_path, "99"))}},
+       {"test_unknown_servable_name",
+        {ServableData<StoragePath>({"test_unknown_servable_name", 17},
+                                   io::JoinPath(base_path, "0017"))}}});
+  std::unique_ptr<test_util::MockStoragePathTarget> target(
+      new StrictMock<test_util::MockStoragePathTarget>);
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("test_servable_name"),
+                                          ElementsAre(version_17)));
+  ConnectSourceToTarget(source.get(), target.get());
+  EXPECT_EQ(io::JoinPath(base_path, "0017"),
+            source->GetAspiredVersionPath({"test_servable_name", 17}));
+  EXPECT_EQ("", source->GetAspiredVersionPath({"test_servable_name", 42}));
+}
+
 TEST(FileSystemStoragePathSourceTest, MultipleVersionsAtTheSameTime) {
   const string base_path =
       io::JoinPath(testing::TmpDir(), "MultipleVersionsAtTheSameTime");
@@ -829,6 +875,105 @@ TEST(FileSystemStoragePathSourceTest, PollFilesystemOnlyOnce) {
   EXPECT_EQ(notify_count.load(), 1);
 }
 
+TEST(FileSystemStoragePathSourceTest, WatchForChanges) {
+  const string base_path = io::JoinPath(testing::TmpDir(), "WatchForChanges");
+  TF_ASSERT_OK(Env::Default()->CreateDir(base_path));
+  auto config = test_util::CreateProto<FileSystemStoragePathSourceConfig>(
+      strings::Printf("servables: {"
+                      "  servable_name: 'test_servable_name' "
+                      "  base_path: '%s' "
+                      "} "
+                      "watch_for_changes: true "
+                      // Disable the polling thread, so only the notifications
+                      // of changes cause polls.
+                      "file_system_poll_wait_seconds: -1 ",
+                      base_path.c_str()));
+  std::unique_ptr<FileSystemStoragePathSource> source;
+  TF_ASSERT_OK(FileSystemStoragePathSource::Create(config, &source));
+  internal::FileSystemStoragePathSourceTestAccess source_test(source.get());
+  std::atomic<int> notify_count(0);
+  source_test.SetAspiredVersionsCallbackNotifier([&]() { notify_count++; });
+  std::unique_ptr<test_util::MockStoragePathTarget> target(
+      new StrictMock<test_util::MockStoragePathTarget>);
+  ConnectSourceToTarget(source.get(), target.get());
+
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("test_servable_name"),
+                                          ElementsAre(ServableData<StoragePath>(
+                                              {"test_servable_name", 3},
+                                              io::JoinPath(base_path, "3")))));
+  TF_ASSERT_OK(Env::Default()->CreateDir(io::JoinPath(base_path, "3")));
+  while (notify_count == 0) {
+    Env::Default()->SleepForMicroseconds(1000 /* 1 ms */);
+  }
+
+  // Changing whether to watch for changes is not supported.
+  config.set_watch_for_changes(false);
+  EXPECT_FALSE(source->UpdateConfig(config).ok());
+}
+
+TEST(FileSystemStoragePathSourceTest, ParallelPolls) {
+  const string base_path = io::JoinPath(testing::TmpDir(), "ParallelPolls");
+  FileSystemStoragePathSourceConfig config;
+  config.set_num_file_system_poll_threads(4);
+  // Disable the polling thread, and poll manually below.
+  config.set_file_system_poll_wait_seconds(-1);
+  std::unique_ptr<test_util::MockStoragePathTarget> target(
+      new StrictMock<test_util::MockStoragePathTarget>);
+  for (int i = 0; i < 10; ++i) {
+    const string servable_name = strings::StrCat("servable_", i);
+    const string servable_base_path = io::JoinPath(base_path, servable_name);
+    TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+        io::JoinPath(servable_base_path, strings::StrCat(i))));
+    auto* servable = config.add_servables();
+    servable->set_servable_name(servable_name);
+    servable->set_base_path(servable_base_path);
+    EXPECT_CALL(*target, SetAspiredVersions(
+                             Eq(servable_name),
+                             ElementsAre(ServableData<StoragePath>(
+                                 {servable_name, i},
+                                 io::JoinPath(servable_base_path,
+                                              strings::StrCat(i))))));
+  }
+  std::unique_ptr<FileSystemStoragePathSource> source;
+  TF_ASSERT_OK(FileSystemStoragePathSource::Create(config, &source));
+  ConnectSourceToTarget(source.get(), target.get());
+  TF_ASSERT_OK(internal::FileSystemStoragePathSourceTestAccess(source.get())
+                   .PollFileSystemAndInvokeCallback());
+}
+
+TEST(FileSystemStoragePathSourceTest, BacksOffUnchangedServables) {
+  const string base_path =
+      io::JoinPath(testing::TmpDir(), "BacksOffUnchangedServables");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(
+      io::JoinPath(base_path, "3")));
+  auto config = test_util::CreateProto<FileSystemStoragePathSourceConfig>(
+      strings::Printf("servables: {"
+                      "  servable_name: 'test_servable_name' "
+                      "  base_path: '%s' "
+                      "} "
+                      "max_file_system_poll_backoff_seconds: 100 "
+                      // Disable the polling thread.
+                      "file_system_poll_wait_seconds: -1 ",
+                      base_path.c_str()));
+  std::unique_ptr<FileSystemStoragePathSource> source;
+  TF_ASSERT_OK(FileSystemStoragePathSource::Create(config, &source));
+  std::unique_ptr<test_util::MockStoragePathTarget> target(
+      new StrictMock<test_util::MockStoragePathTarget>);
+  ConnectSourceToTarget(source.get(), target.get());
+
+  // The first poll finds a change, so the second one is not skipped. It finds
+  // none, so the third one, within two polling periods, is.
+  EXPECT_CALL(*target, SetAspiredVersions(Eq("test_servable_name"),
+                                          ElementsAre(ServableData<StoragePath>(
+                                              {"test_servable_name", 3},
+                                              io::JoinPath(base_path, "3")))))
+      .Times(2);
+  for (int i = 0; i < 3; ++i) {
+    TF_ASSERT_OK(internal::FileSystemStoragePathSourceTestAccess(source.get())
+                     .PollFileSystemAndInvokeCallback());
+  }
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -0,0 +1,158 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/sources/storage_path/inotify_change_notifier.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// The events of a watched directory that are notified.
+constexpr uint32_t kWatchedEvents = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                    IN_MOVED_TO | IN_DELETE_SELF |
+                                    IN_MOVE_SELF | IN_ONLYDIR;
+
+// How often the event thread checks whether it should stop.
+constexpr int kStopCheckIntervalMillis = 100;
+
+const bool kRegistered = [] {
+  RegisterFileSystemChangeNotifierFactory("", InotifyChangeNotifier::Create);
+  return true;
+}();
+
+}  // namespace
+
+Status InotifyChangeNotifier::Create(
+    ChangeCallback callback,
+    std::unique_ptr<FileSystemChangeNotifier>* notifier) {
+  const int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    return errors::Unavailable("Could not initialize inotify: ",
+                               strerror(errno));
+  }
+  notifier->reset(new InotifyChangeNotifier(fd, std::move(callback)));
+  return OkStatus();
+}
+
+InotifyChangeNotifier::InotifyChangeNotifier(int fd, ChangeCallback callback)
+    : fd_(fd), callback_(std::move(callback)) {
+  thread_.reset(Env::Default()->StartThread(ThreadOptions(),
+                                            "InotifyChangeNotifier_events",
+                                            [this]() { ReadEvents(); }));
+}
+
+InotifyChangeNotifier::~InotifyChangeNotifier() {
+  stopped_ = true;
+  thread_.reset();
+  close(fd_);
+}
+
+Status InotifyChangeNotifier::Watch(const string& path) {
+  mutex_lock l(mu_);
+  if (watch_by_path_.count(path) > 0) {
+    return OkStatus();
+  }
+  const int watch = inotify_add_watch(fd_, path.c_str(), kWatchedEvents);
+  if (watch < 0) {
+    return errors::Unavailable("Could not watch ", path, ": ",
+                               strerror(errno));
+  }
+  watch_by_path_[path] = watch;
+  paths_by_watch_[watch].insert(path);
+  return OkStatus();
+}
+
+void InotifyChangeNotifier::Unwatch(const string& path) {
+  mutex_lock l(mu_);
+  auto it = watch_by_path_.find(path);
+  if (it == watch_by_path_.end()) {
+    return;
+  }
+  const int watch = it->second;
+  watch_by_path_.erase(it);
+  std::set<string>& paths = paths_by_watch_[watch];
+  paths.erase(path);
+  if (paths.empty()) {
+    paths_by_watch_.erase(watch);
+    inotify_rm_watch(fd_, watch);
+  }
+}
+
+void InotifyChangeNotifier::ReadEvents() {
+  alignas(struct inotify_event) char buffer[4096];
+  while (!stopped_) {
+    struct pollfd poll_fd = {fd_, POLLIN, 0};
+    if (poll(&poll_fd, 1, kStopCheckIntervalMillis) <= 0) {
+      continue;
+    }
+    const ssize_t length = read(fd_, buffer, sizeof(buffer));
+    if (length <= 0) {
+      continue;
+    }
+
+    std::set<string> changed_paths;
+    {
+      mutex_lock l(mu_);
+      for (const char* position = buffer; position < buffer + length;) {
+        const auto* event =
+            reinterpret_cast<const struct inotify_event*>(position);
+        position += sizeof(struct inotify_event) + event->len;
+        if (event->mask & IN_Q_OVERFLOW) {
+          // Events were dropped, so any of the paths may have changed.
+          for (const auto& entry : watch_by_path_) {
+            changed_paths.insert(entry.first);
+          }
+          continue;
+        }
+        auto it = paths_by_watch_.find(event->wd);
+        if (it == paths_by_watch_.end()) {
+          continue;
+        }
+        changed_paths.insert(it->second.begin(), it->second.end());
+        if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+          // The directory was deleted or moved away from its path, or its file
+          // system unmounted, so the path is no longer watched. (The kernel
+          // removes the watch of a deleted directory itself.)
+          if (event->mask & IN_MOVE_SELF) {
+            inotify_rm_watch(fd_, event->wd);
+          }
+          for (const string& path : it->second) {
+            watch_by_path_.erase(path);
+          }
+          paths_by_watch_.erase(it);
+        }
+      }
+    }
+    for (const string& path : changed_paths) {
+      VLOG(1) << "Children of " << path << " changed";
+      callback_(path);
+    }
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
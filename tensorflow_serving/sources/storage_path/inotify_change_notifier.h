@@ -0,0 +1,85 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_SOURCES_STORAGE_PATH_INOTIFY_CHANGE_NOTIFIER_H_
+#define TENSORFLOW_SERVING_SOURCES_STORAGE_PATH_INOTIFY_CHANGE_NOTIFIER_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/sources/storage_path/file_system_change_notifier.h"
+
+namespace tensorflow {
+namespace serving {
+
+/// A FileSystemChangeNotifier for local directories, using Linux inotify.
+/// Notifies of children being created, deleted or moved in or out of the
+/// watched directories, and of the directories themselves being deleted or
+/// moved (after which they are no longer watched). Changes below the children,
+/// e.g. files being written into a version directory, are not notified.
+///
+/// Registered as the notifier of local paths, i.e. of the empty scheme.
+class InotifyChangeNotifier : public FileSystemChangeNotifier {
+ public:
+  static Status Create(ChangeCallback callback,
+                       std::unique_ptr<FileSystemChangeNotifier>* notifier);
+
+  /// Blocks until the thread that reads the events, and so any running call of
+  /// the callback, has stopped.
+  ~InotifyChangeNotifier() override;
+
+  Status Watch(const string& path) override TF_LOCKS_EXCLUDED(mu_);
+
+  void Unwatch(const string& path) override TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  InotifyChangeNotifier(int fd, ChangeCallback callback);
+
+  // Reads the events of 'fd_' and calls 'callback_' for them, until 'stopped_'
+  // is set.
+  void ReadEvents() TF_LOCKS_EXCLUDED(mu_);
+
+  // The inotify instance.
+  const int fd_;
+
+  const ChangeCallback callback_;
+
+  mutex mu_;
+
+  // The watched paths, and their watch descriptors. Paths that resolve to the
+  // same directory share a watch descriptor.
+  std::map<string, int> watch_by_path_ TF_GUARDED_BY(mu_);
+  std::map<int, std::set<string>> paths_by_watch_ TF_GUARDED_BY(mu_);
+
+  std::atomic<bool> stopped_{false};
+
+  // Runs ReadEvents().
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InotifyChangeNotifier);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_SOURCES_STORAGE_PATH_INOTIFY_CHANGE_NOTIFIER_H_
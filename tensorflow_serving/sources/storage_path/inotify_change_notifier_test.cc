@@ -0,0 +1,124 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/sources/storage_path/inotify_change_notifier.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <set>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class InotifyChangeNotifierTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    TF_ASSERT_OK(InotifyChangeNotifier::Create(
+        [this](const string& path) {
+          mutex_lock l(mu_);
+          changed_paths_.insert(path);
+          changed_cv_.notify_all();
+        },
+        &notifier_));
+  }
+
+  // Waits until 'path' is notified to have changed, for up to 10 seconds.
+  bool WaitForChange(const string& path) {
+    mutex_lock l(mu_);
+    for (int i = 0; i < 100 && changed_paths_.count(path) == 0; ++i) {
+      changed_cv_.wait_for(l, std::chrono::milliseconds(100));
+    }
+    return changed_paths_.erase(path) > 0;
+  }
+
+  std::unique_ptr<FileSystemChangeNotifier> notifier_;
+
+  mutex mu_;
+  condition_variable changed_cv_;
+  std::set<string> changed_paths_ TF_GUARDED_BY(mu_);
+};
+
+TEST_F(InotifyChangeNotifierTest, NotifiesChildChanges) {
+  const string base_path =
+      io::JoinPath(testing::TmpDir(), "NotifiesChildChanges");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(base_path));
+  TF_ASSERT_OK(notifier_->Watch(base_path));
+  // Watching again is a no-op.
+  TF_ASSERT_OK(notifier_->Watch(base_path));
+
+  TF_ASSERT_OK(Env::Default()->CreateDir(io::JoinPath(base_path, "1")));
+  EXPECT_TRUE(WaitForChange(base_path));
+  TF_ASSERT_OK(Env::Default()->RenameFile(io::JoinPath(base_path, "1"),
+                                          io::JoinPath(base_path, "2")));
+  EXPECT_TRUE(WaitForChange(base_path));
+  TF_ASSERT_OK(Env::Default()->DeleteDir(io::JoinPath(base_path, "2")));
+  EXPECT_TRUE(WaitForChange(base_path));
+}
+
+TEST_F(InotifyChangeNotifierTest, Unwatch) {
+  const string base_path = io::JoinPath(testing::TmpDir(), "Unwatch");
+  const string other_path = io::JoinPath(testing::TmpDir(), "UnwatchOther");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(base_path));
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(other_path));
+  TF_ASSERT_OK(notifier_->Watch(base_path));
+  TF_ASSERT_OK(notifier_->Watch(other_path));
+  notifier_->Unwatch(base_path);
+
+  // Events are delivered in order, so once the change of 'other_path' is seen,
+  // one of 'base_path' would have been too.
+  TF_ASSERT_OK(Env::Default()->CreateDir(io::JoinPath(base_path, "1")));
+  TF_ASSERT_OK(Env::Default()->CreateDir(io::JoinPath(other_path, "1")));
+  EXPECT_TRUE(WaitForChange(other_path));
+  mutex_lock l(mu_);
+  EXPECT_EQ(0, changed_paths_.count(base_path));
+}
+
+TEST_F(InotifyChangeNotifierTest, DeletedDirectoryIsNoLongerWatched) {
+  const string base_path =
+      io::JoinPath(testing::TmpDir(), "DeletedDirectoryIsNoLongerWatched");
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(base_path));
+  TF_ASSERT_OK(notifier_->Watch(base_path));
+  TF_ASSERT_OK(Env::Default()->DeleteDir(base_path));
+  EXPECT_TRUE(WaitForChange(base_path));
+
+  // Watching the path again watches the new directory.
+  EXPECT_FALSE(notifier_->Watch(base_path).ok());
+  TF_ASSERT_OK(Env::Default()->CreateDir(base_path));
+  TF_ASSERT_OK(notifier_->Watch(base_path));
+  TF_ASSERT_OK(Env::Default()->CreateDir(io::JoinPath(base_path, "1")));
+  EXPECT_TRUE(WaitForChange(base_path));
+}
+
+TEST(InotifyChangeNotifierRegistrationTest, RegisteredForLocalPaths) {
+  std::unique_ptr<FileSystemChangeNotifier> notifier;
+  TF_EXPECT_OK(CreateFileSystemChangeNotifier(
+      "", [](const string& path) {}, &notifier));
+  EXPECT_FALSE(CreateFileSystemChangeNotifier(
+                   "bogus", [](const string& path) {}, &notifier)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,87 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/composite_tensor_util.h"
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+int64_t RowSplit(const Tensor& row_splits, int64_t i) {
+  return row_splits.dtype() == DT_INT32 ? row_splits.flat<int32>()(i)
+                                        : row_splits.flat<int64_t>()(i);
+}
+
+Status ValidateRowSplits(const string& name, const Tensor& row_splits) {
+  if ((row_splits.dtype() != DT_INT32 && row_splits.dtype() != DT_INT64) ||
+      row_splits.dims() != 1 || row_splits.dim_size(0) == 0) {
+    return errors::InvalidArgument(
+        "The row splits '", name,
+        "' of a ragged tensor must be a non-empty int32 or int64 vector; got ",
+        DataTypeString(row_splits.dtype()), " of shape ",
+        row_splits.shape().DebugString());
+  }
+  if (RowSplit(row_splits, 0) != 0) {
+    return errors::InvalidArgument("The row splits '", name,
+                                   "' of a ragged tensor must start at 0");
+  }
+  for (int64_t i = 1; i < row_splits.dim_size(0); ++i) {
+    if (RowSplit(row_splits, i) < RowSplit(row_splits, i - 1)) {
+      return errors::InvalidArgument("The row splits '", name,
+                                     "' of a ragged tensor must not decrease");
+    }
+  }
+  return OkStatus();
+}
+
+Status ValidateSparseIndices(const string& name, const Tensor& indices,
+                             const Tensor& dense_shape) {
+  if (indices.dtype() != DT_INT64 || dense_shape.dtype() != DT_INT64 ||
+      indices.dims() != 2 || dense_shape.dims() != 1 ||
+      indices.dim_size(1) != dense_shape.dim_size(0)) {
+    return errors::InvalidArgument(
+        "The sparse tensor '", name,
+        "' must have int64 indices of shape [N, rank] and dense shape of "
+        "shape [rank]; got ",
+        DataTypeString(indices.dtype()), " indices of shape ",
+        indices.shape().DebugString(), " and ",
+        DataTypeString(dense_shape.dtype()), " dense shape of shape ",
+        dense_shape.shape().DebugString());
+  }
+  const auto shape = dense_shape.vec<int64_t>();
+  for (int64_t d = 0; d < shape.size(); ++d) {
+    if (shape(d) < 0) {
+      return errors::InvalidArgument("The dense shape of the sparse tensor '",
+                                     name, "' must not be negative");
+    }
+  }
+  const auto index = indices.matrix<int64_t>();
+  for (int64_t i = 0; i < indices.dim_size(0); ++i) {
+    for (int64_t d = 0; d < indices.dim_size(1); ++d) {
+      if (index(i, d) < 0 || index(i, d) >= shape(d)) {
+        return errors::InvalidArgument(
+            "Index ", i, " of the sparse tensor '", name, "' is ",
+            index(i, d), " in dimension ", d, ", out of its dense shape of ",
+            shape(d));
+      }
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
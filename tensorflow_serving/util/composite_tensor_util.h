@@ -0,0 +1,46 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_COMPOSITE_TENSOR_UTIL_H_
+#define TENSORFLOW_SERVING_UTIL_COMPOSITE_TENSOR_UTIL_H_
+
+#include <cstdint>
+#include <string>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Returns entry 'i' of 'row_splits', the DT_INT32 or DT_INT64 row splits of a
+// ragged tensor.
+int64_t RowSplit(const Tensor& row_splits, int64_t i);
+
+// Returns an InvalidArgument error unless 'row_splits', the row splits of the
+// ragged tensor 'name', is a non-empty DT_INT32 or DT_INT64 vector that starts
+// at 0 and does not decrease.
+Status ValidateRowSplits(const string& name, const Tensor& row_splits);
+
+// Returns an InvalidArgument error unless 'indices' and 'dense_shape', the
+// DT_INT64 components of the sparse tensor 'name' of shapes [N, rank] and
+// [rank], have every index within the dense shape.
+Status ValidateSparseIndices(const string& name, const Tensor& indices,
+                             const Tensor& dense_shape);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_COMPOSITE_TENSOR_UTIL_H_
@@ -0,0 +1,77 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/composite_tensor_util.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::HasSubstr;
+
+TEST(CompositeTensorUtilTest, RowSplit) {
+  EXPECT_EQ(3, RowSplit(test::AsTensor<int32>({0, 3}), 1));
+  EXPECT_EQ(5, RowSplit(test::AsTensor<int64_t>({0, 2, 5}), 2));
+}
+
+TEST(CompositeTensorUtilTest, ValidatesRowSplits) {
+  TF_EXPECT_OK(ValidateRowSplits("s", test::AsTensor<int64_t>({0})));
+  TF_EXPECT_OK(ValidateRowSplits("s", test::AsTensor<int32>({0, 0, 2, 5})));
+
+  Status status = ValidateRowSplits("s", test::AsTensor<int64_t>({0, 3, 1}));
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("must not decrease"));
+
+  status = ValidateRowSplits("s", test::AsTensor<int64_t>({1, 3}));
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("must start at 0"));
+
+  for (const Tensor& row_splits :
+       {Tensor(DT_INT64, TensorShape({0})), test::AsTensor<float>({0, 1}),
+        test::AsTensor<int64_t>({0, 1}, {1, 2})}) {
+    EXPECT_TRUE(errors::IsInvalidArgument(ValidateRowSplits("s", row_splits)));
+  }
+}
+
+TEST(CompositeTensorUtilTest, ValidatesSparseIndices) {
+  const Tensor dense_shape = test::AsTensor<int64_t>({2, 3});
+  TF_EXPECT_OK(ValidateSparseIndices(
+      "s", test::AsTensor<int64_t>({0, 0, 1, 2}, {2, 2}), dense_shape));
+  TF_EXPECT_OK(ValidateSparseIndices(
+      "s", Tensor(DT_INT64, TensorShape({0, 2})), dense_shape));
+
+  Status status = ValidateSparseIndices(
+      "s", test::AsTensor<int64_t>({0, 0, 1, 3}, {2, 2}), dense_shape);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("out of its dense shape"));
+  EXPECT_TRUE(errors::IsInvalidArgument(ValidateSparseIndices(
+      "s", test::AsTensor<int64_t>({-1, 0}, {1, 2}), dense_shape)));
+  EXPECT_TRUE(errors::IsInvalidArgument(
+      ValidateSparseIndices("s", Tensor(DT_INT64, TensorShape({0, 2})),
+                            test::AsTensor<int64_t>({2, -1}))));
+  // The rank of the indices must be that of the dense shape.
+  EXPECT_TRUE(errors::IsInvalidArgument(ValidateSparseIndices(
+      "s", test::AsTensor<int64_t>({0, 0, 0}, {1, 3}), dense_shape)));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,265 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/cpu_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <utility>
+
+#include "absl/debugging/stacktrace.h"
+#include "absl/debugging/symbolize.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/env.h"
+
+#if defined(__linux__)
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/time.h>
+#endif
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr int kMaxStackDepth = 64;
+
+// A stack as recorded by the signal handler, before aggregation.
+struct RawSample {
+  int depth;
+  void* stack[kMaxStackDepth];
+  char thread_name[16];
+};
+
+// The state shared with the signal handler. 'g_samples' is only set while a
+// profile is running, and the handlers in flight are counted so that
+// ProfileCpu() can wait them out before reading the samples. The handler
+// counts itself then loads 'g_samples', and ProfileCpu() clears 'g_samples'
+// then loads the count: both orders only hold with sequential consistency.
+std::atomic<RawSample*> g_samples{nullptr};
+std::atomic<int> g_num_samples{0};
+std::atomic<int> g_max_samples{0};
+std::atomic<int64_t> g_num_dropped{0};
+std::atomic<int> g_num_handlers_running{0};
+
+// Whether a profile is being taken.
+std::atomic<bool> g_profiling{false};
+
+#if defined(__linux__)
+
+// Only calls async-signal-safe functions, and allocates nothing.
+void HandleProfilingSignal(int signal, siginfo_t* info, void* ucontext) {
+  const int saved_errno = errno;
+  g_num_handlers_running.fetch_add(1, std::memory_order_seq_cst);
+  RawSample* samples = g_samples.load(std::memory_order_seq_cst);
+  if (samples != nullptr) {
+    const int index = g_num_samples.fetch_add(1, std::memory_order_relaxed);
+    if (index < g_max_samples.load(std::memory_order_relaxed)) {
+      RawSample* sample = &samples[index];
+      // Skips this handler's frame.
+      sample->depth = absl::GetStackTraceWithContext(
+          sample->stack, kMaxStackDepth, 1, ucontext, nullptr);
+      sample->thread_name[0] = '\0';
+      prctl(PR_GET_NAME, sample->thread_name, 0, 0, 0);
+      sample->thread_name[sizeof(sample->thread_name) - 1] = '\0';
+    } else {
+      g_num_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  g_num_handlers_running.fetch_sub(1, std::memory_order_release);
+  errno = saved_errno;
+}
+
+Status SetProfilingTimer(int64_t period_micros) {
+  struct itimerval timer = {};
+  timer.it_interval.tv_sec = period_micros / 1000000;
+  timer.it_interval.tv_usec = period_micros % 1000000;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+    return errors::Internal("setitimer failed: ", strerror(errno));
+  }
+  return OkStatus();
+}
+
+#endif  // defined(__linux__)
+
+// Returns the symbol of 'pc', or its address if it can't be symbolized.
+string Symbolize(void* pc, bool is_return_address) {
+  // A return address may be past the end of the calling function, so the
+  // symbol of the call instruction is looked up instead.
+  char* lookup = static_cast<char*>(pc) - (is_return_address ? 1 : 0);
+  char symbol[1024];
+  if (absl::Symbolize(lookup, symbol, sizeof(symbol))) {
+    return symbol;
+  }
+  return absl::StrCat("0x", absl::Hex(reinterpret_cast<uintptr_t>(pc)));
+}
+
+void AppendWord(uintptr_t word, string* out) {
+  out->append(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+}  // namespace
+
+Status ProfileCpu(const CpuProfileOptions& options, CpuProfile* profile) {
+#if defined(__linux__)
+  if (options.frequency_hz <= 0 || options.frequency_hz > 10000) {
+    return errors::InvalidArgument("frequency_hz must be in (0, 10000]; was ",
+                                   options.frequency_hz);
+  }
+  if (options.duration_micros <= 0 || options.max_samples <= 0) {
+    return errors::InvalidArgument(
+        "duration_micros and max_samples must be positive");
+  }
+  if (g_profiling.exchange(true)) {
+    return errors::Unavailable("A CPU profile is already being taken");
+  }
+  auto done_profiling = gtl::MakeCleanup([] { g_profiling.store(false); });
+
+  // Walks a stack first, in case the unwinder initializes itself lazily.
+  void* warmup[kMaxStackDepth];
+  absl::GetStackTrace(warmup, kMaxStackDepth, 0);
+
+  std::unique_ptr<RawSample[]> samples(new RawSample[options.max_samples]);
+  g_num_samples.store(0, std::memory_order_relaxed);
+  g_max_samples.store(options.max_samples, std::memory_order_relaxed);
+  g_num_dropped.store(0, std::memory_order_relaxed);
+  g_samples.store(samples.get(), std::memory_order_release);
+
+  struct sigaction action = {};
+  action.sa_sigaction = HandleProfilingSignal;
+  action.sa_flags = SA_RESTART | SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+  struct sigaction old_action;
+  if (sigaction(SIGPROF, &action, &old_action) != 0) {
+    g_samples.store(nullptr, std::memory_order_release);
+    return errors::Internal("sigaction failed: ", strerror(errno));
+  }
+  const int64_t period_micros = std::max(1000000 / options.frequency_hz, 1);
+  Status status = SetProfilingTimer(period_micros);
+  if (status.ok()) {
+    Env* env = Env::Default();
+    const uint64_t deadline_micros = env->NowMicros() + options.duration_micros;
+    for (uint64_t now_micros = env->NowMicros(); now_micros < deadline_micros;
+         now_micros = env->NowMicros()) {
+      env->SleepForMicroseconds(deadline_micros - now_micros);
+    }
+    SetProfilingTimer(0).IgnoreError();
+  }
+  // Signals still pending are ignored by the handler from here on.
+  g_samples.store(nullptr, std::memory_order_seq_cst);
+  while (g_num_handlers_running.load(std::memory_order_seq_cst) > 0) {
+  }
+  sigaction(SIGPROF, &old_action, nullptr);
+  TF_RETURN_IF_ERROR(status);
+
+  const int num_samples =
+      std::min(g_num_samples.load(std::memory_order_relaxed),
+               options.max_samples);
+  std::map<std::pair<string, std::vector<void*>>, int64_t> counts;
+  for (int i = 0; i < num_samples; ++i) {
+    const RawSample& sample = samples[i];
+    ++counts[{sample.thread_name,
+              std::vector<void*>(sample.stack, sample.stack + sample.depth)}];
+  }
+  profile->samples.clear();
+  profile->samples.reserve(counts.size());
+  for (auto& entry : counts) {
+    CpuProfile::Sample sample;
+    sample.thread_name = entry.first.first;
+    sample.stack = entry.first.second;
+    sample.count = entry.second;
+    profile->samples.push_back(std::move(sample));
+  }
+  profile->period_micros = period_micros;
+  profile->num_dropped = g_num_dropped.load(std::memory_order_relaxed);
+  return OkStatus();
+#else
+  return errors::Unimplemented("CPU profiling is only supported on Linux");
+#endif  // defined(__linux__)
+}
+
+string CpuProfileToFoldedStacks(const CpuProfile& profile) {
+  std::map<void*, string> symbols[2];
+  string folded;
+  for (const CpuProfile::Sample& sample : profile.samples) {
+    std::vector<string> frames;
+    frames.reserve(sample.stack.size() + 1);
+    frames.push_back(sample.thread_name.empty() ? "unnamed_thread"
+                                                : sample.thread_name);
+    // Outermost frame first; all frames but the innermost are return
+    // addresses.
+    for (int i = sample.stack.size() - 1; i >= 0; --i) {
+      const bool is_return_address = i > 0;
+      void* pc = sample.stack[i];
+      auto it = symbols[is_return_address].find(pc);
+      if (it == symbols[is_return_address].end()) {
+        it = symbols[is_return_address]
+                 .emplace(pc, Symbolize(pc, is_return_address))
+                 .first;
+      }
+      frames.push_back(it->second);
+    }
+    absl::StrAppend(&folded, absl::StrJoin(frames, ";"), " ", sample.count,
+                    "\n");
+  }
+  return folded;
+}
+
+string CpuProfileToPprof(const CpuProfile& profile) {
+  string pprof;
+  // Header: header count, header words, format version, sampling period,
+  // padding.
+  for (uintptr_t word : {uintptr_t{0}, uintptr_t{3}, uintptr_t{0},
+                         static_cast<uintptr_t>(profile.period_micros),
+                         uintptr_t{0}}) {
+    AppendWord(word, &pprof);
+  }
+  // Samples of the same stack on different threads are merged.
+  std::map<std::vector<void*>, int64_t> counts;
+  for (const CpuProfile::Sample& sample : profile.samples) {
+    counts[sample.stack] += sample.count;
+  }
+  for (const auto& entry : counts) {
+    AppendWord(entry.second, &pprof);
+    AppendWord(entry.first.size(), &pprof);
+    for (void* pc : entry.first) {
+      AppendWord(reinterpret_cast<uintptr_t>(pc), &pprof);
+    }
+  }
+  // Trailer, then the memory map pprof symbolizes the addresses with.
+  for (uintptr_t word : {uintptr_t{0}, uintptr_t{1}, uintptr_t{0}}) {
+    AppendWord(word, &pprof);
+  }
+  std::ifstream maps("/proc/self/maps");
+  if (maps) {
+    std::stringstream contents;
+    contents << maps.rdbuf();
+    pprof.append(contents.str());
+  }
+  return pprof;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,85 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_CPU_PROFILER_H_
+#define TENSORFLOW_SERVING_UTIL_CPU_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace serving {
+
+struct CpuProfileOptions {
+  // How long to sample for.
+  int64_t duration_micros = 10 * 1000 * 1000;
+
+  // The sampling rate, per second of CPU time of the process.
+  int frequency_hz = 100;
+
+  // Samples past this many are dropped (and counted in
+  // CpuProfile::num_dropped).
+  int max_samples = 1 << 16;
+};
+
+// The call stacks sampled by ProfileCpu(), aggregated per thread name and
+// stack.
+struct CpuProfile {
+  struct Sample {
+    // The name of the sampled thread (truncated to 15 characters by the OS).
+    string thread_name;
+
+    // The program counters of the stack, innermost frame first.
+    std::vector<void*> stack;
+
+    // How many times the thread was sampled in this stack.
+    int64_t count = 0;
+  };
+
+  std::vector<Sample> samples;
+
+  // The CPU time each sample stands for.
+  int64_t period_micros = 0;
+
+  int64_t num_dropped = 0;
+};
+
+// Samples the call stacks of the threads of the process as they use CPU, for
+// 'options.duration_micros', and blocks until done. Sampling is driven by a
+// SIGPROF timer on the CPU time of the process, so idle threads cost nothing
+// and the overhead is a stack walk per sample. Only one profile can be taken at
+// a time in the process; returns Unavailable while another one is running, and
+// Unimplemented on platforms other than Linux.
+Status ProfileCpu(const CpuProfileOptions& options, CpuProfile* profile);
+
+// Renders 'profile' in the folded stacks format read by flamegraph.pl and
+// speedscope: a line per stack, outermost frame first and rooted at the thread
+// name, e.g.
+//
+//   batch_threads;start_thread;...;tensorflow::DirectSession::Run 42
+//
+string CpuProfileToFoldedStacks(const CpuProfile& profile);
+
+// Renders 'profile' in the legacy binary CPU profile format of gperftools,
+// which `pprof <binary> <profile>` reads. Thread names are not kept.
+string CpuProfileToPprof(const CpuProfile& profile);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_CPU_PROFILER_H_
@@ -0,0 +1,144 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/cpu_profiler.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "absl/strings/match.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+#if defined(__linux__)
+
+TEST(CpuProfilerTest, SamplesBusyThreads) {
+  std::atomic<bool> stop{false};
+  std::unique_ptr<Thread> spinner(
+      Env::Default()->StartThread({}, "spinner", [&stop] {
+        prctl(PR_SET_NAME, "busy_spinner", 0, 0, 0);
+        volatile uint64_t sum = 0;
+        while (!stop.load()) {
+          sum = sum + 1;
+        }
+      }));
+
+  CpuProfileOptions options;
+  options.duration_micros = 500 * 1000;
+  options.frequency_hz = 1000;
+  CpuProfile profile;
+  TF_ASSERT_OK(ProfileCpu(options, &profile));
+  stop.store(true);
+  spinner.reset();
+
+  EXPECT_EQ(1000, profile.period_micros);
+  int64_t num_spinner_samples = 0;
+  for (const CpuProfile::Sample& sample : profile.samples) {
+    EXPECT_GT(sample.count, 0);
+    EXPECT_FALSE(sample.stack.empty());
+    if (sample.thread_name == "busy_spinner") {
+      num_spinner_samples += sample.count;
+    }
+  }
+  // The spinner is on CPU for all of the profile.
+  EXPECT_GT(num_spinner_samples, 10);
+  EXPECT_TRUE(absl::StrContains(CpuProfileToFoldedStacks(profile),
+                                "busy_spinner;"));
+}
+
+TEST(CpuProfilerTest, OneProfileAtATime) {
+  std::atomic<bool> started{false};
+  Status first_status;
+  std::unique_ptr<Thread> first(
+      Env::Default()->StartThread({}, "first", [&] {
+        CpuProfileOptions options;
+        options.duration_micros = 2 * 1000 * 1000;
+        CpuProfile profile;
+        started.store(true);
+        first_status = ProfileCpu(options, &profile);
+      }));
+  while (!started.load()) {
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  Env::Default()->SleepForMicroseconds(200 * 1000);
+
+  CpuProfile profile;
+  EXPECT_EQ(error::UNAVAILABLE, ProfileCpu({}, &profile).code());
+  first.reset();
+  TF_EXPECT_OK(first_status);
+}
+
+TEST(CpuProfilerTest, InvalidOptions) {
+  CpuProfile profile;
+  CpuProfileOptions options;
+  options.frequency_hz = 0;
+  EXPECT_EQ(error::INVALID_ARGUMENT, ProfileCpu(options, &profile).code());
+  options = CpuProfileOptions();
+  options.duration_micros = 0;
+  EXPECT_EQ(error::INVALID_ARGUMENT, ProfileCpu(options, &profile).code());
+}
+
+#endif  // defined(__linux__)
+
+CpuProfile MakeProfile() {
+  CpuProfile profile;
+  profile.period_micros = 10000;
+  CpuProfile::Sample sample;
+  sample.thread_name = "batch_threads";
+  sample.stack = {nullptr};
+  sample.count = 3;
+  profile.samples.push_back(sample);
+  sample.thread_name = "grpcpp_sync_ser";
+  sample.count = 2;
+  profile.samples.push_back(sample);
+  return profile;
+}
+
+TEST(CpuProfilerTest, FoldedStacks) {
+  EXPECT_EQ(
+      "batch_threads;0x0 3\n"
+      "grpcpp_sync_ser;0x0 2\n",
+      CpuProfileToFoldedStacks(MakeProfile()));
+}
+
+TEST(CpuProfilerTest, Pprof) {
+  const string pprof = CpuProfileToPprof(MakeProfile());
+  // Header, one merged sample of depth one, and trailer.
+  const size_t num_words = 5 + 3 + 3;
+  ASSERT_GE(pprof.size(), num_words * sizeof(uintptr_t));
+  uintptr_t words[num_words];
+  std::memcpy(words, pprof.data(), sizeof(words));
+  EXPECT_EQ(3, words[1]);
+  EXPECT_EQ(10000, words[3]);
+  EXPECT_EQ(5, words[5]);
+  EXPECT_EQ(1, words[6]);
+  EXPECT_EQ(0, words[7]);
+  EXPECT_EQ(1, words[9]);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,139 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/cpu_set_env.h"
+
+#include <map>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// Restricts the calling thread to 'cpus'.
+void SetCurrentThreadAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (const int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  const int error =
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  if (error != 0) {
+    LOG(WARNING) << "Failed to set the CPU affinity of a thread: error "
+                 << error;
+  }
+#else
+  LOG_FIRST_N(WARNING, 1) << "CPU affinity is not supported on this platform";
+#endif
+}
+
+// Returns the CPUs the calling thread may run on, or none if unknown.
+std::vector<int> GetCurrentThreadAffinity() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) ==
+      0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+}  // namespace
+
+CpuSetEnv::CpuSetEnv(Env* target, std::vector<int> cpus)
+    : EnvWrapper(target), cpus_(std::move(cpus)) {}
+
+CpuSetEnv* CpuSetEnv::ForCpus(const std::vector<int>& cpus) {
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* envs = new std::map<std::vector<int>, CpuSetEnv*>();
+  mutex_lock l(mu);
+  CpuSetEnv*& env = (*envs)[cpus];
+  if (env == nullptr) {
+    env = new CpuSetEnv(Env::Default(), cpus);
+  }
+  return env;
+}
+
+Thread* CpuSetEnv::StartThread(const ThreadOptions& thread_options,
+                               const string& name, std::function<void()> fn) {
+  if (cpus_.empty()) {
+    return target()->StartThread(thread_options, name, std::move(fn));
+  }
+  return target()->StartThread(
+      thread_options, name, [cpus = cpus_, fn = std::move(fn)]() {
+        SetCurrentThreadAffinity(cpus);
+        fn();
+      });
+}
+
+ScopedThreadCpus::ScopedThreadCpus(const std::vector<int>& cpus) {
+  if (cpus.empty()) {
+    return;
+  }
+  saved_cpus_ = GetCurrentThreadAffinity();
+  SetCurrentThreadAffinity(cpus);
+}
+
+ScopedThreadCpus::~ScopedThreadCpus() {
+  if (!saved_cpus_.empty()) {
+    SetCurrentThreadAffinity(saved_cpus_);
+  }
+}
+
+Status ParseCpuList(const absl::string_view list, std::vector<int>* cpus) {
+  cpus->clear();
+  for (const absl::string_view range :
+       absl::StrSplit(list, ',', absl::SkipWhitespace())) {
+    const std::vector<absl::string_view> bounds =
+        absl::StrSplit(range, absl::MaxSplits('-', 1));
+    int first;
+    int last;
+    if (!absl::SimpleAtoi(bounds[0], &first) ||
+        !absl::SimpleAtoi(bounds.back(), &last) || first < 0 ||
+        last < first) {
+      return errors::InvalidArgument("Invalid CPU list: ", list);
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus->push_back(cpu);
+    }
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_CPU_SET_ENV_H_
+#define TENSORFLOW_SERVING_UTIL_CPU_SET_ENV_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+
+// An Env that starts all threads with affinity to a set of CPUs, so that e.g.
+// the threads of a thread::ThreadPool created with it only run on those CPUs.
+// Only effective on Linux; elsewhere, threads start without affinity. All
+// other calls are forwarded to the wrapped Env.
+class CpuSetEnv : public EnvWrapper {
+ public:
+  // 'target' must outlive this Env. An empty 'cpus' sets no affinity.
+  CpuSetEnv(Env* target, std::vector<int> cpus);
+  ~CpuSetEnv() override = default;
+
+  // Returns an Env that wraps Env::Default() for 'cpus'. The returned Env lives
+  // for the remainder of the process, like Env::Default() itself, e.g. for
+  // the thread pools of sessions that TF shares across the process.
+  static CpuSetEnv* ForCpus(const std::vector<int>& cpus);
+
+  Thread* StartThread(const ThreadOptions& thread_options, const string& name,
+                      std::function<void()> fn) override;
+
+  const std::vector<int>& cpus() const { return cpus_; }
+
+ private:
+  const std::vector<int> cpus_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(CpuSetEnv);
+};
+
+// Restricts the calling thread to 'cpus' for the lifetime of the object, and
+// then restores its affinity. On Linux, threads start with the affinity of the
+// thread that starts them, so this pins the threads that a library starts
+// without an Env to take (e.g. gRPC). An empty 'cpus' changes nothing.
+class ScopedThreadCpus {
+ public:
+  explicit ScopedThreadCpus(const std::vector<int>& cpus);
+  ~ScopedThreadCpus();
+
+ private:
+  // The CPUs the thread could run on before, if they were changed.
+  std::vector<int> saved_cpus_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedThreadCpus);
+};
+
+// Parses a list of CPUs in the format of the Linux cpuset "cpus" files, e.g.
+// "0-3,8,10-11", to 'cpus'. An empty list parses to no CPUs.
+Status ParseCpuList(absl::string_view list, std::vector<int>* cpus);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_CPU_SET_ENV_H_
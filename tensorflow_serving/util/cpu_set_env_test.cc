@@ -0,0 +1,126 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/cpu_set_env.h"
+
+#include <memory>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Returns the first CPU the calling thread may run on.
+int FirstAllowedCpu() {
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpu_set)) return cpu;
+    }
+  }
+#endif
+  return 0;
+}
+
+TEST(CpuSetEnvTest, StartsThreadsOnCpus) {
+  const int cpu = FirstAllowedCpu();
+  CpuSetEnv env(Env::Default(), {cpu});
+  bool ran = false;
+  int num_cpus = -1;
+  {
+    std::unique_ptr<Thread> thread(
+        env.StartThread({}, "thread", [cpu, &ran, &num_cpus] {
+          ran = true;
+#if defined(__linux__)
+          cpu_set_t cpu_set;
+          CPU_ZERO(&cpu_set);
+          if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0 &&
+              CPU_ISSET(cpu, &cpu_set)) {
+            num_cpus = CPU_COUNT(&cpu_set);
+          }
+#endif
+        }));
+  }
+  EXPECT_TRUE(ran);
+#if defined(__linux__)
+  EXPECT_EQ(1, num_cpus);
+#endif
+}
+
+TEST(CpuSetEnvTest, NoCpusSetsNoAffinity) {
+  CpuSetEnv env(Env::Default(), {});
+  EXPECT_TRUE(env.cpus().empty());
+  bool ran = false;
+  {
+    std::unique_ptr<Thread> thread(
+        env.StartThread({}, "thread", [&ran] { ran = true; }));
+  }
+  EXPECT_TRUE(ran);
+}
+
+TEST(CpuSetEnvTest, ForCpusReturnsOneEnvPerSet) {
+  CpuSetEnv* env = CpuSetEnv::ForCpus({0, 1});
+  EXPECT_EQ(env, CpuSetEnv::ForCpus({0, 1}));
+  EXPECT_NE(env, CpuSetEnv::ForCpus({0}));
+  EXPECT_EQ(std::vector<int>({0, 1}), env->cpus());
+}
+
+TEST(CpuSetEnvTest, ScopedThreadCpusPinsStartedThreads) {
+  const int cpu = FirstAllowedCpu();
+  int num_cpus = -1;
+  {
+    ScopedThreadCpus scoped_cpus({cpu});
+    // Started without an Env that sets affinity, so inherits it.
+    std::unique_ptr<Thread> thread(
+        Env::Default()->StartThread({}, "thread", [&num_cpus] {
+#if defined(__linux__)
+          cpu_set_t cpu_set;
+          CPU_ZERO(&cpu_set);
+          if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+            num_cpus = CPU_COUNT(&cpu_set);
+          }
+#endif
+        }));
+  }
+#if defined(__linux__)
+  EXPECT_EQ(1, num_cpus);
+#endif
+}
+
+TEST(CpuSetEnvTest, ParseCpuList) {
+  std::vector<int> cpus;
+  TF_ASSERT_OK(ParseCpuList("0-3,8,10-11", &cpus));
+  EXPECT_THAT(cpus, ::testing::ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  TF_ASSERT_OK(ParseCpuList("", &cpus));
+  EXPECT_TRUE(cpus.empty());
+  for (const char* invalid : {"a", "1-", "-1", "3-1", "1,,x"}) {
+    EXPECT_FALSE(ParseCpuList(invalid, &cpus).ok()) << invalid;
+  }
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
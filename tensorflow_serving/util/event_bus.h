@@ -13,15 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-// TODO(b/25725560): Consider having a thread pool for invoking callbacks.
-
 #ifndef TENSORFLOW_SERVING_UTIL_EVENT_BUS_H_
 #define TENSORFLOW_SERVING_UTIL_EVENT_BUS_H_
 
 #include <algorithm>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/core/platform/env.h"
@@ -44,15 +44,19 @@ namespace serving {
 /// Important scaling and threading limitations:
 ///
 /// Scaling:
-/// The EventBus is not currently optimized for high scale, either in the number
-/// of subscribers or frequency of events. For such use-cases, consider
-/// alternate implementations or upgrades to this class.
+/// The list of subscribers is copied on write, so publishing only briefly
+/// takes the bus's lock, but subscribing and unsubscribing are linear in the
+/// number of subscribers.
 ///
 /// Threading:
 /// EventBus is thread-safe. However, if any subscriber callback calls any
-/// method in the EventBus, it will deadlock. Subscribers are notified serially
-/// on the event publisher's thread. Thus, the amount of work done in a
-/// subscriber's callback should be very minimal.
+/// method in the EventBus, it may deadlock. By default, subscribers are
+/// notified serially on the event publisher's thread. Thus, the amount of work
+/// done in a subscriber's callback should be very minimal. With
+/// Options::async_publication, each subscriber is instead notified on a thread
+/// of its own, so that a slow subscriber only stalls publishers once its queue
+/// is full. Either way, each subscriber is notified of the events in the order
+/// in which they were published, and not concurrently.
 ///
 /// This implementation is single-binary and does not communicate across tasks.
 ///
@@ -88,8 +92,18 @@ class EventBus : public std::enable_shared_from_this<EventBus<E>> {
   };
 
   struct Options {
-    // The environment to use for time.
+    // The environment to use for time, and for the threads of asynchronous
+    // publication.
     Env* env = Env::Default();
+
+    // If true, Publish() only queues the event for each subscriber, and each
+    // subscriber is notified of its queued events on a thread of its own.
+    bool async_publication = false;
+
+    // The maximum number of events queued for a subscriber, in asynchronous
+    // publication. Publish() blocks while the queue of a subscriber is full.
+    // Values below 1 are treated as 1.
+    size_t max_queued_events_per_subscriber = 1024;
   };
 
   /// Creates an EventBus and returns a shared_ptr to it. This is the only
@@ -97,7 +111,7 @@ class EventBus : public std::enable_shared_from_this<EventBus<E>> {
   /// references to an EventBus uniformly.
   static std::shared_ptr<EventBus> CreateEventBus(const Options& options = {});
 
-  ~EventBus() = default;
+  ~EventBus();
 
   /// Event and the publish time associated with it.
   struct EventAndTime {
@@ -111,7 +125,8 @@ class EventBus : public std::enable_shared_from_this<EventBus<E>> {
   ///   including subscribing, publishing or unsubscribing. This will cause a
   ///   circular deadlock.
   /// * Callbacks must do very little work as they are invoked on the
-  ///   publisher's thread. Any costly work should be performed asynchronously.
+  ///   publisher's thread, unless publication is asynchronous. Any costly work
+  ///   should be performed asynchronously.
   using Callback = std::function<void(const EventAndTime&)>;
 
   /// Subscribes to all events on the EventBus.
@@ -139,21 +154,49 @@ class EventBus : public std::enable_shared_from_this<EventBus<E>> {
   // Unsubscribes the specified subscriber. Called only by Subscription.
   void Unsubscribe(const Subscription* subscription) TF_LOCKS_EXCLUDED(mutex_);
 
+  // An event queued for a subscriber, in asynchronous publication.
+  struct QueuedEvent {
+    E event;
+    uint64_t event_time_micros;
+  };
+
   // All of the information needed for a single subscription, both for
   // publishing events and unsubscribing.
-  struct SubscriptionTuple {
+  struct Subscriber {
     // Uniquely identifies the Subscription.
     Subscription* subscription;
     Callback callback;
+
+    // Held while the callback is invoked on the publisher's thread, so that
+    // unsubscribing waits for the invocation to finish.
+    mutex mu;
+    bool unsubscribed TF_GUARDED_BY(mu) = false;
+
+    // The events not yet delivered, in asynchronous publication.
+    std::deque<QueuedEvent> queue TF_GUARDED_BY(mu);
+    // Signaled when 'queue' or 'unsubscribed' changes.
+    condition_variable queue_changed;
+
+    // The thread that delivers the queued events, in asynchronous publication.
+    std::unique_ptr<Thread> thread;
   };
 
-  // Mutex held for all operations on an EventBus including all publishing and
-  // subscription operations.
+  using SubscriberList = std::vector<std::shared_ptr<Subscriber>>;
+
+  // Delivers the queued events of the subscriber until it is unsubscribed.
+  static void DeliverQueuedEvents(Subscriber* subscriber);
+
+  // Marks the subscriber as unsubscribed, and waits until its callback is no
+  // longer invoked.
+  static void StopSubscriber(Subscriber* subscriber);
+
+  // Mutex held while reading or replacing 'subscribers_'.
   mutable mutex mutex_;
 
-  // All subscriptions that the EventBus is aware of. Note that this is not
-  // optimized for high scale in the number of subscribers.
-  std::vector<SubscriptionTuple> subscriptions_ TF_GUARDED_BY(mutex_);
+  // All subscriptions that the EventBus is aware of. The list is never
+  // changed, only replaced, so that publishers can notify the subscribers
+  // without holding 'mutex_'.
+  std::shared_ptr<const SubscriberList> subscribers_ TF_GUARDED_BY(mutex_);
 
   const Options options_;
 
@@ -177,15 +220,37 @@ EventBus<E>::Subscription::~Subscription() {
 template <typename E>
 std::unique_ptr<typename EventBus<E>::Subscription> EventBus<E>::Subscribe(
     const Callback& callback) {
-  mutex_lock lock(mutex_);
   std::unique_ptr<Subscription> subscription(
       new Subscription(this->shared_from_this()));
-  subscriptions_.push_back({subscription.get(), callback});
+  auto subscriber = std::make_shared<Subscriber>();
+  subscriber->subscription = subscription.get();
+  subscriber->callback = callback;
+  if (options_.async_publication) {
+    Subscriber* const subscriber_ptr = subscriber.get();
+    subscriber->thread.reset(options_.env->StartThread(
+        {}, "EventBusSubscriber",
+        [subscriber_ptr]() { DeliverQueuedEvents(subscriber_ptr); }));
+  }
+
+  mutex_lock lock(mutex_);
+  auto subscribers = std::make_shared<SubscriberList>(*subscribers_);
+  subscribers->push_back(std::move(subscriber));
+  subscribers_ = std::move(subscribers);
   return subscription;
 }
 
 template <typename E>
-EventBus<E>::EventBus(const Options& options) : options_(options) {}
+EventBus<E>::EventBus(const Options& options)
+    : subscribers_(std::make_shared<SubscriberList>()), options_(options) {}
+
+template <typename E>
+EventBus<E>::~EventBus() {
+  // Subscriptions may outlive the bus, but their callbacks may not be invoked
+  // afterwards.
+  for (const std::shared_ptr<Subscriber>& subscriber : *subscribers_) {
+    StopSubscriber(subscriber.get());
+  }
+}
 
 template <typename E>
 std::shared_ptr<EventBus<E>> EventBus<E>::CreateEventBus(
@@ -196,22 +261,95 @@ std::shared_ptr<EventBus<E>> EventBus<E>::CreateEventBus(
 template <typename E>
 void EventBus<E>::Unsubscribe(
     const typename EventBus<E>::Subscription* subscription) {
-  mutex_lock lock(mutex_);
-  subscriptions_.erase(
-      std::remove_if(subscriptions_.begin(), subscriptions_.end(),
-                     [subscription](SubscriptionTuple s) {
-                       return s.subscription == subscription;
-                     }),
-      subscriptions_.end());
+  std::shared_ptr<Subscriber> unsubscribed;
+  {
+    mutex_lock lock(mutex_);
+    auto subscribers = std::make_shared<SubscriberList>();
+    subscribers->reserve(subscribers_->size());
+    for (const std::shared_ptr<Subscriber>& subscriber : *subscribers_) {
+      if (subscriber->subscription == subscription) {
+        unsubscribed = subscriber;
+      } else {
+        subscribers->push_back(subscriber);
+      }
+    }
+    subscribers_ = std::move(subscribers);
+  }
+  if (unsubscribed != nullptr) {
+    StopSubscriber(unsubscribed.get());
+  }
+}
+
+template <typename E>
+void EventBus<E>::StopSubscriber(Subscriber* const subscriber) {
+  {
+    mutex_lock lock(subscriber->mu);
+    subscriber->unsubscribed = true;
+    subscriber->queue.clear();
+    subscriber->queue_changed.notify_all();
+  }
+  // Joins the thread, if any.
+  subscriber->thread.reset();
+}
+
+template <typename E>
+void EventBus<E>::DeliverQueuedEvents(Subscriber* const subscriber) {
+  while (true) {
+    std::deque<QueuedEvent> events;
+    {
+      mutex_lock lock(subscriber->mu);
+      while (!subscriber->unsubscribed && subscriber->queue.empty()) {
+        subscriber->queue_changed.wait(lock);
+      }
+      if (subscriber->unsubscribed) {
+        return;
+      }
+      events.swap(subscriber->queue);
+      subscriber->queue_changed.notify_all();
+    }
+    for (const QueuedEvent& queued_event : events) {
+      {
+        mutex_lock lock(subscriber->mu);
+        if (subscriber->unsubscribed) {
+          return;
+        }
+      }
+      subscriber->callback(
+          {queued_event.event, queued_event.event_time_micros});
+    }
+  }
 }
 
 template <typename E>
 void EventBus<E>::Publish(const E& event) {
-  mutex_lock lock(mutex_);
+  std::shared_ptr<const SubscriberList> subscribers;
+  {
+    mutex_lock lock(mutex_);
+    subscribers = subscribers_;
+  }
   const uint64_t event_time = options_.env->NowMicros();
-  const EventAndTime event_and_time = {event, event_time};
-  for (const SubscriptionTuple& subscription : subscriptions_) {
-    subscription.callback(event_and_time);
+  if (!options_.async_publication) {
+    const EventAndTime event_and_time = {event, event_time};
+    for (const std::shared_ptr<Subscriber>& subscriber : *subscribers) {
+      mutex_lock lock(subscriber->mu);
+      if (!subscriber->unsubscribed) {
+        subscriber->callback(event_and_time);
+      }
+    }
+    return;
+  }
+  const size_t max_queued_events =
+      std::max<size_t>(options_.max_queued_events_per_subscriber, 1);
+  for (const std::shared_ptr<Subscriber>& subscriber : *subscribers) {
+    mutex_lock lock(subscriber->mu);
+    while (!subscriber->unsubscribed &&
+           subscriber->queue.size() >= max_queued_events) {
+      subscriber->queue_changed.wait(lock);
+    }
+    if (!subscriber->unsubscribed) {
+      subscriber->queue.push_back({event, event_time});
+      subscriber->queue_changed.notify_all();
+    }
   }
 }
 
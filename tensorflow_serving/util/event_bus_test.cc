@@ -16,9 +16,13 @@ limitations under the License.
 #include "tensorflow_serving/util/event_bus.h"
 
 #include <memory>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace serving {
@@ -127,6 +131,80 @@ TEST(EventBusTest, TestAutomaticUnsubscribing) {
   EXPECT_EQ(3, value_timestamp);
 }
 
+TEST(EventBusTest, AsyncPublication) {
+  IntEventBus::Options bus_options;
+  bus_options.async_publication = true;
+  bus_options.max_queued_events_per_subscriber = 100;
+  std::shared_ptr<IntEventBus> bus = IntEventBus::CreateEventBus(bus_options);
+
+  Notification release_subscriber;
+  mutex mu;
+  std::vector<int> values;
+  std::unique_ptr<IntEventBus::Subscription> subscription =
+      bus->Subscribe([&](const IntEventBus::EventAndTime& event_and_time) {
+        release_subscriber.WaitForNotification();
+        mutex_lock l(mu);
+        values.push_back(event_and_time.event);
+      });
+  int other_sum = 0;
+  std::unique_ptr<IntEventBus::Subscription> other_subscription =
+      bus->Subscribe([&](const IntEventBus::EventAndTime& event_and_time) {
+        other_sum += event_and_time.event;
+      });
+
+  // Publishing doesn't wait for the blocked subscriber.
+  std::vector<int> expected_values;
+  for (int i = 0; i < 50; ++i) {
+    bus->Publish(i);
+    expected_values.push_back(i);
+  }
+  release_subscriber.Notify();
+  while (true) {
+    {
+      mutex_lock l(mu);
+      if (values.size() == expected_values.size()) {
+        break;
+      }
+    }
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  {
+    mutex_lock l(mu);
+    EXPECT_EQ(expected_values, values);
+  }
+
+  // Once unsubscribed, a subscriber is no longer notified.
+  subscription.reset();
+  bus->Publish(100);
+  other_subscription.reset();
+  EXPECT_EQ(49 * 50 / 2 + 100, other_sum);
+  mutex_lock l(mu);
+  EXPECT_EQ(expected_values, values);
+}
+
+TEST(EventBusTest, AsyncPublicationBusDestroyedFirst) {
+  IntEventBus::Options bus_options;
+  bus_options.async_publication = true;
+  bus_options.max_queued_events_per_subscriber = 1;
+  std::shared_ptr<IntEventBus> bus = IntEventBus::CreateEventBus(bus_options);
+  Notification release_subscriber;
+  std::unique_ptr<IntEventBus::Subscription> subscription =
+      bus->Subscribe([&](const IntEventBus::EventAndTime& event_and_time) {
+        release_subscriber.WaitForNotification();
+      });
+  bus->Publish(1);
+  std::unique_ptr<Thread> release_thread(
+      Env::Default()->StartThread({}, "Release", [&]() {
+        Env::Default()->SleepForMicroseconds(10 * 1000);
+        release_subscriber.Notify();
+      }));
+  // Blocks while the queue is full, until the subscriber is released.
+  bus->Publish(2);
+  bus->Publish(3);
+  bus.reset();
+  subscription.reset();
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
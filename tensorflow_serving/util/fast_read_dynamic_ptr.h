@@ -21,6 +21,8 @@ limitations under the License.
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/platform/cpu_info.h"
@@ -303,6 +305,130 @@ class ShardedReadPtrs {
   std::unique_ptr<PaddedThreadSafeSharedPtr[]> shards_;
 };
 
+// This maintains one ReadPtr per reading thread, each with a reference count of
+// its own.  A reader only locks its own thread's slot, which only update()
+// contends for, so neither the mutex nor the reference count it touches is
+// ever shared with other readers.  Unlike with ShardedReadPtrs, many threads
+// running on one CPU don't share a shard, and a thread migrating between CPUs
+// doesn't drag a shard's cache line along with it.
+//
+// The cost is a slot per pair of reading thread and ThreadLocalReadPtrs, which
+// update() visits.  Slots are released when their thread exits, so this suits
+// pointers that are read by a bounded set of long-lived threads, such as RPC
+// server threads.
+template <typename T>
+class ThreadLocalReadPtrs {
+ public:
+  ThreadLocalReadPtrs() : registry_(std::make_shared<Registry>()) {}
+
+  std::shared_ptr<const T> get() const {
+    Slot* const slot = GetSlot();
+    mutex_lock lock(slot->mu);
+    return slot->p;
+  }
+
+  template <typename Factory>
+  void update(const Factory& f) {
+    mutex_lock registry_lock(registry_->mu);
+    registry_->current = f();
+    auto it = registry_->slots.begin();
+    while (it != registry_->slots.end()) {
+      std::shared_ptr<Slot> slot = it->lock();
+      if (slot == nullptr) {
+        // The slot's thread has exited.
+        it = registry_->slots.erase(it);
+        continue;
+      }
+      auto p = f();
+      {
+        mutex_lock lock(slot->mu);
+        slot->p.swap(p);
+      }
+      ++it;
+    }
+  }
+
+ private:
+  struct Slot {
+    mutex mu;
+    std::shared_ptr<const T> p;
+  };
+
+  // The state shared between a ThreadLocalReadPtrs and the threads reading it,
+  // which may outlive it.
+  struct Registry {
+    // Identifies the registry in the thread-local slot maps, without ever
+    // being reused.
+    const uint64 id = NextRegistryId();
+
+    mutex mu;
+    // The ReadPtr handed to slots created after the last update(), and the
+    // slots of all threads that have read this ReadPtrHolder.
+    std::shared_ptr<const T> current;
+    std::vector<std::weak_ptr<Slot>> slots;
+  };
+
+  static uint64 NextRegistryId() {
+    static std::atomic<uint64> next_id{0};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Returns the calling thread's slot, creating and registering it on the
+  // thread's first get().
+  Slot* GetSlot() const {
+    struct ThreadSlot {
+      std::weak_ptr<Registry> registry;
+      std::shared_ptr<Slot> slot;
+    };
+    thread_local std::unordered_map<uint64, ThreadSlot> thread_slots;
+    // Slots of destroyed ReadPtrHolders are pruned whenever the map has doubled
+    // in size since the last pruning.
+    thread_local size_t prune_size = 1;
+    // Most threads only read one ReadPtrHolder per type, so remember the last
+    // lookup.
+    thread_local uint64 last_id = ~uint64{0};
+    thread_local Slot* last_slot = nullptr;
+
+    if (last_id == registry_->id) {
+      return last_slot;
+    }
+    auto it = thread_slots.find(registry_->id);
+    if (it == thread_slots.end()) {
+      if (thread_slots.size() >= prune_size) {
+        for (auto prune_it = thread_slots.begin();
+             prune_it != thread_slots.end();) {
+          if (prune_it->second.registry.expired()) {
+            prune_it = thread_slots.erase(prune_it);
+          } else {
+            ++prune_it;
+          }
+        }
+        prune_size = 2 * std::max<size_t>(1, thread_slots.size());
+      }
+      auto slot = std::make_shared<Slot>();
+      {
+        mutex_lock lock(registry_->mu);
+        // Give the slot a reference count of its own, which keeps the current
+        // ReadPtr alive.
+        const std::shared_ptr<const T>& current = registry_->current;
+        if (current != nullptr) {
+          slot->p = std::shared_ptr<const T>(current.get(),
+                                             [current](const T*) {});
+        }
+        registry_->slots.push_back(slot);
+      }
+      it = thread_slots
+               .emplace(registry_->id, ThreadSlot{registry_, std::move(slot)})
+               .first;
+    }
+    last_id = registry_->id;
+    last_slot = it->second.slot.get();
+    return last_slot;
+  }
+
+  const std::shared_ptr<Registry> registry_;
+};
+
 }  // namespace internal_read_ptr_holder
 
 template <typename T, typename ReadPtrHolder>
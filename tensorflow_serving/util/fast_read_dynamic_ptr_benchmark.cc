@@ -56,19 +56,20 @@ namespace tensorflow {
 namespace serving {
 namespace {
 
-using FastReadIntPtr = FastReadDynamicPtr<int>;
-
 // The amount of time to sleep for the cases where we simulate doing work.
 constexpr absl::Duration kWorkSleepTime = absl::Milliseconds(5);
 
 // This class maintains all state for a benchmark and handles the concurrency
-// concerns around the concurrent read and update threads.
+// concerns around the concurrent read and update threads. FastReadIntPtr is the
+// FastReadDynamicPtr<int> being benchmarked, with one of the ReadPtrHolders.
 //
 // Example:
-//    BenchmarkState state(0 /* no updates */, false /* Don't do any work */);
+//    BenchmarkState<FastReadDynamicPtr<int>> state(0 /* no updates */,
+//                                                  false /* no work */);
 //    state.Setup();
 //    state.RunBenchmarkReadIterations(5 /* num_threads */, 42 /* iters */);
 //    state.Teardown();
+template <typename FastReadIntPtr>
 class BenchmarkState {
  public:
   BenchmarkState(const int update_micros, const bool do_work)
@@ -112,7 +113,8 @@ class BenchmarkState {
   bool do_work_;
 };
 
-void BenchmarkState::RunUpdateThread() {
+template <typename FastReadIntPtr>
+void BenchmarkState<FastReadIntPtr>::RunUpdateThread() {
   int current_value;
   {
     std::shared_ptr<const int> current = fast_ptr_.get();
@@ -122,7 +124,8 @@ void BenchmarkState::RunUpdateThread() {
   fast_ptr_.Update(std::move(tmp));
 }
 
-void BenchmarkState::Setup() {
+template <typename FastReadIntPtr>
+void BenchmarkState<FastReadIntPtr>::Setup() {
   // setup fast read int ptr:
   std::unique_ptr<int> i(new int(0));
   fast_ptr_.Update(std::move(i));
@@ -136,12 +139,14 @@ void BenchmarkState::Setup() {
   }
 }
 
-void BenchmarkState::Teardown() {
+template <typename FastReadIntPtr>
+void BenchmarkState<FastReadIntPtr>::Teardown() {
   // Destruct the update thread which blocks until it exits.
   update_thread_.reset();
 }
 
-void BenchmarkState::RunBenchmarkReads(int iters) {
+template <typename FastReadIntPtr>
+void BenchmarkState<FastReadIntPtr>::RunBenchmarkReads(int iters) {
   // Wait until all_read_threads_scheduled_ has been notified.
   all_read_threads_scheduled_.WaitForNotification();
 
@@ -155,7 +160,8 @@ void BenchmarkState::RunBenchmarkReads(int iters) {
   }
 }
 
-void BenchmarkState::RunBenchmarkReadIterations(
+template <typename FastReadIntPtr>
+void BenchmarkState<FastReadIntPtr>::RunBenchmarkReadIterations(
     int num_threads, ::testing::benchmark::State& state) {
   CHECK_GE(num_threads, 1) << " ****unexpected thread number";
   // To be compatible with the Google benchmark framework, the tensorflow new
@@ -196,10 +202,11 @@ void BenchmarkState::RunBenchmarkReadIterations(
   state.SetItemsProcessed(num_threads * kSubIters * state.iterations());
 }
 
+template <typename FastReadIntPtr = FastReadDynamicPtr<int>>
 void BenchmarkReadsAndUpdates(int update_micros, bool do_work,
                               ::testing::benchmark::State& state,
                               int num_threads) {
-  BenchmarkState bm_state(update_micros, do_work);
+  BenchmarkState<FastReadIntPtr> bm_state(update_micros, do_work);
   bm_state.Setup();
   bm_state.RunBenchmarkReadIterations(num_threads, state);
   bm_state.Teardown();
@@ -233,6 +240,27 @@ void BM_NoWork_FrequentUpdates_Reads(::testing::benchmark::State& state) {
   BenchmarkReadsAndUpdates(1000, false, state, num_threads);
 }
 
+// The same as the NoWork benchmarks above, with ReadPtrs reference counted per
+// reading thread rather than per CPU. Since each iteration reads from new
+// threads, these include the registration of their slots.
+using PerThreadFastReadIntPtr =
+    FastReadDynamicPtr<int, internal_read_ptr_holder::ThreadLocalReadPtrs<int>>;
+
+void BM_NoWork_NoUpdates_PerThread_Reads(::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  CHECK_GT(num_threads, 0);
+  BenchmarkReadsAndUpdates<PerThreadFastReadIntPtr>(0, false, state,
+                                                    num_threads);
+}
+
+void BM_NoWork_FrequentUpdates_PerThread_Reads(
+    ::testing::benchmark::State& state) {
+  const int num_threads = state.range(0);
+  CHECK_GT(num_threads, 0);
+  BenchmarkReadsAndUpdates<PerThreadFastReadIntPtr>(1000, false, state,
+                                                    num_threads);
+}
+
 // The benchmarking system by default uses cpu time to calculate items per
 // second, which would include time spent by all the threads on the cpu.
 // Instead of that we use real-time here so that we can see items/s increasing
@@ -278,6 +306,26 @@ BENCHMARK(BM_NoWork_FrequentUpdates_Reads)
     ->Arg(32)
     ->Arg(64);
 
+BENCHMARK(BM_NoWork_NoUpdates_PerThread_Reads)
+    ->UseRealTime()
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
+
+BENCHMARK(BM_NoWork_FrequentUpdates_PerThread_Reads)
+    ->UseRealTime()
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -32,7 +32,9 @@ class FastReadDynamicPtrTest : public ::testing::Test {};
 using FastReadDynamicPtrTypes = ::testing::Types<
     FastReadDynamicPtr<int>,
     FastReadDynamicPtr<int, internal_read_ptr_holder::ShardedReadPtrs<int>>,
-    FastReadDynamicPtr<int, internal_read_ptr_holder::SingleReadPtr<int>>>;
+    FastReadDynamicPtr<int, internal_read_ptr_holder::SingleReadPtr<int>>,
+    FastReadDynamicPtr<int,
+                       internal_read_ptr_holder::ThreadLocalReadPtrs<int>>>;
 
 TYPED_TEST_SUITE(FastReadDynamicPtrTest, FastReadDynamicPtrTypes);
 
@@ -116,6 +118,43 @@ TYPED_TEST(FastReadDynamicPtrTest, WaitsForReadPtrsBeforeDestruction) {
   fast_read_int = nullptr;
 }
 
+template <typename T>
+using ThreadLocalFastReadDynamicPtr =
+    FastReadDynamicPtr<T, internal_read_ptr_holder::ThreadLocalReadPtrs<T>>;
+
+TEST(ThreadLocalReadPtrsTest, ManyInstancesPerThread) {
+  std::vector<std::unique_ptr<ThreadLocalFastReadDynamicPtr<int>>> ptrs;
+  for (int i = 0; i < 10; ++i) {
+    ptrs.emplace_back(new ThreadLocalFastReadDynamicPtr<int>(
+        std::unique_ptr<int>(new int(i))));
+  }
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < ptrs.size(); ++i) {
+      EXPECT_EQ(i + round, *ptrs[i]->get());
+    }
+    // Replace the instances by new ones, so that the slots of the old ones have
+    // to be pruned.
+    for (int i = 0; i < ptrs.size(); ++i) {
+      ptrs[i].reset(new ThreadLocalFastReadDynamicPtr<int>(
+          std::unique_ptr<int>(new int(i + round + 1))));
+    }
+  }
+}
+
+TEST(ThreadLocalReadPtrsTest, ThreadsReadAfterUpdates) {
+  ThreadLocalFastReadDynamicPtr<int> fast_read_int;
+  for (int value = 0; value < 10; ++value) {
+    fast_read_int.Update(std::unique_ptr<int>(new int(value)));
+    // Both threads that already have a slot, and threads that get one now, see
+    // the update.
+    EXPECT_EQ(value, *fast_read_int.get());
+    std::unique_ptr<Thread> thread(
+        Env::Default()->StartThread({}, "Reader", [&fast_read_int, value] {
+          EXPECT_EQ(value, *fast_read_int.get());
+        }));
+  }
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
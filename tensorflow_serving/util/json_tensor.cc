@@ -17,30 +17,43 @@ limitations under the License.
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <limits>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <system_error>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "rapidjson/document.h"
 #include "rapidjson/error/en.h"
 #include "rapidjson/prettywriter.h"
+#include "rapidjson/reader.h"
 #include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/charconv.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
-#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/blocking_counter.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/protobuf/struct.pb.h"
 #include "tensorflow_serving/apis/input.pb.h"
 #include "tensorflow_serving/apis/model.pb.h"
 
@@ -88,6 +101,92 @@ constexpr char kBytesTensorNameSuffix[] = "_bytes";
 
 using RapidJsonWriter = rapidjson::PrettyWriter<rapidjson::StringBuffer>;
 
+// Sets the format options of 'writer'. Compact writers have none.
+template <typename OutputStream>
+void SetFormatOptions(rapidjson::PrettyWriter<OutputStream>* writer,
+                      rapidjson::PrettyFormatOptions options) {
+  writer->SetFormatOptions(options);
+}
+template <typename OutputStream>
+void SetFormatOptions(rapidjson::Writer<OutputStream>* writer,
+                      rapidjson::PrettyFormatOptions options) {}
+
+// A rapidjson output stream that passes what is written to a JsonChunkWriter
+// in chunks of (about) 'chunk_size' bytes.
+class ChunkedJsonStream {
+ public:
+  typedef char Ch;
+
+  ChunkedJsonStream(size_t chunk_size, const JsonChunkWriter& write_chunk)
+      : chunk_size_(std::max<size_t>(chunk_size, 1)),
+        write_chunk_(write_chunk) {
+    buffer_.reserve(chunk_size_);
+  }
+
+  void Put(Ch c) {
+    buffer_.push_back(c);
+    if (buffer_.size() >= chunk_size_) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    if (!buffer_.empty()) {
+      write_chunk_(buffer_);
+      buffer_.clear();
+    }
+  }
+
+ private:
+  const size_t chunk_size_;
+  const JsonChunkWriter& write_chunk_;
+  string buffer_;
+};
+
+// Where WriteJson() writes the JSON: to 'json', if set, or else to
+// 'write_chunk' in chunks of 'chunk_size' bytes.
+struct JsonSink {
+  string* json = nullptr;
+  size_t chunk_size = 0;
+  const JsonChunkWriter* write_chunk = nullptr;
+};
+
+// Writes JSON to 'stream' through 'write', which is called with a writer of
+// 'output_format' (i.e. a rapidjson::PrettyWriter or rapidjson::Writer).
+template <typename OutputStream, typename WriteFn>
+Status WriteJsonToStream(JsonOutputFormat output_format, WriteFn write,
+                         OutputStream* stream) {
+  if (output_format == JsonOutputFormat::kCompact) {
+    rapidjson::Writer<OutputStream> writer(*stream);
+    return write(&writer);
+  }
+  rapidjson::PrettyWriter<OutputStream> writer(*stream);
+  return write(&writer);
+}
+
+// As above, writing to 'sink'.
+template <typename WriteFn>
+Status WriteJson(JsonOutputFormat output_format, WriteFn write,
+                 const JsonSink& sink) {
+  if (sink.json == nullptr) {
+    ChunkedJsonStream stream(sink.chunk_size, *sink.write_chunk);
+    TF_RETURN_IF_ERROR(WriteJsonToStream(output_format, write, &stream));
+    stream.Flush();
+    return OkStatus();
+  }
+  rapidjson::StringBuffer buffer;
+  TF_RETURN_IF_ERROR(WriteJsonToStream(output_format, write, &buffer));
+  sink.json->assign(buffer.GetString(), buffer.GetSize());
+  return OkStatus();
+}
+
+template <typename WriteFn>
+Status WriteJson(JsonOutputFormat output_format, WriteFn write, string* json) {
+  JsonSink sink;
+  sink.json = json;
+  return WriteJson(output_format, write, sink);
+}
+
 string JsonTypeString(const rapidjson::Value& val) {
   switch (val.GetType()) {
     case rapidjson::kNullType:
@@ -107,18 +206,28 @@ string JsonTypeString(const rapidjson::Value& val) {
   }
 }
 
-template <typename dtype>
-bool StringToDecimal(const absl::string_view s, dtype* out) {
-  return absl::SimpleAtof(s, out);
-}
-
-template <>
-bool StringToDecimal(const absl::string_view s, double* out) {
-  return absl::SimpleAtod(s, out);
+// Writes the 'size' characters of 'decimal_str', a formatted number, which
+// has room for two more.
+template <typename Writer>
+bool WriteDecimalString(Writer* writer, char* decimal_str, size_t size) {
+  // Add trailing '.0' for whole numbers and those not in scientific notation.
+  // StrCat() formats numbers in six-digit (printf "%g"), numbers like 9000000
+  // and .00003 get written as 9e+06 and 3e-05 (scientific notation).
+  //
+  // Not adding '.0' can lead to lists containing mix of decimal and whole
+  // numbers -- making it difficult for consumers to pick the correct type to
+  // store these numbers (note, JSON does not have metadata to describe types.
+  // These are inferred from the tokens).
+  if (memchr(decimal_str, '.', size) == nullptr &&
+      memchr(decimal_str, 'e', size) == nullptr) {
+    decimal_str[size++] = '.';
+    decimal_str[size++] = '0';
+  }
+  return writer->RawValue(decimal_str, size, rapidjson::kNumberType);
 }
 
-template <typename dtype>
-bool WriteDecimal(RapidJsonWriter* writer, dtype val) {
+template <typename Writer, typename dtype>
+bool WriteDecimal(Writer* writer, dtype val) {
   static_assert(
       std::is_same<dtype, float>::value || std::is_same<dtype, double>::value,
       "Only floating-point value types are supported.");
@@ -130,39 +239,64 @@ bool WriteDecimal(RapidJsonWriter* writer, dtype val) {
   // To get around this, we write the string representation of the float number
   // as a raw JSON value (annotated as kNumberType, to ensure JSON does not
   // quote the string).
-  string decimal_str;
-  if (std::isfinite(val)) {
-    decimal_str = absl::StrCat(val);
+  //
+  // This runs for every element of floating-point outputs (e.g. embeddings),
+  // so formats into a stack buffer rather than allocating a string per value.
+  if (std::isnan(val)) {
+    return writer->RawValue("NaN", 3, rapidjson::kNumberType);
+  }
+  if (std::isinf(val)) {
+    return std::signbit(val)
+               ? writer->RawValue("-Infinity", 9, rapidjson::kNumberType)
+               : writer->RawValue("Infinity", 8, rapidjson::kNumberType);
+  }
 
-    // If converted number does not roundtrip, format using full precision.
-    dtype num;
-    if (!StringToDecimal(decimal_str, &num)) {
-      return false;
-    }
-    if (val != num) {
-      decimal_str = absl::StrFormat(
-          "%.*g", std::numeric_limits<dtype>::max_digits10, val);
-    }
+  // Large enough for max_digits10 significant digits, sign, exponent and the
+  // '.0' suffix below.
+  char decimal_str[32];
+  // Same six-digit (printf "%g") formatting as StrCat(), without the copy.
+  const absl::AlphaNum six_digits(val);
+  size_t size = six_digits.size();
+  memcpy(decimal_str, six_digits.data(), size);
+
+  // If converted number does not roundtrip, format using full precision.
+  dtype num;
+  const absl::from_chars_result result =
+      absl::from_chars(decimal_str, decimal_str + size, num);
+  if (result.ec != std::errc() || result.ptr != decimal_str + size) {
+    return false;
+  }
+  if (val != num) {
+    size = absl::SNPrintF(decimal_str, sizeof(decimal_str), "%.*g",
+                          std::numeric_limits<dtype>::max_digits10, val);
+  }
 
-    // Add trailing '.0' for whole numbers and those not in scientific notation.
-    // StrCat() formats numbers in six-digit (printf "%g"), numbers like 9000000
-    // and .00003 get written as 9e+06 and 3e-05 (scientific notation).
-    //
-    // Not adding '.0' can lead to lists containing mix of decimal and whole
-    // numbers -- making it difficult for consumers to pick the correct type to
-    // store these numbers (note, JSON does not have metadata to describe types.
-    // These are inferred from the tokens).
-    if (!absl::StrContains(decimal_str, '.') &&
-        !absl::StrContains(decimal_str, 'e')) {
-      absl::StrAppend(&decimal_str, ".0");
+  return WriteDecimalString(writer, decimal_str, size);
+}
+
+// Writes 'val', a DT_BFLOAT16 or DT_HALF value, with the fewest significant
+// digits that parse back to it at its precision: e.g. the bfloat16 nearest to
+// 0.1 as 0.1, not as the 0.100098 its float value would be written as.
+template <typename Writer, typename dtype>
+bool WriteReducedPrecisionDecimal(Writer* writer, dtype val) {
+  const float float_val = static_cast<float>(val);
+  if (!std::isfinite(float_val)) {
+    return WriteDecimal(writer, float_val);
+  }
+  char decimal_str[32];
+  size_t size = 0;
+  for (int digits = 1; digits <= std::numeric_limits<float>::max_digits10;
+       ++digits) {
+    size = absl::SNPrintF(decimal_str, sizeof(decimal_str), "%.*g", digits,
+                          float_val);
+    float num;
+    const absl::from_chars_result result =
+        absl::from_chars(decimal_str, decimal_str + size, num);
+    if (result.ec == std::errc() && static_cast<dtype>(num) == val) {
+      break;
     }
-  } else if (std::isnan(val)) {
-    decimal_str = "NaN";
-  } else if (std::isinf(val)) {
-    decimal_str = std::signbit(val) ? "-Infinity" : "Infinity";
   }
-  return writer->RawValue(decimal_str.c_str(), decimal_str.size(),
-                          rapidjson::kNumberType);
+  return WriteDecimalString(writer, decimal_str, size);
 }
 
 // Stringify JSON value (only for use in error reporting or debugging).
@@ -552,14 +686,127 @@ Status FillTensorMapFromInstancesList(
   return OkStatus();
 }
 
+// Whether 'tensor_info' is a sparse or a ragged tensor, sent in the
+// 'sparse_inputs' or 'ragged_inputs' of a PredictRequest.
+bool IsCompositeTensorInfo(const TensorInfo& tensor_info) {
+  return tensor_info.has_coo_sparse() || tensor_info.has_composite_tensor();
+}
+
+Status FillTensorFromJson(const rapidjson::Value& val, DataType dtype,
+                          TensorProto* tensor) {
+  tensor->set_dtype(dtype);
+  tensor->mutable_tensor_shape()->Clear();
+  GetDenseTensorShape(val, tensor->mutable_tensor_shape());
+  int unused_size = 0;
+  return FillTensorProto(val, 0 /* level */, dtype, &unused_size, tensor);
+}
+
+// Looks up the member 'key' of 'val', the object of the input 'name'.
+Status FindCompositeMember(const rapidjson::Value& val, const string& name,
+                           const char* key, const rapidjson::Value** member) {
+  auto itr = val.FindMember(key);
+  if (itr == val.MemberEnd()) {
+    return errors::InvalidArgument("Missing '", key,
+                                   "' in object of composite input: ", name);
+  }
+  *member = &itr->value;
+  return OkStatus();
+}
+
+// Fills the sparse or ragged input 'name' of 'request', of signature input
+// 'tensor_info', from 'val': an object of its components,
+//
+//   {"indices": [[0, 3], ...], "values": [...], "dense_shape": [2, 1000]}
+//
+// for sparse tensors, and
+//
+//   {"flat_values": [...], "nested_row_splits": [[0, 1, 3], ...]}
+//
+// for ragged tensors.
+Status FillCompositeInputFromJson(const rapidjson::Value& val,
+                                  const string& name,
+                                  const TensorInfo& tensor_info,
+                                  PredictRequest* request) {
+  if (!val.IsObject() || IsValBase64Object(val)) {
+    return errors::InvalidArgument("Expecting an object of components for "
+                                   "sparse or ragged input: ", name);
+  }
+  const auto& components = tensor_info.composite_tensor().components();
+  auto component_dtype = [&components](int i, DataType default_dtype) {
+    return i < components.size() && components[i].dtype() != DT_INVALID
+               ? components[i].dtype()
+               : default_dtype;
+  };
+  if (tensor_info.has_coo_sparse() ||
+      tensor_info.composite_tensor().type_spec().type_spec_class() ==
+          TypeSpecProto::SPARSE_TENSOR_SPEC) {
+    const rapidjson::Value *indices, *values, *dense_shape;
+    TF_RETURN_IF_ERROR(FindCompositeMember(val, name, "indices", &indices));
+    TF_RETURN_IF_ERROR(FindCompositeMember(val, name, "values", &values));
+    TF_RETURN_IF_ERROR(
+        FindCompositeMember(val, name, "dense_shape", &dense_shape));
+    SparseTensorProto& sparse = (*request->mutable_sparse_inputs())[name];
+    TF_RETURN_IF_ERROR(
+        FillTensorFromJson(*indices, DT_INT64, sparse.mutable_indices()));
+    TF_RETURN_IF_ERROR(FillTensorFromJson(
+        *values,
+        tensor_info.has_coo_sparse() ? tensor_info.dtype()
+                                     : component_dtype(1, DT_INVALID),
+        sparse.mutable_values()));
+    TF_RETURN_IF_ERROR(FillTensorFromJson(*dense_shape, DT_INT64,
+                                          sparse.mutable_dense_shape()));
+    // No values: the indices are an empty [0, rank] matrix.
+    if (sparse.indices().tensor_shape().dim_size() == 1 &&
+        sparse.indices().tensor_shape().dim(0).size() == 0) {
+      sparse.mutable_indices()->mutable_tensor_shape()->add_dim()->set_size(
+          sparse.dense_shape().tensor_shape().dim_size() > 0
+              ? sparse.dense_shape().tensor_shape().dim(0).size()
+              : 0);
+    }
+    return OkStatus();
+  }
+
+  const rapidjson::Value *flat_values, *nested_row_splits;
+  TF_RETURN_IF_ERROR(
+      FindCompositeMember(val, name, "flat_values", &flat_values));
+  TF_RETURN_IF_ERROR(
+      FindCompositeMember(val, name, "nested_row_splits", &nested_row_splits));
+  if (!nested_row_splits->IsArray()) {
+    return errors::InvalidArgument(
+        "Expecting 'nested_row_splits' of ragged input: ", name,
+        " to be a list of lists");
+  }
+  RaggedTensorProto& ragged = (*request->mutable_ragged_inputs())[name];
+  TF_RETURN_IF_ERROR(FillTensorFromJson(*flat_values,
+                                        component_dtype(0, DT_INVALID),
+                                        ragged.mutable_flat_values()));
+  int i = 1;
+  for (const auto& row_splits : nested_row_splits->GetArray()) {
+    TF_RETURN_IF_ERROR(FillTensorFromJson(row_splits,
+                                          component_dtype(i++, DT_INT64),
+                                          ragged.add_nested_row_splits()));
+  }
+  return OkStatus();
+}
+
 Status FillTensorMapFromInputsMap(
     const rapidjson::Value::MemberIterator& itr,
     const ::google::protobuf::Map<string, tensorflow::TensorInfo>& tensorinfo_map,
-    ::google::protobuf::Map<string, TensorProto>* tensor_map) {
+    PredictRequest* request) {
+  auto* tensor_map = request->mutable_inputs();
   // "inputs" key can hold a value that is one of the following:
   // - a list or base64 object (when there is only one named input)
   // - a object of key->value pairs (when there are multiple named inputs)
+  // - the object of the components of the single input (when it is a sparse
+  //   or ragged tensor)
   const rapidjson::Value& val = itr->value;
+  if (tensorinfo_map.size() == 1 &&
+      IsCompositeTensorInfo(tensorinfo_map.begin()->second) &&
+      (!val.IsObject() ||
+       !val.HasMember(tensorinfo_map.begin()->first.c_str()))) {
+    return FillCompositeInputFromJson(val, tensorinfo_map.begin()->first,
+                                      tensorinfo_map.begin()->second, request);
+  }
   if (!val.IsObject() || IsValBase64Object(val)) {
     if (tensorinfo_map.size() > 1) {
       return errors::InvalidArgument(
@@ -581,6 +828,11 @@ Status FillTensorMapFromInputsMap(
         return errors::InvalidArgument("Missing named input: ", name,
                                        " in 'inputs' object.");
       }
+      if (IsCompositeTensorInfo(kv.second)) {
+        TF_RETURN_IF_ERROR(
+            FillCompositeInputFromJson(item->value, name, kv.second, request));
+        continue;
+      }
       const auto dtype = kv.second.dtype();
       auto* tensor = &(*tensor_map)[name];
       tensor->set_dtype(dtype);
@@ -634,6 +886,13 @@ Status FillPredictRequestFromJson(
       return FormatError(doc, "No values in '",
         kPredictRequestInstancesKey, "' array");
     }
+    for (const auto& kv : tensorinfo_map) {
+      if (IsCompositeTensorInfo(kv.second)) {
+        return errors::InvalidArgument(
+            "Input: ", kv.first, " is a sparse or ragged tensor, which can "
+            "only be sent in the '", kPredictRequestInputsKey, "' format");
+      }
+    }
     *format = JsonPredictRequestFormat::kRow;
     return FillTensorMapFromInstancesList(itr_instances, tensorinfo_map,
                                           request->mutable_inputs());
@@ -644,14 +903,1205 @@ Status FillPredictRequestFromJson(
         kPredictRequestInstancesKey, "' keys to exist ");
     }
     *format = JsonPredictRequestFormat::kColumnar;
-    return FillTensorMapFromInputsMap(itr_inputs, tensorinfo_map,
-                                      request->mutable_inputs());
+    return FillTensorMapFromInputsMap(itr_inputs, tensorinfo_map, request);
   }
   return errors::InvalidArgument("Missing 'inputs' or 'instances' key");
 }
 
 namespace {
 
+// An event of a rapidjson Reader, i.e. of the SAX interface.
+struct JsonEvent {
+  enum Type {
+    kNull,
+    kBool,
+    kInt64,   // negative integers
+    kUint64,  // other integers
+    kDouble,
+    kString,
+    kKey,
+    kStartObject,
+    kEndObject,
+    kStartArray,
+    kEndArray,
+  };
+
+  Type type;
+  bool bool_val = false;
+  int64_t int_val = 0;
+  uint64_t uint_val = 0;
+  double double_val = 0;
+  absl::string_view string_val;
+
+  bool IsNumber() const {
+    return type == kInt64 || type == kUint64 || type == kDouble;
+  }
+  bool IsInt() const {
+    return (type == kInt64 && int_val >= std::numeric_limits<int32>::min() &&
+            int_val <= std::numeric_limits<int32>::max()) ||
+           (type == kUint64 && uint_val <= std::numeric_limits<int32>::max());
+  }
+  bool IsInt64() const {
+    return type == kInt64 ||
+           (type == kUint64 && uint_val <= std::numeric_limits<int64_t>::max());
+  }
+  bool IsUint() const {
+    return type == kUint64 && uint_val <= std::numeric_limits<uint32>::max();
+  }
+  bool IsUint64() const { return type == kUint64; }
+
+  // The number, converted to 'T' as rapidjson's GetFloat() etc. do.
+  template <typename T>
+  T As() const {
+    switch (type) {
+      case kInt64:
+        return static_cast<T>(int_val);
+      case kUint64:
+        return static_cast<T>(uint_val);
+      default:
+        return static_cast<T>(double_val);
+    }
+  }
+
+  // Stringify the event (only for use in error reporting).
+  string ToString() const {
+    switch (type) {
+      case kNull:
+        return "null";
+      case kBool:
+        return bool_val ? "true" : "false";
+      case kInt64:
+        return absl::StrCat(int_val);
+      case kUint64:
+        return absl::StrCat(uint_val);
+      case kDouble:
+        return absl::StrCat(double_val);
+      case kString:
+      case kKey:
+        return absl::StrCat("\"", string_val, "\"");
+      case kStartObject:
+      case kEndObject:
+        return "{...}";
+      case kStartArray:
+      case kEndArray:
+        return "[...]";
+    }
+  }
+
+  // Same as JsonTypeString().
+  string TypeString() const {
+    switch (type) {
+      case kNull:
+        return "Null";
+      case kBool:
+        return bool_val ? "True" : "False";
+      case kInt64:
+      case kUint64:
+      case kDouble:
+        return "Number";
+      case kString:
+      case kKey:
+        return "String";
+      case kStartObject:
+      case kEndObject:
+        return "Object";
+      case kStartArray:
+      case kEndArray:
+        return "Array";
+    }
+  }
+};
+
+Status TypeError(const JsonEvent& event, DataType dtype) {
+  return errors::InvalidArgument("JSON Value: ", event.ToString(),
+                                 " Type: ", event.TypeString(),
+                                 " is not of expected type: ",
+                                 DataTypeString(dtype));
+}
+
+// Decodes the values of one input tensor from JSON events, appending them as
+// they come: those of plain data types straight to the bytes of
+// 'tensor_content', and strings to 'string_val'. The shape is learned from
+// the first value decoded (i.e. the first instance, in row format), and the
+// later values are validated against it.
+class StreamingTensorDecoder {
+ public:
+  StreamingTensorDecoder(DataType dtype, TensorProto* tensor)
+      : dtype_(dtype),
+        tensor_(tensor),
+        content_(tensor->mutable_tensor_content()),
+        add_value_(AddValueFunction(dtype)) {}
+
+  // Whether no value is being decoded, i.e. the decoder isn't inside a list.
+  bool idle() const { return counts_.empty(); }
+
+  Status StartList() {
+    const int level = counts_.size();
+    // If list is nested deeper than rank, stop processing.
+    if (rank_ >= 0 && level >= rank_) {
+      if (shape_known_) {
+        return errors::InvalidArgument("Expecting shape ", ShapeString(),
+                                       " but got a list at level: ", level);
+      }
+      return errors::InvalidArgument("Encountered list at unexpected level: ",
+                                     level, " expected < ", rank_);
+    }
+    if (level > 0) counts_.back()++;
+    if (level == static_cast<int>(dims_.size())) dims_.push_back(-1);
+    counts_.push_back(0);
+    return OkStatus();
+  }
+
+  Status EndList() {
+    const int level = counts_.size() - 1;
+    const int64_t count = counts_.back();
+    counts_.pop_back();
+    if (dims_[level] < 0) {
+      // The first list at this level sets its dimension, and an empty one
+      // the rank.
+      dims_[level] = count;
+      if (count == 0 && rank_ < 0) rank_ = level + 1;
+    } else if (dims_[level] != count) {
+      if (shape_known_) {
+        return errors::InvalidArgument("Expecting shape ", ShapeString(),
+                                       " but got a list of size: ", count,
+                                       " at level: ", level);
+      }
+      return errors::InvalidArgument(
+          "Encountered list at unexpected size: ", count, " at level: ", level,
+          " expected size: ", dims_[level]);
+    }
+    if (counts_.empty()) shape_known_ = true;
+    return OkStatus();
+  }
+
+  // Adds a scalar value, at the current level.
+  Status AddValue(const JsonEvent& event) { return (this->*add_value_)(event); }
+
+  // Adds the base64 encoded string 'encoded', at the current level.
+  Status AddBase64(absl::string_view encoded) {
+    const auto value_string = [encoded]() {
+      return absl::StrCat("{\"", kBase64Key, "\":\"", encoded, "\"}");
+    };
+    TF_RETURN_IF_ERROR(StartValue(value_string));
+    if (dtype_ != DT_STRING) {
+      return errors::InvalidArgument("JSON Value: ", value_string(),
+                                     " Type: Object is not of expected type: ",
+                                     DataTypeString(dtype_));
+    }
+    if (!absl::Base64Unescape(encoded, tensor_->add_string_val())) {
+      return errors::InvalidArgument("Unable to base64 decode");
+    }
+    return OkStatus();
+  }
+
+  // Sets the type and shape of the tensor, once all values are decoded. The
+  // shape has a leading dimension of 'batch_size' unless it is negative.
+  void Finish(int64_t batch_size) {
+    tensor_->set_dtype(dtype_);
+    TensorShapeProto* shape = tensor_->mutable_tensor_shape();
+    shape->Clear();
+    if (batch_size >= 0) shape->add_dim()->set_size(batch_size);
+    for (const int64_t dim : dims_) shape->add_dim()->set_size(dim);
+  }
+
+  DataType dtype() const { return dtype_; }
+
+  // The last object of the request that had a value of this tensor, as
+  // numbered by the caller.
+  int64_t last_object = -1;
+
+ private:
+  using AddValueFn = Status (StreamingTensorDecoder::*)(const JsonEvent&);
+
+  // Returns the AddValue() of 'dtype'. Decoding columns of millions of values
+  // is dominated by these, so each type has its own, with its checks and
+  // conversion resolved at compile time instead of per value.
+  static AddValueFn AddValueFunction(DataType dtype) {
+    switch (dtype) {
+      case DT_FLOAT:
+        return &StreamingTensorDecoder::AddValueOfType<DT_FLOAT>;
+      case DT_DOUBLE:
+        return &StreamingTensorDecoder::AddValueOfType<DT_DOUBLE>;
+      case DT_INT32:
+        return &StreamingTensorDecoder::AddValueOfType<DT_INT32>;
+      case DT_INT16:
+        return &StreamingTensorDecoder::AddValueOfType<DT_INT16>;
+      case DT_INT8:
+        return &StreamingTensorDecoder::AddValueOfType<DT_INT8>;
+      case DT_UINT8:
+        return &StreamingTensorDecoder::AddValueOfType<DT_UINT8>;
+      case DT_STRING:
+        return &StreamingTensorDecoder::AddValueOfType<DT_STRING>;
+      case DT_INT64:
+        return &StreamingTensorDecoder::AddValueOfType<DT_INT64>;
+      case DT_BOOL:
+        return &StreamingTensorDecoder::AddValueOfType<DT_BOOL>;
+      case DT_UINT32:
+        return &StreamingTensorDecoder::AddValueOfType<DT_UINT32>;
+      case DT_UINT64:
+        return &StreamingTensorDecoder::AddValueOfType<DT_UINT64>;
+      default:
+        return &StreamingTensorDecoder::AddUnsupportedValue;
+    }
+  }
+
+  // Whether 'event' is a JSON value that converts to 'dtype'.
+  template <DataType dtype>
+  static bool HasType(const JsonEvent& event) {
+    if constexpr (dtype == DT_FLOAT || dtype == DT_DOUBLE) {
+      return event.IsNumber();
+    } else if constexpr (dtype == DT_INT32 || dtype == DT_INT16 ||
+                         dtype == DT_INT8 || dtype == DT_UINT8) {
+      return event.IsInt();
+    } else if constexpr (dtype == DT_INT64) {
+      return event.IsInt64();
+    } else if constexpr (dtype == DT_UINT32) {
+      return event.IsUint();
+    } else if constexpr (dtype == DT_UINT64) {
+      return event.IsUint64();
+    } else if constexpr (dtype == DT_BOOL) {
+      return event.type == JsonEvent::kBool;
+    } else {
+      return event.type == JsonEvent::kString;
+    }
+  }
+
+  template <DataType dtype>
+  Status AddValueOfType(const JsonEvent& event) {
+    TF_RETURN_IF_ERROR(StartValue([&event]() { return event.ToString(); }));
+    if (!HasType<dtype>(event)) return TypeError(event, dtype);
+    if constexpr (dtype == DT_STRING) {
+      tensor_->add_string_val(event.string_val.data(), event.string_val.size());
+    } else if constexpr (dtype == DT_BOOL) {
+      Append(event.bool_val);
+    } else {
+      Append(event.As<typename EnumToDataType<dtype>::Type>());
+    }
+    return OkStatus();
+  }
+
+  Status AddUnsupportedValue(const JsonEvent& event) {
+    TF_RETURN_IF_ERROR(StartValue([&event]() { return event.ToString(); }));
+    return errors::Unimplemented("Conversion of JSON Value: ",
+                                 event.ToString(),
+                                 " to type: ", DataTypeString(dtype_));
+  }
+
+  // Counts a value at the current level. 'value_string' prints the value,
+  // and is only called for errors, so the common case formats nothing.
+  template <typename ValueString>
+  Status StartValue(const ValueString& value_string) {
+    const int level = counts_.size();
+    // All values of a (dense) tensor are at same (leaf) level equal to its
+    // rank, which the first one sets.
+    if (rank_ < 0) rank_ = level;
+    if (level != rank_) {
+      if (shape_known_) {
+        return errors::InvalidArgument("Expecting shape ", ShapeString(),
+                                       " but got JSON Value: ", value_string(),
+                                       " at level: ", level);
+      }
+      return errors::InvalidArgument(
+          "JSON Value: ", value_string(),
+          " found at incorrect level: ", level + 1,
+          " in the JSON DOM. Expected at level: ", rank_);
+    }
+    if (level > 0) {
+      counts_.back()++;
+    } else {
+      shape_known_ = true;
+    }
+    return OkStatus();
+  }
+
+  // Prints the shape of the values in [x, y, z] format.
+  string ShapeString() const {
+    return absl::StrCat("[", absl::StrJoin(dims_, ","), "]");
+  }
+
+  template <typename T>
+  void Append(T value) {
+    content_->append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  const DataType dtype_;
+  TensorProto* const tensor_;
+  string* const content_;
+  const AddValueFn add_value_;
+
+  // Unknown (-1) until the first value, or empty list, at the leaf level.
+  int rank_ = -1;
+  // Whether a whole value has been decoded, which fixes the shape.
+  bool shape_known_ = false;
+  // The dimensions of the value, each unknown (-1) until the first list at
+  // its level ends.
+  std::vector<int64_t> dims_;
+  // The number of elements so far of each list being decoded.
+  std::vector<int64_t> counts_;
+};
+
+// Fills a PredictRequest from the events of a rapidjson Reader, as
+// FillPredictRequestFromJson() does from the DOM, in a single pass.
+//
+// Requests in a few rare forms are declined, i.e. parsing stops with
+// declined() true, leaving them to FillPredictRequestFromJson():
+// "signature_name" after "instances" or "inputs", whose input types depend
+// on it, and objects whose first key is "b64" but that are not base64
+// strings.
+class PredictRequestJsonHandler {
+ public:
+  using GetTensorInfoMap = std::function<Status(
+      const string&, ::google::protobuf::Map<string, TensorInfo>*)>;
+
+  PredictRequestJsonHandler(const GetTensorInfoMap& get_tensorinfo_map,
+                            PredictRequest* request,
+                            JsonPredictRequestFormat* format)
+      : get_tensorinfo_map_(get_tensorinfo_map),
+        request_(request),
+        format_(format) {}
+
+  // The status of the request once parsing stops; the error if the handler
+  // stopped it.
+  const Status& status() const { return status_; }
+  bool declined() const { return declined_; }
+
+  // Sets the shapes of the tensors, once the whole request is parsed.
+  Status Finish();
+
+  // The rapidjson Handler interface.
+  bool Null() { return Handle({JsonEvent::kNull}); }
+  bool Bool(bool b) {
+    JsonEvent event{JsonEvent::kBool};
+    event.bool_val = b;
+    return Handle(event);
+  }
+  bool Int(int i) { return Int64(i); }
+  bool Uint(unsigned u) { return Uint64(u); }
+  bool Int64(int64_t i) {
+    JsonEvent event{JsonEvent::kInt64};
+    event.int_val = i;
+    return Handle(event);
+  }
+  bool Uint64(uint64_t u) {
+    JsonEvent event{JsonEvent::kUint64};
+    event.uint_val = u;
+    return Handle(event);
+  }
+  bool Double(double d) {
+    JsonEvent event{JsonEvent::kDouble};
+    event.double_val = d;
+    return Handle(event);
+  }
+  bool RawNumber(const char* str, rapidjson::SizeType length, bool copy) {
+    return Decline();  // only with kParseNumbersAsStringsFlag
+  }
+  bool String(const char* str, rapidjson::SizeType length, bool copy) {
+    JsonEvent event{JsonEvent::kString};
+    event.string_val = absl::string_view(str, length);
+    return Handle(event);
+  }
+  bool StartObject() { return Handle({JsonEvent::kStartObject}); }
+  bool Key(const char* str, rapidjson::SizeType length, bool copy) {
+    JsonEvent event{JsonEvent::kKey};
+    event.string_val = absl::string_view(str, length);
+    return Handle(event);
+  }
+  bool EndObject(rapidjson::SizeType member_count) {
+    return Handle({JsonEvent::kEndObject});
+  }
+  bool StartArray() { return Handle({JsonEvent::kStartArray}); }
+  bool EndArray(rapidjson::SizeType element_count) {
+    return Handle({JsonEvent::kEndArray});
+  }
+
+ private:
+  enum class State {
+    kDocument,            // expecting the top-level object
+    kTopLevelKey,         // expecting a key of the top-level object, or its end
+    kSignatureName,       // expecting the value of "signature_name"
+    kInstances,           // expecting the "instances" list
+    kInstance,            // expecting an element of "instances", or its end
+    kInstanceKey,         // expecting a key of an instance object, or its end
+    kInputs,              // expecting the value of "inputs"
+    kInputsKey,           // expecting a key of the "inputs" object, or its end
+    kObjectFirstKey,      // in an object that may be a base64 string
+    kMaybeBase64Value,    // after its "b64" key
+    kMaybeBase64End,      // after its string
+    kTensor,              // decoding a tensor value
+    kBase64Key,           // in a base64 string within a tensor value
+    kBase64Value,         // after its "b64" key
+    kBase64End,           // after its string
+    kSkip,                // skipping an ignored value
+    kDone,
+  };
+
+  bool Handle(const JsonEvent& event) {
+    Status status = HandleEvent(event);
+    if (!status.ok()) {
+      status_ = status;
+      return false;
+    }
+    return !declined_;
+  }
+
+  bool Decline() {
+    declined_ = true;
+    return false;
+  }
+
+  Status HandleEvent(const JsonEvent& event);
+  Status HandleTopLevelKey(const JsonEvent& event);
+  Status HandleInstance(const JsonEvent& event);
+  Status HandleInstanceKey(const JsonEvent& event);
+  Status HandleInputs(const JsonEvent& event);
+  Status HandleInputsKey(const JsonEvent& event);
+  Status HandleObjectFirstKey(const JsonEvent& event);
+  Status HandleTensor(const JsonEvent& event);
+  Status HandleSkip(const JsonEvent& event);
+
+  // Creates the decoders of the inputs of the signature.
+  Status StartInputs();
+
+  // Starts an element of "instances", or the value of "inputs", which is a
+  // value or list of the single input, or else an object of named inputs.
+  Status StartPlainValue();
+  Status StartNamedObject();
+
+  // Has 'decoder' decode the value that the next event starts, and moves to
+  // 'next_state' when it is done.
+  void StartTensorValue(StreamingTensorDecoder* decoder, State next_state);
+  void EndTensorValue();
+
+  // Returns the decoder of the named input 'name', or null if none.
+  StreamingTensorDecoder* FindDecoder(absl::string_view name);
+
+  const GetTensorInfoMap& get_tensorinfo_map_;
+  PredictRequest* const request_;
+  JsonPredictRequestFormat* const format_;
+
+  Status status_;
+  bool declined_ = false;
+
+  State state_ = State::kDocument;
+
+  // The decoders of the inputs of the signature, once either "instances" or
+  // "inputs" is reached.
+  std::map<string, std::unique_ptr<StreamingTensorDecoder>, std::less<>>
+      decoders_;
+
+  // The context of an object in kObjectFirstKey: kInstance or kInputs.
+  State object_context_ = State::kDocument;
+  // The string of an object of kMaybeBase64End, or of kBase64End.
+  string base64_string_;
+
+  // The number of elements of "instances" so far, and whether they are
+  // objects (of named inputs), as the first one sets.
+  int64_t num_instances_ = 0;
+  bool instances_are_objects_ = false;
+
+  // The number of objects of named inputs so far, and the number of inputs
+  // seen in the last one.
+  int64_t num_objects_ = 0;
+  int num_object_inputs_ = 0;
+
+  // The tensor value being decoded, and the state after it.
+  StreamingTensorDecoder* decoder_ = nullptr;
+  State next_state_ = State::kDocument;
+
+  // The depth of the value being skipped, and the state after it.
+  int skip_depth_ = 0;
+  State after_skip_ = State::kDocument;
+};
+
+Status PredictRequestJsonHandler::HandleEvent(const JsonEvent& event) {
+  switch (state_) {
+    case State::kDocument:
+      // We expect top level JSON to be an object.
+      if (event.type != JsonEvent::kStartObject) {
+        return errors::InvalidArgument("JSON Value: ", event.ToString(),
+                                       " Is not object");
+      }
+      state_ = State::kTopLevelKey;
+      return OkStatus();
+
+    case State::kTopLevelKey:
+      return HandleTopLevelKey(event);
+
+    case State::kSignatureName:
+      if (event.type != JsonEvent::kString) {
+        return errors::InvalidArgument(
+            "JSON Value: ", event.ToString(),
+            " not formatted correctly. 'signature_name' key must be a string "
+            "value.");
+      }
+      if (!decoders_.empty()) {
+        Decline();
+        return OkStatus();
+      }
+      request_->mutable_model_spec()->set_signature_name(
+          event.string_val.data(), event.string_val.size());
+      state_ = State::kTopLevelKey;
+      return OkStatus();
+
+    case State::kInstances:
+      if (event.type != JsonEvent::kStartArray) {
+        return errors::InvalidArgument("JSON Value: ", event.ToString(),
+                                       " Expecting '",
+                                       kPredictRequestInstancesKey,
+                                       "' to be an list/array");
+      }
+      state_ = State::kInstance;
+      return OkStatus();
+
+    case State::kInstance:
+      return HandleInstance(event);
+
+    case State::kInstanceKey:
+      return HandleInstanceKey(event);
+
+    case State::kInputs:
+      return HandleInputs(event);
+
+    case State::kInputsKey:
+      return HandleInputsKey(event);
+
+    case State::kObjectFirstKey:
+      return HandleObjectFirstKey(event);
+
+    case State::kMaybeBase64Value:
+      if (event.type != JsonEvent::kString) {
+        Decline();
+        return OkStatus();
+      }
+      base64_string_.assign(event.string_val.data(), event.string_val.size());
+      state_ = State::kMaybeBase64End;
+      return OkStatus();
+
+    case State::kMaybeBase64End:
+      if (event.type != JsonEvent::kEndObject) {
+        Decline();
+        return OkStatus();
+      }
+      // The object is a base64 string: a value of the single input.
+      TF_RETURN_IF_ERROR(StartPlainValue());
+      TF_RETURN_IF_ERROR(decoder_->AddBase64(base64_string_));
+      EndTensorValue();
+      return OkStatus();
+
+    case State::kTensor:
+      return HandleTensor(event);
+
+    case State::kBase64Key:
+      if (event.type != JsonEvent::kKey || event.string_val != kBase64Key) {
+        return errors::InvalidArgument(
+            "JSON Value: ", event.ToString(),
+            " not formatted correctly for base64 data");
+      }
+      state_ = State::kBase64Value;
+      return OkStatus();
+
+    case State::kBase64Value:
+      if (event.type != JsonEvent::kString) {
+        return errors::InvalidArgument(
+            "JSON Value: ", event.ToString(),
+            " not formatted correctly for base64 data");
+      }
+      base64_string_.assign(event.string_val.data(), event.string_val.size());
+      state_ = State::kBase64End;
+      return OkStatus();
+
+    case State::kBase64End:
+      if (event.type != JsonEvent::kEndObject) {
+        return errors::InvalidArgument(
+            "JSON Value: ", event.ToString(),
+            " not formatted correctly for base64 data");
+      }
+      TF_RETURN_IF_ERROR(decoder_->AddBase64(base64_string_));
+      state_ = State::kTensor;
+      if (decoder_->idle()) EndTensorValue();
+      return OkStatus();
+
+    case State::kSkip:
+      return HandleSkip(event);
+
+    case State::kDone:
+      break;
+  }
+  return errors::Internal("Unexpected JSON value: ", event.ToString());
+}
+
+Status PredictRequestJsonHandler::HandleTopLevelKey(const JsonEvent& event) {
+  if (event.type == JsonEvent::kEndObject) {
+    state_ = State::kDone;
+    return OkStatus();
+  }
+  const absl::string_view key = event.string_val;
+  if (key == kPredictRequestSignatureKey) {
+    state_ = State::kSignatureName;
+    return OkStatus();
+  }
+  if (key == kPredictRequestInstancesKey || key == kPredictRequestInputsKey) {
+    if (!decoders_.empty()) {
+      return errors::InvalidArgument(
+          "Not formatted correctly expecting only one of '",
+          kPredictRequestInputsKey, "' or '", kPredictRequestInstancesKey,
+          "' keys to exist ");
+    }
+    TF_RETURN_IF_ERROR(StartInputs());
+    if (key == kPredictRequestInstancesKey) {
+      *format_ = JsonPredictRequestFormat::kRow;
+      state_ = State::kInstances;
+    } else {
+      *format_ = JsonPredictRequestFormat::kColumnar;
+      state_ = State::kInputs;
+    }
+    return OkStatus();
+  }
+  // Other keys are ignored.
+  skip_depth_ = 0;
+  after_skip_ = State::kTopLevelKey;
+  state_ = State::kSkip;
+  return OkStatus();
+}
+
+Status PredictRequestJsonHandler::StartInputs() {
+  ::google::protobuf::Map<string, TensorInfo> tensorinfo_map;
+  const string& signame = request_->model_spec().signature_name();
+  TF_RETURN_IF_ERROR(get_tensorinfo_map_(signame, &tensorinfo_map));
+  if (tensorinfo_map.empty()) {
+    return errors::InvalidArgument("Failed to get input map for signature: ",
+                                   signame.empty() ? "DEFAULT" : signame);
+  }
+  for (const auto& kv : tensorinfo_map) {
+    if (IsCompositeTensorInfo(kv.second)) {
+      Decline();
+      return OkStatus();
+    }
+  }
+  auto* inputs = request_->mutable_inputs();
+  inputs->clear();
+  for (const auto& kv : tensorinfo_map) {
+    decoders_.emplace(kv.first, absl::make_unique<StreamingTensorDecoder>(
+                                    kv.second.dtype(), &(*inputs)[kv.first]));
+  }
+  return OkStatus();
+}
+
+Status PredictRequestJsonHandler::HandleInstance(const JsonEvent& event) {
+  switch (event.type) {
+    case JsonEvent::kEndArray:
+      if (num_instances_ == 0) {
+        return errors::InvalidArgument("No values in '",
+                                       kPredictRequestInstancesKey,
+                                       "' array");
+      }
+      state_ = State::kTopLevelKey;
+      return OkStatus();
+
+    case JsonEvent::kStartObject:
+      object_context_ = State::kInstance;
+      state_ = State::kObjectFirstKey;
+      return OkStatus();
+
+    default:
+      TF_RETURN_IF_ERROR(StartPlainValue());
+      return HandleTensor(event);
+  }
+}
+
+Status PredictRequestJsonHandler::HandleInputs(const JsonEvent& event) {
+  if (event.type == JsonEvent::kStartObject) {
+    object_context_ = State::kInputs;
+    state_ = State::kObjectFirstKey;
+    return OkStatus();
+  }
+  TF_RETURN_IF_ERROR(StartPlainValue());
+  return HandleTensor(event);
+}
+
+Status PredictRequestJsonHandler::HandleObjectFirstKey(
+    const JsonEvent& event) {
+  if (event.type == JsonEvent::kKey && event.string_val == kBase64Key) {
+    state_ = State::kMaybeBase64Value;
+    return OkStatus();
+  }
+  TF_RETURN_IF_ERROR(StartNamedObject());
+  return HandleEvent(event);
+}
+
+Status PredictRequestJsonHandler::StartPlainValue() {
+  const State context =
+      state_ == State::kMaybeBase64End ? object_context_ : state_;
+  const bool is_instance = context == State::kInstance;
+  if (is_instance && num_instances_ > 0 && instances_are_objects_) {
+    return errors::InvalidArgument("Expecting object but got list at item ",
+                                   num_instances_, " of input list");
+  }
+  if (decoders_.size() > 1) {
+    return errors::InvalidArgument(
+        is_instance ? "instances is a plain list, but expecting list of "
+                      "objects as multiple input tensors required as per "
+                      "tensorinfo_map"
+                    : "inputs is a plain value/list, but expecting an object "
+                      "as multiple input tensors required as per "
+                      "tensorinfo_map");
+  }
+  StartTensorValue(decoders_.begin()->second.get(),
+                   is_instance ? State::kInstance : State::kTopLevelKey);
+  return OkStatus();
+}
+
+Status PredictRequestJsonHandler::StartNamedObject() {
+  if (object_context_ == State::kInstance) {
+    if (num_instances_ > 0 && !instances_are_objects_) {
+      return errors::InvalidArgument(
+          "Expecting value/list but got object at item ", num_instances_,
+          " of input list");
+    }
+    instances_are_objects_ = true;
+    state_ = State::kInstanceKey;
+  } else {
+    state_ = State::kInputsKey;
+  }
+  ++num_objects_;
+  num_object_inputs_ = 0;
+  return OkStatus();
+}
+
+StreamingTensorDecoder* PredictRequestJsonHandler::FindDecoder(
+    absl::string_view name) {
+  auto it = decoders_.find(name);
+  return it == decoders_.end() ? nullptr : it->second.get();
+}
+
+Status PredictRequestJsonHandler::HandleInstanceKey(const JsonEvent& event) {
+  if (event.type == JsonEvent::kEndObject) {
+    if (num_object_inputs_ != static_cast<int>(decoders_.size())) {
+      std::vector<absl::string_view> input_names;
+      for (const auto& kv : decoders_) input_names.push_back(kv.first);
+      return errors::InvalidArgument(
+          "Failed to process element: ", num_instances_,
+          " of 'instances' list. JSON object keys must be equal to: ",
+          absl::StrJoin(input_names, ","));
+    }
+    ++num_instances_;
+    state_ = State::kInstance;
+    return OkStatus();
+  }
+  StreamingTensorDecoder* decoder = FindDecoder(event.string_val);
+  if (decoder == nullptr) {
+    return errors::InvalidArgument("JSON object: does not have named input: ",
+                                   event.string_val);
+  }
+  if (decoder->last_object == num_objects_) {
+    return errors::InvalidArgument("Failed to process element: ",
+                                   num_instances_, " of 'instances' list. "
+                                   "Repeated key: ", event.string_val);
+  }
+  decoder->last_object = num_objects_;
+  ++num_object_inputs_;
+  StartTensorValue(decoder, State::kInstanceKey);
+  return OkStatus();
+}
+
+Status PredictRequestJsonHandler::HandleInputsKey(const JsonEvent& event) {
+  if (event.type == JsonEvent::kEndObject) {
+    for (const auto& kv : decoders_) {
+      if (kv.second->last_object != num_objects_) {
+        return errors::InvalidArgument("Missing named input: ", kv.first,
+                                       " in 'inputs' object.");
+      }
+    }
+    state_ = State::kTopLevelKey;
+    return OkStatus();
+  }
+  StreamingTensorDecoder* decoder = FindDecoder(event.string_val);
+  if (decoder == nullptr) {
+    // Other keys are ignored.
+    skip_depth_ = 0;
+    after_skip_ = State::kInputsKey;
+    state_ = State::kSkip;
+    return OkStatus();
+  }
+  if (decoder->last_object == num_objects_) {
+    return errors::InvalidArgument("Repeated named input: ", event.string_val,
+                                   " in 'inputs' object.");
+  }
+  decoder->last_object = num_objects_;
+  StartTensorValue(decoder, State::kInputsKey);
+  return OkStatus();
+}
+
+void PredictRequestJsonHandler::StartTensorValue(
+    StreamingTensorDecoder* decoder, State next_state) {
+  decoder_ = decoder;
+  next_state_ = next_state;
+  state_ = State::kTensor;
+}
+
+void PredictRequestJsonHandler::EndTensorValue() {
+  if (next_state_ == State::kInstance) ++num_instances_;
+  state_ = next_state_;
+}
+
+Status PredictRequestJsonHandler::HandleTensor(const JsonEvent& event) {
+  switch (event.type) {
+    case JsonEvent::kStartArray:
+      TF_RETURN_IF_ERROR(decoder_->StartList());
+      break;
+
+    case JsonEvent::kEndArray:
+      TF_RETURN_IF_ERROR(decoder_->EndList());
+      break;
+
+    case JsonEvent::kStartObject:
+      // Only base64 strings are objects within tensors.
+      if (decoder_->dtype() != DT_STRING) {
+        return TypeError(event, decoder_->dtype());
+      }
+      state_ = State::kBase64Key;
+      return OkStatus();
+
+    case JsonEvent::kKey:
+    case JsonEvent::kEndObject:
+      return errors::Internal("Unexpected JSON value: ", event.ToString());
+
+    default:
+      TF_RETURN_IF_ERROR(decoder_->AddValue(event));
+  }
+  if (decoder_->idle()) EndTensorValue();
+  return OkStatus();
+}
+
+Status PredictRequestJsonHandler::HandleSkip(const JsonEvent& event) {
+  switch (event.type) {
+    case JsonEvent::kStartObject:
+    case JsonEvent::kStartArray:
+      ++skip_depth_;
+      break;
+    case JsonEvent::kEndObject:
+    case JsonEvent::kEndArray:
+      --skip_depth_;
+      break;
+    case JsonEvent::kKey:
+      return OkStatus();
+    default:
+      break;
+  }
+  if (skip_depth_ == 0) state_ = after_skip_;
+  return OkStatus();
+}
+
+Status PredictRequestJsonHandler::Finish() {
+  if (decoders_.empty()) {
+    return errors::InvalidArgument("Missing 'inputs' or 'instances' key");
+  }
+  const bool is_row = *format_ == JsonPredictRequestFormat::kRow;
+  for (const auto& kv : decoders_) {
+    kv.second->Finish(is_row ? num_instances_ : -1);
+  }
+  return OkStatus();
+}
+
+}  // namespace
+
+Status FillPredictRequestFromJsonStreaming(
+    const absl::string_view json,
+    const std::function<tensorflow::Status(
+        const string&, ::google::protobuf::Map<string, tensorflow::TensorInfo>*)>&
+        get_tensorinfo_map,
+    PredictRequest* request, JsonPredictRequestFormat* format) {
+  *format = JsonPredictRequestFormat::kInvalid;
+  if (json.empty()) {
+    return errors::InvalidArgument("JSON Parse error: The document is empty");
+  }
+
+  PredictRequestJsonHandler handler(get_tensorinfo_map, request, format);
+  {
+    // `json` may not be null-terminated (read from a mem buffer).
+    rapidjson::MemoryStream ms(json.data(), json.size());
+    rapidjson::EncodedInputStream<rapidjson::UTF8<>, rapidjson::MemoryStream>
+        jsonstream(ms);
+    // The iterative parser doesn't recurse on nested lists.
+    rapidjson::Reader reader;
+    reader.Parse<rapidjson::kParseNanAndInfFlag |
+                 rapidjson::kParseIterativeFlag>(jsonstream, handler);
+    if (reader.HasParseError() && !handler.declined()) {
+      if (!handler.status().ok()) {
+        *format = JsonPredictRequestFormat::kInvalid;
+        return handler.status();
+      }
+      return errors::InvalidArgument(
+          "JSON Parse error: ",
+          rapidjson::GetParseError_En(reader.GetParseErrorCode()),
+          " at offset: ", reader.GetErrorOffset());
+    }
+  }
+  if (!handler.declined()) {
+    return handler.Finish();
+  }
+
+  // Leave the rare forms the handler declines to the DOM.
+  request->mutable_model_spec()->clear_signature_name();
+  request->clear_inputs();
+  request->clear_sparse_inputs();
+  request->clear_ragged_inputs();
+  return FillPredictRequestFromJson(json, get_tensorinfo_map, request, format);
+}
+
+namespace {
+
+// "instances" are decoded in parallel only in chunks of at least this many
+// bytes, to pay for scheduling the chunks and concatenating their tensors.
+constexpr size_t kMinParallelChunkBytes = 256 << 10;
+
+absl::string_view StripJsonWhitespace(absl::string_view s) {
+  const size_t begin = s.find_first_not_of(" \t\n\r");
+  if (begin == absl::string_view::npos) {
+    return absl::string_view();
+  }
+  return s.substr(begin, s.find_last_not_of(" \t\n\r") + 1 - begin);
+}
+
+// Splits the elements of the top-level "instances" list of `json` without
+// decoding them, and sets `list` to the list, brackets included, and
+// `signature_name` to the (raw, unescaped) top-level "signature_name" string,
+// if any. Returns false if `json` doesn't have a single, non-empty such list,
+// or if it's malformed.
+bool SplitInstances(absl::string_view json, absl::string_view* list,
+                    std::vector<absl::string_view>* elements,
+                    absl::string_view* signature_name) {
+  std::vector<char> open_brackets;
+  // The last key of the top-level object, and whether its value is next.
+  absl::string_view key;
+  bool in_value = false;
+  const char* list_begin = nullptr;
+  bool in_list = false;
+  size_t element_begin = 0;
+  auto add_element = [&](size_t end) {
+    elements->push_back(
+        StripJsonWhitespace(json.substr(element_begin, end - element_begin)));
+    return !elements->back().empty();
+  };
+
+  for (size_t i = 0; i < json.size(); ++i) {
+    const char c = json[i];
+    switch (c) {
+      case '"': {
+        const size_t string_begin = i + 1;
+        for (++i; i < json.size() && json[i] != '"'; ++i) {
+          if (json[i] == '\\') ++i;
+        }
+        if (i >= json.size()) return false;
+        if (open_brackets.size() == 1) {
+          const absl::string_view s =
+              json.substr(string_begin, i - string_begin);
+          if (!in_value) {
+            key = s;
+          } else if (key == kPredictRequestSignatureKey) {
+            *signature_name = s;
+          }
+        }
+        break;
+      }
+      case '{':
+      case '[':
+        if (c == '[' && open_brackets.size() == 1 && in_value &&
+            key == kPredictRequestInstancesKey) {
+          if (list_begin != nullptr) return false;
+          list_begin = json.data() + i;
+          in_list = true;
+          element_begin = i + 1;
+        }
+        open_brackets.push_back(c);
+        break;
+      case '}':
+      case ']':
+        if (open_brackets.empty() ||
+            open_brackets.back() != (c == '}' ? '{' : '[')) {
+          return false;
+        }
+        open_brackets.pop_back();
+        if (in_list && open_brackets.size() == 1) {
+          if (!add_element(i)) return false;
+          in_list = false;
+          *list =
+              absl::string_view(list_begin, json.data() + i + 1 - list_begin);
+        }
+        break;
+      case ':':
+        if (open_brackets.size() == 1) in_value = true;
+        break;
+      case ',':
+        if (open_brackets.size() == 1) in_value = false;
+        if (in_list && open_brackets.size() == 2) {
+          if (!add_element(i)) return false;
+          element_begin = i + 1;
+        }
+        break;
+    }
+  }
+  return list_begin != nullptr && !in_list && open_brackets.empty();
+}
+
+// The form of an element of "instances", which decides how it's decoded.
+enum class InstanceForm { kObject, kBase64, kValue };
+
+InstanceForm GetInstanceForm(absl::string_view element) {
+  if (element[0] != '{') {
+    return InstanceForm::kValue;
+  }
+  return absl::StartsWith(StripJsonWhitespace(element.substr(1)), "\"b64\"")
+             ? InstanceForm::kBase64
+             : InstanceForm::kObject;
+}
+
+// Decodes `json` into `request` in chunks of its "instances" on
+// `thread_pool`, and concatenates their tensors. Returns false, leaving
+// `request` in an unspecified state, if `json` is not worth decoding in
+// parallel, or if the chunks don't decode to the same request as the whole
+// would (e.g. since it's malformed).
+bool FillPredictRequestFromJsonChunks(
+    const absl::string_view json,
+    const std::function<tensorflow::Status(
+        const string&, ::google::protobuf::Map<string, tensorflow::TensorInfo>*)>&
+        get_tensorinfo_map,
+    thread::ThreadPool* thread_pool, PredictRequest* request,
+    JsonPredictRequestFormat* format) {
+  const size_t max_chunks =
+      std::min<size_t>(thread_pool->NumThreads() + 1,
+                       json.size() / kMinParallelChunkBytes);
+  absl::string_view list;
+  std::vector<absl::string_view> instances;
+  absl::string_view signature_name;
+  if (max_chunks < 2 ||
+      !SplitInstances(json, &list, &instances, &signature_name) ||
+      absl::StrContains(signature_name, '\\')) {
+    return false;
+  }
+  const size_t num_chunks =
+      std::min({max_chunks, instances.size(),
+                list.size() / kMinParallelChunkBytes});
+  if (num_chunks < 2) {
+    return false;
+  }
+
+  // The index of the first instance of each chunk, balanced by bytes, and
+  // the end of the last.
+  std::vector<size_t> chunk_begins = {0};
+  for (size_t i = 1; i < instances.size() && chunk_begins.size() < num_chunks;
+       ++i) {
+    if (instances[i].data() - list.data() >=
+        list.size() * chunk_begins.size() / num_chunks) {
+      chunk_begins.push_back(i);
+    }
+  }
+  chunk_begins.push_back(instances.size());
+  auto chunk_instances = [&](size_t chunk) {
+    const absl::string_view first = instances[chunk_begins[chunk]];
+    const absl::string_view last = instances[chunk_begins[chunk + 1] - 1];
+    return absl::string_view(first.data(),
+                             last.data() + last.size() - first.data());
+  };
+
+  // Each chunk must decode the same way as the first, so mixed forms (which
+  // are errors, but for plain and base64 values) are left to a single pass.
+  const InstanceForm form = GetInstanceForm(instances[0]);
+  for (size_t chunk = 1; chunk + 1 < chunk_begins.size(); ++chunk) {
+    if (GetInstanceForm(instances[chunk_begins[chunk]]) != form) {
+      return false;
+    }
+  }
+
+  // The first chunk is decoded in the rest of the document, on this thread,
+  // and the others on their own.
+  const size_t list_offset = list.data() - json.data();
+  const string first_json =
+      absl::StrCat(json.substr(0, list_offset), "[", chunk_instances(0), "]",
+                   json.substr(list_offset + list.size()));
+  const string chunk_signature_name(signature_name);
+  const auto chunk_get_tensorinfo_map =
+      [&](const string& unused_signature_name,
+          ::google::protobuf::Map<string, tensorflow::TensorInfo>* map) {
+        return get_tensorinfo_map(chunk_signature_name, map);
+      };
+  const size_t num_other_chunks = chunk_begins.size() - 2;
+  std::vector<PredictRequest> chunk_requests(num_other_chunks);
+  std::vector<Status> chunk_statuses(num_other_chunks);
+  BlockingCounter counter(num_other_chunks);
+  for (size_t i = 0; i < num_other_chunks; ++i) {
+    thread_pool->Schedule([&, i]() {
+      const string chunk_json =
+          absl::StrCat("{\"", kPredictRequestInstancesKey, "\":[",
+                       chunk_instances(i + 1), "]}");
+      JsonPredictRequestFormat chunk_format;
+      chunk_statuses[i] = FillPredictRequestFromJsonStreaming(
+          chunk_json, chunk_get_tensorinfo_map, &chunk_requests[i],
+          &chunk_format);
+      counter.DecrementCount();
+    });
+  }
+  const Status status = FillPredictRequestFromJsonStreaming(
+      first_json, get_tensorinfo_map, request, format);
+  counter.Wait();
+  if (!status.ok() || *format != JsonPredictRequestFormat::kRow ||
+      request->model_spec().signature_name() != chunk_signature_name) {
+    return false;
+  }
+  for (const Status& chunk_status : chunk_statuses) {
+    if (!chunk_status.ok()) return false;
+  }
+
+  for (auto& kv : *request->mutable_inputs()) {
+    std::vector<Tensor> parts(num_other_chunks + 1);
+    if (!parts[0].FromProto(kv.second)) return false;
+    for (size_t i = 0; i < num_other_chunks; ++i) {
+      const auto it = chunk_requests[i].inputs().find(kv.first);
+      if (it == chunk_requests[i].inputs().end() ||
+          !parts[i + 1].FromProto(it->second) ||
+          parts[i + 1].dims() != parts[0].dims()) {
+        return false;
+      }
+      for (int d = 1; d < parts[0].dims(); ++d) {
+        if (parts[i + 1].dim_size(d) != parts[0].dim_size(d)) return false;
+      }
+    }
+    Tensor tensor;
+    if (!tensor::Concat(parts, &tensor).ok()) return false;
+    kv.second.Clear();
+    if (tensor.dtype() == DT_STRING) {
+      tensor.AsProtoField(&kv.second);
+    } else {
+      tensor.AsProtoTensorContent(&kv.second);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status FillPredictRequestFromJsonInParallel(
+    const absl::string_view json,
+    const std::function<tensorflow::Status(
+        const string&, ::google::protobuf::Map<string, tensorflow::TensorInfo>*)>&
+        get_tensorinfo_map,
+    thread::ThreadPool* thread_pool, PredictRequest* request,
+    JsonPredictRequestFormat* format) {
+  if (thread_pool != nullptr &&
+      FillPredictRequestFromJsonChunks(json, get_tensorinfo_map, thread_pool,
+                                       request, format)) {
+    return OkStatus();
+  }
+  // Including to report the errors of any chunk, as a single pass does.
+  request->mutable_model_spec()->clear_signature_name();
+  request->clear_inputs();
+  return FillPredictRequestFromJsonStreaming(json, get_tensorinfo_map, request,
+                                             format);
+}
+
+namespace {
+
 bool IsFeatureOfKind(const Feature& feature, Feature::KindCase kind) {
   return feature.kind_case() == Feature::KIND_NOT_SET ||
          feature.kind_case() == kind;
@@ -831,8 +2281,9 @@ bool IsNamedTensorBytes(const string& name, const TensorProto& tensor) {
 }
 
 
+template <typename Writer>
 Status AddSingleValueAndAdvance(const TensorProto& tensor, bool string_as_bytes,
-                                RapidJsonWriter* writer, int* offset) {
+                                Writer* writer, int* offset) {
   bool success = false;
   switch (tensor.dtype()) {
     case DT_FLOAT:
@@ -843,6 +2294,19 @@ Status AddSingleValueAndAdvance(const TensorProto& tensor, bool string_as_bytes,
       success = WriteDecimal(writer, tensor.double_val(*offset));
       break;
 
+    // The values are the bits of the 16-bit floats (see Tensor::AsProtoField).
+    case DT_BFLOAT16:
+      success = WriteReducedPrecisionDecimal(
+          writer, Eigen::numext::bit_cast<bfloat16>(
+                      static_cast<uint16_t>(tensor.half_val(*offset))));
+      break;
+
+    case DT_HALF:
+      success = WriteReducedPrecisionDecimal(
+          writer, Eigen::numext::bit_cast<Eigen::half>(
+                      static_cast<uint16_t>(tensor.half_val(*offset))));
+      break;
+
     case DT_INT32:
     case DT_INT16:
     case DT_INT8:
@@ -895,8 +2359,9 @@ Status AddSingleValueAndAdvance(const TensorProto& tensor, bool string_as_bytes,
   return OkStatus();
 }
 
+template <typename Writer>
 Status AddTensorValues(const TensorProto& tensor, bool string_as_bytes, int dim,
-                       RapidJsonWriter* writer, int* offset) {
+                       Writer* writer, int* offset) {
   // Scalar values dont need to be enclosed in an array.
   // Just write the (single) value out and return.
   if (dim > tensor.tensor_shape().dim_size() - 1) {
@@ -919,7 +2384,8 @@ Status AddTensorValues(const TensorProto& tensor, bool string_as_bytes, int dim,
 }
 
 Status MakeRowFormatJsonFromTensors(
-    const ::google::protobuf::Map<string, TensorProto>& tensor_map, string* json) {
+    const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+    JsonOutputFormat output_format, const JsonSink& sink) {
   // Verify if each named tensor has same first dimension. The first dimension
   // is the batchsize and for an output to be consistent, all named tensors must
   // be batched to the same size.
@@ -944,59 +2410,65 @@ Status MakeRowFormatJsonFromTensors(
     offset_map.insert({name, 0});
   }
 
-  rapidjson::StringBuffer buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-  writer.StartObject();
-  writer.Key(kPredictResponsePredictionsKey);
-  writer.StartArray();
-  const bool elements_are_objects = tensor_map.size() > 1;
-  for (int item = 0; item < batch_size; item++) {
-    if (elements_are_objects) writer.StartObject();
-    writer.SetFormatOptions(rapidjson::kFormatSingleLineArray);
-    for (const auto& kv : tensor_map) {
-      const auto& name = kv.first;
-      const auto& tensor = kv.second;
-      if (elements_are_objects) writer.Key(name.c_str());
-      TF_RETURN_IF_ERROR(AddTensorValues(
-          tensor, IsNamedTensorBytes(name, tensor),
-          1 /* dimension, we start from 1st as 0th is batch dimension */,
-          &writer, &offset_map.at(name)));
-    }
-    writer.SetFormatOptions(rapidjson::kFormatDefault);
-    if (elements_are_objects) writer.EndObject();
-  }
-  writer.EndArray();
-  writer.EndObject();
-  json->assign(buffer.GetString());
-  return OkStatus();
+  return WriteJson(
+      output_format,
+      [&](auto* writer) -> Status {
+        writer->StartObject();
+        writer->Key(kPredictResponsePredictionsKey);
+        writer->StartArray();
+        const bool elements_are_objects = tensor_map.size() > 1;
+        for (int item = 0; item < batch_size; item++) {
+          if (elements_are_objects) writer->StartObject();
+          SetFormatOptions(writer, rapidjson::kFormatSingleLineArray);
+          for (const auto& kv : tensor_map) {
+            const auto& name = kv.first;
+            const auto& tensor = kv.second;
+            if (elements_are_objects) writer->Key(name.c_str());
+            TF_RETURN_IF_ERROR(AddTensorValues(
+                tensor, IsNamedTensorBytes(name, tensor),
+                1 /* dimension, we start from 1st as 0th is batch dimension */,
+                writer, &offset_map.at(name)));
+          }
+          SetFormatOptions(writer, rapidjson::kFormatDefault);
+          if (elements_are_objects) writer->EndObject();
+        }
+        writer->EndArray();
+        writer->EndObject();
+        return OkStatus();
+      },
+      sink);
 }
 
 Status MakeColumnarFormatJsonFromTensors(
-    const ::google::protobuf::Map<string, TensorProto>& tensor_map, string* json) {
-  rapidjson::StringBuffer buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-  writer.StartObject();
-  writer.Key(kPredictResponseOutputsKey);
-  const bool elements_are_objects = tensor_map.size() > 1;
-  if (elements_are_objects) writer.StartObject();
-  for (const auto& kv : tensor_map) {
-    const auto& name = kv.first;
-    const auto& tensor = kv.second;
-    if (elements_are_objects) writer.Key(name.c_str());
-    int unused_offset = 0;
-    TF_RETURN_IF_ERROR(AddTensorValues(tensor, IsNamedTensorBytes(name, tensor),
-                                       0, &writer, &unused_offset));
-  }
-  if (elements_are_objects) writer.EndObject();
-  writer.EndObject();
-  json->assign(buffer.GetString());
-  return OkStatus();
+    const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+    JsonOutputFormat output_format, const JsonSink& sink) {
+  return WriteJson(
+      output_format,
+      [&](auto* writer) -> Status {
+        writer->StartObject();
+        writer->Key(kPredictResponseOutputsKey);
+        const bool elements_are_objects = tensor_map.size() > 1;
+        if (elements_are_objects) writer->StartObject();
+        for (const auto& kv : tensor_map) {
+          const auto& name = kv.first;
+          const auto& tensor = kv.second;
+          if (elements_are_objects) writer->Key(name.c_str());
+          int unused_offset = 0;
+          TF_RETURN_IF_ERROR(AddTensorValues(tensor,
+                                             IsNamedTensorBytes(name, tensor),
+                                             0, writer, &unused_offset));
+        }
+        if (elements_are_objects) writer->EndObject();
+        writer->EndObject();
+        return OkStatus();
+      },
+      sink);
 }
 
-}  // namespace
-
-Status MakeJsonFromTensors(const ::google::protobuf::Map<string, TensorProto>& tensor_map,
-                           JsonPredictRequestFormat format, string* json) {
+Status MakeJsonFromTensorsToSink(
+    const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+    JsonPredictRequestFormat format, JsonOutputFormat output_format,
+    const JsonSink& sink) {
   if (tensor_map.empty()) {
     return errors::InvalidArgument("Cannot convert empty tensor map to JSON");
   }
@@ -1005,71 +2477,116 @@ Status MakeJsonFromTensors(const ::google::protobuf::Map<string, TensorProto>& t
     case JsonPredictRequestFormat::kInvalid:
       return errors::InvalidArgument("Invalid request format");
     case JsonPredictRequestFormat::kRow:
-      return MakeRowFormatJsonFromTensors(tensor_map, json);
+      return MakeRowFormatJsonFromTensors(tensor_map, output_format, sink);
     case JsonPredictRequestFormat::kColumnar:
-      return MakeColumnarFormatJsonFromTensors(tensor_map, json);
+      return MakeColumnarFormatJsonFromTensors(tensor_map, output_format,
+                                               sink);
   }
 }
 
+}  // namespace
+
+Status MakeJsonFromTensors(const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+                           JsonPredictRequestFormat format, string* json) {
+  return MakeJsonFromTensors(tensor_map, format, JsonOutputFormat::kPretty,
+                             json);
+}
+
+Status MakeJsonFromTensors(const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+                           JsonPredictRequestFormat format,
+                           JsonOutputFormat output_format, string* json) {
+  JsonSink sink;
+  sink.json = json;
+  return MakeJsonFromTensorsToSink(tensor_map, format, output_format, sink);
+}
+
+Status MakeJsonFromTensors(const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+                           JsonPredictRequestFormat format,
+                           JsonOutputFormat output_format, size_t chunk_size,
+                           const JsonChunkWriter& write_chunk) {
+  JsonSink sink;
+  sink.chunk_size = chunk_size;
+  sink.write_chunk = &write_chunk;
+  return MakeJsonFromTensorsToSink(tensor_map, format, output_format, sink);
+}
+
+Status MakeJsonFromClassificationResult(const ClassificationResult& result,
+                                        string* json) {
+  return MakeJsonFromClassificationResult(result, JsonOutputFormat::kPretty,
+                                          json);
+}
+
 Status MakeJsonFromClassificationResult(const ClassificationResult& result,
+                                        JsonOutputFormat output_format,
                                         string* json) {
   if (result.classifications_size() == 0) {
     return errors::InvalidArgument(
         "Cannot convert empty ClassificationResults to JSON");
   }
 
-  rapidjson::StringBuffer buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-  writer.StartObject();
-  writer.Key(kClassifyRegressResponseKey);
-  writer.StartArray();
-  for (const auto& classifications : result.classifications()) {
-    writer.SetFormatOptions(rapidjson::kFormatSingleLineArray);
-    writer.StartArray();
-    for (const auto& elem : classifications.classes()) {
-      writer.StartArray();
-      if (!writer.String(elem.label().c_str(), elem.label().size())) {
-        return errors::Internal("Failed to write class label: ", elem.label(),
-                                " to output JSON buffer");
-      }
-      if (!WriteDecimal(&writer, elem.score())) {
-        return errors::Internal("Failed to write class score : ", elem.score(),
-                                " to output JSON buffer");
-      }
-      writer.EndArray();
-    }
-    writer.EndArray();
-    writer.SetFormatOptions(rapidjson::kFormatDefault);
-  }
-  writer.EndArray();
-  writer.EndObject();
-  json->assign(buffer.GetString());
-  return OkStatus();
+  return WriteJson(
+      output_format,
+      [&result](auto* writer) -> Status {
+        writer->StartObject();
+        writer->Key(kClassifyRegressResponseKey);
+        writer->StartArray();
+        for (const auto& classifications : result.classifications()) {
+          SetFormatOptions(writer, rapidjson::kFormatSingleLineArray);
+          writer->StartArray();
+          for (const auto& elem : classifications.classes()) {
+            writer->StartArray();
+            if (!writer->String(elem.label().c_str(), elem.label().size())) {
+              return errors::Internal("Failed to write class label: ",
+                                      elem.label(), " to output JSON buffer");
+            }
+            if (!WriteDecimal(writer, elem.score())) {
+              return errors::Internal("Failed to write class score : ",
+                                      elem.score(), " to output JSON buffer");
+            }
+            writer->EndArray();
+          }
+          writer->EndArray();
+          SetFormatOptions(writer, rapidjson::kFormatDefault);
+        }
+        writer->EndArray();
+        writer->EndObject();
+        return OkStatus();
+      },
+      json);
+}
+
+Status MakeJsonFromRegressionResult(const RegressionResult& result,
+                                    string* json) {
+  return MakeJsonFromRegressionResult(result, JsonOutputFormat::kPretty, json);
 }
 
 Status MakeJsonFromRegressionResult(const RegressionResult& result,
+                                    JsonOutputFormat output_format,
                                     string* json) {
   if (result.regressions_size() == 0) {
     return errors::InvalidArgument(
         "Cannot convert empty RegressionResults to JSON");
   }
 
-  rapidjson::StringBuffer buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
-  writer.StartObject();
-  writer.Key(kClassifyRegressResponseKey);
-  writer.SetFormatOptions(rapidjson::kFormatSingleLineArray);
-  writer.StartArray();
-  for (const auto& regression : result.regressions()) {
-    if (!WriteDecimal(&writer, regression.value())) {
-      return errors::Internal("Failed to write regression value : ",
-                              regression.value(), " to output JSON buffer");
-    }
-  }
-  writer.EndArray();
-  writer.EndObject();
-  json->assign(buffer.GetString());
-  return OkStatus();
+  return WriteJson(
+      output_format,
+      [&result](auto* writer) -> Status {
+        writer->StartObject();
+        writer->Key(kClassifyRegressResponseKey);
+        SetFormatOptions(writer, rapidjson::kFormatSingleLineArray);
+        writer->StartArray();
+        for (const auto& regression : result.regressions()) {
+          if (!WriteDecimal(writer, regression.value())) {
+            return errors::Internal("Failed to write regression value : ",
+                                    regression.value(),
+                                    " to output JSON buffer");
+          }
+        }
+        writer->EndArray();
+        writer->EndObject();
+        return OkStatus();
+      },
+      json);
 }
 
 void MakeJsonFromStatus(const tensorflow::Status& status, string* json) {
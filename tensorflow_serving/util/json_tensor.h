@@ -22,6 +22,7 @@ limitations under the License.
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tensorflow/core/protobuf/meta_graph.pb.h"
 #include "tensorflow_serving/apis/classification.pb.h"
 #include "tensorflow_serving/apis/predict.pb.h"
@@ -142,6 +143,18 @@ enum class JsonPredictRequestFormat {
 //     "sensor": [[1, 2], [3, 4], [4, 5], [6, 8]]
 //   }
 // }
+//
+// Inputs that are sparse or ragged tensors in the signature are only accepted
+// in this format, as objects of their components, and are added to
+// `PredictRequest.sparse_inputs` and `PredictRequest.ragged_inputs`:
+//
+// {
+//   "inputs": {
+//     "clicks": {"indices": [[0, 3], [1, 999]], "values": [1, 2],
+//                "dense_shape": [2, 1000]},
+//     "tokens": {"flat_values": [7, 8, 9], "nested_row_splits": [[0, 1, 3]]}
+//   }
+// }
 tensorflow::Status FillPredictRequestFromJson(
     const absl::string_view json,
     const std::function<tensorflow::Status(
@@ -149,6 +162,42 @@ tensorflow::Status FillPredictRequestFromJson(
         get_tensorinfo_map,
     PredictRequest* request, JsonPredictRequestFormat* format);
 
+// Same as FillPredictRequestFromJson(), but parses `json` in a single pass
+// without building a DOM, and writes the values of tensors of plain data types
+// (e.g. DT_FLOAT, DT_INT64 and DT_BOOL) straight into the bytes of their
+// `tensor_content`, rather than into the repeated `*_val` fields. The predict
+// path aliases large `tensor_content`s rather than copying them, so this
+// saves the DOM and both per-value conversions for large requests. String
+// tensors are still filled in `string_val`.
+//
+// The shape of each tensor is taken from its first value (the first element
+// of "instances", in row format) and the later values are validated against
+// it, with the same errors as above. The few forms of request the single pass
+// cannot decode, e.g. "signature_name" placed after the tensors whose types
+// depend on it, are decoded by FillPredictRequestFromJson() instead.
+tensorflow::Status FillPredictRequestFromJsonStreaming(
+    const absl::string_view json,
+    const std::function<tensorflow::Status(
+        const string&, ::google::protobuf::Map<string, tensorflow::TensorInfo>*)>&
+        get_tensorinfo_map,
+    PredictRequest* request, JsonPredictRequestFormat* format);
+
+// Same as FillPredictRequestFromJsonStreaming(), but splits a large row format
+// "instances" list into chunks that are decoded concurrently on `thread_pool`,
+// and concatenates the decoded tensors. Requests that are too small to gain
+// from it, `thread_pool` being null, and requests that fail to decode in
+// chunks are decoded in a single pass, so the result and any error are the
+// same as FillPredictRequestFromJsonStreaming()'s.
+//
+// `get_tensorinfo_map` may be called concurrently, so must be thread-safe.
+tensorflow::Status FillPredictRequestFromJsonInParallel(
+    const absl::string_view json,
+    const std::function<tensorflow::Status(
+        const string&, ::google::protobuf::Map<string, tensorflow::TensorInfo>*)>&
+        get_tensorinfo_map,
+    thread::ThreadPool* thread_pool, PredictRequest* request,
+    JsonPredictRequestFormat* format);
+
 // Fills ClassificationRequest proto from a JSON object.
 //
 // `json` string is parsed to create `Example` protos and added to
@@ -260,6 +309,32 @@ tensorflow::Status MakeJsonFromTensors(
     const ::google::protobuf::Map<string, tensorflow::TensorProto>& tensor_map,
     JsonPredictRequestFormat format, string* json);
 
+// Whitespace of the JSON written by the MakeJsonFrom*() functions below.
+enum class JsonOutputFormat {
+  // Indented as shown in the comments of the functions.
+  kPretty,
+  // Without any whitespace between tokens. Smaller, and cheaper to write and
+  // to parse.
+  kCompact,
+};
+
+// As above, writing `json` in `output_format`.
+tensorflow::Status MakeJsonFromTensors(
+    const ::google::protobuf::Map<string, tensorflow::TensorProto>& tensor_map,
+    JsonPredictRequestFormat format, JsonOutputFormat output_format,
+    string* json);
+
+// Receives the chunks of a JSON document, in order.
+using JsonChunkWriter = std::function<void(absl::string_view chunk)>;
+
+// As above, but passes the JSON to `write_chunk` in chunks of about
+// `chunk_size` bytes as it is written, rather than building it whole. On
+// error, the chunks passed so far are the start of an incomplete document.
+tensorflow::Status MakeJsonFromTensors(
+    const ::google::protobuf::Map<string, tensorflow::TensorProto>& tensor_map,
+    JsonPredictRequestFormat format, JsonOutputFormat output_format,
+    size_t chunk_size, const JsonChunkWriter& write_chunk);
+
 // Make JSON object from ClassificationResult proto.
 //
 // The output JSON object is formatted as follows:
@@ -283,6 +358,11 @@ tensorflow::Status MakeJsonFromTensors(
 tensorflow::Status MakeJsonFromClassificationResult(
     const ClassificationResult& result, string* json);
 
+// As above, writing `json` in `output_format`.
+tensorflow::Status MakeJsonFromClassificationResult(
+    const ClassificationResult& result, JsonOutputFormat output_format,
+    string* json);
+
 // Make JSON object from RegressionResult proto.
 //
 // The output JSON object is formatted as follows:
@@ -297,6 +377,11 @@ tensorflow::Status MakeJsonFromClassificationResult(
 tensorflow::Status MakeJsonFromRegressionResult(const RegressionResult& result,
                                                 string* json);
 
+// As above, writing `json` in `output_format`.
+tensorflow::Status MakeJsonFromRegressionResult(const RegressionResult& result,
+                                                JsonOutputFormat output_format,
+                                                string* json);
+
 // Make JSON object from Status.
 //
 // The output JSON object is formatted as follows:
@@ -0,0 +1,292 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of the JSON codec of the REST API: decoding predict requests,
+// in a DOM and in a single pass, and encoding predict responses, and the
+// classify and regress requests and results.
+//
+// Predict benchmarks take the arguments (dtype, rank, format, elements):
+// 'dtype' is a TensorDtype below, 'rank' the rank of the tensor (its inner
+// dimensions are of size 4), 'format' 0 for row format and 1 for columnar,
+// and 'elements' the number of values of the tensor.
+//
+// Run with:
+// bazel run -c opt \
+// tensorflow_serving/util:json_tensor_benchmark -- --benchmarks=.
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/protobuf/meta_graph.pb.h"
+#include "tensorflow_serving/apis/classification.pb.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+#include "tensorflow_serving/apis/regression.pb.h"
+#include "tensorflow_serving/util/json_tensor.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using TensorInfoMap = ::google::protobuf::Map<string, TensorInfo>;
+using TensorMap = ::google::protobuf::Map<string, TensorProto>;
+
+// The tensor dtypes benchmarked, by argument.
+enum TensorDtype {
+  kFloat = 0,
+  kInt64 = 1,
+  // Strings are written as JSON strings.
+  kString = 2,
+  // Strings of a tensor whose name ends in "_bytes" are written base64
+  // encoded.
+  kBase64String = 3,
+};
+
+// The inner dimensions of the tensors.
+constexpr int kInnerDimSize = 4;
+
+string TensorName(const int dtype) {
+  return dtype == kBase64String ? "x_bytes" : "x";
+}
+
+DataType ToDataType(const int dtype) {
+  switch (dtype) {
+    case kFloat:
+      return DT_FLOAT;
+    case kInt64:
+      return DT_INT64;
+    default:
+      return DT_STRING;
+  }
+}
+
+JsonPredictRequestFormat ToFormat(const int format) {
+  return format == 0 ? JsonPredictRequestFormat::kRow
+                     : JsonPredictRequestFormat::kColumnar;
+}
+
+// Returns a tensor map of the single tensor described by the arguments, filled
+// as a predict response is (in the '*_val' fields).
+TensorMap MakeTensorMap(const int dtype, const int rank,
+                        const int num_elements) {
+  int64_t outer_dim_size = num_elements;
+  for (int i = 1; i < rank; ++i) {
+    outer_dim_size /= kInnerDimSize;
+  }
+  TensorShape shape({outer_dim_size});
+  for (int i = 1; i < rank; ++i) {
+    shape.AddDim(kInnerDimSize);
+  }
+  Tensor tensor(ToDataType(dtype), shape);
+  for (int64_t i = 0; i < tensor.NumElements(); ++i) {
+    switch (dtype) {
+      case kFloat:
+        tensor.flat<float>()(i) = i * 0.25f;
+        break;
+      case kInt64:
+        tensor.flat<int64_t>()(i) = i * 1000003;
+        break;
+      case kString:
+        tensor.flat<tstring>()(i) = absl::StrCat("value", i);
+        break;
+      default:
+        // Binary, as bytes tensors usually are (e.g. encoded images).
+        tensor.flat<tstring>()(i) =
+            absl::StrCat(string(1, static_cast<char>(i % 256)), "value", i);
+        break;
+    }
+  }
+  TensorMap tensor_map;
+  tensor.AsProtoField(&tensor_map[TensorName(dtype)]);
+  return tensor_map;
+}
+
+// Returns the JSON of the predict request with the tensor described by the
+// arguments.
+string MakePredictRequestJson(const int dtype, const int rank,
+                              const int format, const int num_elements) {
+  // The response of each format is its request, bar the key.
+  string json;
+  TF_CHECK_OK(MakeJsonFromTensors(MakeTensorMap(dtype, rank, num_elements),
+                                  ToFormat(format), JsonOutputFormat::kCompact,
+                                  &json));
+  const absl::string_view response_key =
+      format == 0 ? "{\"predictions\":" : "{\"outputs\":";
+  CHECK(absl::StartsWith(json, response_key)) << json.substr(0, 100);
+  return absl::StrCat(format == 0 ? "{\"instances\":" : "{\"inputs\":",
+                      json.substr(response_key.size()));
+}
+
+std::function<Status(const string&, TensorInfoMap*)> GetTensorInfoMap(
+    const int dtype) {
+  return [dtype](const string&, TensorInfoMap* tensor_info_map) {
+    (*tensor_info_map)[TensorName(dtype)].set_dtype(ToDataType(dtype));
+    return OkStatus();
+  };
+}
+
+void PredictArgs(::benchmark::internal::Benchmark* benchmark) {
+  for (const int dtype : {kFloat, kInt64, kString, kBase64String}) {
+    for (const int rank : {1, 2, 4}) {
+      for (const int format : {0, 1}) {
+        for (const int num_elements : {256, 4096, 65536}) {
+          benchmark->Args({dtype, rank, format, num_elements});
+        }
+      }
+    }
+  }
+}
+
+using FillPredictRequestFn = Status (*)(
+    absl::string_view,
+    const std::function<Status(const string&, TensorInfoMap*)>&,
+    PredictRequest*, JsonPredictRequestFormat*);
+
+void BenchmarkFillPredictRequest(FillPredictRequestFn fill,
+                                 benchmark::State& state) {
+  const int dtype = state.range(0);
+  const string json = MakePredictRequestJson(dtype, state.range(1),
+                                             state.range(2), state.range(3));
+  const auto get_tensorinfo_map = GetTensorInfoMap(dtype);
+  JsonPredictRequestFormat format;
+  for (auto s : state) {
+    PredictRequest request;
+    TF_CHECK_OK(fill(json, get_tensorinfo_map, &request, &format));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(3));
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+
+void BM_FillPredictRequestFromJson(benchmark::State& state) {
+  BenchmarkFillPredictRequest(&FillPredictRequestFromJson, state);
+}
+BENCHMARK(BM_FillPredictRequestFromJson)->Apply(PredictArgs);
+
+void BM_FillPredictRequestFromJsonStreaming(benchmark::State& state) {
+  BenchmarkFillPredictRequest(&FillPredictRequestFromJsonStreaming, state);
+}
+BENCHMARK(BM_FillPredictRequestFromJsonStreaming)->Apply(PredictArgs);
+
+void BM_MakeJsonFromTensors(benchmark::State& state) {
+  const TensorMap tensor_map =
+      MakeTensorMap(state.range(0), state.range(1), state.range(3));
+  const JsonPredictRequestFormat format = ToFormat(state.range(2));
+  string json;
+  for (auto s : state) {
+    json.clear();
+    TF_CHECK_OK(MakeJsonFromTensors(tensor_map, format,
+                                    JsonOutputFormat::kCompact, &json));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(3));
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_MakeJsonFromTensors)->Apply(PredictArgs);
+
+// Returns the JSON of a classify or regress request of 'num_examples'
+// examples, each with a float feature of 16 values and a string feature.
+string MakeExamplesRequestJson(const int num_examples) {
+  string json = R"({"signature_name": "serving_default", "examples": [)";
+  for (int i = 0; i < num_examples; ++i) {
+    absl::StrAppend(&json, i == 0 ? "" : ",", R"({"floats": [)");
+    for (int j = 0; j < 16; ++j) {
+      absl::StrAppend(&json, j == 0 ? "" : ",", i + j * 0.25);
+    }
+    absl::StrAppend(&json, R"(], "tag": "example)", i, "\"}");
+  }
+  return absl::StrCat(json, "]}");
+}
+
+void BM_FillClassificationRequestFromJson(benchmark::State& state) {
+  const string json = MakeExamplesRequestJson(state.range(0));
+  for (auto s : state) {
+    ClassificationRequest request;
+    TF_CHECK_OK(FillClassificationRequestFromJson(json, &request));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_FillClassificationRequestFromJson)->Range(1, 1024);
+
+void BM_FillRegressionRequestFromJson(benchmark::State& state) {
+  const string json = MakeExamplesRequestJson(state.range(0));
+  for (auto s : state) {
+    RegressionRequest request;
+    TF_CHECK_OK(FillRegressionRequestFromJson(json, &request));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_FillRegressionRequestFromJson)->Range(1, 1024);
+
+// Arguments: (examples, classes per example).
+void BM_MakeJsonFromClassificationResult(benchmark::State& state) {
+  ClassificationResult result;
+  for (int i = 0; i < state.range(0); ++i) {
+    Classifications* classifications = result.add_classifications();
+    for (int j = 0; j < state.range(1); ++j) {
+      Class* c = classifications->add_classes();
+      c->set_label(absl::StrCat("label", j));
+      c->set_score(1.0 / (j + 1));
+    }
+  }
+  string json;
+  for (auto s : state) {
+    json.clear();
+    TF_CHECK_OK(MakeJsonFromClassificationResult(
+        result, JsonOutputFormat::kCompact, &json));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_MakeJsonFromClassificationResult)
+    ->ArgPair(1, 10)
+    ->ArgPair(64, 10)
+    ->ArgPair(1024, 10)
+    ->ArgPair(64, 1000);
+
+void BM_MakeJsonFromRegressionResult(benchmark::State& state) {
+  RegressionResult result;
+  for (int i = 0; i < state.range(0); ++i) {
+    result.add_regressions()->set_value(i * 0.25);
+  }
+  string json;
+  for (auto s : state) {
+    json.clear();
+    TF_CHECK_OK(MakeJsonFromRegressionResult(result, JsonOutputFormat::kCompact,
+                                             &json));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_MakeJsonFromRegressionResult)->Range(1, 1024);
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  tensorflow::testing::RunBenchmarks();
+  return 0;
+}
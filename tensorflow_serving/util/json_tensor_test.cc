@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow_serving/util/json_tensor.h"
 
 #include <functional>
+#include <vector>
 
 #include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
@@ -24,9 +25,13 @@ limitations under the License.
 #include "rapidjson/error/en.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow_serving/apis/model.pb.h"
 #include "tensorflow_serving/apis/predict.pb.h"
@@ -604,6 +609,94 @@ TEST(JsontensorTest, MultipleNamedTensorColumnarFormat) {
               )"));
 }
 
+TEST(JsontensorTest, SparseAndRaggedTensorsColumnarFormat) {
+  TensorInfoMap infomap;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    dtype: DT_FLOAT
+    coo_sparse {
+      values_tensor_name: "values:0"
+      indices_tensor_name: "indices:0"
+      dense_shape_tensor_name: "dense_shape:0"
+    })",
+                                          &infomap["clicks"]));
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    composite_tensor {
+      type_spec { type_spec_class: RAGGED_TENSOR_SPEC }
+      components { name: "flat_values:0" dtype: DT_INT64 }
+      components { name: "row_splits:0" dtype: DT_INT64 }
+    })",
+                                          &infomap["tokens"]));
+
+  for (const auto& fill : {FillPredictRequestFromJson,
+                           FillPredictRequestFromJsonStreaming}) {
+    PredictRequest req;
+    JsonPredictRequestFormat format;
+    TF_EXPECT_OK(fill(R"(
+      {
+        "inputs": {
+          "clicks": {"indices": [[0, 3], [1, 999]], "values": [1.5, 2],
+                     "dense_shape": [2, 1000]},
+          "tokens": {"flat_values": [7, 8, 9], "nested_row_splits": [[0, 1, 3]]}
+        }
+      })",
+                      getmap(infomap), &req, &format));
+    EXPECT_EQ(format, JsonPredictRequestFormat::kColumnar);
+    EXPECT_TRUE(req.inputs().empty());
+    EXPECT_THAT(req.sparse_inputs().at("clicks"), EqualsProto(R"(
+                  indices {
+                    dtype: DT_INT64
+                    tensor_shape {
+                      dim { size: 2 }
+                      dim { size: 2 }
+                    }
+                    int64_val: [ 0, 3, 1, 999 ]
+                  }
+                  values {
+                    dtype: DT_FLOAT
+                    tensor_shape { dim { size: 2 } }
+                    float_val: [ 1.5, 2 ]
+                  }
+                  dense_shape {
+                    dtype: DT_INT64
+                    tensor_shape { dim { size: 2 } }
+                    int64_val: [ 2, 1000 ]
+                  }
+                )"));
+    EXPECT_THAT(req.ragged_inputs().at("tokens"), EqualsProto(R"(
+                  flat_values {
+                    dtype: DT_INT64
+                    tensor_shape { dim { size: 3 } }
+                    int64_val: [ 7, 8, 9 ]
+                  }
+                  nested_row_splits {
+                    dtype: DT_INT64
+                    tensor_shape { dim { size: 3 } }
+                    int64_val: [ 0, 1, 3 ]
+                  }
+                )"));
+  }
+
+  // A single sparse input can be the value of "inputs" itself, and may have
+  // no values.
+  TensorInfoMap sparse_infomap;
+  sparse_infomap["clicks"] = infomap["clicks"];
+  PredictRequest req;
+  JsonPredictRequestFormat format;
+  TF_EXPECT_OK(FillPredictRequestFromJson(
+      R"({"inputs": {"indices": [], "values": [], "dense_shape": [2, 1000]}})",
+      getmap(sparse_infomap), &req, &format));
+  EXPECT_THAT(req.sparse_inputs().at("clicks").indices().tensor_shape(),
+              EqualsProto("dim { size: 0 } dim { size: 2 }"));
+
+  // Sparse and ragged inputs can't be sent in row format.
+  req.Clear();
+  const Status status = FillPredictRequestFromJson(
+      R"({"instances": [{"clicks": [1], "tokens": [2]}]})", getmap(infomap),
+      &req, &format);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("sparse or ragged"));
+}
+
 TEST(JsontensorTest, SingleUnnamedTensorErrors) {
   TensorInfoMap infomap;
   ASSERT_TRUE(
@@ -758,6 +851,353 @@ TEST(JsontensorTest, MultipleNamedTensorErrors) {
               HasSubstr("Expecting value/list but got object"));
 }
 
+// Checks that FillPredictRequestFromJsonStreaming() decodes 'json' into the
+// same tensors as FillPredictRequestFromJson().
+void ExpectSameAsDom(const string& json, const TensorInfoMap& infomap) {
+  PredictRequest dom_req;
+  JsonPredictRequestFormat dom_format;
+  TF_ASSERT_OK(
+      FillPredictRequestFromJson(json, getmap(infomap), &dom_req, &dom_format));
+
+  PredictRequest req;
+  JsonPredictRequestFormat format;
+  TF_ASSERT_OK(FillPredictRequestFromJsonStreaming(json, getmap(infomap), &req,
+                                                   &format));
+  EXPECT_EQ(dom_format, format);
+  EXPECT_EQ(dom_req.model_spec().signature_name(),
+            req.model_spec().signature_name());
+  ASSERT_EQ(dom_req.inputs().size(), req.inputs().size());
+  for (const auto& kv : dom_req.inputs()) {
+    SCOPED_TRACE(kv.first);
+    ASSERT_EQ(1, req.inputs().count(kv.first));
+    const TensorProto& proto = req.inputs().at(kv.first);
+    EXPECT_EQ(kv.second.dtype(), proto.dtype());
+    EXPECT_THAT(proto.tensor_shape(), EqualsProto(kv.second.tensor_shape()));
+    Tensor dom_tensor, tensor;
+    ASSERT_TRUE(dom_tensor.FromProto(kv.second));
+    ASSERT_TRUE(tensor.FromProto(proto));
+    EXPECT_EQ(dom_tensor.DebugString(1000), tensor.DebugString(1000));
+  }
+}
+
+TEST(JsontensorTest, StreamingMatchesDom) {
+  TensorInfoMap infomap;
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_INT32", &infomap["default"]));
+  ExpectSameAsDom(R"({"instances": [[1,2],[3,4],[5,6]]})", infomap);
+  ExpectSameAsDom(R"({"instances": [1, 2, 3]})", infomap);
+  ExpectSameAsDom(R"({"instances": [[], []]})", infomap);
+  ExpectSameAsDom(R"({"inputs": [[[1], [2]], [[3], [4]]]})", infomap);
+  ExpectSameAsDom(R"({"inputs": 7, "other": {"a": [1, {}]}})", infomap);
+  ExpectSameAsDom(R"({"inputs": {"default": [-1, 2], "other": [[]]}})",
+                  infomap);
+
+  infomap.clear();
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_STRING", &infomap["default"]));
+  ExpectSameAsDom(R"({"instances": [{"b64": "aGVsbG8="}, {"b64": "d29y"}]})",
+                  infomap);
+  ExpectSameAsDom(R"({"instances": [[{"b64": "aGVsbG8="}], ["plain"]]})",
+                  infomap);
+  ExpectSameAsDom(R"({"instances": [{"default": {"b64": "aGVsbG8="}}]})",
+                  infomap);
+  ExpectSameAsDom(R"({"inputs": {"b64": "aGVsbG8="}})", infomap);
+
+  infomap.clear();
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_INT32", &infomap["int_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_STRING", &infomap["str_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_FLOAT", &infomap["float_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_DOUBLE", &infomap["dbl_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_INT64", &infomap["int64_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_UINT64", &infomap["u64_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_BOOL", &infomap["bool_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_UINT8", &infomap["u8_tensor"]));
+  ExpectSameAsDom(R"(
+    {
+      "signature_name": "sig",
+      "instances": [
+        {
+          "int_tensor": [[1,2],[3,4],[5,6]],
+          "str_tensor": ["foo", "bar"],
+          "float_tensor": [1.0, NaN],
+          "dbl_tensor": [-Infinity],
+          "int64_tensor": -9000000000,
+          "u64_tensor": [18446744073709551615],
+          "bool_tensor": [true, false],
+          "u8_tensor": [255]
+        },
+        {
+          "u8_tensor": [0],
+          "bool_tensor": [false, false],
+          "u64_tensor": [0],
+          "int64_tensor": 9000000000,
+          "dbl_tensor": [2],
+          "float_tensor": [2, 0.1],
+          "str_tensor": ["baz", "bat"],
+          "int_tensor": [[7,8],[9,0],[1,2]]
+        }
+      ]
+    })",
+                  infomap);
+  ExpectSameAsDom(R"(
+    {
+      "inputs": {
+        "int_tensor": [[1,2],[3,4],[5,6]],
+        "str_tensor": ["foo", "bar", {"b64": "aGVsbG8="}],
+        "float_tensor": [[1.5], [-2]],
+        "dbl_tensor": 3.25,
+        "int64_tensor": [],
+        "u64_tensor": [[[1]]],
+        "bool_tensor": true,
+        "u8_tensor": [[]]
+      },
+      "signature_name": "sig"
+    })",
+                  infomap);
+}
+
+TEST(JsontensorTest, StreamingWritesTensorContent) {
+  TensorInfoMap infomap;
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_FLOAT", &infomap["default"]));
+
+  PredictRequest req;
+  JsonPredictRequestFormat format;
+  TF_ASSERT_OK(FillPredictRequestFromJsonStreaming(
+      R"({"instances": [[1.5, 2], [3, -4]]})", getmap(infomap), &req,
+      &format));
+  const TensorProto& proto = req.inputs().at("default");
+  EXPECT_EQ(0, proto.float_val_size());
+  const float values[] = {1.5, 2, 3, -4};
+  EXPECT_EQ(string(reinterpret_cast<const char*>(values), sizeof(values)),
+            proto.tensor_content());
+}
+
+TEST(JsontensorTest, StreamingFallsBackForSignatureNameAfterInputs) {
+  // The input types depend on the signature.
+  auto get_map = [](const string& signature, TensorInfoMap* map) {
+    map->clear();
+    TextFormat::ParseFromString(
+        signature == "ints" ? "dtype: DT_INT32" : "dtype: DT_STRING",
+        &(*map)["default"]);
+    return OkStatus();
+  };
+
+  PredictRequest req;
+  JsonPredictRequestFormat format;
+  TF_ASSERT_OK(FillPredictRequestFromJsonStreaming(
+      R"({"instances": [1, 2], "signature_name": "ints"})", get_map, &req,
+      &format));
+  EXPECT_EQ("ints", req.model_spec().signature_name());
+  EXPECT_THAT(req.inputs().at("default"), EqualsProto(R"(
+    dtype: DT_INT32
+    tensor_shape { dim { size: 2 } }
+    int_val: 1
+    int_val: 2
+    )"));
+}
+
+TEST(JsontensorTest, StreamingErrors) {
+  TensorInfoMap infomap;
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_INT32", &infomap["int_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_STRING", &infomap["str_tensor"]));
+
+  auto fill = [&infomap](const string& json) {
+    PredictRequest req;
+    JsonPredictRequestFormat format;
+    return FillPredictRequestFromJsonStreaming(json, getmap(infomap), &req,
+                                               &format);
+  };
+  auto expect_error = [&fill](const string& json, const string& message) {
+    SCOPED_TRACE(json);
+    const Status status = fill(json);
+    ASSERT_TRUE(errors::IsInvalidArgument(status)) << status;
+    EXPECT_THAT(status.message(), HasSubstr(message));
+  };
+
+  expect_error("", "JSON Parse error: The document is empty");
+  expect_error("{", "JSON Parse error");
+  expect_error("[]", "Is not object");
+  expect_error(R"({"signature_name": 5})", "must be a string value");
+  expect_error(R"({"instances": {}})", "to be an list/array");
+  expect_error(R"({"instances": []})", "No values in 'instances' array");
+  expect_error(R"({"other": 1})", "Missing 'inputs' or 'instances' key");
+  expect_error(R"({"instances": [1], "inputs": [1]})",
+               "Not formatted correctly");
+  expect_error(R"({"instances": [[1]]})",
+               "instances is a plain list, but expecting list of objects");
+  expect_error(R"({"inputs": [1]})",
+               "inputs is a plain value/list, but expecting an object");
+  expect_error(R"({"inputs": {"int_tensor": [1]}})",
+               "Missing named input: str_tensor");
+  expect_error(R"({"instances": [{"int_tensor": 1, "bogus": 2}]})",
+               "does not have named input: bogus");
+  expect_error(R"({"instances": [{"int_tensor": 1}]})",
+               "keys must be equal to: int_tensor,str_tensor");
+  expect_error(R"({"instances": [{"int_tensor": 1, "str_tensor": "a"}, [1]]})",
+               "Expecting object but got list");
+  expect_error(R"({"instances": [{"int_tensor": 1.5, "str_tensor": "a"}]})",
+               "not of expected type: int32");
+  expect_error(R"({"instances": [{"int_tensor": 1, "str_tensor": 2}]})",
+               "not of expected type: string");
+  expect_error(
+      R"({"instances": [{"int_tensor": [1, 2], "str_tensor": "a"},
+                        {"int_tensor": [1], "str_tensor": "b"}]})",
+      "Expecting shape [2]");
+  expect_error(
+      R"({"instances": [{"int_tensor": [1, 2], "str_tensor": "a"},
+                        {"int_tensor": 1, "str_tensor": "b"}]})",
+      "Expecting shape [2]");
+  expect_error(R"({"inputs": {"int_tensor": [[1, 2], [3]], "str_tensor": ""}})",
+               "Encountered list at unexpected size");
+  expect_error(R"({"inputs": {"int_tensor": [1, [2]], "str_tensor": ""}})",
+               "Encountered list at unexpected level");
+  expect_error(R"({"inputs": {"int_tensor": [[1], 2], "str_tensor": ""}})",
+               "found at incorrect level");
+  expect_error(R"({"inputs": {"int_tensor": 1, "str_tensor": {"b": "x"}}})",
+               "not formatted correctly for base64 data");
+
+  infomap.clear();
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_STRING", &infomap["default"]));
+  expect_error(R"({"instances": ["a", {"default": "b"}]})",
+               "Expecting value/list but got object");
+}
+
+// Checks that FillPredictRequestFromJsonInParallel() decodes 'json' into the
+// same request as FillPredictRequestFromJsonStreaming(), or fails the same.
+void ExpectParallelSameAsStreaming(const string& json,
+                                   const TensorInfoMap& infomap) {
+  PredictRequest streaming_req;
+  JsonPredictRequestFormat streaming_format;
+  const Status streaming_status = FillPredictRequestFromJsonStreaming(
+      json, getmap(infomap), &streaming_req, &streaming_format);
+
+  thread::ThreadPool thread_pool(Env::Default(), "json_decode", 4);
+  PredictRequest req;
+  JsonPredictRequestFormat format;
+  const Status status = FillPredictRequestFromJsonInParallel(
+      json, getmap(infomap), &thread_pool, &req, &format);
+  ASSERT_EQ(streaming_status, status);
+  if (!status.ok()) {
+    return;
+  }
+  EXPECT_EQ(streaming_format, format);
+  EXPECT_EQ(streaming_req.model_spec().signature_name(),
+            req.model_spec().signature_name());
+  ASSERT_EQ(streaming_req.inputs().size(), req.inputs().size());
+  for (const auto& kv : streaming_req.inputs()) {
+    SCOPED_TRACE(kv.first);
+    ASSERT_EQ(1, req.inputs().count(kv.first));
+    Tensor streaming_tensor, tensor;
+    ASSERT_TRUE(streaming_tensor.FromProto(kv.second));
+    ASSERT_TRUE(tensor.FromProto(req.inputs().at(kv.first)));
+    EXPECT_EQ(streaming_tensor.DebugString(-1), tensor.DebugString(-1));
+  }
+}
+
+// Returns a row format request of 'num_instances' instances, each made by
+// 'make_instance' from its index.
+string MakeInstancesJson(int num_instances,
+                         const std::function<string(int)>& make_instance) {
+  string json = R"({"signature_name": "sig", "instances": [)";
+  for (int i = 0; i < num_instances; ++i) {
+    absl::StrAppend(&json, i == 0 ? "" : ",\n  ", make_instance(i));
+  }
+  absl::StrAppend(&json, "]}");
+  return json;
+}
+
+TEST(JsontensorTest, ParallelMatchesStreaming) {
+  // Large enough to be split into several chunks.
+  constexpr int kNumInstances = 50000;
+  TensorInfoMap infomap;
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_FLOAT", &infomap["default"]));
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(kNumInstances,
+                        [](int i) {
+                          return absl::StrCat("[[", i, ", 0.5], [-1, ", i,
+                                              "], [3.25, 1e10]]");
+                        }),
+      infomap);
+  // Too small to be split.
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(10, [](int i) { return absl::StrCat(i); }), infomap);
+
+  infomap.clear();
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_INT64", &infomap["int_tensor"]));
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_STRING", &infomap["str_tensor"]));
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(kNumInstances,
+                        [](int i) {
+                          return absl::StrCat(
+                              R"({"str_tensor": [{"b64": "aGVsbG8="}, "s)", i,
+                              R"("], "int_tensor": )", -i, "}");
+                        }),
+      infomap);
+
+  infomap.clear();
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_STRING", &infomap["default"]));
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(kNumInstances,
+                        [](int i) {
+                          return i % 2 == 0 ? R"({"b64": "aGVsbG8gd29ybGQ="})"
+                                            : R"({ "b64" : "d29ybGQ="})";
+                        }),
+      infomap);
+}
+
+TEST(JsontensorTest, ParallelErrorsMatchStreaming) {
+  constexpr int kNumInstances = 50000;
+  TensorInfoMap infomap;
+  ASSERT_TRUE(
+      TextFormat::ParseFromString("dtype: DT_INT32", &infomap["default"]));
+  // Errors in a later chunk are reported as by a single pass.
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(kNumInstances,
+                        [](int i) {
+                          return i == kNumInstances - 1
+                                     ? string("[1.5, 2, 3, 4, 5, 6]")
+                                     : string("[1, 2, 3, 4, 5, 6]");
+                        }),
+      infomap);
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(kNumInstances,
+                        [](int i) {
+                          return i == kNumInstances - 1
+                                     ? string("[1, 2, 3, 4, 5]")
+                                     : string("[1, 2, 3, 4, 5, 6]");
+                        }),
+      infomap);
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(kNumInstances,
+                        [](int i) {
+                          return i == kNumInstances - 1
+                                     ? string(R"({"default": [1, 2, 3, 4]})")
+                                     : string("[1, 2, 3, 4, 5, 6]");
+                        }),
+      infomap);
+  ExpectParallelSameAsStreaming(
+      MakeInstancesJson(kNumInstances,
+                        [](int i) { return string("[1, 2, 3, 4, 5, 6]"); }) +
+          "junk",
+      infomap);
+}
+
 template <const unsigned int parseflags = rapidjson::kParseNanAndInfFlag>
 Status CompareJson(const string& json1, const string& json2) {
   rapidjson::Document doc1;
@@ -912,6 +1352,67 @@ TEST(JsontensorTest, FromJsonSingleFloatTensorSixDigitPrecision) {
     ]})"));
 }
 
+// Tests values that don't roundtrip in six digits are written with full
+// precision.
+TEST(JsontensorTest, FromJsonSingleDoubleTensorFullPrecision) {
+  TensorMap tensormap;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    dtype: DT_DOUBLE
+    tensor_shape {
+      dim { size: 2 }
+      dim { size: 2 }
+    }
+    double_val: 0.1
+    double_val: 1.0000000000000002
+    double_val: -2.5e-300
+    double_val: 1234567
+    )",
+                                          &tensormap["double_tensor"]));
+
+  string json;
+  TF_EXPECT_OK(
+      MakeJsonFromTensors(tensormap, JsonPredictRequestFormat::kRow, &json));
+  TF_EXPECT_OK(CompareJsonAllValuesAsStrings(json, R"({
+    "predictions": [
+      [0.1, 1.0000000000000002],
+      [-2.5e-300, 1234567.0]
+    ]})"));
+}
+
+// Tests 16-bit floats are written with the fewest digits that roundtrip at
+// their precision.
+TEST(JsontensorTest, FromJsonSingleReducedPrecisionTensor) {
+  Tensor bfloat16_tensor(DT_BFLOAT16, TensorShape({2, 2}));
+  Tensor half_tensor(DT_HALF, TensorShape({2, 2}));
+  const std::vector<float> values = {0.1f, 3, -2.5f, 1000.5f};
+  for (int i = 0; i < values.size(); ++i) {
+    bfloat16_tensor.flat<bfloat16>()(i) = static_cast<bfloat16>(values[i]);
+    half_tensor.flat<Eigen::half>()(i) = static_cast<Eigen::half>(values[i]);
+  }
+
+  TensorMap tensormap;
+  bfloat16_tensor.AsProtoField(&tensormap["bfloat16_tensor"]);
+  string json;
+  TF_EXPECT_OK(
+      MakeJsonFromTensors(tensormap, JsonPredictRequestFormat::kRow, &json));
+  // 1000.5 is 1000 in bfloat16.
+  TF_EXPECT_OK(CompareJsonAllValuesAsStrings(json, R"({
+    "predictions": [
+      [0.1, 3.0],
+      [-2.5, 1e+03]
+    ]})"));
+
+  tensormap.clear();
+  half_tensor.AsProtoField(&tensormap["half_tensor"]);
+  TF_EXPECT_OK(
+      MakeJsonFromTensors(tensormap, JsonPredictRequestFormat::kRow, &json));
+  TF_EXPECT_OK(CompareJsonAllValuesAsStrings(json, R"({
+    "predictions": [
+      [0.1, 3.0],
+      [-2.5, 1000.5]
+    ]})"));
+}
+
 TEST(JsontensorTest, FromJsonSingleFloatTensorNonFinite) {
   TensorMap tensormap;
   ASSERT_TRUE(TextFormat::ParseFromString(R"(
@@ -1562,6 +2063,110 @@ TEST(ClassifyRegressnResultTest, JsonFromResultErrors) {
   EXPECT_THAT(status.message(), HasSubstr("empty RegressionResults"));
 }
 
+TEST(ClassifyRegressnResultTest, CompactJsonFromResults) {
+  ClassificationResult classification_result;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    classifications {
+      classes { label: "car" score: 0.2 }
+      classes { label: "bike" score: 0.7 }
+    }
+    )",
+                                          &classification_result));
+  string json;
+  TF_EXPECT_OK(MakeJsonFromClassificationResult(
+      classification_result, JsonOutputFormat::kCompact, &json));
+  EXPECT_EQ(R"({"results":[[["car",0.2],["bike",0.7]]]})", json);
+
+  RegressionResult regression_result;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    regressions { value: 0.2 }
+    regressions { value: 1.0 }
+    )",
+                                          &regression_result));
+  TF_EXPECT_OK(MakeJsonFromRegressionResult(
+      regression_result, JsonOutputFormat::kCompact, &json));
+  EXPECT_EQ(R"({"results":[0.2,1.0]})", json);
+}
+
+TEST(MakeJsonFromTensors, CompactJson) {
+  TensorMap tensormap;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    dtype: DT_FLOAT
+    tensor_shape {
+      dim { size: 2 }
+      dim { size: 2 }
+    }
+    float_val: 1.5
+    float_val: 2
+    float_val: NaN
+    float_val: -4
+    )",
+                                          &tensormap["float_tensor"]));
+
+  string json;
+  TF_EXPECT_OK(MakeJsonFromTensors(tensormap, JsonPredictRequestFormat::kRow,
+                                   JsonOutputFormat::kCompact, &json));
+  EXPECT_EQ(R"({"predictions":[[1.5,2.0],[NaN,-4.0]]})", json);
+  TF_EXPECT_OK(MakeJsonFromTensors(tensormap,
+                                   JsonPredictRequestFormat::kColumnar,
+                                   JsonOutputFormat::kCompact, &json));
+  EXPECT_EQ(R"({"outputs":[[1.5,2.0],[NaN,-4.0]]})", json);
+
+  // The pretty and compact outputs hold the same JSON.
+  string pretty_json;
+  TF_EXPECT_OK(MakeJsonFromTensors(tensormap,
+                                   JsonPredictRequestFormat::kColumnar,
+                                   JsonOutputFormat::kPretty, &pretty_json));
+  EXPECT_NE(pretty_json, json);
+  TF_EXPECT_OK(CompareJsonAllValuesAsStrings(pretty_json, json));
+}
+
+TEST(JsontensorTest, MakeJsonFromTensorsInChunks) {
+  TensorMap tensormap;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    dtype: DT_INT32
+    tensor_shape {
+      dim { size: 2 }
+      dim { size: 3 }
+    }
+    int_val: [1, 2, 3, 4, 5, 6]
+    )",
+                                          &tensormap["int_tensor"]));
+  ASSERT_TRUE(TextFormat::ParseFromString(R"(
+    dtype: DT_STRING
+    tensor_shape { dim { size: 2 } }
+    string_val: ["foo", "bar"]
+    )",
+                                          &tensormap["str_tensor"]));
+
+  for (const auto format :
+       {JsonPredictRequestFormat::kRow, JsonPredictRequestFormat::kColumnar}) {
+    for (const auto output_format :
+         {JsonOutputFormat::kPretty, JsonOutputFormat::kCompact}) {
+      string json;
+      TF_ASSERT_OK(
+          MakeJsonFromTensors(tensormap, format, output_format, &json));
+
+      // The chunks make up the same JSON.
+      std::vector<string> chunks;
+      TF_ASSERT_OK(MakeJsonFromTensors(
+          tensormap, format, output_format, 16,
+          [&chunks](absl::string_view chunk) { chunks.emplace_back(chunk); }));
+      ASSERT_GT(chunks.size(), 1);
+      for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+        EXPECT_EQ(16, chunks[i].size());
+      }
+      EXPECT_EQ(json, absl::StrJoin(chunks, ""));
+    }
+  }
+
+  tensormap["str_tensor"].mutable_tensor_shape()->mutable_dim(0)->set_size(1);
+  EXPECT_FALSE(MakeJsonFromTensors(tensormap, JsonPredictRequestFormat::kRow,
+                                   JsonOutputFormat::kCompact, 16,
+                                   [](absl::string_view chunk) {})
+                   .ok());
+}
+
 TEST(MakeJsonFromTensors, StatusOK) {
   string json;
   MakeJsonFromStatus(OkStatus(), &json);
@@ -0,0 +1,313 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/memory_accounting.h"
+
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/lib/monitoring/metric_def.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/util/sharded_metrics.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+template <int NumLabels>
+using GaugeDef =
+    monitoring::MetricDef<monitoring::MetricKind::kGauge, int64_t, NumLabels>;
+
+constexpr int kNumSubsystems = 4;
+
+const char* SubsystemName(const MemorySubsystem subsystem) {
+  switch (subsystem) {
+    case MemorySubsystem::kBatching:
+      return "batching";
+    case MemorySubsystem::kJson:
+      return "json";
+    case MemorySubsystem::kLogging:
+      return "logging";
+    case MemorySubsystem::kRequestArenas:
+      return "request_arenas";
+  }
+  return "unknown";
+}
+
+std::atomic<bool> enabled{false};
+
+// The bytes charged to each subsystem, sharded as they change per request.
+ShardedCounterCell* SubsystemCell(const MemorySubsystem subsystem) {
+  static ShardedCounterCell* const cells =
+      new ShardedCounterCell[kNumSubsystems];
+  return &cells[static_cast<int>(subsystem)];
+}
+
+// Reads the resident and virtual memory of the process. Returns false where
+// they are not known.
+bool GetProcessMemory(int64_t* resident_bytes, int64_t* virtual_bytes) {
+#ifdef __linux__
+  string statm;
+  if (!ReadFileToString(Env::Default(), "/proc/self/statm", &statm).ok()) {
+    return false;
+  }
+  long long virtual_pages, resident_pages;  // NOLINT(runtime/int)
+  if (sscanf(statm.c_str(), "%lld %lld", &virtual_pages, &resident_pages) !=
+      2) {
+    return false;
+  }
+  const int64_t page_size = sysconf(_SC_PAGESIZE);
+  *resident_bytes = resident_pages * page_size;
+  *virtual_bytes = virtual_pages * page_size;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// Reads the memory malloc has handed out and the freed memory it holds on to.
+// Returns false where they are not known.
+bool GetHeapMemory(int64_t* in_use_bytes, int64_t* free_bytes) {
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+  const struct mallinfo2 info = mallinfo2();
+  // Large allocations are mapped on their own, and unmapped when freed.
+  *in_use_bytes = info.uordblks + info.hblkhd;
+  *free_bytes = info.fordblks;
+  return true;
+#else
+  return false;
+#endif
+}
+
+// The state behind the gauges, which are collected on demand.
+class MemoryMetrics {
+ public:
+  static MemoryMetrics* Get() {
+    static MemoryMetrics* const metrics = new MemoryMetrics();
+    return metrics;
+  }
+
+  void AddAllocator(Allocator* allocator) TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    allocators_.emplace(allocator->Name(), allocator);
+  }
+
+  void SetServable(const string& model_name, const int64_t version,
+                   const std::map<string, int64_t>& bytes_by_device)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    servables_[{model_name, version}] = bytes_by_device;
+  }
+
+  void ClearServable(const string& model_name, const int64_t version)
+      TF_LOCKS_EXCLUDED(mu_) {
+    mutex_lock l(mu_);
+    servables_.erase({model_name, version});
+  }
+
+ private:
+  MemoryMetrics()
+      : model_bytes_("/tensorflow/serving/memory/model_bytes",
+                     "The memory taken by each loaded servable, by device.",
+                     "model_name", "version", "device"),
+        subsystem_bytes_(
+            "/tensorflow/serving/memory/subsystem_bytes",
+            "The memory held by the buffers of each serving subsystem.",
+            "subsystem"),
+        allocator_bytes_("/tensorflow/serving/memory/allocator_bytes",
+                         "The statistics of the TF allocators of the loaded "
+                         "sessions.",
+                         "allocator", "stat"),
+        process_bytes_("/tensorflow/serving/memory/process_bytes",
+                       "The resident and virtual memory of the process.",
+                       "stat"),
+        heap_bytes_("/tensorflow/serving/memory/heap_bytes",
+                    "The memory malloc has handed out, and the freed memory "
+                    "it holds on to.",
+                    "stat") {
+    monitoring::CollectionRegistry* const registry =
+        monitoring::CollectionRegistry::Default();
+    handles_.push_back(registry->Register(
+        &model_bytes_, [this](monitoring::MetricCollectorGetter getter) {
+          auto collector = getter.Get(&model_bytes_);
+          mutex_lock l(mu_);
+          for (const auto& servable : servables_) {
+            for (const auto& device : servable.second) {
+              collector.CollectValue(
+                  {servable.first.first, absl::StrCat(servable.first.second),
+                   device.first},
+                  device.second);
+            }
+          }
+        }));
+    handles_.push_back(registry->Register(
+        &subsystem_bytes_, [this](monitoring::MetricCollectorGetter getter) {
+          auto collector = getter.Get(&subsystem_bytes_);
+          for (int i = 0; i < kNumSubsystems; ++i) {
+            const auto subsystem = static_cast<MemorySubsystem>(i);
+            collector.CollectValue({SubsystemName(subsystem)},
+                                   SubsystemCell(subsystem)->value());
+          }
+        }));
+    handles_.push_back(registry->Register(
+        &allocator_bytes_, [this](monitoring::MetricCollectorGetter getter) {
+          auto collector = getter.Get(&allocator_bytes_);
+          mutex_lock l(mu_);
+          for (const auto& entry : allocators_) {
+            const absl::optional<AllocatorStats> stats =
+                entry.second->GetStats();
+            if (!stats.has_value()) {
+              continue;
+            }
+            collector.CollectValue({entry.first, "bytes_in_use"},
+                                   stats->bytes_in_use);
+            collector.CollectValue({entry.first, "peak_bytes_in_use"},
+                                   stats->peak_bytes_in_use);
+            if (stats->bytes_limit.has_value()) {
+              collector.CollectValue({entry.first, "bytes_limit"},
+                                     *stats->bytes_limit);
+            }
+          }
+        }));
+    handles_.push_back(registry->Register(
+        &process_bytes_, [this](monitoring::MetricCollectorGetter getter) {
+          auto collector = getter.Get(&process_bytes_);
+          int64_t resident_bytes, virtual_bytes;
+          if (GetProcessMemory(&resident_bytes, &virtual_bytes)) {
+            collector.CollectValue({"resident"}, resident_bytes);
+            collector.CollectValue({"virtual"}, virtual_bytes);
+          }
+        }));
+    handles_.push_back(registry->Register(
+        &heap_bytes_, [this](monitoring::MetricCollectorGetter getter) {
+          auto collector = getter.Get(&heap_bytes_);
+          int64_t in_use_bytes, free_bytes;
+          if (GetHeapMemory(&in_use_bytes, &free_bytes)) {
+            collector.CollectValue({"in_use"}, in_use_bytes);
+            collector.CollectValue({"free"}, free_bytes);
+          }
+        }));
+  }
+
+  const GaugeDef<3> model_bytes_;
+  const GaugeDef<1> subsystem_bytes_;
+  const GaugeDef<2> allocator_bytes_;
+  const GaugeDef<1> process_bytes_;
+  const GaugeDef<1> heap_bytes_;
+
+  mutex mu_;
+  // The allocators, by name.
+  std::map<string, Allocator*> allocators_ TF_GUARDED_BY(mu_);
+  std::map<std::pair<string, int64_t>, std::map<string, int64_t>> servables_
+      TF_GUARDED_BY(mu_);
+
+  std::vector<
+      std::unique_ptr<monitoring::CollectionRegistry::RegistrationHandle>>
+      handles_;
+};
+
+}  // namespace
+
+void EnableMemoryAccounting() {
+  // The CPU allocator only keeps statistics on request.
+  EnableCPUAllocatorStats();
+  MemoryMetrics::Get()->AddAllocator(cpu_allocator());
+  enabled.store(true, std::memory_order_relaxed);
+}
+
+bool MemoryAccountingEnabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void AccountSessionAllocators(Session* session) {
+  if (!MemoryAccountingEnabled()) {
+    return;
+  }
+  const DeviceMgr* device_mgr;
+  if (!session->LocalDeviceManager(&device_mgr).ok()) {
+    return;
+  }
+  for (Device* device : device_mgr->ListDevices()) {
+    Allocator* const allocator = device->GetAllocator(AllocatorAttributes());
+    if (allocator != nullptr) {
+      MemoryMetrics::Get()->AddAllocator(allocator);
+    }
+  }
+}
+
+void SetServableMemory(const string& model_name, const int64_t version,
+                       const std::map<string, int64_t>& bytes_by_device) {
+  if (MemoryAccountingEnabled()) {
+    MemoryMetrics::Get()->SetServable(model_name, version, bytes_by_device);
+  }
+}
+
+void ClearServableMemory(const string& model_name, const int64_t version) {
+  if (MemoryAccountingEnabled()) {
+    MemoryMetrics::Get()->ClearServable(model_name, version);
+  }
+}
+
+int64_t GetChargedMemory(const MemorySubsystem subsystem) {
+  return SubsystemCell(subsystem)->value();
+}
+
+MemoryCharge::MemoryCharge(const MemorySubsystem subsystem,
+                           const int64_t bytes)
+    : subsystem_(subsystem) {
+  Add(bytes);
+}
+
+MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) {
+  if (this != &other) {
+    Release();
+    subsystem_ = other.subsystem_;
+    bytes_ = other.bytes_;
+    other.bytes_ = 0;
+  }
+  return *this;
+}
+
+void MemoryCharge::Add(const int64_t bytes) {
+  if (bytes <= 0 || !MemoryAccountingEnabled()) {
+    return;
+  }
+  SubsystemCell(subsystem_)->IncrementBy(bytes);
+  bytes_ += bytes;
+}
+
+void MemoryCharge::Release() {
+  if (bytes_ != 0) {
+    SubsystemCell(subsystem_)->IncrementBy(-bytes_);
+    bytes_ = 0;
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_MEMORY_ACCOUNTING_H_
+#define TENSORFLOW_SERVING_UTIL_MEMORY_ACCOUNTING_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Breaks the memory of the model server down, on the monitoring endpoint:
+//
+//   /tensorflow/serving/memory/model_bytes{model_name, version, device}
+//       The memory each loaded servable takes, as measured after its load
+//       (see ResourceMeasurer) or else as estimated before it.
+//   /tensorflow/serving/memory/subsystem_bytes{subsystem}
+//       The memory held by the buffers of the serving subsystems that tag
+//       their allocations with a MemoryCharge: merged batches, JSON requests
+//       and responses, queued request logs, and the blocks the threads keep
+//       for the arenas of their requests (see RequestArena).
+//   /tensorflow/serving/memory/allocator_bytes{allocator, stat}
+//       The 'bytes_in_use', 'peak_bytes_in_use' and 'bytes_limit' of the TF
+//       allocators of the devices of the loaded sessions.
+//   /tensorflow/serving/memory/process_bytes{stat}
+//       The 'resident' and 'virtual' memory of the process, against which the
+//       rest tells what the allocators hold on to beyond what is in use.
+//   /tensorflow/serving/memory/heap_bytes{stat}
+//       The memory malloc has handed out ('in_use') and the freed memory it
+//       holds on to ('free'), with glibc. A 'free' share that grows over the
+//       uptime of the server is fragmentation of the heap.
+//
+// Nothing is accounted for until EnableMemoryAccounting() is called, as it
+// turns on the statistics of the CPU allocator, which cost a lock per
+// allocation.
+
+// The subsystems whose buffers are accounted for.
+enum class MemorySubsystem {
+  kBatching,
+  kJson,
+  kLogging,
+  kRequestArenas,
+};
+
+// Starts accounting for memory. Meant to be called once, at startup, before
+// models load.
+void EnableMemoryAccounting();
+
+bool MemoryAccountingEnabled();
+
+// Reports the allocators of the devices of 'session' on the monitoring
+// endpoint. Sessions that do not expose their devices are skipped.
+void AccountSessionAllocators(Session* session);
+
+// Sets the memory of the servable 'model_name' version 'version', in bytes by
+// device (e.g. "main", "gpu:0"), until ClearServableMemory() is called.
+void SetServableMemory(const string& model_name, int64_t version,
+                       const std::map<string, int64_t>& bytes_by_device);
+void ClearServableMemory(const string& model_name, int64_t version);
+
+// Returns the bytes currently charged to 'subsystem'.
+int64_t GetChargedMemory(MemorySubsystem subsystem);
+
+// Charges memory to a subsystem for the lifetime of the object. Moves with
+// the buffer it accounts for. A no-op unless memory accounting is enabled.
+class MemoryCharge {
+ public:
+  MemoryCharge() = default;
+  MemoryCharge(MemorySubsystem subsystem, int64_t bytes);
+  ~MemoryCharge() { Release(); }
+
+  MemoryCharge(MemoryCharge&& other)
+      : subsystem_(other.subsystem_), bytes_(other.bytes_) {
+    other.bytes_ = 0;
+  }
+  MemoryCharge& operator=(MemoryCharge&& other);
+
+  // Charges 'bytes' more to the subsystem.
+  void Add(int64_t bytes);
+
+  // Uncharges the memory, early.
+  void Release();
+
+ private:
+  MemorySubsystem subsystem_ = MemorySubsystem::kBatching;
+  int64_t bytes_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryCharge);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_MEMORY_ACCOUNTING_H_
@@ -0,0 +1,107 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/memory_accounting.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Returns the point of the metric 'name' with label values 'labels'.
+std::unique_ptr<monitoring::Point> CollectPoint(
+    const string& name, const std::vector<string>& labels) {
+  std::unique_ptr<monitoring::CollectedMetrics> collected =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  const auto point_set = collected->point_set_map.find(name);
+  if (point_set == collected->point_set_map.end()) {
+    return nullptr;
+  }
+  for (std::unique_ptr<monitoring::Point>& point :
+       point_set->second->points) {
+    std::vector<string> point_labels;
+    for (const auto& label : point->labels) {
+      point_labels.push_back(label.value);
+    }
+    if (point_labels == labels) {
+      return std::move(point);
+    }
+  }
+  return nullptr;
+}
+
+// A single test, as accounting cannot be disabled once enabled.
+TEST(MemoryAccountingTest, ChargesAndGauges) {
+  {
+    // Nothing is charged before accounting is enabled.
+    MemoryCharge charge(MemorySubsystem::kJson, 100);
+    EXPECT_EQ(0, GetChargedMemory(MemorySubsystem::kJson));
+  }
+
+  EnableMemoryAccounting();
+  ASSERT_TRUE(MemoryAccountingEnabled());
+  {
+    MemoryCharge charge(MemorySubsystem::kJson, 100);
+    charge.Add(50);
+    EXPECT_EQ(150, GetChargedMemory(MemorySubsystem::kJson));
+    EXPECT_EQ(0, GetChargedMemory(MemorySubsystem::kBatching));
+
+    // The charge moves with the buffer.
+    std::vector<MemoryCharge> queue;
+    queue.push_back(std::move(charge));
+    queue.emplace_back(MemorySubsystem::kLogging, 10);
+    EXPECT_EQ(150, GetChargedMemory(MemorySubsystem::kJson));
+    EXPECT_EQ(10, GetChargedMemory(MemorySubsystem::kLogging));
+
+    std::unique_ptr<monitoring::Point> point = CollectPoint(
+        "/tensorflow/serving/memory/subsystem_bytes", {"json"});
+    ASSERT_NE(nullptr, point);
+    EXPECT_EQ(150, point->int64_value);
+
+    queue[0].Release();
+    EXPECT_EQ(0, GetChargedMemory(MemorySubsystem::kJson));
+  }
+  EXPECT_EQ(0, GetChargedMemory(MemorySubsystem::kLogging));
+
+  SetServableMemory("m", 1, {{"main", 1000}, {"gpu:0", 2000}});
+  std::unique_ptr<monitoring::Point> point = CollectPoint(
+      "/tensorflow/serving/memory/model_bytes", {"m", "1", "gpu:0"});
+  ASSERT_NE(nullptr, point);
+  EXPECT_EQ(2000, point->int64_value);
+  ClearServableMemory("m", 1);
+  EXPECT_EQ(nullptr, CollectPoint("/tensorflow/serving/memory/model_bytes",
+                                  {"m", "1", "gpu:0"}));
+
+  // The CPU allocator keeps statistics once accounting is enabled.
+  EXPECT_NE(nullptr, CollectPoint("/tensorflow/serving/memory/allocator_bytes",
+                                  {cpu_allocator()->Name(), "bytes_in_use"}));
+
+#ifdef __GLIBC__
+  point = CollectPoint("/tensorflow/serving/memory/heap_bytes", {"in_use"});
+  ASSERT_NE(nullptr, point);
+  EXPECT_GT(point->int64_value, 0);
+#endif
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,157 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/memory_reclaimer.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Lowers the scheduling priority of the calling thread to the lowest, which is
+// per thread on Linux.
+void LowerThreadPriority() {
+#ifdef __linux__
+  if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19) !=
+      0) {
+    LOG(WARNING) << "Failed to lower the priority of the memory reclaimer";
+  }
+#endif
+}
+
+}  // namespace
+
+std::atomic<MemoryReclaimer*> MemoryReclaimer::global_reclaimer_{nullptr};
+
+MemoryReclaimer::MemoryReclaimer(const Options& options) : options_(options) {
+  thread_.reset(options_.env->StartThread({}, "memory_reclaimer", [this]() {
+    if (options_.low_priority) {
+      LowerThreadPriority();
+    }
+    ReclaimLoop();
+  }));
+}
+
+MemoryReclaimer::~MemoryReclaimer() {
+  {
+    mutex_lock l(mu_);
+    stopping_ = true;
+    work_cv_.notify_all();
+  }
+  thread_.reset();
+}
+
+Status MemoryReclaimer::SetGlobal(std::unique_ptr<MemoryReclaimer> reclaimer) {
+  MemoryReclaimer* expected = nullptr;
+  if (!global_reclaimer_.compare_exchange_strong(
+          expected, reclaimer.get(), std::memory_order_acq_rel)) {
+    return errors::FailedPrecondition("A memory reclaimer is set already");
+  }
+  // Lives for the rest of the process, as loaders may be handing it servables.
+  reclaimer.release();
+  return OkStatus();
+}
+
+void MemoryReclaimer::Release(std::function<void()> release,
+                              const uint64_t bytes) {
+  mutex_lock l(mu_);
+  queue_.push_back({std::move(release), bytes});
+  ++num_pending_;
+  pending_bytes_ += bytes;
+  work_cv_.notify_one();
+}
+
+void MemoryReclaimer::WaitUntilIdle() {
+  mutex_lock l(mu_);
+  while (num_pending_ > 0) {
+    idle_cv_.wait(l);
+  }
+}
+
+uint64_t MemoryReclaimer::pending_bytes() {
+  mutex_lock l(mu_);
+  return pending_bytes_;
+}
+
+void MemoryReclaimer::ReclaimLoop() {
+  while (true) {
+    PendingRelease pending;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !stopping_) {
+        work_cv_.wait(l);
+      }
+      if (queue_.empty()) {
+        return;  // stopping, with nothing left to release
+      }
+      pending = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    const uint64_t start_micros = options_.env->NowMicros();
+    pending.release();
+    pending.release = nullptr;
+    VLOG(1) << "Released " << pending.bytes << " bytes in "
+            << options_.env->NowMicros() - start_micros << " us";
+    {
+      // Freed, if not yet returned to the OS, so the process can reuse it.
+      mutex_lock l(mu_);
+      pending_bytes_ -= pending.bytes;
+    }
+    ReturnToSystem(pending.bytes);
+
+    mutex_lock l(mu_);
+    --num_pending_;
+    idle_cv_.notify_all();
+  }
+}
+
+void MemoryReclaimer::ReturnToSystem(uint64_t bytes) {
+  const uint64_t max_step_bytes =
+      options_.max_release_step_bytes > 0
+          ? static_cast<uint64_t>(options_.max_release_step_bytes)
+          : bytes;
+  while (bytes > 0) {
+    const uint64_t step_bytes = std::min(bytes, max_step_bytes);
+    port::MallocExtension_ReleaseToSystem(step_bytes);
+    bytes -= step_bytes;
+    if (options_.release_bytes_per_second > 0) {
+      options_.env->SleepForMicroseconds(static_cast<int64_t>(
+          1e6 * step_bytes / options_.release_bytes_per_second));
+    }
+  }
+#ifdef __GLIBC__
+  // glibc holds on to freed memory, which MallocExtension doesn't release.
+  malloc_trim(0);
+#endif
+}
+
+}  // namespace serving
+}  // namespace tensorflow
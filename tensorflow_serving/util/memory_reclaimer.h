@@ -0,0 +1,124 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_MEMORY_RECLAIMER_H_
+#define TENSORFLOW_SERVING_UTIL_MEMORY_RECLAIMER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Frees the memory of unloaded servables on a low-priority thread, off the
+// unload path, and returns it to the OS gradually.
+//
+// Destroying a large servable frees GBs of tensors and tears down its session,
+// which can take seconds and contend on the allocator locks with the threads
+// serving the other models. With a global reclaimer set, SimpleLoader::Unload()
+// hands the servable over to it instead: the reclaimer destroys the servables
+// one at a time, then returns their memory to the OS (MallocExtension, and
+// malloc_trim() with glibc) in steps, at up to 'release_bytes_per_second'.
+//
+// Note that the memory of an unloaded servable is only free once the reclaimer
+// gets to it, though the manager drops its reservation when Unload() returns.
+// The ResourceTracker therefore counts pending_bytes() as used RAM.
+//
+// This class is thread-safe.
+class MemoryReclaimer {
+ public:
+  struct Options {
+    // The rate to return freed memory to the OS at, which spaces the servables
+    // destroyed in turn too. 0 returns it as fast as it is freed.
+    int64_t release_bytes_per_second = 0;
+
+    // The most memory returned to the OS in one step.
+    int64_t max_release_step_bytes = 64 * 1024 * 1024;
+
+    // Whether to run the reclamation thread at the lowest scheduling priority
+    // (on Linux).
+    bool low_priority = true;
+
+    Env* env = Env::Default();
+  };
+
+  explicit MemoryReclaimer(const Options& options);
+
+  // Finishes the pending releases.
+  ~MemoryReclaimer();
+
+  // Makes 'reclaimer' the one Global() returns, for the rest of the process.
+  static Status SetGlobal(std::unique_ptr<MemoryReclaimer> reclaimer);
+
+  // Returns null unless SetGlobal() was called.
+  static MemoryReclaimer* Global() {
+    return global_reclaimer_.load(std::memory_order_acquire);
+  }
+
+  // Runs 'release', which frees about 'bytes' of memory (e.g. destroys a
+  // servable), on the reclamation thread, then returns the memory to the OS.
+  void Release(std::function<void()> release, uint64_t bytes)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Blocks until all the releases so far are done.
+  void WaitUntilIdle() TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the total 'bytes' of the releases whose 'release' has not run to
+  // completion yet, i.e. the memory still held by the servables handed over.
+  uint64_t pending_bytes() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct PendingRelease {
+    std::function<void()> release;
+    uint64_t bytes = 0;
+  };
+
+  void ReclaimLoop() TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns 'bytes' of freed memory to the OS, at the configured rate.
+  void ReturnToSystem(uint64_t bytes);
+
+  static std::atomic<MemoryReclaimer*> global_reclaimer_;
+
+  const Options options_;
+
+  mutex mu_;
+  condition_variable work_cv_;
+  condition_variable idle_cv_;
+  std::deque<PendingRelease> queue_ TF_GUARDED_BY(mu_);
+  // The queued releases and the one running.
+  int num_pending_ TF_GUARDED_BY(mu_) = 0;
+  uint64_t pending_bytes_ TF_GUARDED_BY(mu_) = 0;
+  bool stopping_ TF_GUARDED_BY(mu_) = false;
+
+  // Declared last, to stop before the rest is destroyed.
+  std::unique_ptr<Thread> thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryReclaimer);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_MEMORY_RECLAIMER_H_
@@ -0,0 +1,115 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/memory_reclaimer.h"
+
+#include <memory>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(MemoryReclaimerTest, ReleasesInOrderOffTheCallingThread) {
+  MemoryReclaimer::Options options;
+  options.low_priority = false;
+  MemoryReclaimer reclaimer(options);
+
+  // The first release blocks the reclaimer, but not the caller.
+  Notification unblock;
+  std::vector<int> released;
+  reclaimer.Release([&]() { unblock.WaitForNotification(); }, 0);
+  for (int i = 0; i < 3; ++i) {
+    reclaimer.Release([&released, i]() { released.push_back(i); }, 1024);
+  }
+  unblock.Notify();
+  reclaimer.WaitUntilIdle();
+  EXPECT_THAT(released, ElementsAre(0, 1, 2));
+}
+
+TEST(MemoryReclaimerTest, CountsPendingBytesUntilReleased) {
+  MemoryReclaimer::Options options;
+  options.low_priority = false;
+  MemoryReclaimer reclaimer(options);
+  EXPECT_EQ(0, reclaimer.pending_bytes());
+
+  Notification unblock;
+  reclaimer.Release([&]() { unblock.WaitForNotification(); }, 1024);
+  reclaimer.Release([]() {}, 2048);
+  EXPECT_EQ(3072, reclaimer.pending_bytes());
+  unblock.Notify();
+  reclaimer.WaitUntilIdle();
+  EXPECT_EQ(0, reclaimer.pending_bytes());
+}
+
+TEST(MemoryReclaimerTest, DestroyingFinishesPendingReleases) {
+  std::weak_ptr<int> weak;
+  {
+    MemoryReclaimer reclaimer({});
+    auto shared = std::make_shared<int>(42);
+    weak = shared;
+    reclaimer.Release([shared]() mutable { shared.reset(); }, 0);
+    shared.reset();
+  }
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST(MemoryReclaimerTest, RateLimitsReturningMemory) {
+  test_util::FakeClockEnv env(Env::Default());
+  MemoryReclaimer::Options options;
+  options.release_bytes_per_second = 1024;
+  options.max_release_step_bytes = 1024;
+  options.low_priority = false;
+  options.env = &env;
+  std::unique_ptr<MemoryReclaimer> reclaimer(new MemoryReclaimer(options));
+
+  Notification first_released;
+  Notification second_released;
+  reclaimer->Release([&]() { first_released.Notify(); }, 2048);
+  reclaimer->Release([&]() { second_released.Notify(); }, 0);
+  first_released.WaitForNotification();
+
+  // Two steps of a second each before the next release.
+  env.BlockUntilThreadsAsleep(1);
+  EXPECT_FALSE(second_released.HasBeenNotified());
+  env.AdvanceByMicroseconds(1000 * 1000);
+  env.BlockUntilThreadsAsleep(1);
+  EXPECT_FALSE(second_released.HasBeenNotified());
+  env.AdvanceByMicroseconds(1000 * 1000);
+  second_released.WaitForNotification();
+  reclaimer.reset();
+}
+
+TEST(MemoryReclaimerTest, SetGlobalOnce) {
+  EXPECT_EQ(nullptr, MemoryReclaimer::Global());
+  TF_ASSERT_OK(MemoryReclaimer::SetGlobal(
+      std::make_unique<MemoryReclaimer>(MemoryReclaimer::Options())));
+  EXPECT_NE(nullptr, MemoryReclaimer::Global());
+  EXPECT_FALSE(MemoryReclaimer::SetGlobal(std::make_unique<MemoryReclaimer>(
+                                              MemoryReclaimer::Options()))
+                   .ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
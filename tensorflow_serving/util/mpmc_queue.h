@@ -0,0 +1,163 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_MPMC_QUEUE_H_
+#define TENSORFLOW_SERVING_UTIL_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A bounded queue that any number of threads can push to and pop from without
+// locks. Pushes fail rather than block when the queue is full, and pops when
+// it's empty.
+//
+// Each cell of the ring buffer carries a sequence number that tells pushers
+// and poppers whether it's theirs to fill or to empty for the current lap,
+// so that a push or pop claims its position with a single compare-and-swap
+// (D. Vyukov's bounded MPMC queue).
+//
+// This class is thread-safe.
+template <typename T>
+class MpmcQueue {
+ public:
+  // The capacity is rounded up to a power of two, and is at least 2.
+  explicit MpmcQueue(size_t capacity);
+
+  ~MpmcQueue() = default;
+
+  // Pushes 'value' and returns true, or returns false, leaving 'value' as it
+  // is, if the queue is full.
+  bool TryPush(T&& value);
+
+  // Pops the oldest value into 'value' and returns true, or returns false if
+  // the queue is empty.
+  bool TryPop(T* value);
+
+  size_t capacity() const { return mask_ + 1; }
+
+  // The number of values in the queue, which may be stale by the time it's
+  // returned.
+  size_t ApproximateSize() const;
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  static size_t RoundUpCapacity(size_t capacity);
+
+  const size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+
+  // On separate cache lines, so that pushers and poppers don't contend.
+  alignas(64) std::atomic<size_t> enqueue_position_{0};
+  alignas(64) std::atomic<size_t> dequeue_position_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MpmcQueue);
+};
+
+//////////
+// Implementation details follow. API users need not read.
+
+template <typename T>
+size_t MpmcQueue<T>::RoundUpCapacity(size_t capacity) {
+  size_t rounded = 2;
+  while (rounded < capacity) {
+    rounded <<= 1;
+  }
+  return rounded;
+}
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity)
+    : mask_(RoundUpCapacity(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+  for (size_t i = 0; i <= mask_; ++i) {
+    cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+template <typename T>
+bool MpmcQueue<T>::TryPush(T&& value) {
+  size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell* cell = &cells_[position & mask_];
+    const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) -
+                                static_cast<std::ptrdiff_t>(position);
+    if (diff == 0) {
+      // The cell is free for this lap; claim it.
+      if (enqueue_position_.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The cell still holds the value of the previous lap.
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+bool MpmcQueue<T>::TryPop(T* value) {
+  size_t position = dequeue_position_.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell* cell = &cells_[position & mask_];
+    const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    const std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) -
+                                static_cast<std::ptrdiff_t>(position + 1);
+    if (diff == 0) {
+      // The cell is filled for this lap; claim it.
+      if (dequeue_position_.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+        *value = std::move(cell->value);
+        cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // The cell hasn't been filled yet.
+      return false;
+    } else {
+      position = dequeue_position_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+template <typename T>
+size_t MpmcQueue<T>::ApproximateSize() const {
+  const size_t dequeue_position =
+      dequeue_position_.load(std::memory_order_relaxed);
+  const size_t enqueue_position =
+      enqueue_position_.load(std::memory_order_relaxed);
+  return enqueue_position > dequeue_position
+             ? enqueue_position - dequeue_position
+             : 0;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_MPMC_QUEUE_H_
@@ -0,0 +1,99 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/mpmc_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(MpmcQueueTest, RoundsUpCapacity) {
+  EXPECT_EQ(2, MpmcQueue<int>(0).capacity());
+  EXPECT_EQ(8, MpmcQueue<int>(5).capacity());
+  EXPECT_EQ(8, MpmcQueue<int>(8).capacity());
+}
+
+TEST(MpmcQueueTest, FifoAndBounded) {
+  MpmcQueue<std::unique_ptr<int>> queue(4);
+  int value;
+  std::unique_ptr<int> popped;
+  EXPECT_FALSE(queue.TryPop(&popped));
+  for (value = 0; value < 4; ++value) {
+    EXPECT_TRUE(queue.TryPush(std::make_unique<int>(value)));
+  }
+  EXPECT_EQ(4, queue.ApproximateSize());
+
+  // A failed push leaves its value alone.
+  auto extra = std::make_unique<int>(4);
+  EXPECT_FALSE(queue.TryPush(std::move(extra)));
+  ASSERT_NE(nullptr, extra);
+
+  // Wraps around the ring buffer.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(queue.TryPop(&popped));
+      EXPECT_EQ(lap * 4 + i, *popped);
+      EXPECT_TRUE(queue.TryPush(std::make_unique<int>(value++)));
+    }
+  }
+  EXPECT_EQ(4, queue.ApproximateSize());
+}
+
+TEST(MpmcQueueTest, ConcurrentPushAndPop) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumValuesPerThread = 10000;
+  MpmcQueue<int> queue(16);
+  std::atomic<int64_t> popped_sum{0};
+  std::atomic<int> num_popped{0};
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < kNumThreads; ++i) {
+      threads.emplace_back(Env::Default()->StartThread({}, "pusher", [&]() {
+        for (int value = 1; value <= kNumValuesPerThread; ++value) {
+          int pushed = value;
+          while (!queue.TryPush(std::move(pushed))) {
+          }
+        }
+      }));
+      threads.emplace_back(Env::Default()->StartThread({}, "popper", [&]() {
+        while (num_popped.load() < kNumThreads * kNumValuesPerThread) {
+          int value;
+          if (queue.TryPop(&value)) {
+            popped_sum += value;
+            ++num_popped;
+          }
+        }
+      }));
+    }
+  }
+  // Every value is popped exactly once.
+  EXPECT_EQ(kNumThreads * kNumValuesPerThread, num_popped.load());
+  EXPECT_EQ(int64_t{kNumThreads} * kNumValuesPerThread *
+                (kNumValuesPerThread + 1) / 2,
+            popped_sum.load());
+  int value;
+  EXPECT_FALSE(queue.TryPop(&value));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
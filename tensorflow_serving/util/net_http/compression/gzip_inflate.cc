@@ -0,0 +1,398 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/net_http/compression/gzip_inflate.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#ifdef TF_SERVING_GZIP_LIBDEFLATE
+#include "libdeflate.h"
+#else
+#include <zlib.h>
+#endif
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_serving/util/net_http/internal/fixed_thread_pool.h"
+
+namespace tensorflow {
+namespace serving {
+namespace net_http {
+namespace {
+
+// A 10-byte header, an empty final stored block, and an 8-byte footer.
+constexpr size_t kMinMemberBytes = 20;
+
+// The first output buffer of a member is this many times its compressed size,
+// and at least kMinOutputBytes; it then doubles as needed.
+constexpr size_t kInitialInflateRatio = 4;
+constexpr size_t kMinOutputBytes = 64 * 1024;
+
+// Returns the size to grow the output buffer of a member of about 'hint'
+// compressed bytes to from 'capacity', up to 'limit'.
+size_t NextCapacity(size_t capacity, size_t hint, size_t limit) {
+  const size_t next =
+      capacity == 0 ? std::max(hint * kInitialInflateRatio, kMinOutputBytes)
+                    : capacity * 2;
+  return std::min(next, limit);
+}
+
+// Inflates the gzip member at the start of 'data' to 'output', and sets
+// 'consumed' to its compressed size. 'hint' is the expected compressed size of
+// the member. Returns false if the member is invalid or inflates to more than
+// 'max_bytes'.
+bool InflateMember(const uint8_t* data, size_t size, size_t hint,
+                   size_t max_bytes, std::string* output, size_t* consumed) {
+  // One past the max, to tell a member of exactly 'max_bytes' from a larger
+  // one.
+  const size_t limit = max_bytes + 1;
+#ifdef TF_SERVING_GZIP_LIBDEFLATE
+  libdeflate_decompressor* decompressor = libdeflate_alloc_decompressor();
+  if (decompressor == nullptr) {
+    return false;
+  }
+  // libdeflate needs room for the whole member, so is restarted on a larger
+  // buffer if it runs out.
+  size_t capacity = NextCapacity(0, hint, limit);
+  size_t in_bytes = 0;
+  size_t out_bytes = 0;
+  libdeflate_result result;
+  while (true) {
+    output->resize(capacity);
+    result = libdeflate_gzip_decompress_ex(decompressor, data, size,
+                                           &(*output)[0], capacity, &in_bytes,
+                                           &out_bytes);
+    if (result != LIBDEFLATE_INSUFFICIENT_SPACE || capacity >= limit) {
+      break;
+    }
+    capacity = NextCapacity(capacity, hint, limit);
+  }
+  libdeflate_free_decompressor(decompressor);
+  if (result != LIBDEFLATE_SUCCESS || out_bytes > max_bytes) {
+    return false;
+  }
+  output->resize(out_bytes);
+  *consumed = in_bytes;
+  return true;
+#else
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+    return false;
+  }
+  // zlib counts in uInt, so large buffers are handed over in chunks.
+  constexpr size_t kMaxChunkBytes = 1 << 30;
+  size_t in_offset = 0;
+  size_t out_offset = 0;
+  output->clear();
+  int err = Z_OK;
+  while (err == Z_OK) {
+    if (out_offset == output->size()) {
+      if (output->size() >= limit) {
+        break;  // exceeds 'max_bytes'
+      }
+      output->resize(NextCapacity(output->size(), hint, limit));
+    }
+    const uInt in_chunk =
+        static_cast<uInt>(std::min(size - in_offset, kMaxChunkBytes));
+    const uInt out_chunk = static_cast<uInt>(
+        std::min(output->size() - out_offset, kMaxChunkBytes));
+    stream.next_in = const_cast<Bytef*>(data + in_offset);
+    stream.avail_in = in_chunk;
+    stream.next_out = reinterpret_cast<Bytef*>(&(*output)[out_offset]);
+    stream.avail_out = out_chunk;
+    // Stops at the end of the member, rather than going on to the next one.
+    err = inflate(&stream, Z_NO_FLUSH);
+    in_offset += in_chunk - stream.avail_in;
+    out_offset += out_chunk - stream.avail_out;
+  }
+  inflateEnd(&stream);
+  if (err != Z_STREAM_END || out_offset > max_bytes) {
+    return false;
+  }
+  output->resize(out_offset);
+  *consumed = in_offset;
+  return true;
+#endif
+}
+
+// Returns the offsets in 'data' that may start a gzip member: the start, and
+// the offsets with the magic bytes, the deflate method and valid flags.
+std::vector<size_t> FindMemberCandidates(const uint8_t* data, size_t size) {
+  std::vector<size_t> starts = {0};
+  const uint8_t* const end = data + size;
+  const uint8_t* p = data + 1;
+  while (static_cast<size_t>(end - p) >= kMinMemberBytes) {
+    p = static_cast<const uint8_t*>(
+        memchr(p, 0x1f, (end - p) - kMinMemberBytes + 1));
+    if (p == nullptr) {
+      break;
+    }
+    if (p[1] == 0x8b && p[2] == 8 && (p[3] & 0xe0) == 0) {
+      starts.push_back(p - data);
+    }
+    ++p;
+  }
+  return starts;
+}
+
+bool InflateSequentially(const uint8_t* data, size_t size, size_t max_bytes,
+                         std::string* output) {
+  output->clear();
+  std::string member;
+  size_t offset = 0;
+  while (offset < size) {
+    size_t consumed = 0;
+    if (!InflateMember(data + offset, size - offset, size - offset,
+                       max_bytes - output->size(), &member, &consumed)) {
+      return false;
+    }
+    if (output->empty()) {
+      output->swap(member);
+    } else {
+      output->append(member);
+    }
+    offset += consumed;
+  }
+  return true;
+}
+
+// The pool the members of all the bodies inflated in parallel share, so that
+// concurrent requests queue for its threads rather than each start their own.
+FixedThreadPool* InflatePool() {
+  static FixedThreadPool* const pool = new FixedThreadPool(
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+  return pool;
+}
+
+// The inflation of the members of a body, shared by the calling thread and the
+// pool workers that help it.
+class ParallelInflate {
+ public:
+  ParallelInflate(const uint8_t* data, size_t size,
+                  const std::vector<size_t>& starts, size_t max_bytes)
+      : data_(data),
+        size_(size),
+        starts_(starts),
+        members_(starts.size()),
+        budget_(static_cast<int64_t>(max_bytes)) {}
+
+  // Inflates candidates until there are none left. Workers that join after
+  // the calling thread returned from Finish() do nothing.
+  void Work() {
+    {
+      absl::MutexLock l(&mu_);
+      if (finished_) {
+        return;
+      }
+      ++num_working_;
+    }
+    for (size_t i = next_.fetch_add(1); i < starts_.size() && !stopped_.load();
+         i = next_.fetch_add(1)) {
+      InflateCandidate(i);
+    }
+    absl::MutexLock l(&mu_);
+    --num_working_;
+  }
+
+  // Waits for the workers, and returns whether the members chained up from the
+  // start to the end of the body within the budget, appending them to 'output'
+  // if so. Sets 'exhausted' if the budget ran out.
+  bool Finish(std::string* output, bool* exhausted) {
+    absl::MutexLock l(&mu_);
+    finished_ = true;
+    mu_.Await(absl::Condition(
+        +[](int* num_working) { return *num_working == 0; }, &num_working_));
+    *exhausted = exhausted_.load();
+    if (*exhausted || chain_end_.load() != size_) {
+      return false;
+    }
+    size_t total_bytes = 0;
+    for (size_t i : chain_) {
+      total_bytes += members_[i].data.size();
+    }
+    output->clear();
+    output->reserve(total_bytes);
+    for (size_t i : chain_) {
+      output->append(members_[i].data);
+    }
+    return true;
+  }
+
+ private:
+  struct Member {
+    bool done = false;
+    bool ok = false;
+    size_t consumed = 0;
+    std::string data;
+  };
+
+  void InflateCandidate(size_t i) {
+    // Candidates inside a member already on the chain are false matches.
+    if (starts_[i] < chain_end_.load()) {
+      return;
+    }
+    const int64_t budget = budget_.load();
+    if (budget < 0) {
+      return;
+    }
+    const size_t hint =
+        (i + 1 < starts_.size() ? starts_[i + 1] : size_) - starts_[i];
+    Member member;
+    member.ok = InflateMember(data_ + starts_[i], size_ - starts_[i], hint,
+                              static_cast<size_t>(budget), &member.data,
+                              &member.consumed);
+    // Every candidate is charged what it inflated, or allocated if it failed,
+    // whether it turns out to be on the chain or not, so that false matches
+    // cannot inflate more than the body may in total.
+    const int64_t charge = static_cast<int64_t>(member.data.size());
+    if (budget_.fetch_sub(charge) < charge) {
+      exhausted_ = true;
+      stopped_ = true;
+    }
+    if (!member.ok) {
+      member.data.clear();
+      member.data.shrink_to_fit();
+    }
+    member.done = true;
+
+    absl::MutexLock l(&mu_);
+    if (i < chain_index_) {
+      // The chain passed over the candidate while it was inflated.
+      member.data.clear();
+      member.data.shrink_to_fit();
+    }
+    members_[i] = std::move(member);
+    AdvanceChain();
+  }
+
+  // Extends the chain of members from the start of the body over those that
+  // are inflated, and frees the members of the candidates it passed over.
+  void AdvanceChain() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    size_t offset = chain_end_.load();
+    while (offset < size_) {
+      auto start = std::lower_bound(starts_.begin() + chain_index_,
+                                    starts_.end(), offset);
+      if (start == starts_.end() || *start != offset) {
+        stopped_ = true;  // trailing bytes that don't start a member
+        return;
+      }
+      const size_t index = start - starts_.begin();
+      for (size_t i = chain_index_; i < index; ++i) {
+        if (chain_.empty() || i != chain_.back()) {
+          std::string().swap(members_[i].data);
+        }
+      }
+      chain_index_ = index;
+      const Member& member = members_[index];
+      if (!member.done) {
+        return;
+      }
+      if (!member.ok) {
+        stopped_ = true;
+        return;
+      }
+      chain_.push_back(index);
+      offset += member.consumed;
+      chain_end_ = offset;
+    }
+  }
+
+  const uint8_t* const data_;
+  const size_t size_;
+  const std::vector<size_t>& starts_;
+
+  // The next candidate to inflate.
+  std::atomic<size_t> next_{0};
+  // The bytes left for all the candidates to inflate; only ever decremented.
+  std::atomic<int64_t> budget_;
+  std::atomic<bool> exhausted_{false};
+  std::atomic<bool> stopped_{false};
+  // The end of the chain of members from the start of the body.
+  std::atomic<size_t> chain_end_{0};
+
+  absl::Mutex mu_;
+  std::vector<Member> members_ ABSL_GUARDED_BY(mu_);
+  // The candidates on the chain, in order, and the first candidate not before
+  // its end.
+  std::vector<size_t> chain_ ABSL_GUARDED_BY(mu_);
+  size_t chain_index_ ABSL_GUARDED_BY(mu_) = 0;
+  int num_working_ ABSL_GUARDED_BY(mu_) = 0;
+  bool finished_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+// Inflates the members at 'starts' on the calling thread and up to
+// 'num_threads' - 1 pool threads. Sets 'exhausted' if the candidates inflated
+// more than 'max_bytes' in total, in which case the body may still be valid.
+bool InflateInParallel(const uint8_t* data, size_t size,
+                       const std::vector<size_t>& starts, size_t max_bytes,
+                       int num_threads, std::string* output, bool* exhausted) {
+  auto inflate =
+      std::make_shared<ParallelInflate>(data, size, starts, max_bytes);
+  for (int i = 1; i < num_threads; ++i) {
+    InflatePool()->Schedule([inflate]() { inflate->Work(); });
+  }
+  inflate->Work();
+  return inflate->Finish(output, exhausted);
+}
+
+}  // namespace
+
+bool InflateGzip(absl::string_view input, const GzipInflateOptions& options,
+                 std::string* output) {
+  if (input.empty() || options.max_uncompressed_bytes < 0) {
+    return false;
+  }
+  const auto* data = reinterpret_cast<const uint8_t*>(input.data());
+  const size_t max_bytes = static_cast<size_t>(options.max_uncompressed_bytes);
+  if (input.size() >= options.min_parallel_bytes && options.max_threads > 1) {
+    const std::vector<size_t> starts = FindMemberCandidates(data, input.size());
+    // Bodies with too many candidates, most likely false matches, are not
+    // worth spreading.
+    if (starts.size() > 1 && starts.size() <= options.max_parallel_members) {
+      const int num_threads = static_cast<int>(
+          std::min<size_t>(options.max_threads, starts.size()));
+      bool exhausted = false;
+      if (InflateInParallel(data, input.size(), starts, max_bytes, num_threads,
+                            output, &exhausted)) {
+        return true;
+      }
+      // The false matches may have used up the budget of a valid body, which
+      // the sequential inflation tells apart.
+      if (!exhausted) {
+        return false;
+      }
+    }
+  }
+  return InflateSequentially(data, input.size(), max_bytes, output);
+}
+
+const char* GzipInflateBackend() {
+#ifdef TF_SERVING_GZIP_LIBDEFLATE
+  return "libdeflate";
+#else
+  return "zlib";
+#endif
+}
+
+}  // namespace net_http
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,77 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_NET_HTTP_COMPRESSION_GZIP_INFLATE_H_
+#define TENSORFLOW_SERVING_UTIL_NET_HTTP_COMPRESSION_GZIP_INFLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_serving/util/net_http/compression/gzip_zlib.h"
+
+namespace tensorflow {
+namespace serving {
+namespace net_http {
+
+// Inflates whole gzipped bodies, for callers that have received all of the
+// body, unlike the streaming ZLib::UncompressAtMost().
+//
+// The body may hold several gzip members, concatenated (RFC 1952 2.2), as
+// written by parallel compressors such as pigz or bgzip. The members of large
+// bodies are inflated in parallel: since member boundaries are only known once
+// the member before is inflated, a worker inflates one member from each offset
+// that starts with a gzip header, and the members that don't chain up from
+// the start of the body are discarded. A body of a single member is inflated
+// on the calling thread.
+//
+// All the candidate members of a body share its max_uncompressed_bytes: once
+// they have inflated (or, for the ones that failed, allocated) that much in
+// total, as they may if the body is crafted with false headers, the parallel
+// inflation stops and the body is inflated sequentially instead. Candidates
+// inside members already chained up are skipped, and the workers are the
+// threads of a pool shared by all the bodies.
+//
+// Members are inflated with libdeflate, if built with
+// --define=gzip_libdeflate=true, else with zlib.
+struct GzipInflateOptions {
+  // Fails bodies that inflate to more than this many bytes.
+  int64_t max_uncompressed_bytes = ZLib::kMaxUncompressedBytes;
+
+  // Bodies of at least this many compressed bytes are inflated in parallel,
+  // with up to 'max_threads' threads.
+  size_t min_parallel_bytes = 1024 * 1024;
+  int max_threads = 4;
+
+  // Bodies with more candidate members than this are inflated sequentially.
+  size_t max_parallel_members = 1024;
+};
+
+// Inflates all the gzip members of 'input' to 'output'. Returns false if
+// 'input' isn't a valid gzip stream (including trailing bytes after the last
+// member, or a member failing its CRC), or if it inflates to more than
+// options.max_uncompressed_bytes.
+bool InflateGzip(absl::string_view input, const GzipInflateOptions& options,
+                 std::string* output);
+
+// The library members are inflated with: "zlib" or "libdeflate".
+const char* GzipInflateBackend();
+
+}  // namespace net_http
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_NET_HTTP_COMPRESSION_GZIP_INFLATE_H_
@@ -0,0 +1,163 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/net_http/compression/gzip_inflate.h"
+
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow_serving/util/net_http/compression/gzip_zlib.h"
+
+namespace tensorflow {
+namespace serving {
+namespace net_http {
+namespace {
+
+std::string Gzip(const std::string& text,
+                 int level = Z_DEFAULT_COMPRESSION) {
+  uLongf size = ZLib::MinCompressbufSize(text.size());
+  std::string compressed(size, '\0');
+  ZLib zlib;
+  zlib.SetCompressionLevel(level);
+  EXPECT_EQ(Z_OK, zlib.Compress(reinterpret_cast<Bytef*>(&compressed[0]),
+                                &size,
+                                reinterpret_cast<const Bytef*>(text.data()),
+                                text.size()));
+  compressed.resize(size);
+  return compressed;
+}
+
+// Text that compresses, but not to nothing.
+std::string RandomText(std::mt19937* rng, size_t size) {
+  std::uniform_int_distribution<int> letter('a', 'p');
+  std::string text(size, '\0');
+  for (char& c : text) {
+    c = static_cast<char>(letter(*rng));
+  }
+  return text;
+}
+
+TEST(InflateGzipTest, SingleMember) {
+  std::mt19937 rng(1);
+  const std::string text = RandomText(&rng, 300 * 1024);
+  std::string output;
+  ASSERT_TRUE(InflateGzip(Gzip(text), GzipInflateOptions(), &output));
+  EXPECT_EQ(text, output);
+
+  ASSERT_TRUE(InflateGzip(Gzip(""), GzipInflateOptions(), &output));
+  EXPECT_EQ("", output);
+}
+
+TEST(InflateGzipTest, MultipleMembers) {
+  std::mt19937 rng(2);
+  std::string text;
+  std::string compressed;
+  for (int i = 0; i < 16; ++i) {
+    const std::string member = RandomText(&rng, (i + 1) * 10 * 1000);
+    absl::StrAppend(&text, member);
+    absl::StrAppend(&compressed, Gzip(member));
+  }
+
+  // Sequentially, and in parallel.
+  for (size_t min_parallel_bytes : {compressed.size() + 1, size_t{0}}) {
+    GzipInflateOptions options;
+    options.min_parallel_bytes = min_parallel_bytes;
+    std::string output;
+    ASSERT_TRUE(InflateGzip(compressed, options, &output));
+    EXPECT_EQ(text, output);
+  }
+}
+
+TEST(InflateGzipTest, MaxUncompressedBytes) {
+  const std::string text(1000, 'x');
+  const std::string compressed = absl::StrCat(Gzip(text), Gzip(text));
+  for (size_t min_parallel_bytes : {compressed.size() + 1, size_t{0}}) {
+    GzipInflateOptions options;
+    options.min_parallel_bytes = min_parallel_bytes;
+    options.max_uncompressed_bytes = 2000;
+    std::string output;
+    EXPECT_TRUE(InflateGzip(compressed, options, &output));
+    options.max_uncompressed_bytes = 1999;
+    EXPECT_FALSE(InflateGzip(compressed, options, &output));
+  }
+}
+
+TEST(InflateGzipTest, NestedFalseMembers) {
+  // A member stored uncompressed, holding members that each inflate to 16 MB:
+  // their headers are false matches, which would inflate to 4 GB in total if
+  // each had the whole budget.
+  const std::string nested = Gzip(std::string(16 << 20, 'x'));
+  std::string text;
+  for (int i = 0; i < 256; ++i) {
+    absl::StrAppend(&text, nested);
+  }
+  const std::string compressed = Gzip(text, /*level=*/0);
+  GzipInflateOptions options;
+  options.min_parallel_bytes = 0;
+  options.max_uncompressed_bytes = 2 * text.size();
+  std::string output;
+  ASSERT_TRUE(InflateGzip(compressed, options, &output));
+  EXPECT_EQ(text, output);
+
+  // Without a valid outer member, the body is rejected.
+  std::string corrupted = compressed;
+  corrupted[corrupted.size() - 8] ^= 1;
+  EXPECT_FALSE(InflateGzip(corrupted, options, &output));
+  options.max_uncompressed_bytes = text.size() - 1;
+  EXPECT_FALSE(InflateGzip(compressed, options, &output));
+}
+
+TEST(InflateGzipTest, ManyCandidateMembers) {
+  std::string text;
+  std::string compressed;
+  for (int i = 0; i < 8; ++i) {
+    absl::StrAppend(&text, "member ", i);
+    absl::StrAppend(&compressed, Gzip(absl::StrCat("member ", i)));
+  }
+  GzipInflateOptions options;
+  options.min_parallel_bytes = 0;
+  options.max_parallel_members = 4;
+  std::string output;
+  ASSERT_TRUE(InflateGzip(compressed, options, &output));
+  EXPECT_EQ(text, output);
+}
+
+TEST(InflateGzipTest, InvalidInput) {
+  std::mt19937 rng(3);
+  const std::string compressed = Gzip(RandomText(&rng, 100 * 1000));
+  for (size_t min_parallel_bytes : {compressed.size() + 1, size_t{0}}) {
+    GzipInflateOptions options;
+    options.min_parallel_bytes = min_parallel_bytes;
+    std::string output;
+    EXPECT_FALSE(InflateGzip("", options, &output));
+    EXPECT_FALSE(InflateGzip("not gzip", options, &output));
+    // Truncated.
+    EXPECT_FALSE(InflateGzip(compressed.substr(0, compressed.size() - 1),
+                             options, &output));
+    // Trailing bytes.
+    EXPECT_FALSE(InflateGzip(absl::StrCat(compressed, "x"), options, &output));
+    // Bad CRC.
+    std::string corrupted = compressed;
+    corrupted[corrupted.size() - 8] ^= 1;
+    EXPECT_FALSE(InflateGzip(corrupted, options, &output));
+  }
+}
+
+}  // namespace
+}  // namespace net_http
+}  // namespace serving
+}  // namespace tensorflow
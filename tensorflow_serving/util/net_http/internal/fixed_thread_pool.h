@@ -29,7 +29,8 @@ namespace tensorflow {
 namespace serving {
 namespace net_http {
 
-// A simple fixed-size ThreadPool implementation for tests.
+// A simple fixed-size ThreadPool implementation, for tests and for the work
+// of requests that is spread over threads (see InflateGzip()).
 // The initial version is copied from
 // absl/synchronization/internal/thread_pool.h
 class FixedThreadPool {
@@ -0,0 +1,539 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// HTTP/2 (h2c) sessions over libevent bufferevents, using nghttp2
+
+#include "tensorflow_serving/util/net_http/server/internal/evhttp2_session.h"
+
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "libevent/include/event2/buffer.h"
+#include "libevent/include/event2/bufferevent.h"
+#include "libevent/include/event2/event.h"
+#include "nghttp2/nghttp2.h"
+#include "tensorflow_serving/util/net_http/compression/gzip_inflate.h"
+#include "tensorflow_serving/util/net_http/internal/net_logging.h"
+#include "tensorflow_serving/util/net_http/public/header_names.h"
+
+namespace tensorflow {
+namespace serving {
+namespace net_http {
+
+namespace {
+
+// nghttp2 stops queueing frames for the connection beyond this much unsent
+// output, and resumes once the output has been written.
+constexpr size_t kMaxPendingOutputBytes = 64 << 10;
+
+nghttp2_nv MakeHeader(const std::string& name, const std::string& value) {
+  return {reinterpret_cast<uint8_t*>(const_cast<char*>(name.data())),
+          reinterpret_cast<uint8_t*>(const_cast<char*>(value.data())),
+          name.size(), value.size(), NGHTTP2_NV_FLAG_NONE};
+}
+
+}  // namespace
+
+EvHTTP2Request::EvHTTP2Request(int32_t stream_id,
+                               std::weak_ptr<EvHTTP2Session> session,
+                               ServerSupport* server)
+    : stream_id_(stream_id), session_(std::move(session)), server_(server) {}
+
+absl::string_view EvHTTP2Request::path() const {
+  absl::string_view path = path_and_query_;
+  return path.substr(0, path.find_first_of("?#"));
+}
+
+void EvHTTP2Request::WriteResponseBytes(const char* data, int64_t size) {
+  assert(size >= 0);
+  response_body_.append(data, static_cast<size_t>(size));
+}
+
+void EvHTTP2Request::WriteResponseString(absl::string_view data) {
+  WriteResponseBytes(data.data(), static_cast<int64_t>(data.size()));
+}
+
+void EvHTTP2Request::WriteResponseBuffer(std::string data) {
+  if (response_body_.empty()) {
+    response_body_ = std::move(data);
+  } else {
+    response_body_.append(data);
+  }
+}
+
+std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>
+EvHTTP2Request::ReadRequestBytes(int64_t* size) {
+  *size = 0;
+  if (request_body_read_ || request_body_.empty()) {
+    return nullptr;  // EOF, or no body
+  }
+  request_body_read_ = true;
+  if (!MaybeInflateRequestBody()) {
+    return nullptr;
+  }
+
+  char* block = std::allocator<char>().allocate(request_body_.size());
+  memcpy(block, request_body_.data(), request_body_.size());
+  *size = static_cast<int64_t>(request_body_.size());
+  std::string().swap(request_body_);
+  return std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>(
+      block, ServerRequestInterface::BlockDeleter(*size));
+}
+
+absl::string_view EvHTTP2Request::ReadRequestBody() {
+  if (!request_body_read_) {
+    request_body_read_ = true;
+    MaybeInflateRequestBody();
+  }
+  return request_body_;
+}
+
+bool EvHTTP2Request::MaybeInflateRequestBody() {
+  if (request_body_.empty() || handler_options_ == nullptr ||
+      !handler_options_->auto_uncompress_input() ||
+      !absl::StrContains(GetRequestHeader(HTTPHeaders::CONTENT_ENCODING),
+                         "gzip")) {
+    return true;
+  }
+  GzipInflateOptions inflate_options;
+  if (handler_options_->auto_uncompress_max_size() > 0) {
+    inflate_options.max_uncompressed_bytes =
+        handler_options_->auto_uncompress_max_size();
+  }
+  std::string inflated;
+  if (!InflateGzip(request_body_, inflate_options, &inflated)) {
+    NET_LOG(ERROR, "Failed to uncompress the gzipped body, or it exceeds "
+            "the max uncompressed size: %jd",
+            static_cast<intmax_t>(inflate_options.max_uncompressed_bytes));
+    std::string().swap(request_body_);
+    request_body_failed_ = true;
+    return false;
+  }
+  request_body_.swap(inflated);
+  return true;
+}
+
+absl::string_view EvHTTP2Request::GetRequestHeader(
+    absl::string_view header) const {
+  for (const Header& request_header : request_headers_) {
+    if (absl::EqualsIgnoreCase(request_header.first, header)) {
+      return request_header.second;
+    }
+  }
+  return absl::string_view();
+}
+
+std::vector<absl::string_view> EvHTTP2Request::request_headers() const {
+  std::vector<absl::string_view> result;
+  for (const Header& request_header : request_headers_) {
+    result.emplace_back(request_header.first);
+  }
+  return result;
+}
+
+void EvHTTP2Request::OverwriteResponseHeader(absl::string_view header,
+                                             absl::string_view value) {
+  response_headers_.erase(
+      std::remove_if(response_headers_.begin(), response_headers_.end(),
+                     [header](const Header& response_header) {
+                       return absl::EqualsIgnoreCase(response_header.first,
+                                                     header);
+                     }),
+      response_headers_.end());
+  AppendResponseHeader(header, value);
+}
+
+void EvHTTP2Request::AppendResponseHeader(absl::string_view header,
+                                          absl::string_view value) {
+  // HTTP/2 header names are lower case.
+  response_headers_.emplace_back(absl::AsciiStrToLower(header),
+                                 std::string(value));
+}
+
+// The response is sent whole by Reply(), so partial replies just keep
+// buffering it.
+void EvHTTP2Request::PartialReplyWithStatus(HTTPStatusCode status) {}
+
+void EvHTTP2Request::PartialReply() {}
+
+ServerRequestInterface::CallbackStatus
+EvHTTP2Request::PartialReplyWithFlushCallback(std::function<void()> callback) {
+  NET_LOG(FATAL, "PartialReplyWithStatus not implemented.");
+  return CallbackStatus::NOT_SCHEDULED;
+}
+
+void EvHTTP2Request::ReplyWithStatus(HTTPStatusCode status) {
+  bool result =
+      server_->EventLoopSchedule([this, status]() { EvSendReply(status); });
+
+  if (!result) {
+    NET_LOG(ERROR, "Failed to EventLoopSchedule ReplyWithStatus()");
+    ServerSupport* server = server_;
+    delete this;
+    server->DecOps();
+  }
+}
+
+void EvHTTP2Request::Reply() { ReplyWithStatus(HTTPStatusCode::OK); }
+
+void EvHTTP2Request::EvSendReply(HTTPStatusCode status) {
+  if (std::shared_ptr<EvHTTP2Session> session = session_.lock()) {
+    session->SubmitResponse(this, status);
+  }
+  ServerSupport* server = server_;
+  delete this;
+  server->DecOps();
+}
+
+void EvHTTP2Request::Abort() {
+  const int32_t stream_id = stream_id_;
+  std::weak_ptr<EvHTTP2Session> weak_session = session_;
+  ServerSupport* server = server_;
+  delete this;
+  // Reset the stream from the event loop
+  if (!server->EventLoopSchedule([stream_id, weak_session]() {
+        if (std::shared_ptr<EvHTTP2Session> session = weak_session.lock()) {
+          session->ResetStream(stream_id);
+        }
+      })) {
+    NET_LOG(ERROR, "Failed to EventLoopSchedule Abort()");
+  }
+  server->DecOps();
+}
+
+struct EvHTTP2Session::Callbacks {
+  static void ReadFn(bufferevent* bev, void* arg) {
+    auto session = static_cast<EvHTTP2Session*>(arg)->shared_from_this();
+    evbuffer* input = bufferevent_get_input(bev);
+    const size_t length = evbuffer_get_length(input);
+    const uint8_t* data = evbuffer_pullup(input, -1);
+    ssize_t read_length =
+        nghttp2_session_mem_recv(session->session_, data, length);
+    if (read_length < 0) {
+      NET_LOG(ERROR, "HTTP/2 session error: %s",
+              nghttp2_strerror(static_cast<int>(read_length)));
+      session->Close();
+      return;
+    }
+    evbuffer_drain(input, static_cast<size_t>(read_length));
+    session->Send();
+  }
+
+  static void WriteFn(bufferevent* bev, void* arg) {
+    auto session = static_cast<EvHTTP2Session*>(arg)->shared_from_this();
+    session->Send();
+  }
+
+  static void EventFn(bufferevent* bev, int16_t events, void* arg) {
+    auto session = static_cast<EvHTTP2Session*>(arg)->shared_from_this();
+    if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR | BEV_EVENT_TIMEOUT)) {
+      session->Close();
+    }
+  }
+
+  static ssize_t SendFn(nghttp2_session* ng_session, const uint8_t* data,
+                        size_t length, int flags, void* user_data) {
+    auto session = static_cast<EvHTTP2Session*>(user_data);
+    if (evbuffer_get_length(bufferevent_get_output(session->bev_)) >=
+        kMaxPendingOutputBytes) {
+      return NGHTTP2_ERR_WOULDBLOCK;
+    }
+    if (bufferevent_write(session->bev_, data, length) != 0) {
+      return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    return static_cast<ssize_t>(length);
+  }
+
+  static bool IsRequestHeaders(const nghttp2_frame* frame) {
+    return frame->hd.type == NGHTTP2_HEADERS &&
+           frame->headers.cat == NGHTTP2_HCAT_REQUEST;
+  }
+
+  static int OnBeginHeadersFn(nghttp2_session* ng_session,
+                              const nghttp2_frame* frame, void* user_data) {
+    if (IsRequestHeaders(frame)) {
+      static_cast<EvHTTP2Session*>(user_data)->OnBeginHeaders(
+          frame->hd.stream_id);
+    }
+    return 0;
+  }
+
+  static int OnHeaderFn(nghttp2_session* ng_session,
+                        const nghttp2_frame* frame, const uint8_t* name,
+                        size_t name_length, const uint8_t* value,
+                        size_t value_length, uint8_t flags, void* user_data) {
+    // Trailers are dropped
+    if (IsRequestHeaders(frame)) {
+      static_cast<EvHTTP2Session*>(user_data)->OnHeader(
+          frame->hd.stream_id,
+          absl::string_view(reinterpret_cast<const char*>(name), name_length),
+          absl::string_view(reinterpret_cast<const char*>(value),
+                            value_length));
+    }
+    return 0;
+  }
+
+  static int OnDataChunkFn(nghttp2_session* ng_session, uint8_t flags,
+                           int32_t stream_id, const uint8_t* data,
+                           size_t length, void* user_data) {
+    static_cast<EvHTTP2Session*>(user_data)->OnDataChunk(
+        stream_id,
+        absl::string_view(reinterpret_cast<const char*>(data), length));
+    return 0;
+  }
+
+  static int OnFrameRecvFn(nghttp2_session* ng_session,
+                           const nghttp2_frame* frame, void* user_data) {
+    if ((frame->hd.type == NGHTTP2_HEADERS ||
+         frame->hd.type == NGHTTP2_DATA) &&
+        (frame->hd.flags & NGHTTP2_FLAG_END_STREAM)) {
+      static_cast<EvHTTP2Session*>(user_data)->DispatchRequest(
+          frame->hd.stream_id);
+    }
+    return 0;
+  }
+
+  static int OnStreamCloseFn(nghttp2_session* ng_session, int32_t stream_id,
+                             uint32_t error_code, void* user_data) {
+    static_cast<EvHTTP2Session*>(user_data)->OnStreamClose(stream_id);
+    return 0;
+  }
+
+  static ssize_t ReadResponseBodyFn(nghttp2_session* ng_session,
+                                    int32_t stream_id, uint8_t* buf,
+                                    size_t length, uint32_t* data_flags,
+                                    nghttp2_data_source* source,
+                                    void* user_data) {
+    auto body = static_cast<ResponseBody*>(source->ptr);
+    const size_t copied = std::min(length, body->data.size() - body->offset);
+    memcpy(buf, body->data.data() + body->offset, copied);
+    body->offset += copied;
+    if (body->offset == body->data.size()) {
+      *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+    }
+    return static_cast<ssize_t>(copied);
+  }
+};
+
+EvHTTP2Session::EvHTTP2Session(bufferevent* bev, ServerSupport* server,
+                               Dispatcher dispatcher,
+                               CloseCallback close_callback)
+    : bev_(bev),
+      server_(server),
+      dispatcher_(std::move(dispatcher)),
+      close_callback_(std::move(close_callback)) {}
+
+EvHTTP2Session::~EvHTTP2Session() {
+  if (session_ != nullptr) {
+    nghttp2_session_del(session_);
+  }
+  if (bev_ != nullptr) {
+    bufferevent_free(bev_);
+  }
+}
+
+bool EvHTTP2Session::Start(uint32_t max_concurrent_streams) {
+  nghttp2_session_callbacks* callbacks;
+  if (nghttp2_session_callbacks_new(&callbacks) != 0) {
+    return false;
+  }
+  nghttp2_session_callbacks_set_send_callback(callbacks, &Callbacks::SendFn);
+  nghttp2_session_callbacks_set_on_begin_headers_callback(
+      callbacks, &Callbacks::OnBeginHeadersFn);
+  nghttp2_session_callbacks_set_on_header_callback(callbacks,
+                                                   &Callbacks::OnHeaderFn);
+  nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+      callbacks, &Callbacks::OnDataChunkFn);
+  nghttp2_session_callbacks_set_on_frame_recv_callback(
+      callbacks, &Callbacks::OnFrameRecvFn);
+  nghttp2_session_callbacks_set_on_stream_close_callback(
+      callbacks, &Callbacks::OnStreamCloseFn);
+  int result = nghttp2_session_server_new(&session_, callbacks, this);
+  nghttp2_session_callbacks_del(callbacks);
+  if (result != 0) {
+    NET_LOG(ERROR, "Failed to create an HTTP/2 session: %s",
+            nghttp2_strerror(result));
+    return false;
+  }
+
+  nghttp2_settings_entry settings[] = {
+      {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, max_concurrent_streams}};
+  result = nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, settings,
+                                   sizeof(settings) / sizeof(settings[0]));
+  if (result != 0) {
+    NET_LOG(ERROR, "Failed to submit HTTP/2 settings: %s",
+            nghttp2_strerror(result));
+    return false;
+  }
+
+  bufferevent_setcb(bev_, &Callbacks::ReadFn, &Callbacks::WriteFn,
+                    reinterpret_cast<bufferevent_event_cb>(&Callbacks::EventFn),
+                    this);
+  if (bufferevent_enable(bev_, EV_READ | EV_WRITE) != 0) {
+    return false;
+  }
+  return nghttp2_session_send(session_) == 0;
+}
+
+void EvHTTP2Session::OnBeginHeaders(int32_t stream_id) {
+  pending_requests_[stream_id] = std::unique_ptr<EvHTTP2Request>(
+      new EvHTTP2Request(stream_id, shared_from_this(), server_));
+}
+
+void EvHTTP2Session::OnHeader(int32_t stream_id, absl::string_view name,
+                              absl::string_view value) {
+  auto it = pending_requests_.find(stream_id);
+  if (it == pending_requests_.end()) {
+    return;
+  }
+  EvHTTP2Request* request = it->second.get();
+  if (name == ":method") {
+    request->method_ = std::string(value);
+  } else if (name == ":path") {
+    request->path_and_query_ = std::string(value);
+  } else if (name == ":authority") {
+    request->request_headers_.emplace_back("host", std::string(value));
+  } else if (!absl::StartsWith(name, ":")) {
+    request->request_headers_.emplace_back(std::string(name),
+                                           std::string(value));
+  }
+}
+
+void EvHTTP2Session::OnDataChunk(int32_t stream_id, absl::string_view data) {
+  auto it = pending_requests_.find(stream_id);
+  if (it != pending_requests_.end()) {
+    it->second->request_body_.append(data.data(), data.size());
+  }
+}
+
+void EvHTTP2Session::OnStreamClose(int32_t stream_id) {
+  // Requests that are being handled find out when they reply.
+  pending_requests_.erase(stream_id);
+  response_bodies_.erase(stream_id);
+}
+
+void EvHTTP2Session::DispatchRequest(int32_t stream_id) {
+  auto it = pending_requests_.find(stream_id);
+  if (it == pending_requests_.end()) {
+    return;
+  }
+  std::unique_ptr<EvHTTP2Request> request = std::move(it->second);
+  pending_requests_.erase(it);
+  if (dispatcher_(&request)) {
+    return;
+  }
+  const std::string status_name = ":status";
+  const std::string status =
+      std::to_string(static_cast<int>(HTTPStatusCode::NOT_FOUND));
+  nghttp2_nv headers[] = {MakeHeader(status_name, status)};
+  nghttp2_submit_response(session_, stream_id, headers, 1, nullptr);
+}
+
+void EvHTTP2Session::SubmitResponse(EvHTTP2Request* request,
+                                    HTTPStatusCode status) {
+  const int32_t stream_id = request->stream_id_;
+  if (closed_ || nghttp2_session_find_stream(session_, stream_id) == nullptr) {
+    return;  // the client has gone
+  }
+
+  const std::string status_name = ":status";
+  const std::string status_value = std::to_string(static_cast<int>(status));
+  const std::string content_length_name = "content-length";
+  const std::string content_length =
+      std::to_string(request->response_body_.size());
+  std::vector<nghttp2_nv> headers;
+  headers.reserve(request->response_headers_.size() + 2);
+  headers.push_back(MakeHeader(status_name, status_value));
+  bool has_content_length = false;
+  for (const EvHTTP2Request::Header& header : request->response_headers_) {
+    has_content_length |= header.first == content_length_name;
+    headers.push_back(MakeHeader(header.first, header.second));
+  }
+  if (!has_content_length) {
+    headers.push_back(MakeHeader(content_length_name, content_length));
+  }
+
+  int result;
+  if (request->response_body_.empty()) {
+    result = nghttp2_submit_response(session_, stream_id, headers.data(),
+                                     headers.size(), nullptr);
+  } else {
+    ResponseBody& body = response_bodies_[stream_id];
+    body.data = std::move(request->response_body_);
+    nghttp2_data_provider data_provider;
+    data_provider.source.ptr = &body;
+    data_provider.read_callback = &Callbacks::ReadResponseBodyFn;
+    result = nghttp2_submit_response(session_, stream_id, headers.data(),
+                                     headers.size(), &data_provider);
+  }
+  if (result != 0) {
+    NET_LOG(ERROR, "Failed to submit an HTTP/2 response: %s",
+            nghttp2_strerror(result));
+    response_bodies_.erase(stream_id);
+  }
+  Send();
+}
+
+void EvHTTP2Session::ResetStream(int32_t stream_id) {
+  if (closed_ || nghttp2_session_find_stream(session_, stream_id) == nullptr) {
+    return;
+  }
+  nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, stream_id,
+                            NGHTTP2_INTERNAL_ERROR);
+  Send();
+}
+
+bool EvHTTP2Session::Send() {
+  if (closed_) {
+    return false;
+  }
+  int result = nghttp2_session_send(session_);
+  if (result != 0) {
+    NET_LOG(ERROR, "HTTP/2 session error: %s", nghttp2_strerror(result));
+    Close();
+    return false;
+  }
+  if (nghttp2_session_want_read(session_) == 0 &&
+      nghttp2_session_want_write(session_) == 0 &&
+      evbuffer_get_length(bufferevent_get_output(bev_)) == 0) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void EvHTTP2Session::Close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  pending_requests_.clear();
+  bufferevent_disable(bev_, EV_READ | EV_WRITE);
+  // May destroy this, once the caller's reference is gone.
+  close_callback_(this);
+}
+
+}  // namespace net_http
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,223 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// HTTP/2 (h2c) sessions over libevent bufferevents, using nghttp2
+
+#ifndef TENSORFLOW_SERVING_UTIL_NET_HTTP_SERVER_INTERNAL_EVHTTP2_SESSION_H_
+#define TENSORFLOW_SERVING_UTIL_NET_HTTP_SERVER_INTERNAL_EVHTTP2_SESSION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_serving/util/net_http/server/internal/server_support.h"
+#include "tensorflow_serving/util/net_http/server/public/httpserver_interface.h"
+#include "tensorflow_serving/util/net_http/server/public/server_request_interface.h"
+
+struct bufferevent;
+struct nghttp2_session;
+
+namespace tensorflow {
+namespace serving {
+namespace net_http {
+
+class EvHTTP2Session;
+
+// A request on a stream of an HTTP/2 session. The request is received in full
+// before it is dispatched, and the response is sent by Reply(); partial
+// replies are buffered till then.
+//
+// Thread-compatible. See ServerRequestInterface on the exact contract
+// between the server runtime and application handlers.
+class EvHTTP2Request final : public ServerRequestInterface {
+ public:
+  ~EvHTTP2Request() override = default;
+
+  EvHTTP2Request(const EvHTTP2Request& other) = delete;
+  EvHTTP2Request& operator=(const EvHTTP2Request& other) = delete;
+
+  // Doesn't own the server
+  EvHTTP2Request(int32_t stream_id, std::weak_ptr<EvHTTP2Session> session,
+                 ServerSupport* server);
+
+  absl::string_view uri_path() const override { return path_and_query_; }
+
+  absl::string_view http_method() const override { return method_; }
+
+  void WriteResponseBytes(const char* data, int64_t size) override;
+
+  void WriteResponseString(absl::string_view data) override;
+
+  void WriteResponseBuffer(std::string data) override;
+
+  std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>
+  ReadRequestBytes(int64_t* size) override;
+
+  absl::string_view ReadRequestBody() override;
+
+  absl::string_view GetRequestHeader(absl::string_view header) const override;
+
+  std::vector<absl::string_view> request_headers() const override;
+
+  void OverwriteResponseHeader(absl::string_view header,
+                               absl::string_view value) override;
+  void AppendResponseHeader(absl::string_view header,
+                            absl::string_view value) override;
+
+  void PartialReplyWithStatus(HTTPStatusCode status) override;
+  void PartialReply() override;
+
+  CallbackStatus PartialReplyWithFlushCallback(
+      std::function<void()> callback) override;
+
+  void ReplyWithStatus(HTTPStatusCode status) override;
+  void Reply() override;
+
+  void Abort() override;
+
+  BodyStatus request_body_status() override {
+    return request_body_failed_ ? BodyStatus::FAILED : BodyStatus::COMPLETE;
+  }
+
+  // Keeps a reference to the registered RequestHandlerOptions
+  void SetHandlerOptions(const RequestHandlerOptions& handler_options) {
+    handler_options_ = &handler_options;
+  }
+
+  // The path of the request URI, without the query or fragment, to dispatch
+  // the request by.
+  absl::string_view path() const;
+
+ private:
+  friend class EvHTTP2Session;
+
+  typedef std::pair<std::string, std::string> Header;
+
+  // Sends the response from the event loop, and releases this.
+  void EvSendReply(HTTPStatusCode status);
+
+  // Uncompresses the request body in place if it is gzipped and the handler
+  // options allow. Returns false, and empties the body, if it fails to.
+  bool MaybeInflateRequestBody();
+
+  const int32_t stream_id_;
+  const std::weak_ptr<EvHTTP2Session> session_;
+  ServerSupport* const server_;
+
+  const RequestHandlerOptions* handler_options_ = nullptr;
+
+  // Set by the session while receiving the request.
+  std::string method_;
+  std::string path_and_query_ = "/";
+  std::vector<Header> request_headers_;
+  std::string request_body_;
+  bool request_body_read_ = false;
+  bool request_body_failed_ = false;
+
+  std::vector<Header> response_headers_;
+  std::string response_body_;
+};
+
+// An HTTP/2 session over a connection that speaks h2c with prior knowledge,
+// i.e. starts with the HTTP/2 connection preface. Streams are multiplexed on
+// the connection, and their headers HPACK-compressed, by nghttp2.
+//
+// Must only be used from the event loop of its connection.
+class EvHTTP2Session final
+    : public std::enable_shared_from_this<EvHTTP2Session> {
+ public:
+  // Schedules the handler of a request. Returns false, leaving 'request'
+  // alone, if no handler is registered for it.
+  typedef std::function<bool(std::unique_ptr<EvHTTP2Request>* request)>
+      Dispatcher;
+
+  // Called once the connection is closed, after which the session may be
+  // destroyed.
+  typedef std::function<void(EvHTTP2Session* session)> CloseCallback;
+
+  // Takes the ownership of 'bev'. Requests reply through 'server', which must
+  // schedule on the same event loop as 'bev'.
+  EvHTTP2Session(bufferevent* bev, ServerSupport* server,
+                 Dispatcher dispatcher, CloseCallback close_callback);
+  ~EvHTTP2Session();
+
+  EvHTTP2Session(const EvHTTP2Session& other) = delete;
+  EvHTTP2Session& operator=(const EvHTTP2Session& other) = delete;
+
+  // Sends the server connection preface and starts reading requests. Returns
+  // false if any error, in which case the session is to be destroyed, which
+  // closes the connection.
+  bool Start(uint32_t max_concurrent_streams);
+
+ private:
+  friend class EvHTTP2Request;
+
+  // The body of a response that is being sent.
+  struct ResponseBody {
+    std::string data;
+    size_t offset = 0;
+  };
+
+  // Submits the response of 'request', unless its stream has been closed.
+  void SubmitResponse(EvHTTP2Request* request, HTTPStatusCode status);
+
+  // Resets the stream of an aborted request, unless it has been closed.
+  void ResetStream(int32_t stream_id);
+
+  // Sends what nghttp2 has queued, then closes the connection if the session
+  // is done. Returns false if the connection got closed.
+  bool Send();
+
+  void Close();
+
+  // The libevent and nghttp2 callbacks, which call the methods below.
+  struct Callbacks;
+
+  void OnBeginHeaders(int32_t stream_id);
+  void OnHeader(int32_t stream_id, absl::string_view name,
+                absl::string_view value);
+  void OnDataChunk(int32_t stream_id, absl::string_view data);
+  void OnStreamClose(int32_t stream_id);
+
+  // Dispatches the request on 'stream_id', which has been received in full.
+  void DispatchRequest(int32_t stream_id);
+
+  bufferevent* bev_;
+  ServerSupport* const server_;
+  const Dispatcher dispatcher_;
+  const CloseCallback close_callback_;
+
+  nghttp2_session* session_ = nullptr;
+  bool closed_ = false;
+
+  // The requests being received, by stream.
+  std::unordered_map<int32_t, std::unique_ptr<EvHTTP2Request>>
+      pending_requests_;
+
+  // The bodies of the responses being sent, by stream.
+  std::unordered_map<int32_t, ResponseBody> response_bodies_;
+};
+
+}  // namespace net_http
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_NET_HTTP_SERVER_INTERNAL_EVHTTP2_SESSION_H_
@@ -0,0 +1,256 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/net_http/server/internal/evhttp2_session.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/memory/memory.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "nghttp2/nghttp2.h"
+#include "tensorflow_serving/util/net_http/internal/fixed_thread_pool.h"
+#include "tensorflow_serving/util/net_http/server/internal/evhttp_server.h"
+#include "tensorflow_serving/util/net_http/server/public/httpserver_interface.h"
+#include "tensorflow_serving/util/net_http/server/public/server_request_interface.h"
+
+namespace tensorflow {
+namespace serving {
+namespace net_http {
+namespace {
+
+class MyExecutor final : public EventExecutor {
+ public:
+  explicit MyExecutor(int num_threads) : thread_pool_(num_threads) {}
+
+  void Schedule(std::function<void()> fn) override {
+    thread_pool_.Schedule(fn);
+  }
+
+ private:
+  FixedThreadPool thread_pool_;
+};
+
+struct TestResponse {
+  int status = 0;
+  std::string body;
+};
+
+// A blocking h2c client, with prior knowledge, over one connection.
+class TestHttp2Client {
+ public:
+  ~TestHttp2Client() {
+    if (session_ != nullptr) {
+      nghttp2_session_del(session_);
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  bool Connect(int port) {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&addr),
+                           sizeof(addr)) != 0) {
+      return false;
+    }
+
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_send_callback(callbacks, &SendFn);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, &OnHeaderFn);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+        callbacks, &OnDataChunkFn);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks,
+                                                           &OnStreamCloseFn);
+    int result = nghttp2_session_client_new(&session_, callbacks, this);
+    nghttp2_session_callbacks_del(callbacks);
+    return result == 0 &&
+           nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, nullptr,
+                                   0) == 0;
+  }
+
+  // Sends GET requests for all 'paths' on concurrent streams, and returns
+  // their responses in the same order.
+  std::vector<TestResponse> GetAll(const std::vector<std::string>& paths) {
+    std::vector<int32_t> stream_ids;
+    for (const std::string& path : paths) {
+      const std::string method = "GET";
+      const std::string scheme = "http";
+      const std::string authority = "localhost";
+      nghttp2_nv headers[] = {MakeHeader(":method", method),
+                              MakeHeader(":scheme", scheme),
+                              MakeHeader(":authority", authority),
+                              MakeHeader(":path", path)};
+      stream_ids.push_back(nghttp2_submit_request(session_, nullptr, headers,
+                                                  4, nullptr, nullptr));
+    }
+
+    num_open_streams_ = paths.size();
+    while (num_open_streams_ > 0) {
+      if (nghttp2_session_send(session_) != 0) {
+        break;
+      }
+      uint8_t buf[4096];
+      ssize_t length = read(fd_, buf, sizeof(buf));
+      if (length <= 0 || nghttp2_session_mem_recv(session_, buf, length) < 0) {
+        break;
+      }
+    }
+
+    std::vector<TestResponse> result;
+    for (int32_t stream_id : stream_ids) {
+      result.push_back(responses_[stream_id]);
+    }
+    return result;
+  }
+
+ private:
+  static nghttp2_nv MakeHeader(const char* name, const std::string& value) {
+    return {reinterpret_cast<uint8_t*>(const_cast<char*>(name)),
+            reinterpret_cast<uint8_t*>(const_cast<char*>(value.data())),
+            strlen(name), value.size(), NGHTTP2_NV_FLAG_NONE};
+  }
+
+  static ssize_t SendFn(nghttp2_session* session, const uint8_t* data,
+                        size_t length, int flags, void* user_data) {
+    auto client = static_cast<TestHttp2Client*>(user_data);
+    return write(client->fd_, data, length);
+  }
+
+  static int OnHeaderFn(nghttp2_session* session, const nghttp2_frame* frame,
+                        const uint8_t* name, size_t name_length,
+                        const uint8_t* value, size_t value_length,
+                        uint8_t flags, void* user_data) {
+    auto client = static_cast<TestHttp2Client*>(user_data);
+    if (std::string(reinterpret_cast<const char*>(name), name_length) ==
+        ":status") {
+      client->responses_[frame->hd.stream_id].status = std::stoi(
+          std::string(reinterpret_cast<const char*>(value), value_length));
+    }
+    return 0;
+  }
+
+  static int OnDataChunkFn(nghttp2_session* session, uint8_t flags,
+                           int32_t stream_id, const uint8_t* data,
+                           size_t length, void* user_data) {
+    auto client = static_cast<TestHttp2Client*>(user_data);
+    client->responses_[stream_id].body.append(
+        reinterpret_cast<const char*>(data), length);
+    return 0;
+  }
+
+  static int OnStreamCloseFn(nghttp2_session* session, int32_t stream_id,
+                             uint32_t error_code, void* user_data) {
+    static_cast<TestHttp2Client*>(user_data)->num_open_streams_--;
+    return 0;
+  }
+
+  int fd_ = -1;
+  nghttp2_session* session_ = nullptr;
+  int num_open_streams_ = 0;
+  std::map<int32_t, TestResponse> responses_;
+};
+
+class EvHTTP2SessionTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    auto options = absl::make_unique<ServerOptions>();
+    options->AddPort(0);
+    options->SetHttp2Port(0);
+    options->SetExecutor(absl::make_unique<MyExecutor>(8));
+    server_ = absl::make_unique<EvHTTPServer>(std::move(options));
+    ASSERT_TRUE(server_->Initialize());
+  }
+
+  void TearDown() override {
+    server_->Terminate();
+    server_->WaitForTermination();
+  }
+
+ protected:
+  std::unique_ptr<EvHTTPServer> server_;
+};
+
+TEST_F(EvHTTP2SessionTest, ServesRegisteredHandlers) {
+  server_->RegisterRequestHandler(
+      "/echo",
+      [](ServerRequestInterface* request) {
+        request->WriteResponseString(request->uri_path());
+        request->Reply();
+      },
+      RequestHandlerOptions());
+  ASSERT_TRUE(server_->StartAcceptingRequests());
+  ASSERT_GT(server_->http2_listen_port(), 0);
+
+  TestHttp2Client client;
+  ASSERT_TRUE(client.Connect(server_->http2_listen_port()));
+  std::vector<TestResponse> responses =
+      client.GetAll({"/echo?a=1", "/missing"});
+  ASSERT_EQ(2, responses.size());
+  EXPECT_EQ(200, responses[0].status);
+  EXPECT_EQ("/echo?a=1", responses[0].body);
+  EXPECT_EQ(404, responses[1].status);
+}
+
+TEST_F(EvHTTP2SessionTest, MultiplexesConcurrentRequests) {
+  constexpr int kNumRequests = 4;
+  // Each handler waits for all of them, so the requests are only served if
+  // they are in flight on the connection at the same time.
+  absl::BlockingCounter all_received(kNumRequests);
+  server_->RegisterRequestHandler(
+      "/wait",
+      [&all_received](ServerRequestInterface* request) {
+        all_received.DecrementCount();
+        all_received.Wait();
+        request->WriteResponseString(request->uri_path());
+        request->Reply();
+      },
+      RequestHandlerOptions());
+  ASSERT_TRUE(server_->StartAcceptingRequests());
+
+  TestHttp2Client client;
+  ASSERT_TRUE(client.Connect(server_->http2_listen_port()));
+  std::vector<std::string> paths;
+  for (int i = 0; i < kNumRequests; ++i) {
+    paths.push_back("/wait?i=" + std::to_string(i));
+  }
+  std::vector<TestResponse> responses = client.GetAll(paths);
+  ASSERT_EQ(kNumRequests, responses.size());
+  for (int i = 0; i < kNumRequests; ++i) {
+    EXPECT_EQ(200, responses[i].status);
+    EXPECT_EQ(paths[i], responses[i].body);
+  }
+}
+
+}  // namespace
+}  // namespace net_http
+}  // namespace serving
+}  // namespace tensorflow
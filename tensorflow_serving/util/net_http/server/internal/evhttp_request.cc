@@ -29,13 +29,17 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
-#include "absl/types/span.h"
+#include "absl/types/optional.h"
 #include "libevent/include/event2/buffer.h"
 #include "libevent/include/event2/event.h"
 #include "libevent/include/event2/http.h"
 #include "libevent/include/event2/keyvalq_struct.h"
+#include "tensorflow_serving/util/net_http/compression/gzip_inflate.h"
 #include "tensorflow_serving/util/net_http/compression/gzip_zlib.h"
 #include "tensorflow_serving/util/net_http/internal/net_logging.h"
 #include "tensorflow_serving/util/net_http/public/header_names.h"
@@ -44,6 +48,47 @@ namespace tensorflow {
 namespace serving {
 namespace net_http {
 
+namespace {
+
+// The size of the blocks a gzipped request body is inflated in, which bounds
+// the memory held for inflating beyond the body itself.
+constexpr size_t kInflateBlockBytes = 256 * 1024;
+
+// Smaller buffers passed to WriteResponseBuffer() are copied, which is cheaper
+// than referencing them.
+constexpr size_t kMinReferencedResponseBytes = 16 * 1024;
+
+// Passed to zlib for empty input.
+const unsigned char kNoInput[1] = {0};
+
+// Returns true if the Accept-Encoding header 'accept_encoding' accepts gzip,
+// by name or by "*", with a non-zero quality value.
+bool AcceptsGzip(absl::string_view accept_encoding) {
+  absl::optional<bool> accepts_gzip;
+  bool accepts_any = false;
+  for (absl::string_view coding : absl::StrSplit(accept_encoding, ',')) {
+    std::vector<absl::string_view> params = absl::StrSplit(coding, ';');
+    const absl::string_view name = absl::StripAsciiWhitespace(params[0]);
+    double quality = 1;
+    for (size_t i = 1; i < params.size(); ++i) {
+      const absl::string_view param = absl::StripAsciiWhitespace(params[i]);
+      if (absl::StartsWithIgnoreCase(param, "q=") &&
+          !absl::SimpleAtod(param.substr(2), &quality)) {
+        quality = 0;
+      }
+    }
+    if (absl::EqualsIgnoreCase(name, "gzip") ||
+        absl::EqualsIgnoreCase(name, "x-gzip")) {
+      accepts_gzip = quality > 0;
+    } else if (name == "*") {
+      accepts_any = quality > 0;
+    }
+  }
+  return accepts_gzip.value_or(accepts_any);
+}
+
+}  // namespace
+
 ParsedEvRequest::~ParsedEvRequest() {
   if (decoded_uri) {
     evhttp_uri_free(decoded_uri);
@@ -142,10 +187,26 @@ absl::string_view EvHTTPRequest::http_method() const {
 }
 
 bool EvHTTPRequest::Initialize() {
-  output_buf = evbuffer_new();
+  if (output_buf == nullptr) {
+    output_buf = evbuffer_new();
+  }
   return output_buf != nullptr;
 }
 
+void EvHTTPRequest::Reset(std::unique_ptr<ParsedEvRequest> request) {
+  parsed_request_ = std::move(request);
+  handler_options_ = nullptr;
+  inflater_.reset();
+  inflated_bytes_ = 0;
+  inflate_done_ = false;
+  request_body_failed_ = false;
+  reply_started_ = false;
+  // evhttp_send_reply() has drained the buffer, unless the reply failed.
+  if (output_buf != nullptr) {
+    evbuffer_drain(output_buf, evbuffer_get_length(output_buf));
+  }
+}
+
 void EvHTTPRequest::WriteResponseBytes(const char* data, int64_t size) {
   assert(size >= 0);
   if (output_buf == nullptr) {
@@ -164,6 +225,31 @@ void EvHTTPRequest::WriteResponseString(absl::string_view data) {
   WriteResponseBytes(data.data(), static_cast<int64_t>(data.size()));
 }
 
+void EvHTTPRequest::WriteResponseBuffer(std::string data) {
+  if (data.size() < kMinReferencedResponseBytes) {
+    WriteResponseString(data);
+    return;
+  }
+  if (output_buf == nullptr) {
+    NET_LOG(FATAL, "Request not initialized.");
+    return;
+  }
+
+  // The output buffer references the data, which is freed once sent.
+  auto* buffer = new std::string(std::move(data));
+  const int ret = evbuffer_add_reference(
+      output_buf, buffer->data(), buffer->size(),
+      [](const void* data, size_t size, void* arg) {
+        delete static_cast<std::string*>(arg);
+      },
+      buffer);
+  if (ret == -1) {
+    NET_LOG(ERROR, "Failed to write %zu bytes data to output buffer",
+            buffer->size());
+    delete buffer;
+  }
+}
+
 std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>
 EvHTTPRequest::ReadRequestBytes(int64_t* size) {
   evbuffer* input_buf =
@@ -173,17 +259,16 @@ EvHTTPRequest::ReadRequestBytes(int64_t* size) {
     return nullptr;  // no body
   }
 
-  // possible a reentry after gzip uncompression
+  // Uncompress the body a block at a time
+  if (NeedUncompressGzipContent()) {
+    return ReadRequestGzipBytes(input_buf, size);
+  }
+
   if (evbuffer_get_length(input_buf) == 0) {
     *size = 0;
     return nullptr;  // EOF
   }
 
-  // Uncompress the entire body
-  if (NeedUncompressGzipContent()) {
-    return ReadRequestGzipBytes(input_buf, size);
-  }
-
   auto buf_size = reinterpret_cast<size_t*>(size);
 
   *buf_size = evbuffer_get_contiguous_space(input_buf);
@@ -206,57 +291,137 @@ EvHTTPRequest::ReadRequestBytes(int64_t* size) {
 
 std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>
 EvHTTPRequest::ReadRequestGzipBytes(evbuffer* input_buf, int64_t* size) {
-  std::vector<absl::Span<char>> buf_list;
-
-  size_t body_length = 0;
-  while (true) {
-    auto buf_size = evbuffer_get_contiguous_space(input_buf);
-
-    if (buf_size == 0) {
-      break;  // EOF
+  *size = 0;
+  if (inflate_done_) {
+    return nullptr;  // EOF
+  }
+  const int64_t max = MaxUncompressedBytes();
+  if (inflater_ == nullptr) {
+    const size_t body_size = evbuffer_get_length(input_buf);
+    if (body_size == 0) {
+      return nullptr;  // no body
     }
-
-    char* block = std::allocator<char>().allocate(buf_size);
-    int ret = evbuffer_remove(input_buf, block, buf_size);
-    if (ret != buf_size) {
-      NET_LOG(ERROR, "Unexpected: read less than specified num_bytes : %zu",
-              buf_size);
-      std::allocator<char>().deallocate(block, buf_size);
-      for (auto buf : buf_list) {
-        std::allocator<char>().deallocate(buf.data(), buf.size());
+    // Large bodies are inflated at once, in parallel if they have several
+    // gzip members.
+    GzipInflateOptions inflate_options;
+    inflate_options.max_uncompressed_bytes = max;
+    if (body_size >= inflate_options.min_parallel_bytes) {
+      inflate_done_ = true;
+      const absl::string_view body(
+          reinterpret_cast<const char*>(evbuffer_pullup(input_buf, -1)),
+          body_size);
+      std::string inflated;
+      if (!InflateGzip(body, inflate_options, &inflated)) {
+        NET_LOG(ERROR, "Failed to uncompress the gzipped body, or it exceeds "
+                "the max uncompressed size: %jd", static_cast<intmax_t>(max));
+        request_body_failed_ = true;
+        return nullptr;
+      }
+      evbuffer_drain(input_buf, body_size);
+      if (inflated.empty()) {
+        return nullptr;  // EOF
       }
-      *size = 0;
-      return nullptr;  // don't return corrupted buffer
+      char* block = std::allocator<char>().allocate(inflated.size());
+      memcpy(block, inflated.data(), inflated.size());
+      *size = static_cast<int64_t>(inflated.size());
+      return std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>(
+          block, ServerRequestInterface::BlockDeleter(inflated.size()));
     }
-
-    body_length += buf_size;
-    buf_list.emplace_back(block, buf_size);
+    inflater_ = std::make_unique<ZLib>();
   }
 
-  char* comp_body = std::allocator<char>().allocate(body_length);
+  auto fail = [this](char* block) {
+    std::allocator<char>().deallocate(block, kInflateBlockBytes);
+    inflate_done_ = true;
+    request_body_failed_ = true;
+    return nullptr;
+  };
+
+  // The whole body has been received, so inflate till the block is full or
+  // there is nothing left to inflate.
+  char* block = std::allocator<char>().allocate(kInflateBlockBytes);
+  size_t block_size = 0;
+  while (block_size < kInflateBlockBytes) {
+    const size_t input_size = evbuffer_get_contiguous_space(input_buf);
+    const unsigned char* input =
+        input_size > 0 ? evbuffer_pullup(input_buf, input_size) : kNoInput;
+    uLong input_left = input_size;
+    uLongf output_size = kInflateBlockBytes - block_size;
+    const int err = inflater_->UncompressAtMost(
+        reinterpret_cast<Bytef*>(block + block_size), &output_size, input,
+        &input_left);
+    if (err != Z_OK && err != Z_BUF_ERROR) {
+      NET_LOG(ERROR, "Failed to uncompress the gzipped body: %d", err);
+      return fail(block);
+    }
+    evbuffer_drain(input_buf, input_size - input_left);
+    block_size += output_size;
+    if (output_size == 0 && input_left == input_size) {
+      break;  // no more input, and no pending output
+    }
+  }
 
-  size_t pos = 0;
-  for (auto buf : buf_list) {
-    memcpy(comp_body + pos, buf.data(), buf.size());
-    pos += buf.size();
-    std::allocator<char>().deallocate(buf.data(), buf.size());
+  inflated_bytes_ += block_size;
+  if (inflated_bytes_ > max) {
+    NET_LOG(ERROR, "The gzipped body exceeds the max uncompressed size: %jd",
+            static_cast<intmax_t>(max));
+    return fail(block);
+  }
+  if (block_size < kInflateBlockBytes) {
+    inflate_done_ = true;
+    if (!inflater_->UncompressChunkDone()) {
+      NET_LOG(ERROR, "Failed to uncompress the gzipped body: truncated or "
+              "corrupted stream");
+      return fail(block);
+    }
+    if (block_size == 0) {
+      std::allocator<char>().deallocate(block, kInflateBlockBytes);
+      return nullptr;  // EOF
+    }
   }
 
-  char* uncomp_body;
-  auto uncomp_size = reinterpret_cast<size_t*>(size);
-  UncompressGzipBody(comp_body, body_length,
-                     reinterpret_cast<void**>(&uncomp_body), uncomp_size);
+  *size = static_cast<int64_t>(block_size);
+  return std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>(
+      block, ServerRequestInterface::BlockDeleter(kInflateBlockBytes));
+}
 
-  std::allocator<char>().deallocate(comp_body, body_length);
+absl::string_view EvHTTPRequest::ReadRequestBody() {
+  if (inflate_done_) {
+    return inflated_body_;  // already read, gzipped
+  }
+  evbuffer* input_buf =
+      evhttp_request_get_input_buffer(parsed_request_->request);
+  if (input_buf == nullptr || evbuffer_get_length(input_buf) == 0) {
+    return absl::string_view();  // no body
+  }
+  // Makes the body contiguous in the input buffer, which only copies it if it
+  // was received into more than one chain.
+  const size_t body_size = evbuffer_get_length(input_buf);
+  const absl::string_view body(
+      reinterpret_cast<const char*>(evbuffer_pullup(input_buf, -1)),
+      body_size);
+  if (!NeedUncompressGzipContent()) {
+    return body;
+  }
 
-  if (uncomp_body != nullptr) {
-    return std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>(
-        uncomp_body, ServerRequestInterface::BlockDeleter(*uncomp_size));
-  } else {
-    NET_LOG(ERROR, "Failed to uncompress the gzipped body");
-    *uncomp_size = 0;
-    return nullptr;
+  inflate_done_ = true;
+  GzipInflateOptions inflate_options;
+  inflate_options.max_uncompressed_bytes = MaxUncompressedBytes();
+  if (!InflateGzip(body, inflate_options, &inflated_body_)) {
+    NET_LOG(ERROR, "Failed to uncompress the gzipped body, or it exceeds "
+            "the max uncompressed size: %jd",
+            static_cast<intmax_t>(inflate_options.max_uncompressed_bytes));
+    std::string().swap(inflated_body_);
+    request_body_failed_ = true;
   }
+  evbuffer_drain(input_buf, body_size);
+  return inflated_body_;
+}
+
+int64_t EvHTTPRequest::MaxUncompressedBytes() const {
+  return handler_options_->auto_uncompress_max_size() > 0
+             ? handler_options_->auto_uncompress_max_size()
+             : ZLib::kMaxUncompressedBytes;
 }
 
 bool EvHTTPRequest::NeedUncompressGzipContent() {
@@ -269,24 +434,44 @@ bool EvHTTPRequest::NeedUncompressGzipContent() {
   return false;
 }
 
-void EvHTTPRequest::UncompressGzipBody(void* input, size_t input_size,
-                                       void** uncompressed_input,
-                                       size_t* uncompressed_input_size) {
-  int64_t max = handler_options_->auto_uncompress_max_size() > 0
-                    ? handler_options_->auto_uncompress_max_size()
-                    : ZLib::kMaxUncompressedBytes;
-
-  // our APIs don't need expose the actual content-length
-  *uncompressed_input_size = static_cast<size_t>(max);
+void EvHTTPRequest::MaybeCompressResponse() {
+  if (handler_options_ == nullptr ||
+      !handler_options_->auto_compress_output()) {
+    return;
+  }
+  const size_t body_size = evbuffer_get_length(output_buf);
+  if (body_size == 0 || static_cast<int64_t>(body_size) <
+                            handler_options_->auto_compress_min_size()) {
+    return;
+  }
+  evkeyvalq* ev_headers =
+      evhttp_request_get_output_headers(parsed_request_->request);
+  if (evhttp_find_header(ev_headers, HTTPHeaders::CONTENT_ENCODING) !=
+          nullptr ||
+      !AcceptsGzip(GetRequestHeader(HTTPHeaders::ACCEPT_ENCODING))) {
+    return;
+  }
 
+  const Bytef* body = evbuffer_pullup(output_buf, -1);
+  uLongf compressed_size = ZLib::MinCompressbufSize(body_size);
+  std::unique_ptr<Bytef[]> compressed(new Bytef[compressed_size]);
   ZLib zlib;
-  int err = zlib.UncompressGzipAndAllocate(
-      reinterpret_cast<Bytef**>(uncompressed_input),
-      reinterpret_cast<uLongf*>(uncompressed_input_size),
-      static_cast<Bytef*>(input), static_cast<uLong>(input_size));
+  const int err =
+      zlib.Compress(compressed.get(), &compressed_size, body, body_size);
   if (err != Z_OK) {
-    NET_LOG(ERROR, "Got zlib error: %d", err);
+    NET_LOG(ERROR, "Failed to compress the response body: %d", err);
+    return;
+  }
+  if (compressed_size >= body_size) {
+    return;  // not worth it
   }
+  evbuffer_drain(output_buf, body_size);
+  if (evbuffer_add(output_buf, compressed.get(), compressed_size) != 0) {
+    NET_LOG(ERROR, "Failed to write the compressed response body");
+    return;
+  }
+  OverwriteResponseHeader(HTTPHeaders::CONTENT_ENCODING, "gzip");
+  AppendResponseHeader(HTTPHeaders::VARY, HTTPHeaders::ACCEPT_ENCODING);
 }
 
 // Note: passing string_view incurs a copy of underlying std::string data
@@ -342,11 +527,36 @@ void EvHTTPRequest::AppendResponseHeader(absl::string_view header,
 }
 
 void EvHTTPRequest::PartialReplyWithStatus(HTTPStatusCode status) {
-  NET_LOG(FATAL, "PartialReplyWithStatus not implemented.");
+  // Hand the data written so far to the event loop, which sends it as a chunk
+  // of a chunked response (or as is to HTTP/1.0 clients).
+  evbuffer* chunk = evbuffer_new();
+  if (chunk == nullptr || evbuffer_add_buffer(chunk, output_buf) != 0) {
+    NET_LOG(ERROR, "Failed to buffer the partial response");
+    if (chunk != nullptr) {
+      evbuffer_free(chunk);
+    }
+    return;
+  }
+  const bool start_reply = !reply_started_;
+  reply_started_ = true;
+  bool result =
+      server_->EventLoopSchedule([this, status, start_reply, chunk]() {
+        if (start_reply) {
+          evhttp_send_reply_start(parsed_request_->request,
+                                  static_cast<int>(status), nullptr);
+        }
+        evhttp_send_reply_chunk(parsed_request_->request, chunk);
+        evbuffer_free(chunk);
+      });
+
+  if (!result) {
+    NET_LOG(ERROR, "Failed to EventLoopSchedule PartialReplyWithStatus()");
+    evbuffer_free(chunk);
+  }
 }
 
 void EvHTTPRequest::PartialReply() {
-  NET_LOG(FATAL, "PartialReplyWithStatus not implemented.");
+  PartialReplyWithStatus(HTTPStatusCode::OK);
 }
 
 ServerRequestInterface::CallbackStatus
@@ -356,8 +566,16 @@ EvHTTPRequest::PartialReplyWithFlushCallback(std::function<void()> callback) {
 }
 
 void EvHTTPRequest::ReplyWithStatus(HTTPStatusCode status) {
-  bool result =
-      server_->EventLoopSchedule([this, status]() { EvSendReply(status); });
+  // Off the event loop, which shouldn't be kept busy compressing. A response
+  // that is partly sent can't be compressed as a whole.
+  const bool reply_started = reply_started_;
+  if (!reply_started) {
+    MaybeCompressResponse();
+  }
+
+  bool result = server_->EventLoopSchedule([this, status, reply_started]() {
+    EvSendReply(status, reply_started);
+  });
 
   if (!result) {
     NET_LOG(ERROR, "Failed to EventLoopSchedule ReplyWithStatus()");
@@ -367,11 +585,21 @@ void EvHTTPRequest::ReplyWithStatus(HTTPStatusCode status) {
   }
 }
 
-void EvHTTPRequest::EvSendReply(HTTPStatusCode status) {
-  evhttp_send_reply(parsed_request_->request, static_cast<int>(status), nullptr,
-                    output_buf);
-  server_->DecOps();
-  delete this;
+void EvHTTPRequest::EvSendReply(HTTPStatusCode status, bool reply_started) {
+  if (reply_started) {
+    // The status has been sent with the first chunk.
+    if (evbuffer_get_length(output_buf) > 0) {
+      evhttp_send_reply_chunk(parsed_request_->request, output_buf);
+    }
+    evhttp_send_reply_end(parsed_request_->request);
+  } else {
+    evhttp_send_reply(parsed_request_->request, static_cast<int>(status),
+                      nullptr, output_buf);
+  }
+  // Done with the server as soon as this is released.
+  ServerSupport* server = server_;
+  server->ReleaseRequest(this);
+  server->DecOps();
 }
 
 void EvHTTPRequest::Reply() { ReplyWithStatus(HTTPStatusCode::OK); }
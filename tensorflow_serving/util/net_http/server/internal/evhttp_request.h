@@ -22,6 +22,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 
+#include "tensorflow_serving/util/net_http/compression/gzip_zlib.h"
 #include "tensorflow_serving/util/net_http/server/internal/server_support.h"
 #include "tensorflow_serving/util/net_http/server/public/httpserver_interface.h"
 #include "tensorflow_serving/util/net_http/server/public/server_request_interface.h"
@@ -81,9 +82,13 @@ class EvHTTPRequest final : public ServerRequestInterface {
 
   void WriteResponseString(absl::string_view data) override;
 
+  void WriteResponseBuffer(std::string data) override;
+
   std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>
   ReadRequestBytes(int64_t* size) override;
 
+  absl::string_view ReadRequestBody() override;
+
   absl::string_view GetRequestHeader(absl::string_view header) const override;
 
   std::vector<absl::string_view> request_headers() const override;
@@ -104,28 +109,45 @@ class EvHTTPRequest final : public ServerRequestInterface {
 
   void Abort() override;
 
-  // Initializes the resource and returns false if any error.
+  // FAILED if the gzipped request body fails to uncompress.
+  // The request body is complete when it's dispatched to the handler.
+  BodyStatus request_body_status() override {
+    return request_body_failed_ ? BodyStatus::FAILED : BodyStatus::COMPLETE;
+  }
+
+  // Initializes the resource and returns false if any error. A no-op for a
+  // request object that is reused.
   bool Initialize();
 
+  // Prepares a request object that has replied for reuse, on 'request'.
+  void Reset(std::unique_ptr<ParsedEvRequest> request);
+
   // Keeps a reference to the registered RequestHandlerOptions
   void SetHandlerOptions(const RequestHandlerOptions& handler_options) {
     this->handler_options_ = &handler_options;
   }
 
  private:
-  void EvSendReply(HTTPStatusCode status);
+  // Sends the response, or the rest of it if 'reply_started', from the event
+  // loop, and releases this.
+  void EvSendReply(HTTPStatusCode status, bool reply_started);
 
   // Returns true if the data needs be uncompressed
   bool NeedUncompressGzipContent();
 
-  // Must set uncompressed_input to nullptr if uncompression is failed
-  void UncompressGzipBody(void* input, size_t input_size,
-                          void** uncompressed_input,
-                          size_t* uncompressed_input_size);
-
+  // Inflates the next block of the gzipped body from 'input_buf', draining
+  // the compressed bytes it consumes. Returns nullptr at the end of the body,
+  // or if it fails to uncompress, which fails request_body_status().
   std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>
   ReadRequestGzipBytes(evbuffer* input_buf, int64_t* size);
 
+  // The max size of a gzipped body once uncompressed.
+  int64_t MaxUncompressedBytes() const;
+
+  // Compresses the response body if the handler options and the request
+  // allow.
+  void MaybeCompressResponse();
+
   ServerSupport* server_;
 
   const RequestHandlerOptions* handler_options_;
@@ -133,6 +155,18 @@ class EvHTTPRequest final : public ServerRequestInterface {
   std::unique_ptr<ParsedEvRequest> parsed_request_;
 
   evbuffer* output_buf;  // owned by this
+
+  // The state of inflating a gzipped request body, across
+  // ReadRequestGzipBytes() calls.
+  std::unique_ptr<ZLib> inflater_;
+  int64_t inflated_bytes_ = 0;
+  // The whole uncompressed body, for ReadRequestBody().
+  std::string inflated_body_;
+  bool inflate_done_ = false;
+  bool request_body_failed_ = false;
+
+  // Whether PartialReply() has started sending the response.
+  bool reply_started_ = false;
 };
 
 }  // namespace net_http
@@ -19,10 +19,12 @@ limitations under the License.
 #include <random>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <gtest/gtest.h>
 #include "absl/memory/memory.h"
 #include "tensorflow_serving/util/net_http/client/test_client/internal/evhttp_connection.h"
+#include "tensorflow_serving/util/net_http/compression/gzip_inflate.h"
 #include "tensorflow_serving/util/net_http/compression/gzip_zlib.h"
 #include "tensorflow_serving/util/net_http/internal/fixed_thread_pool.h"
 #include "tensorflow_serving/util/net_http/public/response_code_enum.h"
@@ -267,6 +269,8 @@ TEST_F(EvHTTPRequestTest, InvalidGzipPost) {
     auto request_body = request->ReadRequestBytes(&num_bytes);
     EXPECT_TRUE(request_body == nullptr);
     EXPECT_EQ(0, num_bytes);
+    EXPECT_EQ(ServerRequestInterface::BodyStatus::FAILED,
+              request->request_body_status());
 
     request->Reply();
   };
@@ -425,15 +429,180 @@ TEST_F(EvHTTPRequestTest, LargeGzipPost) {
       uncompressed.data(), uncompressed.size(), 2 * uncompress_len);
 
   auto handler = [&](ServerRequestInterface* request) {
+    // The body is uncompressed a block at a time.
+    std::string body_str;
+    int num_blocks = 0;
     int64_t num_bytes;
-    auto request_body = request->ReadRequestBytes(&num_bytes);
+    auto request_chunk = request->ReadRequestBytes(&num_bytes);
+    while (request_chunk != nullptr) {
+      body_str.append(request_chunk.get(), static_cast<size_t>(num_bytes));
+      ++num_blocks;
+      request_chunk = request->ReadRequestBytes(&num_bytes);
+    }
+    EXPECT_EQ(0, num_bytes);
+    EXPECT_GT(num_blocks, 1);
+    EXPECT_EQ(body_str, uncompressed);
+    EXPECT_EQ(ServerRequestInterface::BodyStatus::COMPLETE,
+              request->request_body_status());
 
-    std::string body_str(request_body.get(), static_cast<size_t>(num_bytes));
+    request->Reply();
+  };
+  server->RegisterRequestHandler("/ok", std::move(handler),
+                                 RequestHandlerOptions());
+  server->StartAcceptingRequests();
+
+  auto connection =
+      TestEvHTTPConnection::Connect("localhost", server->listen_port());
+  ASSERT_TRUE(connection != nullptr);
+
+  TestClientRequest request = {"/ok", "POST", {}, compressed};
+  request.headers.emplace_back("Content-Encoding", "my_gzip");
+  TestClientResponse response = {};
+
+  EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+  EXPECT_EQ(response.status, HTTPStatusCode::OK);
+
+  server->Terminate();
+  server->WaitForTermination();
+}
+
+// Test large gzip body of several members, as written by parallel
+// compressors, which is inflated at once
+TEST_F(EvHTTPRequestTest, MultiMemberGzipPost) {
+  constexpr int64_t member_len = 512 * 1024;
+  std::string uncompressed;
+  std::string compressed;
+  for (int i = 0; i < 4; ++i) {
+    std::string member = MakeRandomString(member_len);
+    compressed +=
+        CompressLargeString(member.data(), member.size(), 2 * member_len);
+    uncompressed += member;
+  }
+  ASSERT_GE(compressed.size(), GzipInflateOptions().min_parallel_bytes);
+
+  auto handler = [&](ServerRequestInterface* request) {
+    std::string body_str;
+    int64_t num_bytes;
+    auto request_chunk = request->ReadRequestBytes(&num_bytes);
+    while (request_chunk != nullptr) {
+      body_str.append(request_chunk.get(), static_cast<size_t>(num_bytes));
+      request_chunk = request->ReadRequestBytes(&num_bytes);
+    }
     EXPECT_EQ(body_str, uncompressed);
-    EXPECT_EQ(uncompressed.size(), num_bytes);
+    EXPECT_EQ(ServerRequestInterface::BodyStatus::COMPLETE,
+              request->request_body_status());
 
-    EXPECT_EQ(nullptr, request->ReadRequestBytes(&num_bytes));
-    EXPECT_EQ(0, num_bytes);
+    request->Reply();
+  };
+  server->RegisterRequestHandler("/ok", std::move(handler),
+                                 RequestHandlerOptions());
+  server->StartAcceptingRequests();
+
+  auto connection =
+      TestEvHTTPConnection::Connect("localhost", server->listen_port());
+  ASSERT_TRUE(connection != nullptr);
+
+  TestClientRequest request = {"/ok", "POST", {}, compressed};
+  request.headers.emplace_back("Content-Encoding", "gzip");
+  TestClientResponse response = {};
+
+  EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+  EXPECT_EQ(response.status, HTTPStatusCode::OK);
+
+  server->Terminate();
+  server->WaitForTermination();
+}
+
+// Test reading a plain and a gzipped body as one view
+TEST_F(EvHTTPRequestTest, ReadRequestBody) {
+  const std::string uncompressed = MakeRandomString(512 * 1024);
+  const std::string compressed = CompressLargeString(
+      uncompressed.data(), uncompressed.size(), uncompressed.size());
+
+  auto handler = [&](ServerRequestInterface* request) {
+    EXPECT_EQ(request->ReadRequestBody(), uncompressed);
+    // Reading it again returns the same body.
+    EXPECT_EQ(request->ReadRequestBody(), uncompressed);
+    EXPECT_EQ(ServerRequestInterface::BodyStatus::COMPLETE,
+              request->request_body_status());
+    request->Reply();
+  };
+  auto bad_gzip_handler = [](ServerRequestInterface* request) {
+    EXPECT_EQ("", request->ReadRequestBody());
+    EXPECT_EQ(ServerRequestInterface::BodyStatus::FAILED,
+              request->request_body_status());
+    request->Reply();
+  };
+  server->RegisterRequestHandler("/ok", std::move(handler),
+                                 RequestHandlerOptions());
+  server->RegisterRequestHandler("/bad", std::move(bad_gzip_handler),
+                                 RequestHandlerOptions());
+  server->StartAcceptingRequests();
+
+  auto connection =
+      TestEvHTTPConnection::Connect("localhost", server->listen_port());
+  ASSERT_TRUE(connection != nullptr);
+
+  TestClientRequest plain_request = {"/ok", "POST", {}, uncompressed};
+  TestClientRequest gzip_request = {"/ok", "POST", {}, compressed};
+  gzip_request.headers.emplace_back("Content-Encoding", "gzip");
+  TestClientRequest bad_request = {"/bad", "POST", {}, "not gzip"};
+  bad_request.headers.emplace_back("Content-Encoding", "gzip");
+  for (const TestClientRequest& request :
+       {plain_request, gzip_request, bad_request}) {
+    TestClientResponse response = {};
+    EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+    EXPECT_EQ(response.status, HTTPStatusCode::OK);
+  }
+
+  server->Terminate();
+  server->WaitForTermination();
+}
+
+// Test appending buffers to the response body without copying them
+TEST_F(EvHTTPRequestTest, WriteResponseBuffer) {
+  const std::string large = MakeRandomString(1024 * 1024);
+  auto handler = [&](ServerRequestInterface* request) {
+    request->WriteResponseBuffer("small,");
+    request->WriteResponseBuffer(large);
+    request->WriteResponseString(",end");
+    request->Reply();
+  };
+  server->RegisterRequestHandler("/ok", std::move(handler),
+                                 RequestHandlerOptions());
+  server->StartAcceptingRequests();
+
+  auto connection =
+      TestEvHTTPConnection::Connect("localhost", server->listen_port());
+  ASSERT_TRUE(connection != nullptr);
+
+  TestClientRequest request = {"/ok", "GET", {}, ""};
+  TestClientResponse response = {};
+
+  EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+  EXPECT_EQ(response.status, HTTPStatusCode::OK);
+  EXPECT_EQ(response.body, "small," + large + ",end");
+
+  server->Terminate();
+  server->WaitForTermination();
+}
+
+// Test truncated gzip body
+TEST_F(EvHTTPRequestTest, TruncatedGzipPost) {
+  constexpr int64_t uncompress_len = 1024 * 1024;
+  std::string uncompressed = MakeRandomString(uncompress_len);
+  std::string compressed = CompressLargeString(
+      uncompressed.data(), uncompressed.size(), 2 * uncompress_len);
+  compressed.resize(compressed.size() / 2);
+
+  auto handler = [&](ServerRequestInterface* request) {
+    int64_t num_bytes;
+    auto request_chunk = request->ReadRequestBytes(&num_bytes);
+    while (request_chunk != nullptr) {
+      request_chunk = request->ReadRequestBytes(&num_bytes);
+    }
+    EXPECT_EQ(ServerRequestInterface::BodyStatus::FAILED,
+              request->request_body_status());
 
     request->Reply();
   };
@@ -446,7 +615,7 @@ TEST_F(EvHTTPRequestTest, LargeGzipPost) {
   ASSERT_TRUE(connection != nullptr);
 
   TestClientRequest request = {"/ok", "POST", {}, compressed};
-  request.headers.emplace_back("Content-Encoding", "my_gzip");
+  request.headers.emplace_back("Content-Encoding", "gzip");
   TestClientResponse response = {};
 
   EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
@@ -456,6 +625,83 @@ TEST_F(EvHTTPRequestTest, LargeGzipPost) {
   server->WaitForTermination();
 }
 
+// Returns the value of the response header 'name', or "" if not present.
+std::string GetResponseHeader(const TestClientResponse& response,
+                              const std::string& name) {
+  for (const auto& keyvalue : response.headers) {
+    if (keyvalue.first == name) {
+      return keyvalue.second;
+    }
+  }
+  return "";
+}
+
+// Test gzip compressed response
+TEST_F(EvHTTPRequestTest, GzipResponse) {
+  const std::string body(64 * 1024, 'x');
+  auto handler = [&](ServerRequestInterface* request) {
+    request->WriteResponseString(request->uri_path() == "/small" ? "OK"
+                                                                 : body);
+    request->Reply();
+  };
+  RequestHandlerOptions options;
+  options.set_auto_compress_output(true);
+  server->RegisterRequestHandler("/ok", handler, options);
+  server->RegisterRequestHandler("/small", handler, options);
+  server->RegisterRequestHandler("/disabled", handler,
+                                 RequestHandlerOptions());
+  server->StartAcceptingRequests();
+
+  auto send = [this](const std::string& uri,
+                     const std::string& accept_encoding) {
+    auto connection =
+        TestEvHTTPConnection::Connect("localhost", server->listen_port());
+    EXPECT_TRUE(connection != nullptr);
+    TestClientRequest request = {uri, "GET", {}, ""};
+    if (!accept_encoding.empty()) {
+      request.headers.emplace_back("Accept-Encoding", accept_encoding);
+    }
+    TestClientResponse response = {};
+    EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+    EXPECT_EQ(response.status, HTTPStatusCode::OK);
+    return response;
+  };
+
+  TestClientResponse response = send("/ok", "deflate, gzip;q=0.8");
+  EXPECT_EQ("gzip", GetResponseHeader(response, "Content-Encoding"));
+  EXPECT_EQ("Accept-Encoding", GetResponseHeader(response, "Vary"));
+  EXPECT_LT(response.body.size(), body.size());
+  ZLib zlib;
+  Bytef* uncompressed = nullptr;
+  uLongf uncompressed_size = 2 * body.size();
+  ASSERT_EQ(Z_OK, zlib.UncompressGzipAndAllocate(
+                      &uncompressed, &uncompressed_size,
+                      reinterpret_cast<const Bytef*>(response.body.data()),
+                      response.body.size()));
+  EXPECT_EQ(body, std::string(reinterpret_cast<char*>(uncompressed),
+                              uncompressed_size));
+  std::allocator<Bytef>().deallocate(uncompressed, uncompressed_size);
+
+  // Not accepted, too small, or not enabled.
+  for (const auto& uri_and_encoding :
+       std::vector<std::pair<std::string, std::string>>{
+           {"/ok", ""},
+           {"/ok", "br"},
+           {"/ok", "gzip;q=0"},
+           {"/ok", "*;q=0.5, gzip;q=0"},
+           {"/small", "gzip"},
+           {"/disabled", "gzip"}}) {
+    SCOPED_TRACE(uri_and_encoding.first + " " + uri_and_encoding.second);
+    response = send(uri_and_encoding.first, uri_and_encoding.second);
+    EXPECT_EQ("", GetResponseHeader(response, "Content-Encoding"));
+    EXPECT_NE("", response.body);
+  }
+  EXPECT_EQ("gzip", GetResponseHeader(send("/ok", "*"), "Content-Encoding"));
+
+  server->Terminate();
+  server->WaitForTermination();
+}
+
 }  // namespace
 }  // namespace net_http
 }  // namespace serving
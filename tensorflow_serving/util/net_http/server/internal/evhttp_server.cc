@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow_serving/util/net_http/server/internal/evhttp_server.h"
 
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <signal.h>
 #include <sys/socket.h>
 
@@ -30,8 +31,10 @@ limitations under the License.
 
 #include "absl/base/call_once.h"
 #include "absl/memory/memory.h"
+#include "libevent/include/event2/bufferevent.h"
 #include "libevent/include/event2/event.h"
 #include "libevent/include/event2/http.h"
+#include "libevent/include/event2/listener.h"
 #include "libevent/include/event2/thread.h"
 #include "libevent/include/event2/util.h"
 #include "tensorflow_serving/util/net_http/internal/net_logging.h"
@@ -66,6 +69,14 @@ EvHTTPServer::~EvHTTPServer() {
     NET_LOG(ERROR, "Server has not been terminated. Force termination now.");
     Terminate();
   }
+}
+
+EvHTTPServer::EventLoop::~EventLoop() {
+  // Closes the HTTP/2 connections
+  http2_sessions_.clear();
+  if (http2_listener_ != nullptr) {
+    evconnlistener_free(http2_listener_);
+  }
 
   if (ev_http_ != nullptr) {
     // this frees the socket handlers too
@@ -92,7 +103,18 @@ bool EvHTTPServer::Initialize() {
 
   GlobalInitialize();
 
-  // This ev_base_ created per-server v.s. global
+  for (int i = 0; i < server_options_->num_event_loops(); ++i) {
+    event_loops_.push_back(absl::make_unique<EventLoop>(this));
+    if (!event_loops_.back()->Initialize()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool EvHTTPServer::EventLoop::Initialize() {
+  // This ev_base_ created per-loop v.s. global
   ev_base_ = event_base_new();
   if (ev_base_ == nullptr) {
     NET_LOG(FATAL, "Failed to create an event_base.");
@@ -117,16 +139,70 @@ bool EvHTTPServer::Initialize() {
                     EVHTTP_REQ_PATCH);
   evhttp_set_gencb(ev_http_, &DispatchEvRequestFn, this);
 
+  const absl::Duration timeout = server_->server_options_->connection_timeout();
+  if (timeout > absl::ZeroDuration()) {
+    const timeval tv = absl::ToTimeval(timeout);
+    evhttp_set_timeout_tv(ev_http_, &tv);
+  }
+
   return true;
 }
 
+std::unique_ptr<EvHTTPRequest> EvHTTPServer::EventLoop::NewRequest(
+    std::unique_ptr<ParsedEvRequest> parsed_request) {
+  if (recycled_requests_.empty()) {
+    return absl::make_unique<EvHTTPRequest>(std::move(parsed_request), this);
+  }
+  std::unique_ptr<EvHTTPRequest> request =
+      std::move(recycled_requests_.back());
+  recycled_requests_.pop_back();
+  request->Reset(std::move(parsed_request));
+  return request;
+}
+
+void EvHTTPServer::EventLoop::ReleaseRequest(
+    ServerRequestInterface* request) {
+  std::unique_ptr<EvHTTPRequest> ev_request(
+      static_cast<EvHTTPRequest*>(request));
+  if (recycled_requests_.size() <
+      static_cast<size_t>(server_->server_options_->max_recycled_requests())) {
+    // Frees the request's state, other than its buffer, right away.
+    ev_request->Reset(nullptr);
+    recycled_requests_.push_back(std::move(ev_request));
+  }
+}
+
+void EvHTTPServer::EventLoop::CountConnectionRequest(evhttp_request* req,
+                                                     int64_t max_requests) {
+  evhttp_connection* connection = evhttp_request_get_connection(req);
+  if (connection == nullptr) {
+    return;
+  }
+  auto it = connection_requests_.find(connection);
+  if (it == connection_requests_.end()) {
+    it = connection_requests_.emplace(connection, 0).first;
+    evhttp_connection_set_closecb(connection, &ConnectionClosedFn, this);
+  }
+  if (++it->second >= max_requests) {
+    // libevent closes the connection once the response is sent.
+    evhttp_add_header(evhttp_request_get_output_headers(req), "Connection",
+                      "close");
+  }
+}
+
+// static function pointer
+void EvHTTPServer::EventLoop::ConnectionClosedFn(evhttp_connection* connection,
+                                                 void* loop) {
+  static_cast<EventLoop*>(loop)->connection_requests_.erase(connection);
+}
+
 // static function pointer
-void EvHTTPServer::DispatchEvRequestFn(evhttp_request* req, void* server) {
-  EvHTTPServer* http_server = static_cast<EvHTTPServer*>(server);
-  http_server->DispatchEvRequest(req);
+void EvHTTPServer::DispatchEvRequestFn(evhttp_request* req, void* loop) {
+  EventLoop* event_loop = static_cast<EventLoop*>(loop);
+  event_loop->server()->DispatchEvRequest(req, event_loop);
 }
 
-void EvHTTPServer::DispatchEvRequest(evhttp_request* req) {
+void EvHTTPServer::DispatchEvRequest(evhttp_request* req, EventLoop* loop) {
   auto parsed_request = absl::make_unique<ParsedEvRequest>(req);
 
   if (!parsed_request->decode()) {
@@ -134,71 +210,118 @@ void EvHTTPServer::DispatchEvRequest(evhttp_request* req) {
     return;
   }
 
-  std::string path(parsed_request->path);
+  const std::string path(parsed_request->path);
 
-  bool dispatched = false;
-  std::unique_ptr<EvHTTPRequest> ev_request(
-      new EvHTTPRequest(std::move(parsed_request), this));
+  const int64_t max_requests = server_options_->max_requests_per_connection();
+  if (max_requests > 0) {
+    loop->CountConnectionRequest(req, max_requests);
+  }
 
+  // The request replies from the event loop of its connection.
+  std::unique_ptr<EvHTTPRequest> ev_request =
+      loop->NewRequest(std::move(parsed_request));
   if (!ev_request->Initialize()) {
     evhttp_send_error(req, HTTP_SERVUNAVAIL, nullptr);
     return;
   }
 
-  {
-    absl::MutexLock l(&request_mu_);
+  if (!ScheduleRequest(path, &ev_request)) {
+    evhttp_send_error(req, HTTP_NOTFOUND, nullptr);
+    return;
+  }
+}
 
-    auto handler_map_it = uri_handlers_.find(path);
-    if (handler_map_it != uri_handlers_.end()) {
-      ev_request->SetHandlerOptions(handler_map_it->second.options);
-      IncOps();
-      dispatched = true;
-      ScheduleHandlerReference(handler_map_it->second.handler,
-                               ev_request.release());
-    }
+template <typename Request>
+bool EvHTTPServer::ScheduleRequest(const std::string& path,
+                                   std::unique_ptr<Request>* request) {
+  absl::MutexLock l(&request_mu_);
 
-    if (!dispatched) {
-      for (const auto& dispatcher : dispatchers_) {
-        auto handler = dispatcher.dispatcher(ev_request.get());
-        if (handler == nullptr) {
-          continue;
-        }
-        ev_request->SetHandlerOptions(dispatcher.options);
-        IncOps();
-        dispatched = true;
-        ScheduleHandler(std::move(handler), ev_request.release());
-        break;
-      }
-    }
+  auto handler_map_it = uri_handlers_.find(path);
+  if (handler_map_it != uri_handlers_.end()) {
+    (*request)->SetHandlerOptions(handler_map_it->second.options);
+    IncOps();
+    ScheduleHandlerReference(handler_map_it->second.handler,
+                             request->release());
+    return true;
   }
 
-  if (!dispatched) {
-    evhttp_send_error(req, HTTP_NOTFOUND, nullptr);
-    return;
+  for (const auto& dispatcher : dispatchers_) {
+    auto handler = dispatcher.dispatcher(request->get());
+    if (handler == nullptr) {
+      continue;
+    }
+    (*request)->SetHandlerOptions(dispatcher.options);
+    IncOps();
+    ScheduleHandler(std::move(handler), request->release());
+    return true;
   }
+
+  return false;
 }
 
 void EvHTTPServer::ScheduleHandlerReference(const RequestHandler& handler,
-                                            EvHTTPRequest* ev_request) {
+                                            ServerRequestInterface* request) {
   server_options_->executor()->Schedule(
-      [&handler, ev_request]() { handler(ev_request); });
+      [&handler, request]() { handler(request); });
 }
 
 // Exactly one copy of the handler argument
 // with the lambda passed by value to Schedule()
 void EvHTTPServer::ScheduleHandler(RequestHandler&& handler,
-                                   EvHTTPRequest* ev_request) {
+                                   ServerRequestInterface* request) {
   server_options_->executor()->Schedule(
-      [handler, ev_request]() { handler(ev_request); });
+      [handler, request]() { handler(request); });
+}
+
+// static function pointer
+void EvHTTPServer::EventLoop::AcceptHttp2Fn(evconnlistener* listener,
+                                            evutil_socket_t fd,
+                                            sockaddr* address, int socklen,
+                                            void* loop) {
+  static_cast<EventLoop*>(loop)->AcceptHttp2(fd);
+}
+
+void EvHTTPServer::EventLoop::AcceptHttp2(evutil_socket_t fd) {
+  bufferevent* bev = bufferevent_socket_new(
+      ev_base_, fd, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_DEFER_CALLBACKS);
+  if (bev == nullptr) {
+    NET_LOG(ERROR, "Failed to create a bufferevent for an HTTP/2 connection");
+    evutil_closesocket(fd);
+    return;
+  }
+
+  // Frames are small and latency-sensitive
+  int no_delay = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+  const absl::Duration timeout = server_->server_options_->connection_timeout();
+  if (timeout > absl::ZeroDuration()) {
+    const timeval tv = absl::ToTimeval(timeout);
+    bufferevent_set_timeouts(bev, &tv, &tv);
+  }
+
+  EvHTTPServer* server = server_;
+  auto session = std::make_shared<EvHTTP2Session>(
+      bev, this,
+      [server](std::unique_ptr<EvHTTP2Request>* request) {
+        const std::string path((*request)->path());
+        return server->ScheduleRequest(path, request);
+      },
+      [this](EvHTTP2Session* session) { http2_sessions_.erase(session); });
+  EvHTTP2Session* session_key = session.get();
+  http2_sessions_.emplace(session_key, std::move(session));
+  if (!session_key->Start(
+          server_->server_options_->max_concurrent_http2_streams())) {
+    http2_sessions_.erase(session_key);
+  }
 }
 
 namespace {
 
-void ResolveEphemeralPort(evhttp_bound_socket* listener, int* port) {
+void ResolveEphemeralPort(evutil_socket_t fd, int* port) {
   sockaddr_storage ss = {};
   ev_socklen_t socklen = sizeof(ss);
 
-  evutil_socket_t fd = evhttp_bound_socket_get_fd(listener);
   if (getsockname(fd, reinterpret_cast<sockaddr*>(&ss), &socklen)) {
     NET_LOG(ERROR, "getsockname() failed");
     return;
@@ -213,46 +336,138 @@ void ResolveEphemeralPort(evhttp_bound_socket* listener, int* port) {
   }
 }
 
+// Binds a listener on 'port' of all addresses, falling back to IPv4 if IPv6
+// is not supported. A null 'cb' leaves the listener disabled until one is set.
+evconnlistener* NewListener(event_base* ev_base, int port, bool reuse_port,
+                            evconnlistener_cb cb, void* arg) {
+  unsigned flags =
+      LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE | LEV_OPT_CLOSE_ON_EXEC;
+  if (reuse_port) {
+    flags |= LEV_OPT_REUSEABLE_PORT;
+  }
+  sockaddr_in6 addr6 = {};
+  addr6.sin6_family = AF_INET6;
+  addr6.sin6_addr = in6addr_any;
+  addr6.sin6_port = htons(static_cast<uint16_t>(port));
+  evconnlistener* listener =
+      evconnlistener_new_bind(ev_base, cb, arg, flags, -1,
+                              reinterpret_cast<sockaddr*>(&addr6),
+                              sizeof(addr6));
+  if (listener == nullptr) {
+    sockaddr_in addr4 = {};
+    addr4.sin_family = AF_INET;
+    addr4.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr4.sin_port = htons(static_cast<uint16_t>(port));
+    listener = evconnlistener_new_bind(ev_base, cb, arg, flags, -1,
+                                       reinterpret_cast<sockaddr*>(&addr4),
+                                       sizeof(addr4));
+  }
+  return listener;
+}
+
 }  // namespace
 
+bool EvHTTPServer::EventLoop::Bind(int port, bool reuse_port) {
+  if (!reuse_port) {
+    // "::"  =>  in6addr_any
+    ev_uint16_t ev_port = static_cast<ev_uint16_t>(port);
+    ev_listener_ = evhttp_bind_socket_with_handle(ev_http_, "::", ev_port);
+    if (ev_listener_ == nullptr) {
+      // in case ipv6 is not supported, fallback to inaddr_any
+      ev_listener_ = evhttp_bind_socket_with_handle(ev_http_, nullptr, ev_port);
+    }
+    return ev_listener_ != nullptr;
+  }
+
+  // evhttp_bind_socket_with_handle() doesn't set SO_REUSEPORT, so bind the
+  // listener here.
+  evconnlistener* listener =
+      NewListener(ev_base_, port, /*reuse_port=*/true, nullptr, nullptr);
+  if (listener == nullptr) {
+    return false;
+  }
+  ev_listener_ = evhttp_bind_listener(ev_http_, listener);
+  if (ev_listener_ == nullptr) {
+    evconnlistener_free(listener);
+    return false;
+  }
+  return true;
+}
+
+bool EvHTTPServer::EventLoop::BindHttp2(int port, bool reuse_port) {
+  http2_listener_ =
+      NewListener(ev_base_, port, reuse_port, &AcceptHttp2Fn, this);
+  return http2_listener_ != nullptr;
+}
+
+void EvHTTPServer::EventLoop::Unbind() {
+  // This deletes ev_listener_
+  evhttp_del_accept_socket(ev_http_, ev_listener_);
+  ev_listener_ = nullptr;
+
+  if (http2_listener_ != nullptr) {
+    evconnlistener_free(http2_listener_);
+    http2_listener_ = nullptr;
+    server_->DecOps();
+  }
+}
+
 bool EvHTTPServer::StartAcceptingRequests() {
-  if (ev_http_ == nullptr) {
+  if (event_loops_.empty()) {
     NET_LOG(FATAL, "Server has not been successfully initialized");
     return false;
   }
 
-  const int port = server_options_->ports().front();
-
-  // "::"  =>  in6addr_any
-  ev_uint16_t ev_port = static_cast<ev_uint16_t>(port);
-  ev_listener_ = evhttp_bind_socket_with_handle(ev_http_, "::", ev_port);
-  if (ev_listener_ == nullptr) {
-    // in case ipv6 is not supported, fallback to inaddr_any
-    ev_listener_ = evhttp_bind_socket_with_handle(ev_http_, nullptr, ev_port);
-    if (ev_listener_ == nullptr) {
+  int port = server_options_->ports().front();
+  const bool reuse_port =
+      event_loops_.size() > 1 || server_options_->reuse_port();
+  for (auto& loop : event_loops_) {
+    if (!loop->Bind(port, reuse_port)) {
       NET_LOG(ERROR, "Couldn't bind to port %d", port);
       return false;
     }
-  }
 
-  // Listener counts as an active operation
-  IncOps();
+    // Listener counts as an active operation
+    IncOps();
 
+    // The other loops listen on the port that the first one got.
+    if (port == 0) {
+      ResolveEphemeralPort(evhttp_bound_socket_get_fd(loop->ev_listener()),
+                           &port);
+    }
+  }
   port_ = port;
-  if (port_ == 0) {
-    ResolveEphemeralPort(ev_listener_, &port_);
+
+  int http2_port = server_options_->http2_port();
+  if (http2_port >= 0) {
+    for (auto& loop : event_loops_) {
+      if (!loop->BindHttp2(http2_port, reuse_port)) {
+        NET_LOG(ERROR, "Couldn't bind to HTTP/2 port %d", http2_port);
+        return false;
+      }
+      IncOps();
+
+      if (http2_port == 0) {
+        ResolveEphemeralPort(evconnlistener_get_fd(loop->http2_listener()),
+                             &http2_port);
+      }
+    }
+    http2_port_ = http2_port;
   }
 
   accepting_requests_.Notify();
 
-  IncOps();
-  server_options_->executor()->Schedule([this]() {
-    NET_LOG(INFO, "Entering the event loop ...");
-    int result = event_base_dispatch(ev_base_);
-    NET_LOG(INFO, "event_base_dispatch() exits with value %d", result);
+  for (auto& loop : event_loops_) {
+    IncOps();
+    event_base* ev_base = loop->ev_base();
+    server_options_->executor()->Schedule([this, ev_base]() {
+      NET_LOG(INFO, "Entering the event loop ...");
+      int result = event_base_dispatch(ev_base);
+      NET_LOG(INFO, "event_base_dispatch() exits with value %d", result);
 
-    DecOps();
-  });
+      DecOps();
+    });
+  }
 
   return true;
 }
@@ -276,13 +491,16 @@ void EvHTTPServer::Terminate() {
 
   terminating_.Notify();
 
-  // call exit-loop from the event loop
-  this->EventLoopSchedule([this]() {
-    // Stop the listener first, which will delete ev_listener_
-    // This may cause the loop to exit, so need be scheduled from within
-    evhttp_del_accept_socket(ev_http_, ev_listener_);
-    DecOps();
-  });
+  // call exit-loop from the event loops
+  for (auto& loop : event_loops_) {
+    EventLoop* event_loop = loop.get();
+    event_loop->EventLoopSchedule([this, event_loop]() {
+      // Stop the listener first
+      // This may cause the loop to exit, so need be scheduled from within
+      event_loop->Unbind();
+      DecOps();
+    });
+  }
 
   // Current shut-down behavior:
   // - we don't proactively delete/close any HTTP connections as part of
@@ -309,12 +527,11 @@ void EvHTTPServer::DecOps() {
 void EvHTTPServer::WaitForTermination() {
   {
     absl::MutexLock l(&ops_mu_);
-    ops_mu_.Await(absl::Condition(
-        +[](int64_t* count) { return *count <= 1; }, &num_pending_ops_));
+    ops_mu_.Await(
+        absl::Condition(this, &EvHTTPServer::OnlyEventLoopsPending));
   }
 
-  int result = event_base_loopexit(ev_base_, nullptr);
-  NET_LOG(INFO, "event_base_loopexit() exits with value %d", result);
+  ExitEventLoops();
 
   {
     absl::MutexLock l(&ops_mu_);
@@ -329,14 +546,11 @@ bool EvHTTPServer::WaitForTerminationWithTimeout(absl::Duration timeout) {
   {
     absl::MutexLock l(&ops_mu_);
     wait_result = ops_mu_.AwaitWithTimeout(
-        absl::Condition(
-            +[](int64_t* count) { return *count <= 1; }, &num_pending_ops_),
-        timeout);
+        absl::Condition(this, &EvHTTPServer::OnlyEventLoopsPending), timeout);
   }
 
   if (wait_result) {
-    int result = event_base_loopexit(ev_base_, nullptr);
-    NET_LOG(INFO, "event_base_loopexit() exits with value %d", result);
+    ExitEventLoops();
 
     // This should pass immediately
     {
@@ -351,6 +565,13 @@ bool EvHTTPServer::WaitForTerminationWithTimeout(absl::Duration timeout) {
   return wait_result;
 }
 
+void EvHTTPServer::ExitEventLoops() {
+  for (auto& loop : event_loops_) {
+    int result = event_base_loopexit(loop->ev_base(), nullptr);
+    NET_LOG(INFO, "event_base_loopexit() exits with value %d", result);
+  }
+}
+
 EvHTTPServer::UriHandlerInfo::UriHandlerInfo(
     absl::string_view uri_in, RequestHandler handler_in,
     const RequestHandlerOptions& options_in)
@@ -404,9 +625,19 @@ void EvImmediateCallback(evutil_socket_t socket, int16_t flags, void* arg) {
 }  // namespace
 
 bool EvHTTPServer::EventLoopSchedule(std::function<void()> fn) {
+  if (event_loops_.empty()) {
+    return false;
+  }
+  return event_loops_.front()->EventLoopSchedule(std::move(fn));
+}
+
+bool EvHTTPServer::EventLoop::EventLoopSchedule(std::function<void()> fn) {
   auto scheduled_fn = new std::function<void()>(std::move(fn));
   int result = event_base_once(ev_base_, -1, EV_TIMEOUT, EvImmediateCallback,
                                static_cast<void*>(scheduled_fn), immediate_);
+  if (result != 0) {
+    delete scheduled_fn;
+  }
   return result == 0;
 }
 
@@ -29,14 +29,19 @@ limitations under the License.
 
 #include "absl/synchronization/notification.h"
 
+#include "libevent/include/event2/util.h"
+#include "tensorflow_serving/util/net_http/server/internal/evhttp2_session.h"
 #include "tensorflow_serving/util/net_http/server/internal/evhttp_request.h"
 #include "tensorflow_serving/util/net_http/server/internal/server_support.h"
 #include "tensorflow_serving/util/net_http/server/public/httpserver_interface.h"
 
 struct event_base;
+struct evconnlistener;
 struct evhttp;
 struct evhttp_bound_socket;
+struct evhttp_connection;
 struct evhttp_request;
+struct sockaddr;
 
 namespace tensorflow {
 namespace serving {
@@ -59,6 +64,9 @@ class EvHTTPServer final : public HTTPServerInterface, ServerSupport {
 
   int listen_port() const override;
 
+  // The port HTTP/2 is served on, or -1 if none.
+  int http2_listen_port() const { return http2_port_; }
+
   void Terminate() override;
 
   bool is_terminating() const override;
@@ -76,17 +84,112 @@ class EvHTTPServer final : public HTTPServerInterface, ServerSupport {
   void IncOps() override;
   void DecOps() override;
 
+  // Schedules 'fn' on the first event loop.
   bool EventLoopSchedule(std::function<void()> fn) override;
 
  private:
-  static void DispatchEvRequestFn(struct evhttp_request* req, void* server);
+  // An event loop with its own listener, which does the I/O of the requests
+  // that arrive on the connections it accepts.
+  class EventLoop final : public ServerSupport {
+   public:
+    explicit EventLoop(EvHTTPServer* server) : server_(server) {}
+    ~EventLoop() override;
+
+    bool Initialize();
+
+    // Starts listening on 'port'. With 'reuse_port', other loops may listen
+    // on the same port.
+    bool Bind(int port, bool reuse_port);
+
+    // Starts listening for h2c connections on 'port'.
+    bool BindHttp2(int port, bool reuse_port);
+
+    // Stops listening. Must be called from the event loop.
+    void Unbind();
+
+    void IncOps() override { server_->IncOps(); }
+    void DecOps() override { server_->DecOps(); }
+
+    // Schedules 'fn' on this event loop, where the request objects of its
+    // connections must reply.
+    bool EventLoopSchedule(std::function<void()> fn) override;
+
+    // Returns a request object for 'parsed_request', reusing one released by
+    // an earlier request if any. Must be called from the event loop.
+    std::unique_ptr<EvHTTPRequest> NewRequest(
+        std::unique_ptr<ParsedEvRequest> parsed_request);
+
+    // Keeps 'request' for reuse, up to the max_recycled_requests() option.
+    void ReleaseRequest(ServerRequestInterface* request) override;
+
+    // Counts 'req' towards the requests of its connection, and has the
+    // connection closed after the response if it reaches 'max_requests'.
+    // Must be called from the event loop.
+    void CountConnectionRequest(evhttp_request* req, int64_t max_requests);
+
+    EvHTTPServer* server() const { return server_; }
+    event_base* ev_base() const { return ev_base_; }
+    evhttp_bound_socket* ev_listener() const { return ev_listener_; }
+    evconnlistener* http2_listener() const { return http2_listener_; }
+
+   private:
+    static void ConnectionClosedFn(evhttp_connection* connection, void* loop);
+
+    static void AcceptHttp2Fn(evconnlistener* listener, evutil_socket_t fd,
+                              sockaddr* address, int socklen, void* loop);
 
-  void DispatchEvRequest(struct evhttp_request* req);
+    void AcceptHttp2(evutil_socket_t fd);
+
+    EvHTTPServer* const server_;
+
+    // The following are only used from the event loop.
+
+    // Request objects kept for reuse.
+    std::vector<std::unique_ptr<EvHTTPRequest>> recycled_requests_;
+
+    // The number of requests received so far on each open connection, if
+    // the max_requests_per_connection() option is set.
+    std::unordered_map<evhttp_connection*, int64_t> connection_requests_;
+
+    // The open HTTP/2 connections.
+    std::unordered_map<EvHTTP2Session*, std::shared_ptr<EvHTTP2Session>>
+        http2_sessions_;
+
+    // ev instances
+    event_base* ev_base_ = nullptr;
+    evhttp* ev_http_ = nullptr;
+    evhttp_bound_socket* ev_listener_ = nullptr;
+    evconnlistener* http2_listener_ = nullptr;
+
+    // Timeval used to register immediate callbacks, which are called
+    // in the order that they are registered.
+    const timeval* immediate_ = nullptr;
+  };
+
+  static void DispatchEvRequestFn(struct evhttp_request* req, void* loop);
+
+  void DispatchEvRequest(struct evhttp_request* req, EventLoop* loop);
+
+  // Whether nothing but the event loops themselves is pending.
+  bool OnlyEventLoopsPending() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(ops_mu_) {
+    return num_pending_ops_ <= static_cast<int64_t>(event_loops_.size());
+  }
+
+  void ExitEventLoops();
+
+  // Schedules the handler registered for 'path', or returned by a
+  // dispatcher, on the executor and releases 'request' to it. Returns false,
+  // leaving 'request' alone, if there is no handler.
+  template <typename Request>
+  bool ScheduleRequest(const std::string& path,
+                       std::unique_ptr<Request>* request)
+      ABSL_LOCKS_EXCLUDED(request_mu_);
 
   void ScheduleHandlerReference(const RequestHandler& handler,
-                                EvHTTPRequest* ev_request)
+                                ServerRequestInterface* request)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(request_mu_);
-  void ScheduleHandler(RequestHandler&& handler, EvHTTPRequest* ev_request)
+  void ScheduleHandler(RequestHandler&& handler,
+                       ServerRequestInterface* request)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(request_mu_);
 
   struct UriHandlerInfo {
@@ -113,6 +216,8 @@ class EvHTTPServer final : public HTTPServerInterface, ServerSupport {
   absl::Notification accepting_requests_;
   // Listener port
   int port_ = 0;
+  // HTTP/2 listener port, if any
+  int http2_port_ = -1;
 
   // Started terminating the server, i.e. Terminate() has been called
   absl::Notification terminating_;
@@ -126,14 +231,8 @@ class EvHTTPServer final : public HTTPServerInterface, ServerSupport {
       ABSL_GUARDED_BY(request_mu_);
   std::vector<DispatcherInfo> dispatchers_ ABSL_GUARDED_BY(request_mu_);
 
-  // ev instances
-  event_base* ev_base_ = nullptr;
-  evhttp* ev_http_ = nullptr;
-  evhttp_bound_socket* ev_listener_ = nullptr;
-
-  // Timeval used to register immediate callbacks, which are called
-  // in the order that they are registered.
-  const timeval* immediate_;
+  // Set by Initialize(), with server_options_->num_event_loops() entries.
+  std::vector<std::unique_ptr<EventLoop>> event_loops_;
 };
 
 }  // namespace net_http
@@ -0,0 +1,191 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Throughput and latency benchmarks of the EvHTTPServer, driven by many
+// concurrent keep-alive connections: each benchmark thread holds one
+// connection and sends requests to an echo handler back to back. Reports
+// requests per second (items_per_second), and the median and 99th percentile
+// latencies averaged over the connections.
+//
+// Arguments: (request and response body bytes, whether the bodies are
+// gzipped).
+//
+// Run with:
+// bazel run -c opt \
+// tensorflow_serving/util/net_http/server/internal:evhttp_server_benchmark --
+// --benchmarks=.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow_serving/util/net_http/client/test_client/internal/evhttp_connection.h"
+#include "tensorflow_serving/util/net_http/compression/gzip_zlib.h"
+#include "tensorflow_serving/util/net_http/internal/fixed_thread_pool.h"
+#include "tensorflow_serving/util/net_http/server/public/httpserver.h"
+#include "tensorflow_serving/util/net_http/server/public/httpserver_interface.h"
+#include "tensorflow_serving/util/net_http/server/public/server_request_interface.h"
+
+namespace tensorflow {
+namespace serving {
+namespace net_http {
+namespace {
+
+// The threads that run the handler.
+constexpr int kNumExecutorThreads = 8;
+
+class BenchmarkExecutor final : public EventExecutor {
+ public:
+  explicit BenchmarkExecutor(int num_threads) : thread_pool_(num_threads) {}
+
+  void Schedule(std::function<void()> fn) override {
+    thread_pool_.Schedule(fn);
+  }
+
+ private:
+  FixedThreadPool thread_pool_;
+};
+
+// Returns the port of a server, started on first use and shared by all
+// benchmarks, that echoes the body of each request to "/echo". Gzipped
+// request bodies are uncompressed, and response bodies are gzipped for the
+// clients that accept it.
+int GetEchoServerPort() {
+  static HTTPServerInterface* const server = []() {
+    auto options = absl::make_unique<ServerOptions>();
+    options->AddPort(0);
+    options->SetExecutor(
+        absl::make_unique<BenchmarkExecutor>(kNumExecutorThreads));
+    HTTPServerInterface* server =
+        CreateEvHTTPServer(std::move(options)).release();
+    CHECK(server != nullptr);
+    server->RegisterRequestHandler(
+        "/echo",
+        [](ServerRequestInterface* request) {
+          int64_t num_bytes;
+          while (true) {
+            auto bytes = request->ReadRequestBytes(&num_bytes);
+            if (bytes == nullptr) {
+              break;
+            }
+            request->WriteResponseBytes(bytes.get(), num_bytes);
+          }
+          request->Reply();
+        },
+        RequestHandlerOptions().set_auto_compress_output(true));
+    server->StartAcceptingRequests();
+    return server;
+  }();
+  return server->listen_port();
+}
+
+// Returns a body of 'size' bytes, which compresses about as well as JSON.
+std::string MakeBody(const int64_t size) {
+  std::string body;
+  body.reserve(size);
+  for (int i = 0; static_cast<int64_t>(body.size()) < size; ++i) {
+    body += "{\"instance\": [" + std::to_string(i * 7919 % 100003) + "]},";
+  }
+  body.resize(size);
+  return body;
+}
+
+std::string Gzip(const std::string& data) {
+  ZLib zlib;
+  uLongf compressed_size = ZLib::MinCompressbufSize(data.size());
+  std::string compressed(compressed_size, '\0');
+  CHECK_EQ(Z_OK, zlib.Compress(reinterpret_cast<Bytef*>(&compressed[0]),
+                               &compressed_size,
+                               reinterpret_cast<const Bytef*>(data.data()),
+                               data.size()));
+  compressed.resize(compressed_size);
+  return compressed;
+}
+
+int64_t Percentile(std::vector<int64_t>* values, const double percentile) {
+  if (values->empty()) {
+    return 0;
+  }
+  const size_t rank = std::min<size_t>(values->size() * percentile / 100,
+                                       values->size() - 1);
+  std::nth_element(values->begin(), values->begin() + rank, values->end());
+  return (*values)[rank];
+}
+
+void BM_EchoRoundTrip(::testing::benchmark::State& state) {
+  const int64_t body_size = state.range(0);
+  const bool gzip = state.range(1);
+  const std::string body =
+      gzip ? Gzip(MakeBody(body_size)) : MakeBody(body_size);
+
+  auto connection =
+      TestEvHTTPConnection::Connect("localhost", GetEchoServerPort());
+  CHECK(connection != nullptr);
+  TestClientRequest request = {"/echo", "POST", {}, body};
+  if (gzip) {
+    request.headers.emplace_back("Content-Encoding", "gzip");
+    request.headers.emplace_back("Accept-Encoding", "gzip");
+  }
+
+  std::vector<int64_t> latencies_micros;
+  for (auto s : state) {
+    TestClientResponse response = {};
+    const absl::Time start = absl::Now();
+    CHECK(connection->BlockingSendRequest(request, &response));
+    latencies_micros.push_back(absl::ToInt64Microseconds(absl::Now() - start));
+    CHECK(response.status == HTTPStatusCode::OK);
+  }
+  connection->Terminate();
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * body.size());
+  state.counters["p50_micros"] =
+      ::benchmark::Counter(Percentile(&latencies_micros, 50),
+                           ::benchmark::Counter::kAvgThreads);
+  state.counters["p99_micros"] =
+      ::benchmark::Counter(Percentile(&latencies_micros, 99),
+                           ::benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_EchoRoundTrip)
+    ->ArgPair(0, false)
+    ->ArgPair(1 << 10, false)
+    ->ArgPair(1 << 10, true)
+    ->ArgPair(64 << 10, false)
+    ->ArgPair(64 << 10, true)
+    ->ArgPair(1 << 20, false)
+    ->ArgPair(1 << 20, true)
+    ->UseRealTime()
+    ->ThreadRange(1, 64);
+
+}  // namespace
+}  // namespace net_http
+}  // namespace serving
+}  // namespace tensorflow
+
+int main(int argc, char** argv) {
+  tensorflow::port::InitMain(argv[0], &argc, &argv);
+  tensorflow::testing::RunBenchmarks();
+  return 0;
+}
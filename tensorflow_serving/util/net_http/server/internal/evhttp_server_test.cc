@@ -339,6 +339,142 @@ TEST_F(EvHTTPServerTest, ActiveRequestCountInShutdown) {
   // response.status etc are undefined as the server is terminated
 }
 
+// Test serving from multiple event loops sharing the port
+TEST(EvHTTPServerMultipleEventLoopsTest, ServesFromAllLoops) {
+  auto options = absl::make_unique<ServerOptions>();
+  options->AddPort(0);
+  options->SetNumEventLoops(3);
+  // Each loop holds a thread
+  options->SetExecutor(absl::make_unique<MyExecutor>(6));
+  auto server = CreateEvHTTPServer(std::move(options));
+  ASSERT_TRUE(server != nullptr);
+
+  auto handler = [](ServerRequestInterface* request) {
+    request->WriteResponseString("OK");
+    request->Reply();
+  };
+  server->RegisterRequestHandler("/ok", std::move(handler),
+                                 RequestHandlerOptions());
+  ASSERT_TRUE(server->StartAcceptingRequests());
+  ASSERT_NE(server->listen_port(), 0);
+
+  // Connections may land on any of the loops
+  for (int i = 0; i < 10; ++i) {
+    auto connection =
+        TestEvHTTPConnection::Connect("localhost", server->listen_port());
+    ASSERT_TRUE(connection != nullptr);
+
+    TestClientRequest request = {"/ok", "GET", {}, ""};
+    TestClientResponse response = {};
+
+    EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+    EXPECT_EQ(response.status, HTTPStatusCode::OK);
+    EXPECT_EQ(response.body, "OK");
+  }
+
+  server->Terminate();
+  server->WaitForTermination();
+}
+
+// Test servers, e.g. of different processes, sharing a port
+TEST(EvHTTPServerMultipleEventLoopsTest, ReusePort) {
+  auto create_server = [](int port) {
+    auto options = absl::make_unique<ServerOptions>();
+    options->AddPort(port);
+    options->SetReusePort(true);
+    options->SetExecutor(absl::make_unique<MyExecutor>(4));
+    auto server = CreateEvHTTPServer(std::move(options));
+    if (server != nullptr) {
+      server->RegisterRequestHandler(
+          "/ok",
+          [](ServerRequestInterface* request) {
+            request->WriteResponseString("OK");
+            request->Reply();
+          },
+          RequestHandlerOptions());
+    }
+    return server;
+  };
+  auto server1 = create_server(0);
+  ASSERT_TRUE(server1 != nullptr);
+  ASSERT_TRUE(server1->StartAcceptingRequests());
+  auto server2 = create_server(server1->listen_port());
+  ASSERT_TRUE(server2 != nullptr);
+  ASSERT_TRUE(server2->StartAcceptingRequests());
+  EXPECT_EQ(server1->listen_port(), server2->listen_port());
+
+  // Connections may land on either server
+  for (int i = 0; i < 10; ++i) {
+    auto connection =
+        TestEvHTTPConnection::Connect("localhost", server1->listen_port());
+    ASSERT_TRUE(connection != nullptr);
+
+    TestClientRequest request = {"/ok", "GET", {}, ""};
+    TestClientResponse response = {};
+
+    EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+    EXPECT_EQ(response.status, HTTPStatusCode::OK);
+    EXPECT_EQ(response.body, "OK");
+  }
+
+  server1->Terminate();
+  server1->WaitForTermination();
+  server2->Terminate();
+  server2->WaitForTermination();
+}
+
+// Test closing keep-alive connections after a number of requests, and
+// reusing request objects across requests
+TEST(EvHTTPServerConnectionTest, MaxRequestsPerConnection) {
+  auto options = absl::make_unique<ServerOptions>();
+  options->AddPort(0);
+  options->SetMaxRequestsPerConnection(2);
+  options->SetMaxRecycledRequests(1);
+  options->SetConnectionTimeout(absl::Seconds(10));
+  options->SetExecutor(absl::make_unique<MyExecutor>(4));
+  auto server = CreateEvHTTPServer(std::move(options));
+  ASSERT_TRUE(server != nullptr);
+
+  auto handler = [](ServerRequestInterface* request) {
+    request->WriteResponseString(request->uri_path());
+    request->Reply();
+  };
+  server->RegisterRequestHandler("/ok", std::move(handler),
+                                 RequestHandlerOptions());
+  ASSERT_TRUE(server->StartAcceptingRequests());
+
+  auto connection =
+      TestEvHTTPConnection::Connect("localhost", server->listen_port());
+  ASSERT_TRUE(connection != nullptr);
+
+  auto has_connection_close = [](const TestClientResponse& response) {
+    for (const auto& header : response.headers) {
+      if (header.first == "Connection" && header.second == "close") {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  TestClientRequest request = {"/ok?a=1", "GET", {}, ""};
+  TestClientResponse response = {};
+  EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+  EXPECT_EQ(response.status, HTTPStatusCode::OK);
+  EXPECT_EQ(response.body, "/ok?a=1");
+  EXPECT_FALSE(has_connection_close(response));
+
+  // The recycled request object carries nothing over
+  request = {"/ok?a=2", "GET", {}, ""};
+  response = {};
+  EXPECT_TRUE(connection->BlockingSendRequest(request, &response));
+  EXPECT_EQ(response.status, HTTPStatusCode::OK);
+  EXPECT_EQ(response.body, "/ok?a=2");
+  EXPECT_TRUE(has_connection_close(response));
+
+  server->Terminate();
+  server->WaitForTermination();
+}
+
 }  // namespace
 }  // namespace net_http
 }  // namespace serving
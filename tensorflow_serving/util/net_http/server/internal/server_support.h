@@ -43,6 +43,12 @@ class ServerSupport {
   // Returns false if any error.
   virtual bool EventLoopSchedule(std::function<void()> fn) = 0;
 
+  // Takes back a request that has replied, from the event loop. The server
+  // may reuse the request object for a later request, or delete it.
+  virtual void ReleaseRequest(ServerRequestInterface* request) {
+    delete request;
+  }
+
  protected:
   ServerSupport() = default;
 };
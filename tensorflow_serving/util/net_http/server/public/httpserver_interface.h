@@ -19,7 +19,7 @@ limitations under the License.
 #define TENSORFLOW_SERVING_UTIL_NET_HTTP_SERVER_PUBLIC_HTTPSERVER_INTERFACE_H_
 
 #include <cassert>
-
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -68,13 +68,99 @@ class ServerOptions {
     executor_ = std::move(executor);
   }
 
+  // The number of event loops that accept connections and do the socket I/O
+  // of the requests, parse them and write the responses. Defaults to 1.
+  //
+  // Each event loop has its own listening socket on the port, bound with
+  // SO_REUSEPORT so that the kernel spreads the incoming connections across
+  // the loops. Each loop runs on a thread of the executor for as long as the
+  // server runs.
+  void SetNumEventLoops(int num_event_loops) {
+    assert(num_event_loops >= 1);
+    num_event_loops_ = num_event_loops;
+  }
+
+  // Binds the listening sockets with SO_REUSEPORT even with a single event
+  // loop, so that other processes, e.g. the other worker processes of a
+  // server, may listen on the same port, and the kernel spreads the incoming
+  // connections across all of them.
+  void SetReusePort(bool reuse_port) { reuse_port_ = reuse_port; }
+
+  // How long a keep-alive connection may stay idle, or take to send a
+  // request or receive a response, before it is closed. Independent of how
+  // long the handlers take. Defaults to the libevent default of 50 seconds.
+  void SetConnectionTimeout(absl::Duration timeout) {
+    assert(timeout > absl::ZeroDuration());
+    connection_timeout_ = timeout;
+  }
+
+  // The most requests served on a keep-alive connection. The response to the
+  // last one carries "Connection: close", after which the client reconnects,
+  // which lets the kernel rebalance the connections across the event loops.
+  // 0, the default, is no limit.
+  void SetMaxRequestsPerConnection(int64_t max_requests) {
+    assert(max_requests >= 0);
+    max_requests_per_connection_ = max_requests;
+  }
+
+  // The most request objects each event loop keeps for reuse once their
+  // requests are done, which spares allocating them for later requests.
+  void SetMaxRecycledRequests(int max_requests) {
+    assert(max_requests >= 0);
+    max_recycled_requests_ = max_requests;
+  }
+
+  // Also serves HTTP/2 over cleartext TCP (h2c) on 'port', to clients that
+  // start with the HTTP/2 connection preface, i.e. that know the port speaks
+  // HTTP/2. 0 picks an ephemeral port. The requests go to the same handlers
+  // as the HTTP/1.1 ones, each stream of a connection being a request, and
+  // are served from the same event loops.
+  void SetHttp2Port(int port) {
+    assert(port >= 0);
+    http2_port_ = port;
+  }
+
+  // The most concurrent streams, i.e. requests in flight, on each HTTP/2
+  // connection. Defaults to 100.
+  void SetMaxConcurrentHttp2Streams(uint32_t max_streams) {
+    assert(max_streams > 0);
+    max_concurrent_http2_streams_ = max_streams;
+  }
+
   const std::vector<int>& ports() const { return ports_; }
 
   EventExecutor* executor() const { return executor_.get(); }
 
+  int num_event_loops() const { return num_event_loops_; }
+
+  bool reuse_port() const { return reuse_port_; }
+
+  // Zero if not set.
+  absl::Duration connection_timeout() const { return connection_timeout_; }
+
+  int64_t max_requests_per_connection() const {
+    return max_requests_per_connection_;
+  }
+
+  int max_recycled_requests() const { return max_recycled_requests_; }
+
+  // -1 if HTTP/2 isn't served.
+  int http2_port() const { return http2_port_; }
+
+  uint32_t max_concurrent_http2_streams() const {
+    return max_concurrent_http2_streams_;
+  }
+
  private:
   std::vector<int> ports_;
   std::unique_ptr<EventExecutor> executor_;
+  int num_event_loops_ = 1;
+  bool reuse_port_ = false;
+  absl::Duration connection_timeout_ = absl::ZeroDuration();
+  int64_t max_requests_per_connection_ = 0;
+  int max_recycled_requests_ = 64;
+  int http2_port_ = -1;
+  uint32_t max_concurrent_http2_streams_ = 100;
 };
 
 // Options to specify when registering a handler (given a uri pattern).
@@ -109,13 +195,40 @@ class RequestHandlerOptions {
 
   inline bool auto_uncompress_input() const { return auto_uncompress_input_; }
 
+  // The auto_compress_output option specifies whether the response body
+  // should be gzip compressed, with the Content-Encoding: gzip header, if
+  // the request accepts gzip (Accept-Encoding) and the body has at least
+  // auto_compress_min_size() bytes. Responses that already have a
+  // Content-Encoding are sent as is. The option defaults to false.
+  inline RequestHandlerOptions& set_auto_compress_output(bool should_compress) {
+    auto_compress_output_ = should_compress;
+    return *this;
+  }
+
+  inline bool auto_compress_output() const { return auto_compress_output_; }
+
+  // Sets the min length of a response body to compress, as smaller bodies
+  // don't gain enough from compression to pay for it.
+  inline RequestHandlerOptions& set_auto_compress_min_size(int64_t size) {
+    auto_compress_min_size_ = size;
+    return *this;
+  }
+
+  inline int64_t auto_compress_min_size() const {
+    return auto_compress_min_size_;
+  }
+
  private:
-  // To be added: compression, CORS rules, streaming control
+  // To be added: CORS rules, streaming control
   // thread executor, admission control, limits ...
 
   bool auto_uncompress_input_ = true;
 
   int64_t auto_uncompress_max_size_ = 0;
+
+  bool auto_compress_output_ = false;
+
+  int64_t auto_compress_min_size_ = 1024;
 };
 
 // A request handler is registered by the application to handle a request
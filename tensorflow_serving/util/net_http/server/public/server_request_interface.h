@@ -30,6 +30,7 @@ limitations under the License.
 #include <cstdlib>
 #include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -88,6 +89,11 @@ class ServerRequestInterface {
   // the response body.
   virtual void WriteResponseString(absl::string_view data) = 0;
 
+  // Appends 'data' to the end of the response body, taking its ownership
+  // rather than copying it, e.g. for a large serialized response. The data is
+  // released once it is sent.
+  virtual void WriteResponseBuffer(std::string data) = 0;
+
   // Reads from the request body.
   // Returns the number bytes of data read, whose ownership will be transferred
   // to the caller. Returns nullptr when EOF is reached or when there
@@ -101,6 +107,17 @@ class ServerRequestInterface {
   virtual std::unique_ptr<char[], ServerRequestInterface::BlockDeleter>
   ReadRequestBytes(int64_t* size) = 0;
 
+  // Returns the whole request body as one contiguous view, uncompressed as
+  // for ReadRequestBytes(), without copying it out a block at a time. The body
+  // is kept in the receive buffer where that is contiguous, so e.g. a JSON body
+  // is parsed straight from it.
+  //
+  // The view stays valid until the response is completed or the request is
+  // aborted. Returns "" when there is no body, or when it fails to read (see
+  // request_body_status()). Use either this or ReadRequestBytes() for a
+  // request, not both.
+  virtual absl::string_view ReadRequestBody() = 0;
+
   // Returns the first value, including "", associated with a request
   // header name. The header name argument is case-insensitive.
   // Returns nullptr if the specified header doesn't exist.
@@ -0,0 +1,48 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/numa_node_env.h"
+
+#include <map>
+#include <utility>
+
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+
+NumaNodeEnv::NumaNodeEnv(Env* target, int numa_node)
+    : EnvWrapper(target), numa_node_(numa_node) {}
+
+NumaNodeEnv* NumaNodeEnv::ForNode(int numa_node) {
+  static mutex mu(LINKER_INITIALIZED);
+  static auto* envs = new std::map<int, NumaNodeEnv*>();
+  mutex_lock l(mu);
+  NumaNodeEnv*& env = (*envs)[numa_node];
+  if (env == nullptr) {
+    env = new NumaNodeEnv(Env::Default(), numa_node);
+  }
+  return env;
+}
+
+Thread* NumaNodeEnv::StartThread(const ThreadOptions& thread_options,
+                                 const string& name, std::function<void()> fn) {
+  ThreadOptions options = thread_options;
+  options.numa_node = numa_node_;
+  return target()->StartThread(options, name, std::move(fn));
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,55 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_NUMA_NODE_ENV_H_
+#define TENSORFLOW_SERVING_UTIL_NUMA_NODE_ENV_H_
+
+#include <functional>
+#include <string>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+
+// An Env that starts all threads with affinity to one NUMA node, so that e.g.
+// the batch threads of a SharedBatchScheduler created with it stay on the
+// cores of that node. All other calls are forwarded to the wrapped Env.
+class NumaNodeEnv : public EnvWrapper {
+ public:
+  // 'target' must outlive this Env.
+  NumaNodeEnv(Env* target, int numa_node);
+  ~NumaNodeEnv() override = default;
+
+  // Returns an Env that wraps Env::Default() for 'numa_node'. The returned Env
+  // lives for the remainder of the process, like Env::Default() itself.
+  static NumaNodeEnv* ForNode(int numa_node);
+
+  Thread* StartThread(const ThreadOptions& thread_options, const string& name,
+                      std::function<void()> fn) override;
+
+  int numa_node() const { return numa_node_; }
+
+ private:
+  const int numa_node_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(NumaNodeEnv);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_NUMA_NODE_ENV_H_
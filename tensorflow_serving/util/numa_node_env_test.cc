@@ -0,0 +1,70 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/numa_node_env.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Records the NUMA node of the last thread started.
+class NumaNodeRecordingEnv : public EnvWrapper {
+ public:
+  NumaNodeRecordingEnv() : EnvWrapper(Env::Default()) {}
+
+  Thread* StartThread(const ThreadOptions& thread_options, const string& name,
+                      std::function<void()> fn) override {
+    last_numa_node_ = thread_options.numa_node;
+    return target()->StartThread(thread_options, name, std::move(fn));
+  }
+
+  int last_numa_node() const { return last_numa_node_; }
+
+ private:
+  int last_numa_node_ = port::kNUMANoAffinity;
+};
+
+TEST(NumaNodeEnvTest, StartsThreadsOnNode) {
+  NumaNodeRecordingEnv recording_env;
+  NumaNodeEnv env(&recording_env, /*numa_node=*/1);
+  bool ran = false;
+  {
+    std::unique_ptr<Thread> thread(
+        env.StartThread({}, "thread", [&ran] { ran = true; }));
+  }
+  EXPECT_TRUE(ran);
+  EXPECT_EQ(1, recording_env.last_numa_node());
+}
+
+TEST(NumaNodeEnvTest, ForNodeReturnsOneEnvPerNode) {
+  NumaNodeEnv* env = NumaNodeEnv::ForNode(0);
+  EXPECT_EQ(0, env->numa_node());
+  EXPECT_EQ(env, NumaNodeEnv::ForNode(0));
+  EXPECT_NE(env, NumaNodeEnv::ForNode(1));
+  EXPECT_EQ(1, NumaNodeEnv::ForNode(1)->numa_node());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow_serving/util/prometheus_exporter.h"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/match.h"
@@ -23,6 +24,8 @@ limitations under the License.
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "re2/re2.h"
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
 namespace serving {
@@ -31,6 +34,9 @@ namespace {
 
 string SanitizeLabelValue(const string& value) {
   // Backslash and double quote have to be escaped.
+  if (value.find_first_of("\\\"") == string::npos) {
+    return value;
+  }
   string new_value = value;
   // Replace \ with \\.
   RE2::GlobalReplace(&new_value, "\\\\", "\\\\\\\\");
@@ -62,9 +68,71 @@ string GetPrometheusMetricName(
   return new_name;
 }
 
+// Returns the labels of 'point', as name="value",name="value".
+string SerializeLabels(const monitoring::Point& point) {
+  std::vector<string> labels = {};
+  labels.reserve(point.labels.size());
+  for (const auto& label : point.labels) {
+    labels.push_back(absl::StrFormat("%s=\"%s\"", SanatizeLabelName(label.name),
+                                     SanitizeLabelValue(label.value)));
+  }
+  return absl::StrJoin(labels, ",");
+}
+
+bool LabelsEqual(const monitoring::Point& a, const monitoring::Point& b) {
+  if (a.labels.size() != b.labels.size()) {
+    return false;
+  }
+  for (int i = 0; i < a.labels.size(); ++i) {
+    if (a.labels[i].name != b.labels[i].name ||
+        a.labels[i].value != b.labels[i].value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if 'a' and 'b' are rendered alike.
+bool PointsEqual(const monitoring::Point& a, const monitoring::Point& b) {
+  if (a.int64_value != b.int64_value || !LabelsEqual(a, b)) {
+    return false;
+  }
+  const HistogramProto& a_histogram = a.histogram_value;
+  const HistogramProto& b_histogram = b.histogram_value;
+  if (a_histogram.sum() != b_histogram.sum() ||
+      a_histogram.bucket_size() != b_histogram.bucket_size() ||
+      a_histogram.bucket_limit_size() != b_histogram.bucket_limit_size()) {
+    return false;
+  }
+  for (int i = 0; i < a_histogram.bucket_size(); ++i) {
+    if (a_histogram.bucket(i) != b_histogram.bucket(i)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < a_histogram.bucket_limit_size(); ++i) {
+    if (a_histogram.bucket_limit(i) != b_histogram.bucket_limit(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PointSetsEqual(const std::vector<monitoring::Point>& points,
+                    const monitoring::PointSet& point_set) {
+  if (points.size() != point_set.points.size()) {
+    return false;
+  }
+  for (int i = 0; i < points.size(); ++i) {
+    if (!PointsEqual(points[i], *point_set.points[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void SerializeHistogram(const monitoring::MetricDescriptor& metric_descriptor,
                         const monitoring::PointSet& point_set,
-                        std::vector<string>* lines) {
+                        const std::vector<string>& labels, string* text) {
   // For a metric name NAME, we should output:
   //   NAME_bucket{le=b1} x1
   //   NAME_bucket{le=b2} x2
@@ -73,20 +141,14 @@ void SerializeHistogram(const monitoring::MetricDescriptor& metric_descriptor,
   //   NAME_count xcount
   string prom_metric_name = GetPrometheusMetricName(metric_descriptor);
   // Type definition line.
-  lines->push_back(absl::StrFormat("# TYPE %s histogram", prom_metric_name));
-  for (const auto& point : point_set.points) {
+  absl::StrAppend(text, "# TYPE ", prom_metric_name, " histogram\n");
+  for (int p = 0; p < point_set.points.size(); ++p) {
     // Each points has differnet label values.
-    std::vector<string> labels = {};
-    labels.reserve(point->labels.size());
-    for (const auto& label : point->labels) {
-      labels.push_back(absl::StrFormat("%s=\"%s\"",
-                                       SanatizeLabelName(label.name),
-                                       SanitizeLabelValue(label.value)));
-    }
+    const auto& point = point_set.points[p];
     int64_t cumulative_count = 0;
     string bucket_prefix =
-        absl::StrCat(prom_metric_name, "_bucket{", absl::StrJoin(labels, ","));
-    if (!labels.empty()) {
+        absl::StrCat(prom_metric_name, "_bucket{", labels[p]);
+    if (!labels[p].empty()) {
       absl::StrAppend(&bucket_prefix, ",");
     }
     // One bucket per line, last one should be le="Inf".
@@ -96,23 +158,20 @@ void SerializeHistogram(const monitoring::MetricDescriptor& metric_descriptor,
           (i < point->histogram_value.bucket_size() - 1)
               ? absl::StrCat(point->histogram_value.bucket_limit(i))
               : "+Inf";
-      lines->push_back(absl::StrCat(
-          bucket_prefix, absl::StrFormat("le=\"%s\"} ", bucket_limit),
-          cumulative_count));
+      absl::StrAppend(text, bucket_prefix, "le=\"", bucket_limit, "\"} ",
+                      cumulative_count, "\n");
     }
     // _sum and _count.
-    lines->push_back(absl::StrCat(prom_metric_name, "_sum{",
-                                  absl::StrJoin(labels, ","), "} ",
-                                  point->histogram_value.sum()));
-    lines->push_back(absl::StrCat(prom_metric_name, "_count{",
-                                  absl::StrJoin(labels, ","), "} ",
-                                  cumulative_count));
+    absl::StrAppend(text, prom_metric_name, "_sum{", labels[p], "} ",
+                    point->histogram_value.sum(), "\n");
+    absl::StrAppend(text, prom_metric_name, "_count{", labels[p], "} ",
+                    cumulative_count, "\n");
   }
 }
 
 void SerializeScalar(const monitoring::MetricDescriptor& metric_descriptor,
                      const monitoring::PointSet& point_set,
-                     std::vector<string>* lines) {
+                     const std::vector<string>& labels, string* text) {
   // A counter or gauge metric.
   // The format should be:
   //   NAME{label=value,label=value} x time
@@ -124,30 +183,12 @@ void SerializeScalar(const monitoring::MetricDescriptor& metric_descriptor,
     metric_type_str = "gauge";
   }
   // Type definition line.
-  lines->push_back(
-      absl::StrFormat("# TYPE %s %s", prom_metric_name, metric_type_str));
-  for (const auto& point : point_set.points) {
+  absl::StrAppend(text, "# TYPE ", prom_metric_name, " ", metric_type_str,
+                  "\n");
+  for (int p = 0; p < point_set.points.size(); ++p) {
     // Each points has differnet label values.
-    string name_bracket = absl::StrCat(prom_metric_name, "{");
-    std::vector<string> labels = {};
-    labels.reserve(point->labels.size());
-    for (const auto& label : point->labels) {
-      labels.push_back(absl::StrFormat("%s=\"%s\"",
-                                       SanatizeLabelName(label.name),
-                                       SanitizeLabelValue(label.value)));
-    }
-    lines->push_back(absl::StrCat(name_bracket, absl::StrJoin(labels, ","),
-                                  absl::StrFormat("} %d", point->int64_value)));
-  }
-}
-
-void SerializeMetric(const monitoring::MetricDescriptor& metric_descriptor,
-                     const monitoring::PointSet& point_set,
-                     std::vector<string>* lines) {
-  if (metric_descriptor.value_type == monitoring::ValueType::kHistogram) {
-    SerializeHistogram(metric_descriptor, point_set, lines);
-  } else {
-    SerializeScalar(metric_descriptor, point_set, lines);
+    absl::StrAppend(text, prom_metric_name, "{", labels[p], "} ",
+                    point_set.points[p]->int64_value, "\n");
   }
 }
 
@@ -165,6 +206,15 @@ Status PrometheusExporter::GeneratePage(string* http_page) {
         static_cast<absl::StatusCode>(absl::StatusCode::kInvalidArgument),
         "Http page pointer is null");
   }
+  string page;
+  TF_RETURN_IF_ERROR(WritePage(
+      [&page](absl::string_view piece) { absl::StrAppend(&page, piece); }));
+  *http_page = std::move(page);
+  return absl::OkStatus();
+}
+
+Status PrometheusExporter::WritePage(
+    const std::function<void(absl::string_view)>& write) {
   monitoring::CollectionRegistry::CollectMetricsOptions collect_options;
   collect_options.collect_metric_descriptors = true;
   const std::unique_ptr<monitoring::CollectedMetrics> collected_metrics =
@@ -173,7 +223,10 @@ Status PrometheusExporter::GeneratePage(string* http_page) {
   const auto& descriptor_map = collected_metrics->metric_descriptor_map;
   const auto& metric_map = collected_metrics->point_set_map;
 
-  std::vector<string> lines;
+  mutex_lock l(mu_);
+  // Families of metrics that are gone are dropped with the old map.
+  absl::flat_hash_map<string, RenderedFamily> rendered_families;
+  rendered_families.reserve(descriptor_map.size());
   for (const auto& name_and_metric_descriptor : descriptor_map) {
     const string& metric_name = name_and_metric_descriptor.first;
     auto metric_iterator = metric_map.find(metric_name);
@@ -181,13 +234,51 @@ Status PrometheusExporter::GeneratePage(string* http_page) {
       // Not found.
       continue;
     }
-    SerializeMetric(*name_and_metric_descriptor.second,
-                    *(metric_iterator->second), &lines);
+    const monitoring::PointSet& point_set = *(metric_iterator->second);
+    RenderedFamily family;
+    auto rendered_iterator = rendered_families_.find(metric_name);
+    if (rendered_iterator != rendered_families_.end()) {
+      family = std::move(rendered_iterator->second);
+    }
+    if (rendered_iterator == rendered_families_.end() ||
+        !PointSetsEqual(family.points, point_set)) {
+      Render(*name_and_metric_descriptor.second, point_set, &family);
+    }
+    write(family.text);
+    rendered_families.emplace(metric_name, std::move(family));
   }
-  *http_page = absl::StrJoin(lines, "\n");
-  absl::StrAppend(http_page, "\n");
+  rendered_families_ = std::move(rendered_families);
   return absl::OkStatus();
 }
 
+// static
+void PrometheusExporter::Render(
+    const monitoring::MetricDescriptor& metric_descriptor,
+    const monitoring::PointSet& point_set, RenderedFamily* family) {
+  std::vector<string> labels;
+  labels.reserve(point_set.points.size());
+  for (int i = 0; i < point_set.points.size(); ++i) {
+    const monitoring::Point& point = *point_set.points[i];
+    if (i < family->points.size() && LabelsEqual(family->points[i], point)) {
+      labels.push_back(std::move(family->labels[i]));
+    } else {
+      labels.push_back(SerializeLabels(point));
+    }
+  }
+
+  family->text.clear();
+  if (metric_descriptor.value_type == monitoring::ValueType::kHistogram) {
+    SerializeHistogram(metric_descriptor, point_set, labels, &family->text);
+  } else {
+    SerializeScalar(metric_descriptor, point_set, labels, &family->text);
+  }
+  family->labels = std::move(labels);
+  family->points.clear();
+  family->points.reserve(point_set.points.size());
+  for (const auto& point : point_set.points) {
+    family->points.push_back(*point);
+  }
+}
+
 }  // namespace serving
 }  // namespace tensorflow
@@ -16,16 +16,29 @@ limitations under the License.
 #ifndef TENSORFLOW_SERVING_UTIL_PROMETHEUS_EXPORTER_H_
 #define TENSORFLOW_SERVING_UTIL_PROMETHEUS_EXPORTER_H_
 
+#include <functional>
+#include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/monitoring/collected_metrics.h"
 #include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace serving {
 
 // Exports metrics in Prometheus monitoring format.
+//
+// The text of each metric family is kept between pages, and only rendered
+// again if the points of the family changed, so that the many families that
+// don't change between scrapes (e.g. of idle models) cost a comparison rather
+// than formatting. The labels of points are kept as well.
+//
+// This class is thread-safe.
 class PrometheusExporter {
  public:
   // Default path to expose the metrics.
@@ -38,9 +51,34 @@ class PrometheusExporter {
   // If an error status returned, http_page is unchanged.
   Status GeneratePage(string* http_page);
 
+  // Like GeneratePage(), but passes the page to 'write' in pieces, e.g. to
+  // write them to the HTTP response as they come.
+  Status WritePage(const std::function<void(absl::string_view)>& write)
+      TF_LOCKS_EXCLUDED(mu_);
+
  private:
+  // The text of a metric family, and the points it was rendered from.
+  struct RenderedFamily {
+    std::vector<monitoring::Point> points;
+    // The serialized labels of each of the points.
+    std::vector<string> labels;
+    string text;
+  };
+
+  // Renders 'point_set' into 'family', reusing the labels of its previous
+  // points.
+  static void Render(const monitoring::MetricDescriptor& metric_descriptor,
+                     const monitoring::PointSet& point_set,
+                     RenderedFamily* family);
+
   // The metrics registry.
   monitoring::CollectionRegistry* collection_registry_;
+
+  mutex mu_;
+
+  // The families of the last page, by metric name.
+  absl::flat_hash_map<string, RenderedFamily> rendered_families_
+      TF_GUARDED_BY(mu_);
 };
 
 }  // namespace serving
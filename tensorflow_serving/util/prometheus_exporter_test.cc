@@ -19,6 +19,8 @@ limitations under the License.
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/monitoring/gauge.h"
 #include "tensorflow/core/lib/monitoring/sampler.h"
@@ -142,6 +144,33 @@ TEST(PrometheusExporterTest, SanitizeMetricName) {
   EXPECT_PRED_FORMAT2(testing::IsSubstring, expected_result, http_page);
 }
 
+TEST(PrometheusExporterTest, RendersChangedFamiliesAgain) {
+  auto exporter = absl::make_unique<PrometheusExporter>();
+  auto counter = absl::WrapUnique(
+      monitoring::Counter<1>::New("/test/path/changing", "A counter.", "name"));
+  counter->GetCell("abc")->IncrementBy(2);
+
+  string http_page;
+  TF_ASSERT_OK(exporter->GeneratePage(&http_page));
+  EXPECT_PRED_FORMAT2(testing::IsSubstring,
+                      ":test:path:changing{name=\"abc\"} 2\n", http_page);
+
+  // Unchanged families are written from the last page.
+  string written_page;
+  TF_ASSERT_OK(exporter->WritePage([&written_page](absl::string_view piece) {
+    absl::StrAppend(&written_page, piece);
+  }));
+  EXPECT_EQ(http_page, written_page);
+
+  counter->GetCell("abc")->IncrementBy(1);
+  counter->GetCell("def")->IncrementBy(4);
+  TF_ASSERT_OK(exporter->GeneratePage(&http_page));
+  EXPECT_PRED_FORMAT2(testing::IsSubstring,
+                      absl::StrCat(":test:path:changing{name=\"abc\"} 3\n",
+                                   ":test:path:changing{name=\"def\"} 4\n"),
+                      http_page);
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
@@ -0,0 +1,90 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/request_arena.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "tensorflow_serving/util/memory_accounting.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+// The block a thread keeps for its request arenas.
+struct ThreadBlock {
+  std::unique_ptr<char[]> block;
+  size_t bytes = 0;
+  MemoryCharge charge;
+  // Whether a RequestArena has the block.
+  bool in_use = false;
+
+  void Allocate(const size_t new_bytes) {
+    block.reset(new char[new_bytes]);
+    bytes = new_bytes;
+    charge = MemoryCharge(MemorySubsystem::kRequestArenas, new_bytes);
+  }
+};
+
+thread_local ThreadBlock thread_block;
+
+}  // namespace
+
+constexpr size_t RequestArena::kMinBlockBytes;
+constexpr size_t RequestArena::kMaxBlockBytes;
+
+RequestArena::RequestArena() {
+  if (thread_block.in_use) {
+    arena_.emplace();
+    return;
+  }
+  if (thread_block.block == nullptr) {
+    thread_block.Allocate(kMinBlockBytes);
+  }
+  thread_block.in_use = true;
+  has_thread_block_ = true;
+  ::google::protobuf::ArenaOptions options;
+  options.initial_block = thread_block.block.get();
+  options.initial_block_size = thread_block.bytes;
+  arena_.emplace(options);
+}
+
+RequestArena::~RequestArena() {
+  const size_t space_allocated = arena_->SpaceAllocated();
+  // The arena is done with the block once it is destroyed.
+  arena_.reset();
+  if (!has_thread_block_) {
+    return;
+  }
+  thread_block.in_use = false;
+  if (space_allocated > thread_block.bytes &&
+      thread_block.bytes < kMaxBlockBytes) {
+    // Grow the block to fit the request, in powers of two to settle quickly.
+    size_t new_bytes = thread_block.bytes;
+    while (new_bytes < space_allocated && new_bytes < kMaxBlockBytes) {
+      new_bytes *= 2;
+    }
+    thread_block.Allocate(std::min(new_bytes, kMaxBlockBytes));
+  }
+}
+
+size_t RequestArena::ThreadBlockBytesForTesting() {
+  return thread_block.bytes;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
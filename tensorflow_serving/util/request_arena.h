@@ -0,0 +1,70 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_REQUEST_ARENA_H_
+#define TENSORFLOW_SERVING_UTIL_REQUEST_ARENA_H_
+
+#include <cstddef>
+
+#include "google/protobuf/arena.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace tensorflow {
+namespace serving {
+
+// A protobuf Arena for the messages of one request, e.g. its parsed
+// PredictRequest and the PredictResponse, whose first block is reused by the
+// requests served on the same thread after it.
+//
+// A plain Arena mallocs its blocks for each request and frees them at its end,
+// interleaved with the allocations of the other requests and of the models,
+// which fragments the heap over the uptime of the server. Each thread instead
+// keeps one block, which grows to fit the largest request it has served, up to
+// kMaxBlockBytes, so the messages of most requests are bump-allocated from
+// memory the thread already holds. The blocks held are charged to
+// MemorySubsystem::kRequestArenas.
+//
+// An arena made on a thread while another one is alive on it starts without a
+// block of its own, like a plain Arena.
+class RequestArena {
+ public:
+  // The size of the first block of a thread, and the most a block grows to.
+  static constexpr size_t kMinBlockBytes = 64 << 10;
+  static constexpr size_t kMaxBlockBytes = 4 << 20;
+
+  RequestArena();
+
+  // Frees the messages, and returns the block to the thread.
+  ~RequestArena();
+
+  ::google::protobuf::Arena* get() { return &*arena_; }
+
+  // Returns the size of the block the calling thread keeps. For tests.
+  static size_t ThreadBlockBytesForTesting();
+
+ private:
+  // Whether the arena has the block of its thread.
+  bool has_thread_block_ = false;
+
+  absl::optional<::google::protobuf::Arena> arena_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RequestArena);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_REQUEST_ARENA_H_
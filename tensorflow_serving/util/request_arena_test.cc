@@ -0,0 +1,93 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/request_arena.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+// Returns where a message made on 'arena' goes.
+uintptr_t FirstMessageAddress(RequestArena* arena) {
+  return reinterpret_cast<uintptr_t>(
+      ::google::protobuf::Arena::Create<TensorProto>(arena->get()));
+}
+
+// Runs 'fn' on a new thread, which starts without a block.
+void RunOnNewThread(std::function<void()> fn) {
+  std::unique_ptr<Thread> thread(
+      Env::Default()->StartThread({}, "request_arena_test", std::move(fn)));
+}
+
+TEST(RequestArenaTest, ReusesThreadBlock) {
+  RunOnNewThread([]() {
+    uintptr_t first_address, second_address;
+    {
+      RequestArena arena;
+      first_address = FirstMessageAddress(&arena);
+    }
+    {
+      RequestArena arena;
+      second_address = FirstMessageAddress(&arena);
+
+      // A nested arena does not share the block.
+      RequestArena nested_arena;
+      EXPECT_NE(second_address, FirstMessageAddress(&nested_arena));
+    }
+    EXPECT_EQ(first_address, second_address);
+    EXPECT_EQ(RequestArena::kMinBlockBytes,
+              RequestArena::ThreadBlockBytesForTesting());
+  });
+}
+
+TEST(RequestArenaTest, GrowsThreadBlockUpToMax) {
+  RunOnNewThread([]() {
+    {
+      RequestArena arena;
+      ::google::protobuf::Arena::CreateArray<char>(arena.get(), 200 << 10);
+    }
+    const size_t grown_bytes = RequestArena::ThreadBlockBytesForTesting();
+    EXPECT_GE(grown_bytes, 200 << 10);
+    EXPECT_LT(grown_bytes, RequestArena::kMaxBlockBytes);
+
+    // Smaller requests keep the block.
+    {
+      RequestArena arena;
+      ::google::protobuf::Arena::CreateArray<char>(arena.get(), 100 << 10);
+    }
+    EXPECT_EQ(grown_bytes, RequestArena::ThreadBlockBytesForTesting());
+
+    {
+      RequestArena arena;
+      ::google::protobuf::Arena::CreateArray<char>(
+          arena.get(), 2 * RequestArena::kMaxBlockBytes);
+    }
+    EXPECT_EQ(RequestArena::kMaxBlockBytes,
+              RequestArena::ThreadBlockBytesForTesting());
+  });
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,78 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/request_deadline.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/time/clock.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+thread_local std::shared_ptr<const RequestDeadline> current_request_deadline;
+
+}  // namespace
+
+Status RequestDeadline::Check() const {
+  if (IsCancelled()) {
+    return errors::Cancelled("The request was cancelled by its caller");
+  }
+  if (deadline_ != absl::InfiniteFuture() && absl::Now() >= deadline_) {
+    return errors::DeadlineExceeded("The deadline of the request has passed");
+  }
+  return OkStatus();
+}
+
+Status RequestDeadline::Apply(RunOptions* run_options) const {
+  TF_RETURN_IF_ERROR(Check());
+  if (deadline_ == absl::InfiniteFuture()) {
+    return OkStatus();
+  }
+  // A timeout of 0 means none, so round the time left up to 1ms.
+  const int64_t time_left_ms = std::max<int64_t>(
+      1, absl::ToInt64Milliseconds(deadline_ - absl::Now()));
+  if (run_options->timeout_in_ms() <= 0 ||
+      run_options->timeout_in_ms() > time_left_ms) {
+    run_options->set_timeout_in_ms(time_left_ms);
+  }
+  return OkStatus();
+}
+
+std::shared_ptr<const RequestDeadline> RequestDeadline::Current() {
+  return current_request_deadline;
+}
+
+ScopedRequestDeadline::ScopedRequestDeadline(
+    std::shared_ptr<const RequestDeadline> deadline)
+    : previous_(std::exchange(current_request_deadline, std::move(deadline))) {}
+
+ScopedRequestDeadline::~ScopedRequestDeadline() {
+  current_request_deadline = std::move(previous_);
+}
+
+Status ApplyCurrentRequestDeadline(RunOptions* run_options) {
+  if (current_request_deadline == nullptr) {
+    return OkStatus();
+  }
+  return current_request_deadline->Apply(run_options);
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,94 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_REQUEST_DEADLINE_H_
+#define TENSORFLOW_SERVING_UTIL_REQUEST_DEADLINE_H_
+
+#include <functional>
+#include <memory>
+
+#include "absl/time/time.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// The deadline of a request, and whether its caller has cancelled it.
+//
+// The RPC handlers set the deadline of the request they serve for the calling
+// thread, with ScopedRequestDeadline, when they take the request in. The layers
+// below, which the request reaches through interfaces that have no room for it
+// (e.g. Session::Run()), pick it up with Current(): the sessions charge the
+// time the request has spent (parsing, handle lookup, ...) against the timeout
+// of their runs, and drop requests that are cancelled or past their deadline,
+// e.g. while they wait in a batch queue.
+class RequestDeadline {
+ public:
+  // 'is_cancelled', if set, returns whether the caller has cancelled the
+  // request. It must stay callable until the request is responded to.
+  RequestDeadline(absl::Time deadline, std::function<bool()> is_cancelled)
+      : deadline_(deadline), is_cancelled_(std::move(is_cancelled)) {}
+
+  // absl::InfiniteFuture() if the request has no deadline.
+  absl::Time deadline() const { return deadline_; }
+
+  bool IsCancelled() const {
+    return is_cancelled_ != nullptr && is_cancelled_();
+  }
+
+  // Returns a Cancelled error if the caller has cancelled the request, a
+  // DeadlineExceeded error if the deadline has passed, and OK otherwise.
+  Status Check() const;
+
+  // Checks the request like Check(), and if it may go on, lowers the timeout of
+  // 'run_options' to the time left before the deadline.
+  Status Apply(RunOptions* run_options) const;
+
+  // Returns the deadline of the request the calling thread serves, or null if
+  // it serves none.
+  static std::shared_ptr<const RequestDeadline> Current();
+
+ private:
+  const absl::Time deadline_;
+  const std::function<bool()> is_cancelled_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RequestDeadline);
+};
+
+// Makes RequestDeadline::Current() return 'deadline' in the calling thread for
+// the lifetime of this object.
+class ScopedRequestDeadline {
+ public:
+  explicit ScopedRequestDeadline(
+      std::shared_ptr<const RequestDeadline> deadline);
+
+  ~ScopedRequestDeadline();
+
+ private:
+  std::shared_ptr<const RequestDeadline> previous_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedRequestDeadline);
+};
+
+// Applies the deadline of the request the calling thread serves, if any, to
+// 'run_options' (see RequestDeadline::Apply()).
+Status ApplyCurrentRequestDeadline(RunOptions* run_options);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_REQUEST_DEADLINE_H_
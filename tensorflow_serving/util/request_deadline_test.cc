@@ -0,0 +1,96 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/request_deadline.h"
+
+#include <atomic>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "absl/time/clock.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/protobuf/error_codes.pb.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+TEST(RequestDeadlineTest, ChargesTimeLeft) {
+  const RequestDeadline deadline(absl::Now() + absl::Hours(1), nullptr);
+  TF_EXPECT_OK(deadline.Check());
+
+  // No timeout, or a longer one, is lowered to the time left.
+  RunOptions run_options;
+  TF_ASSERT_OK(deadline.Apply(&run_options));
+  EXPECT_GT(run_options.timeout_in_ms(), 0);
+  EXPECT_LE(run_options.timeout_in_ms(), 3600 * 1000);
+  run_options.set_timeout_in_ms(24 * 3600 * 1000);
+  TF_ASSERT_OK(deadline.Apply(&run_options));
+  EXPECT_LE(run_options.timeout_in_ms(), 3600 * 1000);
+
+  // A shorter timeout is kept.
+  run_options.set_timeout_in_ms(10);
+  TF_ASSERT_OK(deadline.Apply(&run_options));
+  EXPECT_EQ(10, run_options.timeout_in_ms());
+}
+
+TEST(RequestDeadlineTest, NoDeadline) {
+  const RequestDeadline deadline(absl::InfiniteFuture(), nullptr);
+  RunOptions run_options;
+  TF_ASSERT_OK(deadline.Apply(&run_options));
+  EXPECT_EQ(0, run_options.timeout_in_ms());
+}
+
+TEST(RequestDeadlineTest, FailsPastDeadlineOrCancelled) {
+  const RequestDeadline past(absl::Now() - absl::Seconds(1), nullptr);
+  RunOptions run_options;
+  EXPECT_EQ(error::DEADLINE_EXCEEDED, past.Apply(&run_options).code());
+
+  std::atomic<bool> cancelled{false};
+  const RequestDeadline cancellable(
+      absl::InfiniteFuture(), [&cancelled]() { return cancelled.load(); });
+  TF_EXPECT_OK(cancellable.Check());
+  cancelled = true;
+  EXPECT_TRUE(cancellable.IsCancelled());
+  EXPECT_EQ(error::CANCELLED, cancellable.Check().code());
+}
+
+TEST(RequestDeadlineTest, Current) {
+  EXPECT_EQ(nullptr, RequestDeadline::Current());
+  RunOptions run_options;
+  TF_EXPECT_OK(ApplyCurrentRequestDeadline(&run_options));
+  EXPECT_EQ(0, run_options.timeout_in_ms());
+
+  auto outer = std::make_shared<RequestDeadline>(
+      absl::Now() + absl::Hours(1), nullptr);
+  auto inner = std::make_shared<RequestDeadline>(
+      absl::Now() - absl::Seconds(1), nullptr);
+  {
+    ScopedRequestDeadline outer_scope(outer);
+    EXPECT_EQ(outer, RequestDeadline::Current());
+    {
+      ScopedRequestDeadline inner_scope(inner);
+      EXPECT_EQ(inner, RequestDeadline::Current());
+      EXPECT_FALSE(ApplyCurrentRequestDeadline(&run_options).ok());
+    }
+    EXPECT_EQ(outer, RequestDeadline::Current());
+    TF_EXPECT_OK(ApplyCurrentRequestDeadline(&run_options));
+  }
+  EXPECT_EQ(nullptr, RequestDeadline::Current());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
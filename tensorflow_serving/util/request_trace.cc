@@ -0,0 +1,334 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/request_trace.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+auto* dropped_spans = monitoring::Counter<0>::New(
+    "/tensorflow/serving/request_trace/dropped_spans",
+    "Total count of spans of traced requests dropped because the queue of "
+    "spans to export was full");
+
+// How long the export thread waits for more spans, once it's out of them.
+constexpr int64_t kExportIntervalMillis = 200;
+
+thread_local CurrentTraceInfo current_trace;
+
+// Parses the first 'digits' characters of 'hex' as a hex number.
+bool ParseHex(absl::string_view hex, const int digits, uint64_t* value) {
+  if (hex.size() < digits) {
+    return false;
+  }
+  *value = 0;
+  for (int i = 0; i < digits; ++i) {
+    const char c = hex[i];
+    int digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else {
+      return false;
+    }
+    *value = (*value << 4) | digit;
+  }
+  return true;
+}
+
+// Returns a random id, which is never 0 (i.e. invalid).
+uint64_t NewId() {
+  uint64_t id;
+  do {
+    id = random::New64();
+  } while (id == 0);
+  return id;
+}
+
+// Appends 'value' to 'json' as a JSON string.
+void AppendJsonString(absl::string_view value, string* json) {
+  json->push_back('"');
+  for (const char c : value) {
+    if (c == '"' || c == '\\') {
+      json->push_back('\\');
+      json->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      absl::StrAppendFormat(json, "\\u%04x", static_cast<int>(c));
+    } else {
+      json->push_back(c);
+    }
+  }
+  json->push_back('"');
+}
+
+// Appends 'span' to 'json' as an OTLP/JSON span.
+void AppendOtlpJsonSpan(const Span& span, string* json) {
+  absl::StrAppendFormat(
+      json, "{\"traceId\":\"%016x%016x\",\"spanId\":\"%016x\",",
+      span.context.trace_id_high, span.context.trace_id_low,
+      span.context.span_id);
+  if (span.parent_span_id != 0) {
+    absl::StrAppendFormat(json, "\"parentSpanId\":\"%016x\",",
+                          span.parent_span_id);
+  }
+  absl::StrAppend(json, "\"name\":");
+  AppendJsonString(span.name, json);
+  // SPAN_KIND_SERVER or SPAN_KIND_INTERNAL.
+  absl::StrAppend(json, ",\"kind\":", span.server ? 2 : 1,
+                  ",\"startTimeUnixNano\":\"", span.start_micros, "000\"",
+                  ",\"endTimeUnixNano\":\"", span.end_micros, "000\"",
+                  ",\"attributes\":[");
+  for (int i = 0; i < span.attributes.size(); ++i) {
+    if (i > 0) {
+      json->push_back(',');
+    }
+    absl::StrAppend(json, "{\"key\":");
+    AppendJsonString(span.attributes[i].first, json);
+    absl::StrAppend(json, ",\"value\":{\"stringValue\":");
+    AppendJsonString(span.attributes[i].second, json);
+    absl::StrAppend(json, "}}");
+  }
+  absl::StrAppend(json, "]}");
+}
+
+}  // namespace
+
+bool TraceContext::FromTraceparent(const absl::string_view traceparent,
+                                   TraceContext* const context,
+                                   bool* const sampled) {
+  // version "-" trace-id "-" parent-id "-" trace-flags, where later versions
+  // may append fields.
+  constexpr int kLength = 2 + 1 + 32 + 1 + 16 + 1 + 2;
+  uint64_t version, flags;
+  TraceContext parsed;
+  if (traceparent.size() < kLength || traceparent[2] != '-' ||
+      traceparent[35] != '-' || traceparent[52] != '-' ||
+      !ParseHex(traceparent, 2, &version) || version == 0xff ||
+      (version == 0 && traceparent.size() != kLength) ||
+      !ParseHex(traceparent.substr(3), 16, &parsed.trace_id_high) ||
+      !ParseHex(traceparent.substr(19), 16, &parsed.trace_id_low) ||
+      !ParseHex(traceparent.substr(36), 16, &parsed.span_id) ||
+      !ParseHex(traceparent.substr(53), 2, &flags) || !parsed.valid()) {
+    return false;
+  }
+  *context = parsed;
+  *sampled = (flags & 0x1) != 0;
+  return true;
+}
+
+string TraceContext::ToTraceparent() const {
+  return absl::StrFormat("00-%016x%016x-%016x-01", trace_id_high, trace_id_low,
+                         span_id);
+}
+
+Status OtlpJsonFileSpanExporter::Create(
+    const string& filename, std::unique_ptr<SpanExporter>* const exporter) {
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewAppendableFile(filename, &file));
+  exporter->reset(new OtlpJsonFileSpanExporter(std::move(file)));
+  return OkStatus();
+}
+
+Status OtlpJsonFileSpanExporter::Export(const std::vector<Span>& spans) {
+  string json =
+      "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":"
+      "\"service.name\",\"value\":{\"stringValue\":\"tensorflow_serving\"}}]},"
+      "\"scopeSpans\":[{\"scope\":{\"name\":\"tensorflow_serving\"},"
+      "\"spans\":[";
+  for (int i = 0; i < spans.size(); ++i) {
+    if (i > 0) {
+      json.push_back(',');
+    }
+    AppendOtlpJsonSpan(spans[i], &json);
+  }
+  absl::StrAppend(&json, "]}]}]}\n");
+  TF_RETURN_IF_ERROR(file_->Append(json));
+  return file_->Flush();
+}
+
+std::atomic<RequestTracer*> RequestTracer::global_tracer_{nullptr};
+
+RequestTracer::RequestTracer(Options options)
+    : options_(std::move(options)),
+      queue_(std::max(1, options_.queue_capacity)) {
+  export_thread_.reset(options_.env->StartThread(
+      {}, "request_trace_exporter", [this]() { ExportQueuedSpans(); }));
+}
+
+RequestTracer::~RequestTracer() {
+  {
+    mutex_lock l(stop_mu_);
+    stopping_ = true;
+    stop_cv_.notify_all();
+  }
+  export_thread_.reset();
+  Flush();
+}
+
+Status RequestTracer::SetGlobal(std::unique_ptr<RequestTracer> tracer) {
+  RequestTracer* expected = nullptr;
+  if (!global_tracer_.compare_exchange_strong(expected, tracer.get(),
+                                              std::memory_order_acq_rel)) {
+    return errors::FailedPrecondition("A request tracer is set already");
+  }
+  // Lives for the rest of the process, as handlers may be using it.
+  tracer.release();
+  return OkStatus();
+}
+
+bool RequestTracer::Sample() const {
+  return options_.sampling_rate > 0 &&
+         random::New64() <
+             options_.sampling_rate * static_cast<double>(~uint64_t{0});
+}
+
+void RequestTracer::Record(Span span) {
+  if (!queue_.TryPush(std::move(span))) {
+    dropped_spans->GetCell()->IncrementBy(1);
+  }
+}
+
+void RequestTracer::RecordSpan(const TraceContext& parent,
+                               const absl::string_view name,
+                               const uint64_t start_micros,
+                               const uint64_t end_micros) {
+  Span span;
+  span.context = parent;
+  span.context.span_id = NewId();
+  span.parent_span_id = parent.span_id;
+  span.name = string(name);
+  span.start_micros = start_micros;
+  span.end_micros = end_micros;
+  Record(std::move(span));
+}
+
+void RequestTracer::Flush() {
+  mutex_lock l(export_mu_);
+  while (ExportBatch() > 0) {
+  }
+}
+
+void RequestTracer::ExportQueuedSpans() {
+  while (true) {
+    int num_exported;
+    {
+      mutex_lock l(export_mu_);
+      num_exported = ExportBatch();
+    }
+    if (num_exported < std::max(1, options_.max_batch_size)) {
+      // Out of spans for now.
+      mutex_lock l(stop_mu_);
+      if (stopping_) {
+        return;
+      }
+      WaitForMilliseconds(&l, &stop_cv_, kExportIntervalMillis);
+    }
+  }
+}
+
+int RequestTracer::ExportBatch() {
+  std::vector<Span> batch;
+  Span span;
+  const int max_batch_size = std::max(1, options_.max_batch_size);
+  while (batch.size() < max_batch_size &&
+         queue_.TryPop(&span)) {
+    batch.push_back(std::move(span));
+  }
+  if (!batch.empty() && options_.exporter != nullptr) {
+    const Status status = options_.exporter->Export(batch);
+    if (!status.ok()) {
+      LOG_EVERY_N_SEC(WARNING, 60)
+          << "Failed to export spans of traced requests: " << status;
+    }
+  }
+  return batch.size();
+}
+
+CurrentTraceInfo CurrentTrace() { return current_trace; }
+
+ScopedSpan::ScopedSpan(const absl::string_view name) {
+  if (current_trace.tracer != nullptr) {
+    Start(current_trace.tracer, current_trace.context, name);
+  }
+}
+
+ScopedSpan::ScopedSpan(RequestTracer* const tracer,
+                       const absl::string_view traceparent,
+                       const absl::string_view name) {
+  if (tracer == nullptr) {
+    return;
+  }
+  TraceContext parent;
+  bool sampled;
+  if (TraceContext::FromTraceparent(traceparent, &parent, &sampled)) {
+    // The caller decided.
+    if (sampled) {
+      Start(tracer, parent, name);
+      span_.server = true;
+    }
+    return;
+  }
+  if (tracer->Sample()) {
+    parent.trace_id_high = NewId();
+    parent.trace_id_low = NewId();
+    // The span of the request is the root of the trace.
+    parent.span_id = 0;
+    Start(tracer, parent, name);
+    span_.server = true;
+  }
+}
+
+void ScopedSpan::Start(RequestTracer* const tracer, const TraceContext& parent,
+                       const absl::string_view name) {
+  tracer_ = tracer;
+  span_.context = parent;
+  span_.context.span_id = NewId();
+  span_.parent_span_id = parent.span_id;
+  span_.name = string(name);
+  span_.start_micros = tracer->env()->NowMicros();
+  previous_ = std::exchange(current_trace, {tracer, span_.context});
+}
+
+ScopedSpan::~ScopedSpan() {
+  if (tracer_ == nullptr) {
+    return;
+  }
+  current_trace = previous_;
+  span_.end_micros = tracer_->env()->NowMicros();
+  tracer_->Record(std::move(span_));
+}
+
+void ScopedSpan::AddAttribute(const absl::string_view key,
+                              const absl::string_view value) {
+  if (tracer_ != nullptr) {
+    span_.attributes.emplace_back(string(key), string(value));
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
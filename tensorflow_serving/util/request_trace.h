@@ -0,0 +1,233 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_REQUEST_TRACE_H_
+#define TENSORFLOW_SERVING_UTIL_REQUEST_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow_serving/util/mpmc_queue.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Sampled tracing of requests, in the W3C trace context and OpenTelemetry
+// model: the requests that are sampled get a span for each stage they go
+// through (the RPC, the servable lookup, the batch queue, running the batch,
+// ...), which are exported in the background.
+//
+// Like RequestDeadline, the RPC handlers start the trace of the request they
+// serve for the calling thread, with a root ScopedSpan, and the layers below
+// add child spans to it with ScopedSpan, or to a trace they've carried to
+// another thread (see CurrentTrace()) with RequestTracer::RecordSpan(). For
+// requests that aren't sampled, spans cost a thread-local lookup.
+
+// The place of a span in its trace.
+struct TraceContext {
+  uint64_t trace_id_high = 0;
+  uint64_t trace_id_low = 0;
+  uint64_t span_id = 0;
+
+  bool valid() const {
+    return (trace_id_high != 0 || trace_id_low != 0) && span_id != 0;
+  }
+
+  // Parses a W3C 'traceparent' header, e.g.
+  // "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01". Returns false
+  // if it's malformed.
+  static bool FromTraceparent(absl::string_view traceparent,
+                              TraceContext* context, bool* sampled);
+
+  // Returns the 'traceparent' header of the span, sampled.
+  string ToTraceparent() const;
+};
+
+// A span that ended.
+struct Span {
+  // The trace of the span, and its id.
+  TraceContext context;
+  // 0 for the root span of a trace.
+  uint64_t parent_span_id = 0;
+  // Whether the span is of a request served by this server, rather than of
+  // work within it.
+  bool server = false;
+  string name;
+  uint64_t start_micros = 0;
+  uint64_t end_micros = 0;
+  std::vector<std::pair<string, string>> attributes;
+};
+
+// Exports the spans of a RequestTracer.
+class SpanExporter {
+ public:
+  virtual ~SpanExporter() = default;
+
+  // Called from one thread at a time.
+  virtual Status Export(const std::vector<Span>& spans) = 0;
+};
+
+// Writes spans to a file as lines of OTLP/JSON ExportTraceServiceRequests,
+// which the OpenTelemetry Collector reads with its otlpjsonfile receiver.
+class OtlpJsonFileSpanExporter : public SpanExporter {
+ public:
+  static Status Create(const string& filename,
+                       std::unique_ptr<SpanExporter>* exporter);
+
+  Status Export(const std::vector<Span>& spans) override;
+
+ private:
+  explicit OtlpJsonFileSpanExporter(std::unique_ptr<WritableFile> file)
+      : file_(std::move(file)) {}
+
+  const std::unique_ptr<WritableFile> file_;
+};
+
+// Samples requests to trace, and exports the spans of their traces from a
+// background thread, in batches. Spans that don't fit in the queue of the
+// exporter are dropped, rather than slowing requests down.
+//
+// This class is thread-safe.
+class RequestTracer {
+ public:
+  struct Options {
+    // The fraction of requests traced, of those whose callers didn't decide
+    // (requests with a trace context are traced if it's sampled).
+    double sampling_rate = 0;
+
+    // The number of spans waiting for export (rounded up to a power of two).
+    int queue_capacity = 8192;
+
+    // The most spans passed to the exporter at once.
+    int max_batch_size = 512;
+
+    std::unique_ptr<SpanExporter> exporter;
+
+    Env* env = Env::Default();
+  };
+
+  explicit RequestTracer(Options options);
+
+  // Exports the queued spans.
+  ~RequestTracer();
+
+  // Makes 'tracer' the one Global() returns, which the RPC handlers trace
+  // requests with, for the rest of the process. Returns an error if there's
+  // one already.
+  static Status SetGlobal(std::unique_ptr<RequestTracer> tracer);
+
+  // Returns null unless SetGlobal() was called.
+  static RequestTracer* Global() {
+    return global_tracer_.load(std::memory_order_acquire);
+  }
+
+  // Returns whether to trace a request without a trace context.
+  bool Sample() const;
+
+  // Queues 'span' for export.
+  void Record(Span span);
+
+  // Records a span of 'name' from 'start_micros' to 'end_micros', as a child
+  // of the span of 'parent'.
+  void RecordSpan(const TraceContext& parent, absl::string_view name,
+                  uint64_t start_micros, uint64_t end_micros);
+
+  // Exports the spans queued so far.
+  void Flush() TF_LOCKS_EXCLUDED(export_mu_);
+
+  Env* env() const { return options_.env; }
+
+ private:
+  // The loop of the export thread.
+  void ExportQueuedSpans();
+
+  // Exports up to max_batch_size queued spans, and returns how many.
+  int ExportBatch() TF_EXCLUSIVE_LOCKS_REQUIRED(export_mu_);
+
+  static std::atomic<RequestTracer*> global_tracer_;
+
+  const Options options_;
+  MpmcQueue<Span> queue_;
+
+  // Serializes exports.
+  mutex export_mu_;
+
+  mutex stop_mu_;
+  condition_variable stop_cv_;
+  bool stopping_ TF_GUARDED_BY(stop_mu_) = false;
+  std::unique_ptr<Thread> export_thread_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RequestTracer);
+};
+
+// The trace of the traced request that the calling thread serves.
+struct CurrentTraceInfo {
+  // Null if the thread serves no traced request.
+  RequestTracer* tracer = nullptr;
+  TraceContext context;
+};
+
+// Returns the trace of the request the calling thread serves, e.g. to record
+// spans of it on other threads.
+CurrentTraceInfo CurrentTrace();
+
+// A span that lasts for the lifetime of this object, and is the current span
+// of the calling thread meanwhile.
+class ScopedSpan {
+ public:
+  // Starts a child of the current span of the thread, if it serves a traced
+  // request.
+  explicit ScopedSpan(absl::string_view name);
+
+  // Starts the root span of a request served by this server, with 'tracer'
+  // (which may be null), in the trace of the 'traceparent' header of the
+  // request if it has one. If the trace context is sampled, or the request
+  // has none and 'tracer' samples it, the request is traced.
+  ScopedSpan(RequestTracer* tracer, absl::string_view traceparent,
+             absl::string_view name);
+
+  // Ends the span.
+  ~ScopedSpan();
+
+  bool active() const { return tracer_ != nullptr; }
+
+  // No-op unless active().
+  void AddAttribute(absl::string_view key, absl::string_view value);
+
+ private:
+  // Starts the span with the given parent.
+  void Start(RequestTracer* tracer, const TraceContext& parent,
+             absl::string_view name);
+
+  RequestTracer* tracer_ = nullptr;
+  Span span_;
+  CurrentTraceInfo previous_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedSpan);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_REQUEST_TRACE_H_
@@ -0,0 +1,204 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/request_trace.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class FakeSpanExporter : public SpanExporter {
+ public:
+  explicit FakeSpanExporter(std::vector<Span>* spans, mutex* mu)
+      : spans_(spans), mu_(mu) {}
+
+  Status Export(const std::vector<Span>& spans) override {
+    mutex_lock l(*mu_);
+    spans_->insert(spans_->end(), spans.begin(), spans.end());
+    return OkStatus();
+  }
+
+ private:
+  std::vector<Span>* const spans_;
+  mutex* const mu_;
+};
+
+class RequestTraceTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<RequestTracer> CreateTracer(const double sampling_rate) {
+    RequestTracer::Options options;
+    options.sampling_rate = sampling_rate;
+    options.exporter.reset(new FakeSpanExporter(&spans_, &mu_));
+    return std::unique_ptr<RequestTracer>(
+        new RequestTracer(std::move(options)));
+  }
+
+  std::vector<Span> GetSpans() {
+    mutex_lock l(mu_);
+    return spans_;
+  }
+
+  mutex mu_;
+  std::vector<Span> spans_;
+};
+
+TEST(TraceContextTest, Traceparent) {
+  TraceContext context;
+  bool sampled;
+  ASSERT_TRUE(TraceContext::FromTraceparent(
+      "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", &context,
+      &sampled));
+  EXPECT_EQ(0x4bf92f3577b34da6, context.trace_id_high);
+  EXPECT_EQ(0xa3ce929d0e0e4736, context.trace_id_low);
+  EXPECT_EQ(0x00f067aa0ba902b7, context.span_id);
+  EXPECT_TRUE(sampled);
+  EXPECT_EQ("00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01",
+            context.ToTraceparent());
+
+  ASSERT_TRUE(TraceContext::FromTraceparent(
+      "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00", &context,
+      &sampled));
+  EXPECT_FALSE(sampled);
+
+  // Malformed, or with invalid ids.
+  EXPECT_FALSE(TraceContext::FromTraceparent("", &context, &sampled));
+  EXPECT_FALSE(TraceContext::FromTraceparent(
+      "00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01", &context,
+      &sampled));
+  EXPECT_FALSE(TraceContext::FromTraceparent(
+      "00-00000000000000000000000000000000-00f067aa0ba902b7-01", &context,
+      &sampled));
+  EXPECT_FALSE(TraceContext::FromTraceparent(
+      "00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01", &context,
+      &sampled));
+  EXPECT_FALSE(TraceContext::FromTraceparent(
+      "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01-extra",
+      &context, &sampled));
+}
+
+TEST_F(RequestTraceTest, RecordsChildSpans) {
+  std::unique_ptr<RequestTracer> tracer = CreateTracer(0);
+  {
+    ScopedSpan request(
+        tracer.get(), "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01",
+        "Predict");
+    ASSERT_TRUE(request.active());
+    request.AddAttribute("model_name", "m");
+    {
+      ScopedSpan lookup("lookup");
+      EXPECT_TRUE(lookup.active());
+    }
+    const CurrentTraceInfo trace = CurrentTrace();
+    EXPECT_EQ(tracer.get(), trace.tracer);
+    trace.tracer->RecordSpan(trace.context, "batch_queue", 1, 2);
+  }
+  EXPECT_EQ(nullptr, CurrentTrace().tracer);
+  tracer->Flush();
+
+  const std::vector<Span> spans = GetSpans();
+  ASSERT_EQ(3, spans.size());
+  const Span& lookup = spans[0];
+  const Span& queue = spans[1];
+  const Span& request = spans[2];
+  EXPECT_EQ("Predict", request.name);
+  EXPECT_TRUE(request.server);
+  EXPECT_EQ(0x00f067aa0ba902b7, request.parent_span_id);
+  EXPECT_EQ(0xa3ce929d0e0e4736, request.context.trace_id_low);
+  ASSERT_EQ(1, request.attributes.size());
+  EXPECT_EQ("model_name", request.attributes[0].first);
+
+  EXPECT_EQ("lookup", lookup.name);
+  EXPECT_FALSE(lookup.server);
+  EXPECT_EQ(request.context.span_id, lookup.parent_span_id);
+  EXPECT_EQ(request.context.trace_id_low, lookup.context.trace_id_low);
+  EXPECT_EQ("batch_queue", queue.name);
+  EXPECT_EQ(request.context.span_id, queue.parent_span_id);
+  EXPECT_EQ(1, queue.start_micros);
+  EXPECT_EQ(2, queue.end_micros);
+}
+
+TEST_F(RequestTraceTest, Sampling) {
+  std::unique_ptr<RequestTracer> never = CreateTracer(0);
+  {
+    ScopedSpan request(never.get(), "", "Predict");
+    EXPECT_FALSE(request.active());
+    ScopedSpan child("lookup");
+    EXPECT_FALSE(child.active());
+  }
+  {
+    // The caller decided not to trace the request.
+    std::unique_ptr<RequestTracer> always = CreateTracer(1);
+    ScopedSpan request(
+        always.get(), "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00",
+        "Predict");
+    EXPECT_FALSE(request.active());
+  }
+
+  std::unique_ptr<RequestTracer> always = CreateTracer(1);
+  {
+    ScopedSpan request(always.get(), "", "Predict");
+    EXPECT_TRUE(request.active());
+  }
+  always.reset();
+  const std::vector<Span> spans = GetSpans();
+  ASSERT_EQ(1, spans.size());
+  EXPECT_EQ(0, spans[0].parent_span_id);
+  EXPECT_TRUE(spans[0].context.valid());
+
+  ScopedSpan untraced(nullptr, "", "Predict");
+  EXPECT_FALSE(untraced.active());
+}
+
+TEST(OtlpJsonFileSpanExporterTest, WritesSpans) {
+  const string filename = io::JoinPath(testing::TmpDir(), "spans.json");
+  std::unique_ptr<SpanExporter> exporter;
+  TF_ASSERT_OK(OtlpJsonFileSpanExporter::Create(filename, &exporter));
+  Span span;
+  ASSERT_TRUE(TraceContext::FromTraceparent(
+      "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", &span.context,
+      &span.server));
+  span.name = "Predict \"m\"";
+  span.start_micros = 5;
+  span.end_micros = 7;
+  span.attributes = {{"model_name", "m"}};
+  TF_ASSERT_OK(exporter->Export({span}));
+  exporter.reset();
+
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  EXPECT_EQ(
+      "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":"
+      "\"service.name\",\"value\":{\"stringValue\":\"tensorflow_serving\"}}]},"
+      "\"scopeSpans\":[{\"scope\":{\"name\":\"tensorflow_serving\"},"
+      "\"spans\":[{\"traceId\":\"4bf92f3577b34da6a3ce929d0e0e4736\","
+      "\"spanId\":\"00f067aa0ba902b7\",\"name\":\"Predict \\\"m\\\"\","
+      "\"kind\":2,\"startTimeUnixNano\":\"5000\","
+      "\"endTimeUnixNano\":\"7000\",\"attributes\":[{\"key\":\"model_name\","
+      "\"value\":{\"stringValue\":\"m\"}}]}]}]}]}\n",
+      contents);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -15,23 +15,93 @@ limitations under the License.
 
 #include "tensorflow_serving/util/retrier.h"
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 
-#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 namespace serving {
 
+RetryBudget::RetryBudget(const double retries_per_second,
+                         const double max_burst, Env* const env)
+    : retries_per_second_(retries_per_second),
+      max_burst_(max_burst),
+      env_(env),
+      available_(max_burst),
+      last_refill_micros_(env->NowMicros()) {}
+
+bool RetryBudget::TryAcquire() {
+  mutex_lock l(mu_);
+  const uint64_t now_micros = env_->NowMicros();
+  if (now_micros > last_refill_micros_) {
+    const double elapsed_seconds = (now_micros - last_refill_micros_) / 1e6;
+    available_ = std::min(max_burst_,
+                          available_ + retries_per_second_ * elapsed_seconds);
+    last_refill_micros_ = now_micros;
+  }
+  if (available_ < 1) {
+    return false;
+  }
+  available_ -= 1;
+  return true;
+}
+
+namespace internal {
+
+int64_t GetRetryIntervalMicros(const RetryOptions& options, const int num_retry,
+                               const Status& status, const double random) {
+  const RetryBackoff& backoff = options.backoff;
+  const bool transient = errors::IsUnavailable(status) ||
+                         errors::IsDeadlineExceeded(status) ||
+                         errors::IsAborted(status);
+  double interval_micros =
+      transient && backoff.transient_error_interval_micros >= 0
+          ? backoff.transient_error_interval_micros
+          : options.retry_interval_micros;
+  interval_micros *= std::pow(std::max(backoff.multiplier, 1.0), num_retry - 1);
+  if (backoff.max_interval_micros > 0) {
+    interval_micros =
+        std::min(interval_micros,
+                 static_cast<double>(backoff.max_interval_micros));
+  }
+  const double jitter = std::min(std::max(backoff.jitter, 0.0), 1.0);
+  interval_micros *= 1 - jitter * random;
+  return static_cast<int64_t>(interval_micros);
+}
+
+}  // namespace internal
+
 Status Retry(const string& description, const uint32 max_num_retries,
              const int64_t retry_interval_micros,
              const std::function<Status()>& retried_fn,
              const std::function<bool()>& is_cancelled) {
+  RetryOptions options;
+  options.max_num_retries = max_num_retries;
+  options.retry_interval_micros = retry_interval_micros;
+  return Retry(description, options, retried_fn, is_cancelled);
+}
+
+Status Retry(const string& description, const RetryOptions& options,
+             const std::function<Status()>& retried_fn,
+             const std::function<bool()>& is_cancelled) {
+  const uint32 max_num_retries = options.max_num_retries;
   Status status;
   int num_tries = 0;
   do {
     if (num_tries > 0) {
-      Env::Default()->SleepForMicroseconds(retry_interval_micros);
+      if (options.budget != nullptr && !options.budget->TryAcquire()) {
+        LOG(INFO) << "Retrying of " << description
+                  << " stopped: the retry budget is spent";
+        return status;
+      }
+      // Uniform in [0, 1), from the top 53 bits.
+      const double uniform = (random::New64() >> 11) * (1.0 / (1ULL << 53));
+      Env::Default()->SleepForMicroseconds(internal::GetRetryIntervalMicros(
+          options, num_tries, status, uniform));
       LOG(INFO) << "Retrying of " << description << " retry: " << num_tries;
     }
     status = retried_fn();
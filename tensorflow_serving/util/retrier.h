@@ -20,10 +20,74 @@ limitations under the License.
 #include <string>
 
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace serving {
 
+// Limits the rate of retries over many retried operations, e.g. the loads of
+// all models of a server, so that an outage of what they share doesn't get
+// multiplied into a storm of retries once it starts to recover. Holds up to
+// 'max_burst' retries, refilled at 'retries_per_second'.
+//
+// This class is thread-safe.
+class RetryBudget {
+ public:
+  RetryBudget(double retries_per_second, double max_burst,
+              Env* env = Env::Default());
+
+  // Takes a retry from the budget. Returns false if it is spent.
+  bool TryAcquire() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  const double retries_per_second_;
+  const double max_burst_;
+  Env* const env_;
+
+  mutex mu_;
+  double available_ TF_GUARDED_BY(mu_);
+  uint64_t last_refill_micros_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RetryBudget);
+};
+
+// How the interval between retries grows.
+struct RetryBackoff {
+  // Each retry after the first waits this many times the interval of the
+  // previous one.
+  double multiplier = 1.0;
+
+  // The longest interval, once grown, in microseconds. 0 means no limit.
+  int64_t max_interval_micros = 0;
+
+  // The fraction of each interval that is drawn at random, so that operations
+  // which failed together don't retry together: intervals are uniform in
+  // [(1 - jitter) * interval, interval].
+  double jitter = 0;
+
+  // If non-negative, the interval, in microseconds, of the first retry after
+  // a transient error (UNAVAILABLE, DEADLINE_EXCEEDED or ABORTED), which can
+  // be retried sooner than the likes of a missing file. Later retries after
+  // transient errors grow from it.
+  int64_t transient_error_interval_micros = -1;
+};
+
+struct RetryOptions {
+  // The number of retries, after the first try.
+  uint32 max_num_retries = 0;
+
+  // The interval, in microseconds, before the first retry.
+  int64_t retry_interval_micros = 0;
+
+  RetryBackoff backoff;
+
+  // The budget retries are taken from, if any. Retrying stops once it is
+  // spent.
+  RetryBudget* budget = nullptr;
+};
+
 // Tries running 'retried_fn' once, and if it doesn't succeed, retries running
 // the 'retried_fn' till it returns an ok status or max_num_retries are
 // exhausted or cancelled() returns true. Each retry is attempted after an
@@ -35,6 +99,21 @@ Status Retry(
     int64_t retry_interval_micros, const std::function<Status()>& retried_fn,
     const std::function<bool()>& is_cancelled = [] { return false; });
 
+// As above, with the retries backing off per 'options'.
+Status Retry(
+    const string& description, const RetryOptions& options,
+    const std::function<Status()>& retried_fn,
+    const std::function<bool()>& is_cancelled = [] { return false; });
+
+namespace internal {
+
+// The interval before retry number 'num_retry' (from 1) of 'options', after a
+// try that failed with 'status'. 'random' is uniform in [0, 1).
+int64_t GetRetryIntervalMicros(const RetryOptions& options, int num_retry,
+                               const Status& status, double random);
+
+}  // namespace internal
+
 }  // namespace serving
 }  // namespace tensorflow
 
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -68,6 +69,52 @@ TEST(RetrierTest, RetryCancelled) {
   EXPECT_EQ(1, call_count);
 }
 
+TEST(RetrierTest, RetryIntervalsBackOff) {
+  RetryOptions options;
+  options.retry_interval_micros = 100;
+  options.backoff.multiplier = 2;
+  options.backoff.max_interval_micros = 500;
+  const Status error = errors::NotFound("Missing");
+  EXPECT_EQ(100, internal::GetRetryIntervalMicros(options, 1, error, 0));
+  EXPECT_EQ(200, internal::GetRetryIntervalMicros(options, 2, error, 0));
+  EXPECT_EQ(400, internal::GetRetryIntervalMicros(options, 3, error, 0));
+  EXPECT_EQ(500, internal::GetRetryIntervalMicros(options, 4, error, 0));
+
+  // Jitter takes up to its fraction off the interval.
+  options.backoff.jitter = 0.5;
+  EXPECT_EQ(200, internal::GetRetryIntervalMicros(options, 2, error, 0));
+  EXPECT_EQ(150, internal::GetRetryIntervalMicros(options, 2, error, 0.5));
+
+  // Transient errors back off from their own interval.
+  options.backoff.jitter = 0;
+  options.backoff.transient_error_interval_micros = 10;
+  const Status transient = errors::Unavailable("Try again");
+  EXPECT_EQ(10, internal::GetRetryIntervalMicros(options, 1, transient, 0));
+  EXPECT_EQ(40, internal::GetRetryIntervalMicros(options, 3, transient, 0));
+  EXPECT_EQ(100, internal::GetRetryIntervalMicros(options, 1, error, 0));
+}
+
+TEST(RetrierTest, RetryStopsWhenBudgetIsSpent) {
+  test_util::FakeClockEnv env(Env::Default());
+  RetryBudget budget(/*retries_per_second=*/1, /*max_burst=*/2, &env);
+  RetryOptions options;
+  options.max_num_retries = 10;
+  options.budget = &budget;
+  int call_count = 0;
+  auto retried_fn = [&]() {
+    ++call_count;
+    return errors::Unknown("Error");
+  };
+  EXPECT_FALSE(Retry("RetryStopsWhenBudgetIsSpent", options, retried_fn).ok());
+  EXPECT_EQ(3, call_count);
+
+  // The budget refills over time.
+  env.AdvanceByMicroseconds(1000 * 1000);
+  call_count = 0;
+  EXPECT_FALSE(Retry("RetryStopsWhenBudgetIsSpent", options, retried_fn).ok());
+  EXPECT_EQ(2, call_count);
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace tensorflow
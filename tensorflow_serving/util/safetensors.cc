@@ -0,0 +1,316 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/safetensors.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "rapidjson/document.h"
+#include "rapidjson/error/en.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/byte_order.h"
+
+namespace tensorflow {
+namespace serving {
+
+const char kSafetensorsContentType[] = "application/x-safetensors";
+
+namespace {
+
+// The size of the header size that starts the body.
+constexpr size_t kHeaderSizeBytes = 8;
+
+// The header key of the (string to string) metadata, and the metadata key of
+// the signature name.
+constexpr char kMetadataKey[] = "__metadata__";
+constexpr char kSignatureNameKey[] = "signature_name";
+
+struct DtypeName {
+  const char* name;
+  DataType dtype;
+};
+
+constexpr DtypeName kDtypeNames[] = {
+    {"BOOL", DT_BOOL},  {"U8", DT_UINT8},     {"I8", DT_INT8},
+    {"U16", DT_UINT16}, {"I16", DT_INT16},    {"U32", DT_UINT32},
+    {"I32", DT_INT32},  {"U64", DT_UINT64},   {"I64", DT_INT64},
+    {"F16", DT_HALF},   {"BF16", DT_BFLOAT16}, {"F32", DT_FLOAT},
+    {"F64", DT_DOUBLE},
+};
+
+Status DtypeFromName(absl::string_view name, DataType* dtype) {
+  for (const DtypeName& entry : kDtypeNames) {
+    if (name == entry.name) {
+      *dtype = entry.dtype;
+      return OkStatus();
+    }
+  }
+  return errors::InvalidArgument("Unsupported safetensors dtype: ", name);
+}
+
+Status NameFromDtype(DataType dtype, const char** name) {
+  for (const DtypeName& entry : kDtypeNames) {
+    if (dtype == entry.dtype) {
+      *name = entry.name;
+      return OkStatus();
+    }
+  }
+  return errors::InvalidArgument("Tensors of type ", DataTypeString(dtype),
+                                 " have no safetensors encoding");
+}
+
+Status GetUint64(const rapidjson::Value& value, const string& what,
+                 uint64_t* out) {
+  if (!value.IsUint64()) {
+    return errors::InvalidArgument("safetensors header: ", what,
+                                   " must be a non-negative integer");
+  }
+  *out = value.GetUint64();
+  return OkStatus();
+}
+
+// Fills 'tensor' from the header entry 'info' of the tensor 'name', with its
+// values in 'data'.
+Status ParseTensor(const string& name, const rapidjson::Value& info,
+                   absl::string_view data, TensorProto* tensor) {
+  if (!info.IsObject()) {
+    return errors::InvalidArgument("safetensors header: Tensor ", name,
+                                   " is not an object");
+  }
+
+  const auto dtype_it = info.FindMember("dtype");
+  if (dtype_it == info.MemberEnd() || !dtype_it->value.IsString()) {
+    return errors::InvalidArgument("safetensors header: Tensor ", name,
+                                   " has no string dtype");
+  }
+  DataType dtype;
+  TF_RETURN_IF_ERROR(DtypeFromName(
+      absl::string_view(dtype_it->value.GetString(),
+                        dtype_it->value.GetStringLength()),
+      &dtype));
+
+  const auto shape_it = info.FindMember("shape");
+  if (shape_it == info.MemberEnd() || !shape_it->value.IsArray()) {
+    return errors::InvalidArgument("safetensors header: Tensor ", name,
+                                   " has no shape list");
+  }
+  std::vector<int64_t> dims;
+  for (const rapidjson::Value& dim : shape_it->value.GetArray()) {
+    uint64_t size;
+    TF_RETURN_IF_ERROR(GetUint64(dim, absl::StrCat("Shape of ", name), &size));
+    dims.push_back(static_cast<int64_t>(size));
+  }
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(TensorShape::BuildTensorShape(dims, &shape));
+
+  const auto offsets_it = info.FindMember("data_offsets");
+  if (offsets_it == info.MemberEnd() || !offsets_it->value.IsArray() ||
+      offsets_it->value.Size() != 2) {
+    return errors::InvalidArgument("safetensors header: Tensor ", name,
+                                   " has no [begin, end] data_offsets");
+  }
+  uint64_t begin, end;
+  const string offsets_what = absl::StrCat("data_offsets of ", name);
+  TF_RETURN_IF_ERROR(GetUint64(offsets_it->value[0], offsets_what, &begin));
+  TF_RETURN_IF_ERROR(GetUint64(offsets_it->value[1], offsets_what, &end));
+  if (begin > end || end > data.size()) {
+    return errors::InvalidArgument("safetensors header: data_offsets [", begin,
+                                   ", ", end, "] of ", name,
+                                   " are out of the data of ", data.size(),
+                                   " bytes");
+  }
+  const uint64_t num_bytes = shape.num_elements() * DataTypeSize(dtype);
+  if (end - begin != num_bytes) {
+    return errors::InvalidArgument("safetensors: Tensor ", name, " has ",
+                                   end - begin, " bytes of data, expecting ",
+                                   num_bytes, " for shape ",
+                                   shape.DebugString());
+  }
+
+  tensor->set_dtype(dtype);
+  shape.AsProto(tensor->mutable_tensor_shape());
+  tensor->set_tensor_content(data.data() + begin, num_bytes);
+  return OkStatus();
+}
+
+}  // namespace
+
+Status FillPredictRequestFromSafetensors(absl::string_view body,
+                                         PredictRequest* request) {
+  if (!port::kLittleEndian) {
+    return errors::Unimplemented(
+        "safetensors bodies are only supported on little-endian hosts");
+  }
+  if (body.size() < kHeaderSizeBytes) {
+    return errors::InvalidArgument("safetensors body of ", body.size(),
+                                   " bytes is too short for a header size");
+  }
+  uint64_t header_size = 0;
+  for (int i = kHeaderSizeBytes - 1; i >= 0; --i) {
+    header_size = (header_size << 8) | static_cast<uint8_t>(body[i]);
+  }
+  if (header_size > body.size() - kHeaderSizeBytes) {
+    return errors::InvalidArgument("safetensors header of ", header_size,
+                                   " bytes overruns the body of ", body.size(),
+                                   " bytes");
+  }
+  const absl::string_view header = body.substr(kHeaderSizeBytes, header_size);
+  const absl::string_view data = body.substr(kHeaderSizeBytes + header_size);
+
+  rapidjson::Document doc;
+  if (doc.Parse(header.data(), header.size()).HasParseError()) {
+    return errors::InvalidArgument(
+        "safetensors header: JSON Parse error: ",
+        rapidjson::GetParseError_En(doc.GetParseError()),
+        " at offset: ", doc.GetErrorOffset());
+  }
+  if (!doc.IsObject()) {
+    return errors::InvalidArgument("safetensors header is not an object");
+  }
+
+  auto* inputs = request->mutable_inputs();
+  inputs->clear();
+  for (const auto& member : doc.GetObject()) {
+    const string name(member.name.GetString(), member.name.GetStringLength());
+    if (name == kMetadataKey) {
+      if (!member.value.IsObject()) {
+        return errors::InvalidArgument(
+            "safetensors header: ", kMetadataKey, " is not an object");
+      }
+      const auto it = member.value.FindMember(kSignatureNameKey);
+      if (it != member.value.MemberEnd()) {
+        if (!it->value.IsString()) {
+          return errors::InvalidArgument("safetensors header: ",
+                                         kSignatureNameKey,
+                                         " must be a string value");
+        }
+        request->mutable_model_spec()->set_signature_name(
+            it->value.GetString(), it->value.GetStringLength());
+      }
+      continue;
+    }
+    TF_RETURN_IF_ERROR(ParseTensor(name, member.value, data, &(*inputs)[name]));
+  }
+  if (inputs->empty()) {
+    return errors::InvalidArgument("safetensors body has no tensors");
+  }
+  return OkStatus();
+}
+
+Status MakeSafetensorsFromTensors(
+    const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+    string* body) {
+  if (!port::kLittleEndian) {
+    return errors::Unimplemented(
+        "safetensors bodies are only supported on little-endian hosts");
+  }
+  if (tensor_map.empty()) {
+    return errors::InvalidArgument(
+        "Cannot convert empty tensor map to safetensors");
+  }
+
+  // Write the tensors in the order of their names, for stable output.
+  std::vector<const std::pair<const string, TensorProto>*> entries;
+  for (const auto& kv : tensor_map) {
+    entries.push_back(&kv);
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const std::pair<const string, TensorProto>* a,
+               const std::pair<const string, TensorProto>* b) {
+              return a->first < b->first;
+            });
+
+  // The values of each tensor, in its 'tensor_content' or in 'tensors'.
+  std::vector<absl::string_view> values;
+  std::vector<Tensor> tensors;
+  rapidjson::StringBuffer header;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(header);
+  writer.StartObject();
+  uint64_t offset = 0;
+  for (const auto* entry : entries) {
+    const string& name = entry->first;
+    const TensorProto& proto = entry->second;
+    const char* dtype_name;
+    Status status = NameFromDtype(proto.dtype(), &dtype_name);
+    if (!status.ok()) {
+      return errors::InvalidArgument("Tensor ", name, ": ", status.message());
+    }
+    TensorShape shape;
+    TF_RETURN_IF_ERROR(
+        TensorShape::BuildTensorShape(proto.tensor_shape(), &shape));
+    const uint64_t num_bytes =
+        shape.num_elements() * DataTypeSize(proto.dtype());
+    absl::string_view value;
+    if (proto.tensor_content().size() == num_bytes) {
+      value = proto.tensor_content();
+    } else {
+      Tensor tensor;
+      if (!tensor.FromProto(proto)) {
+        return errors::InvalidArgument("Unable to parse tensor ", name);
+      }
+      value = tensor.tensor_data();
+      tensors.push_back(std::move(tensor));
+    }
+
+    writer.Key(name.c_str(), name.size());
+    writer.StartObject();
+    writer.Key("dtype");
+    writer.String(dtype_name);
+    writer.Key("shape");
+    writer.StartArray();
+    for (const auto& dim : proto.tensor_shape().dim()) {
+      writer.Uint64(dim.size());
+    }
+    writer.EndArray();
+    writer.Key("data_offsets");
+    writer.StartArray();
+    writer.Uint64(offset);
+    writer.Uint64(offset + value.size());
+    writer.EndArray();
+    writer.EndObject();
+    offset += value.size();
+    values.push_back(value);
+  }
+  writer.EndObject();
+
+  // Pad the header with spaces to align the data to 8 bytes, as the reference
+  // implementation does.
+  const size_t header_size =
+      (header.GetSize() + kHeaderSizeBytes - 1) / kHeaderSizeBytes *
+      kHeaderSizeBytes;
+  body->clear();
+  body->reserve(kHeaderSizeBytes + header_size + offset);
+  for (size_t i = 0; i < kHeaderSizeBytes; ++i) {
+    body->push_back(static_cast<char>(header_size >> (8 * i)));
+  }
+  body->append(header.GetString(), header.GetSize());
+  body->append(header_size - header.GetSize(), ' ');
+  for (const absl::string_view value : values) {
+    body->append(value.data(), value.size());
+  }
+  return OkStatus();
+}
+
+}  // namespace serving
+}  // namespace tensorflow
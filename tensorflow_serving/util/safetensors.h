@@ -0,0 +1,74 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_SAFETENSORS_H_
+#define TENSORFLOW_SERVING_UTIL_SAFETENSORS_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow_serving/apis/predict.pb.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Binary encoding of named tensors, for REST API clients that don't want to
+// pay for encoding and decoding large numeric tensors as JSON.
+//
+// The encoding is the safetensors format
+// (https://github.com/huggingface/safetensors), so it can be produced and
+// consumed with existing libraries:
+//
+//   <header size N: 8 bytes, little-endian unsigned>
+//   <header: N bytes of JSON>
+//   <data: the raw, little-endian values of the tensors>
+//
+// where the header is a JSON object, with one key per tensor:
+//
+//   {
+//     "<name>": {
+//       "dtype": "F32",
+//       "shape": [2, 3],
+//       "data_offsets": [<begin>, <end>]  // Byte range in the data.
+//     },
+//     ...
+//     "__metadata__": { "signature_name": "<signature>" }  // Optional.
+//   }
+//
+// The supported dtypes are BOOL, U8, I8, U16, I16, U32, I32, U64, I64, F16,
+// BF16, F32 and F64. String tensors have no binary encoding.
+
+// The media type of safetensors request and response bodies.
+extern const char kSafetensorsContentType[];
+
+// Fills the inputs of `request`, and its signature name from the metadata,
+// from the safetensors `body`. The values of each input are copied into its
+// `tensor_content` as is, without any per-value conversion.
+Status FillPredictRequestFromSafetensors(absl::string_view body,
+                                         PredictRequest* request);
+
+// Encodes `tensor_map` as safetensors into `body`. Tensors whose
+// `tensor_content` holds their values are written without any per-value
+// conversion.
+Status MakeSafetensorsFromTensors(
+    const ::google::protobuf::Map<string, TensorProto>& tensor_map,
+    string* body);
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_SAFETENSORS_H_
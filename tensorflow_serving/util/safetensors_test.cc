@@ -0,0 +1,158 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/safetensors.h"
+
+#include <cstdint>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+using ::testing::HasSubstr;
+
+// Returns a safetensors body of 'header' and 'data'.
+string MakeBody(const string& header, const string& data) {
+  string body;
+  for (int i = 0; i < 8; ++i) {
+    body.push_back(static_cast<char>(static_cast<uint64_t>(header.size()) >>
+                                     (8 * i)));
+  }
+  return body + header + data;
+}
+
+TEST(SafetensorsTest, FillPredictRequest) {
+  const float floats[] = {1.5, -2, 3, 4};
+  const int64_t ints[] = {7, 8};
+  const string data =
+      string(reinterpret_cast<const char*>(floats), sizeof(floats)) +
+      string(reinterpret_cast<const char*>(ints), sizeof(ints));
+  PredictRequest request;
+  TF_ASSERT_OK(FillPredictRequestFromSafetensors(
+      MakeBody(R"({
+        "x": {"dtype": "F32", "shape": [2, 2], "data_offsets": [0, 16]},
+        "y": {"dtype": "I64", "shape": [2], "data_offsets": [16, 32]},
+        "__metadata__": {"signature_name": "sig", "other": "ignored"}
+      }   )",
+               data),
+      &request));
+
+  EXPECT_EQ("sig", request.model_spec().signature_name());
+  ASSERT_EQ(2, request.inputs().size());
+  Tensor x, y;
+  ASSERT_TRUE(x.FromProto(request.inputs().at("x")));
+  ASSERT_TRUE(y.FromProto(request.inputs().at("y")));
+  test::ExpectTensorEqual<float>(
+      x, test::AsTensor<float>({1.5, -2, 3, 4}, TensorShape({2, 2})));
+  test::ExpectTensorEqual<int64_t>(
+      y, test::AsTensor<int64_t>({7, 8}, TensorShape({2})));
+}
+
+TEST(SafetensorsTest, RoundTrip) {
+  ::google::protobuf::Map<string, TensorProto> tensor_map;
+  // In the repeated fields, as well as in 'tensor_content'.
+  test::AsTensor<float>({1, 2, 3}, TensorShape({3, 1}))
+      .AsProtoField(&tensor_map["b"]);
+  test::AsTensor<bool>({true, false}, TensorShape({2}))
+      .AsProtoTensorContent(&tensor_map["a"]);
+  test::AsTensor<int32>({}, TensorShape({0, 4}))
+      .AsProtoTensorContent(&tensor_map["c"]);
+
+  string body;
+  TF_ASSERT_OK(MakeSafetensorsFromTensors(tensor_map, &body));
+  // The data is 8-byte aligned.
+  uint64_t header_size = 0;
+  for (int i = 7; i >= 0; --i) {
+    header_size = (header_size << 8) | static_cast<uint8_t>(body[i]);
+  }
+  EXPECT_EQ(0, header_size % 8);
+  EXPECT_EQ(8 + header_size + 2 + 3 * sizeof(float), body.size());
+  EXPECT_THAT(body.substr(8, header_size),
+              HasSubstr(R"({"a":{"dtype":"BOOL","shape":[2],)"
+                        R"("data_offsets":[0,2]},)"));
+
+  PredictRequest request;
+  TF_ASSERT_OK(FillPredictRequestFromSafetensors(body, &request));
+  ASSERT_EQ(3, request.inputs().size());
+  for (const auto& kv : tensor_map) {
+    SCOPED_TRACE(kv.first);
+    Tensor expected, actual;
+    ASSERT_TRUE(expected.FromProto(kv.second));
+    ASSERT_TRUE(actual.FromProto(request.inputs().at(kv.first)));
+    EXPECT_EQ(expected.DebugString(100), actual.DebugString(100));
+  }
+}
+
+TEST(SafetensorsTest, FillPredictRequestErrors) {
+  auto expect_error = [](const string& body, const string& message) {
+    PredictRequest request;
+    const Status status = FillPredictRequestFromSafetensors(body, &request);
+    ASSERT_TRUE(errors::IsInvalidArgument(status)) << status;
+    EXPECT_THAT(status.message(), HasSubstr(message));
+  };
+  expect_error("1234", "too short for a header size");
+  expect_error(MakeBody("{}", "").substr(0, 9), "overruns the body");
+  expect_error(MakeBody("{", ""), "JSON Parse error");
+  expect_error(MakeBody("[]", ""), "is not an object");
+  expect_error(MakeBody("{}", ""), "has no tensors");
+  expect_error(
+      MakeBody(R"({"x": {"dtype": "F8", "shape": [], "data_offsets": [0, 1]}})",
+               "a"),
+      "Unsupported safetensors dtype: F8");
+  expect_error(
+      MakeBody(R"({"x": {"dtype": "U8", "shape": [-1], )"
+               R"("data_offsets": [0, 1]}})",
+               "a"),
+      "must be a non-negative integer");
+  expect_error(
+      MakeBody(R"({"x": {"dtype": "U8", "shape": [2], )"
+               R"("data_offsets": [0, 3]}})",
+               "ab"),
+      "are out of the data of 2 bytes");
+  expect_error(
+      MakeBody(R"({"x": {"dtype": "U16", "shape": [2], )"
+               R"("data_offsets": [0, 2]}})",
+               "ab"),
+      "has 2 bytes of data, expecting 4");
+  expect_error(MakeBody(R"({"x": {"dtype": "U8", "shape": [1]}})", "a"),
+               "has no [begin, end] data_offsets");
+  expect_error(MakeBody(R"({"__metadata__": {"signature_name": 1}})", ""),
+               "must be a string value");
+}
+
+TEST(SafetensorsTest, MakeSafetensorsErrors) {
+  ::google::protobuf::Map<string, TensorProto> tensor_map;
+  string body;
+  EXPECT_TRUE(
+      errors::IsInvalidArgument(MakeSafetensorsFromTensors(tensor_map, &body)));
+
+  test::AsTensor<tstring>({"a"}, TensorShape({1}))
+      .AsProtoField(&tensor_map["s"]);
+  const Status status = MakeSafetensorsFromTensors(tensor_map, &body);
+  ASSERT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_THAT(status.message(), HasSubstr("has no safetensors encoding"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,247 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/saturation_monitor.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/monitoring/gauge.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+auto* server_saturation_gauge = monitoring::Gauge<double, 0>::New(
+    "/tensorflow/serving/saturation/server",
+    "The saturation of the server: the largest utilization of the resources "
+    "of its models, 1 when saturated.");
+
+auto* model_saturation_gauge = monitoring::Gauge<double, 1>::New(
+    "/tensorflow/serving/saturation",
+    "The saturation of the model: the largest utilization of the resources it "
+    "depends on, including the server-wide ones, 1 when saturated.",
+    "model_name");
+
+auto* signal_gauge = monitoring::Gauge<double, 2>::New(
+    "/tensorflow/serving/saturation/signal",
+    "The utilization of a resource that the model depends on, e.g. its batch "
+    "queues, or of a server-wide one if model_name is empty.",
+    "model_name", "signal");
+
+}  // namespace
+
+SaturationMonitor::SaturationMonitor(const Options& options)
+    : options_(options) {}
+
+SaturationMonitor* SaturationMonitor::Global() {
+  static SaturationMonitor* const monitor = new SaturationMonitor(Options());
+  return monitor;
+}
+
+std::unique_ptr<SaturationMonitor::Registration> SaturationMonitor::Register(
+    const string& model_name, const string& signal,
+    std::function<double()> sample) {
+  mutex_lock l(mu_);
+  signals_.push_front({model_name, signal, std::move(sample)});
+  const auto it = signals_.begin();
+  return std::unique_ptr<Registration>(
+      new Registration([this, it]() { Unregister(it); }));
+}
+
+void SaturationMonitor::Unregister(std::list<SignalState>::iterator signal) {
+  mutex_lock l(mu_);
+  signals_.erase(signal);
+}
+
+std::unique_ptr<SaturationMonitor::Registration>
+SaturationMonitor::EnableLatencyTracking(const string& model_name,
+                                         const int64_t latency_slo_micros) {
+  {
+    mutex_lock l(latency_mu_);
+    LatencyState& state = latencies_[model_name];
+    if (state.num_trackers++ == 0) {
+      state.window_start_micros = options_.env->NowMicros();
+    }
+  }
+  std::shared_ptr<Registration> signal = Register(
+      model_name, "latency", [this, model_name, latency_slo_micros]() {
+        return latency_slo_micros > 0
+                   ? GetRecentLatencyMicros(model_name) / latency_slo_micros
+                   : 0.0;
+      });
+  return std::unique_ptr<Registration>(
+      new Registration([this, model_name, signal]() mutable {
+        signal.reset();
+        DisableLatencyTracking(model_name);
+      }));
+}
+
+void SaturationMonitor::DisableLatencyTracking(const string& model_name) {
+  mutex_lock l(latency_mu_);
+  auto it = latencies_.find(model_name);
+  if (it != latencies_.end() && --it->second.num_trackers == 0) {
+    latencies_.erase(it);
+  }
+}
+
+void SaturationMonitor::MaybeRollWindow(const uint64_t now_micros,
+                                        LatencyState* state) {
+  const uint64_t window_micros = options_.latency_window_micros;
+  if (now_micros - state->window_start_micros < window_micros) {
+    return;
+  }
+  // The previous window only counts if it ended just now.
+  const bool previous_is_recent =
+      now_micros - state->window_start_micros < 2 * window_micros;
+  state->previous_sum_micros = previous_is_recent ? state->sum_micros : 0;
+  state->previous_count = previous_is_recent ? state->count : 0;
+  state->sum_micros = 0;
+  state->count = 0;
+  state->window_start_micros = now_micros;
+}
+
+void SaturationMonitor::RecordLatency(const string& model_name,
+                                      const int64_t latency_micros) {
+  mutex_lock l(latency_mu_);
+  auto it = latencies_.find(model_name);
+  if (it == latencies_.end()) {
+    return;
+  }
+  MaybeRollWindow(options_.env->NowMicros(), &it->second);
+  it->second.sum_micros += latency_micros;
+  ++it->second.count;
+}
+
+double SaturationMonitor::GetRecentLatencyMicros(const string& model_name) {
+  mutex_lock l(latency_mu_);
+  auto it = latencies_.find(model_name);
+  if (it == latencies_.end()) {
+    return 0;
+  }
+  LatencyState* state = &it->second;
+  MaybeRollWindow(options_.env->NowMicros(), state);
+  const int64_t count = state->count + state->previous_count;
+  return count > 0 ? (state->sum_micros + state->previous_sum_micros) / count
+                   : 0;
+}
+
+SaturationMonitor::Report SaturationMonitor::Sample() {
+  mutex_lock l(mu_);
+  const uint64_t now_micros = options_.env->NowMicros();
+  if (sampled_ &&
+      now_micros - last_sample_micros_ <
+          static_cast<uint64_t>(options_.min_sample_interval_micros)) {
+    return last_report_;
+  }
+
+  // The largest value of each signal, by model name ("" for the server).
+  std::map<string, std::map<string, double>> signals_by_model;
+  for (const SignalState& state : signals_) {
+    double& value = signals_by_model[state.model_name][state.signal];
+    value = std::max(value, state.sample());
+  }
+
+  Report report;
+  report.signals = std::move(signals_by_model[""]);
+  signals_by_model.erase("");
+  for (const auto& entry : report.signals) {
+    report.saturation = std::max(report.saturation, entry.second);
+  }
+  const double server_wide_saturation = report.saturation;
+  for (auto& entry : signals_by_model) {
+    ModelSaturation model;
+    model.model_name = entry.first;
+    model.signals = std::move(entry.second);
+    model.saturation = server_wide_saturation;
+    for (const auto& signal : model.signals) {
+      model.saturation = std::max(model.saturation, signal.second);
+    }
+    report.saturation = std::max(report.saturation, model.saturation);
+    report.models.push_back(std::move(model));
+  }
+
+  // Models and signals that are gone are reset, as the gauges keep their
+  // cells.
+  for (const ModelSaturation& model : last_report_.models) {
+    model_saturation_gauge->GetCell(model.model_name)->Set(0);
+    for (const auto& signal : model.signals) {
+      signal_gauge->GetCell(model.model_name, signal.first)->Set(0);
+    }
+  }
+  for (const auto& signal : last_report_.signals) {
+    signal_gauge->GetCell("", signal.first)->Set(0);
+  }
+  server_saturation_gauge->GetCell()->Set(report.saturation);
+  for (const auto& signal : report.signals) {
+    signal_gauge->GetCell("", signal.first)->Set(signal.second);
+  }
+  for (const ModelSaturation& model : report.models) {
+    model_saturation_gauge->GetCell(model.model_name)->Set(model.saturation);
+    for (const auto& signal : model.signals) {
+      signal_gauge->GetCell(model.model_name, signal.first)
+          ->Set(signal.second);
+    }
+  }
+
+  last_report_ = report;
+  last_sample_micros_ = now_micros;
+  sampled_ = true;
+  return report;
+}
+
+UtilizationMeter::UtilizationMeter(const int capacity, Env* env)
+    : env_(env), capacity_(capacity) {
+  interval_start_micros_ = last_update_micros_ = env_->NowMicros();
+}
+
+void UtilizationMeter::SetCapacity(const int capacity) {
+  mutex_lock l(mu_);
+  capacity_ = capacity;
+}
+
+void UtilizationMeter::Update(const uint64_t now_micros) {
+  busy_micros_ += static_cast<double>(num_busy_) *
+                  (now_micros - last_update_micros_);
+  last_update_micros_ = now_micros;
+}
+
+void UtilizationMeter::Begin() {
+  mutex_lock l(mu_);
+  Update(env_->NowMicros());
+  ++num_busy_;
+}
+
+void UtilizationMeter::End() {
+  mutex_lock l(mu_);
+  Update(env_->NowMicros());
+  --num_busy_;
+}
+
+double UtilizationMeter::TakeUtilization() {
+  mutex_lock l(mu_);
+  const uint64_t now_micros = env_->NowMicros();
+  Update(now_micros);
+  const uint64_t elapsed_micros = now_micros - interval_start_micros_;
+  const double utilization =
+      elapsed_micros > 0 && capacity_ > 0
+          ? busy_micros_ / (static_cast<double>(elapsed_micros) * capacity_)
+          : 0;
+  busy_micros_ = 0;
+  interval_start_micros_ = now_micros;
+  return utilization;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
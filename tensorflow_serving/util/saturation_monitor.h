@@ -0,0 +1,226 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_SATURATION_MONITOR_H_
+#define TENSORFLOW_SERVING_UTIL_SATURATION_MONITOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Tracks how saturated the models of the server, and the server as a whole,
+// are: how close each is to the most load it can take without its requests
+// queueing up or missing their latency objective. Meant for autoscaling, in
+// place of CPU utilization, which is a poor proxy for both.
+//
+// Saturation is the largest of a set of signals, each the utilization of one
+// resource, 1 when the resource is saturated and more when overloaded. The
+// components of the server register the signals of the models they serve,
+// e.g.
+//  - "batch_queue": the fill of the batch queues of the model,
+//  - "concurrency": the requests in flight and queued to the model, relative
+//    to its concurrency limit,
+//  - "latency": the recent mean latency of the model's requests, relative to
+//    its latency objective,
+// and server-wide ones, of resources that all models share, e.g.
+//  - "batch_threads": the busy share of the shared batch threads.
+// The saturation of a model includes the server-wide signals, and that of the
+// server is the largest of all. The headroom is 1 - saturation.
+//
+// Sample() computes the signals, at most once per 'min_sample_interval_micros'
+// (later calls get the same report), and exports them as the gauges
+// /tensorflow/serving/saturation and /tensorflow/serving/saturation/signal.
+//
+// This class is thread-safe.
+class SaturationMonitor {
+ public:
+  struct Options {
+    // The shortest interval between two samples, which also is the shortest
+    // window over which UtilizationMeters measure.
+    int64_t min_sample_interval_micros = 1000 * 1000;
+
+    // The window over which the recent mean latency of a model is taken.
+    int64_t latency_window_micros = 10 * 1000 * 1000;
+
+    Env* env = Env::Default();
+  };
+
+  explicit SaturationMonitor(const Options& options);
+  ~SaturationMonitor() = default;
+
+  // The monitor of the process, with the default options.
+  static SaturationMonitor* Global();
+
+  // Registers the signal 'signal' of the model 'model_name', or of the server
+  // if 'model_name' is empty, until 'registration' is destroyed. 'sample' is
+  // called from Sample() and returns the current utilization. Several
+  // registrations of one signal, e.g. by the batch queues of the signatures of
+  // a model, count as their largest.
+  class Registration;
+  std::unique_ptr<Registration> Register(const string& model_name,
+                                         const string& signal,
+                                         std::function<double()> sample)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Records the latency of a request to 'model_name', towards its recent mean
+  // latency. A no-op for models that no EnableLatencyTracking() registration
+  // tracks.
+  void RecordLatency(const string& model_name, int64_t latency_micros)
+      TF_LOCKS_EXCLUDED(latency_mu_);
+
+  // Tracks the latency of 'model_name' against 'latency_slo_micros', as its
+  // "latency" signal, until the returned registration is destroyed.
+  std::unique_ptr<Registration> EnableLatencyTracking(
+      const string& model_name, int64_t latency_slo_micros)
+      TF_LOCKS_EXCLUDED(mu_, latency_mu_);
+
+  // The mean latency of the requests to 'model_name' in the last
+  // 'latency_window_micros' or so, 0 if there were none.
+  double GetRecentLatencyMicros(const string& model_name)
+      TF_LOCKS_EXCLUDED(latency_mu_);
+
+  struct ModelSaturation {
+    string model_name;
+    double saturation = 0;
+    // The signals of the model, without the server-wide ones.
+    std::map<string, double> signals;
+  };
+  struct Report {
+    double saturation = 0;
+    // The server-wide signals.
+    std::map<string, double> signals;
+    // By model name.
+    std::vector<ModelSaturation> models;
+  };
+
+  // Samples the signals, or returns the last report if it is more recent than
+  // 'min_sample_interval_micros'.
+  Report Sample() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct SignalState {
+    string model_name;
+    string signal;
+    std::function<double()> sample;
+  };
+
+  // The latencies of a model in the current and previous windows.
+  struct LatencyState {
+    int num_trackers = 0;
+    uint64_t window_start_micros = 0;
+    double sum_micros = 0;
+    int64_t count = 0;
+    double previous_sum_micros = 0;
+    int64_t previous_count = 0;
+  };
+
+  // Starts a new window for 'state' if the current one is over.
+  void MaybeRollWindow(uint64_t now_micros, LatencyState* state)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(latency_mu_);
+
+  void Unregister(std::list<SignalState>::iterator signal)
+      TF_LOCKS_EXCLUDED(mu_);
+  void DisableLatencyTracking(const string& model_name)
+      TF_LOCKS_EXCLUDED(latency_mu_);
+
+  const Options options_;
+
+  mutex mu_;
+  std::list<SignalState> signals_ TF_GUARDED_BY(mu_);
+  Report last_report_ TF_GUARDED_BY(mu_);
+  uint64_t last_sample_micros_ TF_GUARDED_BY(mu_) = 0;
+  bool sampled_ TF_GUARDED_BY(mu_) = false;
+
+  mutex latency_mu_;
+  std::map<string, LatencyState> latencies_ TF_GUARDED_BY(latency_mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SaturationMonitor);
+};
+
+// The registration of a signal, or of latency tracking, with a
+// SaturationMonitor. Unregisters it when destroyed.
+class SaturationMonitor::Registration {
+ public:
+  ~Registration() { unregister_(); }
+
+ private:
+  friend class SaturationMonitor;
+
+  explicit Registration(std::function<void()> unregister)
+      : unregister_(std::move(unregister)) {}
+
+  const std::function<void()> unregister_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Registration);
+};
+
+// Measures the utilization of a pool of 'capacity' workers, e.g. of threads:
+// the average number of workers busy, bracketed by Begin() and End(), over
+// the time since the previous call to TakeUtilization(), divided by the
+// capacity.
+//
+// This class is thread-safe.
+class UtilizationMeter {
+ public:
+  explicit UtilizationMeter(int capacity, Env* env = Env::Default());
+  ~UtilizationMeter() = default;
+
+  // Changes the number of workers.
+  void SetCapacity(int capacity) TF_LOCKS_EXCLUDED(mu_);
+
+  // Marks a worker busy, until the matching End().
+  void Begin() TF_LOCKS_EXCLUDED(mu_);
+  void End() TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns the utilization since the previous call (or since construction),
+  // and starts a new interval.
+  double TakeUtilization() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Adds the busy time since the last update.
+  void Update(uint64_t now_micros) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+
+  mutex mu_;
+  int capacity_ TF_GUARDED_BY(mu_);
+  int num_busy_ TF_GUARDED_BY(mu_) = 0;
+  // The worker-microseconds busy since the interval started at
+  // 'interval_start_micros_', as of 'last_update_micros_'.
+  double busy_micros_ TF_GUARDED_BY(mu_) = 0;
+  uint64_t interval_start_micros_ TF_GUARDED_BY(mu_);
+  uint64_t last_update_micros_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(UtilizationMeter);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_SATURATION_MONITOR_H_
@@ -0,0 +1,128 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/saturation_monitor.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/kernels/batching_util/fake_clock_env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+class SaturationMonitorTest : public ::testing::Test {
+ protected:
+  SaturationMonitorTest() : env_(Env::Default()) {
+    SaturationMonitor::Options options;
+    options.min_sample_interval_micros = 100;
+    options.latency_window_micros = 1000;
+    options.env = &env_;
+    monitor_.reset(new SaturationMonitor(options));
+  }
+
+  test_util::FakeClockEnv env_;
+  std::unique_ptr<SaturationMonitor> monitor_;
+};
+
+TEST_F(SaturationMonitorTest, TakesLargestSignals) {
+  double queue_a = 0.2;
+  auto queue_a1 =
+      monitor_->Register("a", "batch_queue", [&queue_a] { return queue_a; });
+  auto queue_a2 = monitor_->Register("a", "batch_queue", [] { return 0.1; });
+  auto concurrency_b =
+      monitor_->Register("b", "concurrency", [] { return 0.9; });
+  auto threads = monitor_->Register("", "batch_threads", [] { return 0.5; });
+
+  SaturationMonitor::Report report = monitor_->Sample();
+  EXPECT_DOUBLE_EQ(0.9, report.saturation);
+  EXPECT_DOUBLE_EQ(0.5, report.signals["batch_threads"]);
+  ASSERT_EQ(2, report.models.size());
+  EXPECT_EQ("a", report.models[0].model_name);
+  // The server-wide signal counts towards the model.
+  EXPECT_DOUBLE_EQ(0.5, report.models[0].saturation);
+  EXPECT_DOUBLE_EQ(0.2, report.models[0].signals["batch_queue"]);
+  EXPECT_EQ("b", report.models[1].model_name);
+  EXPECT_DOUBLE_EQ(0.9, report.models[1].saturation);
+
+  // Samples are reused within the sample interval.
+  queue_a = 1.5;
+  EXPECT_DOUBLE_EQ(0.9, monitor_->Sample().saturation);
+  env_.AdvanceByMicroseconds(100);
+  EXPECT_DOUBLE_EQ(1.5, monitor_->Sample().saturation);
+
+  // Destroyed registrations are gone.
+  queue_a1.reset();
+  queue_a2.reset();
+  env_.AdvanceByMicroseconds(100);
+  report = monitor_->Sample();
+  ASSERT_EQ(1, report.models.size());
+  EXPECT_EQ("b", report.models[0].model_name);
+}
+
+TEST_F(SaturationMonitorTest, TracksRecentLatency) {
+  // Untracked models are not recorded.
+  monitor_->RecordLatency("a", 100);
+  EXPECT_EQ(0, monitor_->GetRecentLatencyMicros("a"));
+
+  auto tracking = monitor_->EnableLatencyTracking("a", 200);
+  monitor_->RecordLatency("a", 100);
+  monitor_->RecordLatency("a", 300);
+  EXPECT_DOUBLE_EQ(200, monitor_->GetRecentLatencyMicros("a"));
+  EXPECT_DOUBLE_EQ(1.0, monitor_->Sample().models[0].signals["latency"]);
+
+  // The previous window still counts for one window.
+  env_.AdvanceByMicroseconds(1000);
+  monitor_->RecordLatency("a", 500);
+  EXPECT_DOUBLE_EQ(300, monitor_->GetRecentLatencyMicros("a"));
+  env_.AdvanceByMicroseconds(1000);
+  EXPECT_DOUBLE_EQ(500, monitor_->GetRecentLatencyMicros("a"));
+  env_.AdvanceByMicroseconds(2000);
+  EXPECT_EQ(0, monitor_->GetRecentLatencyMicros("a"));
+
+  tracking.reset();
+  env_.AdvanceByMicroseconds(100);
+  EXPECT_TRUE(monitor_->Sample().models.empty());
+}
+
+TEST(UtilizationMeterTest, AveragesBusyWorkers) {
+  test_util::FakeClockEnv env(Env::Default());
+  UtilizationMeter meter(/*capacity=*/2, &env);
+  meter.Begin();
+  env.AdvanceByMicroseconds(100);
+  meter.Begin();
+  env.AdvanceByMicroseconds(100);
+  meter.End();
+  meter.End();
+  // 300 worker-microseconds busy out of 2 * 200.
+  EXPECT_DOUBLE_EQ(0.75, meter.TakeUtilization());
+
+  env.AdvanceByMicroseconds(100);
+  EXPECT_DOUBLE_EQ(0, meter.TakeUtilization());
+
+  // Work in progress counts up to now.
+  meter.Begin();
+  env.AdvanceByMicroseconds(100);
+  EXPECT_DOUBLE_EQ(0.5, meter.TakeUtilization());
+  meter.SetCapacity(1);
+  env.AdvanceByMicroseconds(100);
+  EXPECT_DOUBLE_EQ(1.0, meter.TakeUtilization());
+  meter.End();
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
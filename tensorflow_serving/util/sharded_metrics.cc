@@ -0,0 +1,102 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/sharded_metrics.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace internal {
+
+// Beyond this, more shards cost memory and collection time for little less
+// contention.
+constexpr int kMaxMetricShards = 64;
+
+int NumMetricShards() {
+  static const int num_shards =
+      std::max(1, std::min(kMaxMetricShards, port::NumSchedulableCPUs()));
+  return num_shards;
+}
+
+int CurrentMetricShard() {
+  // Threads are assigned shards round-robin as they first update a sharded
+  // metric, which spreads the threads of a pool evenly.
+  static std::atomic<int> next_shard{0};
+  thread_local const int shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % NumMetricShards();
+  return shard;
+}
+
+void AddHistogram(const HistogramProto& from, HistogramProto* const to) {
+  DCHECK_EQ(from.bucket_size(), to->bucket_size());
+  to->set_min(std::min(to->min(), from.min()));
+  to->set_max(std::max(to->max(), from.max()));
+  to->set_num(to->num() + from.num());
+  to->set_sum(to->sum() + from.sum());
+  to->set_sum_squares(to->sum_squares() + from.sum_squares());
+  for (int i = 0; i < from.bucket_size() && i < to->bucket_size(); ++i) {
+    to->set_bucket(i, to->bucket(i) + from.bucket(i));
+  }
+}
+
+}  // namespace internal
+
+int64_t ShardedCounterCell::value() const {
+  int64_t value = 0;
+  for (int i = 0; i < internal::NumMetricShards(); ++i) {
+    value += shards_[i].value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+ShardedSamplerCell::ShardedSamplerCell(
+    const std::vector<double>& bucket_limits) {
+  shards_.reserve(internal::NumMetricShards());
+  for (int i = 0; i < internal::NumMetricShards(); ++i) {
+    shards_.emplace_back(new Shard(bucket_limits));
+  }
+}
+
+void ShardedSamplerCell::Add(const double sample) {
+  Shard* const shard = shards_[internal::CurrentMetricShard()].get();
+  mutex_lock l(shard->mu);
+  shard->histogram.Add(sample);
+}
+
+HistogramProto ShardedSamplerCell::value() const {
+  HistogramProto value;
+  for (int i = 0; i < shards_.size(); ++i) {
+    HistogramProto shard_value;
+    {
+      tf_shared_lock l(shards_[i]->mu);
+      // Zero buckets are kept, so that the buckets of the shards line up.
+      shards_[i]->histogram.EncodeToProto(&shard_value,
+                                          /*preserve_zero_buckets=*/true);
+    }
+    if (i == 0) {
+      value = std::move(shard_value);
+    } else {
+      internal::AddHistogram(shard_value, &value);
+    }
+  }
+  return value;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,228 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_SHARDED_METRICS_H_
+#define TENSORFLOW_SERVING_UTIL_SHARDED_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/lib/histogram/histogram.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/lib/monitoring/metric_def.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace serving {
+
+// Drop-in replacements for monitoring::Counter and monitoring::Sampler, for
+// metrics updated on every request: each cell is split into shards on their
+// own cache lines, and each thread updates one shard, so that threads on
+// different cores don't contend on the cell. The shards are summed when the
+// metric is collected, e.g. on a Prometheus scrape, which makes reading a cell
+// more expensive than with the monitoring:: metrics.
+//
+// Looking up a cell takes a reader lock, rather than the exclusive lock of the
+// monitoring:: metrics, so callers can still look cells up per update.
+
+namespace internal {
+
+// The number of shards of each cell.
+int NumMetricShards();
+
+// Returns the shard the calling thread updates, in [0, NumMetricShards()).
+int CurrentMetricShard();
+
+// Adds the histogram 'from' to 'to', which have the same bucket limits.
+void AddHistogram(const HistogramProto& from, HistogramProto* to);
+
+}  // namespace internal
+
+// The cell of a ShardedCounter, for a set of label values.
+class ShardedCounterCell {
+ public:
+  ShardedCounterCell() : shards_(new Shard[internal::NumMetricShards()]) {}
+
+  void IncrementBy(const int64_t step) {
+    shards_[internal::CurrentMetricShard()].value.fetch_add(
+        step, std::memory_order_relaxed);
+  }
+
+  // Sums the shards.
+  int64_t value() const;
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<int64_t> value{0};
+  };
+
+  const std::unique_ptr<Shard[]> shards_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardedCounterCell);
+};
+
+// The cell of a ShardedSampler, for a set of label values.
+class ShardedSamplerCell {
+ public:
+  explicit ShardedSamplerCell(const std::vector<double>& bucket_limits);
+
+  void Add(double sample);
+
+  // Merges the histograms of the shards.
+  HistogramProto value() const;
+
+ private:
+  // Threads that share a shard serialize on its lock, which in the common case
+  // of a shard per core is uncontended.
+  struct alignas(64) Shard {
+    explicit Shard(const std::vector<double>& bucket_limits)
+        : histogram(bucket_limits) {}
+
+    mutable mutex mu;
+    histogram::Histogram histogram TF_GUARDED_BY(mu);
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardedSamplerCell);
+};
+
+namespace internal {
+
+// The cells of a sharded metric, by label values, which it registers for
+// collection with the default CollectionRegistry.
+template <typename Cell, typename Value, int NumLabels>
+class ShardedMetric {
+ public:
+  using MetricDefType =
+      monitoring::MetricDef<monitoring::MetricKind::kCumulative, Value,
+                            NumLabels>;
+
+  ShardedMetric(const MetricDefType& metric_def,
+                std::function<std::unique_ptr<Cell>()> new_cell)
+      : metric_def_(metric_def), new_cell_(std::move(new_cell)) {
+    registration_handle_ = monitoring::CollectionRegistry::Default()->Register(
+        &metric_def_, [this](monitoring::MetricCollectorGetter getter) {
+          auto metric_collector = getter.Get(&metric_def_);
+          tf_shared_lock l(mu_);
+          for (const auto& cell : cells_) {
+            metric_collector.CollectValue(cell.first, cell.second->value());
+          }
+        });
+  }
+
+  template <typename... Labels>
+  Cell* GetCell(const Labels&... labels) TF_LOCKS_EXCLUDED(mu_) {
+    static_assert(sizeof...(Labels) == NumLabels,
+                  "Mismatch between ShardedMetric<NumLabels> and number of "
+                  "labels provided in GetCell(...).");
+    const LabelArray label_array = {{labels...}};
+    {
+      tf_shared_lock l(mu_);
+      const auto found = cells_.find(label_array);
+      if (found != cells_.end()) {
+        return found->second.get();
+      }
+    }
+    mutex_lock l(mu_);
+    std::unique_ptr<Cell>& cell = cells_[label_array];
+    if (cell == nullptr) {
+      cell = new_cell_();
+    }
+    return cell.get();
+  }
+
+ private:
+  using LabelArray = std::array<string, NumLabels>;
+
+  mutable mutex mu_;
+  const MetricDefType metric_def_;
+  const std::function<std::unique_ptr<Cell>()> new_cell_;
+  std::map<LabelArray, std::unique_ptr<Cell>> cells_ TF_GUARDED_BY(mu_);
+
+  // Last, to stop the collection of the metric before the cells are destroyed.
+  std::unique_ptr<monitoring::CollectionRegistry::RegistrationHandle>
+      registration_handle_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShardedMetric);
+};
+
+}  // namespace internal
+
+// A counter, like monitoring::Counter<NumLabels>, with sharded cells.
+//
+// Usage is the same:
+//   auto* request_count = ShardedCounter<1>::New(
+//       "/tensorflow/serving/request_count", "The number of requests.",
+//       "model_name");
+//   request_count->GetCell("mnist")->IncrementBy(1);
+template <int NumLabels>
+class ShardedCounter
+    : public internal::ShardedMetric<ShardedCounterCell, int64_t, NumLabels> {
+ public:
+  template <typename... MetricDefArgs>
+  static ShardedCounter* New(MetricDefArgs&&... metric_def_args) {
+    return new ShardedCounter(
+        typename ShardedCounter::MetricDefType(
+            std::forward<MetricDefArgs>(metric_def_args)...));
+  }
+
+ private:
+  explicit ShardedCounter(
+      const typename ShardedCounter::MetricDefType& metric_def)
+      : internal::ShardedMetric<ShardedCounterCell, int64_t, NumLabels>(
+            metric_def, []() {
+              return std::unique_ptr<ShardedCounterCell>(
+                  new ShardedCounterCell());
+            }) {}
+};
+
+// A sampler, like monitoring::Sampler<NumLabels>, with sharded cells.
+template <int NumLabels>
+class ShardedSampler
+    : public internal::ShardedMetric<ShardedSamplerCell, HistogramProto,
+                                     NumLabels> {
+ public:
+  static ShardedSampler* New(
+      const typename ShardedSampler::MetricDefType& metric_def,
+      std::unique_ptr<monitoring::Buckets> buckets) {
+    return new ShardedSampler(metric_def, buckets->explicit_bounds());
+  }
+
+ private:
+  ShardedSampler(const typename ShardedSampler::MetricDefType& metric_def,
+                 const std::vector<double>& bucket_limits)
+      : internal::ShardedMetric<ShardedSamplerCell, HistogramProto, NumLabels>(
+            metric_def, [bucket_limits]() {
+              return std::unique_ptr<ShardedSamplerCell>(
+                  new ShardedSamplerCell(bucket_limits));
+            }) {}
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_SHARDED_METRICS_H_
@@ -0,0 +1,105 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/sharded_metrics.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/monitoring/collected_metrics.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+auto* test_counter = ShardedCounter<1>::New(
+    "/tensorflow/serving/test/sharded_counter", "A sharded counter.", "label");
+
+auto* test_sampler = ShardedSampler<1>::New(
+    {"/tensorflow/serving/test/sharded_sampler", "A sharded sampler.",
+     "label"},
+    monitoring::Buckets::Explicit({1, 10}));
+
+// Returns the point of the metric 'name' with label value 'label'.
+std::unique_ptr<monitoring::Point> CollectPoint(const string& name,
+                                                const string& label) {
+  std::unique_ptr<monitoring::CollectedMetrics> collected =
+      monitoring::CollectionRegistry::Default()->CollectMetrics({});
+  const auto point_set = collected->point_set_map.find(name);
+  if (point_set == collected->point_set_map.end()) {
+    return nullptr;
+  }
+  for (std::unique_ptr<monitoring::Point>& point :
+       point_set->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == label) {
+      return std::move(point);
+    }
+  }
+  return nullptr;
+}
+
+TEST(ShardedMetricsTest, SumsShardsOfCounter) {
+  ShardedCounterCell* const cell = test_counter->GetCell("a");
+  EXPECT_EQ(cell, test_counter->GetCell("a"));
+  EXPECT_NE(cell, test_counter->GetCell("b"));
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < 8; ++i) {
+      threads.emplace_back(Env::Default()->StartThread({}, "increment", [&]() {
+        for (int j = 0; j < 1000; ++j) {
+          test_counter->GetCell("a")->IncrementBy(2);
+        }
+      }));
+    }
+  }
+  EXPECT_EQ(16000, cell->value());
+  EXPECT_EQ(0, test_counter->GetCell("b")->value());
+
+  std::unique_ptr<monitoring::Point> point =
+      CollectPoint("/tensorflow/serving/test/sharded_counter", "a");
+  ASSERT_NE(nullptr, point);
+  EXPECT_EQ(16000, point->int64_value);
+}
+
+TEST(ShardedMetricsTest, MergesShardsOfSampler) {
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back(Env::Default()->StartThread({}, "add", [i]() {
+        test_sampler->GetCell("a")->Add(i < 2 ? 0.5 : 5);
+      }));
+    }
+  }
+  const HistogramProto histogram = test_sampler->GetCell("a")->value();
+  EXPECT_EQ(4, histogram.num());
+  EXPECT_EQ(11, histogram.sum());
+  EXPECT_EQ(0.5, histogram.min());
+  EXPECT_EQ(5, histogram.max());
+  ASSERT_EQ(3, histogram.bucket_size());
+  EXPECT_EQ(2, histogram.bucket(0));
+  EXPECT_EQ(2, histogram.bucket(1));
+  EXPECT_EQ(0, histogram.bucket(2));
+
+  std::unique_ptr<monitoring::Point> point =
+      CollectPoint("/tensorflow/serving/test/sharded_sampler", "a");
+  ASSERT_NE(nullptr, point);
+  EXPECT_EQ(4, point->histogram_value.num());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
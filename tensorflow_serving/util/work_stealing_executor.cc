@@ -0,0 +1,165 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/work_stealing_executor.h"
+
+#include <utility>
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+auto* queue_depth = monitoring::Sampler<1>::New(
+    {"/tensorflow/serving/work_stealing_executor/queue_depth",
+     "Depth of the queue a closure is scheduled on, including the closure.",
+     "executor"},
+    monitoring::Buckets::Exponential(1, 2, 16));
+
+auto* steal_count = monitoring::Counter<1>::New(
+    "/tensorflow/serving/work_stealing_executor/steal_count",
+    "Number of closures run by a thread other than the one queued for.",
+    "executor");
+
+// The executor and index of the current thread, if it is a worker.
+struct CurrentWorker {
+  const void* executor = nullptr;
+  int worker = -1;
+};
+
+CurrentWorker* GetCurrentWorker() {
+  thread_local CurrentWorker current_worker;
+  return &current_worker;
+}
+
+}  // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(Env* const env, const string& name,
+                                           const int num_threads)
+    : name_(name) {
+  CHECK_GT(num_threads, 0);
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  threads_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(env->StartThread(
+        {}, name, [this, i]() { WorkerLoop(i); }));
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    mutex_lock l(mu_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  // Joins the threads, once they have run all queued closures.
+  threads_.clear();
+}
+
+void WorkStealingExecutor::Schedule(std::function<void()> fn) {
+  const CurrentWorker* current = GetCurrentWorker();
+  if (current->executor == this) {
+    Enqueue(current->worker, std::move(fn));
+    return;
+  }
+  Enqueue(next_worker_.fetch_add(1, std::memory_order_relaxed) %
+              workers_.size(),
+          std::move(fn));
+}
+
+void WorkStealingExecutor::ScheduleWithAffinity(const int affinity_hint,
+                                                std::function<void()> fn) {
+  const int num_workers = workers_.size();
+  Enqueue(((affinity_hint % num_workers) + num_workers) % num_workers,
+          std::move(fn));
+}
+
+void WorkStealingExecutor::Enqueue(const int worker,
+                                   std::function<void()> fn) {
+  Worker* const w = workers_[worker].get();
+  size_t depth;
+  {
+    mutex_lock l(w->mu);
+    w->queue.push_back(std::move(fn));
+    depth = w->queue.size();
+  }
+  queue_depth->GetCell(name_)->Add(depth);
+  // Pairs with WorkerLoop() counting itself as waiting before it checks
+  // 'num_queued_': either it sees this closure, or this sees it waiting.
+  num_queued_.fetch_add(1);
+  if (num_waiting_.load() > 0) {
+    mutex_lock l(mu_);
+    cv_.notify_one();
+  }
+}
+
+bool WorkStealingExecutor::Dequeue(const int worker,
+                                   std::function<void()>* fn) {
+  {
+    Worker* const own = workers_[worker].get();
+    mutex_lock l(own->mu);
+    if (!own->queue.empty()) {
+      *fn = std::move(own->queue.front());
+      own->queue.pop_front();
+      num_queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  const int num_workers = workers_.size();
+  for (int i = 1; i < num_workers; ++i) {
+    Worker* const victim = workers_[(worker + i) % num_workers].get();
+    mutex_lock l(victim->mu);
+    if (!victim->queue.empty()) {
+      *fn = std::move(victim->queue.back());
+      victim->queue.pop_back();
+      num_queued_.fetch_sub(1);
+      steal_count->GetCell(name_)->IncrementBy(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingExecutor::WorkerLoop(const int worker) {
+  CurrentWorker* current = GetCurrentWorker();
+  current->executor = this;
+  current->worker = worker;
+  std::function<void()> fn;
+  while (true) {
+    if (Dequeue(worker, &fn)) {
+      fn();
+      fn = nullptr;
+      continue;
+    }
+    mutex_lock l(mu_);
+    num_waiting_.fetch_add(1);
+    while (num_queued_.load() <= 0 && !stopping_) {
+      cv_.wait(l);
+    }
+    num_waiting_.fetch_sub(1);
+    if (stopping_ && num_queued_.load() <= 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace serving
+}  // namespace tensorflow
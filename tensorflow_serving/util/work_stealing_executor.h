@@ -0,0 +1,105 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_SERVING_UTIL_WORK_STEALING_EXECUTOR_H_
+#define TENSORFLOW_SERVING_UTIL_WORK_STEALING_EXECUTOR_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow_serving/util/executor.h"
+
+namespace tensorflow {
+namespace serving {
+
+// An executor with a queue per thread, whose idle threads steal work from the
+// queues of the others, rather than all threads sharing a single queue.
+//
+// Closures scheduled from a thread of the executor go to the queue of that
+// thread, keeping follow-up work on the core whose caches hold its data;
+// closures scheduled from elsewhere are spread over the queues round-robin,
+// unless given an affinity hint. Threads run their own queue in order, and
+// steal the most recently queued closures of other queues. Scheduling thus
+// only contends with the one thread it queues for (and its occasional
+// thieves), which matters under bursty load.
+//
+// Exports the depth of the queues, sampled as closures are scheduled, and the
+// number of steals, by the name of the executor.
+class WorkStealingExecutor : public Executor {
+ public:
+  // Starts 'num_threads' threads named 'name' in 'env'.
+  //
+  // REQUIRES: num_threads > 0.
+  WorkStealingExecutor(Env* env, const string& name, int num_threads);
+
+  // Waits until all scheduled work has finished and then joins the threads.
+  ~WorkStealingExecutor() override;
+
+  void Schedule(std::function<void()> fn) override;
+
+  // Schedules 'fn' on the queue of thread 'affinity_hint' modulo the number of
+  // threads, e.g. to keep the work on one piece of data together. Another
+  // thread may still steal it.
+  void ScheduleWithAffinity(int affinity_hint, std::function<void()> fn);
+
+  int num_threads() const { return workers_.size(); }
+
+ private:
+  struct Worker {
+    mutex mu;
+    std::deque<std::function<void()>> queue TF_GUARDED_BY(mu);
+  };
+
+  void Enqueue(int worker, std::function<void()> fn);
+
+  // Takes the next closure of the queue of 'worker', or else steals one from
+  // another queue. Returns false if all queues are empty.
+  bool Dequeue(int worker, std::function<void()>* fn);
+
+  void WorkerLoop(int worker);
+
+  const string name_;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Where the next closure scheduled from outside the executor goes.
+  std::atomic<uint32_t> next_worker_{0};
+
+  // The number of closures queued, and of threads waiting on 'cv_' for any.
+  // Scheduling only takes 'mu_' when a thread is waiting.
+  std::atomic<int64_t> num_queued_{0};
+  std::atomic<int> num_waiting_{0};
+
+  mutex mu_;
+  condition_variable cv_;
+  bool stopping_ TF_GUARDED_BY(mu_) = false;
+
+  std::vector<std::unique_ptr<Thread>> threads_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingExecutor);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_SERVING_UTIL_WORK_STEALING_EXECUTOR_H_
@@ -0,0 +1,99 @@
+/* Copyright 2026 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_serving/util/work_stealing_executor.h"
+
+#include <atomic>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/platform/notification.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+constexpr int kNumThreads = 8;
+
+TEST(WorkStealingExecutorTest, Empty) {
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads++) {
+    WorkStealingExecutor executor(Env::Default(), "test", num_threads);
+  }
+}
+
+TEST(WorkStealingExecutorTest, DoWork) {
+  for (int num_threads = 1; num_threads < kNumThreads; num_threads++) {
+    const int kWorkItems = 100;
+    std::atomic<int> work[kWorkItems];
+    for (int i = 0; i < kWorkItems; ++i) {
+      work[i] = 0;
+    }
+    {
+      WorkStealingExecutor executor(Env::Default(), "test", num_threads);
+      for (int i = 0; i < kWorkItems; i++) {
+        executor.Schedule([&work, i]() { ++work[i]; });
+      }
+    }
+    for (int i = 0; i < kWorkItems; i++) {
+      ASSERT_EQ(1, work[i]);
+    }
+  }
+}
+
+TEST(WorkStealingExecutorTest, RunsWorkScheduledByWork) {
+  std::atomic<int> num_done{0};
+  {
+    WorkStealingExecutor executor(Env::Default(), "test", kNumThreads);
+    for (int i = 0; i < 10; ++i) {
+      executor.Schedule([&executor, &num_done]() {
+        for (int j = 0; j < 10; ++j) {
+          executor.Schedule([&num_done]() { ++num_done; });
+        }
+      });
+    }
+  }
+  EXPECT_EQ(100, num_done);
+}
+
+TEST(WorkStealingExecutorTest, IdleThreadsStealWork) {
+  WorkStealingExecutor executor(Env::Default(), "test", 2);
+  // Block thread 0, then queue more work for it, which thread 1 must steal.
+  Notification blocked;
+  Notification unblock;
+  executor.ScheduleWithAffinity(0, [&blocked, &unblock]() {
+    blocked.Notify();
+    unblock.WaitForNotification();
+  });
+  blocked.WaitForNotification();
+  Notification stolen;
+  executor.ScheduleWithAffinity(0, [&stolen]() { stolen.Notify(); });
+  stolen.WaitForNotification();
+  unblock.Notify();
+}
+
+TEST(WorkStealingExecutorTest, AffinityHintsWrapAround) {
+  std::atomic<int> num_done{0};
+  {
+    WorkStealingExecutor executor(Env::Default(), "test", 3);
+    EXPECT_EQ(3, executor.num_threads());
+    for (int hint : {-4, -1, 0, 2, 7}) {
+      executor.ScheduleWithAffinity(hint, [&num_done]() { ++num_done; });
+    }
+  }
+  EXPECT_EQ(5, num_done);
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
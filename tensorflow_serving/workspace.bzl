@@ -42,6 +42,25 @@ def tf_serving_workspace():
         build_file = "@//third_party/libevent:BUILD",
     )
 
+    # ===== nghttp2 (nghttp2.org) dependency =====
+    http_archive(
+        name = "com_github_nghttp2_nghttp2",
+        url = "https://github.com/nghttp2/nghttp2/releases/download/v1.52.0/nghttp2-1.52.0.tar.gz",
+        sha256 = "9877caa62bd72dde1331da38ce039dadb049817a01c3bdee809da15b754771b8",
+        strip_prefix = "nghttp2-1.52.0",
+        build_file = "@//third_party/nghttp2:BUILD",
+    )
+
+    # ===== libdeflate (github.com/ebiggers/libdeflate) dependency =====
+    # Only used with --define=gzip_libdeflate=true.
+    http_archive(
+        name = "com_github_ebiggers_libdeflate",
+        url = "https://github.com/ebiggers/libdeflate/archive/refs/tags/v1.19.tar.gz",
+        sha256 = "27bf62d71cd64728ff43a9feb92f2ac2f2bf748986d856133cc1e51992428c25",
+        strip_prefix = "libdeflate-1.19",
+        build_file = "@//third_party/libdeflate:BUILD",
+    )
+
     # ===== ICU dependency =====
     # Note: This overrides the dependency from TensorFlow with a version
     # that contains all data.